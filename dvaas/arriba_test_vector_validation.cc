@@ -14,14 +14,30 @@
 
 #include "dvaas/arriba_test_vector_validation.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT: third_party code.
+#include <utility>
 #include <vector>
 
+#include "absl/container/btree_map.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "dvaas/packet_injection.h"
 #include "dvaas/test_run_validation.h"
 #include "dvaas/test_vector.h"
 #include "dvaas/test_vector.pb.h"
+#include "glog/logging.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/util/delimited_message_util.h"
+#include "gutil/adaptive_rate_controller.h"
 #include "gutil/status.h"
 #include "gutil/test_artifact_writer.h"
 #include "p4/v1/p4runtime.pb.h"
@@ -29,26 +45,52 @@
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
 #include "p4_pdpi/p4_runtime_session_extras.h"
+#include "p4_pdpi/shared_ir_p4info.h"
 #include "sai_p4/instantiations/google/test_tools/test_entries.h"
 
 namespace dvaas {
+namespace {
 
-absl::Status ValidateAgaistArribaTestVector(
-    pdpi::P4RuntimeSession& sut, pdpi::P4RuntimeSession& control_switch,
-    const ArribaTestVector& arriba_test_vector,
-    const ArribaTestVectorValidationParams& params) {
-  // Prepare control switch.
+// Replaces the entries on the `control_switch` with entries punting all
+// packets.
+absl::Status PrepareControlSwitch(pdpi::P4RuntimeSession& control_switch) {
   ASSIGN_OR_RETURN(p4::v1::GetForwardingPipelineConfigResponse config,
                    GetForwardingPipelineConfig(&control_switch));
-  ASSIGN_OR_RETURN(pdpi::IrP4Info ir_p4info,
-                   pdpi::CreateIrP4Info(config.config().p4info()));
+  ASSIGN_OR_RETURN(pdpi::SharedIrP4Info ir_p4info,
+                   pdpi::SharedIrP4Info::Create(config.config().p4info()));
   ASSIGN_OR_RETURN(std::vector<p4::v1::Entity> punt_entities,
                    sai::EntryBuilder()
                        .AddEntryPuntingAllPackets(sai::PuntAction::kTrap)
-                       .GetDedupedPiEntities(ir_p4info));
+                       .GetDedupedPiEntities(ir_p4info.info()));
 
   RETURN_IF_ERROR(pdpi::ClearTableEntries(&control_switch));
-  RETURN_IF_ERROR(pdpi::InstallPiEntities(control_switch, punt_entities));
+  return pdpi::InstallPiEntities(control_switch, punt_entities);
+}
+
+// Returns the number of outputs that the switches produce at least for the
+// given test vectors, assuming no loss.
+int MinimumNumberOfOutputs(const PacketTestVectorById& test_vector_by_id) {
+  int num_outputs = 0;
+  for (const auto& [id, test_vector] : test_vector_by_id) {
+    std::optional<int> min_outputs;
+    for (const SwitchOutput& output : test_vector.acceptable_outputs()) {
+      const int outputs = output.packets_size() + output.packet_ins_size();
+      if (!min_outputs.has_value() || outputs < *min_outputs) {
+        min_outputs = outputs;
+      }
+    }
+    num_outputs += min_outputs.value_or(0);
+  }
+  return num_outputs;
+}
+
+}  // namespace
+
+absl::Status ValidateAgaistArribaTestVector(
+    pdpi::P4RuntimeSession& sut, pdpi::P4RuntimeSession& control_switch,
+    const ArribaTestVector& arriba_test_vector,
+    const ArribaTestVectorValidationParams& params) {
+  RETURN_IF_ERROR(PrepareControlSwitch(control_switch));
 
   // Prepare SUT.
   RETURN_IF_ERROR(pdpi::ClearTableEntries(&sut));
@@ -80,4 +122,240 @@ absl::Status ValidateAgaistArribaTestVector(
                                 "test_failures.txt", failures);
                           });
 }
+
+absl::Status WriteArribaTestVectorFile(
+    const std::string& path, const ArribaTestVector& arriba_test_vector) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return gutil::InternalErrorBuilder()
+           << "Could not open Arriba test vector file '" << path
+           << "' for writing: " << std::strerror(errno);
+  }
+  auto write_record =
+      [&](const ArribaTestVectorRecord& record) -> absl::Status {
+    if (!google::protobuf::util::SerializeDelimitedToOstream(record, &file)) {
+      return gutil::InternalErrorBuilder()
+             << "Failed to write record to Arriba test vector file '" << path
+             << "'.";
+    }
+    return absl::OkStatus();
+  };
+
+  ArribaTestVectorRecord record;
+  for (const pdpi::IrTableEntry& entry :
+       arriba_test_vector.ir_table_entries().entries()) {
+    *record.mutable_ir_table_entry() = entry;
+    RETURN_IF_ERROR(write_record(record));
+  }
+  // Written in order of ID, since protobuf maps are unordered.
+  const absl::btree_map<int64_t, PacketTestVector> packet_test_vector_by_id(
+      arriba_test_vector.packet_test_vector_by_id().begin(),
+      arriba_test_vector.packet_test_vector_by_id().end());
+  for (const auto& [id, packet_test_vector] : packet_test_vector_by_id) {
+    record.mutable_packet_test_vector()->set_id(id);
+    *record.mutable_packet_test_vector()->mutable_packet_test_vector() =
+        packet_test_vector;
+    RETURN_IF_ERROR(write_record(record));
+  }
+
+  file.close();
+  if (file.fail()) {
+    return gutil::InternalErrorBuilder()
+           << "Failed to write Arriba test vector file '" << path << "'.";
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ValidateAgainstArribaTestVectorFile(
+    pdpi::P4RuntimeSession& sut, pdpi::P4RuntimeSession& control_switch,
+    const std::string& path, const ArribaTestVectorValidationParams& params) {
+  if (params.table_entries_per_chunk <= 0 ||
+      params.packet_test_vectors_per_chunk <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Chunk sizes must be > 0, but got table_entries_per_chunk = "
+           << params.table_entries_per_chunk
+           << " and packet_test_vectors_per_chunk = "
+           << params.packet_test_vectors_per_chunk;
+  }
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return gutil::NotFoundErrorBuilder()
+           << "Could not open Arriba test vector file '" << path
+           << "': " << std::strerror(errno);
+  }
+  google::protobuf::io::IstreamInputStream input(&file);
+  int num_records = 0;
+  // Returns the next record, or nullopt at the end of the file.
+  auto read_record =
+      [&]() -> absl::StatusOr<std::optional<ArribaTestVectorRecord>> {
+    ArribaTestVectorRecord record;
+    bool clean_eof = false;
+    if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+            &record, &input, &clean_eof)) {
+      if (clean_eof) return std::nullopt;
+      return gutil::DataLossErrorBuilder()
+             << "Arriba test vector file '" << path << "' is corrupt after "
+             << num_records << " records.";
+    }
+    ++num_records;
+    return record;
+  };
+
+  // Prepare control switch.
+  RETURN_IF_ERROR(PrepareControlSwitch(control_switch));
+
+  // Prepare SUT, one chunk of entries at a time.
+  RETURN_IF_ERROR(pdpi::ClearTableEntries(&sut));
+  ASSIGN_OR_RETURN(const pdpi::IrP4Info sut_ir_p4info, pdpi::GetIrP4Info(sut));
+  std::vector<p4::v1::Update> updates;
+  auto install_updates = [&]() -> absl::Status {
+    if (updates.empty()) return absl::OkStatus();
+    RETURN_IF_ERROR(
+        pdpi::SendPiUpdatesPipelined(sut, sut_ir_p4info, updates,
+                                     params.table_entry_write_options)
+            .status());
+    updates.clear();
+    return absl::OkStatus();
+  };
+  ASSIGN_OR_RETURN(std::optional<ArribaTestVectorRecord> record,
+                   read_record());
+  while (record.has_value() && record->has_ir_table_entry()) {
+    p4::v1::Update& update = updates.emplace_back();
+    update.set_type(p4::v1::Update::INSERT);
+    ASSIGN_OR_RETURN(
+        *update.mutable_entity()->mutable_table_entry(),
+        pdpi::IrTableEntryToPi(sut_ir_p4info, record->ir_table_entry()));
+    if (static_cast<int>(updates.size()) >= params.table_entries_per_chunk) {
+      RETURN_IF_ERROR(install_updates());
+    }
+    ASSIGN_OR_RETURN(record, read_record());
+  }
+  RETURN_IF_ERROR(install_updates());
+
+  // All chunks write their failures to the same artifact, separated by blank
+  // lines. Only one chunk is validated at a time.
+  gutil::BazelTestArtifactWriter artifact_writer;
+  bool wrote_failure = false;
+  auto write_failure = [&](absl::string_view failure) {
+    absl::string_view separator = wrote_failure ? "\n\n" : "";
+    wrote_failure = true;
+    return artifact_writer.AppendToTestArtifact(
+        "test_failures.txt", absl::StrCat(separator, failure));
+  };
+
+  // Validates a chunk of test runs on `validator` while the next chunk is being
+  // injected.
+  TestRunFailureSummary summary;
+  PacketTestRuns test_runs_to_validate;
+  absl::StatusOr<TestRunFailureSummary> chunk_summary;
+  std::optional<std::thread> validator;
+  auto finish_validation = [&]() -> absl::Status {
+    if (!validator.has_value()) return absl::OkStatus();
+    validator->join();
+    validator.reset();
+    RETURN_IF_ERROR(chunk_summary.status());
+    if (summary.num_failures == 0) {
+      summary.first_failure = std::move(chunk_summary->first_failure);
+    }
+    summary.num_failures += chunk_summary->num_failures;
+    return absl::OkStatus();
+  };
+
+  PacketStatistics packet_statistics;
+  std::optional<gutil::AdaptiveRateController> rate_controller;
+  if (params.adaptive_packet_rate.has_value()) {
+    gutil::AdaptiveRateOptions rate_options = *params.adaptive_packet_rate;
+    if (params.max_packets_to_send_per_second.has_value()) {
+      rate_options.initial_rate = *params.max_packets_to_send_per_second;
+    }
+    rate_controller.emplace(rate_options);
+  }
+  // Injects the packet test vectors chunk by chunk. Must not return while
+  // `validator` is running, hence the immediately invoked lambda.
+  const absl::Status injection_status = [&]() -> absl::Status {
+    while (record.has_value()) {
+      PacketTestVectorById test_vector_by_id;
+      while (record.has_value() && static_cast<int>(test_vector_by_id.size()) <
+                                       params.packet_test_vectors_per_chunk) {
+        if (!record->has_packet_test_vector()) {
+          return gutil::InvalidArgumentErrorBuilder()
+                 << "Record " << num_records << " of Arriba test vector file '"
+                 << path << "' is not a packet test vector; all table "
+                 << "entries must precede all packet test vectors.";
+        }
+        ArribaTestVectorRecord::IdentifiedPacketTestVector& packet_test =
+            *record->mutable_packet_test_vector();
+        auto [it, inserted] = test_vector_by_id.insert(
+            {packet_test.id(),
+             std::move(*packet_test.mutable_packet_test_vector())});
+        if (!inserted) {
+          return gutil::InvalidArgumentErrorBuilder()
+                 << "Duplicate packet test vector ID " << packet_test.id()
+                 << " in Arriba test vector file '" << path << "'.";
+        }
+        ASSIGN_OR_RETURN(record, read_record());
+      }
+
+      // Send tests to switch and collect results.
+      std::optional<int> max_packets_to_send_per_second =
+          params.max_packets_to_send_per_second;
+      if (rate_controller.has_value()) {
+        max_packets_to_send_per_second = rate_controller->rate();
+      }
+      const PacketStatistics statistics_before = packet_statistics;
+      ASSIGN_OR_RETURN(
+          PacketTestRuns test_runs,
+          SendTestPacketsAndCollectOutputs(sut, control_switch,
+                                           test_vector_by_id, packet_statistics,
+                                           max_packets_to_send_per_second));
+      if (rate_controller.has_value()) {
+        const int num_outputs =
+            packet_statistics.total_packets_forwarded +
+            packet_statistics.total_packets_punted -
+            statistics_before.total_packets_forwarded -
+            statistics_before.total_packets_punted;
+        const int num_missing_outputs =
+            std::max(0, MinimumNumberOfOutputs(test_vector_by_id) -
+                            num_outputs);
+        rate_controller->ReportInterval(test_vector_by_id.size(),
+                                        num_missing_outputs);
+        LOG(INFO) << "Missing " << num_missing_outputs << " outputs of "
+                  << test_vector_by_id.size() << " test packets; sending at "
+                  << rate_controller->rate() << " packets per second.";
+      }
+
+      // Compare the switch output with expected output for each test vector,
+      // concurrently with injecting the next chunk.
+      RETURN_IF_ERROR(finish_validation());
+      test_runs_to_validate = std::move(test_runs);
+      validator.emplace([&] {
+        chunk_summary = ValidateTestRunsAndSummarizeFailures(
+            test_runs_to_validate, params.ignored_fields_for_validation,
+            params.ignored_metadata_for_validation, write_failure);
+      });
+    }
+    return absl::OkStatus();
+  }();
+  const absl::Status validation_status = finish_validation();
+  if (rate_controller.has_value()) {
+    LOG(INFO) << "Highest injection rate sustained without loss: "
+              << rate_controller->sustained_max_rate().value_or(0)
+              << " packets per second.";
+  }
+  RETURN_IF_ERROR(injection_status);
+  RETURN_IF_ERROR(validation_status);
+
+  // Always write, so that the artifact exists even if there are no failures.
+  if (summary.num_failures == 0) {
+    RETURN_IF_ERROR(
+        artifact_writer.AppendToTestArtifact("test_failures.txt", ""));
+    return absl::OkStatus();
+  }
+  return gutil::FailedPreconditionErrorBuilder()
+         << summary.num_failures
+         << " failures among test results. Showing only the first failure.\n"
+         << summary.first_failure
+         << "\nRefer to the test artifacts for the full list of failures.";
+}
+
 }  // namespace dvaas
@@ -15,11 +15,14 @@
 #ifndef PINS_DVAAS_ARRIBA_TEST_VECTOR_VALIDATION_H_
 #define PINS_DVAAS_ARRIBA_TEST_VECTOR_VALIDATION_H_
 
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "dvaas/test_vector.pb.h"
+#include "gutil/adaptive_rate_controller.h"
 #include "p4_pdpi/p4_runtime_session.h"
 #include "thinkit/mirror_testbed.h"
 
@@ -47,6 +50,20 @@ struct ArribaTestVectorValidationParams {
   // TODO: Increase default packet injection rate when rate
   // limites are disabled.
   std::optional<int> max_packets_to_send_per_second = 100;
+
+  // The following only apply to `ValidateAgainstArribaTestVectorFile`.
+  // The number of table entries installed at a time.
+  int table_entries_per_chunk = 10000;
+  // How the entries of a chunk are written to the SUT.
+  pdpi::PipelinedWriteOptions table_entry_write_options;
+  // The number of packet test vectors injected at a time. Bounds the memory
+  // used for packet test vectors and their outputs.
+  int packet_test_vectors_per_chunk = 1000;
+  // If set, the injection rate is adapted after every chunk instead of being
+  // fixed to `max_packets_to_send_per_second`, which is only the initial rate.
+  // A chunk counts as lossy by the outputs missing compared to the smallest
+  // acceptable output of each test vector.
+  std::optional<gutil::AdaptiveRateOptions> adaptive_packet_rate;
 };
 
 // Validates the `sut` in the provided mirror testbed (`sut` and
@@ -70,6 +87,28 @@ absl::Status ValidateAgaistArribaTestVector(
     const ArribaTestVector& arriba_test_vector,
     const ArribaTestVectorValidationParams& params = {});
 
+// Writes `arriba_test_vector` to the file at `path` as length-delimited
+// `ArribaTestVectorRecord`s, in the format read by
+// `ValidateAgainstArribaTestVectorFile`. Table entries are written in the given
+// order, which must list every entry after the entries it refers to.
+absl::Status WriteArribaTestVectorFile(
+    const std::string& path, const ArribaTestVector& arriba_test_vector);
+
+// Like `ValidateAgaistArribaTestVector`, but streams the test vector from the
+// file at `path`, which holds length-delimited `ArribaTestVectorRecord`s, so
+// that memory use does not grow with the size of the test vector:
+// - Table entries are installed in chunks of `table_entries_per_chunk` using
+//   pipelined batch writes. Since each chunk is sequenced on its own, entries
+//   must follow the entries they refer to.
+// - Packet test vectors are injected in chunks of
+//   `packet_test_vectors_per_chunk`. Each chunk is validated while the next
+//   chunk is being injected.
+// Failures of all chunks are written to a single test artifact.
+absl::Status ValidateAgainstArribaTestVectorFile(
+    pdpi::P4RuntimeSession& sut, pdpi::P4RuntimeSession& control_switch,
+    const std::string& path,
+    const ArribaTestVectorValidationParams& params = {});
+
 }  // namespace dvaas
 
 #endif  // PINS_DVAAS_ARRIBA_TEST_VECTOR_VALIDATION_H_
@@ -0,0 +1,194 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dvaas/incremental_test_vector_update.h"
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "dvaas/symbolic_test_vector_generation.h"
+#include "gutil/proto_ordering.h"
+#include "gutil/status.h"
+#include "p4_symbolic/ir/ir.pb.h"
+#include "p4_symbolic/symbolic/symbolic.h"
+
+namespace dvaas {
+namespace {
+
+using ::p4_symbolic::ir::TableEntry;
+
+// How the entries of a table changed.
+struct TableDelta {
+  // Maps the index of every old entry to the index of the same entry among the
+  // new entries, or to nullopt if it was deleted.
+  std::vector<std::optional<int>> new_index_by_old_index;
+  bool has_deletions = false;
+  bool has_insertions = false;
+};
+
+TableDelta ComputeTableDelta(absl::Span<const TableEntry> old_entries,
+                             absl::Span<const TableEntry> new_entries) {
+  // Identical entries, if any, are paired up in order.
+  absl::flat_hash_map<std::string, std::vector<int>> new_indices_by_key;
+  for (int i = static_cast<int>(new_entries.size()) - 1; i >= 0; --i) {
+    new_indices_by_key[gutil::ProtoOrderingKey(new_entries[i])].push_back(i);
+  }
+
+  TableDelta delta;
+  int num_kept_entries = 0;
+  for (const TableEntry& entry : old_entries) {
+    auto it = new_indices_by_key.find(gutil::ProtoOrderingKey(entry));
+    if (it == new_indices_by_key.end() || it->second.empty()) {
+      delta.new_index_by_old_index.push_back(std::nullopt);
+      delta.has_deletions = true;
+      continue;
+    }
+    delta.new_index_by_old_index.push_back(it->second.back());
+    it->second.pop_back();
+    ++num_kept_entries;
+  }
+  delta.has_insertions = num_kept_entries < new_entries.size();
+  return delta;
+}
+
+absl::Span<const TableEntry> EntriesOf(
+    const p4_symbolic::symbolic::Dataplane& data_plane,
+    const std::string& table_name) {
+  auto it = data_plane.entries.find(table_name);
+  if (it == data_plane.entries.end()) return {};
+  return it->second;
+}
+
+}  // namespace
+
+absl::StatusOr<TestVectorUpdate> UpdateSymbolicPacketTestVectors(
+    const p4_symbolic::symbolic::Dataplane& old_data_plane,
+    const p4_symbolic::symbolic::Dataplane& new_data_plane,
+    const SymbolicTestVectorGenerationParams& params,
+    TracedPacketTestVectorById& test_vectors) {
+  // Tables without entries before and after are left out.
+  absl::btree_map<std::string, TableDelta> delta_by_table;
+  for (const auto* data_plane : {&old_data_plane, &new_data_plane}) {
+    for (const auto& [table_name, entries] : data_plane->entries) {
+      if (delta_by_table.contains(table_name)) continue;
+      delta_by_table[table_name] =
+          ComputeTableDelta(EntriesOf(old_data_plane, table_name),
+                            EntriesOf(new_data_plane, table_name));
+    }
+  }
+  // Returns the new index of entry `entry_index` of `table_name`, or nullopt
+  // if it was deleted. The default entry, -1, is never deleted.
+  auto new_entry_index = [&](int id, const std::string& table_name,
+                             int entry_index)
+      -> absl::StatusOr<std::optional<int>> {
+    if (entry_index < 0) return std::optional<int>(entry_index);
+    auto delta = delta_by_table.find(table_name);
+    if (delta == delta_by_table.end() ||
+        entry_index >= delta->second.new_index_by_old_index.size()) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Test vector #" << id << " hits entry " << entry_index
+             << " of table '" << table_name
+             << "', which the old data plane does not have";
+    }
+    return delta->second.new_index_by_old_index[entry_index];
+  };
+
+  TestVectorUpdate update;
+  // The goals of the remaining test vectors, and of the removed ones, in terms
+  // of the new entries.
+  absl::btree_set<std::pair<std::string, int>> covered_goals;
+  absl::btree_set<std::pair<std::string, int>> goals;
+  const int first_new_id =
+      test_vectors.empty() ? 1 : test_vectors.rbegin()->first + 1;
+  for (auto it = test_vectors.begin(); it != test_vectors.end();) {
+    const auto& [id, test_vector] = *it;
+    ASSIGN_OR_RETURN(std::optional<int> goal_index,
+                     new_entry_index(id, test_vector.goal.table_name,
+                                     test_vector.goal.entry_index));
+    bool valid = goal_index.has_value();
+    absl::btree_map<std::string, int> new_entry_index_by_table;
+    for (const auto& [table_name, entry_index] :
+         test_vector.entry_index_by_table) {
+      ASSIGN_OR_RETURN(std::optional<int> new_index,
+                       new_entry_index(id, table_name, entry_index));
+      auto delta = delta_by_table.find(table_name);
+      if (!new_index.has_value() ||
+          (delta != delta_by_table.end() && delta->second.has_insertions)) {
+        valid = false;
+        break;
+      }
+      new_entry_index_by_table[table_name] = *new_index;
+    }
+
+    if (valid) {
+      it->second.goal.entry_index = *goal_index;
+      it->second.entry_index_by_table = std::move(new_entry_index_by_table);
+      covered_goals.insert({test_vector.goal.table_name, *goal_index});
+      ++it;
+      continue;
+    }
+    if (goal_index.has_value()) {
+      goals.insert({test_vector.goal.table_name, *goal_index});
+    }
+    update.removed_ids.push_back(id);
+    it = test_vectors.erase(it);
+  }
+
+  // Entries of changed tables may have become reachable, even if they are not
+  // new.
+  std::vector<std::string> table_names = params.table_names;
+  if (table_names.empty()) {
+    for (const auto& [table_name, entries] : new_data_plane.entries) {
+      if (!entries.empty()) table_names.push_back(table_name);
+    }
+  }
+  for (const std::string& table_name : table_names) {
+    auto delta = delta_by_table.find(table_name);
+    if (delta == delta_by_table.end() ||
+        !(delta->second.has_insertions || delta->second.has_deletions)) {
+      continue;
+    }
+    const int num_entries = EntriesOf(new_data_plane, table_name).size();
+    for (int entry_index = -1; entry_index < num_entries; ++entry_index) {
+      if (!covered_goals.contains({table_name, entry_index})) {
+        goals.insert({table_name, entry_index});
+      }
+    }
+  }
+
+  std::vector<EntryCoverageGoal> goal_list;
+  goal_list.reserve(goals.size());
+  for (const auto& [table_name, entry_index] : goals) {
+    goal_list.push_back(
+        {.table_name = table_name, .entry_index = entry_index});
+  }
+  RETURN_IF_ERROR(GenerateSymbolicPacketTestVectorsForGoals(
+      new_data_plane, params, goal_list, first_new_id,
+      [&](int id, TracedPacketTestVector test_vector) -> absl::Status {
+        test_vectors.insert({id, std::move(test_vector)});
+        update.added_ids.push_back(id);
+        return absl::OkStatus();
+      }));
+  return update;
+}
+
+}  // namespace dvaas
@@ -0,0 +1,64 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Updates symbolic packet test vectors after a change of the table entries of
+// the switch, so that only the test vectors the change may affect need to be
+// run again.
+//
+// The expected output of a test vector only depends on the entries its input
+// packet hits. A test vector thus stays valid, unless:
+// - an entry it hits was deleted or modified, or
+// - an entry was inserted into a table applied to it, which may now be hit
+//   instead.
+// Entries are compared by content, so a modification is a deletion followed by
+// an insertion.
+
+#ifndef PINS_DVAAS_INCREMENTAL_TEST_VECTOR_UPDATE_H_
+#define PINS_DVAAS_INCREMENTAL_TEST_VECTOR_UPDATE_H_
+
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "dvaas/symbolic_test_vector_generation.h"
+#include "p4_symbolic/symbolic/symbolic.h"
+
+namespace dvaas {
+
+// The changes made to test vectors by `UpdateSymbolicPacketTestVectors`.
+struct TestVectorUpdate {
+  // The test vectors that were removed, in increasing order.
+  std::vector<int> removed_ids;
+  // The test vectors that were added, in increasing order. These need to be
+  // run; the others behave on the new entries as they did on the old ones.
+  std::vector<int> added_ids;
+};
+
+// Updates `test_vectors`, generated for `old_data_plane` with `params`, to
+// `new_data_plane`, which must have the same program. Removes the test vectors
+// that may no longer be valid, and generates new ones for their goals, and for
+// the entries without a test vector of the tables whose entries changed. The
+// traces of the remaining test vectors are re-indexed to the new entries. New
+// ids are greater than all previous ones.
+//
+// Entries that no packet reaches are only retried once their own table
+// changes, even if a change to another table makes them reachable.
+absl::StatusOr<TestVectorUpdate> UpdateSymbolicPacketTestVectors(
+    const p4_symbolic::symbolic::Dataplane& old_data_plane,
+    const p4_symbolic::symbolic::Dataplane& new_data_plane,
+    const SymbolicTestVectorGenerationParams& params,
+    TracedPacketTestVectorById& test_vectors);
+
+}  // namespace dvaas
+
+#endif  // PINS_DVAAS_INCREMENTAL_TEST_VECTOR_UPDATE_H_
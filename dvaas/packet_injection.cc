@@ -14,85 +14,187 @@
 
 #include "dvaas/packet_injection.h"
 
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT: third_party code.
+#include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "dvaas/test_vector.h"
 #include "dvaas/test_vector.pb.h"
+#include "glog/logging.h"
 #include "gutil/status.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/p4_runtime_session.h"
+#include "p4_pdpi/packetlib/packet_view.h"
 #include "p4_pdpi/packetlib/packetlib.h"
 #include "p4_pdpi/packetlib/packetlib.pb.h"
+#include "p4_pdpi/shared_ir_p4info.h"
+#include "sai_p4/tools/packetio_tools.h"
 #include "tests/forwarding/util.h"
 
 namespace dvaas {
 namespace {
 
 // Utils.
-// Reads P4Info from the `device` and convert it to IrP4Info.
-absl::StatusOr<pdpi::IrP4Info> GetIrP4Info(
+// Reads P4Info from the `device` and convert it to IrP4Info. Switches with the
+// same P4Info share the IrP4Info, so it is created once per P4Info.
+absl::StatusOr<pdpi::SharedIrP4Info> GetIrP4Info(
     pdpi::P4RuntimeSession& p4rt_session) {
   ASSIGN_OR_RETURN(p4::v1::GetForwardingPipelineConfigResponse response,
                    pdpi::GetForwardingPipelineConfig(&p4rt_session));
-  return pdpi::CreateIrP4Info(response.config().p4info());
+  return pdpi::SharedIrP4Info::Create(response.config().p4info());
 }
 
-// Processed information about a PacketIn message with a tagged payload.
-struct TaggedPacketIn {
-  int tag;
-  p4::v1::PacketIn packet_in;
-  packetlib::Packet parsed_inner_packet;
-};
+// Tagged PacketIn messages, bucketed by their tag in order of arrival.
+using PacketInsByTag = absl::flat_hash_map<int, std::vector<p4::v1::PacketIn>>;
 
-absl::StatusOr<std::vector<TaggedPacketIn>>
-CollectStreamMessageResponsesAndReturnTaggedPacketIns(
-    pdpi::P4RuntimeSession& p4rt_session, absl::Duration duration,
+// Returns the tag of the packet-in in the stream message `response`, or
+// nullopt for expected unsolicited packets. Only reads the tag out of the
+// payload; tagged packets are parsed once collection is done.
+absl::StatusOr<std::optional<int>> ExtractTagOfPacketIn(
+    const p4::v1::StreamMessageResponse& response,
     const IsExpectedUnsolicitedPacketFunctionType&
         is_expected_unsolicited_packet) {
-  // Collect all unread stream messages responses from the P4RT session that
-  // were received before or during the specified duration.
-  ASSIGN_OR_RETURN(std::vector<p4::v1::StreamMessageResponse> responses,
-                   p4rt_session.GetAllStreamMessagesFor(duration));
-
-  std::vector<TaggedPacketIn> tagged_packet_ins;
-  for (const p4::v1::StreamMessageResponse& response : responses) {
-    if (!response.has_packet()) {
-      // TODO: Decide if we should continue or fail and stop.
-      return gutil::FailedPreconditionErrorBuilder()
-             << "Unexpected (i.e. non-packet-in) response "
-             << response.DebugString();
-    } else {
-      const packetlib::Packet parsed_inner_packet =
-          packetlib::ParsePacket(response.packet().payload());
-
-      absl::StatusOr<int> test_packet_id =
-          ExtractTestPacketTag(parsed_inner_packet);
-      if (test_packet_id.ok()) {
-        tagged_packet_ins.push_back({
-            .tag = *test_packet_id,
-            .packet_in = response.packet(),
-            .parsed_inner_packet = parsed_inner_packet,
-        });
-      } else {
-        if (is_expected_unsolicited_packet(parsed_inner_packet)) {
-          // TODO: Append to artifact instead of logging.
-          LOG(INFO) << "Ignoring expected unsolicited packet "
-                    << parsed_inner_packet.ShortDebugString();
-        } else {
-          // TODO: Decide if we should continue or fail and stop.
-          return gutil::FailedPreconditionErrorBuilder()
-                 << "Non-tagged packet-in "
-                 << parsed_inner_packet.DebugString();
+  if (!response.has_packet()) {
+    // TODO: Decide if we should continue or fail and stop.
+    return gutil::FailedPreconditionErrorBuilder()
+           << "Unexpected (i.e. non-packet-in) response "
+           << response.DebugString();
+  }
+  const packetlib::PacketView inner_packet =
+      packetlib::PacketView::Parse(response.packet().payload());
+  absl::StatusOr<int> test_packet_id =
+      ExtractTestPacketTag(inner_packet.payload());
+  if (test_packet_id.ok()) return *test_packet_id;
+
+  const packetlib::Packet parsed_inner_packet = inner_packet.ToPacket();
+  if (is_expected_unsolicited_packet(parsed_inner_packet)) {
+    // TODO: Append to artifact instead of logging.
+    LOG(INFO) << "Ignoring expected unsolicited packet "
+              << parsed_inner_packet.ShortDebugString();
+    return std::nullopt;
+  }
+  // TODO: Decide if we should continue or fail and stop.
+  return gutil::FailedPreconditionErrorBuilder()
+         << "Non-tagged packet-in " << parsed_inner_packet.DebugString();
+}
+
+// The tagged packet-ins collected from both switches, shared by the threads
+// collecting them and the thread injecting the test packets.
+class OutputCollector {
+ public:
+  // `expected_outputs_by_tag` holds the number of outputs after which a test
+  // vector is accounted for.
+  explicit OutputCollector(
+      absl::flat_hash_map<int, int> expected_outputs_by_tag)
+      : remaining_outputs_by_tag_(std::move(expected_outputs_by_tag)) {
+    for (const auto& [tag, remaining] : remaining_outputs_by_tag_) {
+      if (remaining > 0) ++num_unaccounted_tags_;
+    }
+  }
+
+  // Reads stream messages from `session` into `packet_ins_by_tag` until
+  // `Stop` is called or an error occurs.
+  void Collect(pdpi::P4RuntimeSession& session,
+               const IsExpectedUnsolicitedPacketFunctionType&
+                   is_expected_unsolicited_packet,
+               PacketInsByTag& packet_ins_by_tag) {
+    constexpr int kMaxMessagesPerRead = 1000;
+    constexpr absl::Duration kPollInterval = absl::Milliseconds(20);
+    while (!stopped()) {
+      absl::StatusOr<std::vector<p4::v1::StreamMessageResponse>> responses =
+          session.GetNextStreamMessages(kMaxMessagesPerRead, kPollInterval);
+      if (absl::IsDeadlineExceeded(responses.status())) continue;
+      if (!responses.ok()) {
+        Fail(responses.status());
+        return;
+      }
+      for (p4::v1::StreamMessageResponse& response : *responses) {
+        absl::StatusOr<std::optional<int>> tag =
+            ExtractTagOfPacketIn(response, is_expected_unsolicited_packet);
+        if (!tag.ok()) {
+          Fail(tag.status());
+          return;
         }
+        if (!tag->has_value()) continue;
+        RecordOutput(**tag);
+        packet_ins_by_tag[**tag].push_back(
+            std::move(*response.mutable_packet()));
       }
     }
   }
 
-  return tagged_packet_ins;
+  // Waits until every test vector is accounted for, `Collect` failed, or
+  // `timeout` expired. Returns true in the first case.
+  bool AwaitAllAccountedFor(absl::Duration timeout) {
+    absl::MutexLock lock(&mutex_);
+    auto done = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return num_unaccounted_tags_ == 0 || !status_.ok();
+    };
+    mutex_.AwaitWithTimeout(absl::Condition(&done), timeout);
+    return num_unaccounted_tags_ == 0 && status_.ok();
+  }
+
+  void Stop() {
+    absl::MutexLock lock(&mutex_);
+    stopped_ = true;
+  }
+
+  // The first error encountered by `Collect`, if any.
+  absl::Status status() {
+    absl::MutexLock lock(&mutex_);
+    return status_;
+  }
+
+ private:
+  bool stopped() {
+    absl::MutexLock lock(&mutex_);
+    return stopped_ || !status_.ok();
+  }
+
+  void Fail(absl::Status status) {
+    absl::MutexLock lock(&mutex_);
+    if (status_.ok()) status_ = std::move(status);
+  }
+
+  void RecordOutput(int tag) {
+    absl::MutexLock lock(&mutex_);
+    auto it = remaining_outputs_by_tag_.find(tag);
+    if (it == remaining_outputs_by_tag_.end()) return;
+    if (--it->second == 0) --num_unaccounted_tags_;
+  }
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<int, int> remaining_outputs_by_tag_
+      ABSL_GUARDED_BY(mutex_);
+  int num_unaccounted_tags_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Returns the number of outputs after which `test_vector` is accounted for:
+// the size of its largest acceptable output.
+int ExpectedNumberOfOutputs(const PacketTestVector& test_vector) {
+  int expected_outputs = 0;
+  for (const SwitchOutput& output : test_vector.acceptable_outputs()) {
+    expected_outputs = std::max(
+        expected_outputs, output.packets_size() + output.packet_ins_size());
+  }
+  return expected_outputs;
 }
 
 }  // namespace
@@ -112,94 +214,136 @@ absl::StatusOr<PacketTestRuns> SendTestPacketsAndCollectOutputs(
     PacketStatistics& statistics,
     std::optional<int> max_packets_to_send_per_second,
     const IsExpectedUnsolicitedPacketFunctionType&
-        is_expected_unsolicited_packet) {
+        is_expected_unsolicited_packet,
+    const PacketInjectionOptions& options) {
   LOG(INFO) << "Injecting test packets into the dataplane "
             << packet_test_vector_by_id.size();
   statistics.total_packets_injected += packet_test_vector_by_id.size();
 
   // Get IrP4Infos.
-  ASSIGN_OR_RETURN(const pdpi::IrP4Info sut_ir_p4info, GetIrP4Info(sut));
-  ASSIGN_OR_RETURN(const pdpi::IrP4Info control_ir_p4info,
+  ASSIGN_OR_RETURN(const pdpi::SharedIrP4Info sut_ir_p4info, GetIrP4Info(sut));
+  ASSIGN_OR_RETURN(const pdpi::SharedIrP4Info control_ir_p4info,
                    GetIrP4Info(control_switch));
 
-  // Compute per packet injection delay.
-  std::optional<absl::Duration> injection_delay;
-  if (max_packets_to_send_per_second.has_value()) {
-    injection_delay = absl::Milliseconds(1e3 / *max_packets_to_send_per_second);
+  if (options.packet_out_batch_size <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "PacketOut batch size must be > 0, but got "
+           << options.packet_out_batch_size;
   }
 
-  // Send packets.
+  // Translate every packet before injecting any, so that the injection is not
+  // slowed down by translation and unsupported inputs fail early.
+  std::vector<p4::v1::StreamMessageRequest> packet_outs;
+  packet_outs.reserve(packet_test_vector_by_id.size());
+  absl::flat_hash_map<int, int> expected_outputs_by_tag;
   for (const auto& [test_id, packet_test_vector] : packet_test_vector_by_id) {
-    if (packet_test_vector.input().type() == SwitchInput::DATAPLANE) {
-      const Packet& packet = packet_test_vector.input().packet();
-
-      // Inject to egress of control switch.
-      RETURN_IF_ERROR(gpins::InjectEgressPacket(
-          packet.port(), absl::HexStringToBytes(packet.hex()),
-          control_ir_p4info, &control_switch, injection_delay));
-    } else {
+    if (packet_test_vector.input().type() != SwitchInput::DATAPLANE) {
       return absl::UnimplementedError(
           absl::StrCat("Test vector input type not supported\n",
                        packet_test_vector.input().DebugString()));
     }
+    const Packet& packet = packet_test_vector.input().packet();
+    const std::string payload = absl::HexStringToBytes(packet.hex());
+    ASSIGN_OR_RETURN(
+        *packet_outs.emplace_back().mutable_packet(),
+        sai::MakePiPacketOutMessage(control_ir_p4info.info(),
+                                    sai::PacketOutMetadata{
+                                        .submit_to_ingress = false,
+                                        .payload = payload,
+                                        .egress_port = packet.port(),
+                                    }));
+    expected_outputs_by_tag[test_id] =
+        ExpectedNumberOfOutputs(packet_test_vector);
+  }
+
+  // Collect the output of the switches while injecting.
+  OutputCollector collector(std::move(expected_outputs_by_tag));
+  PacketInsByTag control_packet_ins_by_tag;
+  PacketInsByTag sut_packet_ins_by_tag;
+  std::thread control_collector([&] {
+    collector.Collect(control_switch, is_expected_unsolicited_packet,
+                      control_packet_ins_by_tag);
+  });
+  std::thread sut_collector([&] {
+    collector.Collect(sut, is_expected_unsolicited_packet,
+                      sut_packet_ins_by_tag);
+  });
+  auto stop_collection = [&] {
+    collector.Stop();
+    control_collector.join();
+    sut_collector.join();
+  };
+
+  // Inject to egress of control switch, in batches.
+  if (absl::Status status = gpins::WriteStreamMessageRequests(
+          packet_outs, &control_switch,
+          gpins::PacketInjectionOptions{
+              .packets_per_second = max_packets_to_send_per_second,
+              .max_batch_size = options.packet_out_batch_size,
+          });
+      !status.ok()) {
+    stop_collection();
+    return status;
   }
   LOG(INFO) << "Finished injecting test packets";
 
-  // Check the output of the switches.
-  const absl::Duration kCollectionDuration = absl::Seconds(3);
-  absl::StatusOr<std::vector<TaggedPacketIn>> control_packet_ins =
-      CollectStreamMessageResponsesAndReturnTaggedPacketIns(
-          control_switch, kCollectionDuration, is_expected_unsolicited_packet);
-  RETURN_IF_ERROR(control_packet_ins.status())
-      << "while collecting the output of control_switch";
-  LOG(INFO) << "Collected " << control_packet_ins->size()
+  if (collector.AwaitAllAccountedFor(options.max_collection_duration)) {
+    absl::SleepFor(options.settle_duration);
+  }
+  stop_collection();
+  RETURN_IF_ERROR(collector.status()) << "while collecting switch outputs";
+  int num_forwarded = 0;
+  for (const auto& [tag, packet_ins] : control_packet_ins_by_tag) {
+    num_forwarded += packet_ins.size();
+  }
+  LOG(INFO) << "Collected " << num_forwarded
             << " forwarded packets (from control switch)";
-  statistics.total_packets_forwarded += control_packet_ins->size();
-
-  absl::StatusOr<std::vector<TaggedPacketIn>> sut_packet_ins =
-      CollectStreamMessageResponsesAndReturnTaggedPacketIns(
-          sut, kCollectionDuration, is_expected_unsolicited_packet);
-  RETURN_IF_ERROR(sut_packet_ins.status())
-      << "while  collecting the output of SUT";
-  LOG(INFO) << "Collected " << sut_packet_ins->size()
-            << " punted packets (from SUT)";
-  statistics.total_packets_punted += sut_packet_ins->size();
+  statistics.total_packets_forwarded += num_forwarded;
+  int num_punted = 0;
+  for (const auto& [tag, packet_ins] : sut_packet_ins_by_tag) {
+    num_punted += packet_ins.size();
+  }
+  LOG(INFO) << "Collected " << num_punted << " punted packets (from SUT)";
+  statistics.total_packets_punted += num_punted;
 
   absl::btree_map<int, SwitchOutput> switch_output_by_id;
   // Processing the output of the control switch.
-  for (const TaggedPacketIn& packet_in : *control_packet_ins) {
-    // Add to (forwarded) switch output for ID.
-    Packet& forwarded_output =
-        *switch_output_by_id[packet_in.tag].add_packets();
+  for (const auto& [tag, packet_ins] : control_packet_ins_by_tag) {
+    SwitchOutput& switch_output = switch_output_by_id[tag];
+    for (const p4::v1::PacketIn& packet_in : packet_ins) {
+      // Add to (forwarded) switch output for ID.
+      Packet& forwarded_output = *switch_output.add_packets();
 
-    // Set hex and parsed packet.
-    forwarded_output.set_hex(
-        absl::BytesToHexString(packet_in.packet_in.payload()));
-    *forwarded_output.mutable_parsed() = packet_in.parsed_inner_packet;
+      // Set hex and parsed packet.
+      forwarded_output.set_hex(absl::BytesToHexString(packet_in.payload()));
+      *forwarded_output.mutable_parsed() =
+          packetlib::ParsePacket(packet_in.payload());
 
-    // Set port.
-    ASSIGN_OR_RETURN(
-        pdpi::IrPacketIn ir_packet_in,
-        pdpi::PiPacketInToIr(control_ir_p4info, packet_in.packet_in));
-    ASSIGN_OR_RETURN(*forwarded_output.mutable_port(),
-                     GetIngressPortFromIrPacketIn(ir_packet_in));
+      // Set port.
+      ASSIGN_OR_RETURN(pdpi::IrPacketIn ir_packet_in,
+                       pdpi::PiPacketInToIr(control_ir_p4info.info(), packet_in));
+      ASSIGN_OR_RETURN(*forwarded_output.mutable_port(),
+                       GetIngressPortFromIrPacketIn(ir_packet_in));
+    }
   }
 
   // Processing the output of SUT.
-  for (const TaggedPacketIn& packet_in : *sut_packet_ins) {
-    // Add to (punted) switch output for ID.
-    PacketIn& punted_output =
-        *switch_output_by_id[packet_in.tag].add_packet_ins();
+  for (const auto& [tag, packet_ins] : sut_packet_ins_by_tag) {
+    SwitchOutput& switch_output = switch_output_by_id[tag];
+    for (const p4::v1::PacketIn& packet_in : packet_ins) {
+      // Add to (punted) switch output for ID.
+      PacketIn& punted_output = *switch_output.add_packet_ins();
 
-    // Set hex and parsed packet.
-    punted_output.set_hex(
-        absl::BytesToHexString(packet_in.packet_in.payload()));
-    *punted_output.mutable_parsed() = packet_in.parsed_inner_packet;
+      // Set hex and parsed packet.
+      punted_output.set_hex(absl::BytesToHexString(packet_in.payload()));
+      *punted_output.mutable_parsed() =
+          packetlib::ParsePacket(packet_in.payload());
 
-    // Set metadata.
-    ASSIGN_OR_RETURN(pdpi::IrPacketIn ir_packet_in,
-                     pdpi::PiPacketInToIr(sut_ir_p4info, packet_in.packet_in));
-    *punted_output.mutable_metadata() = ir_packet_in.metadata();
+      // Set metadata.
+      ASSIGN_OR_RETURN(pdpi::IrPacketIn ir_packet_in,
+                       pdpi::PiPacketInToIr(sut_ir_p4info.info(), packet_in));
+      *punted_output.mutable_metadata() = ir_packet_in.metadata();
+    }
   }
 
   // Create PacketTestRuns.
@@ -221,4 +365,81 @@ absl::StatusOr<PacketTestRuns> SendTestPacketsAndCollectOutputs(
   return result;
 }
 
+absl::StatusOr<PacketTestRuns> SendTestPacketsAndCollectOutputs(
+    absl::Span<const PacketInjectionShard> shards,
+    const PacketTestVectorById& packet_test_vector_by_id,
+    PacketStatistics& statistics,
+    std::optional<int> max_packets_to_send_per_second,
+    const IsExpectedUnsolicitedPacketFunctionType&
+        is_expected_unsolicited_packet,
+    const PacketInjectionOptions& options) {
+  // Partition the test vectors by the shard owning their input port.
+  absl::flat_hash_map<std::string, int> shard_by_port;
+  for (int i = 0; i < shards.size(); ++i) {
+    if (shards[i].sut == nullptr || shards[i].control_switch == nullptr) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Shard " << i << " is missing a P4Runtime session";
+    }
+    for (const std::string& port : shards[i].control_switch_ports) {
+      auto [it, inserted] = shard_by_port.insert({port, i});
+      if (!inserted) {
+        return gutil::InvalidArgumentErrorBuilder()
+               << "Port '" << port << "' belongs to both shard " << it->second
+               << " and shard " << i;
+      }
+    }
+  }
+  std::vector<PacketTestVectorById> test_vectors_by_shard(shards.size());
+  for (const auto& [id, packet_test_vector] : packet_test_vector_by_id) {
+    const std::string& port = packet_test_vector.input().packet().port();
+    auto it = shard_by_port.find(port);
+    if (it == shard_by_port.end()) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Test vector " << id << " is injected at port '" << port
+             << "', which does not belong to any shard";
+    }
+    test_vectors_by_shard[it->second][id] = packet_test_vector;
+  }
+
+  // Run the shards concurrently, each on its own sessions.
+  std::vector<absl::StatusOr<PacketTestRuns>> runs_by_shard(shards.size());
+  std::vector<PacketStatistics> statistics_by_shard(shards.size());
+  std::vector<std::thread> threads;
+  threads.reserve(shards.size());
+  for (int i = 0; i < shards.size(); ++i) {
+    if (test_vectors_by_shard[i].empty()) continue;
+    threads.emplace_back([&, i] {
+      runs_by_shard[i] = SendTestPacketsAndCollectOutputs(
+          *shards[i].sut, *shards[i].control_switch, test_vectors_by_shard[i],
+          statistics_by_shard[i], max_packets_to_send_per_second,
+          is_expected_unsolicited_packet, options);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  // Merge the test runs in order of test vector ID. Each shard returns its test
+  // runs in the order of its (ordered) test vectors.
+  absl::btree_map<int, PacketTestRun*> run_by_id;
+  for (int i = 0; i < shards.size(); ++i) {
+    if (test_vectors_by_shard[i].empty()) continue;
+    RETURN_IF_ERROR(runs_by_shard[i].status()) << "in shard " << i;
+    statistics.total_packets_injected +=
+        statistics_by_shard[i].total_packets_injected;
+    statistics.total_packets_forwarded +=
+        statistics_by_shard[i].total_packets_forwarded;
+    statistics.total_packets_punted +=
+        statistics_by_shard[i].total_packets_punted;
+    auto run = runs_by_shard[i]->mutable_test_runs()->begin();
+    for (const auto& [id, unused] : test_vectors_by_shard[i]) {
+      run_by_id[id] = &*run++;
+    }
+  }
+  PacketTestRuns result;
+  result.mutable_test_runs()->Reserve(run_by_id.size());
+  for (const auto& [id, run] : run_by_id) {
+    *result.add_test_runs() = std::move(*run);
+  }
+  return result;
+}
+
 }  // namespace dvaas
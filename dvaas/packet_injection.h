@@ -22,6 +22,8 @@
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "dvaas/test_vector.h"
 #include "dvaas/test_vector.pb.h"
 #include "p4_pdpi/ir.pb.h"
@@ -66,6 +68,21 @@ inline bool DefaultIsExpectedUnsolicitedPacket(
   return false;
 }
 
+// Tunes how test packets are injected and their outputs collected.
+struct PacketInjectionOptions {
+  // PacketOuts are translated up front and written to the stream in batches of
+  // up to this many buffered writes. When the injection rate is limited, it is
+  // kept by a token bucket with a burst of one batch.
+  int packet_out_batch_size = 100;
+  // Collection stops this long after the last packet was injected, even if
+  // some test vectors have not produced all of their expected outputs yet.
+  absl::Duration max_collection_duration = absl::Seconds(3);
+  // Once every test vector has produced as many outputs as its largest
+  // acceptable output, outputs are still collected for this long to catch
+  // unexpected additional packets.
+  absl::Duration settle_duration = absl::Milliseconds(200);
+};
+
 // Gets 'ingress_port' value from metadata in `packet_in`. Returns
 // InvalidArgumentError if 'ingress_port' metadata is missing.
 // TODO: Make this function private.
@@ -76,13 +93,44 @@ absl::StatusOr<std::string> GetIngressPortFromIrPacketIn(
 // - Injecting those packets to the control switch egress to send to the SUT.
 // - Determining the set of packets that were forwarded (punted from control
 //   switch) and punted (punted from SUT) for each input packet.
+//
+// Outputs are collected from both switches on dedicated threads while packets
+// are being injected. Collection ends early once every test vector is
+// accounted for (see `PacketInjectionOptions`).
 absl::StatusOr<PacketTestRuns> SendTestPacketsAndCollectOutputs(
     pdpi::P4RuntimeSession& sut, pdpi::P4RuntimeSession& control_switch,
     const PacketTestVectorById& packet_test_vector_by_id,
     PacketStatistics& statistics,
     std::optional<int> max_packets_to_send_per_second,
     const IsExpectedUnsolicitedPacketFunctionType&
-        is_expected_unsolicited_packet = DefaultIsExpectedUnsolicitedPacket);
+        is_expected_unsolicited_packet = DefaultIsExpectedUnsolicitedPacket,
+    const PacketInjectionOptions& options = {});
+
+// A SUT and control switch session pair driving the test packets injected at
+// the given control switch ports, e.g. the ports of one group of links.
+struct PacketInjectionShard {
+  pdpi::P4RuntimeSession* sut;
+  pdpi::P4RuntimeSession* control_switch;
+  absl::flat_hash_set<std::string> control_switch_ports;
+};
+
+// Like `SendTestPacketsAndCollectOutputs`, but partitions the test vectors by
+// the port they are injected at and runs each partition on its shard, all
+// shards concurrently. Returns the test runs of all shards, ordered by test
+// vector ID, and adds the packets of all shards to `statistics`.
+//
+// Every input port must belong to exactly one shard, and shards must not share
+// sessions: each shard only accounts for the tags of its own test vectors, so
+// its sessions must only receive the outputs of packets it injected.
+// `max_packets_to_send_per_second` limits each shard separately.
+absl::StatusOr<PacketTestRuns> SendTestPacketsAndCollectOutputs(
+    absl::Span<const PacketInjectionShard> shards,
+    const PacketTestVectorById& packet_test_vector_by_id,
+    PacketStatistics& statistics,
+    std::optional<int> max_packets_to_send_per_second,
+    const IsExpectedUnsolicitedPacketFunctionType&
+        is_expected_unsolicited_packet = DefaultIsExpectedUnsolicitedPacket,
+    const PacketInjectionOptions& options = {});
 
 }  // namespace dvaas
 
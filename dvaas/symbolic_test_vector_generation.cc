@@ -0,0 +1,279 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dvaas/symbolic_test_vector_generation.h"
+
+#include <bitset>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+#include "absl/types/span.h"
+#include "dvaas/test_vector.h"
+#include "dvaas/test_vector.pb.h"
+#include "glog/logging.h"
+#include "gutil/status.h"
+#include "p4_pdpi/netaddr/ipv4_address.h"
+#include "p4_pdpi/netaddr/mac_address.h"
+#include "p4_pdpi/packetlib/packetlib.h"
+#include "p4_pdpi/packetlib/packetlib.pb.h"
+#include "p4_symbolic/symbolic/symbolic.h"
+#include "z3++.h"
+
+namespace dvaas {
+namespace {
+
+using ::p4_symbolic::symbolic::ConcreteContext;
+using ::p4_symbolic::symbolic::ConcretePacket;
+using ::p4_symbolic::symbolic::SymbolicContext;
+
+constexpr uint32_t kIpv4EtherType = 0x0800;
+
+// Parses a value of a z3 model, i.e. `#x<hex>`, `#b<binary>`, or a decimal
+// number, of at most 64 bits.
+absl::StatusOr<uint64_t> ParseZ3Value(absl::string_view value) {
+  uint64_t result = 0;
+  absl::string_view digits = value;
+  if (absl::ConsumePrefix(&digits, "#x")) {
+    if (digits.size() <= 16 && absl::SimpleHexAtoi(digits, &result)) {
+      return result;
+    }
+  } else if (absl::ConsumePrefix(&digits, "#b")) {
+    if (!digits.empty() && digits.size() <= 64 &&
+        digits.find_first_not_of("01") == absl::string_view::npos) {
+      for (char digit : digits) result = (result << 1) | (digit - '0');
+      return result;
+    }
+  } else if (absl::SimpleAtoi(digits, &result)) {
+    return result;
+  }
+  return gutil::InvalidArgumentErrorBuilder()
+         << "Unexpected value in z3 model: '" << value << "'";
+}
+
+// Returns the Ethernet and, for IPv4 packets, the IPv4 header of `packet`,
+// followed by `payload`. Computed fields are left empty.
+absl::StatusOr<packetlib::Packet> ToPacketlibPacket(
+    const ConcretePacket& packet, absl::string_view payload) {
+  packetlib::Packet result;
+  packetlib::EthernetHeader& ethernet =
+      *result.add_headers()->mutable_ethernet_header();
+  ASSIGN_OR_RETURN(uint64_t eth_dst, ParseZ3Value(packet.eth_dst));
+  ASSIGN_OR_RETURN(uint64_t eth_src, ParseZ3Value(packet.eth_src));
+  ASSIGN_OR_RETURN(uint64_t eth_type, ParseZ3Value(packet.eth_type));
+  ethernet.set_ethernet_destination(
+      netaddr::MacAddress(std::bitset<48>(eth_dst)).ToString());
+  ethernet.set_ethernet_source(
+      netaddr::MacAddress(std::bitset<48>(eth_src)).ToString());
+  ethernet.set_ethertype(packetlib::EtherType(eth_type));
+
+  if (eth_type == kIpv4EtherType) {
+    packetlib::Ipv4Header& ipv4 = *result.add_headers()->mutable_ipv4_header();
+    ASSIGN_OR_RETURN(uint64_t ipv4_src, ParseZ3Value(packet.ipv4_src));
+    ASSIGN_OR_RETURN(uint64_t ipv4_dst, ParseZ3Value(packet.ipv4_dst));
+    ASSIGN_OR_RETURN(uint64_t dscp, ParseZ3Value(packet.dscp));
+    ASSIGN_OR_RETURN(uint64_t ttl, ParseZ3Value(packet.ttl));
+    ASSIGN_OR_RETURN(uint64_t protocol, ParseZ3Value(packet.protocol));
+    ipv4.set_dscp(packetlib::IpDscp(dscp));
+    ipv4.set_ecn(packetlib::IpEcn(0));
+    ipv4.set_identification(packetlib::IpIdentification(0));
+    ipv4.set_flags(packetlib::IpFlags(0));
+    ipv4.set_fragment_offset(packetlib::IpFragmentOffset(0));
+    ipv4.set_ttl(packetlib::IpTtl(ttl));
+    ipv4.set_protocol(packetlib::IpProtocol(protocol));
+    ipv4.set_ipv4_source(
+        netaddr::Ipv4Address(std::bitset<32>(ipv4_src)).ToString());
+    ipv4.set_ipv4_destination(
+        netaddr::Ipv4Address(std::bitset<32>(ipv4_dst)).ToString());
+  }
+  result.set_payload(std::string(payload));
+  return result;
+}
+
+// Returns the test vector packet for `packet` on `port`, i.e. with its
+// computed fields and padding filled in.
+absl::StatusOr<Packet> ToTestVectorPacket(const ConcretePacket& packet,
+                                          absl::string_view port,
+                                          absl::string_view payload) {
+  ASSIGN_OR_RETURN(uint64_t port_number, ParseZ3Value(port));
+  Packet result;
+  result.set_port(absl::StrCat(port_number));
+  ASSIGN_OR_RETURN(*result.mutable_parsed(),
+                   ToPacketlibPacket(packet, payload));
+  RETURN_IF_ERROR(
+      packetlib::PadPacketToMinimumSize(*result.mutable_parsed()).status());
+  RETURN_IF_ERROR(
+      packetlib::UpdateMissingComputedFields(*result.mutable_parsed())
+          .status());
+  ASSIGN_OR_RETURN(std::string raw_packet,
+                   packetlib::SerializePacket(result.parsed()));
+  result.set_hex(absl::BytesToHexString(raw_packet));
+  return result;
+}
+
+// Returns the test vector tagged with `id` for the packet found by the solver.
+absl::StatusOr<PacketTestVector> ToPacketTestVector(
+    int id, const ConcreteContext& packet) {
+  // Both packets carry the same payload, since it is not modified by the
+  // switch. Padding is added to the ingress packet only, and thus forwarded.
+  const std::string payload = absl::StrCat("test packet #", id, ":");
+
+  PacketTestVector test_vector;
+  SwitchInput& input = *test_vector.mutable_input();
+  input.set_type(SwitchInput::DATAPLANE);
+  ASSIGN_OR_RETURN(
+      *input.mutable_packet(),
+      ToTestVectorPacket(packet.ingress_packet, packet.ingress_port, payload));
+
+  SwitchOutput& output = *test_vector.add_acceptable_outputs();
+  if (packet.trace.dropped) return test_vector;
+  ASSIGN_OR_RETURN(
+      *output.add_packets(),
+      ToTestVectorPacket(packet.egress_packet, packet.egress_port,
+                         input.packet().parsed().payload()));
+  return test_vector;
+}
+
+// Returns an assertion that the packet hits entry `entry_index` of `table`,
+// or its default entry if `entry_index` is -1.
+p4_symbolic::symbolic::Assertion HitsEntry(std::string table,
+                                           int entry_index) {
+  return [table = std::move(table),
+          entry_index](const SymbolicContext& context) -> z3::expr {
+    auto it = context.trace.matched_entries.find(table);
+    if (it == context.trace.matched_entries.end()) {
+      return context.z3_context->bool_val(false);
+    }
+    return it->second.matched && it->second.entry_index == entry_index;
+  };
+}
+
+// Returns one goal per entry of the covered tables of `data_plane`, starting
+// with the default entry of each table.
+std::vector<EntryCoverageGoal> EntryCoverageGoals(
+    const p4_symbolic::symbolic::Dataplane& data_plane,
+    const SymbolicTestVectorGenerationParams& params) {
+  std::vector<std::string> table_names = params.table_names;
+  if (table_names.empty()) {
+    for (const auto& [table_name, entries] : data_plane.entries) {
+      if (!entries.empty()) table_names.push_back(table_name);
+    }
+  }
+
+  std::vector<EntryCoverageGoal> goals;
+  for (const std::string& table_name : table_names) {
+    auto entries = data_plane.entries.find(table_name);
+    const int num_entries =
+        entries == data_plane.entries.end() ? 0 : entries->second.size();
+    for (int entry_index = -1; entry_index < num_entries; ++entry_index) {
+      goals.push_back({.table_name = table_name, .entry_index = entry_index});
+    }
+  }
+  return goals;
+}
+
+}  // namespace
+
+absl::Status GenerateSymbolicPacketTestVectorsForGoals(
+    const p4_symbolic::symbolic::Dataplane& data_plane,
+    const SymbolicTestVectorGenerationParams& params,
+    absl::Span<const EntryCoverageGoal> goals, int first_id,
+    absl::FunctionRef<absl::Status(int id, TracedPacketTestVector test_vector)>
+        consume) {
+  std::vector<p4_symbolic::symbolic::Assertion> assertions;
+  assertions.reserve(goals.size());
+  for (const EntryCoverageGoal& goal : goals) {
+    assertions.push_back(HitsEntry(goal.table_name, goal.entry_index));
+  }
+
+  ASSIGN_OR_RETURN(
+      std::vector<std::optional<ConcreteContext>> packets,
+      p4_symbolic::symbolic::SolveConcurrently(
+          data_plane, params.physical_ports, params.hardcoded_parser,
+          assertions, params.num_threads, params.solver_options));
+
+  int next_id = first_id;
+  for (int i = 0; i < packets.size(); ++i) {
+    const auto& [table_name, entry_index] = goals[i];
+    if (!packets[i].has_value()) {
+      LOG(WARNING) << "No packet hits entry " << entry_index << " of table '"
+                   << table_name << "'; skipping it";
+      continue;
+    }
+    const int id = next_id++;
+    TracedPacketTestVector test_vector{.goal = goals[i]};
+    ASSIGN_OR_RETURN(test_vector.test_vector,
+                     ToPacketTestVector(id, *packets[i]),
+                     _ << " while building the test vector for entry "
+                       << entry_index << " of table '" << table_name << "'");
+    for (const auto& [table, match] : packets[i]->trace.matched_entries) {
+      if (match.matched) {
+        test_vector.entry_index_by_table[table] = match.entry_index;
+      }
+    }
+    RETURN_IF_ERROR(consume(id, std::move(test_vector)));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status GenerateSymbolicPacketTestVectors(
+    const p4_symbolic::symbolic::Dataplane& data_plane,
+    const SymbolicTestVectorGenerationParams& params,
+    PacketTestVectorConsumer consume) {
+  return GenerateSymbolicPacketTestVectorsForGoals(
+      data_plane, params, EntryCoverageGoals(data_plane, params),
+      /*first_id=*/1,
+      [&](int id, TracedPacketTestVector test_vector) -> absl::Status {
+        return consume(id, std::move(test_vector.test_vector));
+      });
+}
+
+absl::StatusOr<TracedPacketTestVectorById>
+GenerateTracedSymbolicPacketTestVectors(
+    const p4_symbolic::symbolic::Dataplane& data_plane,
+    const SymbolicTestVectorGenerationParams& params) {
+  TracedPacketTestVectorById test_vectors;
+  RETURN_IF_ERROR(GenerateSymbolicPacketTestVectorsForGoals(
+      data_plane, params, EntryCoverageGoals(data_plane, params),
+      /*first_id=*/1,
+      [&](int id, TracedPacketTestVector test_vector) -> absl::Status {
+        test_vectors.insert({id, std::move(test_vector)});
+        return absl::OkStatus();
+      }));
+  return test_vectors;
+}
+
+absl::StatusOr<PacketTestVectorById> GenerateSymbolicPacketTestVectors(
+    const p4_symbolic::symbolic::Dataplane& data_plane,
+    const SymbolicTestVectorGenerationParams& params) {
+  PacketTestVectorById test_vectors;
+  RETURN_IF_ERROR(GenerateSymbolicPacketTestVectors(
+      data_plane, params,
+      [&](int id, PacketTestVector test_vector) -> absl::Status {
+        test_vectors.insert({id, std::move(test_vector)});
+        return absl::OkStatus();
+      }));
+  return test_vectors;
+}
+
+}  // namespace dvaas
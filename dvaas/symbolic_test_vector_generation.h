@@ -0,0 +1,110 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_DVAAS_SYMBOLIC_TEST_VECTOR_GENERATION_H_
+#define PINS_DVAAS_SYMBOLIC_TEST_VECTOR_GENERATION_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "dvaas/test_vector.h"
+#include "dvaas/test_vector.pb.h"
+#include "p4_symbolic/symbolic/symbolic.h"
+
+namespace dvaas {
+
+// Parameters for generating packet test vectors with p4_symbolic.
+struct SymbolicTestVectorGenerationParams {
+  // The P4 port numbers packets may be received on.
+  std::vector<int> physical_ports;
+  // Whether p4_symbolic uses its hardcoded parser.
+  bool hardcoded_parser = true;
+  // The number of threads the coverage goals are solved on, each with its own
+  // solver state.
+  int num_threads = 1;
+  p4_symbolic::symbolic::SolverOptions solver_options;
+  // The tables whose entries are covered. If empty, every table with at least
+  // one entry is covered.
+  std::vector<std::string> table_names;
+};
+
+// The goal of hitting entry `entry_index` of table `table_name`, or its
+// default entry if `entry_index` is -1.
+struct EntryCoverageGoal {
+  std::string table_name;
+  int entry_index = -1;
+};
+
+// A test vector along with the goal it was generated for, and the trace of its
+// input packet in the data plane it was generated for.
+struct TracedPacketTestVector {
+  PacketTestVector test_vector;
+  EntryCoverageGoal goal;
+  // Maps the name of every table applied to the input packet to the index of
+  // the entry it hits, or to -1 if it hits the default entry.
+  absl::btree_map<std::string, int> entry_index_by_table;
+};
+
+using TracedPacketTestVectorById = absl::btree_map<int, TracedPacketTestVector>;
+
+// Called with every generated test vector and its id, in order of ids.
+using PacketTestVectorConsumer =
+    absl::FunctionRef<absl::Status(int id, PacketTestVector test_vector)>;
+
+// Generates one packet test vector per entry, and per default entry, of the
+// covered tables of `data_plane`, and passes each to `consume` as soon as it
+// is built, e.g. to inject it while the next ones are being built. Goals that
+// no packet can reach are skipped. Ids start at 1 and are embedded in the
+// payload of the input packet.
+//
+// Ports are the decimal P4 port numbers of the model. The expected output is
+// the one of the symbolic model: no packets if the packet is dropped, and
+// otherwise the egress packet on the egress port. Only the Ethernet and IPv4
+// fields modelled by p4_symbolic are taken from the solver; the others get
+// fixed values, and are expected to be forwarded unchanged.
+absl::Status GenerateSymbolicPacketTestVectors(
+    const p4_symbolic::symbolic::Dataplane& data_plane,
+    const SymbolicTestVectorGenerationParams& params,
+    PacketTestVectorConsumer consume);
+
+// Generates one packet test vector per goal in `goals` that some packet
+// reaches, with ids starting at `first_id`, and passes each to `consume` along
+// with its trace. `params.table_names` is ignored.
+absl::Status GenerateSymbolicPacketTestVectorsForGoals(
+    const p4_symbolic::symbolic::Dataplane& data_plane,
+    const SymbolicTestVectorGenerationParams& params,
+    absl::Span<const EntryCoverageGoal> goals, int first_id,
+    absl::FunctionRef<absl::Status(int id, TracedPacketTestVector test_vector)>
+        consume);
+
+// Returns the packet test vectors for every entry, and every default entry, of
+// the covered tables of `data_plane` by id, along with their traces.
+absl::StatusOr<TracedPacketTestVectorById>
+GenerateTracedSymbolicPacketTestVectors(
+    const p4_symbolic::symbolic::Dataplane& data_plane,
+    const SymbolicTestVectorGenerationParams& params);
+
+// Same as above, but returns all test vectors by id.
+absl::StatusOr<PacketTestVectorById> GenerateSymbolicPacketTestVectors(
+    const p4_symbolic::symbolic::Dataplane& data_plane,
+    const SymbolicTestVectorGenerationParams& params);
+
+}  // namespace dvaas
+
+#endif  // PINS_DVAAS_SYMBOLIC_TEST_VECTOR_GENERATION_H_
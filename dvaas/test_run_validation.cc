@@ -14,9 +14,12 @@
 
 #include "dvaas/test_run_validation.h"
 
+#include <algorithm>
+#include <atomic>
 #include <optional>
 #include <ostream>
 #include <string>
+#include <thread>  // NOLINT: third_party code.
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -30,6 +33,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "dvaas/output_writer.h"
@@ -44,7 +48,6 @@
 #include "gutil/status.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/packetlib/packetlib.pb.h"
-#include "re2/re2.h"
 
 namespace dvaas {
 
@@ -80,6 +83,13 @@ std::string Indent(int indentation, absl::string_view string) {
   return result;
 }
 
+// Returns true if `expected` and `actual` are known to have the same bytes.
+// Packets without bytes are compared structurally only.
+template <class P>
+bool HaveSameBytes(const P& expected, const P& actual) {
+  return !expected.hex().empty() && expected.hex() == actual.hex();
+}
+
 std::optional<pdpi::IrPacketMetadata> GetPacketInMetadataByName(
     const PacketIn& packet_in, absl::string_view target) {
   for (const auto& metadata : packet_in.metadata()) {
@@ -121,6 +131,9 @@ bool CompareSwitchOutputs(
   for (int i = 0; i < expected_output.packets_size(); ++i) {
     const Packet& actual_packet = actual_output.packets(i);
     const Packet& expected_packet = expected_output.packets(i);
+    // Identical bytes parse to identical headers, so the (comparatively
+    // expensive) structural diff can only fail on packets that differ.
+    if (HaveSameBytes(expected_packet, actual_packet)) continue;
     MessageDifferencer differ;
     for (auto* field : ignored_fields) differ.IgnoreField(field);
     std::string diff;
@@ -140,7 +153,8 @@ bool CompareSwitchOutputs(
     for (auto* field : ignored_fields) differ.IgnoreField(field);
     std::string diff;
     differ.ReportDifferencesToString(&diff);
-    if (!differ.Compare(expected_packet_in.parsed(),
+    if (!HaveSameBytes(expected_packet_in, actual_packet_in) &&
+        !differ.Compare(expected_packet_in.parsed(),
                         actual_packet_in.parsed())) {
       *listener << "has packet in " << i
                 << " with mismatched header fields:\n  " << Indent(2, diff);
@@ -319,16 +333,6 @@ static constexpr absl::string_view kExpectationBanner =
 
 }  // namespace
 
-absl::StatusOr<int> ExtractTestPacketTag(const packetlib::Packet& packet) {
-  // Regexp to extract the ID from a test packet's payload.
-  constexpr LazyRE2 kTestPacketIdRegexp{R"(test packet #([0-9]+):)"};
-  int tag;
-  if (RE2::PartialMatch(packet.payload(), *kTestPacketIdRegexp, &tag))
-    return tag;
-  return absl::InvalidArgumentError(absl::StrCat(
-      "Payload does not contain a packet id: ", packet.DebugString()));
-}
-
 PacketTestValidationResult ValidateTestRun(
     const PacketTestRun& test_run,
     const absl::flat_hash_set<std::string>& ignored_packet_in_metadata,
@@ -400,29 +404,91 @@ PacketTestValidationResult ValidateTestRun(
   return result;
 }
 
-absl::Status ValidateTestRuns(
+absl::StatusOr<TestRunFailureSummary> ValidateTestRunsAndSummarizeFailures(
     const PacketTestRuns& test_runs,
-    std::vector<const google::protobuf::FieldDescriptor*> ignored_fields,
+    const std::vector<const google::protobuf::FieldDescriptor*>&
+        ignored_fields,
     const absl::flat_hash_set<std::string>& ignored_metadata,
-    const OutputWriterFunctionType& write_failures) {
-  LOG(INFO) << "Validating test runs";
+    const OutputWriterFunctionType& write_failure,
+    const ValidateTestRunsOptions& options) {
+  const int num_test_runs = test_runs.test_runs_size();
+  const int num_threads =
+      std::clamp(options.num_threads, 1, std::max(num_test_runs, 1));
+
+  // Workers claim test runs in order through `next_to_validate` and publish
+  // their results under `mutex`, so that the calling thread can write the
+  // failures in order while later test runs are still being validated.
+  std::atomic<int> next_to_validate = 0;
+  absl::Mutex mutex;
+  std::vector<std::optional<PacketTestValidationResult>> results(
+      num_test_runs);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&] {
+      for (int index = next_to_validate++; index < num_test_runs;
+           index = next_to_validate++) {
+        PacketTestValidationResult result = ValidateTestRun(
+            test_runs.test_runs(index), ignored_metadata, ignored_fields);
+        absl::MutexLock lock(&mutex);
+        results[index] = std::move(result);
+      }
+    });
+  }
 
-  std::vector<std::string> failures;
-  for (const PacketTestRun& test_run : test_runs.test_runs()) {
-    PacketTestValidationResult result =
-        ValidateTestRun(test_run, ignored_metadata, ignored_fields);
-    if (result.has_failure()) {
-      failures.push_back(result.failure().description());
+  TestRunFailureSummary summary;
+  absl::Status write_status;
+  for (int index = 0; index < num_test_runs; ++index) {
+    PacketTestValidationResult result;
+    {
+      absl::MutexLock lock(&mutex);
+      auto validated = [&]() { return results[index].has_value(); };
+      mutex.Await(absl::Condition(&validated));
+      result = *std::move(results[index]);
+      results[index].reset();
     }
+    if (!result.has_failure()) continue;
+    const std::string& failure = result.failure().description();
+    if (summary.num_failures++ == 0) summary.first_failure = failure;
+    if (write_status.ok()) write_status = write_failure(failure);
   }
+  for (std::thread& thread : threads) thread.join();
+
+  RETURN_IF_ERROR(write_status);
+  return summary;
+}
 
-  RETURN_IF_ERROR(write_failures(absl::StrJoin(failures, "\n\n")));
+absl::Status ValidateTestRuns(
+    const PacketTestRuns& test_runs,
+    std::vector<const google::protobuf::FieldDescriptor*> ignored_fields,
+    const absl::flat_hash_set<std::string>& ignored_metadata,
+    const OutputWriterFunctionType& write_failures,
+    const ValidateTestRunsOptions& options) {
+  LOG(INFO) << "Validating test runs";
 
-  if (!failures.empty()) {
+  bool wrote_failure = false;
+  ASSIGN_OR_RETURN(
+      const TestRunFailureSummary summary,
+      ValidateTestRunsAndSummarizeFailures(
+          test_runs, ignored_fields, ignored_metadata,
+          /*write_failure=*/
+          [&](absl::string_view failure) {
+            if (!wrote_failure) {
+              wrote_failure = true;
+              return write_failures(failure);
+            }
+            return write_failures(absl::StrCat("\n\n", failure));
+          },
+          options));
+
+  // Always write, so that the artifact exists even if there are no failures.
+  if (summary.num_failures == 0) RETURN_IF_ERROR(write_failures(""));
+
+  if (summary.num_failures > 0) {
     return gutil::FailedPreconditionErrorBuilder()
-           << failures.size()
+           << summary.num_failures
            << " failures among test results. Showing only the first failure.\n"
-           << failures[0]
+           << summary.first_failure
            << "\nRefer to the test artifacts for the full list of failures.";
   }
 
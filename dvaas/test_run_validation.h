@@ -20,6 +20,7 @@
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "dvaas/output_writer.h"
 #include "dvaas/test_vector.pb.h"
@@ -38,13 +39,42 @@ PacketTestValidationResult ValidateTestRun(
     const std::vector<const google::protobuf::FieldDescriptor*>&
         ignored_fields = {});
 
-// Like `ValidateTestRun`, but for a collection of `test_runs`. Also
-// writes the results to a test artifact using `write_failures`.
+struct ValidateTestRunsOptions {
+  // The number of threads validating test runs concurrently.
+  int num_threads = 8;
+};
+
+// The failures found while validating a collection of test runs.
+struct TestRunFailureSummary {
+  int num_failures = 0;
+  // The description of the first failure, in the order of the test runs.
+  std::string first_failure;
+};
+
+// Validates the given `test_runs` concurrently, like `ValidateTestRuns`, and
+// calls `write_failure` on the calling thread with the description of each
+// failure, in the order of `test_runs`, as soon as that failure and all
+// failures before it are known. Only returns an error if `write_failure` does;
+// the failures themselves are returned in the summary.
+absl::StatusOr<TestRunFailureSummary> ValidateTestRunsAndSummarizeFailures(
+    const PacketTestRuns& test_runs,
+    const std::vector<const google::protobuf::FieldDescriptor*>&
+        ignored_fields,
+    const absl::flat_hash_set<std::string>& ignored_metadata,
+    const OutputWriterFunctionType& write_failure,
+    const ValidateTestRunsOptions& options = {});
+
+// Like `ValidateTestRun`, but for a collection of `test_runs`, which are
+// validated concurrently. Also writes the failures to a test artifact using
+// `write_failures`, which is called on the calling thread, once per failure
+// (separated by blank lines) and in the order of `test_runs`, as soon as that
+// failure and all failures before it are known.
 absl::Status ValidateTestRuns(
     const PacketTestRuns& test_runs,
     std::vector<const google::protobuf::FieldDescriptor*> ignored_fields,
     const absl::flat_hash_set<std::string>& ignored_metadata,
-    const OutputWriterFunctionType& write_failures);
+    const OutputWriterFunctionType& write_failures,
+    const ValidateTestRunsOptions& options = {});
 
 }  // namespace dvaas
 
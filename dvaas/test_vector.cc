@@ -22,6 +22,9 @@
 
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
@@ -39,8 +42,8 @@
 #include "gutil/proto.h"
 #include "gutil/status.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/packetlib/packet_view.h"
 #include "p4_pdpi/packetlib/packetlib.pb.h"
-#include "re2/re2.h"
 
 namespace dvaas {
 namespace {
@@ -315,15 +318,44 @@ static constexpr absl::string_view kExpectationBanner =
 }  // namespace
 
 absl::StatusOr<int> ExtractTestPacketTag(const packetlib::Packet& packet) {
-  // Regexp to extract the ID from a test packet's payload.
-  constexpr LazyRE2 kTestPacketIdRegexp{R"(test packet #([0-9]+):)"};
-  int tag;
-  if (RE2::PartialMatch(packet.payload(), *kTestPacketIdRegexp, &tag))
-    return tag;
+  absl::StatusOr<int> tag = ExtractTestPacketTag(packet.payload());
+  if (tag.ok()) return tag;
   return absl::InvalidArgumentError(absl::StrCat(
       "Payload does not contain a packet id: ", packet.DebugString()));
 }
 
+absl::StatusOr<int> ExtractTestPacketTag(const packetlib::PacketView& packet) {
+  absl::StatusOr<int> tag = ExtractTestPacketTag(packet.payload());
+  if (tag.ok()) return tag;
+  return absl::InvalidArgumentError(
+      absl::StrCat("Payload does not contain a packet id: ",
+                   packet.ToPacket().DebugString()));
+}
+
+absl::StatusOr<int> ExtractTestPacketTag(absl::string_view payload) {
+  // Finds the first match of the regular expression `test packet #([0-9]+):`.
+  // Test packets are tagged at the start of their payload, so in practice the
+  // first `find` returns 0.
+  constexpr absl::string_view kTagPrefix = "test packet #";
+  for (size_t pos = payload.find(kTagPrefix); pos != absl::string_view::npos;
+       pos = payload.find(kTagPrefix, pos + 1)) {
+    const absl::string_view rest = payload.substr(pos + kTagPrefix.size());
+    size_t num_digits = 0;
+    while (num_digits < rest.size() && absl::ascii_isdigit(rest[num_digits])) {
+      ++num_digits;
+    }
+    int tag;
+    if (num_digits > 0 && num_digits < rest.size() &&
+        rest[num_digits] == ':' &&
+        absl::SimpleAtoi(rest.substr(0, num_digits), &tag)) {
+      return tag;
+    }
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Payload does not contain a packet id: ",
+                   absl::CEscape(payload)));
+}
+
 absl::StatusOr<std::string> GetIngressPortFromIrPacketIn(
     const pdpi::IrPacketIn& packet_in) {
   for (const auto& metadata : packet_in.metadata()) {
@@ -22,10 +22,12 @@
 #include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "dvaas/test_vector.pb.h"
 #include "google/protobuf/descriptor.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/packetlib/packet_view.h"
 
 namespace dvaas {
 
@@ -34,6 +36,11 @@ namespace dvaas {
 // TODO: Implement and use a unified (open-source) API for test
 // packet tag embedding and extraction.
 absl::StatusOr<int> ExtractTestPacketTag(const packetlib::Packet& packet);
+// Same as above, but reads the payload directly from the raw packet.
+absl::StatusOr<int> ExtractTestPacketTag(const packetlib::PacketView& packet);
+// Same as above, but for the payload of a packet. Does not copy or parse the
+// payload, and finds tags at the start of the payload in constant time.
+absl::StatusOr<int> ExtractTestPacketTag(absl::string_view payload);
 
 // Needed to make gUnit produce human-readable output in open source.
 inline std::ostream& operator<<(std::ostream& os, const SwitchOutput& output) {
@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_GUTIL_ADAPTIVE_RATE_CONTROLLER_H_
+#define PINS_GUTIL_ADAPTIVE_RATE_CONTROLLER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+namespace gutil {
+
+struct AdaptiveRateOptions {
+  // All rates are in units of work (e.g. packets) per second.
+  double initial_rate = 100;
+  double min_rate = 1;
+  double max_rate = 100000;
+  // Until the first loss, the rate is multiplied by this factor after every
+  // interval without loss.
+  double ramp_up_factor = 2;
+  // After the first loss, the rate grows by this fraction after every interval
+  // without loss, probing carefully for a higher sustainable rate.
+  double probe_increase = 0.05;
+  // The rate is multiplied by this factor after every interval with loss.
+  double back_off_factor = 0.5;
+  // The fraction of work that may be lost in an interval without counting as
+  // loss.
+  double loss_tolerance = 0;
+};
+
+// Finds the highest rate at which work (e.g. injected packets) is not lost, by
+// ramping up quickly until the first loss and then backing off on loss and
+// probing upwards slowly otherwise (like TCP congestion control). Callers work
+// at `rate()` for an interval and report how much work was lost.
+//
+// Not thread-safe.
+class AdaptiveRateController {
+ public:
+  explicit AdaptiveRateController(const AdaptiveRateOptions& options = {})
+      : options_(options),
+        rate_(std::clamp(options.initial_rate, options.min_rate,
+                         options.max_rate)) {}
+
+  // The rate to work at during the next interval.
+  double rate() const { return rate_; }
+
+  // The highest rate at which an interval saw no loss, if any.
+  std::optional<double> sustained_max_rate() const {
+    return sustained_max_rate_;
+  }
+
+  // Reports that `num_lost` out of `num_sent` units of work were lost in an
+  // interval worked at `rate()`, and adapts the rate accordingly.
+  void ReportInterval(int64_t num_sent, int64_t num_lost) {
+    if (num_sent <= 0) return;
+    if (num_lost > options_.loss_tolerance * num_sent) {
+      saw_loss_ = true;
+      rate_ *= options_.back_off_factor;
+    } else {
+      sustained_max_rate_ = std::max(sustained_max_rate_.value_or(0), rate_);
+      rate_ *= saw_loss_ ? 1 + options_.probe_increase
+                         : options_.ramp_up_factor;
+    }
+    rate_ = std::clamp(rate_, options_.min_rate, options_.max_rate);
+  }
+
+ private:
+  AdaptiveRateOptions options_;
+  double rate_;
+  bool saw_loss_ = false;
+  std::optional<double> sustained_max_rate_;
+};
+
+}  // namespace gutil
+
+#endif  // PINS_GUTIL_ADAPTIVE_RATE_CONTROLLER_H_
@@ -0,0 +1,78 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gutil/adaptive_rate_controller.h"
+
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace gutil {
+namespace {
+
+using ::testing::DoubleEq;
+using ::testing::Optional;
+
+TEST(AdaptiveRateControllerTest, RampsUpUntilFirstLoss) {
+  AdaptiveRateController controller({.initial_rate = 10, .max_rate = 1000});
+  EXPECT_EQ(controller.sustained_max_rate(), std::nullopt);
+
+  controller.ReportInterval(/*num_sent=*/10, /*num_lost=*/0);
+  EXPECT_THAT(controller.rate(), DoubleEq(20));
+  controller.ReportInterval(/*num_sent=*/20, /*num_lost=*/0);
+  EXPECT_THAT(controller.rate(), DoubleEq(40));
+  EXPECT_THAT(controller.sustained_max_rate(), Optional(DoubleEq(20)));
+}
+
+TEST(AdaptiveRateControllerTest, BacksOffOnLossAndThenProbesSlowly) {
+  AdaptiveRateController controller(
+      {.initial_rate = 100, .probe_increase = 0.1, .back_off_factor = 0.5});
+  controller.ReportInterval(/*num_sent=*/100, /*num_lost=*/0);
+  controller.ReportInterval(/*num_sent=*/200, /*num_lost=*/5);
+  EXPECT_THAT(controller.rate(), DoubleEq(100));
+
+  controller.ReportInterval(/*num_sent=*/100, /*num_lost=*/0);
+  EXPECT_THAT(controller.rate(), DoubleEq(110));
+  EXPECT_THAT(controller.sustained_max_rate(), Optional(DoubleEq(100)));
+}
+
+TEST(AdaptiveRateControllerTest, ToleratesConfiguredLoss) {
+  AdaptiveRateController controller(
+      {.initial_rate = 100, .loss_tolerance = 0.01});
+  controller.ReportInterval(/*num_sent=*/1000, /*num_lost=*/10);
+  EXPECT_THAT(controller.rate(), DoubleEq(200));
+  controller.ReportInterval(/*num_sent=*/1000, /*num_lost=*/11);
+  EXPECT_THAT(controller.rate(), DoubleEq(100));
+}
+
+TEST(AdaptiveRateControllerTest, StaysWithinBounds) {
+  AdaptiveRateController controller(
+      {.initial_rate = 5, .min_rate = 4, .max_rate = 8});
+  controller.ReportInterval(/*num_sent=*/5, /*num_lost=*/0);
+  EXPECT_THAT(controller.rate(), DoubleEq(8));
+  controller.ReportInterval(/*num_sent=*/8, /*num_lost=*/8);
+  controller.ReportInterval(/*num_sent=*/4, /*num_lost=*/4);
+  EXPECT_THAT(controller.rate(), DoubleEq(4));
+}
+
+TEST(AdaptiveRateControllerTest, IgnoresEmptyIntervals) {
+  AdaptiveRateController controller({.initial_rate = 50});
+  controller.ReportInterval(/*num_sent=*/0, /*num_lost=*/0);
+  EXPECT_THAT(controller.rate(), DoubleEq(50));
+  EXPECT_EQ(controller.sustained_max_rate(), std::nullopt);
+}
+
+}  // namespace
+}  // namespace gutil
@@ -0,0 +1,96 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gutil/binary_proto_records.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/any.pb.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/util/delimited_message_util.h"
+#include "gutil/proto.h"
+#include "gutil/status.h"
+
+namespace gutil {
+
+std::string SerializeBinaryProtoRecord(
+    const google::protobuf::Message& message) {
+  google::protobuf::Any any;
+  any.PackFrom(message);
+  std::string record;
+  {
+    google::protobuf::io::StringOutputStream output(&record);
+    google::protobuf::util::SerializeDelimitedToZeroCopyStream(any, &output);
+  }
+  return record;
+}
+
+absl::StatusOr<std::vector<google::protobuf::Any>> ParseBinaryProtoRecords(
+    absl::string_view records) {
+  google::protobuf::io::ArrayInputStream input(records.data(), records.size());
+  google::protobuf::io::CodedInputStream coded_input(&input);
+  std::vector<google::protobuf::Any> result;
+  while (coded_input.CurrentPosition() < static_cast<int>(records.size())) {
+    bool clean_eof = false;
+    if (!google::protobuf::util::ParseDelimitedFromCodedStream(
+            &result.emplace_back(), &coded_input, &clean_eof)) {
+      return gutil::DataLossErrorBuilder()
+             << "failed to parse binary proto record #" << result.size()
+             << " at byte offset " << coded_input.CurrentPosition();
+    }
+  }
+  return result;
+}
+
+absl::StatusOr<std::string> BinaryProtoRecordsToText(
+    absl::string_view records) {
+  ASSIGN_OR_RETURN(std::vector<google::protobuf::Any> anys,
+                   ParseBinaryProtoRecords(records));
+  std::string text;
+  for (const google::protobuf::Any& any : anys) {
+    std::string type_name;
+    const google::protobuf::Descriptor* descriptor = nullptr;
+    if (google::protobuf::Any::ParseAnyTypeUrl(any.type_url(), &type_name)) {
+      descriptor = google::protobuf::DescriptorPool::generated_pool()
+                       ->FindMessageTypeByName(type_name);
+    }
+    if (descriptor == nullptr) {
+      absl::StrAppend(&text, "# google.protobuf.Any of unknown type '",
+                      any.type_url(), "'\n", PrintTextProto(any), "\n");
+      continue;
+    }
+    std::unique_ptr<google::protobuf::Message> message(
+        google::protobuf::MessageFactory::generated_factory()
+            ->GetPrototype(descriptor)
+            ->New());
+    if (!any.UnpackTo(message.get())) {
+      return gutil::DataLossErrorBuilder()
+             << "failed to parse binary proto record of type '" << type_name
+             << "'";
+    }
+    absl::StrAppend(&text, "# ", type_name, "\n", PrintTextProto(*message),
+                    "\n");
+  }
+  return text;
+}
+
+}  // namespace gutil
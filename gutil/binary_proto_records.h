@@ -0,0 +1,54 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_GUTIL_BINARY_PROTO_RECORDS_H_
+#define PINS_GUTIL_BINARY_PROTO_RECORDS_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/any.pb.h"
+#include "google/protobuf/message.h"
+
+namespace gutil {
+
+// A compact binary format for streams of protos of arbitrary types, e.g. large
+// test artifacts. Serializing a proto is much cheaper than printing it as text,
+// so writers emit this format and the text view is produced offline (e.g. with
+// `binary_proto_records_to_text`).
+//
+// A stream is a concatenation of records. Each record is a
+// `google.protobuf.Any` packing the proto, prefixed by its varint-encoded size
+// (i.e. length-delimited, as `SerializeDelimitedToOstream` writes). Streams can
+// be concatenated, so appending records to a file is fine.
+
+// Returns `message` as one record.
+std::string SerializeBinaryProtoRecord(
+    const google::protobuf::Message& message);
+
+// Returns the records of `records`, in order.
+absl::StatusOr<std::vector<google::protobuf::Any>> ParseBinaryProtoRecords(
+    absl::string_view records);
+
+// Returns the text view of `records`: every record is printed as a text proto,
+// preceded by a comment naming its type. Records of types not linked into the
+// binary are printed as `google.protobuf.Any`.
+absl::StatusOr<std::string> BinaryProtoRecordsToText(
+    absl::string_view records);
+
+}  // namespace gutil
+
+#endif  // PINS_GUTIL_BINARY_PROTO_RECORDS_H_
@@ -0,0 +1,94 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gutil/binary_proto_records.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/any.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/proto_test.pb.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+
+namespace gutil {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+
+TEST(BinaryProtoRecordsTest, RoundTripsConcatenatedRecords) {
+  const auto message =
+      ParseProtoOrDie<TestMessage>(R"pb(int_field: 42 string_field: "hi")pb");
+  const auto another_message =
+      ParseProtoOrDie<AnotherTestMessage>(R"pb(int_field: 7)pb");
+  const std::string records =
+      absl::StrCat(SerializeBinaryProtoRecord(message),
+                   SerializeBinaryProtoRecord(another_message));
+
+  ASSERT_OK_AND_ASSIGN(std::vector<google::protobuf::Any> anys,
+                       ParseBinaryProtoRecords(records));
+  ASSERT_EQ(anys.size(), 2);
+  TestMessage parsed_message;
+  ASSERT_TRUE(anys[0].UnpackTo(&parsed_message));
+  EXPECT_THAT(parsed_message, EqualsProto(message));
+  AnotherTestMessage parsed_another_message;
+  ASSERT_TRUE(anys[1].UnpackTo(&parsed_another_message));
+  EXPECT_THAT(parsed_another_message, EqualsProto(another_message));
+}
+
+TEST(BinaryProtoRecordsTest, ParsesEmptyStreams) {
+  EXPECT_THAT(ParseBinaryProtoRecords(""), IsOkAndHolds(IsEmpty()));
+}
+
+TEST(BinaryProtoRecordsTest, RejectsTruncatedRecords) {
+  std::string record =
+      SerializeBinaryProtoRecord(ParseProtoOrDie<TestMessage>(
+          R"pb(string_field: "truncated")pb"));
+  record.resize(record.size() - 1);
+  EXPECT_THAT(ParseBinaryProtoRecords(record),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(BinaryProtoRecordsTest, PrintsRecordsAsTextProtos) {
+  EXPECT_THAT(BinaryProtoRecordsToText(SerializeBinaryProtoRecord(
+                  ParseProtoOrDie<TestMessage>(R"pb(int_field: 42)pb"))),
+              IsOkAndHolds("# gutil.TestMessage\nint_field: 42\n\n"));
+}
+
+TEST(BinaryProtoRecordsTest, PrintsRecordsOfUnknownTypesAsAny) {
+  google::protobuf::Any any;
+  any.set_type_url("type.googleapis.com/not.a.Type");
+  const std::string serialized_any = any.SerializeAsString();
+  // A record is the serialized Any prefixed by its varint-encoded size, which
+  // is a single byte for sizes below 128.
+  ASSERT_LT(serialized_any.size(), 128);
+  const std::string record =
+      absl::StrCat(std::string(1, serialized_any.size()), serialized_any);
+
+  ASSERT_OK_AND_ASSIGN(std::string text, BinaryProtoRecordsToText(record));
+  EXPECT_THAT(text, HasSubstr("google.protobuf.Any of unknown type"));
+  EXPECT_THAT(text, HasSubstr("not.a.Type"));
+}
+
+}  // namespace
+}  // namespace gutil
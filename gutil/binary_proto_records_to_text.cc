@@ -0,0 +1,88 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Prints the text view of a binary proto records file (see
+// gutil/binary_proto_records.h), e.g. a test artifact written with
+// `TestArtifactWriter::AppendToBinaryTestArtifact`.
+#include <iostream>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "google/protobuf/descriptor.h"
+#include "gutil/binary_proto_records.h"
+#include "gutil/io.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+
+ABSL_FLAG(std::string, input, "", "Binary proto records file (required)");
+ABSL_FLAG(std::string, output, "",
+          "Text file to write; writes to stdout if empty");
+
+constexpr absl::string_view kUsage = "--input=<file> [--output=<file>]";
+
+// Records are printed as text only if their type is linked into this binary.
+// Referencing the descriptors of the types commonly stored as test artifacts
+// ensures that the linker keeps them.
+[[maybe_unused]] const google::protobuf::Descriptor* const kLinkedTypes[] = {
+    p4::config::v1::P4Info::descriptor(),
+    p4::v1::ReadResponse::descriptor(),
+    p4::v1::StreamMessageResponse::descriptor(),
+    p4::v1::WriteRequest::descriptor(),
+    pdpi::IrEntities::descriptor(),
+    pdpi::IrP4Info::descriptor(),
+    pdpi::IrWriteRequest::descriptor(),
+};
+
+int main(int argc, char** argv) {
+  absl::SetProgramUsageMessage(
+      absl::Substitute("usage: $0 $1", argv[0], kUsage));
+  absl::ParseCommandLine(argc, argv);
+
+  const std::string input = absl::GetFlag(FLAGS_input);
+  if (input.empty()) {
+    std::cerr << "Missing argument: --input=<file>" << std::endl;
+    return 1;
+  }
+  absl::StatusOr<std::string> records = gutil::ReadFile(input);
+  if (!records.ok()) {
+    std::cerr << absl::Substitute("Failed to read '$0': $1\n", input,
+                                  records.status().message());
+    return 1;
+  }
+  absl::StatusOr<std::string> text = gutil::BinaryProtoRecordsToText(*records);
+  if (!text.ok()) {
+    std::cerr << absl::Substitute("Failed to convert '$0': $1\n", input,
+                                  text.status().message());
+    return 1;
+  }
+
+  const std::string output = absl::GetFlag(FLAGS_output);
+  if (output.empty()) {
+    std::cout << *text;
+    return 0;
+  }
+  if (absl::Status status = gutil::WriteFile(*text, output); !status.ok()) {
+    std::cerr << absl::Substitute("Failed to write '$0': $1\n", output,
+                                  status.message());
+    return 1;
+  }
+  return 0;
+}
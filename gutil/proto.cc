@@ -15,16 +15,29 @@
 #include "gutil/proto.h"
 
 #include <fcntl.h>
-
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <string>
+#include <utility>
 
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/text_format.h"
+#include "google/protobuf/util/delimited_message_util.h"
 #include "gutil/proto_string_error_collector.h"
 #include "gutil/status.h"
 
@@ -34,22 +47,74 @@ bool IsEmptyProto(const google::protobuf::Message &message) {
   return message.ByteSizeLong() == 0;
 }
 
-absl::Status ReadProtoFromFile(absl::string_view filename,
-                               google::protobuf::Message *message) {
-  // Verifies that the version of the library that we linked against is
-  // compatible with the version of the headers we compiled against.
-  GOOGLE_PROTOBUF_VERIFY_VERSION;
+namespace {
 
+bool IsBinaryProtoFile(absl::string_view filename) {
+  return absl::EndsWith(filename, kBinaryProtoFileExtension);
+}
+
+// A read-only memory mapping of a whole file.
+struct MappedFile {
+  // nullptr for empty files, which cannot be mapped.
+  const void *data = nullptr;
+  size_t size = 0;
+};
+
+absl::StatusOr<MappedFile> MapFile(absl::string_view filename) {
   int fd = open(std::string(filename).c_str(), O_RDONLY);
   if (fd < 0) {
     return InvalidArgumentErrorBuilder()
            << "Error opening the file " << filename;
   }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    const int error = errno;
+    close(fd);
+    return InternalErrorBuilder() << "Error reading the size of the file "
+                                  << filename << ": " << std::strerror(error);
+  }
+  // Protobuf streams address at most 2 GiB.
+  if (file_stat.st_size > std::numeric_limits<int>::max()) {
+    close(fd);
+    return InvalidArgumentErrorBuilder()
+           << "File " << filename << " exceeds the 2 GiB limit of protobufs";
+  }
+  MappedFile file{.size = static_cast<size_t>(file_stat.st_size)};
+  if (file.size > 0) {
+    void *data = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      const int error = errno;
+      close(fd);
+      return InternalErrorBuilder() << "Error mapping the file " << filename
+                                    << ": " << std::strerror(error);
+    }
+    file.data = data;
+  }
+  // The mapping stays valid after closing the file.
+  close(fd);
+  return file;
+}
 
-  google::protobuf::io::FileInputStream file_stream(fd);
-  file_stream.SetCloseOnDelete(true);
+void UnmapFile(const MappedFile &file) {
+  if (file.data != nullptr) munmap(const_cast<void *>(file.data), file.size);
+}
+
+}  // namespace
+
+absl::Status ReadProtoFromFile(absl::string_view filename,
+                               google::protobuf::Message *message) {
+  // Verifies that the version of the library that we linked against is
+  // compatible with the version of the headers we compiled against.
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
 
-  if (!google::protobuf::TextFormat::Parse(&file_stream, message)) {
+  ASSIGN_OR_RETURN(MappedFile file, MapFile(filename));
+  google::protobuf::io::ArrayInputStream file_stream(file.data, file.size);
+  const bool parsed = IsBinaryProtoFile(filename)
+                          ? message->ParseFromZeroCopyStream(&file_stream)
+                          : google::protobuf::TextFormat::Parse(&file_stream,
+                                                                message);
+  UnmapFile(file);
+  if (!parsed) {
     return InvalidArgumentErrorBuilder() << "Failed to parse file " << filename;
   }
 
@@ -67,7 +132,9 @@ absl::Status ReadProtoFromString(absl::string_view proto_string,
   StringErrorCollector collector(&all_errors);
   parser.RecordErrorsTo(&collector);
 
-  if (!parser.ParseFromString(std::string(proto_string), message)) {
+  google::protobuf::io::ArrayInputStream input(proto_string.data(),
+                                              proto_string.size());
+  if (!parser.Parse(&input, message)) {
     return InvalidArgumentErrorBuilder()
            << "string <" << proto_string << "> did not parse as a"
            << message->GetTypeName() << ":\n"
@@ -82,7 +149,8 @@ absl::Status SaveProtoToFile(absl::string_view filename,
   // Verifies that the version of the library that we linked against is
   // compatible with the version of the headers we compiled against.
   GOOGLE_PROTOBUF_VERIFY_VERSION;
-  int fd = open(std::string(filename).c_str(), O_WRONLY | O_CREAT, 0644);
+  int fd =
+      open(std::string(filename).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
   if (fd < 0) {
     return InvalidArgumentErrorBuilder()
            << "Error opening the file " << filename;
@@ -91,7 +159,11 @@ absl::Status SaveProtoToFile(absl::string_view filename,
   google::protobuf::io::FileOutputStream file_stream(fd);
   file_stream.SetCloseOnDelete(true);
 
-  if (!google::protobuf::TextFormat::Print(message, &file_stream)) {
+  const bool written =
+      IsBinaryProtoFile(filename)
+          ? message.SerializeToZeroCopyStream(&file_stream)
+          : google::protobuf::TextFormat::Print(message, &file_stream);
+  if (!written) {
     return InvalidArgumentErrorBuilder()
            << "Failed to print proto to file " << filename;
   }
@@ -100,6 +172,90 @@ absl::Status SaveProtoToFile(absl::string_view filename,
   return absl::OkStatus();
 }
 
+// -- DelimitedProtoFileReader -------------------------------------------------
+
+absl::StatusOr<std::unique_ptr<DelimitedProtoFileReader>>
+DelimitedProtoFileReader::Open(absl::string_view filename) {
+  ASSIGN_OR_RETURN(MappedFile file, MapFile(filename));
+  return absl::WrapUnique(new DelimitedProtoFileReader(
+      std::string(filename), file.data, file.size));
+}
+
+DelimitedProtoFileReader::DelimitedProtoFileReader(std::string filename,
+                                                   const void *data,
+                                                   size_t size)
+    : filename_(std::move(filename)),
+      data_(data),
+      size_(size),
+      input_(data, size) {}
+
+DelimitedProtoFileReader::~DelimitedProtoFileReader() {
+  UnmapFile(MappedFile{.data = data_, .size = size_});
+}
+
+absl::StatusOr<bool> DelimitedProtoFileReader::ReadNext(
+    google::protobuf::Message &message) {
+  bool clean_eof = false;
+  if (google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+          &message, &input_, &clean_eof)) {
+    ++num_messages_read_;
+    return true;
+  }
+  if (clean_eof) return false;
+  return DataLossErrorBuilder()
+         << "Failed to parse message #" << num_messages_read_ << " of type "
+         << message.GetTypeName() << " from file " << filename_;
+}
+
+// -- DelimitedProtoFileWriter -------------------------------------------------
+
+absl::StatusOr<std::unique_ptr<DelimitedProtoFileWriter>>
+DelimitedProtoFileWriter::Create(absl::string_view filename) {
+  int fd =
+      open(std::string(filename).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return InvalidArgumentErrorBuilder()
+           << "Error opening the file " << filename;
+  }
+  // Not closed on delete: `Close` closes it, and protobuf crashes when a stream
+  // is closed twice.
+  auto output = std::make_unique<google::protobuf::io::FileOutputStream>(fd);
+  return absl::WrapUnique(
+      new DelimitedProtoFileWriter(std::string(filename), std::move(output)));
+}
+
+DelimitedProtoFileWriter::DelimitedProtoFileWriter(
+    std::string filename,
+    std::unique_ptr<google::protobuf::io::FileOutputStream> output)
+    : filename_(std::move(filename)), output_(std::move(output)) {}
+
+DelimitedProtoFileWriter::~DelimitedProtoFileWriter() { Close().IgnoreError(); }
+
+absl::Status DelimitedProtoFileWriter::Write(
+    const google::protobuf::Message &message) {
+  if (output_ == nullptr) {
+    return FailedPreconditionErrorBuilder()
+           << "File " << filename_ << " has already been closed";
+  }
+  if (!google::protobuf::util::SerializeDelimitedToZeroCopyStream(
+          message, output_.get())) {
+    return InternalErrorBuilder() << "Failed to write message of type "
+                                  << message.GetTypeName() << " to file "
+                                  << filename_;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status DelimitedProtoFileWriter::Close() {
+  if (output_ == nullptr) return absl::OkStatus();
+  const bool closed = output_->Close();
+  output_.reset();
+  if (!closed) {
+    return InternalErrorBuilder() << "Failed to write file " << filename_;
+  }
+  return absl::OkStatus();
+}
+
 absl::StatusOr<std::string> ProtoDiff(
     const google::protobuf::Message &message1,
     const google::protobuf::Message &message2,
@@ -14,14 +14,115 @@
 
 #include "gutil/proto_ordering.h"
 
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/types/span.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/message.h"
 #include "gutil/proto.h"
 
 namespace gutil {
+namespace {
+
+// Inputs smaller than this are serialized and sorted on the calling thread.
+constexpr int kMinMessagesPerThread = 1 << 13;
+
+// Returns the number of threads to use for `size` messages.
+int NumThreads(int size) {
+  int hardware_threads = std::max<int>(1, std::thread::hardware_concurrency());
+  return std::clamp(size / kMinMessagesPerThread, 1, hardware_threads);
+}
+
+// Calls `f(begin, end)` on `num_threads` consecutive chunks of [0, size), each
+// on its own thread.
+template <class F>
+void ForEachChunk(int size, int num_threads, const F& f) {
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(f, size * i / num_threads,
+                         size * (i + 1) / num_threads);
+  }
+  f(0, size / num_threads);
+  for (std::thread& thread : threads) thread.join();
+}
+
+// Returns the indices of `messages` sorted by `keys`, with ties broken by
+// index. Chunks are sorted on separate threads and then merged.
+std::vector<int> SortedIndices(const std::vector<std::string>& keys,
+                               int num_threads) {
+  std::vector<int> indices(keys.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  auto less = [&keys](int a, int b) {
+    int comparison = keys[a].compare(keys[b]);
+    return comparison < 0 || (comparison == 0 && a < b);
+  };
+  ForEachChunk(indices.size(), num_threads, [&](int begin, int end) {
+    std::sort(indices.begin() + begin, indices.begin() + end, less);
+  });
+  for (int width = 1; width < num_threads; width *= 2) {
+    for (int i = 0; i + width < num_threads; i += 2 * width) {
+      const int size = indices.size();
+      std::inplace_merge(
+          indices.begin() + size * i / num_threads,
+          indices.begin() + size * (i + width) / num_threads,
+          indices.begin() +
+              size * std::min(i + 2 * width, num_threads) / num_threads,
+          less);
+    }
+  }
+  return indices;
+}
+
+// Returns the `ProtoOrderingKey` of every message, and the sorted indices.
+std::vector<int> SortedIndices(
+    absl::Span<const google::protobuf::Message* const> messages,
+    std::vector<std::string>& keys) {
+  const int num_threads = NumThreads(messages.size());
+  keys.resize(messages.size());
+  ForEachChunk(messages.size(), num_threads, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) keys[i] = ProtoOrderingKey(*messages[i]);
+  });
+  return SortedIndices(keys, num_threads);
+}
+
+}  // namespace
 
 bool InefficientProtoLessThan(const google::protobuf::Message &message1,
                               const google::protobuf::Message &message2) {
   return PrintTextProto(message1) < PrintTextProto(message2);
 }
 
+std::string ProtoOrderingKey(const google::protobuf::Message& message) {
+  std::string bytes;
+  {
+    google::protobuf::io::StringOutputStream output_stream(&bytes);
+    google::protobuf::io::CodedOutputStream output(&output_stream);
+    output.SetSerializationDeterministic(true);
+    message.SerializeToCodedStream(&output);
+  }
+  return bytes;
+}
+
+std::vector<int> ProtoSortPermutation(
+    absl::Span<const google::protobuf::Message* const> messages) {
+  std::vector<std::string> keys;
+  return SortedIndices(messages, keys);
+}
+
+std::vector<int> ProtoSortAndDedupPermutation(
+    absl::Span<const google::protobuf::Message* const> messages) {
+  std::vector<std::string> keys;
+  std::vector<int> indices = SortedIndices(messages, keys);
+  auto same_key = [&keys](int a, int b) { return keys[a] == keys[b]; };
+  indices.erase(std::unique(indices.begin(), indices.end(), same_key),
+                indices.end());
+  return indices;
+}
+
 }  // namespace gutil
@@ -17,7 +17,9 @@
 #define PINS_GUTIL_PROTO_ORDERING_H_
 
 #include <iterator>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/types/span.h"
@@ -51,6 +53,36 @@ void InefficientProtoSort(ProtoSequence& messages);
 template <class ProtoSequence>
 void InefficientProtoSortAndDedup(ProtoSequence& messages);
 
+// Returns the bytes of the deterministic serialization of `message`, which
+// define the order used by `ProtoSort` and `ProtoSortAndDedup`.
+std::string ProtoOrderingKey(const google::protobuf::Message& message);
+
+// Returns the permutation of indices that sorts `messages` by their
+// `ProtoOrderingKey`, keeping equal messages in their input order. Every
+// message is serialized exactly once, and large inputs are serialized and
+// sorted on multiple threads.
+std::vector<int> ProtoSortPermutation(
+    absl::Span<const google::protobuf::Message* const> messages);
+
+// Like `ProtoSortPermutation`, but only keeps the first index of every set of
+// messages with equal `ProtoOrderingKey`s.
+std::vector<int> ProtoSortAndDedupPermutation(
+    absl::Span<const google::protobuf::Message* const> messages);
+
+// Sorts the given sequence of `messages` with respect to an arbitrary, but
+// deterministic order. Unlike `InefficientProtoSort`, each message is only
+// serialized once, so this is suitable for large sequences. The order differs
+// from that of `InefficientProtoSort`.
+template <typename ProtoSequence>
+void ProtoSort(ProtoSequence& messages);
+
+// Sorts the given sequence of `messages` like `ProtoSort`, and removes all
+// duplicate messages. Messages are considered duplicates if their
+// deterministic serializations are equal, which, unlike
+// `MessageDifferencer::Equals`, distinguishes e.g. 0.0 from -0.0.
+template <class ProtoSequence>
+void ProtoSortAndDedup(ProtoSequence& messages);
+
 // == END OF PUBLIC INTERFACE ==================================================
 
 template <typename ProtoSequence>
@@ -79,6 +111,37 @@ void InefficientProtoSortAndDedup(ProtoSequence& messages) {
                       google::protobuf::util::MessageDifferencer::Equals);
 }
 
+// Replaces `messages` with the messages at `permutation`, in order.
+template <class ProtoSequence>
+void ApplyProtoPermutation(const std::vector<int>& permutation,
+                           ProtoSequence& messages) {
+  ProtoSequence tmp;
+  std::swap(messages, tmp);
+  auto inserter = BackInserter(messages);
+  for (int index : permutation) *inserter++ = std::move(tmp[index]);
+}
+
+template <class ProtoSequence>
+std::vector<const google::protobuf::Message*> ProtoPointers(
+    const ProtoSequence& messages) {
+  std::vector<const google::protobuf::Message*> pointers;
+  pointers.reserve(messages.size());
+  for (const auto& message : messages) pointers.push_back(&message);
+  return pointers;
+}
+
+template <typename ProtoSequence>
+void ProtoSort(ProtoSequence& messages) {
+  ApplyProtoPermutation(ProtoSortPermutation(ProtoPointers(messages)),
+                        messages);
+}
+
+template <class ProtoSequence>
+void ProtoSortAndDedup(ProtoSequence& messages) {
+  ApplyProtoPermutation(ProtoSortAndDedupPermutation(ProtoPointers(messages)),
+                        messages);
+}
+
 }  // namespace gutil
 
 #endif  // PINS_GUTIL_PROTO_ORDERING_H_
@@ -1,9 +1,12 @@
 #include "gutil/proto_ordering.h"
 
+#include <algorithm>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "gmock/gmock.h"
 #include "google/protobuf/repeated_ptr_field.h"
+#include "google/protobuf/util/message_differencer.h"
 #include "gtest/gtest.h"
 #include "gutil/proto_matchers.h"
 #include "gutil/proto_test.pb.h"
@@ -191,5 +194,58 @@ TEST(InefficientProtoSortAndDedupTest, Sorts) {
   EXPECT_THAT(messages, EqualsProtoSequence(deduped_messages));
 }
 
+TEST(ProtoSort, AllPermutationsOfThreeGetOrderedTheSameWay) {
+  std::vector<TestMessage> x1 = {ArbitraryProtoMessage1(),
+                                 ArbitraryProtoMessage2(),
+                                 ArbitraryProtoMessage3()};
+  std::vector<TestMessage> x2 = {ArbitraryProtoMessage3(),
+                                 ArbitraryProtoMessage1(),
+                                 ArbitraryProtoMessage2()};
+  std::vector<TestMessage> x3 = {ArbitraryProtoMessage2(),
+                                 ArbitraryProtoMessage3(),
+                                 ArbitraryProtoMessage1()};
+  ProtoSort(x1);
+  ProtoSort(x2);
+  ProtoSort(x3);
+  EXPECT_THAT(x2, EqualsProtoSequence(x1));
+  EXPECT_THAT(x3, EqualsProtoSequence(x1));
+}
+
+TEST(ProtoSortAndDedupTest, RemovesDuplicates) {
+  google::protobuf::RepeatedPtrField<TestMessage> messages;
+  messages.Add(ArbitraryProtoMessage1());
+  messages.Add(ArbitraryProtoMessage2());
+  messages.Add(ArbitraryProtoMessage1());
+  messages.Add(ArbitraryProtoMessage3());
+  messages.Add(ArbitraryProtoMessage2());
+  ProtoSortAndDedup(messages);
+  EXPECT_THAT(messages,
+              UnorderedElementsAre(EqualsProto(ArbitraryProtoMessage1()),
+                                   EqualsProto(ArbitraryProtoMessage2()),
+                                   EqualsProto(ArbitraryProtoMessage3())));
+}
+
+// Large inputs are sorted on multiple threads, which must not change the order.
+TEST(ProtoSortAndDedupTest, LargeInputsMatchSmallInputs) {
+  std::vector<TestMessage> messages;
+  for (int i = 0; i < 100000; ++i) {
+    TestMessage message;
+    message.set_int_field((i * 7919) % 50000);
+    messages.push_back(message);
+  }
+  std::vector<TestMessage> expected = messages;
+  absl::c_stable_sort(expected, [](const TestMessage& a, const TestMessage& b) {
+    return ProtoOrderingKey(a) < ProtoOrderingKey(b);
+  });
+  expected.erase(
+      std::unique(expected.begin(), expected.end(),
+                  google::protobuf::util::MessageDifferencer::Equals),
+      expected.end());
+
+  ProtoSortAndDedup(messages);
+  ASSERT_EQ(messages.size(), 50000);
+  EXPECT_THAT(messages, EqualsProtoSequence(expected));
+}
+
 }  // namespace
 }  // namespace gutil
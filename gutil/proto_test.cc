@@ -1,11 +1,17 @@
 #include "gutil/proto.h"
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "gutil/proto_matchers.h"
 #include "gutil/proto_test.pb.h"
+#include "gutil/io.h"
 #include "gutil/status_matchers.h"
 
 namespace gutil {
@@ -52,6 +58,112 @@ TEST(ParseTextProto, NonEmptyValidTextProtoIsParsedCorrectly) {
   EXPECT_EQ(proto->string_field(), "hello!");
 }
 
+TEST(ReadProtoFromString, ParsesTextProtos) {
+  TestMessage message;
+  ASSERT_OK(ReadProtoFromString("int_field: 42", &message));
+  EXPECT_EQ(message.int_field(), 42);
+}
+
+TEST(SaveProtoToFile, RoundTripsTextAndBinaryProtos) {
+  ASSERT_OK_AND_ASSIGN(auto message, ParseTextProto<TestMessage>(R"pb(
+                         int_field: 42
+                         string_field: "hello!"
+                       )pb"));
+  for (const std::string extension : {".txtpb", ".binpb"}) {
+    SCOPED_TRACE(extension);
+    const std::string filename =
+        absl::StrCat(testing::TempDir(), "/message", extension);
+    ASSERT_OK(SaveProtoToFile(filename, message));
+    TestMessage read_message;
+    ASSERT_OK(ReadProtoFromFile(filename, &read_message));
+    EXPECT_THAT(read_message, EqualsProto(message));
+  }
+}
+
+TEST(SaveProtoToFile, WritesBinaryProtosToBinpbFiles) {
+  TestMessage message;
+  message.set_int_field(42);
+  const std::string filename = absl::StrCat(testing::TempDir(), "/m.binpb");
+  ASSERT_OK(SaveProtoToFile(filename, message));
+  EXPECT_THAT(ReadFile(filename), IsOkAndHolds(message.SerializeAsString()));
+}
+
+TEST(SaveProtoToFile, OverwritesLongerFiles) {
+  const std::string filename = absl::StrCat(testing::TempDir(), "/short.txtpb");
+  ASSERT_OK(WriteFile(std::string(100, '#'), filename));
+  TestMessage message;
+  message.set_int_field(42);
+  ASSERT_OK(SaveProtoToFile(filename, message));
+
+  TestMessage read_message;
+  ASSERT_OK(ReadProtoFromFile(filename, &read_message));
+  EXPECT_THAT(read_message, EqualsProto(message));
+}
+
+TEST(ReadProtoFromFile, ReadsEmptyFiles) {
+  const std::string filename = absl::StrCat(testing::TempDir(), "/empty.binpb");
+  ASSERT_OK(WriteFile("", filename));
+  TestMessage message;
+  message.set_int_field(42);
+  ASSERT_OK(ReadProtoFromFile(filename, &message));
+  EXPECT_TRUE(IsEmptyProto(message));
+}
+
+TEST(ReadProtoFromFile, ReturnsErrorForMissingFiles) {
+  TestMessage message;
+  EXPECT_THAT(ReadProtoFromFile("/does/not/exist.txtpb", &message),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(DelimitedProtoFile, RoundTripsMessages) {
+  const std::string filename =
+      absl::StrCat(testing::TempDir(), "/messages.delimited");
+  std::vector<TestMessage> messages(3);
+  messages[0].set_int_field(1);
+  messages[2].set_string_field("three");
+  ASSERT_OK(SaveDelimitedProtosToFile(filename, messages));
+
+  ASSERT_OK_AND_ASSIGN(std::vector<TestMessage> read_messages,
+                       ReadDelimitedProtosFromFile<TestMessage>(filename));
+  ASSERT_EQ(read_messages.size(), messages.size());
+  for (size_t i = 0; i < messages.size(); ++i) {
+    EXPECT_THAT(read_messages[i], EqualsProto(messages[i]));
+  }
+}
+
+TEST(DelimitedProtoFile, ReadsEmptyFiles) {
+  const std::string filename =
+      absl::StrCat(testing::TempDir(), "/empty.delimited");
+  ASSERT_OK(SaveDelimitedProtosToFile(filename, std::vector<TestMessage>()));
+  EXPECT_THAT(ReadDelimitedProtosFromFile<TestMessage>(filename),
+              IsOkAndHolds(IsEmpty()));
+}
+
+TEST(DelimitedProtoFile, ReturnsErrorForTruncatedFiles) {
+  const std::string filename =
+      absl::StrCat(testing::TempDir(), "/truncated.delimited");
+  TestMessage message;
+  message.set_string_field("truncated");
+  ASSERT_OK(SaveDelimitedProtosToFile(filename, std::vector{message}));
+  ASSERT_OK_AND_ASSIGN(std::string contents, ReadFile(filename));
+  ASSERT_OK(WriteFile(contents.substr(0, contents.size() - 1), filename));
+
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<DelimitedProtoFileReader> reader,
+                       DelimitedProtoFileReader::Open(filename));
+  EXPECT_THAT(reader->ReadNext(message),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(DelimitedProtoFileWriter, RejectsWritesAfterClose) {
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<DelimitedProtoFileWriter> writer,
+      DelimitedProtoFileWriter::Create(
+          absl::StrCat(testing::TempDir(), "/closed.delimited")));
+  ASSERT_OK(writer->Close());
+  EXPECT_THAT(writer->Write(TestMessage()),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
 TEST(ProtoDiff, ReturnsErrorForIncompatibleMessages) {
   ASSERT_OK_AND_ASSIGN(auto message1, ParseTextProto<TestMessage>(R"pb(
                          int_field: 42
@@ -27,20 +27,25 @@ std::string StableStatusToString(const absl::Status& status) {
 }
 
 absl::Status gutil::StatusBuilder::GetStatusAndLog() const {
-  std::string message = source_;
+  const std::string streamed = stream_ == nullptr ? "" : stream_->str();
+  // Nothing to add, so the status (and its payloads) can be shared as is.
+  if (file_.empty() && streamed.empty() && !log_error_) return status_;
+
+  std::string message;
+  if (!file_.empty()) absl::StrAppend(&message, "[", file_, ":", line_, "]: ");
   switch (join_style_) {
     case MessageJoinStyle::kPrepend:
-      absl::StrAppend(&message, stream_.str(), status_.message());
+      absl::StrAppend(&message, streamed, status_.message());
       break;
     case MessageJoinStyle::kAppend:
-      absl::StrAppend(&message, status_.message(), stream_.str());
+      absl::StrAppend(&message, status_.message(), streamed);
       break;
     case MessageJoinStyle::kAnnotate:
     default: {
-      if (!status_.message().empty() && !stream_.str().empty()) {
-        absl::StrAppend(&message, status_.message(), "; ", stream_.str());
+      if (!status_.message().empty() && !streamed.empty()) {
+        absl::StrAppend(&message, status_.message(), "; ", streamed);
       } else if (status_.message().empty()) {
-        absl::StrAppend(&message, stream_.str());
+        absl::StrAppend(&message, streamed);
       } else {
         absl::StrAppend(&message, status_.message());
       }
@@ -15,6 +15,7 @@
 #define GUTIL_STATUS_H
 
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -82,6 +83,12 @@ absl::Status GrpcStatusToAbslStatus(const grpc::Status& status);
 // StatusBuilder facilitates easier construction of Status objects with streamed
 // message building.
 //
+// The builder is cheap until a message is streamed into it: the stream is only
+// allocated on the first `<<`, and the final message is only assembled when
+// converting to a status. Without a streamed message or source location, the
+// conversion returns the wrapped status as is, so passing errors through
+// RETURN_IF_ERROR and ASSIGN_OR_RETURN allocates nothing.
+//
 // Example usage:
 //   absl::Status foo(int i) {
 //     if (i < 0) {
@@ -91,34 +98,31 @@ absl::Status GrpcStatusToAbslStatus(const grpc::Status& status);
 class ABSL_MUST_USE_RESULT StatusBuilder {
  public:
   StatusBuilder(std::string file, int line, absl::StatusCode code)
-      : status_(absl::Status(code, "")),
-        log_error_(false),
-        join_style_(MessageJoinStyle::kAnnotate) {
-    source_ = absl::StrCat("[", file, ":", line, "]: ");
-  }
+      : file_(std::move(file)), line_(line), status_(absl::Status(code, "")) {}
 
   explicit StatusBuilder(absl::StatusCode code)
-      : status_(absl::Status(code, "")),
-        log_error_(false),
-        join_style_(MessageJoinStyle::kAnnotate) {}
+      : status_(absl::Status(code, "")) {}
 
-  explicit StatusBuilder(absl::Status status)
-      : status_(status),
-        log_error_(false),
-        join_style_(MessageJoinStyle::kAnnotate) {}
+  explicit StatusBuilder(absl::Status status) : status_(std::move(status)) {}
 
   StatusBuilder(const StatusBuilder& other)
-      : source_(other.source_),
+      : file_(other.file_),
+        line_(other.line_),
         status_(other.status_),
         log_error_(other.log_error_),
         join_style_(other.join_style_) {
-    stream_ << other.stream_.str();
+    if (other.stream_ != nullptr) {
+      stream_ = std::make_unique<std::ostringstream>(other.stream_->str(),
+                                                     std::ios_base::ate);
+    }
   }
+  StatusBuilder(StatusBuilder&&) = default;
 
   // Streaming to the StatusBuilder appends to the error message.
-  template <typename t>
-  ABSL_MUST_USE_RESULT StatusBuilder& operator<<(t val) {
-    stream_ << val;
+  template <typename T>
+  ABSL_MUST_USE_RESULT StatusBuilder& operator<<(const T& val) {
+    if (stream_ == nullptr) stream_ = std::make_unique<std::ostringstream>();
+    *stream_ << val;
     return *this;
   }
 
@@ -169,11 +173,14 @@ class ABSL_MUST_USE_RESULT StatusBuilder {
     kPrepend,
   };
 
-  std::string source_;
+  // The source location to prefix the message with, if `file_` is non-empty.
+  std::string file_;
+  int line_ = 0;
   absl::Status status_;
-  std::stringstream stream_;
-  bool log_error_;
-  MessageJoinStyle join_style_;
+  // Null until a message is streamed.
+  std::unique_ptr<std::ostringstream> stream_;
+  bool log_error_ = false;
+  MessageJoinStyle join_style_ = MessageJoinStyle::kAnnotate;
 
   absl::Status GetStatusAndLog() const;
 };
@@ -163,4 +163,29 @@ TEST(StatusTest, TestEmptyStatusMessage) {
   EXPECT_EQ(gutil_status, util_status);
 }
 
+TEST(StatusBuilderTest, ReturnsWrappedStatusWithoutMessage) {
+  absl::Status status = absl::InvalidArgumentError("Original message");
+  status.SetPayload("url", absl::Cord("payload"));
+  const absl::Status built = ReturnStatusWithAnnotatedStream(
+      "Original message", /*streamed_message=*/"", /*is_google3=*/false);
+  EXPECT_EQ(built, absl::InvalidArgumentError("Original message"));
+  EXPECT_EQ(absl::Status(gutil::StatusBuilder(status)), status);
+}
+
+TEST(StatusBuilderTest, CopiesKeepTheStreamedMessage) {
+  gutil::StatusBuilder builder(absl::StatusCode::kInternal);
+  builder << "Hello";
+  gutil::StatusBuilder copy = builder;
+  copy << ", World!";
+  EXPECT_EQ(absl::Status(builder).message(), "Hello");
+  EXPECT_EQ(absl::Status(copy).message(), "Hello, World!");
+}
+
+TEST(StatusBuilderTest, PrefixesSourceLocation) {
+  absl::Status status =
+      gutil::StatusBuilder("file.cc", 42, absl::StatusCode::kInternal)
+      << "Message";
+  EXPECT_EQ(status.message(), "[file.cc:42]: Message");
+}
+
 }  // namespace gutil
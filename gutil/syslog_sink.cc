@@ -4,9 +4,23 @@
 #include <sys/syslog.h>
 #include <sys/time.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <thread>  // NOLINT
+#include <utility>
 
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "glog/logging.h"
+#include "gutil/token_bucket.h"
 
 namespace gutil {
 namespace {
@@ -26,6 +40,36 @@ constexpr std::array<char, 4> kGlogSeverityLetter = {
     'F',
 };
 
+// Formats a message the same way as SyslogSink into `buffer`, truncating it if
+// needed. Returns the formatted length.
+int FormatMessage(char* buffer, int buffer_size, google::LogSeverity severity,
+                  const char* base_filename, int line, const char* message,
+                  size_t message_len) {
+  struct timeval tv;
+  struct tm time;
+  gettimeofday(&tv, /*tz=*/nullptr);
+  localtime_r(&tv.tv_sec, &time);
+
+  int length = snprintf(
+      buffer, buffer_size, "%c%02d%02d %02d:%02d:%02d.%06ld %5ld %s:%d] %.*s",
+      kGlogSeverityLetter[severity], 1 + time.tm_mon, time.tm_mday,
+      time.tm_hour, time.tm_min, time.tm_sec, static_cast<long>(tv.tv_usec),
+      syscall(SYS_gettid), base_filename, line, static_cast<int>(message_len),
+      message);
+  return std::clamp(length, 0, buffer_size - 1);
+}
+
+void WriteToSyslog(int priority, absl::string_view message) {
+  syslog(priority, "%.*s", static_cast<int>(message.size()), message.data());
+}
+
+uint64_t RoundUpToPowerOfTwo(int value) {
+  const uint64_t target = std::max(value, 2);
+  uint64_t result = 2;
+  while (result < target) result <<= 1;
+  return result;
+}
+
 }  // namespace
 
 SyslogSink::SyslogSink(const char* process_name) {
@@ -59,4 +103,145 @@ void SyslogSink::send(google::LogSeverity severity, const char* full_filename,
          static_cast<int>(message_len), message);
 }
 
+AsyncSyslogSink::AsyncSyslogSink(const char* process_name,
+                                 AsyncSyslogSinkOptions options, Writer writer)
+    : options_(options),
+      owns_syslog_(writer == nullptr),
+      writer_(writer == nullptr ? WriteToSyslog : std::move(writer)),
+      capacity_(RoundUpToPowerOfTwo(options.queue_size)),
+      slots_(std::make_unique<Slot[]>(capacity_)) {
+  for (uint64_t i = 0; i < capacity_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  if (options_.max_messages_per_second > 0) {
+    rate_limiter_.emplace(
+        options_.max_messages_per_second,
+        std::max<int64_t>(1, options_.max_messages_per_second));
+  }
+  if (owns_syslog_) openlog(process_name, LOG_NDELAY, LOG_USER);
+  flush_thread_ = std::thread(&AsyncSyslogSink::FlushLoop, this);
+  google::AddLogSink(this);
+}
+
+AsyncSyslogSink::~AsyncSyslogSink() {
+  google::RemoveLogSink(this);
+  stop_.Notify();
+  flush_thread_.join();
+  if (owns_syslog_) closelog();
+}
+
+void AsyncSyslogSink::send(google::LogSeverity severity,
+                           const char* full_filename,
+                           const char* base_filename, int line,
+                           const google::LogMessageTime& logmsgtime,
+                           const char* message, size_t message_len) {
+  if (severity < google::GLOG_FATAL &&
+      TryEnqueue(severity, base_filename, line, message, message_len)) {
+    return;
+  }
+  if (severity < google::GLOG_FATAL &&
+      options_.overflow_policy == SyslogOverflowPolicy::kDropNewest) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  // Everything queued before a FATAL message is written first so the lead up
+  // to the crash is not lost.
+  if (severity >= google::GLOG_FATAL) Flush();
+  char buffer[kMaxMessageBytes];
+  int length = FormatMessage(buffer, sizeof(buffer), severity, base_filename,
+                             line, message, message_len);
+  writer_(kGlogSeverityToSyslog[severity], absl::string_view(buffer, length));
+  written_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AsyncSyslogSink::Flush() {
+  absl::MutexLock l(&drain_lock_);
+  Drain(absl::Now());
+}
+
+AsyncSyslogSinkStats AsyncSyslogSink::GetStats() const {
+  return AsyncSyslogSinkStats{
+      .written = written_.load(std::memory_order_relaxed),
+      .dropped = dropped_.load(std::memory_order_relaxed),
+      .rate_limited = rate_limited_.load(std::memory_order_relaxed),
+  };
+}
+
+bool AsyncSyslogSink::TryEnqueue(google::LogSeverity severity,
+                                 const char* base_filename, int line,
+                                 const char* message, size_t message_len) {
+  // A bounded multi-producer queue: each slot's sequence tells producers
+  // whether the slot is free for their position, so claiming one only takes a
+  // compare-and-swap on the enqueue position.
+  uint64_t position = enqueue_position_.load(std::memory_order_relaxed);
+  Slot* slot;
+  while (true) {
+    slot = &slots_[position & (capacity_ - 1)];
+    const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const int64_t difference =
+        static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+    if (difference == 0) {
+      if (enqueue_position_.compare_exchange_weak(position, position + 1,
+                                                  std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      // The slot still holds a message from the previous lap.
+      return false;
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->priority = kGlogSeverityToSyslog[severity];
+  slot->length = FormatMessage(slot->text, kMaxMessageBytes, severity,
+                               base_filename, line, message, message_len);
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+void AsyncSyslogSink::Drain(absl::Time now) {
+  while (true) {
+    Slot& slot = slots_[dequeue_position_ & (capacity_ - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) !=
+        dequeue_position_ + 1) {
+      break;
+    }
+    if (rate_limiter_.has_value() && slot.priority >= LOG_WARNING &&
+        rate_limiter_->TryAcquire(1, now) == 0) {
+      rate_limited_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      writer_(slot.priority, absl::string_view(slot.text, slot.length));
+      written_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Free the slot for the producer one lap ahead.
+    slot.sequence.store(dequeue_position_ + capacity_,
+                        std::memory_order_release);
+    ++dequeue_position_;
+  }
+  ReportLosses(now);
+}
+
+void AsyncSyslogSink::ReportLosses(absl::Time now) {
+  if (now - last_loss_report_ < absl::Seconds(1)) return;
+  const int64_t dropped = dropped_.load(std::memory_order_relaxed);
+  const int64_t rate_limited = rate_limited_.load(std::memory_order_relaxed);
+  if (dropped + rate_limited == reported_losses_) return;
+
+  reported_losses_ = dropped + rate_limited;
+  last_loss_report_ = now;
+  writer_(LOG_WARNING,
+          absl::StrFormat("Lost log messages: %d dropped because the syslog "
+                          "queue was full, and %d rate limited (totals).",
+                          dropped, rate_limited));
+}
+
+void AsyncSyslogSink::FlushLoop() {
+  while (!stop_.WaitForNotificationWithTimeout(options_.flush_interval)) {
+    Flush();
+  }
+  Flush();
+}
+
 }  // namespace gutil
@@ -1,9 +1,21 @@
 #ifndef PINS_GUTIL_SYSLOG_SINK_H_
 #define PINS_GUTIL_SYSLOG_SINK_H_
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <thread>  // NOLINT
 
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "glog/logging.h"
+#include "gutil/token_bucket.h"
 
 namespace gutil {
 
@@ -29,6 +41,116 @@ class SyslogSink : google::LogSink {
             size_t message_len) override;
 };
 
+// What AsyncSyslogSink does with a message when its queue is full.
+enum class SyslogOverflowPolicy {
+  // The message is dropped, and counted.
+  kDropNewest,
+  // The message is written to syslog on the logging thread, like SyslogSink.
+  kWriteSynchronously,
+};
+
+struct AsyncSyslogSinkOptions {
+  // Number of messages that can wait to be written. Rounded up to a power of
+  // two.
+  int queue_size = 1024;
+  SyslogOverflowPolicy overflow_policy = SyslogOverflowPolicy::kDropNewest;
+  // When positive, at most this many INFO and WARNING messages are written per
+  // second, with bursts of up to a second's worth. The rest are counted and
+  // dropped. ERROR and FATAL messages are never rate limited.
+  double max_messages_per_second = 0;
+  // How often the background thread looks for new messages.
+  absl::Duration flush_interval = absl::Milliseconds(10);
+};
+
+struct AsyncSyslogSinkStats {
+  int64_t written = 0;
+  // Dropped because the queue was full.
+  int64_t dropped = 0;
+  // Dropped by the rate limit.
+  int64_t rate_limited = 0;
+};
+
+// Forwards LOG() messages to syslog like SyslogSink, but without making the
+// logging thread wait on the syslog socket. Messages are formatted into a
+// bounded, lock-free queue and written by a background thread, so a burst of
+// log messages costs the logging threads little more than the formatting.
+//
+// Messages longer than kMaxMessageBytes are truncated. Dropped and rate
+// limited messages are summarized in syslog at most once a second. A FATAL
+// message flushes the queue, and is written synchronously, since the process
+// is about to abort.
+class AsyncSyslogSink : google::LogSink {
+ public:
+  static constexpr int kMaxMessageBytes = 2048;
+
+  // Writes one formatted message with a syslog priority. Must be thread-safe.
+  using Writer = std::function<void(int priority, absl::string_view message)>;
+
+  // Messages are written with syslog() unless a `writer` is given (e.g. for
+  // tests).
+  explicit AsyncSyslogSink(const char* process_name,
+                           AsyncSyslogSinkOptions options = {},
+                           Writer writer = nullptr);
+
+  // Writes any queued messages before returning.
+  ~AsyncSyslogSink() override;
+
+  void send(google::LogSeverity severity, const char* full_filename,
+            const char* base_filename, int line,
+            const google::LogMessageTime& logmsgtime, const char* message,
+            size_t message_len) override;
+
+  // Writes every queued message now.
+  void Flush() ABSL_LOCKS_EXCLUDED(drain_lock_);
+
+  AsyncSyslogSinkStats GetStats() const;
+
+ private:
+  struct Slot {
+    // Equal to the enqueue position the slot is free for, or to that position
+    // plus one once the message is ready to be written.
+    std::atomic<uint64_t> sequence;
+    int priority;
+    int length;
+    char text[kMaxMessageBytes];
+  };
+
+  // Claims a free slot and formats the message into it. Returns false if the
+  // queue is full. Lock-free, and safe to call from any thread.
+  bool TryEnqueue(google::LogSeverity severity, const char* base_filename,
+                  int line, const char* message, size_t message_len);
+
+  // Writes every ready message. Only one thread drains at a time.
+  void Drain(absl::Time now) ABSL_EXCLUSIVE_LOCKS_REQUIRED(drain_lock_);
+
+  // Writes a summary of the messages lost since the last summary.
+  void ReportLosses(absl::Time now) ABSL_EXCLUSIVE_LOCKS_REQUIRED(drain_lock_);
+
+  void FlushLoop();
+
+  const AsyncSyslogSinkOptions options_;
+  const bool owns_syslog_;
+  Writer writer_;
+
+  const uint64_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t> enqueue_position_{0};
+
+  absl::Mutex drain_lock_;
+  uint64_t dequeue_position_ ABSL_GUARDED_BY(drain_lock_) = 0;
+  std::optional<TokenBucket> rate_limiter_ ABSL_GUARDED_BY(drain_lock_);
+  absl::Time last_loss_report_ ABSL_GUARDED_BY(drain_lock_) =
+      absl::InfinitePast();
+  int64_t reported_losses_ ABSL_GUARDED_BY(drain_lock_) = 0;
+
+  std::atomic<int64_t> written_{0};
+  std::atomic<int64_t> dropped_{0};
+  std::atomic<int64_t> rate_limited_{0};
+
+  absl::Notification stop_;
+  std::thread flush_thread_;
+};
+
 }  // namespace gutil
 
 #endif  // PINS_GUTIL_SYSLOG_SINK_H_
@@ -0,0 +1,177 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gutil/syslog_sink.h"
+
+#include <sys/syslog.h>
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "glog/logging.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace gutil {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::EndsWith;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+
+// Collects every message written by a sink.
+class FakeSyslog {
+ public:
+  AsyncSyslogSink::Writer Writer() {
+    return [this](int priority, absl::string_view message) {
+      absl::MutexLock l(&lock_);
+      messages_.push_back({priority, std::string(message)});
+    };
+  }
+
+  std::vector<std::pair<int, std::string>> messages() {
+    absl::MutexLock l(&lock_);
+    return messages_;
+  }
+
+ private:
+  absl::Mutex lock_;
+  std::vector<std::pair<int, std::string>> messages_ ABSL_GUARDED_BY(lock_);
+};
+
+// Messages are only written when the test flushes them.
+AsyncSyslogSinkOptions ManualFlushOptions() {
+  return AsyncSyslogSinkOptions{.flush_interval = absl::Hours(1)};
+}
+
+void Send(AsyncSyslogSink& sink, google::LogSeverity severity,
+          const char* message) {
+  sink.send(severity, "/path/to/file.cc", "file.cc", 10,
+            google::LogMessageTime(), message, strlen(message));
+}
+
+TEST(AsyncSyslogSinkTest, WritesQueuedMessagesInOrderWhenFlushed) {
+  FakeSyslog syslog;
+  AsyncSyslogSink sink("test", ManualFlushOptions(), syslog.Writer());
+  Send(sink, google::GLOG_INFO, "first");
+  Send(sink, google::GLOG_WARNING, "second");
+  EXPECT_THAT(syslog.messages(), IsEmpty());
+
+  sink.Flush();
+  EXPECT_THAT(syslog.messages(),
+              ElementsAre(Pair(LOG_INFO, EndsWith("file.cc:10] first")),
+                          Pair(LOG_WARNING, EndsWith("file.cc:10] second"))));
+  EXPECT_EQ(sink.GetStats().written, 2);
+}
+
+TEST(AsyncSyslogSinkTest, DropsNewestMessagesWhenTheQueueIsFull) {
+  FakeSyslog syslog;
+  AsyncSyslogSinkOptions options = ManualFlushOptions();
+  options.queue_size = 2;
+  AsyncSyslogSink sink("test", options, syslog.Writer());
+  Send(sink, google::GLOG_INFO, "first");
+  Send(sink, google::GLOG_INFO, "second");
+  Send(sink, google::GLOG_INFO, "third");
+  EXPECT_EQ(sink.GetStats().dropped, 1);
+
+  sink.Flush();
+  EXPECT_THAT(syslog.messages(),
+              ElementsAre(Pair(LOG_INFO, EndsWith("first")),
+                          Pair(LOG_INFO, EndsWith("second")),
+                          Pair(LOG_WARNING, HasSubstr("1 dropped"))));
+
+  // The queue is usable again once flushed.
+  Send(sink, google::GLOG_INFO, "fourth");
+  sink.Flush();
+  EXPECT_THAT(syslog.messages().back(), Pair(LOG_INFO, EndsWith("fourth")));
+}
+
+TEST(AsyncSyslogSinkTest, CanWriteSynchronouslyWhenTheQueueIsFull) {
+  FakeSyslog syslog;
+  AsyncSyslogSinkOptions options = ManualFlushOptions();
+  options.queue_size = 2;
+  options.overflow_policy = SyslogOverflowPolicy::kWriteSynchronously;
+  AsyncSyslogSink sink("test", options, syslog.Writer());
+  Send(sink, google::GLOG_INFO, "first");
+  Send(sink, google::GLOG_INFO, "second");
+  Send(sink, google::GLOG_INFO, "third");
+
+  EXPECT_THAT(syslog.messages(),
+              ElementsAre(Pair(LOG_INFO, EndsWith("third"))));
+  EXPECT_EQ(sink.GetStats().dropped, 0);
+}
+
+TEST(AsyncSyslogSinkTest, RateLimitsInfoAndWarningButNotErrors) {
+  FakeSyslog syslog;
+  AsyncSyslogSinkOptions options = ManualFlushOptions();
+  options.max_messages_per_second = 1;
+  AsyncSyslogSink sink("test", options, syslog.Writer());
+  Send(sink, google::GLOG_INFO, "first");
+  Send(sink, google::GLOG_INFO, "second");
+  Send(sink, google::GLOG_WARNING, "third");
+  Send(sink, google::GLOG_ERROR, "fourth");
+
+  sink.Flush();
+  EXPECT_THAT(syslog.messages(),
+              ElementsAre(Pair(LOG_INFO, EndsWith("first")),
+                          Pair(LOG_ERR, EndsWith("fourth")),
+                          Pair(LOG_WARNING, HasSubstr("2 rate limited"))));
+  EXPECT_EQ(sink.GetStats().rate_limited, 2);
+}
+
+TEST(AsyncSyslogSinkTest, TruncatesLongMessages) {
+  FakeSyslog syslog;
+  AsyncSyslogSink sink("test", ManualFlushOptions(), syslog.Writer());
+  std::string message(2 * AsyncSyslogSink::kMaxMessageBytes, 'x');
+  Send(sink, google::GLOG_INFO, message.c_str());
+
+  sink.Flush();
+  ASSERT_EQ(syslog.messages().size(), 1);
+  EXPECT_EQ(syslog.messages()[0].second.size(),
+            AsyncSyslogSink::kMaxMessageBytes - 1);
+}
+
+TEST(AsyncSyslogSinkTest, WritesQueuedMessagesWhenDestroyed) {
+  FakeSyslog syslog;
+  {
+    AsyncSyslogSink sink("test", ManualFlushOptions(), syslog.Writer());
+    Send(sink, google::GLOG_INFO, "first");
+  }
+  EXPECT_THAT(syslog.messages(),
+              ElementsAre(Pair(LOG_INFO, EndsWith("first"))));
+}
+
+TEST(AsyncSyslogSinkTest, BackgroundThreadWritesMessages) {
+  FakeSyslog syslog;
+  AsyncSyslogSink sink(
+      "test", AsyncSyslogSinkOptions{.flush_interval = absl::Milliseconds(1)},
+      syslog.Writer());
+  Send(sink, google::GLOG_INFO, "first");
+
+  for (int i = 0; i < 1000 && syslog.messages().empty(); ++i) {
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+  EXPECT_THAT(syslog.messages(),
+              ElementsAre(Pair(LOG_INFO, EndsWith("first"))));
+}
+
+}  // namespace
+}  // namespace gutil
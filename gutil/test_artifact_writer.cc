@@ -15,12 +15,16 @@ limitations under the License.
 
 #include "gutil/test_artifact_writer.h"
 
+#include <cstdint>
 #include <cstdlib>
 #include <filesystem>  // NOLINT: open source code
 #include <fstream>
 #include <ios>
+#include <memory>
 #include <string>
 #include <system_error>  // NOLINT: open source code
+#include <thread>        // NOLINT: third_party code.
+#include <utility>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
@@ -30,6 +34,7 @@ limitations under the License.
 #include "absl/synchronization/mutex.h"
 #include "google/protobuf/message.h"
 #include "gtest/gtest.h"
+#include "gutil/binary_proto_records.h"
 #include "gutil/proto.h"
 #include "gutil/status.h"
 
@@ -120,6 +125,10 @@ absl::Status TestArtifactWriter::AppendToTestArtifact(
   return AppendToTestArtifact(filename,
                               absl::StrCat(PrintTextProto(proto), "\n"));
 }
+absl::Status TestArtifactWriter::AppendToBinaryTestArtifact(
+    absl::string_view filename, const google::protobuf::Message& proto) {
+  return AppendToTestArtifact(filename, SerializeBinaryProtoRecord(proto));
+}
 
 // -- BazelTestArtifactWriter --------------------------------------------------
 
@@ -136,4 +145,113 @@ absl::Status BazelTestArtifactWriter::AppendToTestArtifact(
                              open_file_by_filepath_);
 }
 
+// -- AsyncTestArtifactWriter -------------------------------------------------
+
+AsyncTestArtifactWriter::AsyncTestArtifactWriter(
+    std::unique_ptr<TestArtifactWriter> writer,
+    AsyncTestArtifactWriterOptions options)
+    : writer_(std::move(writer)),
+      options_(options),
+      writer_thread_([this] { WriteQueuedWrites(); }) {}
+
+AsyncTestArtifactWriter::~AsyncTestArtifactWriter() {
+  {
+    absl::MutexLock lock(&mutex_);
+    shutting_down_ = true;
+  }
+  writer_thread_.join();
+}
+
+absl::Status AsyncTestArtifactWriter::StoreTestArtifact(
+    absl::string_view filename, absl::string_view contents) {
+  return Enqueue(PendingWrite{.filename = std::string(filename),
+                              .contents = std::string(contents),
+                              .size = static_cast<int64_t>(contents.size())});
+}
+absl::Status AsyncTestArtifactWriter::StoreTestArtifact(
+    absl::string_view filename, const google::protobuf::Message& proto) {
+  return EnqueueProto(filename, /*append=*/false, proto);
+}
+absl::Status AsyncTestArtifactWriter::AppendToTestArtifact(
+    absl::string_view filename, absl::string_view contents) {
+  return Enqueue(PendingWrite{.filename = std::string(filename),
+                              .append = true,
+                              .contents = std::string(contents),
+                              .size = static_cast<int64_t>(contents.size())});
+}
+absl::Status AsyncTestArtifactWriter::AppendToTestArtifact(
+    absl::string_view filename, const google::protobuf::Message& proto) {
+  return EnqueueProto(filename, /*append=*/true, proto);
+}
+
+absl::Status AsyncTestArtifactWriter::Flush() {
+  absl::MutexLock lock(&mutex_);
+  auto done = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return queue_.empty() && !write_in_progress_;
+  };
+  mutex_.Await(absl::Condition(&done));
+  return status_;
+}
+
+absl::Status AsyncTestArtifactWriter::EnqueueProto(
+    absl::string_view filename, bool append,
+    const google::protobuf::Message& proto) {
+  std::unique_ptr<google::protobuf::Message> copy(proto.New());
+  copy->CopyFrom(proto);
+  const int64_t size = copy->SpaceUsedLong();
+  return Enqueue(PendingWrite{.filename = std::string(filename),
+                              .append = append,
+                              .proto = std::move(copy),
+                              .size = size});
+}
+
+absl::Status AsyncTestArtifactWriter::Enqueue(PendingWrite write) {
+  absl::MutexLock lock(&mutex_);
+  const int64_t size = write.size;
+  auto has_room = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return buffered_bytes_ == 0 ||
+           buffered_bytes_ + size <= options_.max_buffered_bytes;
+  };
+  mutex_.Await(absl::Condition(&has_room));
+  buffered_bytes_ += size;
+  queue_.push_back(std::move(write));
+  return status_;
+}
+
+absl::Status AsyncTestArtifactWriter::Write(const PendingWrite& write) {
+  if (write.proto != nullptr) {
+    return write.append
+               ? writer_->AppendToTestArtifact(write.filename, *write.proto)
+               : writer_->StoreTestArtifact(write.filename, *write.proto);
+  }
+  return write.append
+             ? writer_->AppendToTestArtifact(write.filename, write.contents)
+             : writer_->StoreTestArtifact(write.filename, write.contents);
+}
+
+void AsyncTestArtifactWriter::WriteQueuedWrites() {
+  while (true) {
+    PendingWrite write;
+    {
+      absl::MutexLock lock(&mutex_);
+      auto has_work = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+        return shutting_down_ || !queue_.empty();
+      };
+      mutex_.Await(absl::Condition(&has_work));
+      // Queued writes are still written when shutting down.
+      if (queue_.empty()) return;
+      write = std::move(queue_.front());
+      queue_.pop_front();
+      write_in_progress_ = true;
+    }
+
+    absl::Status status = Write(write);
+
+    absl::MutexLock lock(&mutex_);
+    buffered_bytes_ -= write.size;
+    write_in_progress_ = false;
+    if (status_.ok()) status_ = status;
+  }
+}
+
 }  // namespace gutil
@@ -18,10 +18,15 @@ limitations under the License.
 #ifndef PINS_GUTIL_TEST_WRITER_H_
 #define PINS_GUTIL_TEST_WRITER_H_
 
+#include <cstdint>
+#include <deque>
 #include <fstream>
 #include <ios>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT: third_party code.
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
@@ -39,15 +44,22 @@ class TestArtifactWriter {
   // existing files.
   virtual absl::Status StoreTestArtifact(absl::string_view filename,
                                          absl::string_view contents) = 0;
-  absl::Status StoreTestArtifact(absl::string_view filename,
-                                 const google::protobuf::Message& proto);
+  virtual absl::Status StoreTestArtifact(
+      absl::string_view filename, const google::protobuf::Message& proto);
 
   // Appends contents to an existing test artifact with the specified filename.
   // Creates a new file if it doesn't exist.
   virtual absl::Status AppendToTestArtifact(absl::string_view filename,
                                             absl::string_view contents) = 0;
-  absl::Status AppendToTestArtifact(absl::string_view filename,
-                                    const google::protobuf::Message& proto);
+  virtual absl::Status AppendToTestArtifact(
+      absl::string_view filename, const google::protobuf::Message& proto);
+
+  // Appends `proto` as a binary record (see gutil/binary_proto_records.h) to
+  // the test artifact with the specified filename. Much cheaper than appending
+  // it as text for large protos; use `binary_proto_records_to_text` to view
+  // the artifact.
+  absl::Status AppendToBinaryTestArtifact(
+      absl::string_view filename, const google::protobuf::Message& proto);
 };
 
 // A thread-safe class for storing test artifacts.
@@ -82,6 +94,77 @@ class BazelTestArtifactWriter : public TestArtifactWriter {
   absl::Mutex write_mutex_;
 };
 
+struct AsyncTestArtifactWriterOptions {
+  // Callers block while this many bytes of writes are queued, so a slow disk
+  // cannot grow the queue without bound. A single larger write is still
+  // accepted once the queue is empty.
+  int64_t max_buffered_bytes = 64 << 20;
+};
+
+// A thread-safe TestArtifactWriter that returns immediately and performs the
+// writes of the wrapped `writer` on a background thread, in call order. Protos
+// are copied and only printed as text on the background thread, so storing
+// large protos does not stall the test.
+//
+// Since writes happen later, a failed write is reported by the next call (and
+// by `Flush`) rather than the call that queued it.
+class AsyncTestArtifactWriter : public TestArtifactWriter {
+ public:
+  explicit AsyncTestArtifactWriter(
+      std::unique_ptr<TestArtifactWriter> writer,
+      AsyncTestArtifactWriterOptions options = {});
+  // Waits for all queued writes.
+  ~AsyncTestArtifactWriter() override;
+
+  // Each of these returns the error of the first failed write so far, if any.
+  absl::Status StoreTestArtifact(absl::string_view filename,
+                                 absl::string_view contents) override;
+  absl::Status StoreTestArtifact(
+      absl::string_view filename,
+      const google::protobuf::Message& proto) override;
+  absl::Status AppendToTestArtifact(absl::string_view filename,
+                                    absl::string_view contents) override;
+  absl::Status AppendToTestArtifact(
+      absl::string_view filename,
+      const google::protobuf::Message& proto) override;
+
+  // Blocks until all queued writes are done. Returns the error of the first
+  // failed write so far, if any.
+  absl::Status Flush() ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct PendingWrite {
+    std::string filename;
+    bool append = false;
+    // Exactly one of `contents` and `proto` is used.
+    std::string contents;
+    std::unique_ptr<google::protobuf::Message> proto;
+    int64_t size = 0;
+  };
+
+  absl::Status Enqueue(PendingWrite write) ABSL_LOCKS_EXCLUDED(mutex_);
+  absl::Status EnqueueProto(absl::string_view filename, bool append,
+                            const google::protobuf::Message& proto);
+  // Performs `write` with the wrapped writer.
+  absl::Status Write(const PendingWrite& write);
+  // Runs on `writer_thread_` until destruction.
+  void WriteQueuedWrites() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  const std::unique_ptr<TestArtifactWriter> writer_;
+  const AsyncTestArtifactWriterOptions options_;
+
+  absl::Mutex mutex_;
+  std::deque<PendingWrite> queue_ ABSL_GUARDED_BY(mutex_);
+  // The total size of `queue_`, and of the write in progress, if any.
+  int64_t buffered_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool write_in_progress_ ABSL_GUARDED_BY(mutex_) = false;
+  bool shutting_down_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+
+  // Declared last, so it starts after everything it uses is initialized.
+  std::thread writer_thread_;
+};
+
 }  // namespace gutil
 
 #endif  // PINS_GUTIL_TEST_WRITER_H_
@@ -15,15 +15,22 @@ limitations under the License.
 
 #include "gutil/test_artifact_writer.h"
 
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 // Switching benchmark dependency to third_party seems to not output any
 // benchmarking information when run.
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "benchmark/benchmark.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "gutil/binary_proto_records.h"
+#include "gutil/proto.h"
 #include "gutil/status_matchers.h"
 #include "gutil/test_artifact_writer_test.pb.h"
 
@@ -31,6 +38,10 @@ namespace gutil {
 namespace {
 
 using ::gutil::IsOk;
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
 
 // -- Tests --------------------------------------------------------------------
 
@@ -72,6 +83,94 @@ TEST(BazelTestArtifactWriterTest, AppendStoreAppendTestArtifact) {
       artifact_writer.AppendToTestArtifact(kTestArtifact, GetTestProto()));
 }
 
+// Stores artifacts in memory, optionally failing every write.
+class InMemoryTestArtifactWriter : public TestArtifactWriter {
+ public:
+  explicit InMemoryTestArtifactWriter(
+      absl::flat_hash_map<std::string, std::string>& contents_by_filename,
+      absl::Status write_status = absl::OkStatus())
+      : contents_by_filename_(contents_by_filename),
+        write_status_(std::move(write_status)) {}
+
+  absl::Status StoreTestArtifact(absl::string_view filename,
+                                 absl::string_view contents) override {
+    contents_by_filename_[filename] = std::string(contents);
+    return write_status_;
+  }
+  using TestArtifactWriter::StoreTestArtifact;
+
+  absl::Status AppendToTestArtifact(absl::string_view filename,
+                                    absl::string_view contents) override {
+    absl::StrAppend(&contents_by_filename_[filename], contents);
+    return write_status_;
+  }
+  using TestArtifactWriter::AppendToTestArtifact;
+
+ private:
+  absl::flat_hash_map<std::string, std::string>& contents_by_filename_;
+  absl::Status write_status_;
+};
+
+TEST(AsyncTestArtifactWriterTest, WritesInCallOrder) {
+  absl::flat_hash_map<std::string, std::string> contents_by_filename;
+  AsyncTestArtifactWriter artifact_writer(
+      std::make_unique<InMemoryTestArtifactWriter>(contents_by_filename),
+      {.max_buffered_bytes = 4});
+  EXPECT_OK(artifact_writer.AppendToTestArtifact("a", "Hello, "));
+  EXPECT_OK(artifact_writer.AppendToTestArtifact("a", "World!"));
+  EXPECT_OK(artifact_writer.StoreTestArtifact("b", "overwritten"));
+  EXPECT_OK(artifact_writer.StoreTestArtifact("b", GetTestProto()));
+  EXPECT_OK(artifact_writer.AppendToTestArtifact("b", GetTestProto()));
+  ASSERT_OK(artifact_writer.Flush());
+
+  const std::string text_proto = PrintTextProto(GetTestProto());
+  EXPECT_THAT(contents_by_filename,
+              UnorderedElementsAre(
+                  Pair("a", "Hello, World!"),
+                  Pair("b", absl::StrCat(text_proto, text_proto, "\n"))));
+}
+
+TEST(AsyncTestArtifactWriterTest, WritesQueuedWritesOnDestruction) {
+  absl::flat_hash_map<std::string, std::string> contents_by_filename;
+  {
+    AsyncTestArtifactWriter artifact_writer(
+        std::make_unique<InMemoryTestArtifactWriter>(contents_by_filename));
+    EXPECT_OK(artifact_writer.StoreTestArtifact("a", "Hello"));
+  }
+  EXPECT_THAT(contents_by_filename, UnorderedElementsAre(Pair("a", "Hello")));
+}
+
+TEST(AsyncTestArtifactWriterTest, ReportsFailedWritesLater) {
+  absl::flat_hash_map<std::string, std::string> contents_by_filename;
+  AsyncTestArtifactWriter artifact_writer(
+      std::make_unique<InMemoryTestArtifactWriter>(
+          contents_by_filename, absl::InternalError("disk full")));
+  EXPECT_OK(artifact_writer.StoreTestArtifact("a", "Hello"));
+  EXPECT_THAT(artifact_writer.Flush(),
+              StatusIs(absl::StatusCode::kInternal));
+  EXPECT_THAT(artifact_writer.StoreTestArtifact("a", "Hello"),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
+TEST(TestArtifactWriterTest, AppendToBinaryTestArtifactAppendsRecords) {
+  absl::flat_hash_map<std::string, std::string> contents_by_filename;
+  InMemoryTestArtifactWriter artifact_writer(contents_by_filename);
+  EXPECT_OK(artifact_writer.AppendToBinaryTestArtifact("a", GetTestProto()));
+  EXPECT_OK(artifact_writer.AppendToBinaryTestArtifact("a", GetTestProto()));
+
+  const std::string text =
+      absl::StrCat("# gutil.ArtifactWriterTestMessage\n",
+                   PrintTextProto(GetTestProto()), "\n");
+  EXPECT_THAT(BinaryProtoRecordsToText(contents_by_filename["a"]),
+              IsOkAndHolds(absl::StrCat(text, text)));
+}
+
+TEST(BazelTestArtifactWriterTest, AppendToBinaryTestArtifact) {
+  BazelTestArtifactWriter artifact_writer;
+  EXPECT_OK(artifact_writer.AppendToBinaryTestArtifact("my_test_artifact.bin",
+                                                       GetTestProto()));
+}
+
 // -- Benchmarks ---------------------------------------------------------------
 //
 // Best run with 'blaze test --test_arg=--benchmark_filter=all <target>'.
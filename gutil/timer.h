@@ -15,17 +15,24 @@
 #ifndef PINS_GUTIL_TIMER_H_
 #define PINS_GUTIL_TIMER_H_
 
-#include "absl/time/clock.h"
+#include <chrono>  // NOLINT: absl has no monotonic clock.
+
 #include "absl/time/time.h"
 
 namespace gutil {
 
-// A simple timer implementation.
+// A simple timer implementation. Measures on a monotonic clock, so durations
+// are unaffected by wall clock adjustments (e.g. NTP steps), and reading it is
+// cheap enough to time short stages.
 class Timer {
  public:
   // Returns the duration between the current time and the last reset (or
   // initialization).
-  absl::Duration GetDuration() { return absl::Now() - start_time_; }
+  absl::Duration GetDuration() {
+    return absl::FromChrono(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                             start_time_));
+  }
 
   // Same as GetDuration. Resets the timer as well.
   absl::Duration GetDurationAndReset() {
@@ -36,10 +43,12 @@ class Timer {
 
   // Subsequent calls to GetDuration will measure the duration between the last
   // call to Reset and those calls.
-  void Reset() { start_time_ = absl::Now(); }
+  void Reset() { start_time_ = Clock::now(); }
 
  private:
-  absl::Time start_time_ = absl::Now();
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point start_time_ = Clock::now();
 };
 
 }  // namespace gutil
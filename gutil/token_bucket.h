@@ -0,0 +1,83 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_GUTIL_TOKEN_BUCKET_H_
+#define PINS_GUTIL_TOKEN_BUCKET_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace gutil {
+
+// A token bucket for pacing work at `rate_per_second` on average while
+// allowing bursts of up to `burst` units. Tokens accrue continuously; callers
+// acquire as many as they are about to spend and sleep when the bucket is
+// empty, instead of sleeping a fixed delay per unit of work.
+//
+// Starts full. Not thread-safe.
+class TokenBucket {
+ public:
+  TokenBucket(double rate_per_second, int64_t burst,
+              absl::Time now = absl::Now())
+      : interval_(absl::Seconds(1) / rate_per_second),
+        burst_(std::max<int64_t>(burst, 1)),
+        // Everything before `empty_since_` has been spent, so a full bucket's
+        // worth of tokens has accrued at `now`.
+        empty_since_(now - burst_ * interval_) {}
+
+  // Acquires up to `max_tokens` tokens available at `now`. Returns the number
+  // of tokens acquired, which is 0 iff the bucket is empty.
+  int64_t TryAcquire(int64_t max_tokens, absl::Time now = absl::Now()) {
+    // Tokens beyond `burst_` are lost.
+    empty_since_ = std::max(empty_since_, now - burst_ * interval_);
+    const int64_t available = absl::IDivDuration(now - empty_since_, interval_,
+                                                 /*rem=*/&unused_remainder_);
+    const int64_t acquired = std::clamp<int64_t>(max_tokens, 0, available);
+    empty_since_ += acquired * interval_;
+    return acquired;
+  }
+
+  // Returns how long after `now` until at least one token is available.
+  absl::Duration TimeUntilAvailable(absl::Time now = absl::Now()) const {
+    return std::max(absl::ZeroDuration(), empty_since_ + interval_ - now);
+  }
+
+  // Blocks until at least one token is available, then acquires up to
+  // `max_tokens` of them. Returns the number of tokens acquired, which is at
+  // least 1 if `max_tokens` is positive.
+  int64_t Acquire(int64_t max_tokens) {
+    if (max_tokens <= 0) return 0;
+    absl::SleepFor(TimeUntilAvailable());
+    int64_t acquired;
+    while ((acquired = TryAcquire(max_tokens)) == 0) {
+      absl::SleepFor(TimeUntilAvailable());
+    }
+    return acquired;
+  }
+
+ private:
+  // The time it takes for one token to accrue.
+  absl::Duration interval_;
+  int64_t burst_;
+  // The bucket holds the tokens accrued since this time.
+  absl::Time empty_since_;
+  absl::Duration unused_remainder_;
+};
+
+}  // namespace gutil
+
+#endif  // PINS_GUTIL_TOKEN_BUCKET_H_
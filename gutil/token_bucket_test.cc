@@ -0,0 +1,66 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gutil/token_bucket.h"
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gtest/gtest.h"
+
+namespace gutil {
+namespace {
+
+const absl::Time kStart = absl::FromUnixSeconds(1000);
+
+TEST(TokenBucketTest, StartsFullWithBurstTokens) {
+  TokenBucket bucket(/*rate_per_second=*/10, /*burst=*/5, kStart);
+  EXPECT_EQ(bucket.TryAcquire(3, kStart), 3);
+  EXPECT_EQ(bucket.TryAcquire(3, kStart), 2);
+  EXPECT_EQ(bucket.TryAcquire(3, kStart), 0);
+}
+
+TEST(TokenBucketTest, RefillsAtRate) {
+  TokenBucket bucket(/*rate_per_second=*/10, /*burst=*/5, kStart);
+  ASSERT_EQ(bucket.TryAcquire(5, kStart), 5);
+
+  EXPECT_EQ(bucket.TimeUntilAvailable(kStart), absl::Milliseconds(100));
+  EXPECT_EQ(bucket.TryAcquire(5, kStart + absl::Milliseconds(99)), 0);
+  EXPECT_EQ(bucket.TryAcquire(5, kStart + absl::Milliseconds(250)), 2);
+  // The partially accrued third token is kept.
+  EXPECT_EQ(bucket.TimeUntilAvailable(kStart + absl::Milliseconds(250)),
+            absl::Milliseconds(50));
+  EXPECT_EQ(bucket.TryAcquire(5, kStart + absl::Milliseconds(300)), 1);
+}
+
+TEST(TokenBucketTest, DoesNotAccrueMoreThanBurst) {
+  TokenBucket bucket(/*rate_per_second=*/10, /*burst=*/5, kStart);
+  ASSERT_EQ(bucket.TryAcquire(5, kStart), 5);
+
+  const absl::Time later = kStart + absl::Seconds(60);
+  EXPECT_EQ(bucket.TimeUntilAvailable(later), absl::ZeroDuration());
+  EXPECT_EQ(bucket.TryAcquire(100, later), 5);
+  EXPECT_EQ(bucket.TryAcquire(100, later), 0);
+}
+
+TEST(TokenBucketTest, AcquireBlocksUntilATokenIsAvailable) {
+  TokenBucket bucket(/*rate_per_second=*/100, /*burst=*/1);
+  ASSERT_EQ(bucket.Acquire(10), 1);
+
+  const absl::Time before = absl::Now();
+  EXPECT_EQ(bucket.Acquire(10), 1);
+  EXPECT_GE(absl::Now() - before, absl::Milliseconds(9));
+}
+
+}  // namespace
+}  // namespace gutil
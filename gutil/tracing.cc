@@ -0,0 +1,231 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gutil/tracing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT: absl has no monotonic clock.
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace gutil {
+namespace {
+
+std::atomic<bool> tracing_enabled{false};
+std::atomic<int> buffer_capacity_per_thread{
+    kDefaultTraceBufferCapacityPerThread};
+
+int64_t NowNanoseconds() {
+  static const auto* const kOrigin = new std::chrono::steady_clock::time_point(
+      std::chrono::steady_clock::now());
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - *kOrigin)
+      .count();
+}
+
+// The events recorded by one thread. Only the owning thread records into it,
+// so its mutex is uncontended except while events are collected or cleared.
+class ThreadTraceBuffer {
+ public:
+  ThreadTraceBuffer(int thread_id, int capacity)
+      : thread_id_(thread_id), capacity_(std::max(capacity, 1)) {}
+
+  int thread_id() const { return thread_id_; }
+
+  // The number of open spans of the owning thread. Only accessed by the owning
+  // thread.
+  int& depth() { return depth_; }
+
+  void Record(TraceEvent event) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    if (static_cast<int>(events_.size()) < capacity_) {
+      events_.push_back(std::move(event));
+    } else {
+      events_[oldest_] = std::move(event);
+      oldest_ = (oldest_ + 1) % capacity_;
+    }
+  }
+
+  void AppendTo(std::vector<TraceEvent>& events) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    events.insert(events.end(), events_.begin(), events_.end());
+  }
+
+  void Clear() ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    events_.clear();
+    oldest_ = 0;
+  }
+
+ private:
+  const int thread_id_;
+  const int capacity_;
+  int depth_ = 0;
+  absl::Mutex mutex_;
+  // A ring of at most `capacity_` events.
+  std::vector<TraceEvent> events_ ABSL_GUARDED_BY(mutex_);
+  // The index of the oldest event in `events_`, once it is full.
+  int oldest_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+// The buffers of all threads that have recorded events. Buffers outlive their
+// threads, so events recorded by finished threads can still be collected.
+struct TraceBufferRegistry {
+  absl::Mutex mutex;
+  std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers
+      ABSL_GUARDED_BY(mutex);
+  int next_thread_id ABSL_GUARDED_BY(mutex) = 1;
+};
+
+TraceBufferRegistry& GetTraceBufferRegistry() {
+  static auto* const kRegistry = new TraceBufferRegistry();
+  return *kRegistry;
+}
+
+ThreadTraceBuffer& CurrentThreadTraceBuffer() {
+  thread_local const std::shared_ptr<ThreadTraceBuffer> buffer = [] {
+    TraceBufferRegistry& registry = GetTraceBufferRegistry();
+    absl::MutexLock lock(&registry.mutex);
+    auto buffer = std::make_shared<ThreadTraceBuffer>(
+        registry.next_thread_id++, buffer_capacity_per_thread.load());
+    registry.buffers.push_back(buffer);
+    return buffer;
+  }();
+  return *buffer;
+}
+
+// Escapes `text` for use within a JSON string.
+std::string JsonEscape(absl::string_view text) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (char c : text) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(&escaped, "\\u%04x", c);
+        } else {
+          escaped += c;
+        }
+    }
+  }
+  return escaped;
+}
+
+}  // namespace
+
+void SetTracingEnabled(bool enabled) {
+  tracing_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool IsTracingEnabled() {
+  return tracing_enabled.load(std::memory_order_relaxed);
+}
+
+void SetTraceBufferCapacityPerThread(int capacity) {
+  buffer_capacity_per_thread.store(capacity);
+}
+
+TraceSpan::TraceSpan(absl::string_view name) : enabled_(IsTracingEnabled()) {
+  if (!enabled_) return;
+  name_ = std::string(name);
+  ++CurrentThreadTraceBuffer().depth();
+  start_ns_ = NowNanoseconds();
+}
+
+TraceSpan::~TraceSpan() {
+  if (!enabled_) return;
+  const int64_t end_ns = NowNanoseconds();
+  ThreadTraceBuffer& buffer = CurrentThreadTraceBuffer();
+  const int depth = --buffer.depth();
+  buffer.Record(TraceEvent{
+      .name = std::move(name_),
+      .start = absl::Nanoseconds(start_ns_),
+      .duration = absl::Nanoseconds(end_ns - start_ns_),
+      .thread_id = buffer.thread_id(),
+      .depth = depth,
+  });
+}
+
+std::vector<TraceEvent> CollectTraceEvents() {
+  std::vector<TraceEvent> events;
+  TraceBufferRegistry& registry = GetTraceBufferRegistry();
+  {
+    absl::MutexLock lock(&registry.mutex);
+    for (const auto& buffer : registry.buffers) buffer->AppendTo(events);
+  }
+  // Parents start no later than their children; order them first on ties so
+  // viewers nest them correctly.
+  std::stable_sort(events.begin(), events.end(),
+                   [](const TraceEvent& a, const TraceEvent& b) {
+                     if (a.start != b.start) return a.start < b.start;
+                     return a.depth < b.depth;
+                   });
+  return events;
+}
+
+void ClearTraceEvents() {
+  TraceBufferRegistry& registry = GetTraceBufferRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  // Buffers only referenced by the registry belong to finished threads.
+  registry.buffers.erase(
+      std::remove_if(registry.buffers.begin(), registry.buffers.end(),
+                     [](const std::shared_ptr<ThreadTraceBuffer>& buffer) {
+                       return buffer.use_count() == 1;
+                     }),
+      registry.buffers.end());
+  for (const auto& buffer : registry.buffers) buffer->Clear();
+}
+
+std::string TraceEventsToChromeTraceJson(absl::Span<const TraceEvent> events) {
+  std::string json = "{\"traceEvents\":[";
+  for (size_t i = 0; i < events.size(); ++i) {
+    const TraceEvent& event = events[i];
+    // Chrome trace timestamps and durations are in microseconds.
+    absl::StrAppendFormat(
+        &json,
+        "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+        "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"depth\":%d}}",
+        i == 0 ? "" : ",", JsonEscape(event.name), event.thread_id,
+        absl::ToDoubleMicroseconds(event.start),
+        absl::ToDoubleMicroseconds(event.duration), event.depth);
+  }
+  absl::StrAppend(&json, "\n],\"displayTimeUnit\":\"ns\"}\n");
+  return json;
+}
+
+}  // namespace gutil
@@ -0,0 +1,101 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_GUTIL_TRACING_H_
+#define PINS_GUTIL_TRACING_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace gutil {
+
+// Lightweight scoped tracing spans for finding out where latency goes.
+//
+// Tracing is disabled by default, in which case a `TraceSpan` costs a single
+// atomic load. When enabled, every thread records its completed spans into its
+// own bounded ring buffer (so recording never contends with other threads),
+// timed on a monotonic clock. The recorded events can be exported in Chrome's
+// trace event format and viewed as a timeline in chrome://tracing or
+// https://ui.perfetto.dev, e.g.
+//
+//   gutil::SetTracingEnabled(true);
+//   ...
+//   {
+//     gutil::TraceSpan span("translate");
+//     ...
+//   }
+//   ...
+//   RETURN_IF_ERROR(artifact_writer.StoreTestArtifact(
+//       "trace.json",
+//       gutil::TraceEventsToChromeTraceJson(gutil::CollectTraceEvents())));
+
+// A completed span.
+struct TraceEvent {
+  std::string name;
+  // Time since an arbitrary, process-wide origin at which the span started.
+  absl::Duration start;
+  absl::Duration duration;
+  // Identifies the thread that recorded the event. Unique within the process.
+  int thread_id = 0;
+  // The number of spans on the same thread that enclose this span.
+  int depth = 0;
+};
+
+// Enables or disables recording spans, process-wide. Spans that are already
+// open when tracing is toggled keep the state they were opened with.
+void SetTracingEnabled(bool enabled);
+bool IsTracingEnabled();
+
+// The maximum number of events kept per thread; once reached, the oldest
+// events of the thread are dropped. Applies to threads recording their first
+// event after the call.
+inline constexpr int kDefaultTraceBufferCapacityPerThread = 1 << 16;
+void SetTraceBufferCapacityPerThread(int capacity);
+
+// Records the time from construction to destruction as a `TraceEvent` of the
+// current thread, if tracing is enabled on construction. Spans nest: a span
+// opened while another span of the same thread is open is its child.
+class TraceSpan {
+ public:
+  explicit TraceSpan(absl::string_view name);
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  bool enabled_ = false;
+  std::string name_;
+  // Nanoseconds since the trace origin.
+  int64_t start_ns_ = 0;
+};
+
+// Returns the events recorded by all threads that are still buffered, ordered
+// by start time.
+std::vector<TraceEvent> CollectTraceEvents();
+
+// Drops all recorded events.
+void ClearTraceEvents();
+
+// Returns `events` in Chrome's trace event JSON format.
+std::string TraceEventsToChromeTraceJson(absl::Span<const TraceEvent> events);
+
+}  // namespace gutil
+
+#endif  // PINS_GUTIL_TRACING_H_
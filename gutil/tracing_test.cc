@@ -0,0 +1,110 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gutil/tracing.h"
+
+#include <string>
+#include <thread>  // NOLINT: third_party code.
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace gutil {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::Ge;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Le;
+
+class TracingTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ClearTraceEvents();
+    SetTracingEnabled(true);
+  }
+  void TearDown() override {
+    SetTracingEnabled(false);
+    SetTraceBufferCapacityPerThread(kDefaultTraceBufferCapacityPerThread);
+    ClearTraceEvents();
+  }
+};
+
+TEST_F(TracingTest, RecordsNothingWhileDisabled) {
+  SetTracingEnabled(false);
+  { TraceSpan span("span"); }
+  EXPECT_THAT(CollectTraceEvents(), IsEmpty());
+}
+
+TEST_F(TracingTest, RecordsNestedSpans) {
+  {
+    TraceSpan parent("parent");
+    { TraceSpan child("child"); }
+  }
+  std::vector<TraceEvent> events = CollectTraceEvents();
+  ASSERT_THAT(events, ElementsAre(Field(&TraceEvent::name, "parent"),
+                                  Field(&TraceEvent::name, "child")));
+  const TraceEvent& parent = events[0];
+  const TraceEvent& child = events[1];
+  EXPECT_EQ(parent.depth, 0);
+  EXPECT_EQ(child.depth, 1);
+  EXPECT_EQ(parent.thread_id, child.thread_id);
+  EXPECT_THAT(child.start, Ge(parent.start));
+  EXPECT_THAT(child.start + child.duration,
+              Le(parent.start + parent.duration));
+}
+
+TEST_F(TracingTest, RecordsSpansOfEveryThread) {
+  std::thread thread([] { TraceSpan span("other thread"); });
+  thread.join();
+  { TraceSpan span("this thread"); }
+
+  std::vector<TraceEvent> events = CollectTraceEvents();
+  ASSERT_EQ(events.size(), 2);
+  EXPECT_NE(events[0].thread_id, events[1].thread_id);
+  EXPECT_EQ(events[0].name, "other thread");
+}
+
+TEST_F(TracingTest, DropsOldestEventsOfFullBuffers) {
+  SetTraceBufferCapacityPerThread(2);
+  std::thread thread([] {
+    for (absl::string_view name : {"1", "2", "3"}) TraceSpan span(name);
+  });
+  thread.join();
+
+  EXPECT_THAT(CollectTraceEvents(),
+              ElementsAre(Field(&TraceEvent::name, "2"),
+                          Field(&TraceEvent::name, "3")));
+}
+
+TEST(TraceEventsToChromeTraceJsonTest, ReturnsCompleteEvents) {
+  std::string json = TraceEventsToChromeTraceJson({TraceEvent{
+      .name = "say \"hi\"",
+      .start = absl::Microseconds(1.5),
+      .duration = absl::Nanoseconds(2),
+      .thread_id = 3,
+  }});
+  EXPECT_THAT(json, HasSubstr("{\"traceEvents\":["));
+  EXPECT_THAT(json, HasSubstr("{\"name\":\"say \\\"hi\\\"\",\"ph\":\"X\","
+                              "\"pid\":1,\"tid\":3,\"ts\":1.500,"
+                              "\"dur\":0.002,\"args\":{\"depth\":0}}"));
+}
+
+}  // namespace
+}  // namespace gutil
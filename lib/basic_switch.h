@@ -21,11 +21,16 @@
 #include <string_view>
 #include <utility>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "cert/cert.grpc.pb.h"
 #include "diag/diag.grpc.pb.h"
 #include "factory_reset/factory_reset.grpc.pb.h"
 #include "grpc/grpc_security_constants.h"
+#include "grpcpp/channel.h"
+#include "grpcpp/create_channel.h"
 #include "grpcpp/security/credentials.h"
 #include "grpcpp/support/channel_arguments.h"
 #include "grpcpp/support/stub_options.h"
@@ -74,6 +79,61 @@ class CreateGrpcStub : private CredentialsPolicy {
   }
 };
 
+// A stub creation policy like `CreateGrpcStub`, but one that keeps a pool of
+// channels keyed by chassis and service and creates every stub on the pooled
+// channel. Stubs are cheap; the channel owns the connection, so reusing it
+// saves a TCP/TLS handshake per stub and keeps connection churn off the
+// switch's management plane when helpers create stubs in a loop.
+//
+// Before a pooled channel is reused, it is health checked: a channel that has
+// been shut down, or that is in TRANSIENT_FAILURE (e.g. because the switch
+// rebooted and the channel is backing off), is replaced by a fresh channel.
+//
+// Thread-safe.
+template <class CredentialsPolicy>
+class CreatePooledGrpcStub : private CredentialsPolicy {
+ public:
+  template <class... Args>
+  explicit CreatePooledGrpcStub(Args&&... args)
+      : CredentialsPolicy(std::forward<Args>(args)...) {}
+
+  template <class NewStubFunction>
+  auto Create(NewStubFunction&& new_stub, const std::string& address,
+              std::string_view chassis, std::string_view stub_type,
+              grpc::ChannelArguments channel_arguments = {}) {
+    return new_stub(
+        GetOrCreateChannel(address, chassis, stub_type, channel_arguments),
+        grpc::StubOptions());
+  }
+
+ private:
+  std::shared_ptr<grpc::Channel> GetOrCreateChannel(
+      const std::string& address, std::string_view chassis,
+      std::string_view stub_type,
+      const grpc::ChannelArguments& channel_arguments) {
+    absl::MutexLock lock(&mutex_);
+    std::shared_ptr<grpc::Channel>& channel =
+        channels_[std::make_pair(std::string(chassis), std::string(stub_type))];
+    if (channel == nullptr || !IsHealthy(*channel)) {
+      channel = grpc::CreateCustomChannel(
+          address, CredentialsPolicy::Credentials(), channel_arguments);
+    }
+    return channel;
+  }
+
+  static bool IsHealthy(grpc::Channel& channel) {
+    const grpc_connectivity_state state =
+        channel.GetState(/*try_to_connect=*/false);
+    return state != GRPC_CHANNEL_SHUTDOWN &&
+           state != GRPC_CHANNEL_TRANSIENT_FAILURE;
+  }
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::pair<std::string, std::string>,
+                      std::shared_ptr<grpc::Channel>>
+      channels_ ABSL_GUARDED_BY(mutex_);
+};
+
 // BasicSwitch implements ThinKit's Switch interface by creating stubs to
 // addresses of the various gRPC services that connect to the switch. The
 // template parameter allows the user to provide a policy class to create new
@@ -95,6 +155,7 @@ class CreateGrpcStub : private CredentialsPolicy {
 // };
 // BasicSwitch<CreateMyGrpcStub> my_switch(...);
 // absl::make_unique<BasicSwitch<CreateGrpcStub<LocalTcp>>>(...);
+// absl::make_unique<BasicSwitch<CreatePooledGrpcStub<LocalTcp>>>(...);
 template <class CreateStubPolicy>
 class BasicSwitch : public thinkit::Switch, private CreateStubPolicy {
  public:
@@ -14,6 +14,7 @@
 
 #include "lib/basic_switch.h"
 
+#include <chrono>  // NOLINT: grpc deadlines are std::chrono time points.
 #include <functional>
 #include <memory>
 #include <string_view>
@@ -23,7 +24,9 @@
 #include "diag/diag.grpc.pb.h"
 #include "factory_reset/factory_reset.grpc.pb.h"
 #include "gmock/gmock.h"
+#include "grpcpp/security/credentials.h"
 #include "grpcpp/support/channel_arguments.h"
+#include "grpcpp/support/stub_options.h"
 #include "gtest/gtest.h"
 #include "gutil/status_matchers.h"
 #include "os/os.grpc.pb.h"
@@ -38,6 +41,7 @@ using ::gutil::IsOkAndHolds;
 using ::testing::AtLeast;
 using ::testing::IsNull;
 using ::testing::MockFunction;
+using ::testing::NotNull;
 
 // Calls the mock function on `Create` and returns nullptr.
 class MockCreateGrpcStub {
@@ -91,5 +95,61 @@ TEST(BasicSwitch, MakeUniqueCompiles) {
       [](std::string_view, std::string_view) {});
 }
 
+class InsecureCredentials {
+ public:
+  std::shared_ptr<grpc::ChannelCredentials> Credentials() {
+    return grpc::InsecureChannelCredentials();
+  }
+};
+
+// Returns the channel a stub would have been created on.
+std::shared_ptr<grpc::ChannelInterface> ChannelOf(
+    const std::shared_ptr<grpc::ChannelInterface>& channel,
+    const grpc::StubOptions&) {
+  return channel;
+}
+
+TEST(CreatePooledGrpcStub, ReusesChannelPerChassisAndService) {
+  CreatePooledGrpcStub<InsecureCredentials> policy;
+  std::shared_ptr<grpc::ChannelInterface> gnmi =
+      policy.Create(ChannelOf, "localhost:1", "my.switch", "gNMI");
+  ASSERT_THAT(gnmi, NotNull());
+  EXPECT_EQ(policy.Create(ChannelOf, "localhost:1", "my.switch", "gNMI"),
+            gnmi);
+  EXPECT_NE(policy.Create(ChannelOf, "localhost:1", "my.switch", "gNOI OS"),
+            gnmi);
+  EXPECT_NE(policy.Create(ChannelOf, "localhost:1", "other.switch", "gNMI"),
+            gnmi);
+}
+
+TEST(CreatePooledGrpcStub, ReplacesChannelsInTransientFailure) {
+  CreatePooledGrpcStub<InsecureCredentials> policy;
+  // Nothing listens on port 1, so connecting fails.
+  std::shared_ptr<grpc::ChannelInterface> channel =
+      policy.Create(ChannelOf, "localhost:1", "my.switch", "gNMI");
+  const auto deadline =
+      std::chrono::system_clock::now() + std::chrono::seconds(10);
+  grpc_connectivity_state state = channel->GetState(/*try_to_connect=*/true);
+  while (state != GRPC_CHANNEL_TRANSIENT_FAILURE &&
+         channel->WaitForStateChange(state, deadline)) {
+    state = channel->GetState(/*try_to_connect=*/false);
+  }
+  ASSERT_EQ(state, GRPC_CHANNEL_TRANSIENT_FAILURE);
+  EXPECT_NE(policy.Create(ChannelOf, "localhost:1", "my.switch", "gNMI"),
+            channel);
+}
+
+TEST(BasicSwitch, WorksWithPooledGrpcStubs) {
+  BasicSwitch<CreatePooledGrpcStub<InsecureCredentials>> my_switch(
+      "my.switch", /*device_id=*/0,
+      SwitchServices{.p4runtime_address = "localhost:1",
+                     .gnmi_address = "localhost:2",
+                     .gnoi_address = "localhost:3"});
+  EXPECT_THAT(my_switch.CreateP4RuntimeStub(), IsOkAndHolds(NotNull()));
+  EXPECT_THAT(my_switch.CreateGnmiStub(), IsOkAndHolds(NotNull()));
+  EXPECT_THAT(my_switch.CreateGnmiStub(), IsOkAndHolds(NotNull()));
+  EXPECT_THAT(my_switch.CreateGnoiSystemStub(), IsOkAndHolds(NotNull()));
+}
+
 }  // namespace
 }  // namespace pins_test
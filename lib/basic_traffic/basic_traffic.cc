@@ -15,9 +15,12 @@
 #include "lib/basic_traffic/basic_traffic.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>  // NOLINT
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -35,8 +38,10 @@
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "gutil/adaptive_rate_controller.h"
 #include "gutil/collections.h"
 #include "gutil/status.h"
+#include "gutil/token_bucket.h"
 #include "lib/basic_traffic/basic_p4rt_util.h"
 #include "lib/gnmi/gnmi_helper.h"
 #include "lib/p4rt/p4rt_programming_context.h"
@@ -46,6 +51,7 @@
 #include "p4_pdpi/p4_runtime_session.h"
 #include "p4_pdpi/packetlib/packetlib.h"
 #include "p4_pdpi/packetlib/packetlib.pb.h"
+#include "p4_pdpi/sequencing.h"
 #include "thinkit/control_device.h"
 #include "thinkit/generic_testbed.h"
 #include "thinkit/switch.h"
@@ -57,11 +63,15 @@ namespace {
 // according to a certain set of interface pairs, the `serialized_packet` to be
 // actually sent, and the `control_interface` to send it out of.
 struct PrecomputedPacket {
+  int pair_index;
   std::string control_interface;
   packetlib::Packet packet;
   std::string serialized_packet;
 };
 
+// An element of the map from flow key to precomputed packet.
+using KeyedPacket = std::pair<const std::string, PrecomputedPacket>;
+
 // A struct that represents a key for every flow. This key identifies a flow by
 // the index of the packet and the index of the interface pair that packet is
 // sent into and expected to be received from.
@@ -86,30 +96,6 @@ std::string SerializeKey(Key key) {
   return absl::StrCat(key.pair_index, ":", key.packet_index);
 }
 
-// Parses the `key` string.
-absl::StatusOr<Key> DeserializeKey(absl::string_view key) {
-  std::vector<absl::string_view> key_parts = absl::StrSplit(key, ':');
-  if (key_parts.size() != 2) {
-    return absl::InternalError(absl::StrCat(
-        "Key '", key, "' does not match format pair_index:packet_index."));
-  }
-  int pair_index;
-  if (!absl::SimpleAtoi(key_parts[0], &pair_index)) {
-    return absl::InternalError(
-        absl::StrCat("Key '", key,
-                     "' with format pair_index:packet_index, pair_index is not "
-                     "an int."));
-  }
-  int packet_index;
-  if (!absl::SimpleAtoi(key_parts[1], &packet_index)) {
-    return absl::InternalError(absl::StrCat(
-        "Key '", key,
-        "' with format pair_index:packet_index, packet_index is not "
-        "an int."));
-  }
-  return Key{.pair_index = pair_index, .packet_index = packet_index};
-}
-
 // Precomputes the packets to send to which control interfaces by substituting
 // the proper destination IP and payload fields and serializing them. The
 // precomputed packets contain the payload key, the final packet proto, and the
@@ -162,6 +148,7 @@ PrecomputePackets(
                        RawSerializePacket(packet));
 
       precomputed_packets[std::move(key)] = PrecomputedPacket{
+          .pair_index = pair_index,
           .control_interface = control_info.peer_interface_name,
           .packet = std::move(packet),
           .serialized_packet = std::move(serialized_packet)};
@@ -170,10 +157,112 @@ PrecomputePackets(
   return precomputed_packets;
 }
 
-// Returns the payload with 0-padding removed that might have been added to a
-// packet to fulfill minimum length requirements.
-absl::string_view RemovePadding(absl::string_view payload) {
-  return payload.substr(0, payload.find_first_of('\0'));
+// Identifies the flow of a received packet by looking up its payload, which
+// routing leaves untouched, in a hash map instead of parsing the packet.
+class FlowLookup {
+ public:
+  // `packets` must outlive this object.
+  explicit FlowLookup(
+      const absl::flat_hash_map<std::string, PrecomputedPacket>& packets) {
+    for (const auto& key_and_packet : packets) {
+      const std::string& payload = key_and_packet.second.packet.payload();
+      flow_from_payload_[payload] = &key_and_packet;
+      payload_sizes_.insert(payload.size());
+    }
+  }
+
+  // Returns the key and precomputed packet of the flow that `packet_string`
+  // belongs to, or nullptr if it is not a packet that was sent (e.g. one picked
+  // up by PacketIO).
+  const KeyedPacket* Find(absl::string_view packet_string) const {
+    // The payload is the end of the packet. There are only as many distinct
+    // payload sizes as there are packets per pair.
+    for (size_t payload_size : payload_sizes_) {
+      if (payload_size > packet_string.size()) continue;
+      auto it = flow_from_payload_.find(
+          packet_string.substr(packet_string.size() - payload_size));
+      if (it != flow_from_payload_.end()) return it->second;
+    }
+    return nullptr;
+  }
+
+ private:
+  absl::flat_hash_map<absl::string_view, const KeyedPacket*> flow_from_payload_;
+  absl::flat_hash_set<size_t> payload_sizes_;
+};
+
+// Sends `packets` over and over until `duration` has passed since
+// `start_time`, paced to `packets_per_second`, and counts the packets sent per
+// key in `sent_packets`.
+absl::Status SendPacketsFor(
+    thinkit::ControlDevice& control_device,
+    absl::Span<const KeyedPacket* const> packets,
+    double packets_per_second, absl::Time start_time, absl::Duration duration,
+    absl::flat_hash_map<std::string, int>& sent_packets) {
+  gutil::TokenBucket token_bucket(packets_per_second, /*burst=*/1);
+  while (absl::Now() - start_time < duration) {
+    for (const auto* key_and_packet : packets) {
+      const auto& [key, packet] = *key_and_packet;
+      token_bucket.Acquire(1);
+      RETURN_IF_ERROR(control_device.SendPacket(
+          packet.control_interface, packet.serialized_packet, std::nullopt));
+      sent_packets[key]++;
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Sends `packets_to_send` like `SendPacketsFor` on `num_threads` threads, each
+// sending the packets of a share of the control interfaces.
+absl::Status SendPacketsConcurrentlyFor(
+    thinkit::ControlDevice& control_device,
+    const absl::flat_hash_map<std::string, PrecomputedPacket>& packets_to_send,
+    int num_threads, double packets_per_second, absl::Duration duration,
+    absl::flat_hash_map<std::string, int>& sent_packets) {
+  // Assign every control interface to a thread, round robin.
+  absl::flat_hash_map<std::string, int> thread_from_interface;
+  std::vector<std::string> interfaces;
+  for (const auto& [key, packet] : packets_to_send) {
+    if (thread_from_interface.insert({packet.control_interface, 0}).second) {
+      interfaces.push_back(packet.control_interface);
+    }
+  }
+  absl::c_sort(interfaces);
+  num_threads = std::min<int>(num_threads, interfaces.size());
+  for (int i = 0; i < interfaces.size(); ++i) {
+    thread_from_interface[interfaces[i]] = i % num_threads;
+  }
+  std::vector<std::vector<const KeyedPacket*>> packets_by_thread(num_threads);
+  for (const auto& key_and_packet : packets_to_send) {
+    packets_by_thread[thread_from_interface[key_and_packet.second
+                                                .control_interface]]
+        .push_back(&key_and_packet);
+  }
+
+  std::vector<absl::Status> statuses(num_threads);
+  std::vector<absl::flat_hash_map<std::string, int>> sent_by_thread(
+      num_threads);
+  std::vector<std::thread> threads;
+  const absl::Time start_time = absl::Now();
+  for (int i = 0; i < num_threads; ++i) {
+    // Each thread gets the share of the rate of its share of the packets.
+    const double thread_packets_per_second =
+        packets_per_second * packets_by_thread[i].size() /
+        packets_to_send.size();
+    threads.emplace_back([&, i, thread_packets_per_second] {
+      statuses[i] = SendPacketsFor(control_device, packets_by_thread[i],
+                                   thread_packets_per_second, start_time,
+                                   duration, sent_by_thread[i]);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (int i = 0; i < num_threads; ++i) {
+    for (const auto& [key, count] : sent_by_thread[i]) {
+      sent_packets[key] += count;
+    }
+  }
+  for (const absl::Status& status : statuses) RETURN_IF_ERROR(status);
+  return absl::OkStatus();
 }
 
 }  // namespace
@@ -206,6 +295,33 @@ absl::Status ProgramRoutes(
   return ProgramL3AdmitTableEntry(write_request, ir_p4info);
 }
 
+absl::Status ProgramRoutesInBatches(
+    const std::function<absl::Status(p4::v1::WriteRequest&)>& write_request,
+    const pdpi::IrP4Info& ir_p4info,
+    const absl::flat_hash_map<std::string, std::string>& port_id_from_interface,
+    absl::Span<const InterfacePair> pairs) {
+  // Collect the updates that `ProgramRoutes` would write one by one.
+  std::vector<p4::v1::Update> updates;
+  RETURN_IF_ERROR(ProgramRoutes(
+      [&updates](p4::v1::WriteRequest& request) {
+        for (p4::v1::Update& update : *request.mutable_updates()) {
+          updates.push_back(std::move(update));
+        }
+        return absl::OkStatus();
+      },
+      ir_p4info, port_id_from_interface, pairs));
+
+  ASSIGN_OR_RETURN(
+      std::vector<p4::v1::WriteRequest> requests,
+      pdpi::SequencePiUpdatesIntoWriteRequests(ir_p4info, updates));
+  LOG(INFO) << "Programming " << updates.size() << " route entries in "
+            << requests.size() << " write requests.";
+  for (p4::v1::WriteRequest& request : requests) {
+    RETURN_IF_ERROR(write_request(request));
+  }
+  return absl::OkStatus();
+}
+
 std::vector<InterfacePair> OneToOne(
     absl::Span<const std::string> sources,
     absl::Span<const std::string> destinations) {
@@ -275,15 +391,20 @@ absl::StatusOr<std::vector<TrafficStatistic>> SendTraffic(
   ASSIGN_OR_RETURN(auto gnmi_stub, testbed.Sut().CreateGnmiStub());
   ASSIGN_OR_RETURN(auto port_id_from_sut_interface,
                    GetAllInterfaceNameToPortId(*gnmi_stub));
-  P4rtProgrammingContext p4rt_context(session,
-                                      std::move(options.write_request));
+  // With batched route programming, the routes are also reverted in batches.
+  P4rtProgrammingContext p4rt_context =
+      options.batch_route_programming
+          ? P4rtProgrammingContext(session, ir_p4info,
+                                   std::move(options.write_request))
+          : P4rtProgrammingContext(session, std::move(options.write_request));
 
   if (options.program_routes) {
     // Program the necessary table entries to forward traffic between the
     // interface pair.
-    RETURN_IF_ERROR(ProgramRoutes(p4rt_context.GetWriteRequestFunction(),
-                                  ir_p4info, port_id_from_sut_interface,
-                                  pairs));
+    RETURN_IF_ERROR((options.batch_route_programming ? ProgramRoutesInBatches
+                                                     : ProgramRoutes)(
+        p4rt_context.GetWriteRequestFunction(), ir_p4info,
+        port_id_from_sut_interface, pairs));
   } else {
     LOG(INFO) << "Skipped route programming";
   }
@@ -298,27 +419,80 @@ absl::StatusOr<std::vector<TrafficStatistic>> SendTraffic(
   // Send packets.
   absl::flat_hash_map<std::string, int> sent_packets;
   std::vector<std::tuple<std::string, std::string>> received_packets;
+  if (options.num_sending_threads > 1) {
+    RET_CHECK(!options.adaptive_rate.has_value())
+        << "adaptive_rate is not supported with multiple sending threads";
+  }
   {
     ASSIGN_OR_RETURN(auto finalizer, testbed.ControlDevice().CollectPackets());
 
     LOG(INFO) << "Starting to send traffic.";
     absl::Time start_time = absl::Now();
-    absl::Time last_sent_time = start_time;
-    absl::Duration interpacket_time =
-        absl::Seconds(1.0f / options.packets_per_second);
-    while (absl::Now() - start_time < duration) {
+    if (options.num_sending_threads > 1) {
+      RETURN_IF_ERROR(SendPacketsConcurrentlyFor(
+          testbed.ControlDevice(), packets_to_send, options.num_sending_threads,
+          options.packets_per_second, duration, sent_packets));
+      if (options.packets_sent != nullptr) {
+        for (const auto& [key, count] : sent_packets) {
+          *options.packets_sent += count;
+        }
+      }
+    }
+    // Pace packets with a token bucket, which sleeps until the next packet is
+    // due instead of busy-waiting between packets.
+    gutil::TokenBucket token_bucket(options.packets_per_second,
+                                    /*burst=*/1);
+
+    // With an adaptive rate, the token bucket is replaced at the end of every
+    // adaptation interval.
+    std::optional<gutil::AdaptiveRateController> rate_controller;
+    absl::Time interval_start = start_time;
+    int packets_sent_in_interval = 0;
+    int64_t drop_count_at_interval_start = 0;
+    if (options.adaptive_rate.has_value()) {
+      RET_CHECK(options.read_drop_count != nullptr)
+          << "read_drop_count is required for an adaptive rate";
+      gutil::AdaptiveRateOptions rate_options = *options.adaptive_rate;
+      rate_options.initial_rate = options.packets_per_second;
+      rate_controller.emplace(rate_options);
+      token_bucket = gutil::TokenBucket(rate_controller->rate(), /*burst=*/1);
+      ASSIGN_OR_RETURN(drop_count_at_interval_start, options.read_drop_count());
+    }
+
+    while (options.num_sending_threads <= 1 &&
+           absl::Now() - start_time < duration) {
       for (const auto& [key, packet] : packets_to_send) {
+        token_bucket.Acquire(1);
         RETURN_IF_ERROR(testbed.ControlDevice().SendPacket(
             packet.control_interface, packet.serialized_packet, std::nullopt));
         sent_packets[key]++;
         if (options.packets_sent != nullptr) {
           (*options.packets_sent)++;
         }
-        while (absl::Now() - last_sent_time < interpacket_time) {
+
+        ++packets_sent_in_interval;
+        if (!rate_controller.has_value() ||
+            absl::Now() - interval_start < options.adaptation_interval) {
+          continue;
         }
-        last_sent_time = absl::Now();
+        ASSIGN_OR_RETURN(int64_t drop_count, options.read_drop_count());
+        const int64_t dropped = drop_count - drop_count_at_interval_start;
+        rate_controller->ReportInterval(packets_sent_in_interval, dropped);
+        LOG(INFO) << "Dropped " << dropped
+                  << " of " << packets_sent_in_interval
+                  << " packets; sending at " << rate_controller->rate()
+                  << " packets per second.";
+        token_bucket = gutil::TokenBucket(rate_controller->rate(), /*burst=*/1);
+        interval_start = absl::Now();
+        packets_sent_in_interval = 0;
+        drop_count_at_interval_start = drop_count;
       }
     }
+    if (rate_controller.has_value() &&
+        options.sustained_packets_per_second != nullptr) {
+      *options.sustained_packets_per_second =
+          rate_controller->sustained_max_rate().value_or(0);
+    }
 
     RETURN_IF_ERROR(finalizer->HandlePacketsFor(
         kPassthroughWaitTime,
@@ -339,29 +513,29 @@ absl::StatusOr<std::vector<TrafficStatistic>> SendTraffic(
         link.sut_interface;
   }
 
-  // Parse the received packets and bucket them based on their payload. Valid
-  // packets are those that came in on the expected egress interface, while
-  // invalid packets are those that came in on a different egress interface.
+  // Bucket the received packets based on their payload. Valid packets are
+  // those that came in on the expected egress interface, while invalid packets
+  // are those that came in on a different egress interface.
+  const FlowLookup flow_lookup(packets_to_send);
   absl::flat_hash_map<std::string, int> valid_received_packets;
   absl::flat_hash_map<std::string, int> invalid_received_packets;
   for (const auto& [control_interface, packet_string] : received_packets) {
-    packetlib::Packet packet = packetlib::ParsePacket(packet_string);
-    absl::string_view key_string = RemovePadding(packet.payload());
-    absl::StatusOr<Key> key = DeserializeKey(key_string);
+    const auto* flow = flow_lookup.Find(packet_string);
     // Skip invalid packets that might have been picked up by PacketIO.
-    if (!key.ok()) {
+    if (flow == nullptr) {
       continue;
     }
+    const auto& [key, precomputed_packet] = *flow;
 
     absl::string_view expected_egress_interface =
-        pairs[key->pair_index].egress_interface;
+        pairs[precomputed_packet.pair_index].egress_interface;
     ASSIGN_OR_RETURN(std::string actual_egress_interface,
                      gutil::FindOrStatus(sut_interface_from_control_interface,
                                          control_interface));
     if (expected_egress_interface == actual_egress_interface) {
-      valid_received_packets[key_string]++;
+      valid_received_packets[key]++;
     } else {
-      invalid_received_packets[key_string]++;
+      invalid_received_packets[key]++;
     }
   }
 
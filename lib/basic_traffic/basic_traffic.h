@@ -15,7 +15,9 @@
 #ifndef PINS_LIB_BASIC_TRAFFIC_BASIC_TRAFFIC_H_
 #define PINS_LIB_BASIC_TRAFFIC_BASIC_TRAFFIC_H_
 
+#include <cstdint>
 #include <functional>
+#include <optional>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -25,6 +27,7 @@
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "gutil/adaptive_rate_controller.h"
 #include "lib/basic_traffic/basic_p4rt_util.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.pb.h"
@@ -76,8 +79,29 @@ struct SendTrafficOptions {
 
   // Flag to program routes on SUT to forward traffic.
   bool program_routes = true;
+  // If set, routes are programmed with `ProgramRoutesInBatches` instead of one
+  // write request per table entry.
+  bool batch_route_programming = false;
+
+  // If greater than 1, packets are sent concurrently by this many threads, each
+  // sending the packets of its share of the control interfaces at its share of
+  // `packets_per_second`. The control device's `SendPacket` must be
+  // thread-safe. Not supported with `adaptive_rate`.
+  int num_sending_threads = 1;
 
   int* packets_sent = nullptr;
+
+  // If set, `packets_per_second` is only the initial rate. Every
+  // `adaptation_interval`, the rate is adapted to the packets dropped in that
+  // interval, as counted by `read_drop_count`.
+  std::optional<gutil::AdaptiveRateOptions> adaptive_rate;
+  absl::Duration adaptation_interval = absl::Seconds(1);
+  // Returns the total number of packets dropped so far, e.g. the sum of the
+  // SUT's CPU queue drop counters read via gNMI. Required for `adaptive_rate`.
+  std::function<absl::StatusOr<int64_t>()> read_drop_count;
+  // If non-null and `adaptive_rate` is set, receives the highest rate sustained
+  // for an interval without drops, or 0 if there was none.
+  double* sustained_packets_per_second = nullptr;
 };
 
 // Programs the routes to forward traffic through all the interface pairs.
@@ -87,6 +111,15 @@ absl::Status ProgramRoutes(
     const absl::flat_hash_map<std::string, std::string>& port_id_from_interface,
     absl::Span<const InterfacePair> pairs);
 
+// Like `ProgramRoutes`, but writes all table entries with a few large write
+// requests, sequenced so that every entry is written after the entries it
+// refers to, instead of one write request per entry.
+absl::Status ProgramRoutesInBatches(
+    const std::function<absl::Status(p4::v1::WriteRequest&)>& write_request,
+    const pdpi::IrP4Info& ir_p4info,
+    const absl::flat_hash_map<std::string, std::string>& port_id_from_interface,
+    absl::Span<const InterfacePair> pairs);
+
 // Returns a list of interface pairs generated by assigning one source to one
 // destination in order.
 // e.g. sources = (a, b), destinations = (c, d) -> pairs = ((a, c), (b, d)).
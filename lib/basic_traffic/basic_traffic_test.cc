@@ -41,6 +41,7 @@
 #include "gutil/status_matchers.h"
 #include "gutil/testing.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
 #include "p4_pdpi/packetlib/packetlib.h"
 #include "p4_pdpi/packetlib/packetlib.pb.h"
@@ -119,6 +120,38 @@ TEST(BasicTraffic, AllToAll) {
   EXPECT_THAT(AllToAll({}), IsEmpty());
 }
 
+TEST(BasicTraffic, ProgramRoutesInBatchesWritesTheSameUpdatesInFewerRequests) {
+  const pdpi::IrP4Info ir_p4info =
+      sai::GetIrP4Info(sai::Instantiation::kMiddleblock);
+  const absl::flat_hash_map<std::string, std::string> port_id_from_interface =
+      {{"Ethernet0", "0"}, {"Ethernet1", "1"}, {"Ethernet2", "2"}};
+  const std::vector<InterfacePair> pairs =
+      AllToAll({"Ethernet0", "Ethernet1", "Ethernet2"});
+
+  int unbatched_requests = 0;
+  int unbatched_updates = 0;
+  ASSERT_OK(ProgramRoutes(
+      [&](p4::v1::WriteRequest& request) {
+        ++unbatched_requests;
+        unbatched_updates += request.updates_size();
+        return absl::OkStatus();
+      },
+      ir_p4info, port_id_from_interface, pairs));
+
+  int batched_requests = 0;
+  int batched_updates = 0;
+  ASSERT_OK(ProgramRoutesInBatches(
+      [&](p4::v1::WriteRequest& request) {
+        ++batched_requests;
+        batched_updates += request.updates_size();
+        return absl::OkStatus();
+      },
+      ir_p4info, port_id_from_interface, pairs));
+
+  EXPECT_EQ(batched_updates, unbatched_updates);
+  EXPECT_LT(batched_requests, unbatched_requests);
+}
+
 class FakePacketGenerationFinalizer
     : public thinkit::PacketGenerationFinalizer {
  public:
@@ -0,0 +1,438 @@
+// Copyright (c) 2024, Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lib/gnmi/interface_state_cache.h"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT: third_party code.
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "glog/logging.h"
+#include "grpcpp/client_context.h"
+#include "gutil/status.h"
+#include "include/nlohmann/json.hpp"
+#include "lib/gnmi/gnmi_helper.h"
+#include "proto/gnmi/gnmi.grpc.pb.h"
+#include "proto/gnmi/gnmi.pb.h"
+#include "thinkit/switch.h"
+
+namespace pins_test {
+namespace {
+
+constexpr char kInterfaceConfigPortIdPath[] =
+    "interfaces/interface[name=*]/config/openconfig-p4rt:id";
+
+// Returns `name` without its YANG module prefix, e.g. "id" for
+// "openconfig-p4rt:id".
+absl::string_view StripModule(absl::string_view name) {
+  size_t pos = name.rfind(':');
+  return pos == name.npos ? name : name.substr(pos + 1);
+}
+
+bool IsTrackedLeaf(absl::string_view leaf) {
+  return leaf == "oper-status" || leaf == "id";
+}
+
+std::string& TrackedLeaf(InterfaceState& state, absl::string_view leaf) {
+  return leaf == "oper-status" ? state.oper_status : state.port_id;
+}
+
+// The interface addressed by a gNMI path and, for paths of the leaves directly
+// below the interface's `state` or `config` container, the leaf name.
+struct InterfacePath {
+  std::string interface_name;
+  // Empty for paths of the interface itself.
+  std::string leaf;
+};
+
+// Returns the interface addressed by `prefix` + `path`, or nullopt if the path
+// is not that of an interface or of one of its direct leaves.
+absl::StatusOr<std::optional<InterfacePath>> ParseInterfacePath(
+    const gnmi::Path& prefix, const gnmi::Path& path) {
+  std::vector<const gnmi::PathElem*> elems;
+  elems.reserve(prefix.elem_size() + path.elem_size());
+  for (const gnmi::PathElem& elem : prefix.elem()) elems.push_back(&elem);
+  for (const gnmi::PathElem& elem : path.elem()) elems.push_back(&elem);
+
+  if (elems.size() < 2 || StripModule(elems[0]->name()) != "interfaces" ||
+      StripModule(elems[1]->name()) != "interface") {
+    return std::nullopt;
+  }
+  auto name = elems[1]->key().find("name");
+  if (name == elems[1]->key().end()) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Interface path without a name: " << path.ShortDebugString();
+  }
+  if (elems.size() == 2) {
+    return InterfacePath{.interface_name = name->second};
+  }
+  // Leaves of subinterfaces, ethernet, etc. share the names of the tracked
+  // leaves, so only the leaves directly below `state` or `config` count.
+  if (elems.size() != 4) return std::nullopt;
+  return InterfacePath{.interface_name = name->second,
+                       .leaf = std::string(StripModule(elems[3]->name()))};
+}
+
+// Returns the value of a leaf, which may be wrapped in an object keyed by the
+// leaf name, e.g. `{"openconfig-interfaces:oper-status":"UP"}`.
+absl::StatusOr<std::string> ParseJsonLeaf(absl::string_view json_string) {
+  nlohmann::json json = nlohmann::json::parse(json_string, /*cb=*/nullptr,
+                                              /*allow_exceptions=*/false);
+  if (json.is_discarded()) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Invalid JSON leaf: " << json_string;
+  }
+  if (json.is_object() && json.size() == 1) json = json.begin().value();
+  if (json.is_string()) return json.get<std::string>();
+  if (json.is_number_integer()) return json.dump();
+  return gutil::InvalidArgumentErrorBuilder()
+         << "Unsupported JSON leaf: " << json_string;
+}
+
+absl::StatusOr<std::string> ParseLeafValue(const gnmi::TypedValue& value) {
+  switch (value.value_case()) {
+    case gnmi::TypedValue::kStringVal:
+      return value.string_val();
+    case gnmi::TypedValue::kIntVal:
+      return absl::StrCat(value.int_val());
+    case gnmi::TypedValue::kUintVal:
+      return absl::StrCat(value.uint_val());
+    case gnmi::TypedValue::kJsonIetfVal:
+      return ParseJsonLeaf(value.json_ietf_val());
+    case gnmi::TypedValue::kJsonVal:
+      return ParseJsonLeaf(value.json_val());
+    default:
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unsupported leaf value: " << value.ShortDebugString();
+  }
+}
+
+// Gets `paths` with a single Get and returns the interface states it holds.
+absl::StatusOr<InterfaceStateByName> GetInterfaceStates(
+    gnmi::gNMI::StubInterface& stub, gnmi::GetRequest::DataType type,
+    absl::Span<const absl::string_view> paths, absl::Duration timeout) {
+  gnmi::GetRequest request;
+  request.set_type(type);
+  request.mutable_prefix()->set_origin(kOpenconfigStr);
+  for (absl::string_view path : paths) {
+    *request.add_path() = ConvertOCStringToPath(path);
+  }
+  gnmi::GetResponse response;
+  grpc::ClientContext context;
+  context.set_deadline(absl::ToChronoTime(absl::Now() + timeout));
+  RETURN_IF_ERROR(
+      gutil::GrpcStatusToAbslStatus(stub.Get(&context, request, &response)))
+          .SetPrepend()
+      << "GET request failed with error: ";
+
+  InterfaceStateCache cache;
+  for (const gnmi::Notification& notification : response.notification()) {
+    RETURN_IF_ERROR(cache.ApplyNotification(notification));
+  }
+  return cache.Snapshot();
+}
+
+absl::Status WaitForGnmiPortIdConvergenceOnSwitch(
+    GnmiStubPool& stub_pool, thinkit::Switch& chassis, absl::Duration timeout,
+    const InterfaceStateSubscriptionOptions& options) {
+  ASSIGN_OR_RETURN(gnmi::gNMI::StubInterface * stub,
+                   stub_pool.GetOrCreateStub(chassis));
+  return WaitForGnmiPortIdConvergenceOverSubscription(*stub, timeout, options);
+}
+
+}  // namespace
+
+absl::Status InterfaceStateCache::ApplyNotification(
+    const gnmi::Notification& notification) {
+  absl::MutexLock lock(&mu_);
+  for (const gnmi::Path& path : notification.delete_()) {
+    ASSIGN_OR_RETURN(std::optional<InterfacePath> interface,
+                     ParseInterfacePath(notification.prefix(), path));
+    if (!interface.has_value()) continue;
+    if (interface->leaf.empty()) {
+      states_.erase(interface->interface_name);
+      continue;
+    }
+    auto state = states_.find(interface->interface_name);
+    if (state == states_.end() || !IsTrackedLeaf(interface->leaf)) continue;
+    TrackedLeaf(state->second, interface->leaf).clear();
+  }
+  for (const gnmi::Update& update : notification.update()) {
+    ASSIGN_OR_RETURN(std::optional<InterfacePath> interface,
+                     ParseInterfacePath(notification.prefix(), update.path()));
+    if (!interface.has_value() || !IsTrackedLeaf(interface->leaf)) continue;
+    ASSIGN_OR_RETURN(std::string value, ParseLeafValue(update.val()),
+                     _ << "for interface " << interface->interface_name);
+    TrackedLeaf(states_[interface->interface_name], interface->leaf) =
+        std::move(value);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status InterfaceStateCache::ApplySubscribeResponse(
+    const gnmi::SubscribeResponse& response) {
+  switch (response.response_case()) {
+    case gnmi::SubscribeResponse::kUpdate:
+      return ApplyNotification(response.update());
+    case gnmi::SubscribeResponse::kSyncResponse:
+      MarkSynced();
+      return absl::OkStatus();
+    default:
+      return absl::OkStatus();
+  }
+}
+
+void InterfaceStateCache::MarkSynced() {
+  absl::MutexLock lock(&mu_);
+  synced_ = true;
+}
+
+void InterfaceStateCache::MarkFailed(absl::Status status) {
+  absl::MutexLock lock(&mu_);
+  if (status_.ok()) status_ = std::move(status);
+}
+
+InterfaceStateByName InterfaceStateCache::Snapshot() const {
+  absl::MutexLock lock(&mu_);
+  return states_;
+}
+
+absl::Status InterfaceStateCache::WaitUntil(
+    absl::FunctionRef<bool(const InterfaceStateByName&)> condition,
+    absl::Duration timeout) const {
+  absl::MutexLock lock(&mu_);
+  auto done = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return !status_.ok() || (synced_ && condition(states_));
+  };
+  if (!mu_.AwaitWithTimeout(absl::Condition(&done), timeout)) {
+    return gutil::DeadlineExceededErrorBuilder()
+           << "Interface state did not reach the expected condition within "
+           << timeout << (synced_ ? "." : "; the cache never synced.");
+  }
+  return status_;
+}
+
+absl::flat_hash_map<std::string, std::string> OperStatusByName(
+    const InterfaceStateByName& states) {
+  absl::flat_hash_map<std::string, std::string> oper_status_by_name;
+  for (const auto& [name, state] : states) {
+    if (!state.oper_status.empty()) {
+      oper_status_by_name[name] = state.oper_status;
+    }
+  }
+  return oper_status_by_name;
+}
+
+absl::flat_hash_map<std::string, std::string> PortIdByName(
+    const InterfaceStateByName& states) {
+  absl::flat_hash_map<std::string, std::string> port_id_by_name;
+  for (const auto& [name, state] : states) {
+    if (!state.port_id.empty()) port_id_by_name[name] = state.port_id;
+  }
+  return port_id_by_name;
+}
+
+absl::StatusOr<std::unique_ptr<InterfaceStateSubscription>>
+InterfaceStateSubscription::Create(
+    gnmi::gNMI::StubInterface& stub,
+    const InterfaceStateSubscriptionOptions& options) {
+  gnmi::SubscribeRequest request;
+  gnmi::SubscriptionList& subscription_list = *request.mutable_subscribe();
+  subscription_list.set_mode(gnmi::SubscriptionList::STREAM);
+  subscription_list.mutable_prefix()->set_origin(kOpenconfigStr);
+  subscription_list.mutable_prefix()->set_target(kTarget);
+  for (absl::string_view path :
+       {kInterfaceOperStatusPath, kInterfacePortIdPath}) {
+    AddSubtreeToGnmiSubscription(path, subscription_list, options.mode,
+                                 /*suppress_redundant=*/false,
+                                 options.sample_interval);
+  }
+
+  auto subscription = absl::WrapUnique(new InterfaceStateSubscription());
+  subscription->stream_ = stub.Subscribe(&subscription->context_);
+  if (subscription->stream_ == nullptr) {
+    return absl::UnavailableError("Failed to create a gNMI Subscribe stream.");
+  }
+  if (!subscription->stream_->Write(request)) {
+    return gutil::UnavailableErrorBuilder()
+           << "Failed to write subscribe request: "
+           << request.ShortDebugString();
+  }
+  subscription->reader_ =
+      std::thread([subscription = subscription.get()] {
+        subscription->ReadResponses();
+      });
+  return subscription;
+}
+
+InterfaceStateSubscription::~InterfaceStateSubscription() {
+  context_.TryCancel();
+  if (reader_.joinable()) reader_.join();
+}
+
+void InterfaceStateSubscription::ReadResponses() {
+  gnmi::SubscribeResponse response;
+  while (stream_->Read(&response)) {
+    if (absl::Status status = cache_.ApplySubscribeResponse(response);
+        !status.ok()) {
+      LOG(WARNING) << "Cancelling interface state subscription: " << status;
+      cache_.MarkFailed(status);
+      context_.TryCancel();
+    }
+  }
+  absl::Status status = gutil::GrpcStatusToAbslStatus(stream_->Finish());
+  cache_.MarkFailed(status.ok() ? absl::UnavailableError(
+                                      "The gNMI Subscribe stream has ended.")
+                                : status);
+}
+
+absl::StatusOr<InterfaceStateByName> GetInterfaceStatesOverGnmi(
+    gnmi::gNMI::StubInterface& stub, absl::Duration timeout) {
+  return GetInterfaceStates(stub, gnmi::GetRequest::STATE,
+                            {kInterfaceOperStatusPath, kInterfacePortIdPath},
+                            timeout);
+}
+
+absl::Status WaitForPortIdConvergence(
+    const InterfaceStateCache& cache,
+    const absl::flat_hash_map<std::string, std::string>&
+        expected_port_id_by_name,
+    absl::Duration timeout) {
+  absl::Status status = cache.WaitUntil(
+      [&](const InterfaceStateByName& states) {
+        return PortIdByName(states) == expected_port_id_by_name;
+      },
+      timeout);
+  if (absl::IsDeadlineExceeded(status)) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "Port IDs did not converge after " << timeout << ": got=\n  "
+           << absl::StrJoin(PortIdByName(cache.Snapshot()), "\n  ",
+                            absl::PairFormatter(":"))
+           << "\nwant=\n  "
+           << absl::StrJoin(expected_port_id_by_name, "\n  ",
+                            absl::PairFormatter(":"));
+  }
+  return status;
+}
+
+absl::Status WaitForInterfaceOperState(const InterfaceStateCache& cache,
+                                       absl::string_view interface_oper_state,
+                                       absl::Span<const std::string> interfaces,
+                                       absl::Duration timeout) {
+  // Returns the interfaces that are not in `interface_oper_state`.
+  auto unavailable_interfaces = [&](const InterfaceStateByName& states) {
+    std::vector<std::string> unavailable;
+    if (interfaces.empty()) {
+      for (const auto& [name, state] : states) {
+        if (!state.oper_status.empty() &&
+            state.oper_status != interface_oper_state) {
+          unavailable.push_back(name);
+        }
+      }
+      return unavailable;
+    }
+    for (const std::string& interface : interfaces) {
+      auto state = states.find(interface);
+      if (state == states.end() ||
+          state->second.oper_status != interface_oper_state) {
+        unavailable.push_back(interface);
+      }
+    }
+    return unavailable;
+  };
+  absl::Status status = cache.WaitUntil(
+      [&](const InterfaceStateByName& states) {
+        return unavailable_interfaces(states).empty();
+      },
+      timeout);
+  if (absl::IsDeadlineExceeded(status)) {
+    return absl::UnavailableError(absl::StrCat(
+        "Some interfaces are not in the expected state ", interface_oper_state,
+        " after ", absl::FormatDuration(timeout), ":\n",
+        absl::StrJoin(unavailable_interfaces(cache.Snapshot()), "\n")));
+  }
+  return status;
+}
+
+absl::Status WaitForGnmiPortIdConvergenceOverSubscription(
+    gnmi::gNMI::StubInterface& stub, absl::Duration timeout,
+    const InterfaceStateSubscriptionOptions& options) {
+  absl::Time deadline = absl::Now() + timeout;
+  ASSIGN_OR_RETURN(InterfaceStateByName config,
+                   GetInterfaceStates(stub, gnmi::GetRequest::CONFIG,
+                                      {kInterfaceConfigPortIdPath}, timeout));
+  ASSIGN_OR_RETURN(std::unique_ptr<InterfaceStateSubscription> subscription,
+                   InterfaceStateSubscription::Create(stub, options));
+  LOG(INFO) << "Waiting for port name & ID mappings to converge.";
+  return WaitForPortIdConvergence(subscription->cache(), PortIdByName(config),
+                                  deadline - absl::Now());
+}
+
+absl::StatusOr<gnmi::gNMI::StubInterface*> GnmiStubPool::GetOrCreateStub(
+    thinkit::Switch& chassis) {
+  absl::MutexLock lock(&mu_);
+  std::unique_ptr<gnmi::gNMI::StubInterface>& stub =
+      stub_by_chassis_name_[chassis.ChassisName()];
+  if (stub == nullptr) {
+    ASSIGN_OR_RETURN(stub, chassis.CreateGnmiStub());
+  }
+  return stub.get();
+}
+
+absl::Status WaitForGnmiPortIdConvergence(
+    GnmiStubPool& stub_pool, absl::Span<thinkit::Switch* const> switches,
+    absl::Duration timeout, const InterfaceStateSubscriptionOptions& options) {
+  std::vector<absl::Status> statuses(switches.size());
+  std::vector<std::thread> threads;
+  threads.reserve(switches.size());
+  for (size_t i = 0; i < switches.size(); ++i) {
+    threads.emplace_back([&, i] {
+      statuses[i] = WaitForGnmiPortIdConvergenceOnSwitch(
+          stub_pool, *switches[i], timeout, options);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  std::vector<std::string> errors;
+  for (size_t i = 0; i < switches.size(); ++i) {
+    if (!statuses[i].ok()) {
+      errors.push_back(absl::StrCat(switches[i]->ChassisName(), ": ",
+                                    statuses[i].ToString()));
+    }
+  }
+  if (errors.empty()) return absl::OkStatus();
+  return gutil::FailedPreconditionErrorBuilder()
+         << "Port IDs did not converge on " << errors.size() << " of "
+         << switches.size() << " switches:\n"
+         << absl::StrJoin(errors, "\n");
+}
+
+}  // namespace pins_test
@@ -0,0 +1,214 @@
+// Copyright (c) 2024, Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_LIB_GNMI_INTERFACE_STATE_CACHE_H_
+#define PINS_LIB_GNMI_INTERFACE_STATE_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT: third_party code.
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "grpcpp/client_context.h"
+#include "grpcpp/support/sync_stream.h"
+#include "proto/gnmi/gnmi.grpc.pb.h"
+#include "proto/gnmi/gnmi.pb.h"
+#include "thinkit/switch.h"
+
+namespace pins_test {
+
+// The subset of an interface's gNMI state tracked by `InterfaceStateCache`.
+// Leaves the switch has not reported (yet) are empty.
+struct InterfaceState {
+  std::string oper_status;
+  // The P4RT port ID, i.e. `openconfig-p4rt:id`.
+  std::string port_id;
+
+  bool operator==(const InterfaceState& other) const {
+    return oper_status == other.oper_status && port_id == other.port_id;
+  }
+};
+
+using InterfaceStateByName = absl::flat_hash_map<std::string, InterfaceState>;
+
+// Path-scoped gNMI paths of the leaves tracked by `InterfaceStateCache`. Unlike
+// the `interfaces` subtree, a Get or Subscribe of these paths only returns one
+// small update per interface and leaf.
+inline constexpr char kInterfaceOperStatusPath[] =
+    "interfaces/interface[name=*]/state/oper-status";
+inline constexpr char kInterfacePortIdPath[] =
+    "interfaces/interface[name=*]/state/openconfig-p4rt:id";
+
+// Interface state that is updated incrementally from gNMI notifications, e.g.
+// the responses of a subscription to the paths above. Each update only touches
+// the leaf it carries, so the cost of keeping the cache current is proportional
+// to what changed on the switch rather than to the size of the interface tree.
+//
+// Thread-safe.
+class InterfaceStateCache {
+ public:
+  // Applies the updates and deletes of `notification`. Updates of leaves that
+  // are not tracked are ignored. Leaves are matched regardless of their
+  // container, so notifications of the `config` paths populate the cache just
+  // like those of the `state` paths.
+  absl::Status ApplyNotification(const gnmi::Notification& notification)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Applies a response of a Subscribe stream. A sync response marks the cache
+  // as synced, i.e. as reflecting the full state of the switch.
+  absl::Status ApplySubscribeResponse(const gnmi::SubscribeResponse& response)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Marks the cache as synced without waiting for a sync response, e.g. when
+  // it was populated from a Get.
+  void MarkSynced() ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Marks the source of updates as failed. Pending and future `WaitUntil`
+  // calls return `status`.
+  void MarkFailed(absl::Status status) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Returns a copy of the cached interface states.
+  InterfaceStateByName Snapshot() const ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Blocks until the cache is synced and `condition` holds for its states.
+  // Returns DeadlineExceeded if that does not happen within `timeout`, and the
+  // failure of the update source if it fails first. `condition` is evaluated
+  // under the cache's lock, once per applied notification, and must not call
+  // back into the cache.
+  absl::Status WaitUntil(
+      absl::FunctionRef<bool(const InterfaceStateByName&)> condition,
+      absl::Duration timeout) const ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  mutable absl::Mutex mu_;
+  InterfaceStateByName states_ ABSL_GUARDED_BY(mu_);
+  bool synced_ ABSL_GUARDED_BY(mu_) = false;
+  absl::Status status_ ABSL_GUARDED_BY(mu_);
+};
+
+// Returns the oper status by interface name of `states`, skipping interfaces
+// whose oper status is unknown.
+absl::flat_hash_map<std::string, std::string> OperStatusByName(
+    const InterfaceStateByName& states);
+
+// Returns the P4RT port ID by interface name of `states`, skipping interfaces
+// without a port ID.
+absl::flat_hash_map<std::string, std::string> PortIdByName(
+    const InterfaceStateByName& states);
+
+struct InterfaceStateSubscriptionOptions {
+  // ON_CHANGE only streams updates of changed leaves. Switches that do not
+  // support it for the tracked leaves can use SAMPLE instead.
+  gnmi::SubscriptionMode mode = gnmi::ON_CHANGE;
+  // The sample interval of SAMPLE subscriptions.
+  absl::Duration sample_interval = absl::Seconds(1);
+};
+
+// A gNMI STREAM subscription to the oper status and P4RT port ID of all
+// interfaces that keeps an `InterfaceStateCache` up to date on a background
+// thread. Waiting for interface state through the cache replaces polling the
+// full `interfaces` subtree.
+class InterfaceStateSubscription {
+ public:
+  // Subscribes through `stub`, which must outlive the subscription.
+  static absl::StatusOr<std::unique_ptr<InterfaceStateSubscription>> Create(
+      gnmi::gNMI::StubInterface& stub,
+      const InterfaceStateSubscriptionOptions& options = {});
+
+  // Cancels the subscription and joins the background thread.
+  ~InterfaceStateSubscription();
+
+  InterfaceStateSubscription(const InterfaceStateSubscription&) = delete;
+  InterfaceStateSubscription& operator=(const InterfaceStateSubscription&) =
+      delete;
+
+  const InterfaceStateCache& cache() const { return cache_; }
+
+ private:
+  InterfaceStateSubscription() = default;
+
+  // Applies responses to the cache until the stream ends.
+  void ReadResponses();
+
+  grpc::ClientContext context_;
+  std::unique_ptr<grpc::ClientReaderWriterInterface<gnmi::SubscribeRequest,
+                                                    gnmi::SubscribeResponse>>
+      stream_;
+  InterfaceStateCache cache_;
+  std::thread reader_;
+};
+
+// Returns the oper status and P4RT port ID of all interfaces using a
+// path-scoped Get of the tracked leaves instead of the `interfaces` subtree.
+absl::StatusOr<InterfaceStateByName> GetInterfaceStatesOverGnmi(
+    gnmi::gNMI::StubInterface& stub,
+    absl::Duration timeout = absl::Seconds(60));
+
+// Waits until the P4RT port IDs in `cache` match `expected_port_id_by_name`.
+absl::Status WaitForPortIdConvergence(
+    const InterfaceStateCache& cache,
+    const absl::flat_hash_map<std::string, std::string>&
+        expected_port_id_by_name,
+    absl::Duration timeout);
+
+// Waits until all `interfaces` in `cache` have the oper status
+// `interface_oper_state`. Passing in nothing for `interfaces` waits for all
+// interfaces.
+absl::Status WaitForInterfaceOperState(const InterfaceStateCache& cache,
+                                       absl::string_view interface_oper_state,
+                                       absl::Span<const std::string> interfaces,
+                                       absl::Duration timeout);
+
+// Like `WaitForGnmiPortIdConvergence`, but subscribes to the port IDs instead
+// of repeatedly getting and parsing the `interfaces` subtree, and reads the
+// expected port IDs with a path-scoped Get of the config.
+absl::Status WaitForGnmiPortIdConvergenceOverSubscription(
+    gnmi::gNMI::StubInterface& stub, absl::Duration timeout,
+    const InterfaceStateSubscriptionOptions& options = {});
+
+// Shares one gNMI stub, and thereby one channel, per switch between all
+// helpers that talk to it, so that concurrent helpers neither open a channel
+// each nor repeat the connection setup.
+//
+// Thread-safe. The stubs live as long as the pool.
+class GnmiStubPool {
+ public:
+  // Returns the stub of `chassis`, creating it on first use.
+  absl::StatusOr<gnmi::gNMI::StubInterface*> GetOrCreateStub(
+      thinkit::Switch& chassis) ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  absl::Mutex mu_;
+  absl::flat_hash_map<std::string, std::unique_ptr<gnmi::gNMI::StubInterface>>
+      stub_by_chassis_name_ ABSL_GUARDED_BY(mu_);
+};
+
+// Runs `WaitForGnmiPortIdConvergenceOverSubscription` on all `switches`
+// concurrently, using the stubs of `stub_pool`. Returns the errors of all
+// switches that did not converge.
+absl::Status WaitForGnmiPortIdConvergence(
+    GnmiStubPool& stub_pool, absl::Span<thinkit::Switch* const> switches,
+    absl::Duration timeout,
+    const InterfaceStateSubscriptionOptions& options = {});
+
+}  // namespace pins_test
+
+#endif  // PINS_LIB_GNMI_INTERFACE_STATE_CACHE_H_
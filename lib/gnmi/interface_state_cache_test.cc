@@ -0,0 +1,351 @@
+// Copyright (c) 2024, Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lib/gnmi/interface_state_cache.h"
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "grpcpp/support/status.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "proto/gnmi/gnmi.pb.h"
+#include "proto/gnmi/gnmi_mock.grpc.pb.h"
+
+namespace pins_test {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::AllOf;
+using ::testing::DoAll;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+using ::testing::Return;
+using ::testing::SaveArg;
+using ::testing::SetArgPointee;
+using ::testing::UnorderedElementsAre;
+
+TEST(InterfaceStateCacheTest, AppliesPathScopedUpdates) {
+  InterfaceStateCache cache;
+  ASSERT_OK(cache.ApplyNotification(
+      gutil::ParseProtoOrDie<gnmi::Notification>(R"pb(
+        prefix { origin: "openconfig" }
+        update {
+          path {
+            elem { name: "interfaces" }
+            elem {
+              name: "interface"
+              key { key: "name" value: "Ethernet0" }
+            }
+            elem { name: "state" }
+            elem { name: "oper-status" }
+          }
+          val {
+            json_ietf_val: "{\"openconfig-interfaces:oper-status\":\"UP\"}"
+          }
+        }
+        update {
+          path {
+            elem { name: "interfaces" }
+            elem {
+              name: "interface"
+              key { key: "name" value: "Ethernet0" }
+            }
+            elem { name: "state" }
+            elem { name: "openconfig-p4rt:id" }
+          }
+          val { json_ietf_val: "1" }
+        }
+        update {
+          path {
+            elem { name: "interfaces" }
+            elem {
+              name: "interface"
+              key { key: "name" value: "Ethernet8" }
+            }
+            elem { name: "state" }
+            elem { name: "openconfig-p4rt:id" }
+          }
+          val { uint_val: 2 }
+        }
+      )pb")));
+
+  EXPECT_THAT(OperStatusByName(cache.Snapshot()),
+              UnorderedElementsAre(Pair("Ethernet0", "UP")));
+  EXPECT_THAT(PortIdByName(cache.Snapshot()),
+              UnorderedElementsAre(Pair("Ethernet0", "1"),
+                                   Pair("Ethernet8", "2")));
+}
+
+TEST(InterfaceStateCacheTest, AppliesPrefixedUpdatesAndDeletes) {
+  InterfaceStateCache cache;
+  ASSERT_OK(cache.ApplyNotification(
+      gutil::ParseProtoOrDie<gnmi::Notification>(R"pb(
+        prefix {
+          elem { name: "interfaces" }
+          elem {
+            name: "interface"
+            key { key: "name" value: "Ethernet0" }
+          }
+        }
+        update {
+          path {
+            elem { name: "state" }
+            elem { name: "oper-status" }
+          }
+          val { string_val: "DOWN" }
+        }
+        update {
+          path {
+            elem { name: "state" }
+            elem { name: "id" }
+          }
+          val { uint_val: 1 }
+        }
+      )pb")));
+  ASSERT_OK(cache.ApplyNotification(
+      gutil::ParseProtoOrDie<gnmi::Notification>(R"pb(
+        prefix {
+          elem { name: "interfaces" }
+          elem {
+            name: "interface"
+            key { key: "name" value: "Ethernet0" }
+          }
+        }
+        delete {
+          elem { name: "state" }
+          elem { name: "id" }
+        }
+      )pb")));
+  EXPECT_THAT(OperStatusByName(cache.Snapshot()),
+              UnorderedElementsAre(Pair("Ethernet0", "DOWN")));
+  EXPECT_THAT(PortIdByName(cache.Snapshot()), IsEmpty());
+
+  ASSERT_OK(cache.ApplyNotification(
+      gutil::ParseProtoOrDie<gnmi::Notification>(R"pb(
+        delete {
+          elem { name: "interfaces" }
+          elem {
+            name: "interface"
+            key { key: "name" value: "Ethernet0" }
+          }
+        }
+      )pb")));
+  EXPECT_THAT(cache.Snapshot(), IsEmpty());
+}
+
+TEST(InterfaceStateCacheTest, IgnoresLeavesOutsideOfTheInterfaceState) {
+  InterfaceStateCache cache;
+  ASSERT_OK(cache.ApplyNotification(
+      gutil::ParseProtoOrDie<gnmi::Notification>(R"pb(
+        update {
+          path {
+            elem { name: "interfaces" }
+            elem {
+              name: "interface"
+              key { key: "name" value: "Ethernet0" }
+            }
+            elem { name: "subinterfaces" }
+            elem {
+              name: "subinterface"
+              key { key: "index" value: "0" }
+            }
+            elem { name: "state" }
+            elem { name: "oper-status" }
+          }
+          val { string_val: "UP" }
+        }
+        update {
+          path {
+            elem { name: "interfaces" }
+            elem {
+              name: "interface"
+              key { key: "name" value: "Ethernet0" }
+            }
+            elem { name: "state" }
+            elem { name: "mtu" }
+          }
+          val { uint_val: 9100 }
+        }
+        update {
+          path {
+            elem { name: "components" }
+            elem {
+              name: "component"
+              key { key: "name" value: "1/1" }
+            }
+            elem { name: "state" }
+            elem { name: "oper-status" }
+          }
+          val { string_val: "ACTIVE" }
+        }
+      )pb")));
+  EXPECT_THAT(cache.Snapshot(), IsEmpty());
+}
+
+TEST(InterfaceStateCacheTest, RejectsInterfacesWithoutName) {
+  InterfaceStateCache cache;
+  EXPECT_THAT(cache.ApplyNotification(
+                  gutil::ParseProtoOrDie<gnmi::Notification>(R"pb(
+                    update {
+                      path {
+                        elem { name: "interfaces" }
+                        elem { name: "interface" }
+                        elem { name: "state" }
+                        elem { name: "oper-status" }
+                      }
+                      val { string_val: "UP" }
+                    }
+                  )pb")),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(InterfaceStateCacheTest, WaitUntilRequiresSyncResponse) {
+  InterfaceStateCache cache;
+  auto always = [](const InterfaceStateByName&) { return true; };
+  EXPECT_THAT(cache.WaitUntil(always, absl::Milliseconds(10)),
+              StatusIs(absl::StatusCode::kDeadlineExceeded,
+                       HasSubstr("never synced")));
+
+  ASSERT_OK(cache.ApplySubscribeResponse(
+      gutil::ParseProtoOrDie<gnmi::SubscribeResponse>("sync_response: true")));
+  EXPECT_OK(cache.WaitUntil(always, absl::Milliseconds(10)));
+}
+
+TEST(InterfaceStateCacheTest, WaitUntilReturnsFailureOfUpdateSource) {
+  InterfaceStateCache cache;
+  cache.MarkFailed(absl::UnavailableError("stream ended"));
+  EXPECT_THAT(
+      cache.WaitUntil([](const InterfaceStateByName&) { return false; },
+                      absl::Seconds(60)),
+      StatusIs(absl::StatusCode::kUnavailable, HasSubstr("stream ended")));
+}
+
+TEST(WaitForPortIdConvergenceTest, ReportsMismatchedPortIds) {
+  InterfaceStateCache cache;
+  ASSERT_OK(cache.ApplyNotification(
+      gutil::ParseProtoOrDie<gnmi::Notification>(R"pb(
+        update {
+          path {
+            elem { name: "interfaces" }
+            elem {
+              name: "interface"
+              key { key: "name" value: "Ethernet0" }
+            }
+            elem { name: "state" }
+            elem { name: "openconfig-p4rt:id" }
+          }
+          val { uint_val: 1 }
+        }
+      )pb")));
+  cache.MarkSynced();
+
+  EXPECT_OK(WaitForPortIdConvergence(cache, {{"Ethernet0", "1"}},
+                                     absl::Milliseconds(10)));
+  EXPECT_THAT(WaitForPortIdConvergence(cache, {{"Ethernet0", "2"}},
+                                       absl::Milliseconds(10)),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       AllOf(HasSubstr("Ethernet0:1"),
+                             HasSubstr("want=\n  Ethernet0:2"))));
+}
+
+TEST(WaitForInterfaceOperStateTest, WaitsForGivenInterfaces) {
+  InterfaceStateCache cache;
+  ASSERT_OK(cache.ApplyNotification(
+      gutil::ParseProtoOrDie<gnmi::Notification>(R"pb(
+        update {
+          path {
+            elem { name: "interfaces" }
+            elem {
+              name: "interface"
+              key { key: "name" value: "Ethernet0" }
+            }
+            elem { name: "state" }
+            elem { name: "oper-status" }
+          }
+          val { string_val: "UP" }
+        }
+        update {
+          path {
+            elem { name: "interfaces" }
+            elem {
+              name: "interface"
+              key { key: "name" value: "Ethernet8" }
+            }
+            elem { name: "state" }
+            elem { name: "oper-status" }
+          }
+          val { string_val: "DOWN" }
+        }
+      )pb")));
+  cache.MarkSynced();
+
+  EXPECT_OK(WaitForInterfaceOperState(cache, "UP", {"Ethernet0"},
+                                      absl::Milliseconds(10)));
+  EXPECT_THAT(
+      WaitForInterfaceOperState(cache, "UP", /*interfaces=*/{},
+                                absl::Milliseconds(10)),
+      StatusIs(absl::StatusCode::kUnavailable, HasSubstr("Ethernet8")));
+  EXPECT_THAT(
+      WaitForInterfaceOperState(cache, "UP", {"Ethernet16"},
+                                absl::Milliseconds(10)),
+      StatusIs(absl::StatusCode::kUnavailable, HasSubstr("Ethernet16")));
+}
+
+TEST(GetInterfaceStatesOverGnmiTest, GetsTrackedLeavesOnly) {
+  gnmi::MockgNMIStub stub;
+  gnmi::GetRequest request;
+  EXPECT_CALL(stub, Get)
+      .WillOnce(DoAll(
+          SaveArg<1>(&request),
+          SetArgPointee<2>(gutil::ParseProtoOrDie<gnmi::GetResponse>(R"pb(
+            notification {
+              update {
+                path {
+                  elem { name: "interfaces" }
+                  elem {
+                    name: "interface"
+                    key { key: "name" value: "Ethernet0" }
+                  }
+                  elem { name: "state" }
+                  elem { name: "oper-status" }
+                }
+                val { json_ietf_val: "\"UP\"" }
+              }
+            }
+          )pb")),
+          Return(grpc::Status::OK)));
+
+  ASSERT_OK_AND_ASSIGN(InterfaceStateByName states,
+                       GetInterfaceStatesOverGnmi(stub));
+  EXPECT_THAT(states,
+              UnorderedElementsAre(Pair(
+                  "Ethernet0", InterfaceState{.oper_status = "UP"})));
+  EXPECT_EQ(request.path_size(), 2);
+}
+
+TEST(GetInterfaceStatesOverGnmiTest, GnmiGetRpcFails) {
+  gnmi::MockgNMIStub stub;
+  EXPECT_CALL(stub, Get).WillOnce(
+      Return(grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED, "")));
+  EXPECT_THAT(GetInterfaceStatesOverGnmi(stub),
+              StatusIs(absl::StatusCode::kDeadlineExceeded));
+}
+
+}  // namespace
+}  // namespace pins_test
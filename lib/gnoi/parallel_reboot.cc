@@ -0,0 +1,284 @@
+// Copyright (c) 2024, Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lib/gnoi/parallel_reboot.h"
+
+#include <functional>
+#include <string>
+#include <thread>  // NOLINT: third_party code.
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "glog/logging.h"
+#include "grpcpp/client_context.h"
+#include "gutil/status.h"
+#include "lib/validator/validator_lib.h"
+#include "system/system.grpc.pb.h"
+#include "system/system.pb.h"
+#include "thinkit/ssh_client.h"
+#include "thinkit/switch.h"
+
+namespace pins_test {
+namespace {
+
+// How long a single ping may take while waiting for a switch to go down.
+constexpr absl::Duration kPingTimeout = absl::Seconds(5);
+
+absl::Status SendGnoiReboot(thinkit::Switch& thinkit_switch,
+                            gnoi::system::RebootMethod method) {
+  ASSIGN_OR_RETURN(auto gnoi_system_stub,
+                   thinkit_switch.CreateGnoiSystemStub());
+  gnoi::system::RebootRequest request;
+  request.set_method(method);
+  request.set_message("Parallel reboot");
+  gnoi::system::RebootResponse response;
+  grpc::ClientContext context;
+  LOG(INFO) << "Sending gNOI reboot request to "
+            << thinkit_switch.ChassisName() << ": "
+            << request.ShortDebugString();
+  return gutil::GrpcStatusToAbslStatus(
+      gnoi_system_stub->Reboot(&context, request, &response));
+}
+
+// Hands out the right to make a switch unavailable, to at most
+// `max_unavailable` switches at a time. A switch that fails to come back keeps
+// its slot.
+class UnavailabilitySlots {
+ public:
+  explicit UnavailabilitySlots(int max_unavailable)
+      : max_unavailable_(max_unavailable) {}
+
+  // Blocks until a slot is free. Returns false if no slot will ever be free
+  // again because too many switches failed.
+  bool Acquire() ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    mu_.Await(absl::Condition(this, &UnavailabilitySlots::CanDecide));
+    if (failed_ >= max_unavailable_) return false;
+    ++rebooting_;
+    return true;
+  }
+
+  // Releases the slot of a switch that is ready again.
+  void Release() ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    --rebooting_;
+  }
+
+  // Keeps the slot of a switch that failed to come back.
+  void Fail() ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock l(&mu_);
+    --rebooting_;
+    ++failed_;
+  }
+
+ private:
+  bool CanDecide() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return rebooting_ + failed_ < max_unavailable_ ||
+           failed_ >= max_unavailable_;
+  }
+
+  const int max_unavailable_;
+  absl::Mutex mu_;
+  int rebooting_ ABSL_GUARDED_BY(mu_) = 0;
+  int failed_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+// Reboots `target` and waits for it to pass all phases, recording them in
+// `progress`.
+absl::Status RebootAndWaitForReady(const RebootTarget& target,
+                                   const ParallelRebootOptions& options,
+                                   RebootProgress& progress) {
+  thinkit::Switch& thinkit_switch = *target.thinkit_switch;
+  const RebootPhaseChecks& checks = options.checks;
+  WaitForConditionOptions wait_options = options.wait_options;
+  if (target.wakeup != nullptr) wait_options.wakeup = target.wakeup;
+  auto reached = [&](RebootPhase phase) {
+    progress.phases.push_back({phase, absl::Now()});
+    LOG(INFO) << progress.chassis_name << " reached "
+              << RebootPhaseToString(phase) << " after "
+              << progress.RebootDuration();
+    if (options.on_phase) options.on_phase(progress.chassis_name, phase);
+  };
+  // Waits for `check` to pass, then records `phase`.
+  auto wait_for = [&](RebootPhase phase, absl::Time deadline,
+                      const std::function<absl::Status()>& check)
+      -> absl::Status {
+    RETURN_IF_ERROR(WaitForCondition(wait_options, check,
+                                     deadline - absl::Now()))
+        << progress.chassis_name << " did not reach "
+        << RebootPhaseToString(phase);
+    reached(phase);
+    return absl::OkStatus();
+  };
+
+  RETURN_IF_ERROR(checks.reboot(thinkit_switch, options.method))
+      << "Failed to reboot " << progress.chassis_name;
+  reached(RebootPhase::kRebootRequested);
+
+  RETURN_IF_ERROR(wait_for(RebootPhase::kDown,
+                           absl::Now() + options.down_timeout,
+                           [&] { return checks.down(thinkit_switch); }));
+
+  const absl::Time deadline = absl::Now() + options.ready_timeout;
+  if (target.ssh_client != nullptr) {
+    RETURN_IF_ERROR(wait_for(RebootPhase::kSshable, deadline, [&] {
+      return checks.sshable(thinkit_switch, *target.ssh_client);
+    }));
+  }
+  RETURN_IF_ERROR(wait_for(RebootPhase::kGnmiable, deadline,
+                           [&] { return checks.gnmiable(thinkit_switch); }));
+  RETURN_IF_ERROR(wait_for(RebootPhase::kP4rtable, deadline,
+                           [&] { return checks.p4rtable(thinkit_switch); }));
+  if (options.check_ports) {
+    RETURN_IF_ERROR(wait_for(RebootPhase::kPortsUp, deadline, [&] {
+      return checks.ports_up(thinkit_switch, target.interfaces);
+    }));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+std::string RebootPhaseToString(RebootPhase phase) {
+  switch (phase) {
+    case RebootPhase::kQueued:
+      return "queued";
+    case RebootPhase::kRebootRequested:
+      return "reboot requested";
+    case RebootPhase::kDown:
+      return "down";
+    case RebootPhase::kSshable:
+      return "SSH-able";
+    case RebootPhase::kGnmiable:
+      return "gNMI-able";
+    case RebootPhase::kP4rtable:
+      return "P4RT-able";
+    case RebootPhase::kPortsUp:
+      return "ports up";
+  }
+  return "unknown";
+}
+
+RebootPhaseChecks RebootPhaseChecks::Default() {
+  return {
+      .reboot = SendGnoiReboot,
+      .down =
+          [](thinkit::Switch& thinkit_switch) {
+            if (Pingable(thinkit_switch, kPingTimeout).ok()) {
+              return absl::UnavailableError(
+                  "The switch still responds to pings.");
+            }
+            return absl::OkStatus();
+          },
+      .sshable =
+          [](thinkit::Switch& thinkit_switch, thinkit::SSHClient& ssh_client) {
+            return SSHable(thinkit_switch, ssh_client);
+          },
+      .gnmiable =
+          [](thinkit::Switch& thinkit_switch) {
+            return GnmiAble(thinkit_switch);
+          },
+      .p4rtable =
+          [](thinkit::Switch& thinkit_switch) {
+            return P4rtAble(thinkit_switch);
+          },
+      .ports_up =
+          [](thinkit::Switch& thinkit_switch,
+             absl::Span<const std::string> interfaces) {
+            return PortsUp(thinkit_switch, interfaces);
+          },
+  };
+}
+
+absl::Duration RebootProgress::RebootDuration() const {
+  if (phases.empty()) return absl::ZeroDuration();
+  return phases.back().second - phases.front().second;
+}
+
+absl::StatusOr<std::vector<RebootProgress>> RebootInParallel(
+    absl::Span<const RebootTarget> targets,
+    const ParallelRebootOptions& options) {
+  if (options.max_unavailable <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "max_unavailable must be positive, but is "
+           << options.max_unavailable;
+  }
+  const RebootPhaseChecks& checks = options.checks;
+  if (!checks.reboot || !checks.down || !checks.sshable || !checks.gnmiable ||
+      !checks.p4rtable || !checks.ports_up) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Every reboot phase check must be set.";
+  }
+  std::vector<RebootProgress> progress(targets.size());
+  for (int i = 0; i < targets.size(); ++i) {
+    if (targets[i].thinkit_switch == nullptr) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Reboot target " << i << " has no switch.";
+    }
+    progress[i].chassis_name = targets[i].thinkit_switch->ChassisName();
+  }
+
+  UnavailabilitySlots slots(options.max_unavailable);
+  std::vector<std::thread> threads;
+  threads.reserve(targets.size());
+  for (int i = 0; i < targets.size(); ++i) {
+    threads.emplace_back([&, i] {
+      RebootProgress& device_progress = progress[i];
+      if (!slots.Acquire()) {
+        device_progress.status = gutil::AbortedErrorBuilder()
+                                 << "Not rebooted because "
+                                 << options.max_unavailable
+                                 << " switches failed to come back.";
+        return;
+      }
+      device_progress.status =
+          RebootAndWaitForReady(targets[i], options, device_progress);
+      if (device_progress.status.ok()) {
+        slots.Release();
+      } else {
+        LOG(WARNING) << device_progress.status;
+        slots.Fail();
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  return progress;
+}
+
+absl::Status AllRebootsSucceeded(absl::Span<const RebootProgress> progress) {
+  std::vector<std::string> failures;
+  for (const RebootProgress& device_progress : progress) {
+    if (!device_progress.status.ok()) {
+      failures.push_back(absl::StrCat(
+          device_progress.chassis_name, " (last phase: ",
+          RebootPhaseToString(device_progress.LastPhase()),
+          "): ", device_progress.status.message()));
+    }
+  }
+  if (failures.empty()) return absl::OkStatus();
+  return gutil::UnavailableErrorBuilder()
+         << failures.size() << " of " << progress.size()
+         << " switches are not ready:\n"
+         << absl::StrJoin(failures, "\n");
+}
+
+}  // namespace pins_test
@@ -0,0 +1,142 @@
+// Copyright (c) 2024, Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Reboots many switches over gNOI concurrently, with at most a given number of
+// them unavailable at any time, and waits for each of them to be ready again.
+//
+// Every switch goes through the phases of `RebootPhase` in order. A switch
+// moves on to the next phase as soon as the check of its current phase passes,
+// so a group of switches is ready after about as long as its slowest switch
+// takes, rather than the sum of all of them.
+
+#ifndef PINS_LIB_GNOI_PARALLEL_REBOOT_H_
+#define PINS_LIB_GNOI_PARALLEL_REBOOT_H_
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "lib/validator/validator_lib.h"
+#include "system/system.pb.h"
+#include "thinkit/ssh_client.h"
+#include "thinkit/switch.h"
+
+namespace pins_test {
+
+// The phases of a reboot, in the order a switch goes through them.
+enum class RebootPhase {
+  // Waiting for fewer than `max_unavailable` switches to be unavailable.
+  kQueued,
+  // The gNOI reboot request was accepted.
+  kRebootRequested,
+  // The switch stopped responding to pings.
+  kDown,
+  // The switch accepts SSH connections. Skipped without an SSH client.
+  kSshable,
+  kGnmiable,
+  kP4rtable,
+  // All interfaces of the target are up. Skipped if `check_ports` is false.
+  kPortsUp,
+};
+
+std::string RebootPhaseToString(RebootPhase phase);
+
+// A switch to reboot.
+struct RebootTarget {
+  thinkit::Switch* thinkit_switch = nullptr;
+  // If null, the SSH phase is skipped.
+  thinkit::SSHClient* ssh_client = nullptr;
+  // The interfaces that need to be up. If empty, all interfaces do.
+  std::vector<std::string> interfaces;
+  // If set, notifying it (e.g. on a gNMI or syslog event from the switch)
+  // makes the current phase check run right away instead of after its delay.
+  ConditionWakeup* wakeup = nullptr;
+};
+
+// The checks that move a switch from one phase to the next. Each returns OK
+// once the switch has reached the phase. They default to the validators of
+// validator_lib, and are replaceable for tests.
+struct RebootPhaseChecks {
+  std::function<absl::Status(thinkit::Switch&, gnoi::system::RebootMethod)>
+      reboot;
+  std::function<absl::Status(thinkit::Switch&)> down;
+  std::function<absl::Status(thinkit::Switch&, thinkit::SSHClient&)> sshable;
+  std::function<absl::Status(thinkit::Switch&)> gnmiable;
+  std::function<absl::Status(thinkit::Switch&)> p4rtable;
+  std::function<absl::Status(thinkit::Switch&, absl::Span<const std::string>)>
+      ports_up;
+
+  static RebootPhaseChecks Default();
+};
+
+struct ParallelRebootOptions {
+  // The maximum number of switches that are rebooting, or failed to come back,
+  // at any time. Must be positive.
+  int max_unavailable = 1;
+  gnoi::system::RebootMethod method = gnoi::system::RebootMethod::COLD;
+  // How long a switch may take to go down after the reboot request, and then
+  // to pass all remaining phases.
+  absl::Duration down_timeout = absl::Minutes(5);
+  absl::Duration ready_timeout = absl::Minutes(15);
+  bool check_ports = true;
+  // The delays between the tries of a phase check.
+  WaitForConditionOptions wait_options = {
+      .initial_backoff = absl::Milliseconds(500),
+      .max_backoff = absl::Seconds(5),
+  };
+  // Called whenever a switch reaches a phase, from the thread rebooting it.
+  std::function<void(const std::string& chassis_name, RebootPhase phase)>
+      on_phase;
+  RebootPhaseChecks checks = RebootPhaseChecks::Default();
+};
+
+// The outcome of rebooting one switch.
+struct RebootProgress {
+  std::string chassis_name;
+  // The phases reached, with the time they were reached.
+  std::vector<std::pair<RebootPhase, absl::Time>> phases;
+  // OK if the switch is ready, otherwise why the last phase was not passed.
+  absl::Status status;
+
+  RebootPhase LastPhase() const {
+    return phases.empty() ? RebootPhase::kQueued : phases.back().first;
+  }
+  // The time from the reboot request until the last phase reached, i.e. until
+  // the switch was ready if `status` is OK.
+  absl::Duration RebootDuration() const;
+};
+
+// Reboots all `targets` following `options` and returns their progress, in the
+// order of `targets`. Only fails if the options or targets are invalid; the
+// outcome of each reboot is in its `RebootProgress::status`.
+//
+// A switch that fails to come back stays unavailable, so once
+// `max_unavailable` switches have failed, the remaining ones are not rebooted
+// and their status is Aborted.
+absl::StatusOr<std::vector<RebootProgress>> RebootInParallel(
+    absl::Span<const RebootTarget> targets,
+    const ParallelRebootOptions& options = {});
+
+// Returns OK if all switches are ready, or an error listing the ones that are
+// not.
+absl::Status AllRebootsSucceeded(absl::Span<const RebootProgress> progress);
+
+}  // namespace pins_test
+
+#endif  // PINS_LIB_GNOI_PARALLEL_REBOOT_H_
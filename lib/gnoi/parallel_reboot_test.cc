@@ -0,0 +1,208 @@
+// Copyright (c) 2024, Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lib/gnoi/parallel_reboot.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "thinkit/mock_ssh_client.h"
+#include "thinkit/mock_switch.h"
+
+namespace pins_test {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::NiceMock;
+using ::testing::ReturnRef;
+
+// Fake switches that go down as soon as they are rebooted, and pass every
+// readiness check the next time it is tried. Tracks how many are unavailable.
+class FakeFleet {
+ public:
+  explicit FakeFleet(int size) {
+    for (int i = 0; i < size; ++i) {
+      names_.push_back(std::make_unique<std::string>(absl::StrCat("sw", i)));
+      switches_.push_back(std::make_unique<NiceMock<thinkit::MockSwitch>>());
+      ON_CALL(*switches_.back(), ChassisName)
+          .WillByDefault(ReturnRef(*names_.back()));
+    }
+  }
+
+  std::vector<RebootTarget> Targets() {
+    std::vector<RebootTarget> targets;
+    for (auto& thinkit_switch : switches_) {
+      targets.push_back({.thinkit_switch = thinkit_switch.get()});
+    }
+    return targets;
+  }
+
+  ParallelRebootOptions Options(int max_unavailable) {
+    return {
+        .max_unavailable = max_unavailable,
+        .wait_options = {.initial_backoff = absl::Milliseconds(1)},
+        .checks = {
+            .reboot =
+                [this](thinkit::Switch& thinkit_switch,
+                       gnoi::system::RebootMethod) {
+                  absl::MutexLock l(&mu_);
+                  if (failing_.contains(thinkit_switch.ChassisName())) {
+                    return absl::UnavailableError("Reboot rejected.");
+                  }
+                  max_unavailable_seen_ =
+                      std::max(max_unavailable_seen_, ++unavailable_);
+                  return absl::OkStatus();
+                },
+            .down = [](thinkit::Switch&) { return absl::OkStatus(); },
+            .sshable = [](thinkit::Switch&,
+                          thinkit::SSHClient&) { return absl::OkStatus(); },
+            .gnmiable = [](thinkit::Switch&) { return absl::OkStatus(); },
+            .p4rtable =
+                [this](thinkit::Switch& thinkit_switch) {
+                  absl::MutexLock l(&mu_);
+                  // Fails the first try, so that the switch stays unavailable
+                  // while the others are rebooted.
+                  if (p4rt_tried_.insert(thinkit_switch.ChassisName())
+                          .second) {
+                    return absl::UnavailableError("P4RT not up yet.");
+                  }
+                  return absl::OkStatus();
+                },
+            .ports_up =
+                [this](thinkit::Switch&, absl::Span<const std::string>) {
+                  absl::MutexLock l(&mu_);
+                  --unavailable_;
+                  return absl::OkStatus();
+                },
+        },
+    };
+  }
+
+  // Makes the reboot of the given switch fail.
+  void FailReboot(const std::string& chassis_name) {
+    absl::MutexLock l(&mu_);
+    failing_.insert(chassis_name);
+  }
+
+  int MaxUnavailableSeen() {
+    absl::MutexLock l(&mu_);
+    return max_unavailable_seen_;
+  }
+
+ private:
+  std::vector<std::unique_ptr<std::string>> names_;
+  std::vector<std::unique_ptr<NiceMock<thinkit::MockSwitch>>> switches_;
+  absl::Mutex mu_;
+  absl::flat_hash_set<std::string> failing_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_set<std::string> p4rt_tried_ ABSL_GUARDED_BY(mu_);
+  int unavailable_ ABSL_GUARDED_BY(mu_) = 0;
+  int max_unavailable_seen_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+std::vector<RebootPhase> Phases(const RebootProgress& progress) {
+  std::vector<RebootPhase> phases;
+  for (const auto& [phase, time] : progress.phases) phases.push_back(phase);
+  return phases;
+}
+
+TEST(RebootInParallelTest, RebootsEverySwitchThroughAllPhases) {
+  FakeFleet fleet(3);
+  ASSERT_OK_AND_ASSIGN(std::vector<RebootProgress> progress,
+                       RebootInParallel(fleet.Targets(), fleet.Options(3)));
+  ASSERT_EQ(progress.size(), 3);
+  EXPECT_OK(AllRebootsSucceeded(progress));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(progress[i].chassis_name, absl::StrCat("sw", i));
+    EXPECT_THAT(Phases(progress[i]),
+                ElementsAre(RebootPhase::kRebootRequested, RebootPhase::kDown,
+                            RebootPhase::kGnmiable, RebootPhase::kP4rtable,
+                            RebootPhase::kPortsUp));
+  }
+}
+
+TEST(RebootInParallelTest, RespectsMaxUnavailable) {
+  FakeFleet fleet(8);
+  ASSERT_OK_AND_ASSIGN(std::vector<RebootProgress> progress,
+                       RebootInParallel(fleet.Targets(), fleet.Options(2)));
+  EXPECT_OK(AllRebootsSucceeded(progress));
+  EXPECT_LE(fleet.MaxUnavailableSeen(), 2);
+}
+
+TEST(RebootInParallelTest, ChecksSshOnlyWithAClientAndPortsOnlyIfRequested) {
+  FakeFleet fleet(1);
+  thinkit::MockSSHClient ssh_client;
+  std::vector<RebootTarget> targets = fleet.Targets();
+  targets[0].ssh_client = &ssh_client;
+  ParallelRebootOptions options = fleet.Options(1);
+  options.check_ports = false;
+  ASSERT_OK_AND_ASSIGN(std::vector<RebootProgress> progress,
+                       RebootInParallel(targets, options));
+  EXPECT_THAT(Phases(progress[0]),
+              ElementsAre(RebootPhase::kRebootRequested, RebootPhase::kDown,
+                          RebootPhase::kSshable, RebootPhase::kGnmiable,
+                          RebootPhase::kP4rtable));
+}
+
+TEST(RebootInParallelTest, FailedSwitchesKeepTheirSlot) {
+  FakeFleet fleet(3);
+  fleet.FailReboot("sw0");
+  fleet.FailReboot("sw1");
+  fleet.FailReboot("sw2");
+  ASSERT_OK_AND_ASSIGN(std::vector<RebootProgress> progress,
+                       RebootInParallel(fleet.Targets(), fleet.Options(2)));
+  // The first two failures use up both slots, so the last switch is not
+  // rebooted.
+  int failed = 0, aborted = 0;
+  for (const RebootProgress& device_progress : progress) {
+    if (device_progress.status.code() == absl::StatusCode::kAborted) {
+      ++aborted;
+    } else if (!device_progress.status.ok()) {
+      ++failed;
+    }
+  }
+  EXPECT_EQ(failed, 2);
+  EXPECT_EQ(aborted, 1);
+  EXPECT_THAT(AllRebootsSucceeded(progress),
+              StatusIs(absl::StatusCode::kUnavailable,
+                       HasSubstr("3 of 3 switches are not ready")));
+}
+
+TEST(RebootInParallelTest, RejectsInvalidOptions) {
+  FakeFleet fleet(1);
+  EXPECT_THAT(RebootInParallel(fleet.Targets(), fleet.Options(0)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  ParallelRebootOptions options = fleet.Options(1);
+  options.checks.down = nullptr;
+  EXPECT_THAT(RebootInParallel(fleet.Targets(), options),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(RebootInParallel({RebootTarget()}, fleet.Options(1)),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace pins_test
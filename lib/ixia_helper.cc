@@ -14,15 +14,19 @@
 
 #include "lib/ixia_helper.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>  // NOLINT
 #include <type_traits>
 #include <variant>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/random/random.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -1029,12 +1033,10 @@ absl::Status AppendUdp(absl::string_view tref,
   return ixia::WaitForComplete(append_response, generic_testbed);
 }
 
-absl::Status AppendProtocolAtStack(absl::string_view tref,
-                                   absl::string_view protocol,
-                                   absl::string_view stack,
-                                   thinkit::GenericTestbed &generic_testbed) {
-  // GET to /ixnetwork/traffic/protocolTemplate to find the correct protocol
-  // template to use.
+// Returns the response of a GET to /ixnetwork/traffic/protocolTemplate, which
+// lists every protocol template.
+static absl::StatusOr<std::string> GetProtocolTemplates(
+    thinkit::GenericTestbed &generic_testbed) {
   constexpr absl::string_view kProtoPath =
       "/ixnetwork/traffic/protocolTemplate?links=true&skip=0&take=end";
   ASSIGN_OR_RETURN(thinkit::HttpResponse proto_response,
@@ -1044,27 +1046,39 @@ absl::Status AppendProtocolAtStack(absl::string_view tref,
   if (proto_response.response_code != 200)
     return absl::InternalError(absl::StrFormat("unexpected response: %u",
                                                proto_response.response_code));
+  return proto_response.response;
+}
 
-  std::size_t ixname = proto_response.response.find(
-      absl::Substitute("\"displayName\":\"$0\"", protocol));
+// Returns the href of the template with the `displayName` `protocol`, given
+// the response of `GetProtocolTemplates`.
+static absl::StatusOr<std::string> FindProtocolTemplate(
+    absl::string_view templates, absl::string_view protocol) {
+  std::size_t ixname =
+      templates.find(absl::Substitute("\"displayName\":\"$0\"", protocol));
   if (ixname == std::string::npos)
     return absl::InternalError(
         absl::StrCat("no template found for ", protocol));
-  std::size_t ixhref = proto_response.response.find("\"href\":", ixname);
+  std::size_t ixhref = templates.find("\"href\":", ixname);
   if (ixhref == std::string::npos)
     return absl::InternalError(
         absl::StrCat("no template found for ", protocol));
-  std::size_t ixqt = proto_response.response.find('"', ixhref + 8);
+  std::size_t ixqt = templates.find('"', ixhref + 8);
   if (ixqt == std::string::npos)
     return absl::InternalError(
         absl::StrCat("no template found for ", protocol));
-  std::string tcpref =
-      proto_response.response.substr(ixhref + 8, ixqt - ixhref - 8);
-  std::size_t ixfield = tcpref.find("/field");
+  std::string template_ref(templates.substr(ixhref + 8, ixqt - ixhref - 8));
+  std::size_t ixfield = template_ref.find("/field");
   if (ixfield != std::string::npos) {
-    tcpref = tcpref.substr(0, ixfield);
+    template_ref = template_ref.substr(0, ixfield);
   }
+  return template_ref;
+}
 
+// Appends the protocol template with the given href, as returned by
+// `FindProtocolTemplate`, after the given stack of the traffic item.
+static absl::Status AppendProtocolTemplateAtStack(
+    absl::string_view tref, absl::string_view template_ref,
+    absl::string_view stack, thinkit::GenericTestbed &generic_testbed) {
   // POST to
   // /ixnetwork/traffic/trafficItem/configElement/stack/operations/appendprotocol
   // {"arg1":"/api/v1/sessions/1/ixnetwork/traffic/trafficItem/1/configElement/1/stack/<stack>","arg2":"/api/v1/sessions/1/ixnetwork/traffic/protocolTemplate/<template>"}
@@ -1074,7 +1088,7 @@ absl::Status AppendProtocolAtStack(absl::string_view tref,
 
   std::string append_json =
       absl::StrCat("{\"arg1\":\"", tref, "/configElement/1/stack/", stack,
-                   "\",\"arg2\":\"", tcpref, "\"}");
+                   "\",\"arg2\":\"", template_ref, "\"}");
   LOG(INFO) << "json " << append_json;
   ASSIGN_OR_RETURN(thinkit::HttpResponse append_response,
                    generic_testbed.SendRestRequestToIxia(
@@ -1085,6 +1099,20 @@ absl::Status AppendProtocolAtStack(absl::string_view tref,
   return ixia::WaitForComplete(append_response, generic_testbed);
 }
 
+absl::Status AppendProtocolAtStack(absl::string_view tref,
+                                   absl::string_view protocol,
+                                   absl::string_view stack,
+                                   thinkit::GenericTestbed &generic_testbed) {
+  // GET to /ixnetwork/traffic/protocolTemplate to find the correct protocol
+  // template to use.
+  ASSIGN_OR_RETURN(std::string templates,
+                   GetProtocolTemplates(generic_testbed));
+  ASSIGN_OR_RETURN(std::string template_ref,
+                   FindProtocolTemplate(templates, protocol));
+  return AppendProtocolTemplateAtStack(tref, template_ref, stack,
+                                       generic_testbed);
+}
+
 absl::StatusOr<std::string> GetRawStatsView(
     absl::string_view href, int stats_view_index,
     thinkit::GenericTestbed &generic_testbed) {
@@ -1332,6 +1360,275 @@ absl::Status SetTrafficParameters(absl::string_view tref,
   return absl::OkStatus();
 }
 
+// Returns the xpath used by IxNetwork configuration imports for the traffic
+// item with the given tref, e.g. "/traffic/trafficItem[1]" for
+// "/api/v1/sessions/1/ixnetwork/traffic/trafficItem/1".
+static absl::StatusOr<std::string> TrafficItemXpath(absl::string_view tref) {
+  constexpr absl::string_view kTrafficItem = "/traffic/trafficItem/";
+  std::size_t ixitem = tref.rfind(kTrafficItem);
+  int id;
+  if (ixitem == absl::string_view::npos ||
+      !absl::SimpleAtoi(tref.substr(ixitem + kTrafficItem.size()), &id)) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "expected a traffic item tref, but got: '" << tref << "'";
+  }
+  return absl::StrCat("/traffic/trafficItem[", id, "]");
+}
+
+// Returns the part of the given tref up to and including "/ixnetwork", e.g.
+// "/api/v1/sessions/1/ixnetwork".
+static absl::StatusOr<std::string> IxNetworkRoot(absl::string_view tref) {
+  constexpr absl::string_view kIxNetwork = "/ixnetwork";
+  std::size_t ixroot = tref.find(absl::StrCat(kIxNetwork, "/"));
+  if (ixroot == absl::string_view::npos) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "expected an IxNetwork href, but got: '" << tref << "'";
+  }
+  return std::string(tref.substr(0, ixroot + kIxNetwork.size()));
+}
+
+// Returns the configuration setting a single value of a header field, where
+// `stack` and `field` are IxNetwork aliases, e.g. "ipv4-2" and
+// "ipv4.header.srcIp-27".
+static Json FieldConfig(absl::string_view config_element_xpath,
+                        absl::string_view stack, absl::string_view field,
+                        absl::string_view value) {
+  return Json::object({
+      {"xpath", absl::Substitute("$0/stack[@alias = '$1']/field[@alias = '$2']",
+                                 config_element_xpath, stack, field)},
+      {"activeFieldChoice", true},
+      {"singleValue", std::string(value)},
+  });
+}
+
+static absl::Status CheckIpPriority(const IpPriority &priority) {
+  if (priority.dscp < 0 || priority.dscp > 63) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Invalid dscp: %d, valid range 0 - 63", priority.dscp));
+  }
+  if (priority.ecn < 0 || priority.ecn > 3) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Invalid ecn_bits: %d, valid range 0 - 3", priority.ecn));
+  }
+  return absl::OkStatus();
+}
+
+// Appends the configuration of the IP header fields to `config`. The field
+// numbers match those used by `SetSrcIPv4`, `SetIpPriority`, etc.
+static absl::Status AppendIpConfig(absl::string_view config_element_xpath,
+                                   const Ipv4TrafficParameters &params,
+                                   Json &config) {
+  config.push_back(FieldConfig(config_element_xpath, "ipv4-2",
+                               "ipv4.header.srcIp-27",
+                               params.src_ipv4.ToString()));
+  config.push_back(FieldConfig(config_element_xpath, "ipv4-2",
+                               "ipv4.header.dstIp-28",
+                               params.dst_ipv4.ToString()));
+  if (params.priority.has_value()) {
+    RETURN_IF_ERROR(CheckIpPriority(*params.priority));
+    // IPv4 takes the type of service in hex.
+    config.push_back(FieldConfig(
+        config_element_xpath, "ipv4-2", "ipv4.header.priority.raw-3",
+        absl::StrFormat("%X",
+                        (params.priority->dscp << 2) | params.priority->ecn)));
+  }
+  return absl::OkStatus();
+}
+
+static absl::Status AppendIpConfig(absl::string_view config_element_xpath,
+                                   const Ipv6TrafficParameters &params,
+                                   Json &config) {
+  config.push_back(FieldConfig(config_element_xpath, "ipv6-2",
+                               "ipv6.header.srcIP-7",
+                               params.src_ipv6.ToString()));
+  config.push_back(FieldConfig(config_element_xpath, "ipv6-2",
+                               "ipv6.header.dstIP-8",
+                               params.dst_ipv6.ToString()));
+  if (params.priority.has_value()) {
+    RETURN_IF_ERROR(CheckIpPriority(*params.priority));
+    // IPv6 takes the traffic class in decimal.
+    config.push_back(FieldConfig(
+        config_element_xpath, "ipv6-2",
+        "ipv6.header.versionTrafficClassFlowLabel.trafficClass-2",
+        absl::StrFormat("%d",
+                        (params.priority->dscp << 2) | params.priority->ecn)));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string> TrafficParametersToIxiaConfig(
+    absl::Span<const std::string> trefs,
+    absl::Span<const TrafficParameters> params) {
+  if (trefs.size() != params.size()) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "got " << trefs.size() << " trefs but " << params.size()
+           << " sets of traffic parameters";
+  }
+  Json config = Json::array();
+  for (int i = 0; i < trefs.size(); ++i) {
+    ASSIGN_OR_RETURN(std::string item_xpath, TrafficItemXpath(trefs[i]));
+    const std::string element_xpath =
+        absl::StrCat(item_xpath, "/configElement[1]");
+    const TrafficParameters &item_params = params[i];
+
+    if (item_params.frame_count.has_value()) {
+      config.push_back(Json::object({
+          {"xpath", absl::StrCat(element_xpath, "/transmissionControl")},
+          {"type", "fixedFrameCount"},
+          {"frameCount", *item_params.frame_count},
+      }));
+    }
+    if (item_params.frame_size_in_bytes.has_value()) {
+      config.push_back(Json::object({
+          {"xpath", absl::StrCat(element_xpath, "/frameSize")},
+          {"fixedSize", *item_params.frame_size_in_bytes},
+      }));
+    }
+    config.push_back(std::visit(
+        gutil::Overload{
+            [&](FramesPerSecond speed) {
+              return Json::object({
+                  {"xpath", absl::StrCat(element_xpath, "/frameRate")},
+                  {"type", "framesPerSecond"},
+                  {"rate", speed.frames_per_second},
+              });
+            },
+            [&](PercentOfMaxLineRate speed) {
+              return Json::object({
+                  {"xpath", absl::StrCat(element_xpath, "/frameRate")},
+                  {"type", "percentLineRate"},
+                  {"rate", speed.percent_of_max_line_rate},
+              });
+            }},
+        item_params.traffic_speed));
+
+    config.push_back(FieldConfig(element_xpath, "ethernet-1",
+                                 "ethernet.header.destinationAddress-1",
+                                 item_params.dst_mac.ToString()));
+    config.push_back(FieldConfig(element_xpath, "ethernet-1",
+                                 "ethernet.header.sourceAddress-2",
+                                 item_params.src_mac.ToString()));
+
+    if (item_params.ip_parameters.has_value()) {
+      RETURN_IF_ERROR(std::visit(
+          [&](const auto &ip_params) {
+            return AppendIpConfig(element_xpath, ip_params, config);
+          },
+          *item_params.ip_parameters));
+    }
+  }
+  return config.dump();
+}
+
+// Calls `f(i)` for every i in [0, `count`), on up to `max_concurrency` threads
+// at a time. Returns the error of the lowest failing i, if any.
+static absl::Status ForEachConcurrently(
+    int count, int max_concurrency, absl::FunctionRef<absl::Status(int)> f) {
+  std::vector<absl::Status> statuses(count);
+  // Each thread claims the next index until none are left.
+  std::atomic<int> next = 0;
+  auto run = [&] {
+    for (int i = next++; i < count; i = next++) statuses[i] = f(i);
+  };
+  const int num_threads = std::min(std::max(max_concurrency, 1), count);
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) threads.emplace_back(run);
+  run();
+  for (std::thread &thread : threads) thread.join();
+  for (absl::Status &status : statuses) RETURN_IF_ERROR(status);
+  return absl::OkStatus();
+}
+
+// Applies a configuration, as returned by `TrafficParametersToIxiaConfig`,
+// without replacing the rest of the session's configuration.
+static absl::Status ImportIxiaConfig(absl::string_view ixnetwork_root,
+                                     absl::string_view config,
+                                     thinkit::GenericTestbed &testbed,
+                                     absl::Duration timeout) {
+  // POST to /ixnetwork/resourceManager/operations/importconfig with
+  // {"arg1":"/api/v1/sessions/1/ixnetwork/resourceManager",
+  //  "arg2":"[{\"xpath\":...}, ...]","arg3":false}
+  constexpr absl::string_view kImportPath =
+      "/ixnetwork/resourceManager/operations/importconfig";
+  const Json import_json = Json::object({
+      {"arg1", absl::StrCat(ixnetwork_root, "/resourceManager")},
+      {"arg2", config},
+      {"arg3", false},
+  });
+  LOG(INFO) << "path " << kImportPath;
+  LOG(INFO) << "json " << import_json;
+  ASSIGN_OR_RETURN(
+      thinkit::HttpResponse import_response,
+      testbed.SendRestRequestToIxia(thinkit::RequestType::kPost, kImportPath,
+                                    import_json.dump()));
+  LOG(INFO) << "Received code: " << import_response.response_code;
+  LOG(INFO) << "Received response: "
+            << FormatJsonBestEffort(import_response.response);
+  return WaitForComplete(import_response, testbed, timeout);
+}
+
+absl::Status SetTrafficParameters(absl::Span<const std::string> trefs,
+                                  absl::Span<const TrafficParameters> params,
+                                  thinkit::GenericTestbed &testbed,
+                                  const BulkTrafficSetupOptions &options) {
+  // Validate and build the whole configuration before touching the Ixia.
+  ASSIGN_OR_RETURN(std::string config,
+                   TrafficParametersToIxiaConfig(trefs, params));
+  if (trefs.empty()) return absl::OkStatus();
+  ASSIGN_OR_RETURN(std::string ixnetwork_root, IxNetworkRoot(trefs.front()));
+
+  // The IP stacks must exist before their fields can be configured. Appending
+  // a protocol is an operation of its own, so it is done per item, but the
+  // protocol templates are only looked up once.
+  std::optional<std::string> ipv4_template_ref;
+  std::optional<std::string> ipv6_template_ref;
+  std::vector<const std::string *> template_refs(trefs.size(), nullptr);
+  std::optional<std::string> templates;
+  for (int i = 0; i < params.size(); ++i) {
+    if (!params[i].ip_parameters.has_value()) continue;
+    if (!templates.has_value()) {
+      ASSIGN_OR_RETURN(templates, GetProtocolTemplates(testbed));
+    }
+    const bool is_ipv4 =
+        std::holds_alternative<Ipv4TrafficParameters>(*params[i].ip_parameters);
+    std::optional<std::string> &template_ref =
+        is_ipv4 ? ipv4_template_ref : ipv6_template_ref;
+    if (!template_ref.has_value()) {
+      ASSIGN_OR_RETURN(template_ref,
+                       FindProtocolTemplate(*templates, is_ipv4 ? "IPv4"
+                                                                : "IPv6"));
+    }
+    template_refs[i] = &*template_ref;
+  }
+  RETURN_IF_ERROR(ForEachConcurrently(
+      trefs.size(), options.max_concurrent_items, [&](int i) {
+        if (template_refs[i] == nullptr) return absl::OkStatus();
+        return AppendProtocolTemplateAtStack(trefs[i], *template_refs[i],
+                                             /*stack=*/"1", testbed);
+      }));
+
+  return ImportIxiaConfig(ixnetwork_root, config, testbed, options.timeout);
+}
+
+absl::StatusOr<std::vector<std::string>> SetUpTrafficItems(
+    absl::Span<const TrafficItemSpec> specs, thinkit::GenericTestbed &testbed,
+    const BulkTrafficSetupOptions &options) {
+  std::vector<std::string> trefs(specs.size());
+  RETURN_IF_ERROR(ForEachConcurrently(
+      specs.size(), options.max_concurrent_items, [&](int i) -> absl::Status {
+        ASSIGN_OR_RETURN(trefs[i],
+                         SetUpTrafficItem(specs[i].vref_src, specs[i].vref_dst,
+                                          specs[i].traffic_name, testbed));
+        return absl::OkStatus();
+      }));
+
+  std::vector<TrafficParameters> params;
+  params.reserve(specs.size());
+  for (const TrafficItemSpec &spec : specs) params.push_back(spec.parameters);
+  RETURN_IF_ERROR(SetTrafficParameters(trefs, params, testbed, options));
+  return trefs;
+}
+
 // Go over the connections and return vector of connections
 // whose links are up.
 absl::StatusOr<std::vector<IxiaLink>> GetReadyIxiaLinks(
@@ -302,6 +302,52 @@ absl::Status SetTrafficParameters(absl::string_view tref,
                                   const TrafficParameters &params,
                                   thinkit::GenericTestbed &testbed);
 
+// -- Bulk traffic item setup -------------------------------------------------
+
+// A traffic item to be set up by `SetUpTrafficItems`.
+struct TrafficItemSpec {
+  // The vrefs returned by IxiaVport.
+  std::string vref_src;
+  std::string vref_dst;
+  // Name of the traffic item, useful for querying stats.
+  std::string traffic_name;
+  TrafficParameters parameters;
+};
+
+struct BulkTrafficSetupOptions {
+  // The number of traffic items whose per-item requests (creation, endpoints,
+  // protocol stack) are sent at a time. The testbed's `SendRestRequestToIxia`
+  // is called from this many threads at once, so set it to 1 if that is not
+  // thread-safe.
+  int max_concurrent_items = 8;
+  // How long to wait for the bulk configuration to be applied.
+  absl::Duration timeout = absl::Minutes(2);
+};
+
+// Sets up the given traffic items and all of their parameters. Unlike calling
+// `SetUpTrafficItem` and `SetTrafficParameters` per item, which sends one REST
+// request per attribute, the attributes of all items are applied with a single
+// IxNetwork import of the configuration, and the per-item requests are sent
+// for several items concurrently. Returns the trefs of the items, in order.
+absl::StatusOr<std::vector<std::string>> SetUpTrafficItems(
+    absl::Span<const TrafficItemSpec> specs, thinkit::GenericTestbed &testbed,
+    const BulkTrafficSetupOptions &options = {});
+
+// Sets the given parameters of the given traffic items, which must already
+// exist and have the Ethernet stack only, with a single bulk request for the
+// attributes (see `SetUpTrafficItems`). `params[i]` applies to `trefs[i]`.
+absl::Status SetTrafficParameters(absl::Span<const std::string> trefs,
+                                  absl::Span<const TrafficParameters> params,
+                                  thinkit::GenericTestbed &testbed,
+                                  const BulkTrafficSetupOptions &options = {});
+
+// Returns the IxNetwork configuration, as a JSON list of xpath objects, that
+// sets the attributes of `params[i]` on `trefs[i]`. Assumes the IP stack of
+// each item, if any, has already been appended. Exposed for testing.
+absl::StatusOr<std::string> TrafficParametersToIxiaConfig(
+    absl::Span<const std::string> trefs,
+    absl::Span<const TrafficParameters> params);
+
 // -- Statistics ---------------------------------------------------------------
 
 // Low-level function for obtaining unparsed statistics view by index.
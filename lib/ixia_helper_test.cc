@@ -1,9 +1,14 @@
 #include "lib/ixia_helper.h"
 
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "gutil/proto_matchers.h"
 #include "gutil/status_matchers.h"
+#include "include/nlohmann/json.hpp"
+#include "p4_pdpi/netaddr/ipv4_address.h"
 #include "thinkit/generic_testbed.h"
 
 namespace pins_test::ixia {
@@ -11,6 +16,8 @@ namespace pins_test::ixia {
 using ::gutil::EqualsProto;
 using ::gutil::IsOkAndHolds;
 using ::gutil::StatusIs;
+using ::testing::SizeIs;
+using Json = ::nlohmann::json;
 
 TEST(FindIdByField, FindsId) {
   static constexpr absl::string_view kArray =
@@ -272,4 +279,71 @@ TEST(ParseTrafficItemStats, ParsesExampleCorrectly) {
               )pb")));
 }
 
+TEST(TrafficParametersToIxiaConfig, ConfiguresEveryItemInOneConfig) {
+  TrafficParameters ipv4_params{
+      .frame_count = 1000,
+      .frame_size_in_bytes = 128,
+      .traffic_speed = FramesPerSecond{.frames_per_second = 500},
+      .ip_parameters = Ipv4TrafficParameters{
+          .dst_ipv4 = netaddr::Ipv4Address(10, 0, 0, 1),
+          .priority = IpPriority{.dscp = 8, .ecn = 1},
+      }};
+  TrafficParameters l2_params{
+      .traffic_speed = PercentOfMaxLineRate{.percent_of_max_line_rate = 50}};
+
+  ASSERT_OK_AND_ASSIGN(
+      std::string raw_config,
+      TrafficParametersToIxiaConfig(
+          {"/api/v1/sessions/1/ixnetwork/traffic/trafficItem/3",
+           "/api/v1/sessions/1/ixnetwork/traffic/trafficItem/4"},
+          {ipv4_params, l2_params}));
+  Json config = Json::parse(raw_config);
+  // Item 3: frame count, frame size, rate, 2 MACs and 3 IPv4 fields.
+  // Item 4: rate and 2 MACs.
+  ASSERT_THAT(config, SizeIs(11));
+
+  EXPECT_EQ(config[0]["xpath"],
+            "/traffic/trafficItem[3]/configElement[1]/transmissionControl");
+  EXPECT_EQ(config[0]["frameCount"], 1000);
+  EXPECT_EQ(config[1]["fixedSize"], 128);
+  EXPECT_EQ(config[2]["type"], "framesPerSecond");
+  EXPECT_EQ(config[2]["rate"], 500);
+  EXPECT_EQ(config[6]["xpath"],
+            "/traffic/trafficItem[3]/configElement[1]/stack[@alias = "
+            "'ipv4-2']/field[@alias = 'ipv4.header.dstIp-28']");
+  EXPECT_EQ(config[6]["singleValue"], "10.0.0.1");
+  // (8 << 2) | 1 in hex.
+  EXPECT_EQ(config[7]["singleValue"], "21");
+
+  EXPECT_EQ(config[8]["xpath"],
+            "/traffic/trafficItem[4]/configElement[1]/frameRate");
+  EXPECT_EQ(config[8]["type"], "percentLineRate");
+  EXPECT_EQ(config[8]["rate"], 50);
+}
+
+TEST(TrafficParametersToIxiaConfig, RejectsMismatchedSizes) {
+  EXPECT_THAT(
+      TrafficParametersToIxiaConfig(
+          {"/api/v1/sessions/1/ixnetwork/traffic/trafficItem/1"}, {}),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(TrafficParametersToIxiaConfig, RejectsNonTrafficItemTref) {
+  EXPECT_THAT(TrafficParametersToIxiaConfig(
+                  {"/api/v1/sessions/1/ixnetwork/vport/1"},
+                  {TrafficParameters{}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(TrafficParametersToIxiaConfig, RejectsInvalidPriority) {
+  TrafficParameters params{
+      .ip_parameters = Ipv6TrafficParameters{
+          .priority = IpPriority{.dscp = 64},
+      }};
+  EXPECT_THAT(
+      TrafficParametersToIxiaConfig(
+          {"/api/v1/sessions/1/ixnetwork/traffic/trafficItem/1"}, {params}),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 }  // namespace pins_test::ixia
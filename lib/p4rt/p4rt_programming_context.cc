@@ -17,12 +17,14 @@
 #include <functional>
 #include <iterator>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "glog/logging.h"
 #include "gutil/status.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/sequencing.h"
 
 namespace pins_test {
 namespace {
@@ -69,7 +71,31 @@ absl::Status P4rtProgrammingContext::SendWriteRequest(
   return absl::OkStatus();
 }
 
+absl::Status P4rtProgrammingContext::BatchInverseRequests() {
+  if (inverse_programming_requests_.size() <= 1) return absl::OkStatus();
+
+  // Inverse updates are collected most recent first, so that sequencing, which
+  // keeps the input order within a batch, preserves the revert order.
+  std::vector<p4::v1::Update> updates;
+  for (auto it = inverse_programming_requests_.rbegin();
+       it != inverse_programming_requests_.rend(); ++it) {
+    for (const p4::v1::Update& update : it->updates()) {
+      updates.push_back(update);
+    }
+  }
+  ASSIGN_OR_RETURN(
+      std::vector<p4::v1::WriteRequest> requests,
+      pdpi::SequencePiUpdatesIntoWriteRequests(*ir_p4info_, updates));
+
+  // `Revert` sends requests from the back.
+  inverse_programming_requests_.assign(
+      std::make_move_iterator(requests.rbegin()),
+      std::make_move_iterator(requests.rend()));
+  return absl::OkStatus();
+}
+
 absl::Status P4rtProgrammingContext::Revert() {
+  if (ir_p4info_ != nullptr) RETURN_IF_ERROR(BatchInverseRequests());
   for (auto it = inverse_programming_requests_.rbegin();
        it != inverse_programming_requests_.rend(); ++it) {
     RETURN_IF_ERROR(write_request_(session_, *it));
@@ -21,6 +21,7 @@
 
 #include "absl/functional/bind_front.h"
 #include "absl/status/status.h"
+#include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
 
 namespace pins_test {
@@ -46,6 +47,19 @@ class P4rtProgrammingContext {
         write_request_function_(absl::bind_front(
             &P4rtProgrammingContext::SendWriteRequest, this)) {}
 
+  // Like the constructor above, but `Revert` sequences all inverse updates
+  // using `ir_p4info` and sends them in a few batched write requests rather
+  // than one request per programmed request. `ir_p4info` needs to be valid
+  // during the lifetime of this object.
+  P4rtProgrammingContext(
+      pdpi::P4RuntimeSession* session, const pdpi::IrP4Info& ir_p4info,
+      std::function<absl::Status(pdpi::P4RuntimeSession*,
+                                 p4::v1::WriteRequest&)>
+          write_request = pdpi::SetMetadataAndSendPiWriteRequest)
+      : P4rtProgrammingContext(session, std::move(write_request)) {
+    ir_p4info_ = &ir_p4info;
+  }
+
   P4rtProgrammingContext(const P4rtProgrammingContext& other) = delete;
   P4rtProgrammingContext(P4rtProgrammingContext&& other) = default;
 
@@ -69,11 +83,18 @@ class P4rtProgrammingContext {
   absl::Status SendWriteRequest(p4::v1::WriteRequest& request);
 
   // Reverts all programmed write requests by sending them back in reverse order
-  // with INSERT replaced by DELETE and vice versa.
+  // with INSERT replaced by DELETE and vice versa. If the context has an
+  // IrP4Info, the inverse updates are first sequenced into dependency order and
+  // batched. On failure, calling `Revert` again resumes with the request that
+  // failed.
   absl::Status Revert();
 
  private:
+  // Merges all inverse requests into as few sequenced requests as possible.
+  absl::Status BatchInverseRequests();
+
   pdpi::P4RuntimeSession* session_;
+  const pdpi::IrP4Info* ir_p4info_ = nullptr;
   std::function<absl::Status(pdpi::P4RuntimeSession*, p4::v1::WriteRequest&)>
       write_request_;
   std::vector<p4::v1::WriteRequest> inverse_programming_requests_;
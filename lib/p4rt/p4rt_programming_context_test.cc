@@ -23,7 +23,10 @@
 #include "gutil/status_matchers.h"
 #include "gutil/testing.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
+#include "sai_p4/instantiations/google/instantiations.h"
+#include "sai_p4/instantiations/google/sai_p4info.h"
 
 namespace pins_test {
 namespace {
@@ -65,6 +68,21 @@ static constexpr char kDeleteVrfRequest[] =
            }
          })pb";
 
+static constexpr char kInsertOtherVrfRequest[] =
+    R"pb(updates {
+           type: INSERT
+           entity {
+             table_entry {
+               table_id: 33554506
+               match {
+                 field_id: 1
+                 exact { value: "other-vrf" }
+               }
+               action { action { action_id: 24742814 } }
+             }
+           }
+         })pb";
+
 static constexpr char kInsertPreingressRequest[] = R"pb(
   updates {
     type: INSERT
@@ -304,6 +322,101 @@ TEST(P4rtProgrammingContext, RevertsOnRevertCallResumesOnFailure) {
   EXPECT_OK(context.SendWriteRequest(vrf_request));
 }
 
+TEST(P4rtProgrammingContext, BatchesIndependentRevertsWithIrP4Info) {
+  const pdpi::IrP4Info ir_p4info =
+      sai::GetIrP4Info(sai::Instantiation::kMiddleblock);
+  MockFunction<absl::Status(pdpi::P4RuntimeSession*, p4::v1::WriteRequest&)>
+      mock_write_request;
+  Sequence sequence;
+  EXPECT_CALL(mock_write_request, Call(_, EqualsProto(kInsertVrfRequest)))
+      .InSequence(sequence)
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_CALL(mock_write_request, Call(_, EqualsProto(kInsertOtherVrfRequest)))
+      .InSequence(sequence)
+      .WillOnce(Return(absl::OkStatus()));
+
+  // Both deletes are sent in a single request, most recent first.
+  EXPECT_CALL(mock_write_request, Call(_, EqualsProto(R"pb(
+                updates {
+                  type: DELETE
+                  entity {
+                    table_entry {
+                      table_id: 33554506
+                      match {
+                        field_id: 1
+                        exact { value: "other-vrf" }
+                      }
+                      action { action { action_id: 24742814 } }
+                    }
+                  }
+                }
+                updates {
+                  type: DELETE
+                  entity {
+                    table_entry {
+                      table_id: 33554506
+                      match {
+                        field_id: 1
+                        exact { value: "default-vrf" }
+                      }
+                      action { action { action_id: 24742814 } }
+                    }
+                  }
+                }
+              )pb")))
+      .InSequence(sequence)
+      .WillOnce(Return(absl::OkStatus()));
+
+  P4rtProgrammingContext context(nullptr, ir_p4info,
+                                 mock_write_request.AsStdFunction());
+  auto vrf_request =
+      gutil::ParseProtoOrDie<p4::v1::WriteRequest>(kInsertVrfRequest);
+  EXPECT_OK(context.SendWriteRequest(vrf_request));
+  auto other_vrf_request =
+      gutil::ParseProtoOrDie<p4::v1::WriteRequest>(kInsertOtherVrfRequest);
+  EXPECT_OK(context.SendWriteRequest(other_vrf_request));
+  EXPECT_OK(context.Revert());
+}
+
+TEST(P4rtProgrammingContext, BatchedRevertKeepsDependencyOrder) {
+  const pdpi::IrP4Info ir_p4info =
+      sai::GetIrP4Info(sai::Instantiation::kMiddleblock);
+  MockFunction<absl::Status(pdpi::P4RuntimeSession*, p4::v1::WriteRequest&)>
+      mock_write_request;
+  Sequence sequence;
+  EXPECT_CALL(mock_write_request, Call(_, EqualsProto(kInsertVrfRequest)))
+      .InSequence(sequence)
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_CALL(mock_write_request,
+              Call(_, EqualsProto(kInsertPreingressRequest)))
+      .InSequence(sequence)
+      .WillOnce(Return(absl::OkStatus()));
+
+  // The preingress entry refers to the VRF, so it is deleted first. A failed
+  // revert resumes where it left off.
+  EXPECT_CALL(mock_write_request,
+              Call(_, EqualsProto(kDeletePreingressRequest)))
+      .InSequence(sequence)
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_CALL(mock_write_request, Call(_, EqualsProto(kDeleteVrfRequest)))
+      .InSequence(sequence)
+      .WillOnce(Return(absl::UnknownError("Error")));
+  EXPECT_CALL(mock_write_request, Call(_, EqualsProto(kDeleteVrfRequest)))
+      .InSequence(sequence)
+      .WillOnce(Return(absl::OkStatus()));
+
+  P4rtProgrammingContext context(nullptr, ir_p4info,
+                                 mock_write_request.AsStdFunction());
+  auto vrf_request =
+      gutil::ParseProtoOrDie<p4::v1::WriteRequest>(kInsertVrfRequest);
+  EXPECT_OK(context.SendWriteRequest(vrf_request));
+  auto preingress_request =
+      gutil::ParseProtoOrDie<p4::v1::WriteRequest>(kInsertPreingressRequest);
+  EXPECT_OK(context.SendWriteRequest(preingress_request));
+  EXPECT_THAT(context.Revert(), StatusIs(absl::StatusCode::kUnknown));
+  EXPECT_OK(context.Revert());
+}
+
 TEST(P4rtProgrammingContext, RejectModifyRequests) {
   MockFunction<absl::Status(pdpi::P4RuntimeSession*, p4::v1::WriteRequest&)>
       mock_write_request;
@@ -13,18 +13,29 @@
 // limitations under the License.
 #include "lib/p4rt/packet_listener.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
+#include <optional>
 #include <string>
+#include <thread>  // NOLINT: third_party code.
 #include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "glog/logging.h"
 #include "gutil/status.h"
 #include "gutil/testing.h"
 #include "lib/p4rt/p4rt_programming_context.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/internal/bounded_ring_buffer.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
 #include "p4_pdpi/pd.h"
@@ -34,45 +45,228 @@
 
 namespace pins_test {
 
+namespace {
+
+// A decoded packet: the name of the port it arrived at and its payload.
+struct DecodedPacket {
+  std::string port_name;
+  std::string payload;
+};
+
+// Decodes the packet-in in `pi_response`, or returns nullopt (after logging
+// why) if it is malformed or arrived at an unknown port.
+std::optional<DecodedPacket> DecodePacket(
+    const pdpi::IrP4Info& ir_p4info,
+    const absl::flat_hash_map<std::string, std::string>&
+        interface_port_id_to_name,
+    const p4::v1::StreamMessageResponse& pi_response) {
+  sai::StreamMessageResponse pd_response;
+  if (!pdpi::PiStreamMessageResponseToPd(ir_p4info, pi_response, &pd_response)
+           .ok()) {
+    LOG(ERROR) << "Failed to convert PI stream message response to PD.";
+    return std::nullopt;
+  }
+  if (!pd_response.has_packet()) {
+    LOG(ERROR) << "PD response has no packet.";
+    return std::nullopt;
+  }
+  const std::string& port_id = pd_response.packet().metadata().ingress_port();
+
+  auto port_name = interface_port_id_to_name.find(port_id);
+  if (port_name == interface_port_id_to_name.end()) {
+    LOG(WARNING) << port_id << " not found.";
+    return std::nullopt;
+  }
+  return DecodedPacket{
+      .port_name = port_name->second,
+      .payload = std::move(*pd_response.mutable_packet()->mutable_payload()),
+  };
+}
+
+// Packets flowing from the reading thread through the decode threads to the
+// delivering thread. Packets are numbered in order of arrival, so that they can
+// be delivered in that order no matter which decode thread finishes first.
+class DecodePipeline {
+ public:
+  explicit DecodePipeline(int max_queued_packets)
+      : max_queued_packets_(max_queued_packets),
+        undecoded_(max_queued_packets) {}
+
+  // Called by the reading thread for every received packet, in order. Drops
+  // the oldest undecoded packet if the decode threads are falling behind.
+  void Push(p4::v1::StreamMessageResponse response) {
+    absl::MutexLock lock(&mutex_);
+    if (undecoded_.size() == undecoded_.capacity()) {
+      // The dropped packet is delivered as a gap.
+      decoded_[undecoded_.Pop()->first] = std::nullopt;
+      ++num_dropped_;
+    }
+    undecoded_.Push({num_pushed_++, std::move(response)});
+  }
+
+  // Called by the reading thread once all packets have been pushed.
+  void FinishPushing() {
+    absl::MutexLock lock(&mutex_);
+    finished_pushing_ = true;
+  }
+
+  // Run by each decode thread. Decodes packets until all have been decoded.
+  void Decode(const pdpi::IrP4Info& ir_p4info,
+              const absl::flat_hash_map<std::string, std::string>&
+                  interface_port_id_to_name) {
+    while (true) {
+      std::pair<int64_t, p4::v1::StreamMessageResponse> packet;
+      {
+        absl::MutexLock lock(&mutex_);
+        // Back pressure: only decode while there is room for the result.
+        auto can_decode = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+          return (!undecoded_.empty() &&
+                  static_cast<int>(decoded_.size()) + num_decoding_ <
+                      max_queued_packets_) ||
+                 (undecoded_.empty() && finished_pushing_);
+        };
+        mutex_.Await(absl::Condition(&can_decode));
+        if (undecoded_.empty()) return;
+        packet = *undecoded_.Pop();
+        ++num_decoding_;
+      }
+      std::optional<DecodedPacket> decoded =
+          DecodePacket(ir_p4info, interface_port_id_to_name, packet.second);
+      absl::MutexLock lock(&mutex_);
+      decoded_[packet.first] = std::move(decoded);
+      --num_decoding_;
+    }
+  }
+
+  // Called by the delivering thread. Returns the next packet in order of
+  // arrival (nullopt if it was dropped or could not be decoded), or an
+  // empty outer optional once all packets were delivered.
+  std::optional<std::optional<DecodedPacket>> Next() {
+    absl::MutexLock lock(&mutex_);
+    auto ready = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return decoded_.contains(num_delivered_) ||
+             (finished_pushing_ && num_delivered_ == num_pushed_);
+    };
+    mutex_.Await(absl::Condition(&ready));
+    auto it = decoded_.find(num_delivered_);
+    if (it == decoded_.end()) return std::nullopt;
+    std::optional<DecodedPacket> packet = std::move(it->second);
+    decoded_.erase(it);
+    ++num_delivered_;
+    return packet;
+  }
+
+  int64_t num_dropped() {
+    absl::MutexLock lock(&mutex_);
+    return num_dropped_;
+  }
+
+ private:
+  const int max_queued_packets_;
+  absl::Mutex mutex_;
+  pdpi::BoundedRingBuffer<std::pair<int64_t, p4::v1::StreamMessageResponse>>
+      undecoded_ ABSL_GUARDED_BY(mutex_);
+  // Decoded (or dropped) packets that are not yet delivered, by number.
+  absl::flat_hash_map<int64_t, std::optional<DecodedPacket>> decoded_
+      ABSL_GUARDED_BY(mutex_);
+  int num_decoding_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t num_pushed_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t num_delivered_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t num_dropped_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool finished_pushing_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+}  // namespace
+
 PacketListener::PacketListener(
     pdpi::P4RuntimeSession* session, P4rtProgrammingContext context,
     sai::Instantiation instantiation,
     const absl::flat_hash_map<std::string, std::string>*
-        interface_port_id_to_name)
+        interface_port_id_to_name,
+    PacketListenerOptions options)
     : session_(session),
       context_(std::move(context)),
       instantiation_(instantiation),
-      interface_port_id_to_name_(*interface_port_id_to_name) {}
+      interface_port_id_to_name_(*interface_port_id_to_name),
+      options_(options) {}
 
 absl::Status PacketListener::HandlePacketsFor(
     absl::Duration duration, thinkit::PacketCallback callback) {
+  if (options_.num_decode_threads > 0) {
+    return HandlePacketsConcurrentlyFor(duration, std::move(callback));
+  }
   ASSIGN_OR_RETURN(std::vector<p4::v1::StreamMessageResponse> messages,
                    session_->GetAllStreamMessagesFor(duration));
+  const pdpi::IrP4Info& ir_p4info = sai::GetIrP4Info(instantiation_);
   for (const auto& pi_response : messages) {
-    sai::StreamMessageResponse pd_response;
-    if (!pdpi::PiStreamMessageResponseToPd(sai::GetIrP4Info(instantiation_),
-                                           pi_response, &pd_response)
-             .ok()) {
-      LOG(ERROR) << "Failed to convert PI stream message response to PD.";
-      continue;
-    }
-    if (!pd_response.has_packet()) {
-      LOG(ERROR) << "PD response has no packet.";
-      continue;
-    }
-    std::string port_id = pd_response.packet().metadata().ingress_port();
-
-    auto port_name = interface_port_id_to_name_.find(port_id);
-    if (port_name == interface_port_id_to_name_.end()) {
-      LOG(WARNING) << port_id << " not found.";
-      continue;
-    }
+    std::optional<DecodedPacket> packet =
+        DecodePacket(ir_p4info, interface_port_id_to_name_, pi_response);
+    if (!packet.has_value()) continue;
     LOG_EVERY_N(INFO, 1000)
         << "Packet received (Count: " << google::COUNTER << ").";
-    callback(port_name->second, pd_response.packet().payload());
+    callback(packet->port_name, packet->payload);
   }
 
   return absl::OkStatus();
 }
 
+absl::Status PacketListener::HandlePacketsConcurrentlyFor(
+    absl::Duration duration, thinkit::PacketCallback callback) {
+  if (options_.max_queued_packets <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "max_queued_packets must be > 0, but got "
+           << options_.max_queued_packets;
+  }
+  const pdpi::IrP4Info& ir_p4info = sai::GetIrP4Info(instantiation_);
+  DecodePipeline pipeline(options_.max_queued_packets);
+
+  // Read for `duration`, in small steps so that reading stops on time.
+  constexpr int kMaxMessagesPerRead = 1000;
+  constexpr absl::Duration kMaxReadTimeout = absl::Milliseconds(50);
+  absl::Status read_status;
+  std::thread reader([&] {
+    const absl::Time deadline = absl::Now() + duration;
+    for (absl::Time now = absl::Now(); now < deadline; now = absl::Now()) {
+      absl::StatusOr<std::vector<p4::v1::StreamMessageResponse>> messages =
+          session_->GetNextStreamMessages(
+              kMaxMessagesPerRead, std::min(deadline - now, kMaxReadTimeout));
+      if (absl::IsDeadlineExceeded(messages.status())) continue;
+      if (!messages.ok()) {
+        read_status = messages.status();
+        break;
+      }
+      for (p4::v1::StreamMessageResponse& message : *messages) {
+        pipeline.Push(std::move(message));
+      }
+    }
+    pipeline.FinishPushing();
+  });
+  std::vector<std::thread> decoders;
+  decoders.reserve(options_.num_decode_threads);
+  for (int i = 0; i < options_.num_decode_threads; ++i) {
+    decoders.emplace_back(
+        [&] { pipeline.Decode(ir_p4info, interface_port_id_to_name_); });
+  }
+
+  int64_t num_delivered = 0;
+  for (std::optional<std::optional<DecodedPacket>> packet = pipeline.Next();
+       packet.has_value(); packet = pipeline.Next()) {
+    if (!packet->has_value()) continue;
+    if (++num_delivered % 1000 == 0) {
+      LOG(INFO) << "Packet received (Count: " << num_delivered << ").";
+    }
+    callback((*packet)->port_name, (*packet)->payload);
+  }
+  reader.join();
+  for (std::thread& decoder : decoders) decoder.join();
+
+  const int64_t num_dropped = pipeline.num_dropped();
+  if (num_dropped > 0) {
+    LOG(WARNING) << "Dropped " << num_dropped
+                 << " packets because decoding could not keep up.";
+  }
+  num_dropped_packets_ += num_dropped;
+  return read_status;
+}
+
 }  // namespace pins_test
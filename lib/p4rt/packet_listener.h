@@ -14,6 +14,7 @@
 #ifndef GOOGLE_LIB_P4RT_PACKET_LISTENER_H_
 #define GOOGLE_LIB_P4RT_PACKET_LISTENER_H_
 
+#include <cstdint>
 #include <functional>
 #include <string>
 
@@ -33,6 +34,20 @@
 
 namespace pins_test {
 
+struct PacketListenerOptions {
+  // If positive, received packets are decoded on this many threads while
+  // further packets are being read, instead of being read for the whole
+  // duration first and decoded one by one afterwards. Either way, the callback
+  // is called on the calling thread in order of arrival, and thus in order per
+  // port.
+  int num_decode_threads = 0;
+  // With decode threads, the most packets that may wait to be decoded, and the
+  // most decoded packets that may wait to be delivered to the callback. When
+  // more packets arrive than can wait to be decoded, the oldest waiting packet
+  // is dropped (see `num_dropped_packets`), so that reading never blocks.
+  int max_queued_packets = 10000;
+};
+
 // `PacketListener` will callback once a packet is received and stop listening
 // for packets when it goes out of scope.
 class PacketListener : public thinkit::PacketGenerationFinalizer {
@@ -44,11 +59,16 @@ class PacketListener : public thinkit::PacketGenerationFinalizer {
                  P4rtProgrammingContext context,
                  sai::Instantiation instantiation,
                  const absl::flat_hash_map<std::string, std::string>*
-                     interface_port_id_to_name);
+                     interface_port_id_to_name,
+                 PacketListenerOptions options = {});
 
   absl::Status HandlePacketsFor(absl::Duration duration,
                                 thinkit::PacketCallback callback_) override;
 
+  // The number of packets dropped so far because the decode threads could not
+  // keep up. Does not include drops by the session's own stream buffer.
+  int64_t num_dropped_packets() const { return num_dropped_packets_; }
+
   ~PacketListener() {
     absl::Status status = context_.Revert();
     if (!status.ok()) {
@@ -62,6 +82,12 @@ class PacketListener : public thinkit::PacketGenerationFinalizer {
   sai::Instantiation instantiation_;
   const absl::flat_hash_map<std::string, std::string>&
       interface_port_id_to_name_;
+  PacketListenerOptions options_;
+  int64_t num_dropped_packets_ = 0;
+
+  // Implements `HandlePacketsFor` with `options_.num_decode_threads` > 0.
+  absl::Status HandlePacketsConcurrentlyFor(absl::Duration duration,
+                                            thinkit::PacketCallback callback);
 };
 
 }  // namespace pins_test
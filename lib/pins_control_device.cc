@@ -17,6 +17,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -28,6 +29,7 @@
 #include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "diag/diag.grpc.pb.h"
@@ -91,6 +93,44 @@ absl::StatusOr<gnmi::SetRequest> BuildGnmiSetLinkStateRequest(
   }
 }
 
+// Hands the packets of a `PacketListener` to a callback from a background
+// thread until destroyed.
+class StreamingPacketListener : public thinkit::PacketGenerationFinalizer {
+ public:
+  StreamingPacketListener(std::unique_ptr<PacketListener> listener,
+                          thinkit::PacketCallback callback)
+      : listener_(std::move(listener)),
+        thread_([this, callback = std::move(callback)] {
+          // Listen in short steps so that destruction is not held up.
+          while (!stop_.HasBeenNotified()) {
+            absl::Status status =
+                listener_->HandlePacketsFor(kListenStep, callback);
+            if (!status.ok()) {
+              LOG(WARNING) << "Stopped streaming packets: " << status;
+              return;
+            }
+          }
+        }) {}
+
+  ~StreamingPacketListener() override {
+    stop_.Notify();
+    thread_.join();
+  }
+
+  absl::Status HandlePacketsFor(absl::Duration duration,
+                                thinkit::PacketCallback handler) override {
+    return absl::FailedPreconditionError(
+        "Packets are already being streamed to a callback.");
+  }
+
+ private:
+  static constexpr absl::Duration kListenStep = absl::Milliseconds(100);
+
+  std::unique_ptr<PacketListener> listener_;
+  absl::Notification stop_;
+  std::thread thread_;
+};
+
 }  // namespace
 
 PinsControlDevice::PinsControlDevice(
@@ -120,8 +160,8 @@ absl::StatusOr<PinsControlDevice> PinsControlDevice::Create(
                            std::move(interface_name_to_port_id));
 }
 
-absl::StatusOr<std::unique_ptr<thinkit::PacketGenerationFinalizer>>
-PinsControlDevice::CollectPackets() {
+absl::StatusOr<std::unique_ptr<PacketListener>>
+PinsControlDevice::StartPacketListener() {
   if (control_session_ == nullptr) {
     return absl::InternalError(
         "No P4RuntimeSession exists; Likely failed to establish another "
@@ -130,7 +170,7 @@ PinsControlDevice::CollectPackets() {
 
   // Program the punt all table entry through the context, which will remove
   // this flow once packet collection has finished.
-  P4rtProgrammingContext context(control_session_.get());
+  P4rtProgrammingContext context(control_session_.get(), ir_p4_info_);
   ASSIGN_OR_RETURN(
       p4::v1::WriteRequest punt_all_request,
       pdpi::PdWriteRequestToPi(
@@ -154,6 +194,19 @@ PinsControlDevice::CollectPackets() {
       sai::Instantiation::kMiddleblock, &interface_port_id_to_name_);
 }
 
+absl::StatusOr<std::unique_ptr<thinkit::PacketGenerationFinalizer>>
+PinsControlDevice::CollectPackets() {
+  return StartPacketListener();
+}
+
+absl::StatusOr<std::unique_ptr<thinkit::PacketGenerationFinalizer>>
+PinsControlDevice::StreamPackets(thinkit::PacketCallback callback) {
+  ASSIGN_OR_RETURN(std::unique_ptr<PacketListener> listener,
+                   StartPacketListener());
+  return std::make_unique<StreamingPacketListener>(std::move(listener),
+                                                   std::move(callback));
+}
+
 absl::Status PinsControlDevice::SendPacket(
     absl::string_view interface, absl::string_view packet,
     std::optional<absl::Duration> packet_delay) {
@@ -169,10 +222,38 @@ absl::Status PinsControlDevice::SendPacket(
 
 absl::Status PinsControlDevice::SendPackets(
     absl::string_view interface, absl::Span<const std::string> packets) {
-  for (absl::string_view packet : packets) {
-    RETURN_IF_ERROR(SendPacket(interface, packet, std::nullopt));
+  std::vector<thinkit::InterfacePacket> interface_packets;
+  interface_packets.reserve(packets.size());
+  for (const std::string& packet : packets) {
+    interface_packets.push_back({std::string(interface), packet});
   }
-  return absl::OkStatus();
+  return SendPacketBatch(interface_packets, thinkit::SendPacketBatchOptions());
+}
+
+absl::Status PinsControlDevice::SendPacketBatch(
+    absl::Span<const thinkit::InterfacePacket> packets,
+    const thinkit::SendPacketBatchOptions& options) {
+  if (control_session_ == nullptr) {
+    return absl::InternalError(
+        "No P4RuntimeSession exists; Likely failed to establish another "
+        "P4RuntimeSession.");
+  }
+  std::vector<gpins::EgressPacket> egress_packets;
+  egress_packets.reserve(packets.size());
+  for (const thinkit::InterfacePacket& packet : packets) {
+    auto port_id = interface_name_to_port_id_.find(packet.interface);
+    if (port_id == interface_name_to_port_id_.end()) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unknown control device interface: " << packet.interface;
+    }
+    egress_packets.push_back({port_id->second, packet.packet});
+  }
+  return gpins::InjectEgressPackets(
+      egress_packets, ir_p4_info_, control_session_.get(),
+      gpins::PacketInjectionOptions{
+          .packets_per_second = options.packets_per_second,
+          .max_batch_size = options.max_batch_size,
+      });
 }
 
 absl::Status PinsControlDevice::SetAdminLinkState(
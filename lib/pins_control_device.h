@@ -18,6 +18,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -29,6 +30,7 @@
 #include "diag/diag.grpc.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
 #include "diag/diag.pb.h"
+#include "lib/p4rt/packet_listener.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
@@ -66,6 +68,15 @@ class PinsControlDevice : public thinkit::ControlDevice {
   absl::Status SendPackets(absl::string_view interface,
                            absl::Span<const std::string> packets) override;
 
+  // Writes the PacketOuts in batches of buffered stream writes instead of
+  // one at a time.
+  absl::Status SendPacketBatch(
+      absl::Span<const thinkit::InterfacePacket> packets,
+      const thinkit::SendPacketBatchOptions& options) override;
+
+  absl::StatusOr<std::unique_ptr<thinkit::PacketGenerationFinalizer>>
+  StreamPackets(thinkit::PacketCallback callback) override;
+
   absl::Status SetAdminLinkState(absl::Span<const std::string> interfaces,
                                  thinkit::LinkState state) override;
 
@@ -99,6 +110,10 @@ class PinsControlDevice : public thinkit::ControlDevice {
       absl::Span<const std::string> interfaces) override;
 
  private:
+  // Punts every packet to the control session, and listens for them until the
+  // returned listener goes out of scope.
+  absl::StatusOr<std::unique_ptr<PacketListener>> StartPacketListener();
+
   std::unique_ptr<thinkit::Switch> sut_;
   pdpi::IrP4Info ir_p4_info_;
   std::unique_ptr<pdpi::P4RuntimeSession> control_session_;
@@ -0,0 +1,207 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lib/route_convergence.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "glog/logging.h"
+#include "gutil/status.h"
+#include "lib/ixia_helper.h"
+#include "lib/ixia_helper.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/p4_runtime_session.h"
+#include "thinkit/generic_testbed.h"
+
+namespace pins_test {
+namespace {
+
+// Flow statistics of all traffic items, as sampled at `time`.
+struct StatsSample {
+  absl::Time time;
+  ixia::TrafficStats stats;
+};
+
+}  // namespace
+
+std::optional<absl::Duration> ComputeConvergenceTime(
+    absl::Time send_time, absl::Time ack_time,
+    absl::Span<const FlowSample> samples, double min_delivery_ratio) {
+  for (int i = 1; i < samples.size(); ++i) {
+    const FlowSample& previous = samples[i - 1];
+    const FlowSample& current = samples[i];
+    // Traffic received before the write was sent took another path.
+    if (previous.time < send_time) continue;
+    const int64_t num_tx_frames =
+        current.num_tx_frames - previous.num_tx_frames;
+    const int64_t num_rx_frames =
+        current.num_rx_frames - previous.num_rx_frames;
+    if (num_tx_frames > 0 &&
+        num_rx_frames >= min_delivery_ratio * num_tx_frames) {
+      return current.time - ack_time;
+    }
+  }
+  return std::nullopt;
+}
+
+absl::Duration RouteConvergenceResult::Percentile(double percentile) const {
+  if (convergence_time_by_prefix.empty()) return absl::ZeroDuration();
+  std::vector<absl::Duration> times;
+  times.reserve(convergence_time_by_prefix.size());
+  for (const auto& [prefix, time] : convergence_time_by_prefix) {
+    times.push_back(time);
+  }
+  std::sort(times.begin(), times.end());
+  const int rank = std::clamp<int>(
+      std::ceil(percentile / 100 * times.size()), 1, times.size());
+  return times[rank - 1];
+}
+
+std::string RouteConvergenceResult::Summary() const {
+  return absl::StrFormat(
+      "converged=%d/%d p50=%s p90=%s p99=%s max=%s",
+      convergence_time_by_prefix.size(),
+      convergence_time_by_prefix.size() + unconverged_prefixes.size(),
+      absl::FormatDuration(Percentile(50)),
+      absl::FormatDuration(Percentile(90)),
+      absl::FormatDuration(Percentile(99)),
+      absl::FormatDuration(Percentile(100)));
+}
+
+absl::StatusOr<RouteConvergenceResult> MeasureRouteConvergence(
+    pdpi::P4RuntimeSession& session,
+    absl::Span<const p4::v1::WriteRequest> write_requests,
+    absl::Span<const RouteConvergenceFlow> flows, absl::string_view ixia_href,
+    thinkit::GenericTestbed& testbed, const RouteConvergenceOptions& options) {
+  for (const RouteConvergenceFlow& flow : flows) {
+    if (flow.write_request_index < 0 ||
+        flow.write_request_index >= write_requests.size()) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Flow for prefix '" << flow.prefix
+             << "' refers to write request " << flow.write_request_index
+             << ", but there are only " << write_requests.size();
+    }
+  }
+
+  // The view is looked up once, so that each sample takes a single request.
+  ASSIGN_OR_RETURN(thinkit::HttpResponse views,
+                   testbed.SendRestRequestToIxia(thinkit::RequestType::kGet,
+                                                 "/ixnetwork/statistics/view",
+                                                 /*payload=*/""));
+  ASSIGN_OR_RETURN(int flow_stats_view_index,
+                   ixia::FindIdByField(views, "caption", "Flow Statistics"));
+
+  absl::Mutex mutex;
+  bool done = false;  // Guarded by `mutex`.
+  // Only accessed by the sampling thread until it is joined.
+  absl::Status sampling_status;
+  std::vector<StatsSample> samples;
+  std::thread sampler([&] {
+    absl::Time next_sample_time = absl::Now();
+    while (true) {
+      {
+        absl::MutexLock lock(&mutex);
+        if (mutex.AwaitWithDeadline(absl::Condition(&done),
+                                    next_sample_time)) {
+          return;
+        }
+      }
+      const absl::Time start = absl::Now();
+      next_sample_time = start + options.sampling_interval;
+      absl::StatusOr<std::string> raw_stats =
+          ixia::GetRawStatsView(ixia_href, flow_stats_view_index, testbed);
+      const absl::Time end = absl::Now();
+      if (!raw_stats.ok()) {
+        sampling_status = raw_stats.status();
+        return;
+      }
+      absl::StatusOr<ixia::TrafficStats> stats =
+          ixia::ParseTrafficItemStats(*raw_stats);
+      // The view is briefly not ready while Ixia refreshes it.
+      if (absl::IsUnavailable(stats.status())) continue;
+      if (!stats.ok()) {
+        sampling_status = stats.status();
+        return;
+      }
+      // The statistics were taken somewhere during the request.
+      samples.push_back(
+          {.time = start + (end - start) / 2, .stats = *std::move(stats)});
+    }
+  });
+
+  RouteConvergenceResult result;
+  absl::Status write_status;
+  for (const p4::v1::WriteRequest& request : write_requests) {
+    result.send_times.push_back(absl::Now());
+    write_status = session.Write(request);
+    result.ack_times.push_back(absl::Now());
+    if (!write_status.ok()) break;
+  }
+  if (write_status.ok()) absl::SleepFor(options.max_convergence_time);
+  {
+    absl::MutexLock lock(&mutex);
+    done = true;
+  }
+  sampler.join();
+  RETURN_IF_ERROR(write_status)
+      << "in write request " << result.ack_times.size() << " of "
+      << write_requests.size();
+  RETURN_IF_ERROR(sampling_status)
+      << "while sampling the Ixia flow statistics";
+
+  result.num_samples = samples.size();
+  for (const RouteConvergenceFlow& flow : flows) {
+    std::vector<FlowSample> flow_samples;
+    flow_samples.reserve(samples.size());
+    for (const StatsSample& sample : samples) {
+      auto stats =
+          sample.stats.stats_by_traffic_item().find(flow.traffic_item_name);
+      if (stats == sample.stats.stats_by_traffic_item().end()) continue;
+      flow_samples.push_back({
+          .time = sample.time,
+          .num_tx_frames = stats->second.num_tx_frames(),
+          .num_rx_frames = stats->second.num_rx_frames(),
+      });
+    }
+    std::optional<absl::Duration> convergence_time = ComputeConvergenceTime(
+        result.send_times[flow.write_request_index],
+        result.ack_times[flow.write_request_index], flow_samples,
+        options.min_delivery_ratio);
+    if (convergence_time.has_value()) {
+      result.convergence_time_by_prefix[flow.prefix] = *convergence_time;
+    } else {
+      result.unconverged_prefixes.push_back(flow.prefix);
+    }
+  }
+  LOG(INFO) << "Route convergence over " << result.num_samples
+            << " samples: " << result.Summary();
+  return result;
+}
+
+}  // namespace pins_test
@@ -0,0 +1,114 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures route convergence: the time from the P4RT write acknowledging a
+// route change to traffic for the route arriving on its new path.
+//
+// Every measured prefix has an Ixia traffic item that sends traffic to the
+// prefix and receives it on the new path only. While the write requests are
+// sent, the Ixia flow statistics are sampled at a fixed interval. A flow has
+// converged at the end of the first sampling interval, after its write was
+// sent, in which Ixia received nearly all frames it sent.
+
+#ifndef PINS_LIB_ROUTE_CONVERGENCE_H_
+#define PINS_LIB_ROUTE_CONVERGENCE_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/p4_runtime_session.h"
+#include "thinkit/generic_testbed.h"
+
+namespace pins_test {
+
+// A route whose convergence is measured.
+struct RouteConvergenceFlow {
+  // The prefix of the route, as reported in the results.
+  std::string prefix;
+  // The name of the Ixia traffic item sending traffic to `prefix`, and
+  // receiving it on the new path of the route.
+  std::string traffic_item_name;
+  // The index of the write request that moves the route to its new path.
+  int write_request_index = 0;
+};
+
+struct RouteConvergenceOptions {
+  // How often the Ixia flow statistics are sampled. Convergence times are
+  // upper bounds, within the sampling interval plus the time to fetch the
+  // statistics.
+  absl::Duration sampling_interval = absl::Milliseconds(100);
+  // How long after the last write is acknowledged flows may take to converge.
+  absl::Duration max_convergence_time = absl::Seconds(10);
+  // The fraction of sent frames that must be received during an interval for
+  // the flow to count as converged.
+  double min_delivery_ratio = 0.99;
+};
+
+// The statistics of an Ixia flow at a point in time.
+struct FlowSample {
+  absl::Time time;
+  int64_t num_tx_frames = 0;
+  int64_t num_rx_frames = 0;
+};
+
+// Returns the time from `ack_time` to the end of the first interval between
+// consecutive `samples`, starting no earlier than `send_time`, in which at
+// least `min_delivery_ratio` of the sent frames were received. The result is
+// negative if traffic converged before the write was acknowledged. Returns
+// nullopt if the flow never converged. `samples` must be ordered by time.
+std::optional<absl::Duration> ComputeConvergenceTime(
+    absl::Time send_time, absl::Time ack_time,
+    absl::Span<const FlowSample> samples, double min_delivery_ratio);
+
+struct RouteConvergenceResult {
+  // Convergence time by prefix, for every flow that converged.
+  absl::btree_map<std::string, absl::Duration> convergence_time_by_prefix;
+  // The prefixes whose flows did not converge.
+  std::vector<std::string> unconverged_prefixes;
+  // When each write request was sent and acknowledged.
+  std::vector<absl::Time> send_times;
+  std::vector<absl::Time> ack_times;
+  int num_samples = 0;
+
+  // Returns the convergence time at `percentile` (i.e. [0, 100]) of the
+  // converged flows, using the nearest-rank method. Returns zero if no flow
+  // converged.
+  absl::Duration Percentile(double percentile) const;
+
+  // Returns a short human readable summary (e.g. count, p50, p99, and max).
+  std::string Summary() const;
+};
+
+// Sends `write_requests` on `session` one after the other, while sampling the
+// flow statistics of Ixia connected as `ixia_href` (see ixia::ConnectToIxia),
+// and returns the convergence time of every flow. Traffic must already be
+// running. Fails if a write request fails.
+absl::StatusOr<RouteConvergenceResult> MeasureRouteConvergence(
+    pdpi::P4RuntimeSession& session,
+    absl::Span<const p4::v1::WriteRequest> write_requests,
+    absl::Span<const RouteConvergenceFlow> flows, absl::string_view ixia_href,
+    thinkit::GenericTestbed& testbed,
+    const RouteConvergenceOptions& options = {});
+
+}  // namespace pins_test
+
+#endif  // PINS_LIB_ROUTE_CONVERGENCE_H_
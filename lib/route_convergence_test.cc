@@ -0,0 +1,104 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lib/route_convergence.h"
+
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace pins_test {
+namespace {
+
+using ::testing::Eq;
+using ::testing::HasSubstr;
+using ::testing::Optional;
+
+// Samples every 100ms from time 0, sending 100 frames per interval, and
+// receiving `num_rx_frames_per_interval[i]` in the i-th interval.
+std::vector<FlowSample> Samples(std::vector<int> num_rx_frames_per_interval) {
+  std::vector<FlowSample> samples = {{.time = absl::UnixEpoch()}};
+  for (int num_rx_frames : num_rx_frames_per_interval) {
+    const FlowSample& last = samples.back();
+    samples.push_back({
+        .time = last.time + absl::Milliseconds(100),
+        .num_tx_frames = last.num_tx_frames + 100,
+        .num_rx_frames = last.num_rx_frames + num_rx_frames,
+    });
+  }
+  return samples;
+}
+
+TEST(ComputeConvergenceTimeTest, IsMeasuredFromTheAck) {
+  // Converged in the interval ending at 400ms.
+  std::vector<FlowSample> samples = Samples({0, 0, 50, 100, 100});
+  EXPECT_THAT(ComputeConvergenceTime(
+                  /*send_time=*/absl::UnixEpoch(),
+                  /*ack_time=*/absl::UnixEpoch() + absl::Milliseconds(150),
+                  samples, /*min_delivery_ratio=*/0.99),
+              Optional(Eq(absl::Milliseconds(250))));
+  // Partial delivery counts with a lower ratio.
+  EXPECT_THAT(ComputeConvergenceTime(
+                  /*send_time=*/absl::UnixEpoch(),
+                  /*ack_time=*/absl::UnixEpoch() + absl::Milliseconds(150),
+                  samples, /*min_delivery_ratio=*/0.5),
+              Optional(Eq(absl::Milliseconds(150))));
+}
+
+TEST(ComputeConvergenceTimeTest, CanConvergeBeforeTheAck) {
+  EXPECT_THAT(ComputeConvergenceTime(
+                  /*send_time=*/absl::UnixEpoch(),
+                  /*ack_time=*/absl::UnixEpoch() + absl::Milliseconds(250),
+                  Samples({0, 100, 100}), /*min_delivery_ratio=*/0.99),
+              Optional(Eq(absl::Milliseconds(-50))));
+}
+
+TEST(ComputeConvergenceTimeTest, IgnoresTrafficBeforeTheWrite) {
+  EXPECT_THAT(ComputeConvergenceTime(
+                  /*send_time=*/absl::UnixEpoch() + absl::Milliseconds(150),
+                  /*ack_time=*/absl::UnixEpoch() + absl::Milliseconds(150),
+                  Samples({100, 100, 0, 100}), /*min_delivery_ratio=*/0.99),
+              Optional(Eq(absl::Milliseconds(250))));
+}
+
+TEST(ComputeConvergenceTimeTest, ReturnsNulloptIfNeverConverged) {
+  EXPECT_EQ(ComputeConvergenceTime(absl::UnixEpoch(), absl::UnixEpoch(),
+                                   Samples({0, 10, 90}),
+                                   /*min_delivery_ratio=*/0.99),
+            std::nullopt);
+  EXPECT_EQ(ComputeConvergenceTime(absl::UnixEpoch(), absl::UnixEpoch(), {},
+                                   /*min_delivery_ratio=*/0.99),
+            std::nullopt);
+}
+
+TEST(RouteConvergenceResultTest, PercentilesUseTheNearestRank) {
+  RouteConvergenceResult result;
+  EXPECT_EQ(result.Percentile(50), absl::ZeroDuration());
+  for (int i = 1; i <= 10; ++i) {
+    result.convergence_time_by_prefix[absl::StrCat("10.0.", i, ".0/24")] =
+        absl::Milliseconds(10 * i);
+  }
+  result.unconverged_prefixes.push_back("10.1.0.0/24");
+  EXPECT_EQ(result.Percentile(0), absl::Milliseconds(10));
+  EXPECT_EQ(result.Percentile(50), absl::Milliseconds(50));
+  EXPECT_EQ(result.Percentile(91), absl::Milliseconds(100));
+  EXPECT_EQ(result.Percentile(100), absl::Milliseconds(100));
+  EXPECT_THAT(result.Summary(), HasSubstr("converged=10/11"));
+}
+
+}  // namespace
+}  // namespace pins_test
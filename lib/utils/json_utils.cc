@@ -14,12 +14,16 @@
 
 #include "lib/utils/json_utils.h"
 
+#include <cstddef>
+#include <iterator>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -38,6 +42,10 @@ using StringSetMap =
     absl::flat_hash_map<std::string, absl::btree_set<std::string>>;
 using StringMap = absl::flat_hash_map<std::string, std::string>;
 
+// Receives the flattened path and the value of a leaf.
+using LeafVisitor =
+    absl::FunctionRef<void(absl::string_view path, std::string value)>;
+
 // Helper function to perform flattening recursively.
 //
 // A list data node in YANG is represented as an array in JSON. The YANG model
@@ -50,29 +58,34 @@ using StringMap = absl::flat_hash_map<std::string, std::string>;
 //  - path_without_keys contains the currently traversed JSON value without
 //    key/value pairs for array elements. This is used to look up key leaves.
 //    e. g. /outer_element/array_container/array_element/leaf
+//    Both paths are buffers shared by the whole traversal: each level appends
+//    its path element and truncates it again before returning.
 //  - yang_path_key_name_map contains a map of yang list paths to the name of
 //    the leaf that's defined as the key for that list (multiple keys are
 //    supported).
+//  - visit_leaf is called with the path and value of every leaf.
 //  - unknown_key_paths: If the key for a list is absent in
 //  'yang_path_key_name_map', then such paths are recorded in
 //  'unknown_key_paths'
-absl::Status FlattenJson(const absl::string_view path,
-                         const absl::string_view path_without_keys,
-                         const nlohmann::json& source,
+absl::Status FlattenJson(const nlohmann::json& source,
                          const StringSetMap& yang_path_key_name_map,
-                         StringMap& flattened_map,
+                         std::string& path, std::string& path_without_keys,
+                         LeafVisitor visit_leaf,
                          absl::btree_set<std::string>& unknown_key_paths) {
+  const size_t path_size = path.size();
+  const size_t path_without_keys_size = path_without_keys.size();
   switch (source.type()) {
     case nlohmann::json::value_t::object: {
       // Traverse recursively through all the members of the object type after
       // adding the path element to the path.
-      for (const auto& [name, value] : source.items()) {
-        const std::string member_path = absl::StrCat(path, "/", name);
-        const std::string member_path_without_keys =
-            absl::StrCat(path_without_keys, "/", name);
-        RETURN_IF_ERROR(FlattenJson(member_path, member_path_without_keys,
-                                    value, yang_path_key_name_map,
-                                    flattened_map, unknown_key_paths));
+      for (auto member = source.begin(); member != source.end(); ++member) {
+        absl::StrAppend(&path, "/", member.key());
+        absl::StrAppend(&path_without_keys, "/", member.key());
+        RETURN_IF_ERROR(FlattenJson(*member, yang_path_key_name_map, path,
+                                    path_without_keys, visit_leaf,
+                                    unknown_key_paths));
+        path.resize(path_size);
+        path_without_keys.resize(path_without_keys_size);
       }
       break;
     }
@@ -81,7 +94,7 @@ absl::Status FlattenJson(const absl::string_view path,
       // in the array.
       auto key_name_iter = yang_path_key_name_map.find(path_without_keys);
       if (key_name_iter == yang_path_key_name_map.end()) {
-        unknown_key_paths.insert(std::string(path_without_keys));
+        unknown_key_paths.insert(path_without_keys);
         return absl::OkStatus();
       }
       const absl::btree_set<std::string>& key_names = key_name_iter->second;
@@ -89,58 +102,61 @@ absl::Status FlattenJson(const absl::string_view path,
       // Find the value of the key leaf for each element in the array to
       // construct the path element.
       for (int i = 0; i < source.size(); ++i) {
-        std::string member_path = std::string(path);
-        std::string key_value;
+        const nlohmann::json& element = source[i];
         if (key_names.empty()) {
-          switch (source[i].type()) {
+          switch (element.type()) {
             case nlohmann::json::value_t::number_integer:
             case nlohmann::json::value_t::number_unsigned:
             case nlohmann::json::value_t::number_float:
             case nlohmann::json::value_t::string:
             case nlohmann::json::value_t::boolean:
-              key_value = GetSimpleJsonValueAsString(source[i]);
+              absl::StrAppend(&path, "['", GetSimpleJsonValueAsString(element),
+                              "']");
               break;
             default:
               return absl::InvalidArgumentError(absl::StrCat(
-                  "Invalid type '", source[i].type_name(),
-                  "' for array element (leaf list) ", i, " under path [", path,
+                  "Invalid type '", element.type_name(),
+                  "' for array element (leaf list) ", i, " under path [",
+                  absl::string_view(path).substr(0, path_size),
                   "]. Expected: integer, unsigned, float, string, bool."));
               break;
           }
-          member_path = absl::StrCat(path, "['", key_value, "']");
         }
         for (const auto& key_name : key_names) {
-          if (!source[i].contains(key_name)) {
+          auto key = element.find(key_name);
+          if (key == element.end()) {
             return absl::InvalidArgumentError(absl::StrCat(
                 "No key leaf '", key_name, "' found for array element ", i,
-                " under path: [", path, "]."));
+                " under path: [", absl::string_view(path).substr(0, path_size),
+                "]."));
           }
 
-          switch (source[i][key_name].type()) {
+          switch (key->type()) {
             case nlohmann::json::value_t::number_integer:
             case nlohmann::json::value_t::number_unsigned:
             case nlohmann::json::value_t::number_float:
             case nlohmann::json::value_t::string:
             case nlohmann::json::value_t::boolean:
-              key_value = GetSimpleJsonValueAsString(source[i][key_name]);
+              absl::StrAppend(&path, "[", key_name, "='",
+                              GetSimpleJsonValueAsString(*key), "']");
               break;
             default:
               // This is an error case. The key leaf must be a simple value.
               return absl::InvalidArgumentError(absl::StrCat(
-                  "Invalid type '", source[i][key_name].type_name(),
-                  "' for key leaf '", key_name, "' for array element ", i,
-                  " under path [", path,
+                  "Invalid type '", key->type_name(), "' for key leaf '",
+                  key_name, "' for array element ", i, " under path [",
+                  absl::string_view(path).substr(0, path_size),
                   "]. Expected: integer, unsigned, float, string, bool."));
               break;
           }
-          absl::StrAppend(&member_path, "[", key_name, "='", key_value, "']");
         }
 
         // Traverse each array element recursively after adding the path element
         // to the path.
-        RETURN_IF_ERROR(FlattenJson(member_path, path_without_keys, source[i],
-                                    yang_path_key_name_map, flattened_map,
+        RETURN_IF_ERROR(FlattenJson(element, yang_path_key_name_map, path,
+                                    path_without_keys, visit_leaf,
                                     unknown_key_paths));
+        path.resize(path_size);
       }
       break;
     }
@@ -149,7 +165,7 @@ absl::Status FlattenJson(const absl::string_view path,
     case nlohmann::json::value_t::number_float:
     case nlohmann::json::value_t::string:
     case nlohmann::json::value_t::boolean:
-      flattened_map[path] = GetSimpleJsonValueAsString(source);
+      visit_leaf(path, GetSimpleJsonValueAsString(source));
       break;
     case nlohmann::json::value_t::null:
       // No yang path.
@@ -162,6 +178,48 @@ absl::Status FlattenJson(const absl::string_view path,
   return absl::OkStatus();
 }
 
+// Flattens `root` like `FlattenJsonToMap`, but hands each leaf to `visit_leaf`
+// instead of materializing the map. Leaves are visited before an unknown key
+// path is reported as an error.
+absl::Status VisitFlattenedJson(const nlohmann::json& root,
+                                const StringSetMap& yang_path_key_name_map,
+                                bool ignore_unknown_key_paths,
+                                LeafVisitor visit_leaf) {
+  std::string path;
+  std::string path_without_keys;
+  absl::btree_set<std::string> unknown_key_paths;
+  RETURN_IF_ERROR(FlattenJson(root, yang_path_key_name_map, path,
+                              path_without_keys, visit_leaf,
+                              unknown_key_paths));
+  if (!unknown_key_paths.empty() && !ignore_unknown_key_paths) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("No key found in the map for the paths: \n",
+                     absl::StrJoin(unknown_key_paths, "\n")));
+  }
+  return absl::OkStatus();
+}
+
+// Checks that the leaf at `source_path` has `source_value` in `target_map`,
+// and adds a difference if not.
+bool IsLeafInTarget(absl::string_view source_path,
+                    absl::string_view source_value,
+                    const StringMap& target_map,
+                    std::vector<std::string>& differences) {
+  auto target_iter = target_map.find(source_path);
+  if (target_iter == target_map.end()) {
+    differences.push_back(absl::StrCat("Missing: [", source_path,
+                                       "] with value '", source_value, "'."));
+    return false;
+  }
+  if (source_value != target_iter->second) {
+    differences.push_back(absl::StrCat("Mismatch: [", source_path, "]: '",
+                                       source_value, "' != '",
+                                       target_iter->second, "'"));
+    return false;
+  }
+  return true;
+}
+
 }  // namespace
 
 absl::StatusOr<nlohmann::json> ParseJson(absl::string_view json_str) {
@@ -197,34 +255,10 @@ std::string FormatJsonBestEffort(absl::string_view raw_json) {
 
 nlohmann::json ReplaceNamesinJsonObject(
     const nlohmann::json& source, const StringMap& old_name_to_new_name_map) {
-  switch (source.type()) {
-    case nlohmann::json::value_t::object: {
-      nlohmann::json target(nlohmann::json::value_t::object);
-      for (const auto& [name, value] : source.items()) {
-        // Replace the path element if necessary.
-        auto name_iter = old_name_to_new_name_map.find(name);
-        const std::string new_name = name_iter == old_name_to_new_name_map.end()
-                                         ? name
-                                         : name_iter->second;
-        // Traverse through all the members recursively.
-        target[new_name] =
-            ReplaceNamesinJsonObject(value, old_name_to_new_name_map);
-      }
-      return target;
-    }
-    case nlohmann::json::value_t::array: {
-      nlohmann::json target(nlohmann::json::value_t::array);
-      for (int i = 0; i < source.size(); ++i) {
-        // Traverse through all array elements recursively.
-        target.push_back(
-            ReplaceNamesinJsonObject(source[i], old_name_to_new_name_map));
-      }
-      return target;
-    }
-    default:
-      // Leaf value or null. Nothing to replace.
-      return source;
-  }
+  // Copying once and renaming in place avoids rebuilding every object.
+  nlohmann::json target = source;
+  ReplaceNamesinJsonObject(old_name_to_new_name_map, target);
+  return target;
 }
 
 void ReplaceNamesinJsonObject(const StringMap& old_name_to_new_name_map,
@@ -232,26 +266,25 @@ void ReplaceNamesinJsonObject(const StringMap& old_name_to_new_name_map,
   switch (root.type()) {
     case nlohmann::json::value_t::object: {
       for (const auto& [old_name, new_name] : old_name_to_new_name_map) {
-        if (!root.contains(old_name)) continue;
-
-        // Create an empty JSON with the new name (erases any existing value).
-        root[new_name] = nlohmann::json(nlohmann::json::value_t::null);
-        // Swap with JSON values between the old and new names.
-        root[old_name].swap(root[new_name]);
-        // Erase the old name.
-        root.erase(old_name);
+        auto old_member = root.find(old_name);
+        if (old_member == root.end()) continue;
+
+        // Move the value to the new name (overwriting any existing value) and
+        // erase the old name.
+        nlohmann::json value = std::move(*old_member);
+        root.erase(old_member);
+        root[new_name] = std::move(value);
       }
-      for (auto& [_, value] : root.items()) {
+      for (nlohmann::json& value : root) {
         // Traverse through all the members recursively.
         ReplaceNamesinJsonObject(old_name_to_new_name_map, value);
       }
       break;
     }
     case nlohmann::json::value_t::array: {
-      nlohmann::json target(nlohmann::json::value_t::array);
-      for (int i = 0; i < root.size(); ++i) {
+      for (nlohmann::json& element : root) {
         // Traverse through all array elements recursively.
-        ReplaceNamesinJsonObject(old_name_to_new_name_map, root[i]);
+        ReplaceNamesinJsonObject(old_name_to_new_name_map, element);
       }
       break;
     }
@@ -265,14 +298,11 @@ absl::StatusOr<StringMap> FlattenJsonToMap(
     const nlohmann::json& root, const StringSetMap& yang_path_key_name_map,
     bool ignore_unknown_key_paths) {
   StringMap flattened_json;
-  absl::btree_set<std::string> unknown_key_paths;
-  RETURN_IF_ERROR(FlattenJson("", "", root, yang_path_key_name_map,
-                              flattened_json, unknown_key_paths));
-  if (!unknown_key_paths.empty() && !ignore_unknown_key_paths) {
-    return absl::InvalidArgumentError(
-        absl::StrCat("No key found in the map for the paths: \n",
-                     absl::StrJoin(unknown_key_paths, "\n")));
-  }
+  RETURN_IF_ERROR(VisitFlattenedJson(
+      root, yang_path_key_name_map, ignore_unknown_key_paths,
+      [&](absl::string_view path, std::string value) {
+        flattened_json[path] = std::move(value);
+      }));
   return flattened_json;
 }
 
@@ -281,17 +311,8 @@ bool IsJsonSubset(const StringMap& source_map, const StringMap& target_map,
   // Iterate over all the paths in source and compare to the paths in target.
   bool is_subset = true;
   for (const auto& [source_path, source_value] : source_map) {
-    auto target_iter = target_map.find(source_path);
-    if (target_iter == target_map.end()) {
-      differences.push_back(absl::StrCat("Missing: [", source_path,
-                                         "] with value '", source_value, "'."));
-      is_subset = false;
-    } else if (source_value != target_iter->second) {
-      differences.push_back(absl::StrCat("Mismatch: [", source_path, "]: '",
-                                         source_value, "' != '",
-                                         target_iter->second, "'"));
-      is_subset = false;
-    }
+    is_subset &=
+        IsLeafInTarget(source_path, source_value, target_map, differences);
   }
   return is_subset;
 }
@@ -300,59 +321,71 @@ absl::StatusOr<bool> IsJsonSubset(const nlohmann::json& source,
                                   const nlohmann::json& target,
                                   const StringSetMap& yang_path_key_name_map,
                                   std::vector<std::string>& differences) {
-  ASSIGN_OR_RETURN(auto flat_source,
-                   FlattenJsonToMap(source, yang_path_key_name_map,
-                                    /*ignore_unknown_key_paths=*/false));
   ASSIGN_OR_RETURN(auto flat_target,
                    FlattenJsonToMap(target, yang_path_key_name_map,
                                     /*ignore_unknown_key_paths=*/false));
-  return IsJsonSubset(flat_source, flat_target, differences);
+
+  // Compare the source leaves while traversing it rather than flattening it
+  // into a map first. Differences are only reported if the traversal succeeds.
+  bool is_subset = true;
+  std::vector<std::string> source_differences;
+  RETURN_IF_ERROR(VisitFlattenedJson(
+      source, yang_path_key_name_map, /*ignore_unknown_key_paths=*/false,
+      [&](absl::string_view path, std::string value) {
+        is_subset &=
+            IsLeafInTarget(path, value, flat_target, source_differences);
+      }));
+  differences.insert(differences.end(),
+                     std::make_move_iterator(source_differences.begin()),
+                     std::make_move_iterator(source_differences.end()));
+  return is_subset;
 }
 
 absl::StatusOr<bool> AreJsonEqual(const nlohmann::json& lhs,
                                   const nlohmann::json& rhs,
                                   const StringSetMap& yang_path_key_name_map,
                                   std::vector<std::string>& differences) {
-  // Create a flattened map of the lhs.
-  ASSIGN_OR_RETURN(const StringMap& flat_lhs,
-                   FlattenJsonToMap(lhs, yang_path_key_name_map,
-                                    /*ignore_unknown_key_paths=*/false));
-
   // Create a flattened map of the rhs.
   ASSIGN_OR_RETURN(const StringMap& flat_rhs,
                    FlattenJsonToMap(rhs, yang_path_key_name_map,
                                     /*ignore_unknown_key_paths=*/false));
 
-  // Create a union of the paths from both lhs and rhs.
-  absl::flat_hash_set<std::string> all_paths;
-  for (const auto& [path, _] : flat_lhs) all_paths.insert(path);
-  for (const auto& [path, _] : flat_rhs) all_paths.insert(path);
-
-  // Iterate over all the paths and compare to the paths in lhs and rhs.
+  // Compare the lhs leaves to the rhs while traversing the lhs, remembering
+  // the rhs paths that were seen. The views point into `flat_rhs`.
   bool are_equal = true;
-  for (const auto& path : all_paths) {
-    auto lhs_iter = flat_lhs.find(path);
-    auto rhs_iter = flat_rhs.find(path);
-
-    if (lhs_iter != flat_lhs.end() && rhs_iter != flat_rhs.end()) {
-      // The path exists in both. Compare the values.
-      if (lhs_iter->second != rhs_iter->second) {
-        differences.push_back(absl::StrCat("Mismatch: [", path, "]: '",
-                                           lhs_iter->second, "' != '",
-                                           rhs_iter->second, "'"));
-        are_equal = false;
-      }
-    } else if (rhs_iter == flat_rhs.end()) {
-      // Exists in lhs but not rhs.
-      differences.push_back(absl::StrCat(
-          "Missing rhs: [", path, "] with value '", lhs_iter->second, "'."));
-      are_equal = false;
-    } else {
-      // Exists in rhs but not lhs.
-      differences.push_back(absl::StrCat(
-          "Missing lhs: [", path, "] with value '", rhs_iter->second, "'."));
-      are_equal = false;
-    }
+  std::vector<std::string> lhs_differences;
+  absl::flat_hash_set<absl::string_view> lhs_paths_in_rhs;
+  RETURN_IF_ERROR(VisitFlattenedJson(
+      lhs, yang_path_key_name_map, /*ignore_unknown_key_paths=*/false,
+      [&](absl::string_view path, std::string value) {
+        auto rhs_iter = flat_rhs.find(path);
+        if (rhs_iter == flat_rhs.end()) {
+          // Exists in lhs but not rhs.
+          lhs_differences.push_back(absl::StrCat(
+              "Missing rhs: [", path, "] with value '", value, "'."));
+          are_equal = false;
+          return;
+        }
+        lhs_paths_in_rhs.insert(rhs_iter->first);
+        // The path exists in both. Compare the values.
+        if (value != rhs_iter->second) {
+          lhs_differences.push_back(absl::StrCat("Mismatch: [", path, "]: '",
+                                                 value, "' != '",
+                                                 rhs_iter->second, "'"));
+          are_equal = false;
+        }
+      }));
+  differences.insert(differences.end(),
+                     std::make_move_iterator(lhs_differences.begin()),
+                     std::make_move_iterator(lhs_differences.end()));
+
+  if (lhs_paths_in_rhs.size() == flat_rhs.size()) return are_equal;
+  for (const auto& [path, value] : flat_rhs) {
+    if (lhs_paths_in_rhs.contains(path)) continue;
+    // Exists in rhs but not lhs.
+    differences.push_back(
+        absl::StrCat("Missing lhs: [", path, "] with value '", value, "'."));
+    are_equal = false;
   }
   return are_equal;
 }
@@ -384,20 +417,39 @@ using ::Json::arrayValue;
 using ::Json::objectValue;
 using ::Json::Value;
 
-}  // namespace
+// Helper for `JsonReplaceKey` that converts the keys only once.
+void ReplaceKey(Value& source, const std::string& old_key,
+                const std::string& new_key) {
+  switch (source.type()) {
+    case arrayValue:
+    case objectValue: {
+      Value value;
+      if (source.isObject() && source.removeMember(old_key, &value)) {
+        source[new_key] = std::move(value);
+      }
+      for (Value& member : source) {
+        // recursive call to replace keys in members
+        ReplaceKey(member, old_key, new_key);
+      }
+      break;
+    }
 
-bool JsonDiff(const Value& source, const Value& target, Value& diff) {
-  // If values are the same, return empty diff.
-  if (source == target) {
-    return false;
+    default:
+      break;
   }
+}
 
+}  // namespace
+
+bool JsonDiff(const Value& source, const Value& target, Value& diff) {
   if (source.type() != target.type()) {
     // Different types: replace value.
     diff = source;
     return true;
   } else {
-    // Do a deep comparison of array/object members.
+    // Do a deep comparison of array/object members. Equal subtrees produce no
+    // diff, so only leaves need to be compared as a whole; comparing every
+    // subtree up front would revisit each leaf once per ancestor.
     switch (source.type()) {
       case arrayValue: {
         bool diff_detected = false;
@@ -409,7 +461,7 @@ bool JsonDiff(const Value& source, const Value& target, Value& diff) {
           // Recursive call to compare array values at index i.
           if (JsonDiff(source[i], target[i], diff_at_index)) {
             if (!diff_at_index.isNull()) {
-              diff[diff.size()] = diff_at_index;
+              diff.append(std::move(diff_at_index));
               diff_detected = true;
             }
           }
@@ -420,7 +472,7 @@ bool JsonDiff(const Value& source, const Value& target, Value& diff) {
         for (uint i = traverse_size; i < source.size(); ++i) {
           // Add operations in reverse order to avoid invalid
           // indices.
-          diff[diff.size()] = source[i];
+          diff.append(source[i]);
           diff_detected = true;
         }
         return diff_detected;
@@ -429,12 +481,13 @@ bool JsonDiff(const Value& source, const Value& target, Value& diff) {
       case objectValue: {
         bool diff_detected = false;
         // Traverse this object's elements.
-        for (const auto& name : source.getMemberNames()) {
+        for (auto member = source.begin(); member != source.end(); ++member) {
+          const std::string name = member.name();
           // Recursive call to compare object values with key 'name'.
           Value diff_at_key;
-          if (JsonDiff(source[name], target[name], diff_at_key)) {
+          if (JsonDiff(*member, target[name], diff_at_key)) {
             if (!diff_at_key.isNull()) {
-              diff[name] = diff_at_key;
+              diff[name] = std::move(diff_at_key);
               diff_detected = true;
             }
           }
@@ -443,6 +496,8 @@ bool JsonDiff(const Value& source, const Value& target, Value& diff) {
       }
 
       default:
+        // If values are the same, return empty diff.
+        if (source == target) return false;
         diff = source;
         return true;
     }
@@ -454,32 +509,7 @@ void JsonReplaceKey(Value& source, const absl::string_view old_key,
   if (old_key == new_key) {
     return;
   }
-
-  switch (source.type()) {
-    case arrayValue: {
-      for (auto& s : source) {
-        // recursive call to replace key
-        JsonReplaceKey(s, old_key, new_key);
-      }
-      break;
-    }
-
-    case objectValue: {
-      if (source.isMember(std::string(old_key))) {
-        source[std::string(new_key).c_str()] =
-            source[std::string(old_key).c_str()];
-        source.removeMember(std::string(old_key).c_str());
-      }
-      for (const auto& name : source.getMemberNames()) {
-        // recursive call to replace keys in members
-        JsonReplaceKey(source[name], old_key, new_key);
-      }
-      break;
-    }
-
-    default:
-      break;
-  }
+  ReplaceKey(source, std::string(old_key), std::string(new_key));
 }
 
 bool JsonIsSubset(const Value& source, const Value& target,
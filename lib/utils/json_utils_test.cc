@@ -1532,6 +1532,29 @@ TEST(IsJsonSubset, TestBadTarget) {
   EXPECT_TRUE(differences.empty());
 }
 
+TEST(IsJsonSubset, TestNoDifferencesOnUnknownKeyInSource) {
+  // The mismatching leaf is traversed before the list without a known key.
+  constexpr char kSourceJson[] = R"({
+    "outer_element": {
+      "leaf" : "value1",
+      "unknown_list" : [ { "leaf" : "value" } ]
+    }
+  })";
+  constexpr char kTargetJson[] = R"({
+    "outer_element": {
+      "leaf" : "value2"
+    }
+  })";
+  ASSERT_OK_AND_ASSIGN(nlohmann::json source, ParseJson(kSourceJson));
+  ASSERT_OK_AND_ASSIGN(nlohmann::json target, ParseJson(kTargetJson));
+
+  std::vector<std::string> differences;
+  EXPECT_THAT(IsJsonSubset(source, target, *kPathKeyNameMap, differences),
+              gutil::StatusIs(absl::StatusCode::kInvalidArgument,
+                              testing::HasSubstr("unknown_list")));
+  EXPECT_TRUE(differences.empty());
+}
+
 TEST(IsJsonSubset, TestBothEmpty) {
   ASSERT_OK_AND_ASSIGN(nlohmann::json source, ParseJson(""));
   ASSERT_OK_AND_ASSIGN(nlohmann::json target, ParseJson(""));
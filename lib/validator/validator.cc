@@ -14,10 +14,11 @@
 
 #include "lib/validator/validator.h"
 
-#include <functional>
-#include <iterator>
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT: third_party code.
 #include <utility>
 #include <vector>
 
@@ -26,52 +27,110 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "glog/logging.h"
 #include "lib/validator/validator_backend.h"
 
 namespace pins_test {
 
-Validator::Validator(std::vector<std::unique_ptr<ValidatorBackend>> backends)
-    : backends_(std::move(backends)) {
+std::string ValidationTimingReport(
+    absl::Span<const DeviceValidationResult> results) {
+  std::vector<const DeviceValidationResult*> slowest_first;
+  slowest_first.reserve(results.size());
+  for (const DeviceValidationResult& result : results) {
+    slowest_first.push_back(&result);
+  }
+  absl::c_stable_sort(slowest_first, [](const DeviceValidationResult* lhs,
+                                        const DeviceValidationResult* rhs) {
+    return lhs->duration > rhs->duration;
+  });
+
+  std::string report = "Validation time per device:";
+  for (const DeviceValidationResult* result : slowest_first) {
+    absl::StrAppend(&report, "\n  ", result->device, ": ",
+                    absl::FormatDuration(result->duration),
+                    result->status.ok() ? " (passed)" : " (failed)");
+  }
+  return report;
+}
+
+Validator::Validator(std::vector<std::unique_ptr<ValidatorBackend>> backends,
+                     ValidatorOptions options)
+    : backends_(std::move(backends)), options_(options) {
   for (const auto& backend : backends_) {
     backend->SetupValidations();
   }
 }
 
-absl::Status Validator::RunValidations(
+DeviceValidationResult Validator::ValidateDevice(
+    absl::string_view device, absl::Span<const absl::string_view> validations,
+    int retry_count, absl::Duration timeout) {
+  const absl::Time start = absl::Now();
+  std::vector<std::string> validation_messages;
+  bool any_validation_passed = false;
+  for (const auto& backend : backends_) {
+    absl::Status status =
+        backend->RunValidations(device, validations, retry_count, timeout);
+    if (status.ok()) {
+      any_validation_passed = true;
+    } else if (status.code() != absl::StatusCode::kNotFound) {
+      validation_messages.push_back(
+          absl::StrCat(device, " failed with: ", status.message()));
+      // The remaining backends depend on the checks that just failed.
+      break;
+    }
+  }
+  // If all statuses failed but there are no messages, then all statuses were
+  // NOT_FOUND.
+  if (!any_validation_passed && validation_messages.empty()) {
+    validation_messages.push_back(
+        absl::StrCat("No backends ran any validations on ", device));
+  }
+  return DeviceValidationResult{
+      .device = std::string(device),
+      .status = validation_messages.empty()
+                    ? absl::OkStatus()
+                    : absl::InternalError(
+                          absl::StrJoin(validation_messages, "; ")),
+      .duration = absl::Now() - start,
+  };
+}
+
+std::vector<DeviceValidationResult> Validator::RunValidationsPerDevice(
     absl::Span<const absl::string_view> devices,
     absl::Span<const absl::string_view> validations, int retry_count,
     absl::Duration timeout) {
-  std::vector<std::string> messages;
-  auto validate_device = [&](absl::string_view device, const auto& backend) {
-    return backend->RunValidations(device, validations, retry_count, timeout);
+  std::vector<DeviceValidationResult> results(devices.size());
+  // Each thread claims the next device until none are left.
+  std::atomic<int> next_device = 0;
+  auto validate_devices = [&] {
+    for (int i = next_device++; i < static_cast<int>(devices.size());
+         i = next_device++) {
+      results[i] = ValidateDevice(devices[i], validations, retry_count, timeout);
+    }
   };
+  const int num_threads = std::min(std::max(options_.max_concurrent_devices, 1),
+                                   static_cast<int>(devices.size()));
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) threads.emplace_back(validate_devices);
+  validate_devices();
+  for (std::thread& thread : threads) thread.join();
+  return results;
+}
 
-  for (const auto& device : devices) {
-    std::vector<absl::Status> validation_statuses;
-    std::vector<std::string> validation_messages;
-    absl::c_transform(
-        backends_, std::back_inserter(validation_statuses),
-        [&](const auto& backend) { return validate_device(device, backend); });
-
-    absl::c_for_each(validation_statuses, [&](const absl::Status& status) {
-      if (!status.ok() && status.code() != absl::StatusCode::kNotFound) {
-        validation_messages.push_back(
-            absl::StrCat(device, " failed with: ", status.message()));
-      }
-    });
+absl::Status Validator::RunValidations(
+    absl::Span<const absl::string_view> devices,
+    absl::Span<const absl::string_view> validations, int retry_count,
+    absl::Duration timeout) {
+  std::vector<DeviceValidationResult> results =
+      RunValidationsPerDevice(devices, validations, retry_count, timeout);
+  LOG(INFO) << ValidationTimingReport(results);
 
-    bool any_validation_passed =
-        absl::c_any_of(validation_statuses, std::mem_fn(&absl::Status::ok));
-    // If all statuses failed but there are no messages, then all statuses were
-    // NOT_FOUND.
-    if (!any_validation_passed && validation_messages.empty()) {
-      validation_messages.push_back(
-          absl::StrCat("No backends ran any validations on ", device));
-    }
-    messages.insert(messages.begin(), validation_messages.begin(),
-                    validation_messages.end());
+  std::vector<absl::string_view> messages;
+  for (const DeviceValidationResult& result : results) {
+    if (!result.status.ok()) messages.push_back(result.status.message());
   }
   if (!messages.empty()) {
     return absl::InternalError(absl::StrJoin(messages, "; "));
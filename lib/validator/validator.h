@@ -16,6 +16,7 @@
 #define PINS_LIB_VALIDATOR_VALIDATOR_H_
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "absl/status/status.h"
@@ -26,6 +27,25 @@
 
 namespace pins_test {
 
+struct ValidatorOptions {
+  // The maximum number of devices that are validated concurrently. Backends
+  // must support running validations on different devices concurrently.
+  int max_concurrent_devices = 16;
+};
+
+// The outcome of validating a single device.
+struct DeviceValidationResult {
+  std::string device;
+  // OK if the device passed, or an error combining the backend failures.
+  absl::Status status;
+  // The time all backends took on the device.
+  absl::Duration duration;
+};
+
+// Returns a report of the time each device took, slowest first.
+std::string ValidationTimingReport(
+    absl::Span<const DeviceValidationResult> results);
+
 // `Validator` provides a backend-agnostic class for tests to run certain
 // validation routines on arbitrary devices. This allows tests to properly check
 // the status of those devices, even if the devices themselves have proprietary
@@ -43,21 +63,41 @@ class Validator {
 
   // Initializes the 'Validator' with the provided 'backends'. Calls
   // 'SetupValidations' on every backend.
-  Validator(std::vector<std::unique_ptr<ValidatorBackend>> backends);
+  //
+  // The backends run on each device in the given order, and the first backend
+  // that fails on a device skips the remaining ones for it, so basic checks
+  // (e.g. pinging) should come before the checks that depend on them (e.g.
+  // gNMI), which would otherwise only fail after all their retries.
+  Validator(std::vector<std::unique_ptr<ValidatorBackend>> backends,
+            ValidatorOptions options = {});
 
   // Runs the provided `validations` on the provided reachable addresses of the
   // `devices`. The provided `retry_count` option refers to how many times a
   // specific validation will have to fail before being considered a failure.
   // The provided `timeout` option refers to how long each try should take
-  // before timing out.
+  // before timing out. Devices are validated concurrently, and the time each
+  // device took is logged.
   absl::Status RunValidations(absl::Span<const absl::string_view> devices,
                               absl::Span<const absl::string_view> validations,
                               int retry_count = 3,
                               absl::Duration timeout = absl::Minutes(5));
 
+  // Like `RunValidations`, but returns the result of every device, in the
+  // order of `devices`.
+  std::vector<DeviceValidationResult> RunValidationsPerDevice(
+      absl::Span<const absl::string_view> devices,
+      absl::Span<const absl::string_view> validations, int retry_count = 3,
+      absl::Duration timeout = absl::Minutes(5));
+
  private:
+  // Runs the backends on a single device.
+  DeviceValidationResult ValidateDevice(
+      absl::string_view device, absl::Span<const absl::string_view> validations,
+      int retry_count, absl::Duration timeout);
+
   // The provided backends that this `Validator` will use.
   std::vector<std::unique_ptr<ValidatorBackend>> backends_;
+  ValidatorOptions options_;
 };
 
 }  // namespace pins_test
@@ -16,11 +16,13 @@
 
 #include <stdio.h>
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/random/random.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
@@ -28,6 +30,7 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
@@ -283,4 +286,36 @@ absl::Status OnFailure(absl::Status status,
   return status;
 }
 
+void ConditionWakeup::Notify() {
+  absl::MutexLock lock(&mu_);
+  notified_ = true;
+}
+
+bool ConditionWakeup::WaitForNotification(absl::Duration timeout) {
+  absl::MutexLock lock(&mu_);
+  bool notified = mu_.AwaitWithTimeout(absl::Condition(&notified_), timeout);
+  notified_ = false;
+  return notified;
+}
+
+namespace internal {
+
+void RetryBackoff::Wait(absl::Time deadline) {
+  absl::Duration delay = next_delay_;
+  if (options_.jitter > 0) {
+    delay *= absl::Uniform(bitgen_, 1 - options_.jitter, 1 + options_.jitter);
+  }
+  delay = std::min(delay, deadline - absl::Now());
+  next_delay_ = std::min(next_delay_ * options_.backoff_multiplier,
+                         options_.max_backoff);
+  if (delay <= absl::ZeroDuration()) return;
+  if (options_.wakeup != nullptr) {
+    options_.wakeup->WaitForNotification(delay);
+  } else {
+    absl::SleepFor(delay);
+  }
+}
+
+}  // namespace internal
+
 }  // namespace pins_test
@@ -15,17 +15,22 @@
 #ifndef PINS_LIB_VALIDATOR_VALIDATOR_LIB_H_
 #define PINS_LIB_VALIDATOR_VALIDATOR_LIB_H_
 
+#include <array>
 #include <cstdint>
 #include <functional>
-#include <list>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/random/random.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "absl/types/span.h"
@@ -124,9 +129,62 @@ absl::Status SwitchReadyWithSsh(thinkit::Switch& thinkit_switch,
 absl::Status OnFailure(absl::Status status,
                        const std::function<void()>& on_failure);
 
+// Wakes up `WaitForCondition` calls that are waiting between tries, e.g. from
+// a gNMI subscription or another event source when the watched state changes,
+// so that the condition is checked right away instead of after its backoff.
+//
+// Thread-safe.
+class ConditionWakeup {
+ public:
+  // Ends the current delay of a wait using this wakeup, or the next one if
+  // none is waiting.
+  void Notify() ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Blocks until `Notify` is called or `timeout` expires, and consumes the
+  // notification. Returns true if notified.
+  bool WaitForNotification(absl::Duration timeout) ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  absl::Mutex mu_;
+  bool notified_ ABSL_GUARDED_BY(mu_) = false;
+};
+
+struct WaitForConditionOptions {
+  // The delay after the first failed try. Every further failure multiplies the
+  // delay by `backoff_multiplier`, up to `max_backoff`.
+  absl::Duration initial_backoff = absl::Milliseconds(1);
+  double backoff_multiplier = 2;
+  absl::Duration max_backoff = absl::Seconds(1);
+  // Every delay is scaled by a random factor in [1 - jitter, 1 + jitter], so
+  // that concurrent waits do not hit the switch in lockstep.
+  double jitter = 0.2;
+  // If set, ends delays early when notified. Must outlive the wait.
+  ConditionWakeup* wakeup = nullptr;
+};
+
+namespace internal {
+
+// The delays between the tries of a `WaitForCondition`.
+class RetryBackoff {
+ public:
+  explicit RetryBackoff(const WaitForConditionOptions& options)
+      : options_(options), next_delay_(options.initial_backoff) {}
+
+  // Waits for the next delay, but no later than `deadline`.
+  void Wait(absl::Time deadline);
+
+ private:
+  const WaitForConditionOptions& options_;
+  absl::Duration next_delay_;
+  absl::BitGen bitgen_;
+};
+
+}  // namespace internal
+
 // Waits for the expected condition to return success. The condition will be
 // checked until either the timeout is expired (in which case an error status is
-// returned) or the condition returns ok.
+// returned) or the condition returns ok. Failed tries are followed by an
+// exponentially growing delay, see `WaitForConditionOptions`.
 //
 // Examples:
 //   std::vector<std::string> interfaces = ...;
@@ -134,15 +192,17 @@ absl::Status OnFailure(absl::Status status,
 //
 //   ASSERT_OK(WaitForCondition(P4rtAble, absl::Seconds(10)));
 template <typename Func, typename... Args>
-absl::Status WaitForCondition(Func&& condition, absl::Duration timeout,
+absl::Status WaitForCondition(const WaitForConditionOptions& options,
+                              Func&& condition, absl::Duration timeout,
                               Args&&... args) {
   absl::Time deadline = absl::Now() + timeout;
   constexpr int kMaxResults = 2;
   absl::Status final_status = absl::OkStatus();
   uint64_t number_of_function_invocations = 0;
-  std::list<std::string> latest_results;
-  do {
-    number_of_function_invocations++;
+  // The latest results in a ring, only formatted if the wait fails.
+  std::array<std::pair<absl::Time, absl::Status>, kMaxResults> latest_results;
+  internal::RetryBackoff backoff(options);
+  while (true) {
     if constexpr (std::is_invocable_r_v<absl::Status, Func, Args...,
                                         absl::Duration>) {
       final_status = condition(std::forward<Args>(args)...,
@@ -150,17 +210,36 @@ absl::Status WaitForCondition(Func&& condition, absl::Duration timeout,
     } else {
       final_status = condition(std::forward<Args>(args)...);
     }
-    latest_results.push_back(absl::StrCat(absl::FormatTime(absl::Now()), ": ",
-                                          final_status.message()));
-    if (latest_results.size() > kMaxResults) latest_results.pop_front();
-  } while (!final_status.ok() && absl::Now() < deadline);
+    latest_results[number_of_function_invocations++ % kMaxResults] = {
+        absl::Now(), final_status};
+    if (final_status.ok() || absl::Now() >= deadline) break;
+    backoff.Wait(deadline);
+    if (absl::Now() >= deadline) break;
+  }
   if (final_status.ok()) return final_status;
 
+  std::vector<std::string> results;
+  for (uint64_t i = number_of_function_invocations > kMaxResults
+                        ? number_of_function_invocations - kMaxResults
+                        : 0;
+       i < number_of_function_invocations; ++i) {
+    const auto& [time, status] = latest_results[i % kMaxResults];
+    results.push_back(
+        absl::StrCat(absl::FormatTime(time), ": ", status.message()));
+  }
   return absl::DeadlineExceededError(absl::StrCat(
       "Failed to reach the requested condition after ",
       absl::FormatDuration(timeout), " with ", number_of_function_invocations,
       " function invocations. Latest results:\n",
-      absl::StrJoin(latest_results, "\n")));
+      absl::StrJoin(results, "\n")));
+}
+
+template <typename Func, typename... Args>
+absl::Status WaitForCondition(Func&& condition, absl::Duration timeout,
+                              Args&&... args) {
+  return WaitForCondition(WaitForConditionOptions(),
+                          std::forward<Func>(condition), timeout,
+                          std::forward<Args>(args)...);
 }
 
 // Waits for the expected condition to return an error. The inverse of
@@ -327,6 +327,50 @@ TEST(WaitForConditionTest, ReturnsMoreUsefulMessageAfterTimeout) {
                               testing::HasSubstr("A Useful Message")));
 }
 
+TEST(WaitForConditionTest, BacksOffBetweenTries) {
+  int call_count = 0;
+  auto fail = [&call_count] {
+    ++call_count;
+    return absl::InternalError("Failed");
+  };
+  // Tries at roughly 0, 10, 30 and 70 milliseconds.
+  EXPECT_FALSE(WaitForCondition({.initial_backoff = absl::Milliseconds(10),
+                                 .backoff_multiplier = 2,
+                                 .jitter = 0},
+                                fail, absl::Milliseconds(100))
+                   .ok());
+  EXPECT_GE(call_count, 3);
+  EXPECT_LE(call_count, 5);
+}
+
+TEST(WaitForConditionTest, WakeupEndsBackoffEarly) {
+  ConditionWakeup wakeup;
+  int call_count = 0;
+  auto succeed_on_second_try = [&] {
+    if (++call_count >= 2) return absl::OkStatus();
+    // The backoff after this try is cut short by the notification.
+    wakeup.Notify();
+    return absl::InternalError("Failed");
+  };
+  absl::Time start = absl::Now();
+  EXPECT_OK(WaitForCondition({.initial_backoff = absl::Minutes(1),
+                              .max_backoff = absl::Minutes(1),
+                              .wakeup = &wakeup},
+                             succeed_on_second_try, absl::Minutes(5)));
+  EXPECT_EQ(call_count, 2);
+  EXPECT_LT(absl::Now() - start, absl::Minutes(1));
+}
+
+TEST(WaitForConditionTest, BackoffDoesNotExceedDeadline) {
+  auto fail = [] { return absl::InternalError("Failed"); };
+  absl::Time start = absl::Now();
+  EXPECT_THAT(WaitForCondition({.initial_backoff = absl::Minutes(1)}, fail,
+                               absl::Milliseconds(10)),
+              gutil::StatusIs(absl::StatusCode::kDeadlineExceeded,
+                              testing::HasSubstr("1 function invocations")));
+  EXPECT_LT(absl::Now() - start, absl::Minutes(1));
+}
+
 TEST(OnFailureTest, DoesntRunOnSuccess) {
   MockFunction<void()> mock_function;
   EXPECT_CALL(mock_function, Call()).Times(0);
@@ -0,0 +1,126 @@
+// Copyright (c) 2024, Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "lib/validator/validator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "lib/validator/validator_backend.h"
+
+namespace pins_test {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::AllOf;
+using ::testing::HasSubstr;
+
+constexpr char kDeviceOne[] = "device_one";
+constexpr char kDeviceTwo[] = "device_two";
+constexpr char kReady[] = "Ready";
+
+// Runs a single callback for `kReady` on the given devices.
+class FakeBackend : public ValidatorBackend {
+ public:
+  FakeBackend(absl::flat_hash_set<std::string> devices, Callback callback)
+      : ValidatorBackend(std::move(devices)), callback_(std::move(callback)) {}
+
+  void SetupValidations() override {
+    AddCallbacksToValidation(kReady, {callback_});
+  }
+
+ private:
+  Callback callback_;
+};
+
+TEST(ValidatorTest, ValidatesDevicesConcurrently) {
+  std::atomic<int> in_flight = 0;
+  std::atomic<int> max_in_flight = 0;
+  std::vector<std::unique_ptr<ValidatorBackend>> backends;
+  backends.push_back(std::make_unique<FakeBackend>(
+      absl::flat_hash_set<std::string>{kDeviceOne, kDeviceTwo},
+      [&](absl::string_view, absl::Duration) {
+        int current = ++in_flight;
+        int max = max_in_flight;
+        while (current > max &&
+               !max_in_flight.compare_exchange_weak(max, current)) {
+        }
+        absl::SleepFor(absl::Milliseconds(100));
+        --in_flight;
+        return absl::OkStatus();
+      }));
+  Validator validator(std::move(backends), {.max_concurrent_devices = 2});
+
+  EXPECT_OK(validator.RunValidations({kDeviceOne, kDeviceTwo}, {kReady}));
+  EXPECT_EQ(max_in_flight, 2);
+}
+
+TEST(ValidatorTest, SkipsLaterBackendsAfterFailure) {
+  int later_backend_calls = 0;
+  std::vector<std::unique_ptr<ValidatorBackend>> backends;
+  backends.push_back(std::make_unique<FakeBackend>(
+      absl::flat_hash_set<std::string>{kDeviceOne},
+      [](absl::string_view, absl::Duration) {
+        return absl::UnavailableError("not pingable");
+      }));
+  backends.push_back(std::make_unique<FakeBackend>(
+      absl::flat_hash_set<std::string>{kDeviceOne},
+      [&](absl::string_view, absl::Duration) {
+        ++later_backend_calls;
+        return absl::OkStatus();
+      }));
+  Validator validator(std::move(backends));
+
+  EXPECT_THAT(validator.RunValidations({kDeviceOne}, {kReady},
+                                       /*retry_count=*/0),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("device_one failed with")));
+  EXPECT_EQ(later_backend_calls, 0);
+}
+
+TEST(ValidatorTest, ReturnsResultPerDevice) {
+  std::vector<std::unique_ptr<ValidatorBackend>> backends;
+  backends.push_back(std::make_unique<FakeBackend>(
+      absl::flat_hash_set<std::string>{kDeviceOne},
+      [](absl::string_view, absl::Duration) { return absl::OkStatus(); }));
+  Validator validator(std::move(backends));
+
+  std::vector<DeviceValidationResult> results =
+      validator.RunValidationsPerDevice({kDeviceOne, kDeviceTwo}, {kReady});
+  ASSERT_EQ(results.size(), 2);
+  EXPECT_EQ(results[0].device, kDeviceOne);
+  EXPECT_OK(results[0].status);
+  EXPECT_EQ(results[1].device, kDeviceTwo);
+  EXPECT_THAT(results[1].status,
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("No backends ran any validations")));
+  EXPECT_THAT(ValidationTimingReport(results),
+              AllOf(HasSubstr("device_one: "), HasSubstr("(passed)"),
+                    HasSubstr("device_two: "), HasSubstr("(failed)")));
+}
+
+}  // namespace
+}  // namespace pins_test
@@ -0,0 +1,236 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_fuzzer/bulk_state.h"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/random/random.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/fuzz_util.h"
+#include "p4_fuzzer/switch_state.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/p4_runtime_session.h"
+
+namespace p4_fuzzer {
+namespace {
+
+using ::p4::v1::FieldMatch;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+
+// Returns the tables of `ir_p4_info` such that every table comes after all the
+// tables its entries can refer to.
+std::vector<const pdpi::IrTableDefinition*> TablesInDependencyOrder(
+    const pdpi::IrP4Info& ir_p4_info) {
+  std::vector<const pdpi::IrTableDefinition*> tables;
+  for (const auto& [id, table] : ir_p4_info.tables_by_id()) {
+    tables.push_back(&table);
+  }
+  auto rank = [&](const pdpi::IrTableDefinition* table) {
+    auto it = ir_p4_info.dependency_rank_by_table_name().find(
+        table->preamble().alias());
+    return it == ir_p4_info.dependency_rank_by_table_name().end() ? 0
+                                                                  : it->second;
+  };
+  // Referenced tables have higher ranks. Ties are broken by id, so the order
+  // does not depend on map iteration order.
+  absl::c_sort(tables, [&](const pdpi::IrTableDefinition* a,
+                           const pdpi::IrTableDefinition* b) {
+    return std::make_pair(-rank(a), a->preamble().id()) <
+           std::make_pair(-rank(b), b->preamble().id());
+  });
+  return tables;
+}
+
+// Returns the value of match field `field_id` in `entry`, or nullopt if the
+// field is absent or not an exact or optional match.
+std::optional<std::string> GetMatchValue(const TableEntry& entry,
+                                         uint32_t field_id) {
+  for (const FieldMatch& match : entry.match()) {
+    if (match.field_id() != field_id) continue;
+    if (match.has_exact()) return match.exact().value();
+    if (match.has_optional()) return match.optional().value();
+    return std::nullopt;
+  }
+  return std::nullopt;
+}
+
+// Returns true if `field` is present in `entry`, i.e. if a reference from it
+// constrains the entry.
+bool HasField(const TableEntry& entry, const pdpi::IrField& field) {
+  if (field.match_field().has_p4_match_field()) {
+    const uint32_t field_id =
+        field.match_field().p4_match_field().field_id();
+    return absl::c_any_of(entry.match(), [&](const FieldMatch& match) {
+      return match.field_id() == field_id;
+    });
+  }
+  if (field.action_field().has_p4_action_field()) {
+    const uint32_t action_id =
+        field.action_field().p4_action_field().action_id();
+    if (entry.action().has_action()) {
+      return entry.action().action().action_id() == action_id;
+    }
+    return absl::c_any_of(
+        entry.action().action_profile_action_set().action_profile_actions(),
+        [&](const p4::v1::ActionProfileAction& action) {
+          return action.action().action_id() == action_id;
+        });
+  }
+  return false;
+}
+
+// Sets `field` of `entry` to `value`, wherever it is present.
+void SetField(const pdpi::IrField& field, const std::string& value,
+              TableEntry& entry) {
+  if (field.match_field().has_p4_match_field()) {
+    const uint32_t field_id =
+        field.match_field().p4_match_field().field_id();
+    for (FieldMatch& match : *entry.mutable_match()) {
+      if (match.field_id() != field_id) continue;
+      if (match.has_exact()) match.mutable_exact()->set_value(value);
+      if (match.has_optional()) match.mutable_optional()->set_value(value);
+    }
+    return;
+  }
+  if (!field.action_field().has_p4_action_field()) return;
+  const pdpi::IrP4ActionField& action_field =
+      field.action_field().p4_action_field();
+  auto set_param = [&](p4::v1::Action& action) {
+    if (action.action_id() != action_field.action_id()) return;
+    for (p4::v1::Action::Param& param : *action.mutable_params()) {
+      if (param.param_id() == action_field.parameter_id()) {
+        param.set_value(value);
+      }
+    }
+  };
+  if (entry.action().has_action()) {
+    set_param(*entry.mutable_action()->mutable_action());
+  }
+  for (p4::v1::ActionProfileAction& action :
+       *entry.mutable_action()
+            ->mutable_action_profile_action_set()
+            ->mutable_action_profile_actions()) {
+    set_param(*action.mutable_action());
+  }
+}
+
+// Rewrites the fields of `entry` that refer to other tables to the values of an
+// entry in `state`. Returns false if that is impossible, e.g. because a
+// referenced table is empty.
+bool SatisfyReferences(absl::BitGen* gen,
+                       const pdpi::IrTableDefinition& ir_table,
+                       const SwitchState& state, TableEntry& entry) {
+  for (const pdpi::IrTableReference& reference :
+       ir_table.outgoing_references()) {
+    // Built-in tables are not tracked by `SwitchState`.
+    if (!reference.destination_table().has_p4_table()) continue;
+    if (absl::c_none_of(
+            reference.field_references(),
+            [&](const pdpi::IrTableReference::FieldReference& field) {
+              return HasField(entry, field.source());
+            })) {
+      continue;
+    }
+
+    absl::Span<const TableEntry> destinations = state.GetTableEntries(
+        reference.destination_table().p4_table().table_id());
+    if (destinations.empty()) return false;
+    // All fields of one reference must refer to the same entry.
+    const TableEntry& destination = UniformFromSpan(gen, destinations);
+    for (const pdpi::IrTableReference::FieldReference& field :
+         reference.field_references()) {
+      if (!field.destination().match_field().has_p4_match_field()) continue;
+      std::optional<std::string> value = GetMatchValue(
+          destination,
+          field.destination().match_field().p4_match_field().field_id());
+      if (!value.has_value()) {
+        if (HasField(entry, field.source())) return false;
+        continue;
+      }
+      SetField(field.source(), *value, entry);
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+absl::StatusOr<std::vector<TableEntry>> FuzzValidState(
+    absl::BitGen* gen, const pdpi::IrP4Info& ir_p4_info,
+    const ValidStateOptions& options, SwitchState& state) {
+  if (options.entries_per_table < 0 || options.max_attempts_per_entry <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Entries per table must be >= 0 and max attempts per entry must "
+              "be > 0. Entries per table: "
+           << options.entries_per_table
+           << ", max attempts per entry: " << options.max_attempts_per_entry;
+  }
+
+  std::vector<TableEntry> entries;
+  for (const pdpi::IrTableDefinition* ir_table :
+       TablesInDependencyOrder(ir_p4_info)) {
+    const uint32_t table_id = ir_table->preamble().id();
+    int num_entries = 0;
+    int attempts = 0;
+    while (num_entries < options.entries_per_table &&
+           state.CanAccommodateInserts(table_id, 1) &&
+           attempts < options.max_attempts_per_entry) {
+      ++attempts;
+      TableEntry entry = FuzzValidTableEntry(gen, ir_p4_info, *ir_table);
+      if (ir_table->requires_priority() && entry.priority() == 0) {
+        entry.set_priority(1);
+      }
+      if (!SatisfyReferences(gen, *ir_table, state, entry) ||
+          state.GetTableEntry(entry) != nullptr) {
+        continue;
+      }
+
+      Update update;
+      update.set_type(Update::INSERT);
+      *update.mutable_entity()->mutable_table_entry() = entry;
+      RETURN_IF_ERROR(state.ApplyUpdate(update));
+      entries.push_back(std::move(entry));
+      ++num_entries;
+      attempts = 0;
+    }
+  }
+  return entries;
+}
+
+absl::Status InstallEntries(pdpi::P4RuntimeSession& session,
+                            const pdpi::IrP4Info& ir_p4_info,
+                            absl::Span<const TableEntry> entries,
+                            const pdpi::PipelinedWriteOptions& options) {
+  std::vector<Update> updates;
+  updates.reserve(entries.size());
+  for (const TableEntry& entry : entries) {
+    Update& update = updates.emplace_back();
+    update.set_type(Update::INSERT);
+    *update.mutable_entity()->mutable_table_entry() = entry;
+  }
+  return pdpi::SendPiUpdatesPipelined(session, ir_p4_info, updates, options)
+      .status();
+}
+
+}  // namespace p4_fuzzer
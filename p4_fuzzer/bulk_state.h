@@ -0,0 +1,61 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_FUZZER_BULK_STATE_H_
+#define PINS_P4_FUZZER_BULK_STATE_H_
+
+#include <vector>
+
+#include "absl/random/random.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/switch_state.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/p4_runtime_session.h"
+
+namespace p4_fuzzer {
+
+struct ValidStateOptions {
+  // The number of entries to generate per table. Capped by the size of each
+  // table, i.e. its minimum guaranteed size, minus the entries already in the
+  // state.
+  int entries_per_table = 1000;
+  // The number of consecutive attempts to generate a new valid entry for a
+  // table before moving on to the next table with fewer entries. Attempts fail
+  // when the generated entry already exists, typically because the key space
+  // of the table is small, or when it refers to a table without entries.
+  int max_attempts_per_entry = 10;
+};
+
+// Generates valid table entries for every table in `ir_p4_info` directly,
+// without going through fuzzed write requests, and inserts them into `state`.
+// Entries are referentially consistent: every field with a `@refers_to`
+// annotation takes its value from an entry of the referenced table, which is
+// generated first. Returns the new entries in an order in which they can be
+// installed, i.e. with referenced entries first.
+absl::StatusOr<std::vector<p4::v1::TableEntry>> FuzzValidState(
+    absl::BitGen* gen, const pdpi::IrP4Info& ir_p4_info,
+    const ValidStateOptions& options, SwitchState& state);
+
+// Inserts `entries`, e.g. as returned by `FuzzValidState`, into the switch with
+// pipelined batch writes (see `pdpi::SendPiUpdatesPipelined`).
+absl::Status InstallEntries(pdpi::P4RuntimeSession& session,
+                            const pdpi::IrP4Info& ir_p4_info,
+                            absl::Span<const p4::v1::TableEntry> entries,
+                            const pdpi::PipelinedWriteOptions& options = {});
+
+}  // namespace p4_fuzzer
+
+#endif  // PINS_P4_FUZZER_BULK_STATE_H_
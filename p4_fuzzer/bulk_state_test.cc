@@ -0,0 +1,117 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_fuzzer/bulk_state.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/random/random.h"
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/switch_state.h"
+#include "p4_pdpi/ir.pb.h"
+#include "sai_p4/instantiations/google/sai_p4info.h"
+
+namespace p4_fuzzer {
+namespace {
+
+using ::gutil::StatusIs;
+using ::p4::v1::TableEntry;
+
+const pdpi::IrP4Info& MiddleblockIrP4Info() {
+  return sai::GetIrP4Info(sai::Instantiation::kMiddleblock);
+}
+
+TEST(FuzzValidStateTest, RespectsTableSizes) {
+  absl::BitGen gen;
+  SwitchState state(MiddleblockIrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<TableEntry> entries,
+      FuzzValidState(&gen, MiddleblockIrP4Info(),
+                     {.entries_per_table = 1000000}, state));
+
+  EXPECT_FALSE(entries.empty());
+  EXPECT_EQ(state.GetNumTableEntries(), static_cast<int64_t>(entries.size()));
+  for (const auto& [id, table] : MiddleblockIrP4Info().tables_by_id()) {
+    EXPECT_LE(state.GetNumTableEntries(id), table.size())
+        << table.preamble().alias();
+  }
+}
+
+TEST(FuzzValidStateTest, ReferencedEntriesComeFirst) {
+  absl::BitGen gen;
+  SwitchState state(MiddleblockIrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<TableEntry> entries,
+      FuzzValidState(&gen, MiddleblockIrP4Info(), {.entries_per_table = 20},
+                     state));
+
+  // Replaying the entries in order, every referenced match field value must
+  // already be installed in the destination table.
+  SwitchState replayed(MiddleblockIrP4Info());
+  for (const TableEntry& entry : entries) {
+    const pdpi::IrTableDefinition& table =
+        MiddleblockIrP4Info().tables_by_id().at(entry.table_id());
+    for (const pdpi::IrTableReference& reference :
+         table.outgoing_references()) {
+      if (!reference.destination_table().has_p4_table()) continue;
+      for (const auto& field : reference.field_references()) {
+        if (!field.source().match_field().has_p4_match_field() ||
+            !field.destination().match_field().has_p4_match_field()) {
+          continue;
+        }
+        for (const p4::v1::FieldMatch& match : entry.match()) {
+          if (match.field_id() !=
+                  field.source().match_field().p4_match_field().field_id() ||
+              !match.has_exact()) {
+            continue;
+          }
+          bool found = false;
+          for (const TableEntry& destination : replayed.GetTableEntries(
+                   reference.destination_table().p4_table().table_id())) {
+            for (const p4::v1::FieldMatch& destination_match :
+                 destination.match()) {
+              found |= destination_match.field_id() ==
+                           field.destination()
+                               .match_field()
+                               .p4_match_field()
+                               .field_id() &&
+                       destination_match.exact().value() ==
+                           match.exact().value();
+            }
+          }
+          EXPECT_TRUE(found) << entry.DebugString();
+        }
+      }
+    }
+    p4::v1::Update update;
+    update.set_type(p4::v1::Update::INSERT);
+    *update.mutable_entity()->mutable_table_entry() = entry;
+    ASSERT_OK(replayed.ApplyUpdate(update));
+  }
+}
+
+TEST(FuzzValidStateTest, RejectsInvalidOptions) {
+  absl::BitGen gen;
+  SwitchState state(MiddleblockIrP4Info());
+  EXPECT_THAT(FuzzValidState(&gen, MiddleblockIrP4Info(),
+                             {.max_attempts_per_entry = 0}, state),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace p4_fuzzer
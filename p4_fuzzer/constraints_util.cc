@@ -1,8 +1,16 @@
 #include "p4_fuzzer/constraints_util.h"
 
+#include <algorithm>
 #include <bitset>
 #include <cstdio>
-
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/random/distributions.h"
+#include "absl/random/random.h"
 #include "absl/status/status.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
@@ -221,6 +229,16 @@ MatchKeyToBddVariableMapping::GetOrAllocateBddVariable(
   return bdd_var;
 }
 
+absl::StatusOr<MatchFieldBit> MatchKeyToBddVariableMapping::GetMatchFieldBit(
+    BddVariable bdd_var) const {
+  auto search = bdd_to_key_.find(bdd_var);
+  if (search == bdd_to_key_.end()) {
+    return absl::NotFoundError(
+        absl::StrCat("No match field bit for BDD variable ", bdd_var));
+  }
+  return search->second;
+}
+
 absl::StatusOr<std::vector<BddVariable>>
 MatchKeyToBddVariableMapping::GetOrAllocateBddVariablesForKey(
     const p4_constraints::ast::Expression& expr) {
@@ -281,4 +299,155 @@ absl::StatusOr<BDDInfo> ConstraintToBddInfo(
   return bdd_info;
 }
 
+BddSampler::BddSampler(const SymbolicConstraint& constraint, Cudd* mgr)
+    : bdd_(constraint.bdd) {
+  const int num_variables = constraint.mapping.num_bdd_variables();
+  variable_by_position_.resize(num_variables);
+  std::iota(variable_by_position_.begin(), variable_by_position_.end(), 0);
+  absl::c_sort(variable_by_position_, [mgr](BddVariable a, BddVariable b) {
+    return Cudd_ReadPerm(mgr->getManager(), a) <
+           Cudd_ReadPerm(mgr->getManager(), b);
+  });
+  position_by_variable_.resize(num_variables);
+  for (int position = 0; position < num_variables; ++position) {
+    position_by_variable_[variable_by_position_[position]] = position;
+  }
+
+  CountNodeSolutions(Cudd_Regular(bdd_.getNode()));
+  num_solutions_ = CountSolutions(bdd_.getNode(), /*from=*/0);
+}
+
+int BddSampler::Position(DdNode* node) const {
+  if (Cudd_IsConstant(node)) return variable_by_position_.size();
+  return position_by_variable_[Cudd_NodeReadIndex(node)];
+}
+
+void BddSampler::CountNodeSolutions(DdNode* node) {
+  if (Cudd_IsConstant(node) || solutions_by_node_.contains(node)) return;
+  CountNodeSolutions(Cudd_Regular(Cudd_T(node)));
+  CountNodeSolutions(Cudd_Regular(Cudd_E(node)));
+  const int from = Position(node) + 1;
+  solutions_by_node_[node] =
+      CountSolutions(Cudd_T(node), from) + CountSolutions(Cudd_E(node), from);
+}
+
+mpz_class BddSampler::CountSolutions(DdNode* edge, int from) const {
+  DdNode* node = Cudd_Regular(edge);
+  const int position = Position(node);
+  // The only constant node of a BDD is 1; 0 is its complement.
+  mpz_class solutions =
+      Cudd_IsConstant(node) ? mpz_class(1) : solutions_by_node_.at(node);
+  if (Cudd_IsComplement(edge)) {
+    const int num_free_variables = variable_by_position_.size() - position;
+    solutions = (mpz_class(1) << num_free_variables) - solutions;
+  }
+  // Variables skipped by the edge are unconstrained.
+  return solutions << (position - from);
+}
+
+absl::StatusOr<std::vector<bool>> BddSampler::Sample(absl::BitGen& gen) const {
+  if (num_solutions_ == 0) {
+    return absl::FailedPreconditionError(
+        "Cannot sample from an unsatisfiable constraint");
+  }
+
+  std::vector<bool> assignment(variable_by_position_.size());
+  DdNode* edge = bdd_.getNode();
+  int from = 0;
+  while (true) {
+    DdNode* node = Cudd_Regular(edge);
+    const int position = Position(node);
+    for (; from < position; ++from) {
+      assignment[variable_by_position_[from]] = absl::Bernoulli(gen, 0.5);
+    }
+    if (Cudd_IsConstant(node)) break;
+
+    // Complemented edges complement both cofactors of their node.
+    DdNode* then_edge = Cudd_NotCond(Cudd_T(node), Cudd_IsComplement(edge));
+    DdNode* else_edge = Cudd_NotCond(Cudd_E(node), Cudd_IsComplement(edge));
+    const mpz_class then_solutions = CountSolutions(then_edge, position + 1);
+    mpq_class then_probability(
+        then_solutions,
+        then_solutions + CountSolutions(else_edge, position + 1));
+    then_probability.canonicalize();
+    const bool value = absl::Bernoulli(gen, then_probability.get_d());
+    assignment[Cudd_NodeReadIndex(node)] = value;
+    edge = value ? then_edge : else_edge;
+    from = position + 1;
+  }
+  return assignment;
+}
+
+absl::StatusOr<absl::flat_hash_map<std::string, std::string>>
+AssignmentToMatchFieldValues(const MatchKeyToBddVariableMapping& mapping,
+                             const std::vector<bool>& assignment) {
+  if (assignment.size() != mapping.num_bdd_variables()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Expected an assignment of ", mapping.num_bdd_variables(),
+        " BDD variables, but got ", assignment.size()));
+  }
+
+  absl::flat_hash_map<std::string, std::vector<bool>> bits_by_field;
+  for (BddVariable bdd_var = 0; bdd_var < assignment.size(); ++bdd_var) {
+    ASSIGN_OR_RETURN(MatchFieldBit field_bit,
+                     mapping.GetMatchFieldBit(bdd_var));
+    std::vector<bool>& bits = bits_by_field[field_bit.name];
+    if (bits.size() <= field_bit.bit) bits.resize(field_bit.bit + 1);
+    bits[field_bit.bit] = assignment[bdd_var];
+  }
+
+  absl::flat_hash_map<std::string, std::string> values;
+  for (const auto& [name, bits] : bits_by_field) {
+    const int num_bytes = (bits.size() + 7) / 8;
+    std::string& value = values[name];
+    value.assign(num_bytes, '\0');
+    for (int i = 0; i < bits.size(); ++i) {
+      if (bits[i]) value[num_bytes - 1 - i / 8] |= 1 << (i % 8);
+    }
+  }
+  return values;
+}
+
+absl::StatusOr<std::shared_ptr<const CachedConstraint>> BddCache::GetOrCreate(
+    const p4_constraints::ast::Expression& expr) {
+  std::string key = expr.SerializeAsString();
+  if (auto search = constraints_by_expression_.find(key);
+      search != constraints_by_expression_.end()) {
+    return search->second;
+  }
+
+  MatchKeyToBddVariableMapping mapping;
+  ASSIGN_OR_RETURN(BDD bdd, ExpressionToBDD(expr, mgr_, &mapping));
+  SymbolicConstraint constraint{bdd, mapping};
+  auto cached = std::make_shared<const CachedConstraint>(
+      CachedConstraint{constraint, BddSampler(constraint, mgr_)});
+  constraints_by_expression_[std::move(key)] = cached;
+  return cached;
+}
+
+absl::StatusOr<BDDInfo> ConstraintToBddInfo(
+    const p4_constraints::ConstraintInfo& constraints, BddCache& cache) {
+  BDDInfo bdd_info;
+
+  for (auto& [id, table_info] : constraints) {
+    if (!table_info.constraint.has_value()) {
+      continue;
+    }
+
+    const auto& expr = table_info.constraint.value();
+
+    ASSIGN_OR_RETURN(std::shared_ptr<const CachedConstraint> cached,
+                     cache.GetOrCreate(expr));
+
+    auto [_, inserted] = bdd_info.insert({id, cached->constraint});
+
+    if (!inserted) {
+      return absl::InternalError(absl::StrCat(
+          "Duplicate constraint for table ID ", id, ": ", expr.DebugString()));
+    }
+  }
+
+  return bdd_info;
+}
+
 }  // namespace p4_fuzzer
@@ -2,13 +2,19 @@
 #define P4_FUZZER_CONSTRAINTS_UTIL_H_
 
 #include <cstdio>
+#include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/hash/hash.h"
+#include "absl/random/random.h"
+#include "absl/status/statusor.h"
 #include "absl/types/variant.h"
 #include "cudd.h"
 #include "cuddObj.hh"
+#include "gmpxx.h"
 #include "gutil/status.h"
 #include "p4_constraints/ast.pb.h"
 #include "p4_constraints/backend/constraint_info.h"
@@ -53,6 +59,12 @@ class MatchKeyToBddVariableMapping {
   absl::StatusOr<std::vector<BddVariable>> GetOrAllocateBddVariablesForKey(
       const p4_constraints::ast::Expression& expr);
 
+  // Returns the number of allocated BDD variables. They are numbered from 0.
+  int num_bdd_variables() const { return bdd_var_latest_; }
+
+  // Returns the match field bit that `bdd_var` represents.
+  absl::StatusOr<MatchFieldBit> GetMatchFieldBit(BddVariable bdd_var) const;
+
  private:
   absl::StatusOr<BddVariable> GetOrAllocateBddVariable(
       const MatchFieldBit& field_bit);
@@ -99,6 +111,80 @@ using BDDInfo = absl::flat_hash_map<uint32_t, SymbolicConstraint>;
 absl::StatusOr<BDDInfo> ConstraintToBddInfo(
     const p4_constraints::ConstraintInfo& constraints, Cudd* mgr);
 
+// Samples satisfying assignments of a SymbolicConstraint uniformly at random.
+// The number of satisfying assignments below each BDD node is computed once on
+// creation, so each sample takes time linear in the number of BDD variables.
+// Assumes the variable order of the manager does not change afterwards, i.e.
+// that dynamic reordering is disabled (the default).
+class BddSampler {
+ public:
+  BddSampler(const SymbolicConstraint& constraint, Cudd* mgr);
+
+  // The number of satisfying assignments of the constraint's BDD variables.
+  const mpz_class& num_solutions() const { return num_solutions_; }
+
+  // Returns a uniformly random satisfying assignment, indexed by BddVariable,
+  // or an error if the constraint is unsatisfiable.
+  absl::StatusOr<std::vector<bool>> Sample(absl::BitGen& gen) const;
+
+ private:
+
+  // Returns the position of the variable of `node` in the variable order, or
+  // the number of variables for the constant node.
+  int Position(DdNode* node) const;
+
+  // Fills `solutions_by_node_` for the regular `node` and its descendants.
+  void CountNodeSolutions(DdNode* node);
+
+  // Returns the number of satisfying assignments of the variables at positions
+  // `from` and above for the function at the end of `edge`.
+  mpz_class CountSolutions(DdNode* edge, int from) const;
+
+  // Keeps the BDD nodes in `solutions_by_node_` alive.
+  BDD bdd_;
+  std::vector<int> position_by_variable_;
+  std::vector<BddVariable> variable_by_position_;
+  // The number of satisfying assignments of the variables at or below the
+  // position of each (regular, i.e. uncomplemented) node.
+  absl::flat_hash_map<DdNode*, mpz_class> solutions_by_node_;
+  mpz_class num_solutions_;
+};
+
+// Maps each match field in `mapping` to the value it takes in `assignment`, as
+// returned by `BddSampler::Sample`. Values are big-endian byte strings of the
+// minimal width holding all bits of the field.
+absl::StatusOr<absl::flat_hash_map<std::string, std::string>>
+AssignmentToMatchFieldValues(const MatchKeyToBddVariableMapping& mapping,
+                             const std::vector<bool>& assignment);
+
+// A constraint translated to a BDD, together with a sampler for it.
+struct CachedConstraint {
+  SymbolicConstraint constraint;
+  BddSampler sampler;
+};
+
+// Caches the translation of p4-constraints to BDDs, keyed by the constraint
+// expression, so tables (or P4Infos) sharing a constraint translate it once.
+// Entries live as long as the cache, which must not outlive `mgr`.
+class BddCache {
+ public:
+  explicit BddCache(Cudd* mgr) : mgr_(mgr) {}
+
+  // Returns the translation of `expr`, translating it on first use. Errors are
+  // not cached.
+  absl::StatusOr<std::shared_ptr<const CachedConstraint>> GetOrCreate(
+      const p4_constraints::ast::Expression& expr);
+
+ private:
+  Cudd* mgr_;
+  absl::flat_hash_map<std::string, std::shared_ptr<const CachedConstraint>>
+      constraints_by_expression_;
+};
+
+// Like `ConstraintToBddInfo` above, but reuses the translations in `cache`.
+absl::StatusOr<BDDInfo> ConstraintToBddInfo(
+    const p4_constraints::ConstraintInfo& constraints, BddCache& cache);
+
 }  // namespace p4_fuzzer
 
 #endif  // P4_FUZZER_CONSTRAINTS_UTIL_H_
@@ -1,9 +1,14 @@
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/random/random.h"
 #include "glog/logging.h"
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "gutil/proto.h"
+#include "gutil/status_matchers.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4_constraints/backend/constraint_info.h"
 #include "p4_fuzzer/constraints_util.h"
@@ -84,6 +89,55 @@ TEST(ConstraintsUtilTest, BDDConversionTest) {
   PrintBDDAsDotFile(bdd, &mgr);
 }
 
+TEST(ConstraintsUtilTest, BddSamplerSamplesOnlySatisfyingAssignments) {
+  Cudd mgr(0, 0);
+  BddCache cache(&mgr);
+  absl::BitGen gen;
+
+  // hdr.hdr_fuzz.fuzz_field_1 == 42
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<const CachedConstraint> equals,
+      cache.GetOrCreate(GetFirstExpressionFromConstraintInfo(
+          GetConstraintInfoFromP4Info(kBinaryEqualsP4InfoFile))));
+  EXPECT_EQ(equals->sampler.num_solutions(), 1);
+  ASSERT_OK_AND_ASSIGN(std::vector<bool> assignment,
+                       equals->sampler.Sample(gen));
+  ASSERT_OK_AND_ASSIGN(
+      (absl::flat_hash_map<std::string, std::string> values),
+      AssignmentToMatchFieldValues(equals->constraint.mapping, assignment));
+  ASSERT_EQ(values.size(), 1);
+  EXPECT_EQ(values.begin()->second, "\x2a");
+
+  // hdr.hdr_fuzz.fuzz_field_1 != 42
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<const CachedConstraint> not_equals,
+      cache.GetOrCreate(GetFirstExpressionFromConstraintInfo(
+          GetConstraintInfoFromP4Info(kBinaryNotEqualsP4InfoFile))));
+  EXPECT_EQ(not_equals->sampler.num_solutions(), 255);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_OK_AND_ASSIGN(assignment, not_equals->sampler.Sample(gen));
+    ASSERT_OK_AND_ASSIGN(values, AssignmentToMatchFieldValues(
+                                     not_equals->constraint.mapping,
+                                     assignment));
+    ASSERT_EQ(values.size(), 1);
+    EXPECT_NE(values.begin()->second, "\x2a");
+  }
+}
+
+TEST(ConstraintsUtilTest, BddCacheTranslatesEachConstraintOnce) {
+  Cudd mgr(0, 0);
+  BddCache cache(&mgr);
+  const p4_constraints::ast::Expression expr =
+      GetFirstExpressionFromConstraintInfo(
+          GetConstraintInfoFromP4Info(kBinaryEqualsP4InfoFile));
+
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const CachedConstraint> first,
+                       cache.GetOrCreate(expr));
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const CachedConstraint> second,
+                       cache.GetOrCreate(expr));
+  EXPECT_EQ(first.get(), second.get());
+}
+
 }  // namespace
 
 }  // namespace p4_fuzzer
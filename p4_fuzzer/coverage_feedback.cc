@@ -0,0 +1,120 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_fuzzer/coverage_feedback.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/fuzzer.pb.h"
+
+namespace p4_fuzzer {
+namespace {
+
+std::pair<uint32_t, int> Kind(uint32_t table_id,
+                              std::optional<Mutation> mutation) {
+  return {table_id, mutation.has_value() ? static_cast<int>(*mutation) : -1};
+}
+
+}  // namespace
+
+std::string ErrorMessageClass(absl::string_view message) {
+  std::string result;
+  char quote = '\0';
+  for (int i = 0; i < static_cast<int>(message.size()); ++i) {
+    const char c = message[i];
+    if (quote != '\0') {
+      if (c == quote) {
+        result.push_back(c);
+        quote = '\0';
+      }
+      continue;
+    }
+    if (c == '\'' || c == '"') {
+      result.push_back(c);
+      quote = c;
+    } else if (absl::ascii_isdigit(c)) {
+      // A number, including any hex digits that follow its first digit.
+      result.push_back('#');
+      while (i + 1 < static_cast<int>(message.size()) &&
+             absl::ascii_isxdigit(message[i + 1])) {
+        ++i;
+      }
+    } else {
+      result.push_back(c);
+    }
+  }
+  return result;
+}
+
+std::string ResponseClass(uint32_t table_id, std::optional<Mutation> mutation,
+                          const p4::v1::Error& status) {
+  return absl::StrCat(
+      table_id, "/",
+      mutation.has_value() ? Mutation_Name(*mutation) : "NO_MUTATION", "/",
+      absl::StatusCodeToString(
+          static_cast<absl::StatusCode>(status.canonical_code())),
+      "/", ErrorMessageClass(status.message()));
+}
+
+bool CoverageFeedback::Record(const p4::v1::Update& update,
+                              std::optional<Mutation> mutation,
+                              const p4::v1::Error& status) {
+  const uint32_t table_id = update.entity().table_entry().table_id();
+  KindStats& stats = stats_by_kind_[Kind(table_id, mutation)];
+  ++stats.sent;
+  if (!response_classes_.insert(ResponseClass(table_id, mutation, status))
+           .second) {
+    return false;
+  }
+  ++stats.new_response_classes;
+
+  if (max_corpus_size_ <= 0) return true;
+  if (static_cast<int>(corpus_.size()) < max_corpus_size_) {
+    corpus_.push_back(update);
+  } else {
+    corpus_[next_corpus_index_] = update;
+    next_corpus_index_ = (next_corpus_index_ + 1) % max_corpus_size_;
+  }
+  return true;
+}
+
+double CoverageFeedback::Weight(uint32_t table_id,
+                                std::optional<Mutation> mutation) const {
+  auto stats = stats_by_kind_.find(Kind(table_id, mutation));
+  if (stats == stats_by_kind_.end()) return 1.0;
+  return (1.0 + stats->second.new_response_classes) /
+         (1.0 + stats->second.sent);
+}
+
+double CoverageFeedback::RequestWeight(
+    const p4::v1::WriteRequest& request,
+    absl::Span<const std::optional<Mutation>> mutations) const {
+  if (request.updates().empty()) return 0.0;
+  double total = 0.0;
+  for (int i = 0; i < request.updates_size(); ++i) {
+    total += Weight(request.updates(i).entity().table_entry().table_id(),
+                    i < static_cast<int>(mutations.size()) ? mutations[i]
+                                                           : std::nullopt);
+  }
+  return total / request.updates_size();
+}
+
+}  // namespace p4_fuzzer
@@ -0,0 +1,96 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_FUZZER_COVERAGE_FEEDBACK_H_
+#define PINS_P4_FUZZER_COVERAGE_FEEDBACK_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/fuzzer.pb.h"
+
+namespace p4_fuzzer {
+
+// Returns the class of a switch error message: the message with the contents
+// of quotes removed, and every number replaced by '#'. So errors that only
+// differ in the entry, or the value, they name fall into the same class.
+std::string ErrorMessageClass(absl::string_view message);
+
+// Returns the response class of the switch's `status` for an update to
+// `table_id`, with the given `mutation`, if any. That is the tuple (table,
+// mutation, response code, error message class) as a string.
+std::string ResponseClass(uint32_t table_id, std::optional<Mutation> mutation,
+                          const p4::v1::Error& status);
+
+// Tracks which response classes the switch has given to fuzzed updates, so
+// that generation can be steered toward updates that still find new ones.
+//
+// Updates are grouped into kinds by their table and mutation. The more updates
+// of a kind are sent without finding a new response class, the less
+// interesting another one is. Updates that found a new response class are kept
+// in a corpus so they can be mutated again.
+class CoverageFeedback {
+ public:
+  static constexpr int kDefaultMaxCorpusSize = 1000;
+
+  explicit CoverageFeedback(int max_corpus_size = kDefaultMaxCorpusSize)
+      : max_corpus_size_(max_corpus_size) {}
+
+  // Records the switch's response to an update. Returns true if its response
+  // class was new, in which case the update is added to the corpus. A full
+  // corpus replaces its oldest update.
+  bool Record(const p4::v1::Update& update, std::optional<Mutation> mutation,
+              const p4::v1::Error& status);
+
+  // Returns how interesting another update of this kind is. Kinds that were
+  // never sent have a weight of 1, and the weight falls as updates of the kind
+  // are sent without finding new response classes.
+  double Weight(uint32_t table_id, std::optional<Mutation> mutation) const;
+
+  // Returns the mean weight of the updates of `request`, where `mutations`
+  // holds the mutation of each update. An empty request has no weight.
+  double RequestWeight(const p4::v1::WriteRequest& request,
+                       absl::Span<const std::optional<Mutation>> mutations)
+      const;
+
+  const std::vector<p4::v1::Update>& corpus() const { return corpus_; }
+  int num_response_classes() const { return response_classes_.size(); }
+
+ private:
+  // The table ID, and the mutation or -1 if there is none.
+  using UpdateKind = std::pair<uint32_t, int>;
+
+  struct KindStats {
+    int64_t sent = 0;
+    int64_t new_response_classes = 0;
+  };
+
+  int max_corpus_size_;
+  absl::flat_hash_set<std::string> response_classes_;
+  absl::flat_hash_map<UpdateKind, KindStats> stats_by_kind_;
+  std::vector<p4::v1::Update> corpus_;
+  // The corpus entry the next new update replaces once the corpus is full.
+  int next_corpus_index_ = 0;
+};
+
+}  // namespace p4_fuzzer
+
+#endif  // PINS_P4_FUZZER_COVERAGE_FEEDBACK_H_
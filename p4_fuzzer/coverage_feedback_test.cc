@@ -0,0 +1,122 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_fuzzer/coverage_feedback.h"
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/fuzzer.pb.h"
+
+namespace p4_fuzzer {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::p4::v1::Error;
+using ::p4::v1::Update;
+using ::p4::v1::WriteRequest;
+using ::testing::ElementsAre;
+using ::testing::Lt;
+
+Update TableUpdate(uint32_t table_id) {
+  Update update;
+  update.set_type(Update::INSERT);
+  update.mutable_entity()->mutable_table_entry()->set_table_id(table_id);
+  return update;
+}
+
+Error SwitchStatus(absl::StatusCode code, std::string message = "") {
+  Error error;
+  error.set_canonical_code(static_cast<int>(code));
+  error.set_message(std::move(message));
+  return error;
+}
+
+TEST(ErrorMessageClassTest, IgnoresNumbersAndQuotedValues) {
+  EXPECT_EQ(ErrorMessageClass("Entry 'fe80::1' in table 42 already exists"),
+            ErrorMessageClass("Entry 'fe80::2' in table 7 already exists"));
+  EXPECT_EQ(ErrorMessageClass("Weight 0x1f is invalid"),
+            "Weight #x# is invalid");
+  EXPECT_NE(ErrorMessageClass("Entry already exists"),
+            ErrorMessageClass("Entry does not exist"));
+}
+
+TEST(ResponseClassTest, DependsOnTableMutationCodeAndMessage) {
+  const Error error =
+      SwitchStatus(absl::StatusCode::kInvalidArgument, "Bad id 1");
+  const std::string response_class = ResponseClass(1, std::nullopt, error);
+  EXPECT_EQ(response_class,
+            ResponseClass(1, std::nullopt,
+                          SwitchStatus(absl::StatusCode::kInvalidArgument,
+                                       "Bad id 2")));
+  EXPECT_NE(response_class, ResponseClass(2, std::nullopt, error));
+  EXPECT_NE(response_class, ResponseClass(1, INVALID_TABLE_ID, error));
+  EXPECT_NE(response_class,
+            ResponseClass(1, std::nullopt,
+                          SwitchStatus(absl::StatusCode::kUnknown,
+                                       "Bad id 1")));
+}
+
+TEST(CoverageFeedbackTest, KeepsUpdatesWithNewResponseClasses) {
+  CoverageFeedback feedback;
+  EXPECT_TRUE(feedback.Record(TableUpdate(1), std::nullopt,
+                              SwitchStatus(absl::StatusCode::kOk)));
+  EXPECT_FALSE(feedback.Record(TableUpdate(1), std::nullopt,
+                               SwitchStatus(absl::StatusCode::kOk)));
+  EXPECT_TRUE(feedback.Record(TableUpdate(2), std::nullopt,
+                              SwitchStatus(absl::StatusCode::kOk)));
+
+  EXPECT_EQ(feedback.num_response_classes(), 2);
+  EXPECT_THAT(feedback.corpus(), ElementsAre(EqualsProto(TableUpdate(1)),
+                                             EqualsProto(TableUpdate(2))));
+}
+
+TEST(CoverageFeedbackTest, FullCorpusReplacesItsOldestUpdate) {
+  CoverageFeedback feedback(/*max_corpus_size=*/2);
+  for (uint32_t table_id : {1, 2, 3}) {
+    feedback.Record(TableUpdate(table_id), std::nullopt,
+                    SwitchStatus(absl::StatusCode::kOk));
+  }
+  EXPECT_THAT(feedback.corpus(), ElementsAre(EqualsProto(TableUpdate(3)),
+                                             EqualsProto(TableUpdate(2))));
+}
+
+TEST(CoverageFeedbackTest, KindsStopBeingInterestingWithoutNewResponses) {
+  CoverageFeedback feedback;
+  EXPECT_EQ(feedback.Weight(1, std::nullopt), 1.0);
+
+  for (int i = 0; i < 10; ++i) {
+    feedback.Record(TableUpdate(1), std::nullopt,
+                    SwitchStatus(absl::StatusCode::kOk));
+  }
+  EXPECT_THAT(feedback.Weight(1, std::nullopt), Lt(0.5));
+  // Other tables, and other mutations of the same table, are unaffected.
+  EXPECT_EQ(feedback.Weight(2, std::nullopt), 1.0);
+  EXPECT_EQ(feedback.Weight(1, INVALID_TABLE_ID), 1.0);
+
+  WriteRequest request;
+  *request.add_updates() = TableUpdate(1);
+  *request.add_updates() = TableUpdate(2);
+  EXPECT_EQ(feedback.RequestWeight(request, {std::nullopt, std::nullopt}),
+            (feedback.Weight(1, std::nullopt) + 1.0) / 2);
+  EXPECT_EQ(feedback.RequestWeight(WriteRequest(), {}), 0.0);
+}
+
+}  // namespace
+}  // namespace p4_fuzzer
@@ -0,0 +1,585 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_fuzzer/fuzz_campaign.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT: third_party code.
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/random/random.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "google/protobuf/util/message_differencer.h"
+#include "gutil/status.h"
+#include "gutil/test_artifact_writer.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/annotation_util.h"
+#include "p4_fuzzer/coverage_feedback.h"
+#include "p4_fuzzer/fuzz_util.h"
+#include "p4_fuzzer/fuzzer.pb.h"
+#include "p4_fuzzer/mutation.h"
+#include "p4_fuzzer/oracle_util.h"
+#include "p4_fuzzer/switch_state.h"
+#include "p4_fuzzer/table_entry_key.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/utils/latency_histogram.h"
+
+namespace p4_fuzzer {
+namespace {
+
+using ::p4::v1::Entity;
+using ::p4::v1::Error;
+using ::p4::v1::ReadRequest;
+using ::p4::v1::TableEntry;
+using ::p4::v1::Update;
+using ::p4::v1::WriteRequest;
+
+// The probability that a coverage guided request mutates an update from the
+// corpus, instead of generating new updates.
+constexpr double kCorpusMutationProbability = 0.25;
+// The number of requests generated for every coverage guided request. The one
+// with the most interesting updates is sent.
+constexpr int kCoverageGuidedCandidates = 4;
+
+// A generated request, with the mutation applied to each of its updates, if
+// any.
+struct GeneratedRequest {
+  WriteRequest request;
+  std::vector<std::optional<Mutation>> mutations;
+};
+
+GeneratedRequest GenerateRequest(absl::BitGen& gen,
+                                 const pdpi::IrP4Info& ir_p4_info,
+                                 const SwitchState& state) {
+  GeneratedRequest generated;
+  const AnnotatedWriteRequest annotated_request =
+      FuzzWriteRequest(&gen, ir_p4_info, state);
+  for (const AnnotatedUpdate& update : annotated_request.updates()) {
+    // Generated updates carry at most one mutation.
+    generated.mutations.push_back(
+        update.mutations().empty()
+            ? std::nullopt
+            : std::make_optional(static_cast<Mutation>(update.mutations(0))));
+  }
+  generated.request = RemoveAnnotations(annotated_request);
+  return generated;
+}
+
+// Generates a request steered by `feedback`: either an update from the corpus
+// with a new mutation, or the most interesting of a few generated requests.
+GeneratedRequest GenerateCoverageGuidedRequest(
+    absl::BitGen& gen, const pdpi::IrP4Info& ir_p4_info,
+    const SwitchState& state, const CoverageFeedback& feedback) {
+  const std::vector<Update>& corpus = feedback.corpus();
+  if (!corpus.empty() && absl::Bernoulli(gen, kCorpusMutationProbability)) {
+    Update update = corpus[absl::Uniform<size_t>(gen, 0, corpus.size())];
+    const Mutation mutation = FuzzMutation(&gen);
+    // Not every mutation applies to every update; those fall back to a
+    // generated request.
+    if (MutateUpdate(&gen, &update, ir_p4_info, state, mutation).ok()) {
+      GeneratedRequest generated;
+      *generated.request.add_updates() = std::move(update);
+      generated.mutations.push_back(mutation);
+      return generated;
+    }
+  }
+
+  GeneratedRequest best = GenerateRequest(gen, ir_p4_info, state);
+  double best_weight = feedback.RequestWeight(best.request, best.mutations);
+  for (int i = 1; i < kCoverageGuidedCandidates; ++i) {
+    GeneratedRequest candidate = GenerateRequest(gen, ir_p4_info, state);
+    const double weight =
+        feedback.RequestWeight(candidate.request, candidate.mutations);
+    if (weight > best_weight) {
+      best = std::move(candidate);
+      best_weight = weight;
+    }
+  }
+  return best;
+}
+
+// Generates the `num_requests` requests of the given round against `state`.
+// Request i is generated by worker i % num_workers, so the result only depends
+// on the seed, the number of workers, `state` and `feedback`. Requests are
+// steered by `feedback` if it is non-null.
+std::vector<GeneratedRequest> GenerateRound(const pdpi::IrP4Info& ir_p4_info,
+                                            const FuzzCampaignOptions& options,
+                                            int round, int num_requests,
+                                            const SwitchState& state,
+                                            const CoverageFeedback* feedback) {
+  std::vector<GeneratedRequest> requests(num_requests);
+  const int num_workers = std::min(options.num_workers, num_requests);
+  std::vector<std::thread> threads;
+  threads.reserve(num_workers);
+  for (int worker = 0; worker < num_workers; ++worker) {
+    threads.emplace_back([&, worker] {
+      std::seed_seq seeds{static_cast<uint32_t>(options.seed),
+                          static_cast<uint32_t>(options.seed >> 32),
+                          static_cast<uint32_t>(round),
+                          static_cast<uint32_t>(worker)};
+      absl::BitGen gen(seeds);
+      for (int i = worker; i < num_requests; i += num_workers) {
+        requests[i] = feedback == nullptr
+                          ? GenerateRequest(gen, ir_p4_info, state)
+                          : GenerateCoverageGuidedRequest(gen, ir_p4_info,
+                                                          state, *feedback);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  return requests;
+}
+
+LatencySummary SummarizeLatencies(const p4rt_app::LatencyHistogram& histogram) {
+  LatencySummary summary;
+  summary.set_count(histogram.count());
+  if (histogram.count() > 0) {
+    summary.set_mean_us(absl::ToInt64Microseconds(histogram.sum()) /
+                        histogram.count());
+  }
+  summary.set_p50_us(absl::ToInt64Microseconds(histogram.Percentile(50)));
+  summary.set_p90_us(absl::ToInt64Microseconds(histogram.Percentile(90)));
+  summary.set_p99_us(absl::ToInt64Microseconds(histogram.Percentile(99)));
+  summary.set_max_us(absl::ToInt64Microseconds(histogram.max()));
+  return summary;
+}
+
+// The response of the switch to a request, queued for the oracle.
+struct Response {
+  int index;
+  const GeneratedRequest* generated;
+  std::vector<Error> statuses;
+};
+
+// Checks each queued response in order with `WriteRequestOracle`, then applies
+// the updates the switch accepted to `state`. Records the time spent in the
+// oracle in `oracle_latency`, which tables were written to in
+// `coverage_by_table`, and the response to every update in `feedback`. Returns
+// once `done` is set and the queue is drained.
+void CheckResponses(
+    const pdpi::IrP4Info& ir_p4_info, absl::Mutex& mutex,
+    std::deque<Response>& responses, const bool& done, SwitchState& state,
+    std::vector<std::string>& problems,
+    p4rt_app::LatencyHistogram& oracle_latency,
+    absl::flat_hash_map<std::string, TableCoverage>& coverage_by_table,
+    CoverageFeedback& feedback) {
+  while (true) {
+    Response response;
+    {
+      absl::MutexLock lock(&mutex);
+      auto cond = [&responses, &done]() { return !responses.empty() || done; };
+      mutex.Await(absl::Condition(&cond));
+      if (responses.empty()) return;
+      response = std::move(responses.front());
+      responses.pop_front();
+    }
+
+    const WriteRequest& request = response.generated->request;
+    const absl::Time start = absl::Now();
+    if (auto oracle_problems = WriteRequestOracle(ir_p4_info, request,
+                                                  response.statuses, state);
+        oracle_problems.has_value()) {
+      for (const std::string& problem : *oracle_problems) {
+        problems.push_back(
+            absl::StrCat("Request #", response.index, ": ", problem));
+      }
+    }
+    oracle_latency.Record(absl::Now() - start);
+
+    for (int i = 0; i < request.updates_size(); ++i) {
+      const Update& update = request.updates(i);
+      feedback.Record(update, response.generated->mutations[i],
+                      response.statuses[i]);
+      const bool accepted = response.statuses[i].canonical_code() == 0;
+      auto table = ir_p4_info.tables_by_id().find(
+          update.entity().table_entry().table_id());
+      TableCoverage& coverage =
+          coverage_by_table[table == ir_p4_info.tables_by_id().end()
+                                ? "<unknown table>"
+                                : table->second.preamble().alias()];
+      if (!accepted) {
+        coverage.set_rejected_updates(coverage.rejected_updates() + 1);
+        continue;
+      }
+      coverage.set_accepted_updates(coverage.accepted_updates() + 1);
+      if (absl::Status status = state.ApplyUpdate(update); !status.ok()) {
+        problems.push_back(absl::StrCat("Request #", response.index,
+                                        ": Failed to update state: ",
+                                        status.message()));
+      }
+    }
+  }
+}
+
+// The latency and coverage metrics of a campaign, accumulated across rounds.
+struct CampaignStats {
+  p4rt_app::LatencyHistogram write_latency;
+  p4rt_app::LatencyHistogram oracle_latency;
+  p4rt_app::LatencyHistogram verification_latency;
+  // Written by the oracle thread, so kept out of `metrics` until the end.
+  absl::flat_hash_map<std::string, TableCoverage> coverage_by_table;
+  CoverageFeedback feedback;
+};
+
+// Sends `requests` through `write` in order, while the responses are checked
+// on an oracle thread that owns `state` until this returns. If `send_times` is
+// non-empty, request i is not sent before `send_times[i]`. Returns the first
+// write error, after the responses received until then have been checked.
+absl::Status SendAndCheck(const pdpi::IrP4Info& ir_p4_info,
+                          absl::Span<const GeneratedRequest> requests,
+                          absl::Span<const absl::Time> send_times,
+                          const SwitchWriter& write, SwitchState& state,
+                          FuzzCampaignResult& result, CampaignStats& stats) {
+  FuzzCampaignMetrics& metrics = result.metrics;
+  absl::Mutex mutex;
+  std::deque<Response> responses;
+  bool done = false;
+  std::thread oracle([&] {
+    CheckResponses(ir_p4_info, mutex, responses, done, state, result.problems,
+                   stats.oracle_latency, stats.coverage_by_table,
+                   stats.feedback);
+  });
+
+  absl::Status write_status;
+  for (int i = 0; i < static_cast<int>(requests.size()); ++i) {
+    const GeneratedRequest& generated = requests[i];
+    const WriteRequest& request = generated.request;
+    if (!send_times.empty()) absl::SleepFor(send_times[i] - absl::Now());
+    const absl::Time write_start = absl::Now();
+    absl::StatusOr<std::vector<Error>> statuses = write(request);
+    stats.write_latency.Record(absl::Now() - write_start);
+    if (statuses.ok() &&
+        statuses->size() != static_cast<size_t>(request.updates_size())) {
+      statuses = gutil::InternalErrorBuilder()
+                 << "Expected " << request.updates_size()
+                 << " update statuses, but the switch returned "
+                 << statuses->size();
+    }
+    if (!statuses.ok()) {
+      write_status = statuses.status();
+      break;
+    }
+    metrics.set_num_updates(metrics.num_updates() + request.updates_size());
+    for (const std::optional<Mutation>& mutation : generated.mutations) {
+      if (!mutation.has_value()) continue;
+      ++(*metrics.mutable_num_updates_by_mutation())[Mutation_Name(*mutation)];
+    }
+    absl::MutexLock lock(&mutex);
+    responses.push_back({result.num_requests++, &generated,
+                         *std::move(statuses)});
+  }
+  {
+    absl::MutexLock lock(&mutex);
+    done = true;
+  }
+  oracle.join();
+  return write_status;
+}
+
+// The table entries touched by some requests, by key.
+using TouchedEntries = absl::flat_hash_map<TableEntryKey, TableEntry>;
+
+// Returns the entries touched by the updates of `requests`, whether the switch
+// accepted them or not. Updates to tables that `state` does not track are
+// skipped.
+TouchedEntries GetTouchedEntries(absl::Span<const GeneratedRequest> requests,
+                                 const SwitchState& state) {
+  TouchedEntries touched;
+  for (const GeneratedRequest& generated : requests) {
+    for (const Update& update : generated.request.updates()) {
+      const TableEntry& entry = update.entity().table_entry();
+      if (!update.entity().has_table_entry() ||
+          !absl::c_linear_search(state.AllTableIds(), entry.table_id())) {
+        continue;
+      }
+      TableEntry filter;
+      filter.set_table_id(entry.table_id());
+      *filter.mutable_match() = entry.match();
+      filter.set_priority(entry.priority());
+      touched.try_emplace(TableEntryKey(filter), std::move(filter));
+    }
+  }
+  return touched;
+}
+
+// Returns true if the switch's copy of an entry equals the expected entry.
+// Counter and meter data are only known to the switch, so they are ignored.
+bool SwitchEntryMatches(TableEntry switch_entry, const TableEntry& expected) {
+  switch_entry.clear_counter_data();
+  switch_entry.clear_meter_counter_data();
+  google::protobuf::util::MessageDifferencer differencer;
+  differencer.TreatAsSet(TableEntry::descriptor()->FindFieldByName("match"));
+  return differencer.Compare(switch_entry, expected);
+}
+
+// Reads back the switch state through `read`, and compares it with `state`.
+// With `touched`, only those entries are read, each by its key. Otherwise the
+// whole switch is read. Adds a problem to `result` for every entry that does
+// not match.
+absl::Status VerifySwitchState(const SwitchReader& read,
+                               const SwitchState& state,
+                               const TouchedEntries* touched, int round,
+                               FuzzCampaignResult& result,
+                               CampaignStats& stats) {
+  const absl::Time start = absl::Now();
+  ReadRequest request;
+  if (touched == nullptr) {
+    request.add_entities()->mutable_table_entry();
+  } else {
+    if (touched->empty()) return absl::OkStatus();
+    for (const auto& [key, filter] : *touched) {
+      *request.add_entities()->mutable_table_entry() = filter;
+    }
+  }
+  ASSIGN_OR_RETURN(std::vector<Entity> entities, read(request));
+
+  TouchedEntries switch_entries;
+  for (Entity& entity : entities) {
+    if (!entity.has_table_entry()) continue;
+    TableEntryKey key(entity.table_entry());
+    switch_entries.insert_or_assign(std::move(key),
+                                    std::move(*entity.mutable_table_entry()));
+  }
+
+  // A whole switch read is compared against every entry on either side, in
+  // the tables that `state` tracks.
+  TouchedEntries all_entries;
+  if (touched == nullptr) {
+    for (const auto& [key, entry] : switch_entries) {
+      if (absl::c_linear_search(state.AllTableIds(), entry.table_id())) {
+        all_entries.try_emplace(key, entry);
+      }
+    }
+    for (uint32_t table_id : state.AllTableIds()) {
+      for (const TableEntry& entry : state.GetTableEntries(table_id)) {
+        all_entries.try_emplace(TableEntryKey(entry), entry);
+      }
+    }
+    touched = &all_entries;
+  }
+
+  FuzzCampaignMetrics& metrics = result.metrics;
+  for (const auto& [key, filter] : *touched) {
+    metrics.set_num_verified_entries(metrics.num_verified_entries() + 1);
+    const TableEntry* expected = state.GetTableEntry(filter);
+    auto actual = switch_entries.find(key);
+    if (expected == nullptr && actual == switch_entries.end()) continue;
+    if (expected == nullptr) {
+      result.problems.push_back(absl::StrCat(
+          "Round #", round, ": The switch has an entry that should not exist: ",
+          actual->second.ShortDebugString()));
+    } else if (actual == switch_entries.end()) {
+      result.problems.push_back(
+          absl::StrCat("Round #", round, ": The switch is missing an entry: ",
+                       expected->ShortDebugString()));
+    } else if (!SwitchEntryMatches(actual->second, *expected)) {
+      result.problems.push_back(absl::StrCat(
+          "Round #", round, ": The switch has a different entry: ",
+          actual->second.ShortDebugString(),
+          ", expected: ", expected->ShortDebugString()));
+    }
+  }
+  stats.verification_latency.Record(absl::Now() - start);
+  return absl::OkStatus();
+}
+
+// Fills in the summary metrics of `result` for a campaign started at `start`,
+// and stores them through `artifact_writer` if it is non-null.
+absl::Status FinishCampaign(absl::Time start, const CampaignStats& stats,
+                            gutil::TestArtifactWriter* artifact_writer,
+                            FuzzCampaignResult& result) {
+  FuzzCampaignMetrics& metrics = result.metrics;
+  result.duration = absl::Now() - start;
+  metrics.set_num_requests(result.num_requests);
+  metrics.set_requests_per_second(result.RequestsPerSecond());
+  if (result.num_requests > 0) {
+    metrics.set_updates_per_request(
+        static_cast<double>(metrics.num_updates()) / result.num_requests);
+  }
+  *metrics.mutable_write_latency() = SummarizeLatencies(stats.write_latency);
+  *metrics.mutable_oracle_latency() = SummarizeLatencies(stats.oracle_latency);
+  if (stats.verification_latency.count() > 0) {
+    *metrics.mutable_verification_latency() =
+        SummarizeLatencies(stats.verification_latency);
+  }
+  metrics.mutable_coverage_by_table()->insert(stats.coverage_by_table.begin(),
+                                              stats.coverage_by_table.end());
+  metrics.set_num_response_classes(stats.feedback.num_response_classes());
+  if (artifact_writer != nullptr) {
+    RETURN_IF_ERROR(artifact_writer->StoreTestArtifact(
+        "fuzz_campaign_metrics.txtpb", metrics));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<FuzzCampaignResult> RunFuzzCampaign(
+    const pdpi::IrP4Info& ir_p4_info, const FuzzCampaignOptions& options,
+    const SwitchWriter& write, SwitchState& state) {
+  if (options.num_workers <= 0 || options.requests_per_round <= 0 ||
+      options.num_requests < 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Number of workers and requests per round must be > 0, and "
+              "number of requests must be >= 0. Number of workers: "
+           << options.num_workers
+           << ", requests per round: " << options.requests_per_round
+           << ", number of requests: " << options.num_requests;
+  }
+  if (options.verified_rounds <= 0 || options.full_verification_period < 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Number of verified rounds must be > 0, and the full "
+              "verification period must be >= 0. Verified rounds: "
+           << options.verified_rounds << ", full verification period: "
+           << options.full_verification_period;
+  }
+
+  const absl::Time start = absl::Now();
+  FuzzCampaignResult result;
+  CampaignStats stats;
+  // The entries touched by each of the last `options.verified_rounds` rounds.
+  std::deque<TouchedEntries> touched_by_round;
+  std::vector<GeneratedRequest> round_requests = GenerateRound(
+      ir_p4_info, options, /*round=*/0,
+      std::min(options.requests_per_round, options.num_requests), state,
+      options.coverage_guided ? &stats.feedback : nullptr);
+
+  for (int round = 0; !round_requests.empty(); ++round) {
+    // Generates the next round while this one is sent. `state` and the
+    // feedback are owned by the oracle until the round is done, so the
+    // generators get snapshots.
+    const int next_round_size =
+        std::min<int>(options.requests_per_round,
+                      options.num_requests - result.num_requests -
+                          round_requests.size());
+    std::vector<GeneratedRequest> next_round_requests;
+    const SwitchState snapshot = state;
+    std::optional<CoverageFeedback> feedback_snapshot;
+    if (options.coverage_guided) feedback_snapshot = stats.feedback;
+    std::thread generator([&] {
+      next_round_requests = GenerateRound(
+          ir_p4_info, options, round + 1, next_round_size, snapshot,
+          feedback_snapshot.has_value() ? &*feedback_snapshot : nullptr);
+    });
+    const absl::Status write_status =
+        SendAndCheck(ir_p4_info, round_requests, /*send_times=*/{}, write,
+                     state, result, stats);
+    generator.join();
+    RETURN_IF_ERROR(write_status)
+        << "in write request #" << result.num_requests << " of the campaign";
+
+    if (options.read != nullptr) {
+      touched_by_round.push_back(GetTouchedEntries(round_requests, state));
+      while (touched_by_round.size() >
+             static_cast<size_t>(options.verified_rounds)) {
+        touched_by_round.pop_front();
+      }
+      const bool full_verification =
+          options.full_verification_period > 0 &&
+          (round + 1) % options.full_verification_period == 0;
+      TouchedEntries touched;
+      if (full_verification) {
+        result.metrics.set_num_full_verifications(
+            result.metrics.num_full_verifications() + 1);
+      } else {
+        for (const TouchedEntries& round_touched : touched_by_round) {
+          touched.insert(round_touched.begin(), round_touched.end());
+        }
+      }
+      RETURN_IF_ERROR(VerifySwitchState(
+          options.read, state, full_verification ? nullptr : &touched, round,
+          result, stats))
+          << "in the verification after round #" << round << " of the campaign";
+    }
+
+    round_requests = std::move(next_round_requests);
+  }
+
+  RETURN_IF_ERROR(
+      FinishCampaign(start, stats, options.artifact_writer, result));
+  return result;
+}
+
+absl::StatusOr<FuzzCampaignResult> ReplayTrace(
+    const pdpi::IrP4Info& ir_p4_info, absl::Span<const Request> trace,
+    const TraceReplayOptions& options, const SwitchWriter& write,
+    SwitchState& state) {
+  if (options.speedup < 0 || options.mutation_probability < 0 ||
+      options.mutation_probability > 1) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Speedup must be >= 0 and mutation probability must be in [0, "
+              "1]. Speedup: "
+           << options.speedup
+           << ", mutation probability: " << options.mutation_probability;
+  }
+
+  // Mutations are applied up front against the initial state, so that they
+  // neither contend with the oracle for `state` nor delay the replay.
+  std::vector<GeneratedRequest> requests(trace.size());
+  std::seed_seq seeds{static_cast<uint32_t>(options.seed),
+                      static_cast<uint32_t>(options.seed >> 32)};
+  absl::BitGen gen(seeds);
+  for (int i = 0; i < static_cast<int>(trace.size()); ++i) {
+    requests[i].request = trace[i].pi();
+    requests[i].mutations.resize(requests[i].request.updates_size());
+    if (options.mutation_probability == 0) continue;
+    for (int j = 0; j < requests[i].request.updates_size(); ++j) {
+      if (!absl::Bernoulli(gen, options.mutation_probability)) continue;
+      const Mutation mutation = FuzzMutation(&gen);
+      // Not every mutation applies to every update; those are sent as is.
+      if (MutateUpdate(&gen, requests[i].request.mutable_updates(j),
+                       ir_p4_info, state, mutation)
+              .ok()) {
+        requests[i].mutations[j] = mutation;
+      }
+    }
+  }
+
+  const absl::Time start = absl::Now();
+  std::vector<absl::Time> send_times;
+  if (options.speedup > 0) {
+    send_times.reserve(trace.size());
+    for (const Request& request : trace) {
+      send_times.push_back(
+          start +
+          absl::Milliseconds(request.timestamp_request() -
+                             trace.front().timestamp_request()) /
+              options.speedup);
+    }
+  }
+
+  FuzzCampaignResult result;
+  CampaignStats stats;
+  RETURN_IF_ERROR(SendAndCheck(ir_p4_info, requests, send_times, write, state,
+                               result, stats))
+      << "in write request #" << result.num_requests << " of the trace";
+  RETURN_IF_ERROR(
+      FinishCampaign(start, stats, options.artifact_writer, result));
+  return result;
+}
+
+}  // namespace p4_fuzzer
@@ -0,0 +1,132 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_FUZZER_FUZZ_CAMPAIGN_H_
+#define PINS_P4_FUZZER_FUZZ_CAMPAIGN_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "gutil/test_artifact_writer.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/fuzzer.pb.h"
+#include "p4_fuzzer/switch_state.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace p4_fuzzer {
+
+// Sends a write request to the switch under test and returns the status of
+// each of its updates, in order. An error aborts the campaign.
+using SwitchWriter = std::function<absl::StatusOr<std::vector<p4::v1::Error>>(
+    const p4::v1::WriteRequest& request)>;
+
+// Reads entities from the switch under test and returns them, in any order.
+// An error aborts the campaign.
+using SwitchReader = std::function<absl::StatusOr<std::vector<p4::v1::Entity>>(
+    const p4::v1::ReadRequest& request)>;
+
+struct FuzzCampaignOptions {
+  // Seeds the random generators of all workers. Campaigns with the same seed,
+  // options and switch behavior generate the same requests.
+  uint64_t seed = 0;
+  // The number of threads generating write requests.
+  int num_workers = 4;
+  // The total number of write requests to send.
+  int num_requests = 1000;
+  // Requests are generated in rounds of this many requests. Each round is
+  // generated while the previous one is sent, against a snapshot of the switch
+  // state from before the previous round.
+  int requests_per_round = 100;
+  // If set, the campaign's metrics are stored through this writer as
+  // "fuzz_campaign_metrics.txtpb" once it completes.
+  gutil::TestArtifactWriter* artifact_writer = nullptr;
+  // If set, the switch state is read back after every round and compared with
+  // the expected state. Only the entries touched by the last
+  // `verified_rounds` rounds are read, each by its key, so verification does
+  // not slow down as the tables fill up.
+  SwitchReader read = nullptr;
+  int verified_rounds = 1;
+  // Every this many rounds, the whole switch state is read back and compared
+  // instead, to catch changes to entries that were not touched recently. 0
+  // never reads back the whole state.
+  int full_verification_period = 0;
+  // If set, generation is steered by the switch's responses so far. Each
+  // update's response class (table, mutation, response code, and error message
+  // class) is tracked, requests whose kinds of updates keep finding new
+  // response classes are preferred, and updates that found one are mutated
+  // again. See `CoverageFeedback`.
+  bool coverage_guided = false;
+};
+
+struct FuzzCampaignResult {
+  // The number of write requests sent to the switch.
+  int num_requests = 0;
+  // The problems found by `WriteRequestOracle`, in request order, and by the
+  // verification of the switch state after each round.
+  std::vector<std::string> problems;
+  // The wall time of the campaign, including generation of the first round.
+  absl::Duration duration;
+  // Throughput, latency, mutation and table coverage metrics.
+  FuzzCampaignMetrics metrics;
+
+  double RequestsPerSecond() const {
+    return num_requests / absl::ToDoubleSeconds(duration);
+  }
+};
+
+// Sends `options.num_requests` fuzzed write requests to the switch through
+// `write` and checks each response with `WriteRequestOracle`, starting from
+// (and updating) `state`, which must reflect the switch before the campaign.
+//
+// Generation, switch I/O and checking run concurrently: requests are generated
+// by `options.num_workers` threads, one round ahead of the requests being
+// sent, and the oracle checks each response on its own thread while the next
+// request is in flight. The generator of each (round, worker) pair is seeded
+// from `options.seed` and the pair, so the workers never share a generator.
+// With `options.read`, the switch state is verified between rounds, while no
+// requests are in flight.
+absl::StatusOr<FuzzCampaignResult> RunFuzzCampaign(
+    const pdpi::IrP4Info& ir_p4_info, const FuzzCampaignOptions& options,
+    const SwitchWriter& write, SwitchState& state);
+
+struct TraceReplayOptions {
+  // Requests are sent this many times faster than they were recorded, based on
+  // their `timestamp_request`. 0 sends them back to back.
+  double speedup = 1.0;
+  // The probability with which each update of the trace is mutated with a
+  // random `Mutation` before it is sent. Mutations the update does not support
+  // are skipped.
+  double mutation_probability = 0.0;
+  // Seeds the generator choosing and applying mutations.
+  uint64_t seed = 0;
+  // As in `FuzzCampaignOptions`.
+  gutil::TestArtifactWriter* artifact_writer = nullptr;
+};
+
+// Replays the write requests of a recorded `trace` (see `ReadWriteTrace`),
+// e.g. of production churn, instead of generating them, and checks and
+// measures the switch as `RunFuzzCampaign` does. `state` must reflect the
+// switch before the first request of the trace.
+absl::StatusOr<FuzzCampaignResult> ReplayTrace(
+    const pdpi::IrP4Info& ir_p4_info, absl::Span<const Request> trace,
+    const TraceReplayOptions& options, const SwitchWriter& write,
+    SwitchState& state);
+
+}  // namespace p4_fuzzer
+
+#endif  // PINS_P4_FUZZER_FUZZ_CAMPAIGN_H_
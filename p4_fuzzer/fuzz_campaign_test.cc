@@ -0,0 +1,395 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_fuzzer/fuzz_campaign.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/fuzzer.pb.h"
+#include "p4_fuzzer/switch_state.h"
+#include "p4_pdpi/ir.pb.h"
+#include "sai_p4/instantiations/google/sai_p4info.h"
+
+namespace p4_fuzzer {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::StatusIs;
+using ::p4::v1::Entity;
+using ::p4::v1::Error;
+using ::p4::v1::ReadRequest;
+using ::p4::v1::TableEntry;
+using ::p4::v1::WriteRequest;
+using ::testing::Contains;
+using ::testing::Each;
+using ::testing::HasSubstr;
+using ::testing::Not;
+using ::testing::SizeIs;
+
+const pdpi::IrP4Info& IrP4Info() {
+  return sai::GetIrP4Info(sai::Instantiation::kMiddleblock);
+}
+
+// Returns a writer that records each request in `requests` and rejects all of
+// its updates, so the switch state stays empty.
+SwitchWriter RecordingWriter(std::vector<WriteRequest>& requests) {
+  return [&requests](const WriteRequest& request)
+             -> absl::StatusOr<std::vector<Error>> {
+    requests.push_back(request);
+    Error error;
+    error.set_canonical_code(static_cast<int>(absl::StatusCode::kUnknown));
+    return std::vector<Error>(request.updates_size(), error);
+  };
+}
+
+TEST(FuzzCampaignTest, SendsTheRequestedNumberOfRequests) {
+  std::vector<WriteRequest> requests;
+  SwitchState state(IrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      FuzzCampaignResult result,
+      RunFuzzCampaign(IrP4Info(),
+                      {.num_workers = 3,
+                       .num_requests = 25,
+                       .requests_per_round = 10},
+                      RecordingWriter(requests), state));
+
+  EXPECT_EQ(result.num_requests, 25);
+  EXPECT_THAT(requests, SizeIs(25));
+  EXPECT_TRUE(state.AllTablesEmpty());
+}
+
+TEST(FuzzCampaignTest, CampaignsWithTheSameSeedSendTheSameRequests) {
+  const FuzzCampaignOptions options{.seed = 42,
+                                    .num_workers = 3,
+                                    .num_requests = 25,
+                                    .requests_per_round = 10};
+  std::vector<WriteRequest> first_requests;
+  SwitchState first_state(IrP4Info());
+  ASSERT_OK(RunFuzzCampaign(IrP4Info(), options,
+                            RecordingWriter(first_requests), first_state));
+  std::vector<WriteRequest> second_requests;
+  SwitchState second_state(IrP4Info());
+  ASSERT_OK(RunFuzzCampaign(IrP4Info(), options,
+                            RecordingWriter(second_requests), second_state));
+
+  ASSERT_THAT(second_requests, SizeIs(first_requests.size()));
+  for (int i = 0; i < first_requests.size(); ++i) {
+    EXPECT_THAT(second_requests[i], EqualsProto(first_requests[i]));
+  }
+}
+
+TEST(FuzzCampaignTest, ReportsMetrics) {
+  std::vector<WriteRequest> requests;
+  SwitchState state(IrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      FuzzCampaignResult result,
+      RunFuzzCampaign(IrP4Info(),
+                      {.num_requests = 10, .requests_per_round = 4},
+                      RecordingWriter(requests), state));
+  const FuzzCampaignMetrics& metrics = result.metrics;
+
+  int64_t num_updates = 0;
+  for (const WriteRequest& request : requests) {
+    num_updates += request.updates_size();
+  }
+  EXPECT_EQ(metrics.num_requests(), 10);
+  EXPECT_EQ(metrics.num_updates(), num_updates);
+  EXPECT_EQ(metrics.write_latency().count(), 10);
+  EXPECT_EQ(metrics.oracle_latency().count(), 10);
+
+  // The recording writer rejects every update.
+  int64_t num_rejected_updates = 0;
+  for (const auto& [table, coverage] : metrics.coverage_by_table()) {
+    EXPECT_EQ(coverage.accepted_updates(), 0) << table;
+    num_rejected_updates += coverage.rejected_updates();
+  }
+  EXPECT_EQ(num_rejected_updates, num_updates);
+}
+
+TEST(FuzzCampaignTest, ReportsResponseClasses) {
+  std::vector<WriteRequest> requests;
+  SwitchState state(IrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      FuzzCampaignResult result,
+      RunFuzzCampaign(IrP4Info(),
+                      {.num_requests = 10, .requests_per_round = 4},
+                      RecordingWriter(requests), state));
+
+  // Every update falls into exactly one response class.
+  EXPECT_GT(result.metrics.num_response_classes(), 0);
+  EXPECT_LE(result.metrics.num_response_classes(),
+            result.metrics.num_updates());
+}
+
+TEST(FuzzCampaignTest, CoverageGuidedCampaignsWithTheSameSeedAreRepeatable) {
+  const FuzzCampaignOptions options{.seed = 42,
+                                    .num_workers = 3,
+                                    .num_requests = 40,
+                                    .requests_per_round = 10,
+                                    .coverage_guided = true};
+  std::vector<WriteRequest> first_requests;
+  SwitchState first_state(IrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      FuzzCampaignResult result,
+      RunFuzzCampaign(IrP4Info(), options, RecordingWriter(first_requests),
+                      first_state));
+  std::vector<WriteRequest> second_requests;
+  SwitchState second_state(IrP4Info());
+  ASSERT_OK(RunFuzzCampaign(IrP4Info(), options,
+                            RecordingWriter(second_requests), second_state));
+
+  EXPECT_EQ(result.num_requests, 40);
+  ASSERT_THAT(second_requests, SizeIs(first_requests.size()));
+  for (int i = 0; i < first_requests.size(); ++i) {
+    EXPECT_THAT(second_requests[i], EqualsProto(first_requests[i]));
+  }
+}
+
+TEST(FuzzCampaignTest, WriteErrorsAbortTheCampaign) {
+  SwitchState state(IrP4Info());
+  int num_writes = 0;
+  SwitchWriter failing_writer = [&num_writes](const WriteRequest& request)
+      -> absl::StatusOr<std::vector<Error>> {
+    if (++num_writes == 3) return absl::UnavailableError("switch is down");
+    return std::vector<Error>(request.updates_size());
+  };
+
+  EXPECT_THAT(RunFuzzCampaign(IrP4Info(),
+                              {.num_requests = 10, .requests_per_round = 2},
+                              failing_writer, state),
+              StatusIs(absl::StatusCode::kUnavailable));
+  EXPECT_EQ(num_writes, 3);
+}
+
+TEST(FuzzCampaignTest, RejectsResponsesWithTheWrongNumberOfStatuses) {
+  SwitchState state(IrP4Info());
+  SwitchWriter writer =
+      [](const WriteRequest& request) -> absl::StatusOr<std::vector<Error>> {
+    return std::vector<Error>(request.updates_size() + 1);
+  };
+
+  EXPECT_THAT(RunFuzzCampaign(IrP4Info(), {.num_requests = 1}, writer, state),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
+// A switch that accepts every update it can apply to its own state, and serves
+// reads from that state.
+class FakeSwitch {
+ public:
+  FakeSwitch() : state_(IrP4Info()) {}
+
+  SwitchWriter Writer() {
+    return [this](const WriteRequest& request)
+               -> absl::StatusOr<std::vector<Error>> {
+      std::vector<Error> statuses(request.updates_size());
+      for (int i = 0; i < request.updates_size(); ++i) {
+        const p4::v1::Update& update = request.updates(i);
+        if (!absl::c_linear_search(state_.AllTableIds(),
+                                   update.entity().table_entry().table_id()) ||
+            !state_.ApplyUpdate(update).ok()) {
+          statuses[i].set_canonical_code(
+              static_cast<int>(absl::StatusCode::kInvalidArgument));
+        }
+      }
+      return statuses;
+    };
+  }
+
+  // Records each read request. Once `lose_entries` is set, reads return
+  // nothing.
+  SwitchReader Reader() {
+    return [this](const ReadRequest& request)
+               -> absl::StatusOr<std::vector<Entity>> {
+      read_requests_.push_back(request);
+      std::vector<Entity> entities;
+      if (lose_entries_) return entities;
+      for (const Entity& filter : request.entities()) {
+        if (filter.table_entry().table_id() == 0) {
+          for (uint32_t table_id : state_.AllTableIds()) {
+            for (const TableEntry& entry : state_.GetTableEntries(table_id)) {
+              *entities.emplace_back().mutable_table_entry() = entry;
+            }
+          }
+        } else if (const TableEntry* entry =
+                       state_.GetTableEntry(filter.table_entry());
+                   entry != nullptr) {
+          *entities.emplace_back().mutable_table_entry() = *entry;
+        }
+      }
+      return entities;
+    };
+  }
+
+  void LoseEntries() { lose_entries_ = true; }
+  const std::vector<ReadRequest>& read_requests() const {
+    return read_requests_;
+  }
+
+ private:
+  SwitchState state_;
+  bool lose_entries_ = false;
+  std::vector<ReadRequest> read_requests_;
+};
+
+TEST(FuzzCampaignTest, VerifiesTheEntriesTouchedByEachRoundByTheirKeys) {
+  FakeSwitch fake_switch;
+  SwitchState state(IrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      FuzzCampaignResult result,
+      RunFuzzCampaign(IrP4Info(),
+                      {.num_requests = 20,
+                       .requests_per_round = 5,
+                       .read = fake_switch.Reader(),
+                       .verified_rounds = 2},
+                      fake_switch.Writer(), state));
+
+  EXPECT_THAT(result.problems, Each(Not(HasSubstr("Round #"))));
+  EXPECT_GT(result.metrics.num_verified_entries(), 0);
+  EXPECT_EQ(result.metrics.num_full_verifications(), 0);
+  EXPECT_GT(result.metrics.verification_latency().count(), 0);
+  for (const ReadRequest& request : fake_switch.read_requests()) {
+    for (const Entity& filter : request.entities()) {
+      EXPECT_NE(filter.table_entry().table_id(), 0);
+    }
+  }
+}
+
+TEST(FuzzCampaignTest, ReportsEntriesMissingFromTheSwitch) {
+  FakeSwitch fake_switch;
+  fake_switch.LoseEntries();
+  SwitchState state(IrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      FuzzCampaignResult result,
+      RunFuzzCampaign(IrP4Info(),
+                      {.num_requests = 20,
+                       .requests_per_round = 5,
+                       .read = fake_switch.Reader()},
+                      fake_switch.Writer(), state));
+
+  EXPECT_FALSE(state.AllTablesEmpty());
+  EXPECT_THAT(result.problems,
+              Contains(HasSubstr("The switch is missing an entry")));
+}
+
+TEST(FuzzCampaignTest, PeriodicallyVerifiesTheWholeSwitch) {
+  FakeSwitch fake_switch;
+  SwitchState state(IrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      FuzzCampaignResult result,
+      RunFuzzCampaign(IrP4Info(),
+                      {.num_requests = 20,
+                       .requests_per_round = 5,
+                       .read = fake_switch.Reader(),
+                       .full_verification_period = 2},
+                      fake_switch.Writer(), state));
+
+  EXPECT_THAT(result.problems, Each(Not(HasSubstr("Round #"))));
+  EXPECT_EQ(result.metrics.num_full_verifications(), 2);
+  int num_full_reads = 0;
+  for (const ReadRequest& request : fake_switch.read_requests()) {
+    if (request.entities(0).table_entry().table_id() == 0) ++num_full_reads;
+  }
+  EXPECT_EQ(num_full_reads, 2);
+}
+
+TEST(FuzzCampaignTest, RejectsInvalidVerificationOptions) {
+  FakeSwitch fake_switch;
+  SwitchState state(IrP4Info());
+  EXPECT_THAT(RunFuzzCampaign(IrP4Info(),
+                              {.read = fake_switch.Reader(),
+                               .verified_rounds = 0},
+                              fake_switch.Writer(), state),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+// Returns a trace of `num_requests` requests recorded `interval` apart, each
+// inserting an entry into a table that does not exist.
+std::vector<Request> Trace(int num_requests, absl::Duration interval) {
+  std::vector<Request> trace(num_requests);
+  for (int i = 0; i < num_requests; ++i) {
+    trace[i].set_timestamp_request(absl::ToInt64Milliseconds(i * interval));
+    p4::v1::Update* update = trace[i].mutable_pi()->add_updates();
+    update->set_type(p4::v1::Update::INSERT);
+    update->mutable_entity()->mutable_table_entry()->set_table_id(i + 1);
+  }
+  return trace;
+}
+
+TEST(ReplayTraceTest, SendsTheRequestsOfTheTrace) {
+  const std::vector<Request> trace = Trace(5, absl::Milliseconds(10));
+  std::vector<WriteRequest> requests;
+  SwitchState state(IrP4Info());
+  ASSERT_OK_AND_ASSIGN(FuzzCampaignResult result,
+                       ReplayTrace(IrP4Info(), trace, {.speedup = 0},
+                                   RecordingWriter(requests), state));
+
+  EXPECT_EQ(result.num_requests, 5);
+  ASSERT_THAT(requests, SizeIs(5));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_THAT(requests[i], EqualsProto(trace[i].pi()));
+  }
+  EXPECT_EQ(result.metrics.coverage_by_table()
+                .at("<unknown table>")
+                .rejected_updates(),
+            5);
+}
+
+TEST(ReplayTraceTest, KeepsTheRecordedPaceScaledBySpeedup) {
+  std::vector<WriteRequest> requests;
+  SwitchState state(IrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      FuzzCampaignResult result,
+      ReplayTrace(IrP4Info(), Trace(3, absl::Milliseconds(100)),
+                  {.speedup = 2}, RecordingWriter(requests), state));
+
+  EXPECT_GE(result.duration, absl::Milliseconds(100));
+}
+
+TEST(ReplayTraceTest, MutationOverlaysAreCounted) {
+  std::vector<WriteRequest> requests;
+  SwitchState state(IrP4Info());
+  ASSERT_OK_AND_ASSIGN(
+      FuzzCampaignResult result,
+      ReplayTrace(IrP4Info(), Trace(20, absl::ZeroDuration()),
+                  {.speedup = 0, .mutation_probability = 1, .seed = 7},
+                  RecordingWriter(requests), state));
+
+  int64_t num_mutations = 0;
+  for (const auto& [mutation, count] :
+       result.metrics.num_updates_by_mutation()) {
+    num_mutations += count;
+  }
+  EXPECT_GT(num_mutations, 0);
+}
+
+TEST(ReplayTraceTest, RejectsInvalidOptions) {
+  std::vector<WriteRequest> requests;
+  SwitchState state(IrP4Info());
+  EXPECT_THAT(ReplayTrace(IrP4Info(), Trace(1, absl::ZeroDuration()),
+                          {.mutation_probability = 2},
+                          RecordingWriter(requests), state),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace p4_fuzzer
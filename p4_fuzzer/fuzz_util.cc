@@ -202,7 +202,7 @@ AnnotatedUpdate FuzzUpdate(absl::BitGen* gen, const pdpi::IrP4Info& ir_p4_info,
       // just invalid (and it is the oracle's job to know what the switch is
       // supposed to do with this).
       TableEntry table_entry =
-          UniformFromVector(gen, switch_state.GetTableEntries(table_id));
+          UniformFromSpan(gen, switch_state.GetTableEntries(table_id));
       FuzzNonKeyFields(gen, &table_entry);
       *update.mutable_entity()->mutable_table_entry() = table_entry;
       break;
@@ -512,7 +512,7 @@ std::vector<AnnotatedTableEntry> ValidForwardingEntries(
 
     do {
       entry = FuzzValidTableEntry(gen, ir_p4_info, FuzzTableId(gen, state));
-    } while (state.GetTableEntry(entry) != absl::nullopt);
+    } while (state.GetTableEntry(entry) != nullptr);
 
     p4::v1::Update update;
     update.set_type(p4::v1::Update::INSERT);
@@ -19,6 +19,7 @@
 
 #include "absl/random/random.h"
 #include "absl/strings/match.h"
+#include "absl/types/span.h"
 #include "glog/logging.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/v1/p4runtime.pb.h"
@@ -40,6 +41,13 @@ const T& UniformFromVector(absl::BitGen* gen, const std::vector<T>& vec) {
   return vec[index];
 }
 
+template <typename T>
+const T& UniformFromSpan(absl::BitGen* gen, absl::Span<const T> span) {
+  CHECK(!span.empty());
+  int index = absl::Uniform<int>(*gen, /*lo=*/0, /*hi=*/span.size());
+  return span[index];
+}
+
 // Takes a string `data` that represents a number in network byte
 // order (big-endian), and masks off all but the least significant `used_bits`
 // bits.
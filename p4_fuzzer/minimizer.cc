@@ -0,0 +1,224 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_fuzzer/minimizer.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <thread>  // NOLINT: third_party code.
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/fuzz_campaign.h"
+#include "p4_fuzzer/oracle_util.h"
+#include "p4_fuzzer/switch_state.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace p4_fuzzer {
+namespace {
+
+using ::p4::v1::Error;
+using ::p4::v1::WriteRequest;
+
+// The position of an update in the original history.
+struct UpdatePosition {
+  int request;
+  int update;
+};
+
+// Returns the requests made of the updates at `positions`, which must be in
+// history order. Updates of the same original request stay in one request.
+std::vector<WriteRequest> ToRequests(
+    absl::Span<const WriteRequest> history,
+    absl::Span<const UpdatePosition> positions) {
+  std::vector<WriteRequest> requests;
+  int last_request = -1;
+  for (const UpdatePosition& position : positions) {
+    if (position.request != last_request) {
+      WriteRequest& request = requests.emplace_back(history[position.request]);
+      request.clear_updates();
+      last_request = position.request;
+    }
+    *requests.back().add_updates() =
+        history[position.request].updates(position.update);
+  }
+  return requests;
+}
+
+// Splits `positions` into `n` contiguous chunks of nearly equal size.
+std::vector<std::vector<UpdatePosition>> Split(
+    absl::Span<const UpdatePosition> positions, int n) {
+  std::vector<std::vector<UpdatePosition>> chunks;
+  chunks.reserve(n);
+  int begin = 0;
+  for (int i = 0; i < n; ++i) {
+    const int end = (positions.size() * (i + 1)) / n;
+    chunks.emplace_back(positions.begin() + begin, positions.begin() + end);
+    begin = end;
+  }
+  return chunks;
+}
+
+// Returns all chunks except the one at `index`, concatenated.
+std::vector<UpdatePosition> Complement(
+    absl::Span<const std::vector<UpdatePosition>> chunks, int index) {
+  std::vector<UpdatePosition> complement;
+  for (int i = 0; i < static_cast<int>(chunks.size()); ++i) {
+    if (i == index) continue;
+    complement.insert(complement.end(), chunks[i].begin(), chunks[i].end());
+  }
+  return complement;
+}
+
+// Replays a sequence of candidates and returns the index of the first that
+// reproduces the failure, or nullopt if none does. Replays up to
+// `options.num_parallel_replays` candidates at a time and stops at the first
+// batch with a reproducing candidate, or once `num_replays` reaches
+// `options.max_replays`.
+absl::StatusOr<std::optional<int>> FirstReproducingCandidate(
+    absl::Span<const WriteRequest> history,
+    absl::Span<const std::vector<UpdatePosition>> candidates,
+    const ReproducesFailure& reproduces_failure,
+    const MinimizerOptions& options, int& num_replays) {
+  for (int begin = 0; begin < static_cast<int>(candidates.size());) {
+    const int batch_size = std::min<int>(
+        {options.num_parallel_replays, options.max_replays - num_replays,
+         static_cast<int>(candidates.size()) - begin});
+    if (batch_size <= 0) return std::nullopt;
+
+    std::vector<absl::StatusOr<bool>> results(batch_size, false);
+    std::vector<std::thread> threads;
+    threads.reserve(batch_size);
+    for (int i = 0; i < batch_size; ++i) {
+      threads.emplace_back([&, i] {
+        results[i] =
+            reproduces_failure(ToRequests(history, candidates[begin + i]));
+      });
+    }
+    for (std::thread& thread : threads) thread.join();
+    num_replays += batch_size;
+
+    // Picks the first reproducing candidate in order, so the result does not
+    // depend on the number of parallel replays.
+    for (int i = 0; i < batch_size; ++i) {
+      RETURN_IF_ERROR(results[i].status())
+          << "while replaying a candidate reproducer";
+      if (*results[i]) return begin + i;
+    }
+    begin += batch_size;
+  }
+  return std::nullopt;
+}
+
+}  // namespace
+
+absl::StatusOr<MinimizedReproducer> MinimizeReproducer(
+    absl::Span<const WriteRequest> requests,
+    const ReproducesFailure& reproduces_failure,
+    const MinimizerOptions& options) {
+  if (options.num_parallel_replays <= 0 || options.max_replays <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Number of parallel replays and max replays must be > 0. "
+              "Number of parallel replays: "
+           << options.num_parallel_replays
+           << ", max replays: " << options.max_replays;
+  }
+
+  std::vector<UpdatePosition> current;
+  for (int i = 0; i < static_cast<int>(requests.size()); ++i) {
+    for (int j = 0; j < requests[i].updates_size(); ++j) {
+      current.push_back({.request = i, .update = j});
+    }
+  }
+
+  MinimizedReproducer result;
+  ASSIGN_OR_RETURN(bool reproduces,
+                   reproduces_failure(ToRequests(requests, current)),
+                   _ << "while replaying the full history");
+  ++result.num_replays;
+  if (!reproduces) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "The full history of " << current.size()
+           << " updates does not reproduce the failure";
+  }
+
+  // Delta debugging (ddmin): tries each of `n` chunks on its own, then each
+  // complement of a chunk, and refines the granularity when neither
+  // reproduces.
+  int n = 2;
+  while (current.size() >= 2 && result.num_replays < options.max_replays) {
+    n = std::min<int>(n, current.size());
+    std::vector<std::vector<UpdatePosition>> candidates = Split(current, n);
+    // For n = 2, the complements are the chunks themselves.
+    if (n > 2) {
+      candidates.reserve(2 * n);
+      for (int i = 0; i < n; ++i) {
+        candidates.push_back(
+            Complement(absl::MakeConstSpan(candidates).first(n), i));
+      }
+    }
+
+    ASSIGN_OR_RETURN(std::optional<int> reproducing,
+                     FirstReproducingCandidate(requests, candidates,
+                                               reproduces_failure, options,
+                                               result.num_replays));
+    if (reproducing.has_value()) {
+      current = std::move(candidates[*reproducing]);
+      n = *reproducing < n ? 2 : std::max(n - 1, 2);
+    } else if (n == static_cast<int>(current.size())) {
+      break;
+    } else {
+      n *= 2;
+    }
+  }
+
+  result.requests = ToRequests(requests, current);
+  return result;
+}
+
+ReproducesFailure OracleReproducesFailure(
+    const pdpi::IrP4Info& ir_p4_info, const SwitchState& initial_state,
+    std::function<absl::Status()> reset_switch, SwitchWriter write) {
+  return [&ir_p4_info, &initial_state, reset_switch = std::move(reset_switch),
+          write = std::move(write)](
+             absl::Span<const WriteRequest> requests) -> absl::StatusOr<bool> {
+    RETURN_IF_ERROR(reset_switch()) << "while resetting the switch";
+    SwitchState state = initial_state;
+    for (const WriteRequest& request : requests) {
+      ASSIGN_OR_RETURN(std::vector<Error> statuses, write(request));
+      if (statuses.size() != static_cast<size_t>(request.updates_size())) {
+        return gutil::InternalErrorBuilder()
+               << "Expected " << request.updates_size()
+               << " update statuses, but the switch returned "
+               << statuses.size();
+      }
+      if (WriteRequestOracle(ir_p4_info, request, statuses, state)
+              .has_value()) {
+        return true;
+      }
+      for (int i = 0; i < request.updates_size(); ++i) {
+        if (statuses[i].canonical_code() != 0) continue;
+        RETURN_IF_ERROR(state.ApplyUpdate(request.updates(i)));
+      }
+    }
+    return false;
+  };
+}
+
+}  // namespace p4_fuzzer
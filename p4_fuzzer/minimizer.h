@@ -0,0 +1,74 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_FUZZER_MINIMIZER_H_
+#define PINS_P4_FUZZER_MINIMIZER_H_
+
+#include <functional>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_fuzzer/fuzz_campaign.h"
+#include "p4_fuzzer/switch_state.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace p4_fuzzer {
+
+// Replays `requests` from a fixed initial switch state and returns true iff
+// the failure being minimized still occurs.
+using ReproducesFailure = std::function<absl::StatusOr<bool>(
+    absl::Span<const p4::v1::WriteRequest> requests)>;
+
+struct MinimizerOptions {
+  // The number of candidates replayed concurrently. Values above 1 require
+  // `ReproducesFailure` to be thread-safe, e.g. by replaying each call on a
+  // different switch of the testbed.
+  int num_parallel_replays = 1;
+  // Minimization stops after this many replays and returns the smallest
+  // reproducer found so far.
+  int max_replays = 10000;
+};
+
+struct MinimizedReproducer {
+  // A subsequence of the original updates that still reproduces the failure,
+  // grouped into requests as in the original history.
+  std::vector<p4::v1::WriteRequest> requests;
+  // The number of times the failure was replayed.
+  int num_replays = 0;
+};
+
+// Shrinks the history `requests` of a failure to a 1-minimal set of updates
+// using delta debugging: removing any single remaining update makes the
+// failure disappear (unless `options.max_replays` is exhausted first).
+// Candidates are subsequences of the original updates, so the relative order
+// of updates and their grouping into requests is preserved. Returns an error
+// if the full history does not reproduce the failure.
+absl::StatusOr<MinimizedReproducer> MinimizeReproducer(
+    absl::Span<const p4::v1::WriteRequest> requests,
+    const ReproducesFailure& reproduces_failure,
+    const MinimizerOptions& options = {});
+
+// Returns a `ReproducesFailure` that resets the switch with `reset_switch`,
+// sends the requests with `write`, and checks each response with
+// `WriteRequestOracle` against a snapshot of `initial_state`, which must
+// reflect the switch after `reset_switch`. A failure reproduces iff the oracle
+// reports a problem. `ir_p4_info` and `initial_state` must outlive the result.
+ReproducesFailure OracleReproducesFailure(
+    const pdpi::IrP4Info& ir_p4_info, const SwitchState& initial_state,
+    std::function<absl::Status()> reset_switch, SwitchWriter write);
+
+}  // namespace p4_fuzzer
+
+#endif  // PINS_P4_FUZZER_MINIMIZER_H_
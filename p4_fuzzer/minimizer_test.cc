@@ -0,0 +1,140 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_fuzzer/minimizer.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
+
+namespace p4_fuzzer {
+namespace {
+
+using ::gutil::StatusIs;
+using ::p4::v1::WriteRequest;
+using ::testing::Contains;
+using ::testing::ElementsAre;
+using ::testing::Ge;
+
+// Returns `num_requests` requests of `updates_per_request` updates each, where
+// the table ID of each update is its position in the history.
+std::vector<WriteRequest> History(int num_requests, int updates_per_request) {
+  std::vector<WriteRequest> requests(num_requests);
+  int id = 0;
+  for (WriteRequest& request : requests) {
+    for (int i = 0; i < updates_per_request; ++i) {
+      request.add_updates()
+          ->mutable_entity()
+          ->mutable_table_entry()
+          ->set_table_id(id++);
+    }
+  }
+  return requests;
+}
+
+std::vector<uint32_t> TableIds(absl::Span<const WriteRequest> requests) {
+  std::vector<uint32_t> ids;
+  for (const WriteRequest& request : requests) {
+    for (const p4::v1::Update& update : request.updates()) {
+      ids.push_back(update.entity().table_entry().table_id());
+    }
+  }
+  return ids;
+}
+
+// Fails iff updates with all of `ids` are replayed.
+ReproducesFailure FailsWithAll(std::vector<uint32_t> ids) {
+  return [ids](absl::Span<const WriteRequest> requests)
+             -> absl::StatusOr<bool> {
+    std::vector<uint32_t> replayed = TableIds(requests);
+    return absl::c_all_of(ids, [&](uint32_t id) {
+      return absl::c_linear_search(replayed, id);
+    });
+  };
+}
+
+TEST(MinimizeReproducerTest, FindsMinimalSetOfUpdates) {
+  const std::vector<WriteRequest> history =
+      History(/*num_requests=*/50, /*updates_per_request=*/20);
+  ASSERT_OK_AND_ASSIGN(
+      MinimizedReproducer reproducer,
+      MinimizeReproducer(history, FailsWithAll({17, 433, 998})));
+
+  EXPECT_THAT(TableIds(reproducer.requests), ElementsAre(17, 433, 998));
+  // Each update keeps the request it came from.
+  EXPECT_EQ(reproducer.requests.size(), 3);
+  EXPECT_THAT(reproducer.num_replays, Ge(1));
+}
+
+TEST(MinimizeReproducerTest, ParallelReplaysFindTheSameReproducer) {
+  const std::vector<WriteRequest> history =
+      History(/*num_requests=*/10, /*updates_per_request=*/10);
+  absl::Mutex mutex;
+  int num_calls = 0;
+  const ReproducesFailure fails = FailsWithAll({3, 4, 71});
+  const ReproducesFailure counting_fails =
+      [&](absl::Span<const WriteRequest> requests) {
+        absl::MutexLock lock(&mutex);
+        ++num_calls;
+        return fails(requests);
+      };
+
+  ASSERT_OK_AND_ASSIGN(MinimizedReproducer sequential,
+                       MinimizeReproducer(history, fails));
+  ASSERT_OK_AND_ASSIGN(
+      MinimizedReproducer parallel,
+      MinimizeReproducer(history, counting_fails,
+                         {.num_parallel_replays = 8}));
+
+  EXPECT_EQ(TableIds(parallel.requests), TableIds(sequential.requests));
+  EXPECT_THAT(TableIds(parallel.requests), ElementsAre(3, 4, 71));
+  EXPECT_EQ(num_calls, parallel.num_replays);
+}
+
+TEST(MinimizeReproducerTest, StopsAfterMaxReplays) {
+  const std::vector<WriteRequest> history =
+      History(/*num_requests=*/10, /*updates_per_request=*/10);
+  ASSERT_OK_AND_ASSIGN(
+      MinimizedReproducer reproducer,
+      MinimizeReproducer(history, FailsWithAll({5}), {.max_replays = 3}));
+
+  EXPECT_EQ(reproducer.num_replays, 3);
+  EXPECT_THAT(TableIds(reproducer.requests), Contains(5));
+}
+
+TEST(MinimizeReproducerTest, RejectsHistoriesThatDoNotReproduce) {
+  EXPECT_THAT(MinimizeReproducer(History(2, 2), FailsWithAll({100})),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(MinimizeReproducerTest, PropagatesReplayErrors) {
+  EXPECT_THAT(
+      MinimizeReproducer(History(2, 2),
+                         [](absl::Span<const WriteRequest>)
+                             -> absl::StatusOr<bool> {
+                           return absl::UnavailableError("switch is down");
+                         }),
+      StatusIs(absl::StatusCode::kUnavailable));
+}
+
+}  // namespace
+}  // namespace p4_fuzzer
@@ -232,7 +232,7 @@ absl::Status MutateDuplicateInsert(absl::BitGen* gen, p4::v1::Update* update,
   std::vector<TableEntry> entries;
 
   for (auto id : switch_state.AllTableIds()) {
-    std::vector<TableEntry> entries_from_table =
+    absl::Span<const TableEntry> entries_from_table =
         switch_state.GetTableEntries(id);
     entries.insert(entries.end(), entries_from_table.begin(),
                    entries_from_table.end());
@@ -256,7 +256,7 @@ absl::Status MutateNonexistingDelete(absl::BitGen* gen, p4::v1::Update* update,
   const int table_id = FuzzTableId(gen, switch_state);
 
   p4::v1::TableEntry entry = FuzzValidTableEntry(gen, ir_p4_info, table_id);
-  if (switch_state.GetTableEntry(entry) != absl::nullopt) {
+  if (switch_state.GetTableEntry(entry) != nullptr) {
     return absl::InternalError("Generated entry that exists in switch");
   }
 
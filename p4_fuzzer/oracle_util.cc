@@ -47,9 +47,8 @@ absl::Status UpdateOracle(const pdpi::IrP4Info& ir_p4_info,
     }
   } else {
     const TableEntry& table_entry = update.entity().table_entry();
-    const absl::optional<TableEntry>& previous =
-        state.GetTableEntry(table_entry);
-    bool exists = previous.has_value();
+    const TableEntry* previous = state.GetTableEntry(table_entry);
+    bool exists = previous != nullptr;
     switch (update.type()) {
       case p4::v1::Update::DELETE:
         if (exists) {
@@ -100,12 +99,11 @@ absl::Status UpdateOracle(const pdpi::IrP4Info& ir_p4_info,
 // description of why this sequence is not valid otherwise.
 absl::optional<std::string> SequenceOfUpdatesOracle(
     const pdpi::IrP4Info& ir_p4_info,
-    const std::vector<IndexUpdateStatus>& updates,
-    const SwitchState& initial_state) {
+    const std::vector<IndexUpdateStatus>& updates, SwitchState& state) {
   std::vector<absl::Status> oracle_failures;
 
-  // Create a copy of the state.
-  SwitchState state = initial_state;
+  // Apply the updates speculatively, and undo them before returning.
+  state.Checkpoint();
 
   // Go through all updates and check if the status makes sense in the current
   // state.
@@ -134,6 +132,7 @@ absl::optional<std::string> SequenceOfUpdatesOracle(
     }
   }
 
+  state.RollBack();
   if (error.empty()) return absl::nullopt;
   return error.substr(1);
 }
@@ -141,7 +140,7 @@ absl::optional<std::string> SequenceOfUpdatesOracle(
 // See go/p4-fuzzing for more info on the design.
 absl::optional<std::vector<std::string>> WriteRequestOracle(
     const pdpi::IrP4Info& ir_p4_info, const WriteRequest& request,
-    const absl::Span<const Error>& statuses, const SwitchState& state) {
+    const absl::Span<const Error>& statuses, SwitchState& state) {
   // For now, we only support checking requests with table entries.
   CHECK(absl::c_all_of(request.updates(), [](const Update& update) {
     return update.entity().has_table_entry();
@@ -178,7 +177,7 @@ absl::optional<std::vector<std::string>> WriteRequestOracle(
     do {
       absl::optional<std::string> res = absl::nullopt;
       // Optimization: If there is just a single update, we don't need to invoke
-      // SequenceOfUpdatesOracle and can avoid the state copy.
+      // SequenceOfUpdatesOracle and can avoid touching the state.
       if (updates.size() == 1) {
         const auto& update_oracle_result = UpdateOracle(
             ir_p4_info, updates[0].update, updates[0].status, state);
@@ -282,4 +281,11 @@ absl::optional<std::vector<std::string>> WriteRequestOracle(
   return problems;
 }
 
+absl::optional<std::vector<std::string>> WriteRequestOracle(
+    const pdpi::IrP4Info& ir_p4_info, const WriteRequest& request,
+    const absl::Span<const Error>& statuses, const SwitchState& state) {
+  SwitchState scratch_state = state;
+  return WriteRequestOracle(ir_p4_info, request, statuses, scratch_state);
+}
+
 }  // namespace p4_fuzzer
@@ -44,6 +44,15 @@ absl::Status UpdateOracle(const pdpi::IrP4Info& ir_p4_info,
 // Takes a batch and checks whether the way the switch responded is legal.  For
 // now, batches are processed in sequence.  Returns nullopt if everything is
 // valid, and a list of problems otherwise.
+//
+// Updates are replayed speculatively on `state` and rolled back before
+// returning, so `state` is left unchanged and the cost is proportional to the
+// size of the batch rather than to that of the state.
+absl::optional<std::vector<std::string>> WriteRequestOracle(
+    const pdpi::IrP4Info& ir_p4_info, const p4::v1::WriteRequest& request,
+    const absl::Span<const ::p4::v1::Error>& statuses, SwitchState& state);
+
+// As above, but replays the updates on a copy of `state`.
 absl::optional<std::vector<std::string>> WriteRequestOracle(
     const pdpi::IrP4Info& ir_p4_info, const p4::v1::WriteRequest& request,
     const absl::Span<const ::p4::v1::Error>& statuses,
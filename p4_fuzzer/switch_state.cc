@@ -3,11 +3,13 @@
 #include <algorithm>
 #include <iterator>
 #include <set>
+#include <utility>
 
 #include "absl/algorithm/container.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/optional.h"
 #include "glog/logging.h"
 #include "gutil/collections.h"
 #include "gutil/status.h"
@@ -28,11 +30,44 @@ std::string GetTableName(const IrP4Info& info, const uint32_t table_id) {
   return FindOrDie(info.tables_by_id(), table_id).preamble().alias();
 }
 
+// Inserts `entry` into `table`. Returns false if an entry with the same key is
+// already present.
+bool InsertEntry(TableEntries& table, TableEntry entry) {
+  auto [iter, not_present] = table.index.insert(
+      /*value=*/{TableEntryKey(entry), static_cast<int>(table.entries.size())});
+  if (!not_present) return false;
+  table.entries.push_back(std::move(entry));
+  return true;
+}
+
+// Removes the entry with the same key as `entry` from `table` and returns it,
+// or nullopt if there is no such entry. Fills the hole with the last entry, so
+// deletion takes constant time.
+absl::optional<TableEntry> EraseEntry(TableEntries& table,
+                                      const TableEntry& entry) {
+  auto iter = table.index.find(TableEntryKey(entry));
+  if (iter == table.index.end()) return absl::nullopt;
+  const int index = iter->second;
+  table.index.erase(iter);
+  TableEntry erased = std::move(table.entries[index]);
+  if (index != static_cast<int>(table.entries.size()) - 1) {
+    table.entries[index] = std::move(table.entries.back());
+    table.index[TableEntryKey(table.entries[index])] = index;
+  }
+  table.entries.pop_back();
+  return erased;
+}
+
 }  // namespace
 
-SwitchState::SwitchState(IrP4Info ir_p4info) : ir_p4info_(ir_p4info) {
-  for (auto& [table_id, table] : ir_p4info_.tables_by_id()) {
+SwitchState::SwitchState(IrP4Info ir_p4info)
+    : SwitchState(pdpi::SharedIrP4Info(std::move(ir_p4info))) {}
+
+SwitchState::SwitchState(pdpi::SharedIrP4Info ir_p4info)
+    : ir_p4info_(std::move(ir_p4info)) {
+  for (auto& [table_id, table] : ir_p4info_.info().tables_by_id()) {
     tables_[table_id] = TableEntries();
+    table_ids_.push_back(table_id);
   }
 }
 
@@ -51,102 +86,108 @@ bool SwitchState::IsTableFull(const uint32_t table_id) const {
 }
 
 int64_t SwitchState::GetNumTableEntries(const uint32_t table_id) const {
-  return FindOrDie(tables_, table_id).size();
+  return FindOrDie(tables_, table_id).entries.size();
 }
 
 int64_t SwitchState::GetNumTableEntries() const {
   int result = 0;
   for (const auto& [key, table] : tables_) {
-    result += table.size();
+    result += table.entries.size();
   }
   return result;
 }
 
-const std::vector<uint32_t> SwitchState::AllTableIds() const {
-  std::vector<uint32_t> table_ids;
-
-  for (auto& [key, table] : ir_p4info_.tables_by_id()) {
-    table_ids.push_back(key);
-  }
-
-  return table_ids;
-}
-
 bool SwitchState::CanAccommodateInserts(const uint32_t table_id,
                                         const int n) const {
-  return (FindOrDie(ir_p4info_.tables_by_id(), table_id).size() -
+  return (FindOrDie(ir_p4info_.info().tables_by_id(), table_id).size() -
           GetNumTableEntries(table_id)) >= n;
 }
 
 bool SwitchState::IsTableEmpty(const uint32_t table_id) const {
-  return FindOrDie(tables_, table_id).empty();
+  return FindOrDie(tables_, table_id).entries.empty();
 }
 
-std::vector<TableEntry> SwitchState::GetTableEntries(
+absl::Span<const TableEntry> SwitchState::GetTableEntries(
     const uint32_t table_id) const {
-  std::vector<TableEntry> result;
-
-  for (const auto& [key, entry] : FindOrDie(tables_, table_id)) {
-    result.push_back(entry);
-  }
-
-  return result;
+  return FindOrDie(tables_, table_id).entries;
 }
 
-absl::optional<TableEntry> SwitchState::GetTableEntry(TableEntry entry) const {
-  auto table = FindOrDie(tables_, entry.table_id());
+const TableEntry* SwitchState::GetTableEntry(const TableEntry& entry) const {
+  const TableEntries& table = FindOrDie(tables_, entry.table_id());
 
-  if (auto table_iter = table.find(TableEntryKey(entry));
-      table_iter != table.end()) {
-    auto [table_key, table_entry] = *table_iter;
-    return table_entry;
+  if (auto index_iter = table.index.find(TableEntryKey(entry));
+      index_iter != table.index.end()) {
+    return &table.entries[index_iter->second];
   }
 
-  return absl::nullopt;
+  return nullptr;
 }
 
 absl::Status SwitchState::ApplyUpdate(const Update& update) {
   const int table_id = update.entity().table_entry().table_id();
 
-  auto& table = FindOrDie(tables_, table_id);
+  TableEntries& table = FindOrDie(tables_, table_id);
 
-  TableEntry table_entry = update.entity().table_entry();
+  const TableEntry& table_entry = update.entity().table_entry();
 
   switch (update.type()) {
     case Update::INSERT: {
-      auto [iter, not_present] =
-          table.insert(/*value=*/{TableEntryKey(table_entry), table_entry});
-
-      if (!not_present) {
+      if (!InsertEntry(table, table_entry)) {
         return gutil::InvalidArgumentErrorBuilder()
                << "Cannot install the same table entry multiple times. Update: "
                << update.DebugString();
       }
+      if (!checkpoints_.empty()) {
+        undo_log_.push_back({/*inserted=*/true, table_entry});
+      }
       break;
     }
 
-    case Update::DELETE:
-      if (tables_[table_id].erase(TableEntryKey(table_entry)) != 1) {
+    case Update::DELETE: {
+      absl::optional<TableEntry> erased = EraseEntry(table, table_entry);
+      if (!erased.has_value()) {
         return gutil::InvalidArgumentErrorBuilder()
                << "Cannot erase non-existent table entries. Update: "
                << update.DebugString();
       }
+      if (!checkpoints_.empty()) {
+        undo_log_.push_back({/*inserted=*/false, *std::move(erased)});
+      }
       break;
+    }
     default:
       LOG(FATAL) << "Update of unsupported type: " << update.DebugString();
   }
   return absl::OkStatus();
 }
 
+void SwitchState::Checkpoint() { checkpoints_.push_back(undo_log_.size()); }
+
+void SwitchState::RollBack() {
+  CHECK(!checkpoints_.empty());  // Crash okay
+  const int checkpoint = checkpoints_.back();
+  checkpoints_.pop_back();
+  while (static_cast<int>(undo_log_.size()) > checkpoint) {
+    UndoRecord& record = undo_log_.back();
+    TableEntries& table = FindOrDie(tables_, record.entry.table_id());
+    if (record.inserted) {
+      CHECK(EraseEntry(table, record.entry).has_value());  // Crash okay
+    } else {
+      CHECK(InsertEntry(table, std::move(record.entry)));  // Crash okay
+    }
+    undo_log_.pop_back();
+  }
+}
+
 std::string SwitchState::SwitchStateSummary() const {
   if (tables_.empty()) return std::string("EmptyState()");
   std::string res = "";
   int total = 0;
   for (const auto& [table_id, table] : tables_) {
-    total += table.size();
+    total += table.entries.size();
 
-    StrAppend(&res, "\n  ", absl::StrFormat("% 10d", table.size()), " ",
-              GetTableName(ir_p4info_, table_id));
+    StrAppend(&res, "\n  ", absl::StrFormat("% 10d", table.entries.size()),
+              " ", GetTableName(ir_p4info_.info(), table_id));
   }
 
   return StrCat("State(", "\n  ", StrFormat("% 10d", total),
@@ -1,40 +1,51 @@
 #ifndef P4_FUZZER_SWITCH_STATE_H_
 #define P4_FUZZER_SWITCH_STATE_H_
 
+#include <cstdint>
 #include <cstdio>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
-#include "absl/container/node_hash_map.h"
 #include "absl/status/status.h"
-#include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "glog/logging.h"
 #include "gutil/status.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_fuzzer/table_entry_key.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/shared_ir_p4info.h"
 
 namespace p4_fuzzer {
 
 // Only a subset of the fields of TableEntry are used for equality in P4Runtime
-// (as part of the class TableEntryKey). We use an instance of TableEntryKey
-// generated from a TableEntry as the key in an absl::node_hash_map.
-// Therefore, the class SwitchState must preserve the invariant that:
-//   forall t1, t2. table_[t1] = t2  ==> t1 = TableEntryKey(t2)
+// (as part of the class TableEntryKey). The entries of a table are stored
+// contiguously, and an instance of TableEntryKey generated from a TableEntry
+// maps to the entry's index in an absl::flat_hash_map. Therefore, the class
+// SwitchState must preserve the invariant that:
+//   forall k, i. index[k] = i  ==> k = TableEntryKey(entries[i])
 //   TableEntryKey() here is the constructor for the class TableEntryKey.
-using TableEntries = absl::node_hash_map<TableEntryKey, p4::v1::TableEntry>;
+struct TableEntries {
+  std::vector<p4::v1::TableEntry> entries;
+  absl::flat_hash_map<TableEntryKey, int> index;
+};
 
 // Tracks the state of a switch, with methods to apply updates or query the
 // current state. The class assumes all calls are valid (e.g table_ids must all
 // exist). Crashes if that is not the case.
+//
+// Lookups take constant time and never copy entries. Pointers and spans
+// returned by SwitchState are invalidated by the next call to `ApplyUpdate`.
 class SwitchState {
  public:
   // SwitchState needs to know the (PDPI internal representation of the) P4Info
   // of the P4 program P4 fuzzer is fuzzing in order to implement its functions
   // in a program independent manner.
   SwitchState(pdpi::IrP4Info ir_p4info);
+  // Shares `ir_p4info` instead of copying it, so SwitchStates are cheap to
+  // create and copy.
+  explicit SwitchState(pdpi::SharedIrP4Info ir_p4info);
 
   // Returns true if the table is at its resource limit. This means that there
   // is no guarantee that any further entry will fit into this table. Whether
@@ -50,8 +61,8 @@ class SwitchState {
   // Returns true iff the given table can accommodate at least n more entries.
   bool CanAccommodateInserts(const uint32_t table_id, const int n) const;
 
-  // Returns all table entries in a given table.
-  std::vector<p4::v1::TableEntry> GetTableEntries(
+  // Returns all table entries in a given table, in no particular order.
+  absl::Span<const p4::v1::TableEntry> GetTableEntries(
       const uint32_t table_id) const;
 
   // Returns the number of table entries in a given table.
@@ -60,19 +71,28 @@ class SwitchState {
   // Returns the total number of table entries in all tables.
   int64_t GetNumTableEntries() const;
 
-  // Returns the current state of a table entry (or nullopt if it is not
+  // Returns the current state of a table entry (or nullptr if it is not
   // present).  Only the uniquely identifying fields of entry are considered.
-  absl::optional<p4::v1::TableEntry> GetTableEntry(
-      p4::v1::TableEntry entry) const;
+  const p4::v1::TableEntry* GetTableEntry(
+      const p4::v1::TableEntry& entry) const;
 
   // Returns the list of all non-const table IDs in the underlying P4 program.
-  const std::vector<uint32_t> AllTableIds() const;
+  const std::vector<uint32_t>& AllTableIds() const { return table_ids_; }
 
   // Applies the given update to the given table entries. Assumes that all
   // updates can actually be applied successfully e.g for INSERT, an entry
   // cannot already be present, and returns an error otherwise.
   absl::Status ApplyUpdate(const p4::v1::Update& update);
 
+  // Marks the current state, so that `RollBack` can later restore it in time
+  // proportional to the number of updates applied since, rather than to the
+  // size of the state. Checkpoints nest.
+  void Checkpoint();
+
+  // Undoes all updates applied since the most recent checkpoint and removes
+  // that checkpoint. Must only be called after `Checkpoint`.
+  void RollBack();
+
   // Returns a summary of the state.
   std::string SwitchStateSummary() const;
 
@@ -80,7 +100,21 @@ class SwitchState {
   // A map from table ids to the entries they store.
   absl::flat_hash_map<int, TableEntries> tables_;
 
-  pdpi::IrP4Info ir_p4info_;
+  // The keys of `tables_`, computed once since fuzzing samples them per update.
+  std::vector<uint32_t> table_ids_;
+
+  // An entry that was inserted into or deleted from its table since the oldest
+  // open checkpoint.
+  struct UndoRecord {
+    bool inserted;
+    p4::v1::TableEntry entry;
+  };
+  // Only recorded while `checkpoints_` is non-empty.
+  std::vector<UndoRecord> undo_log_;
+  // For each open checkpoint, the size of `undo_log_` when it was taken.
+  std::vector<int> checkpoints_;
+
+  pdpi::SharedIrP4Info ir_p4info_;
 };
 
 }  // namespace p4_fuzzer
@@ -1,5 +1,7 @@
 #include "p4_fuzzer/switch_state.h"
 
+#include <vector>
+
 #include "glog/logging.h"
 #include "gtest/gtest.h"
 #include "gutil/status_matchers.h"
@@ -102,5 +104,84 @@ TEST(SwitchStateTest, RuleDelete) {
   EXPECT_EQ(state.GetTableEntries(42).size(), 0);
 }
 
+TEST(SwitchStateTest, LookupsSurviveDeletesFromTheMiddleOfATable) {
+  P4Info info;
+  Table* ptable = info.add_tables();
+  Preamble* preamble = ptable->mutable_preamble();
+  preamble->set_id(42);
+  preamble->set_alias("Spam");
+
+  IrP4Info ir_info = CreateIrP4Info(info).value();
+
+  SwitchState state(ir_info);
+
+  std::vector<TableEntry> entries(3);
+  for (int i = 0; i < 3; ++i) {
+    entries[i].set_table_id(42);
+    entries[i].set_priority(i + 1);
+
+    Update update;
+    update.set_type(Update::INSERT);
+    *update.mutable_entity()->mutable_table_entry() = entries[i];
+    ASSERT_OK(state.ApplyUpdate(update));
+  }
+
+  Update update;
+  update.set_type(Update::DELETE);
+  *update.mutable_entity()->mutable_table_entry() = entries[0];
+  ASSERT_OK(state.ApplyUpdate(update));
+  EXPECT_FALSE(state.ApplyUpdate(update).ok());
+
+  EXPECT_EQ(state.GetTableEntry(entries[0]), nullptr);
+  for (int i = 1; i < 3; ++i) {
+    const TableEntry* entry = state.GetTableEntry(entries[i]);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->priority(), i + 1);
+  }
+  EXPECT_EQ(state.GetTableEntries(42).size(), 2);
+}
+
+TEST(SwitchStateTest, RollBackRestoresTheCheckpointedState) {
+  P4Info info;
+  Table* ptable = info.add_tables();
+  Preamble* preamble = ptable->mutable_preamble();
+  preamble->set_id(42);
+  preamble->set_alias("Spam");
+
+  IrP4Info ir_info = CreateIrP4Info(info).value();
+
+  SwitchState state(ir_info);
+
+  Update update;
+  update.set_type(Update::INSERT);
+  TableEntry* entry = update.mutable_entity()->mutable_table_entry();
+  entry->set_table_id(42);
+  entry->set_priority(1);
+  entry->set_controller_metadata(1);
+  ASSERT_OK(state.ApplyUpdate(update));
+
+  state.Checkpoint();
+  // Deletes via an entry whose non-key fields differ from the installed one.
+  entry->set_controller_metadata(2);
+  update.set_type(Update::DELETE);
+  ASSERT_OK(state.ApplyUpdate(update));
+
+  state.Checkpoint();
+  update.set_type(Update::INSERT);
+  entry->set_priority(2);
+  ASSERT_OK(state.ApplyUpdate(update));
+  EXPECT_EQ(state.GetNumTableEntries(42), 1);
+
+  state.RollBack();
+  EXPECT_TRUE(state.IsTableEmpty(42));
+
+  state.RollBack();
+  EXPECT_EQ(state.GetNumTableEntries(42), 1);
+  entry->set_priority(1);
+  const TableEntry* restored = state.GetTableEntry(*entry);
+  ASSERT_NE(restored, nullptr);
+  EXPECT_EQ(restored->controller_metadata(), 1);
+}
+
 }  // namespace
 }  // namespace p4_fuzzer
@@ -1,7 +1,9 @@
 #include "p4_fuzzer/table_entry_key.h"
 
+#include "absl/hash/hash.h"
 #include "absl/hash/hash_testing.h"
 #include "gtest/gtest.h"
+#include "p4/v1/p4runtime.pb.h"
 
 namespace p4_fuzzer {
 namespace {
@@ -65,5 +67,26 @@ TEST(TableEntryKeyTest, Hashing) {
       /*values = */ {key_a, key_b, key_c}));
 }
 
+TEST(TableEntryKeyTest, IgnoresOrderOfMatchFields) {
+  TableEntry entry;
+  entry.set_table_id(42);
+  FieldMatch* first = entry.add_match();
+  first->set_field_id(1);
+  first->mutable_exact()->set_value("a");
+  FieldMatch* second = entry.add_match();
+  second->set_field_id(2);
+  second->mutable_lpm()->set_value("b");
+  second->mutable_lpm()->set_prefix_len(8);
+
+  TableEntry reordered;
+  reordered.set_table_id(42);
+  *reordered.add_match() = entry.match(1);
+  *reordered.add_match() = entry.match(0);
+
+  EXPECT_EQ(TableEntryKey(entry), TableEntryKey(reordered));
+  EXPECT_EQ(absl::HashOf(TableEntryKey(entry)),
+            absl::HashOf(TableEntryKey(reordered)));
+}
+
 }  // namespace
 }  // namespace p4_fuzzer
@@ -0,0 +1,80 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_fuzzer/write_trace.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/util/delimited_message_util.h"
+#include "gutil/status.h"
+#include "p4_fuzzer/fuzzer.pb.h"
+
+namespace p4_fuzzer {
+
+absl::Status WriteWriteTrace(const std::string& path,
+                             absl::Span<const Request> requests) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return gutil::InternalErrorBuilder()
+           << "Could not open write trace '" << path
+           << "' for writing: " << std::strerror(errno);
+  }
+  for (const Request& request : requests) {
+    if (!google::protobuf::util::SerializeDelimitedToOstream(request, &file)) {
+      return gutil::InternalErrorBuilder()
+             << "Failed to write request to write trace '" << path << "'.";
+    }
+  }
+  file.close();
+  if (file.fail()) {
+    return gutil::InternalErrorBuilder()
+           << "Failed to write write trace '" << path << "'.";
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<Request>> ReadWriteTrace(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return gutil::NotFoundErrorBuilder()
+           << "Could not open write trace '" << path
+           << "': " << std::strerror(errno);
+  }
+
+  google::protobuf::io::IstreamInputStream input(&file);
+  std::vector<Request> requests;
+  while (true) {
+    Request request;
+    bool clean_eof = false;
+    if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+            &request, &input, &clean_eof)) {
+      if (clean_eof) break;
+      return gutil::DataLossErrorBuilder()
+             << "Write trace '" << path << "' is corrupt after "
+             << requests.size() << " requests.";
+    }
+    requests.push_back(std::move(request));
+  }
+  return requests;
+}
+
+}  // namespace p4_fuzzer
@@ -0,0 +1,41 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_FUZZER_WRITE_TRACE_H_
+#define PINS_P4_FUZZER_WRITE_TRACE_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "p4_fuzzer/fuzzer.pb.h"
+
+namespace p4_fuzzer {
+
+// A write trace is a file of length-delimited `Request` messages, in the order
+// the requests were sent. Replaying a trace only needs the `pi` write request
+// and its `timestamp_request`, so recorders, e.g. on the Write path of
+// p4rt_app, can leave the other fields unset.
+
+// Writes `requests` to a write trace at `path`, replacing any existing file.
+absl::Status WriteWriteTrace(const std::string& path,
+                             absl::Span<const Request> requests);
+
+// Reads the write trace at `path`.
+absl::StatusOr<std::vector<Request>> ReadWriteTrace(const std::string& path);
+
+}  // namespace p4_fuzzer
+
+#endif  // PINS_P4_FUZZER_WRITE_TRACE_H_
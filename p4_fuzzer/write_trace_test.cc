@@ -0,0 +1,81 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_fuzzer/write_trace.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/io.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "p4_fuzzer/fuzzer.pb.h"
+
+namespace p4_fuzzer {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+std::vector<Request> Trace() {
+  std::vector<Request> requests(2);
+  requests[0].set_timestamp_request(100);
+  requests[0].mutable_pi()->set_device_id(1);
+  requests[0].mutable_pi()->add_updates()->set_type(p4::v1::Update::INSERT);
+  requests[1].set_timestamp_request(250);
+  requests[1].mutable_pi()->set_device_id(1);
+  requests[1].mutable_pi()->add_updates()->set_type(p4::v1::Update::DELETE);
+  return requests;
+}
+
+TEST(WriteTraceTest, RoundTrips) {
+  const std::string path = absl::StrCat(testing::TempDir(), "/trace.bin");
+  const std::vector<Request> trace = Trace();
+  ASSERT_OK(WriteWriteTrace(path, trace));
+
+  EXPECT_THAT(ReadWriteTrace(path),
+              IsOkAndHolds(ElementsAre(EqualsProto(trace[0]),
+                                       EqualsProto(trace[1]))));
+}
+
+TEST(WriteTraceTest, ReadsEmptyTraces) {
+  const std::string path = absl::StrCat(testing::TempDir(), "/empty.bin");
+  ASSERT_OK(WriteWriteTrace(path, {}));
+
+  EXPECT_THAT(ReadWriteTrace(path), IsOkAndHolds(IsEmpty()));
+}
+
+TEST(WriteTraceTest, RejectsTruncatedTraces) {
+  const std::string path = absl::StrCat(testing::TempDir(), "/truncated.bin");
+  ASSERT_OK(WriteWriteTrace(path, Trace()));
+  ASSERT_OK_AND_ASSIGN(std::string contents, gutil::ReadFile(path));
+  contents.resize(contents.size() - 1);
+  ASSERT_OK(gutil::WriteFile(contents, path));
+
+  EXPECT_THAT(ReadWriteTrace(path), StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST(WriteTraceTest, RejectsMissingFiles) {
+  EXPECT_THAT(ReadWriteTrace(absl::StrCat(testing::TempDir(), "/missing.bin")),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace p4_fuzzer
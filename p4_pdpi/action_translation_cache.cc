@@ -0,0 +1,101 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/action_translation_cache.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+template <typename T>
+std::shared_ptr<const T> ActionTranslationCache::Lru<T>::Find(
+    absl::string_view key) {
+  absl::MutexLock lock(&mutex_);
+  auto it = entry_by_key_.find(key);
+  if (it == entry_by_key_.end()) {
+    ++num_misses_;
+    return nullptr;
+  }
+  ++num_hits_;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->second;
+}
+
+template <typename T>
+void ActionTranslationCache::Lru<T>::Insert(std::string key, T value) {
+  if (capacity_ <= 0) return;
+  // Built outside the lock, since moving a large action set is not free.
+  auto shared_value = std::make_shared<const T>(std::move(value));
+  absl::MutexLock lock(&mutex_);
+  // Another thread may have translated the same action in the meantime.
+  if (entry_by_key_.contains(key)) return;
+  if (entries_.size() >= static_cast<size_t>(capacity_)) {
+    entry_by_key_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+  entries_.emplace_front(std::move(key), std::move(shared_value));
+  entry_by_key_[entries_.front().first] = entries_.begin();
+}
+
+template <typename T>
+int64_t ActionTranslationCache::Lru<T>::num_hits() const {
+  absl::MutexLock lock(&mutex_);
+  return num_hits_;
+}
+
+template <typename T>
+int64_t ActionTranslationCache::Lru<T>::num_misses() const {
+  absl::MutexLock lock(&mutex_);
+  return num_misses_;
+}
+
+ActionTranslationCache::ActionTranslationCache(int capacity)
+    : actions_(capacity), action_sets_(capacity) {}
+
+std::shared_ptr<const IrActionInvocation> ActionTranslationCache::FindAction(
+    absl::string_view key) {
+  return actions_.Find(key);
+}
+
+std::shared_ptr<const IrActionSet> ActionTranslationCache::FindActionSet(
+    absl::string_view key) {
+  return action_sets_.Find(key);
+}
+
+void ActionTranslationCache::InsertAction(std::string key,
+                                          IrActionInvocation action) {
+  actions_.Insert(std::move(key), std::move(action));
+}
+
+void ActionTranslationCache::InsertActionSet(std::string key,
+                                             IrActionSet action_set) {
+  action_sets_.Insert(std::move(key), std::move(action_set));
+}
+
+int64_t ActionTranslationCache::num_hits() const {
+  return actions_.num_hits() + action_sets_.num_hits();
+}
+
+int64_t ActionTranslationCache::num_misses() const {
+  return actions_.num_misses() + action_sets_.num_misses();
+}
+
+}  // namespace pdpi
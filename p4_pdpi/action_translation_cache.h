@@ -0,0 +1,88 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_PDPI_ACTION_TRANSLATION_CACHE_H_
+#define PINS_P4_PDPI_ACTION_TRANSLATION_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+// Remembers the IR translations of PI actions and action sets. Large route
+// tables reference few distinct actions (e.g. nexthops) and WCMP action sets,
+// so most entries can reuse a translation instead of redoing it.
+//
+// Keys are opaque to the cache; the translation functions build them from the
+// serialized PI action and everything else the translation depends on. Only
+// successful translations are cached. At most `capacity` actions and
+// `capacity` action sets are kept, evicting the least recently used ones.
+//
+// Thread-safe.
+class ActionTranslationCache {
+ public:
+  explicit ActionTranslationCache(int capacity);
+
+  // Return nullptr if `key` is not cached.
+  std::shared_ptr<const IrActionInvocation> FindAction(absl::string_view key);
+  std::shared_ptr<const IrActionSet> FindActionSet(absl::string_view key);
+
+  void InsertAction(std::string key, IrActionInvocation action);
+  void InsertActionSet(std::string key, IrActionSet action_set);
+
+  // The number of lookups that found, or did not find, a translation.
+  int64_t num_hits() const;
+  int64_t num_misses() const;
+
+ private:
+  template <typename T>
+  class Lru {
+   public:
+    explicit Lru(int capacity) : capacity_(capacity) {}
+
+    std::shared_ptr<const T> Find(absl::string_view key);
+    void Insert(std::string key, T value);
+
+    int64_t num_hits() const;
+    int64_t num_misses() const;
+
+   private:
+    using Entry = std::pair<std::string, std::shared_ptr<const T>>;
+
+    const int capacity_;
+    mutable absl::Mutex mutex_;
+    // Most recently used first.
+    std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+    // Keys point into `entries_`.
+    absl::flat_hash_map<absl::string_view, typename std::list<Entry>::iterator>
+        entry_by_key_ ABSL_GUARDED_BY(mutex_);
+    int64_t num_hits_ ABSL_GUARDED_BY(mutex_) = 0;
+    int64_t num_misses_ ABSL_GUARDED_BY(mutex_) = 0;
+  };
+
+  Lru<IrActionInvocation> actions_;
+  Lru<IrActionSet> action_sets_;
+};
+
+}  // namespace pdpi
+
+#endif  // PINS_P4_PDPI_ACTION_TRANSLATION_CACHE_H_
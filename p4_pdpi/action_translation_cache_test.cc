@@ -0,0 +1,67 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/action_translation_cache.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/testing.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::testing::IsNull;
+using ::testing::Pointee;
+
+TEST(ActionTranslationCacheTest, ReturnsInsertedTranslations) {
+  ActionTranslationCache cache(/*capacity=*/2);
+  const auto action = gutil::ParseProtoOrDie<IrActionInvocation>(
+      R"pb(name: "do_thing_1")pb");
+  const auto action_set = gutil::ParseProtoOrDie<IrActionSet>(
+      R"pb(actions { action { name: "do_thing_1" } weight: 1 })pb");
+
+  EXPECT_THAT(cache.FindAction("a"), IsNull());
+  cache.InsertAction("a", action);
+  cache.InsertActionSet("a", action_set);
+  EXPECT_THAT(cache.FindAction("a"), Pointee(EqualsProto(action)));
+  EXPECT_THAT(cache.FindActionSet("a"), Pointee(EqualsProto(action_set)));
+  EXPECT_THAT(cache.FindActionSet("b"), IsNull());
+  EXPECT_EQ(cache.num_hits(), 2);
+  EXPECT_EQ(cache.num_misses(), 2);
+}
+
+TEST(ActionTranslationCacheTest, EvictsTheLeastRecentlyUsedTranslation) {
+  ActionTranslationCache cache(/*capacity=*/2);
+  IrActionInvocation action;
+  action.set_name("do_thing_1");
+
+  cache.InsertAction("a", action);
+  cache.InsertAction("b", action);
+  ASSERT_NE(cache.FindAction("a"), nullptr);
+  cache.InsertAction("c", action);
+  EXPECT_NE(cache.FindAction("a"), nullptr);
+  EXPECT_THAT(cache.FindAction("b"), IsNull());
+  EXPECT_NE(cache.FindAction("c"), nullptr);
+}
+
+TEST(ActionTranslationCacheTest, ZeroCapacityCachesNothing) {
+  ActionTranslationCache cache(/*capacity=*/0);
+  cache.InsertAction("a", IrActionInvocation());
+  EXPECT_THAT(cache.FindAction("a"), IsNull());
+}
+
+}  // namespace
+}  // namespace pdpi
@@ -0,0 +1,448 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks for the hot paths of P4-PDPI: creating IrP4Infos, translating
+// table entries between PI, IR, and PD, sequencing and garbage collecting
+// entities, hashing entity keys, and parsing and serializing packets. Table
+// entries are generated for every supported table of the SAI P4 middleblock
+// and ToR instantiations and of WBB.
+//
+// Run with
+//   bazel run -c opt //p4_pdpi/benchmarks
+// and compare runs before and after a change, e.g. with
+// `--benchmark_out=<file>` and google-benchmark's `compare.py`.
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "benchmark/benchmark.h"
+#include "glog/logging.h"
+#include "gutil/collections.h"
+#include "gutil/status.h"
+#include "gutil/testing.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/packetlib/packet_generator.h"
+#include "p4_pdpi/packetlib/packetlib.h"
+#include "p4_pdpi/packetlib/packetlib.pb.h"
+#include "p4_pdpi/pd.h"
+#include "p4_pdpi/sequencing.h"
+#include "sai_p4/instantiations/google/instantiations.h"
+#include "sai_p4/instantiations/google/sai_p4info.h"
+#include "sai_p4/instantiations/google/sai_pd.pb.h"
+#include "sai_p4/instantiations/google/test_tools/table_entry_generator.h"
+#include "sai_p4/instantiations/google/test_tools/table_entry_generator_helper.h"
+
+namespace pdpi {
+namespace {
+
+using ::sai::Instantiation;
+
+// The instantiations to benchmark, indexed by the `instantiation` argument.
+constexpr Instantiation kInstantiations[] = {
+    Instantiation::kMiddleblock,
+    Instantiation::kTor,
+    Instantiation::kWbb,
+};
+constexpr int kNumInstantiations = std::size(kInstantiations);
+
+// Returns the instantiation given by the first argument of `state`, and labels
+// the benchmark with its name.
+Instantiation InstantiationArg(benchmark::State& state) {
+  Instantiation instantiation = kInstantiations[state.range(0)];
+  state.SetLabel(sai::InstantiationToString(instantiation));
+  return instantiation;
+}
+
+// Runs a benchmark for every instantiation.
+void ForEachInstantiation(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgName("instantiation")->DenseRange(0, kNumInstantiations - 1);
+}
+
+// Runs a benchmark for every instantiation with a growing number of entries
+// per table. At 1000 entries per table, a state has tens of thousands of
+// entries, which is in the range of what switches hold in production.
+void ForEachInstantiationAndEntriesPerTable(
+    benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"instantiation", "entries_per_table"})
+      ->ArgsProduct({benchmark::CreateDenseRange(0, kNumInstantiations - 1,
+                                                 /*step=*/1),
+                     {10, 100, 1000}});
+}
+
+// The table entries generated for an instantiation, in every representation.
+// The entries are deduplicated by key, and each entry comes after the entries
+// it refers to, i.e. the entries are in a valid order for installation.
+struct TestEntries {
+  std::vector<IrTableEntry> ir;
+  std::vector<p4::v1::TableEntry> pi;
+  std::vector<sai::TableEntry> pd;
+  // The `pi` entries, wrapped in entities.
+  std::vector<p4::v1::Entity> entities;
+};
+
+TestEntries GenerateTestEntries(const IrP4Info& info, int entries_per_table) {
+  TestEntries entries;
+  absl::flat_hash_set<TableEntryKey> keys;
+  auto add_entry = [&](const IrTableEntry& ir) {
+    absl::StatusOr<p4::v1::TableEntry> pi = IrTableEntryToPi(info, ir);
+    sai::TableEntry pd;
+    // Generated entries may be unsupported by some instantiations, e.g. if a
+    // match field is missing; those are skipped.
+    if (!pi.ok() || !IrTableEntryToPd(info, ir, &pd).ok()) return;
+    if (!keys.insert(TableEntryKey(*pi)).second) return;
+    entries.ir.push_back(ir);
+    *entries.entities.emplace_back().mutable_table_entry() = *pi;
+    entries.pi.push_back(*std::move(pi));
+    entries.pd.push_back(std::move(pd));
+  };
+
+  // Iterates over the tables in a fixed order to make runs comparable.
+  std::map<std::string, const IrTableDefinition*> tables_by_name;
+  for (const auto& [name, table] : info.tables_by_name()) {
+    tables_by_name[name] = &table;
+  }
+  for (const auto& [name, table] : tables_by_name) {
+    absl::StatusOr<sai::TableEntryGenerator> generator =
+        sai::GetGenerator(*table);
+    if (!generator.ok()) continue;
+    for (const IrTableEntry& prerequisite : generator->prerequisites) {
+      add_entry(prerequisite);
+    }
+    int64_t num_entries = entries_per_table;
+    if (table->size() > 0) num_entries = std::min(num_entries, table->size());
+    for (int i = 0; i < num_entries; ++i) add_entry(generator->generator(i));
+  }
+  CHECK(!entries.ir.empty()) << "no entries generated";  // Crash OK
+  return entries;
+}
+
+// Returns the entries for the instantiation and number of entries per table
+// given by the arguments of `state`. Entries are generated once per process,
+// outside of the timed loops.
+const TestEntries& GetTestEntries(benchmark::State& state) {
+  static auto* const kTestEntries =
+      new std::map<std::pair<Instantiation, int>, TestEntries>();
+  const Instantiation instantiation = InstantiationArg(state);
+  const int entries_per_table = state.range(1);
+  auto it = kTestEntries->find({instantiation, entries_per_table});
+  if (it == kTestEntries->end()) {
+    it = kTestEntries
+             ->insert({{instantiation, entries_per_table},
+                       GenerateTestEntries(sai::GetIrP4Info(instantiation),
+                                           entries_per_table)})
+             .first;
+  }
+  return it->second;
+}
+
+// -- IrP4Info -----------------------------------------------------------------
+
+void BM_CreateIrP4Info(benchmark::State& state) {
+  const p4::config::v1::P4Info& p4info =
+      sai::GetP4Info(InstantiationArg(state));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(CreateIrP4Info(p4info));
+  }
+}
+BENCHMARK(BM_CreateIrP4Info)
+    ->Apply(ForEachInstantiation)
+    ->Unit(benchmark::kMillisecond);
+
+// -- Table entry translation --------------------------------------------------
+
+void BM_PiTableEntryToIr(benchmark::State& state) {
+  const TestEntries& entries = GetTestEntries(state);
+  const IrP4Info& info = sai::GetIrP4Info(InstantiationArg(state));
+  for (auto _ : state) {
+    for (const p4::v1::TableEntry& pi : entries.pi) {
+      benchmark::DoNotOptimize(PiTableEntryToIr(info, pi));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * entries.pi.size());
+}
+BENCHMARK(BM_PiTableEntryToIr)->Apply(ForEachInstantiationAndEntriesPerTable);
+
+void BM_IrTableEntryToPi(benchmark::State& state) {
+  const TestEntries& entries = GetTestEntries(state);
+  const IrP4Info& info = sai::GetIrP4Info(InstantiationArg(state));
+  for (auto _ : state) {
+    for (const IrTableEntry& ir : entries.ir) {
+      benchmark::DoNotOptimize(IrTableEntryToPi(info, ir));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * entries.ir.size());
+}
+BENCHMARK(BM_IrTableEntryToPi)->Apply(ForEachInstantiationAndEntriesPerTable);
+
+void BM_IrTableEntryToPd(benchmark::State& state) {
+  const TestEntries& entries = GetTestEntries(state);
+  const IrP4Info& info = sai::GetIrP4Info(InstantiationArg(state));
+  sai::TableEntry pd;
+  for (auto _ : state) {
+    for (const IrTableEntry& ir : entries.ir) {
+      pd.Clear();
+      benchmark::DoNotOptimize(IrTableEntryToPd(info, ir, &pd));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * entries.ir.size());
+}
+BENCHMARK(BM_IrTableEntryToPd)->Apply(ForEachInstantiationAndEntriesPerTable);
+
+void BM_PdTableEntryToIrEntity(benchmark::State& state) {
+  const TestEntries& entries = GetTestEntries(state);
+  const IrP4Info& info = sai::GetIrP4Info(InstantiationArg(state));
+  for (auto _ : state) {
+    for (const sai::TableEntry& pd : entries.pd) {
+      benchmark::DoNotOptimize(PdTableEntryToIrEntity(info, pd));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * entries.pd.size());
+}
+BENCHMARK(BM_PdTableEntryToIrEntity)
+    ->Apply(ForEachInstantiationAndEntriesPerTable);
+
+void BM_PiTableEntryToPd(benchmark::State& state) {
+  const TestEntries& entries = GetTestEntries(state);
+  const IrP4Info& info = sai::GetIrP4Info(InstantiationArg(state));
+  sai::TableEntry pd;
+  for (auto _ : state) {
+    for (const p4::v1::TableEntry& pi : entries.pi) {
+      pd.Clear();
+      benchmark::DoNotOptimize(PiTableEntryToPd(info, pi, &pd));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * entries.pi.size());
+}
+BENCHMARK(BM_PiTableEntryToPd)->Apply(ForEachInstantiationAndEntriesPerTable);
+
+// -- Sequencing ---------------------------------------------------------------
+
+void BM_SequencePiUpdatesIntoWriteRequests(benchmark::State& state) {
+  const TestEntries& entries = GetTestEntries(state);
+  const IrP4Info& info = sai::GetIrP4Info(InstantiationArg(state));
+  // Inserts the entries in reverse, so that every dependency must be ordered
+  // before the entries referring to it.
+  std::vector<p4::v1::Update> updates;
+  updates.reserve(entries.entities.size());
+  for (auto it = entries.entities.rbegin(); it != entries.entities.rend();
+       ++it) {
+    p4::v1::Update& update = updates.emplace_back();
+    update.set_type(p4::v1::Update::INSERT);
+    *update.mutable_entity() = *it;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(SequencePiUpdatesIntoWriteRequests(info, updates));
+  }
+  state.SetItemsProcessed(state.iterations() * updates.size());
+}
+BENCHMARK(BM_SequencePiUpdatesIntoWriteRequests)
+    ->Apply(ForEachInstantiationAndEntriesPerTable)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_GetEntitiesUnreachableFromRoots(benchmark::State& state) {
+  const TestEntries& entries = GetTestEntries(state);
+  const IrP4Info& info = sai::GetIrP4Info(InstantiationArg(state));
+  const int num_threads = state.range(2);
+  // Like the garbage collection of a switch state, treats entries of tables
+  // that nothing can refer to as roots.
+  auto is_root_entity =
+      [&](const p4::v1::Entity& entity) -> absl::StatusOr<bool> {
+    ASSIGN_OR_RETURN(const IrTableDefinition* table,
+                     gutil::FindPtrOrStatus(info.tables_by_id(),
+                                            entity.table_entry().table_id()));
+    return table->incoming_references().empty();
+  };
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(GetEntitiesUnreachableFromRoots(
+        entries.entities, is_root_entity, info, num_threads));
+  }
+  state.SetItemsProcessed(state.iterations() * entries.entities.size());
+}
+BENCHMARK(BM_GetEntitiesUnreachableFromRoots)
+    ->ArgNames({"instantiation", "entries_per_table", "threads"})
+    ->ArgsProduct({benchmark::CreateDenseRange(0, kNumInstantiations - 1,
+                                               /*step=*/1),
+                   {10, 100, 1000},
+                   {1, 4}})
+    ->Unit(benchmark::kMillisecond);
+
+// -- Entity keys --------------------------------------------------------------
+
+void BM_MakeEntityKeysAndInsertIntoHashSet(benchmark::State& state) {
+  const TestEntries& entries = GetTestEntries(state);
+  for (auto _ : state) {
+    absl::flat_hash_set<EntityKey> keys;
+    keys.reserve(entries.entities.size());
+    for (const p4::v1::Entity& entity : entries.entities) {
+      keys.insert(*EntityKey::MakeEntityKey(entity));
+    }
+    benchmark::DoNotOptimize(keys);
+  }
+  state.SetItemsProcessed(state.iterations() * entries.entities.size());
+}
+BENCHMARK(BM_MakeEntityKeysAndInsertIntoHashSet)
+    ->Apply(ForEachInstantiationAndEntriesPerTable);
+
+void BM_HashEntityKey(benchmark::State& state) {
+  const TestEntries& entries = GetTestEntries(state);
+  std::vector<EntityKey> keys;
+  keys.reserve(entries.entities.size());
+  for (const p4::v1::Entity& entity : entries.entities) {
+    keys.push_back(*EntityKey::MakeEntityKey(entity));
+  }
+  for (auto _ : state) {
+    for (const EntityKey& key : keys) {
+      benchmark::DoNotOptimize(absl::Hash<EntityKey>()(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_HashEntityKey)->Apply(ForEachInstantiationAndEntriesPerTable);
+
+// -- Packetlib ----------------------------------------------------------------
+
+constexpr absl::string_view kIpv4UdpPacket = R"pb(
+  headers {
+    ethernet_header {
+      ethernet_destination: "aa:bb:cc:dd:ee:ff"
+      ethernet_source: "11:22:33:44:55:66"
+      ethertype: "0x0800"
+    }
+  }
+  headers {
+    ipv4_header {
+      version: "0x4"
+      ihl: "0x5"
+      dscp: "0x1b"
+      ecn: "0x1"
+      identification: "0x0000"
+      flags: "0x0"
+      fragment_offset: "0x0000"
+      ttl: "0x10"
+      protocol: "0x11"  # UDP
+      ipv4_source: "192.168.0.31"
+      ipv4_destination: "192.168.0.30"
+    }
+  }
+  headers { udp_header { source_port: "0x0014" destination_port: "0x000a" } }
+)pb";
+
+constexpr absl::string_view kIpv6TcpPacket = R"pb(
+  headers {
+    ethernet_header {
+      ethernet_destination: "aa:bb:cc:dd:ee:ff"
+      ethernet_source: "11:22:33:44:55:66"
+      ethertype: "0x86dd"
+    }
+  }
+  headers {
+    ipv6_header {
+      version: "0x6"
+      dscp: "0x1b"
+      ecn: "0x1"
+      flow_label: "0x12345"
+      next_header: "0x06"  # TCP
+      hop_limit: "0x03"
+      ipv6_source: "0000:1111:2222:3333:4444:5555:6666:7777"
+      ipv6_destination: "8888:9999:aaaa:bbbb:cccc:dddd:eeee:ffff"
+    }
+  }
+  headers {
+    tcp_header {
+      source_port: "0x0001"
+      destination_port: "0x0002"
+      sequence_number: "0x00000001"
+      acknowledgement_number: "0x00000000"
+      rest_of_header: "0x000000000000000"
+    }
+  }
+)pb";
+
+// Returns the given packet with a payload of `payload_size` bytes and all
+// computed fields set.
+packetlib::Packet TestPacket(absl::string_view packet_text, int payload_size) {
+  auto packet = gutil::ParseProtoOrDie<packetlib::Packet>(packet_text);
+  packet.set_payload(std::string(payload_size, 'x'));
+  // Crash OK: benchmark-only code.
+  CHECK_OK(packetlib::UpdateMissingComputedFields(packet).status());
+  return packet;
+}
+
+void BM_ParsePacket(benchmark::State& state, absl::string_view packet_text) {
+  absl::StatusOr<std::string> bytes =
+      packetlib::SerializePacket(TestPacket(packet_text, state.range(0)));
+  CHECK_OK(bytes.status());  // Crash OK
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(packetlib::ParsePacket(*bytes));
+  }
+  state.SetBytesProcessed(state.iterations() * bytes->size());
+}
+BENCHMARK_CAPTURE(BM_ParsePacket, ipv4_udp, kIpv4UdpPacket)
+    ->Arg(0)
+    ->Arg(64)
+    ->Arg(1500);
+BENCHMARK_CAPTURE(BM_ParsePacket, ipv6_tcp, kIpv6TcpPacket)
+    ->Arg(0)
+    ->Arg(64)
+    ->Arg(1500);
+
+void BM_SerializePacket(benchmark::State& state,
+                        absl::string_view packet_text) {
+  const packetlib::Packet packet = TestPacket(packet_text, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(packetlib::SerializePacket(packet));
+  }
+}
+BENCHMARK_CAPTURE(BM_SerializePacket, ipv4_udp, kIpv4UdpPacket)
+    ->Arg(0)
+    ->Arg(64)
+    ->Arg(1500);
+BENCHMARK_CAPTURE(BM_SerializePacket, ipv6_tcp, kIpv6TcpPacket)
+    ->Arg(0)
+    ->Arg(64)
+    ->Arg(1500);
+
+// Compare with BM_SerializePacket, which only serializes a fixed packet.
+void BM_GeneratePacket(benchmark::State& state) {
+  absl::StatusOr<packetlib::PacketGenerator> generator =
+      packetlib::PacketGenerator::Create({
+          .min_payload_bytes = static_cast<int>(state.range(0)),
+          .max_payload_bytes = static_cast<int>(state.range(0)),
+      });
+  CHECK_OK(generator.status());  // Crash OK
+  std::string packet;
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    generator->Next(packet);
+    bytes += packet.size();
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_GeneratePacket)->Arg(0)->Arg(64)->Arg(1500);
+
+}  // namespace
+}  // namespace pdpi
@@ -0,0 +1,183 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/compiled_ir_p4info.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "p4_pdpi/action_translation_cache.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+namespace {
+
+// IDs are only kept in a vector when it would be at most this many times
+// larger than the number of IDs (plus some slack for small sets).
+constexpr uint64_t kMaxDenseOverhead = 4;
+constexpr uint64_t kMinDenseSize = 64;
+
+// Returns the pointer stored for `key`, or nullptr if there is none.
+template <typename Map, typename Key>
+typename Map::mapped_type FindPointerOrNull(const Map& map, const Key& key) {
+  auto iter = map.find(key);
+  return iter == map.end() ? nullptr : iter->second;
+}
+
+}  // namespace
+
+template <typename T>
+void CompiledIrP4Info::IdMap<T>::Insert(uint32_t id, const T* value) {
+  sparse_[id] = value;
+}
+
+template <typename T>
+void CompiledIrP4Info::IdMap<T>::Compile() {
+  if (sparse_.empty()) return;
+
+  uint32_t min_id = sparse_.begin()->first;
+  uint32_t max_id = min_id;
+  for (const auto& [id, _] : sparse_) {
+    min_id = std::min(min_id, id);
+    max_id = std::max(max_id, id);
+  }
+  const uint64_t span = uint64_t{max_id} - min_id + 1;
+  if (span > kMaxDenseOverhead * sparse_.size() + kMinDenseSize) return;
+
+  min_id_ = min_id;
+  dense_.assign(span, nullptr);
+  for (const auto& [id, value] : sparse_) dense_[id - min_id_] = value;
+  sparse_.clear();
+}
+
+template <typename T>
+const T* CompiledIrP4Info::IdMap<T>::Find(uint32_t id) const {
+  if (!dense_.empty()) {
+    // Unsigned wrap-around also rejects IDs below min_id_.
+    const uint32_t offset = id - min_id_;
+    return offset < dense_.size() ? dense_[offset] : nullptr;
+  }
+  return FindPointerOrNull(sparse_, id);
+}
+
+CompiledIrP4Info::CompiledIrP4Info(const IrP4Info& info,
+                                   int action_cache_capacity)
+    : info_(info),
+      action_cache_(action_cache_capacity > 0
+                        ? std::make_unique<ActionTranslationCache>(
+                              action_cache_capacity)
+                        : nullptr) {
+  tables_.reserve(info.tables_by_id_size());
+  for (const auto& [table_id, definition] : info.tables_by_id()) {
+    Table& table = tables_.emplace_back();
+    table.definition = &definition;
+    for (const auto& [field_id, field] : definition.match_fields_by_id()) {
+      table.match_fields_by_id.Insert(field_id, &field);
+      table.match_fields_by_name[field.match_field().name()] = &field;
+    }
+    table.match_fields_by_id.Compile();
+  }
+
+  actions_.reserve(info.actions_by_id_size());
+  for (const auto& [action_id, definition] : info.actions_by_id()) {
+    Action& action = actions_.emplace_back();
+    action.definition = &definition;
+    for (const auto& [param_id, param] : definition.params_by_id()) {
+      action.params_by_id.Insert(param_id, &param);
+      action.params_by_name[param.param().name()] = &param;
+    }
+    action.params_by_id.Compile();
+  }
+
+  // The vectors are complete, so pointers into them stay valid.
+  for (const Table& table : tables_) {
+    tables_by_id_.Insert(table.definition->preamble().id(), &table);
+    tables_by_name_[table.definition->preamble().alias()] = &table;
+  }
+  tables_by_id_.Compile();
+  for (const Action& action : actions_) {
+    actions_by_id_.Insert(action.definition->preamble().id(), &action);
+    actions_by_name_[action.definition->preamble().alias()] = &action;
+  }
+  actions_by_id_.Compile();
+}
+
+const IrTableDefinition* CompiledIrP4Info::FindTableById(
+    uint32_t table_id) const {
+  const Table* table = tables_by_id_.Find(table_id);
+  return table == nullptr ? nullptr : table->definition;
+}
+
+const IrTableDefinition* CompiledIrP4Info::FindTableByName(
+    absl::string_view table_name) const {
+  const Table* table = FindPointerOrNull(tables_by_name_, table_name);
+  return table == nullptr ? nullptr : table->definition;
+}
+
+const IrMatchFieldDefinition* CompiledIrP4Info::FindMatchFieldById(
+    const IrTableDefinition& table, uint32_t field_id) const {
+  const Table* compiled = FindTable(table);
+  return compiled == nullptr ? nullptr
+                             : compiled->match_fields_by_id.Find(field_id);
+}
+
+const IrMatchFieldDefinition* CompiledIrP4Info::FindMatchFieldByName(
+    const IrTableDefinition& table, absl::string_view field_name) const {
+  const Table* compiled = FindTable(table);
+  return compiled == nullptr
+             ? nullptr
+             : FindPointerOrNull(compiled->match_fields_by_name, field_name);
+}
+
+const IrActionDefinition* CompiledIrP4Info::FindActionById(
+    uint32_t action_id) const {
+  const Action* action = actions_by_id_.Find(action_id);
+  return action == nullptr ? nullptr : action->definition;
+}
+
+const IrActionDefinition* CompiledIrP4Info::FindActionByName(
+    absl::string_view action_name) const {
+  const Action* action = FindPointerOrNull(actions_by_name_, action_name);
+  return action == nullptr ? nullptr : action->definition;
+}
+
+const IrActionDefinition::IrActionParamDefinition*
+CompiledIrP4Info::FindParamById(const IrActionDefinition& action,
+                                uint32_t param_id) const {
+  const Action* compiled = FindAction(action);
+  return compiled == nullptr ? nullptr : compiled->params_by_id.Find(param_id);
+}
+
+const IrActionDefinition::IrActionParamDefinition*
+CompiledIrP4Info::FindParamByName(const IrActionDefinition& action,
+                                  absl::string_view param_name) const {
+  const Action* compiled = FindAction(action);
+  return compiled == nullptr
+             ? nullptr
+             : FindPointerOrNull(compiled->params_by_name, param_name);
+}
+
+const CompiledIrP4Info::Table* CompiledIrP4Info::FindTable(
+    const IrTableDefinition& table) const {
+  return tables_by_id_.Find(table.preamble().id());
+}
+
+const CompiledIrP4Info::Action* CompiledIrP4Info::FindAction(
+    const IrActionDefinition& action) const {
+  return actions_by_id_.Find(action.preamble().id());
+}
+
+}  // namespace pdpi
@@ -0,0 +1,123 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_PDPI_COMPILED_IR_P4INFO_H_
+#define PINS_P4_PDPI_COMPILED_IR_P4INFO_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "p4_pdpi/action_translation_cache.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+// Lookup tables for the definitions in an IrP4Info. The IrP4Info keeps its
+// definitions in protobuf maps, and translating an entry does several map
+// lookups per match field and action parameter. A CompiledIrP4Info is built
+// once per IrP4Info and resolves IDs through vectors indexed by their offset
+// from the smallest ID, and names through hash maps of string_views into the
+// IrP4Info.
+//
+// The IrP4Info must outlive the CompiledIrP4Info, and must not be modified
+// while it is in use.
+class CompiledIrP4Info {
+ public:
+  // Translations through this object memoize up to `action_cache_capacity`
+  // actions and action sets (see ActionTranslationCache). Zero disables it.
+  explicit CompiledIrP4Info(const IrP4Info& info,
+                            int action_cache_capacity = 0);
+
+  // Lookups point into the IrP4Info and into this object.
+  CompiledIrP4Info(const CompiledIrP4Info&) = delete;
+  CompiledIrP4Info& operator=(const CompiledIrP4Info&) = delete;
+
+  const IrP4Info& info() const { return info_; }
+
+  // Returns nullptr if translations are not memoized. The cache is
+  // thread-safe, so it may be used through a const CompiledIrP4Info.
+  ActionTranslationCache* action_cache() const { return action_cache_.get(); }
+
+  // Every lookup returns nullptr if the definition does not exist. Match fields
+  // and parameters are found through the ID of the given table or action.
+  const IrTableDefinition* FindTableById(uint32_t table_id) const;
+  const IrTableDefinition* FindTableByName(absl::string_view table_name) const;
+  const IrMatchFieldDefinition* FindMatchFieldById(
+      const IrTableDefinition& table, uint32_t field_id) const;
+  const IrMatchFieldDefinition* FindMatchFieldByName(
+      const IrTableDefinition& table, absl::string_view field_name) const;
+
+  const IrActionDefinition* FindActionById(uint32_t action_id) const;
+  const IrActionDefinition* FindActionByName(
+      absl::string_view action_name) const;
+  const IrActionDefinition::IrActionParamDefinition* FindParamById(
+      const IrActionDefinition& action, uint32_t param_id) const;
+  const IrActionDefinition::IrActionParamDefinition* FindParamByName(
+      const IrActionDefinition& action, absl::string_view param_name) const;
+
+ private:
+  // Maps IDs to values. IDs are usually assigned close together (e.g. match
+  // fields and parameters are numbered from 1) so they index into a vector.
+  // IDs spread too far apart for a vector fall back to a hash map.
+  template <typename T>
+  class IdMap {
+   public:
+    void Insert(uint32_t id, const T* value);
+    // Must be called once every ID has been inserted.
+    void Compile();
+    const T* Find(uint32_t id) const;
+
+   private:
+    uint32_t min_id_ = 0;
+    std::vector<const T*> dense_;
+    absl::flat_hash_map<uint32_t, const T*> sparse_;
+  };
+
+  template <typename T>
+  using NameMap = absl::flat_hash_map<absl::string_view, const T*>;
+
+  struct Table {
+    const IrTableDefinition* definition = nullptr;
+    IdMap<IrMatchFieldDefinition> match_fields_by_id;
+    NameMap<IrMatchFieldDefinition> match_fields_by_name;
+  };
+
+  struct Action {
+    const IrActionDefinition* definition = nullptr;
+    IdMap<IrActionDefinition::IrActionParamDefinition> params_by_id;
+    NameMap<IrActionDefinition::IrActionParamDefinition> params_by_name;
+  };
+
+  const Table* FindTable(const IrTableDefinition& table) const;
+  const Action* FindAction(const IrActionDefinition& action) const;
+
+  const IrP4Info& info_;
+
+  // Never resized after construction, so the maps below can point into them.
+  std::vector<Table> tables_;
+  std::vector<Action> actions_;
+
+  IdMap<Table> tables_by_id_;
+  NameMap<Table> tables_by_name_;
+  IdMap<Action> actions_by_id_;
+  NameMap<Action> actions_by_name_;
+
+  const std::unique_ptr<ActionTranslationCache> action_cache_;
+};
+
+}  // namespace pdpi
+
+#endif  // PINS_P4_PDPI_COMPILED_IR_P4INFO_H_
@@ -0,0 +1,134 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/compiled_ir_p4info.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/testing.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/testing/test_p4info.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::testing::IsNull;
+using ::testing::NotNull;
+using ::testing::Pointee;
+
+TEST(CompiledIrP4InfoTest, FindsEveryTableAndMatchField) {
+  const IrP4Info& info = GetTestIrP4Info();
+  const CompiledIrP4Info compiled(info);
+
+  for (const auto& [id, table] : info.tables_by_id()) {
+    EXPECT_THAT(compiled.FindTableById(id), Pointee(EqualsProto(table)));
+    EXPECT_THAT(compiled.FindTableByName(table.preamble().alias()),
+                Pointee(EqualsProto(table)));
+    for (const auto& [field_id, field] : table.match_fields_by_id()) {
+      EXPECT_THAT(compiled.FindMatchFieldById(table, field_id),
+                  Pointee(EqualsProto(field)));
+      EXPECT_THAT(
+          compiled.FindMatchFieldByName(table, field.match_field().name()),
+          Pointee(EqualsProto(field)));
+    }
+  }
+}
+
+TEST(CompiledIrP4InfoTest, FindsEveryActionAndParam) {
+  const IrP4Info& info = GetTestIrP4Info();
+  const CompiledIrP4Info compiled(info);
+
+  for (const auto& [id, action] : info.actions_by_id()) {
+    EXPECT_THAT(compiled.FindActionById(id), Pointee(EqualsProto(action)));
+    EXPECT_THAT(compiled.FindActionByName(action.preamble().alias()),
+                Pointee(EqualsProto(action)));
+    for (const auto& [param_id, param] : action.params_by_id()) {
+      EXPECT_THAT(compiled.FindParamById(action, param_id),
+                  Pointee(EqualsProto(param)));
+      EXPECT_THAT(compiled.FindParamByName(action, param.param().name()),
+                  Pointee(EqualsProto(param)));
+    }
+  }
+}
+
+TEST(CompiledIrP4InfoTest, AcceptsDefinitionsFromTheNameMaps) {
+  const IrP4Info& info = GetTestIrP4Info();
+  const CompiledIrP4Info compiled(info);
+
+  for (const auto& [name, table] : info.tables_by_name()) {
+    for (const auto& [field_name, field] : table.match_fields_by_name()) {
+      EXPECT_THAT(compiled.FindMatchFieldByName(table, field_name),
+                  Pointee(EqualsProto(field)));
+    }
+  }
+}
+
+TEST(CompiledIrP4InfoTest, ReturnsNullForUnknownDefinitions) {
+  const IrP4Info& info = GetTestIrP4Info();
+  const CompiledIrP4Info compiled(info);
+  ASSERT_GT(info.tables_by_id_size(), 0);
+  const IrTableDefinition& table = info.tables_by_id().begin()->second;
+
+  EXPECT_THAT(compiled.FindTableById(0), IsNull());
+  EXPECT_THAT(compiled.FindTableById(0xffffffff), IsNull());
+  EXPECT_THAT(compiled.FindTableByName("unknown_table"), IsNull());
+  EXPECT_THAT(compiled.FindActionById(0), IsNull());
+  EXPECT_THAT(compiled.FindActionByName("unknown_action"), IsNull());
+  EXPECT_THAT(compiled.FindMatchFieldById(table, 0xffff), IsNull());
+  EXPECT_THAT(compiled.FindMatchFieldByName(table, "unknown_field"), IsNull());
+
+  IrTableDefinition unknown_table = table;
+  unknown_table.mutable_preamble()->set_id(0xffffff);
+  EXPECT_THAT(compiled.FindMatchFieldById(
+                  unknown_table, table.match_fields_by_id().begin()->first),
+              IsNull());
+}
+
+TEST(CompiledIrP4InfoTest, FindsSparseIds) {
+  IrP4Info info = gutil::ParseProtoOrDie<IrP4Info>(R"pb(
+    tables_by_id {
+      key: 1
+      value {
+        preamble { id: 1 alias: "low" }
+        match_fields_by_id {
+          key: 1
+          value { match_field { id: 1 name: "a" } }
+        }
+        match_fields_by_id {
+          key: 1000000
+          value { match_field { id: 1000000 name: "b" } }
+        }
+      }
+    }
+    tables_by_id {
+      key: 4000000000
+      value { preamble { id: 4000000000 alias: "high" } }
+    }
+  )pb");
+  const CompiledIrP4Info compiled(info);
+
+  EXPECT_THAT(compiled.FindTableById(1), NotNull());
+  EXPECT_THAT(compiled.FindTableById(4000000000), NotNull());
+  EXPECT_THAT(compiled.FindTableById(2), IsNull());
+  EXPECT_THAT(compiled.FindTableByName("high"), NotNull());
+
+  const IrTableDefinition& low = info.tables_by_id().at(1);
+  EXPECT_THAT(compiled.FindMatchFieldById(low, 1000000),
+              Pointee(EqualsProto(low.match_fields_by_id().at(1000000))));
+  EXPECT_THAT(compiled.FindMatchFieldById(low, 2), IsNull());
+}
+
+}  // namespace
+}  // namespace pdpi
@@ -14,15 +14,17 @@
 #include "p4_pdpi/entity_keys.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "absl/container/inlined_vector.h"
+#include "absl/hash/hash.h"
 #include "absl/status/statusor.h"
-#include "glog/logging.h"
-#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
-#include "google/protobuf/message.h"
-#include "google/protobuf/util/message_differencer.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "gutil/status.h"
 
 namespace pdpi {
@@ -31,20 +33,38 @@ namespace {
 
 using ::p4::v1::FieldMatch;
 
-// Deterministically serializes a given `proto` to a returned string.
-// Note: This won't necessarily be fully deterministic across builds or proto
-// changes, but hopefully it is close enough to ensure reproducability.
-std::string DeterministicallySerializeProtoToString(
-    const google::protobuf::Message& proto) {
-  std::string output_string;
-  google::protobuf::io::StringOutputStream stream(&output_string);
-  google::protobuf::io::CodedOutputStream coded_stream(&stream);
-  coded_stream.SetSerializationDeterministic(true);
-  CHECK(proto.SerializeToCodedStream(&coded_stream))  // Crash OK
-      << "Serialization of a p4::v1::FieldMatch failed. Proto was: "
-      << proto.DebugString();
+// Most tables match on at most this many fields.
+constexpr int kInlineMatches = 8;
 
-  return output_string;
+void AppendVarint(uint32_t value, std::string& output) {
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+void AppendValue(absl::string_view value, std::string& output) {
+  AppendVarint(value.size(), output);
+  absl::StrAppend(&output, value);
+}
+
+// Removes a value written by `AppendVarint` from the front of `input`.
+uint32_t ConsumeVarint(absl::string_view& input) {
+  uint32_t value = 0;
+  for (int shift = 0; !input.empty(); shift += 7) {
+    const uint8_t byte = input.front();
+    input.remove_prefix(1);
+    value |= uint32_t{byte & 0x7fu} << shift;
+    if (byte < 0x80) break;
+  }
+  return value;
+}
+
+// Removes a value written by `AppendValue` from the front of `input`.
+void ConsumeValue(absl::string_view& input) {
+  const uint32_t size = ConsumeVarint(input);
+  input.remove_prefix(std::min<size_t>(size, input.size()));
 }
 
 }  // namespace
@@ -106,33 +126,54 @@ bool EntityKey::operator<(const EntityKey& other) const {
   return key_ < other.key_;
 }
 
-TableEntryKey::TableEntryKey(const p4::v1::TableEntry& entry) {
-  table_id_ = entry.table_id();
-  priority_ = entry.priority();
-
-  auto match = entry.match();
-  matches_ = std::vector<FieldMatch>(match.begin(), match.end());
+TableEntryKey::TableEntryKey(const p4::v1::TableEntry& entry)
+    : table_id_(entry.table_id()), priority_(entry.priority()) {
   // Sort matches by field to ensure consistent keys.
-  std::sort(matches_.begin(), matches_.end(),
-            [](const FieldMatch& a, const FieldMatch& b) {
-              return a.field_id() < b.field_id();
+  absl::InlinedVector<const FieldMatch*, kInlineMatches> matches;
+  matches.reserve(entry.match_size());
+  for (const FieldMatch& match : entry.match()) matches.push_back(&match);
+  std::sort(matches.begin(), matches.end(),
+            [](const FieldMatch* a, const FieldMatch* b) {
+              return a->field_id() < b->field_id();
             });
-}
 
-bool TableEntryKey::operator==(const TableEntryKey& other) const {
-  // Note: this must match the implementation of hash value below.
-  if ((table_id_ != other.table_id_) || (priority_ != other.priority_) ||
-      matches_.size() != other.matches_.size()) {
-    return false;
-  }
-
-  for (int i = 0; i < matches_.size(); i++) {
-    if (!google::protobuf::util::MessageDifferencer::Equals(
-            matches_[i], other.matches_[i])) {
-      return false;
+  for (const FieldMatch* match : matches) {
+    AppendVarint(match->field_id(), matches_);
+    AppendVarint(match->field_match_type_case(), matches_);
+    switch (match->field_match_type_case()) {
+      case FieldMatch::kExact:
+        AppendValue(match->exact().value(), matches_);
+        break;
+      case FieldMatch::kTernary:
+        AppendValue(match->ternary().value(), matches_);
+        AppendValue(match->ternary().mask(), matches_);
+        break;
+      case FieldMatch::kLpm:
+        AppendValue(match->lpm().value(), matches_);
+        AppendVarint(static_cast<uint32_t>(match->lpm().prefix_len()),
+                     matches_);
+        break;
+      case FieldMatch::kRange:
+        AppendValue(match->range().low(), matches_);
+        AppendValue(match->range().high(), matches_);
+        break;
+      case FieldMatch::kOptional:
+        AppendValue(match->optional().value(), matches_);
+        break;
+      case FieldMatch::kOther:
+        AppendValue(match->other().type_url(), matches_);
+        AppendValue(match->other().value(), matches_);
+        break;
+      case FieldMatch::FIELD_MATCH_TYPE_NOT_SET:
+        break;
     }
   }
-  return true;
+  hash_ = absl::HashOf(table_id_, priority_, matches_);
+}
+
+bool TableEntryKey::operator==(const TableEntryKey& other) const {
+  return hash_ == other.hash_ && table_id_ == other.table_id_ &&
+         priority_ == other.priority_ && matches_ == other.matches_;
 }
 
 bool TableEntryKey::operator!=(const TableEntryKey& other) const {
@@ -142,17 +183,35 @@ bool TableEntryKey::operator!=(const TableEntryKey& other) const {
 bool TableEntryKey::operator<(const TableEntryKey& other) const {
   if (table_id_ != other.table_id_) return table_id_ < other.table_id_;
   if (priority_ != other.priority_) return priority_ < other.priority_;
-  if (matches_.size() != other.matches_.size())
-    return matches_.size() < other.matches_.size();
-
-  for (int i = 0; i < matches_.size(); i++) {
-    if (!google::protobuf::util::MessageDifferencer::Equals(
-            matches_[i], other.matches_[i])) {
-      return DeterministicallySerializeProtoToString(matches_[i]) <
-             DeterministicallySerializeProtoToString(other.matches_[i]);
+  return matches_ < other.matches_;
+}
+
+std::vector<uint32_t> TableEntryKey::FieldIds() const {
+  std::vector<uint32_t> field_ids;
+  absl::string_view matches = matches_;
+  while (!matches.empty()) {
+    const uint32_t field_id = ConsumeVarint(matches);
+    field_ids.push_back(field_id);
+    switch (ConsumeVarint(matches)) {
+      case FieldMatch::kExact:
+      case FieldMatch::kOptional:
+        ConsumeValue(matches);
+        break;
+      case FieldMatch::kTernary:
+      case FieldMatch::kRange:
+      case FieldMatch::kOther:
+        ConsumeValue(matches);
+        ConsumeValue(matches);
+        break;
+      case FieldMatch::kLpm:
+        ConsumeValue(matches);
+        ConsumeVarint(matches);
+        break;
+      default:
+        break;
     }
   }
-  return false;
+  return field_ids;
 }
 
 std::vector<std::string_view> TableEntryKey::NonKeyFieldPaths() {
@@ -15,6 +15,8 @@
 #define PINS_P4_PDPI_ENTITY_KEYS_H_
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <string_view>
@@ -29,10 +31,13 @@
 
 namespace pdpi {
 
+// A key identifying a table entry: its table ID, priority and match fields.
+// The match fields are kept as one canonical byte string and the hash is
+// computed once, so keys are cheap to store, hash and compare.
 class TableEntryKey {
  public:
   TableEntryKey(const p4::v1::TableEntry& entry);
-  TableEntryKey() = default;
+  TableEntryKey() : TableEntryKey(p4::v1::TableEntry()) {}
 
   template <typename H>
   friend H AbslHashValue(H h, const TableEntryKey& key);
@@ -40,10 +45,11 @@ class TableEntryKey {
   // Only intended for debugging purposes.  Do not assume output consistency.
   template <typename Sink>
   friend inline void AbslStringify(Sink& sink, const TableEntryKey& key) {
+    std::vector<uint32_t> field_ids = key.FieldIds();
     absl::Format(&sink, "id: %d priority: %d matches(%d)", key.table_id_,
-                 key.priority_, key.matches_.size());
-    for (auto& m : key.matches_) {
-      absl::Format(&sink, " %d", m.field_id());
+                 key.priority_, field_ids.size());
+    for (uint32_t field_id : field_ids) {
+      absl::Format(&sink, " %d", field_id);
     }
   }
   friend std::ostream& operator<<(std::ostream& stream,
@@ -59,27 +65,23 @@ class TableEntryKey {
   static std::vector<std::string_view> NonKeyFieldPaths();
 
  private:
+  // Returns the IDs of the match fields, in ascending order.
+  std::vector<uint32_t> FieldIds() const;
+
   uint32_t table_id_;
   int32_t priority_;
-  std::vector<p4::v1::FieldMatch> matches_;
+  // The match fields, sorted by ID. Each field is encoded as its ID and the
+  // case of its match type, followed by the values of that match type. Values
+  // are prefixed with their length, so that distinct match fields never have
+  // the same encoding.
+  std::string matches_;
+  // Hash of all of the above.
+  size_t hash_;
 };
 
 template <typename H>
 H AbslHashValue(H h, const TableEntryKey& key) {
-  h = H::combine(std::move(h), key.table_id_, key.priority_);
-
-  for (const auto& field : key.matches_) {
-    // Since protobufs yield a default value for an unset field and since {
-    // exact, ternary, lpm, range, optional } are all part of the oneof
-    // directive (i,e only one of them will be set at a given time), we can get
-    // a correct hash by combining all fields without checking which one is set.
-    h = H::combine(std::move(h), field.field_id(), field.exact().value(),
-                   field.ternary().value(), field.ternary().mask(),
-                   field.lpm().value(), field.lpm().prefix_len(),
-                   field.range().low(), field.range().high(),
-                   field.optional().value());
-  }
-  return h;
+  return H::combine(std::move(h), key.hash_);
 }
 
 // PacketReplicationEntryKey provides a unique key that can be used in maps
@@ -14,9 +14,12 @@
 #include "p4_pdpi/entity_keys.h"
 
 #include <sstream>
+#include <vector>
 
 #include "absl/hash/hash_testing.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "gutil/proto.h"
@@ -318,6 +321,51 @@ TEST(TableEntryKeyTest, StreamOperator) {
   EXPECT_THAT(msg.str(), HasSubstr("8"));
 }
 
+TEST(TableEntryKeyTest, DistinguishesMatchTypesAndValueBoundaries) {
+  std::vector<TableEntryKey> keys;
+  for (absl::string_view match : {
+           R"pb(field_id: 1 exact { value: "\x01" })pb",
+           R"pb(field_id: 1 optional { value: "\x01" })pb",
+           R"pb(field_id: 1 lpm { value: "\x01" prefix_len: 8 })pb",
+           R"pb(field_id: 1 lpm { value: "\x01" prefix_len: 7 })pb",
+           R"pb(field_id: 1 ternary { value: "\x01\x02" mask: "\x03" })pb",
+           R"pb(field_id: 1 ternary { value: "\x01" mask: "\x02\x03" })pb",
+           R"pb(field_id: 1 range { low: "\x01\x02" high: "\x03" })pb",
+           R"pb(field_id: 2 exact { value: "\x01" })pb",
+           R"pb(field_id: 1)pb",
+       }) {
+    ASSERT_OK_AND_ASSIGN(
+        TableEntry entry,
+        gutil::ParseTextProto<TableEntry>(
+            absl::StrCat("table_id: 42 match { ", match, " }")));
+    keys.push_back(TableEntryKey(entry));
+  }
+
+  for (int i = 0; i < keys.size(); ++i) {
+    for (int j = 0; j < keys.size(); ++j) {
+      EXPECT_EQ(keys[i] == keys[j], i == j) << i << " vs " << j;
+      EXPECT_EQ(keys[i] < keys[j] || keys[j] < keys[i], i != j)
+          << i << " vs " << j;
+    }
+  }
+  EXPECT_TRUE(absl::VerifyTypeImplementsAbslHashCorrectly(keys));
+}
+
+TEST(TableEntryKeyTest, StreamOperatorListsEncodedFields) {
+  ASSERT_OK_AND_ASSIGN(TableEntry entry, gutil::ParseTextProto<TableEntry>(R"pb(
+                         table_id: 43
+                         match { field_id: 300 exact { value: "\x01" } }
+                         match {
+                           field_id: 9
+                           lpm { value: "\x01\x02" prefix_len: 200 }
+                         }
+                         match { field_id: 10 }
+                       )pb"));
+  std::stringstream msg;
+  msg << TableEntryKey(entry);
+  EXPECT_THAT(msg.str(), HasSubstr("matches(3) 9 10 300"));
+}
+
 TEST(PacketReplicationEntryKeyTest, TrivialEquality) {
   PacketReplicationEngineEntry entry;
   PacketReplicationEntryKey key_a(entry);
@@ -0,0 +1,109 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_PDPI_INTERNAL_BOUNDED_RING_BUFFER_H_
+#define PINS_P4_PDPI_INTERNAL_BOUNDED_RING_BUFFER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace pdpi {
+
+// A FIFO queue holding at most `capacity` elements in a ring. The ring grows on
+// demand up to `capacity` and its slots are reused afterwards. When an element
+// is pushed into a full buffer, the oldest element is dropped to make room and
+// counted in `num_dropped`, so a slow consumer cannot grow it without bound.
+//
+// Not thread-safe; callers serialize access, e.g. with a mutex.
+template <typename T>
+class BoundedRingBuffer {
+ public:
+  explicit BoundedRingBuffer(int capacity) : capacity_(capacity) {
+    CHECK_GT(capacity, 0);  // Crash OK
+  }
+
+  // Appends `element`, dropping the oldest element if the buffer is full.
+  // Returns true iff an element was dropped.
+  bool Push(T element) {
+    bool dropped = false;
+    if (size_ == capacity()) {
+      Pop();
+      ++num_dropped_;
+      dropped = true;
+    }
+    if (size_ == static_cast<int>(elements_.size())) {
+      // Every slot is in use, so grow the ring. Rotating the oldest element to
+      // the front keeps the elements contiguous (a no-op unless wrapped).
+      std::rotate(elements_.begin(), elements_.begin() + head_,
+                  elements_.end());
+      head_ = 0;
+      elements_.push_back(std::move(element));
+    } else {
+      elements_[(head_ + size_) % elements_.size()] = std::move(element);
+    }
+    ++size_;
+    return dropped;
+  }
+
+  // Removes and returns the oldest element, or nullopt if the buffer is empty.
+  std::optional<T> Pop() {
+    if (empty()) return std::nullopt;
+    std::optional<T> element = std::move(elements_[head_]);
+    elements_[head_] = T();
+    head_ = (head_ + 1) % elements_.size();
+    --size_;
+    return element;
+  }
+
+  // Removes and returns up to `max_elements` of the oldest elements, oldest
+  // first.
+  std::vector<T> PopUpTo(int max_elements) {
+    std::vector<T> elements;
+    elements.reserve(std::min(max_elements, size_));
+    while (!empty() && static_cast<int>(elements.size()) < max_elements) {
+      elements.push_back(*std::move(Pop()));
+    }
+    return elements;
+  }
+
+  // The oldest element. Must not be called on an empty buffer.
+  T& front() {
+    DCHECK(!empty());
+    return elements_[head_];
+  }
+
+  bool empty() const { return size_ == 0; }
+  int size() const { return size_; }
+  int capacity() const { return capacity_; }
+
+  // The number of elements dropped by `Push` since construction.
+  int64_t num_dropped() const { return num_dropped_; }
+
+ private:
+  int capacity_;
+  // The ring. Holds at most `capacity_` slots.
+  std::vector<T> elements_;
+  // The index of the oldest element in `elements_`.
+  int head_ = 0;
+  int size_ = 0;
+  int64_t num_dropped_ = 0;
+};
+
+}  // namespace pdpi
+
+#endif  // PINS_P4_PDPI_INTERNAL_BOUNDED_RING_BUFFER_H_
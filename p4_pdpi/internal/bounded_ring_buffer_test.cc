@@ -0,0 +1,75 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/internal/bounded_ring_buffer.h"
+
+#include <optional>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace pdpi {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+
+TEST(BoundedRingBufferTest, PopsInPushOrder) {
+  BoundedRingBuffer<std::string> buffer(/*capacity=*/3);
+  EXPECT_TRUE(buffer.empty());
+  EXPECT_EQ(buffer.Pop(), std::nullopt);
+
+  EXPECT_FALSE(buffer.Push("a"));
+  EXPECT_FALSE(buffer.Push("b"));
+  EXPECT_EQ(buffer.size(), 2);
+  EXPECT_EQ(buffer.front(), "a");
+  EXPECT_THAT(buffer.Pop(), Optional(std::string("a")));
+
+  // Wraps around the end of the ring.
+  EXPECT_FALSE(buffer.Push("c"));
+  EXPECT_FALSE(buffer.Push("d"));
+  EXPECT_THAT(buffer.PopUpTo(/*max_elements=*/2), ElementsAre("b", "c"));
+  EXPECT_THAT(buffer.PopUpTo(/*max_elements=*/2), ElementsAre("d"));
+  EXPECT_THAT(buffer.PopUpTo(/*max_elements=*/2), IsEmpty());
+  EXPECT_EQ(buffer.num_dropped(), 0);
+}
+
+TEST(BoundedRingBufferTest, GrowsWhileWrappedAroundWithoutReordering) {
+  BoundedRingBuffer<int> buffer(/*capacity=*/4);
+  buffer.Push(1);
+  buffer.Push(2);
+  buffer.Pop();
+  buffer.Push(3);
+  buffer.Push(4);
+  buffer.Push(5);
+
+  EXPECT_EQ(buffer.num_dropped(), 0);
+  EXPECT_THAT(buffer.PopUpTo(/*max_elements=*/10), ElementsAre(2, 3, 4, 5));
+}
+
+TEST(BoundedRingBufferTest, DropsOldestElementsWhenFull) {
+  BoundedRingBuffer<int> buffer(/*capacity=*/2);
+  EXPECT_FALSE(buffer.Push(1));
+  EXPECT_FALSE(buffer.Push(2));
+  EXPECT_TRUE(buffer.Push(3));
+  EXPECT_TRUE(buffer.Push(4));
+
+  EXPECT_EQ(buffer.num_dropped(), 2);
+  EXPECT_EQ(buffer.capacity(), 2);
+  EXPECT_THAT(buffer.PopUpTo(/*max_elements=*/10), ElementsAre(3, 4));
+}
+
+}  // namespace
+}  // namespace pdpi
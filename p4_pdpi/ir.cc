@@ -37,6 +37,7 @@
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "google/protobuf/any.pb.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/map.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/repeated_ptr_field.h"
@@ -49,7 +50,9 @@
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/config/v1/p4types.pb.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/action_translation_cache.h"
 #include "p4_pdpi/built_ins.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/reference_annotations.h"
 #include "p4_pdpi/translation_options.h"
@@ -442,6 +445,17 @@ std::vector<std::string> GetMissingFields(
   return missing_fields;
 }
 
+// Returns true if checks that only guard against malformed input can be
+// skipped for trusted inputs. Builds without NDEBUG always run them, so a
+// trusted input that is not actually valid is still caught.
+bool SkipInputValidation(const TranslationOptions &options) {
+#ifdef NDEBUG
+  return options.trusted_input;
+#else
+  return false;
+#endif
+}
+
 absl::Status CheckMandatoryMatches(
     const absl::flat_hash_set<std::string> &actual_matches,
     const IrTableDefinition &table) {
@@ -475,6 +489,67 @@ absl::Status CheckParams(const absl::flat_hash_set<std::string> &actual_params,
   return absl::OkStatus();
 }
 
+// Resolves the definitions needed to translate table entries. Lookups use the
+// CompiledIrP4Info when there is one, and the IrP4Info maps otherwise.
+class P4InfoLookup {
+ public:
+  P4InfoLookup(const IrP4Info &info)  // NOLINT(google-explicit-constructor)
+      : info_(info) {}
+  explicit P4InfoLookup(const CompiledIrP4Info &compiled)
+      : info_(compiled.info()), compiled_(&compiled) {}
+
+  const IrP4Info &info() const { return info_; }
+  // Returns nullptr if action translations are not memoized.
+  ActionTranslationCache *action_cache() const {
+    return compiled_ == nullptr ? nullptr : compiled_->action_cache();
+  }
+
+  const IrTableDefinition *FindTableById(uint32_t table_id) const {
+    if (compiled_ != nullptr) return compiled_->FindTableById(table_id);
+    return gutil::FindOrNull(info_.tables_by_id(), table_id);
+  }
+  const IrTableDefinition *FindTableByName(const std::string &name) const {
+    if (compiled_ != nullptr) return compiled_->FindTableByName(name);
+    return gutil::FindOrNull(info_.tables_by_name(), name);
+  }
+  const IrMatchFieldDefinition *FindMatchFieldById(
+      const IrTableDefinition &table, uint32_t field_id) const {
+    if (compiled_ != nullptr) {
+      return compiled_->FindMatchFieldById(table, field_id);
+    }
+    return gutil::FindOrNull(table.match_fields_by_id(), field_id);
+  }
+  const IrMatchFieldDefinition *FindMatchFieldByName(
+      const IrTableDefinition &table, const std::string &name) const {
+    if (compiled_ != nullptr) {
+      return compiled_->FindMatchFieldByName(table, name);
+    }
+    return gutil::FindOrNull(table.match_fields_by_name(), name);
+  }
+  const IrActionDefinition *FindActionById(uint32_t action_id) const {
+    if (compiled_ != nullptr) return compiled_->FindActionById(action_id);
+    return gutil::FindOrNull(info_.actions_by_id(), action_id);
+  }
+  const IrActionDefinition *FindActionByName(const std::string &name) const {
+    if (compiled_ != nullptr) return compiled_->FindActionByName(name);
+    return gutil::FindOrNull(info_.actions_by_name(), name);
+  }
+  const IrActionDefinition::IrActionParamDefinition *FindParamById(
+      const IrActionDefinition &action, uint32_t param_id) const {
+    if (compiled_ != nullptr) return compiled_->FindParamById(action, param_id);
+    return gutil::FindOrNull(action.params_by_id(), param_id);
+  }
+  const IrActionDefinition::IrActionParamDefinition *FindParamByName(
+      const IrActionDefinition &action, const std::string &name) const {
+    if (compiled_ != nullptr) return compiled_->FindParamByName(action, name);
+    return gutil::FindOrNull(action.params_by_name(), name);
+  }
+
+ private:
+  const IrP4Info &info_;
+  const CompiledIrP4Info *compiled_ = nullptr;
+};
+
 // Verifies the contents of the PI representation and translates to the IR
 // message
 StatusOr<IrMatch> PiMatchFieldToIr(
@@ -525,13 +600,6 @@ StatusOr<IrMatch> PiMatchFieldToIr(
             "represented by omitting the match altogether."));
       }
       match_entry.set_name(match_field.name());
-      const absl::StatusOr<std::string> &mask =
-          PrefixLenToMask(prefix_len, bitwidth);
-      if (!mask.ok()) {
-        invalid_reasons.push_back(
-            absl::StrCat(kNewBullet, mask.status().message()));
-        break;
-      }
       const absl::StatusOr<std::string> &value =
           ArbitraryToNormalizedByteString(pi_match.lpm().value(), bitwidth);
       if (!value.ok()) {
@@ -539,18 +607,27 @@ StatusOr<IrMatch> PiMatchFieldToIr(
             absl::StrCat(kNewBullet, value.status().message()));
         break;
       }
-      const absl::StatusOr<std::string> &intersection =
-          Intersection(*value, *mask);
-      if (!intersection.ok()) {
-        invalid_reasons.push_back(
-            absl::StrCat(kNewBullet, intersection.status().message()));
-        break;
-      }
-      if (*value != *intersection) {
-        invalid_reasons.push_back(absl::StrCat(
-            kNewBullet, "Lpm value has masked bits that are set. Value: '",
-            absl::CEscape(*value), "' Prefix Length: ", prefix_len));
-        break;
+      if (!SkipInputValidation(options)) {
+        const absl::StatusOr<std::string> &mask =
+            PrefixLenToMask(prefix_len, bitwidth);
+        if (!mask.ok()) {
+          invalid_reasons.push_back(
+              absl::StrCat(kNewBullet, mask.status().message()));
+          break;
+        }
+        const absl::StatusOr<std::string> &intersection =
+            Intersection(*value, *mask);
+        if (!intersection.ok()) {
+          invalid_reasons.push_back(
+              absl::StrCat(kNewBullet, intersection.status().message()));
+          break;
+        }
+        if (*value != *intersection) {
+          invalid_reasons.push_back(absl::StrCat(
+              kNewBullet, "Lpm value has masked bits that are set. Value: '",
+              absl::CEscape(*value), "' Prefix Length: ", prefix_len));
+          break;
+        }
       }
       match_entry.mutable_lpm()->set_prefix_length(prefix_len);
       const absl::StatusOr<IrValue> &ir_value = ArbitraryByteStringToIrValue(
@@ -593,18 +670,20 @@ StatusOr<IrMatch> PiMatchFieldToIr(
         break;
       }
       match_entry.set_name(match_field.name());
-      const absl::StatusOr<std::string> &intersection =
-          Intersection(*value, *mask);
-      if (!intersection.ok()) {
-        invalid_reasons.push_back(
-            absl::StrCat(kNewBullet, intersection.status().message()));
-        break;
-      }
-      if (*value != *intersection) {
-        invalid_reasons.push_back(absl::StrCat(
-            kNewBullet, "Ternary value has masked bits that are set. Value: ",
-            absl::CEscape(*value), " Mask: ", absl::CEscape(*mask)));
-        break;
+      if (!SkipInputValidation(options)) {
+        const absl::StatusOr<std::string> &intersection =
+            Intersection(*value, *mask);
+        if (!intersection.ok()) {
+          invalid_reasons.push_back(
+              absl::StrCat(kNewBullet, intersection.status().message()));
+          break;
+        }
+        if (*value != *intersection) {
+          invalid_reasons.push_back(absl::StrCat(
+              kNewBullet, "Ternary value has masked bits that are set. Value: ",
+              absl::CEscape(*value), " Mask: ", absl::CEscape(*mask)));
+          break;
+        }
       }
       const absl::StatusOr<IrValue> &ir_value = ArbitraryByteStringToIrValue(
           ir_match_definition.format(), bitwidth, *value);
@@ -657,22 +736,23 @@ StatusOr<IrMatch> PiMatchFieldToIr(
 
 // Translates the action invocation from its PI form to IR.
 StatusOr<IrActionInvocation> PiActionToIr(
-    const IrP4Info &info, const TranslationOptions &options,
+    const P4InfoLookup &info, const TranslationOptions &options,
     const p4::v1::Action &pi_action,
     const google::protobuf::RepeatedPtrField<IrActionReference>
         &valid_actions) {
   IrActionInvocation action_entry;
   uint32_t action_id = pi_action.action_id();
 
-  const auto &status_or_ir_action_definition =
-      gutil::FindPtrOrStatus(info.actions_by_id(), action_id);
-  if (!status_or_ir_action_definition.ok()) {
+  const IrActionDefinition *ir_action_definition =
+      info.FindActionById(action_id);
+  if (ir_action_definition == nullptr) {
     return absl::InvalidArgumentError(absl::StrCat(
         kNewBullet, "Action ID ", action_id, " does not exist in the P4Info."));
   }
-  const auto *ir_action_definition = *status_or_ir_action_definition;
 
-  if (absl::c_find_if(valid_actions,
+  const bool validate = !SkipInputValidation(options);
+  if (validate &&
+      absl::c_find_if(valid_actions,
                       [action_id](const IrActionReference &action) {
                         return action.action().preamble().id() == action_id;
                       }) == valid_actions.end()) {
@@ -692,22 +772,25 @@ StatusOr<IrActionInvocation> PiActionToIr(
   }
 
   for (const auto &param : pi_action.params()) {
-    const absl::Status duplicate = gutil::InsertIfUnique(
-        used_params, param.param_id(),
-        absl::StrCat("Duplicate param field with ID ", param.param_id(), "."));
-    if (!duplicate.ok()) {
-      invalid_reasons.push_back(absl::StrCat(kNewBullet, duplicate.message()));
-      continue;
+    if (validate) {
+      const absl::Status duplicate = gutil::InsertIfUnique(
+          used_params, param.param_id(),
+          absl::StrCat("Duplicate param field with ID ", param.param_id(),
+                       "."));
+      if (!duplicate.ok()) {
+        invalid_reasons.push_back(
+            absl::StrCat(kNewBullet, duplicate.message()));
+        continue;
+      }
     }
 
-    const auto status_or_ir_param_definition = gutil::FindPtrOrStatus(
-        ir_action_definition->params_by_id(), param.param_id());
-    if (!status_or_ir_param_definition.ok()) {
+    const auto *ir_param_definition =
+        info.FindParamById(*ir_action_definition, param.param_id());
+    if (ir_param_definition == nullptr) {
       invalid_reasons.push_back(absl::StrCat(
           kNewBullet, "Unable to find param ID ", param.param_id(), "."));
       continue;
     }
-    const auto *ir_param_definition = *status_or_ir_param_definition;
     IrActionInvocation::IrActionParam *param_entry = action_entry.add_params();
     param_entry->set_name(ir_param_definition->param().name());
     const absl::StatusOr<IrValue> &ir_value = ArbitraryByteStringToIrValue(
@@ -719,14 +802,16 @@ StatusOr<IrActionInvocation> PiActionToIr(
                          ir_value.status().message()));
       continue;
     }
-    actual_params.insert(param_entry->name());
+    if (validate) actual_params.insert(param_entry->name());
     *param_entry->mutable_value() = *ir_value;
   }
-  const auto &num_params_status =
-      CheckParams(actual_params, *ir_action_definition);
-  if (!num_params_status.ok()) {
-    invalid_reasons.push_back(
-        absl::StrCat(kNewBullet, num_params_status.message()));
+  if (validate) {
+    const auto &num_params_status =
+        CheckParams(actual_params, *ir_action_definition);
+    if (!num_params_status.ok()) {
+      invalid_reasons.push_back(
+          absl::StrCat(kNewBullet, num_params_status.message()));
+    }
   }
   if (!invalid_reasons.empty()) {
     return absl::InvalidArgumentError(GenerateFormattedError(
@@ -737,7 +822,7 @@ StatusOr<IrActionInvocation> PiActionToIr(
 
 // Translates the action set from its PI form to IR.
 StatusOr<IrActionSet> PiActionSetToIr(
-    const IrP4Info &info, const TranslationOptions &options,
+    const P4InfoLookup &info, const TranslationOptions &options,
     const p4::v1::ActionProfileActionSet &pi_action_set,
     const google::protobuf::RepeatedPtrField<IrActionReference>
         &valid_actions) {
@@ -775,6 +860,63 @@ StatusOr<IrActionSet> PiActionSetToIr(
   return ir_action_set;
 }
 
+// Returns the key of the translation of `pi_action` (an action or action set)
+// in an entry of `table` in the ActionTranslationCache. The valid actions
+// depend on the table, and the translation on `allow_unsupported`. Trusted
+// inputs are kept apart so an action that skipped validation is never reused
+// for an untrusted input.
+template <typename PiAction>
+std::string ActionTranslationCacheKey(const IrTableDefinition &table,
+                                      const TranslationOptions &options,
+                                      const PiAction &pi_action) {
+  return absl::StrCat(table.preamble().id(),
+                      options.allow_unsupported ? "u" : "",
+                      SkipInputValidation(options) ? "t" : "", ":",
+                      pi_action.SerializeAsString());
+}
+
+// Same as PiActionToIr for an entry of `table`, but memoized when `info` has
+// an ActionTranslationCache.
+StatusOr<IrActionInvocation> CachedPiActionToIr(
+    const P4InfoLookup &info, const TranslationOptions &options,
+    const IrTableDefinition &table, const p4::v1::Action &pi_action) {
+  ActionTranslationCache *cache = info.action_cache();
+  if (cache == nullptr) {
+    return PiActionToIr(info, options, pi_action, table.entry_actions());
+  }
+  std::string key = ActionTranslationCacheKey(table, options, pi_action);
+  if (auto cached = cache->FindAction(key); cached != nullptr) {
+    return *cached;
+  }
+  ASSIGN_OR_RETURN(
+      IrActionInvocation ir_action,
+      PiActionToIr(info, options, pi_action, table.entry_actions()));
+  cache->InsertAction(std::move(key), ir_action);
+  return ir_action;
+}
+
+// Same as PiActionSetToIr for an entry of `table`, but memoized when `info`
+// has an ActionTranslationCache.
+StatusOr<IrActionSet> CachedPiActionSetToIr(
+    const P4InfoLookup &info, const TranslationOptions &options,
+    const IrTableDefinition &table,
+    const p4::v1::ActionProfileActionSet &pi_action_set) {
+  ActionTranslationCache *cache = info.action_cache();
+  if (cache == nullptr) {
+    return PiActionSetToIr(info, options, pi_action_set,
+                           table.entry_actions());
+  }
+  std::string key = ActionTranslationCacheKey(table, options, pi_action_set);
+  if (auto cached = cache->FindActionSet(key); cached != nullptr) {
+    return *cached;
+  }
+  ASSIGN_OR_RETURN(
+      IrActionSet ir_action_set,
+      PiActionSetToIr(info, options, pi_action_set, table.entry_actions()));
+  cache->InsertActionSet(std::move(key), ir_action_set);
+  return ir_action_set;
+}
+
 // Generic helper that works for both packet-in and packet-out. For both, I is
 // one of p4::v1::{PacketIn, PacketOut} and O is one of {IrPacketIn,
 // IrPacketOut}.
@@ -1084,21 +1226,22 @@ StatusOr<p4::v1::FieldMatch> IrMatchFieldToPi(
 
 // Translates the action invocation from its IR form to PI.
 StatusOr<p4::v1::Action> IrActionInvocationToPi(
-    const IrP4Info &info, const TranslationOptions &options,
+    const P4InfoLookup &info, const TranslationOptions &options,
     const IrActionInvocation &ir_table_action,
     const google::protobuf::RepeatedPtrField<IrActionReference>
         &valid_actions) {
   const std::string &action_name = ir_table_action.name();
 
-  const auto &status_or_ir_action_definition =
-      gutil::FindPtrOrStatus(info.actions_by_name(), action_name);
-  if (!status_or_ir_action_definition.ok()) {
+  const IrActionDefinition *ir_action_definition =
+      info.FindActionByName(action_name);
+  if (ir_action_definition == nullptr) {
     return absl::InvalidArgumentError(absl::StrCat(
         ActionName(action_name), " does not exist in the P4Info."));
   }
-  const auto *ir_action_definition = *status_or_ir_action_definition;
 
-  if (absl::c_find_if(
+  const bool validate = !SkipInputValidation(options);
+  if (validate &&
+      absl::c_find_if(
           valid_actions, [action_name](const IrActionReference &action) {
             return action.action().preamble().alias() == action_name;
           }) == valid_actions.end()) {
@@ -1117,31 +1260,35 @@ StatusOr<p4::v1::Action> IrActionInvocationToPi(
   }
 
   for (const auto &param : ir_table_action.params()) {
-    const absl::Status &duplicate = gutil::InsertIfUnique(
-        used_params, param.name(),
-        absl::StrCat("Duplicate parameter field found with name '",
-                     param.name(), "'."));
-    if (!duplicate.ok()) {
-      invalid_reasons.push_back(absl::StrCat(kNewBullet, duplicate.message()));
-      continue;
+    if (validate) {
+      const absl::Status &duplicate = gutil::InsertIfUnique(
+          used_params, param.name(),
+          absl::StrCat("Duplicate parameter field found with name '",
+                       param.name(), "'."));
+      if (!duplicate.ok()) {
+        invalid_reasons.push_back(
+            absl::StrCat(kNewBullet, duplicate.message()));
+        continue;
+      }
     }
 
-    const auto &status_or_ir_param_definition = gutil::FindPtrOrStatus(
-        ir_action_definition->params_by_name(), param.name());
-    if (!status_or_ir_param_definition.ok()) {
+    const auto *ir_param_definition =
+        info.FindParamByName(*ir_action_definition, param.name());
+    if (ir_param_definition == nullptr) {
       invalid_reasons.push_back(absl::StrCat(
           kNewBullet, "Unable to find parameter '", param.name(), "'."));
       continue;
     }
-    const auto *ir_param_definition = *status_or_ir_param_definition;
     p4::v1::Action_Param *param_entry = action.add_params();
     param_entry->set_param_id(ir_param_definition->param().id());
-    const absl::Status &valid =
-        ValidateIrValueFormat(param.value(), ir_param_definition->format());
-    if (!valid.ok()) {
-      invalid_reasons.push_back(
-          GenerateReason(ParamName(param.name()), valid.message()));
-      continue;
+    if (validate) {
+      const absl::Status &valid =
+          ValidateIrValueFormat(param.value(), ir_param_definition->format());
+      if (!valid.ok()) {
+        invalid_reasons.push_back(
+            GenerateReason(ParamName(param.name()), valid.message()));
+        continue;
+      }
     }
     const absl::StatusOr<std::string> &value = IrValueToNormalizedByteString(
         param.value(), ir_param_definition->param().bitwidth());
@@ -1157,11 +1304,13 @@ StatusOr<p4::v1::Action> IrActionInvocationToPi(
     }
   }
 
-  const auto &num_params_status =
-      CheckParams(used_params, *ir_action_definition);
-  if (!num_params_status.ok()) {
-    invalid_reasons.push_back(
-        absl::StrCat(kNewBullet, num_params_status.message()));
+  if (validate) {
+    const auto &num_params_status =
+        CheckParams(used_params, *ir_action_definition);
+    if (!num_params_status.ok()) {
+      invalid_reasons.push_back(
+          absl::StrCat(kNewBullet, num_params_status.message()));
+    }
   }
 
   if (!invalid_reasons.empty()) {
@@ -1173,7 +1322,7 @@ StatusOr<p4::v1::Action> IrActionInvocationToPi(
 
 // Translates the action set from its IR form to PI.
 StatusOr<p4::v1::ActionProfileActionSet> IrActionSetToPi(
-    const IrP4Info &info, const TranslationOptions &options,
+    const P4InfoLookup &info, const TranslationOptions &options,
     const IrActionSet &ir_action_set,
     const google::protobuf::RepeatedPtrField<IrActionReference>
         &valid_actions) {
@@ -1834,20 +1983,24 @@ StatusOr<IrP4Info> CreateIrP4Info(const p4::config::v1::P4Info &p4_info) {
   return info;
 }
 
-StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
-                                        const p4::v1::TableEntry &pi,
-                                        const TranslationOptions &options) {
-  IrTableEntry ir;
-  const auto &status_or_table =
-      gutil::FindPtrOrStatus(info.tables_by_id(), pi.table_id());
-  if (!status_or_table.ok()) {
+namespace {
+
+// Translates `pi` into `result`, which must be empty. Every field is built in
+// place, so `result` may be allocated on an arena.
+absl::Status PiTableEntryToIrImpl(const P4InfoLookup &info,
+                                  const p4::v1::TableEntry &pi,
+                                  const TranslationOptions &options,
+                                  IrTableEntry *result) {
+  IrTableEntry &ir = *result;
+  const IrTableDefinition *table = info.FindTableById(pi.table_id());
+  if (table == nullptr) {
     return absl::InvalidArgumentError(absl::StrCat(
         "Table ID ", pi.table_id(), " does not exist in the P4Info."));
   }
-  const auto *table = *status_or_table;
   ir.set_table_name(table->preamble().alias());
   absl::string_view table_name = ir.table_name();
   std::vector<std::string> invalid_reasons;
+  const bool validate = !SkipInputValidation(options);
 
   if (table->is_unsupported() && !options.allow_unsupported) {
     invalid_reasons.push_back(absl::StrCat(kNewBullet, "Table '", table_name,
@@ -1858,43 +2011,47 @@ StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
   absl::flat_hash_set<uint32_t> used_field_ids;
   absl::flat_hash_set<std::string> mandatory_matches;
   for (const auto &pi_match : pi.match()) {
-    const absl::Status &duplicate = gutil::InsertIfUnique(
-        used_field_ids, pi_match.field_id(),
-        absl::StrCat("Duplicate match field found with ID ",
-                     pi_match.field_id(), "."));
-    if (!duplicate.ok()) {
-      invalid_reasons.push_back(absl::StrCat(kNewBullet, duplicate.message()));
-      continue;
+    if (validate) {
+      const absl::Status &duplicate = gutil::InsertIfUnique(
+          used_field_ids, pi_match.field_id(),
+          absl::StrCat("Duplicate match field found with ID ",
+                       pi_match.field_id(), "."));
+      if (!duplicate.ok()) {
+        invalid_reasons.push_back(
+            absl::StrCat(kNewBullet, duplicate.message()));
+        continue;
+      }
     }
 
-    const auto status_or_match = gutil::FindPtrOrStatus(
-        table->match_fields_by_id(), pi_match.field_id());
-    if (!status_or_match.ok()) {
+    const IrMatchFieldDefinition *match =
+        info.FindMatchFieldById(*table, pi_match.field_id());
+    if (match == nullptr) {
       invalid_reasons.push_back(
           absl::StrCat(kNewBullet, "Match field ", pi_match.field_id(),
                        " does not exist in table '", table_name, "'."));
       continue;
     }
-    const auto *match = *status_or_match;
-    const absl::StatusOr<IrMatch> &match_entry =
-        PiMatchFieldToIr(info, options, *match, pi_match);
+    absl::StatusOr<IrMatch> match_entry =
+        PiMatchFieldToIr(info.info(), options, *match, pi_match);
     if (!match_entry.ok()) {
       invalid_reasons.push_back(
           absl::StrCat(kNewBullet, match_entry.status().message()));
       continue;
     }
-    *ir.add_matches() = *match_entry;
+    *ir.add_matches() = *std::move(match_entry);
 
-    if (match->match_field().match_type() == MatchField::EXACT) {
+    if (validate && match->match_field().match_type() == MatchField::EXACT) {
       mandatory_matches.insert(match->match_field().name());
     }
   }
 
-  const absl::Status &mandatory_match_status =
-      CheckMandatoryMatches(mandatory_matches, *table);
-  if (!mandatory_match_status.ok()) {
-    invalid_reasons.push_back(
-        absl::StrCat(kNewBullet, mandatory_match_status.message()));
+  if (validate) {
+    const absl::Status &mandatory_match_status =
+        CheckMandatoryMatches(mandatory_matches, *table);
+    if (!mandatory_match_status.ok()) {
+      invalid_reasons.push_back(
+          absl::StrCat(kNewBullet, mandatory_match_status.message()));
+    }
   }
 
   if (table->requires_priority()) {
@@ -1938,14 +2095,14 @@ StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
                   "action instead."));
               break;
             }
-            const absl::StatusOr<IrActionInvocation> &ir_action = PiActionToIr(
-                info, options, pi.action().action(), table->entry_actions());
+            absl::StatusOr<IrActionInvocation> ir_action =
+                CachedPiActionToIr(info, options, *table, pi.action().action());
             if (!ir_action.ok()) {
               invalid_reasons.push_back(
                   absl::StrCat(kNewBullet, ir_action.status().message()));
               break;
             }
-            *ir.mutable_action() = *ir_action;
+            *ir.mutable_action() = *std::move(ir_action);
             break;
           }
           case p4::v1::TableAction::kActionProfileActionSet: {
@@ -1956,15 +2113,14 @@ StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
                                "oneshot. Got action set instead."));
               break;
             }
-            const absl::StatusOr<IrActionSet> &ir_action_set = PiActionSetToIr(
-                info, options, pi.action().action_profile_action_set(),
-                table->entry_actions());
+            absl::StatusOr<IrActionSet> ir_action_set = CachedPiActionSetToIr(
+                info, options, *table, pi.action().action_profile_action_set());
             if (!ir_action_set.ok()) {
               invalid_reasons.push_back(
                   absl::StrCat(kNewBullet, ir_action_set.status().message()));
               break;
             }
-            *ir.mutable_action_set() = *ir_action_set;
+            *ir.mutable_action_set() = *std::move(ir_action_set);
             break;
           }
           default: {
@@ -2027,6 +2183,24 @@ StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
         TableName(table_name), absl::StrJoin(invalid_reasons, "\n")));
   }
 
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+StatusOr<IrTableEntry> PiTableEntryToIr(const IrP4Info &info,
+                                        const p4::v1::TableEntry &pi,
+                                        const TranslationOptions &options) {
+  IrTableEntry ir;
+  RETURN_IF_ERROR(PiTableEntryToIrImpl(info, pi, options, &ir));
+  return ir;
+}
+
+StatusOr<IrTableEntry> PiTableEntryToIr(const CompiledIrP4Info &info,
+                                        const p4::v1::TableEntry &pi,
+                                        const TranslationOptions &options) {
+  IrTableEntry ir;
+  RETURN_IF_ERROR(PiTableEntryToIrImpl(P4InfoLookup(info), pi, options, &ir));
   return ir;
 }
 
@@ -2200,6 +2374,18 @@ StatusOr<IrEntity> PiEntityToIr(const IrP4Info &info, const p4::v1::Entity &pi,
   return ir_entity;
 }
 
+StatusOr<IrEntity> PiEntityToIr(const CompiledIrP4Info &info,
+                                const p4::v1::Entity &pi,
+                                const TranslationOptions &options) {
+  if (pi.entity_case() != p4::v1::Entity::kTableEntry) {
+    return PiEntityToIr(info.info(), pi, options);
+  }
+  IrEntity ir_entity;
+  ASSIGN_OR_RETURN(*ir_entity.mutable_table_entry(),
+                   PiTableEntryToIr(info, pi.table_entry(), options));
+  return ir_entity;
+}
+
 StatusOr<IrEntities> PiEntitiesToIr(const IrP4Info &info,
                                     const absl::Span<const p4::v1::Entity> pi,
                                     const TranslationOptions &options) {
@@ -2417,21 +2603,56 @@ absl::StatusOr<IrTableEntries> PiTableEntriesToIr(
   return ir;
 }
 
-StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
-    const IrP4Info &info, const IrTableEntry &ir,
-    const TranslationOptions &options) {
-  p4::v1::TableEntry pi;
+StatusOr<IrEntities *> PiEntitiesToIr(const IrP4Info &info,
+                                      absl::Span<const p4::v1::Entity> pi,
+                                      google::protobuf::Arena *arena,
+                                      const TranslationOptions &options) {
+  auto *ir = google::protobuf::Arena::CreateMessage<IrEntities>(arena);
+  ir->mutable_entities()->Reserve(pi.size());
+  for (const auto &pi_entity : pi) {
+    IrEntity &ir_entity = *ir->add_entities();
+    if (pi_entity.entity_case() != p4::v1::Entity::kTableEntry) {
+      ASSIGN_OR_RETURN(ir_entity, PiEntityToIr(info, pi_entity, options));
+      continue;
+    }
+    RETURN_IF_ERROR(PiTableEntryToIrImpl(info, pi_entity.table_entry(),
+                                         options,
+                                         ir_entity.mutable_table_entry()));
+  }
+  return ir;
+}
+
+StatusOr<IrTableEntries *> PiTableEntriesToIr(
+    const IrP4Info &info, absl::Span<const p4::v1::TableEntry> pi,
+    google::protobuf::Arena *arena, const TranslationOptions &options) {
+  auto *ir = google::protobuf::Arena::CreateMessage<IrTableEntries>(arena);
+  ir->mutable_entries()->Reserve(pi.size());
+  for (const auto &pi_entry : pi) {
+    RETURN_IF_ERROR(
+        PiTableEntryToIrImpl(info, pi_entry, options, ir->add_entries()));
+  }
+  return ir;
+}
+
+namespace {
+
+// Translates `ir` into `result`, which must be empty. Every field is built in
+// place, so `result` may be allocated on an arena.
+absl::Status IrTableEntryToPiImpl(const P4InfoLookup &info,
+                                  const IrTableEntry &ir,
+                                  const TranslationOptions &options,
+                                  p4::v1::TableEntry *result) {
+  p4::v1::TableEntry &pi = *result;
   absl::string_view table_name = ir.table_name();
-  const auto &status_or_table =
-      gutil::FindPtrOrStatus(info.tables_by_name(), ir.table_name());
-  if (!status_or_table.ok()) {
+  const IrTableDefinition *table = info.FindTableByName(ir.table_name());
+  if (table == nullptr) {
     return absl::InvalidArgumentError(
         absl::StrCat(TableName(table_name), " does not exist in the P4Info."));
   }
-  const auto *table = *status_or_table;
   pi.set_table_id(table->preamble().id());
 
   std::vector<std::string> invalid_reasons;
+  const bool validate = !SkipInputValidation(options);
 
   if (table->is_unsupported() && !options.allow_unsupported) {
     invalid_reasons.push_back(absl::StrCat(kNewBullet, "Table '", table_name,
@@ -2441,43 +2662,47 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
   // Validate and translate the matches
   absl::flat_hash_set<std::string> used_field_names, mandatory_matches;
   for (const auto &ir_match : ir.matches()) {
-    const absl::Status &duplicate = gutil::InsertIfUnique(
-        used_field_names, ir_match.name(),
-        absl::StrCat("Duplicate match field found with name '", ir_match.name(),
-                     "'."));
-    if (!duplicate.ok()) {
-      invalid_reasons.push_back(absl::StrCat(kNewBullet, duplicate.message()));
-      continue;
+    if (validate) {
+      const absl::Status &duplicate = gutil::InsertIfUnique(
+          used_field_names, ir_match.name(),
+          absl::StrCat("Duplicate match field found with name '",
+                       ir_match.name(), "'."));
+      if (!duplicate.ok()) {
+        invalid_reasons.push_back(
+            absl::StrCat(kNewBullet, duplicate.message()));
+        continue;
+      }
     }
 
-    const auto &status_or_match =
-        gutil::FindPtrOrStatus(table->match_fields_by_name(), ir_match.name());
-    if (!status_or_match.ok()) {
+    const IrMatchFieldDefinition *match =
+        info.FindMatchFieldByName(*table, ir_match.name());
+    if (match == nullptr) {
       invalid_reasons.push_back(absl::StrCat(kNewBullet, "Match Field '",
                                              ir_match.name(),
                                              "' does not exist in table."));
       continue;
     }
-    const auto *match = *status_or_match;
-    const absl::StatusOr<p4::v1::FieldMatch> &match_entry =
-        IrMatchFieldToPi(info, options, *match, ir_match);
+    absl::StatusOr<p4::v1::FieldMatch> match_entry =
+        IrMatchFieldToPi(info.info(), options, *match, ir_match);
     if (!match_entry.ok()) {
       invalid_reasons.push_back(
           absl::StrCat(kNewBullet, match_entry.status().message()));
       continue;
     }
-    *pi.add_match() = *match_entry;
+    *pi.add_match() = *std::move(match_entry);
 
-    if (match->match_field().match_type() == MatchField::EXACT) {
+    if (validate && match->match_field().match_type() == MatchField::EXACT) {
       mandatory_matches.insert(match->match_field().name());
     }
   }
 
-  const absl::Status &mandatory_match_status =
-      CheckMandatoryMatches(mandatory_matches, *table);
-  if (!mandatory_match_status.ok()) {
-    invalid_reasons.push_back(
-        absl::StrCat(kNewBullet, mandatory_match_status.message()));
+  if (validate) {
+    const absl::Status &mandatory_match_status =
+        CheckMandatoryMatches(mandatory_matches, *table);
+    if (!mandatory_match_status.ok()) {
+      invalid_reasons.push_back(
+          absl::StrCat(kNewBullet, mandatory_match_status.message()));
+    }
   }
   if (table->requires_priority()) {
     if (ir.priority() <= 0) {
@@ -2515,7 +2740,7 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
               "Action found for table which has no actions defined."));
           break;
         }
-        const absl::StatusOr<p4::v1::Action> &pi_action =
+        absl::StatusOr<p4::v1::Action> pi_action =
             IrActionInvocationToPi(info, options, ir.action(),
                                    table->entry_actions());
         if (!pi_action.ok()) {
@@ -2523,7 +2748,7 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
               absl::StrCat(kNewBullet, pi_action.status().message()));
           break;
         }
-        *pi.mutable_action()->mutable_action() = *pi_action;
+        *pi.mutable_action()->mutable_action() = *std::move(pi_action);
         break;
       }
       case IrTableEntry::kActionSet: {
@@ -2539,7 +2764,7 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
               kNewBullet,
               "Action set found for table which has no actions defined."));
         }
-        const absl::StatusOr<p4::v1::ActionProfileActionSet> &pi_action_set =
+        absl::StatusOr<p4::v1::ActionProfileActionSet> pi_action_set =
             IrActionSetToPi(info, options, ir.action_set(),
                             table->entry_actions());
         if (!pi_action_set.ok()) {
@@ -2548,7 +2773,7 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
           break;
         }
         *pi.mutable_action()->mutable_action_profile_action_set() =
-            *pi_action_set;
+            *std::move(pi_action_set);
         break;
       }
       default: {
@@ -2609,6 +2834,24 @@ StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
         TableName(table_name), absl::StrJoin(invalid_reasons, "\n")));
   }
 
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
+    const IrP4Info &info, const IrTableEntry &ir,
+    const TranslationOptions &options) {
+  p4::v1::TableEntry pi;
+  RETURN_IF_ERROR(IrTableEntryToPiImpl(info, ir, options, &pi));
+  return pi;
+}
+
+StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
+    const CompiledIrP4Info &info, const IrTableEntry &ir,
+    const TranslationOptions &options) {
+  p4::v1::TableEntry pi;
+  RETURN_IF_ERROR(IrTableEntryToPiImpl(P4InfoLookup(info), ir, options, &pi));
   return pi;
 }
 
@@ -2744,6 +2987,18 @@ StatusOr<p4::v1::Entity> IrEntityToPi(const IrP4Info &info, const IrEntity &ir,
   return pi_entity;
 }
 
+StatusOr<p4::v1::Entity> IrEntityToPi(const CompiledIrP4Info &info,
+                                      const IrEntity &ir,
+                                      const TranslationOptions &options) {
+  if (ir.entity_case() != IrEntity::kTableEntry) {
+    return IrEntityToPi(info.info(), ir, options);
+  }
+  p4::v1::Entity pi_entity;
+  ASSIGN_OR_RETURN(*pi_entity.mutable_table_entry(),
+                   IrTableEntryToPi(info, ir.table_entry(), options));
+  return pi_entity;
+}
+
 absl::StatusOr<std::vector<p4::v1::Entity>> IrEntitiesToPi(
     const IrP4Info &info, const IrEntities &ir,
     const TranslationOptions &options) {
@@ -2756,6 +3011,26 @@ absl::StatusOr<std::vector<p4::v1::Entity>> IrEntitiesToPi(
   return pi_entities;
 }
 
+absl::StatusOr<std::vector<p4::v1::Entity *>> IrEntitiesToPi(
+    const IrP4Info &info, const IrEntities &ir, google::protobuf::Arena *arena,
+    const TranslationOptions &options) {
+  std::vector<p4::v1::Entity *> pi_entities;
+  pi_entities.reserve(ir.entities_size());
+  for (const auto &ir_entity : ir.entities()) {
+    auto *pi_entity =
+        google::protobuf::Arena::CreateMessage<p4::v1::Entity>(arena);
+    if (ir_entity.entity_case() != IrEntity::kTableEntry) {
+      ASSIGN_OR_RETURN(*pi_entity, IrEntityToPi(info, ir_entity, options));
+    } else {
+      RETURN_IF_ERROR(IrTableEntryToPiImpl(info, ir_entity.table_entry(),
+                                           options,
+                                           pi_entity->mutable_table_entry()));
+    }
+    pi_entities.push_back(pi_entity);
+  }
+  return pi_entities;
+}
+
 StatusOr<p4::v1::ReadResponse> IrReadResponseToPi(
     const IrP4Info &info, const IrReadResponse &read_response,
     const TranslationOptions &options) {
@@ -3038,15 +3313,31 @@ absl::StatusOr<IrWriteRpcStatus> GrpcStatusToIrWriteRpcStatus(
 
 static absl::StatusOr<grpc::Status> IrWriteResponseToGrpcStatus(
     const IrWriteResponse &ir_write_response) {
-  p4::v1::Error p4_error;
   google::rpc::Status inner_rpc_status;
+  inner_rpc_status.mutable_details()->Reserve(
+      ir_write_response.statuses_size());
+  // Failed batches are mostly runs of identical statuses (OK before the first
+  // failure, ABORTED after it), so a status equal to the previous one reuses
+  // its packed detail instead of being validated and packed again.
+  const IrUpdateStatus *previous_status = nullptr;
+  const google::protobuf::Any *previous_detail = nullptr;
   for (const IrUpdateStatus &ir_update_status : ir_write_response.statuses()) {
-    RETURN_IF_ERROR(ValidateGenericUpdateStatus(ir_update_status.code(),
-                                                ir_update_status.message()));
-    RETURN_IF_ERROR(IsGoogleRpcCode(ir_update_status.code()));
-    p4_error.set_canonical_code(static_cast<int>(ir_update_status.code()));
-    p4_error.set_message(ir_update_status.message());
-    inner_rpc_status.add_details()->PackFrom(p4_error);
+    google::protobuf::Any *detail = inner_rpc_status.add_details();
+    if (previous_status != nullptr &&
+        previous_status->code() == ir_update_status.code() &&
+        previous_status->message() == ir_update_status.message()) {
+      *detail = *previous_detail;
+    } else {
+      RETURN_IF_ERROR(ValidateGenericUpdateStatus(ir_update_status.code(),
+                                                  ir_update_status.message()));
+      RETURN_IF_ERROR(IsGoogleRpcCode(ir_update_status.code()));
+      p4::v1::Error p4_error;
+      p4_error.set_canonical_code(static_cast<int>(ir_update_status.code()));
+      p4_error.set_message(ir_update_status.message());
+      detail->PackFrom(p4_error);
+    }
+    previous_status = &ir_update_status;
+    previous_detail = detail;
   }
   inner_rpc_status.set_code(static_cast<int>(google::rpc::UNKNOWN));
 
@@ -3059,21 +3350,17 @@ absl::StatusOr<grpc::Status> IrWriteRpcStatusToGrpcStatus(
     const IrWriteRpcStatus &ir_write_status) {
   switch (ir_write_status.status_case()) {
     case IrWriteRpcStatus::kRpcResponse: {
-      bool all_ir_update_status_ok =
-          absl::c_all_of(ir_write_status.rpc_response().statuses(),
-                         [](const IrUpdateStatus &ir_update_status) {
-                           return ir_update_status.code() == google::rpc::OK;
-                         });
-      bool ir_update_status_has_no_error_message =
+      // A fully successful batch has no details to encode.
+      bool all_ir_update_status_ok_without_message =
           absl::c_all_of(ir_write_status.rpc_response().statuses(),
                          [](const IrUpdateStatus &ir_update_status) {
-                           return ir_update_status.message().empty();
+                           return ir_update_status.code() == google::rpc::OK &&
+                                  ir_update_status.message().empty();
                          });
-      if (all_ir_update_status_ok && ir_update_status_has_no_error_message) {
-        return grpc::Status(grpc::StatusCode::OK, "");
-      } else {
-        return IrWriteResponseToGrpcStatus(ir_write_status.rpc_response());
+      if (all_ir_update_status_ok_without_message) {
+        return grpc::Status::OK;
       }
+      return IrWriteResponseToGrpcStatus(ir_write_status.rpc_response());
     }
     case IrWriteRpcStatus::kRpcWideError: {
       RETURN_IF_ERROR(IsGoogleRpcCode(ir_write_status.rpc_wide_error().code()));
@@ -23,9 +23,11 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "google/protobuf/arena.h"
 #include "grpcpp/support/status.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/translation_options.h"
 
@@ -46,16 +48,36 @@ absl::StatusOr<IrP4Info> CreateIrP4Info(const p4::config::v1::P4Info& p4_info);
 absl::StatusOr<IrEntity> PiEntityToIr(
     const IrP4Info& info, const p4::v1::Entity& pi,
     const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
+// Same as above, but table entries are translated through the precomputed
+// lookup tables of a CompiledIrP4Info.
+absl::StatusOr<IrEntity> PiEntityToIr(
+    const CompiledIrP4Info& info, const p4::v1::Entity& pi,
+    const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
 absl::StatusOr<IrEntities> PiEntitiesToIr(
     const IrP4Info& info, absl::Span<const p4::v1::Entity> pi,
     const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
+// Same as above, but the result and all of its fields are allocated on, and
+// owned by, `arena`. This saves an allocation per field when translating many
+// entities. On error, the partial result is left on the arena.
+absl::StatusOr<IrEntities*> PiEntitiesToIr(
+    const IrP4Info& info, absl::Span<const p4::v1::Entity> pi,
+    google::protobuf::Arena* arena,
+    const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
 
 absl::StatusOr<IrTableEntry> PiTableEntryToIr(
     const IrP4Info& info, const p4::v1::TableEntry& pi,
     const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
+absl::StatusOr<IrTableEntry> PiTableEntryToIr(
+    const CompiledIrP4Info& info, const p4::v1::TableEntry& pi,
+    const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
 absl::StatusOr<IrTableEntries> PiTableEntriesToIr(
     const IrP4Info& info, absl::Span<const p4::v1::TableEntry> pi,
     const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
+// Same as above, but the result is allocated on, and owned by, `arena`.
+absl::StatusOr<IrTableEntries*> PiTableEntriesToIr(
+    const IrP4Info& info, absl::Span<const p4::v1::TableEntry> pi,
+    google::protobuf::Arena* arena,
+    const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
 
 absl::StatusOr<IrPacketReplicationEngineEntry>
 PiPacketReplicationEngineEntryToIr(
@@ -104,13 +126,25 @@ absl::StatusOr<IrStreamMessageResponse> PiStreamMessageResponseToIr(
 absl::StatusOr<p4::v1::Entity> IrEntityToPi(
     const IrP4Info& info, const IrEntity& ir,
     const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
+// Same as above, but table entries are translated through the precomputed
+// lookup tables of a CompiledIrP4Info.
+absl::StatusOr<p4::v1::Entity> IrEntityToPi(
+    const CompiledIrP4Info& info, const IrEntity& ir,
+    const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
 absl::StatusOr<std::vector<p4::v1::Entity>> IrEntitiesToPi(
     const IrP4Info& info, const IrEntities& ir,
     const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
+// Same as above, but every entity is allocated on, and owned by, `arena`.
+absl::StatusOr<std::vector<p4::v1::Entity*>> IrEntitiesToPi(
+    const IrP4Info& info, const IrEntities& ir, google::protobuf::Arena* arena,
+    const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
 
 absl::StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
     const IrP4Info& info, const IrTableEntry& ir,
     const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
+absl::StatusOr<p4::v1::TableEntry> IrTableEntryToPi(
+    const CompiledIrP4Info& info, const IrTableEntry& ir,
+    const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
 absl::StatusOr<std::vector<p4::v1::TableEntry>> IrTableEntriesToPi(
     const IrP4Info& info, const IrTableEntries& ir,
     const TranslationOptions& options PDPI_TRANSLATION_OPTIONS_DEFAULT);
@@ -0,0 +1,318 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/ir_p4info_cache.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "gutil/status.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+namespace {
+
+constexpr char kCacheMagic[] = "PDPIIRP4INFO";
+constexpr int kCacheMagicSize = sizeof(kCacheMagic) - 1;
+constexpr uint32_t kCacheVersion = 1;
+
+// Processes rarely use more than a handful of P4Infos, so this only bounds the
+// memory of processes that see many, e.g. fuzzers.
+constexpr int kMaxCachedIrP4Infos = 16;
+
+std::string SerializeDeterministically(const p4::config::v1::P4Info& p4_info) {
+  std::string bytes;
+  {
+    google::protobuf::io::StringOutputStream output_stream(&bytes);
+    google::protobuf::io::CodedOutputStream output(&output_stream);
+    output.SetSerializationDeterministic(true);
+    p4_info.SerializeToCodedStream(&output);
+  }
+  return bytes;
+}
+
+// 64-bit FNV-1a. Unlike absl::Hash, it does not depend on a per-process seed.
+uint64_t Fingerprint(absl::string_view bytes) {
+  uint64_t fingerprint = 0xcbf29ce484222325;
+  for (const char byte : bytes) {
+    fingerprint ^= static_cast<uint8_t>(byte);
+    fingerprint *= 0x100000001b3;
+  }
+  return fingerprint;
+}
+
+std::string CacheFilePath(absl::string_view directory, uint64_t fingerprint) {
+  return absl::StrFormat("%s/%016x.irp4info", directory, fingerprint);
+}
+
+void WriteBytes(google::protobuf::io::CodedOutputStream& output,
+                absl::string_view value) {
+  output.WriteVarint32(value.size());
+  output.WriteRaw(value.data(), value.size());
+}
+
+bool ReadBytes(google::protobuf::io::CodedInputStream& input,
+               std::string& value) {
+  uint32_t size = 0;
+  return input.ReadVarint32(&size) && input.ReadString(&value, size);
+}
+
+absl::Status WriteCacheFile(const std::string& path,
+                            absl::string_view serialized_p4info,
+                            const IrP4Info& ir_p4info) {
+  std::string serialized_ir_p4info;
+  if (!ir_p4info.SerializeToString(&serialized_ir_p4info)) {
+    return gutil::InternalErrorBuilder()
+           << "Failed to serialize IrP4Info for cache '" << path << "'.";
+  }
+
+  const std::string tmp_path = absl::StrCat(path, ".tmp");
+  std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return gutil::InternalErrorBuilder()
+           << "Could not open IrP4Info cache '" << tmp_path
+           << "' for writing: " << std::strerror(errno);
+  }
+
+  bool serialized = true;
+  {
+    google::protobuf::io::OstreamOutputStream output_stream(&file);
+    google::protobuf::io::CodedOutputStream output(&output_stream);
+
+    output.WriteRaw(kCacheMagic, kCacheMagicSize);
+    output.WriteVarint32(kCacheVersion);
+    output.WriteLittleEndian64(Fingerprint(serialized_p4info));
+    WriteBytes(output, serialized_p4info);
+    WriteBytes(output, serialized_ir_p4info);
+    serialized = !output.HadError();
+  }
+  file.close();
+  if (!serialized || file.fail()) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Failed to write IrP4Info cache '" << tmp_path << "'.";
+  }
+
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Could not move IrP4Info cache to '" << path
+           << "': " << std::strerror(errno);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<IrP4Info> ReadCacheFile(const std::string& path,
+                                       absl::string_view serialized_p4info) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return gutil::NotFoundErrorBuilder()
+           << "Could not open IrP4Info cache '" << path
+           << "': " << std::strerror(errno);
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  const std::string data = contents.str();
+
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(data.data()), data.size());
+
+  std::string magic;
+  uint32_t version = 0;
+  uint64_t fingerprint = 0;
+  if (!input.ReadString(&magic, kCacheMagicSize) || magic != kCacheMagic ||
+      !input.ReadVarint32(&version)) {
+    return gutil::DataLossErrorBuilder()
+           << "'" << path << "' is not an IrP4Info cache.";
+  }
+  if (version != kCacheVersion) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "IrP4Info cache '" << path << "' has version " << version
+           << ", but only version " << kCacheVersion << " is supported.";
+  }
+  if (!input.ReadLittleEndian64(&fingerprint)) {
+    return gutil::DataLossErrorBuilder()
+           << "IrP4Info cache '" << path << "' has a corrupt header.";
+  }
+  // The fingerprint is checked first so that stale files are rejected without
+  // reading the P4Info they were written for.
+  if (fingerprint != Fingerprint(serialized_p4info)) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "IrP4Info cache '" << path
+           << "' was written for a different P4Info.";
+  }
+
+  std::string cached_p4info;
+  std::string serialized_ir_p4info;
+  if (!ReadBytes(input, cached_p4info) ||
+      !ReadBytes(input, serialized_ir_p4info)) {
+    return gutil::DataLossErrorBuilder()
+           << "IrP4Info cache '" << path << "' is truncated.";
+  }
+  if (input.CurrentPosition() != data.size()) {
+    return gutil::DataLossErrorBuilder()
+           << "IrP4Info cache '" << path << "' has unexpected trailing data.";
+  }
+  if (cached_p4info != serialized_p4info) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "IrP4Info cache '" << path
+           << "' was written for a different P4Info with the same "
+              "fingerprint.";
+  }
+  IrP4Info ir_p4info;
+  if (!ir_p4info.ParseFromString(serialized_ir_p4info)) {
+    return gutil::DataLossErrorBuilder()
+           << "IrP4Info cache '" << path << "' has a corrupt IrP4Info.";
+  }
+  return ir_p4info;
+}
+
+// The IrP4Infos of the process, keyed by P4Info fingerprint.
+class IrP4InfoCache {
+ public:
+  // Returns the cached IrP4Info for the serialized P4Info, or nullptr.
+  std::shared_ptr<const IrP4Info> Find(uint64_t fingerprint,
+                                       absl::string_view serialized_p4info)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    auto it = entries_.find(fingerprint);
+    if (it == entries_.end() ||
+        it->second.serialized_p4info != serialized_p4info) {
+      return nullptr;
+    }
+    return it->second.ir_p4info;
+  }
+
+  // Caches `ir_p4info` for the serialized P4Info and returns it. If another
+  // thread cached an IrP4Info for it first, returns that one instead. On a
+  // fingerprint collision, `ir_p4info` is returned but not cached.
+  std::shared_ptr<const IrP4Info> Insert(
+      uint64_t fingerprint, std::string serialized_p4info,
+      std::shared_ptr<const IrP4Info> ir_p4info) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    if (auto it = entries_.find(fingerprint); it != entries_.end()) {
+      if (it->second.serialized_p4info != serialized_p4info) return ir_p4info;
+      return it->second.ir_p4info;
+    }
+    entries_.insert(
+        {fingerprint, Entry{.serialized_p4info = std::move(serialized_p4info),
+                            .ir_p4info = ir_p4info}});
+    insertion_order_.push_back(fingerprint);
+    if (insertion_order_.size() > kMaxCachedIrP4Infos) {
+      entries_.erase(insertion_order_.front());
+      insertion_order_.pop_front();
+    }
+    return ir_p4info;
+  }
+
+  void Clear() ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    entries_.clear();
+    insertion_order_.clear();
+  }
+
+ private:
+  struct Entry {
+    // Kept to tell P4Infos with the same fingerprint apart.
+    std::string serialized_p4info;
+    std::shared_ptr<const IrP4Info> ir_p4info;
+  };
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<uint64_t, Entry> entries_ ABSL_GUARDED_BY(mutex_);
+  // Fingerprints in `entries_`, oldest first.
+  std::deque<uint64_t> insertion_order_ ABSL_GUARDED_BY(mutex_);
+};
+
+IrP4InfoCache& GetCache() {
+  static IrP4InfoCache* const kCache = new IrP4InfoCache();
+  return *kCache;
+}
+
+}  // namespace
+
+uint64_t P4InfoFingerprint(const p4::config::v1::P4Info& p4_info) {
+  return Fingerprint(SerializeDeterministically(p4_info));
+}
+
+absl::StatusOr<std::shared_ptr<const IrP4Info>> GetOrCreateIrP4Info(
+    const p4::config::v1::P4Info& p4_info,
+    const IrP4InfoCacheOptions& options) {
+  std::string serialized_p4info = SerializeDeterministically(p4_info);
+  const uint64_t fingerprint = Fingerprint(serialized_p4info);
+  if (std::shared_ptr<const IrP4Info> cached =
+          GetCache().Find(fingerprint, serialized_p4info)) {
+    return cached;
+  }
+
+  std::string path;
+  if (!options.directory.empty()) {
+    path = CacheFilePath(options.directory, fingerprint);
+    absl::StatusOr<IrP4Info> from_file =
+        ReadCacheFile(path, serialized_p4info);
+    if (from_file.ok()) {
+      return GetCache().Insert(
+          fingerprint, std::move(serialized_p4info),
+          std::make_shared<const IrP4Info>(*std::move(from_file)));
+    }
+    LOG_IF(INFO, !absl::IsNotFound(from_file.status()))
+        << "Not using the IrP4Info cache: " << from_file.status();
+  }
+
+  ASSIGN_OR_RETURN(IrP4Info ir_p4info, CreateIrP4Info(p4_info));
+  if (!path.empty()) {
+    absl::Status saved = WriteCacheFile(path, serialized_p4info, ir_p4info);
+    LOG_IF(WARNING, !saved.ok())
+        << "Could not save the IrP4Info cache: " << saved;
+  }
+  return GetCache().Insert(fingerprint, std::move(serialized_p4info),
+                           std::make_shared<const IrP4Info>(
+                               std::move(ir_p4info)));
+}
+
+void ClearIrP4InfoCache() { GetCache().Clear(); }
+
+absl::Status WriteIrP4InfoCacheFile(const std::string& path,
+                                    const p4::config::v1::P4Info& p4_info,
+                                    const IrP4Info& ir_p4info) {
+  return WriteCacheFile(path, SerializeDeterministically(p4_info), ir_p4info);
+}
+
+absl::StatusOr<IrP4Info> ReadIrP4InfoCacheFile(
+    const std::string& path, const p4::config::v1::P4Info& p4_info) {
+  return ReadCacheFile(path, SerializeDeterministically(p4_info));
+}
+
+}  // namespace pdpi
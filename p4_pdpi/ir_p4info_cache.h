@@ -0,0 +1,67 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_PDPI_IR_P4INFO_CACHE_H_
+#define PINS_P4_PDPI_IR_P4INFO_CACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+// Returns a fingerprint of the deterministic serialization of `p4_info`. The
+// fingerprint is stable across processes, so it can name on-disk caches.
+uint64_t P4InfoFingerprint(const p4::config::v1::P4Info& p4_info);
+
+struct IrP4InfoCacheOptions {
+  // If non-empty, IrP4Infos missing from the in-memory cache are read from, and
+  // written to, a file in this directory named after the P4Info fingerprint.
+  // Failing to use the file is not an error, the IrP4Info is created instead.
+  std::string directory;
+};
+
+// Returns the same IrP4Info as `CreateIrP4Info(p4_info)`, but creates it at
+// most once per distinct P4Info in the process: later calls with an identical
+// P4Info return the same shared instance. Errors are not cached.
+//
+// Thread-safe. Two threads asking for the same uncached P4Info at the same time
+// may both create it, but they are returned the same instance. A bounded number
+// of IrP4Infos is retained; evicted instances stay valid while referenced.
+absl::StatusOr<std::shared_ptr<const IrP4Info>> GetOrCreateIrP4Info(
+    const p4::config::v1::P4Info& p4_info,
+    const IrP4InfoCacheOptions& options = {});
+
+// Drops every IrP4Info from the in-memory cache. Intended for tests.
+void ClearIrP4InfoCache();
+
+// Writes `ir_p4info`, created from `p4_info`, to `path`. The file is replaced
+// atomically.
+absl::Status WriteIrP4InfoCacheFile(const std::string& path,
+                                    const p4::config::v1::P4Info& p4_info,
+                                    const IrP4Info& ir_p4info);
+
+// Reads an IrP4Info from a file written by `WriteIrP4InfoCacheFile`. Returns a
+// FailedPrecondition error if the file was written for a different P4Info, and
+// a DataLoss error if it is corrupt.
+absl::StatusOr<IrP4Info> ReadIrP4InfoCacheFile(
+    const std::string& path, const p4::config::v1::P4Info& p4_info);
+
+}  // namespace pdpi
+
+#endif  // PINS_P4_PDPI_IR_P4INFO_CACHE_H_
@@ -0,0 +1,120 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/ir_p4info_cache.h"
+
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/io.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/testing/test_p4info.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+
+TEST(IrP4InfoCacheTest, ReturnsOneSharedInstancePerP4Info) {
+  ClearIrP4InfoCache();
+  const p4::config::v1::P4Info p4info = GetTestP4Info();
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const IrP4Info> first,
+                       GetOrCreateIrP4Info(p4info));
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const IrP4Info> second,
+                       GetOrCreateIrP4Info(p4info));
+  EXPECT_EQ(first.get(), second.get());
+  ASSERT_OK_AND_ASSIGN(IrP4Info expected, CreateIrP4Info(p4info));
+  EXPECT_THAT(*first, EqualsProto(expected));
+
+  p4::config::v1::P4Info other_p4info = p4info;
+  other_p4info.mutable_pkg_info()->set_name("other");
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const IrP4Info> other,
+                       GetOrCreateIrP4Info(other_p4info));
+  EXPECT_NE(first.get(), other.get());
+  EXPECT_EQ(other->pkg_info().name(), "other");
+}
+
+TEST(IrP4InfoCacheTest, ReturnsErrorsOfCreateIrP4Info) {
+  ClearIrP4InfoCache();
+  p4::config::v1::P4Info p4info = GetTestP4Info();
+  *p4info.add_tables() = p4info.tables(0);
+
+  EXPECT_FALSE(GetOrCreateIrP4Info(p4info).ok());
+  EXPECT_FALSE(GetOrCreateIrP4Info(p4info).ok());
+}
+
+TEST(IrP4InfoCacheTest, PersistsIrP4InfosToTheCacheDirectory) {
+  ClearIrP4InfoCache();
+  const p4::config::v1::P4Info& p4info = GetTestP4Info();
+  const IrP4InfoCacheOptions options{.directory = testing::TempDir()};
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const IrP4Info> created,
+                       GetOrCreateIrP4Info(p4info, options));
+
+  // A fresh process, modelled by clearing the in-memory cache, reads the
+  // IrP4Info back from the file written above.
+  ClearIrP4InfoCache();
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const IrP4Info> loaded,
+                       GetOrCreateIrP4Info(p4info, options));
+  EXPECT_NE(created.get(), loaded.get());
+  EXPECT_THAT(*loaded, EqualsProto(*created));
+}
+
+TEST(IrP4InfoCacheTest, CacheFileRoundTrips) {
+  const p4::config::v1::P4Info& p4info = GetTestP4Info();
+  const std::string path =
+      absl::StrCat(testing::TempDir(), "/round_trip.irp4info");
+  ASSERT_OK(WriteIrP4InfoCacheFile(path, p4info, GetTestIrP4Info()));
+
+  EXPECT_THAT(ReadIrP4InfoCacheFile(path, p4info),
+              IsOkAndHolds(EqualsProto(GetTestIrP4Info())));
+}
+
+TEST(IrP4InfoCacheTest, RejectsCacheFilesOfOtherP4Infos) {
+  const p4::config::v1::P4Info& p4info = GetTestP4Info();
+  const std::string path = absl::StrCat(testing::TempDir(), "/stale.irp4info");
+  ASSERT_OK(WriteIrP4InfoCacheFile(path, p4info, GetTestIrP4Info()));
+
+  p4::config::v1::P4Info other_p4info = p4info;
+  other_p4info.mutable_pkg_info()->set_name("other");
+  EXPECT_THAT(ReadIrP4InfoCacheFile(path, other_p4info),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(IrP4InfoCacheTest, RejectsCorruptCacheFiles) {
+  const p4::config::v1::P4Info& p4info = GetTestP4Info();
+  const std::string path =
+      absl::StrCat(testing::TempDir(), "/corrupt.irp4info");
+  ASSERT_OK(WriteIrP4InfoCacheFile(path, p4info, GetTestIrP4Info()));
+  ASSERT_OK_AND_ASSIGN(std::string contents, gutil::ReadFile(path));
+  contents.resize(contents.size() - 1);
+  ASSERT_OK(gutil::WriteFile(contents, path));
+
+  EXPECT_THAT(ReadIrP4InfoCacheFile(path, p4info),
+              StatusIs(absl::StatusCode::kDataLoss));
+  ASSERT_OK(gutil::WriteFile("not a cache", path));
+  EXPECT_THAT(ReadIrP4InfoCacheFile(path, p4info),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+}  // namespace
+}  // namespace pdpi
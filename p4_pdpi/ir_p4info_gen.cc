@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Given a P4Info file, writes the corresponding IrP4Info as a binary proto, so
+// that programs can embed and parse it instead of creating it at startup.
+
+#include <iostream>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_join.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "gutil/io.h"
+#include "gutil/proto.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+
+ABSL_FLAG(std::string, p4info, "", "p4info file (required)");
+ABSL_FLAG(std::string, output, "", "binary IrP4Info output file (required)");
+
+constexpr char kUsage[] = "--p4info=<file> --output=<file>";
+
+using ::p4::config::v1::P4Info;
+
+int main(int argc, char** argv) {
+  absl::SetProgramUsageMessage(
+      absl::StrJoin({"usage:", (const char*)argv[0], kUsage}, " "));
+  absl::ParseCommandLine(argc, argv);
+
+  const std::string p4info_filename = absl::GetFlag(FLAGS_p4info);
+  if (p4info_filename.empty()) {
+    std::cerr << "Missing argument: --p4info=<file>" << std::endl;
+    return 1;
+  }
+  const std::string output_filename = absl::GetFlag(FLAGS_output);
+  if (output_filename.empty()) {
+    std::cerr << "Missing argument: --output=<file>" << std::endl;
+    return 1;
+  }
+
+  P4Info p4info;
+  absl::Status status = gutil::ReadProtoFromFile(p4info_filename, &p4info);
+  if (!status.ok()) {
+    std::cerr << status << std::endl;
+    return 1;
+  }
+
+  absl::StatusOr<pdpi::IrP4Info> info = pdpi::CreateIrP4Info(p4info);
+  if (!info.ok()) {
+    std::cerr << "Failed to convert to IrP4Info: " << info.status()
+              << std::endl;
+    return 1;
+  }
+
+  // Serializes deterministically (map fields in key order), so the output only
+  // changes when the IrP4Info does.
+  std::string serialized_info;
+  {
+    google::protobuf::io::StringOutputStream output_stream(&serialized_info);
+    google::protobuf::io::CodedOutputStream output(&output_stream);
+    output.SetSerializationDeterministic(true);
+    info->SerializeToCodedStream(&output);
+  }
+  status = gutil::WriteFile(serialized_info, output_filename);
+  if (!status.ok()) {
+    std::cerr << status << std::endl;
+    return 1;
+  }
+  return 0;
+}
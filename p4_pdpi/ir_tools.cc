@@ -1,12 +1,16 @@
 #include "p4_pdpi/ir_tools.h"
 
+#include <algorithm>
 #include <string>
+#include <thread>  // NOLINT: third_party code.
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "gutil/collections.h"
 #include "gutil/status.h"
 #include "p4/config/v1/p4info.pb.h"
@@ -88,6 +92,45 @@ absl::Status TransformValuesOfType(
   return absl::OkStatus();
 }
 
+// Returns the value of `match` that is passed to a transformer, or nullptr if
+// `match` has no such value. Mirrors the cases handled above.
+std::string* MutableMatchValue(IrMatch& match) {
+  switch (match.match_value_case()) {
+    case IrMatch::kExact:
+      return match.mutable_exact()->mutable_str();
+    case IrMatch::kOptional:
+      if (!match.optional().has_value()) return nullptr;
+      return match.mutable_optional()->mutable_value()->mutable_str();
+    case IrMatch::kLpm:
+      if (!match.lpm().has_value()) return nullptr;
+      return match.mutable_lpm()->mutable_value()->mutable_str();
+    case IrMatch::kTernary:
+      if (!match.ternary().has_value()) return nullptr;
+      return match.mutable_ternary()->mutable_value()->mutable_str();
+    default:
+      return nullptr;
+  }
+}
+
+// Like `MutableMatchValue`, but without modifying `match`.
+const std::string* MatchValue(const IrMatch& match) {
+  switch (match.match_value_case()) {
+    case IrMatch::kExact:
+      return &match.exact().str();
+    case IrMatch::kOptional:
+      if (!match.optional().has_value()) return nullptr;
+      return &match.optional().value().str();
+    case IrMatch::kLpm:
+      if (!match.lpm().has_value()) return nullptr;
+      return &match.lpm().value().str();
+    case IrMatch::kTernary:
+      if (!match.ternary().has_value()) return nullptr;
+      return &match.ternary().value().str();
+    default:
+      return nullptr;
+  }
+}
+
 }  // namespace
 
 absl::Status TransformValuesOfType(
@@ -131,21 +174,159 @@ absl::Status TransformValuesOfType(
   return absl::OkStatus();
 }
 
-// This implementation is inefficient because it uses `TransformValuesOfType`,
-// which also means that it needs to copy its input entries, in order to not
-// transform them.
-// TODO: Implement a more efficient version if required.
 absl::Status VisitValuesOfType(
     const IrP4Info& info, const p4::config::v1::P4NamedType& target_type,
-    std::vector<IrTableEntry> entries,
+    const std::vector<IrTableEntry>& entries,
     const absl::AnyInvocable<absl::Status(absl::string_view) const>& visitor) {
-  return TransformValuesOfType(
-      info, target_type, entries,
-      /*transformer=*/
-      [&](absl::string_view input) -> absl::StatusOr<std::string> {
-        RETURN_IF_ERROR(visitor(input));
-        return "";
-      });
+  ValuesOfTypeFinder finder(info, target_type);
+  for (const IrTableEntry& entry : entries) {
+    RETURN_IF_ERROR(finder.Visit(entry, visitor));
+  }
+  return absl::OkStatus();
+}
+
+ValuesOfTypeFinder::ValuesOfTypeFinder(
+    const IrP4Info& info, const p4::config::v1::P4NamedType& target_type) {
+  for (const auto& [action_name, action_def] : info.actions_by_name()) {
+    absl::flat_hash_set<std::string>& params =
+        params_by_action_name_[action_name];
+    for (const auto& [param_name, param_def] : action_def.params_by_name()) {
+      if (param_def.param().type_name().name() == target_type.name()) {
+        params.insert(param_name);
+      }
+    }
+  }
+
+  auto action_has_values = [&](const IrActionReference& action_ref) {
+    auto it =
+        params_by_action_name_.find(action_ref.action().preamble().alias());
+    return it != params_by_action_name_.end() && !it->second.empty();
+  };
+  for (const auto& [table_name, table_def] : info.tables_by_name()) {
+    TableValues& values = values_by_table_name_[table_name];
+    for (const auto& [match_name, match_def] :
+         table_def.match_fields_by_name()) {
+      if (match_def.match_field().type_name().name() == target_type.name()) {
+        values.match_fields.insert(match_name);
+      }
+    }
+    values.actions_may_have_values =
+        absl::c_any_of(table_def.entry_actions(), action_has_values) ||
+        absl::c_any_of(table_def.default_only_actions(), action_has_values);
+  }
+}
+
+absl::Status ValuesOfTypeFinder::Transform(
+    IrTableEntry& entry, const Transformer& transformer) const {
+  ASSIGN_OR_RETURN(
+      const TableValues* table_values,
+      gutil::FindPtrOrStatus(values_by_table_name_, entry.table_name()));
+
+  auto transform_action = [&](IrActionInvocation& action) -> absl::Status {
+    ASSIGN_OR_RETURN(
+        const absl::flat_hash_set<std::string>* params,
+        gutil::FindPtrOrStatus(params_by_action_name_, action.name()));
+    if (params->empty()) return absl::OkStatus();
+    for (auto& param : *action.mutable_params()) {
+      if (params->contains(param.name())) {
+        ASSIGN_OR_RETURN(*param.mutable_value()->mutable_str(),
+                         transformer(param.value().str()));
+      }
+    }
+    return absl::OkStatus();
+  };
+  if (table_values->actions_may_have_values) {
+    if (entry.has_action_set()) {
+      for (auto& action : *entry.mutable_action_set()->mutable_actions()) {
+        RETURN_IF_ERROR(transform_action(*action.mutable_action()));
+      }
+    }
+    if (entry.has_action()) {
+      RETURN_IF_ERROR(transform_action(*entry.mutable_action()));
+    }
+  }
+
+  if (table_values->match_fields.empty()) return absl::OkStatus();
+  for (auto& match : *entry.mutable_matches()) {
+    if (!table_values->match_fields.contains(match.name())) continue;
+    if (std::string* value = MutableMatchValue(match); value != nullptr) {
+      ASSIGN_OR_RETURN(*value, transformer(*value));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ValuesOfTypeFinder::Transform(absl::Span<IrTableEntry> entries,
+                                           const Transformer& transformer,
+                                           int num_threads) const {
+  if (num_threads <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Number of threads must be > 0. Number of threads: "
+           << num_threads;
+  }
+  num_threads = std::min<int>(num_threads, entries.size());
+  if (num_threads <= 1) {
+    for (IrTableEntry& entry : entries) {
+      RETURN_IF_ERROR(Transform(entry, transformer));
+    }
+    return absl::OkStatus();
+  }
+
+  // Each thread transforms one contiguous chunk and records its first error,
+  // so the first error over all chunks is the first error in entry order.
+  const int chunk_size = (entries.size() + num_threads - 1) / num_threads;
+  std::vector<absl::Status> statuses(num_threads);
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    const int chunk_start = std::min<int>(i * chunk_size, entries.size());
+    threads.emplace_back([&, i, chunk_start] {
+      for (IrTableEntry& entry : entries.subspan(chunk_start, chunk_size)) {
+        statuses[i] = Transform(entry, transformer);
+        if (!statuses[i].ok()) return;
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (const absl::Status& chunk_status : statuses) {
+    RETURN_IF_ERROR(chunk_status);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ValuesOfTypeFinder::Visit(const IrTableEntry& entry,
+                                       const Visitor& visitor) const {
+  ASSIGN_OR_RETURN(
+      const TableValues* table_values,
+      gutil::FindPtrOrStatus(values_by_table_name_, entry.table_name()));
+
+  auto visit_action = [&](const IrActionInvocation& action) -> absl::Status {
+    ASSIGN_OR_RETURN(
+        const absl::flat_hash_set<std::string>* params,
+        gutil::FindPtrOrStatus(params_by_action_name_, action.name()));
+    if (params->empty()) return absl::OkStatus();
+    for (const auto& param : action.params()) {
+      if (params->contains(param.name())) {
+        RETURN_IF_ERROR(visitor(param.value().str()));
+      }
+    }
+    return absl::OkStatus();
+  };
+  if (table_values->actions_may_have_values) {
+    for (const auto& action : entry.action_set().actions()) {
+      RETURN_IF_ERROR(visit_action(action.action()));
+    }
+    if (entry.has_action()) RETURN_IF_ERROR(visit_action(entry.action()));
+  }
+
+  if (table_values->match_fields.empty()) return absl::OkStatus();
+  for (const auto& match : entry.matches()) {
+    if (!table_values->match_fields.contains(match.name())) continue;
+    if (const std::string* value = MatchValue(match); value != nullptr) {
+      RETURN_IF_ERROR(visitor(*value));
+    }
+  }
+  return absl::OkStatus();
 }
 
 }  // namespace pdpi
@@ -5,10 +5,13 @@
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "absl/types/variant.h"
 #include "p4/config/v1/p4types.pb.h"
 #include "p4_pdpi/ir.pb.h"
@@ -42,14 +45,64 @@ absl::Status TransformValuesOfType(
         transformer);
 
 // `VisitValuesOfType` uses `info` to find all values of `target_type`
-// in `entries`, then applies `visitor` to them.
-// WARNING: This function is inefficient because it copies the entries and uses
-// `TransformValuesOfType`, mutating every value of `target_type`.
+// in `entries`, then applies `visitor` to them. Unlike `TransformValuesOfType`,
+// only table and action names are checked against `info`.
 absl::Status VisitValuesOfType(
     const IrP4Info& info, const p4::config::v1::P4NamedType& target_type,
-    std::vector<IrTableEntry> entries,
+    const std::vector<IrTableEntry>& entries,
     const absl::AnyInvocable<absl::Status(absl::string_view) const>& visitor);
 
+// Finds the values of one P4NamedType in IR table entries. On construction, it
+// works out once per table and action of an IrP4Info which match fields and
+// parameters have the type, so that each entry only costs a lookup of its table
+// and action plus the work on the values of the type. Entries of tables whose
+// match fields and actions never have the type are skipped outright.
+//
+// Entries must belong to the IrP4Info the finder was constructed from, but the
+// IrP4Info need not outlive the finder. Only table and action names are
+// checked; match fields and parameters that the IrP4Info does not know are
+// skipped rather than reported. The same caveats about counters, meters and
+// registers as for `TransformValuesOfType` apply.
+class ValuesOfTypeFinder {
+ public:
+  using Transformer =
+      std::function<absl::StatusOr<std::string>(absl::string_view)>;
+  using Visitor = absl::AnyInvocable<absl::Status(absl::string_view) const>;
+
+  ValuesOfTypeFinder(const IrP4Info& info,
+                     const p4::config::v1::P4NamedType& target_type);
+
+  // Applies `transformer` to every value of the target type in `entry`.
+  absl::Status Transform(IrTableEntry& entry,
+                         const Transformer& transformer) const;
+
+  // Applies `transformer` to every value of the target type in `entries`,
+  // splitting the entries across up to `num_threads` threads. With more than
+  // one thread, `transformer` must be thread-safe. Returns the error of the
+  // first failing entry; any subset of `entries` may have been transformed by
+  // then.
+  absl::Status Transform(absl::Span<IrTableEntry> entries,
+                         const Transformer& transformer,
+                         int num_threads = 1) const;
+
+  // Applies `visitor` to every value of the target type in `entry`.
+  absl::Status Visit(const IrTableEntry& entry, const Visitor& visitor) const;
+
+ private:
+  struct TableValues {
+    // The match fields of the table that have the target type.
+    absl::flat_hash_set<std::string> match_fields;
+    // True if some action of the table has a parameter of the target type.
+    bool actions_may_have_values = false;
+  };
+
+  // Keyed by table name, for every table of the IrP4Info.
+  absl::flat_hash_map<std::string, TableValues> values_by_table_name_;
+  // Keyed by action name, for every action of the IrP4Info.
+  absl::flat_hash_map<std::string, absl::flat_hash_set<std::string>>
+      params_by_action_name_;
+};
+
 }  // namespace pdpi
 
 #endif  // PINS_P4_PDPI_IR_TOOLS_H_
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
@@ -23,6 +24,8 @@ namespace pdpi {
 namespace {
 
 using ::gutil::EqualsProto;
+using ::gutil::EqualsProtoSequence;
+using ::gutil::StatusIs;
 using ::testing::UnorderedElementsAreArray;
 
 absl::StatusOr<std::string> AddAnotherToString(absl::string_view initial) {
@@ -143,5 +146,66 @@ TEST(VisitValuesOfTypeTest, CollectStrings) {
                                  }));
 }
 
+// Transforms a batch of entries of several tables in parallel, giving the same
+// result as transforming them one at a time.
+TEST(ValuesOfTypeFinderTest, BatchTransformMatchesTransformValuesOfType) {
+  const IrP4Info info = GetTestIrP4Info();
+  p4::config::v1::P4NamedType target_type;
+  target_type.set_name("string_id_t");
+
+  ASSERT_OK_AND_ASSIGN(IrTableEntry match_entry,
+                       PartialPdTableEntryToIrTableEntry(
+                           info, gutil::ParseProtoOrDie<TableEntry>(R"pb(
+                             one_match_field_table_entry {
+                               match { id: "string" }
+                               action { do_thing_4 {} }
+                             }
+                           )pb")));
+  ASSERT_OK_AND_ASSIGN(IrTableEntry action_entry,
+                       PartialPdTableEntryToIrTableEntry(
+                           info, gutil::ParseProtoOrDie<TableEntry>(R"pb(
+                             referring_by_action_table_entry {
+                               match { val: "0x001" }
+                               action {
+                                 referring_to_two_match_fields_action {
+                                   referring_id_1: "string",
+                                   referring_id_2: "0x004",
+                                 }
+                               }
+                             }
+                           )pb")));
+  std::vector<IrTableEntry> entries;
+  for (int i = 0; i < 10; ++i) {
+    match_entry.mutable_matches(0)->mutable_exact()->set_str(
+        absl::StrCat("string", i));
+    entries.push_back(match_entry);
+    entries.push_back(action_entry);
+  }
+  std::vector<IrTableEntry> expected_entries = entries;
+  ASSERT_OK(TransformValuesOfType(info, target_type, expected_entries,
+                                  /*transformer=*/AddAnotherToString));
+
+  ValuesOfTypeFinder finder(info, target_type);
+  ASSERT_OK(finder.Transform(absl::MakeSpan(entries),
+                             /*transformer=*/AddAnotherToString,
+                             /*num_threads=*/3));
+  EXPECT_THAT(entries, EqualsProtoSequence(expected_entries));
+}
+
+TEST(ValuesOfTypeFinderTest, RejectsEntriesOfUnknownTables) {
+  p4::config::v1::P4NamedType target_type;
+  target_type.set_name("string_id_t");
+  ValuesOfTypeFinder finder(GetTestIrP4Info(), target_type);
+  IrTableEntry entry;
+  entry.set_table_name("unknown_table");
+
+  EXPECT_THAT(finder.Transform(entry, /*transformer=*/AddAnotherToString),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(finder.Visit(entry, /*visitor=*/[](absl::string_view) {
+    return absl::OkStatus();
+  }),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
 }  // namespace
 }  // namespace pdpi
@@ -17,10 +17,8 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
-#include <vector>
 
 #include "absl/status/statusor.h"
-#include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "gutil/status.h"
@@ -42,6 +40,15 @@ bool ParseByteInBase10(absl::string_view base10_string, uint8_t& byte) {
   return true;
 }
 
+// Writes the byte in base 10, without leading zeros, and returns a pointer
+// past the last digit.
+char* WriteByteInBase10(uint8_t byte, char* buffer) {
+  if (byte >= 100) *buffer++ = '0' + byte / 100;
+  if (byte >= 10) *buffer++ = '0' + byte / 10 % 10;
+  *buffer++ = '0' + byte % 10;
+  return buffer;
+}
+
 }  // namespace
 
 absl::StatusOr<Ipv4Address> Ipv4Address::OfString(absl::string_view address) {
@@ -50,25 +57,30 @@ absl::StatusOr<Ipv4Address> Ipv4Address::OfString(absl::string_view address) {
            << "Invalid IPv4 address: '" << address << "'";
   };
 
-  std::vector<std::string> bytes = absl::StrSplit(address, '.');
-  if (bytes.size() != 4) return invalid();
-
-  std::bitset<32> bits;
-  for (absl::string_view byte_string : bytes) {
+  int num_bytes = 0;
+  uint32_t bits = 0;
+  for (absl::string_view byte_string : absl::StrSplit(address, '.')) {
     uint8_t byte;
-    if (!ParseByteInBase10(byte_string, byte)) return invalid();
-    bits <<= 8;
-    bits |= byte;
+    if (++num_bytes > 4 || !ParseByteInBase10(byte_string, byte)) {
+      return invalid();
+    }
+    bits = (bits << 8) | byte;
   }
-  return Ipv4Address(bits);
+  if (num_bytes != 4) return invalid();
+  return Ipv4Address(std::bitset<32>(bits));
 }
 
 std::string Ipv4Address::ToString() const {
-  uint8_t byte4 = (bits_ >> 24).to_ulong() & 0xFFu;
-  uint8_t byte3 = (bits_ >> 16).to_ulong() & 0xFFu;
-  uint8_t byte2 = (bits_ >> 8).to_ulong() & 0xFFu;
-  uint8_t byte1 = (bits_ >> 0).to_ulong() & 0xFFu;
-  return absl::StrFormat("%d.%d.%d.%d", byte4, byte3, byte2, byte1);
+  const uint32_t bits = bits_.to_ulong();
+
+  // At most "255.255.255.255".
+  char buffer[15];
+  char* end = buffer;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    end = WriteByteInBase10((bits >> shift) & 0xFFu, end);
+    if (shift != 0) *end++ = '.';
+  }
+  return std::string(buffer, end - buffer);
 }
 
 }  // namespace netaddr
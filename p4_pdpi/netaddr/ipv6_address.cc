@@ -19,6 +19,7 @@
 
 #include <bitset>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <utility>
 
@@ -28,14 +29,24 @@
 #include "glog/logging.h"
 #include "gutil/status.h"
 #include "p4_pdpi/netaddr/network_address.h"
+#include "p4_pdpi/string_encodings/byte_string.h"
 #include "p4_pdpi/string_encodings/hex_string.h"
 
 namespace netaddr {
 
 absl::StatusOr<Ipv6Address> Ipv6Address::OfString(absl::string_view address) {
-  std::string bytes = std::string(128 / 8, '\x0');
-  if (inet_pton(AF_INET6, address.data(), bytes.data()) == 1) {
-    auto ip = Ipv6Address::OfByteString(bytes);
+  // inet_pton needs a null-terminated string. No valid address is longer than
+  // INET6_ADDRSTRLEN - 1 characters.
+  char address_buffer[INET6_ADDRSTRLEN];
+  char bytes[128 / 8];
+  if (address.size() < sizeof(address_buffer)) {
+    memcpy(address_buffer, address.data(), address.size());
+    address_buffer[address.size()] = '\0';
+  }
+  if (address.size() < sizeof(address_buffer) &&
+      inet_pton(AF_INET6, address_buffer, bytes) == 1) {
+    auto ip =
+        Ipv6Address::OfByteString(absl::string_view(bytes, sizeof(bytes)));
     if (ip.ok()) return ip;
     LOG(DFATAL) << "failed to parse IPv6 byte string produced by inet_pton: "
                 << ip.status();
@@ -46,9 +57,10 @@ absl::StatusOr<Ipv6Address> Ipv6Address::OfString(absl::string_view address) {
 
 std::string Ipv6Address::ToString() const {
   char result[INET6_ADDRSTRLEN];
-  std::string bytes = ToPaddedByteString();
-  if (inet_ntop(AF_INET6, bytes.c_str(), result, sizeof(result)) != nullptr) {
-    return std::string(std::move(result));
+  char bytes[128 / 8];
+  pdpi::BitsetToPaddedBytes(bits_, bytes);
+  if (inet_ntop(AF_INET6, bytes, result, sizeof(result)) != nullptr) {
+    return std::string(result);
   }
   LOG(DFATAL) << "inet_ntop failed to convert IPv6 address " << ToHexString()
               << " to readable string";
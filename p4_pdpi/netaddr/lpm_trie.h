@@ -0,0 +1,156 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_P4_PDPI_NETADDR_LPM_TRIE_H_
+#define PINS_P4_PDPI_NETADDR_LPM_TRIE_H_
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/statusor.h"
+#include "gutil/status.h"
+#include "p4_pdpi/netaddr/prefix.h"
+
+namespace netaddr {
+
+// An immutable longest-prefix-match table from prefixes of addresses of type
+// `T` to values of type `V`, e.g. from the routes of an LPM table to their
+// entries.
+//
+// Implemented as a multibit trie with controlled prefix expansion: every node
+// consumes `stride_bits` bits of the address, and is a contiguous array of
+// 2^stride_bits slots in a single vector. A lookup thus takes at most
+// kNumBits / stride_bits dependent loads, e.g. 4 for IPv4 with the default
+// stride of 8. Since every node takes 2^stride_bits slots of 8 bytes, a
+// smaller stride (e.g. 4) is more compact for tables of many long prefixes,
+// such as IPv6 /64 or /128 routes.
+template <typename T, typename V, int stride_bits = 8>
+class LpmTrie {
+ public:
+  static constexpr int kNumBits = Prefix<T>::kNumBits;
+  static_assert(stride_bits > 0 && stride_bits <= 16 &&
+                    kNumBits % stride_bits == 0,
+                "stride_bits must divide the number of address bits");
+
+  using Entry = std::pair<Prefix<T>, V>;
+
+  // Returns the trie of the given entries, or error if a prefix occurs twice.
+  static absl::StatusOr<LpmTrie> Build(std::vector<Entry> entries);
+
+  // Returns the entry with the longest prefix containing `address`, or
+  // nullptr if there is none.
+  const Entry* Lookup(const T& address) const;
+
+  // Returns the entries, ordered by prefix length.
+  const std::vector<Entry>& entries() const { return entries_; }
+  int size() const { return entries_.size(); }
+
+  // Returns the number of bytes used by the trie nodes.
+  int64_t NodeBytes() const { return slots_.size() * sizeof(Slot); }
+
+ private:
+  static constexpr int kNumLevels = kNumBits / stride_bits;
+  static constexpr int kFanout = 1 << stride_bits;
+
+  struct Slot {
+    // Index of the longest prefix ending in this node and containing the
+    // addresses of this slot, or -1.
+    int32_t entry = -1;
+    // Index of the first slot of the child node, or -1.
+    int32_t child = -1;
+  };
+
+  // Returns the `level`-th group of `stride_bits` bits of `bits`, counting
+  // from the most significant bits.
+  static int Chunk(const std::bitset<kNumBits>& bits, int level) {
+    return ((bits >> (kNumBits - stride_bits * (level + 1))) &
+            std::bitset<kNumBits>(kFanout - 1))
+        .to_ulong();
+  }
+
+  LpmTrie() : slots_(kFanout) {}
+
+  std::vector<Entry> entries_;
+  // The root node occupies the first kFanout slots.
+  std::vector<Slot> slots_;
+};
+
+// == END OF PUBLIC INTERFACE ==================================================
+
+template <typename T, typename V, int stride_bits>
+absl::StatusOr<LpmTrie<T, V, stride_bits>> LpmTrie<T, V, stride_bits>::Build(
+    std::vector<Entry> entries) {
+  absl::flat_hash_set<Prefix<T>> prefixes;
+  for (const auto& [prefix, value] : entries) {
+    if (!prefixes.insert(prefix).second) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "duplicate prefix " << prefix.ToString();
+    }
+  }
+
+  // Inserting shorter prefixes first lets longer prefixes simply overwrite the
+  // slots they share in a node.
+  LpmTrie trie;
+  trie.entries_ = std::move(entries);
+  std::stable_sort(trie.entries_.begin(), trie.entries_.end(),
+                   [](const Entry& a, const Entry& b) {
+                     return a.first.length() < b.first.length();
+                   });
+  for (int i = 0; i < static_cast<int>(trie.entries_.size()); ++i) {
+    const Prefix<T>& prefix = trie.entries_[i].first;
+    const std::bitset<kNumBits> bits = prefix.address().ToBitset();
+    // The prefix ends in the node at `level`, where it covers the slots that
+    // agree on its remaining bits.
+    const int level =
+        prefix.length() == 0 ? 0 : (prefix.length() - 1) / stride_bits;
+    int node = 0;
+    for (int l = 0; l < level; ++l) {
+      const int slot = node + Chunk(bits, l);
+      if (trie.slots_[slot].child < 0) {
+        trie.slots_[slot].child = trie.slots_.size();
+        trie.slots_.resize(trie.slots_.size() + kFanout);
+      }
+      node = trie.slots_[slot].child;
+    }
+    const int free_bits = stride_bits * (level + 1) - prefix.length();
+    const int first = Chunk(bits, level);
+    for (int slot = first; slot < first + (1 << free_bits); ++slot) {
+      trie.slots_[node + slot].entry = i;
+    }
+  }
+  return trie;
+}
+
+template <typename T, typename V, int stride_bits>
+const typename LpmTrie<T, V, stride_bits>::Entry*
+LpmTrie<T, V, stride_bits>::Lookup(const T& address) const {
+  const std::bitset<kNumBits> bits = address.ToBitset();
+  int32_t best = -1;
+  int node = 0;
+  for (int level = 0; level < kNumLevels; ++level) {
+    const Slot& slot = slots_[node + Chunk(bits, level)];
+    if (slot.entry >= 0) best = slot.entry;
+    if (slot.child < 0) break;
+    node = slot.child;
+  }
+  return best < 0 ? nullptr : &entries_[best];
+}
+
+}  // namespace netaddr
+
+#endif  // PINS_P4_PDPI_NETADDR_LPM_TRIE_H_
@@ -0,0 +1,161 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmarks for longest-prefix matching with LpmTrie, compared to the
+// linear scan over prefixes it replaces, and for PrefixSet operations.
+//
+// Run with
+//   bazel run -c opt //p4_pdpi/netaddr:lpm_trie_benchmark
+
+#include <bitset>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "benchmark/benchmark.h"
+#include "p4_pdpi/netaddr/ipv4_address.h"
+#include "p4_pdpi/netaddr/ipv6_address.h"
+#include "p4_pdpi/netaddr/lpm_trie.h"
+#include "p4_pdpi/netaddr/prefix.h"
+
+namespace netaddr {
+namespace {
+
+// Returns `num_routes` distinct routes with typical prefix lengths of a
+// routing table, mostly /24s, mapped to their index.
+template <typename T>
+std::vector<std::pair<Prefix<T>, int>> RandomRoutes(int num_routes) {
+  std::mt19937_64 rng(1);
+  std::vector<int> lengths = {8, 16, 20, 22, 24, 24, 24, 24, 32};
+  if constexpr (Prefix<T>::kNumBits == 128) {
+    lengths = {32, 48, 56, 64, 64, 64, 64, 128};
+  }
+  std::vector<std::pair<Prefix<T>, int>> routes;
+  absl::flat_hash_set<Prefix<T>> seen;
+  while (static_cast<int>(routes.size()) < num_routes) {
+    std::bitset<Prefix<T>::kNumBits> bits(rng());
+    bits = (bits << 64) ^ std::bitset<Prefix<T>::kNumBits>(rng());
+    const Prefix<T> prefix =
+        *Prefix<T>::Of(T::OfBitset(bits), lengths[rng() % lengths.size()]);
+    if (seen.insert(prefix).second) routes.push_back({prefix, routes.size()});
+  }
+  return routes;
+}
+
+// Returns addresses with the prefixes of `routes`, so that lookups match.
+template <typename T>
+std::vector<T> MatchingAddresses(
+    const std::vector<std::pair<Prefix<T>, int>>& routes) {
+  std::mt19937_64 rng(2);
+  std::vector<T> addresses;
+  for (int i = 0; i < 1024; ++i) {
+    const Prefix<T>& prefix = routes[rng() % routes.size()].first;
+    std::bitset<Prefix<T>::kNumBits> host(rng());
+    if (prefix.length() < Prefix<T>::kNumBits) {
+      host &= ~std::bitset<Prefix<T>::kNumBits>() >> prefix.length();
+    } else {
+      host.reset();
+    }
+    addresses.push_back(T::OfBitset(prefix.address().ToBitset() | host));
+  }
+  return addresses;
+}
+
+template <typename T, int stride_bits>
+void BM_LpmTrieLookup(benchmark::State& state) {
+  const auto routes = RandomRoutes<T>(state.range(0));
+  const std::vector<T> addresses = MatchingAddresses(routes);
+  const auto trie = *LpmTrie<T, int, stride_bits>::Build(routes);
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(trie.Lookup(addresses[i++ % addresses.size()]));
+  }
+  state.counters["node_bytes"] = trie.NodeBytes();
+}
+BENCHMARK_TEMPLATE(BM_LpmTrieLookup, Ipv4Address, 8)
+    ->Arg(100)
+    ->Arg(10000)
+    ->Arg(100000);
+BENCHMARK_TEMPLATE(BM_LpmTrieLookup, Ipv4Address, 4)
+    ->Arg(100)
+    ->Arg(10000)
+    ->Arg(100000);
+BENCHMARK_TEMPLATE(BM_LpmTrieLookup, Ipv6Address, 4)->Arg(100)->Arg(10000);
+
+template <typename T>
+void BM_LinearScanLookup(benchmark::State& state) {
+  const auto routes = RandomRoutes<T>(state.range(0));
+  const std::vector<T> addresses = MatchingAddresses(routes);
+  int i = 0;
+  for (auto _ : state) {
+    const T& address = addresses[i++ % addresses.size()];
+    const std::pair<Prefix<T>, int>* best = nullptr;
+    for (const auto& route : routes) {
+      if (route.first.Contains(address) &&
+          (best == nullptr || route.first.length() > best->first.length())) {
+        best = &route;
+      }
+    }
+    benchmark::DoNotOptimize(best);
+  }
+}
+BENCHMARK_TEMPLATE(BM_LinearScanLookup, Ipv4Address)->Arg(100)->Arg(10000);
+
+void BM_LpmTrieBuild(benchmark::State& state) {
+  const auto routes = RandomRoutes<Ipv4Address>(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LpmTrie<Ipv4Address, int>::Build(routes));
+  }
+  state.SetItemsProcessed(state.iterations() * routes.size());
+}
+BENCHMARK(BM_LpmTrieBuild)->Arg(10000)->Arg(100000);
+
+// Returns the prefixes of `routes`.
+template <typename T>
+std::vector<Prefix<T>> Prefixes(
+    const std::vector<std::pair<Prefix<T>, int>>& routes) {
+  std::vector<Prefix<T>> prefixes;
+  for (const auto& [prefix, index] : routes) prefixes.push_back(prefix);
+  return prefixes;
+}
+
+void BM_PrefixSetDifference(benchmark::State& state) {
+  const auto routes = RandomRoutes<Ipv4Address>(state.range(0));
+  const std::vector<Prefix<Ipv4Address>> prefixes = Prefixes(routes);
+  const PrefixSet<Ipv4Address> all(prefixes);
+  const PrefixSet<Ipv4Address> half(std::vector<Prefix<Ipv4Address>>(
+      prefixes.begin(), prefixes.begin() + prefixes.size() / 2));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(PrefixSet<Ipv4Address>::Difference(all, half));
+  }
+  state.SetItemsProcessed(state.iterations() * prefixes.size());
+}
+BENCHMARK(BM_PrefixSetDifference)->Arg(1000)->Arg(100000);
+
+void BM_PrefixSetContains(benchmark::State& state) {
+  const auto routes = RandomRoutes<Ipv4Address>(state.range(0));
+  const std::vector<Ipv4Address> addresses = MatchingAddresses(routes);
+  const PrefixSet<Ipv4Address> set(Prefixes(routes));
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        set.Contains(addresses[i++ % addresses.size()]));
+  }
+}
+BENCHMARK(BM_PrefixSetContains)->Arg(1000)->Arg(100000);
+
+}  // namespace
+}  // namespace netaddr
@@ -0,0 +1,156 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/netaddr/lpm_trie.h"
+
+#include <bitset>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4_pdpi/netaddr/ipv4_address.h"
+#include "p4_pdpi/netaddr/ipv6_address.h"
+#include "p4_pdpi/netaddr/prefix.h"
+
+namespace netaddr {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::Field;
+using ::testing::IsNull;
+using ::testing::NotNull;
+using ::testing::Pointee;
+
+using Ipv4Prefix = Prefix<Ipv4Address>;
+using Ipv4Trie = LpmTrie<Ipv4Address, std::string>;
+using IntTrie = LpmTrie<Ipv4Address, int>;
+using NarrowIntTrie = LpmTrie<Ipv4Address, int, /*stride_bits=*/4>;
+
+Ipv4Address A(absl::string_view address) {
+  return *Ipv4Address::OfString(address);
+}
+
+Ipv4Prefix P(absl::string_view address, int length) {
+  return *Ipv4Prefix::Of(A(address), length);
+}
+
+// Matches the entry with the given value.
+auto HasValue(absl::string_view value) {
+  return Pointee(Field(&Ipv4Trie::Entry::second, value));
+}
+
+TEST(LpmTrieTest, ReturnsTheLongestMatchingPrefix) {
+  ASSERT_OK_AND_ASSIGN(Ipv4Trie trie,
+                       Ipv4Trie::Build({
+                           {P("0.0.0.0", 0), "default"},
+                           {P("10.0.0.0", 8), "10/8"},
+                           {P("10.1.0.0", 16), "10.1/16"},
+                           {P("10.1.2.0", 23), "10.1.2/23"},
+                           {P("10.1.2.3", 32), "10.1.2.3/32"},
+                       }));
+  EXPECT_EQ(trie.size(), 5);
+  EXPECT_THAT(trie.Lookup(A("11.0.0.0")), HasValue("default"));
+  EXPECT_THAT(trie.Lookup(A("10.2.0.0")), HasValue("10/8"));
+  EXPECT_THAT(trie.Lookup(A("10.1.4.0")), HasValue("10.1/16"));
+  EXPECT_THAT(trie.Lookup(A("10.1.3.255")), HasValue("10.1.2/23"));
+  EXPECT_THAT(trie.Lookup(A("10.1.2.2")), HasValue("10.1.2/23"));
+  EXPECT_THAT(trie.Lookup(A("10.1.2.3")), HasValue("10.1.2.3/32"));
+}
+
+TEST(LpmTrieTest, ReturnsNullWithoutMatch) {
+  ASSERT_OK_AND_ASSIGN(Ipv4Trie trie,
+                       Ipv4Trie::Build({{P("10.0.0.0", 8), "10/8"}}));
+  EXPECT_THAT(trie.Lookup(A("11.0.0.0")), IsNull());
+  ASSERT_OK_AND_ASSIGN(Ipv4Trie empty, Ipv4Trie::Build({}));
+  EXPECT_THAT(empty.Lookup(A("11.0.0.0")), IsNull());
+}
+
+TEST(LpmTrieTest, RejectsDuplicatePrefixes) {
+  EXPECT_THAT(Ipv4Trie::Build({{P("10.0.0.0", 8), "a"},
+                               {P("10.1.0.0", 8), "b"}}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(LpmTrieTest, WorksForIpv6WithASmallStride) {
+  using Ipv6Prefix = Prefix<Ipv6Address>;
+  ASSERT_OK_AND_ASSIGN(Ipv6Address net, Ipv6Address::OfString("2001:db8::"));
+  ASSERT_OK_AND_ASSIGN(Ipv6Address host,
+                       Ipv6Address::OfString("2001:db8::1:2"));
+  ASSERT_OK_AND_ASSIGN(Ipv6Prefix net_prefix, Ipv6Prefix::Of(net, 32));
+  ASSERT_OK_AND_ASSIGN(Ipv6Prefix host_prefix, Ipv6Prefix::Of(host, 127));
+  using Ipv6Trie = LpmTrie<Ipv6Address, int, /*stride_bits=*/4>;
+  ASSERT_OK_AND_ASSIGN(Ipv6Trie trie,
+                       Ipv6Trie::Build({{net_prefix, 1}, {host_prefix, 2}}));
+  ASSERT_OK_AND_ASSIGN(Ipv6Address other,
+                       Ipv6Address::OfString("2001:db8::1:4"));
+  ASSERT_OK_AND_ASSIGN(Ipv6Address sibling,
+                       Ipv6Address::OfString("2001:db8::1:3"));
+  ASSERT_THAT(trie.Lookup(other), NotNull());
+  EXPECT_EQ(trie.Lookup(other)->second, 1);
+  ASSERT_THAT(trie.Lookup(sibling), NotNull());
+  EXPECT_EQ(trie.Lookup(sibling)->second, 2);
+}
+
+// Compares lookups against a linear scan over random, overlapping prefixes.
+TEST(LpmTrieTest, AgreesWithLinearScan) {
+  std::mt19937 rng(42);
+  // Few distinct bits, so that prefixes and addresses overlap a lot.
+  auto random_bits = [&] {
+    return std::bitset<32>(rng() & 0xF0FF00F3);
+  };
+  std::vector<std::pair<Ipv4Prefix, int>> entries;
+  absl::flat_hash_set<Ipv4Prefix> prefixes;
+  for (int i = 0; i < 2000; ++i) {
+    ASSERT_OK_AND_ASSIGN(Ipv4Prefix prefix,
+                         Ipv4Prefix::Of(Ipv4Address(random_bits()),
+                                        rng() % 33));
+    if (prefixes.insert(prefix).second) entries.push_back({prefix, i});
+  }
+  ASSERT_OK_AND_ASSIGN(IntTrie trie, IntTrie::Build(entries));
+  ASSERT_OK_AND_ASSIGN(NarrowIntTrie narrow_trie,
+                       NarrowIntTrie::Build(entries));
+
+  for (int i = 0; i < 10000; ++i) {
+    const Ipv4Address address(random_bits());
+    const std::pair<Ipv4Prefix, int>* expected = nullptr;
+    for (const auto& entry : entries) {
+      if (entry.first.Contains(address) &&
+          (expected == nullptr ||
+           entry.first.length() > expected->first.length())) {
+        expected = &entry;
+      }
+    }
+    if (expected == nullptr) {
+      EXPECT_THAT(trie.Lookup(address), IsNull()) << address;
+      EXPECT_THAT(narrow_trie.Lookup(address), IsNull()) << address;
+    } else {
+      ASSERT_THAT(trie.Lookup(address), NotNull()) << address;
+      EXPECT_EQ(trie.Lookup(address)->second, expected->second) << address;
+      ASSERT_THAT(narrow_trie.Lookup(address), NotNull()) << address;
+      EXPECT_EQ(narrow_trie.Lookup(address)->second, expected->second)
+          << address;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace netaddr
@@ -17,16 +17,16 @@
 #include <cstdint>
 #include <cstring>
 #include <string>
-#include <vector>
 
 #include "absl/status/statusor.h"
 #include "absl/strings/ascii.h"
-#include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "gutil/status.h"
 #include "p4_pdpi/netaddr/ipv6_address.h"
 #include "p4_pdpi/netaddr/network_address.h"
+#include "p4_pdpi/string_encodings/byte_string.h"
+#include "p4_pdpi/string_encodings/hex_string.h"
 
 namespace netaddr {
 
@@ -53,28 +53,33 @@ absl::StatusOr<MacAddress> MacAddress::OfString(absl::string_view address) {
            << "Invalid MAC address: '" << address << "'";
   };
 
-  std::vector<std::string> bytes = absl::StrSplit(address, ':');
-  if (bytes.size() != 6) return invalid();
-
-  std::bitset<48> bits;
-  for (absl::string_view byte_string : bytes) {
+  int num_bytes = 0;
+  uint64_t bits = 0;
+  for (absl::string_view byte_string : absl::StrSplit(address, ':')) {
     uint8_t byte;
-    if (!ParseByteInBase16(byte_string, byte)) return invalid();
-    bits <<= 8;
-    bits |= byte;
+    if (++num_bytes > 6 || !ParseByteInBase16(byte_string, byte)) {
+      return invalid();
+    }
+    bits = (bits << 8) | byte;
   }
-  return MacAddress(bits);
+  if (num_bytes != 6) return invalid();
+  return MacAddress(std::bitset<48>(bits));
 }
 
 std::string MacAddress::ToString() const {
-  uint8_t byte6 = (bits_ >> 40).to_ulong() & 0xFFu;
-  uint8_t byte5 = (bits_ >> 32).to_ulong() & 0xFFu;
-  uint8_t byte4 = (bits_ >> 24).to_ulong() & 0xFFu;
-  uint8_t byte3 = (bits_ >> 16).to_ulong() & 0xFFu;
-  uint8_t byte2 = (bits_ >> 8).to_ulong() & 0xFFu;
-  uint8_t byte1 = (bits_ >> 0).to_ulong() & 0xFFu;
-  return absl::StrFormat("%02x:%02x:%02x:%02x:%02x:%02x", byte6, byte5, byte4,
-                         byte3, byte2, byte1);
+  char bytes[6];
+  pdpi::BitsetToPaddedBytes(bits_, bytes);
+  char hex_digits[12];
+  pdpi::ByteStringToHexDigits(absl::string_view(bytes, sizeof(bytes)),
+                              hex_digits);
+
+  // "xx:xx:xx:xx:xx:xx"
+  std::string result(17, ':');
+  for (int i = 0; i < 6; ++i) {
+    result[3 * i] = hex_digits[2 * i];
+    result[3 * i + 1] = hex_digits[2 * i + 1];
+  }
+  return result;
 }
 
 absl::StatusOr<MacAddress> MacAddress::OfLinkLocalIpv6Address(
@@ -0,0 +1,339 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_P4_PDPI_NETADDR_PREFIX_H_
+#define PINS_P4_PDPI_NETADDR_PREFIX_H_
+
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "gutil/status.h"
+#include "p4_pdpi/netaddr/network_address.h"
+
+namespace netaddr {
+
+// Returns the number of bits of a network address type `T`, i.e. `num_bits`
+// for `T` deriving from `NetworkAddress<num_bits, T>`.
+template <std::size_t num_bits, typename T>
+constexpr int NumAddressBits(const NetworkAddress<num_bits, T>*) {
+  return num_bits;
+}
+template <typename T>
+inline constexpr int kNumAddressBits =
+    NumAddressBits(static_cast<const T*>(nullptr));
+
+// Returns true if `a` is smaller than `b` when read as big-endian unsigned
+// integers. Compares 64 bits at a time.
+template <std::size_t num_bits>
+bool BitsetLess(const std::bitset<num_bits>& a,
+                const std::bitset<num_bits>& b) {
+  const std::bitset<num_bits> word_mask(~uint64_t{0});
+  int shift = num_bits > 64 ? num_bits - 64 : 0;
+  while (true) {
+    const uint64_t a_word = ((a >> shift) & word_mask).to_ullong();
+    const uint64_t b_word = ((b >> shift) & word_mask).to_ullong();
+    if (a_word != b_word) return a_word < b_word;
+    if (shift == 0) return false;
+    // The last word may overlap bits compared already, which are equal.
+    shift = std::max(shift - 64, 0);
+  }
+}
+
+// An LPM prefix of network addresses of type `T`, e.g. 10.0.0.0/8 for
+// `Prefix<Ipv4Address>`. Bits of the address beyond the prefix length are
+// always zero.
+template <typename T>
+class Prefix {
+ public:
+  static constexpr int kNumBits = kNumAddressBits<T>;
+
+  // The default constructor returns the prefix of length 0, matching all
+  // addresses.
+  Prefix() = default;
+
+  // Returns the prefix of the given length containing `address`, or error if
+  // the prefix length is not in the interval [0, kNumBits]. Bits of `address`
+  // beyond the prefix length are ignored.
+  static absl::StatusOr<Prefix> Of(const T& address, int length);
+
+  // Returns the prefix matched by the given LPM value and mask, or error if
+  // `mask` is not an LPM mask.
+  static absl::StatusOr<Prefix> OfValueAndMask(const T& value, const T& mask);
+
+  const T& address() const { return address_; }
+  int length() const { return length_; }
+
+  // Returns true if `address` has this prefix.
+  bool Contains(const T& address) const {
+    return (address.ToBitset() & MaskBits(length_)) == address_.ToBitset();
+  }
+  // Returns true if every address with prefix `other` has this prefix.
+  bool Covers(const Prefix& other) const {
+    return length_ <= other.length_ && Contains(other.address_);
+  }
+  // Returns true if some address has both this prefix and `other`, i.e. if
+  // one of the prefixes covers the other.
+  bool Overlaps(const Prefix& other) const {
+    return Covers(other) || other.Covers(*this);
+  }
+
+  // Returns the prefix one bit longer than this one, with the next bit equal
+  // to `bit`. Must not be called on a prefix of length kNumBits.
+  Prefix Child(bool bit) const {
+    std::bitset<kNumBits> bits = address_.ToBitset();
+    bits[kNumBits - 1 - length_] = bit;
+    return Prefix(T::OfBitset(bits), length_ + 1);
+  }
+  // Returns the prefix one bit shorter than this one. Must not be called on a
+  // prefix of length 0.
+  Prefix Parent() const {
+    return Prefix(T::OfBitset(address_.ToBitset() & MaskBits(length_ - 1)),
+                  length_ - 1);
+  }
+
+  // Returns the prefix as `<address>/<length>`, e.g. "10.0.0.0/8".
+  std::string ToString() const {
+    return absl::StrCat(address_.ToString(), "/", length_);
+  }
+
+  bool operator==(const Prefix& other) const {
+    return length_ == other.length_ && address_ == other.address_;
+  }
+  bool operator!=(const Prefix& other) const { return !(*this == other); }
+  // Orders prefixes by address, then by length. Thus, a prefix comes right
+  // before the prefixes it covers.
+  bool operator<(const Prefix& other) const {
+    if (address_ != other.address_) {
+      return BitsetLess(address_.ToBitset(), other.address_.ToBitset());
+    }
+    return length_ < other.length_;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const Prefix& prefix) {
+    return H::combine(std::move(h), prefix.address_, prefix.length_);
+  }
+
+ private:
+  Prefix(T address, int length)
+      : address_(std::move(address)), length_(length) {}
+
+  static std::bitset<kNumBits> MaskBits(int length) {
+    if (length == 0) return std::bitset<kNumBits>();
+    return ~std::bitset<kNumBits>() << (kNumBits - length);
+  }
+
+  T address_;
+  int length_ = 0;
+};
+
+template <typename T>
+std::ostream& operator<<(std::ostream& os, const Prefix<T>& prefix) {
+  return os << prefix.ToString();
+}
+
+// A set of addresses of type `T`, represented by the smallest set of prefixes
+// containing exactly these addresses. The prefixes are disjoint and sorted,
+// so membership and coverage queries are binary searches.
+template <typename T>
+class PrefixSet {
+ public:
+  PrefixSet() = default;
+  explicit PrefixSet(std::vector<Prefix<T>> prefixes);
+
+  // Returns the canonical prefixes of the set: disjoint, in ascending order,
+  // and with no two prefixes that could be merged into their parent.
+  const std::vector<Prefix<T>>& prefixes() const { return prefixes_; }
+  bool empty() const { return prefixes_.empty(); }
+
+  // Returns true if `address` is in the set.
+  bool Contains(const T& address) const;
+  // Returns true if every address with prefix `prefix` is in the set.
+  bool Covers(const Prefix<T>& prefix) const;
+  // Returns true if some address with prefix `prefix` is in the set.
+  bool Overlaps(const Prefix<T>& prefix) const;
+
+  // Set operations.
+  static PrefixSet Union(const PrefixSet& a, const PrefixSet& b);
+  static PrefixSet Intersection(const PrefixSet& a, const PrefixSet& b);
+  // Returns the addresses in `a` that are not in `b`.
+  static PrefixSet Difference(const PrefixSet& a, const PrefixSet& b);
+
+  bool operator==(const PrefixSet& other) const {
+    return prefixes_ == other.prefixes_;
+  }
+  bool operator!=(const PrefixSet& other) const { return !(*this == other); }
+
+ private:
+  using Iterator = typename std::vector<Prefix<T>>::const_iterator;
+
+  // Returns the last prefix starting at or before the address of `prefix`,
+  // i.e. the only one that may cover `prefix`, or end() if there is none.
+  Iterator Candidate(const Prefix<T>& prefix) const;
+  // Returns the range of prefixes covered by `prefix`.
+  std::pair<Iterator, Iterator> CoveredBy(const Prefix<T>& prefix) const;
+
+  // Appends the addresses of `prefix` that are not in the disjoint, sorted
+  // prefixes [begin, end), all covered by `prefix`, to `result`.
+  static void AppendDifference(const Prefix<T>& prefix, Iterator begin,
+                               Iterator end, std::vector<Prefix<T>>& result);
+
+  std::vector<Prefix<T>> prefixes_;
+};
+
+// == END OF PUBLIC INTERFACE ==================================================
+
+template <typename T>
+absl::StatusOr<Prefix<T>> Prefix<T>::Of(const T& address, int length) {
+  if (length < 0 || length > kNumBits) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "invalid prefix length " << length << " for address of "
+           << kNumBits << " bits; must be in [0, " << kNumBits << "]";
+  }
+  return Prefix(T::OfBitset(address.ToBitset() & MaskBits(length)), length);
+}
+
+template <typename T>
+absl::StatusOr<Prefix<T>> Prefix<T>::OfValueAndMask(const T& value,
+                                                    const T& mask) {
+  ASSIGN_OR_RETURN(int length, mask.ToLpmPrefixLength());
+  return Of(value, length);
+}
+
+template <typename T>
+PrefixSet<T>::PrefixSet(std::vector<Prefix<T>> prefixes) {
+  std::sort(prefixes.begin(), prefixes.end());
+  for (Prefix<T>& prefix : prefixes) {
+    // Since prefixes come right before the ones they cover, a covered prefix
+    // is always covered by the last one kept.
+    if (!prefixes_.empty() && prefixes_.back().Covers(prefix)) continue;
+    prefixes_.push_back(std::move(prefix));
+    // Merges siblings into their parent, which may in turn have a sibling.
+    while (prefixes_.size() >= 2) {
+      const Prefix<T>& last = prefixes_.back();
+      const Prefix<T>& previous = prefixes_[prefixes_.size() - 2];
+      if (last.length() == 0 || previous.length() != last.length() ||
+          previous.Parent() != last.Parent()) {
+        break;
+      }
+      Prefix<T> parent = last.Parent();
+      prefixes_.pop_back();
+      prefixes_.back() = std::move(parent);
+    }
+  }
+}
+
+template <typename T>
+typename PrefixSet<T>::Iterator PrefixSet<T>::Candidate(
+    const Prefix<T>& prefix) const {
+  auto it = std::upper_bound(prefixes_.begin(), prefixes_.end(), prefix);
+  if (it == prefixes_.begin()) return prefixes_.end();
+  return std::prev(it);
+}
+
+template <typename T>
+std::pair<typename PrefixSet<T>::Iterator, typename PrefixSet<T>::Iterator>
+PrefixSet<T>::CoveredBy(const Prefix<T>& prefix) const {
+  auto begin = std::lower_bound(prefixes_.begin(), prefixes_.end(), prefix);
+  auto end = begin;
+  while (end != prefixes_.end() && prefix.Covers(*end)) ++end;
+  return {begin, end};
+}
+
+template <typename T>
+bool PrefixSet<T>::Contains(const T& address) const {
+  // Prefixes of length kNumBits are valid for any address.
+  return Covers(*Prefix<T>::Of(address, Prefix<T>::kNumBits));
+}
+
+template <typename T>
+bool PrefixSet<T>::Covers(const Prefix<T>& prefix) const {
+  // Since sibling prefixes are merged, a prefix whose addresses are all in the
+  // set is covered by a single prefix of the set.
+  Iterator candidate = Candidate(prefix);
+  return candidate != prefixes_.end() && candidate->Covers(prefix);
+}
+
+template <typename T>
+bool PrefixSet<T>::Overlaps(const Prefix<T>& prefix) const {
+  if (Covers(prefix)) return true;
+  auto [begin, end] = CoveredBy(prefix);
+  return begin != end;
+}
+
+template <typename T>
+PrefixSet<T> PrefixSet<T>::Union(const PrefixSet& a, const PrefixSet& b) {
+  std::vector<Prefix<T>> prefixes = a.prefixes_;
+  prefixes.insert(prefixes.end(), b.prefixes_.begin(), b.prefixes_.end());
+  return PrefixSet(std::move(prefixes));
+}
+
+template <typename T>
+PrefixSet<T> PrefixSet<T>::Intersection(const PrefixSet& a,
+                                        const PrefixSet& b) {
+  // Two overlapping prefixes intersect in the longer one.
+  std::vector<Prefix<T>> prefixes;
+  for (const Prefix<T>& prefix : a.prefixes_) {
+    if (b.Covers(prefix)) {
+      prefixes.push_back(prefix);
+      continue;
+    }
+    auto [begin, end] = b.CoveredBy(prefix);
+    prefixes.insert(prefixes.end(), begin, end);
+  }
+  return PrefixSet(std::move(prefixes));
+}
+
+template <typename T>
+PrefixSet<T> PrefixSet<T>::Difference(const PrefixSet& a, const PrefixSet& b) {
+  std::vector<Prefix<T>> prefixes;
+  for (const Prefix<T>& prefix : a.prefixes_) {
+    if (b.Covers(prefix)) continue;
+    auto [begin, end] = b.CoveredBy(prefix);
+    AppendDifference(prefix, begin, end, prefixes);
+  }
+  return PrefixSet(std::move(prefixes));
+}
+
+template <typename T>
+void PrefixSet<T>::AppendDifference(const Prefix<T>& prefix, Iterator begin,
+                                    Iterator end,
+                                    std::vector<Prefix<T>>& result) {
+  if (begin == end) {
+    result.push_back(prefix);
+    return;
+  }
+  if (*begin == prefix) return;
+  // Splits the prefix in two halves. The subtracted prefixes are sorted, so
+  // those in the lower half come first.
+  const Prefix<T> lower = prefix.Child(false);
+  const Prefix<T> upper = prefix.Child(true);
+  Iterator middle = begin;
+  while (middle != end && lower.Covers(*middle)) ++middle;
+  AppendDifference(lower, begin, middle, result);
+  AppendDifference(upper, middle, end, result);
+}
+
+}  // namespace netaddr
+
+#endif  // PINS_P4_PDPI_NETADDR_PREFIX_H_
@@ -0,0 +1,182 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/netaddr/prefix.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4_pdpi/netaddr/ipv4_address.h"
+#include "p4_pdpi/netaddr/ipv6_address.h"
+
+namespace netaddr {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Property;
+
+using Ipv4Prefix = Prefix<Ipv4Address>;
+using Ipv4PrefixSet = PrefixSet<Ipv4Address>;
+
+// Parses a prefix like "10.0.0.0/8".
+Ipv4Prefix P(absl::string_view prefix) {
+  std::vector<std::string> parts = absl::StrSplit(prefix, '/');
+  int length;
+  CHECK(absl::SimpleAtoi(parts[1], &length));
+  return *Ipv4Prefix::Of(*Ipv4Address::OfString(parts[0]), length);
+}
+
+Ipv4Address A(absl::string_view address) {
+  return *Ipv4Address::OfString(address);
+}
+
+template <typename... Strings>
+auto PrefixesAre(Strings... prefixes) {
+  return Property(&Ipv4PrefixSet::prefixes,
+                  ElementsAre(Property(&Ipv4Prefix::ToString, prefixes)...));
+}
+
+TEST(PrefixTest, OfClearsBitsBeyondTheLength) {
+  ASSERT_OK_AND_ASSIGN(Ipv4Prefix prefix,
+                       Ipv4Prefix::Of(A("10.1.2.3"), 16));
+  EXPECT_EQ(prefix.address(), A("10.1.0.0"));
+  EXPECT_EQ(prefix.length(), 16);
+  EXPECT_EQ(prefix.ToString(), "10.1.0.0/16");
+  EXPECT_EQ(prefix, P("10.1.0.0/16"));
+}
+
+TEST(PrefixTest, OfRejectsInvalidLengths) {
+  EXPECT_THAT(Ipv4Prefix::Of(A("10.0.0.0"), -1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(Ipv4Prefix::Of(A("10.0.0.0"), 33),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_OK(Ipv4Prefix::Of(A("10.0.0.0"), 0));
+  EXPECT_OK(Ipv4Prefix::Of(A("10.0.0.0"), 32));
+}
+
+TEST(PrefixTest, OfValueAndMask) {
+  EXPECT_THAT(Ipv4Prefix::OfValueAndMask(A("10.1.2.3"), A("255.255.0.0")),
+              gutil::IsOkAndHolds(P("10.1.0.0/16")));
+  EXPECT_THAT(Ipv4Prefix::OfValueAndMask(A("10.1.2.3"), A("255.0.255.0")),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PrefixTest, ContainsCoversAndOverlaps) {
+  EXPECT_TRUE(P("10.0.0.0/8").Contains(A("10.200.0.1")));
+  EXPECT_FALSE(P("10.0.0.0/8").Contains(A("11.0.0.0")));
+  EXPECT_TRUE(P("0.0.0.0/0").Contains(A("255.255.255.255")));
+
+  EXPECT_TRUE(P("10.0.0.0/8").Covers(P("10.1.0.0/16")));
+  EXPECT_TRUE(P("10.0.0.0/8").Covers(P("10.0.0.0/8")));
+  EXPECT_FALSE(P("10.1.0.0/16").Covers(P("10.0.0.0/8")));
+
+  EXPECT_TRUE(P("10.1.0.0/16").Overlaps(P("10.0.0.0/8")));
+  EXPECT_FALSE(P("10.1.0.0/16").Overlaps(P("10.2.0.0/16")));
+}
+
+TEST(PrefixTest, ChildAndParent) {
+  EXPECT_EQ(P("10.0.0.0/8").Child(false), P("10.0.0.0/9"));
+  EXPECT_EQ(P("10.0.0.0/8").Child(true), P("10.128.0.0/9"));
+  EXPECT_EQ(P("10.128.0.0/9").Parent(), P("10.0.0.0/8"));
+}
+
+TEST(PrefixTest, OrdersByAddressThenLength) {
+  EXPECT_LT(P("10.0.0.0/8"), P("10.0.0.0/16"));
+  EXPECT_LT(P("10.0.0.0/16"), P("10.1.0.0/16"));
+  EXPECT_LT(P("9.0.0.0/8"), P("10.0.0.0/8"));
+  EXPECT_FALSE(P("10.0.0.0/8") < P("10.0.0.0/8"));
+}
+
+TEST(PrefixTest, OrdersWideAddressesByTheirMostSignificantBits) {
+  using Ipv6Prefix = Prefix<Ipv6Address>;
+  ASSERT_OK_AND_ASSIGN(Ipv6Address low, Ipv6Address::OfString("1::ffff"));
+  ASSERT_OK_AND_ASSIGN(Ipv6Address high, Ipv6Address::OfString("2::1"));
+  ASSERT_OK_AND_ASSIGN(Ipv6Prefix low_prefix, Ipv6Prefix::Of(low, 128));
+  ASSERT_OK_AND_ASSIGN(Ipv6Prefix high_prefix, Ipv6Prefix::Of(high, 128));
+  EXPECT_LT(low_prefix, high_prefix);
+  EXPECT_FALSE(high_prefix < low_prefix);
+}
+
+TEST(PrefixSetTest, DropsCoveredPrefixesAndMergesSiblings) {
+  Ipv4PrefixSet set({P("10.1.0.0/16"), P("10.0.0.0/8"), P("12.0.0.0/9"),
+                     P("12.128.0.0/10"), P("12.192.0.0/10")});
+  EXPECT_THAT(set, PrefixesAre("10.0.0.0/8", "12.0.0.0/8"));
+
+  // The merged prefix may be merged again.
+  EXPECT_THAT(Ipv4PrefixSet({P("10.0.0.0/8"), P("11.0.0.0/8")}),
+              PrefixesAre("10.0.0.0/7"));
+  EXPECT_THAT(Ipv4PrefixSet({P("0.0.0.0/1"), P("128.0.0.0/1")}),
+              PrefixesAre("0.0.0.0/0"));
+}
+
+TEST(PrefixSetTest, MembershipQueries) {
+  Ipv4PrefixSet set({P("10.0.0.0/8"), P("192.168.1.0/24")});
+  EXPECT_TRUE(set.Contains(A("10.2.3.4")));
+  EXPECT_TRUE(set.Contains(A("192.168.1.255")));
+  EXPECT_FALSE(set.Contains(A("192.168.2.0")));
+  EXPECT_FALSE(set.Contains(A("9.255.255.255")));
+
+  EXPECT_TRUE(set.Covers(P("10.20.0.0/16")));
+  EXPECT_FALSE(set.Covers(P("192.168.0.0/16")));
+  EXPECT_TRUE(set.Overlaps(P("192.168.0.0/16")));
+  EXPECT_FALSE(set.Overlaps(P("172.16.0.0/12")));
+  EXPECT_FALSE(Ipv4PrefixSet().Overlaps(P("0.0.0.0/0")));
+}
+
+TEST(PrefixSetTest, Union) {
+  EXPECT_THAT(Ipv4PrefixSet::Union(Ipv4PrefixSet({P("10.0.0.0/9")}),
+                                   Ipv4PrefixSet({P("10.128.0.0/9"),
+                                                  P("12.0.0.0/8")})),
+              PrefixesAre("10.0.0.0/8", "12.0.0.0/8"));
+}
+
+TEST(PrefixSetTest, Intersection) {
+  Ipv4PrefixSet a({P("10.0.0.0/8"), P("12.1.0.0/16")});
+  Ipv4PrefixSet b({P("10.1.0.0/16"), P("10.2.0.0/16"), P("12.0.0.0/8")});
+  EXPECT_THAT(Ipv4PrefixSet::Intersection(a, b),
+              PrefixesAre("10.1.0.0/16", "10.2.0.0/16", "12.1.0.0/16"));
+  EXPECT_EQ(Ipv4PrefixSet::Intersection(a, b),
+            Ipv4PrefixSet::Intersection(b, a));
+  EXPECT_THAT(Ipv4PrefixSet::Intersection(a, Ipv4PrefixSet()).prefixes(),
+              IsEmpty());
+}
+
+TEST(PrefixSetTest, Difference) {
+  Ipv4PrefixSet a({P("10.0.0.0/8")});
+  Ipv4PrefixSet b({P("10.0.0.0/9"), P("10.192.0.0/10")});
+  EXPECT_THAT(Ipv4PrefixSet::Difference(a, b), PrefixesAre("10.128.0.0/10"));
+  EXPECT_THAT(Ipv4PrefixSet::Difference(b, a).prefixes(), IsEmpty());
+
+  // Subtracting a single address leaves one prefix per remaining length.
+  Ipv4PrefixSet hole = Ipv4PrefixSet::Difference(
+      Ipv4PrefixSet({P("10.0.0.0/30")}), Ipv4PrefixSet({P("10.0.0.1/32")}));
+  EXPECT_THAT(hole, PrefixesAre("10.0.0.0/32", "10.0.0.2/31"));
+
+  // The difference and the subtracted set add up to the union.
+  EXPECT_EQ(Ipv4PrefixSet::Union(Ipv4PrefixSet::Difference(a, b), b),
+            Ipv4PrefixSet::Union(a, b));
+}
+
+}  // namespace
+}  // namespace netaddr
@@ -23,7 +23,9 @@
 #include <vector>
 
 #include "absl/algorithm/container.h"
+#include "absl/container/btree_map.h"
 #include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -44,6 +46,7 @@
 #include "p4_pdpi/entity_keys.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/ir_p4info_cache.h"
 #include "p4_pdpi/names.h"
 #include "p4_pdpi/sequencing.h"
 // TODO: A temporary dependence on SAI to mask a bug. Safe to remove
@@ -114,7 +117,8 @@ absl::StatusOr<std::unique_ptr<P4RuntimeSession>> P4RuntimeSession::Create(
   // Using `new` to access a private constructor.
   std::unique_ptr<P4RuntimeSession> session =
       absl::WrapUnique(new P4RuntimeSession(
-          device_id, std::move(stub), metadata.election_id, metadata.role));
+          device_id, std::move(stub), metadata.election_id, metadata.role,
+          metadata.stream_message_buffer_capacity));
 
   // Send arbitration request.
   p4::v1::StreamMessageRequest request;
@@ -185,6 +189,48 @@ absl::StatusOr<std::unique_ptr<P4RuntimeSession>> P4RuntimeSession::Create(
                 error_if_not_primary);
 }
 
+absl::StatusOr<std::unique_ptr<P4RuntimeSession>> P4RuntimeSession::Reconnect(
+    std::unique_ptr<P4RuntimeSession> session,
+    const std::optional<std::string>& expected_state_fingerprint,
+    bool error_if_not_primary) {
+  if (session == nullptr) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Cannot reconnect a null session.";
+  }
+  // The stream channel is usually broken already, so failing to close it
+  // cleanly is expected.
+  if (absl::Status status = session->Finish(); !status.ok()) {
+    LOG(INFO) << "Closed the P4RT stream to reconnect: " << status;
+  }
+  const uint32_t device_id = session->device_id_;
+  P4RuntimeSessionOptionalArgs metadata{
+      .election_id = absl::MakeUint128(session->election_id_.high(),
+                                       session->election_id_.low()),
+      .role = session->role_,
+  };
+  {
+    absl::MutexLock lock(&session->stream_read_lock_);
+    metadata.stream_message_buffer_capacity =
+        session->stream_messages_.capacity();
+  }
+  std::unique_ptr<P4Runtime::StubInterface> stub = std::move(session->stub_);
+  session.reset();
+
+  ASSIGN_OR_RETURN(session, Create(std::move(stub), device_id, metadata,
+                                   error_if_not_primary));
+  if (!expected_state_fingerprint.has_value()) return std::move(session);
+
+  ASSIGN_OR_RETURN(std::string fingerprint, session->GetStateFingerprint());
+  if (fingerprint != *expected_state_fingerprint) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "The switch state changed while reconnecting: expected "
+              "fingerprint '"
+           << *expected_state_fingerprint << "', but got '" << fingerprint
+           << "'. All entities must be read again.";
+  }
+  return std::move(session);
+}
+
 // Create the default session with the switch.
 std::unique_ptr<P4RuntimeSession> P4RuntimeSession::Default(
     std::unique_ptr<P4Runtime::StubInterface> stub, uint32_t device_id,
@@ -196,12 +242,14 @@ std::unique_ptr<P4RuntimeSession> P4RuntimeSession::Default(
 
 P4RuntimeSession::P4RuntimeSession(
     uint32_t device_id, std::unique_ptr<p4::v1::P4Runtime::StubInterface> stub,
-    absl::uint128 election_id, const std::string& role)
+    absl::uint128 election_id, const std::string& role,
+    int stream_message_buffer_capacity)
     : device_id_(device_id),
       role_(role),
       stub_(std::move(stub)),
       stream_channel_context_(std::make_unique<grpc::ClientContext>()),
-      stream_channel_(stub_->StreamChannel(stream_channel_context_.get())) {
+      stream_channel_(stub_->StreamChannel(stream_channel_context_.get())),
+      stream_messages_(stream_message_buffer_capacity) {
   election_id_.set_high(absl::Uint128High64(election_id));
   election_id_.set_low(absl::Uint128Low64(election_id));
 
@@ -231,19 +279,87 @@ grpc::Status P4RuntimeSession::WriteAndReturnGrpcStatus(
   return stub_->Write(&context, request, &response);
 }
 
+absl::StatusOr<std::vector<absl::Duration>>
+P4RuntimeSession::WriteConcurrently(absl::Span<const WriteRequest> requests,
+                                    int max_outstanding_requests) {
+  if (max_outstanding_requests <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Max outstanding requests must be > 0. Max outstanding requests: "
+           << max_outstanding_requests;
+  }
+
+  std::vector<absl::Duration> latencies(requests.size());
+  std::vector<absl::Status> statuses(requests.size());
+  absl::Mutex mutex;
+  // Guarded by `mutex`. Requests are started in order, so every request that
+  // is not sent comes after every request that failed.
+  int next_request = 0;
+  bool failed = false;
+  auto send_requests = [&]() {
+    while (true) {
+      int index;
+      {
+        absl::MutexLock lock(&mutex);
+        if (failed || next_request == requests.size()) return;
+        index = next_request++;
+      }
+      const absl::Time start = absl::Now();
+      absl::Status status = Write(requests[index]);
+      latencies[index] = absl::Now() - start;
+      if (!status.ok()) {
+        absl::MutexLock lock(&mutex);
+        failed = true;
+      }
+      statuses[index] = std::move(status);
+    }
+  };
+
+  // The calling thread sends requests too, so a window of 1 sends the requests
+  // sequentially without spawning threads.
+  const int num_threads =
+      std::min<int>(max_outstanding_requests, requests.size());
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) threads.emplace_back(send_requests);
+  send_requests();
+  for (std::thread& thread : threads) thread.join();
+
+  for (int i = 0; i < statuses.size(); ++i) {
+    RETURN_IF_ERROR(statuses[i])
+        << "in write request " << i << " of " << requests.size();
+  }
+  return latencies;
+}
+
 absl::StatusOr<p4::v1::ReadResponse> P4RuntimeSession::Read(
     const p4::v1::ReadRequest& request) {
+  p4::v1::ReadResponse result;
+  RETURN_IF_ERROR(Read(request, [&](p4::v1::ReadResponse& response) {
+    result.MergeFrom(response);
+    return absl::OkStatus();
+  }));
+  return result;
+}
+
+absl::Status P4RuntimeSession::Read(
+    const p4::v1::ReadRequest& request,
+    absl::FunctionRef<absl::Status(p4::v1::ReadResponse&)> on_response) {
   grpc::ClientContext context;
   auto reader = stub_->Read(&context, request);
 
-  p4::v1::ReadResponse result;
   p4::v1::ReadResponse response;
   while (reader->Read(&response)) {
-    result.MergeFrom(response);
+    if (absl::Status status = on_response(response); !status.ok()) {
+      // Drain the stream so that `Finish` does not block on unread responses.
+      context.TryCancel();
+      while (reader->Read(&response)) {
+      }
+      reader->Finish().IgnoreError();
+      return status;
+    }
+    response.Clear();
   }
 
-  RETURN_IF_ERROR(gutil::GrpcStatusToAbslStatus(reader->Finish()));
-  return result;
+  return gutil::GrpcStatusToAbslStatus(reader->Finish());
 }
 
 absl::Status P4RuntimeSession::SetForwardingPipelineConfig(
@@ -264,6 +380,25 @@ P4RuntimeSession::GetForwardingPipelineConfig(
   return response;
 }
 
+absl::StatusOr<std::string> P4RuntimeSession::GetStateFingerprint() {
+  p4::v1::GetForwardingPipelineConfigRequest request;
+  request.set_device_id(device_id_);
+  request.set_response_type(
+      p4::v1::GetForwardingPipelineConfigRequest::COOKIE_ONLY);
+  grpc::ClientContext context;
+  p4::v1::GetForwardingPipelineConfigResponse response;
+  RETURN_IF_ERROR(gutil::GrpcStatusToAbslStatus(
+      stub_->GetForwardingPipelineConfig(&context, request, &response)));
+
+  const auto& trailing_metadata = context.GetServerTrailingMetadata();
+  auto fingerprint = trailing_metadata.find(kStateFingerprintMetadataKey);
+  if (fingerprint == trailing_metadata.end()) {
+    return gutil::UnimplementedErrorBuilder()
+           << "The switch does not expose a state fingerprint.";
+  }
+  return std::string(fingerprint->second.data(), fingerprint->second.size());
+}
+
 bool P4RuntimeSession::StreamChannelRead(
     p4::v1::StreamMessageResponse& response,
     std::optional<absl::Duration> timeout) {
@@ -276,9 +411,10 @@ bool P4RuntimeSession::StreamChannelRead(
   } else {
     stream_read_lock_.Await(absl::Condition(&cond));
   }
-  if (!stream_messages_.empty()) {
-    response = stream_messages_.front();
-    stream_messages_.pop();
+  if (std::optional<p4::v1::StreamMessageResponse> message =
+          stream_messages_.Pop();
+      message.has_value()) {
+    response = *std::move(message);
     return true;
   }
   return false;
@@ -295,6 +431,24 @@ bool P4RuntimeSession::StreamChannelWrite(
   return stream_channel_->Write(request);
 }
 
+bool P4RuntimeSession::StreamChannelWriteBatch(
+    absl::Span<const p4::v1::StreamMessageRequest> requests) {
+  absl::MutexLock lock(&stream_write_lock_);
+  if (is_finished_) {
+    LOG(WARNING) << "Cannot write to a stream channel after WritesDone() has "
+                    "been called.";
+    return false;
+  }
+  for (int i = 0; i < requests.size(); ++i) {
+    grpc::WriteOptions options;
+    // The buffer hint lets gRPC hold back the write until a later one without
+    // the hint, so the last request flushes the whole batch.
+    if (i + 1 < requests.size()) options.set_buffer_hint();
+    if (!stream_channel_->Write(requests[i], options)) return false;
+  }
+  return true;
+}
+
 absl::Status P4RuntimeSession::HandleNextNStreamMessages(
     absl::AnyInvocable<
         absl::StatusOr<bool>(const p4::v1::StreamMessageResponse& message)>
@@ -315,7 +469,7 @@ absl::Status P4RuntimeSession::HandleNextNStreamMessages(
       ++handled_messages;
     }
     ++seen_messages;
-    stream_messages_.pop();
+    stream_messages_.Pop();
     if (handled_messages == expected_messages) {
       return absl::OkStatus();
     }
@@ -353,12 +507,33 @@ P4RuntimeSession::GetAllStreamMessagesFor(absl::Duration duration) {
         "The P4RT stream has gone down unexpectedly.");
   }
 
-  std::vector<p4::v1::StreamMessageResponse> messages;
-  while (!stream_messages_.empty()) {
-    messages.push_back(stream_messages_.front());
-    stream_messages_.pop();
+  return stream_messages_.PopUpTo(stream_messages_.size());
+}
+
+absl::StatusOr<std::vector<p4::v1::StreamMessageResponse>>
+P4RuntimeSession::GetNextStreamMessages(int max_messages,
+                                        absl::Duration timeout) {
+  if (max_messages <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Max messages must be > 0. Max messages: " << max_messages;
   }
-  return messages;
+  absl::MutexLock mu(&stream_read_lock_);
+  auto cond = [&]() ABSL_SHARED_LOCKS_REQUIRED(stream_read_lock_) {
+    return !stream_messages_.empty() || !is_stream_up_;
+  };
+  stream_read_lock_.AwaitWithTimeout(absl::Condition(&cond), timeout);
+  if (!stream_messages_.empty()) return stream_messages_.PopUpTo(max_messages);
+  if (!is_stream_up_) {
+    return absl::UnavailableError(
+        "The P4RT stream has gone down unexpectedly.");
+  }
+  return absl::DeadlineExceededError(absl::StrFormat(
+      "No stream message was seen in %s.", absl::FormatDuration(timeout)));
+}
+
+int64_t P4RuntimeSession::NumDroppedStreamMessages() {
+  absl::MutexLock mu(&stream_read_lock_);
+  return stream_messages_.num_dropped();
 }
 
 absl::Status P4RuntimeSession::Finish() {
@@ -388,11 +563,7 @@ P4RuntimeSession::ReadStreamChannelResponsesAndFinish() {
   // Finish will block if there are unread messages in the channel. Therefore,
   // we read any outstanding messages before calling it.
   absl::MutexLock read_lock(&stream_read_lock_);
-  p4::v1::StreamMessageResponse response;
-  while (!stream_messages_.empty()) {
-    responses.push_back(std::move(stream_messages_.front()));
-    stream_messages_.pop();
-  }
+  responses = stream_messages_.PopUpTo(stream_messages_.size());
 
   RETURN_IF_ERROR(gutil::GrpcStatusToAbslStatus(stream_channel_->Finish()));
   return responses;
@@ -411,7 +582,13 @@ void P4RuntimeSession::CollectStreamReadMessages() {
   p4::v1::StreamMessageResponse response;
   while (stream_channel_->Read(&response)) {
     absl::MutexLock mu(&stream_read_lock_);
-    stream_messages_.push(response);
+    if (stream_messages_.Push(std::move(response)) &&
+        stream_messages_.num_dropped() == 1) {
+      LOG(WARNING) << "P4RT stream message buffer is full; dropping the "
+                      "oldest unread messages. Consider reading them sooner "
+                      "or raising `stream_message_buffer_capacity`.";
+    }
+    response.Clear();
   }
 
   absl::MutexLock mu(&stream_read_lock_);
@@ -467,12 +644,20 @@ absl::StatusOr<ReadResponse> SetMetadataAndSendPiReadRequest(
   return session->Read(read_request);
 }
 
+namespace {
+
+void SetWriteRequestMetadata(const P4RuntimeSession& session,
+                             WriteRequest& write_request) {
+  write_request.set_device_id(session.DeviceId());
+  write_request.set_role(session.Role());
+  *write_request.mutable_election_id() = session.ElectionId();
+}
+
+}  // namespace
+
 absl::Status SetMetadataAndSendPiWriteRequest(P4RuntimeSession* session,
                                               WriteRequest& write_request) {
-  write_request.set_device_id(session->DeviceId());
-  write_request.set_role(session->Role());
-  *write_request.mutable_election_id() = session->ElectionId();
-
+  SetWriteRequestMetadata(*session, write_request);
   return session->Write(write_request);
 }
 
@@ -485,32 +670,52 @@ absl::Status SetMetadataAndSendPiWriteRequests(
 }
 
 absl::StatusOr<std::vector<Entity>> ReadPiEntities(P4RuntimeSession* session) {
+  std::vector<Entity> entities;
+  RETURN_IF_ERROR(ReadPiEntities(session, [&](Entity& entity) {
+    entities.push_back(std::move(entity));
+    return absl::OkStatus();
+  }));
+  return entities;
+}
+
+absl::Status ReadPiEntities(
+    P4RuntimeSession* session,
+    absl::FunctionRef<absl::Status(Entity&)> on_entity) {
   ReadRequest read_request;
+  read_request.set_device_id(session->DeviceId());
+  read_request.set_role(session->Role());
   read_request.add_entities()->mutable_table_entry();
   read_request.add_entities()->mutable_packet_replication_engine_entry();
-  ASSIGN_OR_RETURN(ReadResponse read_response,
-                   SetMetadataAndSendPiReadRequest(session, read_request));
-
-  return std::vector<Entity>{read_response.entities().begin(),
-                             read_response.entities().end()};
+  return session->Read(
+      read_request, [&](ReadResponse& response) -> absl::Status {
+        for (Entity& entity : *response.mutable_entities()) {
+          RETURN_IF_ERROR(on_entity(entity));
+        }
+        return absl::OkStatus();
+      });
 }
 
 absl::StatusOr<std::vector<TableEntry>> ReadPiTableEntries(
     P4RuntimeSession* session) {
   ReadRequest read_request;
+  read_request.set_device_id(session->DeviceId());
+  read_request.set_role(session->Role());
   read_request.add_entities()->mutable_table_entry();
-  ASSIGN_OR_RETURN(ReadResponse read_response,
-                   SetMetadataAndSendPiReadRequest(session, read_request));
 
   std::vector<TableEntry> table_entries;
-  table_entries.reserve(read_response.entities().size());
-  for (const auto& entity : read_response.entities()) {
-    if (!entity.has_table_entry())
-      return gutil::InternalErrorBuilder()
-             << "Entity in the read response has no table entry: "
-             << entity.DebugString();
-    table_entries.push_back(std::move(entity.table_entry()));
-  }
+  RETURN_IF_ERROR(session->Read(
+      read_request, [&](ReadResponse& response) -> absl::Status {
+        table_entries.reserve(table_entries.size() +
+                              response.entities_size());
+        for (Entity& entity : *response.mutable_entities()) {
+          if (!entity.has_table_entry())
+            return gutil::InternalErrorBuilder()
+                   << "Entity in the read response has no table entry: "
+                   << entity.DebugString();
+          table_entries.push_back(std::move(*entity.mutable_table_entry()));
+        }
+        return absl::OkStatus();
+      }));
   return table_entries;
 }
 
@@ -650,6 +855,60 @@ absl::Status ClearEntities(P4RuntimeSession& session) {
   return absl::OkStatus();
 }
 
+absl::Status ClearEntitiesInBulk(P4RuntimeSession& session,
+                                 const PipelinedWriteOptions& options) {
+  if (options.max_batch_size <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Max batch size must be > 0. Max batch size: "
+           << options.max_batch_size;
+  }
+
+  // Get P4Info from Switch. It is needed to rank the delete requests.
+  ASSIGN_OR_RETURN(
+      p4::v1::GetForwardingPipelineConfigResponse response,
+      GetForwardingPipelineConfig(
+          &session,
+          p4::v1::GetForwardingPipelineConfigRequest::P4INFO_AND_COOKIE));
+
+  // If no p4info has been pushed to the switch, then it cannot have any
+  // entities to clear, and reading entities would fail.
+  if (!response.has_config()) return absl::OkStatus();
+
+  ASSIGN_OR_RETURN(std::shared_ptr<const IrP4Info> info,
+                   GetOrCreateIrP4Info(response.config().p4info()));
+
+  // Batch the deletions per rank as the entities are read.
+  absl::btree_map<int, std::vector<WriteRequest>> requests_by_rank;
+  RETURN_IF_ERROR(ReadPiEntities(
+      &session, [&](Entity& entity) -> absl::Status {
+        ASSIGN_OR_RETURN(int rank, GetEntityRank(*info, entity));
+        std::vector<WriteRequest>& requests = requests_by_rank[rank];
+        if (requests.empty() ||
+            requests.back().updates_size() >= options.max_batch_size) {
+          SetWriteRequestMetadata(session, requests.emplace_back());
+        }
+        Update& update = *requests.back().add_updates();
+        update.set_type(Update::DELETE);
+        *update.mutable_entity() = std::move(entity);
+        return absl::OkStatus();
+      }));
+
+  // An entity only depends on entities of strictly higher rank, so deleting
+  // the ranks in ascending order never deletes a referenced entity first.
+  for (const auto& [rank, requests] : requests_by_rank) {
+    RETURN_IF_ERROR(
+        session.WriteConcurrently(requests, options.max_outstanding_requests)
+            .status())
+        << "when attempting to delete entities of dependency rank " << rank;
+  }
+
+  // Verify that all entities were cleared successfully.
+  RETURN_IF_ERROR(CheckNoEntities(session)).SetPrepend()
+      << "cleared all entities: ";
+
+  return absl::OkStatus();
+}
+
 absl::Status CheckNoTableEntries(P4RuntimeSession* session) {
   ASSIGN_OR_RETURN(
       p4::v1::GetForwardingPipelineConfigResponse response,
@@ -748,6 +1007,40 @@ absl::Status SendPiUpdates(P4RuntimeSession* session,
   return SetMetadataAndSendPiWriteRequests(session, requests);
 }
 
+absl::StatusOr<std::vector<WriteBatchLatency>> SendPiUpdatesPipelined(
+    P4RuntimeSession& session, const IrP4Info& info,
+    absl::Span<const Update> updates, const PipelinedWriteOptions& options) {
+  if (options.max_batch_size <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Max batch size must be > 0. Max batch size: "
+           << options.max_batch_size;
+  }
+  ASSIGN_OR_RETURN(std::vector<std::vector<int>> layers,
+                   SequencePiUpdatesInPlace(info, updates));
+
+  std::vector<WriteBatchLatency> result;
+  for (int layer = 0; layer < layers.size(); ++layer) {
+    const std::vector<int>& indices = layers[layer];
+    std::vector<WriteRequest> requests;
+    for (int i = 0; i < indices.size(); ++i) {
+      if (i % options.max_batch_size == 0) {
+        SetWriteRequestMetadata(session, requests.emplace_back());
+      }
+      *requests.back().add_updates() = updates[indices[i]];
+    }
+    ASSIGN_OR_RETURN(
+        std::vector<absl::Duration> latencies,
+        session.WriteConcurrently(requests, options.max_outstanding_requests),
+        _ << "in dependency layer " << layer << " of " << layers.size());
+    for (int i = 0; i < requests.size(); ++i) {
+      result.push_back({.layer = layer,
+                        .num_updates = requests[i].updates_size(),
+                        .latency = latencies[i]});
+    }
+  }
+  return result;
+}
+
 absl::Status InstallPiTableEntries(P4RuntimeSession* session,
                                    const IrP4Info& info,
                                    absl::Span<const TableEntry> pi_entries) {
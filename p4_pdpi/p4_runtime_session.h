@@ -19,7 +19,6 @@
 
 #include <memory>
 #include <optional>
-#include <queue>
 #include <string>
 #include <thread>  // NOLINT: third_party code.
 #include <vector>
@@ -27,6 +26,7 @@
 #include "absl/base/attributes.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
 #include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -40,6 +40,7 @@
 #include "gutil/version.h"
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/internal/bounded_ring_buffer.h"
 #include "p4_pdpi/ir.pb.h"
 #include "sai_p4/fixed/roles.h"
 #include "thinkit/switch.h"
@@ -103,8 +104,15 @@ GrpcChannelArgumentsForP4rtWithAggressiveKeepAlive() {
   return args;
 }
 
+// The default number of unread stream messages buffered by a P4RuntimeSession.
+constexpr int kDefaultStreamMessageBufferCapacity = 1 << 16;
+
 // This struct contains election id and role string with default values. The
 // client can also override them as needed.
+// Trailing metadata of GetForwardingPipelineConfig responses of switches that
+// expose a fingerprint of their programmed entities, e.g. the PINS P4RT app.
+inline constexpr char kStateFingerprintMetadataKey[] = "p4rt-state-fingerprint";
+
 struct P4RuntimeSessionOptionalArgs {
   absl::uint128 election_id = TimeBasedElectionId();
   // If client want to use default role to have "full pipeline access", this
@@ -112,6 +120,9 @@ struct P4RuntimeSessionOptionalArgs {
   // See:
   // https://p4.org/p4runtime/spec/main/P4Runtime-Spec.html#sec-default-role.
   std::string role = P4RUNTIME_ROLE_SDN_CONTROLLER;
+  // The maximum number of unread stream messages (e.g. PacketIns) buffered by
+  // the session. Once the buffer is full, the oldest messages are dropped.
+  int stream_message_buffer_capacity = kDefaultStreamMessageBufferCapacity;
 };
 
 // A P4Runtime session
@@ -146,6 +157,22 @@ class P4RuntimeSession {
       const P4RuntimeSessionOptionalArgs& metadata = {},
       bool error_if_not_primary = true);
 
+  // Replaces `session`, e.g. after its stream channel broke, with a new session
+  // over the same stub, with the same device ID, election ID and role.
+  // Arbitration is performed as in `Create`; the switch must have dropped the
+  // old stream channel, since an election ID cannot be used by two streams.
+  //
+  // If `expected_state_fingerprint` is set, additionally returns
+  // FAILED_PRECONDITION unless the switch state still has that fingerprint
+  // (see `GetStateFingerprint`). A controller that took the fingerprint along
+  // with its view of the switch state can then resume writing after a single
+  // round trip, rather than reading all entities back.
+  static absl::StatusOr<std::unique_ptr<P4RuntimeSession>> Reconnect(
+      std::unique_ptr<P4RuntimeSession> session,
+      const std::optional<std::string>& expected_state_fingerprint =
+          std::nullopt,
+      bool error_if_not_primary = true);
+
   // Connects to the default session on the switch, which has no election_id
   // and which cannot be terminated. This should only be used for testing.
   // The stream_channel and stream_channel_context will be the nullptr.
@@ -178,11 +205,29 @@ class P4RuntimeSession {
   // https://p4.org/p4-spec/p4runtime/main/P4Runtime-Spec.html#sec-error-reporting
   grpc::Status WriteAndReturnGrpcStatus(const p4::v1::WriteRequest& request);
 
+  // Sends independent write requests, i.e. requests that the switch may apply
+  // in any order, keeping at most `max_outstanding_requests` of them in flight
+  // at the same time. Returns the latency of each request, in the order of
+  // `requests`. Once a request fails, no further requests are sent, and the
+  // error of the first failed request (in the order of `requests`) is returned
+  // after the requests in flight have completed.
+  absl::StatusOr<std::vector<absl::Duration>> WriteConcurrently(
+      absl::Span<const p4::v1::WriteRequest> requests,
+      int max_outstanding_requests);
+
   // Sends the read request, and aggregates all the read responses into a
   // single response. Will return an error if an issue is detected with the
   // stream.
   absl::StatusOr<p4::v1::ReadResponse> Read(const p4::v1::ReadRequest& request);
 
+  // Sends the read request, and calls `on_response` on every read response as
+  // it arrives from the server stream, without aggregating them. The visitor
+  // may move out of the response. If `on_response` returns an error, the read
+  // is cancelled and that error is returned.
+  absl::Status Read(
+      const p4::v1::ReadRequest& request,
+      absl::FunctionRef<absl::Status(p4::v1::ReadResponse&)> on_response);
+
   // Set/Get methods for the forwarding pipeline.
   absl::Status SetForwardingPipelineConfig(
       const p4::v1::SetForwardingPipelineConfigRequest& request);
@@ -190,6 +235,11 @@ class P4RuntimeSession {
   GetForwardingPipelineConfig(
       const p4::v1::GetForwardingPipelineConfigRequest& request);
 
+  // Returns a fingerprint of all entities programmed on the switch, which
+  // changes whenever they do. Costs a single round trip. Returns UNIMPLEMENTED
+  // if the switch does not expose one.
+  absl::StatusOr<std::string> GetStateFingerprint();
+
   // Returns the id of the node that this session belongs to.
   uint32_t DeviceId() const { return device_id_; }
   // Returns the election id that has been used to perform arbitration.
@@ -207,6 +257,13 @@ class P4RuntimeSession {
   ABSL_MUST_USE_RESULT bool StreamChannelWrite(
       const p4::v1::StreamMessageRequest& request)
       ABSL_LOCKS_EXCLUDED(stream_write_lock_);
+  // Writes `requests` to the stream channel back to back, holding the write
+  // lock only once and hinting gRPC to coalesce all but the last write into as
+  // few transport frames as possible. Stops at the first failed write and
+  // returns false; the requests before it may have been sent.
+  ABSL_MUST_USE_RESULT bool StreamChannelWriteBatch(
+      absl::Span<const p4::v1::StreamMessageRequest> requests)
+      ABSL_LOCKS_EXCLUDED(stream_write_lock_);
 
   // Thread-safe call that waits for the switch to respond with a stream message
   // (i.e. PacketIn) and then applies the `callback` function to it. Once this
@@ -244,6 +301,21 @@ class P4RuntimeSession {
   GetAllStreamMessagesFor(absl::Duration duration)
       ABSL_LOCKS_EXCLUDED(stream_read_lock_);
 
+  // Thread-safe call that waits until at least one stream message response
+  // from the switch (i.e. PacketIn) is available, and then returns up to
+  // `max_messages` of the buffered responses, oldest first, without waiting
+  // for more. If no response is seen before the `timeout` then it will
+  // terminate with a DEADLINE_EXCEEDED error, or with an UNAVAILABLE error if
+  // the P4Runtime connection went down.
+  ABSL_MUST_USE_RESULT
+  absl::StatusOr<std::vector<p4::v1::StreamMessageResponse>>
+  GetNextStreamMessages(int max_messages, absl::Duration timeout)
+      ABSL_LOCKS_EXCLUDED(stream_read_lock_);
+
+  // Returns the number of stream messages that were dropped because the
+  // session's stream message buffer was full when they arrived.
+  int64_t NumDroppedStreamMessages() ABSL_LOCKS_EXCLUDED(stream_read_lock_);
+
   // Closes the RPC connection by telling the server it is done writing, then
   // reads and logs any outstanding messages from the server. Once the server
   // finishes handling all outstanding writes it will close.
@@ -256,9 +328,11 @@ class P4RuntimeSession {
       ABSL_LOCKS_EXCLUDED(stream_write_lock_, stream_read_lock_);
 
  private:
-  P4RuntimeSession(uint32_t device_id,
-                   std::unique_ptr<p4::v1::P4Runtime::StubInterface> stub,
-                   absl::uint128 election_id, const std::string& role);
+  P4RuntimeSession(
+      uint32_t device_id,
+      std::unique_ptr<p4::v1::P4Runtime::StubInterface> stub,
+      absl::uint128 election_id, const std::string& role,
+      int stream_message_buffer_capacity = kDefaultStreamMessageBufferCapacity);
 
   // Updates the internal state for RPC stream. Logs any changes (e.g. up->down,
   // down->up, but not up->up).
@@ -311,8 +385,9 @@ class P4RuntimeSession {
 
   // All stream messages are queued by the P4RuntimeSession (ensuring the gRPC
   // stream is flushed and can be cleanly closed) for users to read at their
-  // discression.
-  std::queue<p4::v1::StreamMessageResponse> stream_messages_
+  // discression. The queue is bounded so that unread messages cannot grow
+  // without limit; the oldest are dropped once it is full.
+  BoundedRingBuffer<p4::v1::StreamMessageResponse> stream_messages_
       ABSL_GUARDED_BY(stream_read_lock_);
 };
 
@@ -355,6 +430,15 @@ absl::Status SetMetadataAndSendPiWriteRequests(
 absl::StatusOr<std::vector<p4::v1::Entity>> ReadPiEntities(
     P4RuntimeSession* session);
 
+// Reads PI (program independent) entities, calling `on_entity` on each entity
+// as it arrives instead of collecting them, so that large tables need not be
+// held in memory at once. The visitor may move out of the entity. If
+// `on_entity` returns an error, the read is cancelled and that error is
+// returned.
+absl::Status ReadPiEntities(
+    P4RuntimeSession* session,
+    absl::FunctionRef<absl::Status(p4::v1::Entity&)> on_entity);
+
 // Reads PI (program independent) table entries.
 ABSL_DEPRECATED("Prefer ReadPiEntities instead.")
 absl::StatusOr<std::vector<p4::v1::TableEntry>> ReadPiTableEntries(
@@ -419,6 +503,44 @@ absl::Status SendPiUpdates(P4RuntimeSession* session,
                            absl::Span<const p4::v1::Update> pi_updates,
                            std::optional<int> max_batch_size = 5000);
 
+// Options for `SendPiUpdatesPipelined`.
+struct PipelinedWriteOptions {
+  // The maximum number of write requests in flight at the same time.
+  int max_outstanding_requests = 8;
+  // The maximum number of updates in a single write request, see
+  // `SendPiUpdates`.
+  int max_batch_size = 5000;
+};
+
+// The latency of a write request sent by `SendPiUpdatesPipelined`.
+struct WriteBatchLatency {
+  // The index of the dependency layer that the request belongs to.
+  int layer = 0;
+  int num_updates = 0;
+  absl::Duration latency;
+};
+
+// Sends the given PI updates to the switch, sequenced into dependency layers as
+// by `SequencePiUpdatesIntoWriteRequests`. Each layer is split into write
+// requests of at most `options.max_batch_size` updates, which are sent with
+// `P4RuntimeSession::WriteConcurrently`. A layer is sent only once every
+// request of the previous layer has succeeded. Returns the latency of each
+// write request, in the order they were sent.
+absl::StatusOr<std::vector<WriteBatchLatency>> SendPiUpdatesPipelined(
+    P4RuntimeSession& session, const IrP4Info& info,
+    absl::Span<const p4::v1::Update> updates,
+    const PipelinedWriteOptions& options = {});
+
+// Deletes all entities read from `session`, like `ClearEntities`, but without
+// sequencing the deletions through the full reference graph. Entities are
+// instead grouped by `IrP4Info::dependency_rank_by_table_name` of their table,
+// and the ranks are deleted one after another, lowest rank first, each split
+// into batches of at most `options.max_batch_size` updates that are sent
+// concurrently. Entities are grouped as they are read, so they are never all
+// held in memory at once.
+absl::Status ClearEntitiesInBulk(P4RuntimeSession& session,
+                                 const PipelinedWriteOptions& options = {});
+
 // Sets the forwarding pipeline to the given P4 info and, optionally, device
 // configuration.
 absl::Status SetMetadataAndSetForwardingPipelineConfig(
@@ -21,12 +21,14 @@
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/time/time.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "gutil/proto.h"
 #include "gutil/status_matchers.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session_mocking.h"
 #include "p4_pdpi/testing/test_p4info.h"
 
@@ -37,6 +39,7 @@ using ::gutil::IsOkAndHolds;
 using ::gutil::StatusIs;
 using ::testing::_;
 using ::testing::ByMove;
+using ::testing::ElementsAre;
 using ::testing::EqualsProto;
 using ::testing::InSequence;
 using ::testing::Return;
@@ -261,5 +264,195 @@ TEST(SetForwardingPipelineConfigTest, BothVersionsProduceSameRequest) {
       p4rt_session.get(), kForwardingPipelineAction, config));
 }
 
+// Returns a write request that inserts an entry with the given `id` into
+// `one_match_field_table`.
+p4::v1::WriteRequest ConstructInsertRequest(const std::string& id) {
+  const IrTableDefinition& table =
+      GetTestIrP4Info().tables_by_name().at("one_match_field_table");
+  p4::v1::WriteRequest request;
+  p4::v1::Update& update = *request.add_updates();
+  update.set_type(p4::v1::Update::INSERT);
+  p4::v1::TableEntry& entry = *update.mutable_entity()->mutable_table_entry();
+  entry.set_table_id(table.preamble().id());
+  p4::v1::FieldMatch& match = *entry.add_match();
+  match.set_field_id(table.match_fields_by_name().at("id").match_field().id());
+  match.mutable_exact()->set_value(id);
+  return request;
+}
+
+// Returns an entry of `referring_by_action_table` that refers to the
+// `one_match_field_table` entry with the given `id`.
+p4::v1::Entity ConstructReferringEntity(const std::string& id) {
+  const IrP4Info& info = GetTestIrP4Info();
+  const IrTableDefinition& table =
+      info.tables_by_name().at("referring_by_action_table");
+  const IrActionDefinition& action =
+      info.actions_by_name().at("referring_to_one_match_field_action");
+  p4::v1::Entity entity;
+  p4::v1::TableEntry& entry = *entity.mutable_table_entry();
+  entry.set_table_id(table.preamble().id());
+  p4::v1::FieldMatch& match = *entry.add_match();
+  match.set_field_id(table.match_fields_by_name().at("val").match_field().id());
+  match.mutable_exact()->set_value("\x01");
+  p4::v1::Action& pi_action = *entry.mutable_action()->mutable_action();
+  pi_action.set_action_id(action.preamble().id());
+  p4::v1::Action::Param& param = *pi_action.add_params();
+  param.set_param_id(action.params_by_name().at("referring_id_1").param().id());
+  param.set_value(id);
+  return entity;
+}
+
+TEST(WriteConcurrentlyTest, SendsEveryRequestAndReportsItsLatency) {
+  const P4RuntimeSessionOptionalArgs metadata;
+  ASSERT_OK_AND_ASSIGN((auto [p4rt_session, mock_p4rt_stub]),
+                       MakeP4SessionWithMockStub(metadata));
+  std::vector<p4::v1::WriteRequest> requests;
+  for (const std::string id : {"a", "b", "c", "d", "e"}) {
+    requests.push_back(ConstructInsertRequest(id));
+    EXPECT_CALL(mock_p4rt_stub, Write(_, EqualsProto(requests.back()), _))
+        .WillOnce(Return(grpc::Status::OK));
+  }
+
+  ASSERT_OK_AND_ASSIGN(std::vector<absl::Duration> latencies,
+                       p4rt_session->WriteConcurrently(
+                           requests, /*max_outstanding_requests=*/3));
+  EXPECT_EQ(latencies.size(), requests.size());
+}
+
+TEST(WriteConcurrentlyTest, StopsAtTheFirstFailedRequest) {
+  const P4RuntimeSessionOptionalArgs metadata;
+  ASSERT_OK_AND_ASSIGN((auto [p4rt_session, mock_p4rt_stub]),
+                       MakeP4SessionWithMockStub(metadata));
+  const std::vector<p4::v1::WriteRequest> requests = {
+      ConstructInsertRequest("a"), ConstructInsertRequest("b"),
+      ConstructInsertRequest("c")};
+  EXPECT_CALL(mock_p4rt_stub, Write(_, EqualsProto(requests[0]), _))
+      .WillOnce(Return(grpc::Status::OK));
+  EXPECT_CALL(mock_p4rt_stub, Write(_, EqualsProto(requests[1]), _))
+      .WillOnce(Return(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "")));
+  EXPECT_CALL(mock_p4rt_stub, Write(_, EqualsProto(requests[2]), _)).Times(0);
+
+  EXPECT_THAT(p4rt_session->WriteConcurrently(
+                  requests, /*max_outstanding_requests=*/1),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(p4rt_session->WriteConcurrently(
+                  requests, /*max_outstanding_requests=*/0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(SendPiUpdatesPipelinedTest, SendsDependencyLayersInOrder) {
+  const IrP4Info& info = GetTestIrP4Info();
+  const P4RuntimeSessionOptionalArgs metadata;
+  ASSERT_OK_AND_ASSIGN((auto [p4rt_session, mock_p4rt_stub]),
+                       MakeP4SessionWithMockStub(metadata));
+
+  // Refers to the `one_match_field_table` entry with id "a", so it must be
+  // sent after it.
+  p4::v1::Update referring_update;
+  referring_update.set_type(p4::v1::Update::INSERT);
+  *referring_update.mutable_entity() = ConstructReferringEntity("a");
+
+  const std::vector<p4::v1::Update> updates = {
+      referring_update, ConstructInsertRequest("a").updates(0),
+      ConstructInsertRequest("b").updates(0)};
+
+  p4::v1::WriteRequest first_layer;
+  first_layer.set_device_id(kDeviceId);
+  first_layer.set_role(metadata.role);
+  *first_layer.mutable_election_id() = ConstructElectionId(metadata);
+  p4::v1::WriteRequest second_layer = first_layer;
+  *first_layer.add_updates() = updates[1];
+  *second_layer.add_updates() = updates[0];
+  {
+    InSequence sequence;
+    EXPECT_CALL(mock_p4rt_stub, Write(_, EqualsProto(first_layer), _))
+        .WillOnce(Return(grpc::Status::OK));
+    EXPECT_CALL(mock_p4rt_stub, Write(_, EqualsProto(second_layer), _))
+        .WillOnce(Return(grpc::Status::OK));
+  }
+  p4::v1::WriteRequest unrelated_update = first_layer;
+  unrelated_update.clear_updates();
+  *unrelated_update.add_updates() = updates[2];
+  EXPECT_CALL(mock_p4rt_stub, Write(_, EqualsProto(unrelated_update), _))
+      .WillOnce(Return(grpc::Status::OK));
+
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<WriteBatchLatency> latencies,
+      SendPiUpdatesPipelined(*p4rt_session, info, updates,
+                             {.max_outstanding_requests = 2,
+                              .max_batch_size = 1}));
+  ASSERT_EQ(latencies.size(), 3);
+  EXPECT_EQ(latencies[0].layer, 0);
+  EXPECT_EQ(latencies[1].layer, 0);
+  EXPECT_EQ(latencies[2].layer, 1);
+  EXPECT_EQ(latencies[2].num_updates, 1);
+}
+
+TEST(ReadPiEntitiesTest, VisitsEveryEntityAndStopsOnVisitorError) {
+  const P4RuntimeSessionOptionalArgs metadata;
+  ASSERT_OK_AND_ASSIGN((auto [p4rt_session, mock_p4rt_stub]),
+                       MakeP4SessionWithMockStub(metadata));
+  p4::v1::Entity first;
+  *first.mutable_table_entry() = ConstructTableEntry();
+  p4::v1::Entity second = first;
+  second.mutable_table_entry()->set_priority(2);
+
+  SetNextReadResponse(mock_p4rt_stub, {first, second});
+  std::vector<p4::v1::Entity> visited;
+  ASSERT_OK(ReadPiEntities(p4rt_session.get(), [&](p4::v1::Entity& entity) {
+    visited.push_back(std::move(entity));
+    return absl::OkStatus();
+  }));
+  EXPECT_THAT(visited, ElementsAre(EqualsProto(first), EqualsProto(second)));
+
+  SetNextReadResponse(mock_p4rt_stub, {first, second});
+  int num_visited = 0;
+  EXPECT_THAT(ReadPiEntities(p4rt_session.get(),
+                             [&](p4::v1::Entity&) {
+                               ++num_visited;
+                               return absl::CancelledError("enough");
+                             }),
+              StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_EQ(num_visited, 1);
+}
+
+TEST(ClearEntitiesInBulkTest, DeletesReferringEntitiesFirst) {
+  const P4RuntimeSessionOptionalArgs metadata;
+  ASSERT_OK_AND_ASSIGN((auto [p4rt_session, mock_p4rt_stub]),
+                       MakeP4SessionWithMockStub(metadata));
+  const p4::v1::Entity referenced_a =
+      ConstructInsertRequest("a").updates(0).entity();
+  const p4::v1::Entity referenced_b =
+      ConstructInsertRequest("b").updates(0).entity();
+  const p4::v1::Entity referring = ConstructReferringEntity("a");
+  EXPECT_CALL(mock_p4rt_stub, GetForwardingPipelineConfig)
+      .WillRepeatedly([](auto, auto,
+                         p4::v1::GetForwardingPipelineConfigResponse*
+                             get_pipeline_response) {
+        *get_pipeline_response->mutable_config()->mutable_p4info() =
+            GetTestP4Info();
+        return grpc::Status::OK;
+      });
+
+  {
+    InSequence sequence;
+    SetNextReadResponse(mock_p4rt_stub,
+                        {referenced_a, referring, referenced_b});
+    EXPECT_CALL(
+        mock_p4rt_stub,
+        Write(_, EqualsProto(ConstructDeleteRequest(metadata, {referring})), _))
+        .WillOnce(Return(grpc::Status::OK));
+    EXPECT_CALL(mock_p4rt_stub,
+                Write(_,
+                      EqualsProto(ConstructDeleteRequest(
+                          metadata, {referenced_a, referenced_b})),
+                      _))
+        .WillOnce(Return(grpc::Status::OK));
+    SetNextReadResponse(mock_p4rt_stub, std::vector<p4::v1::Entity>{});
+  }
+
+  EXPECT_OK(ClearEntitiesInBulk(*p4rt_session));
+}
+
 }  // namespace
 }  // namespace pdpi
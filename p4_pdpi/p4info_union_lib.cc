@@ -19,6 +19,8 @@
 
 #include "absl/algorithm/container.h"
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
@@ -26,6 +28,8 @@
 #include "absl/types/optional.h"
 #include "absl/types/span.h"
 #include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/util/message_differencer.h"
 #include "gutil/proto.h"
@@ -67,11 +71,37 @@ uint32_t GetId(const p4::config::v1::Action::Param& field) {
   return field.id();
 }
 
+// Returns the deterministic serialization of `message`.
+std::string SerializeDeterministically(
+    const google::protobuf::Message& message) {
+  std::string bytes;
+  {
+    google::protobuf::io::StringOutputStream stream(&bytes);
+    google::protobuf::io::CodedOutputStream coded_stream(&stream);
+    coded_stream.SetSerializationDeterministic(true);
+    message.SerializePartialToCodedStream(&coded_stream);
+  }
+  return bytes;
+}
+
 // Checks if two messages are equal, returning their diff otherwise.
 absl::optional<std::string> DiffMessages(
     const google::protobuf::Message& message1,
     const google::protobuf::Message& message2,
     absl::Span<const std::string> ignored_fields = {}) {
+  // Entities shared between P4Infos are almost always identical, and identical
+  // messages have identical deterministic serializations. Checking those first
+  // is much cheaper than a reflection-based comparison. Differing
+  // serializations do not imply differing messages, so fall through to the
+  // differencer for the final answer and the diff.
+  if (ignored_fields.empty() &&
+      message1.GetDescriptor() == message2.GetDescriptor() &&
+      message1.ByteSizeLong() == message2.ByteSizeLong() &&
+      SerializeDeterministically(message1) ==
+          SerializeDeterministically(message2)) {
+    return absl::nullopt;
+  }
+
   std::string diff_result;
   google::protobuf::util::MessageDifferencer differencer;
   differencer.ReportDifferencesToString(&diff_result);
@@ -174,15 +204,10 @@ absl::Status MapUnionFirstRepeatedFieldIntoSecondById(
 template <typename T>
 absl::Status SetUnionFirstRepeatedFieldIntoSecond(const T& fields,
                                                   T& unioned_fields) {
+  absl::flat_hash_set<typename T::value_type> existing_fields(
+      unioned_fields.begin(), unioned_fields.end());
   for (const auto& field : fields) {
-    bool field_exists = false;
-    for (const auto& unioned_field : unioned_fields) {
-      if (field == unioned_field) {
-        field_exists = true;
-        break;
-      }
-    }
-    if (!field_exists) {
+    if (existing_fields.insert(field).second) {
       *unioned_fields.Add() = field;
     }
   }
@@ -338,22 +363,25 @@ template <class T>
 absl::Status MapUnionFirstRepeatedFieldIntoSecondById(
     const google::protobuf::RepeatedPtrField<T>& fields,
     google::protobuf::RepeatedPtrField<T>& unioned_fields) {
+  // Maps each id to the index of the first field with that id in
+  // `unioned_fields`.
+  absl::flat_hash_map<uint32_t, int> index_by_id;
+  index_by_id.reserve(unioned_fields.size() + fields.size());
+  for (int i = 0; i < unioned_fields.size(); ++i) {
+    index_by_id.try_emplace(GetId(unioned_fields.Get(i)), i);
+  }
+
   for (const auto& field : fields) {
     // If a field matching the given field's ID is already in
     // `unioned_fields`, checks that the fields are equal, returning
     // an error with the diff if they're not.
-    uint32_t id = GetId(field);
-    bool field_with_same_id_exists = false;
-    for (auto& unioned_field : unioned_fields) {
-      if (GetId(unioned_field) == id) {
-        field_with_same_id_exists = true;
-        RETURN_IF_ERROR(UnionFirstFieldIntoSecondAssertingIdenticalId(
-            field, unioned_field));
-        break;
-      }
-    }
-    if (!field_with_same_id_exists) {
+    auto [it, inserted] =
+        index_by_id.try_emplace(GetId(field), unioned_fields.size());
+    if (inserted) {
       *unioned_fields.Add() = field;
+    } else {
+      RETURN_IF_ERROR(UnionFirstFieldIntoSecondAssertingIdenticalId(
+          field, *unioned_fields.Mutable(it->second)));
     }
   }
   return absl::OkStatus();
@@ -0,0 +1,447 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/packetlib/packet_generator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "absl/base/config.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "gutil/status.h"
+#include "p4_pdpi/packetlib/bit_widths.h"
+#include "p4_pdpi/packetlib/packetlib.h"
+
+namespace packetlib {
+namespace {
+
+constexpr int kMaxVlanTags = 16;
+constexpr int kTagIndexBytes = 8;
+
+// IP protocol numbers and EtherTypes of the headers following IP, Ethernet,
+// VLAN and GRE headers.
+constexpr uint8_t kIpProtocolGre = 0x2f;
+constexpr uint8_t kIpProtocolTcp = 0x06;
+constexpr uint8_t kIpProtocolUdp = 0x11;
+// Reserved for experimentation, so packetlib expects no further header.
+constexpr uint8_t kIpProtocolExperimental = 0xfd;
+constexpr uint16_t kEtherTypeIpv4 = 0x0800;
+constexpr uint16_t kEtherTypeIpv6 = 0x86dd;
+constexpr uint16_t kEtherTypeVlan = 0x8100;
+constexpr uint16_t kIpfixVersion = 0x000a;
+
+// Writes `value` into the `num_bytes` bytes at `offset`, most significant byte
+// first.
+void Put(std::string& packet, int offset, int num_bytes, uint64_t value) {
+  for (int i = num_bytes - 1; i >= 0; --i) {
+    packet[offset + i] = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+}
+
+// Returns `sum` folded into 16 bits, in ones' complement arithmetic.
+uint64_t Fold(uint64_t sum) {
+  while (sum >> 16 != 0) sum = (sum & 0xffff) + (sum >> 16);
+  return sum;
+}
+
+// Returns the ones' complement sum of the 16-bit words of the `num_bytes`
+// bytes at `offset`, folded into 16 bits. An odd trailing byte is padded with
+// zero.
+uint64_t OnesComplementSum(const std::string& packet, int offset,
+                           int num_bytes) {
+  // The sum does not depend on byte order (RFC 1071, section 2), so whole
+  // 32-bit words are added in host order, and only the result is swapped.
+  const char* data = packet.data() + offset;
+  uint64_t sum = 0;
+  int i = 0;
+  for (; i + 4 <= num_bytes; i += 4) {
+    uint32_t word;
+    std::memcpy(&word, data + i, 4);
+    sum += word;
+  }
+  for (; i < num_bytes; i += 2) {
+    uint16_t word = 0;
+    std::memcpy(&word, data + i, std::min(2, num_bytes - i));
+    sum += word;
+  }
+  sum = Fold(sum);
+#ifdef ABSL_IS_LITTLE_ENDIAN
+  sum = ((sum & 0xff) << 8) | (sum >> 8);
+#endif
+  return sum;
+}
+
+// Returns the 16-bit ones' complement of `sum`.
+uint16_t Checksum(uint64_t sum) { return ~Fold(sum) & 0xffff; }
+
+}  // namespace
+
+absl::StatusOr<PacketGenerator> PacketGenerator::Create(
+    PacketGeneratorOptions options) {
+  if (options.max_vlan_tags < 0 || options.max_vlan_tags > kMaxVlanTags) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "max_vlan_tags must be in [0, " << kMaxVlanTags << "], but was "
+           << options.max_vlan_tags;
+  }
+  for (auto [name, probability] : {
+           std::make_pair("vlan_probability", options.vlan_probability),
+           std::make_pair("gre_probability", options.gre_probability),
+           std::make_pair("ipfix_probability", options.ipfix_probability),
+       }) {
+    if (!(probability >= 0 && probability <= 1)) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << name << " must be in [0, 1], but was " << probability;
+    }
+  }
+  if (options.ipv4_weight < 0 || options.ipv6_weight < 0 ||
+      options.ipv4_weight + options.ipv6_weight == 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "IP weights must be non-negative and not all 0, but were "
+           << options.ipv4_weight << " (IPv4) and " << options.ipv6_weight
+           << " (IPv6)";
+  }
+  if (options.udp_weight < 0 || options.tcp_weight < 0 ||
+      options.no_l4_weight < 0 ||
+      options.udp_weight + options.tcp_weight + options.no_l4_weight == 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "L4 weights must be non-negative and not all 0, but were "
+           << options.udp_weight << " (UDP), " << options.tcp_weight
+           << " (TCP) and " << options.no_l4_weight << " (no L4 header)";
+  }
+  if (options.min_payload_bytes < 0 ||
+      options.min_payload_bytes > options.max_payload_bytes ||
+      options.max_payload_bytes > kMaxPayloadBytes) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "payload sizes must satisfy 0 <= min_payload_bytes <= "
+              "max_payload_bytes <= "
+           << kMaxPayloadBytes << ", but were " << options.min_payload_bytes
+           << " and " << options.max_payload_bytes;
+  }
+  if (options.tag.size() + kTagIndexBytes > kMaxPayloadBytes) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "tag of " << options.tag.size() << " bytes does not fit into a "
+           << "payload of at most " << kMaxPayloadBytes << " bytes";
+  }
+  return PacketGenerator(std::move(options));
+}
+
+int PacketGenerator::HeaderSize(Layer::Type type) {
+  switch (type) {
+    case Layer::kEthernet:
+      return kEthernetHeaderBitwidth / 8;
+    case Layer::kVlan:
+      return kVlanHeaderBitwidth / 8;
+    case Layer::kIpv4:
+      return kStandardIpv4HeaderBitwidth / 8;
+    case Layer::kIpv6:
+      return kIpv6HeaderBitwidth / 8;
+    case Layer::kGre:
+      return kRfc2784GreHeaderWithoutOptionalsBitwidth / 8;
+    case Layer::kGreWithChecksum:
+      return (kRfc2784GreHeaderWithoutOptionalsBitwidth + kGreChecksumBitwidth +
+              kGreReserved1Bitwidth) /
+             8;
+    case Layer::kUdp:
+    case Layer::kIpfixUdp:
+      return kUdpHeaderBitwidth / 8;
+    case Layer::kTcp:
+      return kStandardTcpHeaderBitwidth / 8;
+    case Layer::kIpfix:
+      return kIpfixHeaderBitwidth / 8;
+    case Layer::kPsamp:
+      return kPsampHeaderBitwidth / 8;
+  }
+  return 0;
+}
+
+int PacketGenerator::Uniform(int lo, int hi) {
+  // Multiply-shift maps 32 random bits to [0, hi - lo] with negligible bias.
+  const uint64_t range = static_cast<uint64_t>(hi - lo) + 1;
+  return lo + static_cast<int>((Bits(32) * range) >> 32);
+}
+
+bool PacketGenerator::Bernoulli(double probability) {
+  // 53 random bits give a uniform double in [0, 1).
+  return static_cast<double>(Bits(53)) * 0x1.0p-53 < probability;
+}
+
+bool PacketGenerator::ChooseFirst(int first_weight, int second_weight) {
+  return Uniform(1, first_weight + second_weight) <= first_weight;
+}
+
+void PacketGenerator::AddLayer(Layer::Type type) {
+  const int offset =
+      layers_.empty() ? 0 : layers_.back().offset + layers_.back().size;
+  layers_.push_back(
+      Layer{.type = type, .offset = offset, .size = HeaderSize(type)});
+}
+
+void PacketGenerator::SampleLayers() {
+  layers_.clear();
+  AddLayer(Layer::kEthernet);
+  for (int i = 0; i < options_.max_vlan_tags &&
+                  Bernoulli(options_.vlan_probability);
+       ++i) {
+    AddLayer(Layer::kVlan);
+  }
+  auto add_ip = [&] {
+    AddLayer(ChooseFirst(options_.ipv4_weight, options_.ipv6_weight)
+                 ? Layer::kIpv4
+                 : Layer::kIpv6);
+  };
+  add_ip();
+  if (Bernoulli(options_.gre_probability)) {
+    AddLayer(Bits(1) ? Layer::kGreWithChecksum : Layer::kGre);
+    add_ip();
+  }
+  const int l4 = Uniform(
+      1, options_.udp_weight + options_.tcp_weight + options_.no_l4_weight);
+  if (l4 <= options_.udp_weight) {
+    if (Bernoulli(options_.ipfix_probability)) {
+      AddLayer(Layer::kIpfixUdp);
+      AddLayer(Layer::kIpfix);
+      AddLayer(Layer::kPsamp);
+    } else {
+      AddLayer(Layer::kUdp);
+    }
+  } else if (l4 <= options_.udp_weight + options_.tcp_weight) {
+    AddLayer(Layer::kTcp);
+  }
+}
+
+void PacketGenerator::WriteLayer(int index, std::string& packet) {
+  const Layer& layer = layers_[index];
+  const int offset = layer.offset;
+  const int total_size = packet.size();
+  // Only used for headers that are followed by another header.
+  const Layer::Type next = index + 1 < layers_.size()
+                               ? layers_[index + 1].type
+                               : Layer::kEthernet;
+  uint16_t next_ethertype = kEtherTypeIpv6;
+  if (next == Layer::kIpv4) {
+    next_ethertype = kEtherTypeIpv4;
+  } else if (next == Layer::kVlan) {
+    next_ethertype = kEtherTypeVlan;
+  }
+  uint8_t next_ip_protocol = kIpProtocolExperimental;
+  if (next == Layer::kGre || next == Layer::kGreWithChecksum) {
+    next_ip_protocol = kIpProtocolGre;
+  } else if (next == Layer::kUdp || next == Layer::kIpfixUdp) {
+    next_ip_protocol = kIpProtocolUdp;
+  } else if (next == Layer::kTcp) {
+    next_ip_protocol = kIpProtocolTcp;
+  }
+
+  switch (layer.type) {
+    case Layer::kEthernet:
+      Put(packet, offset, 6, Bits(48));      // ethernet_destination
+      Put(packet, offset + 6, 6, Bits(48));  // ethernet_source
+      Put(packet, offset + 12, 2, next_ethertype);
+      return;
+    case Layer::kVlan:
+      // priority_code_point, drop_eligible_indicator, vlan_identifier.
+      Put(packet, offset, 2, Bits(16));
+      Put(packet, offset + 2, 2, next_ethertype);
+      return;
+    case Layer::kIpv4:
+      Put(packet, offset, 1, 0x45);              // version, ihl
+      Put(packet, offset + 1, 1, Bits(8));       // dscp, ecn
+      Put(packet, offset + 2, 2, total_size - offset);
+      Put(packet, offset + 4, 2, Bits(16));      // identification
+      // Only the "don't fragment" flag may be set; fragment_offset is 0.
+      Put(packet, offset + 6, 2, Bits(1) << 14);
+      Put(packet, offset + 8, 1, Bits(8));       // ttl
+      Put(packet, offset + 9, 1, next_ip_protocol);
+      Put(packet, offset + 10, 2, 0);            // checksum
+      Put(packet, offset + 12, 4, Bits(32));     // ipv4_source
+      Put(packet, offset + 16, 4, Bits(32));     // ipv4_destination
+      return;
+    case Layer::kIpv6:
+      // version, dscp, ecn, flow_label.
+      Put(packet, offset, 4, (uint64_t{6} << 28) | Bits(28));
+      Put(packet, offset + 4, 2, total_size - offset - layer.size);
+      Put(packet, offset + 6, 1, next_ip_protocol);
+      Put(packet, offset + 7, 1, Bits(8));       // hop_limit
+      Put(packet, offset + 8, 8, Bits(64));      // ipv6_source
+      Put(packet, offset + 16, 8, Bits(64));
+      Put(packet, offset + 24, 8, Bits(64));     // ipv6_destination
+      Put(packet, offset + 32, 8, Bits(64));
+      return;
+    case Layer::kGre:
+    case Layer::kGreWithChecksum: {
+      const bool checksum_present = layer.type == Layer::kGreWithChecksum;
+      // checksum_present, reserved0 and version.
+      Put(packet, offset, 2, checksum_present ? 0x8000 : 0);
+      Put(packet, offset + 2, 2, next_ethertype);
+      if (checksum_present) Put(packet, offset + 4, 4, 0);  // with reserved1
+      return;
+    }
+    case Layer::kUdp:
+    case Layer::kIpfixUdp: {
+      uint64_t destination_port = kIpfixUdpDestPort;
+      if (layer.type == Layer::kUdp) {
+        // Any other port, which packetlib would expect to carry IPFIX.
+        destination_port = Bits(16);
+        if (destination_port == kIpfixUdpDestPort) destination_port ^= 1;
+      }
+      Put(packet, offset, 2, Bits(16));  // source_port
+      Put(packet, offset + 2, 2, destination_port);
+      Put(packet, offset + 4, 2, total_size - offset);
+      Put(packet, offset + 6, 2, 0);  // checksum
+      return;
+    }
+    case Layer::kTcp:
+      Put(packet, offset, 2, Bits(16));       // source_port
+      Put(packet, offset + 2, 2, Bits(16));   // destination_port
+      Put(packet, offset + 4, 4, Bits(32));   // sequence_number
+      Put(packet, offset + 8, 4, Bits(32));   // acknowledgement_number
+      // data_offset, reserved bits, flags and window.
+      Put(packet, offset + 12, 4, (uint64_t{5} << 28) | Bits(28));
+      Put(packet, offset + 16, 2, 0);         // checksum
+      Put(packet, offset + 18, 2, Bits(16));  // urgent pointer
+      return;
+    case Layer::kIpfix:
+      Put(packet, offset, 2, kIpfixVersion);
+      Put(packet, offset + 2, 2, total_size - offset);
+      // export_time, sequence_number, observation_domain_id.
+      Put(packet, offset + 4, 4, Bits(32));
+      Put(packet, offset + 8, 8, Bits(64));
+      return;
+    case Layer::kPsamp:
+      Put(packet, offset, 2, Bits(16));  // template_id
+      Put(packet, offset + 2, 2, total_size - offset);
+      // observation_time, flowset, next_hop_index, epoch, ingress_port,
+      // egress_port, user_meta_field and dlb_id.
+      Put(packet, offset + 4, 8, Bits(64));
+      Put(packet, offset + 12, 8, Bits(64));
+      Put(packet, offset + 20, 5, Bits(40));
+      Put(packet, offset + 25, 1, 0xff);  // variable_length
+      Put(packet, offset + 26, 2, total_size - offset - layer.size);
+      return;
+  }
+}
+
+void PacketGenerator::WritePayload(int offset, std::string& packet) {
+  if (!options_.tag.empty()) {
+    std::memcpy(&packet[offset], options_.tag.data(), options_.tag.size());
+    offset += options_.tag.size();
+    Put(packet, offset, kTagIndexBytes, num_generated_);
+    offset += kTagIndexBytes;
+  }
+  // The bytes are random, so their order does not matter.
+  for (; offset + 8 <= packet.size(); offset += 8) {
+    const uint64_t bytes = random_();
+    std::memcpy(&packet[offset], &bytes, 8);
+  }
+  if (offset < packet.size()) {
+    Put(packet, offset, packet.size() - offset, random_());
+  }
+}
+
+void PacketGenerator::WriteChecksums(std::string& packet) {
+  // Every header has an even size, so the sum of the bytes following a header
+  // is the sum of the sums of the following headers and the payload. Going
+  // from the innermost header outwards, every byte is summed once.
+  const int payload_offset = layers_.back().offset + layers_.back().size;
+  uint64_t sum =
+      OnesComplementSum(packet, payload_offset, packet.size() - payload_offset);
+  for (int i = layers_.size() - 1; i >= 0; --i) {
+    const Layer& layer = layers_[i];
+    const uint64_t header_sum =
+        OnesComplementSum(packet, layer.offset, layer.size);
+    sum += header_sum;
+    int checksum_offset;
+    uint64_t pseudo_header_sum = 0;
+    switch (layer.type) {
+      case Layer::kIpv4: {
+        // Covers only the IPv4 header itself.
+        const uint16_t checksum = Checksum(header_sum);
+        Put(packet, layer.offset + 10, 2, checksum);
+        sum += checksum;
+        continue;
+      }
+      case Layer::kGreWithChecksum:
+        checksum_offset = layer.offset + 4;
+        break;
+      case Layer::kUdp:
+      case Layer::kTcp: {
+        // The pseudo header: addresses, protocol and length of the segment.
+        const Layer& ip = layers_[i - 1];
+        pseudo_header_sum =
+            ip.type == Layer::kIpv4
+                ? OnesComplementSum(packet, ip.offset + 12, 8) +
+                      static_cast<uint8_t>(packet[ip.offset + 9])
+                : OnesComplementSum(packet, ip.offset + 8, 32) +
+                      static_cast<uint8_t>(packet[ip.offset + 6]);
+        pseudo_header_sum += packet.size() - layer.offset;
+        checksum_offset =
+            layer.offset + (layer.type == Layer::kUdp ? 6 : 16);
+        break;
+      }
+      default:
+        // No checksum, or like the UDP header of IPFIX packets, always 0.
+        continue;
+    }
+    const uint16_t checksum = Checksum(sum + pseudo_header_sum);
+    Put(packet, checksum_offset, 2, checksum);
+    sum += checksum;
+  }
+}
+
+void PacketGenerator::Next(std::string& packet) {
+  SampleLayers();
+  const int header_size = layers_.back().offset + layers_.back().size;
+  int payload_size =
+      Uniform(options_.min_payload_bytes, options_.max_payload_bytes);
+  if (!options_.tag.empty()) {
+    payload_size = std::max<int>(payload_size,
+                                 options_.tag.size() + kTagIndexBytes);
+  }
+  // Pad the Ethernet payload, which includes the other headers.
+  payload_size = std::max(payload_size, kMinNumBytesInEthernetPayload -
+                                            (header_size - layers_[0].size));
+
+  packet.resize(header_size + payload_size);
+  for (int i = 0; i < layers_.size(); ++i) WriteLayer(i, packet);
+  WritePayload(header_size, packet);
+  WriteChecksums(packet);
+  ++num_generated_;
+}
+
+std::string PacketGenerator::Next() {
+  std::string packet;
+  Next(packet);
+  return packet;
+}
+
+absl::optional<int64_t> GeneratedPacketIndex(absl::string_view tag,
+                                             absl::string_view payload) {
+  if (tag.empty() || payload.size() < tag.size() + kTagIndexBytes ||
+      !absl::StartsWith(payload, tag)) {
+    return absl::nullopt;
+  }
+  uint64_t index = 0;
+  for (int i = 0; i < kTagIndexBytes; ++i) {
+    index = (index << 8) | static_cast<uint8_t>(payload[tag.size() + i]);
+  }
+  return static_cast<int64_t>(index);
+}
+
+}  // namespace packetlib
@@ -0,0 +1,189 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/packetlib/packet_generator.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4_pdpi/packetlib/packetlib.h"
+#include "p4_pdpi/packetlib/packetlib.pb.h"
+
+namespace packetlib {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+
+constexpr int kNumPackets = 10000;
+
+std::vector<Header::HeaderCase> HeaderCases(const Packet& packet) {
+  std::vector<Header::HeaderCase> result;
+  for (const Header& header : packet.headers()) {
+    result.push_back(header.header_case());
+  }
+  return result;
+}
+
+TEST(PacketGeneratorTest, GeneratesValidPackets) {
+  ASSERT_OK_AND_ASSIGN(PacketGenerator generator,
+                       PacketGenerator::Create({
+                           .max_vlan_tags = 2,
+                           .vlan_probability = 0.5,
+                           .gre_probability = 0.5,
+                           .ipfix_probability = 0.3,
+                           .max_payload_bytes = 1500,
+                       }));
+  absl::flat_hash_set<Header::HeaderCase> header_cases;
+  std::string bytes;
+  for (int i = 0; i < kNumPackets; ++i) {
+    generator.Next(bytes);
+    Packet packet = ParsePacket(bytes);
+    ASSERT_THAT(packet.reasons_invalid(), IsEmpty())
+        << packet.DebugString();
+    ASSERT_THAT(packet.reason_not_fully_parsed(), IsEmpty())
+        << packet.DebugString();
+    for (const Header& header : packet.headers()) {
+      header_cases.insert(header.header_case());
+    }
+  }
+  EXPECT_EQ(generator.num_generated(), kNumPackets);
+  // Every header of the grammar was generated.
+  EXPECT_EQ(header_cases.size(), 9);
+}
+
+TEST(PacketGeneratorTest, FollowsTheGrammar) {
+  ASSERT_OK_AND_ASSIGN(PacketGenerator generator,
+                       PacketGenerator::Create({
+                           .max_vlan_tags = 2,
+                           .vlan_probability = 1,
+                           .ipv6_weight = 0,
+                           .gre_probability = 1,
+                           .tcp_weight = 0,
+                           .no_l4_weight = 0,
+                           .ipfix_probability = 1,
+                       }));
+  for (int i = 0; i < 100; ++i) {
+    Packet packet = ParsePacket(generator.Next());
+    ASSERT_THAT(packet.reasons_invalid(), IsEmpty())
+        << packet.DebugString();
+    EXPECT_THAT(HeaderCases(packet),
+                ElementsAre(Header::kEthernetHeader, Header::kVlanHeader,
+                            Header::kVlanHeader, Header::kIpv4Header,
+                            Header::kGreHeader, Header::kIpv4Header,
+                            Header::kUdpHeader, Header::kIpfixHeader,
+                            Header::kPsampHeader));
+  }
+}
+
+TEST(PacketGeneratorTest, PacketsWithoutL4HeadersAreValid) {
+  ASSERT_OK_AND_ASSIGN(PacketGenerator generator,
+                       PacketGenerator::Create({
+                           .vlan_probability = 0,
+                           .ipv4_weight = 0,
+                           .gre_probability = 0,
+                           .udp_weight = 0,
+                           .tcp_weight = 0,
+                       }));
+  Packet packet = ParsePacket(generator.Next());
+  EXPECT_THAT(packet.reasons_invalid(), IsEmpty()) << packet.DebugString();
+  EXPECT_THAT(HeaderCases(packet),
+              ElementsAre(Header::kEthernetHeader, Header::kIpv6Header));
+}
+
+TEST(PacketGeneratorTest, PacketsOnlyDependOnTheSeed) {
+  ASSERT_OK_AND_ASSIGN(PacketGenerator generator1,
+                       PacketGenerator::Create({.seed = 1}));
+  ASSERT_OK_AND_ASSIGN(PacketGenerator generator2,
+                       PacketGenerator::Create({.seed = 1}));
+  ASSERT_OK_AND_ASSIGN(PacketGenerator generator3,
+                       PacketGenerator::Create({.seed = 2}));
+  for (int i = 0; i < 100; ++i) {
+    std::string packet = generator1.Next();
+    EXPECT_EQ(packet, generator2.Next());
+    EXPECT_NE(packet, generator3.Next());
+  }
+}
+
+TEST(PacketGeneratorTest, PayloadSizesAreWithinTheRange) {
+  ASSERT_OK_AND_ASSIGN(PacketGenerator generator,
+                       PacketGenerator::Create({
+                           .min_payload_bytes = 100,
+                           .max_payload_bytes = 200,
+                       }));
+  for (int i = 0; i < 100; ++i) {
+    Packet packet = ParsePacket(generator.Next());
+    EXPECT_GE(packet.payload().size(), 100);
+    EXPECT_LE(packet.payload().size(), 200);
+  }
+}
+
+TEST(PacketGeneratorTest, PadsPacketsToTheMinimumEthernetFrameSize) {
+  ASSERT_OK_AND_ASSIGN(PacketGenerator generator,
+                       PacketGenerator::Create({.max_payload_bytes = 0}));
+  for (int i = 0; i < 100; ++i) {
+    Packet packet = ParsePacket(generator.Next());
+    EXPECT_THAT(packet.reasons_invalid(), IsEmpty()) << packet.DebugString();
+    ASSERT_OK_AND_ASSIGN(int size, PacketSizeInBytes(packet, 1));
+    EXPECT_GE(size, 46);
+  }
+}
+
+TEST(PacketGeneratorTest, EmbedsTheTagAndPacketIndex) {
+  ASSERT_OK_AND_ASSIGN(PacketGenerator generator,
+                       PacketGenerator::Create({
+                           .ipfix_probability = 0.5,
+                           .max_payload_bytes = 0,
+                           .tag = "generated by test",
+                       }));
+  for (int i = 0; i < 100; ++i) {
+    Packet packet = ParsePacket(generator.Next());
+    EXPECT_THAT(packet.reasons_invalid(), IsEmpty()) << packet.DebugString();
+    EXPECT_THAT(GeneratedPacketIndex("generated by test", packet.payload()),
+                Optional(i));
+    EXPECT_EQ(GeneratedPacketIndex("other test", packet.payload()),
+              absl::nullopt);
+  }
+}
+
+TEST(PacketGeneratorTest, RejectsInvalidOptions) {
+  EXPECT_THAT(PacketGenerator::Create({.max_vlan_tags = -1}).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(PacketGenerator::Create({.gre_probability = 1.5}).status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(
+      PacketGenerator::Create({.ipv4_weight = 0, .ipv6_weight = 0}).status(),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(PacketGenerator::Create(
+                  {.udp_weight = 0, .tcp_weight = 0, .no_l4_weight = 0})
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(PacketGenerator::Create(
+                  {.min_payload_bytes = 10, .max_payload_bytes = 5})
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(PacketGenerator::Create(
+                  {.max_payload_bytes = PacketGenerator::kMaxPayloadBytes + 1})
+                  .status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace packetlib
@@ -0,0 +1,199 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/packetlib/packet_view.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "absl/numeric/int128.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "p4_pdpi/netaddr/ipv6_address.h"
+#include "p4_pdpi/packetlib/bit_widths.h"
+#include "p4_pdpi/packetlib/packetlib.h"
+#include "p4_pdpi/packetlib/packetlib.pb.h"
+
+namespace packetlib {
+namespace {
+
+// The header following an Ethernet, VLAN or GRE header with the given
+// ethertype. Mirrors `GetNextHeaderForEtherType` in packetlib.cc, with nullopt
+// for an unsupported header.
+absl::optional<Header::HeaderCase> NextHeaderForEtherType(uint32_t ethertype) {
+  if (ethertype <= 1535) return Header::HEADER_NOT_SET;
+  if (ethertype == 0x0800) return Header::kIpv4Header;
+  if (ethertype == 0x86dd) return Header::kIpv6Header;
+  if (ethertype == 0x0806) return Header::kArpHeader;
+  if (ethertype == 0x8100) return Header::kVlanHeader;
+  return absl::nullopt;
+}
+
+// The header following an IPv4 or IPv6 header with the given protocol or next
+// header. `icmp` is the protocol number of ICMP for this IP version.
+absl::optional<Header::HeaderCase> NextHeaderForIpProtocol(uint32_t protocol,
+                                                           uint32_t icmp) {
+  if (protocol == icmp) return Header::kIcmpHeader;
+  switch (protocol) {
+    case 0x04:
+      return Header::kIpv4Header;
+    case 0x06:
+      return Header::kTcpHeader;
+    case 0x11:
+      return Header::kUdpHeader;
+    case 0x29:
+      return Header::kIpv6Header;
+    case 0x2f:
+      return Header::kGreHeader;
+    // Reserved for experimentation, so the bits after the header are
+    // arbitrary.
+    case 0xfd:
+    case 0xfe:
+      return Header::HEADER_NOT_SET;
+  }
+  return absl::nullopt;
+}
+
+// Returns the size in bytes of a header of the given type at the start of
+// `data`, or nullopt if `data` is too short for it. Mirrors the `Parse*Header`
+// functions in packetlib.cc.
+absl::optional<int> HeaderSize(Header::HeaderCase header_case,
+                               absl::string_view data) {
+  int size = 0;
+  switch (header_case) {
+    case Header::kEthernetHeader:
+      size = kEthernetHeaderBitwidth / 8;
+      break;
+    case Header::kIpv4Header:
+      size = kStandardIpv4HeaderBitwidth / 8;
+      break;
+    case Header::kIpv6Header:
+      size = kIpv6HeaderBitwidth / 8;
+      break;
+    case Header::kUdpHeader:
+      size = kUdpHeaderBitwidth / 8;
+      break;
+    case Header::kTcpHeader:
+      size = kStandardTcpHeaderBitwidth / 8;
+      break;
+    case Header::kArpHeader:
+      size = kArpHeaderBitwidth / 8;
+      break;
+    case Header::kIcmpHeader:
+      size = kIcmpHeaderBitwidth / 8;
+      break;
+    case Header::kVlanHeader:
+      size = kVlanHeaderBitwidth / 8;
+      break;
+    case Header::kGreHeader:
+      size = kRfc2784GreHeaderWithoutOptionalsBitwidth / 8;
+      // The checksum and reserved1 fields are present if the first bit is set.
+      if (!data.empty() && (static_cast<uint8_t>(data[0]) & 0x80) != 0) {
+        size += (kGreChecksumBitwidth + kGreReserved1Bitwidth) / 8;
+      }
+      break;
+    case Header::kSaiP4Bmv2PacketInHeader:
+      size = kSaiP4BMv2PacketInHeaderBitwidth / 8;
+      break;
+    case Header::kIpfixHeader:
+      size = kIpfixHeaderBitwidth / 8;
+      break;
+    case Header::kPsampHeader:
+      size = kPsampHeaderBitwidth / 8;
+      break;
+    case Header::HEADER_NOT_SET:
+      return absl::nullopt;
+  }
+  if (data.size() < size) return absl::nullopt;
+
+  // IPv4 and TCP headers are followed by options, whose length is given in
+  // 32-bit words including the standard header. The options take up the rest
+  // of the packet if it is too short for them.
+  if (header_case == Header::kIpv4Header ||
+      header_case == Header::kTcpHeader) {
+    const int offset = header_case == Header::kIpv4Header ? 0 : 12;
+    const int num_words = header_case == Header::kIpv4Header
+                              ? static_cast<uint8_t>(data[offset]) & 0xF
+                              : static_cast<uint8_t>(data[offset]) >> 4;
+    if (num_words > 5) {
+      size = std::min<int>(4 * num_words, data.size());
+    }
+  }
+  return size;
+}
+
+// Returns the header following `header`, or nullopt if it is unsupported.
+// Mirrors `GetNextHeader` in packetlib.cc.
+absl::optional<Header::HeaderCase> NextHeader(const HeaderView& header) {
+  switch (header.header_case()) {
+    case Header::kEthernetHeader:
+      return NextHeaderForEtherType(EthernetHeaderView(header).ethertype());
+    case Header::kVlanHeader:
+      return NextHeaderForEtherType(VlanHeaderView(header).ethertype());
+    case Header::kGreHeader:
+      return NextHeaderForEtherType(GreHeaderView(header).protocol_type());
+    case Header::kIpv4Header:
+      return NextHeaderForIpProtocol(Ipv4HeaderView(header).protocol(),
+                                     /*icmp=*/0x01);
+    case Header::kIpv6Header:
+      return NextHeaderForIpProtocol(Ipv6HeaderView(header).next_header(),
+                                     /*icmp=*/0x3a);
+    case Header::kUdpHeader:
+      if (UdpHeaderView(header).destination_port() == kIpfixUdpDestPort) {
+        return Header::kIpfixHeader;
+      }
+      return Header::HEADER_NOT_SET;
+    case Header::kSaiP4Bmv2PacketInHeader:
+      return Header::kEthernetHeader;
+    case Header::kIpfixHeader:
+      return Header::kPsampHeader;
+    case Header::kTcpHeader:
+    case Header::kArpHeader:
+    case Header::kIcmpHeader:
+    case Header::kPsampHeader:
+    case Header::HEADER_NOT_SET:
+      return Header::HEADER_NOT_SET;
+  }
+  return Header::HEADER_NOT_SET;
+}
+
+}  // namespace
+
+netaddr::Ipv6Address HeaderView::Ipv6AddressAt(int byte_offset) const {
+  return netaddr::Ipv6Address(absl::MakeUint128(
+      Bits(8 * byte_offset, 64), Bits(8 * byte_offset + 64, 64)));
+}
+
+PacketView PacketView::Parse(absl::string_view packet,
+                             Header::HeaderCase first_header) {
+  PacketView view(packet, first_header);
+  absl::string_view rest = packet;
+  absl::optional<Header::HeaderCase> next_header = first_header;
+  while (next_header.has_value() && *next_header != Header::HEADER_NOT_SET) {
+    absl::optional<int> size = HeaderSize(*next_header, rest);
+    if (!size.has_value()) break;
+    view.headers_.emplace_back(*next_header, rest.substr(0, *size));
+    rest.remove_prefix(*size);
+    next_header = NextHeader(view.headers_.back());
+  }
+  view.parsed_all_headers_ =
+      next_header.has_value() && *next_header == Header::HEADER_NOT_SET;
+  view.payload_ = rest;
+  return view;
+}
+
+Packet PacketView::ToPacket() const {
+  return ParsePacket(bytes_, first_header_);
+}
+
+}  // namespace packetlib
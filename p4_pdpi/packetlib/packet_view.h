@@ -0,0 +1,279 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A read-only view of a raw packet that locates its headers without copying
+// them, and reads header fields as integers and addresses on demand.
+//
+// `ParsePacket` turns every field into a string and validates the packet,
+// which is what you want for printing and diffing, but is wasteful when only a
+// few fields or the payload are needed. A `PacketView` finds the same headers
+// as `ParsePacket` and can be converted to a `Packet` when needed.
+
+#ifndef GOOGLE_P4_PDPI_PACKETLIB_PACKET_VIEW_H_
+#define GOOGLE_P4_PDPI_PACKETLIB_PACKET_VIEW_H_
+
+#include <cstdint>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "p4_pdpi/netaddr/ipv4_address.h"
+#include "p4_pdpi/netaddr/ipv6_address.h"
+#include "p4_pdpi/netaddr/mac_address.h"
+#include "p4_pdpi/packetlib/packetlib.pb.h"
+
+namespace packetlib {
+
+// A header found by `PacketView`: its type and its bytes in the packet. The
+// bytes always cover the fixed-size fields of the header.
+class HeaderView {
+ public:
+  HeaderView(Header::HeaderCase header_case, absl::string_view bytes)
+      : header_case_(header_case), bytes_(bytes) {}
+
+  Header::HeaderCase header_case() const { return header_case_; }
+  absl::string_view bytes() const { return bytes_; }
+
+ protected:
+  // Returns the `num_bits` bits starting `bit_offset` bits into the header,
+  // most significant bit first. `bit_offset % 8 + num_bits` must be at most 64.
+  uint64_t Bits(int bit_offset, int num_bits) const {
+    uint64_t result = 0;
+    for (int byte = bit_offset / 8; byte < (bit_offset + num_bits + 7) / 8;
+         ++byte) {
+      result = (result << 8) | static_cast<uint8_t>(bytes_[byte]);
+    }
+    const int trailing_bits = (8 - (bit_offset + num_bits) % 8) % 8;
+    result >>= trailing_bits;
+    return num_bits == 64 ? result : result & ((uint64_t{1} << num_bits) - 1);
+  }
+  uint8_t Byte(int byte_offset) const { return bytes_[byte_offset]; }
+  netaddr::MacAddress MacAddressAt(int byte_offset) const {
+    return netaddr::MacAddress(Byte(byte_offset), Byte(byte_offset + 1),
+                               Byte(byte_offset + 2), Byte(byte_offset + 3),
+                               Byte(byte_offset + 4), Byte(byte_offset + 5));
+  }
+  netaddr::Ipv4Address Ipv4AddressAt(int byte_offset) const {
+    return netaddr::Ipv4Address(Byte(byte_offset), Byte(byte_offset + 1),
+                                Byte(byte_offset + 2), Byte(byte_offset + 3));
+  }
+  netaddr::Ipv6Address Ipv6AddressAt(int byte_offset) const;
+
+ private:
+  Header::HeaderCase header_case_;
+  absl::string_view bytes_;
+};
+
+// Typed views of the headers whose fields packetlib interprets. Accessors are
+// named after the fields of the corresponding header proto. The view must have
+// the matching `header_case()`.
+
+class EthernetHeaderView : public HeaderView {
+ public:
+  static constexpr Header::HeaderCase kHeaderCase = Header::kEthernetHeader;
+  explicit EthernetHeaderView(const HeaderView& header) : HeaderView(header) {}
+
+  netaddr::MacAddress ethernet_destination() const { return MacAddressAt(0); }
+  netaddr::MacAddress ethernet_source() const { return MacAddressAt(6); }
+  uint32_t ethertype() const { return Bits(96, 16); }
+};
+
+class VlanHeaderView : public HeaderView {
+ public:
+  static constexpr Header::HeaderCase kHeaderCase = Header::kVlanHeader;
+  explicit VlanHeaderView(const HeaderView& header) : HeaderView(header) {}
+
+  uint32_t priority_code_point() const { return Bits(0, 3); }
+  uint32_t drop_eligible_indicator() const { return Bits(3, 1); }
+  uint32_t vlan_identifier() const { return Bits(4, 12); }
+  uint32_t ethertype() const { return Bits(16, 16); }
+};
+
+class Ipv4HeaderView : public HeaderView {
+ public:
+  static constexpr Header::HeaderCase kHeaderCase = Header::kIpv4Header;
+  explicit Ipv4HeaderView(const HeaderView& header) : HeaderView(header) {}
+
+  uint32_t version() const { return Bits(0, 4); }
+  uint32_t ihl() const { return Bits(4, 4); }
+  uint32_t dscp() const { return Bits(8, 6); }
+  uint32_t ecn() const { return Bits(14, 2); }
+  uint32_t total_length() const { return Bits(16, 16); }
+  uint32_t identification() const { return Bits(32, 16); }
+  uint32_t flags() const { return Bits(48, 3); }
+  uint32_t fragment_offset() const { return Bits(51, 13); }
+  uint32_t ttl() const { return Bits(64, 8); }
+  uint32_t protocol() const { return Bits(72, 8); }
+  uint32_t checksum() const { return Bits(80, 16); }
+  netaddr::Ipv4Address ipv4_source() const { return Ipv4AddressAt(12); }
+  netaddr::Ipv4Address ipv4_destination() const { return Ipv4AddressAt(16); }
+  // The options, which may be cut short if the packet is truncated.
+  absl::string_view uninterpreted_options() const {
+    return bytes().substr(20);
+  }
+};
+
+class Ipv6HeaderView : public HeaderView {
+ public:
+  static constexpr Header::HeaderCase kHeaderCase = Header::kIpv6Header;
+  explicit Ipv6HeaderView(const HeaderView& header) : HeaderView(header) {}
+
+  uint32_t version() const { return Bits(0, 4); }
+  uint32_t dscp() const { return Bits(4, 6); }
+  uint32_t ecn() const { return Bits(10, 2); }
+  uint32_t flow_label() const { return Bits(12, 20); }
+  uint32_t payload_length() const { return Bits(32, 16); }
+  uint32_t next_header() const { return Bits(48, 8); }
+  uint32_t hop_limit() const { return Bits(56, 8); }
+  netaddr::Ipv6Address ipv6_source() const { return Ipv6AddressAt(8); }
+  netaddr::Ipv6Address ipv6_destination() const { return Ipv6AddressAt(24); }
+};
+
+class UdpHeaderView : public HeaderView {
+ public:
+  static constexpr Header::HeaderCase kHeaderCase = Header::kUdpHeader;
+  explicit UdpHeaderView(const HeaderView& header) : HeaderView(header) {}
+
+  uint32_t source_port() const { return Bits(0, 16); }
+  uint32_t destination_port() const { return Bits(16, 16); }
+  uint32_t length() const { return Bits(32, 16); }
+  uint32_t checksum() const { return Bits(48, 16); }
+};
+
+class TcpHeaderView : public HeaderView {
+ public:
+  static constexpr Header::HeaderCase kHeaderCase = Header::kTcpHeader;
+  explicit TcpHeaderView(const HeaderView& header) : HeaderView(header) {}
+
+  uint32_t source_port() const { return Bits(0, 16); }
+  uint32_t destination_port() const { return Bits(16, 16); }
+  uint32_t sequence_number() const { return Bits(32, 32); }
+  uint32_t acknowledgement_number() const { return Bits(64, 32); }
+  uint32_t data_offset() const { return Bits(96, 4); }
+  uint64_t rest_of_header() const { return Bits(100, 60); }
+  // The options, which may be cut short if the packet is truncated.
+  absl::string_view uninterpreted_options() const {
+    return bytes().substr(20);
+  }
+};
+
+class ArpHeaderView : public HeaderView {
+ public:
+  static constexpr Header::HeaderCase kHeaderCase = Header::kArpHeader;
+  explicit ArpHeaderView(const HeaderView& header) : HeaderView(header) {}
+
+  uint32_t hardware_type() const { return Bits(0, 16); }
+  uint32_t protocol_type() const { return Bits(16, 16); }
+  uint32_t hardware_length() const { return Bits(32, 8); }
+  uint32_t protocol_length() const { return Bits(40, 8); }
+  uint32_t operation() const { return Bits(48, 16); }
+  netaddr::MacAddress sender_hardware_address() const {
+    return MacAddressAt(8);
+  }
+  netaddr::Ipv4Address sender_protocol_address() const {
+    return Ipv4AddressAt(14);
+  }
+  netaddr::MacAddress target_hardware_address() const {
+    return MacAddressAt(18);
+  }
+  netaddr::Ipv4Address target_protocol_address() const {
+    return Ipv4AddressAt(24);
+  }
+};
+
+class IcmpHeaderView : public HeaderView {
+ public:
+  static constexpr Header::HeaderCase kHeaderCase = Header::kIcmpHeader;
+  explicit IcmpHeaderView(const HeaderView& header) : HeaderView(header) {}
+
+  uint32_t type() const { return Bits(0, 8); }
+  uint32_t code() const { return Bits(8, 8); }
+  uint32_t checksum() const { return Bits(16, 16); }
+  uint32_t rest_of_header() const { return Bits(32, 32); }
+};
+
+class GreHeaderView : public HeaderView {
+ public:
+  static constexpr Header::HeaderCase kHeaderCase = Header::kGreHeader;
+  explicit GreHeaderView(const HeaderView& header) : HeaderView(header) {}
+
+  uint32_t checksum_present() const { return Bits(0, 1); }
+  uint32_t reserved0() const { return Bits(1, 12); }
+  uint32_t version() const { return Bits(13, 3); }
+  uint32_t protocol_type() const { return Bits(16, 16); }
+  // Only present if `checksum_present()`.
+  absl::optional<uint32_t> checksum() const {
+    if (!checksum_present()) return absl::nullopt;
+    return Bits(32, 16);
+  }
+  absl::optional<uint32_t> reserved1() const {
+    if (!checksum_present()) return absl::nullopt;
+    return Bits(48, 16);
+  }
+};
+
+// The headers and payload of a raw packet. Does not own the packet, which must
+// outlive the view. Parsing never fails: like `ParsePacket`, it stops at the
+// first header that is truncated or unsupported and treats the remaining bytes
+// as the payload.
+class PacketView {
+ public:
+  // Locates the headers of `packet`, starting with `first_header`. Does not
+  // allocate unless the packet has more than `kInlineHeaders` headers.
+  static PacketView Parse(
+      absl::string_view packet,
+      Header::HeaderCase first_header = Header::kEthernetHeader);
+
+  // The whole packet.
+  absl::string_view bytes() const { return bytes_; }
+  // The headers, in the same order as `ParsePacket` would return them.
+  absl::Span<const HeaderView> headers() const { return headers_; }
+  // The bytes following the last header.
+  absl::string_view payload() const { return payload_; }
+  // Returns true if the last header is followed by a payload that packetlib
+  // does not interpret, and false if parsing stopped at a truncated or
+  // unsupported header.
+  bool parsed_all_headers() const { return parsed_all_headers_; }
+
+  // Returns the first header of the given typed view type (e.g.
+  // `Ipv4HeaderView`), or nullopt if there is none.
+  template <typename View>
+  absl::optional<View> FindHeader() const {
+    for (const HeaderView& header : headers_) {
+      if (header.header_case() == View::kHeaderCase) return View(header);
+    }
+    return absl::nullopt;
+  }
+
+  // Parses the packet into a `Packet`, including its validity checks. Returns
+  // the same as `ParsePacket(bytes(), first_header)`.
+  Packet ToPacket() const;
+
+  static constexpr int kInlineHeaders = 8;
+
+ private:
+  PacketView(absl::string_view bytes, Header::HeaderCase first_header)
+      : bytes_(bytes), first_header_(first_header) {}
+
+  absl::string_view bytes_;
+  Header::HeaderCase first_header_;
+  absl::InlinedVector<HeaderView, kInlineHeaders> headers_;
+  absl::string_view payload_;
+  bool parsed_all_headers_ = false;
+};
+
+}  // namespace packetlib
+
+#endif  // GOOGLE_P4_PDPI_PACKETLIB_PACKET_VIEW_H_
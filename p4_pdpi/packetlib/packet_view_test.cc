@@ -0,0 +1,331 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/packetlib/packet_view.h"
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/random/distributions.h"
+#include "absl/random/random.h"
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "p4_pdpi/packetlib/packetlib.h"
+#include "p4_pdpi/packetlib/packetlib.pb.h"
+#include "p4_pdpi/string_encodings/hex_string.h"
+
+namespace packetlib {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::testing::ElementsAre;
+
+// Returns the bytes of a string literal, which may contain null characters.
+template <size_t size>
+std::string Bytes(const char (&literal)[size]) {
+  return std::string(literal, size - 1);
+}
+
+template <size_t num_bits>
+std::string Hex(uint64_t value) {
+  return pdpi::BitsetToHexString(std::bitset<num_bits>(value));
+}
+
+// Checks that every accessor of `view` agrees with the corresponding field of
+// `header`, as parsed by `ParsePacket`.
+void ExpectHeaderMatches(const HeaderView& view, const Header& header) {
+  ASSERT_EQ(view.header_case(), header.header_case());
+  switch (header.header_case()) {
+    case Header::kEthernetHeader: {
+      const EthernetHeader& expected = header.ethernet_header();
+      EthernetHeaderView actual(view);
+      EXPECT_EQ(actual.ethernet_destination().ToString(),
+                expected.ethernet_destination());
+      EXPECT_EQ(actual.ethernet_source().ToString(),
+                expected.ethernet_source());
+      EXPECT_EQ(Hex<16>(actual.ethertype()), expected.ethertype());
+      return;
+    }
+    case Header::kVlanHeader: {
+      const VlanHeader& expected = header.vlan_header();
+      VlanHeaderView actual(view);
+      EXPECT_EQ(Hex<3>(actual.priority_code_point()),
+                expected.priority_code_point());
+      EXPECT_EQ(Hex<1>(actual.drop_eligible_indicator()),
+                expected.drop_eligible_indicator());
+      EXPECT_EQ(Hex<12>(actual.vlan_identifier()), expected.vlan_identifier());
+      EXPECT_EQ(Hex<16>(actual.ethertype()), expected.ethertype());
+      return;
+    }
+    case Header::kIpv4Header: {
+      const Ipv4Header& expected = header.ipv4_header();
+      Ipv4HeaderView actual(view);
+      EXPECT_EQ(Hex<4>(actual.version()), expected.version());
+      EXPECT_EQ(Hex<4>(actual.ihl()), expected.ihl());
+      EXPECT_EQ(Hex<6>(actual.dscp()), expected.dscp());
+      EXPECT_EQ(Hex<2>(actual.ecn()), expected.ecn());
+      EXPECT_EQ(Hex<16>(actual.total_length()), expected.total_length());
+      EXPECT_EQ(Hex<16>(actual.identification()), expected.identification());
+      EXPECT_EQ(Hex<3>(actual.flags()), expected.flags());
+      EXPECT_EQ(Hex<13>(actual.fragment_offset()), expected.fragment_offset());
+      EXPECT_EQ(Hex<8>(actual.ttl()), expected.ttl());
+      EXPECT_EQ(Hex<8>(actual.protocol()), expected.protocol());
+      EXPECT_EQ(Hex<16>(actual.checksum()), expected.checksum());
+      EXPECT_EQ(actual.ipv4_source().ToString(), expected.ipv4_source());
+      EXPECT_EQ(actual.ipv4_destination().ToString(),
+                expected.ipv4_destination());
+      if (!actual.uninterpreted_options().empty()) {
+        EXPECT_EQ(pdpi::ByteStringToHexString(actual.uninterpreted_options()),
+                  expected.uninterpreted_options());
+      }
+      return;
+    }
+    case Header::kIpv6Header: {
+      const Ipv6Header& expected = header.ipv6_header();
+      Ipv6HeaderView actual(view);
+      EXPECT_EQ(Hex<4>(actual.version()), expected.version());
+      EXPECT_EQ(Hex<6>(actual.dscp()), expected.dscp());
+      EXPECT_EQ(Hex<2>(actual.ecn()), expected.ecn());
+      EXPECT_EQ(Hex<20>(actual.flow_label()), expected.flow_label());
+      EXPECT_EQ(Hex<16>(actual.payload_length()), expected.payload_length());
+      EXPECT_EQ(Hex<8>(actual.next_header()), expected.next_header());
+      EXPECT_EQ(Hex<8>(actual.hop_limit()), expected.hop_limit());
+      EXPECT_EQ(actual.ipv6_source().ToString(), expected.ipv6_source());
+      EXPECT_EQ(actual.ipv6_destination().ToString(),
+                expected.ipv6_destination());
+      return;
+    }
+    case Header::kUdpHeader: {
+      const UdpHeader& expected = header.udp_header();
+      UdpHeaderView actual(view);
+      EXPECT_EQ(Hex<16>(actual.source_port()), expected.source_port());
+      EXPECT_EQ(Hex<16>(actual.destination_port()),
+                expected.destination_port());
+      EXPECT_EQ(Hex<16>(actual.length()), expected.length());
+      EXPECT_EQ(Hex<16>(actual.checksum()), expected.checksum());
+      return;
+    }
+    case Header::kTcpHeader: {
+      const TcpHeader& expected = header.tcp_header();
+      TcpHeaderView actual(view);
+      EXPECT_EQ(Hex<16>(actual.source_port()), expected.source_port());
+      EXPECT_EQ(Hex<16>(actual.destination_port()),
+                expected.destination_port());
+      EXPECT_EQ(Hex<32>(actual.sequence_number()), expected.sequence_number());
+      EXPECT_EQ(Hex<32>(actual.acknowledgement_number()),
+                expected.acknowledgement_number());
+      EXPECT_EQ(Hex<4>(actual.data_offset()), expected.data_offset());
+      EXPECT_EQ(Hex<60>(actual.rest_of_header()), expected.rest_of_header());
+      if (!actual.uninterpreted_options().empty()) {
+        EXPECT_EQ(pdpi::ByteStringToHexString(actual.uninterpreted_options()),
+                  expected.uninterpreted_options());
+      }
+      return;
+    }
+    case Header::kArpHeader: {
+      const ArpHeader& expected = header.arp_header();
+      ArpHeaderView actual(view);
+      EXPECT_EQ(Hex<16>(actual.hardware_type()), expected.hardware_type());
+      EXPECT_EQ(Hex<16>(actual.protocol_type()), expected.protocol_type());
+      EXPECT_EQ(Hex<8>(actual.hardware_length()), expected.hardware_length());
+      EXPECT_EQ(Hex<8>(actual.protocol_length()), expected.protocol_length());
+      EXPECT_EQ(Hex<16>(actual.operation()), expected.operation());
+      EXPECT_EQ(actual.sender_hardware_address().ToString(),
+                expected.sender_hardware_address());
+      EXPECT_EQ(actual.sender_protocol_address().ToString(),
+                expected.sender_protocol_address());
+      EXPECT_EQ(actual.target_hardware_address().ToString(),
+                expected.target_hardware_address());
+      EXPECT_EQ(actual.target_protocol_address().ToString(),
+                expected.target_protocol_address());
+      return;
+    }
+    case Header::kIcmpHeader: {
+      const IcmpHeader& expected = header.icmp_header();
+      IcmpHeaderView actual(view);
+      EXPECT_EQ(Hex<8>(actual.type()), expected.type());
+      EXPECT_EQ(Hex<8>(actual.code()), expected.code());
+      EXPECT_EQ(Hex<16>(actual.checksum()), expected.checksum());
+      EXPECT_EQ(Hex<32>(actual.rest_of_header()), expected.rest_of_header());
+      return;
+    }
+    case Header::kGreHeader: {
+      const GreHeader& expected = header.gre_header();
+      GreHeaderView actual(view);
+      EXPECT_EQ(Hex<1>(actual.checksum_present()), expected.checksum_present());
+      EXPECT_EQ(Hex<12>(actual.reserved0()), expected.reserved0());
+      EXPECT_EQ(Hex<3>(actual.version()), expected.version());
+      EXPECT_EQ(Hex<16>(actual.protocol_type()), expected.protocol_type());
+      if (actual.checksum_present()) {
+        EXPECT_EQ(Hex<16>(*actual.checksum()), expected.checksum());
+        EXPECT_EQ(Hex<16>(*actual.reserved1()), expected.reserved1());
+      }
+      return;
+    }
+    default:
+      return;
+  }
+}
+
+void ExpectViewMatchesParsePacket(absl::string_view bytes,
+                                  Header::HeaderCase first_header) {
+  SCOPED_TRACE(pdpi::ByteStringToHexString(bytes));
+  const PacketView view = PacketView::Parse(bytes, first_header);
+  const Packet packet = ParsePacket(bytes, first_header);
+
+  ASSERT_EQ(view.headers().size(), packet.headers_size());
+  for (int i = 0; i < packet.headers_size(); ++i) {
+    ExpectHeaderMatches(view.headers()[i], packet.headers(i));
+  }
+  EXPECT_EQ(view.payload(), packet.payload());
+  const bool truncated = absl::c_any_of(
+      packet.reasons_invalid(), [](const std::string& reason) {
+        return absl::StartsWith(reason, "Packet is too short to parse");
+      });
+  EXPECT_EQ(view.parsed_all_headers(),
+            packet.reason_not_fully_parsed().empty() && !truncated);
+  EXPECT_THAT(view.ToPacket(), EqualsProto(packet));
+}
+
+// Returns a random packet that starts with `prefix`.
+std::string RandomPacket(absl::BitGen& gen, absl::string_view prefix) {
+  std::string packet(prefix);
+  const int num_random_bytes = absl::Uniform(gen, 0, 120);
+  for (int i = 0; i < num_random_bytes; ++i) {
+    packet.push_back(absl::Uniform<uint8_t>(gen));
+  }
+  return packet;
+}
+
+TEST(PacketViewTest, FindsTheSameHeadersAsParsePacket) {
+  // Ethernet prefixes selecting each supported next header, and IPv4 and IPv6
+  // prefixes selecting each supported protocol.
+  const std::string kEthernet(12, '\x02');
+  std::vector<std::pair<std::string, Header::HeaderCase>> prefixes = {
+      {"", Header::kEthernetHeader},
+      {kEthernet + Bytes("\x08\x00\x45"), Header::kEthernetHeader},
+      {kEthernet + Bytes("\x08\x00\x47"), Header::kEthernetHeader},
+      {kEthernet + "\x86\xdd", Header::kEthernetHeader},
+      {kEthernet + "\x08\x06", Header::kEthernetHeader},
+      {kEthernet + Bytes("\x81\x00"), Header::kEthernetHeader},
+      {kEthernet + Bytes("\x81\x00\x00\x01\x08\x00"), Header::kEthernetHeader},
+      {"", Header::kSaiP4Bmv2PacketInHeader},
+      {"", Header::kGreHeader},
+  };
+  for (char protocol : {'\x01', '\x04', '\x06', '\x11', '\x29', '\x2f', '\x3a',
+                        '\xfd', '\x42'}) {
+    prefixes.push_back({Bytes("\x45\x00\x00\x00\x00\x00\x00\x00\x40") +
+                            protocol + std::string(10, '\0'),
+                        Header::kIpv4Header});
+    prefixes.push_back(
+        {Bytes("\x60\x00\x00\x00\x00\x00") + protocol + "\x40",
+         Header::kIpv6Header});
+  }
+  // A UDP header to the IPFIX port, which is followed by IPFIX and PSAMP.
+  prefixes.push_back({Bytes("\x00\x01\x12\x83"), Header::kUdpHeader});
+  prefixes.push_back({"\x80", Header::kGreHeader});
+
+  absl::BitGen gen;
+  for (const auto& [prefix, first_header] : prefixes) {
+    for (int i = 0; i < 200; ++i) {
+      ExpectViewMatchesParsePacket(RandomPacket(gen, prefix), first_header);
+    }
+  }
+}
+
+TEST(PacketViewTest, ReadsTypedFields) {
+  ASSERT_OK_AND_ASSIGN(std::string bytes, SerializePacket(R"pb(
+                         headers {
+                           ethernet_header {
+                             ethernet_destination: "02:03:04:05:06:07"
+                             ethernet_source: "00:01:02:03:04:05"
+                             ethertype: "0x0800"
+                           }
+                         }
+                         headers {
+                           ipv4_header {
+                             version: "0x4"
+                             ihl: "0x5"
+                             dscp: "0x1b"
+                             ecn: "0x1"
+                             identification: "0xa3cd"
+                             flags: "0x0"
+                             fragment_offset: "0x0000"
+                             ttl: "0x10"
+                             protocol: "0x11"
+                             ipv4_source: "10.0.0.1"
+                             ipv4_destination: "10.0.0.2"
+                           }
+                         }
+                         headers {
+                           udp_header {
+                             source_port: "0x0014"
+                             destination_port: "0x000a"
+                           }
+                         }
+                         payload: "test packet #42: payload"
+                       )pb"));
+
+  const PacketView view = PacketView::Parse(bytes);
+  EXPECT_TRUE(view.parsed_all_headers());
+  std::vector<Header::HeaderCase> header_cases;
+  for (const HeaderView& header : view.headers()) {
+    header_cases.push_back(header.header_case());
+  }
+  EXPECT_THAT(header_cases,
+              ElementsAre(Header::kEthernetHeader, Header::kIpv4Header,
+                          Header::kUdpHeader));
+  EXPECT_EQ(view.payload(), "test packet #42: payload");
+
+  ASSERT_TRUE(view.FindHeader<EthernetHeaderView>().has_value());
+  EXPECT_EQ(view.FindHeader<EthernetHeaderView>()->ethernet_source(),
+            netaddr::MacAddress(0, 1, 2, 3, 4, 5));
+  absl::optional<Ipv4HeaderView> ipv4 = view.FindHeader<Ipv4HeaderView>();
+  ASSERT_TRUE(ipv4.has_value());
+  EXPECT_EQ(ipv4->dscp(), 0x1b);
+  EXPECT_EQ(ipv4->ecn(), 1);
+  EXPECT_EQ(ipv4->ttl(), 0x10);
+  EXPECT_EQ(ipv4->total_length(), 20 + 8 + 24);
+  EXPECT_EQ(ipv4->ipv4_destination(), netaddr::Ipv4Address(10, 0, 0, 2));
+  absl::optional<UdpHeaderView> udp = view.FindHeader<UdpHeaderView>();
+  ASSERT_TRUE(udp.has_value());
+  EXPECT_EQ(udp->destination_port(), 0x000a);
+  EXPECT_FALSE(view.FindHeader<TcpHeaderView>().has_value());
+}
+
+TEST(PacketViewTest, StopsAtTruncatedHeaders) {
+  const std::string bytes = std::string(12, '\x02') + Bytes("\x08\x00\x45");
+  const PacketView view = PacketView::Parse(bytes);
+  EXPECT_FALSE(view.parsed_all_headers());
+  ASSERT_EQ(view.headers().size(), 1);
+  EXPECT_EQ(view.payload(), "\x45");
+}
+
+TEST(PacketViewTest, StopsAtUnsupportedHeaders) {
+  const std::string bytes = std::string(12, '\x02') + "\x12\x34payload";
+  const PacketView view = PacketView::Parse(bytes);
+  EXPECT_FALSE(view.parsed_all_headers());
+  ASSERT_EQ(view.headers().size(), 1);
+  EXPECT_EQ(view.payload(), "payload");
+}
+
+}  // namespace
+}  // namespace packetlib
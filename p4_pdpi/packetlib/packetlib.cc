@@ -2262,44 +2262,68 @@ absl::StatusOr<int> PacketSizeInBits(const Packet& packet,
   return size;
 }
 
-// Returns 16-bit ones' complement of the ones' complement sum of all 16-bit
-// words in the given BitString.
-static absl::StatusOr<int> OnesComplementChecksum(pdpi::BitString data) {
-  // Pad string to be 16-bit multiple.
-  while (data.size() % 16 != 0) data.AppendBit(0);
-
+// Returns the ones' complement sum of all 16-bit words in `bytes`, folded into
+// 16 bits. An odd trailing byte is padded with zero.
+static uint32_t OnesComplementSum(absl::string_view bytes) {
   // Following RFC 1071 and
   // wikipedia.org/wiki/IPv4_header_checksum#Calculating_the_IPv4_header_checksum
-  int sum = 0;
-  while (data.size() != 0) {
-    ASSIGN_OR_RETURN(std::bitset<16> word, data.ConsumeBitset<16>(),
-                     _.SetCode(absl::StatusCode::kInternal));
-    // This looks wrong because we're not taking the ones' complement, but
-    // turns out to work.
-    sum += word.to_ulong();
-  }
+  // A 64-bit accumulator cannot overflow for any packet size.
+  uint64_t sum = 0;
+  size_t i = 0;
+  for (; i + 1 < bytes.size(); i += 2) {
+    sum += (uint32_t{static_cast<uint8_t>(bytes[i])} << 8) |
+           static_cast<uint8_t>(bytes[i + 1]);
+  }
+  if (i < bytes.size()) sum += uint32_t{static_cast<uint8_t>(bytes[i])} << 8;
   // Add carry bits until sum fits into 16 bits.
   while (sum >> 16 != 0) {
     sum = (sum & 0xffff) + (sum >> 16);
   }
+  return sum;
+}
+
+// Returns 16-bit ones' complement of the ones' complement sum of all 16-bit
+// words in the given BitString.
+static absl::StatusOr<int> OnesComplementChecksum(const pdpi::BitString& data) {
+  if (data.size() % 8 != 0) {
+    // Pad to whole bytes; the sum pads the last 16-bit word with zeros anyway.
+    pdpi::BitString padded = data;
+    while (padded.size() % 8 != 0) padded.AppendBit(0);
+    return OnesComplementChecksum(padded);
+  }
+  ASSIGN_OR_RETURN(std::string bytes, data.ToByteString(),
+                   _.SetCode(absl::StatusCode::kInternal));
   // Return 16 bit ones' complement.
-  return (~sum) & 0xffff;
+  return (~OnesComplementSum(bytes)) & 0xffff;
 }
 
-absl::StatusOr<int> Ipv4HeaderChecksum(Ipv4Header header) {
+absl::StatusOr<int> Ipv4HeaderChecksum(const Ipv4Header& header) {
   // The checksum field is the 16-bit ones' complement of the ones' complement
   // sum of all 16-bit words in the header. For purposes of computing the
   // checksum, the value of the checksum field is zero.
 
   // We compute the checksum by setting the checksum field to 0, serializing
   // the header, and then going over all 16-bit words.
-  header.set_checksum("0x0000");
+  Ipv4Header header_without_checksum = header;
+  header_without_checksum.set_checksum("0x0000");
   pdpi::BitString data;
-  RETURN_IF_ERROR(SerializeIpv4Header(header, data));
-  return OnesComplementChecksum(std::move(data));
+  RETURN_IF_ERROR(SerializeIpv4Header(header_without_checksum, data));
+  return OnesComplementChecksum(data);
+}
+
+// Serializes `zeroed_header`, which is `packet.headers(header_index)` with its
+// checksum zeroed, followed by the rest of `packet`, into `data`. This way only
+// the header whose checksum is computed is copied, not the packet.
+static absl::Status SerializeForChecksum(const Packet& packet, int header_index,
+                                         const Header& zeroed_header,
+                                         pdpi::BitString& data) {
+  RETURN_IF_ERROR(SerializeHeader(zeroed_header, data)).SetPrepend()
+      << "while trying to serialize packet.headers(" << header_index << "): ";
+  return RawSerializePacket(packet, header_index + 1, data);
 }
 
-absl::StatusOr<int> UdpHeaderChecksum(Packet packet, int udp_header_index) {
+absl::StatusOr<int> UdpHeaderChecksum(const Packet& packet,
+                                      int udp_header_index) {
   auto invalid_argument = gutil::InvalidArgumentErrorBuilder()
                           << "UdpHeaderChecksum(packet, udp_header_index = "
                           << udp_header_index << "): ";
@@ -2322,8 +2346,8 @@ absl::StatusOr<int> UdpHeaderChecksum(Packet packet, int udp_header_index) {
                             << "] is a " << HeaderCaseName(header_case)
                             << ", expected UdpHeader";
   }
-  UdpHeader& udp_header =
-      *packet.mutable_headers(udp_header_index)->mutable_udp_header();
+  Header zeroed_header = packet.headers(udp_header_index);
+  UdpHeader& udp_header = *zeroed_header.mutable_udp_header();
   udp_header.set_checksum("0x0000");
 
   // Serialize "pseudo header" for checksum calculation, following
@@ -2358,11 +2382,13 @@ absl::StatusOr<int> UdpHeaderChecksum(Packet packet, int udp_header_index) {
                                  "1] to be an IP header, got "
                               << HeaderCaseName(preceding_header.header_case());
   }
-  RETURN_IF_ERROR(RawSerializePacket(packet, udp_header_index, data));
-  return OnesComplementChecksum(std::move(data));
+  RETURN_IF_ERROR(
+      SerializeForChecksum(packet, udp_header_index, zeroed_header, data));
+  return OnesComplementChecksum(data);
 }
 
-absl::StatusOr<int> IcmpHeaderChecksum(Packet packet, int icmp_header_index) {
+absl::StatusOr<int> IcmpHeaderChecksum(const Packet& packet,
+                                       int icmp_header_index) {
   auto invalid_argument = gutil::InvalidArgumentErrorBuilder()
                           << "IcmpHeaderChecksum(packet, icmp_header_index = "
                           << icmp_header_index << "): ";
@@ -2379,9 +2405,8 @@ absl::StatusOr<int> IcmpHeaderChecksum(Packet packet, int icmp_header_index) {
                             << ", expected IcmpHeader";
   }
 
-  IcmpHeader& icmp_header =
-      *packet.mutable_headers(icmp_header_index)->mutable_icmp_header();
-  icmp_header.set_checksum("0x0000");
+  Header zeroed_header = packet.headers(icmp_header_index);
+  zeroed_header.mutable_icmp_header()->set_checksum("0x0000");
 
   pdpi::BitString data;
   const Header& preceding_header = packet.headers(icmp_header_index - 1);
@@ -2410,11 +2435,13 @@ absl::StatusOr<int> IcmpHeaderChecksum(Packet packet, int icmp_header_index) {
                                  "1] to be an IP header, got "
                               << HeaderCaseName(preceding_header.header_case());
   }
-  RETURN_IF_ERROR(RawSerializePacket(packet, icmp_header_index, data));
-  return OnesComplementChecksum(std::move(data));
+  RETURN_IF_ERROR(
+      SerializeForChecksum(packet, icmp_header_index, zeroed_header, data));
+  return OnesComplementChecksum(data);
 }
 
-absl::StatusOr<int> GreHeaderChecksum(Packet packet, int gre_header_index) {
+absl::StatusOr<int> GreHeaderChecksum(const Packet& packet,
+                                      int gre_header_index) {
   auto invalid_argument = gutil::InvalidArgumentErrorBuilder()
                           << "GreHeaderChecksum(packet, gre_header_index = "
                           << gre_header_index << "): ";
@@ -2430,15 +2457,36 @@ absl::StatusOr<int> GreHeaderChecksum(Packet packet, int gre_header_index) {
                             << "] is a " << HeaderCaseName(header_case)
                             << ", expected GreHeader";
   }
-  GreHeader& gre_header =
-      *packet.mutable_headers(gre_header_index)->mutable_gre_header();
+  Header zeroed_header = packet.headers(gre_header_index);
+  zeroed_header.mutable_gre_header()->set_checksum("0x0000");
 
-  gre_header.set_checksum("0x0000");
   pdpi::BitString data;
+  RETURN_IF_ERROR(
+      SerializeForChecksum(packet, gre_header_index, zeroed_header, data));
+  return OnesComplementChecksum(data);
+}
 
-  RETURN_IF_ERROR(RawSerializePacket(packet, gre_header_index, data));
+int UpdateChecksum(int checksum, uint16_t old_word, uint16_t new_word) {
+  // HC' = ~(~HC + ~m + m'), in ones' complement arithmetic.
+  uint32_t sum = (~checksum & 0xffff) + (~old_word & 0xffff) + new_word;
+  while (sum >> 16 != 0) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return (~sum) & 0xffff;
+}
 
-  return OnesComplementChecksum(std::move(data));
+absl::StatusOr<int> UpdateChecksum(int checksum, absl::string_view old_bytes,
+                                   absl::string_view new_bytes) {
+  if (old_bytes.size() != new_bytes.size() || old_bytes.size() % 2 != 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "UpdateChecksum: expected old and new bytes of the same even "
+              "size, got sizes "
+           << old_bytes.size() << " and " << new_bytes.size();
+  }
+  // Subtracting the old sum and adding the new one is the same as updating
+  // word by word, since ones' complement addition is associative.
+  return UpdateChecksum(checksum, OnesComplementSum(old_bytes),
+                        OnesComplementSum(new_bytes));
 }
 
 std::string EtherType(uint32_t ether_type) {
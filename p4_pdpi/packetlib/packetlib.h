@@ -130,27 +130,48 @@ absl::StatusOr<int> PacketSizeInBytes(const Packet& packet,
 
 // Computes the 16-bit checksum of an IPv4 header. All fields must be set and
 // valid except possibly the checksum, which is ignored.
-absl::StatusOr<int> Ipv4HeaderChecksum(Ipv4Header header);
+absl::StatusOr<int> Ipv4HeaderChecksum(const Ipv4Header& header);
 
 // Computes the 16-bit UDP checksum for the given `packet` and
 // `udp_header_index`.
 // The header at the given index must be a UDP header, and it must be preceded
 // by an IP header. All fields in all headers following that IP header must be
 // set and valid except possibly the UDP checksum field, which is ignored.
-absl::StatusOr<int> UdpHeaderChecksum(Packet packet, int udp_header_index);
+absl::StatusOr<int> UdpHeaderChecksum(const Packet& packet,
+                                      int udp_header_index);
 
 // Computes the 16-bit ICMP checksum for the given `packet` and
 // `icmp_header_index`.
 // The header at the given index must be an ICMP header, and it must be preceded
 // by an IP header. All fields in all headers following that IP header must be
 // set and valid except possibly the UDP checksum field, which is ignored.
-absl::StatusOr<int> IcmpHeaderChecksum(Packet packet, int icmp_header_index);
+absl::StatusOr<int> IcmpHeaderChecksum(const Packet& packet,
+                                       int icmp_header_index);
 
 // Computes the 16-bit GRE checksum for the given `packet` and
 // `gre_header_index`. The header at the given index must be an GRE header. All
 // fields in all headers following that GRE header must be set and valid except
 // possibly the GRE checksum field, which is ignored.
-absl::StatusOr<int> GreHeaderChecksum(Packet packet, int gre_header_index);
+absl::StatusOr<int> GreHeaderChecksum(const Packet& packet,
+                                      int gre_header_index);
+
+// Incremental checksum updates, following RFC 1624 (eqn. 3). When a packet is
+// modified one field at a time (e.g. sweeping a port or DSCP value), these
+// update the IPv4, UDP, ICMP or GRE checksum covering the field in constant
+// time instead of recomputing it from the whole packet. The result equals the
+// full recomputation unless every 16-bit word covered by the checksum is zero.
+
+// Returns `checksum` updated for one 16-bit word it covers changing from
+// `old_word` to `new_word`. Fields narrower than 16 bits (e.g. DSCP) must be
+// passed as the 16-bit word containing them.
+int UpdateChecksum(int checksum, uint16_t old_word, uint16_t new_word);
+
+// Returns `checksum` updated for the bytes of a field changing from
+// `old_bytes` to `new_bytes` (e.g. an IPv4 or IPv6 address). The field must
+// start at an even byte offset within the checksummed data. Returns an error
+// if the byte strings differ in size or have an odd size.
+absl::StatusOr<int> UpdateChecksum(int checksum, absl::string_view old_bytes,
+                                   absl::string_view new_bytes);
 
 std::string HeaderCaseName(Header::HeaderCase header_case);
 
@@ -19,16 +19,19 @@
 #include <string>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "gutil/status.h"
 #include "gutil/status_matchers.h"
 #include "p4_pdpi/packetlib/bit_widths.h"
 #include "p4_pdpi/packetlib/packetlib.h"
 #include "p4_pdpi/packetlib/packetlib.pb.h"
+#include "p4_pdpi/string_encodings/hex_string.h"
 
 namespace packetlib {
 namespace {
@@ -553,5 +556,100 @@ TEST(PacketLib, ExperimentalEncapsulatedPacket) {
   ASSERT_OK(SerializePacket(packet));
 }
 
+// Returns an IPv4/UDP packet with all computed fields set.
+absl::StatusOr<Packet> Ipv4UdpPacket() {
+  Packet packet;
+  EthernetHeader* eth = packet.add_headers()->mutable_ethernet_header();
+  eth->set_ethertype(EtherType(ETHERTYPE_IP));
+  eth->set_ethernet_source(std::string(kEthernetSourceAddress));
+  eth->set_ethernet_destination(std::string(kEthernetDestinationAddress));
+
+  Ipv4Header* ipv4 = packet.add_headers()->mutable_ipv4_header();
+  ipv4->set_version(IpVersion(4));
+  ipv4->set_ihl(IpIhl(5));
+  ipv4->set_ipv4_source("192.168.0.31");
+  ipv4->set_ipv4_destination("192.168.0.30");
+  ipv4->set_ttl(IpTtl(0x10));
+  ipv4->set_dscp(IpDscp(3));
+  ipv4->set_protocol(IpProtocol(IPPROTO_UDP));
+  ipv4->set_ecn(IpEcn(2));
+  ipv4->set_identification(IpIdentification(0));
+  ipv4->set_flags(IpFlags(0));
+  ipv4->set_fragment_offset(IpFragmentOffset(0));
+
+  UdpHeader* udp = packet.add_headers()->mutable_udp_header();
+  udp->set_source_port(UdpPort(0x0014));
+  udp->set_destination_port(UdpPort(0x000a));
+  packet.set_payload("Some payload of odd length.");
+  RETURN_IF_ERROR(PadPacketToMinimumSize(packet).status());
+  RETURN_IF_ERROR(UpdateAllComputedFields(packet).status());
+  return packet;
+}
+
+TEST(PacketLib, UpdateChecksumMatchesRecomputationForPortSweep) {
+  ASSERT_OK_AND_ASSIGN(Packet packet, Ipv4UdpPacket());
+  UdpHeader& udp = *packet.mutable_headers(2)->mutable_udp_header();
+  ASSERT_OK_AND_ASSIGN(int checksum, pdpi::HexStringToInt(udp.checksum()));
+  for (int port = 0; port < 0x10000; port += 0x0fed) {
+    ASSERT_OK_AND_ASSIGN(int old_port,
+                         pdpi::HexStringToInt(udp.source_port()));
+    udp.set_source_port(UdpPort(port));
+    checksum = UpdateChecksum(checksum, old_port, port);
+    EXPECT_THAT(UdpHeaderChecksum(packet, 2), IsOkAndHolds(checksum))
+        << "for source port " << port;
+  }
+}
+
+TEST(PacketLib, UpdateChecksumMatchesRecomputationForDscpSweep) {
+  ASSERT_OK_AND_ASSIGN(Packet packet, Ipv4UdpPacket());
+  Ipv4Header& ipv4 = *packet.mutable_headers(1)->mutable_ipv4_header();
+  ASSERT_OK_AND_ASSIGN(int checksum, pdpi::HexStringToInt(ipv4.checksum()));
+  // DSCP shares the first 16-bit word with the version, IHL and ECN.
+  auto first_word = [](int dscp) { return 0x4502 | (dscp << 2); };
+  for (int dscp = 0; dscp < 64; ++dscp) {
+    ASSERT_OK_AND_ASSIGN(int old_dscp, pdpi::HexStringToInt(ipv4.dscp()));
+    ipv4.set_dscp(IpDscp(dscp));
+    checksum = UpdateChecksum(checksum, first_word(old_dscp), first_word(dscp));
+    EXPECT_THAT(Ipv4HeaderChecksum(ipv4), IsOkAndHolds(checksum))
+        << "for DSCP " << dscp;
+  }
+}
+
+TEST(PacketLib, UpdateChecksumMatchesRecomputationForAddressChange) {
+  ASSERT_OK_AND_ASSIGN(Packet packet, Ipv4UdpPacket());
+  Ipv4Header& ipv4 = *packet.mutable_headers(1)->mutable_ipv4_header();
+  const UdpHeader& udp = packet.headers(2).udp_header();
+  ASSERT_OK_AND_ASSIGN(int ipv4_checksum,
+                       pdpi::HexStringToInt(ipv4.checksum()));
+  ASSERT_OK_AND_ASSIGN(int udp_checksum, pdpi::HexStringToInt(udp.checksum()));
+
+  // The destination address is covered by both the IPv4 checksum and the UDP
+  // pseudo header.
+  const std::string old_address("\xc0\xa8\x00\x1e", 4);
+  const std::string new_address = "\x0a\x01\xfe\x63";
+  ipv4.set_ipv4_destination("10.1.254.99");
+  EXPECT_THAT(Ipv4HeaderChecksum(ipv4),
+              IsOkAndHolds(*UpdateChecksum(ipv4_checksum, old_address,
+                                           new_address)));
+  EXPECT_THAT(UdpHeaderChecksum(packet, 2),
+              IsOkAndHolds(*UpdateChecksum(udp_checksum, old_address,
+                                           new_address)));
+}
+
+TEST(PacketLib, UpdateChecksumRejectsMismatchedBytes) {
+  EXPECT_THAT(UpdateChecksum(0x1234, "ab", "abcd"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(UpdateChecksum(0x1234, "abc", "def"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PacketLib, ChecksumsDoNotModifyThePacket) {
+  ASSERT_OK_AND_ASSIGN(Packet packet, Ipv4UdpPacket());
+  const Packet original = packet;
+  ASSERT_OK(UdpHeaderChecksum(packet, 2).status());
+  ASSERT_OK(Ipv4HeaderChecksum(packet.headers(1).ipv4_header()).status());
+  EXPECT_EQ(packet.DebugString(), original.DebugString());
+}
+
 }  // namespace
 }  // namespace packetlib
@@ -265,6 +265,18 @@ ParseAllReferencedByAnnotations(
       "referenced_by", annotations, ParseAsReferencedByAnnotation);
 }
 
+absl::StatusOr<std::vector<ParsedRefersToAnnotation>>
+ParseAllRefersToAnnotations(const AnnotationIndex &annotations) {
+  return GetAllParsedAnnotations<ParsedRefersToAnnotation>(
+      "refers_to", annotations, ParseAsRefersToAnnotation);
+}
+
+absl::StatusOr<std::vector<ParsedReferencedByAnnotation>>
+ParseAllReferencedByAnnotations(const AnnotationIndex &annotations) {
+  return GetAllParsedAnnotations<ParsedReferencedByAnnotation>(
+      "referenced_by", annotations, ParseAsReferencedByAnnotation);
+}
+
 absl::StatusOr<IrField> CreateIrFieldFromRefersTo(
     const ParsedRefersToAnnotation &annotation, const IrP4Info &info) {
   if (info.actions_by_name().contains(annotation.table) ||
@@ -348,10 +360,11 @@ absl::StatusOr<std::vector<IrTableReference>> ParseIrTableReferences(
   for (const auto &[action_name, action_def] : info.actions_by_name()) {
     for (const auto &[param_name, param_def] :
          Ordered(action_def.params_by_name())) {
+      const AnnotationIndex annotations(param_def.param().annotations());
       // Parse @refers_by annotations on parameter.
       ASSIGN_OR_RETURN(
           const std::vector<ParsedRefersToAnnotation> refers_to_annotations,
-          ParseAllRefersToAnnotations(param_def.param().annotations()));
+          ParseAllRefersToAnnotations(annotations));
       for (const ParsedRefersToAnnotation &annotation : refers_to_annotations) {
         IrTableReference::FieldReference field_reference;
         ASSIGN_OR_RETURN(*field_reference.mutable_destination(),
@@ -370,7 +383,7 @@ absl::StatusOr<std::vector<IrTableReference>> ParseIrTableReferences(
       ASSIGN_OR_RETURN(
           const std::vector<ParsedReferencedByAnnotation>
               referenced_by_annotations,
-          ParseAllReferencedByAnnotations(param_def.param().annotations()));
+          ParseAllReferencedByAnnotations(annotations));
       if (!referenced_by_annotations.empty()) {
         return gutil::UnimplementedErrorBuilder()
                << "References to actions are unsupported: parameter '"
@@ -392,11 +405,12 @@ absl::StatusOr<std::vector<IrTableReference>> ParseIrTableReferences(
   for (const auto &[table_name, table_def] : Ordered(info.tables_by_name())) {
     for (const auto &[match_field_name, match_field_def] :
          Ordered(table_def.match_fields_by_name())) {
+      const AnnotationIndex annotations(
+          match_field_def.match_field().annotations());
       // Parse all @refers_to annotations on table match field.
       ASSIGN_OR_RETURN(
           const std::vector<ParsedRefersToAnnotation> refers_to_annotations,
-          ParseAllRefersToAnnotations(
-              match_field_def.match_field().annotations()));
+          ParseAllRefersToAnnotations(annotations));
       for (const ParsedRefersToAnnotation &annotation : refers_to_annotations) {
         IrTableReference &table_reference =
             table_references_by_dst_table_by_src_table[table_name]
@@ -413,8 +427,7 @@ absl::StatusOr<std::vector<IrTableReference>> ParseIrTableReferences(
       // Parse all @referenced_by annotations on table match field.
       ASSIGN_OR_RETURN(const std::vector<ParsedReferencedByAnnotation>
                            referenced_by_annotations,
-                       ParseAllReferencedByAnnotations(
-                           match_field_def.match_field().annotations()));
+                       ParseAllReferencedByAnnotations(annotations));
       for (const ParsedReferencedByAnnotation &annotation :
            referenced_by_annotations) {
         IrTableReference &table_reference =
@@ -8,6 +8,7 @@
 #include "absl/strings/string_view.h"
 #include "google/protobuf/repeated_ptr_field.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/utils/annotation_parser.h"
 
 namespace pdpi {
 
@@ -51,6 +52,13 @@ absl::StatusOr<std::vector<ParsedReferencedByAnnotation>>
 ParseAllReferencedByAnnotations(
     const google::protobuf::RepeatedPtrField<std::string> &annotations);
 
+// Same as the two functions above, but for annotations that were already
+// indexed, e.g. to parse both kinds of annotation of an element.
+absl::StatusOr<std::vector<ParsedRefersToAnnotation>>
+ParseAllRefersToAnnotations(const AnnotationIndex &annotations);
+absl::StatusOr<std::vector<ParsedReferencedByAnnotation>>
+ParseAllReferencedByAnnotations(const AnnotationIndex &annotations);
+
 // Returns an `IrField` created from an @refers_to annotation. Returns error
 // if annotation has invalid information or is a reference to an action.
 absl::StatusOr<IrField> CreateIrFieldFromRefersTo(
@@ -0,0 +1,170 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/reference_graph.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "google/protobuf/repeated_ptr_field.h"
+#include "gutil/collections.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/built_ins.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/references.h"
+
+namespace pdpi {
+namespace {
+
+using IrTableReferences = google::protobuf::RepeatedPtrField<IrTableReference>;
+
+// The references of the table that an entity belongs to.
+struct TableReferences {
+  const IrTableReferences* outgoing;
+  const IrTableReferences* incoming;
+};
+
+absl::StatusOr<TableReferences> GetTableReferences(
+    const IrP4Info& info, const p4::v1::Entity& entity) {
+  if (entity.has_table_entry()) {
+    ASSIGN_OR_RETURN(auto* table_def,
+                     gutil::FindPtrOrStatus(info.tables_by_id(),
+                                            entity.table_entry().table_id()));
+    return TableReferences{.outgoing = &table_def->outgoing_references(),
+                           .incoming = &table_def->incoming_references()};
+  }
+  if (entity.packet_replication_engine_entry().has_multicast_group_entry()) {
+    ASSIGN_OR_RETURN(
+        std::string multicast_table,
+        IrBuiltInTableToString(BUILT_IN_TABLE_MULTICAST_GROUP_TABLE));
+    ASSIGN_OR_RETURN(
+        auto* multicast_group_def,
+        gutil::FindPtrOrStatus(info.built_in_tables(), multicast_table));
+    return TableReferences{
+        .outgoing = &multicast_group_def->outgoing_references(),
+        .incoming = &multicast_group_def->incoming_references()};
+  }
+  return gutil::InvalidArgumentErrorBuilder()
+         << "Unsupported entity type: " << entity.DebugString();
+}
+
+}  // namespace
+
+absl::StatusOr<ReferenceGraph::ReferenceSet>
+ReferenceGraph::OutgoingReferences(const p4::v1::Entity& entity) const {
+  ASSIGN_OR_RETURN(TableReferences table_references,
+                   GetTableReferences(info_, entity));
+  ReferenceSet result;
+  for (const IrTableReference& reference_info : *table_references.outgoing) {
+    ASSIGN_OR_RETURN(ReferenceSet references,
+                     OutgoingConcreteTableReferences(reference_info, entity));
+    result.merge(references);
+  }
+  return result;
+}
+
+absl::StatusOr<ReferenceGraph::ReferenceSet>
+ReferenceGraph::IncomingReferences(const p4::v1::Entity& entity) const {
+  ASSIGN_OR_RETURN(TableReferences table_references,
+                   GetTableReferences(info_, entity));
+  ReferenceSet result;
+  for (const IrTableReference& reference_info : *table_references.incoming) {
+    ASSIGN_OR_RETURN(
+        ReferenceSet references,
+        PossibleIncomingConcreteTableReferences(reference_info, entity));
+    result.merge(references);
+  }
+  return result;
+}
+
+absl::Status ReferenceGraph::AddEntity(const p4::v1::Entity& entity) {
+  ASSIGN_OR_RETURN(EntityKey key, EntityKey::MakeEntityKey(entity));
+  if (entities_.contains(key)) {
+    return gutil::AlreadyExistsErrorBuilder()
+           << "Entity is already in the reference graph: "
+           << entity.ShortDebugString();
+  }
+  Node node;
+  ASSIGN_OR_RETURN(node.outgoing, OutgoingReferences(entity));
+  ASSIGN_OR_RETURN(node.incoming, IncomingReferences(entity));
+
+  for (const ConcreteTableReference& reference : node.outgoing) {
+    entities_by_outgoing_reference_[reference].insert(key);
+  }
+  for (const ConcreteTableReference& reference : node.incoming) {
+    entities_by_incoming_reference_[reference].insert(key);
+  }
+  entities_.insert({std::move(key), std::move(node)});
+  return absl::OkStatus();
+}
+
+absl::Status ReferenceGraph::RemoveEntity(const p4::v1::Entity& entity) {
+  ASSIGN_OR_RETURN(EntityKey key, EntityKey::MakeEntityKey(entity));
+  auto node = entities_.find(key);
+  if (node == entities_.end()) {
+    return gutil::NotFoundErrorBuilder()
+           << "Entity is not in the reference graph: "
+           << entity.ShortDebugString();
+  }
+
+  // Drops `key` from the entries of `references` in `index`, along with
+  // entries that no entity is left in.
+  auto remove_from_index = [&key](const ReferenceSet& references,
+                                  ReferenceIndex& index) {
+    for (const ConcreteTableReference& reference : references) {
+      auto entry = index.find(reference);
+      if (entry == index.end()) continue;
+      entry->second.erase(key);
+      if (entry->second.empty()) index.erase(entry);
+    }
+  };
+  remove_from_index(node->second.outgoing, entities_by_outgoing_reference_);
+  remove_from_index(node->second.incoming, entities_by_incoming_reference_);
+  entities_.erase(node);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<EntityKey>> ReferenceGraph::GetReferencingEntities(
+    const p4::v1::Entity& entity) const {
+  ASSIGN_OR_RETURN(ReferenceSet references, IncomingReferences(entity));
+  absl::btree_set<EntityKey> result;
+  for (const ConcreteTableReference& reference : references) {
+    if (auto* keys = gutil::FindOrNull(entities_by_outgoing_reference_,
+                                       reference)) {
+      result.insert(keys->begin(), keys->end());
+    }
+  }
+  return std::vector<EntityKey>(result.begin(), result.end());
+}
+
+absl::StatusOr<std::vector<EntityKey>> ReferenceGraph::GetReferencedEntities(
+    const p4::v1::Entity& entity) const {
+  ASSIGN_OR_RETURN(ReferenceSet references, OutgoingReferences(entity));
+  absl::btree_set<EntityKey> result;
+  for (const ConcreteTableReference& reference : references) {
+    if (auto* keys = gutil::FindOrNull(entities_by_incoming_reference_,
+                                       reference)) {
+      result.insert(keys->begin(), keys->end());
+    }
+  }
+  return std::vector<EntityKey>(result.begin(), result.end());
+}
+
+}  // namespace pdpi
@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_PDPI_REFERENCE_GRAPH_H_
+#define PINS_P4_PDPI_REFERENCE_GRAPH_H_
+
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/references.h"
+
+namespace pdpi {
+
+// The references between a set of entities (e.g. the entities installed on a
+// switch), maintained as entities are added and removed.
+//
+// Answers "which entities refer to X" and "which entities does X refer to" in
+// time proportional to the number of references of X, instead of recomputing
+// the references of every entity. This makes it cheap to, for example, reject
+// the deletion of an entity that is still referred to.
+//
+// Supports table entries and multicast group entries, like
+// `OutgoingConcreteTableReferences`. The IrP4Info must outlive the graph.
+class ReferenceGraph {
+ public:
+  explicit ReferenceGraph(const IrP4Info& info) : info_(info) {}
+
+  // Adds `entity` to the graph. Returns AlreadyExists if the graph already has
+  // an entity with the same key. Does not check that the entities `entity`
+  // refers to exist, see `GetReferencedEntities`.
+  absl::Status AddEntity(const p4::v1::Entity& entity);
+
+  // Removes the entity with the key of `entity` from the graph. Only the key of
+  // `entity` is used, as in a P4Runtime delete. Returns NotFound if the graph
+  // has no entity with that key. Does not check that no entity refers to the
+  // removed entity, see `GetReferencingEntities`.
+  absl::Status RemoveEntity(const p4::v1::Entity& entity);
+
+  // Returns true if the graph has an entity with key `key`.
+  bool Contains(const EntityKey& key) const { return entities_.contains(key); }
+  int size() const { return entities_.size(); }
+
+  // Returns the keys of the entities in the graph that refer to `entity`, in
+  // ascending order. `entity` need not be in the graph.
+  absl::StatusOr<std::vector<EntityKey>> GetReferencingEntities(
+      const p4::v1::Entity& entity) const;
+
+  // Returns the keys of the entities in the graph that `entity` refers to, in
+  // ascending order. `entity` need not be in the graph.
+  absl::StatusOr<std::vector<EntityKey>> GetReferencedEntities(
+      const p4::v1::Entity& entity) const;
+
+ private:
+  using ReferenceSet = absl::flat_hash_set<ConcreteTableReference>;
+  using ReferenceIndex =
+      absl::flat_hash_map<ConcreteTableReference,
+                          absl::flat_hash_set<EntityKey>>;
+
+  // The references of an entity in the graph, kept so that it can be removed
+  // from the indices below without recomputing them.
+  struct Node {
+    // References from the entity to other entities.
+    ReferenceSet outgoing;
+    // References through which other entities could refer to the entity.
+    ReferenceSet incoming;
+  };
+
+  absl::StatusOr<ReferenceSet> OutgoingReferences(
+      const p4::v1::Entity& entity) const;
+  absl::StatusOr<ReferenceSet> IncomingReferences(
+      const p4::v1::Entity& entity) const;
+
+  const IrP4Info& info_;
+  absl::flat_hash_map<EntityKey, Node> entities_;
+  // Maps each outgoing reference to the entities that make it.
+  ReferenceIndex entities_by_outgoing_reference_;
+  // Maps each incoming reference to the entities that it would refer to.
+  ReferenceIndex entities_by_incoming_reference_;
+};
+
+}  // namespace pdpi
+
+#endif  // PINS_P4_PDPI_REFERENCE_GRAPH_H_
@@ -0,0 +1,144 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/reference_graph.h"
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/testing/test_p4info.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// Returns an entry of `one_match_field_table`, which is referred to by
+// `referring_by_action_table`.
+p4::v1::Entity ReferencedEntity(const std::string& id) {
+  const IrTableDefinition& table =
+      GetTestIrP4Info().tables_by_name().at("one_match_field_table");
+  p4::v1::Entity entity;
+  p4::v1::TableEntry& entry = *entity.mutable_table_entry();
+  entry.set_table_id(table.preamble().id());
+  p4::v1::FieldMatch& match = *entry.add_match();
+  match.set_field_id(table.match_fields_by_name().at("id").match_field().id());
+  match.mutable_exact()->set_value(id);
+  return entity;
+}
+
+// Returns an entry of `referring_by_action_table` that refers to the
+// `one_match_field_table` entry with the given `id`.
+p4::v1::Entity ReferringEntity(const std::string& val, const std::string& id) {
+  const IrP4Info& info = GetTestIrP4Info();
+  const IrTableDefinition& table =
+      info.tables_by_name().at("referring_by_action_table");
+  const IrActionDefinition& action =
+      info.actions_by_name().at("referring_to_one_match_field_action");
+  p4::v1::Entity entity;
+  p4::v1::TableEntry& entry = *entity.mutable_table_entry();
+  entry.set_table_id(table.preamble().id());
+  p4::v1::FieldMatch& match = *entry.add_match();
+  match.set_field_id(table.match_fields_by_name().at("val").match_field().id());
+  match.mutable_exact()->set_value(val);
+  p4::v1::Action& pi_action = *entry.mutable_action()->mutable_action();
+  pi_action.set_action_id(action.preamble().id());
+  p4::v1::Action::Param& param = *pi_action.add_params();
+  param.set_param_id(
+      action.params_by_name().at("referring_id_1").param().id());
+  param.set_value(id);
+  return entity;
+}
+
+EntityKey KeyOf(const p4::v1::Entity& entity) {
+  return EntityKey(entity.table_entry());
+}
+
+TEST(ReferenceGraphTest, FindsReferencesInBothDirections) {
+  ReferenceGraph graph(GetTestIrP4Info());
+  ASSERT_OK(graph.AddEntity(ReferencedEntity("a")));
+  ASSERT_OK(graph.AddEntity(ReferencedEntity("b")));
+  ASSERT_OK(graph.AddEntity(ReferringEntity("\x01", "a")));
+  ASSERT_OK(graph.AddEntity(ReferringEntity("\x02", "a")));
+
+  EXPECT_THAT(graph.GetReferencingEntities(ReferencedEntity("a")),
+              IsOkAndHolds(ElementsAre(KeyOf(ReferringEntity("\x01", "a")),
+                                       KeyOf(ReferringEntity("\x02", "a")))));
+  EXPECT_THAT(graph.GetReferencingEntities(ReferencedEntity("b")),
+              IsOkAndHolds(IsEmpty()));
+  EXPECT_THAT(graph.GetReferencedEntities(ReferringEntity("\x01", "a")),
+              IsOkAndHolds(ElementsAre(KeyOf(ReferencedEntity("a")))));
+}
+
+TEST(ReferenceGraphTest, AnswersQueriesForEntitiesNotInTheGraph) {
+  ReferenceGraph graph(GetTestIrP4Info());
+  ASSERT_OK(graph.AddEntity(ReferencedEntity("a")));
+
+  EXPECT_THAT(graph.GetReferencedEntities(ReferringEntity("\x01", "a")),
+              IsOkAndHolds(ElementsAre(KeyOf(ReferencedEntity("a")))));
+  EXPECT_THAT(graph.GetReferencedEntities(ReferringEntity("\x01", "c")),
+              IsOkAndHolds(IsEmpty()));
+}
+
+TEST(ReferenceGraphTest, RemovedEntitiesNoLongerReferOrAreReferredTo) {
+  ReferenceGraph graph(GetTestIrP4Info());
+  ASSERT_OK(graph.AddEntity(ReferencedEntity("a")));
+  ASSERT_OK(graph.AddEntity(ReferringEntity("\x01", "a")));
+
+  // Only the key is needed to remove an entity.
+  p4::v1::Entity referring_key = ReferringEntity("\x01", "a");
+  referring_key.mutable_table_entry()->clear_action();
+  ASSERT_OK(graph.RemoveEntity(referring_key));
+  EXPECT_THAT(graph.GetReferencingEntities(ReferencedEntity("a")),
+              IsOkAndHolds(IsEmpty()));
+
+  ASSERT_OK(graph.AddEntity(ReferringEntity("\x01", "a")));
+  ASSERT_OK(graph.RemoveEntity(ReferencedEntity("a")));
+  EXPECT_THAT(graph.GetReferencedEntities(ReferringEntity("\x01", "a")),
+              IsOkAndHolds(IsEmpty()));
+  EXPECT_EQ(graph.size(), 1);
+}
+
+TEST(ReferenceGraphTest, RejectsDuplicateAndMissingEntities) {
+  ReferenceGraph graph(GetTestIrP4Info());
+  ASSERT_OK(graph.AddEntity(ReferencedEntity("a")));
+
+  EXPECT_THAT(graph.AddEntity(ReferencedEntity("a")),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+  EXPECT_THAT(graph.RemoveEntity(ReferencedEntity("b")),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_TRUE(graph.Contains(KeyOf(ReferencedEntity("a"))));
+  EXPECT_FALSE(graph.Contains(KeyOf(ReferencedEntity("b"))));
+}
+
+TEST(ReferenceGraphTest, FailedAddLeavesTheGraphUnchanged) {
+  ReferenceGraph graph(GetTestIrP4Info());
+  p4::v1::Entity unknown_table = ReferencedEntity("a");
+  unknown_table.mutable_table_entry()->set_table_id(0);
+
+  EXPECT_THAT(graph.AddEntity(unknown_table),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_EQ(graph.size(), 0);
+}
+
+}  // namespace
+}  // namespace pdpi
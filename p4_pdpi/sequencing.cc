@@ -15,10 +15,13 @@
 #include "p4_pdpi/sequencing.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <optional>
 #include <queue>
 #include <string>
+#include <thread>  // NOLINT
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -26,11 +29,12 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/functional/function_ref.h"
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
-#include "boost/graph/adjacency_list.hpp"
 #include "glog/logging.h"
 #include "google/protobuf/repeated_ptr_field.h"
 #include "gutil/collections.h"
@@ -49,30 +53,97 @@ using ::p4::v1::Action_Param;
 using ::p4::v1::Update;
 using ::p4::v1::WriteRequest;
 
-// We require boost::in_degree, which requires bidirectionalS.
-using Graph =
-    boost::adjacency_list<boost::hash_setS, boost::vecS, boost::bidirectionalS>;
-// Boost uses integers to identify vertices.
+// Updates are identified by their index in the input.
 using Vertex = int;
 
 // Describing a referenced match field (table + match field) as well as the
-// value of that match field (in this order).
-using ReferencedValue = std::tuple<std::string, std::string, std::string>;
-// The mapping of a referenced value to vertices that are being referred to by
-// that referenced value.
-using ReferencedValueToVertices =
-    absl::flat_hash_map<ReferencedValue, absl::flat_hash_set<Vertex>>;
-
-absl::StatusOr<absl::optional<std::string>> GetMatchFieldValue(
-    const IrTableDefinition& ir_table_definition, const Update& update,
-    const std::string& match_field) {
-  ASSIGN_OR_RETURN(
-      const auto* match_field_definition,
-      gutil::FindPtrOrStatus(ir_table_definition.match_fields_by_name(),
-                             match_field),
-      _ << "Failed to build dependency graph: Match field with name "
-        << match_field << " does not exist.");
-  int32_t match_field_id = match_field_definition->match_field().id();
+// value of that match field (in this order). The strings point into the
+// IrP4Info and the updates, which outlive the dependency graph.
+using ReferencedValue =
+    std::tuple<absl::string_view, absl::string_view, absl::string_view>;
+
+// Groups `(row, value)` pairs by row in compressed sparse row form: the values
+// of row r are `values[offsets[r]..offsets[r + 1])`, in the order they appear
+// in `entries`.
+void CompressRows(int num_rows, absl::Span<const std::pair<int, int>> entries,
+                  std::vector<int>& offsets, std::vector<int>& values) {
+  offsets.assign(num_rows + 1, 0);
+  for (const auto& [row, value] : entries) offsets[row + 1]++;
+  for (int row = 0; row < num_rows; row++) offsets[row + 1] += offsets[row];
+  values.resize(entries.size());
+  std::vector<int> next = offsets;
+  for (const auto& [row, value] : entries) values[next[row]++] = value;
+}
+
+// The updates providing each referenced value, i.e. the updates whose match
+// fields hold it. Referenced values are interned into dense IDs.
+struct ReferencedValueIndex {
+  absl::flat_hash_map<ReferencedValue, int> ids;
+  std::vector<int> offsets;
+  std::vector<Vertex> vertices;
+
+  absl::Span<const Vertex> Providers(const ReferencedValue& value) const {
+    auto it = ids.find(value);
+    if (it == ids.end()) return {};
+    return absl::MakeConstSpan(vertices).subspan(
+        offsets[it->second], offsets[it->second + 1] - offsets[it->second]);
+  }
+};
+
+// The dependency graph in compressed sparse row form: the updates depending on
+// update u are `dependents[offsets[u]..offsets[u + 1])`.
+struct DependencyGraph {
+  std::vector<int> offsets;
+  std::vector<Vertex> dependents;
+  std::vector<int> in_degrees;
+};
+
+// A match field that other tables refer to.
+struct ReferencedField {
+  absl::string_view table;
+  absl::string_view match_field;
+  uint32_t match_field_id;
+};
+
+// Returns the distinct match fields of `ir_table_definition` that are referred
+// to according to `info.references()`. Results are cached by table ID in
+// `cache`.
+absl::StatusOr<absl::Span<const ReferencedField>> GetReferencedFields(
+    const IrP4Info& info, const IrTableDefinition& ir_table_definition,
+    absl::flat_hash_map<uint32_t, std::vector<ReferencedField>>& cache) {
+  const uint32_t table_id = ir_table_definition.preamble().id();
+  if (auto it = cache.find(table_id); it != cache.end()) {
+    return absl::MakeConstSpan(it->second);
+  }
+
+  std::vector<ReferencedField> fields;
+  const std::string& table_name = ir_table_definition.preamble().alias();
+  for (const auto& ir_reference : info.references()) {
+    if (table_name != ir_reference.table()) continue;
+    ASSIGN_OR_RETURN(
+        const auto* match_field_definition,
+        gutil::FindPtrOrStatus(ir_table_definition.match_fields_by_name(),
+                               ir_reference.match_field()),
+        _ << "Failed to build dependency graph: Match field with name "
+          << ir_reference.match_field() << " does not exist.");
+    // Many tables may refer to the same match field.
+    if (absl::c_any_of(fields, [&](const ReferencedField& field) {
+          return field.match_field == ir_reference.match_field();
+        })) {
+      continue;
+    }
+    fields.push_back(ReferencedField{
+        .table = ir_reference.table(),
+        .match_field = ir_reference.match_field(),
+        .match_field_id = match_field_definition->match_field().id(),
+    });
+  }
+  return absl::MakeConstSpan(
+      cache.emplace(table_id, std::move(fields)).first->second);
+}
+
+absl::optional<absl::string_view> GetMatchFieldValue(const Update& update,
+                                                     uint32_t match_field_id) {
   for (const auto& match : update.entity().table_entry().match()) {
     if (match.field_id() == match_field_id) {
       if (match.has_exact()) {
@@ -85,21 +156,22 @@ absl::StatusOr<absl::optional<std::string>> GetMatchFieldValue(
   return absl::nullopt;
 }
 
-// Given the ReferencedValue of the current_vertex, record all dependencies.
-void RecordDependenciesForReferencedValue(absl::Span<const Update> all_vertices,
-                                          Vertex current_vertex,
-                                          ReferencedValue referenced_value,
-                                          ReferencedValueToVertices& indices,
-                                          Graph& graph) {
-  for (Vertex referred_update_index : indices[referenced_value]) {
+// Given the ReferencedValue of the current_vertex, record all dependencies as
+// edges `(u, v)`, meaning v depends on u.
+void RecordDependenciesForReferencedValue(
+    absl::Span<const Update> all_vertices, Vertex current_vertex,
+    const ReferencedValue& referenced_value, const ReferencedValueIndex& index,
+    std::vector<std::pair<Vertex, Vertex>>& edges) {
+  const Update::Type current_type = all_vertices[current_vertex].type();
+  for (Vertex referred_update_index : index.Providers(referenced_value)) {
     const Update& referred_update = all_vertices[referred_update_index];
-    if ((all_vertices[current_vertex].type() == p4::v1::Update::INSERT ||
-         all_vertices[current_vertex].type() == p4::v1::Update::MODIFY) &&
+    if ((current_type == p4::v1::Update::INSERT ||
+         current_type == p4::v1::Update::MODIFY) &&
         referred_update.type() == p4::v1::Update::INSERT) {
-      boost::add_edge(referred_update_index, current_vertex, graph);
-    } else if (all_vertices[current_vertex].type() == p4::v1::Update::DELETE &&
+      edges.push_back({referred_update_index, current_vertex});
+    } else if (current_type == p4::v1::Update::DELETE &&
                referred_update.type() == p4::v1::Update::DELETE) {
-      boost::add_edge(current_vertex, referred_update_index, graph);
+      edges.push_back({current_vertex, referred_update_index});
     }
   }
 }
@@ -108,7 +180,8 @@ void RecordDependenciesForReferencedValue(absl::Span<const Update> all_vertices,
 absl::Status RecordDependenciesForActionInvocation(
     absl::Span<const Update> all_vertices, const IrActionDefinition& ir_action,
     absl::Span<const Action_Param* const> params, Vertex current_vertex,
-    ReferencedValueToVertices& indices, Graph& graph) {
+    const ReferencedValueIndex& index,
+    std::vector<std::pair<Vertex, Vertex>>& edges) {
   for (const Action_Param* const param : params) {
     ASSIGN_OR_RETURN(
         const auto* param_definition,
@@ -119,45 +192,51 @@ absl::Status RecordDependenciesForActionInvocation(
       ReferencedValue referenced_value = {
           ir_reference.table(), ir_reference.match_field(), param->value()};
       RecordDependenciesForReferencedValue(all_vertices, current_vertex,
-                                           referenced_value, indices, graph);
+                                           referenced_value, index, edges);
     }
   }
   return absl::OkStatus();
 }
 
 // Builds the dependency graph between updates. An edge from u to v indicates
-// that v depends on u.
-absl::StatusOr<Graph> BuildDependencyGraph(const IrP4Info& info,
-                                           absl::Span<const Update> updates) {
-  // Graph containing one node per update.
-  Graph graph(updates.size());
-
-  // Build indices to map references to the set of updates of that key.
-  ReferencedValueToVertices indices;
-  for (int update_index = 0; update_index < updates.size(); update_index++) {
-    const Update& update = updates[update_index];
-    ASSIGN_OR_RETURN(
-        const IrTableDefinition* ir_table_definition,
-        gutil::FindPtrOrStatus(info.tables_by_id(),
-                               update.entity().table_entry().table_id()),
-        _ << "Failed to build dependency graph: Table with ID "
-          << update.entity().table_entry().table_id() << " does not exist.");
-    const std::string& update_table_name =
-        ir_table_definition->preamble().alias();
-    for (const auto& ir_reference : info.references()) {
-      if (update_table_name != ir_reference.table()) continue;
-      ASSIGN_OR_RETURN(absl::optional<std::string> value,
-                       GetMatchFieldValue(*ir_table_definition, update,
-                                          ir_reference.match_field()));
-      if (value.has_value()) {
-        ReferencedValue reference_value = {
-            ir_reference.table(), ir_reference.match_field(), value.value()};
-        indices[reference_value].insert(update_index);
+// that v depends on u. Takes time linear in the number of updates and edges.
+absl::StatusOr<DependencyGraph> BuildDependencyGraph(
+    const IrP4Info& info, absl::Span<const Update> updates) {
+  // Build an index mapping references to the updates providing them.
+  ReferencedValueIndex index;
+  {
+    absl::flat_hash_map<uint32_t, std::vector<ReferencedField>>
+        referenced_fields_by_table_id;
+    std::vector<std::pair<int, Vertex>> providers;
+    for (int update_index = 0; update_index < updates.size(); update_index++) {
+      const Update& update = updates[update_index];
+      ASSIGN_OR_RETURN(
+          const IrTableDefinition* ir_table_definition,
+          gutil::FindPtrOrStatus(info.tables_by_id(),
+                                 update.entity().table_entry().table_id()),
+          _ << "Failed to build dependency graph: Table with ID "
+            << update.entity().table_entry().table_id() << " does not exist.");
+      ASSIGN_OR_RETURN(absl::Span<const ReferencedField> referenced_fields,
+                       GetReferencedFields(info, *ir_table_definition,
+                                           referenced_fields_by_table_id));
+      for (const ReferencedField& field : referenced_fields) {
+        absl::optional<absl::string_view> value =
+            GetMatchFieldValue(update, field.match_field_id);
+        if (!value.has_value()) continue;
+        const int id =
+            index.ids
+                .try_emplace(
+                    ReferencedValue{field.table, field.match_field, *value},
+                    index.ids.size())
+                .first->second;
+        providers.push_back({id, update_index});
       }
     }
+    CompressRows(index.ids.size(), providers, index.offsets, index.vertices);
   }
 
   // Build dependency graph.
+  std::vector<std::pair<Vertex, Vertex>> edges;
   for (int update_index = 0; update_index < updates.size(); update_index++) {
     const Update& update = updates[update_index];
     const p4::v1::TableEntry& table_entry = update.entity().table_entry();
@@ -183,7 +262,7 @@ absl::StatusOr<Graph> BuildDependencyGraph(const IrP4Info& info,
                                                 ir_reference.match_field(),
                                                 match_field.exact().value()};
             RecordDependenciesForReferencedValue(
-                updates, update_index, referenced_value, indices, graph);
+                updates, update_index, referenced_value, index, edges);
             break;
           }
           case p4::config::v1::MatchField::OPTIONAL: {
@@ -191,7 +270,7 @@ absl::StatusOr<Graph> BuildDependencyGraph(const IrP4Info& info,
                                                 ir_reference.match_field(),
                                                 match_field.optional().value()};
             RecordDependenciesForReferencedValue(
-                updates, update_index, referenced_value, indices, graph);
+                updates, update_index, referenced_value, index, edges);
             break;
           }
           default: {
@@ -213,7 +292,7 @@ absl::StatusOr<Graph> BuildDependencyGraph(const IrP4Info& info,
               << action.action().action_id() << " does not exist.");
         RETURN_IF_ERROR(RecordDependenciesForActionInvocation(
             updates, *ir_action, action.action().params(), update_index,
-            indices, graph));
+            index, edges));
         break;
       }
       case p4::v1::TableAction::kActionProfileActionSet: {
@@ -230,7 +309,7 @@ absl::StatusOr<Graph> BuildDependencyGraph(const IrP4Info& info,
                 << action_profile.action().action_id() << " does not exist.");
           RETURN_IF_ERROR(RecordDependenciesForActionInvocation(
               updates, *ir_action, action_profile.action().params(),
-              update_index, indices, graph));
+              update_index, index, edges));
         }
         break;
       }
@@ -241,6 +320,14 @@ absl::StatusOr<Graph> BuildDependencyGraph(const IrP4Info& info,
       }
     }
   }
+
+  // Edges may be recorded more than once (e.g. when two parameters refer to
+  // the same value). Duplicates count towards the in-degree once per copy and
+  // are removed once per copy, so they do not affect the sequencing.
+  DependencyGraph graph;
+  graph.in_degrees.assign(updates.size(), 0);
+  for (const auto& [source, target] : edges) graph.in_degrees[target]++;
+  CompressRows(updates.size(), edges, graph.offsets, graph.dependents);
   return graph;
 }
 }  // namespace
@@ -299,42 +386,48 @@ absl::StatusOr<std::vector<p4::v1::WriteRequest>> ExtractWriteRequests(
 
 absl::StatusOr<std::vector<std::vector<int>>> SequencePiUpdatesInPlace(
     const IrP4Info& info, absl::Span<const Update> updates) {
-  ASSIGN_OR_RETURN(Graph graph, BuildDependencyGraph(info, updates));
-
-  std::vector<Vertex> roots;
-  for (Vertex vertex : graph.vertex_set()) {
-    if (boost::in_degree(vertex, graph) == 0) {
-      roots.push_back(vertex);
-    }
+  ASSIGN_OR_RETURN(DependencyGraph graph, BuildDependencyGraph(info, updates));
+
+  // Kahn's algorithm. Updates without incoming dependency edges can be batched
+  // together, so each update goes into the batch following the last batch of
+  // the updates it depends on.
+  std::vector<int>& in_degrees = graph.in_degrees;
+  std::vector<int> batch_of_vertex(updates.size(), 0);
+  std::vector<Vertex> ready;
+  for (Vertex vertex = 0; vertex < updates.size(); vertex++) {
+    if (in_degrees[vertex] == 0) ready.push_back(vertex);
   }
-
-  std::vector<std::vector<int>> batches;
-  while (!roots.empty()) {
-    // The roots have no incoming dependency edges, hence can be batched.
-    // Sort them so order of input is retained in the output.
-    std::sort(roots.begin(), roots.end());
-    batches.push_back(roots);
-
-    // Remove edges for old roots and add new roots.
-    std::vector<Vertex> new_roots;
-    for (Vertex root : roots) {
-      for (const auto& edge : graph.out_edge_list(root)) {
-        Vertex target = edge.get_target();
-        // Is this the final `edge` into `target`?
-        if (boost::in_degree(target, graph) == 1) new_roots.push_back(target);
-      }
-      boost::clear_out_edges(root, graph);
+  int num_batches = 0;
+  int num_sequenced = 0;
+  while (!ready.empty()) {
+    const Vertex vertex = ready.back();
+    ready.pop_back();
+    num_sequenced++;
+    const int batch = batch_of_vertex[vertex];
+    num_batches = std::max(num_batches, batch + 1);
+    for (int i = graph.offsets[vertex]; i < graph.offsets[vertex + 1]; i++) {
+      const Vertex dependent = graph.dependents[i];
+      batch_of_vertex[dependent] =
+          std::max(batch_of_vertex[dependent], batch + 1);
+      // Was this the final edge into `dependent`?
+      if (--in_degrees[dependent] == 0) ready.push_back(dependent);
     }
-    roots.swap(new_roots);
   }
 
-  // Upon exiting the loop, no dependencies should remain.
-  if (boost::num_edges(graph) != 0) {
+  // Upon exiting the loop, every update should have been sequenced.
+  if (num_sequenced != updates.size()) {
     return gutil::InvalidArgumentErrorBuilder()
            << "The dependency graph generated during P4 update sequencing is "
               "cyclic. This indicates a cycle in @foreign_key dependencies in "
               "the P4 program.";
   }
+
+  // Fill the batches in input order, so order of input is retained in the
+  // output.
+  std::vector<std::vector<int>> batches(num_batches);
+  for (Vertex vertex = 0; vertex < updates.size(); vertex++) {
+    batches[batch_of_vertex[vertex]].push_back(vertex);
+  }
   return batches;
 }
 
@@ -364,13 +457,13 @@ absl::Status SortTableEntries(const IrP4Info& info,
   return absl::OkStatus();
 }
 
-absl::StatusOr<google::protobuf::RepeatedPtrField<IrTableReference>>
+absl::StatusOr<const google::protobuf::RepeatedPtrField<IrTableReference>*>
 GetOutgoingReferences(const IrP4Info& info, const p4::v1::Entity& entity) {
   if (entity.has_table_entry()) {
     ASSIGN_OR_RETURN(auto* table_def,
                      gutil::FindPtrOrStatus(info.tables_by_id(),
                                             entity.table_entry().table_id()));
-    return table_def->outgoing_references();
+    return &table_def->outgoing_references();
   }
   if (entity.packet_replication_engine_entry().has_multicast_group_entry()) {
     ASSIGN_OR_RETURN(
@@ -379,45 +472,118 @@ GetOutgoingReferences(const IrP4Info& info, const p4::v1::Entity& entity) {
     ASSIGN_OR_RETURN(
         auto* multicast_group_def,
         gutil::FindPtrOrStatus(info.built_in_tables(), multicast_table));
-    return multicast_group_def->outgoing_references();
+    return &multicast_group_def->outgoing_references();
   }
 
   return gutil::InvalidArgumentErrorBuilder()
          << "Unsupported entity type: " << entity.DebugString();
 }
 
-// Returns true if the table of `first` comes before the table of `second` in
-// the dependency order contained in `info`. I.e. if installing `first` before
-// `second` never fails due to dependency issues between them.
-absl::StatusOr<bool> GreaterThanInDependencyOrder(
-    const IrP4Info& info, const p4::v1::Entity& first,
-    const p4::v1::Entity& second) {
-  ASSIGN_OR_RETURN(std::string first_table, EntityToTableName(info, first));
-  ASSIGN_OR_RETURN(std::string second_table, EntityToTableName(info, second));
-  ASSIGN_OR_RETURN(
-      int first_order,
-      gutil::FindOrStatus(info.dependency_rank_by_table_name(), first_table));
-  ASSIGN_OR_RETURN(
-      int second_order,
-      gutil::FindOrStatus(info.dependency_rank_by_table_name(), second_table));
-  return first_order > second_order;
+namespace {
+
+// Looks up the dependency rank of the table of each entity. Ranks are resolved
+// by table id, so that each table name is looked up at most once per sort.
+class DependencyRankCache {
+ public:
+  explicit DependencyRankCache(const IrP4Info& info) : info_(info) {}
+
+  absl::StatusOr<int> GetRank(const p4::v1::Entity& entity) {
+    if (entity.has_table_entry()) {
+      const uint32_t table_id = entity.table_entry().table_id();
+      if (auto it = rank_by_table_id_.find(table_id);
+          it != rank_by_table_id_.end()) {
+        return it->second;
+      }
+      ASSIGN_OR_RETURN(int rank, LookUpRank(entity));
+      rank_by_table_id_[table_id] = rank;
+      return rank;
+    }
+    if (entity.packet_replication_engine_entry().has_multicast_group_entry()) {
+      if (!multicast_group_rank_.has_value()) {
+        ASSIGN_OR_RETURN(multicast_group_rank_, LookUpRank(entity));
+      }
+      return *multicast_group_rank_;
+    }
+    if (entity.packet_replication_engine_entry().has_clone_session_entry()) {
+      if (!clone_session_rank_.has_value()) {
+        ASSIGN_OR_RETURN(clone_session_rank_, LookUpRank(entity));
+      }
+      return *clone_session_rank_;
+    }
+    // Fails with a descriptive error.
+    return LookUpRank(entity);
+  }
+
+ private:
+  absl::StatusOr<int> LookUpRank(const p4::v1::Entity& entity) const {
+    ASSIGN_OR_RETURN(std::string table_name, EntityToTableName(info_, entity));
+    return gutil::FindOrStatus(info_.dependency_rank_by_table_name(),
+                               table_name);
+  }
+
+  const IrP4Info& info_;
+  absl::flat_hash_map<uint32_t, int> rank_by_table_id_;
+  std::optional<int> multicast_group_rank_;
+  std::optional<int> clone_session_rank_;
+};
+
+// Returns the indices of `ranks` stably sorted by decreasing rank, or by
+// increasing rank if `increasing` is true. Ranks take few distinct values, so
+// this is a linear-time counting sort.
+std::vector<int> StableOrderByRank(absl::Span<const int> ranks,
+                                   bool increasing) {
+  if (ranks.empty()) return {};
+  const auto [min_rank, max_rank] = absl::c_minmax_element(ranks);
+  const int min = *min_rank;
+  auto bucket = [&](int rank) {
+    return increasing ? rank - min : *max_rank - rank;
+  };
+
+  // The index of the first position of every bucket.
+  std::vector<int> bucket_starts(*max_rank - min + 2, 0);
+  for (int rank : ranks) ++bucket_starts[bucket(rank) + 1];
+  for (int i = 1; i < bucket_starts.size(); ++i) {
+    bucket_starts[i] += bucket_starts[i - 1];
+  }
+  std::vector<int> order(ranks.size());
+  for (int i = 0; i < ranks.size(); ++i) {
+    order[bucket_starts[bucket(ranks[i])]++] = i;
+  }
+  return order;
+}
+
+// Rearranges a sequence such that its i-th element is the `order[i]`-th
+// element of the input, by following the cycles of the permutation with
+// `swap`. Each element is swapped at most once.
+void ApplyPermutation(absl::Span<const int> order,
+                      absl::FunctionRef<void(int, int)> swap) {
+  std::vector<bool> placed(order.size(), false);
+  for (int start = 0; start < order.size(); ++start) {
+    if (placed[start]) continue;
+    int i = start;
+    while (order[i] != start) {
+      swap(i, order[i]);
+      placed[i] = true;
+      i = order[i];
+    }
+    placed[i] = true;
+  }
 }
 
+}  // namespace
+
 absl::Status StableSortEntities(const IrP4Info& info,
                                 std::vector<p4::v1::Entity>& entities) {
-  absl::c_stable_sort(
-      entities, [&](const p4::v1::Entity& a, const p4::v1::Entity& b) {
-        auto b_may_depend_on_a = GreaterThanInDependencyOrder(info, a, b);
-        if (!b_may_depend_on_a.ok()) {
-          LOG(ERROR) << "Failed to compare entities with error: "
-                     << b_may_depend_on_a.status() << "\nEntities were:\n"
-                     << a.DebugString() << "\n\n   and   \n\n"
-                     << b.DebugString();
-          return false;
-        }
-        return *b_may_depend_on_a;
-      });
-
+  DependencyRankCache rank_cache(info);
+  std::vector<int> ranks;
+  ranks.reserve(entities.size());
+  for (const p4::v1::Entity& entity : entities) {
+    ASSIGN_OR_RETURN(int rank, rank_cache.GetRank(entity),
+                     _ << "while sorting entity: " << entity.DebugString());
+    ranks.push_back(rank);
+  }
+  ApplyPermutation(StableOrderByRank(ranks, /*increasing=*/false),
+                   [&](int i, int j) { entities[i].Swap(&entities[j]); });
   return absl::OkStatus();
 }
 
@@ -425,137 +591,242 @@ absl::Status StableSortUpdates(
     const IrP4Info& info,
     google::protobuf::RepeatedPtrField<p4::v1::Update>& updates,
     bool reverse_ordering) {
-  std::stable_sort(
-      updates.begin(), updates.end(),
-      [&](const p4::v1::Update& a, const p4::v1::Update& b) {
-        auto b_may_depend_on_a =
-            GreaterThanInDependencyOrder(info, a.entity(), b.entity());
-        if (!b_may_depend_on_a.ok()) {
-          LOG(ERROR) << "Failed to compare updates with error: "
-                     << b_may_depend_on_a.status() << "\nUpdates were:\n"
-                     << a.DebugString() << "\n\n   and   \n\n"
-                     << b.DebugString();
-          return false;
-        }
-        return reverse_ordering ? !*b_may_depend_on_a : *b_may_depend_on_a;
-      });
-
+  DependencyRankCache rank_cache(info);
+  std::vector<int> ranks;
+  ranks.reserve(updates.size());
+  for (const p4::v1::Update& update : updates) {
+    ASSIGN_OR_RETURN(int rank, rank_cache.GetRank(update.entity()),
+                     _ << "while sorting update: " << update.DebugString());
+    ranks.push_back(rank);
+  }
+  // Swapping elements of a RepeatedPtrField only swaps pointers.
+  ApplyPermutation(StableOrderByRank(ranks, /*increasing=*/reverse_ordering),
+                   [&](int i, int j) { updates.SwapElements(i, j); });
   return absl::OkStatus();
 }
 
+namespace {
+
+// A ConcreteTableReference together with its hash. The hash is computed once,
+// possibly on a worker thread, rather than on every lookup and rehash.
+struct HashedReference {
+  explicit HashedReference(ConcreteTableReference reference)
+      : reference(std::move(reference)),
+        hash(absl::Hash<ConcreteTableReference>()(this->reference)) {}
+
+  ConcreteTableReference reference;
+  size_t hash;
+};
+
+struct HashedReferenceHash {
+  size_t operator()(const HashedReference& reference) const {
+    return reference.hash;
+  }
+};
+
+struct HashedReferenceEq {
+  bool operator()(const HashedReference& lhs,
+                  const HashedReference& rhs) const {
+    return lhs.hash == rhs.hash && lhs.reference == rhs.reference;
+  }
+};
+
+// Maps each reference to the entities it would make reachable.
+using ReferenceIndex =
+    absl::flat_hash_map<HashedReference, std::vector<int>, HashedReferenceHash,
+                        HashedReferenceEq>;
+
+// Calls `work(i)` for every i in [0, count), spread over up to `num_threads`
+// threads, including the calling thread.
+void ParallelFor(int count, int num_threads,
+                 absl::FunctionRef<void(int)> work) {
+  num_threads = std::min(num_threads, count);
+  if (num_threads <= 1) {
+    for (int i = 0; i < count; i++) work(i);
+    return;
+  }
+  std::atomic<int> next_index = 0;
+  auto run = [&] {
+    for (int i = next_index++; i < count; i = next_index++) work(i);
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (int thread = 1; thread < num_threads; thread++) {
+    threads.emplace_back(run);
+  }
+  run();
+  for (std::thread& thread : threads) thread.join();
+}
+
+// Moves the references in `references` to the end of `result`.
+void AppendHashedReferences(
+    absl::flat_hash_set<ConcreteTableReference>& references,
+    std::vector<HashedReference>& result) {
+  for (auto it = references.begin(); it != references.end();) {
+    result.emplace_back(std::move(references.extract(it++).value()));
+  }
+}
+
+// Returns the references through which `entity` could be reached from entities
+// of the tables in `incoming_references`.
+absl::StatusOr<std::vector<HashedReference>> IncomingReferences(
+    const google::protobuf::RepeatedPtrField<IrTableReference>&
+        incoming_references,
+    const p4::v1::Entity& entity) {
+  std::vector<HashedReference> result;
+  for (const auto& reference_info : incoming_references) {
+    ASSIGN_OR_RETURN(
+        absl::flat_hash_set<ConcreteTableReference> references,
+        PossibleIncomingConcreteTableReferences(reference_info, entity));
+    AppendHashedReferences(references, result);
+  }
+  return result;
+}
+
+// Returns the references from `entity` to other entities.
+absl::StatusOr<std::vector<HashedReference>> OutgoingReferences(
+    const IrP4Info& ir_p4info, const p4::v1::Entity& entity) {
+  ASSIGN_OR_RETURN(const auto* outgoing_references,
+                   GetOutgoingReferences(ir_p4info, entity));
+  std::vector<HashedReference> result;
+  for (const auto& reference_info : *outgoing_references) {
+    ASSIGN_OR_RETURN(absl::flat_hash_set<ConcreteTableReference> references,
+                     OutgoingConcreteTableReferences(reference_info, entity));
+    AppendHashedReferences(references, result);
+  }
+  return result;
+}
+
+}  // namespace
+
 absl::StatusOr<std::vector<p4::v1::Entity>> GetEntitiesUnreachableFromRoots(
     absl::Span<const p4::v1::Entity> entities,
     absl::FunctionRef<absl::StatusOr<bool>(const p4::v1::Entity&)>
         is_root_entity,
-    const IrP4Info& ir_p4info) {
-  absl::flat_hash_map<ConcreteTableReference, std::vector<int>>
-      potentially_reachable_entries;
-  absl::flat_hash_set<int> unreachable_indices;
+    const IrP4Info& ir_p4info, int num_threads) {
+  // Starts out with the entities that can never be reachable, since nothing
+  // refers to their table.
+  std::vector<bool> unreachable(entities.size(), false);
+  // Entities that are reachable if some entity refers to them, together with
+  // the incoming references of their table.
+  std::vector<std::pair<int, const google::protobuf::RepeatedPtrField<
+                                 IrTableReference>*>>
+      potentially_reachable;
   // frontier_indices contains indices for entities that are reachable (either
   // reached by other entities, or are themselves roots) and could potentially
   // refer to other entities.
-  std::queue<int> frontier_indices;
-
-  for (int i = 0; i < entities.size(); i++) {
-    const p4::v1::Entity& entity = entities[i];
-
-    if (!entity.has_table_entry() &&
-        !entity.packet_replication_engine_entry().has_multicast_group_entry()) {
-      return absl::UnimplementedError(
-          absl::StrCat("Garbage collection only supports entities of type "
-                       "table entry or multicast group entry.",
-                       entity.DebugString()));
-    }
-
-    ASSIGN_OR_RETURN(bool is_root_entity, is_root_entity(entity));
-    if (is_root_entity) {
-      if (entity.has_packet_replication_engine_entry()) {
-        continue;
+  std::vector<int> frontier_indices;
+
+  // Classifies every entity, stopping at the first invalid one. Its error is
+  // returned after those of earlier entities, like in a sequential scan.
+  absl::Status classification_status = absl::OkStatus();
+  for (int i = 0; i < entities.size() && classification_status.ok(); i++) {
+    classification_status = [&]() -> absl::Status {
+      const p4::v1::Entity& entity = entities[i];
+
+      if (!entity.has_table_entry() &&
+          !entity.packet_replication_engine_entry()
+               .has_multicast_group_entry()) {
+        return absl::UnimplementedError(
+            absl::StrCat("Garbage collection only supports entities of type "
+                         "table entry or multicast group entry.",
+                         entity.DebugString()));
       }
-      frontier_indices.push(i);
-      continue;
-    }
-    if (!entity.has_table_entry()) {
-      return absl::UnimplementedError(
-          absl::StrCat("Only entities of type table_entry can be garbage "
-                       "collected. Entity: ",
-                       entity.DebugString()));
-    }
-    const p4::v1::TableEntry& table_entry = entity.table_entry();
-    // If the table that entries[i] belongs to is referred to, entries[i] is
-    // potentially reachable. Else, entries[i] is not reachable.
-    ASSIGN_OR_RETURN(auto* table_def,
-                     gutil::FindPtrOrStatus(ir_p4info.tables_by_id(),
-                                            table_entry.table_id()));
-    if (table_def->incoming_references().empty()) {
-      LOG(WARNING) << "Found non-root entry that could never be reachable. "
-                      "This probably indicates some mistake in is_root_entry "
-                      "or the ir_p4info. Found entry: "
-                   << table_entry.DebugString();
-      unreachable_indices.insert(i);
-    } else {
-      for (const auto& reference_info : table_def->incoming_references()) {
-        ASSIGN_OR_RETURN(
-            absl::flat_hash_set<ConcreteTableReference> reference_entries,
-            PossibleIncomingConcreteTableReferences(reference_info, entity));
-        for (const ConcreteTableReference& reference_entry :
-             reference_entries) {
-          potentially_reachable_entries[reference_entry].push_back(i);
+
+      ASSIGN_OR_RETURN(bool is_root_entity, is_root_entity(entity));
+      if (is_root_entity) {
+        if (!entity.has_packet_replication_engine_entry()) {
+          frontier_indices.push_back(i);
         }
+        return absl::OkStatus();
       }
-    }
+      if (!entity.has_table_entry()) {
+        return absl::UnimplementedError(
+            absl::StrCat("Only entities of type table_entry can be garbage "
+                         "collected. Entity: ",
+                         entity.DebugString()));
+      }
+      const p4::v1::TableEntry& table_entry = entity.table_entry();
+      // If the table that entries[i] belongs to is referred to, entries[i] is
+      // potentially reachable. Else, entries[i] is not reachable.
+      ASSIGN_OR_RETURN(auto* table_def,
+                       gutil::FindPtrOrStatus(ir_p4info.tables_by_id(),
+                                              table_entry.table_id()));
+      if (table_def->incoming_references().empty()) {
+        LOG(WARNING) << "Found non-root entry that could never be reachable. "
+                        "This probably indicates some mistake in "
+                        "is_root_entry or the ir_p4info. Found entry: "
+                     << table_entry.DebugString();
+        unreachable[i] = true;
+      } else {
+        potentially_reachable.push_back(
+            {i, &table_def->incoming_references()});
+      }
+      return absl::OkStatus();
+    }();
   }
 
-  // Expand frontier of reachable entries.
-  // Pop an entry off the frontier and if that entry refers to some entries in
-  // potentially_reachable_entries, move them from
-  // `potentially_reachable_entries` to `frontier_indices`.
-  absl::flat_hash_set<int> reached_indices;
+  // Computing concrete references dominates the cost on large states, so it is
+  // spread over threads. Results are merged in entity order.
+  std::vector<absl::StatusOr<std::vector<HashedReference>>> incoming(
+      potentially_reachable.size());
+  ParallelFor(potentially_reachable.size(), num_threads, [&](int k) {
+    const auto& [index, incoming_references] = potentially_reachable[k];
+    incoming[k] = IncomingReferences(*incoming_references, entities[index]);
+  });
+  ReferenceIndex potentially_reachable_entries;
+  for (int k = 0; k < potentially_reachable.size(); k++) {
+    RETURN_IF_ERROR(incoming[k].status());
+    for (HashedReference& reference : *incoming[k]) {
+      potentially_reachable_entries[std::move(reference)].push_back(
+          potentially_reachable[k].first);
+    }
+  }
+  incoming.clear();
+  RETURN_IF_ERROR(classification_status);
+
+  // Expand the frontier of reachable entries one level at a time. The outgoing
+  // references of a level are computed in parallel. If an entry of the level
+  // refers to some entries in `potentially_reachable_entries`, they are moved
+  // from `potentially_reachable_entries` to the next level.
+  std::vector<bool> reached(entities.size(), false);
+  for (int i : frontier_indices) reached[i] = true;
   while (!frontier_indices.empty()) {
-    const p4::v1::Entity& frontier_entity = entities[frontier_indices.front()];
-    ASSIGN_OR_RETURN(auto outgoing_references,
-                     GetOutgoingReferences(ir_p4info, frontier_entity));
-    reached_indices.insert(frontier_indices.front());
-    frontier_indices.pop();
-    for (const auto& reference_info : outgoing_references) {
-      ASSIGN_OR_RETURN(
-          absl::flat_hash_set<ConcreteTableReference> reference_entries,
-          OutgoingConcreteTableReferences(reference_info, frontier_entity));
-      for (const auto& reference_entry : reference_entries) {
-        if (auto it = potentially_reachable_entries.find(reference_entry);
-            it != potentially_reachable_entries.end()) {
-          absl::c_for_each(it->second,
-                           [&frontier_indices, &reached_indices](int i) {
-                             if (!reached_indices.contains(i)) {
-                               frontier_indices.push(i);
-                             }
-                           });
-          potentially_reachable_entries.erase(it);
+    std::vector<absl::StatusOr<std::vector<HashedReference>>> outgoing(
+        frontier_indices.size());
+    ParallelFor(frontier_indices.size(), num_threads, [&](int k) {
+      outgoing[k] =
+          OutgoingReferences(ir_p4info, entities[frontier_indices[k]]);
+    });
+    std::vector<int> next_frontier_indices;
+    for (const auto& references : outgoing) {
+      RETURN_IF_ERROR(references.status());
+      for (const HashedReference& reference : *references) {
+        auto it = potentially_reachable_entries.find(reference);
+        if (it == potentially_reachable_entries.end()) continue;
+        for (int i : it->second) {
+          if (!reached[i]) {
+            reached[i] = true;
+            next_frontier_indices.push_back(i);
+          }
         }
+        potentially_reachable_entries.erase(it);
       }
     }
+    frontier_indices.swap(next_frontier_indices);
   }
+
   // By the end of frontier expansion all remaining potentially reachable
   // entries are not reachable.
   for (const auto& [unused, indices] : potentially_reachable_entries) {
-    absl::c_for_each(indices, [&unreachable_indices, &reached_indices](int i) {
-      if (!reached_indices.contains(i)) {
-        unreachable_indices.insert(i);
-      }
-    });
+    for (int i : indices) {
+      if (!reached[i]) unreachable[i] = true;
+    }
   }
-  std::vector<p4::v1::Entity> unreachable_entities;
-  unreachable_entities.reserve(unreachable_indices.size());
-
-  // TODO: verios - remove sort once tests are updated to handle
-  // non-determinism.
-  std::vector<int> sorted_unreachable_indices(unreachable_indices.begin(),
-                                              unreachable_indices.end());
-  std::sort(sorted_unreachable_indices.begin(),
-            sorted_unreachable_indices.end());
   // Returns unreachable entities in the order of their indices.
-  for (int i : sorted_unreachable_indices) {
-    unreachable_entities.push_back(entities[i]);
+  std::vector<p4::v1::Entity> unreachable_entities;
+  for (int i = 0; i < entities.size(); i++) {
+    if (unreachable[i]) unreachable_entities.push_back(entities[i]);
   }
   return unreachable_entities;
 }
@@ -571,8 +842,7 @@ absl::StatusOr<std::vector<p4::v1::Entity>> OldGetEntitiesUnreachableFromRoots(
   // `frontier_indices` stores indices for entries that could potentially refer
   // to other entries, but whose references have not been examined yet.
   std::queue<int> frontier_indices;
-  absl::flat_hash_map<ReferenceRelationKey, ReferenceRelation>
-      referred_relations = CreateReferenceRelations(ir_p4info);
+  const CompiledReferenceRelations reference_relations(ir_p4info);
 
   for (int i = 0; i < entities.size(); i++) {
     const p4::v1::Entity& entity = entities[i];
@@ -594,11 +864,10 @@ absl::StatusOr<std::vector<p4::v1::Entity>> OldGetEntitiesUnreachableFromRoots(
     const p4::v1::TableEntry& table_entry = entity.table_entry();
     // If the table that entries[i] belongs to is referred to, entries[i] is
     // potentially reachable. Else, entries[i] is not reachable.
-    if (referred_relations.contains(ReferenceRelationKey{
-            .referred_table_id = table_entry.table_id()})) {
-      ASSIGN_OR_RETURN(ReferredTableEntry referrable_table_entry,
-                       CreateReferrableTableEntry(ir_p4info, referred_relations,
-                                                  table_entry));
+    if (reference_relations.IsReferrable(table_entry.table_id())) {
+      ASSIGN_OR_RETURN(
+          ReferredTableEntry referrable_table_entry,
+          reference_relations.CreateReferrableTableEntry(table_entry));
       potentially_reachable_entries[referrable_table_entry].push_back(i);
     } else {
       LOG(WARNING) << "Found non-root entry that could never be reachable. "
@@ -619,7 +888,7 @@ absl::StatusOr<std::vector<p4::v1::Entity>> OldGetEntitiesUnreachableFromRoots(
     frontier_indices.pop();
     ASSIGN_OR_RETURN(
         std::vector<ReferredTableEntry> entries_referred_to_by_frontier_entry,
-        EntriesReferredToByTableEntry(ir_p4info, frontier_entry));
+        reference_relations.EntriesReferredToByTableEntry(frontier_entry));
     for (const ReferredTableEntry& referred_to_entry :
          entries_referred_to_by_frontier_entry) {
       if (auto it = potentially_reachable_entries.find(referred_to_entry);
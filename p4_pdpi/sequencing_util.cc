@@ -3,9 +3,12 @@
 #include <cstdint>
 #include <iterator>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -157,6 +160,27 @@ absl::StatusOr<std::vector<ReferredTableEntry>> EntriesReferredToByAction(
   }
 }
 
+// Adds a field with `value` to the entry of `referred_entries` in
+// `referred_table_id`, creating the entry if there is none yet.
+void AddReferredField(uint32_t referred_table_id, uint32_t match_field_id,
+                      const std::string& value,
+                      std::vector<ReferredTableEntry>& referred_entries) {
+  // Entries usually refer to few tables, so a linear search beats a map.
+  auto it = absl::c_find_if(referred_entries,
+                            [&](const ReferredTableEntry& entry) {
+                              return entry.table_id == referred_table_id;
+                            });
+  if (it == referred_entries.end()) {
+    referred_entries.push_back(
+        ReferredTableEntry{.table_id = referred_table_id});
+    it = std::prev(referred_entries.end());
+  }
+  it->referred_fields.insert(ReferredField{
+      .match_field_id = match_field_id,
+      .value = value,
+  });
+}
+
 }  // namespace
 
 absl::flat_hash_map<ReferenceRelationKey, ReferenceRelation>
@@ -222,4 +246,149 @@ absl::StatusOr<ReferredTableEntry> CreateReferrableTableEntry(
   return referrable_table_entry;
 }
 
+CompiledReferenceRelations::CompiledReferenceRelations(
+    const IrP4Info& ir_p4info) {
+  for (const auto& [table_id, table] : ir_p4info.tables_by_id()) {
+    ReferenceTargetsById& targets = match_field_targets_by_table_id_[table_id];
+    for (const auto& [field_id, field] : table.match_fields_by_id()) {
+      std::vector<ReferenceTarget>& field_targets = targets[field_id];
+      for (const auto& ir_reference : field.references()) {
+        field_targets.push_back({
+            .table_id = ir_reference.table_id(),
+            .match_field_id = ir_reference.match_field_id(),
+        });
+      }
+    }
+  }
+  for (const auto& [action_id, action] : ir_p4info.actions_by_id()) {
+    ReferenceTargetsById& targets = param_targets_by_action_id_[action_id];
+    for (const auto& [param_id, param] : action.params_by_id()) {
+      std::vector<ReferenceTarget>& param_targets = targets[param_id];
+      for (const auto& ir_reference : param.references()) {
+        param_targets.push_back({
+            .table_id = ir_reference.table_id(),
+            .match_field_id = ir_reference.match_field_id(),
+        });
+      }
+    }
+  }
+  for (const IrMatchFieldReference& ir_reference : ir_p4info.references()) {
+    referrable_fields_by_table_id_[ir_reference.table_id()].insert(
+        ir_reference.match_field_id());
+  }
+}
+
+absl::Status CompiledReferenceRelations::AddEntriesReferredToByAction(
+    const p4::v1::Action& action,
+    std::vector<ReferredTableEntry>& referred_entries) const {
+  // Referred entries are only merged across the parameters of one action.
+  std::vector<ReferredTableEntry> referred_entries_by_action;
+  ASSIGN_OR_RETURN(
+      const ReferenceTargetsById* targets_by_param_id,
+      gutil::FindPtrOrStatus(param_targets_by_action_id_, action.action_id()),
+      _ << "Failed to extract action definition when creating entries "
+           "referred by action: Action with ID "
+        << action.action_id() << " does not exist in IrP4Info.");
+  for (const p4::v1::Action_Param& param : action.params()) {
+    ASSIGN_OR_RETURN(
+        const std::vector<ReferenceTarget>* targets,
+        gutil::FindPtrOrStatus(*targets_by_param_id, param.param_id()),
+        _ << "Failed to extract action definition when creating entries "
+             "referred by action: Action param with ID "
+          << param.param_id() << " does not exist.");
+    for (const ReferenceTarget& target : *targets) {
+      AddReferredField(target.table_id, target.match_field_id, param.value(),
+                       referred_entries_by_action);
+    }
+  }
+  referred_entries.insert(
+      referred_entries.end(),
+      std::make_move_iterator(referred_entries_by_action.begin()),
+      std::make_move_iterator(referred_entries_by_action.end()));
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<ReferredTableEntry>>
+CompiledReferenceRelations::EntriesReferredToByTableEntry(
+    const p4::v1::TableEntry& table_entry) const {
+  ASSIGN_OR_RETURN(const ReferenceTargetsById* targets_by_field_id,
+                   gutil::FindPtrOrStatus(match_field_targets_by_table_id_,
+                                          table_entry.table_id()));
+  std::vector<ReferredTableEntry> referred_entries;
+  for (const p4::v1::FieldMatch& field_match : table_entry.match()) {
+    ASSIGN_OR_RETURN(
+        const std::vector<ReferenceTarget>* targets,
+        gutil::FindPtrOrStatus(*targets_by_field_id, field_match.field_id()));
+    // Only Exact or Optional matches are used to refer to entries.
+    const std::string* value = nullptr;
+    if (field_match.has_exact()) {
+      value = &field_match.exact().value();
+    } else if (field_match.has_optional()) {
+      value = &field_match.optional().value();
+    } else {
+      continue;
+    }
+    for (const ReferenceTarget& target : *targets) {
+      AddReferredField(target.table_id, target.match_field_id, *value,
+                       referred_entries);
+    }
+  }
+
+  const p4::v1::TableAction& action = table_entry.action();
+  switch (action.type_case()) {
+    case p4::v1::TableAction::kAction:
+      RETURN_IF_ERROR(
+          AddEntriesReferredToByAction(action.action(), referred_entries));
+      break;
+    case p4::v1::TableAction::kActionProfileActionSet:
+      for (const auto& action_profile_action :
+           action.action_profile_action_set().action_profile_actions()) {
+        RETURN_IF_ERROR(AddEntriesReferredToByAction(
+            action_profile_action.action(), referred_entries));
+      }
+      break;
+    default:
+      return absl::UnimplementedError(absl::StrCat(
+          "Sequencing can only handle action and action profile set, but got:",
+          action.type_case()));
+  }
+  return referred_entries;
+}
+
+absl::StatusOr<std::vector<std::vector<ReferredTableEntry>>>
+CompiledReferenceRelations::EntriesReferredToByTableEntries(
+    absl::Span<const p4::v1::TableEntry> table_entries) const {
+  std::vector<std::vector<ReferredTableEntry>> referred_entries;
+  referred_entries.reserve(table_entries.size());
+  for (const p4::v1::TableEntry& table_entry : table_entries) {
+    ASSIGN_OR_RETURN(referred_entries.emplace_back(),
+                     EntriesReferredToByTableEntry(table_entry));
+  }
+  return referred_entries;
+}
+
+absl::StatusOr<ReferredTableEntry>
+CompiledReferenceRelations::CreateReferrableTableEntry(
+    const p4::v1::TableEntry& table_entry) const {
+  ASSIGN_OR_RETURN(const absl::flat_hash_set<uint32_t>* referrable_fields,
+                   gutil::FindPtrOrStatus(referrable_fields_by_table_id_,
+                                          table_entry.table_id()),
+                   _ << " while trying to look up the referrable fields of "
+                        "table with ID "
+                     << table_entry.table_id());
+  ReferredTableEntry referrable_table_entry = {
+      .table_id = table_entry.table_id(),
+  };
+  for (const p4::v1::FieldMatch& field_match : table_entry.match()) {
+    if (!referrable_fields->contains(field_match.field_id())) continue;
+    ASSIGN_OR_RETURN(std::string value,
+                     GetExactOrOptionalMatchFieldValue(field_match));
+    referrable_table_entry.referred_fields.insert(ReferredField{
+        .match_field_id = field_match.field_id(),
+        .value = std::move(value),
+    });
+  }
+  return referrable_table_entry;
+}
+
 }  // namespace pdpi
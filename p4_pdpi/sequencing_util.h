@@ -7,9 +7,11 @@
 
 #include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/types/span.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.pb.h"
 
@@ -146,6 +148,63 @@ absl::StatusOr<ReferredTableEntry> CreateReferrableTableEntry(
         reference_relations,
     const p4::v1::TableEntry& table_entry);
 
+// The reference relations of an IrP4Info, compiled once into plans indexed by
+// table, match field, action and parameter ID. Equivalent to the functions
+// above, which walk the IrP4Info's reference annotations for every entry, but
+// meant for callers that look up the references of many entries.
+//
+// Does not keep a reference to the IrP4Info.
+class CompiledReferenceRelations {
+ public:
+  explicit CompiledReferenceRelations(const IrP4Info& ir_p4info);
+
+  // Same as `EntriesReferredToByTableEntry(ir_p4info, table_entry)`.
+  absl::StatusOr<std::vector<ReferredTableEntry>> EntriesReferredToByTableEntry(
+      const p4::v1::TableEntry& table_entry) const;
+
+  // Returns the entries referred to by each of `table_entries`, in the same
+  // order. Fails if computing the referred entries of any entry fails.
+  absl::StatusOr<std::vector<std::vector<ReferredTableEntry>>>
+  EntriesReferredToByTableEntries(
+      absl::Span<const p4::v1::TableEntry> table_entries) const;
+
+  // Returns true if entries of the table with `table_id` can be referred to,
+  // i.e. if `CreateReferrableTableEntry` succeeds for well-formed entries.
+  bool IsReferrable(uint32_t table_id) const {
+    return referrable_fields_by_table_id_.contains(table_id);
+  }
+
+  // Same as `CreateReferrableTableEntry(ir_p4info, reference_relations,
+  // table_entry)` with the relations of `CreateReferenceRelations(ir_p4info)`.
+  absl::StatusOr<ReferredTableEntry> CreateReferrableTableEntry(
+      const p4::v1::TableEntry& table_entry) const;
+
+ private:
+  // A match field that a match field or action parameter refers to.
+  struct ReferenceTarget {
+    uint32_t table_id;
+    uint32_t match_field_id;
+  };
+  // The references of each match field of a table, or of each parameter of an
+  // action, by ID. Fields without references map to an empty vector, so that
+  // unknown IDs can be told apart.
+  using ReferenceTargetsById =
+      absl::flat_hash_map<uint32_t, std::vector<ReferenceTarget>>;
+
+  // Adds the entries referred to by the parameters of `action` to
+  // `referred_entries`.
+  absl::Status AddEntriesReferredToByAction(
+      const p4::v1::Action& action,
+      std::vector<ReferredTableEntry>& referred_entries) const;
+
+  absl::flat_hash_map<uint32_t, ReferenceTargetsById>
+      match_field_targets_by_table_id_;
+  absl::flat_hash_map<uint32_t, ReferenceTargetsById>
+      param_targets_by_action_id_;
+  absl::flat_hash_map<uint32_t, absl::flat_hash_set<uint32_t>>
+      referrable_fields_by_table_id_;
+};
+
 }  // namespace pdpi
 
 #endif  // PINS_P4_PDPI_SEQUENCING_UTIL_H_
@@ -2,12 +2,27 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/hash/hash_testing.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/testing/test_p4info.h"
+
 namespace pdpi {
 namespace {
 
+using ::gutil::StatusIs;
+using ::testing::ElementsAreArray;
+
 // Tests to verify different ReferredFields are not equal and have different
 // hash values.
 // The hash value check is provided by VerifyTypeImplementsAbslHashCorrectly
@@ -247,5 +262,118 @@ TEST(ReferredFieldEntryTest, EqualityAndHashingTest) {
   }));
 }
 
+// Returns one entry per table and entry action of `info`, whose exact and
+// optional match fields and action parameters have distinct values.
+std::vector<p4::v1::TableEntry> EntryPerTableAndAction(const IrP4Info& info) {
+  std::vector<p4::v1::TableEntry> entries;
+  int value = 0;
+  auto next_value = [&] { return std::string(1, static_cast<char>(++value)); };
+  for (const auto& [table_id, table] : info.tables_by_id()) {
+    for (const IrActionReference& action : table.entry_actions()) {
+      p4::v1::TableEntry& entry = entries.emplace_back();
+      entry.set_table_id(table_id);
+      for (const auto& [field_id, field] : table.match_fields_by_id()) {
+        switch (field.match_field().match_type()) {
+          case p4::config::v1::MatchField::EXACT: {
+            p4::v1::FieldMatch& match = *entry.add_match();
+            match.set_field_id(field_id);
+            match.mutable_exact()->set_value(next_value());
+            break;
+          }
+          case p4::config::v1::MatchField::OPTIONAL: {
+            p4::v1::FieldMatch& match = *entry.add_match();
+            match.set_field_id(field_id);
+            match.mutable_optional()->set_value(next_value());
+            break;
+          }
+          default:
+            break;
+        }
+      }
+      p4::v1::Action& pi_action = *entry.mutable_action()->mutable_action();
+      pi_action.set_action_id(action.action().preamble().id());
+      for (const auto& [param_id, param] : action.action().params_by_id()) {
+        p4::v1::Action::Param& pi_param = *pi_action.add_params();
+        pi_param.set_param_id(param_id);
+        pi_param.set_value(next_value());
+      }
+    }
+  }
+  return entries;
+}
+
+// Returns `referred_entries` sorted, or nothing if it is an error.
+std::vector<ReferredTableEntry> SortedReferredEntries(
+    absl::StatusOr<std::vector<ReferredTableEntry>> referred_entries) {
+  EXPECT_OK(referred_entries.status());
+  if (!referred_entries.ok()) return {};
+  absl::c_sort(*referred_entries);
+  return *referred_entries;
+}
+
+TEST(CompiledReferenceRelationsTest, AgreesWithUncompiledFunctions) {
+  const IrP4Info& info = GetTestIrP4Info();
+  const CompiledReferenceRelations compiled(info);
+  const absl::flat_hash_map<ReferenceRelationKey, ReferenceRelation>
+      relations = CreateReferenceRelations(info);
+  const std::vector<p4::v1::TableEntry> entries = EntryPerTableAndAction(info);
+  ASSERT_FALSE(entries.empty());
+
+  int num_referring_entries = 0;
+  for (const p4::v1::TableEntry& entry : entries) {
+    SCOPED_TRACE(entry.DebugString());
+    const std::vector<ReferredTableEntry> expected =
+        SortedReferredEntries(EntriesReferredToByTableEntry(info, entry));
+    EXPECT_THAT(
+        SortedReferredEntries(compiled.EntriesReferredToByTableEntry(entry)),
+        ElementsAreArray(expected));
+    if (!expected.empty()) ++num_referring_entries;
+
+    const bool referrable = relations.contains(
+        ReferenceRelationKey{.referred_table_id = entry.table_id()});
+    EXPECT_EQ(compiled.IsReferrable(entry.table_id()), referrable);
+    if (referrable) {
+      ASSERT_OK_AND_ASSIGN(ReferredTableEntry expected_referrable,
+                           CreateReferrableTableEntry(info, relations, entry));
+      EXPECT_THAT(compiled.CreateReferrableTableEntry(entry),
+                  gutil::IsOkAndHolds(expected_referrable));
+    }
+  }
+  // Otherwise the test P4Info no longer exercises references.
+  EXPECT_GT(num_referring_entries, 0);
+}
+
+TEST(CompiledReferenceRelationsTest, BatchReturnsReferredEntriesInOrder) {
+  const IrP4Info& info = GetTestIrP4Info();
+  const CompiledReferenceRelations compiled(info);
+  const std::vector<p4::v1::TableEntry> entries = EntryPerTableAndAction(info);
+
+  ASSERT_OK_AND_ASSIGN(std::vector<std::vector<ReferredTableEntry>> batch,
+                       compiled.EntriesReferredToByTableEntries(entries));
+  ASSERT_EQ(batch.size(), entries.size());
+  for (int i = 0; i < entries.size(); ++i) {
+    absl::c_sort(batch[i]);
+    EXPECT_THAT(batch[i], ElementsAreArray(SortedReferredEntries(
+                              compiled.EntriesReferredToByTableEntry(
+                                  entries[i]))));
+  }
+}
+
+TEST(CompiledReferenceRelationsTest, RejectsUnknownTablesAndActions) {
+  const CompiledReferenceRelations compiled(GetTestIrP4Info());
+  p4::v1::TableEntry unknown_table;
+  unknown_table.set_table_id(0);
+  EXPECT_THAT(compiled.EntriesReferredToByTableEntry(unknown_table),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(compiled.EntriesReferredToByTableEntries({unknown_table}),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_FALSE(compiled.IsReferrable(0));
+
+  p4::v1::TableEntry unknown_action =
+      EntryPerTableAndAction(GetTestIrP4Info()).front();
+  unknown_action.mutable_action()->mutable_action()->set_action_id(0);
+  EXPECT_FALSE(compiled.EntriesReferredToByTableEntry(unknown_action).ok());
+}
+
 }  // namespace
 }  // namespace pdpi
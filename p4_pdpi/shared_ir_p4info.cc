@@ -0,0 +1,43 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/shared_ir_p4info.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "gutil/status.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/ir_p4info_cache.h"
+
+namespace pdpi {
+
+absl::StatusOr<SharedIrP4Info> SharedIrP4Info::Create(
+    const p4::config::v1::P4Info& p4info) {
+  ASSIGN_OR_RETURN(std::shared_ptr<const IrP4Info> info,
+                   GetOrCreateIrP4Info(p4info));
+  return SharedIrP4Info(std::move(info));
+}
+
+SharedIrP4Info::SharedIrP4Info(IrP4Info info, int action_cache_capacity)
+    : SharedIrP4Info(std::make_shared<const IrP4Info>(std::move(info)),
+                     action_cache_capacity) {}
+
+SharedIrP4Info::SharedIrP4Info(std::shared_ptr<const IrP4Info> info,
+                               int action_cache_capacity)
+    : state_(std::make_shared<const State>(std::move(info),
+                                           action_cache_capacity)) {}
+
+}  // namespace pdpi
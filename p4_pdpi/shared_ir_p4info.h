@@ -0,0 +1,73 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4_PDPI_SHARED_IR_P4INFO_H_
+#define PINS_P4_PDPI_SHARED_IR_P4INFO_H_
+
+#include <memory>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+// An immutable IrP4Info together with its CompiledIrP4Info, shared by all
+// copies of the handle. An IrP4Info keeps every definition by ID and by name,
+// so copying one is expensive; copying a SharedIrP4Info copies a pointer.
+//
+// Lookups by ID or name should go through `compiled()`, which resolves both
+// to the definitions stored by ID.
+//
+// Thread-safe, since the IrP4Info can no longer be modified.
+class SharedIrP4Info {
+ public:
+  // Returns the IrP4Info for `p4info` from the process-wide IrP4Info cache (see
+  // `GetOrCreateIrP4Info`), so handles for identical P4Infos share storage.
+  static absl::StatusOr<SharedIrP4Info> Create(
+      const p4::config::v1::P4Info& p4info);
+
+  // Translations through `compiled()` memoize up to `action_cache_capacity`
+  // actions and action sets (see ActionTranslationCache).
+  explicit SharedIrP4Info(IrP4Info info, int action_cache_capacity = 0);
+  explicit SharedIrP4Info(std::shared_ptr<const IrP4Info> info,
+                          int action_cache_capacity = 0);
+
+  const IrP4Info& info() const { return *state_->info; }
+  const CompiledIrP4Info& compiled() const { return state_->compiled; }
+
+  // Returns a pointer that keeps the IrP4Info alive, e.g. to hand it to code
+  // that does not know about SharedIrP4Info.
+  std::shared_ptr<const IrP4Info> shared_info() const {
+    return std::shared_ptr<const IrP4Info>(state_, state_->info.get());
+  }
+
+ private:
+  struct State {
+    State(std::shared_ptr<const IrP4Info> info, int action_cache_capacity)
+        : info(std::move(info)),
+          compiled(*this->info, action_cache_capacity) {}
+
+    const std::shared_ptr<const IrP4Info> info;
+    // Points into `info`.
+    const CompiledIrP4Info compiled;
+  };
+
+  std::shared_ptr<const State> state_;
+};
+
+}  // namespace pdpi
+
+#endif  // PINS_P4_PDPI_SHARED_IR_P4INFO_H_
@@ -0,0 +1,70 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4_pdpi/shared_ir_p4info.h"
+
+#include <memory>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/ir_p4info_cache.h"
+#include "p4_pdpi/testing/test_p4info.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::testing::Pointee;
+
+TEST(SharedIrP4InfoTest, CopiesShareTheIrP4Info) {
+  const SharedIrP4Info shared(GetTestIrP4Info());
+  const SharedIrP4Info copy = shared;
+  EXPECT_EQ(&copy.info(), &shared.info());
+  EXPECT_EQ(&copy.compiled(), &shared.compiled());
+  EXPECT_THAT(shared.info(), EqualsProto(GetTestIrP4Info()));
+}
+
+TEST(SharedIrP4InfoTest, CompiledLooksUpTheSharedIrP4Info) {
+  const SharedIrP4Info shared(GetTestIrP4Info());
+  for (const auto& [id, table] : shared.info().tables_by_id()) {
+    EXPECT_EQ(shared.compiled().FindTableById(id), &table);
+    EXPECT_THAT(shared.compiled().FindTableByName(table.preamble().alias()),
+                Pointee(EqualsProto(table)));
+  }
+}
+
+TEST(SharedIrP4InfoTest, SharedInfoOutlivesTheHandle) {
+  std::shared_ptr<const IrP4Info> info;
+  {
+    const SharedIrP4Info shared(GetTestIrP4Info());
+    info = shared.shared_info();
+    EXPECT_EQ(info.get(), &shared.info());
+  }
+  EXPECT_THAT(*info, EqualsProto(GetTestIrP4Info()));
+}
+
+TEST(SharedIrP4InfoTest, CreateSharesIrP4InfosForIdenticalP4Infos) {
+  ClearIrP4InfoCache();
+  ASSERT_OK_AND_ASSIGN(SharedIrP4Info first,
+                       SharedIrP4Info::Create(GetTestP4Info()));
+  ASSERT_OK_AND_ASSIGN(SharedIrP4Info second,
+                       SharedIrP4Info::Create(GetTestP4Info()));
+  EXPECT_EQ(&first.info(), &second.info());
+  EXPECT_THAT(first.info(), EqualsProto(GetTestIrP4Info()));
+}
+
+}  // namespace
+}  // namespace pdpi
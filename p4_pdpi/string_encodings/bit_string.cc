@@ -14,15 +14,66 @@
 #include "p4_pdpi/string_encodings/bit_string.h"
 
 #include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <string>
 
 #include "absl/status/status.h"
-#include "absl/strings/escaping.h"
-#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "gutil/status.h"
+#include "p4_pdpi/netaddr/ipv4_address.h"
+#include "p4_pdpi/netaddr/ipv6_address.h"
 #include "p4_pdpi/netaddr/mac_address.h"
+#include "p4_pdpi/string_encodings/hex_string.h"
 
 namespace pdpi {
 
+void BitString::AppendBytes(absl::string_view bytes) {
+  if (num_bits_ % 8 == 0) {
+    bytes_.append(bytes.data(), bytes.size());
+    num_bits_ += 8 * bytes.size();
+    return;
+  }
+  for (uint8_t byte : bytes) AppendWord(byte, 8);
+}
+
+void BitString::AppendWord(uint64_t word, int num_bits) {
+  if (num_bits == 0) return;
+  int byte = num_bits_ / 8;
+  bytes_.resize((num_bits_ + num_bits + 7) / 8, '\0');
+
+  int remaining = num_bits;
+  // Fill the free low bits of a partially used last byte.
+  if (const int used = num_bits_ % 8; used != 0) {
+    const int free = 8 - used;
+    const int count = std::min(free, remaining);
+    const uint8_t chunk = (word >> (remaining - count)) & ((1u << count) - 1);
+    bytes_[byte++] |= chunk << (free - count);
+    remaining -= count;
+  }
+  for (; remaining >= 8; remaining -= 8) {
+    bytes_[byte++] = (word >> (remaining - 8)) & 0xFF;
+  }
+  if (remaining > 0) {
+    bytes_[byte] = (word & ((1u << remaining) - 1)) << (8 - remaining);
+  }
+  num_bits_ += num_bits;
+}
+
+uint64_t BitString::ReadWord(int start, int num_bits) const {
+  uint64_t word = 0;
+  while (num_bits > 0) {
+    const int offset = start % 8;
+    const int count = std::min(8 - offset, num_bits);
+    const uint8_t byte = bytes_[start / 8];
+    const uint8_t chunk = (byte >> (8 - offset - count)) & ((1u << count) - 1);
+    word = (word << count) | chunk;
+    start += count;
+    num_bits -= count;
+  }
+  return word;
+}
+
 absl::Status BitString::Consume(int num_bits) {
   if (num_bits < 0) {
     return gutil::InvalidArgumentErrorBuilder()
@@ -56,16 +107,16 @@ absl::StatusOr<std::string> BitString::ConsumeHexString(int num_bits) {
 }
 
 absl::StatusOr<netaddr::MacAddress> BitString::ConsumeMacAddress() {
-  ASSIGN_OR_RETURN(auto hex_string, ConsumeHexString(48));
-  return netaddr::MacAddress::OfHexString(hex_string);
+  ASSIGN_OR_RETURN(auto bits, ConsumeBitset<48>());
+  return netaddr::MacAddress(bits);
 }
 absl::StatusOr<netaddr::Ipv4Address> BitString::ConsumeIpv4Address() {
-  ASSIGN_OR_RETURN(auto hex_string, ConsumeHexString(32));
-  return netaddr::Ipv4Address::OfHexString(hex_string);
+  ASSIGN_OR_RETURN(auto bits, ConsumeBitset<32>());
+  return netaddr::Ipv4Address(bits);
 }
 absl::StatusOr<netaddr::Ipv6Address> BitString::ConsumeIpv6Address() {
-  ASSIGN_OR_RETURN(auto hex_string, ConsumeHexString(128));
-  return netaddr::Ipv6Address::OfHexString(hex_string);
+  ASSIGN_OR_RETURN(auto bits, ConsumeBitset<128>());
+  return netaddr::Ipv6Address(bits);
 }
 
 absl::StatusOr<std::string> BitString::ToByteString() const {
@@ -75,15 +126,11 @@ absl::StatusOr<std::string> BitString::ToByteString() const {
               "converted to a byte string. Got "
            << size();
 
-  std::string result;
-  result.reserve(size() / 8);
-  for (int byte = 0; byte < size() / 8; byte++) {
-    uint8_t character = 0;
-    for (int bit = 0; bit < 8; bit++) {
-      character <<= 1;
-      character |= bits_[start_index_ + byte * 8 + bit];
-    }
-    result += character;
+  if (start_index_ % 8 == 0) return bytes_.substr(start_index_ / 8, size() / 8);
+
+  std::string result(size() / 8, '\0');
+  for (int byte = 0; byte < result.size(); byte++) {
+    result[byte] = ReadWord(start_index_ + 8 * byte, 8);
   }
   return result;
 }
@@ -97,28 +144,26 @@ absl::StatusOr<std::string> BitString::ToHexString() const {
 }
 
 std::string BitString::ToHexString(int start, int num_bits) const {
-  // Process, starting with the last byte.
-  std::string result;
-  for (int byte = 0; byte < (num_bits + 7) / 8; byte++) {
-    uint8_t character = 0;
-    // Note: first byte may only be partially filled
-    int bit;
-    for (bit = 0; bit < 8 && (byte * 8 + bit < num_bits); bit++) {
-      character >>= 1;
-      character |= bits_[start + num_bits - 1 - (byte * 8 + bit)] << 7;
-    }
-    // Finish shifting bits in the first byte
-    for (int i = bit; i < 8; i++) {
-      character >>= 1;
+  std::string result(2 + (num_bits + 3) / 4, '0');
+  result[1] = 'x';
+  if (num_bits == 0) return result;
+
+  // The first hex digit may only be partially filled. The rest are read up to
+  // 16 digits at a time.
+  const int leading_bits = (num_bits - 1) % 4 + 1;
+  int digit = 2;
+  result[digit++] = internal::kHexDigitChars[ReadWord(start, leading_bits)];
+  for (int bit = start + leading_bits; bit < start + num_bits;) {
+    const int count = std::min(64, start + num_bits - bit);
+    uint64_t word = ReadWord(bit, count);
+    for (int i = count / 4 - 1; i >= 0; --i) {
+      result[digit + i] = internal::kHexDigitChars[word & 0xF];
+      word >>= 4;
     }
-    std::string hex = absl::BytesToHexString(std::string(1, character));
-    if (bit <= 4) hex = hex.substr(1, 1);
-    std::reverse(hex.begin(), hex.end());
-    result += hex;
+    digit += count / 4;
+    bit += count;
   }
-
-  std::reverse(result.begin(), result.end());
-  return absl::StrCat("0x", result);
+  return result;
 }
 
 }  // namespace pdpi
@@ -15,13 +15,15 @@
 #define PINS_P4_PDPI_STRING_ENCODINGS_BIT_STRING_H_
 
 #include <bitset>
-#include <vector>
+#include <cstdint>
+#include <string>
 
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "p4_pdpi/netaddr/ipv4_address.h"
 #include "p4_pdpi/netaddr/ipv6_address.h"
 #include "p4_pdpi/netaddr/mac_address.h"
+#include "p4_pdpi/string_encodings/byte_string.h"
 #include "p4_pdpi/string_encodings/hex_string.h"
 
 namespace pdpi {
@@ -37,25 +39,23 @@ class BitString {
   // Constructs a bit string from a byte string.
   static BitString OfByteString(absl::string_view data) {
     BitString result;
-    for (uint8_t character : data) {
-      result.AppendBits(std::bitset<8>(character));
-    }
+    result.AppendBytes(data);
     return result;
   }
 
-  void AppendBit(bool bit) { bits_.push_back(bit); }
+  void AppendBit(bool bit) { AppendWord(bit, 1); }
   template <size_t num_bits>
   void AppendBits(const std::bitset<num_bits>& bits) {
-    for (int i = 0; i < num_bits; i++) {
-      bits_.push_back(bits.test(num_bits - 1 - i));
+    // Append the most significant, possibly partial, word first.
+    constexpr int kNumWords = (num_bits + 63) / 64;
+    constexpr int kLeadingBits = num_bits - 64 * (kNumWords - 1);
+    AppendWord(internal::BitsetWord(bits, kNumWords - 1), kLeadingBits);
+    for (int i = kNumWords - 2; i >= 0; --i) {
+      AppendWord(internal::BitsetWord(bits, i), 64);
     }
   }
 
-  void AppendBytes(absl::string_view bytes) {
-    for (int i = 0; i < bytes.size(); i++) {
-      AppendBits(std::bitset<8>(bytes[i]));
-    }
-  }
+  void AppendBytes(absl::string_view bytes);
 
   absl::Status AppendHexString(absl::string_view hex_string) {
     ASSIGN_OR_RETURN(auto bytes, pdpi::HexStringToByteString(hex_string));
@@ -89,15 +89,21 @@ class BitString {
   absl::StatusOr<std::bitset<num_bits>> ConsumeBitset() {
     const int start_index = start_index_;
     RETURN_IF_ERROR(Consume(num_bits));
-    std::bitset<num_bits> result;
-    for (int i = 0; i < num_bits; ++i) {
-      result[num_bits - i - 1] = bits_[start_index + i];
+    if constexpr (num_bits <= 64) {
+      return std::bitset<num_bits>(ReadWord(start_index, num_bits));
+    } else {
+      constexpr int kLeadingBits = (num_bits - 1) % 64 + 1;
+      std::bitset<num_bits> result(ReadWord(start_index, kLeadingBits));
+      for (int i = start_index + kLeadingBits; i < start_index_; i += 64) {
+        result <<= 64;
+        result |= std::bitset<num_bits>(ReadWord(i, 64));
+      }
+      return result;
     }
-    return result;
   }
 
   // Returns the number of bits.
-  int size() const { return bits_.size() - start_index_; }
+  int size() const { return num_bits_ - start_index_; }
 
   // Returns a byte string representation. Only works if size() % 8 == 0.
   absl::StatusOr<std::string> ToByteString() const;
@@ -110,12 +116,23 @@ class BitString {
   // status otherwise.
   absl::Status Consume(int num_bits);
 
+  // Appends the num_bits <= 64 least significant bits of `word`, most
+  // significant bit first.
+  void AppendWord(uint64_t word, int num_bits);
+
+  // Returns the num_bits <= 64 bits starting at bit `start` as the least
+  // significant bits of a word. The bits must exist.
+  uint64_t ReadWord(int start, int num_bits) const;
+
   // Translate the bits from start to start+num_bits to a hex string.
   std::string ToHexString(int start, int num_bits) const;
 
-  // The bits that make up this bit string. Some prefix might be unused, and the
-  // actual data only starts at start_index_.
-  std::vector<bool> bits_;
+  // The bits that make up this bit string, packed 8 to a byte with the first
+  // bit in the most significant bit of bytes_[0]. Bits past num_bits_ are
+  // zero. Some prefix might be unused, and the actual data only starts at
+  // start_index_.
+  std::string bytes_;
+  int num_bits_ = 0;
   int start_index_ = 0;
 };
 
@@ -13,7 +13,10 @@
 // limitations under the License.
 #include "p4_pdpi/string_encodings/bit_string.h"
 
+#include <bitset>
+
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "gutil/status_matchers.h"
@@ -92,4 +95,48 @@ TEST(ReadableByteStringTest, ConsumeBitsetErrorWhenInputGreaterThanSize) {
                "Only 40 bits left, but attempted to consume 100 bits."));
 }
 
+TEST(ReadableByteStringTest, AppendsAndConsumesAtUnalignedOffsets) {
+  const std::bitset<130> wide = (std::bitset<130>(0x2ab) << 100) |
+                                (std::bitset<130>(0x1234) << 40) |
+                                std::bitset<130>(0x55);
+  BitString test;
+  test.AppendBit(1);
+  test.AppendBits(wide);
+  test.AppendBytes("\xab\xcd");
+  test.AppendBits(std::bitset<5>(0x11));
+  ASSERT_EQ(test.size(), 1 + 130 + 16 + 5);
+
+  EXPECT_THAT(test.ConsumeBitset<1>(), IsOkAndHolds(Eq(std::bitset<1>(1))));
+  EXPECT_THAT(test.ConsumeBitset<130>(), IsOkAndHolds(Eq(wide)));
+  EXPECT_THAT(test.ConsumeHexString(16), IsOkAndHolds("0xabcd"));
+  EXPECT_THAT(test.ConsumeHexString(5), IsOkAndHolds("0x11"));
+  EXPECT_EQ(test.size(), 0);
+}
+
+TEST(ReadableByteStringTest, ToByteStringWorksAfterUnalignedConsume) {
+  BitString test;
+  test.AppendBits(std::bitset<4>(0xa));
+  test.AppendBytes("\x12\x34\x56");
+  test.AppendBits(std::bitset<8>(0xb0));
+  ASSERT_OK(test.ConsumeBitset<4>().status());
+  EXPECT_THAT(test.ToByteString(), IsOkAndHolds("\x12\x34\x56\xb0"));
+  EXPECT_THAT(test.ToHexString(), IsOkAndHolds("0x123456b0"));
+}
+
+TEST(ReadableByteStringTest, ConsumesAddresses) {
+  BitString test = BitString::OfByteString(absl::string_view(
+      "\x01\x02\x03\x04\x05\x06"
+      "\x0a\x00\x00\x01"
+      "\x20\x01\x0d\xb8\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+      "\x01",
+      26));
+  EXPECT_THAT(test.ConsumeMacAddress(),
+              IsOkAndHolds(Eq(netaddr::MacAddress(1, 2, 3, 4, 5, 6))));
+  EXPECT_THAT(test.ConsumeIpv4Address(),
+              IsOkAndHolds(Eq(netaddr::Ipv4Address(10, 0, 0, 1))));
+  EXPECT_THAT(test.ConsumeIpv6Address(),
+              IsOkAndHolds(Eq(netaddr::Ipv6Address(0x2001, 0xdb8, 0, 0, 0,
+                                                   0, 0, 1))));
+}
+
 }  // namespace pdpi
@@ -32,6 +32,7 @@
 #include <algorithm>
 #include <bitset>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <string>
 
@@ -53,6 +54,10 @@ absl::StatusOr<std::bitset<num_bits>> ByteStringToBitset(
 template <std::size_t num_bits>
 std::string BitsetToPaddedByteString(std::bitset<num_bits> bits);
 
+// Same as above, but writes the ceil(bits/8) bytes to `buffer`.
+template <std::size_t num_bits>
+void BitsetToPaddedBytes(const std::bitset<num_bits>& bits, char* buffer);
+
 // Writes the given bits to a canonical P4Runtime binary string.
 template <std::size_t num_bits>
 std::string BitsetToP4RuntimeByteString(std::bitset<num_bits> bits);
@@ -74,14 +79,36 @@ inline constexpr int NumBitsToNumBytes(int num_bits) {
   return (num_bits + 7) / 8;  // ceil(num_bits/8)
 }
 
+// Returns bits [64 * i, 64 * i + 64) of the bitset. Bits beyond the end of
+// the bitset are 0.
+template <std::size_t num_bits>
+uint64_t BitsetWord(const std::bitset<num_bits>& bits, int i) {
+  if constexpr (num_bits <= 64) {
+    return i == 0 ? bits.to_ullong() : 0;
+  } else {
+    static const std::bitset<num_bits> kWordMask(~uint64_t{0});
+    return ((bits >> (64 * i)) & kWordMask).to_ullong();
+  }
+}
+
+// Reads the byte string 8 bytes at a time, from the least significant byte.
+// Bits that do not fit are dropped.
 template <std::size_t num_bits>
 std::bitset<num_bits> AnyByteStringToBitset(absl::string_view byte_string) {
+  if constexpr (num_bits <= 64) {
+    uint64_t word = 0;
+    for (char c : byte_string) word = (word << 8) | static_cast<uint8_t>(c);
+    return std::bitset<num_bits>(word);
+  }
   std::bitset<num_bits> bits;
-  for (char c : byte_string) {
-    uint8_t byte = 0;
-    memcpy(&byte, &c, 1);
-    bits <<= 8;
-    bits |= byte;
+  const int num_bytes = byte_string.size();
+  for (int word_start = 0; word_start < num_bytes; word_start += 8) {
+    const int word_end = std::min(word_start + 8, num_bytes);
+    uint64_t word = 0;
+    for (int i = word_end - 1; i >= word_start; --i) {
+      word = (word << 8) | static_cast<uint8_t>(byte_string[num_bytes - i - 1]);
+    }
+    if (word != 0) bits |= std::bitset<num_bits>(word) << (8 * word_start);
   }
   return bits;
 }
@@ -121,16 +148,24 @@ absl::StatusOr<std::bitset<num_bits>> ByteStringToBitset(
 
 template <std::size_t num_bits>
 std::string BitsetToPaddedByteString(std::bitset<num_bits> bits) {
-  static constexpr int kNumBytes = internal::NumBitsToNumBytes(num_bits);
-  static constexpr std::bitset<num_bits> lsb_mask = std::bitset<num_bits>(0xFF);
-
-  char buffer[kNumBytes];
-  for (int i = kNumBytes - 1; i >= 0; --i) {
-    uint8_t byte = static_cast<uint8_t>((bits & lsb_mask).to_ulong());
-    memcpy(&buffer[i], &byte, 1);
-    bits >>= 8;
+  std::string byte_string(internal::NumBitsToNumBytes(num_bits), '\0');
+  BitsetToPaddedBytes(bits, byte_string.data());
+  return byte_string;
+}
+
+template <std::size_t num_bits>
+void BitsetToPaddedBytes(const std::bitset<num_bits>& bits, char* buffer) {
+  constexpr int kNumBytes = internal::NumBitsToNumBytes(num_bits);
+
+  // Fill in the buffer from the least significant byte, reading the bitset 64
+  // bits at a time.
+  uint64_t word = 0;
+  for (int i = 0; i < kNumBytes; ++i) {
+    if (i % 8 == 0) word = internal::BitsetWord(bits, i / 8);
+    const uint8_t byte = word & 0xFF;
+    memcpy(&buffer[kNumBytes - i - 1], &byte, 1);
+    word >>= 8;
   }
-  return std::string(buffer, kNumBytes);
 }
 
 template <std::size_t num_bits>
@@ -115,6 +115,29 @@ TEST(ByteStringTest, ByteStringToBitsetCorrect) {
   EXPECT_THAT(ByteStringToBitset<2>(SafeString({0, 0, 0b100})), Not(IsOk()));
 }
 
+TEST(ByteStringTest, BitsetToPaddedBytesWritesThePaddedByteString) {
+  for (const auto& [bitset, byte_str] : BitsetsAndPaddedByteStrings()) {
+    char buffer[2];
+    BitsetToPaddedBytes(bitset, buffer);
+    EXPECT_EQ(absl::string_view(buffer, sizeof(buffer)), byte_str);
+  }
+}
+
+TEST(ByteStringTest, BitsetsWiderThan64BitsRoundTrip) {
+  // Every byte is distinct, so bytes that end up in the wrong position or word
+  // are caught.
+  std::vector<uint8_t> bytes;
+  for (int i = 1; i <= 17; ++i) bytes.push_back(i);
+  const std::string byte_str = SafeString(bytes);
+
+  ASSERT_OK_AND_ASSIGN(std::bitset<132> bitset,
+                       ByteStringToBitset<132>(byte_str));
+  EXPECT_EQ(bitset.to_string().substr(0, 4), "0001");
+  EXPECT_EQ((bitset & std::bitset<132>(0xFFFF)).to_ulong(), 0x1011);
+  EXPECT_EQ(BitsetToPaddedByteString(bitset), byte_str);
+  EXPECT_EQ(BitsetToP4RuntimeByteString(bitset), byte_str);
+}
+
 TEST(ByteStringTest, BitsetToPaddedByteString_Regression_2020_12_02) {
   const auto bitset = ~std::bitset<128>();
   BitsetToPaddedByteString(bitset);  // No crash.
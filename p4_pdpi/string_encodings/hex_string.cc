@@ -20,8 +20,6 @@
 #include <string>
 
 #include "absl/status/statusor.h"
-#include "absl/strings/escaping.h"
-#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "glog/logging.h"
 #include "gutil/status.h"
@@ -29,11 +27,41 @@
 #include "p4_pdpi/string_encodings/safe.h"
 
 namespace pdpi {
+namespace {
+
+// The two hex digits of every byte.
+struct ByteHexDigits {
+  char digits[256][2];
+};
+
+constexpr ByteHexDigits MakeByteHexDigits() {
+  ByteHexDigits result = {};
+  for (int byte = 0; byte < 256; ++byte) {
+    result.digits[byte][0] = internal::kHexDigitChars[byte >> 4];
+    result.digits[byte][1] = internal::kHexDigitChars[byte & 0xF];
+  }
+  return result;
+}
+
+constexpr ByteHexDigits kByteHexDigits = MakeByteHexDigits();
+
+}  // namespace
 
 // -- Conversions to Hex Strings -----------------------------------------------
 
 std::string ByteStringToHexString(absl::string_view byte_string) {
-  return absl::StrCat("0x", absl::BytesToHexString(byte_string));
+  std::string hex_string(2 + 2 * byte_string.size(), 'x');
+  hex_string[0] = '0';
+  ByteStringToHexDigits(byte_string, hex_string.data() + 2);
+  return hex_string;
+}
+
+char* ByteStringToHexDigits(absl::string_view byte_string, char* buffer) {
+  for (char c : byte_string) {
+    memcpy(buffer, kByteHexDigits.digits[static_cast<uint8_t>(c)], 2);
+    buffer += 2;
+  }
+  return buffer;
 }
 
 // -- Conversions from Hex Strings ---------------------------------------------
@@ -83,104 +111,47 @@ absl::StatusOr<std::string> HexStringToByteString(
               "strings";
   }
 
-  std::string result;
-  for (size_t i = 0; i < hex_string.size(); i += 2) {
-    const char ith_char = hex_string[i];
-    const char ith_plus1_char = hex_string[i + 1];
-    ASSIGN_OR_RETURN(
-        const uint8_t ith_digit, HexCharToDigit(ith_char),
-        _ << " while trying to convert hex string: " << hex_string);
-    ASSIGN_OR_RETURN(
-        const uint8_t ith_plus1_digit, HexCharToDigit(ith_plus1_char),
-        _ << " while trying to convert hex string: " << hex_string);
-    uint8_t c = (ith_digit << 4) | ith_plus1_digit;
-    result += pdpi::SafeChar(c);
+  std::string result(hex_string.size() / 2, '\0');
+  if (!HexDigitsToByteString(hex_string, result.data())) {
+    // Report the first invalid character.
+    for (char hex_char : hex_string) {
+      RETURN_IF_ERROR(HexCharToDigit(hex_char).status())
+          << " while trying to convert hex string: " << hex_string;
+    }
   }
   return result;
 }
 
+bool HexDigitsToByteString(absl::string_view hex_digits, char* buffer) {
+  // Invalid characters have digit -1, so `invalid` becomes negative once any
+  // of them is seen. This keeps the loop free of branches.
+  int invalid = 0;
+  if (hex_digits.size() % 2 != 0) {
+    const int digit = internal::HexDigitOf(hex_digits[0]);
+    invalid |= digit;
+    *buffer++ = SafeChar(digit & 0xF);
+    hex_digits.remove_prefix(1);
+  }
+  for (size_t i = 0; i < hex_digits.size(); i += 2) {
+    const int high = internal::HexDigitOf(hex_digits[i]);
+    const int low = internal::HexDigitOf(hex_digits[i + 1]);
+    invalid |= high | low;
+    *buffer++ = SafeChar(((high & 0xF) << 4) | (low & 0xF));
+  }
+  return invalid >= 0;
+}
+
 // -- Conversions between Hex Characters and Digits ----------------------------
 
 char HexDigitToChar(int digit) {
-  switch (digit) {
-    case 0:
-      return '0';
-    case 1:
-      return '1';
-    case 2:
-      return '2';
-    case 3:
-      return '3';
-    case 4:
-      return '4';
-    case 5:
-      return '5';
-    case 6:
-      return '6';
-    case 7:
-      return '7';
-    case 8:
-      return '8';
-    case 9:
-      return '9';
-    case 10:
-      return 'a';
-    case 11:
-      return 'b';
-    case 12:
-      return 'c';
-    case 13:
-      return 'd';
-    case 14:
-      return 'e';
-    case 15:
-      return 'f';
-  }
+  if (digit >= 0 && digit < 16) return internal::kHexDigitChars[digit];
   LOG(DFATAL) << "illegal hexadecimal digit: " << digit << "; returning '?'";
   return '?';
 }
 
 absl::StatusOr<int> HexCharToDigit(char hex_char) {
-  switch (hex_char) {
-    case '0':
-      return 0;
-    case '1':
-      return 1;
-    case '2':
-      return 2;
-    case '3':
-      return 3;
-    case '4':
-      return 4;
-    case '5':
-      return 5;
-    case '6':
-      return 6;
-    case '7':
-      return 7;
-    case '8':
-      return 8;
-    case '9':
-      return 9;
-    case 'a':
-    case 'A':
-      return 10;
-    case 'b':
-    case 'B':
-      return 11;
-    case 'c':
-    case 'C':
-      return 12;
-    case 'd':
-    case 'D':
-      return 13;
-    case 'e':
-    case 'E':
-      return 14;
-    case 'f':
-    case 'F':
-      return 15;
-  }
+  const int digit = internal::HexDigitOf(hex_char);
+  if (digit >= 0) return digit;
   return gutil::InvalidArgumentErrorBuilder()
          << "invalid hexadecimal character: " << hex_char;
 }
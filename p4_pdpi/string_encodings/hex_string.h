@@ -32,6 +32,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/strip.h"
 #include "gutil/status.h"
+#include "p4_pdpi/string_encodings/byte_string.h"
 
 namespace pdpi {
 
@@ -42,6 +43,10 @@ std::string BitsetToHexString(const std::bitset<num_bits>& bitset);
 
 std::string ByteStringToHexString(absl::string_view byte_string);
 
+// Writes the 2 * byte_string.size() lowercase hex digits of `byte_string`,
+// without "0x"-prefix, to `buffer`. Returns a pointer past the last digit.
+char* ByteStringToHexDigits(absl::string_view byte_string, char* buffer);
+
 // We do not provide direct conversions from integer types; use
 // BitsetToHexString for that purpose, e.g.:
 // ```
@@ -74,33 +79,62 @@ absl::StatusOr<uint64_t> HexStringToUint64(absl::string_view hex_string);
 
 absl::StatusOr<std::string> HexStringToByteString(absl::string_view hex_string);
 
+// Writes the (hex_digits.size() + 1) / 2 bytes encoded by `hex_digits`, given
+// without "0x"-prefix, to `buffer`. An odd number of digits is read as if it
+// had a leading zero. Returns false iff `hex_digits` contains a non-hexadecimal
+// character, in which case the contents of `buffer` are unspecified.
+bool HexDigitsToByteString(absl::string_view hex_digits, char* buffer);
+
 // == END OF PUBLIC INTERFACE ==================================================
 
 char HexDigitToChar(int digit);
 absl::StatusOr<int> HexCharToDigit(char hex_char);
 
+namespace internal {
+
+inline constexpr char kHexDigitChars[] = "0123456789abcdef";
+
+// The digit of every hexadecimal character, and -1 for all other characters.
+struct HexCharDigits {
+  int8_t digit[256];
+};
+
+constexpr HexCharDigits MakeHexCharDigits() {
+  HexCharDigits result = {};
+  for (int c = 0; c < 256; ++c) {
+    result.digit[c] = (c >= '0' && c <= '9')   ? c - '0'
+                      : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                      : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+                                               : -1;
+  }
+  return result;
+}
+
+inline constexpr HexCharDigits kHexCharDigits = MakeHexCharDigits();
+
+// Returns the digit of `hex_char`, or -1 if it is not a hexadecimal character.
+inline int HexDigitOf(char hex_char) {
+  return kHexCharDigits.digit[static_cast<uint8_t>(hex_char)];
+}
+
+}  // namespace internal
+
 template <std::size_t num_bits>
 std::string BitsetToHexString(const std::bitset<num_bits>& bitset) {
   // Each hexadecimal digit is given by 4 bits in the bitset.
-  const int num_hex_digits = (num_bits + 3) / 4;  // ceil(num_bits / 4.0)
-
-  // Construct hex_string in reverse order, starting from least significant
-  // digit.
-  std::string hex_string;
-  for (int i = 0; i < num_hex_digits; ++i) {
-    int ith_digit = 0;
-    // The ith digit is given by bits 4i+3 to 4i; we set the bits from most to
-    // least significant.
-    for (int k = 4 * i + 3; k >= 4 * i; --k) {
-      int kth_bit = (k < num_bits) ? bitset[k] : 0;  // Implicit bits are 0.
-      ith_digit = (ith_digit << 1) | kth_bit;
-    }
-    hex_string.push_back(HexDigitToChar(ith_digit));
+  constexpr int kNumHexDigits = (num_bits + 3) / 4;  // ceil(num_bits / 4.0)
+
+  // Fill in hex_string from the least significant digit, reading the bitset
+  // 64 bits at a time. Implicit bits are 0.
+  std::string hex_string(2 + kNumHexDigits, '0');
+  hex_string[1] = 'x';
+  uint64_t word = 0;
+  for (int i = 0; i < kNumHexDigits; ++i) {
+    if (i % 16 == 0) word = internal::BitsetWord(bitset, i / 16);
+    hex_string[kNumHexDigits + 1 - i] = internal::kHexDigitChars[word & 0xF];
+    word >>= 4;
   }
-
-  // Reverse string and prepend "0x" prefix
-  std::reverse(hex_string.begin(), hex_string.end());
-  return absl::StrCat("0x", hex_string);
+  return hex_string;
 }
 
 template <std::size_t num_bits>
@@ -112,27 +146,38 @@ absl::StatusOr<std::bitset<num_bits>> HexStringToAnyLargeEnoughBitset(
            << "'";
   }
 
-  // Compute and set bits from least to most significant.
+  // Compute bits from least to most significant, collecting 16 digits into a
+  // 64-bit word before setting them in the bitset.
   std::bitset<num_bits> bitset;
+  uint64_t word = 0;
   for (int i = 0; i < hex_string.size(); ++i) {
     const char ith_char = hex_string[hex_string.size() - i - 1];
-    ASSIGN_OR_RETURN(
-        const int ith_digit, HexCharToDigit(ith_char),
-        _ << " while trying to convert hex string: " << hex_string);
-    for (int j = 0; j < 4; ++j) {
-      // k is the index of the j-th bit of the i-th hex digit.
-      const std::size_t k = 4 * i + j;
-      const bool kth_bit = (ith_digit >> j) % 2 == 1;
-      if (!kth_bit) continue;
-      if (k < num_bits) {
-        bitset.set(k, kth_bit);
-      } else {
+    const int ith_digit = internal::HexDigitOf(ith_char);
+    if (ith_digit < 0) {
+      RETURN_IF_ERROR(HexCharToDigit(ith_char).status())
+          << " while trying to convert hex string: " << hex_string;
+    }
+
+    // The i-th hex digit holds bits 4i to 4i+3, which must all be 0 if they
+    // are not in the bitset.
+    const std::size_t k = 4 * i;
+    if (k + 4 > num_bits) {
+      int lost_bits = k >= num_bits ? ith_digit : ith_digit >> (num_bits - k);
+      if (lost_bits != 0) {
+        std::size_t lost_bit = std::max(k, num_bits);
+        for (; lost_bits % 2 == 0; lost_bits >>= 1) ++lost_bit;
         return gutil::InvalidArgumentErrorBuilder()
-               << "hex string '0x" << hex_string << "' has bit #" << (k + 1)
-               << " set to 1; conversion to " << num_bits
+               << "hex string '0x" << hex_string << "' has bit #"
+               << (lost_bit + 1) << " set to 1; conversion to " << num_bits
                << " bits would lose information";
       }
     }
+
+    word |= static_cast<uint64_t>(ith_digit) << (4 * (i % 16));
+    if (i % 16 == 15 || i + 1 == hex_string.size()) {
+      if (word != 0) bitset |= std::bitset<num_bits>(word) << (64 * (i / 16));
+      word = 0;
+    }
   }
   return bitset;
 }
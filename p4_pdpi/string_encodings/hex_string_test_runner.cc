@@ -14,6 +14,7 @@
 
 #include <iostream>
 #include <limits>
+#include <string>
 
 #include "absl/status/status.h"
 #include "p4_pdpi/string_encodings/hex_string.h"
@@ -38,7 +39,9 @@
   } while (false)
 
 using ::pdpi::BitsetToHexString;
+using ::pdpi::ByteStringToHexString;
 using ::pdpi::HexStringToBitset;
+using ::pdpi::HexStringToByteString;
 using ::pdpi::HexStringToInt;
 using ::pdpi::HexStringToInt32;
 using ::pdpi::HexStringToInt64;
@@ -69,6 +72,13 @@ int main() {
   TEST_PURE(
       BitsetToHexString<8 * sizeof(int)>(std::numeric_limits<int>::min()));
 
+  TEST_PURE(BitsetToHexString(~std::bitset<130>()));
+  TEST_PURE(BitsetToHexString(std::bitset<130>(0xabc) << 64));
+
+  // ByteStringToHexString.
+  TEST_PURE(ByteStringToHexString("AB"));
+  TEST_PURE(ByteStringToHexString(std::string("\xff\x00\x10", 3)));
+
   // HexStringToBitset.
   TEST_STATUSOR(HexStringToBitset<1>("0x0"));
   TEST_STATUSOR(HexStringToBitset<1>("0x1"));
@@ -78,6 +88,19 @@ int main() {
   TEST_STATUSOR(HexStringToBitset<7>("0xf0"));
   TEST_STATUSOR(HexStringToBitset<8>("0xf0"));
   TEST_STATUSOR(HexStringToBitset<8>("0x00ff"));
+  TEST_STATUSOR(HexStringToBitset<130>(
+      "0x3ffffffffffffffffffffffffffffffff"));
+  TEST_STATUSOR(HexStringToBitset<130>(
+      "0x4ffffffffffffffffffffffffffffffff"));
+  TEST_STATUSOR(HexStringToBitset<130>(
+      "0x0000000000000000000000000000000g0"));
+
+  // HexStringToByteString.
+  TEST_STATUSOR(HexStringToByteString("0x4142"));
+  TEST_STATUSOR(HexStringToByteString("0x4A4b"));
+  TEST_STATUSOR(HexStringToByteString("0x414"));
+  TEST_STATUSOR(HexStringToByteString("0x41g2"));
+  TEST_STATUSOR(HexStringToByteString("4142"));
 
   // HexStringToInt.
   TEST_STATUSOR(HexStringToInt("0x0"));
@@ -0,0 +1,185 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmarks for the conversions used when translating values between
+// PI and IR, and by packetlib when parsing and serializing packets.
+//
+// Run with
+//   bazel run -c opt //p4_pdpi/string_encodings:string_encodings_benchmark
+
+#include <bitset>
+#include <cstdint>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "p4_pdpi/netaddr/ipv4_address.h"
+#include "p4_pdpi/netaddr/ipv6_address.h"
+#include "p4_pdpi/netaddr/mac_address.h"
+#include "p4_pdpi/string_encodings/bit_string.h"
+#include "p4_pdpi/string_encodings/byte_string.h"
+#include "p4_pdpi/string_encodings/hex_string.h"
+
+namespace pdpi {
+namespace {
+
+// Returns a byte string of the given size, with every byte set.
+std::string TestByteString(int size) {
+  std::string byte_string(size, '\0');
+  for (int i = 0; i < size; ++i) byte_string[i] = static_cast<char>(0xA5 + i);
+  return byte_string;
+}
+
+// -- Hex strings --------------------------------------------------------------
+
+void BM_ByteStringToHexString(benchmark::State& state) {
+  const std::string byte_string = TestByteString(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ByteStringToHexString(byte_string));
+  }
+  state.SetBytesProcessed(state.iterations() * byte_string.size());
+}
+BENCHMARK(BM_ByteStringToHexString)->Arg(2)->Arg(6)->Arg(16)->Arg(256);
+
+void BM_HexStringToByteString(benchmark::State& state) {
+  const std::string hex_string =
+      ByteStringToHexString(TestByteString(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HexStringToByteString(hex_string));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HexStringToByteString)->Arg(2)->Arg(6)->Arg(16)->Arg(256);
+
+template <std::size_t num_bits>
+void BM_BitsetToHexString(benchmark::State& state) {
+  const std::bitset<num_bits> bits = ~std::bitset<num_bits>();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(BitsetToHexString(bits));
+  }
+}
+BENCHMARK_TEMPLATE(BM_BitsetToHexString, 12);
+BENCHMARK_TEMPLATE(BM_BitsetToHexString, 48);
+BENCHMARK_TEMPLATE(BM_BitsetToHexString, 128);
+
+template <std::size_t num_bits>
+void BM_HexStringToBitset(benchmark::State& state) {
+  const std::string hex_string = BitsetToHexString(~std::bitset<num_bits>());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HexStringToBitset<num_bits>(hex_string));
+  }
+}
+BENCHMARK_TEMPLATE(BM_HexStringToBitset, 12);
+BENCHMARK_TEMPLATE(BM_HexStringToBitset, 48);
+BENCHMARK_TEMPLATE(BM_HexStringToBitset, 128);
+
+// -- Byte strings -------------------------------------------------------------
+
+template <std::size_t num_bits>
+void BM_ByteStringToBitset(benchmark::State& state) {
+  const std::string byte_string =
+      BitsetToPaddedByteString(~std::bitset<num_bits>());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ByteStringToBitset<num_bits>(byte_string));
+  }
+}
+BENCHMARK_TEMPLATE(BM_ByteStringToBitset, 12);
+BENCHMARK_TEMPLATE(BM_ByteStringToBitset, 48);
+BENCHMARK_TEMPLATE(BM_ByteStringToBitset, 128);
+
+template <std::size_t num_bits>
+void BM_BitsetToPaddedByteString(benchmark::State& state) {
+  const std::bitset<num_bits> bits = ~std::bitset<num_bits>();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(BitsetToPaddedByteString(bits));
+  }
+}
+BENCHMARK_TEMPLATE(BM_BitsetToPaddedByteString, 12);
+BENCHMARK_TEMPLATE(BM_BitsetToPaddedByteString, 48);
+BENCHMARK_TEMPLATE(BM_BitsetToPaddedByteString, 128);
+
+// -- Network addresses --------------------------------------------------------
+
+template <typename Address>
+void BM_AddressOfByteStringToString(benchmark::State& state) {
+  const std::string byte_string = Address::AllOnes().ToPaddedByteString();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Address::OfByteString(byte_string)->ToString());
+  }
+}
+BENCHMARK_TEMPLATE(BM_AddressOfByteStringToString, netaddr::Ipv4Address);
+BENCHMARK_TEMPLATE(BM_AddressOfByteStringToString, netaddr::Ipv6Address);
+BENCHMARK_TEMPLATE(BM_AddressOfByteStringToString, netaddr::MacAddress);
+
+template <typename Address>
+void BM_AddressOfStringToPaddedByteString(benchmark::State& state) {
+  const std::string address = Address::AllOnes().ToString();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Address::OfString(address)->ToPaddedByteString());
+  }
+}
+BENCHMARK_TEMPLATE(BM_AddressOfStringToPaddedByteString, netaddr::Ipv4Address);
+BENCHMARK_TEMPLATE(BM_AddressOfStringToPaddedByteString, netaddr::Ipv6Address);
+BENCHMARK_TEMPLATE(BM_AddressOfStringToPaddedByteString, netaddr::MacAddress);
+
+// -- Bit strings --------------------------------------------------------------
+
+// Consumes an Ethernet and an IPv4 header field by field, like packetlib does.
+void BM_BitStringParseHeaders(benchmark::State& state) {
+  const std::string packet = TestByteString(14 + 20 + state.range(0));
+  for (auto _ : state) {
+    BitString bits = BitString::OfByteString(packet);
+    benchmark::DoNotOptimize(bits.ConsumeMacAddress());
+    benchmark::DoNotOptimize(bits.ConsumeMacAddress());
+    benchmark::DoNotOptimize(bits.ConsumeHexString(16));
+    for (int width : {4, 4, 6, 2, 16, 16, 3, 13, 8, 8, 16}) {
+      benchmark::DoNotOptimize(bits.ConsumeHexString(width));
+    }
+    benchmark::DoNotOptimize(bits.ConsumeIpv4Address());
+    benchmark::DoNotOptimize(bits.ConsumeIpv4Address());
+    benchmark::DoNotOptimize(bits.ToByteString());
+  }
+  state.SetBytesProcessed(state.iterations() * packet.size());
+}
+BENCHMARK(BM_BitStringParseHeaders)->Arg(0)->Arg(64)->Arg(1500);
+
+// Appends an Ethernet and an IPv4 header field by field and a payload.
+void BM_BitStringSerializeHeaders(benchmark::State& state) {
+  const std::string payload = TestByteString(state.range(0));
+  for (auto _ : state) {
+    BitString bits;
+    bits.AppendBits(netaddr::MacAddress::AllOnes().ToBitset());
+    bits.AppendBits(netaddr::MacAddress::AllOnes().ToBitset());
+    bits.AppendBits(std::bitset<16>(0x0800));
+    bits.AppendBits(std::bitset<4>(4));
+    bits.AppendBits(std::bitset<4>(5));
+    bits.AppendBits(std::bitset<6>(0));
+    bits.AppendBits(std::bitset<2>(0));
+    bits.AppendBits(std::bitset<16>(20 + payload.size()));
+    bits.AppendBits(std::bitset<16>(0));
+    bits.AppendBits(std::bitset<3>(0));
+    bits.AppendBits(std::bitset<13>(0));
+    bits.AppendBits(std::bitset<8>(64));
+    bits.AppendBits(std::bitset<8>(17));
+    bits.AppendBits(std::bitset<16>(0));
+    bits.AppendBits(netaddr::Ipv4Address::AllOnes().ToBitset());
+    bits.AppendBits(netaddr::Ipv4Address::AllOnes().ToBitset());
+    bits.AppendBytes(payload);
+    benchmark::DoNotOptimize(bits.ToByteString());
+  }
+  state.SetBytesProcessed(state.iterations() * (14 + 20 + payload.size()));
+}
+BENCHMARK(BM_BitStringSerializeHeaders)->Arg(0)->Arg(64)->Arg(1500);
+
+}  // namespace
+}  // namespace pdpi
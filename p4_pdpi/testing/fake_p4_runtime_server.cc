@@ -0,0 +1,304 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_pdpi/testing/fake_p4_runtime_server.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "absl/hash/hash.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "google/rpc/code.pb.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/status.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+namespace {
+
+absl::uint128 ElectionId(const p4::v1::Uint128& election_id) {
+  return absl::MakeUint128(election_id.high(), election_id.low());
+}
+
+// Returns true if `entity` is requested by the read request entity `wildcard`.
+bool IsRequested(const p4::v1::Entity& entity,
+                 const p4::v1::Entity& wildcard) {
+  if (wildcard.has_table_entry()) {
+    return entity.has_table_entry() &&
+           (wildcard.table_entry().table_id() == 0 ||
+            wildcard.table_entry().table_id() ==
+                entity.table_entry().table_id());
+  }
+  if (wildcard.has_packet_replication_engine_entry()) {
+    return entity.has_packet_replication_engine_entry();
+  }
+  return false;
+}
+
+}  // namespace
+
+FakeP4RuntimeService::FakeP4RuntimeService(FakeP4RuntimeServiceOptions options)
+    : options_(std::move(options)) {
+  shards_.reserve(std::max(options_.num_shards, 1));
+  for (int i = 0; i < std::max(options_.num_shards, 1); ++i) {
+    shards_.push_back(std::make_unique<Shard>());
+  }
+}
+
+FakeP4RuntimeService::Shard& FakeP4RuntimeService::ShardOf(
+    const EntityKey& key) {
+  return *shards_[absl::HashOf(key) % shards_.size()];
+}
+
+void FakeP4RuntimeService::Clear() {
+  for (std::unique_ptr<Shard>& shard : shards_) {
+    absl::MutexLock lock(&shard->mutex);
+    shard->entities.clear();
+  }
+}
+
+absl::Status FakeP4RuntimeService::ApplyUpdate(const p4::v1::Update& update,
+                                               const IrP4Info* ir_p4info,
+                                               bool inject_error) {
+  if (inject_error) {
+    return gutil::ResourceExhaustedErrorBuilder() << "Injected error";
+  }
+  if (ir_p4info != nullptr) {
+    RETURN_IF_ERROR(PiUpdateToIr(*ir_p4info, update).status())
+            .SetCode(absl::StatusCode::kInvalidArgument);
+  }
+  ASSIGN_OR_RETURN(EntityKey key, EntityKey::MakeEntityKey(update.entity()),
+                   _.SetCode(absl::StatusCode::kInvalidArgument));
+
+  Shard& shard = ShardOf(key);
+  absl::MutexLock lock(&shard.mutex);
+  switch (update.type()) {
+    case p4::v1::Update::INSERT:
+      if (!shard.entities.try_emplace(key, update.entity()).second) {
+        return gutil::AlreadyExistsErrorBuilder()
+               << "Entity already exists: " << key;
+      }
+      return absl::OkStatus();
+    case p4::v1::Update::MODIFY: {
+      auto it = shard.entities.find(key);
+      if (it == shard.entities.end()) {
+        return gutil::NotFoundErrorBuilder() << "Entity not found: " << key;
+      }
+      it->second = update.entity();
+      return absl::OkStatus();
+    }
+    case p4::v1::Update::DELETE:
+      if (shard.entities.erase(key) == 0) {
+        return gutil::NotFoundErrorBuilder() << "Entity not found: " << key;
+      }
+      return absl::OkStatus();
+    default:
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unsupported update type: " << update.type();
+  }
+}
+
+grpc::Status FakeP4RuntimeService::Write(grpc::ServerContext* context,
+                                         const p4::v1::WriteRequest* request,
+                                         p4::v1::WriteResponse* response) {
+  if (options_.write_latency > absl::ZeroDuration()) {
+    absl::SleepFor(options_.write_latency);
+  }
+  std::shared_ptr<const IrP4Info> ir_p4info;
+  {
+    absl::MutexLock lock(&config_mutex_);
+    ir_p4info = ir_p4info_;
+  }
+  if (options_.validate_updates && ir_p4info == nullptr) {
+    return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                        "No P4Info was pushed to validate updates against.");
+  }
+
+  std::mt19937_64 random(options_.seed + num_writes_++);
+  std::bernoulli_distribution inject_error(
+      std::clamp(options_.update_error_rate, 0.0, 1.0));
+  IrWriteRpcStatus rpc_status;
+  IrWriteResponse& rpc_response = *rpc_status.mutable_rpc_response();
+  bool all_ok = true;
+  for (const p4::v1::Update& update : request->updates()) {
+    absl::Status status =
+        ApplyUpdate(update, ir_p4info.get(), inject_error(random));
+    IrUpdateStatus& update_status = *rpc_response.add_statuses();
+    update_status.set_code(static_cast<google::rpc::Code>(status.code()));
+    update_status.set_message(std::string(status.message()));
+    if (!status.ok()) {
+      all_ok = false;
+      ++num_failed_updates_;
+    }
+  }
+  num_updates_ += request->updates_size();
+  if (all_ok) return grpc::Status::OK;
+
+  absl::StatusOr<grpc::Status> grpc_status =
+      IrWriteRpcStatusToGrpcStatus(rpc_status);
+  if (!grpc_status.ok()) {
+    return grpc::Status(grpc::StatusCode::INTERNAL,
+                        std::string(grpc_status.status().message()));
+  }
+  return *grpc_status;
+}
+
+grpc::Status FakeP4RuntimeService::Read(
+    grpc::ServerContext* context, const p4::v1::ReadRequest* request,
+    grpc::ServerWriter<p4::v1::ReadResponse>* response_writer) {
+  if (options_.read_latency > absl::ZeroDuration()) {
+    absl::SleepFor(options_.read_latency);
+  }
+  p4::v1::ReadResponse response;
+  auto flush = [&]() -> bool {
+    if (response.entities().empty()) return true;
+    const bool written = response_writer->Write(response);
+    response.clear_entities();
+    return written;
+  };
+  for (const std::unique_ptr<Shard>& shard : shards_) {
+    absl::MutexLock lock(&shard->mutex);
+    for (const auto& [key, entity] : shard->entities) {
+      const bool requested = std::any_of(
+          request->entities().begin(), request->entities().end(),
+          [&](const p4::v1::Entity& wildcard) {
+            return IsRequested(entity, wildcard);
+          });
+      if (!requested) continue;
+      *response.add_entities() = entity;
+      if (response.entities_size() >= options_.max_entities_per_read_response &&
+          !flush()) {
+        return grpc::Status(grpc::StatusCode::CANCELLED,
+                            "Failed to write read response.");
+      }
+    }
+  }
+  if (!flush()) {
+    return grpc::Status(grpc::StatusCode::CANCELLED,
+                        "Failed to write read response.");
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeP4RuntimeService::SetForwardingPipelineConfig(
+    grpc::ServerContext* context,
+    const p4::v1::SetForwardingPipelineConfigRequest* request,
+    p4::v1::SetForwardingPipelineConfigResponse* response) {
+  std::shared_ptr<const IrP4Info> ir_p4info;
+  if (options_.validate_updates && request->config().has_p4info()) {
+    absl::StatusOr<IrP4Info> created =
+        CreateIrP4Info(request->config().p4info());
+    if (!created.ok()) {
+      return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                          std::string(created.status().message()));
+    }
+    ir_p4info = std::make_shared<const IrP4Info>(*std::move(created));
+  }
+  if (request->action() ==
+      p4::v1::SetForwardingPipelineConfigRequest::VERIFY) {
+    return grpc::Status::OK;
+  }
+  // Unlike reconciling, committing a new config starts from an empty
+  // forwarding state.
+  if (request->action() !=
+      p4::v1::SetForwardingPipelineConfigRequest::RECONCILE_AND_COMMIT) {
+    Clear();
+  }
+  absl::MutexLock lock(&config_mutex_);
+  config_ = request->config();
+  ir_p4info_ = std::move(ir_p4info);
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeP4RuntimeService::GetForwardingPipelineConfig(
+    grpc::ServerContext* context,
+    const p4::v1::GetForwardingPipelineConfigRequest* request,
+    p4::v1::GetForwardingPipelineConfigResponse* response) {
+  absl::MutexLock lock(&config_mutex_);
+  *response->mutable_config() = config_;
+  return grpc::Status::OK;
+}
+
+grpc::Status FakeP4RuntimeService::StreamChannel(
+    grpc::ServerContext* context,
+    grpc::ServerReaderWriter<p4::v1::StreamMessageResponse,
+                             p4::v1::StreamMessageRequest>* stream) {
+  p4::v1::StreamMessageRequest request;
+  while (stream->Read(&request)) {
+    if (request.has_packet()) {
+      ++num_packet_outs_;
+      continue;
+    }
+    if (!request.has_arbitration()) continue;
+
+    p4::v1::StreamMessageResponse response;
+    p4::v1::MasterArbitrationUpdate& arbitration =
+        *response.mutable_arbitration();
+    arbitration = request.arbitration();
+    {
+      absl::MutexLock lock(&arbitration_mutex_);
+      const absl::uint128 election_id =
+          ElectionId(request.arbitration().election_id());
+      if (!highest_election_id_.has_value() ||
+          election_id >= *highest_election_id_) {
+        highest_election_id_ = election_id;
+        arbitration.mutable_status()->set_code(google::rpc::OK);
+      } else {
+        arbitration.mutable_election_id()->set_high(
+            absl::Uint128High64(*highest_election_id_));
+        arbitration.mutable_election_id()->set_low(
+            absl::Uint128Low64(*highest_election_id_));
+        arbitration.mutable_status()->set_code(google::rpc::ALREADY_EXISTS);
+        arbitration.mutable_status()->set_message(
+            "A controller with a higher election id is primary.");
+      }
+    }
+    if (!stream->Write(response)) break;
+  }
+  return grpc::Status::OK;
+}
+
+std::vector<p4::v1::Entity> FakeP4RuntimeService::GetEntities() const {
+  std::vector<p4::v1::Entity> entities;
+  for (const std::unique_ptr<Shard>& shard : shards_) {
+    absl::MutexLock lock(&shard->mutex);
+    for (const auto& [key, entity] : shard->entities) {
+      entities.push_back(entity);
+    }
+  }
+  return entities;
+}
+
+int64_t FakeP4RuntimeService::EntityCount() const {
+  int64_t count = 0;
+  for (const std::unique_ptr<Shard>& shard : shards_) {
+    absl::MutexLock lock(&shard->mutex);
+    count += shard->entities.size();
+  }
+  return count;
+}
+
+}  // namespace pdpi
@@ -0,0 +1,177 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_P4_PDPI_TESTING_FAKE_P4_RUNTIME_SERVER_H_
+#define PINS_P4_PDPI_TESTING_FAKE_P4_RUNTIME_SERVER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "grpcpp/security/credentials.h"
+#include "grpcpp/server.h"
+#include "grpcpp/server_builder.h"
+#include "p4/v1/p4runtime.grpc.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace pdpi {
+
+struct FakeP4RuntimeServiceOptions {
+  // If set, every update is translated to IR against the P4Info of the last
+  // pushed forwarding pipeline config, and rejected with INVALID_ARGUMENT if
+  // that fails. Writes fail if no P4Info was pushed.
+  bool validate_updates = false;
+  // Added to every Write and Read RPC, respectively.
+  absl::Duration write_latency = absl::ZeroDuration();
+  absl::Duration read_latency = absl::ZeroDuration();
+  // Probability with which an update fails with RESOURCE_EXHAUSTED, without
+  // being applied. Failures are drawn from a generator seeded with `seed`.
+  double update_error_rate = 0;
+  uint64_t seed = 0;
+  // Entities are spread across this many independently locked shards, so that
+  // concurrent RPCs rarely contend.
+  int num_shards = 16;
+  // The maximum number of entities in a single ReadResponse.
+  int max_entities_per_read_response = 1000;
+};
+
+// An in-memory P4Runtime service, e.g. to load-test P4Runtime clients without
+// a switch. Entities are stored by their `EntityKey`; only table entries and
+// packet replication engine entries are supported. Writes are applied in
+// order, update by update, and report per-update errors like a switch.
+// Stream channels perform arbitration, where the highest election id seen so
+// far is primary, and otherwise ignore requests.
+//
+// Thread-safe.
+class FakeP4RuntimeService final : public p4::v1::P4Runtime::Service {
+ public:
+  explicit FakeP4RuntimeService(FakeP4RuntimeServiceOptions options = {});
+
+  grpc::Status Write(grpc::ServerContext* context,
+                     const p4::v1::WriteRequest* request,
+                     p4::v1::WriteResponse* response) override;
+
+  grpc::Status Read(
+      grpc::ServerContext* context, const p4::v1::ReadRequest* request,
+      grpc::ServerWriter<p4::v1::ReadResponse>* response_writer) override;
+
+  grpc::Status SetForwardingPipelineConfig(
+      grpc::ServerContext* context,
+      const p4::v1::SetForwardingPipelineConfigRequest* request,
+      p4::v1::SetForwardingPipelineConfigResponse* response) override;
+
+  grpc::Status GetForwardingPipelineConfig(
+      grpc::ServerContext* context,
+      const p4::v1::GetForwardingPipelineConfigRequest* request,
+      p4::v1::GetForwardingPipelineConfigResponse* response) override;
+
+  grpc::Status StreamChannel(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<p4::v1::StreamMessageResponse,
+                               p4::v1::StreamMessageRequest>* stream) override;
+
+  // Returns all stored entities, in no particular order.
+  std::vector<p4::v1::Entity> GetEntities() const;
+  // Returns the number of stored entities.
+  int64_t EntityCount() const;
+
+  // Counters since construction.
+  int64_t NumUpdates() const { return num_updates_; }
+  int64_t NumFailedUpdates() const { return num_failed_updates_; }
+  int64_t NumPacketOuts() const { return num_packet_outs_; }
+
+ private:
+  struct Shard {
+    mutable absl::Mutex mutex;
+    absl::flat_hash_map<EntityKey, p4::v1::Entity> entities
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  // Applies `update` to the store, unless it fails or an error is injected.
+  absl::Status ApplyUpdate(const p4::v1::Update& update,
+                           const IrP4Info* ir_p4info, bool inject_error);
+
+  Shard& ShardOf(const EntityKey& key);
+  void Clear();
+
+  const FakeP4RuntimeServiceOptions options_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  mutable absl::Mutex config_mutex_;
+  p4::v1::ForwardingPipelineConfig config_ ABSL_GUARDED_BY(config_mutex_);
+  // Set when the config has a P4Info and `validate_updates` is set. Shared so
+  // that writes keep using a consistent P4Info while it is being replaced.
+  std::shared_ptr<const IrP4Info> ir_p4info_ ABSL_GUARDED_BY(config_mutex_);
+
+  absl::Mutex arbitration_mutex_;
+  std::optional<absl::uint128> highest_election_id_
+      ABSL_GUARDED_BY(arbitration_mutex_);
+
+  std::atomic<uint64_t> num_writes_ = 0;
+  std::atomic<int64_t> num_updates_ = 0;
+  std::atomic<int64_t> num_failed_updates_ = 0;
+  std::atomic<int64_t> num_packet_outs_ = 0;
+};
+
+// A P4Runtime server running on `localhost` whose underlying P4Runtime service
+// is a `FakeP4RuntimeService`.
+class FakeP4RuntimeServer {
+ public:
+  // Starts up the server on `localhost`.
+  explicit FakeP4RuntimeServer(FakeP4RuntimeServiceOptions options = {})
+      : service_(options) {}
+
+  // Returns underlying service.
+  FakeP4RuntimeService& service() { return service_; }
+
+  // Returns client-side credentials for connecting to this server.
+  std::shared_ptr<grpc::ChannelCredentials> channel_credentials() const {
+    return channel_credentials_;
+  }
+
+  // Returns port on which this server is reachable.
+  int port() const { return port_; }
+
+  // Returns address at which this server is reachable.
+  const std::string& address() const { return address_; }
+
+ private:
+  FakeP4RuntimeService service_;
+  std::shared_ptr<grpc::ChannelCredentials> channel_credentials_ =
+      grpc::experimental::LocalCredentials(LOCAL_TCP);
+  std::shared_ptr<grpc::ServerCredentials> server_credentials_ =
+      grpc::experimental::LocalServerCredentials(LOCAL_TCP);
+  std::unique_ptr<grpc::Server> server_ =
+      grpc::ServerBuilder()
+          .AddListeningPort("[::]:0", server_credentials_, &port_)
+          .RegisterService(&service_)
+          .BuildAndStart();
+  int port_;  // Initialized by the `ServerBuilder` above.
+  std::string address_ = absl::StrCat("localhost:", port_);
+};
+
+}  // namespace pdpi
+
+#endif  // PINS_P4_PDPI_TESTING_FAKE_P4_RUNTIME_SERVER_H_
@@ -0,0 +1,148 @@
+#include "p4_pdpi/testing/mock_p4_runtime_server.h"
+
+#include <memory>
+
+#include "gmock/gmock.h"
+#include "grpcpp/channel.h"
+#include "grpcpp/client_context.h"
+#include "grpcpp/create_channel.h"
+#include "gtest/gtest.h"
+#include "p4/v1/p4runtime.grpc.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+
+namespace pdpi {
+namespace {
+#include "p4_pdpi/testing/fake_p4_runtime_server.h"
+
+#include <memory>
+
+#include "gmock/gmock.h"
+#include "grpcpp/client_context.h"
+#include "grpcpp/create_channel.h"
+#include "grpcpp/support/status.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/testing.h"
+#include "p4/v1/p4runtime.grpc.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+
+namespace pdpi {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::p4::v1::P4Runtime;
+using ::p4::v1::ReadRequest;
+using ::p4::v1::ReadResponse;
+using ::p4::v1::StreamMessageRequest;
+using ::p4::v1::StreamMessageResponse;
+using ::p4::v1::WriteRequest;
+using ::p4::v1::WriteResponse;
+using ::testing::ElementsAre;
+
+std::unique_ptr<P4Runtime::Stub> ConnectTo(const FakeP4RuntimeServer& server) {
+  return P4Runtime::NewStub(
+      grpc::CreateChannel(server.address(), server.channel_credentials()));
+}
+
+// Returns a write request with a single update of the given type, for a table
+// entry that is keyed by `priority`.
+WriteRequest WriteOf(p4::v1::Update::Type type, int priority = 1) {
+  WriteRequest request = gutil::ParseProtoOrDie<WriteRequest>(R"pb(
+    updates {
+      entity {
+        table_entry {
+          table_id: 1
+          match {
+            field_id: 1
+            ternary { value: "\x01" mask: "\xff" }
+          }
+          action { action { action_id: 1 } }
+        }
+      }
+    }
+  )pb");
+  request.mutable_updates(0)->set_type(type);
+  request.mutable_updates(0)
+      ->mutable_entity()
+      ->mutable_table_entry()
+      ->set_priority(priority);
+  return request;
+}
+
+grpc::Status Write(P4Runtime::Stub& stub, const WriteRequest& request) {
+  grpc::ClientContext context;
+  WriteResponse response;
+  return stub.Write(&context, request, &response);
+}
+
+TEST(FakeP4RuntimeServerTest, ReadsBackWrittenEntities) {
+  FakeP4RuntimeServer server;
+  std::unique_ptr<P4Runtime::Stub> stub = ConnectTo(server);
+  const WriteRequest insert = WriteOf(p4::v1::Update::INSERT);
+  ASSERT_TRUE(Write(*stub, insert).ok());
+  EXPECT_EQ(server.service().EntityCount(), 1);
+
+  grpc::ClientContext context;
+  ReadRequest request;
+  request.add_entities()->mutable_table_entry();
+  auto response_stream = stub->Read(&context, request);
+  ReadResponse response;
+  ASSERT_TRUE(response_stream->Read(&response));
+  EXPECT_THAT(response.entities(),
+              ElementsAre(EqualsProto(insert.updates(0).entity())));
+  EXPECT_FALSE(response_stream->Read(&response));
+  EXPECT_TRUE(response_stream->Finish().ok());
+}
+
+TEST(FakeP4RuntimeServerTest, RejectsDuplicateInsertsAndMissingDeletes) {
+  FakeP4RuntimeServer server;
+  std::unique_ptr<P4Runtime::Stub> stub = ConnectTo(server);
+  ASSERT_TRUE(Write(*stub, WriteOf(p4::v1::Update::INSERT)).ok());
+  EXPECT_EQ(Write(*stub, WriteOf(p4::v1::Update::INSERT)).error_code(),
+            grpc::StatusCode::UNKNOWN);
+  EXPECT_TRUE(Write(*stub, WriteOf(p4::v1::Update::DELETE)).ok());
+  EXPECT_EQ(Write(*stub, WriteOf(p4::v1::Update::DELETE)).error_code(),
+            grpc::StatusCode::UNKNOWN);
+  EXPECT_EQ(server.service().EntityCount(), 0);
+  EXPECT_EQ(server.service().NumUpdates(), 4);
+  EXPECT_EQ(server.service().NumFailedUpdates(), 2);
+}
+
+TEST(FakeP4RuntimeServerTest, InjectsErrors) {
+  FakeP4RuntimeServer server({.update_error_rate = 1});
+  std::unique_ptr<P4Runtime::Stub> stub = ConnectTo(server);
+  EXPECT_FALSE(Write(*stub, WriteOf(p4::v1::Update::INSERT)).ok());
+  EXPECT_EQ(server.service().EntityCount(), 0);
+  EXPECT_EQ(server.service().NumFailedUpdates(), 1);
+}
+
+TEST(FakeP4RuntimeServerTest, ValidatesUpdatesOnlyAfterAP4InfoWasPushed) {
+  FakeP4RuntimeServer server({.validate_updates = true});
+  std::unique_ptr<P4Runtime::Stub> stub = ConnectTo(server);
+  EXPECT_EQ(Write(*stub, WriteOf(p4::v1::Update::INSERT)).error_code(),
+            grpc::StatusCode::FAILED_PRECONDITION);
+}
+
+TEST(FakeP4RuntimeServerTest, HighestElectionIdIsPrimary) {
+  FakeP4RuntimeServer server;
+  std::unique_ptr<P4Runtime::Stub> stub = ConnectTo(server);
+  auto arbitrate = [&](int election_id) {
+    grpc::ClientContext context;
+    auto stream = stub->StreamChannel(&context);
+    StreamMessageRequest request;
+    request.mutable_arbitration()->set_device_id(1);
+    request.mutable_arbitration()->mutable_election_id()->set_low(election_id);
+    EXPECT_TRUE(stream->Write(request));
+    StreamMessageResponse response;
+    EXPECT_TRUE(stream->Read(&response));
+    stream->WritesDone();
+    EXPECT_TRUE(stream->Finish().ok());
+    return response.arbitration().status().code();
+  };
+  EXPECT_EQ(arbitrate(2), google::rpc::OK);
+  EXPECT_EQ(arbitrate(1), google::rpc::ALREADY_EXISTS);
+  EXPECT_EQ(arbitrate(3), google::rpc::OK);
+}
+
+}  // namespace
+}  // namespace pdpi
@@ -7,12 +7,14 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "gmock/gmock.h"
+#include "google/protobuf/arena.h"
 #include "gtest/gtest.h"
 #include "gutil/proto.h"
 #include "gutil/proto_matchers.h"
 #include "gutil/status.h"
 #include "gutil/status_matchers.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/pd.h"
@@ -24,6 +26,7 @@ namespace pdpi {
 namespace {
 
 using gutil::EqualsProto;
+using gutil::IsOkAndHolds;
 using gutil::StatusIs;
 using testing::Eq;
 using testing::SizeIs;
@@ -205,6 +208,146 @@ TEST_P(VectorTranslationTest,
   }
 }
 
+TEST_P(VectorTranslationTest, ArenaTranslationsEqualHeapTranslations) {
+  const TranslationOptions options = GetParam();
+  const auto& info = GetTestIrP4Info();
+  ASSERT_OK_AND_ASSIGN(IrEntities ir_entities, ValidIrEntities());
+  ASSERT_OK_AND_ASSIGN(std::vector<p4::v1::Entity> pi_entities,
+                       IrEntitiesToPi(info, ir_entities, options));
+  std::vector<p4::v1::TableEntry> pi_entries;
+  for (const p4::v1::Entity& pi_entity : pi_entities) {
+    if (pi_entity.has_table_entry()) {
+      pi_entries.push_back(pi_entity.table_entry());
+    }
+  }
+
+  google::protobuf::Arena arena;
+  ASSERT_OK_AND_ASSIGN(std::vector<p4::v1::Entity*> arena_pi_entities,
+                       IrEntitiesToPi(info, ir_entities, &arena, options));
+  ASSERT_EQ(arena_pi_entities.size(), pi_entities.size());
+  for (int i = 0; i < pi_entities.size(); ++i) {
+    EXPECT_EQ(arena_pi_entities[i]->GetArena(), &arena);
+    EXPECT_THAT(*arena_pi_entities[i], EqualsProto(pi_entities[i]));
+  }
+
+  ASSERT_OK_AND_ASSIGN(IrEntities expected_ir_entities,
+                       PiEntitiesToIr(info, pi_entities, options));
+  ASSERT_OK_AND_ASSIGN(IrEntities * arena_ir_entities,
+                       PiEntitiesToIr(info, pi_entities, &arena, options));
+  EXPECT_EQ(arena_ir_entities->GetArena(), &arena);
+  EXPECT_THAT(*arena_ir_entities, EqualsProto(expected_ir_entities));
+
+  ASSERT_OK_AND_ASSIGN(IrTableEntries expected_ir_entries,
+                       PiTableEntriesToIr(info, pi_entries, options));
+  ASSERT_OK_AND_ASSIGN(IrTableEntries * arena_ir_entries,
+                       PiTableEntriesToIr(info, pi_entries, &arena, options));
+  EXPECT_EQ(arena_ir_entries->GetArena(), &arena);
+  EXPECT_THAT(*arena_ir_entries, EqualsProto(expected_ir_entries));
+}
+
+TEST_P(VectorTranslationTest, CompiledIrP4InfoTranslatesLikeTheIrP4Info) {
+  const TranslationOptions options = GetParam();
+  const auto& info = GetTestIrP4Info();
+  const CompiledIrP4Info compiled(info);
+  ASSERT_OK_AND_ASSIGN(IrEntities ir_entities, ValidIrEntities());
+
+  for (const IrEntity& ir_entity : ir_entities.entities()) {
+    SCOPED_TRACE(absl::StrCat("ir entity = ", ir_entity.DebugString()));
+    ASSERT_OK_AND_ASSIGN(p4::v1::Entity expected_pi,
+                         IrEntityToPi(info, ir_entity, options));
+    ASSERT_OK_AND_ASSIGN(p4::v1::Entity pi,
+                         IrEntityToPi(compiled, ir_entity, options));
+    EXPECT_THAT(pi, EqualsProto(expected_pi));
+
+    ASSERT_OK_AND_ASSIGN(IrEntity expected_ir,
+                         PiEntityToIr(info, expected_pi, options));
+    EXPECT_THAT(PiEntityToIr(compiled, expected_pi, options),
+                IsOkAndHolds(EqualsProto(expected_ir)));
+  }
+}
+
+TEST_P(VectorTranslationTest, MemoizedActionsTranslateLikeTheIrP4Info) {
+  const TranslationOptions options = GetParam();
+  const auto& info = GetTestIrP4Info();
+  const CompiledIrP4Info compiled(info, /*action_cache_capacity=*/16);
+  ASSERT_OK_AND_ASSIGN(IrTableEntries ir_entries, ValidIrTableEntries());
+
+  // The second round translates the actions from the cache.
+  for (int round = 0; round < 2; ++round) {
+    for (const IrTableEntry& ir_entry : ir_entries.entries()) {
+      SCOPED_TRACE(absl::StrCat("ir entry = ", ir_entry.DebugString()));
+      ASSERT_OK_AND_ASSIGN(p4::v1::TableEntry pi,
+                           IrTableEntryToPi(info, ir_entry, options));
+      ASSERT_OK_AND_ASSIGN(IrTableEntry expected_ir,
+                           PiTableEntryToIr(info, pi, options));
+      EXPECT_THAT(PiTableEntryToIr(compiled, pi, options),
+                  IsOkAndHolds(EqualsProto(expected_ir)));
+    }
+  }
+  if (!options.key_only) EXPECT_GT(compiled.action_cache()->num_hits(), 0);
+}
+
+TEST_P(VectorTranslationTest, CompiledIrP4InfoReportsTheSameErrors) {
+  const TranslationOptions options = GetParam();
+  const auto& info = GetTestIrP4Info();
+  const CompiledIrP4Info compiled(info);
+  ASSERT_OK_AND_ASSIGN(IrTableEntries ir_entries, ValidIrTableEntries());
+
+  for (const IrTableEntry& ir_entry : ir_entries.entries()) {
+    ASSERT_OK_AND_ASSIGN(p4::v1::TableEntry pi,
+                         IrTableEntryToPi(info, ir_entry, options));
+    p4::v1::TableEntry bad_pi = pi;
+    bad_pi.mutable_match(0)->set_field_id(0xffff);
+    EXPECT_EQ(PiTableEntryToIr(compiled, bad_pi, options).status(),
+              PiTableEntryToIr(info, bad_pi, options).status());
+    bad_pi.set_table_id(0xffffff);
+    EXPECT_EQ(PiTableEntryToIr(compiled, bad_pi, options).status(),
+              PiTableEntryToIr(info, bad_pi, options).status());
+
+    IrTableEntry bad_ir = ir_entry;
+    bad_ir.mutable_matches(0)->set_name("unknown_field");
+    EXPECT_EQ(IrTableEntryToPi(compiled, bad_ir, options).status(),
+              IrTableEntryToPi(info, bad_ir, options).status());
+  }
+}
+
+TEST_P(VectorTranslationTest, TrustedInputsTranslateLikeValidatedInputs) {
+  const TranslationOptions options = GetParam();
+  TranslationOptions trusted_options = options;
+  trusted_options.trusted_input = true;
+  const auto& info = GetTestIrP4Info();
+  ASSERT_OK_AND_ASSIGN(IrTableEntries ir_entries, ValidIrTableEntries());
+
+  for (const IrTableEntry& ir_entry : ir_entries.entries()) {
+    SCOPED_TRACE(absl::StrCat("ir entry = ", ir_entry.DebugString()));
+    ASSERT_OK_AND_ASSIGN(p4::v1::TableEntry pi,
+                         IrTableEntryToPi(info, ir_entry, options));
+    EXPECT_THAT(IrTableEntryToPi(info, ir_entry, trusted_options),
+                IsOkAndHolds(EqualsProto(pi)));
+    ASSERT_OK_AND_ASSIGN(IrTableEntry expected_ir,
+                         PiTableEntryToIr(info, pi, options));
+    EXPECT_THAT(PiTableEntryToIr(info, pi, trusted_options),
+                IsOkAndHolds(EqualsProto(expected_ir)));
+  }
+}
+
+#ifndef NDEBUG
+TEST_P(VectorTranslationTest, TrustedInputsAreStillValidatedInDebugBuilds) {
+  TranslationOptions trusted_options = GetParam();
+  trusted_options.trusted_input = true;
+  const auto& info = GetTestIrP4Info();
+  ASSERT_OK_AND_ASSIGN(IrTableEntries ir_entries, ValidIrTableEntries());
+
+  for (const IrTableEntry& ir_entry : ir_entries.entries()) {
+    ASSERT_OK_AND_ASSIGN(p4::v1::TableEntry pi,
+                         IrTableEntryToPi(info, ir_entry, trusted_options));
+    *pi.add_match() = pi.match(0);
+    EXPECT_THAT(PiTableEntryToIr(info, pi, trusted_options),
+                StatusIs(absl::StatusCode::kInvalidArgument));
+  }
+}
+#endif
+
 using PdToPiRoundtripTest = testing::TestWithParam<pdpi::TranslationOptions>;
 
 TEST_P(PdToPiRoundtripTest, PartialEntriesTranslationRoundrips) {
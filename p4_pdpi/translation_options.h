@@ -28,12 +28,20 @@ struct TranslationOptions {
   // `@unsupported` annotation. Useful during early-stage testing.
   bool allow_unsupported = false;
 
+  // The input was produced, or already validated, by PDPI. E.g. entries that
+  // P4RT wrote to the AppDb itself and now reads back. Checks that only guard
+  // against malformed input are skipped: duplicate and missing match fields
+  // and params, actions that are not valid for the table, and masked bits set
+  // in LPM and ternary values. Builds without NDEBUG still run every check.
+  bool trusted_input = false;
+
   template <typename Sink>
   friend void AbslStringify(Sink& sink, TranslationOptions options) {
-    absl::Format(
-        &sink,
-        "pdpi::TranslationOptions{.key_only = %v, .allow_unsupported = %v}",
-        options.key_only, options.allow_unsupported);
+    absl::Format(&sink,
+                 "pdpi::TranslationOptions{.key_only = %v, .allow_unsupported "
+                 "= %v, .trusted_input = %v}",
+                 options.key_only, options.allow_unsupported,
+                 options.trusted_input);
   }
 };
 
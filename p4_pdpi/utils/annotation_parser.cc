@@ -22,6 +22,8 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "gutil/status.h"
 
 namespace pdpi {
@@ -176,4 +178,65 @@ absl::StatusOr<std::vector<std::string>> ParseAsArgList(std::string value) {
 }
 
 }  // namespace annotation
+
+void AnnotationIndex::Add(const std::string& annotation) {
+  absl::StatusOr<annotation::AnnotationComponents> components =
+      ParseAnnotation(annotation);
+  if (!components.ok()) return;  // Skip unknown labels.
+
+  absl::StatusOr<std::vector<std::string>> arg_list =
+      annotation::ParseAsArgList(components->body);
+  annotations_by_label_[components->label].push_back(
+      Annotation{.annotation = annotation,
+                 .body = std::move(components->body),
+                 .arg_list = std::move(arg_list)});
+}
+
+absl::Span<const AnnotationIndex::Annotation> AnnotationIndex::Find(
+    absl::string_view label) const {
+  auto it = annotations_by_label_.find(label);
+  if (it == annotations_by_label_.end()) return {};
+  return it->second;
+}
+
+absl::StatusOr<std::vector<std::vector<std::string>>>
+GetAllAnnotationsAsArgList(absl::string_view label,
+                           const AnnotationIndex& annotations) {
+  std::vector<std::vector<std::string>> values;
+  for (const AnnotationIndex::Annotation& annotation :
+       annotations.Find(label)) {
+    ASSIGN_OR_RETURN(
+        std::vector<std::string> value, annotation.arg_list,
+        _ << "Failed to parse annotation \"" << annotation.annotation << "\"");
+    values.push_back(std::move(value));
+  }
+  return values;
+}
+
+absl::StatusOr<std::vector<std::string>> GetAnnotationAsArgList(
+    absl::string_view label, const AnnotationIndex& annotations) {
+  ASSIGN_OR_RETURN(std::vector<std::vector<std::string>> values,
+                   GetAllAnnotationsAsArgList(label, annotations));
+  if (values.empty()) {
+    return gutil::NotFoundErrorBuilder()
+           << "No annotations contained label \"" << label << "\"";
+  }
+  if (values.size() > 1) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Multiple annotations contained label \"" << label << "\"";
+  }
+  return std::move(values[0]);
+}
+
+absl::StatusOr<std::string> GetAnnotationBody(
+    absl::string_view label, const AnnotationIndex& annotations) {
+  return GetParsedAnnotation<std::string>(label, annotations, annotation::Raw);
+}
+
+absl::StatusOr<std::vector<std::string>> GetAllAnnotationBodies(
+    absl::string_view label, const AnnotationIndex& annotations) {
+  return GetAllParsedAnnotations<std::string>(label, annotations,
+                                              annotation::Raw);
+}
+
 }  // namespace pdpi
@@ -22,8 +22,10 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "gutil/status.h"
 
 // This header file defines libraries for parsing P4 annotations.
@@ -68,6 +70,41 @@ struct AnnotationComponents {
 absl::StatusOr<annotation::AnnotationComponents> ParseAnnotation(
     const std::string& annotation);
 
+// The annotations of a P4Info element (e.g. a table or an action parameter),
+// parsed once and indexed by label.
+//
+// The functions below accept an AnnotationIndex in place of a container of
+// annotation strings. Looking up a label is then a hash lookup, and the body of
+// each annotation is split into an argument list only once, when the index is
+// built. Use an index when several labels are looked up on the same element.
+// Annotations that do not follow the @<label>(<body>) format are skipped, as
+// they are by the container-based functions.
+class AnnotationIndex {
+ public:
+  struct Annotation {
+    // The annotation as written, used in error messages.
+    std::string annotation;
+    std::string body;
+    // The result of `annotation::ParseAsArgList(body)`.
+    absl::StatusOr<std::vector<std::string>> arg_list;
+  };
+
+  AnnotationIndex() = default;
+  template <typename Container>
+  explicit AnnotationIndex(const Container& annotations) {
+    for (const auto& annotation : annotations) Add(annotation);
+  }
+
+  // Returns the annotations with the given label, in their original order.
+  absl::Span<const Annotation> Find(absl::string_view label) const;
+
+ private:
+  void Add(const std::string& annotation);
+
+  absl::flat_hash_map<std::string, std::vector<Annotation>>
+      annotations_by_label_;
+};
+
 // Returns a list of all annotations split into label & body.
 // Skips annotations that do not follow the expected @<label>(<body>) format.
 template <typename Container>
@@ -112,6 +149,22 @@ absl::StatusOr<std::vector<T>> GetAllParsedAnnotations(
   return values;
 }
 
+// Same as above, but for indexed annotations.
+template <typename T>
+absl::StatusOr<std::vector<T>> GetAllParsedAnnotations(
+    absl::string_view label, const AnnotationIndex& annotations,
+    annotation::BodyParser<T> parser) {
+  std::vector<T> values;
+  for (const AnnotationIndex::Annotation& annotation :
+       annotations.Find(label)) {
+    ASSIGN_OR_RETURN(
+        T value, parser(annotation.body),
+        _ << "Failed to parse annotation \"" << annotation.annotation << "\"");
+    values.push_back(std::move(value));
+  }
+  return values;
+}
+
 // Returns the parsed body of the unique annotation with the given label.
 // Returns a Status with code kNotFound if there is no matching annotation.
 // Returns a Status with code kInvalidArgument if there are multiple matching
@@ -142,6 +195,24 @@ absl::StatusOr<T> GetParsedAnnotation(absl::string_view label,
   return values[0];
 }
 
+// Same as above, but for indexed annotations.
+template <typename T>
+absl::StatusOr<T> GetParsedAnnotation(absl::string_view label,
+                                      const AnnotationIndex& annotations,
+                                      annotation::BodyParser<T> parser) {
+  ASSIGN_OR_RETURN(std::vector<T> values,
+                   GetAllParsedAnnotations<T>(label, annotations, parser));
+  if (values.empty()) {
+    return gutil::NotFoundErrorBuilder()
+           << "No annotations contained label \"" << label << "\"";
+  }
+  if (values.size() > 1) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Multiple annotations contained label \"" << label << "\"";
+  }
+  return std::move(values[0]);
+}
+
 // Returns the body of an annotation with the unique label as a list of strings.
 // Returns an empty list if the matching annotation has no arguments.
 // Returns a Status with code kNotFound if there is no matching annotation.
@@ -178,6 +249,18 @@ absl::StatusOr<std::vector<std::string>> GetAllAnnotationBodies(
                                               annotation::Raw);
 }
 
+// Same as the functions above, but for indexed annotations. Argument lists are
+// not re-parsed.
+absl::StatusOr<std::vector<std::string>> GetAnnotationAsArgList(
+    absl::string_view label, const AnnotationIndex& annotations);
+absl::StatusOr<std::vector<std::vector<std::string>>>
+GetAllAnnotationsAsArgList(absl::string_view label,
+                           const AnnotationIndex& annotations);
+absl::StatusOr<std::string> GetAnnotationBody(
+    absl::string_view label, const AnnotationIndex& annotations);
+absl::StatusOr<std::vector<std::string>> GetAllAnnotationBodies(
+    absl::string_view label, const AnnotationIndex& annotations);
+
 }  // namespace pdpi
 
 #endif  // _COMMON_ANNOTATION_PARSER_H_
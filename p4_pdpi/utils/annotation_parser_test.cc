@@ -541,6 +541,73 @@ INSTANTIATE_TEST_SUITE_P(
       return UnpairedCharacterCasesName(info.param);
     });
 
+// === AnnotationIndex ===
+
+TEST(AnnotationIndex, FindsAnnotationsByLabelInOrder) {
+  const std::vector<std::string> annotations = {
+      "@label(a, b)", "not an annotation", "@other(c)", "  @label ( d )  "};
+  const AnnotationIndex index(annotations);
+
+  EXPECT_THAT(
+      GetAllAnnotationsAsArgList("label", index),
+      IsOkAndHolds(ElementsAre(ElementsAre("a", "b"), ElementsAre("d"))));
+  EXPECT_THAT(GetAllAnnotationBodies("label", index),
+              IsOkAndHolds(ElementsAre("a, b", " d ")));
+  EXPECT_THAT(GetAnnotationAsArgList("other", index),
+              IsOkAndHolds(ElementsAre("c")));
+  EXPECT_THAT(GetAnnotationBody("other", index), IsOkAndHolds("c"));
+  EXPECT_THAT(GetAllAnnotationBodies("missing", index),
+              IsOkAndHolds(IsEmpty()));
+}
+
+TEST(AnnotationIndex, MatchesContainerBasedLookups) {
+  const std::vector<std::string> annotations = {
+      "@label(a, (b, c))", "@label", "@single(\"x, y\")", "@bad(a))"};
+  const AnnotationIndex index(annotations);
+
+  for (const std::string label : {"label", "single", "bad", "missing"}) {
+    SCOPED_TRACE(label);
+    absl::StatusOr<std::vector<std::vector<std::string>>> all_arg_lists =
+        GetAllAnnotationsAsArgList(label, annotations);
+    absl::StatusOr<std::vector<std::vector<std::string>>>
+        indexed_all_arg_lists = GetAllAnnotationsAsArgList(label, index);
+    EXPECT_EQ(indexed_all_arg_lists.status(), all_arg_lists.status());
+    if (all_arg_lists.ok() && indexed_all_arg_lists.ok()) {
+      EXPECT_EQ(*indexed_all_arg_lists, *all_arg_lists);
+    }
+
+    absl::StatusOr<std::vector<std::string>> arg_list =
+        GetAnnotationAsArgList(label, annotations);
+    absl::StatusOr<std::vector<std::string>> indexed_arg_list =
+        GetAnnotationAsArgList(label, index);
+    EXPECT_EQ(indexed_arg_list.status(), arg_list.status());
+    if (arg_list.ok() && indexed_arg_list.ok()) {
+      EXPECT_EQ(*indexed_arg_list, *arg_list);
+    }
+
+    EXPECT_EQ(GetAnnotationBody(label, index).status(),
+              GetAnnotationBody(label, annotations).status());
+  }
+}
+
+TEST(AnnotationIndex, ParsesBodiesWithCustomParsers) {
+  const std::vector<std::string> annotations = {"@num(1)", "@num(2)",
+                                                "@other(3)"};
+  const AnnotationIndex index(annotations);
+  auto parse_int = [](std::string body) -> absl::StatusOr<int> {
+    return std::stoi(body);
+  };
+
+  EXPECT_THAT(GetAllParsedAnnotations<int>("num", index, parse_int),
+              IsOkAndHolds(ElementsAre(1, 2)));
+  EXPECT_THAT(GetParsedAnnotation<int>("other", index, parse_int),
+              IsOkAndHolds(3));
+  EXPECT_THAT(GetParsedAnnotation<int>("num", index, parse_int),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(GetParsedAnnotation<int>("missing", index, ExpectNoParsing),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
 }  // namespace
 }  // namespace annotation
 }  // namespace pdpi
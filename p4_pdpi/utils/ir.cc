@@ -53,6 +53,7 @@
 #include "p4_pdpi/netaddr/ipv4_address.h"
 #include "p4_pdpi/netaddr/ipv6_address.h"
 #include "p4_pdpi/netaddr/mac_address.h"
+#include "p4_pdpi/string_encodings/hex_string.h"
 
 namespace pdpi {
 
@@ -221,15 +222,18 @@ absl::StatusOr<IrValue> ArbitraryByteStringToIrValue(Format format,
     case Format::HEX_STRING: {
       ASSIGN_OR_RETURN(std::string normalized_bytes,
                        ArbitraryToNormalizedByteString(bytes, bitwidth));
-      std::string hex_string = absl::BytesToHexString(normalized_bytes);
+      std::string &hex_string = *result.mutable_hex_str();
+      hex_string.resize(2 + 2 * normalized_bytes.size());
+      hex_string[0] = '0';
+      hex_string[1] = 'x';
+      ByteStringToHexDigits(normalized_bytes, hex_string.data() + 2);
       const int expected_num_hex_chars =
           bitwidth / 4 + (bitwidth % 4 != 0 ? 1 : 0);
-      if (expected_num_hex_chars != hex_string.size()) {
-        // absl::BytesToHexString operates on bytes (= 8 bits), but we want to
+      if (expected_num_hex_chars + 2 != hex_string.size()) {
+        // The hex digits are written per byte (= 8 bits), but we want to
         // operate on nibbles (= 4 bits). This fixes the length as necessary.
-        hex_string = hex_string.substr(1);
+        hex_string.erase(2, 1);
       }
-      result.set_hex_str(absl::StrCat("0x", hex_string));
       return result;
     }
     default:
@@ -359,8 +363,8 @@ absl::StatusOr<std::string> IrValueToNormalizedByteString(
                << "' contains non-hexadecimal characters.";
       }
 
-      std::string byte_string = absl::HexStringToBytes(
-          absl::StrCat(stripped_hex.size() % 2 == 0 ? "" : "0", stripped_hex));
+      std::string byte_string((stripped_hex.size() + 1) / 2, '\0');
+      HexDigitsToByteString(stripped_hex, byte_string.data());
       return ArbitraryToNormalizedByteString(byte_string, bitwidth);
     }
     case IrValue::FORMAT_NOT_SET:
@@ -0,0 +1,417 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks for the stages of P4-Symbolic, as a function of the number of
+// table entries: building the IR, evaluating the pipeline symbolically,
+// solving for a packet, and extracting it from the model. Entries are
+// synthesized for every table of the given programs, from 10 up to
+// --max_entries_per_table entries per table.
+//
+// Programs are given as bmv2 JSON and P4Info files, e.g. the p4c output for the
+// programs in p4_symbolic/testdata or for SAI P4 middleblock:
+//   bazel run -c opt //p4_symbolic/benchmarks -- \
+//     --programs=middleblock:<dir>/middleblock.bmv2.json:<dir>/p4info.pb.txt
+// Every benchmark over entries reports its fitted complexity (the scaling
+// curve), and the peak resident memory of the process so far.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "benchmark/benchmark.h"
+#include "glog/logging.h"
+#include "gutil/proto.h"
+#include "gutil/status.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/string_encodings/byte_string.h"
+#include "p4_symbolic/ir/ir.pb.h"
+#include "p4_symbolic/ir/ir_cache.h"
+#include "p4_symbolic/ir/table_entries.h"
+#include "p4_symbolic/symbolic/solver_state_cache.h"
+#include "p4_symbolic/symbolic/symbolic.h"
+#include "p4_symbolic/symbolic/util.h"
+#include "z3++.h"
+
+ABSL_FLAG(std::vector<std::string>, programs, {},
+          "The programs to benchmark, as comma separated "
+          "<name>:<bmv2 JSON file>:<P4Info text proto file> triples.");
+ABSL_FLAG(int, max_entries_per_table, 100000,
+          "The largest number of entries per table to benchmark with.");
+ABSL_FLAG(bool, hardcoded_parser, false,
+          "Whether to constrain the packet with the hardcoded parser.");
+ABSL_FLAG(std::string, ir_cache_directory, "/tmp",
+          "The directory of the IR cache used by BM_BuildIrFromCache.");
+ABSL_FLAG(std::string, solver_state_cache_directory, "/tmp",
+          "The directory of the solver state cache used by "
+          "BM_EvaluateP4PipelineFromCache.");
+
+namespace p4_symbolic {
+namespace {
+
+// The physical ports of the benchmarked switch.
+const std::vector<int> &PhysicalPorts() {
+  static const std::vector<int> *const kPorts =
+      new std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7};
+  return *kPorts;
+}
+
+// A program to benchmark.
+struct Program {
+  std::string name;
+  std::string bmv2_json_path;
+  p4::config::v1::P4Info p4info;
+  pdpi::IrP4Info ir_p4info;
+  ir::P4Program ir;
+};
+
+absl::StatusOr<Program> LoadProgram(const std::string &flag_value) {
+  std::vector<std::string> parts = absl::StrSplit(flag_value, ':');
+  if (parts.size() != 3) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "expected <name>:<bmv2 JSON file>:<P4Info file>, but got '"
+           << flag_value << "'";
+  }
+  Program program{.name = parts[0], .bmv2_json_path = parts[1]};
+  RETURN_IF_ERROR(gutil::ReadProtoFromFile(parts[2], &program.p4info));
+  ASSIGN_OR_RETURN(program.ir_p4info, pdpi::CreateIrP4Info(program.p4info));
+  ASSIGN_OR_RETURN(program.ir, ir::Bmv2JsonFileAndP4infoToIr(
+                                   program.bmv2_json_path, program.p4info));
+  return program;
+}
+
+// Returns the P4Runtime byte string of the lowest `bitwidth` bits of `value`.
+std::string UintToByteString(uint64_t value, int bitwidth) {
+  if (bitwidth < 64) value &= (uint64_t{1} << bitwidth) - 1;
+  std::string bytes(std::max(1, (bitwidth + 7) / 8), '\0');
+  for (int i = bytes.size() - 1; i >= 0 && value != 0; --i) {
+    bytes[i] = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+  return pdpi::ByteStringToP4runtimeByteString(bytes);
+}
+
+// Returns the `index`-th value of a field of the given bitwidth and format.
+std::string Value(int index, int bitwidth, pdpi::Format format) {
+  if (format == pdpi::STRING) return absl::StrCat("value-", index);
+  return UintToByteString(index, bitwidth);
+}
+
+// Synthesizes up to `entries_per_table` entries for every table of `program`.
+// The `i`-th entry of a table matches every key on a value derived from `i`,
+// e.g. a full-length prefix for LPM keys, and invokes the table's first
+// action with parameters derived from `i`. Entries whose keys would repeat
+// (for narrow keys) are skipped.
+std::vector<p4::v1::Entity> GenerateEntities(const Program &program,
+                                             int entries_per_table) {
+  std::vector<p4::v1::Entity> entities;
+  const std::map<std::string, pdpi::IrTableDefinition> tables(
+      program.ir_p4info.tables_by_name().begin(),
+      program.ir_p4info.tables_by_name().end());
+  for (const auto &[name, table] : tables) {
+    if (table.is_unsupported() || table.entry_actions().empty()) continue;
+    const pdpi::IrActionDefinition &action = table.entry_actions(0).action();
+    absl::flat_hash_set<std::string> keys;
+    for (int i = 0; i < entries_per_table; ++i) {
+      p4::v1::TableEntry entry;
+      entry.set_table_id(table.preamble().id());
+      if (table.requires_priority()) {
+        entry.set_priority(entries_per_table - i);
+      }
+      for (const auto &[id, match_field] : table.match_fields_by_id()) {
+        const int bitwidth = match_field.match_field().bitwidth();
+        const std::string value = Value(i, bitwidth, match_field.format());
+        p4::v1::FieldMatch &match = *entry.add_match();
+        match.set_field_id(id);
+        switch (match_field.match_field().match_type()) {
+          case p4::config::v1::MatchField::EXACT:
+            match.mutable_exact()->set_value(value);
+            break;
+          case p4::config::v1::MatchField::LPM:
+            match.mutable_lpm()->set_value(value);
+            match.mutable_lpm()->set_prefix_len(bitwidth);
+            break;
+          case p4::config::v1::MatchField::TERNARY:
+            match.mutable_ternary()->set_value(value);
+            match.mutable_ternary()->set_mask(
+                UintToByteString(~uint64_t{0}, bitwidth));
+            break;
+          case p4::config::v1::MatchField::OPTIONAL:
+            match.mutable_optional()->set_value(value);
+            break;
+          case p4::config::v1::MatchField::RANGE:
+            match.mutable_range()->set_low(value);
+            match.mutable_range()->set_high(value);
+            break;
+          default:
+            LOG(FATAL) << "unsupported match type in table "  // Crash OK
+                       << name;
+        }
+      }
+      if (!keys.insert(entry.SerializeAsString()).second) continue;
+
+      p4::v1::Action pi_action;
+      pi_action.set_action_id(action.preamble().id());
+      for (const auto &[id, param] : action.params_by_id()) {
+        p4::v1::Action::Param &pi_param = *pi_action.add_params();
+        pi_param.set_param_id(id);
+        pi_param.set_value(Value(i, param.param().bitwidth(), param.format()));
+      }
+      if (table.uses_oneshot()) {
+        p4::v1::ActionProfileAction &profile_action =
+            *entry.mutable_action()
+                 ->mutable_action_profile_action_set()
+                 ->add_action_profile_actions();
+        *profile_action.mutable_action() = std::move(pi_action);
+        profile_action.set_weight(1);
+      } else {
+        *entry.mutable_action()->mutable_action() = std::move(pi_action);
+      }
+      *entities.emplace_back().mutable_table_entry() = std::move(entry);
+    }
+  }
+  return entities;
+}
+
+// Returns the dataplane of `program` with `entries_per_table` synthesized
+// entries per table.
+symbolic::Dataplane MakeDataplane(const Program &program,
+                                  int entries_per_table) {
+  std::vector<p4::v1::Entity> entities =
+      GenerateEntities(program, entries_per_table);
+  absl::StatusOr<ir::TableEntries> entries =
+      ir::ParseTableEntries(program.ir_p4info, entities);
+  CHECK_OK(entries.status());  // Crash OK
+  return symbolic::Dataplane{program.ir, *std::move(entries)};
+}
+
+std::unique_ptr<symbolic::SolverState> Evaluate(
+    const symbolic::Dataplane &data_plane) {
+  absl::StatusOr<std::unique_ptr<symbolic::SolverState>> solver_state =
+      symbolic::EvaluateP4Pipeline(data_plane, PhysicalPorts(),
+                                   absl::GetFlag(FLAGS_hardcoded_parser));
+  CHECK_OK(solver_state.status());  // Crash OK
+  return *std::move(solver_state);
+}
+
+// Returns assertions for hitting every entry of the first table with entries
+// in the trace of `solver_state`.
+std::vector<symbolic::Assertion> EntryHitAssertions(
+    const symbolic::SolverState &solver_state) {
+  std::vector<symbolic::Assertion> assertions;
+  for (const auto &[table_name, entries] : solver_state.entries) {
+    if (entries.empty() ||
+        solver_state.context.trace.matched_entries.count(table_name) == 0) {
+      continue;
+    }
+    for (int i = 0; i < static_cast<int>(entries.size()); ++i) {
+      assertions.push_back([table_name = table_name,
+                            i](const symbolic::SymbolicContext &context) {
+        const symbolic::SymbolicTableMatch &match =
+            context.trace.matched_entries.at(table_name);
+        return match.matched && match.entry_index == i;
+      });
+    }
+    break;
+  }
+  return assertions;
+}
+
+// Reports the peak resident memory of the process so far.
+void ReportPeakMemory(benchmark::State &state) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  state.counters["peak_rss_mb"] = usage.ru_maxrss / 1024.0;
+}
+
+void BM_BuildIr(benchmark::State &state, const Program *program) {
+  for (auto _ : state) {
+    absl::StatusOr<ir::P4Program> ir = ir::Bmv2JsonFileAndP4infoToIr(
+        program->bmv2_json_path, program->p4info);
+    CHECK_OK(ir.status());  // Crash OK
+    benchmark::DoNotOptimize(ir);
+  }
+  ReportPeakMemory(state);
+}
+
+void BM_BuildIrFromCache(benchmark::State &state, const Program *program) {
+  const ir::IrCacheOptions options{
+      .directory = absl::GetFlag(FLAGS_ir_cache_directory)};
+  // Fills the cache.
+  CHECK_OK(ir::Bmv2JsonFileAndP4infoToIr(  // Crash OK
+               program->bmv2_json_path, program->p4info, options)
+               .status());
+  for (auto _ : state) {
+    absl::StatusOr<ir::P4Program> ir = ir::Bmv2JsonFileAndP4infoToIr(
+        program->bmv2_json_path, program->p4info, options);
+    CHECK_OK(ir.status());  // Crash OK
+    benchmark::DoNotOptimize(ir);
+  }
+  ReportPeakMemory(state);
+}
+
+void BM_EvaluateP4Pipeline(benchmark::State &state, const Program *program) {
+  const symbolic::Dataplane data_plane =
+      MakeDataplane(*program, state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Evaluate(data_plane));
+  }
+  state.SetComplexityN(state.range(0));
+  ReportPeakMemory(state);
+}
+
+void BM_EvaluateP4PipelineFromCache(benchmark::State &state,
+                                    const Program *program) {
+  const symbolic::Dataplane data_plane =
+      MakeDataplane(*program, state.range(0));
+  const std::string directory =
+      absl::GetFlag(FLAGS_solver_state_cache_directory);
+  const bool hardcoded_parser = absl::GetFlag(FLAGS_hardcoded_parser);
+  // Fills the cache.
+  CHECK_OK(symbolic::EvaluateP4PipelineWithCache(  // Crash OK
+               data_plane, PhysicalPorts(), hardcoded_parser, directory)
+               .status());
+  for (auto _ : state) {
+    absl::StatusOr<std::unique_ptr<symbolic::SolverState>> solver_state =
+        symbolic::EvaluateP4PipelineWithCache(data_plane, PhysicalPorts(),
+                                              hardcoded_parser, directory);
+    CHECK_OK(solver_state.status());  // Crash OK
+    benchmark::DoNotOptimize(solver_state);
+  }
+  state.SetComplexityN(state.range(0));
+  ReportPeakMemory(state);
+}
+
+void BM_Solve(benchmark::State &state, const Program *program) {
+  std::unique_ptr<symbolic::SolverState> solver_state =
+      Evaluate(MakeDataplane(*program, state.range(0)));
+  const std::vector<symbolic::Assertion> assertions =
+      EntryHitAssertions(*solver_state);
+  if (assertions.empty()) {
+    state.SkipWithError("no table with entries in the trace");
+    return;
+  }
+  // Extraction is benchmarked on its own below.
+  const symbolic::ModelExtractionOptions options{.extract_headers = false};
+  uint64_t conflicts = 0;
+  int next_assertion = 0;
+  for (auto _ : state) {
+    absl::StatusOr<std::optional<symbolic::ConcreteContext>> packet =
+        symbolic::Solve(solver_state, assertions[next_assertion], options);
+    CHECK_OK(packet.status());  // Crash OK
+    conflicts += solver_state->last_query_statistics.conflicts;
+    next_assertion = (next_assertion + 1) % assertions.size();
+  }
+  state.SetComplexityN(state.range(0));
+  state.counters["conflicts"] =
+      benchmark::Counter(conflicts, benchmark::Counter::kAvgIterations);
+  state.counters["z3_max_memory_mb"] =
+      solver_state->last_query_statistics.max_memory_mb;
+  ReportPeakMemory(state);
+}
+
+void BM_ExtractFromModel(benchmark::State &state, const Program *program) {
+  std::unique_ptr<symbolic::SolverState> solver_state =
+      Evaluate(MakeDataplane(*program, state.range(0)));
+  const std::vector<symbolic::Assertion> assertions =
+      EntryHitAssertions(*solver_state);
+  z3::solver &solver = *solver_state->solver;
+  solver.push();
+  solver.add(solver_state->entries_literal);
+  if (!assertions.empty()) solver.add(assertions.back()(solver_state->context));
+  if (solver.check() != z3::sat) {
+    state.SkipWithError("no packet hits the last entry");
+    return;
+  }
+  const z3::model model = solver.get_model();
+  for (auto _ : state) {
+    absl::StatusOr<symbolic::ConcreteContext> packet =
+        symbolic::util::ExtractFromModel(solver_state->context, model,
+                                         solver_state->translator);
+    CHECK_OK(packet.status());  // Crash OK
+    benchmark::DoNotOptimize(packet);
+  }
+  solver.pop();
+  state.SetComplexityN(state.range(0));
+  ReportPeakMemory(state);
+}
+
+void RegisterBenchmarks(const Program &program) {
+  const int max_entries = absl::GetFlag(FLAGS_max_entries_per_table);
+  benchmark::RegisterBenchmark(
+      absl::StrCat("BM_BuildIr/", program.name).c_str(), BM_BuildIr, &program)
+      ->Unit(benchmark::kMillisecond);
+  benchmark::RegisterBenchmark(
+      absl::StrCat("BM_BuildIrFromCache/", program.name).c_str(),
+      BM_BuildIrFromCache, &program)
+      ->Unit(benchmark::kMillisecond);
+  for (auto [name, function] :
+       std::vector<std::pair<std::string, void (*)(benchmark::State &,
+                                                   const Program *)>>{
+           {"BM_EvaluateP4Pipeline", BM_EvaluateP4Pipeline},
+           {"BM_EvaluateP4PipelineFromCache", BM_EvaluateP4PipelineFromCache},
+           {"BM_Solve", BM_Solve},
+           {"BM_ExtractFromModel", BM_ExtractFromModel},
+       }) {
+    benchmark::RegisterBenchmark(
+        absl::StrCat(name, "/", program.name).c_str(), function, &program)
+        ->RangeMultiplier(10)
+        ->Range(10, max_entries)
+        ->Unit(benchmark::kMillisecond)
+        ->Complexity();
+  }
+}
+
+}  // namespace
+}  // namespace p4_symbolic
+
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  absl::ParseCommandLine(argc, argv);
+
+  // Benchmarks refer to their program, so programs must not move.
+  static std::deque<p4_symbolic::Program> *const programs =
+      new std::deque<p4_symbolic::Program>();
+  for (const std::string &flag_value : absl::GetFlag(FLAGS_programs)) {
+    absl::StatusOr<p4_symbolic::Program> program =
+        p4_symbolic::LoadProgram(flag_value);
+    CHECK_OK(program.status());  // Crash OK
+    p4_symbolic::RegisterBenchmarks(
+        programs->emplace_back(*std::move(program)));
+  }
+  if (programs->empty()) {
+    LOG(ERROR) << "No programs to benchmark, see --programs.";
+    return 1;
+  }
+
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
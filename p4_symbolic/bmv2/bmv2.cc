@@ -14,18 +14,74 @@
 
 #include "p4_symbolic/bmv2/bmv2.h"
 
+#include <cerrno>
+#include <cstring>
+#include <fstream>
 #include <string>
 
+#include "absl/strings/str_cat.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/util/json_util.h"
-#include "gutil/io.h"
+#include "google/protobuf/util/type_resolver.h"
+#include "google/protobuf/util/type_resolver_util.h"
 #include "gutil/status.h"
 
 namespace p4_symbolic {
 namespace bmv2 {
 
+namespace {
+
+constexpr char kTypeUrlPrefix[] = "type.googleapis.com";
+
+google::protobuf::util::TypeResolver *GetTypeResolver() {
+  static google::protobuf::util::TypeResolver *const kTypeResolver =
+      google::protobuf::util::NewTypeResolverForDescriptorPool(
+          kTypeUrlPrefix, google::protobuf::DescriptorPool::generated_pool());
+  return kTypeResolver;
+}
+
+}  // namespace
+
 absl::StatusOr<P4Program> ParseBmv2JsonFile(const std::string &json_path) {
-  ASSIGN_OR_RETURN(std::string json, gutil::ReadFile(json_path));
-  return ParseBmv2JsonString(json);
+  std::ifstream file(json_path, std::ios::binary);
+  if (!file.is_open()) {
+    return gutil::NotFoundErrorBuilder()
+           << "Could not open bmv2 JSON file '" << json_path
+           << "': " << std::strerror(errno);
+  }
+
+  // The JSON of large programs is many megabytes, so it is converted to the
+  // binary wire format while streaming it from the file, rather than after
+  // reading all of it into memory.
+  google::protobuf::util::JsonParseOptions options;
+  options.ignore_unknown_fields = true;
+  std::string binary;
+  {
+    google::protobuf::io::IstreamInputStream json_stream(&file);
+    google::protobuf::io::StringOutputStream binary_stream(&binary);
+    RETURN_IF_ERROR(
+        gutil::ToAbslStatus(google::protobuf::util::JsonToBinaryStream(
+            GetTypeResolver(),
+            absl::StrCat(kTypeUrlPrefix, "/",
+                         P4Program::descriptor()->full_name()),
+            &json_stream, &binary_stream, options)))
+        << "while parsing bmv2 JSON file '" << json_path << "'";
+  }
+  if (file.bad()) {
+    return gutil::InternalErrorBuilder()
+           << "Could not read bmv2 JSON file '" << json_path
+           << "': " << std::strerror(errno);
+  }
+
+  P4Program output;
+  if (!output.ParseFromString(binary)) {
+    return gutil::InternalErrorBuilder()
+           << "Failed to parse the binary conversion of bmv2 JSON file '"
+           << json_path << "'";
+  }
+  return output;
 }
 
 absl::StatusOr<P4Program> ParseBmv2JsonString(const std::string &json_string) {
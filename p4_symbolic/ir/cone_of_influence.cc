@@ -0,0 +1,459 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_symbolic/ir/cone_of_influence.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/repeated_ptr_field.h"
+#include "gutil/status.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_symbolic/ir/ir.h"
+#include "p4_symbolic/ir/ir.pb.h"
+#include "p4_symbolic/ir/table_entries.h"
+
+namespace p4_symbolic::ir {
+namespace {
+
+constexpr char kVariablePrefix[] = "$variable$.";
+constexpr char kGotCloned[] = "$got_cloned$";
+constexpr char kGotRecirculated[] = "$got_recirculated$";
+
+// The fields a statement writes, and the fields the written values depend on.
+struct StatementEffect {
+  std::vector<std::string> writes;
+  std::vector<std::string> reads;
+};
+
+std::string FieldName(const FieldValue &field) {
+  return absl::StrCat(field.header_name(), ".", field.field_name());
+}
+
+// Appends the fields of header `header_name`, including its validity, to
+// `fields`.
+absl::Status AppendHeaderFields(const P4Program &program,
+                                const std::string &header_name,
+                                std::vector<std::string> &fields) {
+  auto it = program.headers().find(header_name);
+  if (it == program.headers().end()) {
+    return gutil::NotFoundErrorBuilder()
+           << "Unknown header '" << header_name << "'.";
+  }
+  for (const auto &[field_name, field] : it->second.fields()) {
+    fields.push_back(absl::StrCat(header_name, ".", field_name));
+  }
+  fields.push_back(absl::StrCat(header_name, ".$valid$"));
+  return absl::OkStatus();
+}
+
+// Appends the fields and variables read by `rvalue` to `reads`.
+absl::Status AppendReads(const P4Program &program, const RValue &rvalue,
+                         std::vector<std::string> &reads) {
+  switch (rvalue.rvalue_case()) {
+    case RValue::kHeaderValue:
+      return AppendHeaderFields(program, rvalue.header_value().header_name(),
+                                reads);
+    case RValue::kFieldValue:
+      reads.push_back(FieldName(rvalue.field_value()));
+      return absl::OkStatus();
+    case RValue::kVariableValue:
+      reads.push_back(
+          absl::StrCat(kVariablePrefix, rvalue.variable_value().name()));
+      return absl::OkStatus();
+    case RValue::kExpressionValue: {
+      const RExpression &expression = rvalue.expression_value();
+      switch (expression.expression_case()) {
+        case RExpression::kBinaryExpression:
+          RETURN_IF_ERROR(AppendReads(
+              program, expression.binary_expression().left(), reads));
+          return AppendReads(program, expression.binary_expression().right(),
+                             reads);
+        case RExpression::kUnaryExpression:
+          return AppendReads(program, expression.unary_expression().operand(),
+                             reads);
+        case RExpression::kTernaryExpression:
+          for (const RValue *operand :
+               {&expression.ternary_expression().condition(),
+                &expression.ternary_expression().left(),
+                &expression.ternary_expression().right()}) {
+            RETURN_IF_ERROR(AppendReads(program, *operand, reads));
+          }
+          return absl::OkStatus();
+        case RExpression::kBuiltinExpression:
+          for (const RValue &argument :
+               expression.builtin_expression().arguments()) {
+            RETURN_IF_ERROR(AppendReads(program, argument, reads));
+          }
+          return absl::OkStatus();
+        case RExpression::EXPRESSION_NOT_SET:
+          break;
+      }
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unsupported expression: " << expression.DebugString();
+    }
+    case RValue::kHexstrValue:
+    case RValue::kBoolValue:
+    case RValue::kStringValue:
+      return absl::OkStatus();
+    case RValue::RVALUE_NOT_SET:
+      break;
+  }
+  return gutil::InvalidArgumentErrorBuilder()
+         << "Unsupported rvalue: " << rvalue.DebugString();
+}
+
+// Mirrors the evaluation of statements in symbolic/action.cc.
+absl::StatusOr<StatementEffect> GetStatementEffect(const P4Program &program,
+                                                   const Statement &statement) {
+  StatementEffect effect;
+  switch (statement.statement_case()) {
+    case Statement::kAssignment: {
+      const LValue &left = statement.assignment().left();
+      switch (left.lvalue_case()) {
+        case LValue::kFieldValue:
+          effect.writes.push_back(FieldName(left.field_value()));
+          break;
+        case LValue::kVariableValue:
+          effect.writes.push_back(
+              absl::StrCat(kVariablePrefix, left.variable_value().name()));
+          break;
+        case LValue::LVALUE_NOT_SET:
+          return gutil::InvalidArgumentErrorBuilder()
+                 << "Unsupported lvalue: " << left.DebugString();
+      }
+      RETURN_IF_ERROR(
+          AppendReads(program, statement.assignment().right(), effect.reads));
+      return effect;
+    }
+    case Statement::kDrop: {
+      const std::string &header_name = statement.drop().header().header_name();
+      effect.writes.push_back(absl::StrCat(header_name, ".egress_spec"));
+      effect.writes.push_back(absl::StrCat(header_name, ".mcast_grp"));
+      return effect;
+    }
+    case Statement::kClone:
+      effect.writes.push_back(kGotCloned);
+      return effect;
+    case Statement::kRecirculate:
+      effect.writes.push_back(kGotRecirculated);
+      return effect;
+    case Statement::kHash:
+      // The hash is a fresh free variable.
+      effect.writes.push_back(FieldName(statement.hash().field()));
+      return effect;
+    case Statement::kExit:
+      // Exit statements are not evaluated.
+      return effect;
+    case Statement::kHeaderAssignment: {
+      const HeaderAssignmentStatement &assignment =
+          statement.header_assignment();
+      RETURN_IF_ERROR(AppendHeaderFields(
+          program, assignment.left().header_name(), effect.writes));
+      RETURN_IF_ERROR(AppendHeaderFields(
+          program, assignment.right().header_name(), effect.reads));
+      return effect;
+    }
+    case Statement::STATEMENT_NOT_SET:
+      break;
+  }
+  return gutil::InvalidArgumentErrorBuilder()
+         << "Unsupported statement: " << statement.DebugString();
+}
+
+// The parts of a table the analysis needs.
+struct TableInfo {
+  std::vector<std::string> match_fields;
+  // The effects of the statements of all actions the table may execute.
+  std::vector<StatementEffect> effects;
+  // The distinct controls executed after the table.
+  absl::btree_set<std::string> next_controls;
+};
+
+absl::StatusOr<TableInfo> GetTableInfo(const P4Program &program,
+                                       const Table &table) {
+  TableInfo info;
+  const TableImplementation &implementation = table.table_implementation();
+  for (const auto &[match_name, field] :
+       implementation.match_name_to_field()) {
+    info.match_fields.push_back(FieldName(field));
+  }
+
+  absl::btree_set<std::string> action_names;
+  if (!implementation.default_action().empty()) {
+    action_names.insert(implementation.default_action());
+  }
+  for (const auto *references :
+       {&table.table_definition().entry_actions(),
+        &table.table_definition().default_only_actions()}) {
+    for (const pdpi::IrActionReference &reference : *references) {
+      action_names.insert(reference.action().preamble().name());
+    }
+  }
+  for (const std::string &action_name : action_names) {
+    auto it = program.actions().find(action_name);
+    if (it == program.actions().end()) {
+      return gutil::NotFoundErrorBuilder()
+             << "Table '" << table.table_definition().preamble().name()
+             << "' refers to unknown action '" << action_name << "'.";
+    }
+    for (const Statement &statement :
+         it->second.action_implementation().action_body()) {
+      ASSIGN_OR_RETURN(StatementEffect effect,
+                       GetStatementEffect(program, statement));
+      info.effects.push_back(std::move(effect));
+    }
+  }
+
+  for (const auto &[action_name, next_control] :
+       implementation.action_to_next_control()) {
+    info.next_controls.insert(next_control);
+  }
+  if (info.next_controls.empty()) info.next_controls.insert(EndOfPipeline());
+  return info;
+}
+
+// The controls `control` may be followed by, before reaching `merge_point`.
+std::vector<std::string> Successors(const P4Program &program,
+                                    const std::string &control) {
+  if (auto it = program.tables().find(control); it != program.tables().end()) {
+    std::vector<std::string> successors;
+    for (const auto &[action_name, next_control] :
+         it->second.table_implementation().action_to_next_control()) {
+      successors.push_back(next_control);
+    }
+    return successors;
+  }
+  if (auto it = program.conditionals().find(control);
+      it != program.conditionals().end()) {
+    return {it->second.if_branch(), it->second.else_branch()};
+  }
+  return {};
+}
+
+// Returns true if a control in `cone` may be executed after `conditional`
+// and before its merge point.
+bool BranchesReachCone(const P4Program &program,
+                       const Conditional &conditional,
+                       const ConeOfInfluence &cone) {
+  const std::string &merge_point =
+      conditional.optimized_symbolic_execution_info().merge_point();
+  std::vector<std::string> pending = {conditional.if_branch(),
+                                      conditional.else_branch()};
+  absl::flat_hash_set<std::string> visited;
+  while (!pending.empty()) {
+    std::string control = std::move(pending.back());
+    pending.pop_back();
+    if (control == merge_point || control == EndOfPipeline() ||
+        !visited.insert(control).second) {
+      continue;
+    }
+    if (cone.tables.contains(control) || cone.conditionals.contains(control)) {
+      return true;
+    }
+    for (std::string &successor : Successors(program, control)) {
+      pending.push_back(std::move(successor));
+    }
+  }
+  return false;
+}
+
+bool WritesAny(const StatementEffect &effect,
+               const absl::btree_set<std::string> &fields) {
+  for (const std::string &field : effect.writes) {
+    if (fields.contains(field)) return true;
+  }
+  return false;
+}
+
+// Inserts `fields` into `cone_fields`, and returns true if any was new.
+bool InsertAll(const std::vector<std::string> &fields,
+               absl::btree_set<std::string> &cone_fields) {
+  bool inserted = false;
+  for (const std::string &field : fields) {
+    inserted |= cone_fields.insert(field).second;
+  }
+  return inserted;
+}
+
+}  // namespace
+
+absl::StatusOr<ConeOfInfluence> ComputeConeOfInfluence(
+    const P4Program &program, const SliceCriterion &criterion) {
+  ConeOfInfluence cone;
+  for (const std::string &table : criterion.tables) {
+    if (!program.tables().contains(table)) {
+      return gutil::NotFoundErrorBuilder()
+             << "Cannot slice the program for unknown table '" << table
+             << "'.";
+    }
+    cone.tables.insert(table);
+  }
+  cone.fields = criterion.fields;
+
+  absl::flat_hash_map<std::string, TableInfo> tables;
+  for (const auto &[name, table] : program.tables()) {
+    ASSIGN_OR_RETURN(tables[name], GetTableInfo(program, table));
+  }
+  absl::flat_hash_map<std::string, std::vector<std::string>> condition_reads;
+  for (const auto &[name, conditional] : program.conditionals()) {
+    RETURN_IF_ERROR(
+        AppendReads(program, conditional.condition(), condition_reads[name]));
+  }
+
+  // Every pass only grows the cone, so this terminates.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto &[name, info] : tables) {
+      if (!cone.tables.contains(name)) {
+        // Tables branching the control flow are always kept, since there is no
+        // single control to continue with instead.
+        bool in_cone = info.next_controls.size() > 1;
+        for (const StatementEffect &effect : info.effects) {
+          in_cone = in_cone || WritesAny(effect, cone.fields);
+        }
+        if (!in_cone) continue;
+        cone.tables.insert(name);
+        changed = true;
+      }
+      changed |= InsertAll(info.match_fields, cone.fields);
+      for (const StatementEffect &effect : info.effects) {
+        if (WritesAny(effect, cone.fields)) {
+          changed |= InsertAll(effect.reads, cone.fields);
+        }
+      }
+    }
+    for (const auto &[name, conditional] : program.conditionals()) {
+      if (!cone.conditionals.contains(name)) {
+        if (!BranchesReachCone(program, conditional, cone)) continue;
+        cone.conditionals.insert(name);
+        changed = true;
+      }
+      changed |= InsertAll(condition_reads[name], cone.fields);
+    }
+  }
+  return cone;
+}
+
+absl::StatusOr<P4Program> SliceProgram(const P4Program &program,
+                                       const ConeOfInfluence &cone) {
+  // Maps each control outside of the cone to the control that is executed
+  // instead of it.
+  absl::flat_hash_map<std::string, std::string> bypasses;
+  for (const auto &[name, table] : program.tables()) {
+    if (cone.tables.contains(name)) continue;
+    absl::btree_set<std::string> next_controls;
+    for (const auto &[action_name, next_control] :
+         table.table_implementation().action_to_next_control()) {
+      next_controls.insert(next_control);
+    }
+    if (next_controls.size() > 1) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Table '" << name
+             << "' branches the control flow, so it must be in the cone.";
+    }
+    bypasses[name] =
+        next_controls.empty() ? EndOfPipeline() : *next_controls.begin();
+  }
+  for (const auto &[name, conditional] : program.conditionals()) {
+    if (cone.conditionals.contains(name)) continue;
+    // A conditional that does not continue to its merge point leaves it to
+    // an enclosing conditional, so execution stops here instead.
+    const OptimizedSymbolicExecutionInfo &info =
+        conditional.optimized_symbolic_execution_info();
+    bypasses[name] =
+        info.continue_to_merge_point() && !info.merge_point().empty()
+            ? info.merge_point()
+            : EndOfPipeline();
+  }
+  auto resolve = [&](std::string control) -> absl::StatusOr<std::string> {
+    for (int hops = 0; hops <= bypasses.size(); ++hops) {
+      auto it = bypasses.find(control);
+      if (it == bypasses.end()) return control;
+      control = it->second;
+    }
+    return gutil::InvalidArgumentErrorBuilder()
+           << "The control graph has a cycle through '" << control << "'.";
+  };
+
+  P4Program sliced = program;
+  for (const auto &[name, bypass] : bypasses) {
+    sliced.mutable_tables()->erase(name);
+    sliced.mutable_conditionals()->erase(name);
+  }
+  for (auto &[name, pipeline] : *sliced.mutable_pipeline()) {
+    ASSIGN_OR_RETURN(*pipeline.mutable_initial_control(),
+                     resolve(pipeline.initial_control()));
+  }
+  for (auto &[name, table] : *sliced.mutable_tables()) {
+    TableImplementation &implementation =
+        *table.mutable_table_implementation();
+    for (auto &[action_name, next_control] :
+         *implementation.mutable_action_to_next_control()) {
+      ASSIGN_OR_RETURN(next_control, resolve(next_control));
+    }
+    OptimizedSymbolicExecutionInfo &info =
+        *implementation.mutable_optimized_symbolic_execution_info();
+    if (!info.merge_point().empty()) {
+      ASSIGN_OR_RETURN(*info.mutable_merge_point(),
+                       resolve(info.merge_point()));
+    }
+  }
+  for (auto &[name, conditional] : *sliced.mutable_conditionals()) {
+    ASSIGN_OR_RETURN(*conditional.mutable_if_branch(),
+                     resolve(conditional.if_branch()));
+    ASSIGN_OR_RETURN(*conditional.mutable_else_branch(),
+                     resolve(conditional.else_branch()));
+    OptimizedSymbolicExecutionInfo &info =
+        *conditional.mutable_optimized_symbolic_execution_info();
+    if (!info.merge_point().empty()) {
+      ASSIGN_OR_RETURN(*info.mutable_merge_point(),
+                       resolve(info.merge_point()));
+    }
+  }
+
+  // Drop the statements whose effects are outside of the cone. Actions of
+  // tables outside of the cone are unused, and end up empty.
+  for (auto &[name, action] : *sliced.mutable_actions()) {
+    auto &body = *action.mutable_action_implementation()->mutable_action_body();
+    google::protobuf::RepeatedPtrField<Statement> kept;
+    for (Statement &statement : body) {
+      ASSIGN_OR_RETURN(StatementEffect effect,
+                       GetStatementEffect(program, statement));
+      if (WritesAny(effect, cone.fields)) *kept.Add() = std::move(statement);
+    }
+    body.Swap(&kept);
+  }
+  return sliced;
+}
+
+TableEntries SliceTableEntries(const TableEntries &entries,
+                               const ConeOfInfluence &cone) {
+  TableEntries sliced;
+  for (const auto &[table, table_entries] : entries) {
+    if (cone.tables.contains(table)) sliced[table] = table_entries;
+  }
+  return sliced;
+}
+
+}  // namespace p4_symbolic::ir
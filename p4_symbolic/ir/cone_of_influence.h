@@ -0,0 +1,83 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Computes the part of a P4 program that can influence a few tables and header
+// fields, and slices the program down to that part. Queries that only look at,
+// e.g., the entries hit in a single table can then be answered on a formula
+// that leaves out every unrelated table and assignment.
+//
+// The analysis is a backward fixpoint over the control graph of the pipeline:
+// - A table is in the cone if it is asked for, if it branches the control
+//   flow, or if one of its actions may write a field in the cone. Its match
+//   fields, and the fields read by its assignments to fields in the cone, are
+//   then in the cone too.
+// - A conditional is in the cone if a table or conditional in the cone may be
+//   executed between it and its merge point, i.e. if whether it is executed
+//   depends on the condition. The fields of the condition are then in the
+//   cone.
+// Slicing removes every table and conditional outside of the cone, by
+// redirecting the controls leading to them to where execution continues after
+// them, and every statement that only writes fields outside of the cone.
+
+#ifndef P4_SYMBOLIC_IR_CONE_OF_INFLUENCE_H_
+#define P4_SYMBOLIC_IR_CONE_OF_INFLUENCE_H_
+
+#include <string>
+
+#include "absl/container/btree_set.h"
+#include "absl/status/statusor.h"
+#include "p4_symbolic/ir/ir.pb.h"
+#include "p4_symbolic/ir/table_entries.h"
+
+namespace p4_symbolic::ir {
+
+// What a query looks at.
+struct SliceCriterion {
+  // Full names of the tables whose matches are asserted on.
+  absl::btree_set<std::string> tables;
+  // Header fields, as "<header>.<field>", whose values at the end of the
+  // pipeline are asserted on. Values at the start of the pipeline are free, so
+  // they never need to be listed.
+  absl::btree_set<std::string> fields;
+};
+
+// The tables, conditionals and fields that can influence a `SliceCriterion`.
+// Local variables of actions are included as "$variable$.<name>", and the
+// effects of clone and recirculate statements as "$got_cloned$" and
+// "$got_recirculated$".
+struct ConeOfInfluence {
+  absl::btree_set<std::string> tables;
+  absl::btree_set<std::string> conditionals;
+  absl::btree_set<std::string> fields;
+};
+
+// Returns the cone of influence of `criterion` in `program`. Returns NotFound
+// if the criterion names an unknown table.
+absl::StatusOr<ConeOfInfluence> ComputeConeOfInfluence(
+    const P4Program &program, const SliceCriterion &criterion);
+
+// Returns `program` restricted to `cone`. Headers and their fields are kept,
+// so that the ingress and egress packets of the sliced program have the same
+// fields as those of `program`. Fields outside of `cone` are never written, so
+// they keep their ingress values.
+absl::StatusOr<P4Program> SliceProgram(const P4Program &program,
+                                       const ConeOfInfluence &cone);
+
+// Returns the entries of the tables in `cone`.
+TableEntries SliceTableEntries(const TableEntries &entries,
+                               const ConeOfInfluence &cone);
+
+}  // namespace p4_symbolic::ir
+
+#endif  // P4_SYMBOLIC_IR_CONE_OF_INFLUENCE_H_
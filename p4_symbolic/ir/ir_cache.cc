@@ -0,0 +1,231 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_symbolic/ir/ir_cache.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "gutil/io.h"
+#include "gutil/status.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/ir_p4info_cache.h"
+#include "p4_symbolic/bmv2/bmv2.h"
+#include "p4_symbolic/bmv2/bmv2.pb.h"
+#include "p4_symbolic/ir/ir.h"
+#include "p4_symbolic/ir/ir.pb.h"
+
+namespace p4_symbolic::ir {
+namespace {
+
+constexpr char kCacheMagic[] = "P4SYMBOLICIR";
+constexpr int kCacheMagicSize = sizeof(kCacheMagic) - 1;
+constexpr uint32_t kCacheVersion = 1;
+
+// 64-bit FNV-1a. Unlike absl::Hash, it does not depend on a per-process seed.
+uint64_t Fingerprint(absl::string_view bytes) {
+  uint64_t fingerprint = 0xcbf29ce484222325;
+  for (const char byte : bytes) {
+    fingerprint ^= static_cast<uint8_t>(byte);
+    fingerprint *= 0x100000001b3;
+  }
+  return fingerprint;
+}
+
+// Identifies the inputs an IR was built from.
+struct CacheKey {
+  uint64_t bmv2_fingerprint;
+  uint64_t p4info_fingerprint;
+};
+
+CacheKey MakeCacheKey(absl::string_view bmv2_json,
+                      const p4::config::v1::P4Info &p4info) {
+  return CacheKey{
+      .bmv2_fingerprint = Fingerprint(bmv2_json),
+      .p4info_fingerprint = pdpi::P4InfoFingerprint(p4info),
+  };
+}
+
+std::string CacheFilePath(absl::string_view directory, const CacheKey &key) {
+  return absl::StrFormat("%s/%016x-%016x.p4symbolicir", directory,
+                         key.bmv2_fingerprint, key.p4info_fingerprint);
+}
+
+absl::Status WriteCacheFile(const std::string &path, const CacheKey &key,
+                            const P4Program &program) {
+  std::string serialized_program;
+  if (!program.SerializeToString(&serialized_program)) {
+    return gutil::InternalErrorBuilder()
+           << "Failed to serialize IR for cache '" << path << "'.";
+  }
+
+  const std::string tmp_path = absl::StrCat(path, ".tmp");
+  std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return gutil::InternalErrorBuilder()
+           << "Could not open IR cache '" << tmp_path
+           << "' for writing: " << std::strerror(errno);
+  }
+
+  bool serialized = true;
+  {
+    google::protobuf::io::OstreamOutputStream output_stream(&file);
+    google::protobuf::io::CodedOutputStream output(&output_stream);
+
+    output.WriteRaw(kCacheMagic, kCacheMagicSize);
+    output.WriteVarint32(kCacheVersion);
+    output.WriteLittleEndian64(key.bmv2_fingerprint);
+    output.WriteLittleEndian64(key.p4info_fingerprint);
+    output.WriteVarint32(serialized_program.size());
+    output.WriteRaw(serialized_program.data(), serialized_program.size());
+    serialized = !output.HadError();
+  }
+  file.close();
+  if (!serialized || file.fail()) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Failed to write IR cache '" << tmp_path << "'.";
+  }
+
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Could not move IR cache to '" << path
+           << "': " << std::strerror(errno);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<P4Program> ReadCacheFile(const std::string &path,
+                                        const CacheKey &key) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return gutil::NotFoundErrorBuilder() << "Could not open IR cache '" << path
+                                         << "': " << std::strerror(errno);
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  const std::string data = contents.str();
+
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t *>(data.data()), data.size());
+  // IRs of large programs exceed the default limit of 64MiB.
+  input.SetTotalBytesLimit(data.size());
+
+  std::string magic;
+  uint32_t version = 0;
+  if (!input.ReadString(&magic, kCacheMagicSize) || magic != kCacheMagic ||
+      !input.ReadVarint32(&version)) {
+    return gutil::DataLossErrorBuilder()
+           << "'" << path << "' is not an IR cache.";
+  }
+  if (version != kCacheVersion) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "IR cache '" << path << "' has version " << version
+           << ", but only version " << kCacheVersion << " is supported.";
+  }
+  CacheKey cached_key;
+  if (!input.ReadLittleEndian64(&cached_key.bmv2_fingerprint) ||
+      !input.ReadLittleEndian64(&cached_key.p4info_fingerprint)) {
+    return gutil::DataLossErrorBuilder()
+           << "IR cache '" << path << "' has a corrupt header.";
+  }
+  if (cached_key.bmv2_fingerprint != key.bmv2_fingerprint ||
+      cached_key.p4info_fingerprint != key.p4info_fingerprint) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "IR cache '" << path
+           << "' was written for a different bmv2 JSON or P4Info.";
+  }
+
+  uint32_t size = 0;
+  std::string serialized_program;
+  if (!input.ReadVarint32(&size) ||
+      !input.ReadString(&serialized_program, size)) {
+    return gutil::DataLossErrorBuilder()
+           << "IR cache '" << path << "' is truncated.";
+  }
+  if (input.CurrentPosition() != data.size()) {
+    return gutil::DataLossErrorBuilder()
+           << "IR cache '" << path << "' has unexpected trailing data.";
+  }
+  P4Program program;
+  if (!program.ParseFromString(serialized_program)) {
+    return gutil::DataLossErrorBuilder()
+           << "IR cache '" << path << "' has a corrupt IR.";
+  }
+  return program;
+}
+
+}  // namespace
+
+absl::StatusOr<P4Program> Bmv2JsonFileAndP4infoToIr(
+    const std::string &bmv2_json_path, const p4::config::v1::P4Info &p4info,
+    const IrCacheOptions &options) {
+  if (options.directory.empty()) {
+    ASSIGN_OR_RETURN(bmv2::P4Program bmv2,
+                     bmv2::ParseBmv2JsonFile(bmv2_json_path));
+    ASSIGN_OR_RETURN(std::shared_ptr<const pdpi::IrP4Info> ir_p4info,
+                     pdpi::GetOrCreateIrP4Info(p4info));
+    return Bmv2AndP4infoToIr(bmv2, *ir_p4info);
+  }
+
+  // Reading the JSON is cheap compared to parsing it, and keys the cache by its
+  // contents rather than by its path or modification time.
+  ASSIGN_OR_RETURN(std::string bmv2_json, gutil::ReadFile(bmv2_json_path));
+  const CacheKey key = MakeCacheKey(bmv2_json, p4info);
+  const std::string path = CacheFilePath(options.directory, key);
+  absl::StatusOr<P4Program> from_file = ReadCacheFile(path, key);
+  if (from_file.ok()) return from_file;
+  LOG_IF(INFO, !absl::IsNotFound(from_file.status()))
+      << "Not using the IR cache: " << from_file.status();
+
+  ASSIGN_OR_RETURN(bmv2::P4Program bmv2,
+                   bmv2::ParseBmv2JsonString(bmv2_json));
+  ASSIGN_OR_RETURN(std::shared_ptr<const pdpi::IrP4Info> ir_p4info,
+                   pdpi::GetOrCreateIrP4Info(p4info));
+  ASSIGN_OR_RETURN(P4Program program, Bmv2AndP4infoToIr(bmv2, *ir_p4info));
+  absl::Status saved = WriteCacheFile(path, key, program);
+  LOG_IF(WARNING, !saved.ok()) << "Could not save the IR cache: " << saved;
+  return program;
+}
+
+absl::Status WriteIrCacheFile(const std::string &path,
+                              const std::string &bmv2_json,
+                              const p4::config::v1::P4Info &p4info,
+                              const P4Program &program) {
+  return WriteCacheFile(path, MakeCacheKey(bmv2_json, p4info), program);
+}
+
+absl::StatusOr<P4Program> ReadIrCacheFile(
+    const std::string &path, const std::string &bmv2_json,
+    const p4::config::v1::P4Info &p4info) {
+  return ReadCacheFile(path, MakeCacheKey(bmv2_json, p4info));
+}
+
+}  // namespace p4_symbolic::ir
@@ -0,0 +1,61 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Caches the IR of P4 programs on disk. Parsing the bmv2 JSON and building the
+// IR dominates the startup of p4-symbolic on large programs, and both only
+// depend on the bmv2 JSON and the P4Info.
+
+#ifndef P4_SYMBOLIC_IR_IR_CACHE_H_
+#define P4_SYMBOLIC_IR_IR_CACHE_H_
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4_symbolic/ir/ir.pb.h"
+
+namespace p4_symbolic::ir {
+
+struct IrCacheOptions {
+  // If non-empty, the IR is read from, and written to, a file in this directory
+  // named after the fingerprints of the bmv2 JSON and the P4Info. Failing to
+  // use the file is not an error, the IR is built instead.
+  std::string directory;
+};
+
+// Returns the same IR as parsing the bmv2 JSON file at `bmv2_json_path` and
+// transforming it with `Bmv2AndP4infoToIr`, but reads it from the cache in
+// `options.directory` if possible.
+absl::StatusOr<P4Program> Bmv2JsonFileAndP4infoToIr(
+    const std::string &bmv2_json_path, const p4::config::v1::P4Info &p4info,
+    const IrCacheOptions &options = {});
+
+// Writes `program`, built from the bmv2 JSON `bmv2_json` and `p4info`, to
+// `path`. The file is replaced atomically.
+absl::Status WriteIrCacheFile(const std::string &path,
+                              const std::string &bmv2_json,
+                              const p4::config::v1::P4Info &p4info,
+                              const P4Program &program);
+
+// Reads an IR from a file written by `WriteIrCacheFile`. Returns a
+// FailedPrecondition error if the file was written for a different bmv2 JSON
+// or P4Info, and a DataLoss error if it is corrupt.
+absl::StatusOr<P4Program> ReadIrCacheFile(const std::string &path,
+                                          const std::string &bmv2_json,
+                                          const p4::config::v1::P4Info &p4info);
+
+}  // namespace p4_symbolic::ir
+
+#endif  // P4_SYMBOLIC_IR_IR_CACHE_H_
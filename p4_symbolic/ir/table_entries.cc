@@ -14,14 +14,20 @@
 
 #include "p4_symbolic/ir/table_entries.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "gutil/proto.h"
 #include "gutil/status.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.h"
@@ -85,29 +91,95 @@ absl::Status UseFullyQualifiedNamesInEntity(const pdpi::IrP4Info &info,
   }
 }
 
-}  // namespace
+// Entity files are read and converted this many entities at a time.
+constexpr int kEntitiesPerChunk = 4096;
 
-absl::StatusOr<TableEntries> ParseTableEntries(
-    const pdpi::IrP4Info &p4info, absl::Span<const p4::v1::Entity> entities) {
+// Below this many entities per thread, threads cost more than they save.
+constexpr int kMinEntitiesPerThread = 256;
+
+// Converts a PI entity to the IR used by P4-Symbolic.
+absl::StatusOr<pdpi::IrEntity> ToSymbolicIrEntity(
+    const pdpi::IrP4Info &p4info, const p4::v1::Entity &pi_entity) {
   // Use pdpi to transform each plain p4.v1.TableEntry to the pd representation
   // pdpi.ir.IrTableEntry.
-  TableEntries output;
-  for (const p4::v1::Entity &pi_entity : entities) {
-    ASSIGN_OR_RETURN(
-        pdpi::IrEntity ir_entity,
-        pdpi::PiEntityToIr(p4info, pi_entity, {.allow_unsupported = true}));
-    // TODO: Consider removing this function call if we switch to
-    // using aliases as table/action names in P4-Symbolic.
-    RETURN_IF_ERROR(UseFullyQualifiedNamesInEntity(p4info, ir_entity));
+  ASSIGN_OR_RETURN(
+      pdpi::IrEntity ir_entity,
+      pdpi::PiEntityToIr(p4info, pi_entity, {.allow_unsupported = true}));
+  // TODO: Consider removing this function call if we switch to
+  // using aliases as table/action names in P4-Symbolic.
+  RETURN_IF_ERROR(UseFullyQualifiedNamesInEntity(p4info, ir_entity));
+  return ir_entity;
+}
+
+// Converts `entities` to IR, on up to `num_threads` threads, and appends them
+// to `output` in order. Returns the error of the first entity that fails to
+// convert, if any.
+absl::Status AppendTableEntries(const pdpi::IrP4Info &p4info,
+                                absl::Span<const p4::v1::Entity> entities,
+                                int num_threads, TableEntries &output) {
+  std::vector<absl::StatusOr<pdpi::IrEntity>> ir_entities(
+      entities.size(), absl::UnknownError("Entity has not been converted."));
+  num_threads = std::clamp<int>(entities.size() / kMinEntitiesPerThread, 1,
+                                num_threads);
+  std::atomic<int> next = 0;
+  auto convert = [&] {
+    for (int i = next++; i < entities.size(); i = next++) {
+      ir_entities[i] = ToSymbolicIrEntity(p4info, entities[i]);
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+  for (int i = 1; i < num_threads; ++i) threads.emplace_back(convert);
+  convert();
+  for (std::thread &thread : threads) thread.join();
+
+  for (absl::StatusOr<pdpi::IrEntity> &ir_entity : ir_entities) {
+    RETURN_IF_ERROR(ir_entity.status());
     ASSIGN_OR_RETURN(std::string table_name,
-                     pdpi::EntityToTableName(ir_entity));
+                     pdpi::EntityToTableName(*ir_entity));
 
     std::vector<TableEntry> &output_entries = output[std::move(table_name)];
     int index = output_entries.size();
     ConcreteTableEntry &output_entry =
         *output_entries.emplace_back().mutable_concrete_entry();
     output_entry.set_index(index);
-    *output_entry.mutable_pdpi_ir_entity() = std::move(ir_entity);
+    *output_entry.mutable_pdpi_ir_entity() = *std::move(ir_entity);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<TableEntries> ParseTableEntries(
+    const pdpi::IrP4Info &p4info, absl::Span<const p4::v1::Entity> entities,
+    const ParseTableEntriesOptions &options) {
+  TableEntries output;
+  RETURN_IF_ERROR(
+      AppendTableEntries(p4info, entities, options.num_threads, output));
+  return output;
+}
+
+absl::StatusOr<TableEntries> ParseTableEntriesFromFile(
+    const pdpi::IrP4Info &p4info, absl::string_view filename,
+    const ParseTableEntriesOptions &options) {
+  ASSIGN_OR_RETURN(std::unique_ptr<gutil::DelimitedProtoFileReader> reader,
+                   gutil::DelimitedProtoFileReader::Open(filename));
+  TableEntries output;
+  std::vector<p4::v1::Entity> chunk(kEntitiesPerChunk);
+  bool done = false;
+  while (!done) {
+    int size = 0;
+    while (size < chunk.size()) {
+      ASSIGN_OR_RETURN(bool has_entity, reader->ReadNext(chunk[size]));
+      if (!has_entity) {
+        done = true;
+        break;
+      }
+      ++size;
+    }
+    RETURN_IF_ERROR(AppendTableEntries(
+        p4info, absl::MakeConstSpan(chunk).first(size), options.num_threads,
+        output));
   }
   return output;
 }
@@ -23,6 +23,7 @@
 
 #include "absl/container/btree_map.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.pb.h"
@@ -39,9 +40,24 @@ namespace ir {
 // will be nondeterministic.
 using TableEntries = absl::btree_map<std::string, std::vector<TableEntry>>;
 
+struct ParseTableEntriesOptions {
+  // The number of threads converting PI entities to IR. With 1, entities are
+  // converted on the calling thread.
+  int num_threads = 1;
+};
+
 // Returns table entries in P4-Symbolic IR, keyed by table name.
 absl::StatusOr<TableEntries> ParseTableEntries(
-    const pdpi::IrP4Info &p4info, absl::Span<const p4::v1::Entity> entities);
+    const pdpi::IrP4Info &p4info, absl::Span<const p4::v1::Entity> entities,
+    const ParseTableEntriesOptions &options = {});
+
+// Like `ParseTableEntries`, but streams the entities from `filename`, a file of
+// length-delimited `p4::v1::Entity`s as written by
+// `gutil::DelimitedProtoFileWriter`. Entities are read and converted in
+// chunks, so only one chunk of PI entities is held in memory at a time.
+absl::StatusOr<TableEntries> ParseTableEntriesFromFile(
+    const pdpi::IrP4Info &p4info, absl::string_view filename,
+    const ParseTableEntriesOptions &options = {});
 
 }  // namespace ir
 }  // namespace p4_symbolic
@@ -16,6 +16,13 @@
 
 #include "p4_symbolic/symbolic/guarded_map.h"
 
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "p4_symbolic/symbolic/operators.h"
@@ -24,34 +31,95 @@
 namespace p4_symbolic {
 namespace symbolic {
 
+namespace {
+
+std::string FieldKey(absl::string_view header_name,
+                     absl::string_view field_name) {
+  return absl::StrCat(header_name, ".", field_name);
+}
+
+}  // namespace
+
 absl::StatusOr<SymbolicGuardedMap> SymbolicGuardedMap::CreateSymbolicGuardedMap(
-    const google::protobuf::Map<std::string, ir::HeaderType> &headers) {
-  ASSIGN_OR_RETURN(auto map, util::FreeSymbolicHeaders(headers));
-  return SymbolicGuardedMap(map);
+    const google::protobuf::Map<std::string, ir::HeaderType> &headers,
+    z3::context &z3_context) {
+  ASSIGN_OR_RETURN(auto map, util::FreeSymbolicHeaders(headers, z3_context));
+
+  // Assign ids in the sorted order of the keys, so that iteration order does
+  // not depend on hashing.
+  auto keys = std::make_shared<Keys>();
+  keys->names.reserve(map.size());
+  for (const auto &[key, unused] : map) keys->names.push_back(key);
+  std::sort(keys->names.begin(), keys->names.end());
+
+  auto values = std::make_shared<std::vector<z3::expr>>();
+  values->reserve(map.size());
+  keys->ids.reserve(map.size());
+  for (int id = 0; id < static_cast<int>(keys->names.size()); ++id) {
+    const std::string &key = keys->names[id];
+    keys->ids[key] = id;
+    values->push_back(map.at(key));
+  }
+  return SymbolicGuardedMap(std::move(keys), std::move(values));
 }
 
-bool SymbolicGuardedMap::ContainsKey(const std::string &key) const {
-  return this->map_.count(key) == 1;
+bool SymbolicGuardedMap::ContainsKey(absl::string_view key) const {
+  return keys_->ids.contains(key);
 }
 
-absl::StatusOr<z3::expr> SymbolicGuardedMap::Get(const std::string &key) const {
-  if (this->ContainsKey(key)) {
-    return this->map_.at(key);
+absl::StatusOr<int> SymbolicGuardedMap::GetId(absl::string_view key) const {
+  auto it = keys_->ids.find(key);
+  if (it == keys_->ids.end()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot find key \"", key, "\" in SymbolicGuardedMap!"));
   }
+  return it->second;
+}
+
+absl::StatusOr<z3::expr> SymbolicGuardedMap::Get(absl::string_view key) const {
+  ASSIGN_OR_RETURN(int id, GetId(key));
+  return (*values_)[id];
+}
+
+absl::StatusOr<z3::expr> SymbolicGuardedMap::Get(
+    absl::string_view header_name, absl::string_view field_name) const {
+  return Get(FieldKey(header_name, field_name));
+}
 
-  return absl::InvalidArgumentError(
-      absl::StrCat("Cannot find key \"", key, "\" in SymbolicGuardedMap!"));
+absl::StatusOr<z3::expr> SymbolicGuardedMap::Get(int id) const {
+  if (id < 0 || id >= static_cast<int>(values_->size())) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot find id ", id, " in SymbolicGuardedMap!"));
+  }
+  return (*values_)[id];
 }
 
-absl::Status SymbolicGuardedMap::Set(const std::string &key,
+absl::Status SymbolicGuardedMap::Set(absl::string_view key,
                                      const z3::expr &value,
                                      const z3::expr &guard) {
-  if (!this->ContainsKey(key)) {
+  auto it = keys_->ids.find(key);
+  if (it == keys_->ids.end()) {
     return absl::InvalidArgumentError(absl::StrCat(
         "Cannot assign to key \"", key, "\" in SymbolicGuardedMap!"));
   }
+  return Set(it->second, value, guard);
+}
+
+absl::Status SymbolicGuardedMap::Set(absl::string_view header_name,
+                                     absl::string_view field_name,
+                                     const z3::expr &value,
+                                     const z3::expr &guard) {
+  return Set(FieldKey(header_name, field_name), value, guard);
+}
+
+absl::Status SymbolicGuardedMap::Set(int id, const z3::expr &value,
+                                     const z3::expr &guard) {
+  if (id < 0 || id >= static_cast<int>(values_->size())) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot assign to id ", id, " in SymbolicGuardedMap!"));
+  }
 
-  z3::expr &old_value = this->map_.at(key);
+  const z3::expr &old_value = (*values_)[id];
 
   // operators::Ite will check for sort compatibility and pad when needed.
   // However, Ite() does not have a notion of pre-defined size, and will padd
@@ -65,13 +133,21 @@ absl::Status SymbolicGuardedMap::Set(const std::string &key,
           absl::StrFormat("Cannot assign to key \"%s\" a value whose bit size "
                           "%d is greater than the pre-defined bit size %d in "
                           "SymbolicGuardedMap!",
-                          key, new_size, old_size));
+                          keys_->names[id], new_size, old_size));
     }
   }
 
   // This will return an absl error if the sorts are incompatible, and will pad
   // shorter bit vectors.
-  ASSIGN_OR_RETURN(old_value, operators::Ite(guard, value, old_value));
+  ASSIGN_OR_RETURN(z3::expr new_value, operators::Ite(guard, value, old_value));
+  // Ite folds false guards and unchanged values, so this is common.
+  if (z3::eq(new_value, old_value)) return absl::OkStatus();
+
+  // Copy-on-write: the values are still shared with another copy of the map.
+  if (values_.use_count() > 1) {
+    values_ = std::make_shared<std::vector<z3::expr>>(*values_);
+  }
+  (*values_)[id] = std::move(new_value);
   return absl::OkStatus();
 }
 
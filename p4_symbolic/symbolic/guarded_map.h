@@ -17,10 +17,15 @@
 #ifndef P4_SYMBOLIC_SYMBOLIC_GUARDED_MAP_H_
 #define P4_SYMBOLIC_SYMBOLIC_GUARDED_MAP_H_
 
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "google/protobuf/map.h"
 #include "gutil/status.h"
 #include "p4_symbolic/ir/ir.pb.h"
@@ -29,7 +34,7 @@
 namespace p4_symbolic {
 namespace symbolic {
 
-// This class wraps around an internal std::unordered_map instance,
+// This class wraps around an internal vector of symbolic values,
 // while enforcing the following:
 // 1. This class can only be instantiated with an instance of the IR
 //    header definitions. The resulting instance will be initialized
@@ -48,12 +53,17 @@ namespace symbolic {
 // 2. A value mapped by a key always has the same sort.
 // 3. A value can only be assigned to a key given a guard.
 //
+// Keys are interned to dense ids when the map is created, in the sorted order
+// of the keys, and the key table is shared by all copies of the map. Values
+// are shared between copies too, and only copied by the first `Set` on a copy
+// (copy-on-write), so copying the map at branches of the program is cheap.
 class SymbolicGuardedMap {
  public:
   // Constructor requires passing the headers definition and will fill the map
-  // with a free symbolic variable per header field.
+  // with a free symbolic variable per header field, created in `z3_context`.
   static absl::StatusOr<SymbolicGuardedMap> CreateSymbolicGuardedMap(
-      const google::protobuf::Map<std::string, ir::HeaderType> &headers);
+      const google::protobuf::Map<std::string, ir::HeaderType> &headers,
+      z3::context &z3_context);
 
   // Explicitly copyable and movable!
   SymbolicGuardedMap(const SymbolicGuardedMap &other) = default;
@@ -64,28 +74,77 @@ class SymbolicGuardedMap {
   SymbolicGuardedMap &operator=(SymbolicGuardedMap &&other) = delete;
 
   // Getters.
-  bool ContainsKey(const std::string &key) const;
-  absl::StatusOr<z3::expr> Get(const std::string &key) const;
+  bool ContainsKey(absl::string_view key) const;
+  absl::StatusOr<z3::expr> Get(absl::string_view key) const;
+  absl::StatusOr<z3::expr> Get(absl::string_view header_name,
+                               absl::string_view field_name) const;
 
-  // Guarded setter.
-  // Returns an error if the assigned value has incompatible sort with the
+  // Returns the id of `key`, which stays valid for all copies of this map, or
+  // an error if the key is not found in the map. Looking up values by id
+  // avoids hashing the key again.
+  absl::StatusOr<int> GetId(absl::string_view key) const;
+  absl::StatusOr<z3::expr> Get(int id) const;
+
+  // Guarded setters.
+  // Return an error if the assigned value has incompatible sort with the
   // pre-defined value.
-  absl::Status Set(const std::string &key, const z3::expr &value,
+  absl::Status Set(absl::string_view key, const z3::expr &value,
                    const z3::expr &guard);
+  absl::Status Set(absl::string_view header_name, absl::string_view field_name,
+                   const z3::expr &value, const z3::expr &guard);
+  absl::Status Set(int id, const z3::expr &value, const z3::expr &guard);
+
+  // Constant iterator over (key, value) pairs, in the order of the key ids.
+  class const_iterator {
+   public:
+    using value_type = std::pair<const std::string &, const z3::expr &>;
+
+    value_type operator*() const {
+      return {map_->keys_->names[id_], (*map_->values_)[id_]};
+    }
+    const_iterator &operator++() {
+      ++id_;
+      return *this;
+    }
+    bool operator==(const const_iterator &other) const {
+      return id_ == other.id_;
+    }
+    bool operator!=(const const_iterator &other) const {
+      return id_ != other.id_;
+    }
 
-  // Constant iterators.
-  using const_iterator =
-      std::unordered_map<std::string, z3::expr>::const_iterator;
-  const_iterator begin() const noexcept { return this->map_.cbegin(); }
-  const_iterator end() const noexcept { return this->map_.cend(); }
+   private:
+    friend class SymbolicGuardedMap;
+    const_iterator(const SymbolicGuardedMap *map, int id)
+        : map_(map), id_(id) {}
+
+    const SymbolicGuardedMap *map_;
+    int id_;
+  };
+  const_iterator begin() const noexcept { return const_iterator(this, 0); }
+  const_iterator end() const noexcept {
+    return const_iterator(this, static_cast<int>(values_->size()));
+  }
 
  private:
-  // The underlying map storing the keys and their values.
-  std::unordered_map<std::string, z3::expr> map_;
+  // The interned keys of the map.
+  struct Keys {
+    // Maps the id of a key to the key.
+    std::vector<std::string> names;
+    // Maps a key to its id.
+    absl::flat_hash_map<std::string, int> ids;
+  };
+
+  // Shared by all copies of the map.
+  std::shared_ptr<const Keys> keys_;
+  // Maps the id of a key to its value. Shared by copies of the map until one
+  // of them is mutated.
+  std::shared_ptr<std::vector<z3::expr>> values_;
 
   // Private constructor used by factory.
-  explicit SymbolicGuardedMap(std::unordered_map<std::string, z3::expr> map)
-      : map_(map) {}
+  SymbolicGuardedMap(std::shared_ptr<const Keys> keys,
+                     std::shared_ptr<std::vector<z3::expr>> values)
+      : keys_(std::move(keys)), values_(std::move(values)) {}
 };
 
 }  // namespace symbolic
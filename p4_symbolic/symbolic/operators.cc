@@ -19,6 +19,8 @@
 
 #include "p4_symbolic/symbolic/operators.h"
 
+#include <atomic>
+#include <string>
 #include <utility>
 
 #include "absl/status/status.h"
@@ -35,7 +37,13 @@ namespace operators {
 // checking that the sort is correct.
 z3::expr Pad(const z3::expr &bitvector, int pad_size) {
   if (pad_size > 0) {
-    return z3::concat(Z3Context().bv_val(0, pad_size), bitvector);
+    // Optimization: padded numerals are folded into wider numerals, so that
+    // comparisons against them can be folded too.
+    if (std::string value; bitvector.is_numeral(value)) {
+      return bitvector.ctx().bv_val(
+          value.c_str(), bitvector.get_sort().bv_size() + pad_size);
+    }
+    return z3::concat(bitvector.ctx().bv_val(0, pad_size), bitvector);
   }
   return bitvector;
 }
@@ -100,18 +108,19 @@ absl::StatusOr<std::pair<z3::expr, z3::expr>> SortCheckAndExtract(
 // Free Variable.
 absl::StatusOr<z3::expr> FreeVariable(const std::string &variable_base_name,
                                       const z3::sort &sort) {
-  static unsigned int counter = 0;
+  // Shared by all z3 contexts, which may be used concurrently.
+  static std::atomic<unsigned int> counter = 0;
   std::string variable_name =
       absl::StrFormat("%s.%d", variable_base_name, counter++);
   switch (sort.sort_kind()) {
     case Z3_BOOL_SORT: {
-      return Z3Context().bool_const(variable_name.c_str());
+      return sort.ctx().bool_const(variable_name.c_str());
     }
     case Z3_INT_SORT: {
-      return Z3Context().int_const(variable_name.c_str());
+      return sort.ctx().int_const(variable_name.c_str());
     }
     case Z3_BV_SORT: {
-      return Z3Context().bv_const(variable_name.c_str(), sort.bv_size());
+      return sort.ctx().bv_const(variable_name.c_str(), sort.bv_size());
     }
     default:
       return absl::InvalidArgumentError(
@@ -142,13 +151,18 @@ absl::StatusOr<z3::expr> Eq(const z3::expr &a, const z3::expr &b) {
   ASSIGN_OR_RETURN(auto pair,
                    p4_symbolic::symbolic::operators::SortCheckAndPad(a, b));
   auto [a_expr, b_expr] = pair;
+  // Optimization: z3 hash-conses expressions, so syntactically equal operands
+  // are the same expression, and distinct numerals of the same sort are
+  // distinct values.
+  if (z3::eq(a_expr, b_expr)) return a.ctx().bool_val(true);
+  if (a_expr.is_numeral() && b_expr.is_numeral()) {
+    return a.ctx().bool_val(false);
+  }
   return a_expr == b_expr;
 }
 absl::StatusOr<z3::expr> Neq(const z3::expr &a, const z3::expr &b) {
-  ASSIGN_OR_RETURN(auto pair,
-                   p4_symbolic::symbolic::operators::SortCheckAndPad(a, b));
-  auto [a_expr, b_expr] = pair;
-  return a_expr != b_expr;
+  ASSIGN_OR_RETURN(z3::expr equal, Eq(a, b));
+  return Not(equal);
 }
 absl::StatusOr<z3::expr> Lt(const z3::expr &a, const z3::expr &b) {
   ASSIGN_OR_RETURN(auto pair,
@@ -174,11 +188,22 @@ absl::StatusOr<z3::expr> Gte(const z3::expr &a, const z3::expr &b) {
   auto [a_expr, b_expr] = pair;
   return z3::uge(a_expr, b_expr);
 }
-absl::StatusOr<z3::expr> Not(const z3::expr &a) { return !a; }
+// The boolean operations fold constant and identical operands, since guards
+// are built from them, and most guards are trivially true.
+absl::StatusOr<z3::expr> Not(const z3::expr &a) {
+  if (a.is_true()) return a.ctx().bool_val(false);
+  if (a.is_false()) return a.ctx().bool_val(true);
+  if (a.is_not()) return a.arg(0);
+  return !a;
+}
 absl::StatusOr<z3::expr> And(const z3::expr &a, const z3::expr &b) {
+  if (a.is_true() || b.is_false() || z3::eq(a, b)) return b;
+  if (b.is_true() || a.is_false()) return a;
   return a && b;
 }
 absl::StatusOr<z3::expr> Or(const z3::expr &a, const z3::expr &b) {
+  if (a.is_false() || b.is_true() || z3::eq(a, b)) return b;
+  if (b.is_false() || a.is_true()) return a;
   return a || b;
 }
 absl::StatusOr<z3::expr> BitNeg(const z3::expr &a) { return ~a; }
@@ -253,6 +278,16 @@ absl::StatusOr<z3::expr> Ite(const z3::expr &condition,
   // Values in both cases must have the same sort and signedness.
   ASSIGN_OR_RETURN(auto pair, SortCheckAndPad(true_value, false_value));
   auto [a_expr, b_expr] = pair;
+
+  // Optimization: a constant condition selects a branch, e.g. for assignments
+  // guarded by the guard of the top-level control, which is true. Folding
+  // after padding keeps the sort of the result independent of the condition.
+  if (condition.is_true()) return a_expr;
+  if (condition.is_false()) return b_expr;
+  if (a_expr.is_bool()) {
+    if (a_expr.is_true() && b_expr.is_false()) return condition;
+    if (a_expr.is_false() && b_expr.is_true()) return Not(condition);
+  }
   return z3::ite(condition, a_expr, b_expr);
 }
 
@@ -261,17 +296,16 @@ absl::StatusOr<z3::expr> ToBoolSort(const z3::expr &a) {
   if (a.get_sort().is_bool()) {
     return a;
   } else if (a.get_sort().is_bv()) {
-    return Gte(a, Z3Context().bv_val(1, 1));
+    return Gte(a, a.ctx().bv_val(1, 1));
   } else if (a.get_sort().is_int()) {
-    return a >= Z3Context().int_val(1);
+    return a >= a.ctx().int_val(1);
   } else {
     return absl::InvalidArgumentError("Illegal conversion to bool sort");
   }
 }
 absl::StatusOr<z3::expr> ToBitVectorSort(const z3::expr &a, unsigned int size) {
   if (a.get_sort().is_bool()) {
-    z3::expr bits =
-        z3::ite(a, Z3Context().bv_val(1, 1), Z3Context().bv_val(0, 1));
+    z3::expr bits = z3::ite(a, a.ctx().bv_val(1, 1), a.ctx().bv_val(0, 1));
     return Pad(bits, size - 1);
   } else if (a.get_sort().is_bv()) {
     if (a.get_sort().bv_size() <= size) {
@@ -28,35 +28,38 @@ namespace {
 // Get the symbolic field value from state or return a default value
 // of the given size.
 z3::expr GetOrDefault(SymbolicPerPacketState state, const std::string &field,
-                      unsigned int default_value_bit_size) {
+                      unsigned int default_value_bit_size,
+                      z3::context &z3_context) {
   if (state.ContainsKey(field)) {
     return state.Get(field).value();
   }
-  return Z3Context().bv_val(-1, default_value_bit_size);
+  return z3_context.bv_val(-1, default_value_bit_size);
 }
 
 }  // namespace
 
-SymbolicPacket ExtractSymbolicPacket(SymbolicPerPacketState state) {
-  z3::expr ipv6_src = GetOrDefault(state, "ipv6.src_addr", 128);
-  z3::expr ipv6_dst = GetOrDefault(state, "ipv6.dst_addr", 128);
+SymbolicPacket ExtractSymbolicPacket(SymbolicPerPacketState state,
+                                     z3::context &z3_context) {
+  z3::expr ipv6_src = GetOrDefault(state, "ipv6.src_addr", 128, z3_context);
+  z3::expr ipv6_dst = GetOrDefault(state, "ipv6.dst_addr", 128, z3_context);
 
-  return {GetOrDefault(state, "ethernet.src_addr", 48),
-          GetOrDefault(state, "ethernet.dst_addr", 48),
-          GetOrDefault(state, "ethernet.ether_type", 16),
+  return {GetOrDefault(state, "ethernet.src_addr", 48, z3_context),
+          GetOrDefault(state, "ethernet.dst_addr", 48, z3_context),
+          GetOrDefault(state, "ethernet.ether_type", 16, z3_context),
 
-          GetOrDefault(state, "ipv4.src_addr", 32),
-          GetOrDefault(state, "ipv4.dst_addr", 32),
+          GetOrDefault(state, "ipv4.src_addr", 32, z3_context),
+          GetOrDefault(state, "ipv4.dst_addr", 32, z3_context),
           ipv6_dst.extract(127, 64),
           ipv6_dst.extract(63, 0),
-          GetOrDefault(state, "ipv4.protocol", 8),
-          GetOrDefault(state, "ipv4.dscp", 6),
-          GetOrDefault(state, "ipv4.ttl", 8),
+          GetOrDefault(state, "ipv4.protocol", 8, z3_context),
+          GetOrDefault(state, "ipv4.dscp", 6, z3_context),
+          GetOrDefault(state, "ipv4.ttl", 8, z3_context),
 
-          GetOrDefault(state, "icmp.type", 8)};
+          GetOrDefault(state, "icmp.type", 8, z3_context)};
 }
 
-ConcretePacket ExtractConcretePacket(SymbolicPacket packet, z3::model model) {
+ConcretePacket ExtractConcretePacket(const SymbolicPacket &packet,
+                                     const z3::model &model) {
   return {model.eval(packet.eth_src, true).to_string(),
           model.eval(packet.eth_dst, true).to_string(),
           model.eval(packet.eth_type, true).to_string(),
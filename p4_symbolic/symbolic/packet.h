@@ -27,11 +27,13 @@ namespace symbolic {
 namespace packet {
 
 // Extract the packet fields from their p4 program counterparts.
-SymbolicPacket ExtractSymbolicPacket(SymbolicPerPacketState state);
+SymbolicPacket ExtractSymbolicPacket(SymbolicPerPacketState state,
+                                     z3::context &z3_context);
 
 // Extract a concrete packet by evaluating every field's corresponding
 // expression in the model.
-ConcretePacket ExtractConcretePacket(SymbolicPacket packet, z3::model model);
+ConcretePacket ExtractConcretePacket(const SymbolicPacket &packet,
+                                     const z3::model &model);
 
 }  // namespace packet
 }  // namespace symbolic
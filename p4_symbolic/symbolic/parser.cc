@@ -28,13 +28,13 @@ namespace symbolic {
 namespace parser {
 
 absl::StatusOr<std::vector<z3::expr>> EvaluateHardcodedParser(
-    const SymbolicPerPacketState &state) {
+    const SymbolicPerPacketState &state, z3::context &z3_context) {
   std::vector<z3::expr> constraints;
 
   // Set initial value for vrf.
   ASSIGN_OR_RETURN(z3::expr vrf_id, state.Get("scalars.userMetadata.vrf_id"));
   ASSIGN_OR_RETURN(z3::expr vrf_constraint,
-                   operators::Eq(vrf_id, Z3Context().bv_val(0, 1)));
+                   operators::Eq(vrf_id, z3_context.bv_val(0, 1)));
   constraints.push_back(vrf_constraint);
 
   // l4_src_port and l4_dst_port are extracted from the headers if tcp or udp
@@ -107,9 +107,9 @@ absl::StatusOr<std::vector<z3::expr>> EvaluateHardcodedParser(
   ASSIGN_OR_RETURN(z3::expr tcp_or_udp_valid,
                    operators::Or(tcp_valid, udp_valid));
   ASSIGN_OR_RETURN(z3::expr l4_src_port_constraint,
-                   operators::Eq(l4_src_port, Z3Context().bv_val(0, 1)));
+                   operators::Eq(l4_src_port, z3_context.bv_val(0, 1)));
   ASSIGN_OR_RETURN(z3::expr l4_dst_port_constraint,
-                   operators::Eq(l4_dst_port, Z3Context().bv_val(0, 1)));
+                   operators::Eq(l4_dst_port, z3_context.bv_val(0, 1)));
   constraints.push_back(z3::implies(!tcp_or_udp_valid, l4_src_port_constraint));
   constraints.push_back(z3::implies(!tcp_or_udp_valid, l4_dst_port_constraint));
 
@@ -25,6 +25,7 @@
 
 #include "gutil/status.h"
 #include "p4_symbolic/symbolic/symbolic.h"
+#include "z3++.h"
 
 #define ETHERTYPE_IPV4 0x0800
 #define ETHERTYPE_IPV6 0x86dd
@@ -42,7 +43,7 @@ namespace parser {
 // Creates assertions/constraints that encode some of the interesting
 // behavior of parsers in specific programs we want to analyze.
 absl::StatusOr<std::vector<z3::expr>> EvaluateHardcodedParser(
-    const SymbolicPerPacketState &state);
+    const SymbolicPerPacketState &state, z3::context &z3_context);
 
 }  // namespace parser
 }  // namespace symbolic
@@ -0,0 +1,518 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "p4_symbolic/symbolic/solver_state_cache.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+#include "gutil/status.h"
+#include "p4_symbolic/ir/ir.pb.h"
+#include "p4_symbolic/symbolic/guarded_map.h"
+#include "p4_symbolic/symbolic/packet.h"
+#include "p4_symbolic/symbolic/symbolic.h"
+#include "p4_symbolic/symbolic/values.h"
+#include "z3++.h"
+
+namespace p4_symbolic {
+namespace symbolic {
+namespace {
+
+constexpr char kCacheMagic[] = "P4SYMBOLICSMT";
+constexpr int kCacheMagicSize = sizeof(kCacheMagic) - 1;
+constexpr uint32_t kCacheVersion = 1;
+
+// The names of the symbolic handles of a solver state. Header and trace
+// handles are suffixed with the header field or the table, respectively.
+constexpr char kIngressPort[] = "ingress_port";
+constexpr char kEgressPort[] = "egress_port";
+constexpr char kEntriesLiteral[] = "entries_literal";
+constexpr char kTraceDropped[] = "trace.dropped";
+constexpr char kIngressHeadersPrefix[] = "ingress_headers/";
+constexpr char kEgressHeadersPrefix[] = "egress_headers/";
+constexpr char kTraceMatchedPrefix[] = "trace.matched/";
+constexpr char kTraceEntryIndexPrefix[] = "trace.entry_index/";
+
+// 64-bit FNV-1a over length-prefixed parts. Unlike absl::Hash, it does not
+// depend on a per-process seed.
+class Fingerprinter {
+ public:
+  void Add(absl::string_view bytes) {
+    const uint64_t size = bytes.size();
+    for (int i = 0; i < 8; ++i) AddByte(size >> (8 * i));
+    for (const char byte : bytes) AddByte(byte);
+  }
+  void Add(const google::protobuf::Message &message) {
+    std::string bytes;
+    {
+      google::protobuf::io::StringOutputStream stream(&bytes);
+      google::protobuf::io::CodedOutputStream output(&stream);
+      // Maps are serialized in an arbitrary order otherwise.
+      output.SetSerializationDeterministic(true);
+      message.SerializeToCodedStream(&output);
+    }
+    Add(bytes);
+  }
+
+  uint64_t fingerprint() const { return fingerprint_; }
+
+ private:
+  void AddByte(uint8_t byte) {
+    fingerprint_ ^= byte;
+    fingerprint_ *= 0x100000001b3;
+  }
+
+  uint64_t fingerprint_ = 0xcbf29ce484222325;
+};
+
+// Identifies the inputs a solver state was evaluated from. The z3 version is
+// included since the SMT-LIB2 rendering of a formula may differ across
+// versions.
+uint64_t CacheKey(const ir::P4Program &program, const ir::TableEntries &entries,
+                  const std::vector<int> &physical_ports,
+                  bool hardcoded_parser) {
+  Fingerprinter fingerprinter;
+  fingerprinter.Add(Z3_get_full_version());
+  fingerprinter.Add(program);
+  fingerprinter.Add(absl::StrCat(entries.size()));
+  for (const auto &[table, table_entries] : entries) {
+    fingerprinter.Add(table);
+    fingerprinter.Add(absl::StrCat(table_entries.size()));
+    for (const ir::TableEntry &entry : table_entries) {
+      fingerprinter.Add(entry);
+    }
+  }
+  fingerprinter.Add(absl::StrJoin(physical_ports, ","));
+  fingerprinter.Add(hardcoded_parser ? "hardcoded parser" : "");
+  return fingerprinter.fingerprint();
+}
+
+std::string CacheFilePath(absl::string_view directory, uint64_t key) {
+  return absl::StrFormat("%s/%016x.p4symbolicsmt", directory, key);
+}
+
+// The constant that the i-th handle is asserted to be equal to in the cached
+// formula, so that the handle can be found again after parsing.
+std::string CarrierName(int i) { return absl::StrCat("$cache_", i, "$"); }
+
+// Returns the symbolic handles of `solver_state`, with their names.
+std::vector<std::pair<std::string, z3::expr>> CollectHandles(
+    const SolverState &solver_state) {
+  const SymbolicContext &context = solver_state.context;
+  std::vector<std::pair<std::string, z3::expr>> handles = {
+      {kIngressPort, context.ingress_port},
+      {kEgressPort, context.egress_port},
+      {kEntriesLiteral, solver_state.entries_literal},
+      {kTraceDropped, context.trace.dropped},
+  };
+  for (const auto &[field, value] : context.ingress_headers) {
+    handles.push_back({absl::StrCat(kIngressHeadersPrefix, field), value});
+  }
+  for (const auto &[field, value] : context.egress_headers) {
+    handles.push_back({absl::StrCat(kEgressHeadersPrefix, field), value});
+  }
+  for (const auto &[table, match] : context.trace.matched_entries) {
+    handles.push_back(
+        {absl::StrCat(kTraceMatchedPrefix, table), match.matched});
+    handles.push_back(
+        {absl::StrCat(kTraceEntryIndexPrefix, table), match.entry_index});
+  }
+  return handles;
+}
+
+// Everything in a cache file besides its header.
+struct CacheContents {
+  int entries_version = 0;
+  // The first `num_assertions` assertions of `smt2` are those of the solver,
+  // and the following ones are the carrier equalities of `handle_names`.
+  int num_assertions = 0;
+  std::vector<std::string> handle_names;
+  values::P4RuntimeTranslator translator;
+  std::string smt2;
+};
+
+CacheContents MakeCacheContents(const SolverState &solver_state) {
+  CacheContents contents;
+  contents.entries_version = solver_state.entries_version;
+  contents.translator = solver_state.translator;
+
+  z3::context &z3_context = *solver_state.context.z3_context;
+  z3::solver dump(z3_context);
+  const z3::expr_vector assertions = solver_state.solver->assertions();
+  for (unsigned int i = 0; i < assertions.size(); ++i) dump.add(assertions[i]);
+  contents.num_assertions = assertions.size();
+  for (auto &[name, handle] : CollectHandles(solver_state)) {
+    const int i = contents.handle_names.size();
+    dump.add(z3_context.constant(CarrierName(i).c_str(), handle.get_sort()) ==
+             handle);
+    contents.handle_names.push_back(std::move(name));
+  }
+  contents.smt2 = dump.to_smt2();
+  return contents;
+}
+
+void WriteString(google::protobuf::io::CodedOutputStream &output,
+                 absl::string_view value) {
+  output.WriteVarint64(value.size());
+  output.WriteRaw(value.data(), value.size());
+}
+
+bool ReadString(google::protobuf::io::CodedInputStream &input,
+                std::string *value) {
+  uint64_t size = 0;
+  return input.ReadVarint64(&size) && input.ReadString(value, size);
+}
+
+void WriteTranslator(google::protobuf::io::CodedOutputStream &output,
+                     const values::P4RuntimeTranslator &translator) {
+  output.WriteVarint32(translator.allocators.size());
+  for (const values::IdAllocator &allocator : translator.allocators) {
+    output.WriteVarint32(allocator.AllocatedStrings().size());
+    for (const std::string &value : allocator.AllocatedStrings()) {
+      WriteString(output, value);
+    }
+  }
+  for (const auto *index : {&translator.allocator_index_from_type,
+                            &translator.allocator_index_from_field}) {
+    output.WriteVarint32(index->size());
+    for (const auto &[name, allocator_index] : *index) {
+      WriteString(output, name);
+      output.WriteVarint32(allocator_index);
+    }
+  }
+}
+
+bool ReadTranslator(google::protobuf::io::CodedInputStream &input,
+                    values::P4RuntimeTranslator &translator) {
+  uint32_t num_allocators = 0;
+  if (!input.ReadVarint32(&num_allocators)) return false;
+  translator.allocators.resize(num_allocators);
+  for (values::IdAllocator &allocator : translator.allocators) {
+    uint32_t num_values = 0;
+    if (!input.ReadVarint32(&num_values)) return false;
+    for (uint32_t id = 0; id < num_values; ++id) {
+      std::string value;
+      // Allocating the strings in order gives them their original ids, unless
+      // the file has duplicates.
+      if (!ReadString(input, &value) || allocator.AllocateId(value) != id) {
+        return false;
+      }
+    }
+  }
+  for (auto *index : {&translator.allocator_index_from_type,
+                      &translator.allocator_index_from_field}) {
+    uint32_t size = 0;
+    if (!input.ReadVarint32(&size)) return false;
+    for (uint32_t i = 0; i < size; ++i) {
+      std::string name;
+      uint32_t allocator_index = 0;
+      if (!ReadString(input, &name) || !input.ReadVarint32(&allocator_index) ||
+          allocator_index >= num_allocators) {
+        return false;
+      }
+      (*index)[name] = allocator_index;
+    }
+  }
+  return true;
+}
+
+absl::Status WriteCacheFile(const std::string &path, uint64_t key,
+                            const CacheContents &contents) {
+  const std::string tmp_path = absl::StrCat(path, ".tmp");
+  std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return gutil::InternalErrorBuilder()
+           << "Could not open solver state cache '" << tmp_path
+           << "' for writing: " << std::strerror(errno);
+  }
+
+  bool serialized = true;
+  {
+    google::protobuf::io::OstreamOutputStream output_stream(&file);
+    google::protobuf::io::CodedOutputStream output(&output_stream);
+
+    output.WriteRaw(kCacheMagic, kCacheMagicSize);
+    output.WriteVarint32(kCacheVersion);
+    output.WriteLittleEndian64(key);
+    output.WriteVarint32(contents.entries_version);
+    output.WriteVarint32(contents.num_assertions);
+    output.WriteVarint32(contents.handle_names.size());
+    for (const std::string &name : contents.handle_names) {
+      WriteString(output, name);
+    }
+    WriteTranslator(output, contents.translator);
+    WriteString(output, contents.smt2);
+    serialized = !output.HadError();
+  }
+  file.close();
+  if (!serialized || file.fail()) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Failed to write solver state cache '" << tmp_path << "'.";
+  }
+
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Could not move solver state cache to '" << path
+           << "': " << std::strerror(errno);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<CacheContents> ReadCacheFile(const std::string &path,
+                                            uint64_t key) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return gutil::NotFoundErrorBuilder()
+           << "Could not open solver state cache '" << path
+           << "': " << std::strerror(errno);
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  const std::string data = buffer.str();
+
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t *>(data.data()), data.size());
+  // Formulas of large programs exceed the default limit of 64MiB.
+  input.SetTotalBytesLimit(data.size());
+
+  std::string magic;
+  uint32_t version = 0;
+  if (!input.ReadString(&magic, kCacheMagicSize) || magic != kCacheMagic ||
+      !input.ReadVarint32(&version)) {
+    return gutil::DataLossErrorBuilder()
+           << "'" << path << "' is not a solver state cache.";
+  }
+  if (version != kCacheVersion) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "Solver state cache '" << path << "' has version " << version
+           << ", but only version " << kCacheVersion << " is supported.";
+  }
+  uint64_t cached_key = 0;
+  if (!input.ReadLittleEndian64(&cached_key)) {
+    return gutil::DataLossErrorBuilder()
+           << "Solver state cache '" << path << "' has a corrupt header.";
+  }
+  if (cached_key != key) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "Solver state cache '" << path
+           << "' was written for other inputs or another version of z3.";
+  }
+
+  CacheContents contents;
+  uint32_t entries_version = 0, num_assertions = 0, num_handles = 0;
+  bool complete = input.ReadVarint32(&entries_version) &&
+                  input.ReadVarint32(&num_assertions) &&
+                  input.ReadVarint32(&num_handles);
+  for (uint32_t i = 0; complete && i < num_handles; ++i) {
+    complete = ReadString(input, &contents.handle_names.emplace_back());
+  }
+  complete = complete && ReadTranslator(input, contents.translator) &&
+             ReadString(input, &contents.smt2);
+  if (!complete) {
+    return gutil::DataLossErrorBuilder()
+           << "Solver state cache '" << path << "' is truncated or corrupt.";
+  }
+  if (input.CurrentPosition() != data.size()) {
+    return gutil::DataLossErrorBuilder() << "Solver state cache '" << path
+                                         << "' has unexpected trailing data.";
+  }
+  contents.entries_version = entries_version;
+  contents.num_assertions = num_assertions;
+  return contents;
+}
+
+// Sets every field of `headers` to its handle named `prefix` + field.
+absl::Status RestoreHeaders(
+    const absl::flat_hash_map<std::string, z3::expr> &handles,
+    absl::string_view prefix, SymbolicPerPacketState &headers,
+    z3::context &z3_context) {
+  std::vector<std::string> fields;
+  for (const auto &[field, value] : headers) fields.push_back(field);
+  for (const std::string &field : fields) {
+    auto it = handles.find(absl::StrCat(prefix, field));
+    if (it == handles.end()) {
+      return gutil::DataLossErrorBuilder()
+             << "Solver state cache has no value for " << prefix << field;
+    }
+    RETURN_IF_ERROR(headers.Set(field, it->second, z3_context.bool_val(true)));
+  }
+  return absl::OkStatus();
+}
+
+// Parses `contents` into a new z3 context, and returns the solver state it
+// was made from, for `data_plane` and `physical_ports`.
+absl::StatusOr<std::unique_ptr<SolverState>> RestoreSolverState(
+    const Dataplane &data_plane, const std::vector<int> &physical_ports,
+    const SolverOptions &solver_options, CacheContents contents) {
+  auto z3_context = std::make_unique<z3::context>();
+  z3::expr_vector parsed(*z3_context);
+  try {
+    parsed = z3_context->parse_string(contents.smt2.c_str());
+  } catch (const z3::exception &e) {
+    return gutil::DataLossErrorBuilder()
+           << "Solver state cache has an invalid formula: " << e.msg();
+  }
+  if (parsed.size() != contents.num_assertions + contents.handle_names.size()) {
+    return gutil::DataLossErrorBuilder()
+           << "Solver state cache has " << parsed.size()
+           << " assertions, but expected " << contents.num_assertions
+           << " and " << contents.handle_names.size() << " handles.";
+  }
+
+  auto z3_solver = std::make_unique<z3::solver>(
+      MakeSolver(*z3_context, solver_options));
+  for (int i = 0; i < contents.num_assertions; ++i) z3_solver->add(parsed[i]);
+
+  absl::flat_hash_map<std::string, z3::expr> handles;
+  for (int i = 0; i < contents.handle_names.size(); ++i) {
+    const z3::expr carrier = parsed[contents.num_assertions + i];
+    if (!carrier.is_app() || carrier.num_args() != 2 ||
+        carrier.arg(0).decl().name().str() != CarrierName(i)) {
+      return gutil::DataLossErrorBuilder()
+             << "Solver state cache has a malformed handle for "
+             << contents.handle_names[i];
+    }
+    handles.try_emplace(contents.handle_names[i], carrier.arg(1));
+  }
+  auto get_handle = [&](const std::string &name) -> absl::StatusOr<z3::expr> {
+    auto it = handles.find(name);
+    if (it == handles.end()) {
+      return gutil::DataLossErrorBuilder()
+             << "Solver state cache has no value for " << name;
+    }
+    return it->second;
+  };
+
+  // The ingress headers are free variables, which parse back into the very
+  // same expressions, but are restored like the egress headers regardless.
+  ASSIGN_OR_RETURN(SymbolicPerPacketState ingress_headers,
+                   SymbolicGuardedMap::CreateSymbolicGuardedMap(
+                       data_plane.program.headers(), *z3_context));
+  SymbolicPerPacketState egress_headers(ingress_headers);
+  RETURN_IF_ERROR(RestoreHeaders(handles, kIngressHeadersPrefix,
+                                 ingress_headers, *z3_context));
+  RETURN_IF_ERROR(RestoreHeaders(handles, kEgressHeadersPrefix, egress_headers,
+                                 *z3_context));
+
+  ASSIGN_OR_RETURN(z3::expr dropped, get_handle(kTraceDropped));
+  SymbolicTrace trace = {.dropped = dropped};
+  for (const std::string &name : contents.handle_names) {
+    if (!absl::StartsWith(name, kTraceMatchedPrefix)) continue;
+    const std::string table = name.substr(std::strlen(kTraceMatchedPrefix));
+    ASSIGN_OR_RETURN(z3::expr matched, get_handle(name));
+    ASSIGN_OR_RETURN(z3::expr entry_index,
+                     get_handle(absl::StrCat(kTraceEntryIndexPrefix, table)));
+    trace.matched_entries.insert({table, {matched, entry_index}});
+  }
+
+  ASSIGN_OR_RETURN(z3::expr ingress_port, get_handle(kIngressPort));
+  ASSIGN_OR_RETURN(z3::expr egress_port, get_handle(kEgressPort));
+  ASSIGN_OR_RETURN(z3::expr entries_literal, get_handle(kEntriesLiteral));
+  SymbolicPacket ingress_packet =
+      packet::ExtractSymbolicPacket(ingress_headers, *z3_context);
+  SymbolicPacket egress_packet =
+      packet::ExtractSymbolicPacket(egress_headers, *z3_context);
+  SymbolicContext symbolic_context = {std::move(z3_context),
+                                      ingress_port,
+                                      egress_port,
+                                      ingress_packet,
+                                      egress_packet,
+                                      ingress_headers,
+                                      egress_headers,
+                                      trace};
+
+  return std::make_unique<SolverState>(
+      data_plane.program, data_plane.entries, std::move(symbolic_context),
+      std::move(z3_solver), std::move(contents.translator), physical_ports,
+      entries_literal, contents.entries_version);
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<SolverState>> EvaluateP4PipelineWithCache(
+    const Dataplane &data_plane, const std::vector<int> &physical_ports,
+    bool hardcoded_parser, const std::string &cache_directory,
+    const SolverOptions &solver_options) {
+  if (cache_directory.empty()) {
+    return EvaluateP4Pipeline(data_plane, physical_ports, hardcoded_parser,
+                              solver_options);
+  }
+
+  const std::string path = CacheFilePath(
+      cache_directory, CacheKey(data_plane.program, data_plane.entries,
+                                physical_ports, hardcoded_parser));
+  absl::StatusOr<std::unique_ptr<SolverState>> from_file =
+      ReadSolverStateCacheFile(path, data_plane, physical_ports,
+                               hardcoded_parser, solver_options);
+  if (from_file.ok()) return from_file;
+  LOG_IF(INFO, !absl::IsNotFound(from_file.status()))
+      << "Not using the solver state cache: " << from_file.status();
+
+  ASSIGN_OR_RETURN(std::unique_ptr<SolverState> solver_state,
+                   EvaluateP4Pipeline(data_plane, physical_ports,
+                                      hardcoded_parser, solver_options));
+  absl::Status saved =
+      WriteSolverStateCacheFile(path, *solver_state, hardcoded_parser);
+  LOG_IF(WARNING, !saved.ok())
+      << "Could not save the solver state cache: " << saved;
+  return solver_state;
+}
+
+absl::Status WriteSolverStateCacheFile(const std::string &path,
+                                       const SolverState &solver_state,
+                                       bool hardcoded_parser) {
+  return WriteCacheFile(
+      path,
+      CacheKey(solver_state.program, solver_state.entries,
+               solver_state.physical_ports, hardcoded_parser),
+      MakeCacheContents(solver_state));
+}
+
+absl::StatusOr<std::unique_ptr<SolverState>> ReadSolverStateCacheFile(
+    const std::string &path, const Dataplane &data_plane,
+    const std::vector<int> &physical_ports, bool hardcoded_parser,
+    const SolverOptions &solver_options) {
+  ASSIGN_OR_RETURN(
+      CacheContents contents,
+      ReadCacheFile(path, CacheKey(data_plane.program, data_plane.entries,
+                                   physical_ports, hardcoded_parser)));
+  return RestoreSolverState(data_plane, physical_ports, solver_options,
+                            std::move(contents));
+}
+
+}  // namespace symbolic
+}  // namespace p4_symbolic
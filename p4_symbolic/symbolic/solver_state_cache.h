@@ -0,0 +1,67 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Caches the result of `EvaluateP4Pipeline` on disk. Encoding a large program
+// and its entries dominates the runtime of p4-symbolic when only a few
+// assertions are solved, and only depends on the program, the entries, the
+// physical ports and whether the parser is hardcoded.
+//
+// A cache file holds the assertions of the solver as SMT-LIB2 text, the
+// symbolic handles of the `SymbolicContext` as expressions over the same
+// constants, and the state of the translator. Reading it parses the text into
+// a fresh z3 context, which is much cheaper than evaluating the program again.
+
+#ifndef P4_SYMBOLIC_SYMBOLIC_SOLVER_STATE_CACHE_H_
+#define P4_SYMBOLIC_SYMBOLIC_SOLVER_STATE_CACHE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "p4_symbolic/symbolic/symbolic.h"
+
+namespace p4_symbolic {
+namespace symbolic {
+
+// Returns the same solver state as `EvaluateP4Pipeline`, but reads it from a
+// file in `cache_directory` named after the fingerprint of the inputs, if
+// there is one. Otherwise, evaluates the pipeline and writes the file. Failing
+// to use the file is not an error. If `cache_directory` is empty, this is
+// `EvaluateP4Pipeline`.
+absl::StatusOr<std::unique_ptr<SolverState>> EvaluateP4PipelineWithCache(
+    const Dataplane &data_plane, const std::vector<int> &physical_ports,
+    bool hardcoded_parser, const std::string &cache_directory,
+    const SolverOptions &solver_options = {});
+
+// Writes `solver_state`, evaluated with `hardcoded_parser`, to `path`. The
+// file is replaced atomically.
+absl::Status WriteSolverStateCacheFile(const std::string &path,
+                                       const SolverState &solver_state,
+                                       bool hardcoded_parser);
+
+// Reads a solver state from a file written by `WriteSolverStateCacheFile`,
+// into a new z3 context and a solver configured by `solver_options`. Returns a
+// FailedPrecondition error if the file was written for other inputs or by
+// another version of z3, and a DataLoss error if it is corrupt.
+absl::StatusOr<std::unique_ptr<SolverState>> ReadSolverStateCacheFile(
+    const std::string &path, const Dataplane &data_plane,
+    const std::vector<int> &physical_ports, bool hardcoded_parser,
+    const SolverOptions &solver_options = {});
+
+}  // namespace symbolic
+}  // namespace p4_symbolic
+
+#endif  // P4_SYMBOLIC_SYMBOLIC_SOLVER_STATE_CACHE_H_
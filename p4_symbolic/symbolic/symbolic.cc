@@ -14,8 +14,21 @@
 
 #include "p4_symbolic/symbolic/symbolic.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>  // NOLINT: third_party code.
 #include <utility>
 
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "google/protobuf/util/message_differencer.h"
+#include "p4_symbolic/ir/cone_of_influence.h"
 #include "p4_symbolic/symbolic/control.h"
 #include "p4_symbolic/symbolic/operators.h"
 #include "p4_symbolic/symbolic/packet.h"
@@ -25,107 +38,303 @@
 namespace p4_symbolic {
 namespace symbolic {
 
-z3::context &Z3Context() {
-  static z3::context *z3_context = new z3::context();
-  return *z3_context;
-}
-
-absl::StatusOr<std::unique_ptr<SolverState>> EvaluateP4Pipeline(
-    const Dataplane &data_plane, const std::vector<int> &physical_ports,
-    bool hardcoded_parser) {
-  // Use global context to define a solver.
-  std::unique_ptr<z3::solver> z3_solver =
-      std::make_unique<z3::solver>(Z3Context());
-
-  // Create free/unconstrainted headers variables, and then
-  // put constraints on them matching the hardcoded behavior of the parser
-  // for programs we are interested in.
-  ASSIGN_OR_RETURN(SymbolicPerPacketState ingress_headers,
-                   SymbolicGuardedMap::CreateSymbolicGuardedMap(
-                       data_plane.program.headers()));
-  if (hardcoded_parser) {
-    ASSIGN_OR_RETURN(std::vector<z3::expr> parser_constraints,
-                     parser::EvaluateHardcodedParser(ingress_headers));
-    for (const z3::expr &constraint : parser_constraints) {
-      z3_solver->add(constraint);
-    }
-  }
+namespace {
 
-  // Initially, the p4runtime translator has empty state.
-  values::P4RuntimeTranslator translator;
+// The parts of the symbolic evaluation of a program that depend on its table
+// entries.
+struct EntriesEncoding {
+  SymbolicPerPacketState egress_headers;
+  SymbolicTrace trace;
+  z3::expr egress_port;
+  // Restricts the egress port to the available physical ports.
+  z3::expr egress_port_domain;
+};
 
+// Symbolically evaluates the program in `data_plane` against its entries,
+// starting from `ingress_headers`.
+absl::StatusOr<EntriesEncoding> EvaluateEntries(
+    const Dataplane &data_plane, const SymbolicPerPacketState &ingress_headers,
+    const std::vector<int> &physical_ports,
+    values::P4RuntimeTranslator &translator, z3::context &z3_context) {
   // "Accumulator"-style p4 program headers.
   // This is used to evaluate the P4 program.
   // Initially free/unconstrained and contains symbolic variables for
   // every header field.
   SymbolicPerPacketState egress_headers(ingress_headers);
 
-  ASSIGN_OR_RETURN(z3::expr ingress_port,
-                   ingress_headers.Get("standard_metadata.ingress_port"));
-  SymbolicPacket ingress_packet =
-      packet::ExtractSymbolicPacket(ingress_headers);
-
   // Evaluate the initial control, which will evaluate the next controls
   // internally and return the full symbolic trace.
   ASSIGN_OR_RETURN(
       SymbolicTrace trace,
       control::EvaluateControl(data_plane, data_plane.program.initial_control(),
                                &egress_headers, &translator,
-                               Z3Context().bool_val(true)));
+                               z3_context.bool_val(true)));
 
   // Alias the event that the packet is dropped for ease of use in assertions.
   z3::expr dropped_value =
-      Z3Context().bv_val(DROPPED_EGRESS_SPEC_VALUE, DROPPED_EGRESS_SPEC_LENGTH);
+      z3_context.bv_val(DROPPED_EGRESS_SPEC_VALUE, DROPPED_EGRESS_SPEC_LENGTH);
   ASSIGN_OR_RETURN(trace.dropped,
                    egress_headers.Get("standard_metadata.egress_spec"));
   ASSIGN_OR_RETURN(trace.dropped, operators::Eq(trace.dropped, dropped_value));
 
-  // Construct a symbolic context, containing state and trace information
-  // from evaluating the tables.
   ASSIGN_OR_RETURN(z3::expr egress_port,
                    egress_headers.Get("standard_metadata.egress_spec"));
 
   // Restrict ports to the available physical ports.
+  z3::expr egress_port_domain = z3_context.bool_val(true);
   if (!physical_ports.empty()) {
-    z3::expr ingress_port_domain = Z3Context().bool_val(false);
-    z3::expr egress_port_domain = trace.dropped;
-    unsigned int port_size = ingress_port.get_sort().bv_size();
+    egress_port_domain = trace.dropped;
+    unsigned int port_size = egress_port.get_sort().bv_size();
     for (int port : physical_ports) {
-      ASSIGN_OR_RETURN(
-          z3::expr ingress_port_eq,
-          operators::Eq(ingress_port, Z3Context().bv_val(port, port_size)));
       ASSIGN_OR_RETURN(
           z3::expr egress_port_eq,
-          operators::Eq(egress_port, Z3Context().bv_val(port, port_size)));
+          operators::Eq(egress_port, z3_context.bv_val(port, port_size)));
+      ASSIGN_OR_RETURN(egress_port_domain,
+                       operators::Or(egress_port_domain, egress_port_eq));
+    }
+  }
+
+  return EntriesEncoding{std::move(egress_headers), std::move(trace),
+                         std::move(egress_port), std::move(egress_port_domain)};
+}
+
+// Returns a fresh literal under which the constraints depending on the
+// `version`-th set of entries of a program are enforced.
+z3::expr EntriesLiteral(int version, z3::context &z3_context) {
+  return z3_context.bool_const(absl::StrCat("$entries_", version, "$").c_str());
+}
 
+// Returns the names of the tables whose entries differ between `old_entries`
+// and `new_entries`, in order.
+std::vector<std::string> ChangedTables(const ir::TableEntries &old_entries,
+                                       const ir::TableEntries &new_entries) {
+  auto same_entries = [](const std::vector<ir::TableEntry> &entries1,
+                         const std::vector<ir::TableEntry> &entries2) {
+    return std::equal(entries1.begin(), entries1.end(), entries2.begin(),
+                      entries2.end(),
+                      [](const ir::TableEntry &entry1,
+                         const ir::TableEntry &entry2) {
+                        return google::protobuf::util::MessageDifferencer::
+                            Equals(entry1, entry2);
+                      });
+  };
+  std::vector<std::string> changed_tables;
+  // Both maps are ordered, so a merge finds the differences in one pass.
+  auto old_it = old_entries.begin();
+  auto new_it = new_entries.begin();
+  while (old_it != old_entries.end() || new_it != new_entries.end()) {
+    if (new_it == new_entries.end() ||
+        (old_it != old_entries.end() && old_it->first < new_it->first)) {
+      if (!old_it->second.empty()) changed_tables.push_back(old_it->first);
+      ++old_it;
+    } else if (old_it == old_entries.end() || new_it->first < old_it->first) {
+      if (!new_it->second.empty()) changed_tables.push_back(new_it->first);
+      ++new_it;
+    } else {
+      if (!same_entries(old_it->second, new_it->second)) {
+        changed_tables.push_back(old_it->first);
+      }
+      ++old_it;
+      ++new_it;
+    }
+  }
+  return changed_tables;
+}
+
+// Checks the assertions of the solver of `solver_state` under `assumptions`,
+// and records the statistics of the check.
+z3::check_result CheckAndRecordStatistics(SolverState &solver_state,
+                                          const z3::expr_vector &assumptions) {
+  const absl::Time start = absl::Now();
+  const z3::check_result result = solver_state.solver->check(assumptions);
+
+  SolverStatistics statistics;
+  statistics.result = result;
+  statistics.time = absl::Now() - start;
+  if (result == z3::unknown) {
+    statistics.reason_unknown = solver_state.solver->reason_unknown();
+  }
+  const z3::stats z3_statistics = solver_state.solver->statistics();
+  for (unsigned int i = 0; i < z3_statistics.size(); ++i) {
+    // The SMT solver reports "conflicts", and the SAT solver "sat conflicts".
+    const std::string key = z3_statistics.key(i);
+    if (absl::EndsWith(key, "conflicts") && z3_statistics.is_uint(i)) {
+      statistics.conflicts += z3_statistics.uint_value(i);
+    } else if (key == "max memory" && z3_statistics.is_double(i)) {
+      statistics.max_memory_mb = z3_statistics.double_value(i);
+    }
+  }
+  solver_state.last_query_statistics = std::move(statistics);
+  return result;
+}
+
+}  // namespace
+
+z3::solver MakeSolver(z3::context &z3_context, const SolverOptions &options) {
+  z3::solver solver(z3_context);
+  switch (options.profile) {
+    case SolverProfile::kBitBlast: {
+      z3::tactic bit_blast =
+          z3::tactic(z3_context, "simplify") &
+          z3::tactic(z3_context, "solve-eqs") &
+          z3::tactic(z3_context, "bit-blast") & z3::tactic(z3_context, "sat");
+      // Table matches use integer entry indices, which cannot be bit-blasted.
+      solver = z3::cond(z3::probe(z3_context, "is-qfbv"), bit_blast,
+                        z3::tactic(z3_context, "smt"))
+                   .mk_solver();
+      break;
+    }
+    case SolverProfile::kDefault:
+      break;
+  }
+
+  z3::params params(z3_context);
+  if (options.timeout_ms > 0) params.set("timeout", options.timeout_ms);
+  if (options.random_seed.has_value()) {
+    params.set("random_seed", *options.random_seed);
+  }
+  solver.set(params);
+  return solver;
+}
+
+absl::StatusOr<std::unique_ptr<SolverState>> EvaluateP4Pipeline(
+    const Dataplane &data_plane, const std::vector<int> &physical_ports,
+    bool hardcoded_parser, const SolverOptions &solver_options) {
+  // Every evaluation gets its own context, owned by the resulting
+  // SolverState, so that evaluations can run concurrently.
+  auto z3_context = std::make_unique<z3::context>();
+  std::unique_ptr<z3::solver> z3_solver = std::make_unique<z3::solver>(
+      MakeSolver(*z3_context, solver_options));
+
+  // Create free/unconstrainted headers variables, and then
+  // put constraints on them matching the hardcoded behavior of the parser
+  // for programs we are interested in.
+  ASSIGN_OR_RETURN(SymbolicPerPacketState ingress_headers,
+                   SymbolicGuardedMap::CreateSymbolicGuardedMap(
+                       data_plane.program.headers(), *z3_context));
+  if (hardcoded_parser) {
+    ASSIGN_OR_RETURN(
+        std::vector<z3::expr> parser_constraints,
+        parser::EvaluateHardcodedParser(ingress_headers, *z3_context));
+    for (const z3::expr &constraint : parser_constraints) {
+      z3_solver->add(constraint);
+    }
+  }
+
+  // Initially, the p4runtime translator has empty state.
+  values::P4RuntimeTranslator translator;
+
+  ASSIGN_OR_RETURN(z3::expr ingress_port,
+                   ingress_headers.Get("standard_metadata.ingress_port"));
+  SymbolicPacket ingress_packet =
+      packet::ExtractSymbolicPacket(ingress_headers, *z3_context);
+
+  ASSIGN_OR_RETURN(EntriesEncoding encoding,
+                   EvaluateEntries(data_plane, ingress_headers, physical_ports,
+                                   translator, *z3_context));
+
+  // Restrict ports to the available physical ports.
+  if (!physical_ports.empty()) {
+    z3::expr ingress_port_domain = z3_context->bool_val(false);
+    unsigned int port_size = ingress_port.get_sort().bv_size();
+    for (int port : physical_ports) {
+      ASSIGN_OR_RETURN(
+          z3::expr ingress_port_eq,
+          operators::Eq(ingress_port, z3_context->bv_val(port, port_size)));
       ASSIGN_OR_RETURN(ingress_port_domain,
                        operators::Or(ingress_port_domain, ingress_port_eq));
-      ASSIGN_OR_RETURN(egress_port_domain,
-                       operators::Or(egress_port_domain, egress_port_eq));
     }
     z3_solver->add(ingress_port_domain);
-    z3_solver->add(egress_port_domain);
   }
+  z3::expr entries_literal = EntriesLiteral(/*version=*/0, *z3_context);
+  z3_solver->add(z3::implies(entries_literal, encoding.egress_port_domain));
 
   // Construct solver state for this program.
-  SymbolicPacket egress_packet = packet::ExtractSymbolicPacket(egress_headers);
-  SymbolicContext symbolic_context = {
-      ingress_port,    egress_port,    ingress_packet, egress_packet,
-      ingress_headers, egress_headers, trace};
+  SymbolicPacket egress_packet =
+      packet::ExtractSymbolicPacket(encoding.egress_headers, *z3_context);
+  SymbolicContext symbolic_context = {std::move(z3_context),
+                                      ingress_port,
+                                      encoding.egress_port,
+                                      ingress_packet,
+                                      egress_packet,
+                                      ingress_headers,
+                                      encoding.egress_headers,
+                                      encoding.trace};
+
+  return std::make_unique<SolverState>(
+      data_plane.program, data_plane.entries, std::move(symbolic_context),
+      std::move(z3_solver), translator, physical_ports, entries_literal);
+}
+
+absl::StatusOr<std::unique_ptr<SolverState>> EvaluateP4PipelineSlice(
+    const Dataplane &data_plane, const std::vector<int> &physical_ports,
+    bool hardcoded_parser, ir::SliceCriterion criterion,
+    const SolverOptions &solver_options) {
+  // `EvaluateEntries` derives the egress port and the trace's dropped bit
+  // from it.
+  criterion.fields.insert("standard_metadata.egress_spec");
+  ASSIGN_OR_RETURN(ir::ConeOfInfluence cone,
+                   ir::ComputeConeOfInfluence(data_plane.program, criterion));
+  ASSIGN_OR_RETURN(ir::P4Program program,
+                   ir::SliceProgram(data_plane.program, cone));
+  Dataplane sliced = {std::move(program),
+                      ir::SliceTableEntries(data_plane.entries, cone)};
+  return EvaluateP4Pipeline(sliced, physical_ports, hardcoded_parser,
+                            solver_options);
+}
+
+absl::StatusOr<std::vector<std::string>> UpdateTableEntries(
+    std::unique_ptr<SolverState> &solver_state, ir::TableEntries entries) {
+  std::vector<std::string> changed_tables =
+      ChangedTables(solver_state->entries, entries);
+  if (changed_tables.empty()) return changed_tables;
+
+  // Evaluate into copies, so that `solver_state` is unchanged on error.
+  z3::context &z3_context = *solver_state->context.z3_context;
+  Dataplane data_plane = {solver_state->program, std::move(entries)};
+  values::P4RuntimeTranslator translator = solver_state->translator;
+  ASSIGN_OR_RETURN(
+      EntriesEncoding encoding,
+      EvaluateEntries(data_plane, solver_state->context.ingress_headers,
+                      solver_state->physical_ports, translator, z3_context));
+
+  // Disable the constraints of the old entries, which are only enforced
+  // under their literal, and add the new ones under a fresh literal.
+  z3::solver &solver = *solver_state->solver;
+  solver.add(!solver_state->entries_literal);
+  int entries_version = solver_state->entries_version + 1;
+  z3::expr entries_literal = EntriesLiteral(entries_version, z3_context);
+  solver.add(z3::implies(entries_literal, encoding.egress_port_domain));
 
-  return std::make_unique<SolverState>(data_plane.program, data_plane.entries,
-                                       symbolic_context, std::move(z3_solver),
-                                       translator);
+  SymbolicContext &old_context = solver_state->context;
+  SymbolicPacket egress_packet =
+      packet::ExtractSymbolicPacket(encoding.egress_headers, z3_context);
+  SymbolicContext symbolic_context = {std::move(old_context.z3_context),
+                                      old_context.ingress_port,
+                                      encoding.egress_port,
+                                      old_context.ingress_packet,
+                                      egress_packet,
+                                      old_context.ingress_headers,
+                                      encoding.egress_headers,
+                                      encoding.trace};
+  solver_state = std::make_unique<SolverState>(
+      std::move(data_plane.program), std::move(data_plane.entries),
+      std::move(symbolic_context), std::move(solver_state->solver),
+      std::move(translator), std::move(solver_state->physical_ports),
+      entries_literal, entries_version);
+  return changed_tables;
 }
 
 absl::StatusOr<std::optional<ConcreteContext>> Solve(
     const std::unique_ptr<SolverState> &solver_state,
-    const Assertion &assertion) {
+    const Assertion &assertion, const ModelExtractionOptions &options) {
   z3::expr constraint = assertion(solver_state->context);
 
   solver_state->solver->push();
   solver_state->solver->add(constraint);
-  switch (solver_state->solver->check()) {
+  solver_state->solver->add(solver_state->entries_literal);
+  switch (CheckAndRecordStatistics(
+      *solver_state, z3::expr_vector(*solver_state->context.z3_context))) {
     case z3::unsat:
       solver_state->solver->pop();
       return std::optional<ConcreteContext>();
@@ -140,16 +349,303 @@ absl::StatusOr<std::optional<ConcreteContext>> Solve(
       ASSIGN_OR_RETURN(
           ConcreteContext result,
           util::ExtractFromModel(solver_state->context, packet_model,
-                                 solver_state->translator));
+                                 solver_state->translator, options));
       solver_state->solver->pop();
       return std::make_optional<ConcreteContext>(result);
   }
 }
 
+absl::StatusOr<std::vector<std::optional<ConcreteContext>>> SolveAll(
+    const std::unique_ptr<SolverState> &solver_state,
+    const std::vector<Assertion> &assertions,
+    const ModelExtractionOptions &options) {
+  z3::context &z3_context = *solver_state->context.z3_context;
+  std::vector<z3::expr> goals;
+  goals.reserve(assertions.size());
+  for (const Assertion &assertion : assertions) {
+    goals.push_back(assertion(solver_state->context));
+  }
+
+  std::vector<std::optional<ConcreteContext>> results(goals.size());
+  std::vector<bool> satisfied(goals.size(), false);
+  for (int i = 0; i < static_cast<int>(goals.size()); ++i) {
+    if (satisfied[i]) continue;
+    // Checking under an assumption rather than with push/add/pop keeps the
+    // solver state, including learned lemmas, across all goals.
+    z3::expr_vector assumptions(z3_context);
+    assumptions.push_back(goals[i]);
+    assumptions.push_back(solver_state->entries_literal);
+    if (CheckAndRecordStatistics(*solver_state, assumptions) != z3::sat) {
+      continue;
+    }
+
+    z3::model model = solver_state->solver->get_model();
+    ASSIGN_OR_RETURN(ConcreteContext result,
+                     util::ExtractFromModel(solver_state->context, model,
+                                            solver_state->translator, options));
+    // The model may satisfy later goals too, which then need no solving.
+    for (int j = i + 1; j < static_cast<int>(goals.size()); ++j) {
+      if (!satisfied[j] &&
+          model.eval(goals[j], /*model_completion=*/true).is_true()) {
+        satisfied[j] = true;
+        results[j] = result;
+      }
+    }
+    satisfied[i] = true;
+    results[i] = std::move(result);
+  }
+  return results;
+}
+
+absl::StatusOr<std::vector<TableEntryCoverage>> SolveForTableEntryCoverage(
+    const std::unique_ptr<SolverState> &solver_state,
+    const std::vector<std::string> &table_names, const Assertion &assertion) {
+  std::vector<TableEntryCoverageGoal> goals;
+  std::vector<Assertion> goal_assertions;
+  for (const std::string &table_name : table_names) {
+    if (solver_state->context.trace.matched_entries.count(table_name) == 0) {
+      return gutil::NotFoundErrorBuilder()
+             << "table '" << table_name << "' is not in the symbolic trace";
+    }
+    int num_entries = 0;
+    if (auto it = solver_state->entries.find(table_name);
+        it != solver_state->entries.end()) {
+      num_entries = static_cast<int>(it->second.size());
+    }
+    for (int entry_index = -1; entry_index < num_entries; ++entry_index) {
+      goals.push_back({table_name, entry_index});
+      goal_assertions.push_back(
+          [&assertion, table_name,
+           entry_index](const SymbolicContext &context) -> z3::expr {
+            const SymbolicTableMatch &match =
+                context.trace.matched_entries.at(table_name);
+            return assertion(context) && match.matched &&
+                   match.entry_index == entry_index;
+          });
+    }
+  }
+
+  ASSIGN_OR_RETURN(std::vector<std::optional<ConcreteContext>> packets,
+                   SolveAll(solver_state, goal_assertions));
+  std::vector<TableEntryCoverage> coverage;
+  coverage.reserve(goals.size());
+  for (int i = 0; i < static_cast<int>(goals.size()); ++i) {
+    coverage.push_back({std::move(goals[i]), std::move(packets[i])});
+  }
+  return coverage;
+}
+
+absl::StatusOr<std::vector<std::optional<ConcreteContext>>> SolveConcurrently(
+    const Dataplane &data_plane, const std::vector<int> &physical_ports,
+    bool hardcoded_parser, const std::vector<Assertion> &assertions,
+    int num_threads, const SolverOptions &solver_options) {
+  if (num_threads <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "num_threads must be positive, but got " << num_threads;
+  }
+  num_threads = std::min<int>(num_threads, assertions.size());
+
+  std::vector<absl::StatusOr<std::optional<ConcreteContext>>> results(
+      assertions.size(), std::optional<ConcreteContext>());
+  // Assertions are handed out one at a time, since solving times vary widely.
+  std::atomic<int> next_assertion = 0;
+  // Returns an error iff the program could not be evaluated. Errors in solving
+  // an assertion are stored in its result.
+  auto solve_assertions = [&]() -> absl::Status {
+    ASSIGN_OR_RETURN(
+        std::unique_ptr<SolverState> solver_state,
+        EvaluateP4Pipeline(data_plane, physical_ports, hardcoded_parser,
+                           solver_options));
+    for (int i = next_assertion++; i < static_cast<int>(assertions.size());
+         i = next_assertion++) {
+      results[i] = Solve(solver_state, assertions[i]);
+    }
+    return absl::OkStatus();
+  };
+
+  std::vector<absl::Status> evaluation_statuses(num_threads);
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(
+        [&, i] { evaluation_statuses[i] = solve_assertions(); });
+  }
+  if (num_threads > 0) evaluation_statuses[0] = solve_assertions();
+  for (std::thread &thread : threads) thread.join();
+  for (const absl::Status &evaluation_status : evaluation_statuses) {
+    RETURN_IF_ERROR(evaluation_status);
+  }
+
+  std::vector<std::optional<ConcreteContext>> concrete_contexts;
+  concrete_contexts.reserve(results.size());
+  for (absl::StatusOr<std::optional<ConcreteContext>> &result : results) {
+    ASSIGN_OR_RETURN(std::optional<ConcreteContext> concrete_context,
+                     std::move(result));
+    concrete_contexts.push_back(std::move(concrete_context));
+  }
+  return concrete_contexts;
+}
+
+CubePartition PartitionByEntryIndex(std::string table_name, int num_entries,
+                                    int num_cubes) {
+  // Entry indices range over [-1, num_entries).
+  const int64_t num_indices = std::max(num_entries, 0) + 1;
+  num_cubes = std::clamp<int64_t>(num_cubes, 1, num_indices);
+  return CubePartition{
+      .num_cubes = num_cubes,
+      .cube = [table_name = std::move(table_name), num_indices, num_cubes](
+                  const SymbolicContext &context, int i) -> z3::expr {
+        z3::context &z3_context = *context.z3_context;
+        auto it = context.trace.matched_entries.find(table_name);
+        // A table outside of the trace is never matched, so the first cube
+        // covers everything.
+        if (it == context.trace.matched_entries.end()) {
+          return z3_context.bool_val(i == 0);
+        }
+        // The first and the last cube are unbounded, so that the cubes cover
+        // every packet even without knowing the range of the index.
+        const z3::expr &entry_index = it->second.entry_index;
+        z3::expr cube = z3_context.bool_val(true);
+        if (i > 0) {
+          cube = cube && entry_index >= static_cast<int>(
+                                            -1 + i * num_indices / num_cubes);
+        }
+        if (i < num_cubes - 1) {
+          cube = cube && entry_index < static_cast<int>(
+                                           -1 + (i + 1) * num_indices /
+                                                    num_cubes);
+        }
+        return cube;
+      },
+  };
+}
+
+CubePartition PartitionByIngressPort(std::vector<int> ports) {
+  const int num_cubes = static_cast<int>(ports.size()) + 1;
+  return CubePartition{
+      .num_cubes = num_cubes,
+      .cube = [ports = std::move(ports)](const SymbolicContext &context,
+                                         int i) -> z3::expr {
+        z3::context &z3_context = *context.z3_context;
+        const z3::expr &ingress_port = context.ingress_port;
+        const unsigned int port_size = ingress_port.get_sort().bv_size();
+        if (i < static_cast<int>(ports.size())) {
+          return ingress_port == z3_context.bv_val(ports[i], port_size);
+        }
+        z3::expr other_port = z3_context.bool_val(true);
+        for (int port : ports) {
+          other_port =
+              other_port && ingress_port != z3_context.bv_val(port, port_size);
+        }
+        return other_port;
+      },
+  };
+}
+
+absl::StatusOr<CubeAndConquerResult> SolveCubeAndConquer(
+    const Dataplane &data_plane, const std::vector<int> &physical_ports,
+    bool hardcoded_parser, const Assertion &assertion,
+    const CubePartition &partition, const CubeAndConquerOptions &options) {
+  if (options.num_threads <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "num_threads must be positive, but got " << options.num_threads;
+  }
+  if (partition.num_cubes <= 0 || !partition.cube) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "The partition must have at least one cube.";
+  }
+  const int num_threads = std::min(options.num_threads, partition.num_cubes);
+
+  CubeAndConquerResult result;
+  // Every cube is checked by a single thread, so its statistics need no lock.
+  result.cube_statistics.resize(partition.num_cubes);
+  std::atomic<int> next_cube = 0;
+  absl::Mutex mu;
+  // Guarded by `mu`: whether a packet was found, and the contexts of the
+  // threads still checking cubes, to interrupt them once it is.
+  bool found = false;
+  std::vector<z3::context *> contexts;
+
+  // Returns an error iff the program could not be evaluated, or the packet
+  // could not be extracted from the model.
+  auto solve_cubes = [&]() -> absl::Status {
+    ASSIGN_OR_RETURN(
+        std::unique_ptr<SolverState> solver_state,
+        EvaluateP4Pipeline(data_plane, physical_ports, hardcoded_parser,
+                           options.solver_options));
+    z3::context &z3_context = *solver_state->context.z3_context;
+    {
+      absl::MutexLock lock(&mu);
+      if (found) return absl::OkStatus();
+      contexts.push_back(&z3_context);
+    }
+    // All cubes of this thread are checked under the same assertion, so the
+    // solver keeps what it learned across them.
+    solver_state->solver->add(assertion(solver_state->context));
+
+    absl::Status status;
+    for (int i = next_cube++; i < partition.num_cubes; i = next_cube++) {
+      {
+        absl::MutexLock lock(&mu);
+        if (found) break;
+      }
+      z3::expr_vector assumptions(z3_context);
+      assumptions.push_back(partition.cube(solver_state->context, i));
+      assumptions.push_back(solver_state->entries_literal);
+      const z3::check_result check =
+          CheckAndRecordStatistics(*solver_state, assumptions);
+      result.cube_statistics[i] = solver_state->last_query_statistics;
+      if (check != z3::sat) continue;
+
+      absl::StatusOr<ConcreteContext> packet = util::ExtractFromModel(
+          solver_state->context, solver_state->solver->get_model(),
+          solver_state->translator, options.model_extraction_options);
+      absl::MutexLock lock(&mu);
+      if (found) break;
+      found = true;
+      if (packet.ok()) {
+        result.packet = *std::move(packet);
+      } else {
+        status = packet.status();
+      }
+      for (z3::context *context : contexts) {
+        if (context != &z3_context) context->interrupt();
+      }
+      break;
+    }
+
+    // The context is destroyed with `solver_state`, so it must not be
+    // interrupted anymore.
+    absl::MutexLock lock(&mu);
+    contexts.erase(std::find(contexts.begin(), contexts.end(), &z3_context));
+    return status;
+  };
+
+  std::vector<absl::Status> statuses(num_threads);
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back([&, i] { statuses[i] = solve_cubes(); });
+  }
+  statuses[0] = solve_cubes();
+  for (std::thread &thread : threads) thread.join();
+  for (const absl::Status &status : statuses) RETURN_IF_ERROR(status);
+
+  if (result.packet.has_value()) {
+    result.result = z3::sat;
+  } else if (std::all_of(result.cube_statistics.begin(),
+                         result.cube_statistics.end(),
+                         [](const SolverStatistics &statistics) {
+                           return statistics.result == z3::unsat;
+                         })) {
+    result.result = z3::unsat;
+  }
+  return result;
+}
+
 std::string DebugSMT(const std::unique_ptr<SolverState> &solver_state,
                      const Assertion &assertion) {
   solver_state->solver->push();
   solver_state->solver->add(assertion(solver_state->context));
+  solver_state->solver->add(solver_state->entries_literal);
   std::string smt = solver_state->solver->to_smt2();
   solver_state->solver->pop();
   return smt;
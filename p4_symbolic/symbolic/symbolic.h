@@ -23,6 +23,8 @@
 #define DROPPED_EGRESS_SPEC_VALUE "111111111"
 #define DROPPED_EGRESS_SPEC_LENGTH 9
 
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
@@ -31,7 +33,9 @@
 #include <vector>
 
 #include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
 #include "gutil/status.h"
+#include "p4_symbolic/ir/cone_of_influence.h"
 #include "p4_symbolic/ir/ir.pb.h"
 #include "p4_symbolic/ir/table_entries.h"
 #include "p4_symbolic/symbolic/guarded_map.h"
@@ -41,10 +45,6 @@
 namespace p4_symbolic {
 namespace symbolic {
 
-// Global z3::context used for creating symbolic expressions during symbolic
-// evaluation.
-z3::context &Z3Context();
-
 // Maps the name of a header field in the p4 program to its concrete value.
 using ConcretePerPacketState = std::unordered_map<std::string, std::string>;
 
@@ -201,11 +201,27 @@ struct ConcreteContext {
   }
 };
 
+// Selects the parts of a ConcreteContext that are extracted from a model. The
+// ports, packets and trace are always extracted. Evaluating every header field
+// dominates extraction on large programs, so callers that generate many
+// packets should only ask for the headers they use.
+struct ModelExtractionOptions {
+  // If false, `ingress_headers` and `egress_headers` are left empty.
+  bool extract_headers = true;
+  // If non-empty, only these fields of `ingress_headers` and `egress_headers`
+  // are extracted. Unknown fields are an error.
+  std::vector<std::string> header_fields;
+};
+
 // The symbolic context within our analysis.
 // Exposes symbolic handles for the fields of the input packet,
 // and its trace in the program.
 // Assertions are defined on a symbolic context.
 struct SymbolicContext {
+  // The z3::context owning every symbolic expression below. Declared first so
+  // that it outlives them. A z3::context must not be used by several threads
+  // at once, but distinct contexts can be used on distinct threads.
+  std::unique_ptr<z3::context> z3_context;
   z3::expr ingress_port;
   z3::expr egress_port;
   SymbolicPacket ingress_packet;
@@ -223,6 +239,41 @@ struct Dataplane {
   ir::TableEntries entries;
 };
 
+// Selects how the solver of a SolverState decides queries.
+enum class SolverProfile {
+  // z3's default, incremental SMT solver.
+  kDefault,
+  // Simplifies queries and bit-blasts them to SAT if they only use
+  // bitvectors, and uses the SMT solver otherwise. Every query is solved from
+  // scratch. Often faster on hard bitvector queries.
+  kBitBlast,
+};
+
+// The configuration of the solver of a SolverState.
+struct SolverOptions {
+  SolverProfile profile = SolverProfile::kDefault;
+  // If positive, every query taking longer than this many milliseconds is
+  // abandoned, and its result is unknown.
+  unsigned int timeout_ms = 0;
+  // If set, the seed of the solver's random choices, e.g. to get other
+  // packets for the same assertions.
+  std::optional<unsigned int> random_seed;
+};
+
+// Returns a solver in `z3_context` configured by `options`.
+z3::solver MakeSolver(z3::context &z3_context, const SolverOptions &options);
+
+// Statistics of a single solver query.
+struct SolverStatistics {
+  z3::check_result result = z3::unknown;
+  // Why the result is unknown, e.g. "timeout" or "canceled". Empty otherwise.
+  std::string reason_unknown;
+  absl::Duration time;
+  uint64_t conflicts = 0;
+  // The peak memory of z3, in megabytes.
+  double max_memory_mb = 0;
+};
+
 // The overall state of our symbolic solver/interpreter.
 // This is returned by our main analysis/interpration function, and is used
 // to find concrete test packets and for debugging.
@@ -230,7 +281,8 @@ struct Dataplane {
 // is not expected to access any of these fields or modify them.
 // Only one instance of this struct will be constructed per P4 program
 // evaluation, which can be then used to solve for particular assertions
-// many times.
+// many times. Each instance has its own z3::context (see SymbolicContext), so
+// distinct instances can be evaluated and solved on concurrently.
 struct SolverState {
   // The IR represnetation of the p4 program being analyzed.
   ir::P4Program program;
@@ -245,16 +297,31 @@ struct SolverState {
   std::unique_ptr<z3::solver> solver;
   // Store the p4 runtime translator state for use by .Solve(...).
   values::P4RuntimeTranslator translator;
+  // The physical ports the program was evaluated against.
+  std::vector<int> physical_ports;
+  // The statistics of the most recent query of `solver`.
+  SolverStatistics last_query_statistics;
+  // The constraints in `solver` that depend on `entries` are only enforced
+  // under this literal, which every solver call assumes. This allows
+  // `UpdateTableEntries` to swap them out without resetting the solver.
+  z3::expr entries_literal;
+  // The number of times `UpdateTableEntries` changed the entries.
+  int entries_version;
   // Need this constructor to be defined explicity to be able to use make_unique
   // on this struct.
   SolverState(ir::P4Program program, ir::TableEntries entries,
-              SymbolicContext context, std::unique_ptr<z3::solver> &&solver,
-              values::P4RuntimeTranslator translator)
+              SymbolicContext &&context, std::unique_ptr<z3::solver> &&solver,
+              values::P4RuntimeTranslator translator,
+              std::vector<int> physical_ports, z3::expr entries_literal,
+              int entries_version = 0)
       : program(program),
         entries(entries),
-        context(context),
+        context(std::move(context)),
         solver(std::move(solver)),
-        translator(translator) {}
+        translator(translator),
+        physical_ports(std::move(physical_ports)),
+        entries_literal(std::move(entries_literal)),
+        entries_version(entries_version) {}
 };
 
 // An assertion is a user defined function that takes a symbolic context
@@ -263,20 +330,141 @@ struct SolverState {
 // z3::expr portIsOne(const SymbolicContext &ctx) {
 //   return ctx.ingress_port == 1;
 // }
+// Any expressions built by an assertion must belong to `ctx.z3_context`.
 using Assertion = std::function<z3::expr(const SymbolicContext &)>;
 
 // Symbolically evaluates/interprets the given program against the given
 // entries for every table in that program, and the available physical ports
-// on the switch.
+// on the switch. The solver of the result is configured by `solver_options`.
 absl::StatusOr<std::unique_ptr<SolverState>> EvaluateP4Pipeline(
     const Dataplane &data_plane, const std::vector<int> &physical_ports,
-    bool hardcoded_parser);
+    bool hardcoded_parser, const SolverOptions &solver_options = {});
+
+// Like `EvaluateP4Pipeline`, but only encodes the part of the program that can
+// influence `criterion`, see ir/cone_of_influence.h. The egress port, and
+// whether the packet is dropped, are always part of the criterion. Solving
+// assertions that only refer to the tables and fields of `criterion` gives the
+// same results as on the whole program, from a much smaller formula. The trace
+// of the result only has the tables of the slice, and its program and entries
+// are those of the slice.
+absl::StatusOr<std::unique_ptr<SolverState>> EvaluateP4PipelineSlice(
+    const Dataplane &data_plane, const std::vector<int> &physical_ports,
+    bool hardcoded_parser, ir::SliceCriterion criterion,
+    const SolverOptions &solver_options = {});
+
+// Re-evaluates the program of `solver_state` against `entries`, e.g. after
+// the controller programmed a few entries, and replaces `solver_state` with
+// the result. The z3 context, the solver (including the lemmas it learned),
+// the translator and the symbolic ingress headers are all kept, so unchanged
+// parts of the program are encoded into the very same z3 expressions, and only
+// the constraints depending on the entries are swapped. Does nothing if no
+// table's entries changed. Returns the names of the tables whose entries
+// changed, in order. On error, `solver_state` is left unchanged.
+absl::StatusOr<std::vector<std::string>> UpdateTableEntries(
+    std::unique_ptr<SolverState> &solver_state, ir::TableEntries entries);
 
 // Finds a concrete packet and flow in the program that satisfies the given
-// assertion and meets the structure constrained by solver_state.
+// assertion and meets the structure constrained by solver_state. Returns
+// nullopt if there is no such packet, or if the solver gave up, e.g. on a
+// timeout; `solver_state->last_query_statistics` tells these apart.
 absl::StatusOr<std::optional<ConcreteContext>> Solve(
     const std::unique_ptr<SolverState> &solver_state,
-    const Assertion &assertion);
+    const Assertion &assertion, const ModelExtractionOptions &options = {});
+
+// Finds a concrete packet for each of the given `assertions`, like calling
+// `Solve` on each of them, but with fewer solver calls: every model found is
+// checked against the assertions that are not yet satisfied, and those it
+// satisfies are not solved for again. The i-th result corresponds to the i-th
+// assertion, so results of several assertions may be the same packet. Every
+// solver call is an incremental check on `solver_state`'s solver.
+absl::StatusOr<std::vector<std::optional<ConcreteContext>>> SolveAll(
+    const std::unique_ptr<SolverState> &solver_state,
+    const std::vector<Assertion> &assertions,
+    const ModelExtractionOptions &options = {});
+
+// A coverage goal: hitting the entry at `entry_index` of table `table_name`,
+// or the default entry of the table if `entry_index` is -1.
+struct TableEntryCoverageGoal {
+  std::string table_name;
+  int entry_index;
+};
+
+// The packet found for a coverage goal.
+struct TableEntryCoverage {
+  TableEntryCoverageGoal goal;
+  // Unset if no packet satisfying the assertion hits the entry.
+  std::optional<ConcreteContext> packet;
+};
+
+// Finds a packet hitting each entry and the default entry of each of the
+// tables in `table_names`, using their `SymbolicTrace::matched_entries`.
+// Every packet additionally satisfies `assertion`, e.g. to only find packets
+// that are not dropped. Goals are ordered by table as given, then by entry
+// index, starting with the default entry. Solved with `SolveAll`, so a single
+// packet may cover several goals. Returns NotFound for an unknown table.
+absl::StatusOr<std::vector<TableEntryCoverage>> SolveForTableEntryCoverage(
+    const std::unique_ptr<SolverState> &solver_state,
+    const std::vector<std::string> &table_names, const Assertion &assertion);
+
+// Finds a concrete packet for each of the given `assertions`, like calling
+// `Solve` on each of them, but on up to `num_threads` threads. Since a
+// z3::context is not thread-safe, every thread evaluates the program into its
+// own SolverState, and then solves the assertions it picks up one by one. The
+// i-th result corresponds to the i-th assertion. Returns the first error in
+// the order of the assertions, or InvalidArgument if `num_threads` <= 0.
+absl::StatusOr<std::vector<std::optional<ConcreteContext>>> SolveConcurrently(
+    const Dataplane &data_plane, const std::vector<int> &physical_ports,
+    bool hardcoded_parser, const std::vector<Assertion> &assertions,
+    int num_threads, const SolverOptions &solver_options = {});
+
+// A split of the search space of a query into `num_cubes` parts, or cubes.
+// `cube(context, i)` returns the constraint of the i-th cube over `context`.
+// Every packet must be in at least one cube, so that the query is unsat iff it
+// is unsat in every cube. Cubes are built once per z3 context, so `cube` must
+// return the same constraints for every context of the same program.
+struct CubePartition {
+  int num_cubes = 0;
+  std::function<z3::expr(const SymbolicContext &context, int i)> cube;
+};
+
+// Splits the entries of `table_name`, including the default entry, i.e. entry
+// index -1, into `num_cubes` ranges of about the same size.
+CubePartition PartitionByEntryIndex(std::string table_name, int num_entries,
+                                    int num_cubes);
+
+// Has a cube for each of `ports` as the ingress port, and one for all other
+// ingress ports.
+CubePartition PartitionByIngressPort(std::vector<int> ports);
+
+struct CubeAndConquerOptions {
+  // The number of threads, and thus of z3 contexts, solving cubes. Must be
+  // positive.
+  int num_threads = 1;
+  SolverOptions solver_options;
+  ModelExtractionOptions model_extraction_options;
+};
+
+// The outcome of `SolveCubeAndConquer`.
+struct CubeAndConquerResult {
+  // sat if `packet` is set, unsat if every cube is unsat, unknown otherwise.
+  z3::check_result result = z3::unknown;
+  std::optional<ConcreteContext> packet;
+  // The statistics of the check of each cube. Cubes that were not checked, or
+  // whose check was interrupted, since a packet was found first, are unknown.
+  std::vector<SolverStatistics> cube_statistics;
+};
+
+// Finds a concrete packet satisfying `assertion` like `Solve`, but splits the
+// search into the cubes of `partition`, and checks them concurrently, in one
+// SolverState per thread, like `SolveConcurrently`. As soon as a packet is
+// found in any cube, the checks of the other cubes are interrupted. This cuts
+// the time of a hard query, e.g. over a large ternary table, if some cubes are
+// much easier than the whole query, or if they are about as hard as each
+// other. Returns InvalidArgument on invalid options.
+absl::StatusOr<CubeAndConquerResult> SolveCubeAndConquer(
+    const Dataplane &data_plane, const std::vector<int> &physical_ports,
+    bool hardcoded_parser, const Assertion &assertion,
+    const CubePartition &partition, const CubeAndConquerOptions &options = {});
 
 // Dumps the underlying SMT program for debugging.
 std::string DebugSMT(const std::unique_ptr<SolverState> &solver_state,
@@ -21,8 +21,12 @@
 #include "p4_symbolic/symbolic/table.h"
 
 #include <algorithm>
+#include <numeric>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
@@ -60,25 +64,24 @@ int FindMatchWithName(const pdpi::IrTableEntry &entry,
 // prefixes have higher priority.
 // Finally, if the matches only contain exact matches, there is no priority.
 //
-// The function returns a vector of pairs, where the second element
-// is a table entry, and the first is its index in the old unsorted array.
-// The pairs are sorted by priority, such that the element with highest priority
-// appears first.
-// Elements with equal priority maintaing their relative ordering.
+// The function returns the indices of the entries in the given unsorted
+// array, sorted by priority, such that the index of the entry with highest
+// priority appears first. Entries with equal priority maintain their relative
+// ordering.
 //
-// We return the old index so that Symbolic and Concrete TableMatches are
-// set up against the indices as they appear in the input table entries array,
-// and not the sorted array.
-std::vector<std::pair<size_t, pdpi::IrTableEntry>> SortEntries(
-    const ir::Table &table, const std::vector<pdpi::IrTableEntry> &entries) {
+// We return indices rather than entries so that Symbolic and Concrete
+// TableMatches are set up against the indices as they appear in the input
+// table entries array, and so that large tables are not copied.
+std::vector<int> SortEntries(const ir::Table &table,
+                             const std::vector<pdpi::IrTableEntry> &entries) {
   // Find which *definition* of priority we should use by looking at the
   // table's match types.
   const pdpi::IrTableDefinition &table_definition = table.table_definition();
   bool has_ternary = false;
   bool has_lpm = false;
-  int lpm_index = -1;
-  for (const auto &[id, match_field_definition] :
-       table_definition.match_fields_by_id()) {
+  std::string lpm_name;
+  for (const auto &[name, match_field_definition] :
+       table_definition.match_fields_by_name()) {
     switch (match_field_definition.match_field().match_type()) {
       case p4::config::v1::MatchField::TERNARY: {
         has_ternary = true;
@@ -86,8 +89,7 @@ std::vector<std::pair<size_t, pdpi::IrTableEntry>> SortEntries(
       }
       case p4::config::v1::MatchField::LPM: {
         has_lpm = true;
-        // The match id starts from 1 (instead of zero).
-        lpm_index = id - 1;
+        lpm_name = name;
         break;
       }
       default: {
@@ -100,37 +102,34 @@ std::vector<std::pair<size_t, pdpi::IrTableEntry>> SortEntries(
   }
 
   // The output array.
-  std::vector<std::pair<size_t, pdpi::IrTableEntry>> sorted_entries;
-  for (size_t i = 0; i < entries.size(); i++) {
-    const pdpi::IrTableEntry &entry = entries.at(i);
-    sorted_entries.push_back(std::make_pair(i, entry));
-  }
+  std::vector<int> sorted_entries(entries.size());
+  std::iota(sorted_entries.begin(), sorted_entries.end(), 0);
 
-  // The sort comparator depends on the match types.
-  std::function<bool(const std::pair<size_t, pdpi::IrTableEntry> &,
-                     const std::pair<size_t, pdpi::IrTableEntry> &)>
-      comparator;
+  // Using stable_sort, we preserve the relative order of entries with the same
+  // priority.
   if (has_ternary) {
     // Sort by explicit priority.
-    comparator = [](const std::pair<size_t, pdpi::IrTableEntry> &entry1,
-                    const std::pair<size_t, pdpi::IrTableEntry> &entry2) {
-      return entry1.second.priority() > entry2.second.priority();
-    };
+    std::stable_sort(sorted_entries.begin(), sorted_entries.end(),
+                     [&entries](int index1, int index2) {
+                       return entries[index1].priority() >
+                              entries[index2].priority();
+                     });
   } else if (has_lpm) {
-    // Sort by prefix length.
-    comparator = [lpm_index](
-                     const std::pair<size_t, pdpi::IrTableEntry> &entry1,
-                     const std::pair<size_t, pdpi::IrTableEntry> &entry2) {
-      return entry1.second.matches(lpm_index).lpm().prefix_length() >
-             entry2.second.matches(lpm_index).lpm().prefix_length();
-    };
-  } else {
-    return sorted_entries;
+    // Sort by prefix length. An entry that omits the lpm match is a wildcard,
+    // i.e. it has prefix length 0.
+    std::vector<int> prefix_lengths;
+    prefix_lengths.reserve(entries.size());
+    for (const pdpi::IrTableEntry &entry : entries) {
+      int match_index = FindMatchWithName(entry, lpm_name);
+      prefix_lengths.push_back(
+          match_index == -1 ? 0
+                            : entry.matches(match_index).lpm().prefix_length());
+    }
+    std::stable_sort(sorted_entries.begin(), sorted_entries.end(),
+                     [&prefix_lengths](int index1, int index2) {
+                       return prefix_lengths[index1] > prefix_lengths[index2];
+                     });
   }
-
-  // Using stable_sort, we preserve the relative order of entries with the same
-  // priority.
-  std::stable_sort(sorted_entries.begin(), sorted_entries.end(), comparator);
   return sorted_entries;
 }
 
@@ -140,7 +139,7 @@ std::vector<std::pair<size_t, pdpi::IrTableEntry>> SortEntries(
 absl::StatusOr<z3::expr> EvaluateSingleMatch(
     p4::config::v1::MatchField match_definition, const std::string &field_name,
     const z3::expr &field_expression, const pdpi::IrMatch &match,
-    values::P4RuntimeTranslator *translator) {
+    z3::context &z3_context, values::P4RuntimeTranslator *translator) {
   if (match_definition.match_case() != p4::config::v1::MatchField::kMatchType) {
     // Arch-specific match type.
     return absl::InvalidArgumentError(
@@ -158,7 +157,7 @@ absl::StatusOr<z3::expr> EvaluateSingleMatch(
       ASSIGN_OR_RETURN(z3::expr value_expression,
                        values::FormatP4RTValue(
                            field_name, match_definition.type_name().name(),
-                           match.exact(), translator));
+                           match.exact(), z3_context, translator));
       return operators::Eq(field_expression, value_expression);
     }
 
@@ -170,8 +169,9 @@ absl::StatusOr<z3::expr> EvaluateSingleMatch(
                          match_definition.DebugString()));
       }
 
-      ASSIGN_OR_RETURN(z3::expr value_expression,
-                       values::FormatBmv2Value(match.lpm().value()));
+      ASSIGN_OR_RETURN(
+          z3::expr value_expression,
+          values::FormatBmv2Value(match.lpm().value(), z3_context));
       return operators::PrefixEq(
           field_expression, value_expression,
           static_cast<unsigned int>(match.lpm().prefix_length()));
@@ -185,10 +185,12 @@ absl::StatusOr<z3::expr> EvaluateSingleMatch(
                          match_definition.DebugString()));
       }
 
-      ASSIGN_OR_RETURN(z3::expr mask_expression,
-                       values::FormatBmv2Value(match.ternary().mask()));
-      ASSIGN_OR_RETURN(z3::expr value_expression,
-                       values::FormatBmv2Value(match.ternary().value()));
+      ASSIGN_OR_RETURN(
+          z3::expr mask_expression,
+          values::FormatBmv2Value(match.ternary().mask(), z3_context));
+      ASSIGN_OR_RETURN(
+          z3::expr value_expression,
+          values::FormatBmv2Value(match.ternary().value(), z3_context));
       ASSIGN_OR_RETURN(z3::expr masked_field,
                        operators::BitAnd(field_expression, mask_expression));
       return operators::Eq(masked_field, value_expression);
@@ -200,21 +202,33 @@ absl::StatusOr<z3::expr> EvaluateSingleMatch(
   }
 }
 
+// Symbolic sub-expressions shared by the match conditions of all entries of
+// a table. Entries of large tables mostly differ in a few values, e.g. routing
+// entries share their match keys and often their prefixes, so every match
+// field and every distinct match is only evaluated and formatted once.
+struct TableMatchCache {
+  // Maps a match name to the symbolic value of its match target.
+  absl::flat_hash_map<std::string, z3::expr> field_expressions;
+  // Maps a match name and a match to its symbolic match condition.
+  absl::flat_hash_map<std::string, z3::expr> match_expressions;
+};
+
 // Constructs a symbolic expression that is true if and only if this entry
 // is matched on.
 absl::StatusOr<z3::expr> EvaluateTableEntryCondition(
     const ir::Table &table, const pdpi::IrTableEntry &entry,
-    const SymbolicPerPacketState &state,
-    values::P4RuntimeTranslator *translator) {
+    const SymbolicPerPacketState &state, z3::context &z3_context,
+    values::P4RuntimeTranslator *translator, TableMatchCache *cache) {
   const std::string &table_name = table.table_definition().preamble().name();
 
   // Construct the match condition expression.
-  z3::expr condition_expression = Z3Context().bool_val(true);
+  z3::expr condition_expression = z3_context.bool_val(true);
   const google::protobuf::Map<std::string, ir::FieldValue> &match_to_fields =
       table.table_implementation().match_name_to_field();
   for (const auto &[name, match_fields] :
        table.table_definition().match_fields_by_name()) {
-    p4::config::v1::MatchField match_definition = match_fields.match_field();
+    const p4::config::v1::MatchField &match_definition =
+        match_fields.match_field();
 
     int match_field_index = FindMatchWithName(entry, name);
     if (match_field_index == -1) {
@@ -224,6 +238,15 @@ absl::StatusOr<z3::expr> EvaluateTableEntryCondition(
     }
     const pdpi::IrMatch &match = entry.matches(match_field_index);
 
+    // Entries matching the same value on this key share the condition.
+    std::string match_key = absl::StrCat(name, ":", match.SerializeAsString());
+    if (auto it = cache->match_expressions.find(match_key);
+        it != cache->match_expressions.end()) {
+      ASSIGN_OR_RETURN(condition_expression,
+                       operators::And(condition_expression, it->second));
+      continue;
+    }
+
     // We get the match name for pdpi/p4info for simplicity, however that
     // file only contains the match name as a string, which is the same as the
     // match target expression in most cases but not always.
@@ -238,16 +261,24 @@ absl::StatusOr<z3::expr> EvaluateTableEntryCondition(
           "\" was not found in implementation of table \"", table_name, "\""));
     }
 
-    ir::FieldValue match_field = match_to_fields.at(match_definition.name());
+    const ir::FieldValue &match_field =
+        match_to_fields.at(match_definition.name());
     std::string field_name = absl::StrFormat("%s.%s", match_field.header_name(),
                                              match_field.field_name());
-    action::ActionContext fake_context = {table_name, {}};
+    auto field_it = cache->field_expressions.find(name);
+    if (field_it == cache->field_expressions.end()) {
+      action::ActionContext fake_context = {table_name, {}};
+      ASSIGN_OR_RETURN(
+          z3::expr match_field_expr,
+          action::EvaluateFieldValue(match_field, state, fake_context));
+      field_it =
+          cache->field_expressions.insert({name, match_field_expr}).first;
+    }
     ASSIGN_OR_RETURN(
-        z3::expr match_field_expr,
-        action::EvaluateFieldValue(match_field, state, fake_context));
-    ASSIGN_OR_RETURN(z3::expr match_expression,
-                     EvaluateSingleMatch(match_definition, field_name,
-                                         match_field_expr, match, translator));
+        z3::expr match_expression,
+        EvaluateSingleMatch(match_definition, field_name, field_it->second,
+                            match, z3_context, translator));
+    cache->match_expressions.insert({std::move(match_key), match_expression});
     ASSIGN_OR_RETURN(condition_expression,
                      operators::And(condition_expression, match_expression));
   }
@@ -283,12 +314,11 @@ absl::StatusOr<SymbolicTrace> EvaluateTable(
     const Dataplane data_plane, const ir::Table &table,
     const std::vector<pdpi::IrTableEntry> &entries,
     SymbolicPerPacketState *state, values::P4RuntimeTranslator *translator,
-    const z3::expr &guard) {
+    z3::context &z3_context, const z3::expr &guard) {
   const std::string &table_name = table.table_definition().preamble().name();
 
   // Sort entries by priority deduced from match types.
-  std::vector<std::pair<size_t, pdpi::IrTableEntry>> sorted_entries =
-      SortEntries(table, entries);
+  std::vector<int> sorted_entries = SortEntries(table, entries);
 
   // The table semantically is just a bunch of if conditions, one per
   // table entry, we construct this big if-elseif-...-else symbolically.
@@ -317,49 +347,44 @@ absl::StatusOr<SymbolicTrace> EvaluateTable(
   // entry[2] assign a value to it, that value is unused by this reference.
   //
   // The simplest way to do this is first evaluate all the match conditions
-  // symbolically, then construct complete guard for every entry.
-  // Example, For entry i, all assignments/effects made by that entry's action
-  // are guarded by:
-  // guard && condition[i] && !condition[0] && ... && !condition[i-1]
+  // symbolically, and build the index of the matched entry from them:
+  // match_index =
+  //   if <guard && condition[0]> then 0
+  //   else if <guard && condition[1]> then 1
+  //   else ... else -1
+  // Since all indices are distinct, the priority chain is encoded once, in
+  // match_index, and the complete guard for entry i is simply:
+  // guard && match_index == i
+  // rather than guard && condition[i] && !condition[0] && ... &&
+  // !condition[i-1], which grows quadratically with the number of entries.
   //
   // This way, when we evaluate entry i-1 in the next step, and we retrieve the
   // value, we will use it in the context of the then body guarded by
-  // guard && condition[i-1], which entails that the assignment guard for
+  // guard && match_index == i-1, which entails that the assignment guard for
   // effects of entry i (and all following entries) is false.
 
   // Find all entries match conditions.
+  TableMatchCache match_cache;
   std::vector<z3::expr> entries_matches;
-  for (const auto &[_, entry] : sorted_entries) {
+  entries_matches.reserve(sorted_entries.size());
+  for (int index : sorted_entries) {
     // We are passsing state by const reference here, so we do not need
     // any guard yet.
     ASSIGN_OR_RETURN(
         z3::expr entry_match,
-        EvaluateTableEntryCondition(table, entry, *state, translator));
+        EvaluateTableEntryCondition(table, entries.at(index), *state,
+                                    z3_context, translator, &match_cache));
     entries_matches.push_back(entry_match);
   }
 
-  // Build each entry's assignment/effect guard by negating
-  // higher priority entries.
-  z3::expr default_entry_assignment_guard = guard;
-  std::vector<z3::expr> assignment_guards;
-  if (!entries_matches.empty()) {
-    ASSIGN_OR_RETURN(z3::expr current_guard,
-                     operators::And(guard, entries_matches.at(0)));
-    ASSIGN_OR_RETURN(z3::expr accumulator_guard,
-                     operators::Not(entries_matches.at(0)));
-    assignment_guards.push_back(current_guard);
-    for (size_t i = 1; i < entries_matches.size(); i++) {
-      ASSIGN_OR_RETURN(z3::expr tmp, operators::And(guard, accumulator_guard));
-      ASSIGN_OR_RETURN(current_guard,
-                       operators::And(tmp, entries_matches.at(i)));
-      ASSIGN_OR_RETURN(tmp, operators::Not(entries_matches.at(i)));
-      ASSIGN_OR_RETURN(accumulator_guard,
-                       operators::And(accumulator_guard, tmp));
-      assignment_guards.push_back(current_guard);
-    }
-    ASSIGN_OR_RETURN(
-        default_entry_assignment_guard,
-        operators::And(default_entry_assignment_guard, accumulator_guard));
+  // Build the index of the matched entry in reverse priority.
+  z3::expr match_index = z3_context.int_val(-1);
+  for (int row = sorted_entries.size() - 1; row >= 0; row--) {
+    z3::expr row_symbol = z3_context.int_val(sorted_entries.at(row));
+    ASSIGN_OR_RETURN(z3::expr entry_match,
+                     operators::And(guard, entries_matches.at(row)));
+    ASSIGN_OR_RETURN(match_index,
+                     operators::Ite(entry_match, row_symbol, match_index));
   }
 
   // Build an IrTableEntry object for the default entry.
@@ -374,28 +399,22 @@ absl::StatusOr<SymbolicTrace> EvaluateTable(
   }
 
   // Start with the default entry
-  z3::expr match_index = Z3Context().int_val(-1);
+  ASSIGN_OR_RETURN(z3::expr default_entry_assignment_guard,
+                   operators::And(guard, match_index == -1));
   RETURN_IF_ERROR(EvaluateTableEntryAction(
       table, default_entry, data_plane.program.actions(), state, translator,
       default_entry_assignment_guard));
 
   // Continue evaluating each table entry in reverse priority
   for (int row = sorted_entries.size() - 1; row >= 0; row--) {
-    size_t old_index = sorted_entries.at(row).first;
-    const pdpi::IrTableEntry &entry = sorted_entries.at(row).second;
-    z3::expr row_symbol = Z3Context().int_val(static_cast<int>(old_index));
-
-    // The condition used in the big if_else_then construct.
-    ASSIGN_OR_RETURN(z3::expr entry_match,
-                     operators::And(guard, entries_matches.at(row)));
-    ASSIGN_OR_RETURN(match_index,
-                     operators::Ite(entry_match, row_symbol, match_index));
+    int old_index = sorted_entries.at(row);
 
     // Evaluate the entry's action guarded by its complete assignment guard.
-    z3::expr entry_assignment_guard = assignment_guards.at(row);
-    RETURN_IF_ERROR(
-        EvaluateTableEntryAction(table, entry, data_plane.program.actions(),
-                                 state, translator, entry_assignment_guard));
+    ASSIGN_OR_RETURN(z3::expr entry_assignment_guard,
+                     operators::And(guard, match_index == old_index));
+    RETURN_IF_ERROR(EvaluateTableEntryAction(
+        table, entries.at(old_index), data_plane.program.actions(), state,
+        translator, entry_assignment_guard));
   }
 
   // This table has been completely evaluated, the result of the evaluation
@@ -16,7 +16,9 @@
 
 #include "p4_symbolic/symbolic/util.h"
 
+#include <cstdint>
 #include <string>
+#include <utility>
 
 #include "absl/strings/str_format.h"
 #include "p4_pdpi/utils/ir.h"
@@ -38,10 +40,26 @@ bool Z3BooltoBool(Z3_lbool z3_bool) {
   }
 }
 
+// Evaluates the header field `name` with symbolic value `expr` in `model`, and
+// translates it back to its P4Runtime value if the field is translatable.
+absl::StatusOr<std::string> EvaluateField(
+    const std::string &name, const z3::expr &expr, const z3::model &model,
+    const values::P4RuntimeTranslator &translator) {
+  z3::expr value = model.eval(expr, true);
+  const values::IdAllocator *allocator = translator.FieldAllocator(name);
+  if (allocator == nullptr) return value.to_string();
+  // Translated ids are allocated from 0, so they fit into 64 bits, and can be
+  // read off the numeral without printing and re-parsing it.
+  uint64_t id;
+  if (value.is_numeral_u64(id)) return allocator->IdToString(id);
+  return values::TranslateValueToP4RT(name, value.to_string(), translator);
+}
+
 }  // namespace
 
 absl::StatusOr<std::unordered_map<std::string, z3::expr>> FreeSymbolicHeaders(
-    const google::protobuf::Map<std::string, ir::HeaderType> &headers) {
+    const google::protobuf::Map<std::string, ir::HeaderType> &headers,
+    z3::context &z3_context) {
   // Loop over every header instance in the p4 program.
   // Find its type, and loop over every field in it, creating a symbolic free
   // variable for every field in every header instance.
@@ -49,8 +67,7 @@ absl::StatusOr<std::unordered_map<std::string, z3::expr>> FreeSymbolicHeaders(
   for (const auto &[header_name, header_type] : headers) {
     // Special validity field.
     std::string valid_field_name = absl::StrFormat("%s.$valid$", header_name);
-    z3::expr valid_expression =
-        Z3Context().bool_const(valid_field_name.c_str());
+    z3::expr valid_expression = z3_context.bool_const(valid_field_name.c_str());
     symbolic_headers.insert({valid_field_name, valid_expression});
 
     // Regular fields defined in the p4 program or v1model.
@@ -63,27 +80,28 @@ absl::StatusOr<std::unordered_map<std::string, z3::expr>> FreeSymbolicHeaders(
       std::string field_full_name =
           absl::StrFormat("%s.%s", header_name, field_name);
       z3::expr field_expression =
-          Z3Context().bv_const(field_full_name.c_str(), field.bitwidth());
+          z3_context.bv_const(field_full_name.c_str(), field.bitwidth());
       symbolic_headers.insert({field_full_name, field_expression});
     }
   }
 
   // Finally, we have a special field marking if the packet represented by
   // these headers was dropped.
-  symbolic_headers.insert({"$dropped$", Z3Context().bool_val(false)});
+  symbolic_headers.insert({"$dropped$", z3_context.bool_val(false)});
   return symbolic_headers;
 }
 
-SymbolicTableMatch DefaultTableMatch() {
+SymbolicTableMatch DefaultTableMatch(z3::context &z3_context) {
   return {
-      Z3Context().bool_val(false),  // No match yet!
-      Z3Context().int_val(-1)       // No match index.
+      z3_context.bool_val(false),  // No match yet!
+      z3_context.int_val(-1)       // No match index.
   };
 }
 
 absl::StatusOr<ConcreteContext> ExtractFromModel(
-    SymbolicContext context, z3::model model,
-    const values::P4RuntimeTranslator &translator) {
+    const SymbolicContext &context, const z3::model &model,
+    const values::P4RuntimeTranslator &translator,
+    const ModelExtractionOptions &options) {
   // Extract ports.
   std::string ingress_port = model.eval(context.ingress_port, true).to_string();
   std::string egress_port = model.eval(context.egress_port, true).to_string();
@@ -96,16 +114,42 @@ absl::StatusOr<ConcreteContext> ExtractFromModel(
 
   // Extract the ingress and egress headers.
   ConcretePerPacketState ingress_headers;
-  for (const auto &[name, expr] : context.ingress_headers) {
-    ASSIGN_OR_RETURN(ingress_headers[name],
-                     values::TranslateValueToP4RT(
-                         name, model.eval(expr, true).to_string(), translator));
-  }
   ConcretePerPacketState egress_headers;
-  for (const auto &[name, expr] : context.egress_headers) {
-    ASSIGN_OR_RETURN(egress_headers[name],
-                     values::TranslateValueToP4RT(
-                         name, model.eval(expr, true).to_string(), translator));
+  if (options.extract_headers) {
+    // Fields the program does not modify have the very same expression in both
+    // headers, so their value is only evaluated and translated once.
+    auto extract_field = [&](const std::string &name,
+                             const z3::expr &ingress_expr,
+                             const z3::expr &egress_expr) -> absl::Status {
+      ASSIGN_OR_RETURN(std::string ingress_value,
+                       EvaluateField(name, ingress_expr, model, translator));
+      if (z3::eq(ingress_expr, egress_expr)) {
+        egress_headers[name] = ingress_value;
+      } else {
+        ASSIGN_OR_RETURN(egress_headers[name],
+                         EvaluateField(name, egress_expr, model, translator));
+      }
+      ingress_headers[name] = std::move(ingress_value);
+      return absl::OkStatus();
+    };
+
+    if (options.header_fields.empty()) {
+      // Both headers are copies of the same map, so they have the same ids.
+      int id = 0;
+      for (const auto &[name, ingress_expr] : context.ingress_headers) {
+        ASSIGN_OR_RETURN(z3::expr egress_expr,
+                         context.egress_headers.Get(id++));
+        RETURN_IF_ERROR(extract_field(name, ingress_expr, egress_expr));
+      }
+    } else {
+      for (const std::string &name : options.header_fields) {
+        ASSIGN_OR_RETURN(z3::expr ingress_expr,
+                         context.ingress_headers.Get(name));
+        ASSIGN_OR_RETURN(z3::expr egress_expr,
+                         context.egress_headers.Get(name));
+        RETURN_IF_ERROR(extract_field(name, ingress_expr, egress_expr));
+      }
+    }
   }
 
   // Extract the trace (matches on every table).
@@ -126,7 +170,7 @@ absl::StatusOr<ConcreteContext> ExtractFromModel(
 
 absl::StatusOr<SymbolicTrace> MergeTracesOnCondition(
     const z3::expr &condition, const SymbolicTrace &true_trace,
-    const SymbolicTrace &false_trace) {
+    const SymbolicTrace &false_trace, z3::context &z3_context) {
   ASSIGN_OR_RETURN(
       z3::expr merged_dropped,
       operators::Ite(condition, true_trace.dropped, false_trace.dropped));
@@ -137,7 +181,7 @@ absl::StatusOr<SymbolicTrace> MergeTracesOnCondition(
   // Merge all tables matches in true_trace (including ones in both traces).
   for (const auto &[name, true_match] : true_trace.matched_entries) {
     // Find match in other trace (or use default).
-    SymbolicTableMatch false_match = DefaultTableMatch();
+    SymbolicTableMatch false_match = DefaultTableMatch(z3_context);
     if (false_trace.matched_entries.count(name) > 0) {
       false_match = false_trace.matched_entries.at(name);
     }
@@ -154,7 +198,7 @@ absl::StatusOr<SymbolicTrace> MergeTracesOnCondition(
 
   // Merge all tables matches in false_trace only.
   for (const auto &[name, false_match] : false_trace.matched_entries) {
-    SymbolicTableMatch true_match = DefaultTableMatch();
+    SymbolicTableMatch true_match = DefaultTableMatch(z3_context);
     if (true_trace.matched_entries.count(name) > 0) {
       continue;  // Already covered.
     }
@@ -35,18 +35,20 @@ namespace util {
 // Free (unconstrained) symbolic headers consisting of free symbolic variables
 // for every field in every header instance defined in the P4 program.
 absl::StatusOr<std::unordered_map<std::string, z3::expr>> FreeSymbolicHeaders(
-    const google::protobuf::Map<std::string, ir::HeaderType> &headers);
+    const google::protobuf::Map<std::string, ir::HeaderType> &headers,
+    z3::context &z3_context);
 
 // Returns an symbolic table match containing default values.
 // The table match expression is false, the index is -1, and the value is
 // undefined.
-SymbolicTableMatch DefaultTableMatch();
+SymbolicTableMatch DefaultTableMatch(z3::context &z3_context);
 
 // Extract a concrete context by evaluating every component's corresponding
-// expression in the model.
+// expression in the model, restricted to the headers selected by `options`.
 absl::StatusOr<ConcreteContext> ExtractFromModel(
-    SymbolicContext context, z3::model model,
-    const values::P4RuntimeTranslator &translator);
+    const SymbolicContext &context, const z3::model &model,
+    const values::P4RuntimeTranslator &translator,
+    const ModelExtractionOptions &options = {});
 
 // Merges two symbolic traces into a single trace. A field in the new trace
 // has the value of the changed trace if the condition is true, and the value
@@ -54,7 +56,7 @@ absl::StatusOr<ConcreteContext> ExtractFromModel(
 // Assertion: both traces must contain matches for the same set of table names.
 absl::StatusOr<SymbolicTrace> MergeTracesOnCondition(
     const z3::expr &condition, const SymbolicTrace &true_trace,
-    const SymbolicTrace &false_trace);
+    const SymbolicTrace &false_trace, z3::context &z3_context);
 
 }  // namespace util
 }  // namespace symbolic
@@ -22,6 +22,8 @@
 
 #include <locale>
 #include <sstream>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "absl/strings/match.h"
@@ -56,7 +58,7 @@ unsigned int FindBitsize(uint64_t value) {
 // dependening on the size of the value and the formatting flags it is
 // initialized with.
 uint64_t StringToInt(std::string value) {
-  static std::unordered_map<char, std::string> hex_to_bin = {
+  static const std::unordered_map<char, std::string> hex_to_bin = {
       {'0', "0000"}, {'1', "0001"}, {'2', "0010"}, {'3', "0011"},
       {'4', "0100"}, {'5', "0101"}, {'6', "0110"}, {'7', "0111"},
       {'8', "1000"}, {'9', "1001"}, {'a', "1010"}, {'b', "1011"},
@@ -105,7 +107,8 @@ absl::StatusOr<pdpi::IrValue> ParseIrValue(std::string value) {
   }
 }
 
-absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value) {
+absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value,
+                                         z3::context &z3_context) {
   switch (value.format_case()) {
     case pdpi::IrValue::kHexStr: {
       const std::string &hexstr = value.hex_str();
@@ -114,8 +117,8 @@ absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value) {
       std::stringstream converter;
       converter << std::hex << hexstr;
       if (converter >> decimal) {
-        return Z3Context().bv_val(std::to_string(decimal).c_str(),
-                                  FindBitsize(decimal));
+        return z3_context.bv_val(std::to_string(decimal).c_str(),
+                                 FindBitsize(decimal));
       }
 
       return absl::InvalidArgumentError(absl::StrCat(
@@ -130,7 +133,7 @@ absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value) {
                                      << ((ipv4.size() - i - 1) * 8);
         ip += shifted_component;
       }
-      return Z3Context().bv_val(std::to_string(ip).c_str(), 32);
+      return z3_context.bv_val(std::to_string(ip).c_str(), 32);
     }
 
     case pdpi::IrValue::kMac: {
@@ -147,7 +150,7 @@ absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value) {
               absl::StrCat("Cannot process mac value \"", value.mac(), "\"!"));
         }
       }
-      return Z3Context().bv_val(std::to_string(mac).c_str(), 48);
+      return z3_context.bv_val(std::to_string(mac).c_str(), 48);
     }
 
     case pdpi::IrValue::kIpv6: {
@@ -166,7 +169,7 @@ absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value) {
               "Cannot process ipv6 value \"", value.ipv6(), "\"!"));
         }
       }
-      z3::expr hi = Z3Context().bv_val(std::to_string(ipv6).c_str(), 128);
+      z3::expr hi = z3_context.bv_val(std::to_string(ipv6).c_str(), 128);
 
       // Transform the least significant 64 bits.
       ipv6 = 0;
@@ -181,10 +184,10 @@ absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value) {
               "Cannot process ipv6 value \"", value.ipv6(), "\"!"));
         }
       }
-      z3::expr lo = Z3Context().bv_val(std::to_string(ipv6).c_str(), 128);
+      z3::expr lo = z3_context.bv_val(std::to_string(ipv6).c_str(), 128);
 
       // Add them together.
-      z3::expr shift = Z3Context().bv_val("18446744073709551616", 128);  // 2^64
+      z3::expr shift = z3_context.bv_val("18446744073709551616", 128);  // 2^64
       ASSIGN_OR_RETURN(hi, operators::Times(hi, shift));  // shift << 64.
       return operators::Plus(hi, lo);
     }
@@ -198,29 +201,30 @@ absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value) {
 absl::StatusOr<z3::expr> FormatP4RTValue(const std::string &field_name,
                                          const std::string &type_name,
                                          const pdpi::IrValue &value,
+                                         z3::context &z3_context,
                                          P4RuntimeTranslator *translator) {
   switch (value.format_case()) {
     case pdpi::IrValue::kStr: {
+      // Must translate the string into a bitvector according to the field type.
+      IdAllocator &allocator = translator->GetOrCreateAllocator(type_name);
+
       // Mark that this field is a string translatable field, and map it
-      // to its custom type name (e.g. vrf_id => vrf_t).
+      // to the allocator of its custom type (e.g. vrf_id => vrf_t).
       if (!field_name.empty()) {
-        translator->fields_p4runtime_type[field_name] = type_name;
+        translator->allocator_index_from_field[field_name] =
+            translator->allocator_index_from_type.at(type_name);
       }
 
-      // Must translate the string into a bitvector according to the field type.
-      const std::string &string_value = value.str();
-      IdAllocator &allocator =
-          translator->p4runtime_translation_allocators[type_name];
-      uint64_t int_value = allocator.AllocateId(string_value);
-      return Z3Context().bv_val(int_value, FindBitsize(int_value));
+      uint64_t int_value = allocator.AllocateId(value.str());
+      return z3_context.bv_val(int_value, FindBitsize(int_value));
     }
     default: {
-      if (translator->fields_p4runtime_type.count(field_name)) {
+      if (translator->allocator_index_from_field.contains(field_name)) {
         return absl::InvalidArgumentError(absl::StrCat(
             "A table entry provides a non-string value ", value.DebugString(),
             "to a string translated field", field_name));
       }
-      return FormatBmv2Value(value);
+      return FormatBmv2Value(value, z3_context);
     }
   }
 }
@@ -229,40 +233,47 @@ absl::StatusOr<std::string> TranslateValueToP4RT(
     const std::string &field_name, const std::string &value,
     const P4RuntimeTranslator &translator) {
   // Not translatable: identity function.
-  if (!translator.fields_p4runtime_type.count(field_name)) {
-    return value;
-  }
-
-  // Translatable: do the reverse translation via the type name.
-  const std::string &field_type_name =
-      translator.fields_p4runtime_type.at(field_name);
-  const IdAllocator &allocator =
-      translator.p4runtime_translation_allocators.at(field_type_name);
+  const IdAllocator *allocator = translator.FieldAllocator(field_name);
+  if (allocator == nullptr) return value;
 
+  // Translatable: do the reverse translation via the field's allocator.
   // Turn the value from a string to an int.
   uint64_t int_value = StringToInt(value);
-  return allocator.IdToString(int_value);
+  return allocator->IdToString(int_value);
+}
+
+// P4RuntimeTranslator Implementation.
+
+IdAllocator &P4RuntimeTranslator::GetOrCreateAllocator(
+    const std::string &type_name) {
+  auto [it, inserted] =
+      allocator_index_from_type.try_emplace(type_name, allocators.size());
+  if (inserted) allocators.emplace_back();
+  return allocators[it->second];
+}
+
+const IdAllocator *P4RuntimeTranslator::FieldAllocator(
+    const std::string &field_name) const {
+  auto it = allocator_index_from_field.find(field_name);
+  if (it == allocator_index_from_field.end()) return nullptr;
+  return &allocators[it->second];
 }
 
 // IdAllocator Implementation.
 
 uint64_t IdAllocator::AllocateId(const std::string &string_value) {
-  // If previously allocated, return the same bitvector value.
-  if (this->string_to_id_map_.count(string_value)) {
-    return this->string_to_id_map_.at(string_value);
-  }
-
-  // Allocate new bitvector value and store it in mapping.
-  uint64_t int_value = this->counter_++;
-  this->string_to_id_map_.insert({string_value, int_value});
-  this->id_to_string_map_.insert({int_value, string_value});
-  return int_value;
+  // If previously allocated, return the same bitvector value. Otherwise,
+  // allocate the next bitvector value and store it in both mappings.
+  auto [it, inserted] =
+      this->string_to_id_map_.try_emplace(string_value, id_to_string_.size());
+  if (inserted) this->id_to_string_.push_back(string_value);
+  return it->second;
 }
 
 absl::StatusOr<std::string> IdAllocator::IdToString(uint64_t value) const {
-  // Normalize the bitvector and look it up in the reverse mapping.
-  if (this->id_to_string_map_.count(value)) {
-    return this->id_to_string_map_.at(value);
+  // Look the bitvector up in the reverse mapping.
+  if (value < this->id_to_string_.size()) {
+    return this->id_to_string_[value];
   }
 
   // Could not find the bitvector in reverse map!
@@ -23,8 +23,10 @@
 
 #include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
 #include "gutil/status.h"
 #include "p4_pdpi/ir.pb.h"
 #include "z3++.h"
@@ -49,33 +51,49 @@ class IdAllocator {
   // which it was allocated.
   absl::StatusOr<std::string> IdToString(uint64_t value) const;
 
+  // Returns the strings allocated so far, indexed by their id. Allocating them
+  // in this order to a fresh allocator reproduces this one.
+  absl::Span<const std::string> AllocatedStrings() const {
+    return id_to_string_;
+  }
+
  private:
   // A mapping from string values to bitvector values.
-  std::unordered_map<std::string, uint64_t> string_to_id_map_;
-
-  // A mapping from bitvector values to string values.
-  std::unordered_map<uint64_t, std::string> id_to_string_map_;
+  absl::flat_hash_map<std::string, uint64_t> string_to_id_map_;
 
-  // Counter used to come up with new values per new allocation.
-  uint64_t counter_ = 0;
+  // A mapping from bitvector values to string values. Ids are allocated
+  // sequentially from 0, so the id of a string is its index.
+  std::vector<std::string> id_to_string_;
 };
 
 // This struct stores all the state that is required to translate string values
 // to internal bitvectors per custom p4 type (e.g. vrf_t), and reverse translate
 // bitvector values of fields of such a custom type to a string value.
 struct P4RuntimeTranslator {
-  // Maps a type name to an allocator responsible for translating values for
-  // that type.
+  // Returns the allocator responsible for translating values of the type
+  // `type_name`, creating it if needed.
+  IdAllocator &GetOrCreateAllocator(const std::string &type_name);
+
+  // Returns the allocator of the type of `field_name`, or nullptr if the field
+  // was not detected to be translatable.
+  const IdAllocator *FieldAllocator(const std::string &field_name) const;
+
   // We have an instance of the allocator class per translatable type.
   // The generated ids are unique only per type, different types may re-use
-  // the same id.
-  std::unordered_map<std::string, IdAllocator> p4runtime_translation_allocators;
-  // Maps field name to a type name, only for fields we were able to detect had
-  // a custom p4 type with a @p4runtime_translation annotation attached to it.
+  // the same id. Allocators are referred to by index, so that the translator
+  // stays valid when copied.
+  std::vector<IdAllocator> allocators;
+  // Maps a type name to the index of its allocator.
+  absl::flat_hash_map<std::string, int> allocator_index_from_type;
+  // Maps field name to the index of the allocator of its type, only for fields
+  // we were able to detect had a custom p4 type with a @p4runtime_translation
+  // annotation attached to it. The field is resolved to its allocator once,
+  // when its first value is translated, so that reverse translations need a
+  // single lookup.
   // This information is not available in the bmv2 file, since it strips away
   // type aliases and  annotations, so we must build it ourselves with a best
   // effort approach.
-  std::unordered_map<std::string, std::string> fields_p4runtime_type;
+  absl::flat_hash_map<std::string, int> allocator_index_from_field;
 };
 
 // Transforms a hex string literal from bmv2 json to a pdpi::IrValue
@@ -89,7 +107,8 @@ absl::StatusOr<pdpi::IrValue> ParseIrValue(std::string value);
 // the values are already in the actual domain of values in the p4 program,
 // because p4 and bmv2 both do not support string translation, it is only used
 // as a logical translation at the boundry between P4RT and bmv2.
-absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value);
+absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value,
+                                         z3::context &z3_context);
 
 // Transforms a value read from a table entry to a z3::expr.
 // On top of formatting ipv4, ipv6, hexstrings, and macs as bitvectors,
@@ -101,6 +120,7 @@ absl::StatusOr<z3::expr> FormatBmv2Value(const pdpi::IrValue &value);
 absl::StatusOr<z3::expr> FormatP4RTValue(const std::string &field_name,
                                          const std::string &type_name,
                                          const pdpi::IrValue &value,
+                                         z3::context &z3_context,
                                          P4RuntimeTranslator *translator);
 
 // Reverse translation: operates opposite to FormatP4RTValue().
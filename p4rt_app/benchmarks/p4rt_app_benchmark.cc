@@ -0,0 +1,400 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmarks of the P4RT app running in-process on the fake SONiC adapters
+// used by the component tests. The fakes respond like an OrchAgent that
+// accepts every request, so the numbers reflect the cost of the app itself,
+// plus that of gRPC over the loopback interface.
+//
+// Besides the time per entry, each benchmark reports:
+//   - allocs_per_entry: heap allocations of all threads, per entry.
+//   - `<span> (us)`: the mean time per iteration spent in each traced stage of
+//     the app (see `gutil::TraceSpan`), e.g. "P4RT Write: translate (us)".
+//
+// Example:
+//   bazel run -c opt //p4rt_app/benchmarks -- --benchmark_filter=Ipv4Routes
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "glog/logging.h"
+#include "grpcpp/security/credentials.h"
+#include "gutil/status.h"
+#include "gutil/tracing.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/p4_runtime_session.h"
+#include "p4_pdpi/pd.h"
+#include "p4_pdpi/string_encodings/hex_string.h"
+#include "p4rt_app/p4runtime/p4runtime_impl.h"
+#include "p4rt_app/sonic/packetio_interface.h"
+#include "p4rt_app/tests/lib/p4runtime_grpc_service.h"
+#include "sai_p4/instantiations/google/instantiations.h"
+#include "sai_p4/instantiations/google/sai_p4info.h"
+#include "sai_p4/instantiations/google/sai_pd.pb.h"
+
+// Counts the heap allocations of the whole process, including those of the
+// gRPC and P4RT app threads.
+std::atomic<int64_t> allocation_count{0};
+
+void* operator new(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace p4rt_app {
+namespace {
+
+constexpr sai::Instantiation kInstantiation = sai::Instantiation::kMiddleblock;
+constexpr uint64_t kDeviceId = 183807201;
+constexpr char kPacketIoPortName[] = "Ethernet1/1/0";
+constexpr char kPacketIoPortId[] = "1";
+
+// A P4RT app on fake SONiC adapters, and a primary client session that has
+// pushed the P4Info of `kInstantiation`.
+struct App {
+  std::unique_ptr<test_lib::P4RuntimeGrpcService> service;
+  std::unique_ptr<pdpi::P4RuntimeSession> session;
+};
+
+absl::StatusOr<App> StartApp() {
+  App app;
+  app.service =
+      std::make_unique<test_lib::P4RuntimeGrpcService>(P4RuntimeImplOptions{});
+  RETURN_IF_ERROR(app.service->GetP4rtServer().UpdateDeviceId(kDeviceId));
+  RETURN_IF_ERROR(app.service->GetP4rtServer().AddPacketIoPort(
+      kPacketIoPortName));
+  RETURN_IF_ERROR(app.service->GetP4rtServer().AddPortTranslation(
+      kPacketIoPortName, kPacketIoPortId));
+
+  auto stub = pdpi::CreateP4RuntimeStub(
+      absl::StrCat("localhost:", app.service->GrpcPort()),
+      grpc::InsecureChannelCredentials());
+  ASSIGN_OR_RETURN(app.session, pdpi::P4RuntimeSession::Create(
+                                    std::move(stub), kDeviceId));
+  RETURN_IF_ERROR(pdpi::SetMetadataAndSetForwardingPipelineConfig(
+      app.session.get(),
+      p4::v1::SetForwardingPipelineConfigRequest::RECONCILE_AND_COMMIT,
+      sai::GetP4Info(kInstantiation)));
+  return app;
+}
+
+App StartAppOrDie() {
+  absl::StatusOr<App> app = StartApp();
+  CHECK_OK(app.status());  // Crash OK
+  return *std::move(app);
+}
+
+// -- Workloads ----------------------------------------------------------------
+
+// Returns the address of the `index`-th /32 route, which is distinct for
+// indices below 2^24.
+std::string Ipv4Address(int index) {
+  return absl::StrFormat("10.%d.%d.%d", (index >> 16) & 0xff,
+                         (index >> 8) & 0xff, index & 0xff);
+}
+
+pdpi::IrTableEntry Ipv4Route(int index) {
+  pdpi::IrTableEntry entry;
+  entry.set_table_name("ipv4_table");
+  pdpi::IrMatch& vrf = *entry.add_matches();
+  vrf.set_name("vrf_id");
+  vrf.mutable_exact()->set_str("vrf-1");
+  pdpi::IrMatch& dst = *entry.add_matches();
+  dst.set_name("ipv4_dst");
+  dst.mutable_lpm()->mutable_value()->set_ipv4(Ipv4Address(index));
+  dst.mutable_lpm()->set_prefix_length(32);
+  entry.mutable_action()->set_name("drop");
+  return entry;
+}
+
+pdpi::IrActionSetInvocation& AddWcmpMember(pdpi::IrTableEntry& entry,
+                                           absl::string_view nexthop_id,
+                                           int weight) {
+  pdpi::IrActionSetInvocation& member =
+      *entry.mutable_action_set()->add_actions();
+  member.set_weight(weight);
+  pdpi::IrActionInvocation& action = *member.mutable_action();
+  action.set_name("set_nexthop_id");
+  pdpi::IrActionInvocation::IrActionParam& param = *action.add_params();
+  param.set_name("nexthop_id");
+  param.mutable_value()->set_str(std::string(nexthop_id));
+  return member;
+}
+
+pdpi::IrTableEntry WcmpGroup(int index) {
+  pdpi::IrTableEntry entry;
+  entry.set_table_name("wcmp_group_table");
+  pdpi::IrMatch& id = *entry.add_matches();
+  id.set_name("wcmp_group_id");
+  id.mutable_exact()->set_str(absl::StrCat("group-", index));
+  AddWcmpMember(entry, "nexthop-1", /*weight=*/1);
+  AddWcmpMember(entry, "nexthop-2", /*weight=*/2);
+  return entry;
+}
+
+pdpi::IrTableEntry AclIngressEntry(int index) {
+  pdpi::IrTableEntry entry;
+  entry.set_table_name("acl_ingress_table");
+  entry.set_priority(index + 1);
+  // The P4 constraints of the table require `is_ipv4` to match on `dst_ip`.
+  pdpi::IrMatch& is_ipv4 = *entry.add_matches();
+  is_ipv4.set_name("is_ipv4");
+  is_ipv4.mutable_optional()->mutable_value()->set_hex_str("0x1");
+  pdpi::IrMatch& dst_ip = *entry.add_matches();
+  dst_ip.set_name("dst_ip");
+  dst_ip.mutable_ternary()->mutable_value()->set_ipv4(Ipv4Address(index));
+  dst_ip.mutable_ternary()->mutable_mask()->set_ipv4("255.255.255.255");
+  pdpi::IrActionInvocation& action = *entry.mutable_action();
+  action.set_name("acl_copy");
+  pdpi::IrActionInvocation::IrActionParam& param = *action.add_params();
+  param.set_name("qos_queue");
+  param.mutable_value()->set_str("0x1");
+  return entry;
+}
+
+using EntryGenerator = pdpi::IrTableEntry (*)(int index);
+
+// Returns write requests of the given `type` for the first `num_entries`
+// entries of `generator`, with at most `batch_size` updates per request.
+std::vector<p4::v1::WriteRequest> MakeWriteRequestsOrDie(
+    EntryGenerator generator, int num_entries, int batch_size,
+    p4::v1::Update::Type type) {
+  const pdpi::IrP4Info& ir_p4info = sai::GetIrP4Info(kInstantiation);
+  std::vector<p4::v1::WriteRequest> requests;
+  requests.reserve((num_entries + batch_size - 1) / batch_size);
+  for (int i = 0; i < num_entries; ++i) {
+    if (i % batch_size == 0) requests.emplace_back();
+    absl::StatusOr<p4::v1::TableEntry> entry =
+        pdpi::IrTableEntryToPi(ir_p4info, generator(i));
+    CHECK_OK(entry.status());  // Crash OK
+    p4::v1::Update& update = *requests.back().add_updates();
+    update.set_type(type);
+    *update.mutable_entity()->mutable_table_entry() = *std::move(entry);
+  }
+  return requests;
+}
+
+// -- Reporting ----------------------------------------------------------------
+
+// Per-stage time and allocations, accumulated over the iterations of a
+// benchmark.
+class Measurements {
+ public:
+  // Starts recording the stages and allocations of one iteration.
+  void Start() {
+    gutil::ClearTraceEvents();
+    gutil::SetTracingEnabled(true);
+    allocations_at_start_ = allocation_count.load(std::memory_order_relaxed);
+  }
+
+  // Stops recording and adds the iteration to the totals.
+  void Stop() {
+    allocations_ += allocation_count.load(std::memory_order_relaxed) -
+                    allocations_at_start_;
+    gutil::SetTracingEnabled(false);
+    for (const gutil::TraceEvent& event : gutil::CollectTraceEvents()) {
+      time_by_stage_[event.name] += event.duration;
+    }
+  }
+
+  // Reports the totals, averaged over iterations, as counters of `state`.
+  void Report(benchmark::State& state, int entries_per_iteration) const {
+    state.SetItemsProcessed(state.iterations() * entries_per_iteration);
+    state.counters["allocs_per_entry"] = benchmark::Counter(
+        static_cast<double>(allocations_) / entries_per_iteration,
+        benchmark::Counter::kAvgIterations);
+    for (const auto& [stage, time] : time_by_stage_) {
+      state.counters[absl::StrCat(stage, " (us)")] =
+          benchmark::Counter(absl::ToDoubleMicroseconds(time),
+                             benchmark::Counter::kAvgIterations);
+    }
+  }
+
+ private:
+  int64_t allocations_at_start_ = 0;
+  int64_t allocations_ = 0;
+  absl::flat_hash_map<std::string, absl::Duration> time_by_stage_;
+};
+
+// -- Benchmarks ---------------------------------------------------------------
+
+// Arguments: number of entries, entries per write request.
+void EntryArgs(benchmark::internal::Benchmark* benchmark, int max_entries) {
+  benchmark->ArgNames({"entries", "batch"})->Unit(benchmark::kMillisecond);
+  for (int entries : {1'000, 10'000, 100'000, 500'000}) {
+    if (entries > max_entries) break;
+    for (int batch_size : {100, 1'000}) benchmark->Args({entries, batch_size});
+  }
+}
+
+void RouteArgs(benchmark::internal::Benchmark* benchmark) {
+  EntryArgs(benchmark, /*max_entries=*/500'000);
+}
+void WcmpGroupArgs(benchmark::internal::Benchmark* benchmark) {
+  EntryArgs(benchmark, /*max_entries=*/10'000);
+}
+void AclArgs(benchmark::internal::Benchmark* benchmark) {
+  EntryArgs(benchmark, /*max_entries=*/1'000);
+}
+
+// Reads do not depend on how the entries were batched when inserted.
+void ReadArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"entries", "batch"})->Unit(benchmark::kMillisecond);
+  for (int entries : {10'000, 100'000, 500'000}) {
+    benchmark->Args({entries, 1'000});
+  }
+}
+
+// Inserts entries, timing the inserts only; they are deleted again between
+// iterations.
+void BM_Insert(benchmark::State& state, EntryGenerator generator) {
+  const int num_entries = state.range(0);
+  const int batch_size = state.range(1);
+  App app = StartAppOrDie();
+  std::vector<p4::v1::WriteRequest> inserts = MakeWriteRequestsOrDie(
+      generator, num_entries, batch_size, p4::v1::Update::INSERT);
+  std::vector<p4::v1::WriteRequest> deletes = MakeWriteRequestsOrDie(
+      generator, num_entries, batch_size, p4::v1::Update::DELETE);
+
+  Measurements measurements;
+  for (auto _ : state) {
+    measurements.Start();
+    CHECK_OK(  // Crash OK
+        pdpi::SetMetadataAndSendPiWriteRequests(app.session.get(), inserts));
+    measurements.Stop();
+
+    state.PauseTiming();
+    CHECK_OK(  // Crash OK
+        pdpi::SetMetadataAndSendPiWriteRequests(app.session.get(), deletes));
+    state.ResumeTiming();
+  }
+  measurements.Report(state, num_entries);
+}
+BENCHMARK_CAPTURE(BM_Insert, Ipv4Routes, &Ipv4Route)->Apply(RouteArgs);
+BENCHMARK_CAPTURE(BM_Insert, WcmpGroups, &WcmpGroup)->Apply(WcmpGroupArgs);
+BENCHMARK_CAPTURE(BM_Insert, AclEntries, &AclIngressEntry)->Apply(AclArgs);
+
+// Modifies installed entries, alternating between two versions of them.
+void BM_Modify(benchmark::State& state, EntryGenerator generator) {
+  const int num_entries = state.range(0);
+  const int batch_size = state.range(1);
+  App app = StartAppOrDie();
+  std::vector<p4::v1::WriteRequest> inserts = MakeWriteRequestsOrDie(
+      generator, num_entries, batch_size, p4::v1::Update::INSERT);
+  CHECK_OK(  // Crash OK
+      pdpi::SetMetadataAndSendPiWriteRequests(app.session.get(), inserts));
+  // Modifying an entry to itself still goes through the whole write path.
+  std::vector<p4::v1::WriteRequest> modifies = MakeWriteRequestsOrDie(
+      generator, num_entries, batch_size, p4::v1::Update::MODIFY);
+
+  Measurements measurements;
+  for (auto _ : state) {
+    measurements.Start();
+    CHECK_OK(  // Crash OK
+        pdpi::SetMetadataAndSendPiWriteRequests(app.session.get(), modifies));
+    measurements.Stop();
+  }
+  measurements.Report(state, num_entries);
+}
+BENCHMARK_CAPTURE(BM_Modify, Ipv4Routes, &Ipv4Route)->Apply(RouteArgs);
+
+// Reads back all installed entries.
+void BM_Read(benchmark::State& state, EntryGenerator generator) {
+  const int num_entries = state.range(0);
+  const int batch_size = state.range(1);
+  App app = StartAppOrDie();
+  std::vector<p4::v1::WriteRequest> inserts = MakeWriteRequestsOrDie(
+      generator, num_entries, batch_size, p4::v1::Update::INSERT);
+  CHECK_OK(  // Crash OK
+      pdpi::SetMetadataAndSendPiWriteRequests(app.session.get(), inserts));
+
+  Measurements measurements;
+  for (auto _ : state) {
+    measurements.Start();
+    p4::v1::ReadRequest request;
+    request.add_entities()->mutable_table_entry();
+    absl::StatusOr<p4::v1::ReadResponse> response =
+        pdpi::SetMetadataAndSendPiReadRequest(app.session.get(), request);
+    CHECK_OK(response.status());  // Crash OK
+    CHECK_EQ(response->entities_size(), num_entries);  // Crash OK
+    measurements.Stop();
+  }
+  measurements.Report(state, num_entries);
+}
+BENCHMARK_CAPTURE(BM_Read, Ipv4Routes, &Ipv4Route)->Apply(ReadArgs);
+
+// Sends packets to the fake PacketIO interface, and waits until the app has
+// sent them all.
+void BM_PacketOut(benchmark::State& state) {
+  const int num_packets = state.range(0);
+  App app = StartAppOrDie();
+
+  sai::PacketOut packet_out;
+  packet_out.set_payload(std::string(/*count=*/128, 'x'));
+  packet_out.mutable_metadata()->set_egress_port(kPacketIoPortId);
+  packet_out.mutable_metadata()->set_submit_to_ingress(
+      pdpi::BitsetToHexString<1>(0));
+  p4::v1::StreamMessageRequest request;
+  absl::StatusOr<p4::v1::PacketOut> pi_packet_out =
+      pdpi::PdPacketOutToPi(sai::GetIrP4Info(kInstantiation), packet_out);
+  CHECK_OK(pi_packet_out.status());  // Crash OK
+  *request.mutable_packet() = *std::move(pi_packet_out);
+  const std::vector<p4::v1::StreamMessageRequest> requests(num_packets,
+                                                           request);
+
+  Measurements measurements;
+  for (auto _ : state) {
+    measurements.Start();
+    const int sent_before =
+        app.service->GetP4rtServer().GetPacketIoCounters().packet_out_sent;
+    CHECK(app.session->StreamChannelWriteBatch(requests));  // Crash OK
+    while (true) {
+      const sonic::PacketIoCounters counters =
+          app.service->GetP4rtServer().GetPacketIoCounters();
+      CHECK_EQ(counters.packet_out_errors, 0);  // Crash OK
+      if (counters.packet_out_sent - sent_before >= num_packets) break;
+      absl::SleepFor(absl::Microseconds(100));
+    }
+    measurements.Stop();
+  }
+  measurements.Report(state, num_packets);
+}
+BENCHMARK(BM_PacketOut)
+    ->ArgName("packets")
+    ->Arg(1'000)
+    ->Arg(10'000)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace p4rt_app
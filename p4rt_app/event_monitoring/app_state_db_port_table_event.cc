@@ -21,7 +21,9 @@
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "p4rt_app/p4runtime/p4runtime_impl.h"
+#include "p4rt_app/utils/status_utility.h"
 #include "swss/schema.h"
+#include "swss/table.h"
 
 namespace p4rt_app {
 
@@ -44,4 +46,27 @@ absl::Status AppStateDbPortTableEventHandler::HandleEvent(
       absl::StrCat("Unhandled SWSS operand '", operation, "'"));
 }
 
+absl::Status AppStateDbPortTableEventHandler::HandleEvents(
+    const std::vector<swss::KeyOpFieldsValuesTuple>& events) {
+  std::vector<std::string> additions;
+  std::vector<std::string> removals;
+  std::vector<absl::Status> statuses;
+  for (const auto& event : events) {
+    if (!absl::StartsWith(kfvKey(event), "Ethernet")) continue;
+
+    if (kfvOp(event) == SET_COMMAND) {
+      additions.push_back(kfvKey(event));
+    } else if (kfvOp(event) == DEL_COMMAND) {
+      removals.push_back(kfvKey(event));
+    } else {
+      statuses.push_back(absl::InvalidArgumentError(
+          absl::StrCat("Unhandled SWSS operand '", kfvOp(event), "'")));
+    }
+  }
+  if (!additions.empty() || !removals.empty()) {
+    statuses.push_back(p4runtime_.UpdatePacketIoPorts(additions, removals));
+  }
+  return CombineStatuses(statuses);
+}
+
 }  // namespace p4rt_app
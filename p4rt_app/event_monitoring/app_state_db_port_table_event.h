@@ -21,6 +21,7 @@
 #include "absl/status/status.h"
 #include "p4rt_app/event_monitoring/state_event_monitor.h"
 #include "p4rt_app/p4runtime/p4runtime_impl.h"
+#include "swss/table.h"
 
 namespace p4rt_app {
 
@@ -35,6 +36,10 @@ class AppStateDbPortTableEventHandler : public sonic::StateEventHandler {
       const std::string& operation, const std::string& key,
       const std::vector<std::pair<std::string, std::string>>& values) override;
 
+  // Adds and removes every PacketIO port with one call to the P4RT server.
+  absl::Status HandleEvents(
+      const std::vector<swss::KeyOpFieldsValuesTuple>& events) override;
+
  private:
   P4RuntimeImpl& p4runtime_;
 };
@@ -26,6 +26,7 @@ namespace p4rt_app {
 namespace {
 
 using ::gutil::StatusIs;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::Return;
 
@@ -112,5 +113,29 @@ TEST(PortTableEventTest, P4RuntimeRemovePacketIoFails) {
                        HasSubstr("something was bad")));
 }
 
+TEST(PortTableEventTest, HandlesABatchWithOneUpdate) {
+  MockP4RuntimeImpl mock_p4runtime_impl;
+  AppStateDbPortTableEventHandler port_change_events(&mock_p4runtime_impl);
+
+  EXPECT_CALL(mock_p4runtime_impl,
+              UpdatePacketIoPorts(ElementsAre("Ethernet0", "Ethernet1"),
+                                  ElementsAre("Ethernet2")))
+      .WillOnce(Return(absl::OkStatus()));
+
+  EXPECT_OK(port_change_events.HandleEvents({
+      {"Ethernet0", kSetCommand, {{"status", "up"}}},
+      {"Loopback0", kSetCommand, {}},
+      {"Ethernet1", kSetCommand, {{"status", "down"}}},
+      {"Ethernet2", kDelCommand, {}},
+  }));
+}
+
+TEST(PortTableEventTest, BatchWithOnlyManagementPortsDoesNothing) {
+  MockP4RuntimeImpl mock_p4runtime_impl;
+  AppStateDbPortTableEventHandler port_change_events(&mock_p4runtime_impl);
+  EXPECT_CALL(mock_p4runtime_impl, UpdatePacketIoPorts).Times(0);
+  EXPECT_OK(port_change_events.HandleEvents({{"Loopback0", kSetCommand, {}}}));
+}
+
 }  // namespace
 }  // namespace p4rt_app
@@ -13,20 +13,28 @@
 // limitations under the License.
 #include "p4rt_app/event_monitoring/config_db_port_table_event.h"
 
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "glog/logging.h"
 #include "gutil/status.h"
 #include "p4rt_app/p4runtime/p4runtime_impl.h"
+#include "p4rt_app/utils/status_utility.h"
 #include "swss/schema.h"
+#include "swss/table.h"
 
 namespace p4rt_app {
 
-absl::Status ConfigDbPortTableEventHandler::HandleEvent(
+namespace {
+
+// Returns the port ID to translate to for a SET, or nullopt if the translation
+// should be removed.
+absl::StatusOr<std::optional<std::string>> PortIdForEvent(
     const std::string& operation, const std::string& key,
     const std::vector<std::pair<std::string, std::string>>& values) {
   std::string port_id;
@@ -40,17 +48,49 @@ absl::Status ConfigDbPortTableEventHandler::HandleEvent(
   if (port_id.empty()) {
     LOG(WARNING) << "Port '" << key
                  << "' does not have an ID field. Removing translation.";
-    RETURN_IF_ERROR(p4runtime_.RemovePortTranslation(key));
+    return std::nullopt;
   } else if (operation == DEL_COMMAND) {
-    RETURN_IF_ERROR(p4runtime_.RemovePortTranslation(key));
+    return std::nullopt;
   } else if (operation == SET_COMMAND) {
-    RETURN_IF_ERROR(p4runtime_.AddPortTranslation(key, port_id));
-  } else {
-    return gutil::InvalidArgumentErrorBuilder()
-           << "unexpected event: " << operation << " on " << key;
+    return port_id;
   }
+  return gutil::InvalidArgumentErrorBuilder()
+         << "unexpected event: " << operation << " on " << key;
+}
+
+}  // namespace
 
-  return absl::OkStatus();
+absl::Status ConfigDbPortTableEventHandler::HandleEvent(
+    const std::string& operation, const std::string& key,
+    const std::vector<std::pair<std::string, std::string>>& values) {
+  ASSIGN_OR_RETURN(std::optional<std::string> port_id,
+                   PortIdForEvent(operation, key, values));
+  if (port_id.has_value()) {
+    return p4runtime_.AddPortTranslation(key, *port_id);
+  }
+  return p4runtime_.RemovePortTranslation(key);
+}
+
+absl::Status ConfigDbPortTableEventHandler::HandleEvents(
+    const std::vector<swss::KeyOpFieldsValuesTuple>& events) {
+  std::vector<std::pair<std::string, std::string>> additions;
+  std::vector<std::string> removals;
+  std::vector<absl::Status> statuses;
+  for (const auto& event : events) {
+    absl::StatusOr<std::optional<std::string>> port_id =
+        PortIdForEvent(kfvOp(event), kfvKey(event), kfvFieldsValues(event));
+    if (!port_id.ok()) {
+      statuses.push_back(port_id.status());
+    } else if (port_id->has_value()) {
+      additions.push_back({kfvKey(event), **port_id});
+    } else {
+      removals.push_back(kfvKey(event));
+    }
+  }
+  if (!additions.empty() || !removals.empty()) {
+    statuses.push_back(p4runtime_.UpdatePortTranslations(additions, removals));
+  }
+  return CombineStatuses(statuses);
 }
 
 }  // namespace p4rt_app
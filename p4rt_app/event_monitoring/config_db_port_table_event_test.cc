@@ -27,9 +27,13 @@ namespace p4rt_app {
 namespace {
 
 using ::gutil::StatusIs;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Pair;
 using ::testing::Return;
 using ::testing::StrictMock;
+using ::testing::UnorderedElementsAre;
 
 // Expected SONiC commands assumed by state events.
 constexpr char kSetCommand[] = "SET";
@@ -135,5 +139,37 @@ TEST(PortTableIdEventTest, P4RuntimeRemovePortTranslationFails) {
       StatusIs(absl::StatusCode::kUnknown, HasSubstr("could not remove")));
 }
 
+TEST(PortTableIdEventTest, HandlesABatchWithOneUpdate) {
+  MockP4RuntimeImpl mock_p4runtime_impl;
+  EXPECT_CALL(mock_p4runtime_impl,
+              UpdatePortTranslations(
+                  UnorderedElementsAre(Pair("Ethernet1", "1"),
+                                       Pair("Ethernet2", "2")),
+                  UnorderedElementsAre("Ethernet3", "Ethernet4")))
+      .WillOnce(Return(absl::OkStatus()));
+  ConfigDbPortTableEventHandler event_handler(&mock_p4runtime_impl);
+  EXPECT_OK(event_handler.HandleEvents({
+      {"Ethernet1", kSetCommand, {{"id", "1"}}},
+      {"Ethernet2", kSetCommand, {{"id", "2"}}},
+      {"Ethernet3", kDelCommand, {}},
+      {"Ethernet4", kSetCommand, {{"speed", "100G"}}},
+  }));
+}
+
+TEST(PortTableIdEventTest, BatchStillAppliesValidEventsOnError) {
+  MockP4RuntimeImpl mock_p4runtime_impl;
+  EXPECT_CALL(mock_p4runtime_impl,
+              UpdatePortTranslations(ElementsAre(Pair("Ethernet1", "1")),
+                                     IsEmpty()))
+      .WillOnce(Return(absl::OkStatus()));
+  ConfigDbPortTableEventHandler event_handler(&mock_p4runtime_impl);
+  EXPECT_THAT(event_handler.HandleEvents({
+                  {"Ethernet1", kSetCommand, {{"id", "1"}}},
+                  {"Ethernet2", "UNKNOWN", {{"id", "2"}}},
+              }),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("unexpected event")));
+}
+
 }  // namespace
 }  // namespace p4rt_app
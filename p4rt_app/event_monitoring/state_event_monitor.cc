@@ -13,20 +13,27 @@
 // limitations under the License.
 #include "p4rt_app/event_monitoring/state_event_monitor.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "glog/logging.h"
 #include "gutil/status.h"
+#include "p4rt_app/utils/status_utility.h"
 #include "swss/rediscommand.h"
 #include "swss/select.h"
 #include "swss/selectable.h"
 #include "swss/subscriberstatetable.h"
+#include "swss/table.h"
 
 namespace p4rt_app {
 namespace sonic {
@@ -58,6 +65,29 @@ absl::StatusOr<swss::Selectable*> WaitForSubscribeEvent(
 
 }  // namespace
 
+std::vector<swss::KeyOpFieldsValuesTuple> CoalesceEventsByKey(
+    const std::deque<swss::KeyOpFieldsValuesTuple>& events) {
+  // Walk backwards so the first event seen for a key is its last one.
+  std::vector<swss::KeyOpFieldsValuesTuple> coalesced;
+  absl::flat_hash_set<std::string> seen_keys;
+  for (auto event = events.rbegin(); event != events.rend(); ++event) {
+    if (seen_keys.insert(kfvKey(*event)).second) coalesced.push_back(*event);
+  }
+  std::reverse(coalesced.begin(), coalesced.end());
+  return coalesced;
+}
+
+absl::Status StateEventHandler::HandleEvents(
+    const std::vector<swss::KeyOpFieldsValuesTuple>& events) {
+  std::vector<absl::Status> statuses;
+  statuses.reserve(events.size());
+  for (const auto& event : events) {
+    statuses.push_back(
+        HandleEvent(kfvOp(event), kfvKey(event), kfvFieldsValues(event)));
+  }
+  return CombineStatuses(statuses);
+}
+
 StateEventMonitor::StateEventMonitor(swss::DBConnector& db) : redis_db_(db) {
   // do nothing.
 }
@@ -88,29 +118,49 @@ absl::Status StateEventMonitor::WaitForNextEventAndHandle() {
   ASSIGN_OR_RETURN(selectable,
                    WaitForSubscribeEvent(selector_, redis_db_.getDbName()));
 
-  for (auto& [table_name, handler] : monitored_tables_by_name_) {
-    // Only pop events for the selectable that raised the event.
-    if (selectable != handler.subscriber_table.get()) {
-      continue;
+  // Collect everything that is already pending before handling any of it. At
+  // boot every port comes up at once, and handling them as one batch avoids
+  // taking the P4RT locks once per port.
+  absl::flat_hash_map<std::string, std::deque<swss::KeyOpFieldsValuesTuple>>
+      events_by_table;
+  do {
+    auto table = std::find_if(monitored_tables_by_name_.begin(),
+                              monitored_tables_by_name_.end(),
+                              [selectable](const auto& entry) {
+                                return selectable ==
+                                       entry.second.subscriber_table.get();
+                              });
+    if (table == monitored_tables_by_name_.end()) {
+      return gutil::InternalErrorBuilder()
+             << "Detected an event for " << redis_db_.getDbName()
+             << ", but it was not handled?";
     }
 
     std::deque<swss::KeyOpFieldsValuesTuple> events;
-    handler.subscriber_table->pops(events);
-    for (const auto& event : events) {
-      absl::Status status = handler.event_handler->HandleEvent(
-          kfvOp(event), kfvKey(event), kfvFieldsValues(event));
-      if (!status.ok()) {
-        LOG(ERROR) << "Could not handle " << table_name << " change in "
-                   << redis_db_.getDbName() << ": " << status;
-      }
+    table->second.subscriber_table->pops(events);
+    std::deque<swss::KeyOpFieldsValuesTuple>& table_events =
+        events_by_table[table->first];
+    for (auto& event : events) table_events.push_back(std::move(event));
+
+    selectable = nullptr;
+  } while (selector_.select(&selectable, /*timeout=*/0) ==
+           swss::Select::OBJECT);
+
+  for (const auto& [table_name, events] : events_by_table) {
+    std::vector<swss::KeyOpFieldsValuesTuple> coalesced =
+        CoalesceEventsByKey(events);
+    if (coalesced.empty()) continue;
+    VLOG(1) << "Handling " << coalesced.size() << " " << table_name
+            << " events in " << redis_db_.getDbName() << ".";
+    absl::Status status =
+        monitored_tables_by_name_.at(table_name).event_handler->HandleEvents(
+            coalesced);
+    if (!status.ok()) {
+      LOG(ERROR) << "Could not handle " << table_name << " change in "
+                 << redis_db_.getDbName() << ": " << status;
     }
-
-    return absl::OkStatus();
   }
-
-  return gutil::InternalErrorBuilder()
-         << "Detected an event for " << redis_db_.getDbName()
-         << ", but it was not handled?";
+  return absl::OkStatus();
 }
 
 }  // namespace sonic
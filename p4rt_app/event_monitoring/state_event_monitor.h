@@ -16,6 +16,9 @@
 
 #include <deque>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
@@ -23,6 +26,7 @@
 #include "swss/dbconnector.h"
 #include "swss/select.h"
 #include "swss/subscriberstatetable.h"
+#include "swss/table.h"
 
 namespace p4rt_app {
 namespace sonic {
@@ -48,12 +52,24 @@ class StateEventHandler {
       const std::string& operation, const std::string& key,
       const std::vector<std::pair<std::string, std::string>>& values) = 0;
 
+  // Callback to handle a batch of events for the monitored table. Each key
+  // appears at most once. By default every event is passed to HandleEvent,
+  // but handlers can override this to apply the whole batch at once.
+  virtual absl::Status HandleEvents(
+      const std::vector<swss::KeyOpFieldsValuesTuple>& events);
+
   virtual ~StateEventHandler() = default;
 
  protected:
   StateEventHandler() = default;
 };
 
+// Reduces a sequence of events to the last event for every key, ordered by
+// when that last event happened. The table DBs hold the full state of an entry
+// so only the most recent event matters.
+std::vector<swss::KeyOpFieldsValuesTuple> CoalesceEventsByKey(
+    const std::deque<swss::KeyOpFieldsValuesTuple>& events);
+
 // StateEventMonitor can monitor changes to specific tables in a Redis DB. A
 // single monitor can watch multiple table (e.g. PORT_TABLE, INTF_TABLE) in a
 // Redis DB, but not multiple Redis DBs (e.g. CONFIG_DB, STATE_DB). A unique
@@ -77,7 +93,9 @@ class StateEventMonitor {
                                     std::unique_ptr<StateEventHandler> handler);
 
   // Blocks indefinitely until an event or a set of events occur on any of the
-  // monitored table.
+  // monitored table. Every event that is already pending, on any table, is
+  // collected before handling them. Events are coalesced by key, and each
+  // table's handler gets its events as one batch.
   absl::Status WaitForNextEventAndHandle();
 
  private:
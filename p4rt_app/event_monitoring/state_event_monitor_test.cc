@@ -0,0 +1,90 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/event_monitoring/state_event_monitor.h"
+
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "swss/table.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::FieldsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+
+// Records every event it is asked to handle, and fails for key "bad".
+class RecordingEventHandler : public StateEventHandler {
+ public:
+  absl::Status HandleEvent(
+      const std::string& operation, const std::string& key,
+      const std::vector<std::pair<std::string, std::string>>& values) override {
+    keys_.push_back(key);
+    if (key == "bad") return absl::InvalidArgumentError("bad key");
+    return absl::OkStatus();
+  }
+
+  const std::vector<std::string>& keys() const { return keys_; }
+
+ private:
+  std::vector<std::string> keys_;
+};
+
+TEST(CoalesceEventsByKeyTest, KeepsTheLastEventForEachKey) {
+  std::deque<swss::KeyOpFieldsValuesTuple> events = {
+      {"Ethernet0", "SET", {{"id", "1"}}},
+      {"Ethernet1", "SET", {{"id", "2"}}},
+      {"Ethernet0", "DEL", {}},
+      {"Ethernet0", "SET", {{"id", "3"}}},
+  };
+  EXPECT_THAT(CoalesceEventsByKey(events),
+              ElementsAre(FieldsAre("Ethernet1", "SET",
+                                    ElementsAre(Pair("id", "2"))),
+                          FieldsAre("Ethernet0", "SET",
+                                    ElementsAre(Pair("id", "3")))));
+}
+
+TEST(CoalesceEventsByKeyTest, KeepsADeleteThatComesLast) {
+  std::deque<swss::KeyOpFieldsValuesTuple> events = {
+      {"Ethernet0", "SET", {{"id", "1"}}},
+      {"Ethernet0", "DEL", {}},
+  };
+  EXPECT_THAT(CoalesceEventsByKey(events),
+              ElementsAre(FieldsAre("Ethernet0", "DEL", IsEmpty())));
+}
+
+TEST(StateEventHandlerTest, HandlesEveryEventInABatch) {
+  RecordingEventHandler handler;
+  EXPECT_THAT(handler.HandleEvents({{"good", "SET", {}},
+                                    {"bad", "SET", {}},
+                                    {"also_good", "DEL", {}}}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("bad key")));
+  EXPECT_THAT(handler.keys(), ElementsAre("good", "bad", "also_good"));
+}
+
+}  // namespace
+}  // namespace sonic
+}  // namespace p4rt_app
@@ -13,7 +13,9 @@
 // limitations under the License.
 
 #include <fstream>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -27,6 +29,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
@@ -49,17 +52,22 @@
 #include "p4rt_app/event_monitoring/debug_data_dump_events.h"
 #include "p4rt_app/event_monitoring/state_event_monitor.h"
 #include "p4rt_app/event_monitoring/state_verification_events.h"
+#include "p4rt_app/p4runtime/p4runtime_callback_service.h"
 #include "p4rt_app/p4runtime/p4runtime_impl.h"
 #include "p4rt_app/sonic/adapters/consumer_notifier_adapter.h"
 #include "p4rt_app/sonic/adapters/notification_producer_adapter.h"
 #include "p4rt_app/sonic/adapters/producer_state_table_adapter.h"
 #include "p4rt_app/sonic/adapters/system_call_adapter.h"
 #include "p4rt_app/sonic/adapters/table_adapter.h"
+#include "p4rt_app/sonic/app_db_manager.h"
+#include "p4rt_app/sonic/packet_in_rate_limiter.h"
 #include "p4rt_app/sonic/packetio_impl.h"
 //TODO(PINS):
 //#include "swss/component_state_helper.h"
 //#include "swss/component_state_helper_interface.h"
 #include "p4rt_app/sonic/redis_connections.h"
+#include "p4rt_app/utils/task_executor.h"
+#include "p4rt_app/utils/thread_placement.h"
 #include "swss/dbconnector.h"
 #include "swss/schema.h"
 
@@ -106,6 +114,111 @@ DEFINE_string(save_forwarding_config_file,
               "/etc/sonic/p4rt_forwarding_config.pb.txt",
               "Saves the forwarding pipeline config to a file so it can be "
               "reloaded after reboot.");
+DEFINE_string(entity_cache_snapshot_file, "",
+              "Saves the entity cache to a file when P4RT is stopped so it can "
+              "be reloaded during warm start instead of being rebuilt from "
+              "the AppDb. Disabled when empty.");
+DEFINE_string(acl_table_definition_cache_file, "",
+              "Saves the compiled ACL table definitions to a file so that "
+              "re-applying the same P4Info does not recompile them. Disabled "
+              "when empty.");
+DEFINE_int32(read_response_max_bytes,
+             p4rt_app::kDefaultReadResponseMaxBytes,
+             "Approximate size in bytes of each streamed ReadResponse. Should "
+             "stay below the controller's max gRPC receive message size.");
+DEFINE_int32(acl_counter_cache_staleness_ms, 0,
+             "Serves ACL counter reads from memory when the counters were "
+             "fetched from the CountersDB at most this many milliseconds ago. "
+             "Recently read counters are refreshed in the background. Set to 0 "
+             "to read the CountersDB on every read.");
+DEFINE_int32(acl_counter_cache_idle_timeout_s, 60,
+             "ACL counters that are not read for this many seconds are no "
+             "longer refreshed in the background.");
+DEFINE_int32(state_verification_keys_per_tick, 0,
+             "Number of P4RT_TABLE entries verified against the entity cache "
+             "on every tick of the background state verification. Set to 0 to "
+             "disable background verification.");
+DEFINE_int32(state_verification_tick_ms, 1000,
+             "Time in milliseconds between background state verification "
+             "ticks.");
+DEFINE_int32(write_translation_threads, 0,
+             "Number of extra threads used to translate large Write batches "
+             "and to rebuild the entity cache from the AppDb. Set to 0 to "
+             "translate on the calling thread.");
+DEFINE_int32(read_threads, 0,
+             "Number of extra threads used to filter and serialize the "
+             "entries of large Read requests. Set to 0 to serve reads on the "
+             "calling thread.");
+DEFINE_string(write_capture_file, "",
+              "Captures recent Write requests, with their timing and status, "
+              "in a memory-mapped ring at this file, which is included in "
+              "debug data dumps. Disabled when empty.");
+DEFINE_int32(write_capture_mb, 64, "Size of the write capture ring in MB.");
+DEFINE_int32(write_coalescing_window_us, 0,
+             "Time in microseconds a Write request waits for later requests "
+             "so that they are published to the AppDb together, without their "
+             "superseded updates. Set to 0 to disable coalescing.");
+DEFINE_int32(app_db_publish_max_entries, 0,
+             "Maximum number of P4RT_TABLE updates in each send to the AppDb. "
+             "Set to 0 for no limit.");
+DEFINE_int64(app_db_publish_max_bytes, 0,
+             "Maximum number of bytes of P4RT_TABLE updates in each send to "
+             "the AppDb. Set to 0 for no limit.");
+DEFINE_string(app_db_publish_table_limits, "",
+              "Per-table overrides of the AppDb send limits as "
+              "<table>=<max_entries>:<max_bytes>,... where <table> is an "
+              "AppDb table name (e.g. FIXED_IPV4_TABLE) or a table type "
+              "(e.g. ACL).");
+DEFINE_int32(app_db_publish_max_outstanding_sends, 1,
+             "Number of AppDb sends that can wait on OrchAgent responses at "
+             "a time when the publish limits are set.");
+DEFINE_int64(write_admission_max_outstanding_updates, 0,
+             "Write requests are rejected with RESOURCE_EXHAUSTED while this "
+             "many updates are outstanding. Disabled when 0.");
+DEFINE_int32(write_admission_max_orch_agent_latency_ms, 0,
+             "Write requests are rejected with UNAVAILABLE while the recent "
+             "OrchAgent response latency is above this. Disabled when 0.");
+DEFINE_int32(write_admission_max_wait_ms, 0,
+             "How long a Write request may wait for the admission limits to "
+             "clear before it is rejected.");
+DEFINE_int32(packetio_receive_threads, 0,
+             "Number of threads receiving packets from the netdev ports. Ports "
+             "are sharded across the threads. Set to 0 to receive every port "
+             "on a single thread.");
+DEFINE_string(packet_in_rate_limits, "",
+              "Token bucket limits on the PacketIns sent to the controller, as "
+              "a semicolon separated list of <key>=<packets per second>"
+              "[:<burst>], where <key> is 'total', 'per_port', or a port name. "
+              "Packets over a limit are dropped as they are received. For "
+              "example: 'total=5000;per_port=1000:200;Ethernet1/1/1=50'.");
+DEFINE_int32(p4rt_callback_threads, 0,
+             "Number of threads handling P4Runtime RPCs when serving with the "
+             "gRPC callback API. Set to 0 to use the sync service, which "
+             "holds a gRPC thread for every in-flight RPC and open "
+             "StreamChannel.");
+DEFINE_bool(commit_saved_config_at_startup, false,
+            "Commit the config saved in --save_forwarding_config_file at "
+            "startup, in the background, instead of waiting for a controller "
+            "to COMMIT it. Arbitration is served right away, while Read and "
+            "Write requests wait for the commit to finish.");
+DEFINE_string(thread_placement, "",
+              "CPUs and nice values of the P4RT threads, as a semicolon "
+              "separated list of <role>=<cpus>[@<nice>]. Roles are grpc, "
+              "packetio, event_loops, and background. For example: "
+              "\"grpc=4-7;packetio=2-3@-10;background=0-1@10\". Unlisted roles "
+              "run anywhere.");
+DEFINE_bool(syslog_async, true,
+            "Write log messages to syslog from a background thread instead of "
+            "the logging thread.");
+DEFINE_int32(syslog_queue_size, 1024,
+             "Number of log messages that can wait to be written to syslog "
+             "when --syslog_async is set.");
+DEFINE_bool(syslog_drop_when_full, true,
+            "Drop log messages when the syslog queue is full. Otherwise they "
+            "are written on the logging thread.");
+DEFINE_int32(syslog_max_messages_per_second, 0,
+             "Maximum number of INFO and WARNING messages written to syslog "
+             "per second when --syslog_async is set. Set to 0 for no limit.");
 
 absl::StatusOr<std::shared_ptr<ServerCredentials>> BuildServerCredentials() {
   constexpr int kCertRefreshIntervalSec = 5;
@@ -274,6 +387,7 @@ sonic::HostStatsTable CreateHostStatsTable(swss::DBConnector* state_db) {
 
 void LogStatsEveryMinute(absl::Notification* stop,
                          p4rt_app::P4RuntimeImpl* p4runtime) {
+  int64_t rejected_writes = 0;
   while (!stop->HasBeenNotified()) {
     absl::SleepFor(absl::Minutes(1));
 
@@ -283,6 +397,21 @@ void LogStatsEveryMinute(absl::Notification* stop,
       continue;
     }
 
+    // The write queue depth matters most when writes are stuck, so it is
+    // published even if no write finished. The memory footprint and PacketIO
+    // drops are cheap to publish, and also change without writes.
+    p4runtime->PublishWriteAdmissionStatistics();
+    p4runtime->PublishMemoryFootprint();
+    p4runtime->PublishPacketIoStatistics();
+    if (stats->write_admission.rejected_batches > rejected_writes) {
+      LOG(INFO) << absl::StreamFormat(
+          "Admission control rejected %d write requests over the past minute, "
+          "with %d updates outstanding.",
+          stats->write_admission.rejected_batches - rejected_writes,
+          stats->write_admission.outstanding_updates);
+      rejected_writes = stats->write_admission.rejected_batches;
+    }
+
     // Reads and writes happen independently, but the controller will read every
     // few seconds to verify correctness. To avoid being spammy we will only log
     // performance when changes are made to the switch (i.e. when we see a
@@ -295,6 +424,27 @@ void LogStatsEveryMinute(absl::Notification* stop,
           stats->write_requests_count, stats->write_batch_count,
           absl::ToInt64Microseconds(stats->max_write_time));
 
+      const p4rt_app::WriteLatencyStatistics& latency = stats->write_latency;
+      LOG(INFO) << "Write latency over the past minute: total["
+                << latency.total.Summary() << "] translate["
+                << latency.stages.translate.Summary() << "] app_db_publish["
+                << latency.stages.app_db_publish.Summary()
+                << "] orch_agent_wait["
+                << latency.stages.orch_agent_wait.Summary()
+                << "] cache_update[" << latency.stages.cache_update.Summary()
+                << "]";
+      if (VLOG_IS_ON(1)) {
+        for (const auto& [table, stages] : latency.stages_by_table) {
+          LOG(INFO) << "Write latency for " << table << ": translate["
+                    << stages.translate.Summary() << "] app_db_publish["
+                    << stages.app_db_publish.Summary() << "] orch_agent_wait["
+                    << stages.orch_agent_wait.Summary() << "] cache_update["
+                    << stages.cache_update.Summary() << "]";
+        }
+      }
+      p4runtime->PublishWriteLatencyStatistics(latency);
+      p4runtime->PublishResourceUtilization();
+
       if (stats->read_request_count > 0) {
         LOG(INFO) << absl::StreamFormat(
             "Spent %d microseconds handling %d read requests over the past "
@@ -306,6 +456,36 @@ void LogStatsEveryMinute(absl::Notification* stop,
   }
 }
 
+// Walks through the P4RT_TABLE a slice at a time so that writes are never
+// blocked for a full pass. Progress is published into HOST_STATS by the
+// P4RuntimeImpl.
+void VerifyStateInBackground(absl::Notification* stop,
+                             p4rt_app::P4RuntimeImpl* p4runtime,
+                             int keys_per_tick, absl::Duration tick) {
+  while (!stop->WaitForNotificationWithTimeout(tick)) {
+    absl::Status status = p4runtime->VerifyStateIncrementally(keys_per_tick);
+    // Nothing can be verified until a forwarding pipeline config is pushed.
+    if (absl::IsFailedPrecondition(status)) continue;
+    if (!status.ok()) {
+      LOG(WARNING) << "Background state verification found issues: "
+                   << status.message();
+    }
+  }
+}
+
+// Keeps the ACL counters that are being read fresh, so reads can be served
+// from memory.
+void RefreshAclCountersInBackground(absl::Notification* stop,
+                                    p4rt_app::P4RuntimeImpl* p4runtime,
+                                    absl::Duration interval) {
+  while (!stop->WaitForNotificationWithTimeout(interval)) {
+    if (absl::Status status = p4runtime->RefreshAclCounterCache();
+        !status.ok()) {
+      LOG(WARNING) << "Could not refresh the ACL counter cache: " << status;
+    }
+  }
+}
+
 // Construct and register a table handler with the given state monitor.
 template <typename T, typename... Args>
 void RegisterTableHandlerOrDie(p4rt_app::sonic::StateEventMonitor& monitor,
@@ -337,7 +517,8 @@ void AppStateDbEventLoop(P4RuntimeImpl* p4runtime_server,
 }
 
 void ConfigDbEventLoop(P4RuntimeImpl* p4runtime_server,
-                       bool* monitor_config_db_events) {
+                       bool* monitor_config_db_events,
+                       absl::Notification* initial_events_handled) {
   swss::DBConnector config_db("CONFIG_DB", /*timeout=*/0);
   p4rt_app::sonic::StateEventMonitor config_db_monitor(config_db);
 
@@ -358,16 +539,67 @@ void ConfigDbEventLoop(P4RuntimeImpl* p4runtime_server,
       LOG(ERROR) << "CONFIG_DB event monitor failed waiting for an event: "
                  << status;
     }
+    // The first events include every entry that existed at startup.
+    if (!initial_events_handled->HasBeenNotified()) {
+      initial_events_handled->Notify();
+    }
   }
 }
 
+// Starts a thread that runs `body` with the given placement.
+std::thread StartPlacedThread(absl::string_view name,
+                              const ThreadPlacement& placement,
+                              std::function<void()> body) {
+  return std::thread(
+      [name = std::string(name), placement, body = std::move(body)] {
+        if (absl::Status status = ApplyThreadPlacement(placement);
+            !status.ok()) {
+          LOG(WARNING) << "Could not place the " << name
+                       << " thread: " << status;
+        }
+        body();
+      });
+}
+
 }  // namespace
 }  // namespace p4rt_app
 
 int main(int argc, char** argv) {
-  gutil::SyslogSink syslog_sink("p4rt");
   google::InitGoogleLogging(argv[0]);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  std::optional<gutil::SyslogSink> syslog_sink;
+  std::optional<gutil::AsyncSyslogSink> async_syslog_sink;
+  if (FLAGS_syslog_async) {
+    async_syslog_sink.emplace(
+        "p4rt",
+        gutil::AsyncSyslogSinkOptions{
+            .queue_size = FLAGS_syslog_queue_size,
+            .overflow_policy =
+                FLAGS_syslog_drop_when_full
+                    ? gutil::SyslogOverflowPolicy::kDropNewest
+                    : gutil::SyslogOverflowPolicy::kWriteSynchronously,
+            .max_messages_per_second =
+                static_cast<double>(FLAGS_syslog_max_messages_per_second),
+        });
+  } else {
+    syslog_sink.emplace("p4rt");
+  }
+
+  absl::StatusOr<p4rt_app::ThreadPlacementConfig> thread_placement =
+      p4rt_app::ParseThreadPlacementConfig(FLAGS_thread_placement);
+  if (!thread_placement.ok()) {
+    LOG(ERROR) << "Invalid --thread_placement: " << thread_placement.status();
+    return -1;
+  }
+
+  absl::StatusOr<p4rt_app::sonic::PacketInRateLimits> packet_in_rate_limits =
+      p4rt_app::sonic::ParsePacketInRateLimits(FLAGS_packet_in_rate_limits);
+  if (!packet_in_rate_limits.ok()) {
+    LOG(ERROR) << "Invalid --packet_in_rate_limits: "
+               << packet_in_rate_limits.status();
+    return -1;
+  }
   
   /*TODO(PINS): Get the P4RT component helper which can be used to put the switch into
   // critical state.
@@ -404,7 +636,11 @@ int main(int argc, char** argv) {
   // Create PacketIoImpl for Packet I/O.
   auto packetio_impl = std::make_unique<p4rt_app::sonic::PacketIoImpl>(
       std::make_unique<p4rt_app::sonic::SystemCallAdapter>(),
-      p4rt_app::sonic::PacketIoOptions{});
+      p4rt_app::sonic::PacketIoOptions{
+          .receive_threads = FLAGS_packetio_receive_threads,
+          .receive_placement = thread_placement->packetio,
+          .packet_in_rate_limits = *std::move(packet_in_rate_limits),
+      });
 
   // TODO(PINS): Create a netdev translator for P4Runtime's PacketIo handling.
   //  swss::IntfTranslator netdev_translator(&packetio_config_db);
@@ -413,12 +649,64 @@ int main(int argc, char** argv) {
   p4rt_app::P4RuntimeImplOptions p4rt_options{
       .use_genetlink = FLAGS_use_genetlink,
       .translate_port_ids = FLAGS_use_port_ids,
+      .read_response_max_bytes = FLAGS_read_response_max_bytes,
+      .write_translation_threads = FLAGS_write_translation_threads,
+      .read_threads = FLAGS_read_threads,
+      .write_coalescing_window =
+          absl::Microseconds(FLAGS_write_coalescing_window_us),
+      .acl_counter_cache_max_staleness =
+          absl::Milliseconds(FLAGS_acl_counter_cache_staleness_ms),
+      .acl_counter_cache_idle_timeout =
+          absl::Seconds(FLAGS_acl_counter_cache_idle_timeout_s),
+      .write_admission =
+          {
+              .max_outstanding_updates =
+                  FLAGS_write_admission_max_outstanding_updates,
+              .max_orch_agent_latency = absl::Milliseconds(
+                  FLAGS_write_admission_max_orch_agent_latency_ms),
+              .max_wait = absl::Milliseconds(FLAGS_write_admission_max_wait_ms),
+          },
   };
 
   std::string save_forwarding_config_file = FLAGS_save_forwarding_config_file;
   if (!save_forwarding_config_file.empty()) {
     p4rt_options.forwarding_config_full_path = save_forwarding_config_file;
   }
+  if (!FLAGS_entity_cache_snapshot_file.empty()) {
+    p4rt_options.entity_cache_snapshot_path = FLAGS_entity_cache_snapshot_file;
+  }
+  if (!FLAGS_acl_table_definition_cache_file.empty()) {
+    p4rt_options.acl_table_definition_cache_path =
+        FLAGS_acl_table_definition_cache_file;
+  }
+  p4rt_options.commit_saved_config_at_startup =
+      FLAGS_commit_saved_config_at_startup;
+  if (!FLAGS_write_capture_file.empty()) {
+    p4rt_options.write_capture_path = FLAGS_write_capture_file;
+    p4rt_options.write_capture_bytes =
+        static_cast<int64_t>(FLAGS_write_capture_mb) << 20;
+  }
+
+  if (FLAGS_app_db_publish_max_entries > 0 ||
+      FLAGS_app_db_publish_max_bytes > 0 ||
+      !FLAGS_app_db_publish_table_limits.empty()) {
+    auto limits_by_table = p4rt_app::sonic::ParseAppDbPublishLimitsByTable(
+        FLAGS_app_db_publish_table_limits);
+    if (!limits_by_table.ok()) {
+      LOG(ERROR) << "Invalid --app_db_publish_table_limits: "
+                 << limits_by_table.status();
+      return -1;
+    }
+    p4rt_options.app_db_publish_policy = p4rt_app::sonic::AppDbPublishPolicy{
+        .default_limits =
+            {
+                .max_entries = FLAGS_app_db_publish_max_entries,
+                .max_bytes = FLAGS_app_db_publish_max_bytes,
+            },
+        .limits_by_table = *std::move(limits_by_table),
+        .max_outstanding_sends = FLAGS_app_db_publish_max_outstanding_sends,
+    };
+  }
 
   bool is_warm_start = swss::WarmStart::isWarmStart();
   p4rt_options.is_freeze_mode = is_warm_start;
@@ -448,8 +736,9 @@ int main(int argc, char** argv) {
   // Create a server to listen on the unix socket port.
   std::thread internal_server_thread;
   if (!FLAGS_p4rt_unix_socket.empty()) {
-    internal_server_thread = std::thread(
-        [](p4rt_app::P4RuntimeImpl* p4rt_server) {
+    internal_server_thread = p4rt_app::StartPlacedThread(
+        "unix socket server", thread_placement->grpc,
+        [p4rt_server = &p4runtime_server] {
           ServerBuilder builder;
           builder.AddListeningPort(
               absl::StrCat("unix:", FLAGS_p4rt_unix_socket),
@@ -459,21 +748,40 @@ int main(int argc, char** argv) {
           LOG(INFO) << "Started unix socket server listening on "
                     << FLAGS_p4rt_unix_socket << ".";
           server->Wait();
-        },
-        &p4runtime_server);
+        });
   }
 
   // Spawn a separate thread that can react to AppStateDb changes.
   bool monitor_app_state_db_events = true;
-  auto app_state_db_event_loop = std::thread(
+  auto app_state_db_event_loop = p4rt_app::StartPlacedThread(
+      "APPL_STATE_DB event loop", thread_placement->event_loops,
       absl::bind_front(&p4rt_app::AppStateDbEventLoop, &p4runtime_server,
                        &monitor_app_state_db_events));
 
   // Spawn a separate thread that can react to ConfigDb changes.
   bool monitor_config_db_events = true;
-  auto config_db_event_loop = std::thread(
+  absl::Notification config_db_loaded;
+  auto config_db_event_loop = p4rt_app::StartPlacedThread(
+      "CONFIG_DB event loop", thread_placement->event_loops,
       absl::bind_front(&p4rt_app::ConfigDbEventLoop, &p4runtime_server,
-                       &monitor_config_db_events));
+                       &monitor_config_db_events, &config_db_loaded));
+
+  // Commit the saved config while the rest of the server starts. Translating
+  // the AppDb entries needs the ports, so wait for the ConfigDb to be loaded
+  // first. The ConfigDb may have nothing to load, so only wait for a while.
+  std::thread saved_config_commit;
+  if (p4rt_options.commit_saved_config_at_startup) {
+    saved_config_commit = p4rt_app::StartPlacedThread(
+        "saved config commit", thread_placement->background,
+        [&p4runtime_server, &config_db_loaded] {
+          if (!config_db_loaded.WaitForNotificationWithTimeout(
+                  absl::Seconds(10))) {
+            LOG(WARNING) << "Committing the saved config before the ConfigDb "
+                            "has been loaded.";
+          }
+          p4runtime_server.CommitSavedPipelineConfig().IgnoreError();
+        });
+  }
 
   // Start listening for state verification events, and update StateDb for P4RT.
   swss::DBConnector state_verification_db("STATE_DB", /*timeout=*/0);
@@ -497,8 +805,43 @@ int main(int argc, char** argv) {
 
   // Report performance statistics every minute.
   absl::Notification stop_stats_logging;
-  std::thread stats_logging_loop(p4rt_app::LogStatsEveryMinute,
-                                 &stop_stats_logging, &p4runtime_server);
+  std::thread stats_logging_loop = p4rt_app::StartPlacedThread(
+      "statistics", thread_placement->background,
+      absl::bind_front(p4rt_app::LogStatsEveryMinute, &stop_stats_logging,
+                       &p4runtime_server));
+
+  // Continuously verify the AppDb and entity cache in the background.
+  absl::Notification stop_state_verification;
+  std::thread state_verification_loop;
+  if (FLAGS_state_verification_keys_per_tick > 0) {
+    state_verification_loop = p4rt_app::StartPlacedThread(
+        "state verification", thread_placement->background,
+        absl::bind_front(p4rt_app::VerifyStateInBackground,
+                         &stop_state_verification, &p4runtime_server,
+                         FLAGS_state_verification_keys_per_tick,
+                         absl::Milliseconds(FLAGS_state_verification_tick_ms)));
+  }
+
+  // Refresh the cached ACL counters at twice the rate they go stale, so reads
+  // rarely have to fetch them.
+  absl::Notification stop_acl_counter_refresh;
+  std::thread acl_counter_refresh_loop;
+  if (FLAGS_acl_counter_cache_staleness_ms > 0) {
+    acl_counter_refresh_loop = p4rt_app::StartPlacedThread(
+        "ACL counter refresh", thread_placement->background,
+        absl::bind_front(
+            p4rt_app::RefreshAclCountersInBackground, &stop_acl_counter_refresh,
+            &p4runtime_server,
+            absl::Milliseconds(FLAGS_acl_counter_cache_staleness_ms) / 2));
+  }
+
+  // Every thread created from here on, including gRPC's own threads and the
+  // callback executor, inherits the main thread's placement.
+  if (absl::Status status = p4rt_app::ApplyThreadPlacement(
+          thread_placement->grpc);
+      !status.ok()) {
+    LOG(WARNING) << "Could not place the gRPC threads: " << status;
+  }
 
   // Start a P4 runtime server
   ServerBuilder builder;
@@ -522,7 +865,20 @@ int main(int argc, char** argv) {
     builder.experimental().SetAuthorizationPolicyProvider(std::move(provider));
   }
 
-  builder.RegisterService(&p4runtime_server);
+  // The executor and callback service must outlive the server.
+  std::unique_ptr<p4rt_app::TaskExecutor> callback_executor;
+  std::unique_ptr<p4rt_app::P4RuntimeCallbackService> callback_service;
+  if (FLAGS_p4rt_callback_threads > 0) {
+    callback_executor =
+        std::make_unique<p4rt_app::TaskExecutor>(FLAGS_p4rt_callback_threads);
+    callback_service = std::make_unique<p4rt_app::P4RuntimeCallbackService>(
+        p4runtime_server, *callback_executor);
+    builder.RegisterService(callback_service.get());
+    LOG(INFO) << "Serving P4Runtime with the callback API on "
+              << FLAGS_p4rt_callback_threads << " threads.";
+  } else {
+    builder.RegisterService(&p4runtime_server);
+  }
 
   // Disable max ping strikes behavior to allow more frequent KA.
   builder.AddChannelArgument(GRPC_ARG_HTTP2_MAX_PING_STRIKES, 0);
@@ -547,12 +903,22 @@ int main(int argc, char** argv) {
   server->Wait();
 
   LOG(INFO) << "Stopping the P4RT service.";
+  // TODO: Save the snapshot when the freeze notification is handled.
+  if (absl::Status status = p4runtime_server.SaveEntityCacheSnapshot();
+      !status.ok()) {
+    LOG(WARNING) << "Could not save the entity cache snapshot: " << status;
+  }
   monitor_app_state_db_events = false;
   monitor_config_db_events = false;
   stop_stats_logging.Notify();
+  stop_state_verification.Notify();
+  stop_acl_counter_refresh.Notify();
   app_state_db_event_loop.join();
   config_db_event_loop.join();
   stats_logging_loop.join();
+  if (state_verification_loop.joinable()) state_verification_loop.join();
+  if (acl_counter_refresh_loop.joinable()) acl_counter_refresh_loop.join();
+  if (saved_config_commit.joinable()) saved_config_commit.join();
 
   return 0;
 }
@@ -0,0 +1,122 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/p4runtime/acl_counter_cache.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "gutil/status.h"
+
+namespace p4rt_app {
+namespace {
+
+absl::StatusOr<std::vector<AclCounterCache::CounterValues>> FetchAll(
+    const std::vector<std::string>& keys, AclCounterCache::BatchFetch fetch) {
+  ASSIGN_OR_RETURN(std::vector<AclCounterCache::CounterValues> values,
+                   fetch(keys));
+  if (values.size() != keys.size()) {
+    return gutil::InternalErrorBuilder()
+           << "Requested counter data for " << keys.size()
+           << " keys, but got " << values.size()
+           << " results from the CountersDB.";
+  }
+  return values;
+}
+
+}  // namespace
+
+absl::StatusOr<AclCounterCache::Lookup> AclCounterCache::Get(
+    const std::vector<std::string>& counter_db_keys, BatchFetch fetch,
+    absl::Time now) {
+  Lookup lookup;
+  lookup.values.resize(counter_db_keys.size());
+
+  // Positions of the keys that need to be fetched.
+  std::vector<int> stale_positions;
+  {
+    absl::MutexLock l(&lock_);
+    for (int i = 0; i < counter_db_keys.size(); ++i) {
+      Entry& entry = entries_[counter_db_keys[i]];
+      entry.last_read_time = now;
+      if (now - entry.fetch_time > max_staleness_) {
+        stale_positions.push_back(i);
+        continue;
+      }
+      lookup.values[i] = entry.values;
+      lookup.fetch_time = std::min(lookup.fetch_time, entry.fetch_time);
+    }
+  }
+  if (stale_positions.empty()) return lookup;
+
+  std::vector<std::string> stale_keys;
+  stale_keys.reserve(stale_positions.size());
+  for (int position : stale_positions) {
+    stale_keys.push_back(counter_db_keys[position]);
+  }
+  ASSIGN_OR_RETURN(std::vector<CounterValues> fetched,
+                   FetchAll(stale_keys, fetch));
+  for (int i = 0; i < stale_positions.size(); ++i) {
+    lookup.values[stale_positions[i]] = fetched[i];
+  }
+  lookup.fetch_time = std::min(lookup.fetch_time, now);
+
+  absl::MutexLock l(&lock_);
+  Store(stale_keys, std::move(fetched), now);
+  return lookup;
+}
+
+absl::Status AclCounterCache::Refresh(BatchFetch fetch, absl::Time now) {
+  std::vector<std::string> keys;
+  {
+    absl::MutexLock l(&lock_);
+    absl::erase_if(entries_, [&](const auto& key_and_entry) {
+      return now - key_and_entry.second.last_read_time > idle_timeout_;
+    });
+    keys.reserve(entries_.size());
+    for (const auto& [key, entry] : entries_) keys.push_back(key);
+  }
+  if (keys.empty()) return absl::OkStatus();
+
+  ASSIGN_OR_RETURN(std::vector<CounterValues> fetched, FetchAll(keys, fetch));
+  absl::MutexLock l(&lock_);
+  Store(keys, std::move(fetched), now);
+  return absl::OkStatus();
+}
+
+int AclCounterCache::size() const {
+  absl::MutexLock l(&lock_);
+  return entries_.size();
+}
+
+void AclCounterCache::Store(const std::vector<std::string>& keys,
+                            std::vector<CounterValues> values,
+                            absl::Time fetch_time) {
+  for (int i = 0; i < keys.size(); ++i) {
+    auto entry = entries_.find(keys[i]);
+    if (entry == entries_.end() || entry->second.fetch_time > fetch_time) {
+      continue;
+    }
+    entry->second.values = std::move(values[i]);
+    entry->second.fetch_time = fetch_time;
+  }
+}
+
+}  // namespace p4rt_app
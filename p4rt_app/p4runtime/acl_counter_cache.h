@@ -0,0 +1,103 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PINS_P4RT_APP_P4RUNTIME_ACL_COUNTER_CACHE_H_
+#define PINS_P4RT_APP_P4RUNTIME_ACL_COUNTER_CACHE_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace p4rt_app {
+
+// Counter data of ACL entries, as fetched from the CountersDB, kept in memory
+// so that frequent counter reads do not each go to Redis.
+//
+// The cache is demand driven: a key is only cached once it has been read, and
+// it is only refreshed by Refresh() while it keeps being read. Reads are served
+// from memory while the data is at most `max_staleness` old. Anything older,
+// or never fetched, is fetched in one batch by the reader.
+//
+// Thread-safe. The cache's lock is never held while fetching.
+class AclCounterCache {
+ public:
+  // The field/value pairs of a CountersDB entry.
+  using CounterValues = std::vector<std::pair<std::string, std::string>>;
+
+  // Fetches the CountersDB entries of the keys with one batched request.
+  // Returns one result per key, in order.
+  using BatchFetch =
+      absl::FunctionRef<absl::StatusOr<std::vector<CounterValues>>(
+          const std::vector<std::string>& counter_db_keys)>;
+
+  struct Lookup {
+    // The counter data of each requested key, in order.
+    std::vector<CounterValues> values;
+    // When the oldest of the returned values was fetched.
+    absl::Time fetch_time = absl::InfiniteFuture();
+  };
+
+  // Keys that are not read for `idle_timeout` are no longer refreshed, and are
+  // dropped from the cache.
+  AclCounterCache(absl::Duration max_staleness, absl::Duration idle_timeout)
+      : max_staleness_(max_staleness), idle_timeout_(idle_timeout) {}
+
+  // Returns the counter data of every key. Keys without fresh data are fetched
+  // with a single call to `fetch`.
+  absl::StatusOr<Lookup> Get(const std::vector<std::string>& counter_db_keys,
+                             BatchFetch fetch, absl::Time now = absl::Now())
+      ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Re-fetches, with a single call to `fetch`, every key that has been read
+  // within the idle timeout, and drops the rest. Meant to be called
+  // periodically, at an interval below `max_staleness`, so that reads find
+  // fresh data.
+  absl::Status Refresh(BatchFetch fetch, absl::Time now = absl::Now())
+      ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Number of keys in the cache.
+  int size() const ABSL_LOCKS_EXCLUDED(lock_);
+
+  absl::Duration max_staleness() const { return max_staleness_; }
+
+ private:
+  struct Entry {
+    CounterValues values;
+    absl::Time fetch_time = absl::InfinitePast();
+    absl::Time last_read_time = absl::InfinitePast();
+  };
+
+  // Stores fetched values unless the key already holds newer ones (e.g. a
+  // reader and the poller raced).
+  void Store(const std::vector<std::string>& keys,
+             std::vector<CounterValues> values, absl::Time fetch_time)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const absl::Duration max_staleness_;
+  const absl::Duration idle_timeout_;
+
+  mutable absl::Mutex lock_;
+  absl::flat_hash_map<std::string, Entry> entries_ ABSL_GUARDED_BY(lock_);
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_P4RUNTIME_ACL_COUNTER_CACHE_H_
@@ -0,0 +1,193 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/p4runtime/acl_counter_cache.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+using CounterValues = AclCounterCache::CounterValues;
+
+// Serves every key with a packet count of `packets`, and records the batches
+// it was asked for.
+class FakeCountersDb {
+ public:
+  absl::StatusOr<std::vector<CounterValues>> Fetch(
+      const std::vector<std::string>& keys) {
+    batches_.push_back(keys);
+    return std::vector<CounterValues>(
+        keys.size(), CounterValues{{"packets", std::to_string(packets_)}});
+  }
+
+  void set_packets(int packets) { packets_ = packets; }
+  const std::vector<std::vector<std::string>>& batches() const {
+    return batches_;
+  }
+
+ private:
+  int packets_ = 0;
+  std::vector<std::vector<std::string>> batches_;
+};
+
+constexpr absl::Time kStart = absl::FromUnixSeconds(1000);
+
+TEST(AclCounterCacheTest, FetchesMissingKeysInOneBatch) {
+  AclCounterCache cache(absl::Seconds(5), absl::Minutes(1));
+  FakeCountersDb counters_db;
+  auto fetch = [&](const std::vector<std::string>& keys) {
+    return counters_db.Fetch(keys);
+  };
+  counters_db.set_packets(7);
+
+  ASSERT_OK_AND_ASSIGN(AclCounterCache::Lookup lookup,
+                       cache.Get({"a", "b"}, fetch, kStart));
+  EXPECT_THAT(lookup.values,
+              ElementsAre(ElementsAre(Pair("packets", "7")),
+                          ElementsAre(Pair("packets", "7"))));
+  EXPECT_EQ(lookup.fetch_time, kStart);
+  EXPECT_THAT(counters_db.batches(), ElementsAre(ElementsAre("a", "b")));
+}
+
+TEST(AclCounterCacheTest, ServesFreshDataFromMemory) {
+  AclCounterCache cache(absl::Seconds(5), absl::Minutes(1));
+  FakeCountersDb counters_db;
+  auto fetch = [&](const std::vector<std::string>& keys) {
+    return counters_db.Fetch(keys);
+  };
+  counters_db.set_packets(7);
+  ASSERT_OK(cache.Get({"a"}, fetch, kStart).status());
+
+  counters_db.set_packets(8);
+  ASSERT_OK_AND_ASSIGN(AclCounterCache::Lookup lookup,
+                       cache.Get({"a"}, fetch, kStart + absl::Seconds(5)));
+  EXPECT_THAT(lookup.values, ElementsAre(ElementsAre(Pair("packets", "7"))));
+  EXPECT_EQ(lookup.fetch_time, kStart);
+  EXPECT_EQ(counters_db.batches().size(), 1);
+}
+
+TEST(AclCounterCacheTest, RefetchesOnlyStaleKeys) {
+  AclCounterCache cache(absl::Seconds(5), absl::Minutes(1));
+  FakeCountersDb counters_db;
+  auto fetch = [&](const std::vector<std::string>& keys) {
+    return counters_db.Fetch(keys);
+  };
+  ASSERT_OK(cache.Get({"a"}, fetch, kStart).status());
+  ASSERT_OK(cache.Get({"b"}, fetch, kStart + absl::Seconds(3)).status());
+
+  counters_db.set_packets(9);
+  const absl::Time now = kStart + absl::Seconds(6);
+  ASSERT_OK_AND_ASSIGN(AclCounterCache::Lookup lookup,
+                       cache.Get({"a", "b"}, fetch, now));
+  EXPECT_THAT(lookup.values,
+              ElementsAre(ElementsAre(Pair("packets", "9")),
+                          ElementsAre(Pair("packets", "0"))));
+  // The oldest data served is reported.
+  EXPECT_EQ(lookup.fetch_time, kStart + absl::Seconds(3));
+  EXPECT_THAT(counters_db.batches().back(), ElementsAre("a"));
+}
+
+TEST(AclCounterCacheTest, RefreshUpdatesRecentlyReadKeys) {
+  AclCounterCache cache(absl::Seconds(5), absl::Minutes(1));
+  FakeCountersDb counters_db;
+  auto fetch = [&](const std::vector<std::string>& keys) {
+    return counters_db.Fetch(keys);
+  };
+  ASSERT_OK(cache.Get({"a", "b"}, fetch, kStart).status());
+
+  counters_db.set_packets(3);
+  ASSERT_OK(cache.Refresh(fetch, kStart + absl::Seconds(4)));
+  EXPECT_THAT(counters_db.batches().back(), UnorderedElementsAre("a", "b"));
+
+  // Reads after the refresh are served from memory.
+  ASSERT_OK_AND_ASSIGN(AclCounterCache::Lookup lookup,
+                       cache.Get({"a"}, fetch, kStart + absl::Seconds(8)));
+  EXPECT_THAT(lookup.values, ElementsAre(ElementsAre(Pair("packets", "3"))));
+  EXPECT_EQ(counters_db.batches().size(), 2);
+}
+
+TEST(AclCounterCacheTest, RefreshDropsIdleKeys) {
+  AclCounterCache cache(absl::Seconds(5), absl::Minutes(1));
+  FakeCountersDb counters_db;
+  auto fetch = [&](const std::vector<std::string>& keys) {
+    return counters_db.Fetch(keys);
+  };
+  ASSERT_OK(cache.Get({"a"}, fetch, kStart).status());
+  ASSERT_OK(cache.Get({"b"}, fetch, kStart + absl::Seconds(30)).status());
+
+  ASSERT_OK(cache.Refresh(fetch, kStart + absl::Seconds(61)));
+  EXPECT_THAT(counters_db.batches().back(), ElementsAre("b"));
+  EXPECT_EQ(cache.size(), 1);
+
+  // Nothing is fetched once every key is idle.
+  ASSERT_OK(cache.Refresh(fetch, kStart + absl::Minutes(5)));
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(counters_db.batches().size(), 3);
+}
+
+TEST(AclCounterCacheTest, ReturnsFetchErrors) {
+  AclCounterCache cache(absl::Seconds(5), absl::Minutes(1));
+  EXPECT_THAT(
+      cache.Get(
+          {"a"},
+          [](const std::vector<std::string>&)
+              -> absl::StatusOr<std::vector<CounterValues>> {
+            return absl::UnavailableError("no redis");
+          },
+          kStart),
+      StatusIs(absl::StatusCode::kUnavailable));
+}
+
+TEST(AclCounterCacheTest, RejectsWrongNumberOfResults) {
+  AclCounterCache cache(absl::Seconds(5), absl::Minutes(1));
+  EXPECT_THAT(
+      cache.Get(
+          {"a", "b"},
+          [](const std::vector<std::string>&)
+              -> absl::StatusOr<std::vector<CounterValues>> {
+            return std::vector<CounterValues>(1);
+          },
+          kStart),
+      StatusIs(absl::StatusCode::kInternal));
+}
+
+TEST(AclCounterCacheTest, EmptyReadFetchesNothing) {
+  AclCounterCache cache(absl::Seconds(5), absl::Minutes(1));
+  FakeCountersDb counters_db;
+  auto fetch = [&](const std::vector<std::string>& keys) {
+    return counters_db.Fetch(keys);
+  };
+  ASSERT_OK_AND_ASSIGN(AclCounterCache::Lookup lookup,
+                       cache.Get({}, fetch, kStart));
+  EXPECT_THAT(lookup.values, IsEmpty());
+  EXPECT_EQ(lookup.fetch_time, absl::InfiniteFuture());
+  EXPECT_THAT(counters_db.batches(), IsEmpty());
+}
+
+}  // namespace
+}  // namespace p4rt_app
@@ -0,0 +1,457 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/p4runtime/constraint_plan.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/container/inlined_vector.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "glog/logging.h"
+#include "gutil/status.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_constraints/ast.pb.h"
+#include "p4_constraints/backend/constraint_info.h"
+#include "p4_constraints/backend/interpreter.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::p4_constraints::ast::BinaryOperator;
+using ::p4_constraints::ast::Expression;
+using ::p4_constraints::ast::Type;
+using ::p4::config::v1::MatchField;
+using Value = ConstraintPlan::Value;
+using Op = ConstraintPlan::Op;
+
+constexpr int kMaxBitwidth = 128;
+
+absl::uint128 AllOnes(int bitwidth) {
+  if (bitwidth >= kMaxBitwidth) return absl::Uint128Max();
+  return (absl::uint128(1) << bitwidth) - 1;
+}
+
+// Returns nullopt if the value does not fit in 128 bits.
+std::optional<absl::uint128> BytesToUint128(const std::string& bytes) {
+  absl::uint128 result = 0;
+  int significant_bytes = 0;
+  for (char c : bytes) {
+    uint8_t byte = static_cast<uint8_t>(c);
+    if (significant_bytes == 0 && byte == 0) continue;
+    if (++significant_bytes > kMaxBitwidth / 8) return std::nullopt;
+    result = (result << 8) | byte;
+  }
+  return result;
+}
+
+class Compiler {
+ public:
+  Compiler(const pdpi::IrTableDefinition& table,
+           ConstraintPlan::Program& program)
+      : table_(table), program_(program) {}
+
+  absl::Status Compile(const Expression& expr) {
+    switch (expr.expression_case()) {
+      case Expression::kBooleanConstant:
+        Emit({.op = Op::kConstant,
+              .constant = {.value = expr.boolean_constant() ? 1u : 0u}});
+        return absl::OkStatus();
+      case Expression::kIntegerConstant: {
+        absl::uint128 value;
+        if (!absl::SimpleAtoi(expr.integer_constant(), &value)) {
+          return gutil::UnimplementedErrorBuilder()
+                 << "Integer constant '" << expr.integer_constant()
+                 << "' is negative or wider than 128 bits.";
+        }
+        Emit({.op = Op::kConstant, .constant = {.value = value}});
+        return absl::OkStatus();
+      }
+      case Expression::kKey: {
+        ASSIGN_OR_RETURN(int slot, SlotForKey(expr.key()));
+        Emit({.op = Op::kKey, .arg = slot});
+        return absl::OkStatus();
+      }
+      case Expression::kFieldAccess:
+        return CompileFieldAccess(expr);
+      case Expression::kTypeCast:
+        return CompileTypeCast(expr);
+      case Expression::kBooleanNegation:
+        RETURN_IF_ERROR(Compile(expr.boolean_negation()));
+        Emit({.op = Op::kNot});
+        return absl::OkStatus();
+      case Expression::kBinaryExpression:
+        return CompileBinaryExpression(expr);
+      default:
+        return gutil::UnimplementedErrorBuilder()
+               << "Unsupported expression: " << expr.ShortDebugString();
+    }
+  }
+
+ private:
+  void Emit(ConstraintPlan::Instruction instruction) {
+    program_.instructions.push_back(std::move(instruction));
+  }
+
+  absl::StatusOr<int> SlotForKey(const std::string& name) {
+    auto field = table_.match_fields_by_name().find(name);
+    if (field == table_.match_fields_by_name().end()) {
+      return gutil::UnimplementedErrorBuilder()
+             << "Unknown match field '" << name << "'.";
+    }
+    const MatchField& match_field = field->second.match_field();
+    if (auto slot = program_.slot_by_match_field_id.find(match_field.id());
+        slot != program_.slot_by_match_field_id.end()) {
+      return slot->second;
+    }
+    if (match_field.bitwidth() <= 0 ||
+        match_field.bitwidth() > kMaxBitwidth) {
+      return gutil::UnimplementedErrorBuilder()
+             << "Match field '" << name << "' has unsupported bitwidth "
+             << match_field.bitwidth() << ".";
+    }
+
+    ConstraintPlan::KeySlot slot{.match_field_id = match_field.id(),
+                                 .match_type = match_field.match_type(),
+                                 .bitwidth = match_field.bitwidth()};
+    switch (match_field.match_type()) {
+      case MatchField::EXACT:
+        slot.required = true;
+        break;
+      case MatchField::TERNARY:
+      case MatchField::OPTIONAL:
+      case MatchField::LPM:
+        // Omitted fields are wildcards: a zero mask or prefix length.
+        break;
+      case MatchField::RANGE:
+        slot.default_value.aux = AllOnes(match_field.bitwidth());
+        break;
+      default:
+        return gutil::UnimplementedErrorBuilder()
+               << "Match field '" << name << "' has an unsupported type.";
+    }
+    int index = program_.slots.size();
+    program_.slots.push_back(slot);
+    program_.slot_by_match_field_id[match_field.id()] = index;
+    return index;
+  }
+
+  absl::Status CompileFieldAccess(const Expression& expr) {
+    const Expression& key = expr.field_access().expr();
+    if (key.expression_case() != Expression::kKey) {
+      return gutil::UnimplementedErrorBuilder()
+             << "Field access is only supported on keys: "
+             << expr.ShortDebugString();
+    }
+    ASSIGN_OR_RETURN(int slot, SlotForKey(key.key()));
+    Emit({.op = Op::kKey, .arg = slot});
+
+    const std::string& field = expr.field_access().field();
+    switch (program_.slots[slot].match_type) {
+      case MatchField::EXACT:
+        if (field == "value") {
+          Emit({.op = Op::kSelectValue});
+          return absl::OkStatus();
+        }
+        break;
+      case MatchField::TERNARY:
+      case MatchField::OPTIONAL:
+        if (field == "value" || field == "mask") {
+          Emit({.op = field == "value" ? Op::kSelectValue : Op::kSelectAux});
+          return absl::OkStatus();
+        }
+        break;
+      case MatchField::LPM:
+        if (field == "value" || field == "prefix_length") {
+          Emit({.op = field == "value" ? Op::kSelectValue : Op::kSelectAux});
+          return absl::OkStatus();
+        }
+        break;
+      case MatchField::RANGE:
+        if (field == "low" || field == "high") {
+          Emit({.op = field == "low" ? Op::kSelectValue : Op::kSelectAux});
+          return absl::OkStatus();
+        }
+        break;
+      default:
+        break;
+    }
+    return gutil::UnimplementedErrorBuilder()
+           << "Unsupported field access: " << expr.ShortDebugString();
+  }
+
+  absl::Status CompileTypeCast(const Expression& expr) {
+    const Expression& inner = expr.type_cast();
+    RETURN_IF_ERROR(Compile(inner));
+    if (expr.type().type_case() == Type::kFixedUnsigned) {
+      int bitwidth = expr.type().fixed_unsigned().bitwidth();
+      if (bitwidth > kMaxBitwidth) {
+        return gutil::UnimplementedErrorBuilder()
+               << "Cast to unsupported bitwidth " << bitwidth << ".";
+      }
+      Emit({.op = Op::kTruncate, .mask = AllOnes(bitwidth)});
+      return absl::OkStatus();
+    }
+
+    // Casts to match field types are always from bit<W>.
+    if (inner.type().type_case() != Type::kFixedUnsigned) {
+      return gutil::UnimplementedErrorBuilder()
+             << "Unsupported cast: " << expr.ShortDebugString();
+    }
+    int bitwidth = inner.type().fixed_unsigned().bitwidth();
+    switch (expr.type().type_case()) {
+      case Type::kExact:
+        return absl::OkStatus();
+      case Type::kTernary:
+      case Type::kOptionalMatch:
+        Emit({.op = Op::kSetAux, .mask = AllOnes(bitwidth)});
+        return absl::OkStatus();
+      case Type::kLpm:
+        Emit({.op = Op::kSetAux, .mask = absl::uint128(bitwidth)});
+        return absl::OkStatus();
+      case Type::kRange:
+        Emit({.op = Op::kCopyToAux});
+        return absl::OkStatus();
+      default:
+        return gutil::UnimplementedErrorBuilder()
+               << "Unsupported cast: " << expr.ShortDebugString();
+    }
+  }
+
+  absl::Status CompileBinaryExpression(const Expression& expr) {
+    Op op;
+    switch (expr.binary_expression().binop()) {
+      case BinaryOperator::EQ:
+        op = Op::kEq;
+        break;
+      case BinaryOperator::NE:
+        op = Op::kNe;
+        break;
+      case BinaryOperator::LT:
+        op = Op::kLt;
+        break;
+      case BinaryOperator::LE:
+        op = Op::kLe;
+        break;
+      case BinaryOperator::GT:
+        op = Op::kGt;
+        break;
+      case BinaryOperator::GE:
+        op = Op::kGe;
+        break;
+      case BinaryOperator::AND:
+        op = Op::kAnd;
+        break;
+      case BinaryOperator::OR:
+        op = Op::kOr;
+        break;
+      case BinaryOperator::IMPLIES:
+        op = Op::kImplies;
+        break;
+      default:
+        return gutil::UnimplementedErrorBuilder()
+               << "Unsupported binary operator: " << expr.ShortDebugString();
+    }
+    RETURN_IF_ERROR(Compile(expr.binary_expression().left()));
+    RETURN_IF_ERROR(Compile(expr.binary_expression().right()));
+    Emit({.op = op});
+    return absl::OkStatus();
+  }
+
+  const pdpi::IrTableDefinition& table_;
+  ConstraintPlan::Program& program_;
+};
+
+// Reads the match field as it is seen by the constraint. Returns false if the
+// value cannot be represented.
+bool ReadMatchField(const p4::v1::FieldMatch& match,
+                    const ConstraintPlan::KeySlot& slot, Value& result) {
+  std::optional<absl::uint128> value;
+  std::optional<absl::uint128> aux = 0;
+  switch (slot.match_type) {
+    case MatchField::EXACT:
+      if (!match.has_exact()) return false;
+      value = BytesToUint128(match.exact().value());
+      break;
+    case MatchField::TERNARY:
+      if (!match.has_ternary()) return false;
+      value = BytesToUint128(match.ternary().value());
+      aux = BytesToUint128(match.ternary().mask());
+      break;
+    case MatchField::OPTIONAL:
+      if (!match.has_optional()) return false;
+      value = BytesToUint128(match.optional().value());
+      aux = AllOnes(slot.bitwidth);
+      break;
+    case MatchField::LPM:
+      if (!match.has_lpm()) return false;
+      value = BytesToUint128(match.lpm().value());
+      aux = match.lpm().prefix_len();
+      break;
+    case MatchField::RANGE:
+      if (!match.has_range()) return false;
+      value = BytesToUint128(match.range().low());
+      aux = BytesToUint128(match.range().high());
+      break;
+    default:
+      return false;
+  }
+  if (!value.has_value() || !aux.has_value()) return false;
+  result = Value{.value = *value, .aux = *aux};
+  return true;
+}
+
+}  // namespace
+
+ConstraintPlan::ConstraintPlan(const pdpi::IrP4Info& ir_p4_info,
+                               p4_constraints::ConstraintInfo constraint_info)
+    : constraint_info_(std::move(constraint_info)) {
+  for (const auto& [table_id, table_info] : constraint_info_) {
+    auto table = ir_p4_info.tables_by_id().find(table_id);
+    if (table == ir_p4_info.tables_by_id().end()) continue;
+
+    Program program;
+    if (!table_info.constraint.has_value()) {
+      program.instructions.push_back({.op = Op::kConstant,
+                                      .constant = {.value = 1}});
+    } else {
+      absl::Status status =
+          Compiler(table->second, program).Compile(*table_info.constraint);
+      if (!status.ok()) {
+        LOG(INFO) << "Constraints for table '"
+                  << table->second.preamble().alias()
+                  << "' are checked by the interpreter: " << status.message();
+        continue;
+      }
+    }
+    programs_by_table_id_[table_id] = std::move(program);
+  }
+}
+
+std::optional<bool> ConstraintPlan::Run(const Program& program,
+                                        const p4::v1::TableEntry& entry) {
+  absl::InlinedVector<Value, 16> keys;
+  absl::InlinedVector<bool, 16> present(program.slots.size(), false);
+  keys.reserve(program.slots.size());
+  for (const KeySlot& slot : program.slots) {
+    keys.push_back(slot.default_value);
+  }
+  for (const p4::v1::FieldMatch& match : entry.match()) {
+    auto slot = program.slot_by_match_field_id.find(match.field_id());
+    if (slot == program.slot_by_match_field_id.end()) continue;
+    if (!ReadMatchField(match, program.slots[slot->second],
+                        keys[slot->second])) {
+      return std::nullopt;
+    }
+    present[slot->second] = true;
+  }
+  for (size_t i = 0; i < program.slots.size(); ++i) {
+    if (program.slots[i].required && !present[i]) return std::nullopt;
+  }
+
+  absl::InlinedVector<Value, 16> stack;
+  for (const Instruction& instruction : program.instructions) {
+    switch (instruction.op) {
+      case Op::kConstant:
+        stack.push_back(instruction.constant);
+        continue;
+      case Op::kKey:
+        stack.push_back(keys[instruction.arg]);
+        continue;
+      case Op::kSelectValue:
+        stack.back().aux = 0;
+        continue;
+      case Op::kSelectAux:
+        stack.back() = Value{.value = stack.back().aux};
+        continue;
+      case Op::kTruncate:
+        stack.back().value &= instruction.mask;
+        continue;
+      case Op::kSetAux:
+        stack.back().aux = instruction.mask;
+        continue;
+      case Op::kCopyToAux:
+        stack.back().aux = stack.back().value;
+        continue;
+      case Op::kNot:
+        stack.back().value = stack.back().value == 0 ? 1 : 0;
+        continue;
+      default:
+        break;
+    }
+
+    // Everything else is a binary operator.
+    Value right = stack.back();
+    stack.pop_back();
+    Value& left = stack.back();
+    bool result = false;
+    switch (instruction.op) {
+      case Op::kEq:
+        result = left.value == right.value && left.aux == right.aux;
+        break;
+      case Op::kNe:
+        result = left.value != right.value || left.aux != right.aux;
+        break;
+      case Op::kLt:
+        result = left.value < right.value;
+        break;
+      case Op::kLe:
+        result = left.value <= right.value;
+        break;
+      case Op::kGt:
+        result = left.value > right.value;
+        break;
+      case Op::kGe:
+        result = left.value >= right.value;
+        break;
+      case Op::kAnd:
+        result = left.value != 0 && right.value != 0;
+        break;
+      case Op::kOr:
+        result = left.value != 0 || right.value != 0;
+        break;
+      case Op::kImplies:
+        result = left.value == 0 || right.value != 0;
+        break;
+      default:
+        return std::nullopt;
+    }
+    left = Value{.value = result ? 1u : 0u};
+  }
+  if (stack.size() != 1) return std::nullopt;
+  return stack.back().value != 0;
+}
+
+absl::StatusOr<std::string> ConstraintPlan::ReasonEntryViolatesConstraint(
+    const p4::v1::TableEntry& entry) const {
+  if (auto program = programs_by_table_id_.find(entry.table_id());
+      program != programs_by_table_id_.end()) {
+    std::optional<bool> satisfied = Run(program->second, entry);
+    if (satisfied.has_value() && *satisfied) return "";
+  }
+  // The interpreter explains violations, and handles everything the program
+  // could not.
+  return p4_constraints::ReasonEntryViolatesConstraint(entry,
+                                                       constraint_info_);
+}
+
+}  // namespace p4rt_app
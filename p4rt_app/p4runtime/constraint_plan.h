@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PINS_P4RT_APP_P4RUNTIME_CONSTRAINT_PLAN_H_
+#define PINS_P4RT_APP_P4RUNTIME_CONSTRAINT_PLAN_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/numeric/int128.h"
+#include "absl/status/statusor.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_constraints/backend/constraint_info.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace p4rt_app {
+
+// Checks table entries against the P4 constraints (i.e. @entry_restriction)
+// of their table. Each table's constraint is compiled once per P4Info into a
+// small stack program over the PI match values, so checking an entry does not
+// walk the constraint AST. The p4-constraints interpreter is still used to
+// explain violations, and for any constraint or entry the program cannot
+// handle (e.g. ::priority, or values wider than 128 bits).
+//
+// Thread-safe once constructed.
+class ConstraintPlan {
+ public:
+  ConstraintPlan(const pdpi::IrP4Info& ir_p4_info,
+                 p4_constraints::ConstraintInfo constraint_info);
+
+  // Returns an empty string if the entry meets its table's constraint, or a
+  // description of the violation. Returns an error if the entry could not be
+  // checked.
+  absl::StatusOr<std::string> ReasonEntryViolatesConstraint(
+      const p4::v1::TableEntry& entry) const;
+
+  // Returns true if entries for the table are checked without the
+  // interpreter.
+  bool IsCompiled(uint32_t table_id) const {
+    return programs_by_table_id_.contains(table_id);
+  }
+
+  const p4_constraints::ConstraintInfo& constraint_info() const {
+    return constraint_info_;
+  }
+
+  // A match field, constant, or intermediate result. Match fields keep both
+  // of their components: exact {value, 0}, ternary and optional {value, mask},
+  // LPM {value, prefix_length}, and range {low, high}. Scalars and booleans
+  // only use `value`.
+  struct Value {
+    absl::uint128 value = 0;
+    absl::uint128 aux = 0;
+  };
+
+  enum class Op : uint8_t {
+    kConstant,     // Push `constant`.
+    kKey,          // Push the match field in slot `arg`.
+    kSelectValue,  // Replace the top with its `value`.
+    kSelectAux,    // Replace the top with its `aux`.
+    kTruncate,     // Mask the top's `value` with `mask`.
+    kSetAux,       // Set the top's `aux` to `mask`.
+    kCopyToAux,    // Set the top's `aux` to its `value`.
+    kNot,
+    kEq,
+    kNe,
+    kLt,
+    kLe,
+    kGt,
+    kGe,
+    kAnd,
+    kOr,
+    kImplies,
+  };
+
+  struct Instruction {
+    Op op;
+    int arg = 0;
+    absl::uint128 mask = 0;
+    Value constant;
+  };
+
+  // A match field the program reads, with the value it has when omitted.
+  struct KeySlot {
+    uint32_t match_field_id = 0;
+    p4::config::v1::MatchField::MatchType match_type =
+        p4::config::v1::MatchField::UNSPECIFIED;
+    int bitwidth = 0;
+    Value default_value;
+    // Exact match fields cannot be omitted.
+    bool required = false;
+  };
+
+  struct Program {
+    std::vector<KeySlot> slots;
+    absl::flat_hash_map<uint32_t, int> slot_by_match_field_id;
+    std::vector<Instruction> instructions;
+  };
+
+ private:
+  // Returns nullopt if the program cannot decide, in which case the
+  // interpreter does.
+  static std::optional<bool> Run(const Program& program,
+                                 const p4::v1::TableEntry& entry);
+
+  p4_constraints::ConstraintInfo constraint_info_;
+  absl::flat_hash_map<uint32_t, Program> programs_by_table_id_;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_P4RUNTIME_CONSTRAINT_PLAN_H_
@@ -0,0 +1,146 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/p4runtime/constraint_plan.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_constraints/backend/constraint_info.h"
+#include "p4_constraints/backend/interpreter.h"
+#include "p4_pdpi/ir.pb.h"
+#include "sai_p4/instantiations/google/instantiations.h"
+#include "sai_p4/instantiations/google/sai_p4info.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::testing::IsEmpty;
+using ::testing::Not;
+
+class ConstraintPlanTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK_AND_ASSIGN(
+        constraint_info_,
+        p4_constraints::P4ToConstraintInfo(
+            sai::GetP4Info(sai::Instantiation::kMiddleblock)));
+  }
+
+  uint32_t TableId(const std::string& name) const {
+    return ir_p4info_.tables_by_name().at(name).preamble().id();
+  }
+
+  uint32_t MatchFieldId(const std::string& table, const std::string& field) {
+    return ir_p4info_.tables_by_name()
+        .at(table)
+        .match_fields_by_name()
+        .at(field)
+        .match_field()
+        .id();
+  }
+
+  // Returns an acl_ingress_table entry matching the given ternary fields.
+  p4::v1::TableEntry AclIngressEntry(
+      std::vector<std::pair<std::string, std::string>> ternary_values) {
+    p4::v1::TableEntry entry;
+    entry.set_table_id(TableId("acl_ingress_table"));
+    entry.set_priority(10);
+    for (const auto& [name, value] : ternary_values) {
+      p4::v1::FieldMatch* match = entry.add_match();
+      match->set_field_id(MatchFieldId("acl_ingress_table", name));
+      match->mutable_ternary()->set_value(value);
+      match->mutable_ternary()->set_mask(std::string(value.size(), '\xff'));
+    }
+    return entry;
+  }
+
+  void AddIsIpv4(p4::v1::TableEntry& entry) {
+    p4::v1::FieldMatch* match = entry.add_match();
+    match->set_field_id(MatchFieldId("acl_ingress_table", "is_ipv4"));
+    match->mutable_optional()->set_value("\x01");
+  }
+
+  // Expects the plan to agree with the p4-constraints interpreter.
+  void ExpectSameResultAsInterpreter(const ConstraintPlan& plan,
+                                     const p4::v1::TableEntry& entry,
+                                     bool violates) {
+    ASSERT_OK_AND_ASSIGN(
+        std::string expected,
+        p4_constraints::ReasonEntryViolatesConstraint(entry, constraint_info_));
+    ASSERT_OK_AND_ASSIGN(std::string actual,
+                         plan.ReasonEntryViolatesConstraint(entry));
+    EXPECT_EQ(actual, expected);
+    if (violates) {
+      EXPECT_THAT(actual, Not(IsEmpty()));
+    } else {
+      EXPECT_THAT(actual, IsEmpty());
+    }
+  }
+
+  pdpi::IrP4Info ir_p4info_ =
+      sai::GetIrP4Info(sai::Instantiation::kMiddleblock);
+  p4_constraints::ConstraintInfo constraint_info_;
+};
+
+TEST_F(ConstraintPlanTest, CompilesAclIngressTable) {
+  ConstraintPlan plan(ir_p4info_, constraint_info_);
+  EXPECT_TRUE(plan.IsCompiled(TableId("acl_ingress_table")));
+}
+
+TEST_F(ConstraintPlanTest, PriorityConstraintsAreLeftToTheInterpreter) {
+  ConstraintPlan plan(ir_p4info_, constraint_info_);
+  EXPECT_FALSE(plan.IsCompiled(TableId("acl_pre_ingress_table")));
+}
+
+TEST_F(ConstraintPlanTest, AcceptsEntryMeetingConstraints) {
+  ConstraintPlan plan(ir_p4info_, constraint_info_);
+
+  ExpectSameResultAsInterpreter(plan, AclIngressEntry({}), /*violates=*/false);
+
+  p4::v1::TableEntry entry = AclIngressEntry({{"dst_ip", "\x0a\x01\x02\x03"}});
+  AddIsIpv4(entry);
+  ExpectSameResultAsInterpreter(plan, entry, /*violates=*/false);
+
+  ExpectSameResultAsInterpreter(
+      plan, AclIngressEntry({{"ip_protocol", "\x06"}, {"l4_dst_port", "\x50"}}),
+      /*violates=*/false);
+}
+
+TEST_F(ConstraintPlanTest, RejectsEntryViolatingConstraints) {
+  ConstraintPlan plan(ir_p4info_, constraint_info_);
+
+  // IPv4 matches need is_ipv4.
+  ExpectSameResultAsInterpreter(
+      plan, AclIngressEntry({{"dst_ip", "\x0a\x01\x02\x03"}}),
+      /*violates=*/true);
+
+  // ether_type cannot be used for IP packets.
+  ExpectSameResultAsInterpreter(
+      plan, AclIngressEntry({{"ether_type", std::string("\x08\x00", 2)}}),
+      /*violates=*/true);
+
+  // L4 ports need TCP or UDP.
+  ExpectSameResultAsInterpreter(
+      plan, AclIngressEntry({{"ip_protocol", "\x01"}, {"l4_dst_port", "\x50"}}),
+      /*violates=*/true);
+}
+
+}  // namespace
+}  // namespace p4rt_app
@@ -15,9 +15,14 @@
  */
 #include "p4rt_app/p4runtime/cpu_queue_translator.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/string_view.h"
-#include "gutil/collections.h"
 #include "gutil/status.h"
 
 namespace p4rt_app {
@@ -25,6 +30,7 @@ namespace p4rt_app {
 absl::StatusOr<std::unique_ptr<CpuQueueTranslator>> CpuQueueTranslator::Create(
     const std::vector<std::pair<std::string, std::string>>& name_id_pairs) {
   std::unique_ptr<CpuQueueTranslator> translator = Empty();
+  translator->queues_.reserve(name_id_pairs.size());
   for (const auto& [name, id_string] : name_id_pairs) {
     int id;
     if (!absl::SimpleAtoi(id_string, &id)) {
@@ -32,25 +38,62 @@ absl::StatusOr<std::unique_ptr<CpuQueueTranslator>> CpuQueueTranslator::Create(
              << "Non-integer ID for Cpu Queue Name/ID pair: [" << name << " : "
              << id_string << "]";
     }
-    if (!translator->name_to_id_.insert_or_assign(name, id).second) {
+    if (translator->FindName(name) >= 0) {
       return gutil::InvalidArgumentErrorBuilder()
              << "Duplicate IDs found for CPU Queue Name '" << name << "'";
     }
-    if (!translator->id_to_name_.insert_or_assign(id, name).second) {
+    if (translator->FindId(id) >= 0) {
       return gutil::InvalidArgumentErrorBuilder()
              << "Duplicate Names found for CPU Queue ID '" << id << "'";
     }
+
+    const int index = translator->queues_.size();
+    translator->queues_.push_back({name, id});
+    if (id >= 0 && id < kMaxIndexedQueueId) {
+      if (id >= translator->queue_index_by_id_.size()) {
+        translator->queue_index_by_id_.resize(id + 1, -1);
+      }
+      translator->queue_index_by_id_[id] = index;
+    }
   }
   return translator;
 }
 
 absl::StatusOr<std::string> CpuQueueTranslator::IdToName(int queue_id) const {
-  return gutil::FindOrStatus(id_to_name_, queue_id);
+  const int index = FindId(queue_id);
+  if (index < 0) {
+    return gutil::NotFoundErrorBuilder()
+           << "CPU Queue ID '" << queue_id << "' does not exist.";
+  }
+  return queues_[index].first;
 }
 
 absl::StatusOr<int> CpuQueueTranslator::NameToId(
     absl::string_view queue_name) const {
-  return gutil::FindOrStatus(name_to_id_, queue_name);
+  const int index = FindName(queue_name);
+  if (index < 0) {
+    return gutil::NotFoundErrorBuilder()
+           << "CPU Queue Name '" << queue_name << "' does not exist.";
+  }
+  return queues_[index].second;
+}
+
+int CpuQueueTranslator::FindId(int queue_id) const {
+  if (queue_id >= 0 && queue_id < kMaxIndexedQueueId) {
+    if (queue_id >= queue_index_by_id_.size()) return -1;
+    return queue_index_by_id_[queue_id];
+  }
+  for (int i = 0; i < queues_.size(); ++i) {
+    if (queues_[i].second == queue_id) return i;
+  }
+  return -1;
+}
+
+int CpuQueueTranslator::FindName(absl::string_view queue_name) const {
+  for (int i = 0; i < queues_.size(); ++i) {
+    if (queues_[i].first == queue_name) return i;
+  }
+  return -1;
 }
 
 }  // namespace p4rt_app
@@ -18,15 +18,18 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
-#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 namespace p4rt_app {
 
 // CpuQueueTranslator is an immutable bidirectional map that translates between
-// CPU queue name (string) and ID (int).
+// CPU queue name (string) and ID (int). A switch only has a handful of CPU
+// queues, so the queues are kept in small arrays instead of hash maps: names are
+// found with a linear scan, and IDs are looked up directly by index.
 class CpuQueueTranslator {
  public:
   // Create a translator for the provided name and ID pairs.
@@ -48,8 +51,20 @@ class CpuQueueTranslator {
   CpuQueueTranslator() = default;
 
  private:
-  absl::flat_hash_map<int, std::string> id_to_name_;
-  absl::flat_hash_map<std::string, int> name_to_id_;
+  // Queue IDs in [0, kMaxIndexedQueueId) are looked up by index. Any other ID
+  // falls back to scanning `queues_`.
+  static constexpr int kMaxIndexedQueueId = 1024;
+
+  // Returns the index of the queue in `queues_`, or -1 if it does not exist.
+  int FindId(int queue_id) const;
+  int FindName(absl::string_view queue_name) const;
+
+  // Every {name, ID} pair, in the order they were created.
+  std::vector<std::pair<std::string, int>> queues_;
+
+  // Maps a queue ID to its index in `queues_`, or -1 if the ID is not used.
+  // Only covers IDs up to the largest indexed ID in use.
+  std::vector<int> queue_index_by_id_;
 };
 
 }  // namespace p4rt_app
@@ -139,5 +139,30 @@ TEST(CpuQueueTranslator, CanTranslateNameToId) {
   EXPECT_THAT(translator->NameToId("c"), IsOkAndHolds(3));
 }
 
+TEST(CpuQueueTranslator, CanTranslateSparseAndLargeIds) {
+  ASSERT_OK_AND_ASSIGN(auto translator, CpuQueueTranslator::Create({
+                                            {"low", "0"},
+                                            {"gap", "40"},
+                                            {"large", "100000"},
+                                            {"negative", "-1"},
+                                        }));
+  EXPECT_THAT(*translator, HasBidirectionalTranslation(0, "low"));
+  EXPECT_THAT(*translator, HasBidirectionalTranslation(40, "gap"));
+  EXPECT_THAT(*translator, HasBidirectionalTranslation(100000, "large"));
+  EXPECT_THAT(*translator, HasBidirectionalTranslation(-1, "negative"));
+  EXPECT_THAT(*translator, LacksIdToNameTranslation(1));
+  EXPECT_THAT(*translator, LacksIdToNameTranslation(41));
+  EXPECT_THAT(*translator, LacksIdToNameTranslation(99999));
+  EXPECT_THAT(*translator, LacksNameToIdTranslation("missing"));
+}
+
+TEST(CpuQueueTranslator, CreateFailsForRepeatedLargeQueueId) {
+  EXPECT_THAT(CpuQueueTranslator::Create({
+                  {"b", "5000"},
+                  {"c", "5000"},
+              }),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 }  // namespace
 }  // namespace p4rt_app
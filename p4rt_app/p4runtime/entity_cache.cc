@@ -0,0 +1,315 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "p4rt_app/p4runtime/entity_cache.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "glog/logging.h"
+#include "gutil/collections.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+
+namespace p4rt_app {
+namespace {
+
+// 64-bit FNV-1a of a serialized entity. Unlike absl::Hash the result is stable
+// across processes, so fingerprints can be compared after a restart.
+uint64_t EntityDigest(absl::string_view serialized) {
+  constexpr uint64_t kFnvPrime = 0x100000001b3;
+  uint64_t hash = 0xcbf29ce484222325;
+  for (char c : serialized) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+}  // namespace
+
+EntityCache::EntityCache(EntityMap entities, AppDbKeyMap app_db_keys) {
+  entities_.reserve(entities.size());
+  for (const auto& [key, entity] : entities) {
+    AddToIndex(key, entity);
+    UpdateActionSetUsage(key, entity);
+    entity.SerializeToString(&entities_[key]);
+  }
+  for (auto& [key, app_db_key] : app_db_keys) {
+    if (!entities_.contains(key) || app_db_key.empty()) continue;
+    app_db_keys_[key] = std::move(app_db_key);
+  }
+  for (const auto& [key, entity] : entities) {
+    UpdateFootprint(key, entity, entities_[key], /*sign=*/1);
+  }
+}
+
+std::optional<p4::v1::Entity> EntityCache::Find(
+    const pdpi::EntityKey& key) const {
+  auto iter = entities_.find(key);
+  if (iter == entities_.end()) return std::nullopt;
+  p4::v1::Entity entity;
+  if (absl::Status status = Parse(key, iter->second, entity); !status.ok()) {
+    LOG(ERROR) << status;
+    return std::nullopt;
+  }
+  return entity;
+}
+
+const std::string* EntityCache::FindAppDbKey(
+    const pdpi::EntityKey& key) const {
+  return gutil::FindOrNull(app_db_keys_, key);
+}
+
+const EntityCache::ActionSetUsage* EntityCache::FindActionSetUsage(
+    const pdpi::EntityKey& key) const {
+  return gutil::FindOrNull(action_set_usage_, key);
+}
+
+void EntityCache::InsertOrAssign(const pdpi::EntityKey& key,
+                                 p4::v1::Entity entity,
+                                 std::string app_db_key) {
+  // A MODIFY can never change the table ID, or entity type, because they are
+  // part of the key. So an existing entry is already indexed correctly.
+  auto [iter, inserted] = entities_.try_emplace(key);
+  if (inserted) {
+    AddToIndex(iter->first, entity);
+  } else {
+    UpdateFootprint(iter->first, entity, iter->second, /*sign=*/-1);
+  }
+  UpdateActionSetUsage(iter->first, entity);
+  entity.SerializeToString(&iter->second);
+
+  if (app_db_key.empty()) {
+    app_db_keys_.erase(key);
+  } else {
+    app_db_keys_.insert_or_assign(key, std::move(app_db_key));
+  }
+  UpdateFootprint(iter->first, entity, iter->second, /*sign=*/1);
+}
+
+void EntityCache::Erase(const pdpi::EntityKey& key) {
+  auto iter = entities_.find(key);
+  if (iter == entities_.end()) return;
+  p4::v1::Entity entity;
+  if (absl::Status status = Parse(key, iter->second, entity); !status.ok()) {
+    LOG(ERROR) << status;
+  }
+  RemoveFromIndex(iter->first, entity);
+  UpdateFootprint(iter->first, entity, iter->second, /*sign=*/-1);
+  app_db_keys_.erase(iter->first);
+  action_set_usage_.erase(iter->first);
+  entities_.erase(iter);
+}
+
+absl::Status EntityCache::ForEachEntity(
+    absl::FunctionRef<absl::Status(const pdpi::EntityKey&,
+                                   const p4::v1::Entity&)>
+        visit) const {
+  p4::v1::Entity entity;
+  for (const auto& [key, serialized] : entities_) {
+    RETURN_IF_ERROR(Parse(key, serialized, entity));
+    RETURN_IF_ERROR(visit(key, entity));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status EntityCache::ForEachTableEntry(
+    uint32_t table_id,
+    absl::FunctionRef<absl::Status(const pdpi::EntityKey&,
+                                   const p4::v1::TableEntry&)>
+        visit) const {
+  p4::v1::Entity entity;
+  return ForEachSerializedTableEntry(
+      table_id,
+      [&](const pdpi::EntityKey& key, uint32_t,
+          absl::string_view serialized) -> absl::Status {
+        RETURN_IF_ERROR(Parse(key, serialized, entity));
+        return visit(key, entity.table_entry());
+      });
+}
+
+absl::Status EntityCache::ForEachEntityOfType(
+    p4::v1::Entity::EntityCase entity_type,
+    absl::FunctionRef<absl::Status(const p4::v1::Entity&)> visit) const {
+  p4::v1::Entity entity;
+  return ForEachSerializedEntityOfType(
+      entity_type, [&](absl::string_view serialized) -> absl::Status {
+        if (!entity.ParseFromArray(serialized.data(), serialized.size())) {
+          return gutil::InternalErrorBuilder()
+                 << "Could not parse a cached entity of type " << entity_type;
+        }
+        return visit(entity);
+      });
+}
+
+absl::Status EntityCache::ForEachSerializedTableEntry(
+    uint32_t table_id,
+    absl::FunctionRef<absl::Status(const pdpi::EntityKey&, uint32_t,
+                                   absl::string_view)>
+        visit) const {
+  if (table_id == 0) {
+    for (const auto& [id, keys] : table_entry_keys_by_table_id_) {
+      RETURN_IF_ERROR(ForEachSerializedTableEntry(id, visit));
+    }
+    return absl::OkStatus();
+  }
+
+  const auto* keys = gutil::FindOrNull(table_entry_keys_by_table_id_, table_id);
+  if (keys == nullptr) return absl::OkStatus();
+  for (const pdpi::EntityKey& key : *keys) {
+    const std::string* serialized = gutil::FindOrNull(entities_, key);
+    if (serialized == nullptr) {
+      return gutil::InternalErrorBuilder()
+             << "Entity cache index is out of sync for table " << table_id
+             << " with key: " << key;
+    }
+    RETURN_IF_ERROR(visit(key, table_id, *serialized));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status EntityCache::ForEachSerializedEntityOfType(
+    p4::v1::Entity::EntityCase entity_type,
+    absl::FunctionRef<absl::Status(absl::string_view)> visit) const {
+  std::vector<const absl::flat_hash_set<pdpi::EntityKey>*> key_sets;
+  if (entity_type == p4::v1::Entity::kTableEntry) {
+    for (const auto& [_, keys] : table_entry_keys_by_table_id_) {
+      key_sets.push_back(&keys);
+    }
+  } else if (const auto* keys =
+                 gutil::FindOrNull(keys_by_entity_type_, entity_type);
+             keys != nullptr) {
+    key_sets.push_back(keys);
+  }
+
+  for (const auto* keys : key_sets) {
+    for (const pdpi::EntityKey& key : *keys) {
+      const std::string* serialized = gutil::FindOrNull(entities_, key);
+      if (serialized == nullptr) {
+        return gutil::InternalErrorBuilder()
+               << "Entity cache index is out of sync for entity type "
+               << entity_type << " with key: " << key;
+      }
+      RETURN_IF_ERROR(visit(*serialized));
+    }
+  }
+  return absl::OkStatus();
+}
+
+int EntityCache::TableEntryCount(uint32_t table_id) const {
+  const auto* keys = gutil::FindOrNull(table_entry_keys_by_table_id_, table_id);
+  return keys == nullptr ? 0 : keys->size();
+}
+
+absl::Status EntityCache::Parse(const pdpi::EntityKey& key,
+                                absl::string_view serialized,
+                                p4::v1::Entity& entity) const {
+  if (!entity.ParseFromArray(serialized.data(), serialized.size())) {
+    return gutil::InternalErrorBuilder()
+           << "Could not parse the cached entity for key: " << key;
+  }
+  return absl::OkStatus();
+}
+
+void EntityCache::AddToIndex(const pdpi::EntityKey& key,
+                             const p4::v1::Entity& entity) {
+  if (entity.entity_case() == p4::v1::Entity::kTableEntry) {
+    table_entry_keys_by_table_id_[entity.table_entry().table_id()].insert(key);
+  } else {
+    keys_by_entity_type_[entity.entity_case()].insert(key);
+  }
+}
+
+void EntityCache::RemoveFromIndex(const pdpi::EntityKey& key,
+                                  const p4::v1::Entity& entity) {
+  if (entity.entity_case() == p4::v1::Entity::kTableEntry) {
+    auto iter =
+        table_entry_keys_by_table_id_.find(entity.table_entry().table_id());
+    if (iter == table_entry_keys_by_table_id_.end()) return;
+    iter->second.erase(key);
+    if (iter->second.empty()) table_entry_keys_by_table_id_.erase(iter);
+  } else {
+    auto iter = keys_by_entity_type_.find(entity.entity_case());
+    if (iter == keys_by_entity_type_.end()) return;
+    iter->second.erase(key);
+    if (iter->second.empty()) keys_by_entity_type_.erase(iter);
+  }
+}
+
+void EntityCache::UpdateFootprint(const pdpi::EntityKey& key,
+                                  const p4::v1::Entity& entity,
+                                  const std::string& serialized, int sign) {
+  // Every entity has a slot in entities_, and in one of the indices.
+  constexpr int64_t kSlotBytes =
+      2 * sizeof(pdpi::EntityKey) + sizeof(std::string);
+  int64_t bytes = kSlotBytes + serialized.size();
+  if (const std::string* app_db_key = FindAppDbKey(key);
+      app_db_key != nullptr) {
+    bytes += sizeof(pdpi::EntityKey) + sizeof(std::string) +
+             app_db_key->size();
+  }
+  if (action_set_usage_.contains(key)) {
+    bytes += sizeof(pdpi::EntityKey) + sizeof(ActionSetUsage);
+  }
+
+  auto update = [&](Footprint& footprint) {
+    footprint.entries += sign;
+    footprint.bytes += sign * bytes;
+  };
+  update(footprint_);
+  update(footprint_by_entity_type_[entity.entity_case()]);
+  // Unsigned arithmetic wraps around, so removing an entity exactly undoes
+  // adding it.
+  fingerprint_ += static_cast<uint64_t>(sign) * EntityDigest(serialized);
+  if (entity.has_table_entry()) {
+    update(footprint_by_table_id_[entity.table_entry().table_id()]);
+  }
+  if (sign < 0) {
+    if (footprint_by_entity_type_[entity.entity_case()].entries == 0) {
+      footprint_by_entity_type_.erase(entity.entity_case());
+    }
+    if (entity.has_table_entry() &&
+        footprint_by_table_id_[entity.table_entry().table_id()].entries == 0) {
+      footprint_by_table_id_.erase(entity.table_entry().table_id());
+    }
+  }
+}
+
+void EntityCache::UpdateActionSetUsage(const pdpi::EntityKey& key,
+                                       const p4::v1::Entity& entity) {
+  if (!entity.table_entry().action().has_action_profile_action_set()) {
+    action_set_usage_.erase(key);
+    return;
+  }
+  ActionSetUsage usage;
+  for (const p4::v1::ActionProfileAction& action :
+       entity.table_entry()
+           .action()
+           .action_profile_action_set()
+           .action_profile_actions()) {
+    ++usage.number_of_actions;
+    usage.total_weight += action.weight();
+  }
+  action_set_usage_.insert_or_assign(key, usage);
+}
+
+}  // namespace p4rt_app
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PINS_P4RT_APP_P4RUNTIME_ENTITY_CACHE_H_
+#define PINS_P4RT_APP_P4RUNTIME_ENTITY_CACHE_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+
+namespace p4rt_app {
+
+// The EntityCache holds every entity that has been successfully programmed
+// into the lower layers. Alongside the entities it maintains a per-table (and
+// per-entity-type) index so that requests scoped to a single table only
+// need to visit the entries in that table.
+//
+// Entities are stored in their serialized PI form, which is a fraction of the
+// size of the parsed protos, and parsed again when they are looked up or
+// visited. Reads can also visit the serialized form directly, and copy it into
+// a response without parsing it at all.
+//
+// Entries written to the P4RT_TABLE can also store their AppDb key. That way
+// reads do not need to translate the entry again to find its counters.
+class EntityCache {
+ public:
+  using EntityMap = absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity>;
+  using AppDbKeyMap = absl::flat_hash_map<pdpi::EntityKey, std::string>;
+
+  // The resources used by a table entry's action set (e.g. the members of a
+  // WCMP group). They are counted once when the entry is cached so resource
+  // accounting for a MODIFY or DELETE does not need to walk the old entry.
+  struct ActionSetUsage {
+    int32_t number_of_actions = 0;
+    int64_t total_weight = 0;
+  };
+
+  // Approximate memory used by a set of cached entities: their serialized
+  // bytes, their AppDb keys, and the fixed size of their map and index slots.
+  // Heap memory owned by the EntityKeys is not included.
+  struct Footprint {
+    int64_t entries = 0;
+    int64_t bytes = 0;
+  };
+
+  EntityCache() = default;
+
+  // Builds a cache, and its indices, from an existing set of entities. Any
+  // AppDb key without a matching entity is ignored.
+  explicit EntityCache(EntityMap entities, AppDbKeyMap app_db_keys = {});
+
+  int size() const { return entities_.size(); }
+
+  // Returns every stored AppDb key.
+  const AppDbKeyMap& app_db_keys() const { return app_db_keys_; }
+
+  // Returns true if an entity with the key is cached.
+  bool Contains(const pdpi::EntityKey& key) const {
+    return entities_.contains(key);
+  }
+
+  // Returns the cached entity for a key, or nullopt if it does not exist.
+  std::optional<p4::v1::Entity> Find(const pdpi::EntityKey& key) const;
+
+  // Returns the AppDb key for a cached entity, or nullptr if none was stored.
+  const std::string* FindAppDbKey(const pdpi::EntityKey& key) const;
+
+  // Returns the action set usage of a cached table entry, or nullptr if the
+  // entry does not exist or does not use an action set.
+  const ActionSetUsage* FindActionSetUsage(const pdpi::EntityKey& key) const;
+
+  // Inserts a new entity, or replaces the existing entity with the same key.
+  // An empty `app_db_key` clears any previously stored AppDb key.
+  void InsertOrAssign(const pdpi::EntityKey& key, p4::v1::Entity entity,
+                      std::string app_db_key = "");
+
+  // Removes an entity. Does nothing if the key does not exist.
+  void Erase(const pdpi::EntityKey& key);
+
+  // Visits every cached entity. Stops, and returns, on the first error.
+  absl::Status ForEachEntity(
+      absl::FunctionRef<absl::Status(const pdpi::EntityKey&,
+                                     const p4::v1::Entity&)>
+          visit) const;
+
+  // Visits every cached table entry in `table_id`. If `table_id` is 0 then
+  // every table entry is visited. Stops, and returns, on the first error.
+  absl::Status ForEachTableEntry(
+      uint32_t table_id,
+      absl::FunctionRef<absl::Status(const pdpi::EntityKey&,
+                                     const p4::v1::TableEntry&)>
+          visit) const;
+
+  // Visits every cached entity of a given type. Stops, and returns, on the
+  // first error.
+  absl::Status ForEachEntityOfType(
+      p4::v1::Entity::EntityCase entity_type,
+      absl::FunctionRef<absl::Status(const p4::v1::Entity&)> visit) const;
+
+  // Like ForEachTableEntry, but visits the serialized p4::v1::Entity of every
+  // table entry, along with its table ID, without parsing it.
+  absl::Status ForEachSerializedTableEntry(
+      uint32_t table_id,
+      absl::FunctionRef<absl::Status(const pdpi::EntityKey&, uint32_t table_id,
+                                     absl::string_view serialized_entity)>
+          visit) const;
+
+  // Like ForEachEntityOfType, but visits the serialized p4::v1::Entity without
+  // parsing it.
+  absl::Status ForEachSerializedEntityOfType(
+      p4::v1::Entity::EntityCase entity_type,
+      absl::FunctionRef<absl::Status(absl::string_view serialized_entity)>
+          visit) const;
+
+  // Returns the number of cached entries in a table.
+  int TableEntryCount(uint32_t table_id) const;
+
+  // The footprint of the whole cache, of every entity type, and of every
+  // table's entries. Kept up to date as entities are added and removed.
+  const Footprint& footprint() const { return footprint_; }
+  const absl::flat_hash_map<p4::v1::Entity::EntityCase, Footprint>&
+  footprint_by_entity_type() const {
+    return footprint_by_entity_type_;
+  }
+  const absl::flat_hash_map<uint32_t, Footprint>& footprint_by_table_id()
+      const {
+    return footprint_by_table_id_;
+  }
+
+  // A digest of every cached entity, independent of the order in which they
+  // were written, and stable across processes. Two caches with the same
+  // entities have the same fingerprint. Kept up to date as entities are added
+  // and removed.
+  uint64_t Fingerprint() const { return fingerprint_; }
+
+ private:
+  // Parses a stored entity into `entity`, reusing its allocations.
+  absl::Status Parse(const pdpi::EntityKey& key, absl::string_view serialized,
+                     p4::v1::Entity& entity) const;
+
+  void AddToIndex(const pdpi::EntityKey& key, const p4::v1::Entity& entity);
+  void RemoveFromIndex(const pdpi::EntityKey& key,
+                       const p4::v1::Entity& entity);
+  void UpdateActionSetUsage(const pdpi::EntityKey& key,
+                            const p4::v1::Entity& entity);
+
+  // Adds (or with `sign` -1, removes) the footprint of a cached entity.
+  void UpdateFootprint(const pdpi::EntityKey& key,
+                       const p4::v1::Entity& entity,
+                       const std::string& serialized, int sign);
+
+  // Serialized p4::v1::Entity by key.
+  absl::flat_hash_map<pdpi::EntityKey, std::string> entities_;
+  AppDbKeyMap app_db_keys_;
+  absl::flat_hash_map<pdpi::EntityKey, ActionSetUsage> action_set_usage_;
+
+  // Index of all table entry keys by their table ID.
+  absl::flat_hash_map<uint32_t, absl::flat_hash_set<pdpi::EntityKey>>
+      table_entry_keys_by_table_id_;
+
+  // Index of all non-table entry keys by their entity type.
+  absl::flat_hash_map<p4::v1::Entity::EntityCase,
+                      absl::flat_hash_set<pdpi::EntityKey>>
+      keys_by_entity_type_;
+
+  Footprint footprint_;
+  absl::flat_hash_map<p4::v1::Entity::EntityCase, Footprint>
+      footprint_by_entity_type_;
+  absl::flat_hash_map<uint32_t, Footprint> footprint_by_table_id_;
+  // The sum, wrapping around, of the digests of all serialized entities.
+  uint64_t fingerprint_ = 0;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_P4RUNTIME_ENTITY_CACHE_H_
@@ -0,0 +1,277 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "p4rt_app/p4runtime/entity_cache_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/cleanup/cleanup.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/text_format.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
+
+namespace p4rt_app {
+namespace {
+
+constexpr char kSnapshotMagic[] = "P4RTCACHE";
+constexpr int kSnapshotMagicSize = sizeof(kSnapshotMagic) - 1;
+constexpr uint32_t kSnapshotVersion = 1;
+
+// 64-bit FNV-1a. Unlike absl::Hash the result is stable across processes,
+// which is required since the marker is compared after a restart.
+uint64_t Fnv1a(uint64_t hash, const std::string& value) {
+  constexpr uint64_t kFnvPrime = 0x100000001b3;
+  for (unsigned char c : value) {
+    hash ^= c;
+    hash *= kFnvPrime;
+  }
+  // Include a separator so {"ab", "c"} and {"a", "bc"} differ.
+  hash ^= 0xff;
+  hash *= kFnvPrime;
+  return hash;
+}
+
+bool ReadString(google::protobuf::io::CodedInputStream& input,
+                std::string& value) {
+  uint32_t size = 0;
+  return input.ReadVarint32(&size) && input.ReadString(&value, size);
+}
+
+}  // namespace
+
+std::string AppDbGeneration(std::vector<std::string> app_db_keys) {
+  std::sort(app_db_keys.begin(), app_db_keys.end());
+  uint64_t hash = 0xcbf29ce484222325;
+  for (const std::string& key : app_db_keys) {
+    hash = Fnv1a(hash, key);
+  }
+  return absl::StrFormat("%d:%016x", app_db_keys.size(), hash);
+}
+
+absl::Status WriteEntityCacheSnapshot(const std::string& path,
+                                      const EntityCacheSnapshotHeader& header,
+                                      const EntityCache& entity_cache) {
+  const std::string tmp_path = absl::StrCat(path, ".tmp");
+  std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return gutil::InternalErrorBuilder()
+           << "Could not open entity cache snapshot '" << tmp_path
+           << "' for writing: " << std::strerror(errno);
+  }
+
+  bool serialized = true;
+  {
+    google::protobuf::io::OstreamOutputStream output_stream(&file);
+    google::protobuf::io::CodedOutputStream output(&output_stream);
+    output.SetSerializationDeterministic(true);
+
+    output.WriteRaw(kSnapshotMagic, kSnapshotMagicSize);
+    output.WriteVarint32(kSnapshotVersion);
+    output.WriteLittleEndian64(header.p4info_cookie);
+    output.WriteVarint32(header.app_db_generation.size());
+    output.WriteString(header.app_db_generation);
+    output.WriteVarint64(entity_cache.size());
+    serialized =
+        entity_cache
+            .ForEachEntity([&](const pdpi::EntityKey& key,
+                               const p4::v1::Entity& entity) -> absl::Status {
+              const std::string* app_db_key = entity_cache.FindAppDbKey(key);
+              const std::string empty;
+              if (app_db_key == nullptr) app_db_key = &empty;
+              output.WriteVarint32(app_db_key->size());
+              output.WriteString(*app_db_key);
+              output.WriteVarint32(entity.ByteSizeLong());
+              if (!entity.SerializeToCodedStream(&output)) {
+                return absl::InternalError("Could not serialize entity.");
+              }
+              return absl::OkStatus();
+            })
+            .ok();
+    serialized = serialized && !output.HadError();
+  }
+  file.close();
+  if (!serialized || file.fail()) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Failed to write entity cache snapshot '" << tmp_path << "'.";
+  }
+
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Could not move entity cache snapshot to '" << path
+           << "': " << std::strerror(errno);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status WriteEntityCacheText(const std::string& path,
+                                  const EntityCache& entity_cache) {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file.is_open()) {
+    return gutil::InternalErrorBuilder()
+           << "Could not open '" << path
+           << "' for writing: " << std::strerror(errno);
+  }
+
+  google::protobuf::TextFormat::Printer printer;
+  printer.SetSingleLineMode(true);
+  std::string line;
+  RETURN_IF_ERROR(entity_cache.ForEachEntity(
+      [&](const pdpi::EntityKey& key, const p4::v1::Entity& entity) {
+        line.clear();
+        const std::string* app_db_key = entity_cache.FindAppDbKey(key);
+        if (app_db_key != nullptr) absl::StrAppend(&line, *app_db_key, "\t");
+        std::string text;
+        printer.PrintToString(entity, &text);
+        absl::StrAppend(&line, text, "\n");
+        file << line;
+        return absl::OkStatus();
+      }));
+  file.close();
+  if (file.fail()) {
+    return gutil::InternalErrorBuilder() << "Failed to write '" << path << "'.";
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<EntityCache> ReadEntityCacheSnapshot(
+    const std::string& path, const EntityCacheSnapshotHeader& expected_header) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return gutil::NotFoundErrorBuilder()
+           << "Could not open entity cache snapshot '" << path
+           << "': " << std::strerror(errno);
+  }
+  absl::Cleanup close_file = [fd] { close(fd); };
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    return gutil::InternalErrorBuilder()
+           << "Could not stat entity cache snapshot '" << path
+           << "': " << std::strerror(errno);
+  }
+  if (file_stat.st_size <= 0 ||
+      file_stat.st_size > std::numeric_limits<int>::max()) {
+    return gutil::DataLossErrorBuilder()
+           << "Entity cache snapshot '" << path
+           << "' has an invalid size: " << file_stat.st_size;
+  }
+  const size_t file_size = file_stat.st_size;
+
+  void* data = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    return gutil::InternalErrorBuilder()
+           << "Could not memory-map entity cache snapshot '" << path
+           << "': " << std::strerror(errno);
+  }
+  absl::Cleanup unmap_file = [data, file_size] { munmap(data, file_size); };
+
+  google::protobuf::io::CodedInputStream input(
+      static_cast<const uint8_t*>(data), file_size);
+
+  std::string magic;
+  uint32_t version = 0;
+  EntityCacheSnapshotHeader header;
+  uint64_t entity_count = 0;
+  if (!input.ReadString(&magic, kSnapshotMagicSize) ||
+      magic != kSnapshotMagic || !input.ReadVarint32(&version)) {
+    return gutil::DataLossErrorBuilder()
+           << "'" << path << "' is not an entity cache snapshot.";
+  }
+  if (version != kSnapshotVersion) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "Entity cache snapshot '" << path << "' has version " << version
+           << ", but only version " << kSnapshotVersion << " is supported.";
+  }
+  if (!input.ReadLittleEndian64(&header.p4info_cookie) ||
+      !ReadString(input, header.app_db_generation) ||
+      !input.ReadVarint64(&entity_count)) {
+    return gutil::DataLossErrorBuilder()
+           << "Entity cache snapshot '" << path << "' has a corrupt header.";
+  }
+  if (!(header == expected_header)) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "Entity cache snapshot '" << path
+           << "' is stale. Snapshot has P4Info cookie " << header.p4info_cookie
+           << " and AppDb generation '" << header.app_db_generation
+           << "', but the switch has P4Info cookie "
+           << expected_header.p4info_cookie << " and AppDb generation '"
+           << expected_header.app_db_generation << "'.";
+  }
+
+  EntityCache::EntityMap entities;
+  EntityCache::AppDbKeyMap app_db_keys;
+  for (uint64_t i = 0; i < entity_count; ++i) {
+    std::string app_db_key;
+    uint32_t entity_size = 0;
+    if (!ReadString(input, app_db_key) || !input.ReadVarint32(&entity_size) ||
+        input.CurrentPosition() + entity_size > file_size) {
+      return gutil::DataLossErrorBuilder()
+             << "Entity cache snapshot '" << path << "' is truncated after "
+             << i << " entities.";
+    }
+
+    p4::v1::Entity entity;
+    auto limit = input.PushLimit(entity_size);
+    if (!entity.ParseFromCodedStream(&input) ||
+        !input.ConsumedEntireMessage()) {
+      return gutil::DataLossErrorBuilder()
+             << "Entity cache snapshot '" << path
+             << "' has a corrupt entity at index " << i << ".";
+    }
+    input.PopLimit(limit);
+
+    ASSIGN_OR_RETURN(pdpi::EntityKey key,
+                     pdpi::EntityKey::MakeEntityKey(entity));
+    if (!app_db_key.empty()) app_db_keys[key] = std::move(app_db_key);
+    if (!entities.try_emplace(key, std::move(entity)).second) {
+      return gutil::DataLossErrorBuilder()
+             << "Entity cache snapshot '" << path
+             << "' has a duplicate entity: " << key;
+    }
+  }
+  if (input.CurrentPosition() != file_size) {
+    return gutil::DataLossErrorBuilder()
+           << "Entity cache snapshot '" << path
+           << "' has unexpected trailing data.";
+  }
+
+  return EntityCache(std::move(entities), std::move(app_db_keys));
+}
+
+}  // namespace p4rt_app
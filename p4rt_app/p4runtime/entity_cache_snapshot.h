@@ -0,0 +1,72 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PINS_P4RT_APP_P4RUNTIME_ENTITY_CACHE_SNAPSHOT_H_
+#define PINS_P4RT_APP_P4RUNTIME_ENTITY_CACHE_SNAPSHOT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
+
+namespace p4rt_app {
+
+// Identifies the state an entity cache snapshot was taken from. A snapshot
+// should only be loaded if the header still matches the switch.
+struct EntityCacheSnapshotHeader {
+  // Cookie of the ForwardingPipelineConfig that was applied.
+  uint64_t p4info_cookie = 0;
+
+  // Describes the AppDb contents when the snapshot was taken (see
+  // AppDbGeneration()).
+  std::string app_db_generation;
+
+  bool operator==(const EntityCacheSnapshotHeader& other) const {
+    return p4info_cookie == other.p4info_cookie &&
+           app_db_generation == other.app_db_generation;
+  }
+};
+
+// Returns a marker for a set of AppDb keys that is stable across restarts. The
+// order of the keys does not matter. Entries being added, or removed, will
+// change the marker, but entries being modified in place will not.
+std::string AppDbGeneration(std::vector<std::string> app_db_keys);
+
+// Writes every entity in the cache, and any AppDb keys, to a binary file. The
+// file starts with the header followed by length-delimited entities. The file
+// is replaced atomically so a reader never sees a partial snapshot.
+absl::Status WriteEntityCacheSnapshot(const std::string& path,
+                                      const EntityCacheSnapshotHeader& header,
+                                      const EntityCache& entity_cache);
+
+// Writes every entity in the cache to a text file for debugging. Each line
+// holds the AppDb key, if any, followed by the entity in single-line protobuf
+// text format. Entities are written as they are visited so the whole file is
+// never held in memory.
+absl::Status WriteEntityCacheText(const std::string& path,
+                                  const EntityCache& entity_cache);
+
+// Memory-maps a snapshot file and rebuilds the entity cache from it. Returns a
+// FailedPrecondition error if the snapshot header does not match
+// `expected_header`, and a DataLoss error if the file is corrupt.
+absl::StatusOr<EntityCache> ReadEntityCacheSnapshot(
+    const std::string& path, const EntityCacheSnapshotHeader& expected_header);
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_P4RUNTIME_ENTITY_CACHE_SNAPSHOT_H_
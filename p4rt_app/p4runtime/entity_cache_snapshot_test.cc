@@ -0,0 +1,200 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/p4runtime/entity_cache_snapshot.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/io.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::StatusIs;
+using ::testing::Eq;
+using ::testing::HasSubstr;
+using ::testing::Optional;
+using ::testing::Pointee;
+using ::testing::StartsWith;
+
+p4::v1::Entity TableEntry(uint32_t table_id, const std::string& value) {
+  return gutil::ParseProtoOrDie<p4::v1::Entity>(absl::Substitute(
+      R"pb(table_entry {
+             table_id: $0
+             match {
+               field_id: 1
+               exact { value: "$1" }
+             }
+           })pb",
+      table_id, value));
+}
+
+p4::v1::Entity MulticastEntry(uint32_t group_id) {
+  return gutil::ParseProtoOrDie<p4::v1::Entity>(absl::Substitute(
+      R"pb(packet_replication_engine_entry {
+             multicast_group_entry { multicast_group_id: $0 }
+           })pb",
+      group_id));
+}
+
+pdpi::EntityKey KeyOf(const p4::v1::Entity& entity) {
+  return *pdpi::EntityKey::MakeEntityKey(entity);
+}
+
+class EntityCacheSnapshotTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    const char* test_tmpdir = std::getenv("TEST_TMPDIR");
+    ASSERT_NE(test_tmpdir, nullptr)
+        << "Could not find environment variable ${TEST_TMPDIR}.";
+    path_ = absl::StrCat(test_tmpdir, "/", test_info_->name(), ".snapshot");
+  }
+
+  std::string path_;
+  const EntityCacheSnapshotHeader header_ = {
+      .p4info_cookie = 0x1234,
+      .app_db_generation = AppDbGeneration({"TABLE:key1", "TABLE:key2"}),
+  };
+};
+
+TEST(AppDbGenerationTest, DoesNotDependOnKeyOrder) {
+  EXPECT_EQ(AppDbGeneration({"a", "b", "c"}), AppDbGeneration({"c", "a", "b"}));
+}
+
+TEST(AppDbGenerationTest, ChangesWhenKeysChange) {
+  EXPECT_NE(AppDbGeneration({"a", "b"}), AppDbGeneration({"a", "b", "c"}));
+  EXPECT_NE(AppDbGeneration({"a", "b"}), AppDbGeneration({"a", "c"}));
+  EXPECT_NE(AppDbGeneration({"ab", "c"}), AppDbGeneration({"a", "bc"}));
+  EXPECT_NE(AppDbGeneration({}), AppDbGeneration({""}));
+}
+
+TEST_F(EntityCacheSnapshotTest, RoundTripsEntitiesAndAppDbKeys) {
+  const p4::v1::Entity entry1 = TableEntry(1, "a");
+  const p4::v1::Entity entry2 = TableEntry(2, "b");
+  const p4::v1::Entity multicast = MulticastEntry(7);
+  EntityCache cache({{KeyOf(entry1), entry1},
+                     {KeyOf(entry2), entry2},
+                     {KeyOf(multicast), multicast}},
+                    {{KeyOf(entry1), "TABLE:key1"}});
+
+  ASSERT_OK(WriteEntityCacheSnapshot(path_, header_, cache));
+  ASSERT_OK_AND_ASSIGN(EntityCache loaded,
+                       ReadEntityCacheSnapshot(path_, header_));
+
+  EXPECT_EQ(loaded.size(), 3);
+  EXPECT_THAT(loaded.Find(KeyOf(entry1)), Optional(EqualsProto(entry1)));
+  EXPECT_THAT(loaded.Find(KeyOf(entry2)), Optional(EqualsProto(entry2)));
+  EXPECT_THAT(loaded.Find(KeyOf(multicast)), Optional(EqualsProto(multicast)));
+  EXPECT_THAT(loaded.FindAppDbKey(KeyOf(entry1)), Pointee(Eq("TABLE:key1")));
+  EXPECT_EQ(loaded.FindAppDbKey(KeyOf(entry2)), nullptr);
+
+  // The per-table index is rebuilt as well.
+  EXPECT_EQ(loaded.TableEntryCount(1), 1);
+  EXPECT_EQ(loaded.TableEntryCount(2), 1);
+}
+
+TEST_F(EntityCacheSnapshotTest, RoundTripsAnEmptyCache) {
+  ASSERT_OK(WriteEntityCacheSnapshot(path_, header_, EntityCache()));
+  ASSERT_OK_AND_ASSIGN(EntityCache loaded,
+                       ReadEntityCacheSnapshot(path_, header_));
+  EXPECT_EQ(loaded.size(), 0);
+}
+
+TEST_F(EntityCacheSnapshotTest, RejectsDifferentP4InfoCookie) {
+  ASSERT_OK(WriteEntityCacheSnapshot(path_, header_, EntityCache()));
+
+  EntityCacheSnapshotHeader expected = header_;
+  expected.p4info_cookie = 0x5678;
+  EXPECT_THAT(ReadEntityCacheSnapshot(path_, expected),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_F(EntityCacheSnapshotTest, RejectsDifferentAppDbGeneration) {
+  ASSERT_OK(WriteEntityCacheSnapshot(path_, header_, EntityCache()));
+
+  EntityCacheSnapshotHeader expected = header_;
+  expected.app_db_generation = AppDbGeneration({"TABLE:key1"});
+  EXPECT_THAT(ReadEntityCacheSnapshot(path_, expected),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_F(EntityCacheSnapshotTest, MissingFileReturnsNotFound) {
+  EXPECT_THAT(ReadEntityCacheSnapshot(path_, header_),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST_F(EntityCacheSnapshotTest, RejectsFilesThatAreNotSnapshots) {
+  ASSERT_OK(gutil::WriteFile("not a snapshot", path_));
+  EXPECT_THAT(ReadEntityCacheSnapshot(path_, header_),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST_F(EntityCacheSnapshotTest, RejectsTruncatedFiles) {
+  const p4::v1::Entity entry = TableEntry(1, "a");
+  ASSERT_OK(WriteEntityCacheSnapshot(path_, header_,
+                                     EntityCache({{KeyOf(entry), entry}})));
+  ASSERT_OK_AND_ASSIGN(std::string contents, gutil::ReadFile(path_));
+  ASSERT_OK(
+      gutil::WriteFile(contents.substr(0, contents.size() - 2), path_));
+
+  EXPECT_THAT(ReadEntityCacheSnapshot(path_, header_),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST_F(EntityCacheSnapshotTest, OverwritesAnExistingSnapshot) {
+  const p4::v1::Entity entry = TableEntry(1, "a");
+  ASSERT_OK(WriteEntityCacheSnapshot(path_, header_,
+                                     EntityCache({{KeyOf(entry), entry}})));
+  ASSERT_OK(WriteEntityCacheSnapshot(path_, header_, EntityCache()));
+
+  ASSERT_OK_AND_ASSIGN(EntityCache loaded,
+                       ReadEntityCacheSnapshot(path_, header_));
+  EXPECT_EQ(loaded.size(), 0);
+}
+
+TEST_F(EntityCacheSnapshotTest, WritesOneTextLinePerEntity) {
+  EntityCache cache;
+  p4::v1::Entity table_entry = TableEntry(1, "a");
+  cache.InsertOrAssign(KeyOf(table_entry), table_entry, "P4RT_TABLE:key");
+  p4::v1::Entity multicast_entry = MulticastEntry(7);
+  cache.InsertOrAssign(KeyOf(multicast_entry), multicast_entry);
+
+  ASSERT_OK(WriteEntityCacheText(path_, cache));
+  ASSERT_OK_AND_ASSIGN(std::vector<std::string> lines,
+                       gutil::ReadFileLines(path_));
+  ASSERT_EQ(lines.size(), 2);
+  if (!absl::StartsWith(lines[0], "P4RT_TABLE")) std::swap(lines[0], lines[1]);
+  EXPECT_THAT(lines[0], StartsWith("P4RT_TABLE:key\ttable_entry {"));
+  EXPECT_THAT(lines[1], StartsWith("packet_replication_engine_entry {"));
+  EXPECT_THAT(lines[1], HasSubstr("multicast_group_id: 7"));
+}
+
+}  // namespace
+}  // namespace p4rt_app
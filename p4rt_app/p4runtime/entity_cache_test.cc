@@ -0,0 +1,340 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/p4runtime/entity_cache.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/substitute.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::StatusIs;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+using ::testing::UnorderedElementsAre;
+
+p4::v1::Entity TableEntry(uint32_t table_id, const std::string& value) {
+  return gutil::ParseProtoOrDie<p4::v1::Entity>(absl::Substitute(
+      R"pb(table_entry {
+             table_id: $0
+             match {
+               field_id: 1
+               exact { value: "$1" }
+             }
+           })pb",
+      table_id, value));
+}
+
+p4::v1::Entity MulticastEntry(uint32_t group_id) {
+  return gutil::ParseProtoOrDie<p4::v1::Entity>(absl::Substitute(
+      R"pb(packet_replication_engine_entry {
+             multicast_group_entry { multicast_group_id: $0 }
+           })pb",
+      group_id));
+}
+
+pdpi::EntityKey KeyOf(const p4::v1::Entity& entity) {
+  return *pdpi::EntityKey::MakeEntityKey(entity);
+}
+
+std::vector<uint32_t> TableIdsVisited(const EntityCache& cache,
+                                      uint32_t table_id) {
+  std::vector<uint32_t> result;
+  EXPECT_OK(cache.ForEachTableEntry(
+      table_id,
+      [&](const pdpi::EntityKey&,
+          const p4::v1::TableEntry& entry) -> absl::Status {
+        result.push_back(entry.table_id());
+        return absl::OkStatus();
+      }));
+  return result;
+}
+
+TEST(EntityCacheTest, ForEachTableEntryOnlyVisitsRequestedTable) {
+  EntityCache cache;
+  for (const auto& entity : {TableEntry(1, "a"), TableEntry(1, "b"),
+                             TableEntry(2, "a"), MulticastEntry(7)}) {
+    cache.InsertOrAssign(KeyOf(entity), entity);
+  }
+
+  EXPECT_THAT(TableIdsVisited(cache, 1), UnorderedElementsAre(1, 1));
+  EXPECT_THAT(TableIdsVisited(cache, 2), UnorderedElementsAre(2));
+  EXPECT_THAT(TableIdsVisited(cache, 3), IsEmpty());
+  EXPECT_THAT(TableIdsVisited(cache, 0), UnorderedElementsAre(1, 1, 2));
+  EXPECT_EQ(cache.TableEntryCount(1), 2);
+  EXPECT_EQ(cache.size(), 4);
+}
+
+TEST(EntityCacheTest, ForEachEntityOfTypeVisitsPacketReplicationEntries) {
+  EntityCache cache;
+  for (const auto& entity :
+       {TableEntry(1, "a"), MulticastEntry(7), MulticastEntry(8)}) {
+    cache.InsertOrAssign(KeyOf(entity), entity);
+  }
+
+  std::vector<uint32_t> group_ids;
+  EXPECT_OK(cache.ForEachEntityOfType(
+      p4::v1::Entity::kPacketReplicationEngineEntry,
+      [&](const p4::v1::Entity& entity) -> absl::Status {
+        group_ids.push_back(entity.packet_replication_engine_entry()
+                                .multicast_group_entry()
+                                .multicast_group_id());
+        return absl::OkStatus();
+      }));
+  EXPECT_THAT(group_ids, UnorderedElementsAre(7, 8));
+}
+
+TEST(EntityCacheTest, ForEachSerializedTableEntryVisitsTheCachedBytes) {
+  p4::v1::Entity entity = TableEntry(1, "a");
+  EntityCache cache;
+  for (const auto& cached : {entity, TableEntry(2, "a"), MulticastEntry(7)}) {
+    cache.InsertOrAssign(KeyOf(cached), cached);
+  }
+
+  std::vector<uint32_t> table_ids;
+  EXPECT_OK(cache.ForEachSerializedTableEntry(
+      1,
+      [&](const pdpi::EntityKey& key, uint32_t table_id,
+          absl::string_view serialized) -> absl::Status {
+        table_ids.push_back(table_id);
+        EXPECT_EQ(key, KeyOf(entity));
+        p4::v1::Entity parsed;
+        EXPECT_TRUE(
+            parsed.ParseFromArray(serialized.data(), serialized.size()));
+        EXPECT_THAT(parsed, EqualsProto(entity));
+        return absl::OkStatus();
+      }));
+  EXPECT_THAT(table_ids, UnorderedElementsAre(1));
+
+  int multicast_entries = 0;
+  EXPECT_OK(cache.ForEachSerializedEntityOfType(
+      p4::v1::Entity::kPacketReplicationEngineEntry,
+      [&](absl::string_view serialized) -> absl::Status {
+        ++multicast_entries;
+        return absl::OkStatus();
+      }));
+  EXPECT_EQ(multicast_entries, 1);
+}
+
+TEST(EntityCacheTest, EraseRemovesEntryFromIndex) {
+  p4::v1::Entity entity = TableEntry(1, "a");
+  EntityCache cache;
+  cache.InsertOrAssign(KeyOf(entity), entity);
+  cache.Erase(KeyOf(entity));
+
+  EXPECT_EQ(cache.Find(KeyOf(entity)), std::nullopt);
+  EXPECT_FALSE(cache.Contains(KeyOf(entity)));
+  EXPECT_EQ(cache.TableEntryCount(1), 0);
+  EXPECT_THAT(TableIdsVisited(cache, 1), IsEmpty());
+
+  // Erasing a missing entry is a no-op.
+  cache.Erase(KeyOf(entity));
+  EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(EntityCacheTest, InsertOrAssignReplacesExistingEntry) {
+  p4::v1::Entity entity = TableEntry(1, "a");
+  EntityCache cache;
+  cache.InsertOrAssign(KeyOf(entity), entity);
+
+  p4::v1::Entity modified = entity;
+  modified.mutable_table_entry()->mutable_action()->mutable_action()
+      ->set_action_id(5);
+  cache.InsertOrAssign(KeyOf(modified), modified);
+
+  EXPECT_THAT(cache.Find(KeyOf(entity)), Optional(EqualsProto(modified)));
+  EXPECT_EQ(cache.TableEntryCount(1), 1);
+}
+
+TEST(EntityCacheTest, ConstructorBuildsIndex) {
+  EntityCache::EntityMap entities;
+  for (const auto& entity :
+       {TableEntry(1, "a"), TableEntry(2, "a"), MulticastEntry(7)}) {
+    entities[KeyOf(entity)] = entity;
+  }
+  EntityCache cache(std::move(entities));
+
+  EXPECT_THAT(TableIdsVisited(cache, 2), UnorderedElementsAre(2));
+  EXPECT_EQ(cache.size(), 3);
+}
+
+TEST(EntityCacheTest, VisitorErrorsAreReturned) {
+  p4::v1::Entity entity = TableEntry(1, "a");
+  EntityCache cache;
+  cache.InsertOrAssign(KeyOf(entity), entity);
+
+  EXPECT_THAT(
+      cache.ForEachTableEntry(
+          1,
+          [](const pdpi::EntityKey&, const p4::v1::TableEntry&) {
+            return absl::UnknownError("stop");
+          }),
+      StatusIs(absl::StatusCode::kUnknown));
+}
+
+TEST(EntityCacheTest, AppDbKeysFollowTheirEntity) {
+  p4::v1::Entity entity = TableEntry(1, "a");
+  EntityCache cache;
+  cache.InsertOrAssign(KeyOf(entity), entity, "TABLE:key");
+  ASSERT_NE(cache.FindAppDbKey(KeyOf(entity)), nullptr);
+  EXPECT_EQ(*cache.FindAppDbKey(KeyOf(entity)), "TABLE:key");
+
+  // Replacing the entry without a key clears the old one.
+  cache.InsertOrAssign(KeyOf(entity), entity);
+  EXPECT_EQ(cache.FindAppDbKey(KeyOf(entity)), nullptr);
+
+  cache.InsertOrAssign(KeyOf(entity), entity, "TABLE:key");
+  cache.Erase(KeyOf(entity));
+  EXPECT_EQ(cache.FindAppDbKey(KeyOf(entity)), nullptr);
+}
+
+TEST(EntityCacheTest, ConstructorIgnoresAppDbKeysWithoutAnEntity) {
+  p4::v1::Entity entity = TableEntry(1, "a");
+  p4::v1::Entity missing = TableEntry(1, "b");
+  EntityCache cache({{KeyOf(entity), entity}},
+                    {{KeyOf(entity), "TABLE:a"}, {KeyOf(missing), "TABLE:b"}});
+
+  ASSERT_NE(cache.FindAppDbKey(KeyOf(entity)), nullptr);
+  EXPECT_EQ(*cache.FindAppDbKey(KeyOf(entity)), "TABLE:a");
+  EXPECT_EQ(cache.FindAppDbKey(KeyOf(missing)), nullptr);
+}
+
+TEST(EntityCacheTest, ActionSetUsageFollowsTheEntity) {
+  p4::v1::Entity entity = TableEntry(1, "a");
+  EntityCache cache;
+  cache.InsertOrAssign(KeyOf(entity), entity);
+  EXPECT_EQ(cache.FindActionSetUsage(KeyOf(entity)), nullptr);
+
+  auto& action_set = *entity.mutable_table_entry()
+                          ->mutable_action()
+                          ->mutable_action_profile_action_set();
+  action_set.add_action_profile_actions()->set_weight(2);
+  action_set.add_action_profile_actions()->set_weight(5);
+  cache.InsertOrAssign(KeyOf(entity), entity);
+  const EntityCache::ActionSetUsage* usage =
+      cache.FindActionSetUsage(KeyOf(entity));
+  ASSERT_NE(usage, nullptr);
+  EXPECT_EQ(usage->number_of_actions, 2);
+  EXPECT_EQ(usage->total_weight, 7);
+
+  // Copies keep the usage, and erasing the entry removes it.
+  EntityCache copy = cache;
+  ASSERT_NE(copy.FindActionSetUsage(KeyOf(entity)), nullptr);
+  EXPECT_EQ(copy.FindActionSetUsage(KeyOf(entity))->total_weight, 7);
+  cache.Erase(KeyOf(entity));
+  EXPECT_EQ(cache.FindActionSetUsage(KeyOf(entity)), nullptr);
+}
+
+TEST(EntityCacheTest, FootprintFollowsTheEntities) {
+  p4::v1::Entity small = TableEntry(1, "a");
+  p4::v1::Entity large = TableEntry(2, std::string(1000, 'b'));
+  p4::v1::Entity multicast = MulticastEntry(7);
+  EntityCache cache;
+  cache.InsertOrAssign(KeyOf(small), small, "P4RT_TABLE:small");
+  cache.InsertOrAssign(KeyOf(large), large);
+  cache.InsertOrAssign(KeyOf(multicast), multicast);
+
+  EXPECT_EQ(cache.footprint().entries, 3);
+  EXPECT_EQ(cache.footprint_by_table_id().at(1).entries, 1);
+  EXPECT_GT(cache.footprint_by_table_id().at(2).bytes, 1000);
+  EXPECT_GT(cache.footprint_by_table_id().at(2).bytes,
+            cache.footprint_by_table_id().at(1).bytes);
+  EXPECT_EQ(
+      cache.footprint_by_entity_type().at(p4::v1::Entity::kTableEntry).entries,
+      2);
+  EXPECT_EQ(cache.footprint_by_entity_type()
+                .at(p4::v1::Entity::kPacketReplicationEngineEntry)
+                .entries,
+            1);
+
+  // Replacing an entity only changes its bytes.
+  const int64_t bytes = cache.footprint().bytes;
+  cache.InsertOrAssign(KeyOf(small), small, "P4RT_TABLE:small");
+  EXPECT_EQ(cache.footprint().entries, 3);
+  EXPECT_EQ(cache.footprint().bytes, bytes);
+
+  // A copy of the cache has the same footprint, and removing every entity
+  // leaves nothing behind.
+  EntityCache copy = cache;
+  EXPECT_EQ(copy.footprint().bytes, bytes);
+  cache.Erase(KeyOf(small));
+  cache.Erase(KeyOf(large));
+  cache.Erase(KeyOf(multicast));
+  EXPECT_EQ(cache.footprint().entries, 0);
+  EXPECT_EQ(cache.footprint().bytes, 0);
+  EXPECT_THAT(cache.footprint_by_table_id(), IsEmpty());
+  EXPECT_THAT(cache.footprint_by_entity_type(), IsEmpty());
+}
+
+TEST(EntityCacheTest, ConstructorComputesTheFootprint) {
+  p4::v1::Entity entity = TableEntry(1, "a");
+  EntityCache inserted;
+  inserted.InsertOrAssign(KeyOf(entity), entity, "P4RT_TABLE:a");
+
+  EntityCache constructed({{KeyOf(entity), entity}},
+                          {{KeyOf(entity), "P4RT_TABLE:a"}});
+  EXPECT_EQ(constructed.footprint().entries, 1);
+  EXPECT_EQ(constructed.footprint().bytes, inserted.footprint().bytes);
+}
+
+TEST(EntityCacheTest, FingerprintOnlyDependsOnTheEntities) {
+  p4::v1::Entity a = TableEntry(1, "a");
+  p4::v1::Entity b = TableEntry(1, "b");
+  p4::v1::Entity multicast = MulticastEntry(7);
+  EntityCache empty;
+  EntityCache cache;
+  cache.InsertOrAssign(KeyOf(a), a);
+  cache.InsertOrAssign(KeyOf(b), b);
+  const uint64_t fingerprint = cache.Fingerprint();
+  EXPECT_NE(fingerprint, empty.Fingerprint());
+
+  // The order of writes does not matter.
+  EntityCache reordered({{KeyOf(b), b}, {KeyOf(a), a}});
+  EXPECT_EQ(reordered.Fingerprint(), fingerprint);
+
+  // Every change is reflected, and undoing it restores the fingerprint.
+  cache.InsertOrAssign(KeyOf(multicast), multicast);
+  EXPECT_NE(cache.Fingerprint(), fingerprint);
+  cache.Erase(KeyOf(multicast));
+  EXPECT_EQ(cache.Fingerprint(), fingerprint);
+
+  p4::v1::Entity modified_a = a;
+  modified_a.mutable_table_entry()->mutable_action()->mutable_action()
+      ->set_action_id(5);
+  cache.InsertOrAssign(KeyOf(a), modified_a);
+  EXPECT_NE(cache.Fingerprint(), fingerprint);
+  cache.InsertOrAssign(KeyOf(a), a);
+  EXPECT_EQ(cache.Fingerprint(), fingerprint);
+
+  cache.Erase(KeyOf(a));
+  cache.Erase(KeyOf(b));
+  EXPECT_EQ(cache.Fingerprint(), empty.Fingerprint());
+}
+
+}  // namespace
+}  // namespace p4rt_app
@@ -13,14 +13,18 @@
 // limitations under the License.
 #include "p4rt_app/p4runtime/ir_translation.h"
 
+#include <string>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 #include "glog/logging.h"
 #include "gutil/collections.h"
 #include "gutil/status.h"
+#include "p4/config/v1/p4info.pb.h"
 #include "p4/config/v1/p4types.pb.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.h"
@@ -43,7 +47,7 @@ bool IsCpuQueue(const p4::config::v1::P4NamedType& type) {
 
 absl::Status TranslatePortValue(
     TranslationDirection direction,
-    const boost::bimap<std::string, std::string>& port_map,
+    const PortTranslator& port_map,
     pdpi::IrValue& value) {
   if (value.format_case() != pdpi::IrValue::kStr) {
     return gutil::InvalidArgumentErrorBuilder()
@@ -88,6 +92,48 @@ absl::Status OptionallyTranslateCpuQueue(TranslationDirection direction,
          << "Invalid TranslationDirection provided.";
 }
 
+IrTranslationPlan::Op MatchFieldOp(
+    const pdpi::IrMatchFieldDefinition& match_def) {
+  if (IsPortType(match_def.match_field().type_name())) {
+    return IrTranslationPlan::Op::kPort;
+  }
+  return IrTranslationPlan::Op::kNone;
+}
+
+IrTranslationPlan::Op ActionParamOp(
+    const pdpi::IrActionDefinition::IrActionParamDefinition& param_def) {
+  if (IsPortType(param_def.param().type_name())) {
+    return IrTranslationPlan::Op::kPort;
+  }
+  if (IsCpuQueue(param_def.param().type_name())) {
+    return IrTranslationPlan::Op::kCpuQueue;
+  }
+  return IrTranslationPlan::Op::kNone;
+}
+
+absl::Status TranslateActionParam(
+    const TranslateTableEntryOptions& options, IrTranslationPlan::Op op,
+    const std::string& action_name,
+    pdpi::IrActionInvocation::IrActionParam& param) {
+  switch (op) {
+    case IrTranslationPlan::Op::kNone:
+      return absl::OkStatus();
+    case IrTranslationPlan::Op::kPort:
+      // Port IDs are only translated when enabled.
+      if (!options.translate_port_ids) return absl::OkStatus();
+      RETURN_IF_ERROR(TranslatePortValue(options.direction, options.port_map,
+                                         *param.mutable_value()))
+          << " Found in action parameter '" << param.name() << "' of action '"
+          << action_name << "'.";
+      return absl::OkStatus();
+    case IrTranslationPlan::Op::kCpuQueue:
+      return OptionallyTranslateCpuQueue(
+          options.direction, options.cpu_queue_translator,
+          *param.mutable_value());
+  }
+  return absl::OkStatus();
+}
+
 absl::Status TranslateAction(const TranslateTableEntryOptions& options,
                              const pdpi::IrTableDefinition& table_def,
                              pdpi::IrActionInvocation& action) {
@@ -105,7 +151,6 @@ absl::Status TranslateAction(const TranslateTableEntryOptions& options,
   }
 
   for (auto& param : *action.mutable_params()) {
-    // If the parameter field isn't a port then ignore it.
     const pdpi::IrActionDefinition::IrActionParamDefinition* param_def =
         gutil::FindOrNull(action_def->params_by_name(), param.name());
     if (param_def == nullptr) {
@@ -113,25 +158,40 @@ absl::Status TranslateAction(const TranslateTableEntryOptions& options,
              << "Could not find action param definition for " << param.name()
              << ".";
     }
-    if (options.translate_port_ids &&
-        IsPortType(param_def->param().type_name())) {
-      RETURN_IF_ERROR(TranslatePortValue(options.direction, options.port_map,
-                                         *param.mutable_value()))
-          << " Found in action parameter '" << param.name() << "' of action '"
-          << action.name() << "'.";
-      continue;
-    }
-    if (IsCpuQueue(param_def->param().type_name())) {
-      RETURN_IF_ERROR(OptionallyTranslateCpuQueue(options.direction,
-                                                  options.cpu_queue_translator,
-                                                  *param.mutable_value()));
+    RETURN_IF_ERROR(TranslateActionParam(options, ActionParamOp(*param_def),
+                                         action.name(), param));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status TranslateAction(const TranslateTableEntryOptions& options,
+                             const IrTranslationPlan::Table& table_plan,
+                             pdpi::IrActionInvocation& action) {
+  const IrTranslationPlan::Action* action_plan =
+      gutil::FindOrNull(table_plan.actions_by_name, action.name());
+  if (action_plan == nullptr) {
+    return gutil::InternalErrorBuilder()
+           << "Could not find action definition for " << action.name() << ".";
+  }
+
+  for (auto& param : *action.mutable_params()) {
+    const IrTranslationPlan::Op* op =
+        gutil::FindOrNull(action_plan->params_by_name, param.name());
+    if (op == nullptr) {
+      return gutil::InternalErrorBuilder()
+             << "Could not find action param definition for " << param.name()
+             << ".";
     }
+    RETURN_IF_ERROR(TranslateActionParam(options, *op, action.name(), param));
   }
   return absl::OkStatus();
 }
 
+// `TableDefinition` is either a pdpi::IrTableDefinition or an
+// IrTranslationPlan::Table.
+template <typename TableDefinition>
 absl::Status TranslateActionSet(const TranslateTableEntryOptions& options,
-                                const pdpi::IrTableDefinition& table_def,
+                                const TableDefinition& table_def,
                                 pdpi::IrActionSet& action_set) {
   for (auto& action : *action_set.mutable_actions()) {
     RETURN_IF_ERROR(
@@ -148,7 +208,7 @@ absl::Status TranslateActionSet(const TranslateTableEntryOptions& options,
 
 absl::Status TranslatePortInMatchField(
     TranslationDirection direction,
-    const boost::bimap<std::string, std::string>& port_map,
+    const PortTranslator& port_map,
     pdpi::IrMatch& match) {
   // We expect the port field to be an exact match or optional field.
   switch (match.match_value_case()) {
@@ -170,6 +230,16 @@ absl::Status TranslatePortInMatchField(
   return absl::OkStatus();
 }
 
+absl::Status TranslateMatchField(const TranslateTableEntryOptions& options,
+                                 IrTranslationPlan::Op op,
+                                 pdpi::IrMatch& match) {
+  if (options.translate_port_ids && op == IrTranslationPlan::Op::kPort) {
+    RETURN_IF_ERROR(
+        TranslatePortInMatchField(options.direction, options.port_map, match));
+  }
+  return absl::OkStatus();
+}
+
 absl::Status TranslateMatchField(const TranslateTableEntryOptions& options,
                                  const pdpi::IrTableDefinition& table_def,
                                  pdpi::IrMatch& match) {
@@ -181,13 +251,41 @@ absl::Status TranslateMatchField(const TranslateTableEntryOptions& options,
            << "Could not find match field definition for " << match.name()
            << ".";
   }
+  return TranslateMatchField(options, MatchFieldOp(*match_def), match);
+}
 
-  if (options.translate_port_ids &&
-      IsPortType(match_def->match_field().type_name())) {
-    RETURN_IF_ERROR(
-        TranslatePortInMatchField(options.direction, options.port_map, match));
+absl::Status TranslateMatchField(const TranslateTableEntryOptions& options,
+                                 const IrTranslationPlan::Table& table_plan,
+                                 pdpi::IrMatch& match) {
+  const IrTranslationPlan::Op* op =
+      gutil::FindOrNull(table_plan.match_fields_by_name, match.name());
+  if (op == nullptr) {
+    return gutil::InternalErrorBuilder()
+           << "Could not find match field definition for " << match.name()
+           << ".";
+  }
+  return TranslateMatchField(options, *op, match);
+}
+
+// `TableDefinition` is either a pdpi::IrTableDefinition or an
+// IrTranslationPlan::Table.
+template <typename TableDefinition>
+absl::Status TranslateTableEntryFields(
+    const TranslateTableEntryOptions& options, const TableDefinition& table_def,
+    pdpi::IrTableEntry& entry) {
+  // Handle match fields.
+  for (auto& match : *entry.mutable_matches()) {
+    RETURN_IF_ERROR(TranslateMatchField(options, table_def, match));
   }
 
+  // Handle both a single action, and a action set.
+  if (entry.has_action()) {
+    RETURN_IF_ERROR(
+        TranslateAction(options, table_def, *entry.mutable_action()));
+  } else if (entry.has_action_set()) {
+    RETURN_IF_ERROR(
+        TranslateActionSet(options, table_def, *entry.mutable_action_set()));
+  }
   return absl::OkStatus();
 }
 
@@ -238,36 +336,76 @@ void TranslateIrTableDefForOrchAgent(pdpi::IrTableDefinition& table_def) {
 
 absl::StatusOr<std::string> TranslatePort(
     TranslationDirection direction,
-    const boost::bimap<std::string, std::string>& port_map,
+    const PortTranslator& port_map,
     const std::string& port_key) {
   switch (direction) {
     case TranslationDirection::kForController: {
-      auto value = port_map.left.find(port_key);
-      if (value == port_map.left.end()) {
+      const std::string* value = port_map.NameToId(port_key);
+      if (value == nullptr) {
         return gutil::InvalidArgumentErrorBuilder()
                << "[P4RT App] Cannot translate port '"
                << absl::CHexEscape(port_key)
                << "' to P4RT ID. Has the port been configured with an ID?";
       }
-      return value->second;
+      return *value;
     }
     case TranslationDirection::kForOrchAgent: {
-      auto value = port_map.right.find(port_key);
-      if (value == port_map.right.end()) {
+      const std::string* value = port_map.IdToName(port_key);
+      if (value == nullptr) {
         return gutil::InvalidArgumentErrorBuilder()
                << "[P4RT App] Cannot translate port '"
                << absl::CHexEscape(port_key)
                << "' to SONiC name. Has the port been configured with an ID?";
       }
-      return value->second;
+      return *value;
     }
   }
   return gutil::InternalErrorBuilder() << "Could not translate port because "
                                           "unsupported direction was selected.";
 }
 
+IrTranslationPlan::IrTranslationPlan(const pdpi::IrP4Info& ir_p4_info) {
+  for (const auto& [table_name, table_def] : ir_p4_info.tables_by_name()) {
+    Table& table = tables_by_name_[table_name];
+    for (const auto& [match_name, match_def] :
+         table_def.match_fields_by_name()) {
+      table.match_fields_by_name[match_name] = MatchFieldOp(match_def);
+      if (match_def.match_field().match_type() ==
+              p4::config::v1::MatchField::TERNARY &&
+          match_def.format() == pdpi::Format::IPV6) {
+        table.has_ipv6_ternary_match_field = true;
+      }
+    }
+    for (const auto& entry_action : table_def.entry_actions()) {
+      const pdpi::IrActionDefinition& action_def = entry_action.action();
+      Action& action = table.actions_by_name[action_def.preamble().alias()];
+      for (const auto& [param_name, param_def] : action_def.params_by_name()) {
+        action.params_by_name[param_name] = ActionParamOp(param_def);
+      }
+    }
+  }
+}
+
+const IrTranslationPlan::Table* IrTranslationPlan::FindTable(
+    absl::string_view table_name) const {
+  auto table = tables_by_name_.find(table_name);
+  if (table == tables_by_name_.end()) return nullptr;
+  return &table->second;
+}
+
 absl::Status TranslateTableEntry(const TranslateTableEntryOptions& options,
                                  pdpi::IrTableEntry& entry) {
+  if (options.translation_plan != nullptr) {
+    const IrTranslationPlan::Table* table_plan =
+        options.translation_plan->FindTable(entry.table_name());
+    if (table_plan == nullptr) {
+      return gutil::InternalErrorBuilder()
+             << "Could not find table definition for " << entry.table_name()
+             << ".";
+    }
+    return TranslateTableEntryFields(options, *table_plan, entry);
+  }
+
   // Get the IR table definition for the table entry.
   const pdpi::IrTableDefinition* ir_table_def = gutil::FindOrNull(
       options.ir_p4_info.tables_by_name(), entry.table_name());
@@ -276,22 +414,7 @@ absl::Status TranslateTableEntry(const TranslateTableEntryOptions& options,
            << "Could not find table definition for " << entry.table_name()
            << ".";
   }
-
-  // Handle match fields.
-  for (auto& match : *entry.mutable_matches()) {
-    RETURN_IF_ERROR(TranslateMatchField(options, *ir_table_def, match));
-  }
-
-  // Handle both a single action, and a action set.
-  if (entry.has_action()) {
-    RETURN_IF_ERROR(
-        TranslateAction(options, *ir_table_def, *entry.mutable_action()));
-  } else if (entry.has_action_set()) {
-    RETURN_IF_ERROR(TranslateActionSet(options, *ir_table_def,
-                                       *entry.mutable_action_set()));
-  }
-
-  return absl::OkStatus();
+  return TranslateTableEntryFields(options, *ir_table_def, entry);
 }
 
 absl::Status TranslatePacketReplicationEntry(
@@ -354,7 +477,7 @@ void Convert64BitIpv6AclMatchFieldsTo128Bit(
 absl::StatusOr<pdpi::IrEntity> TranslatePiEntityForOrchAgent(
     const p4::v1::Entity& pi_entity, const pdpi::IrP4Info& ir_p4_info,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator, bool translate_key_only) {
   pdpi::IrEntity ir_entity;
   switch (pi_entity.entity_case()) {
@@ -388,7 +511,7 @@ absl::StatusOr<pdpi::IrEntity> TranslatePiEntityForOrchAgent(
 absl::StatusOr<pdpi::IrTableEntry> TranslatePiTableEntryForOrchAgent(
     const p4::v1::TableEntry& pi_table_entry, const pdpi::IrP4Info& ir_p4_info,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator, bool translate_key_only) {
   auto ir_table_entry =
       pdpi::PiTableEntryToIr(ir_p4_info, pi_table_entry,
@@ -412,7 +535,7 @@ absl::StatusOr<pdpi::IrPacketReplicationEngineEntry>
 TranslatePiPacketReplicationEngineEntryForOrchAgent(
     const p4::v1::PacketReplicationEngineEntry& pi_packet_replication_entry,
     const pdpi::IrP4Info& ir_p4_info, bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator, bool translate_key_only) {
   auto ir_packet_replication_engine_entry =
       pdpi::PiPacketReplicationEngineEntryToIr(
@@ -437,13 +560,14 @@ TranslatePiPacketReplicationEngineEntryForOrchAgent(
 absl::Status UpdateIrEntityForOrchAgent(
     pdpi::IrEntity& ir_entity, const pdpi::IrP4Info& ir_p4_info,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
-    const CpuQueueTranslator& cpu_queue_translator) {
+    const PortTranslator& port_translation_map,
+    const CpuQueueTranslator& cpu_queue_translator,
+    const IrTranslationPlan* translation_plan) {
   switch (ir_entity.entity_case()) {
     case pdpi::IrEntity::kTableEntry:
       RETURN_IF_ERROR(UpdateIrTableEntryForOrchAgent(
           *ir_entity.mutable_table_entry(), ir_p4_info, translate_port_ids,
-          port_translation_map, cpu_queue_translator));
+          port_translation_map, cpu_queue_translator, translation_plan));
       break;
     case pdpi::IrEntity::kPacketReplicationEngineEntry:
       RETURN_IF_ERROR(UpdateIrPacketReplicationEngineEntryForOrchAgent(
@@ -462,12 +586,18 @@ absl::Status UpdateIrEntityForOrchAgent(
 absl::Status UpdateIrTableEntryForOrchAgent(
     pdpi::IrTableEntry& ir_table_entry, const pdpi::IrP4Info& ir_p4_info,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
-    const CpuQueueTranslator& cpu_queue_translator) {
+    const PortTranslator& port_translation_map,
+    const CpuQueueTranslator& cpu_queue_translator,
+    const IrTranslationPlan* translation_plan) {
   // TODO: Remove this when P4Info uses 64-bit IPv6 ACL matchess.
   // We don't allow overwriting of the p4info, so static is ok here.
-
-  Convert64BitIpv6AclMatchFieldsTo128Bit(ir_table_entry);
+  const IrTranslationPlan::Table* table_plan =
+      translation_plan == nullptr
+          ? nullptr
+          : translation_plan->FindTable(ir_table_entry.table_name());
+  if (table_plan == nullptr || table_plan->has_ipv6_ternary_match_field) {
+    Convert64BitIpv6AclMatchFieldsTo128Bit(ir_table_entry);
+  }
   RETURN_IF_ERROR(TranslateTableEntry(
       TranslateTableEntryOptions{
           .direction = TranslationDirection::kForOrchAgent,
@@ -475,6 +605,7 @@ absl::Status UpdateIrTableEntryForOrchAgent(
           .translate_port_ids = translate_port_ids,
           .port_map = port_translation_map,
           .cpu_queue_translator = cpu_queue_translator,
+          .translation_plan = translation_plan,
       },
       ir_table_entry));
   return absl::OkStatus();
@@ -483,7 +614,7 @@ absl::Status UpdateIrTableEntryForOrchAgent(
 absl::Status UpdateIrPacketReplicationEngineEntryForOrchAgent(
     pdpi::IrPacketReplicationEngineEntry& ir_packet_replication_entry,
     const pdpi::IrP4Info& ir_p4_info, bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator) {
   RETURN_IF_ERROR(TranslatePacketReplicationEntry(
       TranslateTableEntryOptions{
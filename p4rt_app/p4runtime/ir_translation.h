@@ -14,32 +14,68 @@
 #ifndef PINS_P4RT_APP_P4RUNTIME_IR_TRANSLATION_H_
 #define PINS_P4RT_APP_P4RUNTIME_IR_TRANSLATION_H_
 
+#include <string>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
-#include "boost/bimap.hpp"
+#include "absl/strings/string_view.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4rt_app/p4runtime/cpu_queue_translator.h"
+#include "p4rt_app/p4runtime/port_translator.h"
 
 namespace p4rt_app {
 
 enum class TranslationDirection { kForController, kForOrchAgent };
 
+// Records how every match field and action parameter in the IrP4Info needs to
+// be translated. The plan is built once per IrP4Info so translating an entry
+// does not need to inspect the field types, or search the table's actions.
+class IrTranslationPlan {
+ public:
+  explicit IrTranslationPlan(const pdpi::IrP4Info& ir_p4_info);
+
+  enum class Op { kNone, kPort, kCpuQueue };
+
+  struct Action {
+    absl::flat_hash_map<std::string, Op> params_by_name;
+  };
+
+  struct Table {
+    absl::flat_hash_map<std::string, Op> match_fields_by_name;
+    absl::flat_hash_map<std::string, Action> actions_by_name;
+
+    // Only tables with an IPv6 ternary match field can need their IPv6 values
+    // converted to 128 bits.
+    bool has_ipv6_ternary_match_field = false;
+  };
+
+  // Returns nullptr if the table does not exist.
+  const Table* FindTable(absl::string_view table_name) const;
+
+ private:
+  absl::flat_hash_map<std::string, Table> tables_by_name_;
+};
+
 struct TranslateTableEntryOptions {
   const TranslationDirection& direction;
   const pdpi::IrP4Info& ir_p4_info;
   bool translate_port_ids = false;
 
-  // boost::bimap<SONiC port name, controller ID>;
-  const boost::bimap<std::string, std::string>& port_map;
+  // Translates between SONiC port names and controller IDs.
+  const PortTranslator& port_map;
   const CpuQueueTranslator& cpu_queue_translator;
+
+  // Optional plan for `ir_p4_info`. When set table entries are translated
+  // using the plan instead of the field definitions.
+  const IrTranslationPlan* translation_plan = nullptr;
 };
 
 // Translates only a port string value.
 absl::StatusOr<std::string> TranslatePort(
     TranslationDirection direction,
-    const boost::bimap<std::string, std::string>& port_map,
+    const PortTranslator& port_map,
     const std::string& port_key);
 
 // Translates all the port fields, and VRF ID in a PDPI IrTableEntry. The
@@ -68,7 +104,7 @@ void Convert64BitIpv6AclMatchFieldsTo128Bit(pdpi::IrTableEntry& ir_table_entry);
 absl::StatusOr<pdpi::IrEntity> TranslatePiEntityForOrchAgent(
     const p4::v1::Entity& pi_entity, const pdpi::IrP4Info& ir_p4_info,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator, bool translate_key_only);
 
 // Translates a PI table entry from the controller into an IR format with field
@@ -76,7 +112,7 @@ absl::StatusOr<pdpi::IrEntity> TranslatePiEntityForOrchAgent(
 absl::StatusOr<pdpi::IrTableEntry> TranslatePiTableEntryForOrchAgent(
     const p4::v1::TableEntry& pi_table_entry, const pdpi::IrP4Info& ir_p4_info,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator, bool translate_key_only);
 
 // Translates a PI packet replication engine entry from the controller into an
@@ -85,7 +121,7 @@ absl::StatusOr<pdpi::IrPacketReplicationEngineEntry>
 TranslatePiPacketReplicationEngineEntryForOrchAgent(
     const p4::v1::PacketReplicationEngineEntry& pi_packet_replication_entry,
     const pdpi::IrP4Info& ir_p4_info, bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator, bool translate_key_only);
 
 // Updates an IR entity from the controller to an IR format with field values
@@ -93,23 +129,25 @@ TranslatePiPacketReplicationEngineEntryForOrchAgent(
 absl::Status UpdateIrEntityForOrchAgent(
     pdpi::IrEntity& ir_entity, const pdpi::IrP4Info& ir_p4_info,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
-    const CpuQueueTranslator& cpu_queue_translator);
+    const PortTranslator& port_translation_map,
+    const CpuQueueTranslator& cpu_queue_translator,
+    const IrTranslationPlan* translation_plan = nullptr);
 
 // Updates a IR table entry from the controller to an IR format with field
 // values consumable by the OA.
 absl::Status UpdateIrTableEntryForOrchAgent(
     pdpi::IrTableEntry& ir_table_entry, const pdpi::IrP4Info& ir_p4_info,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
-    const CpuQueueTranslator& cpu_queue_translator);
+    const PortTranslator& port_translation_map,
+    const CpuQueueTranslator& cpu_queue_translator,
+    const IrTranslationPlan* translation_plan = nullptr);
 
 // Updates a IR packet replication engine entry from the controller to an IR
 // format with field values consumable by the OA.
 absl::Status UpdateIrPacketReplicationEngineEntryForOrchAgent(
     pdpi::IrPacketReplicationEngineEntry& ir_packet_replication_entry,
     const pdpi::IrP4Info& ir_p4_info, bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator);
 
 }  // namespace p4rt_app
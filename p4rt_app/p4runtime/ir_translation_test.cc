@@ -14,7 +14,6 @@
 #include "p4rt_app/p4runtime/ir_translation.h"
 
 #include "absl/strings/string_view.h"
-#include "boost/bimap.hpp"
 #include "gmock/gmock.h"
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
@@ -22,6 +21,7 @@
 #include "gutil/status_matchers.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4rt_app/p4runtime/cpu_queue_translator.h"
+#include "p4rt_app/p4runtime/port_translator.h"
 #include "p4rt_app/utils/ir_builder.h"
 #include "sai_p4/instantiations/google/instantiations.h"
 #include "sai_p4/instantiations/google/sai_p4info.h"
@@ -46,9 +46,9 @@ const CpuQueueTranslator& EmptyCpuQueueTranslator() {
 }
 
 TEST(PortTranslationTest, TranslatePort) {
-  boost::bimap<std::string, std::string> map;
-  map.insert({"key0", "val0"});
-  map.insert({"key1", "val1"});
+  PortTranslator map;
+  map.Insert("key0", "val0");
+  map.Insert("key1", "val1");
   EXPECT_THAT(TranslatePort(TranslationDirection::kForController, map, "key0"),
               IsOkAndHolds("val0"));
   EXPECT_THAT(TranslatePort(TranslationDirection::kForOrchAgent, map, "val0"),
@@ -56,9 +56,9 @@ TEST(PortTranslationTest, TranslatePort) {
 }
 
 TEST(PortTranslationTest, TranslatePortFailsWithMissingKey) {
-  boost::bimap<std::string, std::string> map;
-  map.insert({"key0", "val0"});
-  map.insert({"key1", "val1"});
+  PortTranslator map;
+  map.Insert("key0", "val0");
+  map.Insert("key1", "val1");
   EXPECT_THAT(TranslatePort(TranslationDirection::kForController, map, "key2"),
               StatusIs(absl::StatusCode::kInvalidArgument));
   EXPECT_THAT(TranslatePort(TranslationDirection::kForOrchAgent, map, "val2"),
@@ -66,9 +66,9 @@ TEST(PortTranslationTest, TranslatePortFailsWithMissingKey) {
 }
 
 TEST(PortIdTranslationTest, ActionParameterUpdatedToPortName) {
-  boost::bimap<std::string, std::string> port_translation_map;
-  port_translation_map.insert({"Ethernet0", "1"});
-  port_translation_map.insert({"Ethernet4", "2"});
+  PortTranslator port_translation_map;
+  port_translation_map.Insert("Ethernet0", "1");
+  port_translation_map.Insert("Ethernet4", "2");
 
   pdpi::IrTableEntry table_entry;
   ASSERT_TRUE(TextFormat::ParseFromString(
@@ -96,9 +96,9 @@ TEST(PortIdTranslationTest, ActionParameterUpdatedToPortName) {
 }
 
 TEST(PortIdTranslationTest, WatchPortUpdatedToPortName) {
-  boost::bimap<std::string, std::string> port_translation_map;
-  port_translation_map.insert({"Ethernet0", "1"});
-  port_translation_map.insert({"Ethernet4", "2"});
+  PortTranslator port_translation_map;
+  port_translation_map.Insert("Ethernet0", "1");
+  port_translation_map.Insert("Ethernet4", "2");
 
   pdpi::IrTableEntry table_entry;
   ASSERT_TRUE(TextFormat::ParseFromString(R"pb(
@@ -133,9 +133,9 @@ TEST(PortIdTranslationTest, WatchPortUpdatedToPortName) {
 }
 
 TEST(PortIdTranslationTest, ExactMatchFieldUpdatedToPortName) {
-  boost::bimap<std::string, std::string> port_translation_map;
-  port_translation_map.insert({"Ethernet0", "1"});
-  port_translation_map.insert({"Ethernet4", "2"});
+  PortTranslator port_translation_map;
+  port_translation_map.Insert("Ethernet0", "1");
+  port_translation_map.Insert("Ethernet4", "2");
 
   pdpi::IrTableEntry table_entry;
   ASSERT_TRUE(TextFormat::ParseFromString(
@@ -161,9 +161,9 @@ TEST(PortIdTranslationTest, ExactMatchFieldUpdatedToPortName) {
 }
 
 TEST(PortIdTranslationTest, OptionalMatchFieldUpdatedToPortName) {
-  boost::bimap<std::string, std::string> port_translation_map;
-  port_translation_map.insert({"Ethernet0", "1"});
-  port_translation_map.insert({"Ethernet4", "2"});
+  PortTranslator port_translation_map;
+  port_translation_map.Insert("Ethernet0", "1");
+  port_translation_map.Insert("Ethernet4", "2");
 
   pdpi::IrTableEntry table_entry;
   ASSERT_TRUE(TextFormat::ParseFromString(R"pb(
@@ -305,7 +305,7 @@ TEST(IrTranslationTest, InvalidTableNameFails) {
                                                })pb",
                                           &table_entry));
 
-  boost::bimap<std::string, std::string> port_translation_map;
+  PortTranslator port_translation_map;
   EXPECT_THAT(TranslateTableEntry(
                   TranslateTableEntryOptions{
                       .direction = TranslationDirection::kForOrchAgent,
@@ -332,7 +332,7 @@ TEST(IrTranslationTest, InvalidMatchFieldNameFails) {
         })pb",
       &table_entry));
 
-  boost::bimap<std::string, std::string> port_translation_map;
+  PortTranslator port_translation_map;
   EXPECT_THAT(TranslateTableEntry(
                   TranslateTableEntryOptions{
                       .direction = TranslationDirection::kForOrchAgent,
@@ -356,7 +356,7 @@ TEST(IrTranslationTest, InvalidMatchFieldTypeFails) {
         })pb",
       &table_entry));
 
-  boost::bimap<std::string, std::string> port_translation_map;
+  PortTranslator port_translation_map;
   EXPECT_THAT(TranslateTableEntry(
                   TranslateTableEntryOptions{
                       .direction = TranslationDirection::kForOrchAgent,
@@ -383,7 +383,7 @@ TEST(IrTranslationTest, InvalidActionNameFails) {
         })pb",
       &table_entry));
 
-  boost::bimap<std::string, std::string> port_translation_map;
+  PortTranslator port_translation_map;
   EXPECT_THAT(TranslateTableEntry(
                   TranslateTableEntryOptions{
                       .direction = TranslationDirection::kForOrchAgent,
@@ -410,7 +410,7 @@ TEST(IrTranslationTest, InvalidActionParameterNameFails) {
         })pb",
       &table_entry));
 
-  boost::bimap<std::string, std::string> port_translation_map;
+  PortTranslator port_translation_map;
   EXPECT_THAT(TranslateTableEntry(
                   TranslateTableEntryOptions{
                       .direction = TranslationDirection::kForOrchAgent,
@@ -437,7 +437,7 @@ TEST(IrTranslationTest, ActionParametersWithUnsupportedFormatFails) {
         })pb",
       &table_entry));
 
-  boost::bimap<std::string, std::string> port_translation_map;
+  PortTranslator port_translation_map;
   EXPECT_THAT(TranslateTableEntry(
                   TranslateTableEntryOptions{
                       .direction = TranslationDirection::kForController,
@@ -802,6 +802,206 @@ TEST(TranslateTableEntry, FailsIfAppDbQueueIsNotAString) {
   EXPECT_FALSE(TranslateTableEntry(options, ir_table_entry).ok());
 }
 
+TEST(IrTranslationPlanTest, TranslatesPortsInBothDirections) {
+  PortTranslator port_translation_map;
+  port_translation_map.Insert("Ethernet0", "1");
+  port_translation_map.Insert("Ethernet4", "2");
+  const IrTranslationPlan plan(GetIrP4Info());
+
+  pdpi::IrTableEntry table_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(R"pb(
+                                            table_name: "wcmp_group_table"
+                                            action_set {
+                                              actions {
+                                                action {
+                                                  name: "set_nexthop_id"
+                                                  params {
+                                                    name: "nexthop_id"
+                                                    value { str: "1" }
+                                                  }
+                                                }
+                                                weight: 1
+                                                watch_port: "2"
+                                              }
+                                            })pb",
+                                          &table_entry));
+  const pdpi::IrTableEntry original_entry = table_entry;
+
+  ASSERT_OK(TranslateTableEntry(
+      TranslateTableEntryOptions{
+          .direction = TranslationDirection::kForOrchAgent,
+          .ir_p4_info = GetIrP4Info(),
+          .translate_port_ids = true,
+          .port_map = port_translation_map,
+          .cpu_queue_translator = EmptyCpuQueueTranslator(),
+          .translation_plan = &plan,
+      },
+      table_entry));
+  ASSERT_EQ(table_entry.action_set().actions_size(), 1);
+  EXPECT_EQ(table_entry.action_set().actions(0).watch_port(), "Ethernet4");
+  // The nexthop ID is not a port so it should not change.
+  EXPECT_EQ(
+      table_entry.action_set().actions(0).action().params(0).value().str(),
+      "1");
+
+  ASSERT_OK(TranslateTableEntry(
+      TranslateTableEntryOptions{
+          .direction = TranslationDirection::kForController,
+          .ir_p4_info = GetIrP4Info(),
+          .translate_port_ids = true,
+          .port_map = port_translation_map,
+          .cpu_queue_translator = EmptyCpuQueueTranslator(),
+          .translation_plan = &plan,
+      },
+      table_entry));
+  EXPECT_THAT(table_entry, EqualsProto(original_entry));
+}
+
+TEST(IrTranslationPlanTest, TranslatesPortMatchFieldsAndActionParameters) {
+  PortTranslator port_translation_map;
+  port_translation_map.Insert("Ethernet0", "1");
+  port_translation_map.Insert("Ethernet4", "2");
+  const IrTranslationPlan plan(GetIrP4Info());
+
+  pdpi::IrTableEntry match_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(R"pb(
+                                            table_name: "acl_pre_ingress_table"
+                                            matches {
+                                              name: "in_port"
+                                              optional { value { str: "2" } }
+                                            })pb",
+                                          &match_entry));
+  pdpi::IrTableEntry action_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        table_name: "router_interface_table"
+        action {
+          name: "set_port_and_src_mac"
+          params {
+            name: "port"
+            value { str: "1" }
+          }
+        })pb",
+      &action_entry));
+
+  for (pdpi::IrTableEntry* entry : {&match_entry, &action_entry}) {
+    ASSERT_OK(UpdateIrTableEntryForOrchAgent(
+        *entry, GetIrP4Info(), /*translate_port_ids=*/true,
+        port_translation_map, EmptyCpuQueueTranslator(), &plan));
+  }
+  EXPECT_EQ(match_entry.matches(0).optional().value().str(), "Ethernet4");
+  EXPECT_EQ(action_entry.action().params(0).value().str(), "Ethernet0");
+}
+
+TEST(IrTranslationPlanTest, IgnoresPortsIfTranslationIsDisabled) {
+  const IrTranslationPlan plan(GetIrP4Info());
+  pdpi::IrTableEntry table_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        table_name: "l3_admit_table"
+        matches {
+          name: "in_port"
+          exact { str: "Ethernet0" }
+        })pb",
+      &table_entry));
+  const pdpi::IrTableEntry original_entry = table_entry;
+
+  ASSERT_OK(UpdateIrTableEntryForOrchAgent(
+      table_entry, GetIrP4Info(), /*translate_port_ids=*/false,
+      /*port_translation_map=*/{}, EmptyCpuQueueTranslator(), &plan));
+  EXPECT_THAT(table_entry, EqualsProto(original_entry));
+}
+
+TEST(IrTranslationPlanTest, TranslatesCpuQueues) {
+  const IrTranslationPlan plan(GetIrP4Info());
+  pdpi::IrEntity entity;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        table_entry {
+          table_name: "acl_ingress_table"
+          matches {
+            name: "is_ip"
+            optional { value { hex_str: "0x1" } }
+          }
+          action {
+            name: "acl_trap"
+            params {
+              name: "qos_queue"
+              value { str: "queue15" }
+            }
+          }
+        }
+      )pb",
+      &entity));
+
+  ASSERT_OK_AND_ASSIGN(auto cpu_queue_translator,
+                       CpuQueueTranslator::Create({{"queue15", "15"}}));
+  ASSERT_OK(UpdateIrEntityForOrchAgent(
+      entity, GetIrP4Info(), /*translate_port_ids=*/false,
+      /*port_translation_map=*/{}, *cpu_queue_translator, &plan));
+  EXPECT_EQ(entity.table_entry().action().params(0).value().str(), "0xf");
+}
+
+TEST(IrTranslationPlanTest, Converts64BitIpv6AclMatchFields) {
+  const IrTranslationPlan plan(GetIrP4Info());
+  pdpi::IrTableEntry table_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        table_name: "acl_ingress_table"
+        matches {
+          name: "dst_ipv6"
+          ternary {
+            value { ipv6: "::aaaa:aaaa:aaaa:aaaa" }
+            mask { ipv6: "::ffff:ffff:ffff:ffff" }
+          }
+        }
+        action { name: "acl_drop" }
+      )pb",
+      &table_entry));
+
+  ASSERT_OK(UpdateIrTableEntryForOrchAgent(
+      table_entry, GetIrP4Info(), /*translate_port_ids=*/false,
+      /*port_translation_map=*/{}, EmptyCpuQueueTranslator(), &plan));
+  EXPECT_EQ(table_entry.matches(0).ternary().value().ipv6(),
+            "aaaa:aaaa:aaaa:aaaa::");
+  EXPECT_EQ(table_entry.matches(0).ternary().mask().ipv6(),
+            "ffff:ffff:ffff:ffff::");
+}
+
+TEST(IrTranslationPlanTest, UnknownNamesFail) {
+  const IrTranslationPlan plan(GetIrP4Info());
+  PortTranslator port_translation_map;
+  const TranslateTableEntryOptions options{
+      .direction = TranslationDirection::kForOrchAgent,
+      .ir_p4_info = GetIrP4Info(),
+      .translate_port_ids = true,
+      .port_map = port_translation_map,
+      .cpu_queue_translator = EmptyCpuQueueTranslator(),
+      .translation_plan = &plan,
+  };
+
+  pdpi::IrTableEntry table_entry;
+  table_entry.set_table_name("sample_table");
+  EXPECT_THAT(TranslateTableEntry(options, table_entry),
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("sample_table")));
+
+  table_entry.set_table_name("router_interface_table");
+  table_entry.add_matches()->set_name("sample_match");
+  EXPECT_THAT(TranslateTableEntry(options, table_entry),
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("sample_match")));
+
+  table_entry.clear_matches();
+  table_entry.mutable_action()->set_name("sample_action");
+  EXPECT_THAT(
+      TranslateTableEntry(options, table_entry),
+      StatusIs(absl::StatusCode::kInternal, HasSubstr("sample_action")));
+
+  table_entry.mutable_action()->set_name("set_port_and_src_mac");
+  table_entry.mutable_action()->add_params()->set_name("sample_param");
+  EXPECT_THAT(TranslateTableEntry(options, table_entry),
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("sample_param")));
+}
+
 TEST(TranslatePacketReplication, FailsIfPacketReplicationHasDuplicateReplicas) {
   p4::v1::Entity pi_entity;
   // This packet replication entry is invalid, due to the duplicate replica.
@@ -835,8 +1035,8 @@ TEST(TranslatePacketReplication, TranslatePortInReplicaToOaSuccess) {
       )pb",
       &entry));
 
-  boost::bimap<std::string, std::string> port_translation_map;
-  port_translation_map.insert({"Ethernet0", "1"});
+  PortTranslator port_translation_map;
+  port_translation_map.Insert("Ethernet0", "1");
   TranslateTableEntryOptions options = {
       .direction = TranslationDirection::kForOrchAgent,
       .ir_p4_info = GetIrP4Info(),
@@ -864,9 +1064,9 @@ TEST(TranslatePacketReplication, TranslatePortInReplicaToControllerSuccess) {
       )pb",
       &entry));
 
-  boost::bimap<std::string, std::string> port_translation_map;
-  port_translation_map.insert({"Ethernet0", "1"});
-  port_translation_map.insert({"Ethernet1", "2"});
+  PortTranslator port_translation_map;
+  port_translation_map.Insert("Ethernet0", "1");
+  port_translation_map.Insert("Ethernet1", "2");
   TranslateTableEntryOptions options = {
       .direction = TranslationDirection::kForController,
       .ir_p4_info = GetIrP4Info(),
@@ -893,8 +1093,8 @@ TEST(TranslatePacketReplication, TranslatePortInReplicaToOaMissingPort) {
       )pb",
       &entry));
 
-  boost::bimap<std::string, std::string> port_translation_map;
-  port_translation_map.insert({"Ethernet0", "555"});
+  PortTranslator port_translation_map;
+  port_translation_map.Insert("Ethernet0", "555");
   TranslateTableEntryOptions options = {
       .direction = TranslationDirection::kForController,
       .ir_p4_info = GetIrP4Info(),
@@ -920,9 +1120,9 @@ TEST(TranslatePacketReplication, TranslatesReplicasToOa) {
       )pb",
       &entry));
 
-  boost::bimap<std::string, std::string> port_translation_map;
-  port_translation_map.insert({"Ethernet0", "1"});
-  port_translation_map.insert({"Ethernet1", "2"});
+  PortTranslator port_translation_map;
+  port_translation_map.Insert("Ethernet0", "1");
+  port_translation_map.Insert("Ethernet1", "2");
   auto cpu_queue_translator = EmptyCpuQueueTranslator();
 
   EXPECT_OK(UpdateIrEntityForOrchAgent(
@@ -60,6 +60,11 @@ class MockP4RuntimeImpl : public P4RuntimeImpl {
   MOCK_METHOD(absl::Status, RemovePacketIoPort, (const std::string& port_name),
               (override));
 
+  MOCK_METHOD(absl::Status, UpdatePacketIoPorts,
+              (const std::vector<std::string>& additions,
+               const std::vector<std::string>& removals),
+              (override));
+
   MOCK_METHOD(absl::Status, AddPortTranslation,
               (const std::string& port_name, const std::string& port_id),
               (override));
@@ -67,6 +72,12 @@ class MockP4RuntimeImpl : public P4RuntimeImpl {
   MOCK_METHOD(absl::Status, RemovePortTranslation,
               (const std::string& port_name), (override));
 
+  MOCK_METHOD(absl::Status, UpdatePortTranslations,
+              ((const std::vector<std::pair<std::string, std::string>>&
+                    additions),
+               const std::vector<std::string>& removals),
+              (override));
+
   MOCK_METHOD(absl::Status, VerifyState, (), (override));
 
   MOCK_METHOD(absl::Status, DumpDebugData,
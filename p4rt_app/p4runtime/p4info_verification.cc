@@ -13,6 +13,8 @@
 // limitations under the License.
 #include "p4rt_app/p4runtime/p4info_verification.h"
 
+#include <memory>
+
 #include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
@@ -23,6 +25,7 @@
 #include "p4/config/v1/p4info.pb.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/ir_p4info_cache.h"
 #include "p4rt_app/p4runtime/p4info_verification_schema.h"
 #include "p4rt_app/p4runtime/p4info_verification_schema.pb.h"
 #include "p4rt_app/sonic/app_db_acl_def_table_manager.h"
@@ -111,13 +114,17 @@ absl::Status ValidatePacketIo(const p4::config::v1::P4Info& p4info) {
 
 absl::Status ValidateP4Info(const p4::config::v1::P4Info& p4info) {
   RETURN_IF_ERROR(ValidatePacketIo(p4info));
-  ASSIGN_OR_RETURN(P4InfoVerificationSchema schema, SupportedSchema());
-  ASSIGN_OR_RETURN(auto ir_p4info, pdpi::CreateIrP4Info(p4info),
+  ASSIGN_OR_RETURN(const CompiledSchema* schema, SupportedCompiledSchema());
+  // The P4Info is usually applied right after it is verified, so the IrP4Info
+  // is shared with the one created for the OrchAgent.
+  ASSIGN_OR_RETURN(std::shared_ptr<const pdpi::IrP4Info> cached_ir_p4info,
+                   pdpi::GetOrCreateIrP4Info(p4info),
                    _.SetPayload(kLibraryUrl, absl::Cord("PDPI")));
+  pdpi::IrP4Info ir_p4info = *cached_ir_p4info;
   // We allow arbitrary `@unsupported` entities in the P4Info and reject
   // programming those entities only at runtime.
   pdpi::RemoveUnsupportedEntities(ir_p4info);
-  RETURN_IF_ERROR(IsSupportedBySchema(ir_p4info, schema));
+  RETURN_IF_ERROR(schema->Verify(ir_p4info));
 
   RETURN_IF_ERROR(sonic::ExtractHashPacketFieldConfigs(ir_p4info).status());
   RETURN_IF_ERROR(sonic::ExtractHashParamConfigs(ir_p4info).status());
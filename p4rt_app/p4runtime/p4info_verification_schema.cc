@@ -13,9 +13,14 @@
 // limitations under the License.
 #include "p4rt_app/p4runtime/p4info_verification_schema.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/substitute.h"
 #include "gutil/collections.h"
 #include "gutil/proto.h"
@@ -28,35 +33,6 @@
 
 namespace p4rt_app {
 namespace {
-// Struct version of P4InfoVerificationSchema with name maps.
-struct SchemaMap {
-  struct Table {
-    // Map of match fields by name.
-    absl::flat_hash_map<std::string, MatchSchema> match_schemas;
-    // Map of actions by name.
-    absl::flat_hash_map<std::string, ActionSchema> action_schemas;
-  };
-  // Map of tables by name.
-  absl::flat_hash_map<std::string, Table> tables;
-};
-
-// Return a version of the schema where tables, table actions, and table match
-// fields are mapped by name.
-SchemaMap ToSchemaMap(const P4InfoVerificationSchema& proto_schema) {
-  SchemaMap schema_map;
-  for (const auto& proto_table : proto_schema.tables()) {
-    SchemaMap::Table struct_table;
-    for (const auto& match_field : proto_table.match_fields()) {
-      struct_table.match_schemas[match_field.name()] = match_field;
-    }
-    for (const auto& proto_action : proto_table.actions()) {
-      struct_table.action_schemas[proto_action.name()] = proto_action;
-    }
-    schema_map.tables[proto_table.name()] = struct_table;
-  }
-  return schema_map;
-}
-
 // Return the Schema match type for the provided P4 match type or return an
 // error if the match type is not supported.
 absl::StatusOr<MatchSchema::MatchType> ToSchemaMatchType(
@@ -168,8 +144,8 @@ std::string MatchTypeDescription(MatchSchema::MatchType match_type) {
 
 // Return true if the match field is compatible with the known supported match
 // field.
-absl::Status MatchSchemaIsCompatible(MatchSchema schema,
-                                     MatchSchema supported) {
+absl::Status MatchSchemaIsCompatible(const MatchSchema& schema,
+                                     const MatchSchema& supported) {
   // This should never happen since we check the name before we get here.
   if (schema.name() != supported.name()) {
     return gutil::InternalErrorBuilder() << absl::Substitute(
@@ -199,60 +175,6 @@ absl::Status MatchSchemaIsCompatible(MatchSchema schema,
   return absl::OkStatus();
 }
 
-// Return true if the action is compatible with the known supported action.
-absl::Status ActionSchemaIsCompatible(ActionSchema schema,
-                                      ActionSchema supported) {
-  // This should never happen since we check the name before we get here.
-  if (schema.name() != supported.name()) {
-    return gutil::InternalErrorBuilder() << absl::Substitute(
-               "Attempted to compare configured action '$0' with schema action "
-               "'$1'. This indicates a switch software bug.",
-               schema.name(), supported.name());
-  }
-
-  // Check parameters.
-  absl::flat_hash_map<std::string, const ActionSchema::ParameterSchema*>
-      supported_params;
-  for (const auto& param : supported.parameters()) {
-    supported_params[param.name()] = &param;
-  }
-
-  if (schema.parameters_size() != supported.parameters_size()) {
-    return gutil::InvalidArgumentErrorBuilder() << absl::Substitute(
-               "Invalid parameter set configured in action '$0'. Parameters "
-               "must be exactly [$1].",
-               schema.name(),
-               absl::StrJoin(gutil::Keys(supported_params), ", "));
-  }
-  if (schema.parameters().empty()) return absl::OkStatus();
-
-  for (const auto& schema_param : schema.parameters()) {
-    if (!supported_params.contains(schema_param.name())) {
-      return gutil::NotFoundErrorBuilder() << absl::Substitute(
-                 "Unrecognized parameter '$1' configured in action '$0'. "
-                 "Parameters must be exactly [$2].",
-                 schema.name(), schema_param.name(),
-                 absl::StrJoin(gutil::Keys(supported_params), ", "));
-    }
-    const auto& supported_param = *supported_params.at(schema_param.name());
-    if (schema_param.format() != supported_param.format()) {
-      return gutil::InvalidArgumentErrorBuilder() << absl::Substitute(
-                 "Unsupported format '$2' in action '$0' parameter '$1'. "
-                 "Expected '$3'.",
-                 schema.name(), schema_param.name(),
-                 pdpi::Format_Name(schema_param.format()),
-                 pdpi::Format_Name(supported_param.format()));
-    }
-    if (schema_param.bitwidth() > supported_param.bitwidth()) {
-      return gutil::InvalidArgumentErrorBuilder() << absl::Substitute(
-                 "Configured bitwidth '$2' in action '$0' parameter '$1' is "
-                 "larger than the supported bitwidth '$3'.",
-                 schema.name(), schema_param.name(), schema_param.bitwidth(),
-                 supported_param.bitwidth());
-    }
-  }
-  return absl::OkStatus();
-}
 }  // namespace
 
 // Build the Schema from the IrP4Info or return an error if the IrP4Info cannot
@@ -286,32 +208,82 @@ absl::StatusOr<P4InfoVerificationSchema> SupportedSchema() {
   return schema;
 }
 
-absl::Status IsSupportedBySchema(
-    const pdpi::IrP4Info& ir_p4info,
-    const P4InfoVerificationSchema& supported_schema) {
-  const SchemaMap supported_schema_map = ToSchemaMap(supported_schema);
+CompiledSchema::CompiledSchema(const P4InfoVerificationSchema& schema) {
+  for (const auto& proto_table : schema.tables()) {
+    Table& table = tables_by_name_[proto_table.name()];
+    for (const auto& match_field : proto_table.match_fields()) {
+      table.match_fields_by_name[match_field.name()] = match_field;
+    }
+    for (const auto& proto_action : proto_table.actions()) {
+      Action& action = table.actions_by_name[proto_action.name()];
+      for (const auto& param : proto_action.parameters()) {
+        action.parameters_by_name[param.name()] = param;
+      }
+      std::vector<std::string> parameter_names =
+          gutil::Keys(action.parameters_by_name);
+      std::sort(parameter_names.begin(), parameter_names.end());
+      action.parameter_names = absl::StrJoin(parameter_names, ", ");
+    }
+  }
+}
 
-  ASSIGN_OR_RETURN(P4InfoVerificationSchema schema, ConvertToSchema(ir_p4info));
-  SchemaMap schema_map = ToSchemaMap(schema);
+absl::Status CompiledSchema::ActionIsCompatible(const ActionSchema& action,
+                                                const Action& supported) {
+  if (action.parameters_size() != supported.parameters_by_name.size()) {
+    return gutil::InvalidArgumentErrorBuilder() << absl::Substitute(
+               "Invalid parameter set configured in action '$0'. Parameters "
+               "must be exactly [$1].",
+               action.name(), supported.parameter_names);
+  }
 
-  // The table list should be a subset of the known table tables.
-  for (const auto& [table_name, candidate_table] : schema_map.tables) {
-    const pdpi::IrTableDefinition *ir_table_def =
-      gutil::FindOrNull(ir_p4info.tables_by_name(), table_name);
-    if (ir_table_def == nullptr) {
-      return gutil::NotFoundErrorBuilder()
-             << "Table '" << table_name << "' can not be verified";
+  for (const auto& param : action.parameters()) {
+    const auto* supported_param =
+        gutil::FindOrNull(supported.parameters_by_name, param.name());
+    if (supported_param == nullptr) {
+      return gutil::NotFoundErrorBuilder() << absl::Substitute(
+                 "Unrecognized parameter '$1' configured in action '$0'. "
+                 "Parameters must be exactly [$2].",
+                 action.name(), param.name(), supported.parameter_names);
+    }
+    if (param.format() != supported_param->format()) {
+      return gutil::InvalidArgumentErrorBuilder() << absl::Substitute(
+                 "Unsupported format '$2' in action '$0' parameter '$1'. "
+                 "Expected '$3'.",
+                 action.name(), param.name(), pdpi::Format_Name(param.format()),
+                 pdpi::Format_Name(supported_param->format()));
+    }
+    if (param.bitwidth() > supported_param->bitwidth()) {
+      return gutil::InvalidArgumentErrorBuilder() << absl::Substitute(
+                 "Configured bitwidth '$2' in action '$0' parameter '$1' is "
+                 "larger than the supported bitwidth '$3'.",
+                 action.name(), param.name(), param.bitwidth(),
+                 supported_param->bitwidth());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CompiledSchema::Verify(const pdpi::IrP4Info& ir_p4info) const {
+  for (const auto& [table_name, ir_table] : ir_p4info.tables_by_name()) {
+    ASSIGN_OR_RETURN(table::Type table_type, GetTableType(ir_table),
+                     _.SetPrepend()
+                         << "Failed to process table '" << table_name << "': ");
+    if ((table_type != table::Type::kFixed) &&
+        (table_type != table::Type::kExt)) {
+      continue;
     }
 
-    ASSIGN_OR_RETURN(table::Type table_type, GetTableType(*ir_table_def),
-                     _ << "Failed to get table type for " << table_name << ".");
+    ASSIGN_OR_RETURN(FixedTableSchema candidate_table,
+                     ToTableSchema(table_name, ir_table),
+                     _.SetPrepend()
+                         << "Failed to process table '" << table_name << "': ");
     if (table_type == table::Type::kExt) {
       // Bypass further checks for extension tables
       continue;
     }
 
-    const auto* supported_table =
-        gutil::FindOrNull(supported_schema_map.tables, table_name);
+    const Table* supported_table =
+        gutil::FindOrNull(tables_by_name_, table_name);
     if (supported_table == nullptr) {
       return gutil::NotFoundErrorBuilder()
              << "Table '" << table_name << "' is not a known table."
@@ -320,14 +292,14 @@ absl::Status IsSupportedBySchema(
 
     // The match field list should be a subset of the known table match fields.
     // Each match field should be compatible with the known match field.
-    for (const auto& [match_field_name, candidate_match_field] :
-         candidate_table.match_schemas) {
+    for (const auto& candidate_match_field : candidate_table.match_fields()) {
       const auto* supported_match =
-          gutil::FindOrNull(supported_table->match_schemas, match_field_name);
+          gutil::FindOrNull(supported_table->match_fields_by_name,
+                            candidate_match_field.name());
       if (supported_match == nullptr) {
         return gutil::NotFoundErrorBuilder() << absl::Substitute(
                    "Table '$0' contains unknown match field '$1'.", table_name,
-                   match_field_name);
+                   candidate_match_field.name());
       }
       RETURN_IF_ERROR(
           MatchSchemaIsCompatible(candidate_match_field, *supported_match))
@@ -337,18 +309,16 @@ absl::Status IsSupportedBySchema(
     }
 
     // The action list should be a subset of the known table actions.
-    // Each match field should be compatible with the known match field.
-    for (const auto& [action_name, candidate_action] :
-         candidate_table.action_schemas) {
-      const auto* supported_action =
-          gutil::FindOrNull(supported_table->action_schemas, action_name);
+    // Each action should be compatible with the known action.
+    for (const auto& candidate_action : candidate_table.actions()) {
+      const auto* supported_action = gutil::FindOrNull(
+          supported_table->actions_by_name, candidate_action.name());
       if (supported_action == nullptr) {
         return gutil::NotFoundErrorBuilder()
                << absl::Substitute("Table '$0' contains unknown action '$1'.",
-                                   table_name, action_name);
+                                   table_name, candidate_action.name());
       }
-      RETURN_IF_ERROR(
-          ActionSchemaIsCompatible(candidate_action, *supported_action))
+      RETURN_IF_ERROR(ActionIsCompatible(candidate_action, *supported_action))
               .SetPrepend()
           << absl::Substitute("Table '$0' configuration is invalid: ",
                               table_name);
@@ -357,4 +327,23 @@ absl::Status IsSupportedBySchema(
   return absl::OkStatus();
 }
 
+absl::StatusOr<const CompiledSchema*> SupportedCompiledSchema() {
+  static const absl::StatusOr<CompiledSchema>* const kSupportedSchema =
+      []() {
+        absl::StatusOr<P4InfoVerificationSchema> schema = SupportedSchema();
+        if (!schema.ok()) {
+          return new absl::StatusOr<CompiledSchema>(schema.status());
+        }
+        return new absl::StatusOr<CompiledSchema>(CompiledSchema(*schema));
+      }();
+  if (!kSupportedSchema->ok()) return kSupportedSchema->status();
+  return &**kSupportedSchema;
+}
+
+absl::Status IsSupportedBySchema(
+    const pdpi::IrP4Info& ir_p4info,
+    const P4InfoVerificationSchema& supported_schema) {
+  return CompiledSchema(supported_schema).Verify(ir_p4info);
+}
+
 }  // namespace p4rt_app
@@ -17,6 +17,10 @@
 // This file provides utility functions for working with
 // P4InfoVerificationSchema objects.
 
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4rt_app/p4runtime/p4info_verification_schema.pb.h"
@@ -32,7 +36,42 @@ absl::StatusOr<P4InfoVerificationSchema> ConvertToSchema(
 // tables.
 absl::StatusOr<P4InfoVerificationSchema> SupportedSchema();
 
-// Returns OK if the IrP4Info is supported by the capabilities schema.
+// A P4InfoVerificationSchema compiled into per-table indices of its match
+// fields and actions, so that it can verify any number of IrP4Infos without
+// being rebuilt.
+class CompiledSchema {
+ public:
+  explicit CompiledSchema(const P4InfoVerificationSchema& schema);
+
+  // Returns OK if the IrP4Info is supported by the schema. Each table of the
+  // IrP4Info is converted and checked in a single pass.
+  absl::Status Verify(const pdpi::IrP4Info& ir_p4info) const;
+
+ private:
+  struct Action {
+    absl::flat_hash_map<std::string, ActionSchema::ParameterSchema>
+        parameters_by_name;
+    // The sorted, comma separated parameter names used in error messages.
+    std::string parameter_names;
+  };
+  struct Table {
+    absl::flat_hash_map<std::string, MatchSchema> match_fields_by_name;
+    absl::flat_hash_map<std::string, Action> actions_by_name;
+  };
+
+  // Returns OK if the action is compatible with the supported action.
+  static absl::Status ActionIsCompatible(const ActionSchema& action,
+                                         const Action& supported);
+
+  absl::flat_hash_map<std::string, Table> tables_by_name_;
+};
+
+// Returns the SupportedSchema(), compiled. It is only loaded and compiled once
+// per process.
+absl::StatusOr<const CompiledSchema*> SupportedCompiledSchema();
+
+// Returns OK if the IrP4Info is supported by the capabilities schema. Prefer
+// CompiledSchema when the same schema verifies more than one IrP4Info.
 absl::Status IsSupportedBySchema(
     const pdpi::IrP4Info& ir_p4info,
     const P4InfoVerificationSchema& supported_schema);
@@ -549,6 +549,12 @@ TEST(SupportedSchemaTest, ReturnsASchema) {
       IsOkAndHolds(Property(&P4InfoVerificationSchema::ByteSizeLong, Gt(0))));
 }
 
+TEST(SupportedCompiledSchemaTest, IsOnlyCompiledOnce) {
+  ASSERT_OK_AND_ASSIGN(const CompiledSchema* schema,
+                       SupportedCompiledSchema());
+  EXPECT_THAT(SupportedCompiledSchema(), IsOkAndHolds(schema));
+}
+
 pdpi::IrP4Info IrP4InfoFromSchema(const P4InfoVerificationSchema& schema) {
   IrP4InfoBuilder ir_p4info_builder;
   for (const auto& table : schema.tables()) {
@@ -893,6 +899,14 @@ TEST_P(GoogleInstantiationTest, SchemaSupportsInstantiation) {
   EXPECT_OK(IsSupportedBySchema(p4info, schema));
 }
 
+TEST_P(GoogleInstantiationTest, CompiledSchemaSupportsInstantiation) {
+  pdpi::IrP4Info p4info = sai::GetIrP4Info(GetParam());
+  ASSERT_OK_AND_ASSIGN(const CompiledSchema* schema,
+                       SupportedCompiledSchema());
+  pdpi::RemoveUnsupportedEntities(p4info);
+  EXPECT_OK(schema->Verify(p4info));
+}
+
 INSTANTIATE_TEST_SUITE_P(
     IsSupportedBySchemaTest, GoogleInstantiationTest,
     ValuesIn(sai::AllInstantiations()),
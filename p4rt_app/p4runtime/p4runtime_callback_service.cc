@@ -0,0 +1,211 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "p4rt_app/p4runtime/p4runtime_callback_service.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "glog/logging.h"
+#include "grpcpp/impl/codegen/proto_utils.h"
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/server_callback.h"
+#include "grpcpp/support/slice.h"
+#include "grpcpp/support/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4rt_app/p4runtime/p4runtime_impl.h"
+#include "p4rt_app/p4runtime/sdn_controller_manager.h"
+#include "p4rt_app/utils/task_executor.h"
+
+namespace p4rt_app {
+namespace {
+
+// Lets an executor thread block until a reactor's StartWrite completes. gRPC
+// only allows one outstanding write per stream, and the response must stay
+// alive until the write is done, so callers wait for every write.
+class WriteCompletion {
+ public:
+  void Start() ABSL_LOCKS_EXCLUDED(lock_) {
+    absl::MutexLock l(&lock_);
+    pending_ = true;
+  }
+
+  void Done(bool ok) ABSL_LOCKS_EXCLUDED(lock_) {
+    absl::MutexLock l(&lock_);
+    pending_ = false;
+    ok_ = ok;
+  }
+
+  // Returns false if the write failed (e.g. the stream was cancelled).
+  bool Wait() ABSL_LOCKS_EXCLUDED(lock_) {
+    absl::MutexLock l(&lock_);
+    lock_.Await(absl::Condition(
+        +[](bool* pending) { return !*pending; }, &pending_));
+    return ok_;
+  }
+
+ private:
+  absl::Mutex lock_;
+  bool pending_ ABSL_GUARDED_BY(lock_) = false;
+  bool ok_ ABSL_GUARDED_BY(lock_) = false;
+};
+
+// Parses the request, and streams the serialized Read responses from an
+// executor thread.
+class ReadReactor : public grpc::ServerWriteReactor<grpc::ByteBuffer> {
+ public:
+  ReadReactor(P4RuntimeImpl& server, TaskExecutor& executor,
+              grpc::CallbackServerContext* context,
+              const grpc::ByteBuffer* request) {
+    executor.Schedule([this, &server, context, request] {
+      // Deserializing consumes the buffer, but only its slices are copied.
+      grpc::ByteBuffer request_buffer(*request);
+      p4::v1::ReadRequest read_request;
+      if (grpc::Status status =
+              grpc::SerializationTraits<p4::v1::ReadRequest>::Deserialize(
+                  &request_buffer, &read_request);
+          !status.ok()) {
+        Finish(status);
+        return;
+      }
+      Finish(server.ReadEntities(
+          &read_request,
+          [this](absl::string_view serialized_response) {
+            grpc::Slice slice(serialized_response.data(),
+                              serialized_response.size());
+            grpc::ByteBuffer response(&slice, /*nslices=*/1);
+            write_.Start();
+            StartWrite(&response);
+            return write_.Wait();
+          },
+          context));
+    });
+  }
+
+  void OnWriteDone(bool ok) override { write_.Done(ok); }
+  void OnDone() override { delete this; }
+
+ private:
+  WriteCompletion write_;
+};
+
+// Handles StreamChannel requests on executor threads. Only one read is ever
+// outstanding, and the next read is started after the current request has been
+// handled, so requests from a controller are still handled in order. Responses
+// are written by the SdnConnection's writer thread.
+class StreamChannelReactor
+    : public grpc::ServerBidiReactor<p4::v1::StreamMessageRequest,
+                                     p4::v1::StreamMessageResponse> {
+ public:
+  StreamChannelReactor(P4RuntimeImpl& server, TaskExecutor& executor,
+                       grpc::CallbackServerContext* context)
+      : server_(server),
+        executor_(executor),
+        sdn_connection_(
+            context->peer(),
+            [this](const p4::v1::StreamMessageResponse& response) {
+              write_.Start();
+              StartWrite(&response);
+              return write_.Wait();
+            }) {
+    LOG(INFO) << "StreamChannel is open with peer '" << context->peer() << "'.";
+    StartRead(&request_);
+  }
+
+  void OnReadDone(bool ok) override {
+    executor_.Schedule([this, ok] {
+      if (!ok) {
+        // The peer closed the stream, or it was cancelled.
+        server_.DisconnectStreamChannel(sdn_connection_);
+        Finish(grpc::Status::OK);
+        return;
+      }
+
+      grpc::Status status =
+          server_.HandleStreamMessageRequest(request_, sdn_connection_);
+      if (!status.ok()) {
+        // The connection has already been disconnected, but any pending
+        // responses must be written before finishing.
+        sdn_connection_.CloseStream();
+        Finish(status);
+        return;
+      }
+      StartRead(&request_);
+    });
+  }
+
+  void OnWriteDone(bool ok) override { write_.Done(ok); }
+  void OnDone() override { delete this; }
+
+ private:
+  P4RuntimeImpl& server_;
+  TaskExecutor& executor_;
+  p4::v1::StreamMessageRequest request_;
+  WriteCompletion write_;
+  // Declared last so its writer thread is stopped before `write_` goes away.
+  SdnConnection sdn_connection_;
+};
+
+}  // namespace
+
+// The P4RuntimeImpl unary handlers do not use their ServerContext, so they are
+// called without one.
+grpc::ServerUnaryReactor* P4RuntimeCallbackService::Write(
+    grpc::CallbackServerContext* context, const p4::v1::WriteRequest* request,
+    p4::v1::WriteResponse* response) {
+  grpc::ServerUnaryReactor* reactor = context->DefaultReactor();
+  executor_.Schedule([this, reactor, request, response] {
+    reactor->Finish(server_.Write(/*context=*/nullptr, request, response));
+  });
+  return reactor;
+}
+
+grpc::ServerWriteReactor<grpc::ByteBuffer>* P4RuntimeCallbackService::Read(
+    grpc::CallbackServerContext* context, const grpc::ByteBuffer* request) {
+  return new ReadReactor(server_, executor_, context, request);
+}
+
+grpc::ServerUnaryReactor* P4RuntimeCallbackService::SetForwardingPipelineConfig(
+    grpc::CallbackServerContext* context,
+    const p4::v1::SetForwardingPipelineConfigRequest* request,
+    p4::v1::SetForwardingPipelineConfigResponse* response) {
+  grpc::ServerUnaryReactor* reactor = context->DefaultReactor();
+  executor_.Schedule([this, reactor, request, response] {
+    reactor->Finish(server_.SetForwardingPipelineConfig(/*context=*/nullptr,
+                                                        request, response));
+  });
+  return reactor;
+}
+
+grpc::ServerUnaryReactor* P4RuntimeCallbackService::GetForwardingPipelineConfig(
+    grpc::CallbackServerContext* context,
+    const p4::v1::GetForwardingPipelineConfigRequest* request,
+    p4::v1::GetForwardingPipelineConfigResponse* response) {
+  grpc::ServerUnaryReactor* reactor = context->DefaultReactor();
+  executor_.Schedule([this, reactor, request, response] {
+    reactor->Finish(server_.GetForwardingPipelineConfig(/*context=*/nullptr,
+                                                        request, response));
+  });
+  return reactor;
+}
+
+grpc::ServerBidiReactor<p4::v1::StreamMessageRequest,
+                        p4::v1::StreamMessageResponse>*
+P4RuntimeCallbackService::StreamChannel(grpc::CallbackServerContext* context) {
+  return new StreamChannelReactor(server_, executor_, context);
+}
+
+}  // namespace p4rt_app
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PINS_P4RT_APP_P4RUNTIME_P4RUNTIME_CALLBACK_SERVICE_H_
+#define PINS_P4RT_APP_P4RUNTIME_P4RUNTIME_CALLBACK_SERVICE_H_
+
+#include "grpcpp/server_context.h"
+#include "grpcpp/support/byte_buffer.h"
+#include "grpcpp/support/server_callback.h"
+#include "p4/v1/p4runtime.grpc.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4rt_app/p4runtime/p4runtime_impl.h"
+#include "p4rt_app/utils/task_executor.h"
+
+namespace p4rt_app {
+
+// Serves the P4Runtime API with the gRPC callback API. The sync service ties
+// up a gRPC thread for every in-flight RPC, including every open StreamChannel.
+// Instead, this service runs all request handling on a fixed size executor, so
+// the number of threads does not grow with the number of connected clients.
+//
+// Handlers still run the P4RuntimeImpl logic, so locking and behavior are the
+// same as for the sync service. The only extra threads are the writer thread
+// of each StreamChannel (see SdnConnection).
+//
+// Read responses are assembled from the entity cache's serialized entities, so
+// Read is a raw method that hands those bytes to gRPC without ever parsing the
+// response.
+//
+// Example:
+//   TaskExecutor executor(/*num_threads=*/8);
+//   P4RuntimeCallbackService service(p4runtime_server, executor);
+//   builder.RegisterService(&service);
+class P4RuntimeCallbackService
+    : public p4::v1::P4Runtime::WithRawCallbackMethod_Read<
+          p4::v1::P4Runtime::CallbackService> {
+ public:
+  // Neither the server nor the executor are owned, and both must outlive any
+  // gRPC server the service is registered with.
+  P4RuntimeCallbackService(P4RuntimeImpl& server, TaskExecutor& executor)
+      : server_(server), executor_(executor) {}
+
+  grpc::ServerUnaryReactor* Write(grpc::CallbackServerContext* context,
+                                  const p4::v1::WriteRequest* request,
+                                  p4::v1::WriteResponse* response) override;
+
+  // Takes a serialized ReadRequest, and writes serialized ReadResponses.
+  grpc::ServerWriteReactor<grpc::ByteBuffer>* Read(
+      grpc::CallbackServerContext* context,
+      const grpc::ByteBuffer* request) override;
+
+  grpc::ServerUnaryReactor* SetForwardingPipelineConfig(
+      grpc::CallbackServerContext* context,
+      const p4::v1::SetForwardingPipelineConfigRequest* request,
+      p4::v1::SetForwardingPipelineConfigResponse* response) override;
+
+  grpc::ServerUnaryReactor* GetForwardingPipelineConfig(
+      grpc::CallbackServerContext* context,
+      const p4::v1::GetForwardingPipelineConfigRequest* request,
+      p4::v1::GetForwardingPipelineConfigResponse* response) override;
+
+  grpc::ServerBidiReactor<p4::v1::StreamMessageRequest,
+                          p4::v1::StreamMessageResponse>*
+  StreamChannel(grpc::CallbackServerContext* context) override;
+
+ private:
+  P4RuntimeImpl& server_;
+  TaskExecutor& executor_;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_P4RUNTIME_P4RUNTIME_CALLBACK_SERVICE_H_
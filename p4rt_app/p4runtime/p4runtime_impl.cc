@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <iterator>
 #include <memory>
 #include <optional>
 #include <string>
@@ -24,6 +25,7 @@
 #include <cstring>
 #include <string>
 
+#include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
@@ -33,13 +35,15 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
-#include "boost/bimap.hpp"
+#include "absl/types/span.h"
 #include "glog/logging.h"
+#include "google/protobuf/descriptor.h"
 #include "google/protobuf/util/json_util.h"
 #include "google/protobuf/util/message_differencer.h"
 #include "google/rpc/code.pb.h"
@@ -51,22 +55,31 @@
 #include "gutil/io.h"
 #include "gutil/proto.h"
 #include "gutil/status.h"
+#include "gutil/tracing.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_constraints/backend/constraint_info.h"
-#include "p4_constraints/backend/interpreter.h"
+#include "p4_pdpi/compiled_ir_p4info.h"
 #include "p4_pdpi/entity_keys.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/ir_p4info_cache.h"
+#include "p4_pdpi/shared_ir_p4info.h"
 #include "p4_pdpi/translation_options.h"
 #include "p4rt_app/p4runtime/cpu_queue_translator.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
+#include "p4rt_app/p4runtime/entity_cache_snapshot.h"
 #include "p4rt_app/p4runtime/ir_translation.h"
 #include "p4rt_app/p4runtime/p4info_verification.h"
 #include "p4rt_app/p4runtime/p4runtime_read.h"
 #include "p4rt_app/p4runtime/packetio_helpers.h"
+#include "p4rt_app/p4runtime/port_translator.h"
 #include "p4rt_app/p4runtime/resource_utilization.h"
 #include "p4rt_app/p4runtime/sdn_controller_manager.h"
+#include "p4rt_app/p4runtime/write_capture_ring.h"
+#include "p4rt_app/p4runtime/write_coalescer.h"
 #include "p4rt_app/sonic/adapters/warm_boot_state_adapter.h"
+#include "p4rt_app/sonic/acl_table_definition_cache.h"
 #include "p4rt_app/sonic/app_db_acl_def_table_manager.h"
 #include "p4rt_app/sonic/app_db_manager.h"
 #include "p4rt_app/sonic/hashing.h"
@@ -76,21 +89,21 @@
 #include "p4rt_app/sonic/response_handler.h"
 #include "p4rt_app/sonic/state_verification.h"
 #include "p4rt_app/sonic/vrf_entry_translation.h"
+#include "p4rt_app/utils/latency_histogram.h"
+#include "p4rt_app/utils/lock_contention.h"
 #include "p4rt_app/utils/status_utility.h"
 #include "p4rt_app/utils/table_utility.h"
+#include "p4rt_app/utils/worker_pool.h"
 //TODO(PINS): Add Component/Interface Translator
 /*#include "swss/component_state_helper_interface.h"
 #include "swss/intf_translator.h"*/
 #include "swss/json.h"
+#include "swss/table.h"
 #include <nlohmann/json.hpp>
 
 namespace p4rt_app {
 namespace {
 
-using EntityMap = absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity>;
-using ActionProfileCapacityMap =
-    absl::flat_hash_map<std::string, ActionProfileResourceCapacity>;
-
 grpc::Status EnterCriticalState(const std::string& message) {
   // TODO: report critical state somewhere an don't crash the process.
   LOG(FATAL) << "Entering critical state: " << message;
@@ -185,6 +198,10 @@ p4::v1::StreamMessageResponse GenerateErrorResponse(
 bool P4InfoEquals(const p4::config::v1::P4Info& left,
                   const p4::config::v1::P4Info& right,
                   std::string* diff_report) {
+  // Re-pushing the same P4Info is the common case, and comparing the bytes is
+  // much cheaper than a smart-set comparison.
+  if (left.SerializeAsString() == right.SerializeAsString()) return true;
+
   google::protobuf::util::MessageDifferencer differencer;
   differencer.set_repeated_field_comparison(
       google::protobuf::util::MessageDifferencer::AS_SMART_SET);
@@ -196,12 +213,9 @@ bool P4InfoEquals(const p4::config::v1::P4Info& left,
   return differencer.Compare(left, right);
 }
 
-absl::Status VerifyEntityCacheForExistence(
-    const absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity>& cache,
-    const sonic::AppDbEntry& entry) {
-  bool exists = false;
-  auto iter = cache.find(entry.entity_key);
-  if (iter != cache.end()) exists = true;
+absl::Status VerifyEntityCacheForExistence(const EntityCache& cache,
+                                           const sonic::AppDbEntry& entry) {
+  bool exists = cache.Contains(entry.entity_key);
 
   switch (entry.update_type) {
     case p4::v1::Update::INSERT: {
@@ -244,10 +258,9 @@ absl::Status VerifyEntityCacheForExistence(
 // Prior to updating a table entry in App DB, confirm the table entry does not
 // violate constraints.
 absl::Status ValidateTableEntryConstraints(
-    const p4::v1::TableEntry& entry,
-    const p4_constraints::ConstraintInfo& constraint_info) {
+    const p4::v1::TableEntry& entry, const ConstraintPlan& constraint_plan) {
   absl::StatusOr<std::string> reason_entry_violates_constraint =
-      p4_constraints::ReasonEntryViolatesConstraint(entry, constraint_info);
+      constraint_plan.ReasonEntryViolatesConstraint(entry);
   if (!reason_entry_violates_constraint.ok()) {
     // A status failure implies that the TableEntry was not formatted
     // correctly, so we could not check the constraints.
@@ -267,12 +280,15 @@ absl::Status ValidateTableEntryConstraints(
 }
 
 absl::StatusOr<sonic::AppDbEntry> PiUpdateToAppDbEntry(
-    const pdpi::IrP4Info& p4_info, const p4::v1::Update& pi_update,
-    const std::string& role_name,
-    const p4_constraints::ConstraintInfo& constraint_info,
+    const pdpi::CompiledIrP4Info& compiled_p4_info,
+    const IrTranslationPlan& translation_plan,
+    const sonic::AppDbSerializationPlan& serialization_plan,
+    const p4::v1::Update& pi_update, const std::string& role_name,
+    const ConstraintPlan& constraint_plan,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator) {
+  const pdpi::IrP4Info& p4_info = compiled_p4_info.info();
   const auto pdpi_options = pdpi::TranslationOptions{
       // When deleting we only consider the key. Actions don't matter so we
       // don't waste time trying to translate that part even if the controller
@@ -288,7 +304,7 @@ absl::StatusOr<sonic::AppDbEntry> PiUpdateToAppDbEntry(
   // hardware has successfully programmed the entry. We do the PI to IR
   // translation here so we can efficiently handle the cache.
   auto ir_entity =
-      pdpi::PiEntityToIr(p4_info, pi_update.entity(), pdpi_options);
+      pdpi::PiEntityToIr(compiled_p4_info, pi_update.entity(), pdpi_options);
   if (!ir_entity.ok()) {
     LOG(ERROR) << "PDPI could not translate a PI entity to IR: "
                << pi_update.entity().ShortDebugString();
@@ -296,7 +312,7 @@ absl::StatusOr<sonic::AppDbEntry> PiUpdateToAppDbEntry(
            << "[P4RT/PDPI] " << ir_entity.status().message();
   }
   auto normalized_pi_entry =
-      pdpi::IrEntityToPi(p4_info, *ir_entity, pdpi_options);
+      pdpi::IrEntityToPi(compiled_p4_info, *ir_entity, pdpi_options);
   if (!ir_entity.ok()) {
     LOG(ERROR) << "PDPI could not translate an IR entity to PI: "
                << ir_entity->ShortDebugString();
@@ -311,7 +327,7 @@ absl::StatusOr<sonic::AppDbEntry> PiUpdateToAppDbEntry(
       // If the constraints are not met then we should just report an error
       // (i.e. do not try to handle the entry in lower layers).
       RETURN_IF_ERROR(ValidateTableEntryConstraints(
-          pi_update.entity().table_entry(), constraint_info));
+          pi_update.entity().table_entry(), constraint_plan));
     }
 
     // Verify the table entry can be written to the table.
@@ -326,44 +342,116 @@ absl::StatusOr<sonic::AppDbEntry> PiUpdateToAppDbEntry(
 
   // Apply any custom translation that are needed on the switch side to
   // account for gNMI configs (e.g. port ID translation).
-  RETURN_IF_ERROR(
-      UpdateIrEntityForOrchAgent(*ir_entity, p4_info, translate_port_ids,
-                                 port_translation_map, cpu_queue_translator));
+  RETURN_IF_ERROR(UpdateIrEntityForOrchAgent(
+      *ir_entity, p4_info, translate_port_ids, port_translation_map,
+      cpu_queue_translator, &translation_plan));
 
   ASSIGN_OR_RETURN(auto entity_key,
                    pdpi::EntityKey::MakeEntityKey(*normalized_pi_entry));
-  return sonic::AppDbEntry{
+  sonic::AppDbEntry app_db_entry{
       .entry = *ir_entity,
       .update_type = pi_update.type(),
       .pi_entity = *normalized_pi_entry,
       .entity_key = entity_key,
       .appdb_table = GetAppDbTableType(*ir_entity),
   };
+
+  // Table entries in the P4RT_TABLE need their AppDb key to be written, and
+  // again any time we read their counters. So we compute it once here, and
+  // keep it in the entity cache. Failures are left for the AppDb update to
+  // report.
+  if (app_db_entry.appdb_table == sonic::AppDbTableType::P4RT &&
+      ir_entity->entity_case() == pdpi::IrEntity::kTableEntry) {
+    absl::StatusOr<std::string> app_db_key =
+        sonic::AppDbEntrySerializer(serialization_plan)
+            .P4rtTableKey(ir_entity->table_entry());
+    if (app_db_key.ok()) app_db_entry.app_db_key = *std::move(app_db_key);
+  }
+  return app_db_entry;
+}
+
+// Below this size the cost of waking up the worker threads outweighs the
+// savings of translating entries in parallel.
+constexpr int kMinEntriesForParallelTranslation = 256;
+
+// How long requests wait for the saved config to be committed at startup
+// before they are rejected as UNAVAILABLE.
+constexpr absl::Duration kSavedConfigCommitWait = absl::Seconds(30);
+
+// Translates every update in the request, independent of each other. Large
+// requests are split between the translation pool's threads when one is
+// available.
+std::vector<absl::StatusOr<sonic::AppDbEntry>> TranslateUpdates(
+    const p4::v1::WriteRequest& request,
+    const pdpi::CompiledIrP4Info& compiled_p4_info,
+    const IrTranslationPlan& translation_plan,
+    const sonic::AppDbSerializationPlan& serialization_plan,
+    const ConstraintPlan& constraint_plan,
+    bool translate_port_ids,
+    const PortTranslator& port_translation_map,
+    const CpuQueueTranslator& cpu_queue_translator,
+    WorkerPool* translation_pool) {
+  std::vector<absl::StatusOr<sonic::AppDbEntry>> app_db_entries(
+      request.updates_size(),
+      absl::UnknownError("Update has not been translated."));
+  auto translate = [&](int i) {
+    app_db_entries[i] = PiUpdateToAppDbEntry(
+        compiled_p4_info, translation_plan, serialization_plan,
+        request.updates(i), request.role(),
+        constraint_plan, translate_port_ids, port_translation_map,
+        cpu_queue_translator);
+  };
+
+  if (translation_pool == nullptr ||
+      request.updates_size() < kMinEntriesForParallelTranslation) {
+    for (int i = 0; i < request.updates_size(); ++i) translate(i);
+  } else {
+    translation_pool->ParallelFor(request.updates_size(), translate);
+  }
+  return app_db_entries;
 }
 
+// Translates and validates the request against the entity cache. When the
+// request is coalesced with earlier requests (see WriteCoalescer) the entities
+// they insert are in `pending_inserts`, and `resources_in_batch` holds the
+// action profile resources they use. Otherwise both are empty.
 sonic::AppDbUpdates PiEntityUpdatesToIr(
-    const p4::v1::WriteRequest& request, const pdpi::IrP4Info& p4_info,
-    const EntityMap& entity_cache,
-    const ActionProfileCapacityMap& capacity_by_action_profile_name,
-    const p4_constraints::ConstraintInfo& constraint_info,
+    const p4::v1::WriteRequest& request,
+    const pdpi::CompiledIrP4Info& compiled_p4_info,
+    const IrTranslationPlan& translation_plan,
+    const sonic::AppDbSerializationPlan& serialization_plan,
+    const EntityCache& entity_cache,
+    const ActionProfileCapacityMap& capacity_by_action_profile_id,
+    const ConstraintPlan& constraint_plan,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator,
+    WorkerPool* translation_pool,
+    const absl::flat_hash_set<pdpi::EntityKey>& pending_inserts,
+    absl::flat_hash_map<uint32_t, int64_t>& resources_in_batch,
     pdpi::IrWriteResponse* response) {
+  const pdpi::IrP4Info& p4_info = compiled_p4_info.info();
   absl::flat_hash_set<pdpi::EntityKey> keys_in_request;
   bool has_duplicates = false;
   sonic::AppDbUpdates ir_updates;
-  absl::flat_hash_map<std::string, int64_t> resources_in_batch;
+  ir_updates.serialization_plan = &serialization_plan;
+
+  // Translation only depends on the update itself so it can be done for every
+  // update up front (possibly in parallel). Everything that depends on the
+  // other updates in the batch (i.e. duplicates, cache existence, and capacity)
+  // is still checked in order below.
+  std::vector<absl::StatusOr<sonic::AppDbEntry>> app_db_entries =
+      TranslateUpdates(request, compiled_p4_info, translation_plan,
+                       serialization_plan, constraint_plan, translate_port_ids,
+                       port_translation_map, cpu_queue_translator,
+                       translation_pool);
 
   // Fail on first error.
-  for (const p4::v1::Update& pi_update : request.updates()) {
+  for (absl::StatusOr<sonic::AppDbEntry>& app_db_entry : app_db_entries) {
     pdpi::IrUpdateStatus& entry_status = *response->add_statuses();
 
     // If we cannot translate it then we should just report an error (i.e. do
     // not try to handle it in lower layers).
-    absl::StatusOr<sonic::AppDbEntry> app_db_entry = PiUpdateToAppDbEntry(
-        p4_info, pi_update, request.role(), constraint_info, translate_port_ids,
-        port_translation_map, cpu_queue_translator);
     if (!app_db_entry.ok()) {
       entry_status = GetIrUpdateStatus(app_db_entry.status());
       break;
@@ -375,6 +463,17 @@ sonic::AppDbUpdates PiEntityUpdatesToIr(
     }
     keys_in_request.insert(app_db_entry->entity_key);
 
+    // Deleting an entity inserted by an earlier coalesced request cancels out
+    // the insert, so it never uses any resources.
+    if (app_db_entry->update_type == p4::v1::Update::DELETE &&
+        pending_inserts.contains(app_db_entry->entity_key)) {
+      entry_status = GetIrUpdateStatus(absl::OkStatus());
+      app_db_entry->rpc_index = response->statuses_size() - 1;
+      ir_updates.entries.push_back(*std::move(app_db_entry));
+      ++ir_updates.total_rpc_updates;
+      continue;
+    }
+
     // Verify the entry exists (for MODIFY/DELETE) or not exists (for DELETE)
     // against the cache.
     if (absl::Status cache_verification =
@@ -387,7 +486,7 @@ sonic::AppDbUpdates PiEntityUpdatesToIr(
     absl::StatusOr<sonic::TableResources> resource_change =
         VerifyCapacityAndGetTableResourceChange(
             p4_info, *app_db_entry, entity_cache,
-            capacity_by_action_profile_name, resources_in_batch);
+            capacity_by_action_profile_id, resources_in_batch);
     if (!resource_change.ok()) {
       entry_status = GetIrUpdateStatus(resource_change.status());
       break;
@@ -398,12 +497,12 @@ sonic::AppDbUpdates PiEntityUpdatesToIr(
       // When accounting for the total batch resources we do not assume a MODIFY
       // or DELETE will succeed. So if a request would free resources we act as
       // if it does not (i.e. max of 0).
-      resources_in_batch[resource_change->action_profile->name] +=
+      resources_in_batch[resource_change->action_profile->id] +=
           resource_change->action_profile->total_weight;
     }
     app_db_entry->resource_utilization_change = *resource_change;
     app_db_entry->rpc_index = response->statuses_size() - 1;
-    ir_updates.entries.push_back(*app_db_entry);
+    ir_updates.entries.push_back(*std::move(app_db_entry));
     ++ir_updates.total_rpc_updates;
   }
 
@@ -418,21 +517,19 @@ sonic::AppDbUpdates PiEntityUpdatesToIr(
   }
 
   // Mark any remaining unprocessed updates as aborted.
-  const pdpi::IrUpdateStatus kAborted =
-      GetIrUpdateStatus(absl::StatusCode::kAborted, "Not attempted");
   for (int i = response->statuses().size(); i < request.updates().size(); ++i) {
-    *response->add_statuses() = kAborted;
+    *response->add_statuses() = NotAttemptedIrUpdateStatus();
   }
 
   return ir_updates;
 }
 
 absl::Status UpdateCacheAndUtilizationState(
-    EntityMap& entity_cache,
-    ActionProfileCapacityMap& capacity_by_action_profile_name,
-    const sonic::AppDbUpdates& app_db_updates,
+    EntityCache& entity_cache,
+    ActionProfileCapacityMap& capacity_by_action_profile_id,
+    sonic::AppDbUpdates& app_db_updates,
     const pdpi::IrWriteResponse& results) {
-  for (const sonic::AppDbEntry& app_db_entry : app_db_updates.entries) {
+  for (sonic::AppDbEntry& app_db_entry : app_db_updates.entries) {
     // Lower layers should rervert any state on failure so a failing request
     // should not affect our internal state.
     if (results.statuses(app_db_entry.rpc_index).code() !=
@@ -443,14 +540,14 @@ absl::Status UpdateCacheAndUtilizationState(
     switch (app_db_entry.update_type) {
       case p4::v1::Update::INSERT:
       case p4::v1::Update::MODIFY:
-        entity_cache[app_db_entry.entity_key] = app_db_entry.pi_entity;
+        // The entity is not needed once it is cached, so it is moved in.
+        entity_cache.InsertOrAssign(app_db_entry.entity_key,
+                                    std::move(app_db_entry.pi_entity),
+                                    app_db_entry.app_db_key);
         break;
-      case p4::v1::Update::DELETE: {
-        ASSIGN_OR_RETURN(
-            auto key, pdpi::EntityKey::MakeEntityKey(app_db_entry.pi_entity));
-        entity_cache.erase(key);
+      case p4::v1::Update::DELETE:
+        entity_cache.Erase(app_db_entry.entity_key);
         break;
-      }
       default:
         return gutil::InternalErrorBuilder()
                << "Invalid Update Type: "
@@ -458,14 +555,14 @@ absl::Status UpdateCacheAndUtilizationState(
     }
 
     if (app_db_entry.resource_utilization_change.action_profile.has_value()) {
-      const std::string& profile_name =
-          app_db_entry.resource_utilization_change.action_profile->name;
+      const sonic::ActionProfileResources& profile =
+          *app_db_entry.resource_utilization_change.action_profile;
       auto* utilization =
-          gutil::FindOrNull(capacity_by_action_profile_name, profile_name);
+          gutil::FindOrNull(capacity_by_action_profile_id, profile.id);
       if (utilization == nullptr) {
         return gutil::InternalErrorBuilder()
                << "Could not find action profile utilization for '"
-               << profile_name << "' which needs to be updated.";
+               << profile.name << "' which needs to be updated.";
       }
       utilization->current_utilization +=
           app_db_entry.resource_utilization_change.action_profile->total_weight;
@@ -474,45 +571,100 @@ absl::Status UpdateCacheAndUtilizationState(
   return absl::OkStatus();
 }
 
-absl::StatusOr<absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity>>
-RebuildEntityEntryCache(
-    const pdpi::IrP4Info& p4_info, bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+// Translates a P4RT_TABLE entry read from the AppDb back into the PI table
+// entry the controller originally sent.
+absl::StatusOr<p4::v1::TableEntry> AppDbTableEntryToPi(
+    const pdpi::IrP4Info& p4_info, const IrTranslationPlan& translation_plan,
+    bool translate_port_ids,
+    const PortTranslator& port_translation_map,
+    const CpuQueueTranslator& cpu_queue_translator,
+    pdpi::IrTableEntry ir_table_entry) {
+  RETURN_IF_ERROR(TranslateTableEntry(
+      TranslateTableEntryOptions{
+          .direction = TranslationDirection::kForController,
+          .ir_p4_info = p4_info,
+          .translate_port_ids = translate_port_ids,
+          .port_map = port_translation_map,
+          .cpu_queue_translator = cpu_queue_translator,
+          .translation_plan = &translation_plan,
+      },
+      ir_table_entry));
+
+  // The AppDb only holds entries that were validated when P4RT wrote them.
+  auto p4rt_entry = pdpi::IrTableEntryToPi(
+      p4_info, ir_table_entry, pdpi::TranslationOptions{.trusted_input = true});
+  if (!p4rt_entry.ok()) {
+    LOG(ERROR) << "PDPI could not translate IR table entry to PI: "
+               << ir_table_entry.ShortDebugString();
+    return gutil::StatusBuilder(p4rt_entry.status().code())
+           << "[P4RT/PDPI] " << p4rt_entry.status().message();
+  }
+  p4rt_entry->clear_counter_data();
+  p4rt_entry->clear_meter_counter_data();
+  return p4rt_entry;
+}
+
+absl::StatusOr<EntityCache> RebuildEntityEntryCache(
+    const pdpi::IrP4Info& p4_info, const IrTranslationPlan& translation_plan,
+    bool translate_port_ids,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator,
-    sonic::P4rtTable& p4rt_table, sonic::VrfTable& vrf_table) {
-  absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity> cache;
+    sonic::P4rtTable& p4rt_table, sonic::VrfTable& vrf_table,
+    WorkerPool* translation_pool) {
+  // P4RT_TABLE entries are read, and translated, in chunks. Each chunk is
+  // fetched with pipelined AppDb requests, and then translated (possibly in
+  // parallel). This bounds the memory used for in-flight entries.
+  constexpr int kRebuildChunkSize = 4096;
+
+  EntityCache::EntityMap cache;
+  EntityCache::AppDbKeyMap app_db_keys;
   // Get all P4RT keys associated with IrTableEntry objects from the AppDb.
-  for (const auto& app_db_key : sonic::GetAllP4TableEntryKeys(p4rt_table)) {
-    // Read a single table entry out of the AppDb
-    ASSIGN_OR_RETURN(pdpi::IrTableEntry ir_table_entry,
-                     sonic::ReadP4TableEntry(p4rt_table, p4_info, app_db_key));
-    RETURN_IF_ERROR(TranslateTableEntry(
-        TranslateTableEntryOptions{
-            .direction = TranslationDirection::kForController,
-            .ir_p4_info = p4_info,
-            .translate_port_ids = translate_port_ids,
-            .port_map = port_translation_map,
-            .cpu_queue_translator = cpu_queue_translator,
-        },
-        ir_table_entry));
+  const std::vector<std::string> all_keys =
+      sonic::GetAllP4TableEntryKeys(p4rt_table);
+  for (int chunk_start = 0; chunk_start < all_keys.size();
+       chunk_start += kRebuildChunkSize) {
+    const std::vector<std::string> keys(
+        all_keys.begin() + chunk_start,
+        all_keys.begin() +
+            std::min<int>(chunk_start + kRebuildChunkSize, all_keys.size()));
+
+    std::vector<absl::StatusOr<pdpi::IrTableEntry>> ir_table_entries =
+        sonic::ReadP4TableEntries(p4rt_table, p4_info, keys);
+    std::vector<absl::StatusOr<p4::v1::TableEntry>> pi_table_entries(
+        keys.size(), absl::UnknownError("Entry has not been translated."));
+    auto translate = [&](int i) {
+      if (!ir_table_entries[i].ok()) {
+        pi_table_entries[i] = ir_table_entries[i].status();
+        return;
+      }
+      pi_table_entries[i] = AppDbTableEntryToPi(
+          p4_info, translation_plan, translate_port_ids, port_translation_map,
+          cpu_queue_translator, *std::move(ir_table_entries[i]));
+    };
+    if (translation_pool == nullptr ||
+        keys.size() < kMinEntriesForParallelTranslation) {
+      for (int i = 0; i < keys.size(); ++i) translate(i);
+    } else {
+      translation_pool->ParallelFor(keys.size(), translate);
+    }
 
-    auto p4rt_entry = pdpi::IrTableEntryToPi(p4_info, ir_table_entry);
-    if (!p4rt_entry.ok()) {
-      LOG(ERROR) << "PDPI could not translate IR table entry to PI: "
-                 << ir_table_entry.ShortDebugString();
-      return gutil::StatusBuilder(p4rt_entry.status().code())
-             << "[P4RT/PDPI] " << p4rt_entry.status().message();
+    // Entries are added in key order so the first failure is still reported.
+    for (int i = 0; i < keys.size(); ++i) {
+      if (!pi_table_entries[i].ok()) return pi_table_entries[i].status();
+      pdpi::EntityKey entity_key(*pi_table_entries[i]);
+      *cache[entity_key].mutable_table_entry() =
+          *std::move(pi_table_entries[i]);
+      app_db_keys[entity_key] = keys[i];
     }
-    (*p4rt_entry).clear_counter_data();
-    (*p4rt_entry).clear_meter_counter_data();
-    *cache[pdpi::EntityKey(*p4rt_entry)].mutable_table_entry() = *p4rt_entry;
   }
 
   // Get all VRF_TABLE entries from the AppDb.
   ASSIGN_OR_RETURN(std::vector<pdpi::IrTableEntry> vrf_entries,
                    sonic::GetAllAppDbVrfTableEntries(vrf_table));
   for (const auto& ir_table_entry : vrf_entries) {
-    auto vrf_entry = pdpi::IrTableEntryToPi(p4_info, ir_table_entry);
+    auto vrf_entry =
+        pdpi::IrTableEntryToPi(p4_info, ir_table_entry,
+                               pdpi::TranslationOptions{.trusted_input = true});
     if (!vrf_entry.ok()) {
       LOG(ERROR) << "PDPI could not translate IR table entry to PI: "
                  << ir_table_entry.ShortDebugString();
@@ -550,35 +702,39 @@ RebuildEntityEntryCache(
     cache[entity_key] = pi_entity;
   }
 
-  return cache;
+  return EntityCache(std::move(cache), std::move(app_db_keys));
 }
 
 std::vector<pdpi::IrEntity> GetIrEntitiesFromCache(
-    const absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity>& entity_cache,
-    const pdpi::IrP4Info& ir_p4_info, bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const EntityCache& entity_cache, const pdpi::IrP4Info& ir_p4_info,
+    bool translate_port_ids,
+    const PortTranslator& port_translation_map,
     const CpuQueueTranslator& cpu_queue_translator,
     const p4::v1::Entity::EntityCase entity_type,
     std::vector<std::string>& failures) {
   // Translate the Entity cache into IR entries for comparison.
   std::vector<pdpi::IrEntity> ir_entries;
   int failure_count = 0;
-  for (const auto& [_, pi_entity] : entity_cache) {
-    if (entity_type != pi_entity.entity_case()) {
-      continue;
-    }
-    auto ir_entity = TranslatePiEntityForOrchAgent(
-        pi_entity, ir_p4_info, translate_port_ids, port_translation_map,
-        cpu_queue_translator, /*translate_key_only=*/false);
-    if (!ir_entity.ok()) {
-      failure_count++;
-      continue;
-    }
-    if (GetAppDbTableType(*ir_entity) != sonic::AppDbTableType::P4RT) {
-      continue;
-    }
-    ir_entries.push_back(*std::move(ir_entity));
-  }
+  // The visitor never fails so we can ignore the status.
+  entity_cache
+      .ForEachEntityOfType(
+          entity_type,
+          [&](const p4::v1::Entity& pi_entity) -> absl::Status {
+            auto ir_entity = TranslatePiEntityForOrchAgent(
+                pi_entity, ir_p4_info, translate_port_ids,
+                port_translation_map, cpu_queue_translator,
+                /*translate_key_only=*/false);
+            if (!ir_entity.ok()) {
+              failure_count++;
+              return absl::OkStatus();
+            }
+            if (GetAppDbTableType(*ir_entity) != sonic::AppDbTableType::P4RT) {
+              return absl::OkStatus();
+            }
+            ir_entries.push_back(*std::move(ir_entity));
+            return absl::OkStatus();
+          })
+      .IgnoreError();
   if (failure_count > 0) {
     failures.push_back(absl::StrCat("Failed to translate ", failure_count,
                                     " for entity type ", entity_type,
@@ -587,6 +743,280 @@ std::vector<pdpi::IrEntity> GetIrEntitiesFromCache(
   return ir_entries;
 }
 
+// We do a bit of bookkeeping, before sending our final response to the
+// controller, so that we can ensure correct fail on first semantics. Each
+// layer gets a chance at a "first" failure so it is possible to have multiple
+// failures (not including the ABORTED ones) in a batch.
+//
+// Consider the following case where we get a batch of 10 entries:
+//   1. P4RT App fails to translate entry 6 and thus marks entries
+//      7-10 as ABORTED.
+//   2. SWSS then only sees entries 1-5 for which it fails on entry 3.
+//      Therefore, marking entries 4 and 5 as ABORTED.
+//
+// In the response to the controller entry 6 would have a non-ABORTED error.
+//
+// Returns true if any update failed.
+bool AbortFailuresAfterTheFirst(pdpi::IrWriteResponse& response) {
+  auto* statuses = response.mutable_statuses();
+  auto first_failure =
+      std::find_if(statuses->begin(), statuses->end(),
+                   [](const pdpi::IrUpdateStatus& status) {
+                     return status.code() != google::rpc::OK;
+                   });
+  if (first_failure == statuses->end()) return false;
+
+  for (auto rpc_error = std::next(first_failure); rpc_error != statuses->end();
+       ++rpc_error) {
+    if (rpc_error->code() == google::rpc::OK ||
+        rpc_error->code() == google::rpc::ABORTED) {
+      continue;
+    }
+    LOG_IF(WARNING, rpc_error.code() != google::rpc::ABORTED)
+        << "Found an error that should be marked ABORTED. This is expected "
+           "if a higher layer rejects one flow in a batch and a lower layer "
+           "rejects another: "
+        << rpc_error->message();
+    rpc_error->set_code(google::rpc::ABORTED);
+  }
+  return true;
+}
+
+// Converts a Write response into the status returned to the controller. Fully
+// successful responses, the common case, skip the PDPI conversion since they
+// carry no per-update details.
+absl::StatusOr<grpc::Status> WriteRpcStatusToGrpcStatus(
+    const pdpi::IrWriteRpcStatus& rpc_status, bool any_update_failed) {
+  if (!any_update_failed && rpc_status.has_rpc_response()) {
+    return grpc::Status::OK;
+  }
+  return pdpi::IrWriteRpcStatusToGrpcStatus(rpc_status);
+}
+
+// Time spent in each stage of a single Write() request.
+struct WriteStageTimes {
+  absl::Duration translate;
+  sonic::AppDbUpdateTimes app_db;
+  absl::Duration cache_update;
+};
+
+void RecordStageLatencies(const WriteStageTimes& times,
+                          WriteStageLatencies& latencies) {
+  latencies.translate.Record(times.translate);
+  latencies.app_db_publish.Record(times.app_db.publish);
+  latencies.orch_agent_wait.Record(times.app_db.response_wait);
+  latencies.cache_update.Record(times.cache_update);
+}
+
+void RecordWriteLatencies(const sonic::AppDbUpdates& app_db_updates,
+                          absl::Duration total, const WriteStageTimes& times,
+                          WriteLatencyStatistics& write_latency) {
+  write_latency.total.Record(total);
+  RecordStageLatencies(times, write_latency.stages);
+
+  // A batch is only counted once for each entity type, or table, it touches.
+  absl::flat_hash_set<std::string> entity_types;
+  absl::flat_hash_set<std::string> tables;
+  for (const auto& entry : app_db_updates.entries) {
+    const google::protobuf::FieldDescriptor* entity_field =
+        pdpi::IrEntity::descriptor()->FindFieldByNumber(
+            entry.entry.entity_case());
+    if (entity_field != nullptr) entity_types.insert(entity_field->name());
+    if (entry.entry.has_table_entry()) {
+      tables.insert(entry.entry.table_entry().table_name());
+    }
+  }
+  for (const std::string& entity_type : entity_types) {
+    RecordStageLatencies(times,
+                         write_latency.stages_by_entity_type[entity_type]);
+  }
+  for (const std::string& table : tables) {
+    RecordStageLatencies(times, write_latency.stages_by_table[table]);
+  }
+}
+
+void RecordPacketInLatencies(absl::string_view port_name,
+                             absl::Duration queueing, absl::Duration processing,
+                             PacketInLatencyStatistics& packet_in_latency) {
+  for (PacketInLatencies* latencies :
+       {&packet_in_latency.total,
+        &packet_in_latency.by_port[std::string(port_name)]}) {
+    latencies->queueing.Record(queueing);
+    latencies->processing.Record(processing);
+  }
+}
+
+void AppendLatencyFields(
+    absl::string_view name, const LatencyHistogram& histogram,
+    std::vector<std::pair<std::string, std::string>>& fields) {
+  fields.push_back(
+      {absl::StrCat(name, "-count"), absl::StrCat(histogram.count())});
+  for (int percentile : {50, 90, 99}) {
+    fields.push_back(
+        {absl::StrCat(name, "-p", percentile, "-us"),
+         absl::StrCat(
+             absl::ToInt64Microseconds(histogram.Percentile(percentile)))});
+  }
+  fields.push_back({absl::StrCat(name, "-max-us"),
+                    absl::StrCat(absl::ToInt64Microseconds(histogram.max()))});
+}
+
+std::vector<std::pair<std::string, std::string>> PacketInLatencyFields(
+    const PacketInLatencies& latencies, const std::string& timestamp) {
+  std::vector<std::pair<std::string, std::string>> fields;
+  AppendLatencyFields("queueing", latencies.queueing, fields);
+  AppendLatencyFields("processing", latencies.processing, fields);
+  fields.push_back({"last-update-timestamp", timestamp});
+  return fields;
+}
+
+std::vector<std::pair<std::string, std::string>> StageLatencyFields(
+    const WriteStageLatencies& latencies, const std::string& timestamp) {
+  std::vector<std::pair<std::string, std::string>> fields;
+  AppendLatencyFields("translate", latencies.translate, fields);
+  AppendLatencyFields("app-db-publish", latencies.app_db_publish, fields);
+  AppendLatencyFields("orch-agent-wait", latencies.orch_agent_wait, fields);
+  AppendLatencyFields("cache-update", latencies.cache_update, fields);
+  fields.push_back({"last-update-timestamp", timestamp});
+  return fields;
+}
+
+void AppendStageLatencies(absl::string_view name,
+                          const WriteStageLatencies& latencies,
+                          std::string& report) {
+  absl::StrAppend(&report, name, ":\n");
+  absl::StrAppend(&report, "  translate: ", latencies.translate.Summary(),
+                  "\n");
+  absl::StrAppend(&report,
+                  "  app-db-publish: ", latencies.app_db_publish.Summary(),
+                  "\n");
+  absl::StrAppend(&report,
+                  "  orch-agent-wait: ", latencies.orch_agent_wait.Summary(),
+                  "\n");
+  absl::StrAppend(&report, "  cache-update: ", latencies.cache_update.Summary(),
+                  "\n");
+}
+
+std::string RuntimeIntrospectionReport(
+    const RuntimeIntrospection& introspection) {
+  std::string report =
+      absl::StrCat("Timestamp: ", absl::FormatTime(absl::Now()), "\n");
+
+  absl::StrAppend(&report, "\nLock contention\n");
+  absl::StrAppend(&report, "server_state_lock: ",
+                  introspection.server_state_lock.ToString(), "\n");
+  absl::StrAppend(&report, "controller_manager_lock: ",
+                  introspection.controller_manager_lock.ToString(), "\n");
+
+  absl::StrAppend(&report, "\nQueues\n");
+  absl::StrAppend(
+      &report, "outstanding writes: ",
+      introspection.write_admission.outstanding_batches, " batches, ",
+      introspection.write_admission.outstanding_updates, " updates\n");
+  absl::StrAppend(&report, "orch-agent latency (moving average): ",
+                  absl::FormatDuration(
+                      introspection.write_admission.orch_agent_latency),
+                  "\n");
+  absl::StrAppend(&report, "rejected writes: ",
+                  introspection.write_admission.rejected_batches, "\n");
+  absl::StrAppend(&report, "queued packet-ins: ",
+                  introspection.packetio_queue.queued_packet_ins, ", dropped: ",
+                  introspection.packetio_queue.dropped_packet_ins,
+                  ", rate limited: ",
+                  introspection.packetio_queue.rate_limited_packet_ins, "\n");
+  for (const auto& [port_name, drops] :
+       introspection.packetio_queue.rate_limited_packet_ins_by_port) {
+    absl::StrAppend(&report, "  rate limited on ", port_name, ": ", drops,
+                    "\n");
+  }
+
+  absl::StrAppend(&report, "\nPacketIn latency since the last publish\n");
+  absl::StrAppend(&report, "queueing: ",
+                  introspection.packet_in_latency.total.queueing.Summary(),
+                  "\n");
+  absl::StrAppend(&report, "processing: ",
+                  introspection.packet_in_latency.total.processing.Summary(),
+                  "\n");
+  for (const auto& [port_name, latencies] :
+       introspection.packet_in_latency.by_port) {
+    absl::StrAppend(&report, "  ", port_name,
+                    " queueing: ", latencies.queueing.Summary(),
+                    ", processing: ", latencies.processing.Summary(), "\n");
+  }
+
+  absl::StrAppend(&report, "\nRead requests since the last statistics read\n");
+  absl::StrAppend(&report, "count: ", introspection.read_request_count,
+                  ", time: ", absl::FormatDuration(introspection.read_time),
+                  "\n");
+
+  absl::StrAppend(&report, "\nWrite latency since the last statistics read\n");
+  absl::StrAppend(&report,
+                  "total: ", introspection.write_latency.total.Summary(), "\n");
+  AppendStageLatencies("stages", introspection.write_latency.stages, report);
+  for (const auto& [entity_type, latencies] :
+       introspection.write_latency.stages_by_entity_type) {
+    AppendStageLatencies(absl::StrCat("entity ", entity_type), latencies,
+                         report);
+  }
+  for (const auto& [table, latencies] :
+       introspection.write_latency.stages_by_table) {
+    AppendStageLatencies(absl::StrCat("table ", table), latencies, report);
+  }
+  return report;
+}
+
+absl::StatusOr<p4_constraints::ConstraintInfo> CreateConstraintInfo(
+    const p4::config::v1::P4Info& p4info) {
+  auto constraint_info = p4_constraints::P4ToConstraintInfo(p4info);
+  if (!constraint_info.ok()) {
+    LOG(WARNING) << "Could not get constraint info from P4Info: "
+                 << constraint_info.status();
+    return absl::Status(constraint_info.status().code(),
+                        absl::StrCat("[P4 Constraint] ",
+                                     constraint_info.status().message()));
+  }
+  return *std::move(constraint_info);
+}
+
+// The number of distinct actions, and of WCMP action sets, whose translations
+// are remembered. Route tables share few of them (i.e. nexthops and groups)
+// between many entries.
+constexpr int kActionTranslationCacheCapacity = 4096;
+
+// Returns the IrP4Info used to translate requests for the OrchAgent.
+absl::StatusOr<pdpi::SharedIrP4Info> CreateIrP4InfoForOrchAgent(
+    const p4::config::v1::P4Info& p4info) {
+  // Shares the IrP4Info created when the P4Info was verified.
+  auto cached_ir_p4info = pdpi::GetOrCreateIrP4Info(p4info);
+  if (!cached_ir_p4info.ok()) {
+    LOG(WARNING) << "Could not convert P4Info into IrP4Info: "
+                 << cached_ir_p4info.status();
+    return absl::Status(
+        cached_ir_p4info.status().code(),
+        absl::StrCat("[P4RT/PDPI] ", cached_ir_p4info.status().message()));
+  }
+  pdpi::IrP4Info ir_p4info = **cached_ir_p4info;
+  // Remove `@unsupported` entities so their use in requests will be rejected.
+  pdpi::RemoveUnsupportedEntities(ir_p4info);
+  TranslateIrP4InfoForOrchAgent(ir_p4info);
+  return pdpi::SharedIrP4Info(std::move(ir_p4info),
+                              kActionTranslationCacheCapacity);
+}
+
+// Waits for the OrchAgent to respond to an ACL table definition update.
+absl::Status WaitForAclTableDefinitionResponse(
+    sonic::P4rtTable& p4rt_table, absl::StatusOr<std::string> acl_key) {
+  RETURN_IF_ERROR(acl_key.status());
+  ASSIGN_OR_RETURN(
+      pdpi::IrUpdateStatus status,
+      sonic::GetAndProcessResponseNotificationWithoutRevertingState(
+          *p4rt_table.notification_consumer, *acl_key));
+  if (status.code() != google::rpc::OK) {
+    return gutil::InvalidArgumentErrorBuilder() << status.message();
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 P4RuntimeImpl::P4RuntimeImpl(
@@ -608,19 +1038,57 @@ P4RuntimeImpl::P4RuntimeImpl(
       host_stats_table_(std::move(host_stats_table)),
       warm_boot_state_adapter_(std::move(warm_boot_state_adapter)),
       forwarding_config_full_path_(p4rt_options.forwarding_config_full_path),
+      entity_cache_snapshot_path_(p4rt_options.entity_cache_snapshot_path),
+      acl_table_definition_cache_path_(
+          p4rt_options.acl_table_definition_cache_path),
       packetio_impl_(std::move(packetio_impl)),
 //TODO(PINS): To add component_state, system_state and netdev_translator.
 /*      component_state_(component_state),
       system_state_(system_state),
       netdev_translator_(netdev_translator), */
       translate_port_ids_(p4rt_options.translate_port_ids),
+      read_response_max_bytes_(p4rt_options.read_response_max_bytes),
+      write_coalescing_window_(p4rt_options.write_coalescing_window),
+      app_db_publish_policy_(p4rt_options.app_db_publish_policy),
+      write_admission_(p4rt_options.write_admission),
       cpu_queue_translator_(CpuQueueTranslator::Empty()),
       is_freeze_mode_(p4rt_options.is_freeze_mode) {
   absl::optional<std::string> init_failure;
 
+  if (p4rt_options.acl_counter_cache_max_staleness > absl::ZeroDuration()) {
+    acl_counter_cache_ = std::make_unique<AclCounterCache>(
+        p4rt_options.acl_counter_cache_max_staleness,
+        p4rt_options.acl_counter_cache_idle_timeout);
+  }
+
+  if (p4rt_options.write_translation_threads > 0) {
+    translation_pool_ =
+        std::make_unique<WorkerPool>(p4rt_options.write_translation_threads);
+  }
+  if (p4rt_options.read_threads > 0) {
+    read_pool_ = std::make_unique<WorkerPool>(p4rt_options.read_threads);
+  }
+
+  // Capturing writes is a debugging aid, so P4RT keeps running without it.
+  if (p4rt_options.write_capture_path.has_value()) {
+    absl::StatusOr<std::unique_ptr<WriteCaptureRing>> ring =
+        WriteCaptureRing::Create(*p4rt_options.write_capture_path,
+                                 p4rt_options.write_capture_bytes);
+    if (ring.ok()) {
+      write_capture_ring_ = *std::move(ring);
+    } else {
+      LOG(ERROR) << "Could not create the write capture ring: "
+                 << ring.status();
+    }
+  }
+
   // Start the controller manager.
   controller_manager_ = absl::make_unique<SdnControllerManager>();
 
+  if (!p4rt_options.commit_saved_config_at_startup) {
+    saved_config_committed_.Notify();
+  }
+
   // Spawn the receiver thread to receive In packets.
   auto status_or = StartReceive(p4rt_options.use_genetlink);
   if (status_or.ok()) {
@@ -631,85 +1099,404 @@ P4RuntimeImpl::P4RuntimeImpl(
   }
 }
 
+P4RuntimeImpl::~P4RuntimeImpl() {
+  if (snapshot_verification_thread_.joinable()) {
+    snapshot_verification_thread_.join();
+  }
+}
+
 grpc::Status P4RuntimeImpl::Write(grpc::ServerContext* context,
                                   const p4::v1::WriteRequest* request,
                                   p4::v1::WriteResponse* response) {
-  absl::MutexLock l(&server_state_lock_);
+  if (write_capture_ring_ == nullptr) {
+    return AdmitWrite(context, request, response);
+  }
+
+  // Captured latencies include waiting on other writes, since that is what
+  // the controller observes.
+  const absl::Time start_time = absl::Now();
+  grpc::Status status = AdmitWrite(context, request, response);
+  write_capture_ring_->Record(*request, start_time, absl::Now() - start_time,
+                              status.error_code(), status.error_message());
+  return status;
+}
+
+grpc::Status P4RuntimeImpl::AdmitWrite(grpc::ServerContext* context,
+                                       const p4::v1::WriteRequest* request,
+                                       p4::v1::WriteResponse* response) {
+  if (grpc::Status ready = AwaitSavedPipelineConfig(); !ready.ok()) {
+    return ready;
+  }
+  absl::Duration retry_after;
+  if (absl::Status admission =
+          write_admission_.Admit(request->updates_size(), retry_after);
+      !admission.ok()) {
+    VLOG(1) << "Rejected Write request: " << admission;
+    if (context != nullptr) {
+      context->AddTrailingMetadata(
+          kWriteRetryAfterMetadataKey,
+          absl::StrCat(absl::ToInt64Milliseconds(retry_after)));
+    }
+    return gutil::AbslStatusToGrpcStatus(admission);
+  }
+  grpc::Status status = SequenceWrite(request, response);
+  write_admission_.Release(request->updates_size());
+  return status;
+}
 
+grpc::Status P4RuntimeImpl::SequenceWrite(const p4::v1::WriteRequest* request,
+                                          p4::v1::WriteResponse* response) {
+  // A write from an independent role can only touch tables that no other role
+  // can touch, or refer to. So it only has to be ordered against other writes
+  // from the same role.
+  {
+    absl::ReaderMutexLock pipeline_lock(&write_lock_);
+    if (absl::Mutex* role_lock = IndependentRoleWriteLock(*request);
+        role_lock != nullptr) {
+      absl::MutexLock role_write_lock(role_lock);
+      return WriteEntities(request, response);
+    }
+  }
+
+  // Otherwise only one batch is programmed at a time. This preserves the
+  // per-key ordering of updates across batches, and ensures the entity cache
+  // checks done during translation are still valid when the OrchAgent responds.
+  if (write_coalescing_window_ > absl::ZeroDuration()) {
+    return CoalesceWrite(request);
+  }
+  absl::MutexLock programming_lock(&write_lock_);
+  return WriteEntities(request, response);
+}
+
+grpc::Status P4RuntimeImpl::CoalesceWrite(const p4::v1::WriteRequest* request) {
+  PendingWrite write{.request = request, .start_time = absl::Now()};
+  {
+    absl::MutexLock l(&coalescing_lock_);
+    pending_writes_.push_back(&write);
+    if (pending_writes_.size() > 1) {
+      // An earlier request is waiting out the window, and will handle this
+      // one too.
+      coalescing_lock_.Await(absl::Condition(&write.done));
+      return write.status;
+    }
+  }
+
+  absl::SleepFor(write_coalescing_window_);
+  absl::MutexLock programming_lock(&write_lock_);
+  // Requests keep being queued while waiting for the previous group to finish.
+  std::vector<PendingWrite*> writes;
+  {
+    absl::MutexLock l(&coalescing_lock_);
+    writes.swap(pending_writes_);
+  }
+  WriteCoalescedEntities(writes);
+
+  // The other requests may return, and release their PendingWrite, as soon as
+  // they are done. So we cannot touch them afterwards.
+  absl::MutexLock l(&coalescing_lock_);
+  for (PendingWrite* pending_write : writes) pending_write->done = true;
+  return write.status;
+}
+
+void P4RuntimeImpl::WriteCoalescedEntities(
+    absl::Span<PendingWrite* const> writes) {
+  int next = 0;
 #ifdef __EXCEPTIONS
   try {
 #endif
-    absl::Time write_start_time = absl::Now();
+    while (next < writes.size()) {
+      next += WriteCoalescedGroup(writes.subspan(next));
+    }
+#ifdef __EXCEPTIONS
+  } catch (const std::exception& e) {
+    grpc::Status status = EnterCriticalState(
+        absl::StrCat("Exception caught in ", __func__, ", error:", e.what()));
+    for (; next < writes.size(); ++next) writes[next]->status = status;
+  } catch (...) {
+    grpc::Status status = EnterCriticalState(
+        absl::StrCat("Unknown exception caught in ", __func__, "."));
+    for (; next < writes.size(); ++next) writes[next]->status = status;
+  }
+#endif
+}
 
-    // Verify the request comes from the primary connection.
-    auto connection_status = controller_manager_->AllowRequest(*request);
-    if (!connection_status.ok()) {
-      return connection_status;
+int P4RuntimeImpl::WriteCoalescedGroup(absl::Span<PendingWrite* const> writes) {
+  gutil::TraceSpan write_span("P4RT Write: coalesced");
+
+  // The response of each request, and its index in the coalescer. Requests
+  // rejected before translation are not added to the coalescer.
+  struct CoalescedWrite {
+    pdpi::IrWriteRpcStatus rpc_status;
+    std::optional<int> coalescer_index;
+    int total_rpc_updates = 0;
+  };
+  std::vector<CoalescedWrite> coalesced_writes;
+  coalesced_writes.reserve(writes.size());
+  WriteCoalescer coalescer;
+
+  // The AppDb tables, and IrP4Info, can only be changed while holding the
+  // write_lock_ exclusively. So we can safely reference them after releasing
+  // the server_state_lock_.
+  sonic::P4rtTable* p4rt_table = nullptr;
+  sonic::VrfTable* vrf_table = nullptr;
+  const pdpi::IrP4Info* ir_p4info = nullptr;
+  WriteStageTimes stage_times;
+
+  // Stage 1: translate and validate each request against the current state,
+  // and the requests before it. A request that cannot be merged with the
+  // earlier ones ends the group, and is translated again in the next one.
+  {
+    gutil::TraceSpan translate_span("P4RT Write: translate");
+    ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+    absl::Time translate_start_time = absl::Now();
+    for (PendingWrite* write : writes) {
+      const p4::v1::WriteRequest& request = *write->request;
+      if (auto connection_status = controller_manager_->AllowRequest(request);
+          !connection_status.ok()) {
+        write->status = connection_status;
+        coalesced_writes.emplace_back();
+        continue;
+      }
+      if (!ir_p4info_.has_value()) {
+        write->status =
+            grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                         "Switch has not configured the forwarding pipeline.");
+        coalesced_writes.emplace_back();
+        continue;
+      }
+
+      pdpi::IrWriteRpcStatus rpc_status;
+      absl::flat_hash_map<uint32_t, int64_t> resources_in_batch =
+          coalescer.resources_in_batch();
+      sonic::AppDbUpdates app_db_updates = PiEntityUpdatesToIr(
+          request, ir_p4info_->compiled(), *ir_translation_plan_,
+          *app_db_serialization_plan_, *entity_cache_,
+          capacity_by_action_profile_id_, *constraint_plan_,
+          translate_port_ids_, *port_translator_, *CurrentCpuQueueTranslator(),
+          translation_pool_.get(), coalescer.pending_inserts(),
+          resources_in_batch, rpc_status.mutable_rpc_response());
+      const int total_rpc_updates = app_db_updates.total_rpc_updates;
+      std::optional<int> coalescer_index = coalescer.Add(
+          std::move(app_db_updates), std::move(resources_in_batch));
+      if (!coalescer_index.has_value()) break;
+      coalesced_writes.push_back(CoalescedWrite{
+          .rpc_status = std::move(rpc_status),
+          .coalescer_index = coalescer_index,
+          .total_rpc_updates = total_rpc_updates,
+      });
+    }
+    stage_times.translate = absl::Now() - translate_start_time;
+    p4rt_table = &p4rt_table_;
+    vrf_table = &vrf_table_;
+    if (ir_p4info_.has_value()) ir_p4info = &ir_p4info_->info();
+  }
+  if (coalescer.empty()) return coalesced_writes.size();
+
+  // Stage 2: publish the net updates of every request, and wait for the
+  // OrchAgent responses, while not holding the server_state_lock_.
+  sonic::AppDbUpdates app_db_updates = coalescer.TakeMergedUpdates();
+  pdpi::IrWriteResponse merged_response;
+  for (int i = 0; i < app_db_updates.entries.size(); ++i) {
+    *merged_response.add_statuses() = GetIrUpdateStatus(absl::OkStatus());
+  }
+  VLOG(1) << "Coalesced " << coalescer.num_requests() << " Write requests, "
+          << "dropping " << coalescer.num_coalesced_updates() << " updates.";
+  absl::Status app_db_write_status;
+  {
+    gutil::TraceSpan app_db_span("P4RT Write: update AppDb");
+    absl::MutexLock app_db_lock(&app_db_write_lock_);
+    if (app_db_publish_policy_.has_value()) {
+      app_db_updates.publish_policy = &*app_db_publish_policy_;
+    }
+    app_db_write_status =
+        sonic::UpdateAppDb(*p4rt_table, *vrf_table, app_db_updates, *ir_p4info,
+                           &merged_response, &stage_times.app_db);
+  }
+  if (!app_db_updates.entries.empty()) {
+    write_admission_.RecordOrchAgentLatency(stage_times.app_db.response_wait);
+  }
+  if (!app_db_write_status.ok()) {
+    grpc::Status status = EnterCriticalState(absl::StrCat(
+        "Unexpected error calling UpdateAppDb: ",
+        app_db_write_status.ToString()));
+    for (int i = 0; i < coalesced_writes.size(); ++i) {
+      if (coalesced_writes[i].coalescer_index.has_value()) {
+        writes[i]->status = status;
+      }
     }
+    return coalesced_writes.size();
+  }
 
-    // We can only program the flow if the forwarding pipeline has been set.
-    if (!ir_p4info_.has_value()) {
-      return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
-                          "Switch has not configured the forwarding pipeline.");
+  // Hand each request the statuses of its updates.
+  for (int i = 0; i < coalesced_writes.size(); ++i) {
+    CoalescedWrite& coalesced_write = coalesced_writes[i];
+    if (!coalesced_write.coalescer_index.has_value()) continue;
+    pdpi::IrWriteResponse& rpc_response =
+        *coalesced_write.rpc_status.mutable_rpc_response();
+    coalescer.CopyStatuses(*coalesced_write.coalescer_index, merged_response,
+                           rpc_response);
+    bool any_update_failed = AbortFailuresAfterTheFirst(rpc_response);
+    auto grpc_status = WriteRpcStatusToGrpcStatus(coalesced_write.rpc_status,
+                                                  any_update_failed);
+    if (grpc_status.ok()) {
+      writes[i]->status = *grpc_status;
+    } else {
+      LOG(ERROR) << "PDPI failed to translate RPC status to gRPC status: "
+                 << coalesced_write.rpc_status.ShortDebugString();
+      writes[i]->status = EnterCriticalState(grpc_status.status().ToString());
+    }
+  }
+
+  // Stage 3: commit the net results into the server state.
+  gutil::TraceSpan cache_update_span("P4RT Write: update cache");
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  absl::Time cache_update_start_time = absl::Now();
+  absl::Status cache_and_util_status = UpdateCacheAndUtilizationState(
+      MutableEntityCache(), capacity_by_action_profile_id_, app_db_updates,
+      merged_response);
+  stage_times.cache_update = absl::Now() - cache_update_start_time;
+  if (!cache_and_util_status.ok()) {
+    LOG(ERROR) << "Could not update cache and utilization for write request: "
+               << cache_and_util_status;
+    grpc::Status status = EnterCriticalState(cache_and_util_status.ToString());
+    for (int i = 0; i < coalesced_writes.size(); ++i) {
+      if (coalesced_writes[i].coalescer_index.has_value()) {
+        writes[i]->status = status;
+      }
     }
+    return coalesced_writes.size();
+  }
+
+  // Every request shares the stage times of its group, but is counted on its
+  // own.
+  const absl::Time end_time = absl::Now();
+  for (int i = 0; i < coalesced_writes.size(); ++i) {
+    if (!coalesced_writes[i].coalescer_index.has_value()) continue;
+    absl::Duration write_execution_time = end_time - writes[i]->start_time;
+    write_batch_requests_ += 1;
+    write_total_requests_ += coalesced_writes[i].total_rpc_updates;
+    write_execution_time_ += write_execution_time;
+    RecordWriteLatencies(app_db_updates, write_execution_time, stage_times,
+                         write_latency_);
+  }
+  return coalesced_writes.size();
+}
+
+absl::Mutex* P4RuntimeImpl::IndependentRoleWriteLock(
+    const p4::v1::WriteRequest& request) {
+  auto role_lock = role_write_locks_.find(request.role());
+  if (role_lock == role_write_locks_.end()) return nullptr;
+
+  // Role access is only enforced for table entries, so any other entity (e.g.
+  // a multicast group) could be shared with another role.
+  for (const p4::v1::Update& update : request.updates()) {
+    if (!update.entity().has_table_entry()) return nullptr;
+  }
+  return role_lock->second.get();
+}
+
+grpc::Status P4RuntimeImpl::WriteEntities(const p4::v1::WriteRequest* request,
+                                          p4::v1::WriteResponse* response) {
+#ifdef __EXCEPTIONS
+  try {
+#endif
+    gutil::TraceSpan write_span("P4RT Write");
+    absl::Time write_start_time = absl::Now();
 
     pdpi::IrWriteRpcStatus rpc_status;
     pdpi::IrWriteResponse* rpc_response = rpc_status.mutable_rpc_response();
-    sonic::AppDbUpdates app_db_updates = PiEntityUpdatesToIr(
-        *request, *ir_p4info_, entity_cache_, capacity_by_action_profile_name_,
-        *p4_constraint_info_, translate_port_ids_, port_translation_map_,
-        *cpu_queue_translator_, rpc_response);
+    sonic::AppDbUpdates app_db_updates;
+
+    // The AppDb tables, IrP4Info, and serialization plan can only be changed
+    // while holding the write_lock_ exclusively. So we can safely reference
+    // them after releasing the server_state_lock_.
+    sonic::P4rtTable* p4rt_table = nullptr;
+    sonic::VrfTable* vrf_table = nullptr;
+    const pdpi::IrP4Info* ir_p4info = nullptr;
+
+    WriteStageTimes stage_times;
 
+    // Stage 1: translate and validate the request against the current state.
+    {
+      gutil::TraceSpan translate_span("P4RT Write: translate");
+      ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+
+      // Verify the request comes from the primary connection.
+      auto connection_status = controller_manager_->AllowRequest(*request);
+      if (!connection_status.ok()) {
+        return connection_status;
+      }
+
+      // We can only program the flow if the forwarding pipeline has been set.
+      if (!ir_p4info_.has_value()) {
+        return grpc::Status(
+            grpc::StatusCode::FAILED_PRECONDITION,
+            "Switch has not configured the forwarding pipeline.");
+      }
+
+      absl::Time translate_start_time = absl::Now();
+      absl::flat_hash_map<uint32_t, int64_t> resources_in_batch;
+      app_db_updates = PiEntityUpdatesToIr(
+          *request, ir_p4info_->compiled(), *ir_translation_plan_,
+          *app_db_serialization_plan_, *entity_cache_,
+          capacity_by_action_profile_id_, *constraint_plan_,
+          translate_port_ids_, *port_translator_, *CurrentCpuQueueTranslator(),
+          translation_pool_.get(), /*pending_inserts=*/{}, resources_in_batch,
+          rpc_response);
+      stage_times.translate = absl::Now() - translate_start_time;
+      p4rt_table = &p4rt_table_;
+      vrf_table = &vrf_table_;
+      ir_p4info = &ir_p4info_->info();
+    }
+
+    // Stage 2: publish the updates and wait for the OrchAgent responses. This
+    // can take a while so we do not block other requests (e.g. Read) by
+    // holding the server_state_lock_.
+    //
     // Any AppDb update failures should be appended to the `rpc_response`. If
     // UpdateAppDb fails we should go critical.
-    auto app_db_write_status = sonic::UpdateAppDb(
-        p4rt_table_, vrf_table_, app_db_updates, *ir_p4info_, rpc_response);
+    absl::Status app_db_write_status;
+    {
+      gutil::TraceSpan app_db_span("P4RT Write: update AppDb");
+      // Every table shares the OrchAgent response channel, so writes from
+      // independent roles still take turns publishing.
+      absl::MutexLock app_db_lock(&app_db_write_lock_);
+      if (app_db_publish_policy_.has_value()) {
+        app_db_updates.publish_policy = &*app_db_publish_policy_;
+      }
+      app_db_write_status = sonic::UpdateAppDb(*p4rt_table, *vrf_table,
+                                               app_db_updates, *ir_p4info,
+                                               rpc_response,
+                                               &stage_times.app_db);
+    }
+    if (!app_db_updates.entries.empty()) {
+      write_admission_.RecordOrchAgentLatency(
+          stage_times.app_db.response_wait);
+    }
     if (!app_db_write_status.ok()) {
       return EnterCriticalState(
           absl::StrCat("Unexpected error calling UpdateAppDb: ",
                        app_db_write_status.ToString()));
     }
 
-    // We do a bit of bookkeeping, before sending our final response to the
-    // controller, so that we can ensure correct fail on first semantics. Each
-    // layer gets a chance at a "first" failure so it is possible to have
-    // multiple failures (not including the ABORTED ones) in a batch.
-    //
-    // Consider the following case where we get a batch of 10 entries:
-    //   1. P4RT App fails to translate entry 6 and thus marks entries
-    //      7-10 as ABORTED.
-    //   2. SWSS then only sees entries 1-5 for which it fails on entry 3.
-    //      Therefore, marking entries 4 and 5 as ABORTED.
-    //
-    // In the response to the controller entry 6 would have a non-ABORTED error.
-    bool found_first_failure = false;
-    for (auto& rpc_error :
-         *rpc_status.mutable_rpc_response()->mutable_statuses()) {
-      if (rpc_error.code() == google::rpc::OK) {
-        continue;
-      }
-      if (!found_first_failure) {
-        found_first_failure = true;
-        continue;
-      }
-      LOG_IF(WARNING, rpc_error.code() != google::rpc::ABORTED)
-          << "Found an error that should be marked ABORTED. This is expected "
-             "if a higher layer rejects one flow in a batch and a lower layer "
-             "rejects another: "
-          << rpc_error.message();
-      rpc_error.set_code(google::rpc::ABORTED);
-    }
+    bool any_update_failed = AbortFailuresAfterTheFirst(*rpc_response);
 
-    auto grpc_status = pdpi::IrWriteRpcStatusToGrpcStatus(rpc_status);
+    auto grpc_status =
+        WriteRpcStatusToGrpcStatus(rpc_status, any_update_failed);
     if (!grpc_status.ok()) {
       LOG(ERROR) << "PDPI failed to translate RPC status to gRPC status: "
                  << rpc_status.ShortDebugString();
       return EnterCriticalState(grpc_status.status().ToString());
     }
 
+    // Stage 3: commit the results into the server state.
+    gutil::TraceSpan cache_update_span("P4RT Write: update cache");
+    ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+    absl::Time cache_update_start_time = absl::Now();
     absl::Status cache_and_util_status = UpdateCacheAndUtilizationState(
-        entity_cache_, capacity_by_action_profile_name_, app_db_updates,
+        MutableEntityCache(), capacity_by_action_profile_id_, app_db_updates,
         *rpc_response);
+    stage_times.cache_update = absl::Now() - cache_update_start_time;
     if (!cache_and_util_status.ok()) {
       LOG(ERROR) << "Could not update cache and utilization for write request: "
                  << cache_and_util_status;
@@ -720,6 +1507,8 @@ grpc::Status P4RuntimeImpl::Write(grpc::ServerContext* context,
     write_batch_requests_ += 1;
     write_total_requests_ += app_db_updates.total_rpc_updates;
     write_execution_time_ += write_execution_time;
+    RecordWriteLatencies(app_db_updates, write_execution_time, stage_times,
+                         write_latency_);
 
     // Log a warning for any batch requests that are taking "too long" so we can
     // have an accurate time of when it happened.
@@ -754,47 +1543,101 @@ grpc::Status P4RuntimeImpl::Write(grpc::ServerContext* context,
 grpc::Status P4RuntimeImpl::Read(
     grpc::ServerContext* context, const p4::v1::ReadRequest* request,
     grpc::ServerWriter<p4::v1::ReadResponse>* response_writer) {
-  // Default max receive message size in GRPC is 4MB, setting the batch size to
-  // 2500 assuming each response message is less than ~1600 bytes max.
-  constexpr int kReadResponseBatchSize = 2500;
-  absl::MutexLock l(&server_state_lock_);
+  if (response_writer == nullptr) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "ReadResponse writer cannot be a nullptr.");
+  }
+  // The sync API only writes typed responses, so each one is parsed once.
+  p4::v1::ReadResponse response;
+  return ReadEntities(
+      request,
+      [&](absl::string_view serialized_response) {
+        if (!response.ParseFromArray(serialized_response.data(),
+                                     serialized_response.size())) {
+          LOG(ERROR) << "Could not parse a serialized ReadResponse.";
+          return false;
+        }
+        return response_writer->Write(response);
+      },
+      context);
+}
+
+grpc::Status P4RuntimeImpl::ReadEntities(
+    const p4::v1::ReadRequest* request,
+    absl::FunctionRef<bool(absl::string_view)> write_response,
+    grpc::ServerContextBase* context) {
+  if (grpc::Status ready = AwaitSavedPipelineConfig(); !ready.ok()) {
+    return ready;
+  }
 
 #ifdef __EXCEPTIONS
   try {
 #endif
     absl::Time read_start_time = absl::Now();
 
-    auto connection_status = controller_manager_->AllowRequest(*request);
-    if (!connection_status.ok()) {
-      return connection_status;
-    }
+    // The IrP4Info cannot be changed once it has been set, and the P4RT_TABLE
+    // is only used to read counter data which is guarded by the
+    // counter_db_lock_. So we can safely reference them after releasing the
+    // server_state_lock_.
+    const pdpi::IrP4Info* ir_p4info = nullptr;
+    sonic::P4rtTable* p4rt_table = nullptr;
+
+    // Everything else needed to serve the read is copied, or shared, while
+    // holding the lock.
+    std::shared_ptr<const EntityCache> entity_cache;
+    std::shared_ptr<const CpuQueueTranslator> cpu_queue_translator;
+    std::shared_ptr<const PortTranslator> port_translator;
+    bool translate_port_ids = false;
+    {
+      ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+      auto connection_status = controller_manager_->AllowRequest(*request);
+      if (!connection_status.ok()) {
+        return connection_status;
+      }
 
-    if (!ir_p4info_.has_value()) {
-      return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
-                          "Switch has no ForwardingPipelineConfig.");
-    }
-    if (request == nullptr) {
-      return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
-                          "ReadRequest cannot be a nullptr.");
-    }
-    if (response_writer == nullptr) {
-      return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
-                          "ReadResponse writer cannot be a nullptr.");
+      if (!ir_p4info_.has_value()) {
+        return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                            "Switch has no ForwardingPipelineConfig.");
+      }
+      if (request == nullptr) {
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                            "ReadRequest cannot be a nullptr.");
+      }
+      ir_p4info = &ir_p4info_->info();
+      p4rt_table = &p4rt_table_;
+      entity_cache = entity_cache_;
+      cpu_queue_translator = CurrentCpuQueueTranslator();
+      port_translator = port_translator_;
+      translate_port_ids = translate_port_ids_;
     }
 
-    auto responses_status = ReadAllEntitiesInBatches(
-        kReadResponseBatchSize, *request, *ir_p4info_, entity_cache_,
-        translate_port_ids_, port_translation_map_, *cpu_queue_translator_,
-        p4rt_table_);
-    if (!responses_status.ok()) {
-      LOG(WARNING) << "Read failure: " << responses_status.status();
+    // Responses are written as soon as they fill up so the controller can start
+    // processing them while we continue reading.
+    absl::Time counter_data_time = absl::InfiniteFuture();
+    absl::Status read_status = StreamAllEntities(
+        read_response_max_bytes_, *request, *ir_p4info, *entity_cache,
+        translate_port_ids, *port_translator, *cpu_queue_translator,
+        *p4rt_table, counter_db_lock_, acl_counter_cache_.get(),
+        [&](absl::string_view response) -> absl::Status {
+          if (!write_response(response)) {
+            return gutil::UnavailableErrorBuilder()
+                   << "Failed to write ReadResponse. The stream may have been "
+                      "closed.";
+          }
+          return absl::OkStatus();
+        },
+        &counter_data_time, read_pool_.get());
+    if (!read_status.ok()) {
+      LOG(WARNING) << "Read failure: " << read_status;
       return grpc::Status(
           grpc::StatusCode::UNKNOWN,
-          absl::StrCat("Read failure: ", responses_status.status().ToString()));
+          absl::StrCat("Read failure: ", read_status.ToString()));
     }
-
-    for (auto& response : responses_status.value()) {
-      response_writer->Write(response);
+    if (acl_counter_cache_ != nullptr && context != nullptr &&
+        counter_data_time != absl::InfiniteFuture()) {
+      context->AddTrailingMetadata(
+          kAclCounterDataTimeMetadataKey,
+          absl::StrCat(absl::ToUnixMicros(counter_data_time)));
     }
 
     absl::Duration read_execution_time = absl::Now() - read_start_time;
@@ -833,74 +1676,12 @@ grpc::Status P4RuntimeImpl::StreamChannel(
     // While the connection is active we can receive and send requests.
     p4::v1::StreamMessageRequest request;
     while (stream->Read(&request)) {
-      absl::MutexLock l(&server_state_lock_);
-
-      switch (request.update_case()) {
-        case p4::v1::StreamMessageRequest::kArbitration: {
-          LOG(INFO) << "Received arbitration request from '" << context->peer()
-                    << "': " << request.ShortDebugString();
-
-          auto status = controller_manager_->HandleArbitrationUpdate(
-              request.arbitration(), sdn_connection.get());
-          if (!status.ok()) {
-            LOG(WARNING) << "Failed arbitration request for '"
-                         << context->peer() << "': " << status.error_message();
-            controller_manager_->Disconnect(sdn_connection.get());
-            return status;
-          }
-          break;
-        }
-        case p4::v1::StreamMessageRequest::kPacket: {
-          if (controller_manager_
-                  ->AllowMutableRequest(controller_manager_->GetDeviceId(),
-                                        sdn_connection->GetRoleName(),
-                                        sdn_connection->GetElectionId())
-                  .ok()) {
-            // If we're the primary connection we can try to handle the
-            // PacketOut request.
-            absl::Status packet_out_status =
-                HandlePacketOutRequest(request.packet());
-            if (!packet_out_status.ok()) {
-              packetio_counters_.packet_out_errors += 1;
-              LOG(WARNING) << "Could not handle PacketOut request: "
-                           << packet_out_status;
-              sdn_connection->SendStreamMessageResponse(
-                  GenerateErrorResponse(packet_out_status, request.packet()));
-            } else {
-              packetio_counters_.packet_out_sent += 1;
-            }
-          } else {
-            // Otherwise, if it's not the primary connection trying to send a
-            // message so we return a PERMISSION_DENIED error.
-            packetio_counters_.packet_out_errors += 1;
-            LOG(WARNING) << "Non-primary controller '" << context->peer()
-                         << "' is trying to send PacketOut requests.";
-            sdn_connection->SendStreamMessageResponse(
-                GenerateErrorResponse(gutil::PermissionDeniedErrorBuilder()
-                                          << "Only the primary connection can "
-                                             "send PacketOut requests.",
-                                      request.packet()));
-          }
-          break;
-        }
-        default:
-          LOG(WARNING) << "Stream Channel '" << context->peer()
-                       << "' has sent a request that was unhandled: "
-                       << request.ShortDebugString();
-          sdn_connection->SendStreamMessageResponse(
-              GenerateErrorResponse(gutil::UnimplementedErrorBuilder()
-                                    << "Stream update type is not supported."));
-      }
+      grpc::Status status =
+          HandleStreamMessageRequest(request, *sdn_connection);
+      if (!status.ok()) return status;
     }
 
-    // Disconnect the controller from the list of available connections, and
-    // inform any other connections about arbitration changes.
-    {
-      absl::MutexLock l(&server_state_lock_);
-      controller_manager_->Disconnect(sdn_connection.get());
-    }
-
-    LOG(INFO) << "Closing stream to peer '" << context->peer() << "'.";
+    DisconnectStreamChannel(*sdn_connection);
     if (context->IsCancelled()) {
       LOG(WARNING)
           << "Stream was canceled and the peer may not have been informed.";
@@ -917,12 +1698,100 @@ grpc::Status P4RuntimeImpl::StreamChannel(
 #endif
 }
 
+grpc::Status P4RuntimeImpl::HandleStreamMessageRequest(
+    const p4::v1::StreamMessageRequest& request,
+    SdnConnection& sdn_connection) {
+  if (request.update_case() == p4::v1::StreamMessageRequest::kPacket) {
+    HandleStreamPacketOut(request.packet(), sdn_connection);
+    return grpc::Status::OK;
+  }
+
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  const std::string& peer = sdn_connection.GetPeer();
+
+  switch (request.update_case()) {
+    case p4::v1::StreamMessageRequest::kArbitration: {
+      LOG(INFO) << "Received arbitration request from '" << peer
+                << "': " << request.ShortDebugString();
+
+      auto status = controller_manager_->HandleArbitrationUpdate(
+          request.arbitration(), &sdn_connection);
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed arbitration request for '" << peer
+                     << "': " << status.error_message();
+        controller_manager_->Disconnect(&sdn_connection);
+        return status;
+      }
+      break;
+    }
+    default:
+      LOG(WARNING) << "Stream Channel '" << peer
+                   << "' has sent a request that was unhandled: "
+                   << request.ShortDebugString();
+      sdn_connection.SendStreamMessageResponse(
+          GenerateErrorResponse(gutil::UnimplementedErrorBuilder()
+                                << "Stream update type is not supported."));
+  }
+  return grpc::Status::OK;
+}
+
+void P4RuntimeImpl::HandleStreamPacketOut(const p4::v1::PacketOut& packet_out,
+                                          SdnConnection& sdn_connection) {
+  if (!controller_manager_
+           ->AllowMutableRequest(controller_manager_->GetDeviceId(),
+                                 sdn_connection.GetRoleName(),
+                                 sdn_connection.GetElectionId())
+           .ok()) {
+    // Otherwise, if it's not the primary connection trying to send a message
+    // so we return a PERMISSION_DENIED error.
+    packet_out_errors_ += 1;
+    LOG(WARNING) << "Non-primary controller '" << sdn_connection.GetPeer()
+                 << "' is trying to send PacketOut requests.";
+    sdn_connection.SendStreamMessageResponse(GenerateErrorResponse(
+        gutil::PermissionDeniedErrorBuilder()
+            << "Only the primary connection can send PacketOut requests.",
+        packet_out));
+    return;
+  }
+
+  // If we're the primary connection we can try to handle the PacketOut
+  // request.
+  absl::Status packet_out_status = HandlePacketOutRequest(packet_out);
+  if (!packet_out_status.ok()) {
+    packet_out_errors_ += 1;
+    LOG(WARNING) << "Could not handle PacketOut request: "
+                 << packet_out_status;
+    sdn_connection.SendStreamMessageResponse(
+        GenerateErrorResponse(packet_out_status, packet_out));
+  } else {
+    packet_out_sent_ += 1;
+  }
+}
+
+void P4RuntimeImpl::DisconnectStreamChannel(SdnConnection& sdn_connection) {
+  // Disconnect the controller from the list of available connections, and
+  // inform any other connections about arbitration changes.
+  {
+    ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+    controller_manager_->Disconnect(&sdn_connection);
+  }
+
+  // Flush anything still queued for the controller. This is done without the
+  // server_state_lock_ since the peer may be slow to drain the stream.
+  sdn_connection.CloseStream();
+  SdnConnection::ResponseWriter::Counters counters =
+      sdn_connection.GetStreamCounters();
+  LOG(INFO) << "Closing stream to peer '" << sdn_connection.GetPeer()
+            << "' after " << counters.written << " responses ("
+            << counters.dropped << " PacketIns dropped, "
+            << counters.write_failures << " failed writes, max queue depth "
+            << counters.max_queue_depth << ").";
+}
+
 grpc::Status P4RuntimeImpl::SetForwardingPipelineConfig(
     grpc::ServerContext* context,
     const p4::v1::SetForwardingPipelineConfigRequest* request,
     p4::v1::SetForwardingPipelineConfigResponse* response) {
-  absl::MutexLock l(&server_state_lock_);
-
 #ifdef __EXCEPTIONS
   try {
 #endif
@@ -931,6 +1800,38 @@ grpc::Status P4RuntimeImpl::SetForwardingPipelineConfig(
         << request->election_id().ShortDebugString();
 
     // Verify this connection is allowed to set the P4Info.
+    {
+      ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+      auto connection_status = controller_manager_->AllowRequest(*request);
+      if (!connection_status.ok()) {
+        return connection_status;
+      }
+    }
+
+    // Verifying a config only depends on the request, so it is done without
+    // holding any locks. That way VERIFY requests never block programming, and
+    // VERIFY_AND_COMMIT only holds the locks while committing.
+    using ::p4::v1::SetForwardingPipelineConfigRequest;
+    if (request->action() == SetForwardingPipelineConfigRequest::VERIFY ||
+        request->action() ==
+            SetForwardingPipelineConfigRequest::VERIFY_AND_COMMIT) {
+      grpc::Status verified = VerifyPipelineConfig(*request);
+      if (!verified.ok()) {
+        LOG(WARNING) << "SetForwardingPipelineConfig failed: "
+                     << verified.error_message();
+        return verified;
+      }
+      if (request->action() == SetForwardingPipelineConfigRequest::VERIFY) {
+        LOG(INFO) << "SetForwardingPipelineConfig completed 'VERIFY' "
+                     "successfully.";
+        return grpc::Status::OK;
+      }
+    }
+
+    absl::MutexLock programming_lock(&write_lock_);
+    ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+
+    // The primary connection may have changed while the config was verified.
     auto connection_status = controller_manager_->AllowRequest(*request);
     if (!connection_status.ok()) {
       return connection_status;
@@ -943,17 +1844,16 @@ grpc::Status P4RuntimeImpl::SetForwardingPipelineConfig(
     grpc::Status action_status;
     VLOG(1) << "Request action: " << request->Action_Name(request->action());
     switch (request->action()) {
-      case p4::v1::SetForwardingPipelineConfigRequest::VERIFY:
-        action_status = VerifyPipelineConfig(*request);
-        break;
       case p4::v1::SetForwardingPipelineConfigRequest::VERIFY_AND_COMMIT:
-        action_status = VerifyAndCommitPipelineConfig(*request);
+        action_status = VerifyAndCommitPipelineConfig(
+            *request, /*config_verified=*/true);
         break;
       case p4::v1::SetForwardingPipelineConfigRequest::COMMIT:
         action_status = CommitPipelineConfig(*request);
         break;
       case p4::v1::SetForwardingPipelineConfigRequest::RECONCILE_AND_COMMIT: {
-        action_status = ReconcileAndCommitPipelineConfig(*request);
+        action_status = ReconcileAndCommitPipelineConfig(
+            *request, /*config_verified=*/false);
         break;
       }
       default: {
@@ -983,13 +1883,11 @@ grpc::Status P4RuntimeImpl::SetForwardingPipelineConfig(
         p4::v1::SetForwardingPipelineConfigRequest::Action_Name(
             request->action()));
 
-    // Only record the time for a successful commit action.
-    if (request->action() !=
-        p4::v1::SetForwardingPipelineConfigRequest::VERIFY) {
-      host_stats_table_.state_db->set(
-          "CONFIG", {{"last-configuration-timestamp",
-                      absl::StrCat(absl::ToUnixNanos(absl::Now()))}});
-    }
+    // Only record the time for a successful commit action. VERIFY requests
+    // have already returned.
+    host_stats_table_.state_db->set(
+        "CONFIG", {{"last-configuration-timestamp",
+                    absl::StrCat(absl::ToUnixNanos(absl::Now()))}});
 
 #ifdef __EXCEPTIONS
   } catch (const std::exception& e) {
@@ -1008,7 +1906,10 @@ grpc::Status P4RuntimeImpl::GetForwardingPipelineConfig(
     grpc::ServerContext* context,
     const p4::v1::GetForwardingPipelineConfigRequest* request,
     p4::v1::GetForwardingPipelineConfigResponse* response) {
-  absl::MutexLock l(&server_state_lock_);
+  if (grpc::Status ready = AwaitSavedPipelineConfig(); !ready.ok()) {
+    return ready;
+  }
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
 
 #ifdef __EXCEPTIONS
   try {
@@ -1017,6 +1918,13 @@ grpc::Status P4RuntimeImpl::GetForwardingPipelineConfig(
     if (!connection_status.ok()) {
       return connection_status;
     }
+    // Lets a reconnecting controller check that the entities it knows of are
+    // still accurate, without reading them back.
+    if (context != nullptr) {
+      context->AddTrailingMetadata(
+          kStateFingerprintMetadataKey,
+          absl::StrFormat("%016x", entity_cache_->Fingerprint()));
+    }
 
     // If we have not set the forwarding pipeline. Then we don't return
     // anything on a get request.
@@ -1071,20 +1979,35 @@ grpc::Status P4RuntimeImpl::GetForwardingPipelineConfig(
 }
 
 absl::Status P4RuntimeImpl::UpdateDeviceId(uint64_t device_id) {
-  absl::MutexLock l(&server_state_lock_);
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
   return controller_manager_->SetDeviceId(device_id);
 }
 
 absl::Status P4RuntimeImpl::AddPacketIoPort(const std::string& port_name) {
-  absl::MutexLock l(&server_state_lock_);
+  absl::MutexLock l(&packetio_lock_);
   return packetio_impl_->AddPacketIoPort(port_name);
 }
 
 absl::Status P4RuntimeImpl::RemovePacketIoPort(const std::string& port_name) {
-  absl::MutexLock l(&server_state_lock_);
+  absl::MutexLock l(&packetio_lock_);
   return packetio_impl_->RemovePacketIoPort(port_name);
 }
 
+absl::Status P4RuntimeImpl::UpdatePacketIoPorts(
+    const std::vector<std::string>& additions,
+    const std::vector<std::string>& removals) {
+  absl::MutexLock l(&packetio_lock_);
+  std::vector<absl::Status> statuses;
+  statuses.reserve(additions.size() + removals.size());
+  for (const std::string& port_name : removals) {
+    statuses.push_back(packetio_impl_->RemovePacketIoPort(port_name));
+  }
+  for (const std::string& port_name : additions) {
+    statuses.push_back(packetio_impl_->AddPacketIoPort(port_name));
+  }
+  return CombineStatuses(statuses);
+}
+
 // Responds with one of the following actions to port translation:
 // * Add the new port translation for unknown name & ID
 // * Update an existing {name, id} translation to the new ID
@@ -1103,8 +2026,15 @@ absl::Status P4RuntimeImpl::RemovePacketIoPort(const std::string& port_name) {
 //  "C" | Reject | Reject |  Add   |
 absl::Status P4RuntimeImpl::AddPortTranslation(const std::string& port_name,
                                                const std::string& port_id) {
-  absl::MutexLock l(&server_state_lock_);
+  absl::MutexLock programming_lock(&write_lock_);
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  absl::Status status = AddPortTranslationLocked(port_name, port_id);
+  PublishPacketIoView(/*ir_p4info_changed=*/false);
+  return status;
+}
 
+absl::Status P4RuntimeImpl::AddPortTranslationLocked(
+    const std::string& port_name, const std::string& port_id) {
   // Do not allow empty strings.
   if (port_name.empty()) {
     return gutil::InvalidArgumentErrorBuilder()
@@ -1119,49 +2049,80 @@ absl::Status P4RuntimeImpl::AddPortTranslation(const std::string& port_name,
   // TODO: Remove DB writes when sFlow listens to another table.
   // If the Port Name/ID pair already exists then update AppDB and AppStateDB to
   // ensure sFlow gets an update.
-  const auto name_iter = port_translation_map_.left.find(port_name);
-  if (name_iter != port_translation_map_.left.end() &&
-      name_iter->second == port_id) {
+  const std::string* existing_id = port_translator_->NameToId(port_name);
+  if (existing_id != nullptr && *existing_id == port_id) {
     port_table_.app_db->set(port_name, {{"id", port_id}});
     port_table_.app_state_db->set(port_name, {{"id", port_id}});
     return absl::OkStatus();
   }
 
   // If the ID exists (but isn't paired to the name), reject.
-  if (const auto id_iter = port_translation_map_.right.find(port_id);
-      id_iter != port_translation_map_.right.end()) {
+  if (const std::string* existing_name = port_translator_->IdToName(port_id);
+      existing_name != nullptr) {
     return gutil::AlreadyExistsErrorBuilder()
            << "Cannot add port translation {'" << port_name << "', '" << port_id
            << "'}. Port ID is already in use for translation {'"
-           << id_iter->second << "', '" << port_id << "'}.";
+           << *existing_name << "', '" << port_id << "'}.";
   }
   // Insert or update the port mapping.
   LOG(INFO) << "Adding translation for {'" << port_name << "', '" << port_id
             << "'}.";
-  if (name_iter != port_translation_map_.left.end()) {
-    port_translation_map_.left.erase(name_iter);
-  }
-  port_translation_map_.insert({port_name, port_id});
+  PortTranslator& port_translator = MutablePortTranslator();
+  port_translator.RemoveName(port_name);
+  port_translator.Insert(port_name, port_id);
   port_table_.app_db->set(port_name, {{"id", port_id}});
   port_table_.app_state_db->set(port_name, {{"id", port_id}});
   return absl::OkStatus();
 }
 
+PortTranslator& P4RuntimeImpl::MutablePortTranslator() {
+  // Readers only take a reference while holding the lock. So if nobody else
+  // holds one now, nobody can until the lock is released.
+  if (port_translator_.use_count() > 1) {
+    port_translator_ = std::make_shared<PortTranslator>(*port_translator_);
+  }
+  return *port_translator_;
+}
+
 absl::Status P4RuntimeImpl::RemovePortTranslation(
     const std::string& port_name) {
-  absl::MutexLock l(&server_state_lock_);
+  absl::MutexLock programming_lock(&write_lock_);
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  absl::Status status = RemovePortTranslationLocked(port_name);
+  PublishPacketIoView(/*ir_p4info_changed=*/false);
+  return status;
+}
+
+absl::Status P4RuntimeImpl::UpdatePortTranslations(
+    const std::vector<std::pair<std::string, std::string>>& additions,
+    const std::vector<std::string>& removals) {
+  absl::MutexLock programming_lock(&write_lock_);
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  std::vector<absl::Status> statuses;
+  statuses.reserve(additions.size() + removals.size());
+  for (const std::string& port_name : removals) {
+    statuses.push_back(RemovePortTranslationLocked(port_name));
+  }
+  for (const auto& [port_name, port_id] : additions) {
+    statuses.push_back(AddPortTranslationLocked(port_name, port_id));
+  }
+  PublishPacketIoView(/*ir_p4info_changed=*/false);
+  return CombineStatuses(statuses);
+}
 
+absl::Status P4RuntimeImpl::RemovePortTranslationLocked(
+    const std::string& port_name) {
   // Do not allow empty strings.
   if (port_name.empty()) {
     return absl::InvalidArgumentError(
         "Cannot remove port translation without the port name.");
   }
 
-  if (auto port = port_translation_map_.left.find(port_name);
-      port != port_translation_map_.left.end()) {
-    LOG(INFO) << "Removing translation for {'" << port->first << "', '"
-              << port->second << "'}.";
-    port_translation_map_.left.erase(port);
+  if (const std::string* port_id = port_translator_->NameToId(port_name);
+      port_id != nullptr) {
+    LOG(INFO) << "Removing translation for {'" << port_name << "', '"
+              << *port_id << "'}.";
+    MutablePortTranslator().RemoveName(port_name);
   }
 
   port_table_.app_db->del(port_name);
@@ -1171,6 +2132,21 @@ absl::Status P4RuntimeImpl::RemovePortTranslation(
 
 absl::Status P4RuntimeImpl::DumpDebugData(const std::string& path,
                                           const std::string& log_level) {
+  // Only references to the shared state are taken while holding the
+  // server_state_lock_. Everything is written after releasing it so a dump
+  // never stalls programming, no matter how large the cache is.
+  std::shared_ptr<const EntityCache> entity_cache;
+  absl::optional<p4::config::v1::P4Info> p4info;
+  EntityCacheSnapshotHeader header;
+  {
+    ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+    entity_cache = entity_cache_;
+    if (forwarding_pipeline_config_.has_value()) {
+      p4info = forwarding_pipeline_config_->p4info();
+      header.p4info_cookie = forwarding_pipeline_config_->cookie().cookie();
+    }
+  }
+
   sonic::PacketIoCounters counters = GetPacketIoCounters();
   std::string debug_str = absl::StrFormat(
       "Timestamp: %s\n"
@@ -1181,39 +2157,80 @@ absl::Status P4RuntimeImpl::DumpDebugData(const std::string& path,
       counters.packet_out_errors, counters.packet_in_received,
       counters.packet_in_errors);
 
-  return gutil::WriteFile(debug_str, path + "/packet_io_counters");
+  // Try to write every file even if one of them fails.
+  std::vector<absl::Status> statuses;
+  statuses.push_back(gutil::WriteFile(debug_str, path + "/packet_io_counters"));
+  statuses.push_back(
+      gutil::WriteFile(RuntimeIntrospectionReport(GetRuntimeIntrospection()),
+                       path + "/runtime_introspection"));
+  if (p4info.has_value()) {
+    statuses.push_back(gutil::SaveProtoToFile(path + "/p4info.txt", *p4info));
+  }
+
+  // The binary snapshot can be loaded back into an EntityCache, and the text
+  // version is for reading.
+  statuses.push_back(WriteEntityCacheSnapshot(path + "/entity_cache.bin",
+                                              header, *entity_cache));
+  statuses.push_back(
+      WriteEntityCacheText(path + "/entity_cache.txt", *entity_cache));
+  if (write_capture_ring_ != nullptr) {
+    statuses.push_back(
+        write_capture_ring_->Dump(path + "/write_capture.bin"));
+  }
+
+  for (const absl::Status& status : statuses) {
+    RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
 }
 
 //absl::Status P4RuntimeImpl::VerifyState(bool update_component_state) {
 absl::Status P4RuntimeImpl::VerifyState() {
-  absl::MutexLock l(&server_state_lock_);
+  absl::MutexLock programming_lock(&write_lock_);
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
   std::vector<std::string> failures = {"P4RT App State Verification failures:"};
 
   // Verify the P4RT_TABLE entries against the cache.
   std::vector<pdpi::IrEntity> p4rt_entities = GetIrEntitiesFromCache(
-      entity_cache_, *ir_p4info_, translate_port_ids_, port_translation_map_,
-      *cpu_queue_translator_, p4::v1::Entity::kTableEntry, failures);
+      *entity_cache_, ir_p4info_->info(), translate_port_ids_,
+      *port_translator_, *CurrentCpuQueueTranslator(),
+      p4::v1::Entity::kTableEntry, failures);
   std::vector<std::string> p4rt_table_failures =
-      sonic::VerifyP4rtTableWithCacheEntities(*p4rt_table_.app_db,
-                                              p4rt_entities, *ir_p4info_);
+      sonic::VerifyP4rtTableWithCacheEntities(
+          *p4rt_table_.app_db, p4rt_entities, ir_p4info_->info());
   if (!p4rt_table_failures.empty()) {
     failures.insert(failures.end(), p4rt_table_failures.begin(),
                     p4rt_table_failures.end());
   }
 
+  VerifyNonP4rtTableState(failures, /*only_changed_entries=*/false);
+
+  if (failures.size() > 1) {
+    return gutil::UnknownErrorBuilder() << absl::StrJoin(failures, "\n  ");
+  }
+  return absl::OkStatus();
+}
+
+void P4RuntimeImpl::VerifyNonP4rtTableState(
+    std::vector<std::string>& failures, bool only_changed_entries) {
+  auto verify_table = [only_changed_entries](auto& table) {
+    if (only_changed_entries) {
+      return sonic::VerifyChangedAppStateDbAndAppDbEntries(
+          *table.app_state_db, *table.app_db, *table.generations);
+    }
+    return sonic::VerifyAppStateDbAndAppDbEntries(*table.app_state_db,
+                                                  *table.app_db);
+  };
+
   // Verify the VRF_TABLE entries.
-  std::vector<std::string> vrf_table_failures =
-      sonic::VerifyAppStateDbAndAppDbEntries(*vrf_table_.app_state_db,
-                                             *vrf_table_.app_db);
+  std::vector<std::string> vrf_table_failures = verify_table(vrf_table_);
   if (!vrf_table_failures.empty()) {
     failures.insert(failures.end(), vrf_table_failures.begin(),
                     vrf_table_failures.end());
   }
 
   // Verify the HASH_TABLE entries.
-  std::vector<std::string> hash_table_failures =
-      sonic::VerifyAppStateDbAndAppDbEntries(*hash_table_.app_state_db,
-                                             *hash_table_.app_db);
+  std::vector<std::string> hash_table_failures = verify_table(hash_table_);
   if (!hash_table_failures.empty()) {
     failures.insert(failures.end(), hash_table_failures.begin(),
                     hash_table_failures.end());
@@ -1221,8 +2238,7 @@ absl::Status P4RuntimeImpl::VerifyState() {
 
   // Verify the SWITCH_TABLE entries.
   std::vector<std::string> switch_table_failures =
-      sonic::VerifyAppStateDbAndAppDbEntries(*switch_table_.app_state_db,
-                                             *switch_table_.app_db);
+      verify_table(switch_table_);
   if (!switch_table_failures.empty()) {
     failures.insert(failures.end(), switch_table_failures.begin(),
                     switch_table_failures.end());
@@ -1230,8 +2246,9 @@ absl::Status P4RuntimeImpl::VerifyState() {
 
   // Verify the packet replication entries.
   std::vector<pdpi::IrEntity> packet_replication_entries =
-      GetIrEntitiesFromCache(entity_cache_, *ir_p4info_, translate_port_ids_,
-                             port_translation_map_, *cpu_queue_translator_,
+      GetIrEntitiesFromCache(*entity_cache_, ir_p4info_->info(),
+                             translate_port_ids_, *port_translator_,
+                             *CurrentCpuQueueTranslator(),
                              p4::v1::Entity::kPacketReplicationEngineEntry,
                              failures);
   std::vector<std::string> packet_replication_table_failures =
@@ -1241,16 +2258,271 @@ absl::Status P4RuntimeImpl::VerifyState() {
     failures.insert(failures.end(), packet_replication_table_failures.begin(),
                     packet_replication_table_failures.end());
   }
+}
 
-  if (failures.size() > 1) {
-    return gutil::UnknownErrorBuilder() << absl::StrJoin(failures, "\n  ");
+absl::Status P4RuntimeImpl::RefreshAclCounterCache() {
+  if (acl_counter_cache_ == nullptr) return absl::OkStatus();
+
+  // Like reads, the P4RT_TABLE is only used for its CountersDb which is
+  // guarded by the counter_db_lock_.
+  sonic::P4rtTable* p4rt_table = nullptr;
+  {
+    ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+    p4rt_table = &p4rt_table_;
+  }
+  return acl_counter_cache_->Refresh(
+      [&](const std::vector<std::string>& counter_db_keys)
+          -> absl::StatusOr<std::vector<AclCounterCache::CounterValues>> {
+        absl::MutexLock l(&counter_db_lock_);
+        return p4rt_table->counter_db->batch_get(counter_db_keys);
+      });
+}
+
+absl::Status P4RuntimeImpl::VerifyStateIncrementally(int max_keys) {
+  absl::MutexLock programming_lock(&write_lock_);
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  if (!ir_p4info_.has_value()) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "Switch has not configured the forwarding pipeline.";
+  }
+  if (max_keys <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Incremental state verification needs to check at least 1 key "
+              "per call.";
+  }
+
+  StateVerificationProgress& progress = state_verification_progress_;
+  std::vector<std::string> failures;
+
+  // Start a new pass by snapshotting the P4RT_TABLE keys from both the AppDb
+  // and the entity cache. Only reading the keys is cheap compared to reading,
+  // and translating, every entry which is spread out over later calls.
+  if (progress.cursor >= state_verification_keys_.size()) {
+    absl::btree_map<std::string, absl::optional<pdpi::EntityKey>> key_space;
+    for (std::string& key : sonic::GetAllP4TableEntryKeys(p4rt_table_)) {
+      key_space.try_emplace(std::move(key));
+    }
+    for (const auto& [entity_key, app_db_key] : entity_cache_->app_db_keys()) {
+      key_space[app_db_key] = entity_key;
+    }
+    state_verification_keys_.assign(key_space.begin(), key_space.end());
+    progress.cursor = 0;
+    progress.key_space_size = state_verification_keys_.size();
+    progress.current_pass_mismatches = 0;
+
+    // Every pass runs in the background, so only the VRF_TABLE, HASH_TABLE and
+    // SWITCH_TABLE entries that changed since the last pass are compared.
+    VerifyNonP4rtTableState(failures, /*only_changed_entries=*/true);
+  }
+
+  const int64_t slice_end = std::min<int64_t>(
+      progress.cursor + max_keys, state_verification_keys_.size());
+  std::vector<std::string> keys;
+  keys.reserve(slice_end - progress.cursor);
+  for (int64_t i = progress.cursor; i < slice_end; ++i) {
+    keys.push_back(state_verification_keys_[i].first);
+  }
+  std::vector<std::vector<std::pair<std::string, std::string>>> values =
+      p4rt_table_.app_db->batch_get(keys);
+  values.resize(keys.size());
+
+  for (int i = 0; i < keys.size(); ++i) {
+    const absl::optional<pdpi::EntityKey>& entity_key =
+        state_verification_keys_[progress.cursor + i].second;
+
+    // The entity may have been modified, or removed, since the pass started.
+    // Only use it if it still belongs to this AppDb key. Keys that were in the
+    // AppDb, but not the cache, at the start of the pass are already a
+    // mismatch and are reported if they are still in the AppDb.
+    std::optional<p4::v1::Entity> cache_entity;
+    if (entity_key.has_value()) {
+      const std::string* app_db_key = entity_cache_->FindAppDbKey(*entity_key);
+      if (app_db_key != nullptr && *app_db_key == keys[i]) {
+        cache_entity = entity_cache_->Find(*entity_key);
+      }
+    }
+
+    absl::optional<pdpi::IrTableEntry> cache_entry;
+    if (cache_entity.has_value()) {
+      auto ir_entity = TranslatePiEntityForOrchAgent(
+          *cache_entity, ir_p4info_->info(), translate_port_ids_,
+          *port_translator_, *CurrentCpuQueueTranslator(),
+          /*translate_key_only=*/false);
+      if (!ir_entity.ok() ||
+          ir_entity->entity_case() != pdpi::IrEntity::kTableEntry) {
+        failures.push_back(absl::StrCat(
+            "Failed to translate the entity cache entry for key: ", keys[i]));
+        continue;
+      }
+      cache_entry = std::move(*ir_entity->mutable_table_entry());
+    }
+
+    std::vector<std::string> entry_failures =
+        sonic::VerifyP4rtTableEntryWithCacheEntity(
+            keys[i], values[i],
+            cache_entry.has_value() ? &*cache_entry : nullptr);
+    failures.insert(failures.end(), entry_failures.begin(),
+                    entry_failures.end());
+  }
+
+  progress.cursor = slice_end;
+  progress.keys_verified += keys.size();
+  progress.mismatches += failures.size();
+  progress.current_pass_mismatches += failures.size();
+  if (progress.cursor >= state_verification_keys_.size()) {
+    ++progress.completed_passes;
+    progress.last_pass_mismatches = progress.current_pass_mismatches;
+    state_verification_keys_.clear();
+    progress.cursor = 0;
+  }
+
+  host_stats_table_.state_db->set(
+      "STATE_VERIFICATION",
+      {
+          {"completed_passes", absl::StrCat(progress.completed_passes)},
+          {"cursor", absl::StrCat(progress.cursor)},
+          {"key_space_size", absl::StrCat(progress.key_space_size)},
+          {"keys_verified", absl::StrCat(progress.keys_verified)},
+          {"mismatches", absl::StrCat(progress.mismatches)},
+          {"last_pass_mismatches", absl::StrCat(progress.last_pass_mismatches)},
+          {"timestamp", absl::StrCat(absl::ToUnixNanos(absl::Now()))},
+      });
+
+  if (!failures.empty()) {
+    return gutil::UnknownErrorBuilder()
+           << "P4RT App State Verification failures:\n  "
+           << absl::StrJoin(failures, "\n  ");
+  }
+  return absl::OkStatus();
+}
+
+StateVerificationProgress P4RuntimeImpl::GetStateVerificationProgress() {
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  return state_verification_progress_;
+}
+
+absl::Status P4RuntimeImpl::SaveEntityCacheSnapshot() {
+  if (!entity_cache_snapshot_path_.has_value()) return absl::OkStatus();
+
+  absl::MutexLock programming_lock(&write_lock_);
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  if (!forwarding_pipeline_config_.has_value()) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "Cannot save the entity cache before a forwarding pipeline "
+              "config has been applied.";
   }
+
+  EntityCacheSnapshotHeader header = {
+      .p4info_cookie = forwarding_pipeline_config_->cookie().cookie(),
+      .app_db_generation = CurrentAppDbGeneration(),
+  };
+  RETURN_IF_ERROR(WriteEntityCacheSnapshot(*entity_cache_snapshot_path_,
+                                           header, *entity_cache_));
+  LOG(INFO) << "Saved " << entity_cache_->size()
+            << " entities to the entity cache snapshot: "
+            << *entity_cache_snapshot_path_;
   return absl::OkStatus();
 }
 
+absl::Status P4RuntimeImpl::VerifyEntityCacheSnapshot() {
+  // Holding the write_lock_ means neither the entity cache, nor the AppDb, can
+  // change during verification. The AppDb connection is only ever used while
+  // holding the write_lock_ so it is safe to use after releasing the
+  // server_state_lock_. The same is true for the IrP4Info which cannot be
+  // changed once it has been set.
+  absl::MutexLock programming_lock(&write_lock_);
+
+  const pdpi::IrP4Info* ir_p4info = nullptr;
+  sonic::P4rtTable* p4rt_table = nullptr;
+  std::shared_ptr<const EntityCache> entity_cache;
+  std::shared_ptr<const CpuQueueTranslator> cpu_queue_translator;
+  std::shared_ptr<const PortTranslator> port_translator;
+  bool translate_port_ids = false;
+  {
+    ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+    if (!ir_p4info_.has_value()) {
+      return gutil::FailedPreconditionErrorBuilder()
+             << "Switch has not configured the forwarding pipeline.";
+    }
+    ir_p4info = &ir_p4info_->info();
+    p4rt_table = &p4rt_table_;
+    entity_cache = entity_cache_;
+    cpu_queue_translator = CurrentCpuQueueTranslator();
+    port_translator = port_translator_;
+    translate_port_ids = translate_port_ids_;
+  }
+
+  std::vector<std::string> failures;
+  std::vector<pdpi::IrEntity> p4rt_entities = GetIrEntitiesFromCache(
+      *entity_cache, *ir_p4info, translate_port_ids, *port_translator,
+      *cpu_queue_translator, p4::v1::Entity::kTableEntry, failures);
+  std::vector<std::string> p4rt_table_failures =
+      sonic::VerifyP4rtTableWithCacheEntities(*p4rt_table->app_db,
+                                              p4rt_entities, *ir_p4info);
+  failures.insert(failures.end(), p4rt_table_failures.begin(),
+                  p4rt_table_failures.end());
+
+  std::vector<pdpi::IrEntity> packet_replication_entries =
+      GetIrEntitiesFromCache(*entity_cache, *ir_p4info, translate_port_ids,
+                             *port_translator, *cpu_queue_translator,
+                             p4::v1::Entity::kPacketReplicationEngineEntry,
+                             failures);
+  std::vector<std::string> packet_replication_table_failures =
+      sonic::VerifyPacketReplicationWithCacheEntities(
+          *p4rt_table, packet_replication_entries);
+  failures.insert(failures.end(), packet_replication_table_failures.begin(),
+                  packet_replication_table_failures.end());
+
+  if (failures.empty()) {
+    LOG(INFO) << "Verified " << entity_cache->size()
+              << " entities from the entity cache snapshot.";
+    return absl::OkStatus();
+  }
+  LOG(WARNING) << "Entity cache snapshot does not match the AppDb. Rebuilding "
+                  "the cache:\n  "
+               << absl::StrJoin(failures, "\n  ");
+
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  auto rebuilt_cache = RebuildEntityEntryCache(
+      ir_p4info_->info(), *ir_translation_plan_, translate_port_ids_,
+      *port_translator_, *CurrentCpuQueueTranslator(), p4rt_table_, vrf_table_,
+      translation_pool_.get());
+  if (!rebuilt_cache.ok()) {
+    LOG(ERROR) << "Failed to rebuild the table cache after verifying the "
+                  "snapshot: "
+               << rebuilt_cache.status();
+    EnterCriticalState(rebuilt_cache.status().ToString());
+    return rebuilt_cache.status();
+  }
+  entity_cache_ = std::make_shared<EntityCache>(*std::move(rebuilt_cache));
+  return absl::OkStatus();
+}
+
+std::string P4RuntimeImpl::CurrentAppDbGeneration() {
+  std::vector<std::string> keys = sonic::GetAllP4TableEntryKeys(p4rt_table_);
+  for (const std::string& key : vrf_table_.app_db->keys()) {
+    keys.push_back(absl::StrCat("VRF_TABLE:", key));
+  }
+  return AppDbGeneration(std::move(keys));
+}
+
+absl::StatusOr<EntityCache> P4RuntimeImpl::LoadEntityCacheSnapshot(
+    uint64_t config_cookie) {
+  if (!entity_cache_snapshot_path_.has_value()) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "No entity cache snapshot path is configured.";
+  }
+  return ReadEntityCacheSnapshot(
+      *entity_cache_snapshot_path_,
+      EntityCacheSnapshotHeader{
+          .p4info_cookie = config_cookie,
+          .app_db_generation = CurrentAppDbGeneration(),
+      });
+}
+
 absl::StatusOr<FlowProgrammingStatistics>
 P4RuntimeImpl::GetFlowProgrammingStatistics() {
-  absl::MutexLock l(&server_state_lock_);
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
 
   std::optional<absl::Duration> max_write_time =
       write_execution_time_.ReadMaxValue();
@@ -1265,31 +2537,374 @@ P4RuntimeImpl::GetFlowProgrammingStatistics() {
   if (max_write_time.has_value()) {
     stats.max_write_time = *max_write_time;
   }
+  stats.write_latency = std::exchange(write_latency_, WriteLatencyStatistics());
+  stats.write_admission = write_admission_.GetStats();
+  stats.memory = GetMemoryFootprint();
   return stats;
 }
 
+RuntimeIntrospection P4RuntimeImpl::GetRuntimeIntrospection() {
+  RuntimeIntrospection introspection{
+      .read_request_count = read_total_requests_.ReadData(),
+      .read_time = read_execution_time_.ReadData(),
+      .write_admission = write_admission_.GetStats(),
+      .controller_manager_lock = controller_manager_->GetLockContention(),
+  };
+  {
+    ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+    introspection.write_latency = write_latency_;
+  }
+  // Read after releasing the lock, so the above acquisition is included.
+  introspection.server_state_lock = server_state_lock_contention_.GetStats();
+  {
+    absl::MutexLock l(&packetio_lock_);
+    if (packetio_impl_ != nullptr) {
+      introspection.packetio_queue = packetio_impl_->GetQueueStats();
+    }
+  }
+  {
+    absl::MutexLock l(&packet_in_latency_lock_);
+    introspection.packet_in_latency = packet_in_latency_;
+  }
+  return introspection;
+}
+
+MemoryFootprintStatistics P4RuntimeImpl::GetMemoryFootprint() const {
+  MemoryFootprintStatistics memory{.entity_cache = entity_cache_->footprint()};
+  for (const auto& [entity_type, footprint] :
+       entity_cache_->footprint_by_entity_type()) {
+    const google::protobuf::FieldDescriptor* entity_field =
+        p4::v1::Entity::descriptor()->FindFieldByNumber(entity_type);
+    memory.entity_cache_by_entity_type[entity_field != nullptr
+                                           ? entity_field->name()
+                                           : absl::StrCat(entity_type)] =
+        footprint;
+  }
+  for (const auto& [table_id, footprint] :
+       entity_cache_->footprint_by_table_id()) {
+    const pdpi::IrTableDefinition* table_def =
+        ir_p4info_.has_value()
+            ? gutil::FindOrNull(ir_p4info_->info().tables_by_id(), table_id)
+            : nullptr;
+    memory.entity_cache_by_table[table_def != nullptr
+                                     ? table_def->preamble().alias()
+                                     : absl::StrCat(table_id)] = footprint;
+  }
+
+  if (ir_p4info_.has_value()) {
+    memory.ir_p4info_bytes = ir_p4info_->info().SpaceUsedLong();
+  }
+  for (const auto& [action_profile_id, capacity] :
+       capacity_by_action_profile_id_) {
+    memory.action_profile_capacity_bytes +=
+        sizeof(action_profile_id) + sizeof(capacity) + capacity.name.size();
+  }
+  return memory;
+}
+
+void P4RuntimeImpl::PublishWriteAdmissionStatistics() {
+  const WriteAdmissionController::Stats stats = write_admission_.GetStats();
+  std::vector<std::pair<std::string, std::string>> fields = {
+      {"outstanding-batches", absl::StrCat(stats.outstanding_batches)},
+      {"outstanding-updates", absl::StrCat(stats.outstanding_updates)},
+      {"rejected-batches", absl::StrCat(stats.rejected_batches)},
+      {"orch-agent-latency-us",
+       absl::StrCat(absl::ToInt64Microseconds(stats.orch_agent_latency))},
+      {"last-update-timestamp", absl::StrCat(absl::ToUnixNanos(absl::Now()))},
+  };
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  host_stats_table_.state_db->set("WRITE_ADMISSION", fields);
+}
+
+void P4RuntimeImpl::PublishPacketIoStatistics() {
+  sonic::PacketIoQueueStats stats;
+  {
+    absl::MutexLock l(&packetio_lock_);
+    if (packetio_impl_ != nullptr) stats = packetio_impl_->GetQueueStats();
+  }
+  const std::string timestamp = absl::StrCat(absl::ToUnixNanos(absl::Now()));
+  std::vector<swss::KeyOpFieldsValuesTuple> updates;
+  updates.push_back(swss::KeyOpFieldsValuesTuple(
+      "PACKET_IO", "SET",
+      {
+          {"queued-packet-ins", absl::StrCat(stats.queued_packet_ins)},
+          {"dropped-packet-ins", absl::StrCat(stats.dropped_packet_ins)},
+          {"rate-limited-packet-ins",
+           absl::StrCat(stats.rate_limited_packet_ins)},
+          {"last-update-timestamp", timestamp},
+      }));
+  for (const auto& [port_name, drops] : stats.rate_limited_packet_ins_by_port) {
+    updates.push_back(swss::KeyOpFieldsValuesTuple(
+        absl::StrCat("PACKET_IO:PORT:", port_name), "SET",
+        {{"rate-limited-packet-ins", absl::StrCat(drops)},
+         {"last-update-timestamp", timestamp}}));
+  }
+
+  PacketInLatencyStatistics packet_in_latency;
+  {
+    absl::MutexLock l(&packet_in_latency_lock_);
+    packet_in_latency =
+        std::exchange(packet_in_latency_, PacketInLatencyStatistics());
+  }
+  updates.push_back(swss::KeyOpFieldsValuesTuple(
+      "PACKET_IN_LATENCY", "SET",
+      PacketInLatencyFields(packet_in_latency.total, timestamp)));
+  for (const auto& [port_name, latencies] : packet_in_latency.by_port) {
+    updates.push_back(swss::KeyOpFieldsValuesTuple(
+        absl::StrCat("PACKET_IN_LATENCY:PORT:", port_name), "SET",
+        PacketInLatencyFields(latencies, timestamp)));
+  }
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  host_stats_table_.state_db->batch_set(updates);
+}
+
+void P4RuntimeImpl::PublishWriteLatencyStatistics(
+    const WriteLatencyStatistics& write_latency) {
+  const std::string timestamp = absl::StrCat(absl::ToUnixNanos(absl::Now()));
+  std::vector<std::pair<std::string, std::string>> fields =
+      StageLatencyFields(write_latency.stages, timestamp);
+  AppendLatencyFields("total", write_latency.total, fields);
+
+  std::vector<swss::KeyOpFieldsValuesTuple> updates;
+  updates.push_back(
+      swss::KeyOpFieldsValuesTuple("WRITE_LATENCY", "SET", std::move(fields)));
+  for (const auto& [entity_type, latencies] :
+       write_latency.stages_by_entity_type) {
+    updates.push_back(swss::KeyOpFieldsValuesTuple(
+        absl::StrCat("WRITE_LATENCY:ENTITY:", entity_type), "SET",
+        StageLatencyFields(latencies, timestamp)));
+  }
+  for (const auto& [table, latencies] : write_latency.stages_by_table) {
+    updates.push_back(swss::KeyOpFieldsValuesTuple(
+        absl::StrCat("WRITE_LATENCY:TABLE:", table), "SET",
+        StageLatencyFields(latencies, timestamp)));
+  }
+
+  // Every table adds its own entry, so pipeline the writes instead of paying a
+  // Redis round trip for each one while holding the lock.
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  host_stats_table_.state_db->batch_set(updates);
+}
+
+void P4RuntimeImpl::PublishResourceUtilization() {
+  const std::string timestamp = absl::StrCat(absl::ToUnixNanos(absl::Now()));
+
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  if (!ir_p4info_.has_value()) return;
+  std::vector<swss::KeyOpFieldsValuesTuple> updates;
+  for (const auto& [table_id, table_def] :
+       ir_p4info_->info().tables_by_id()) {
+    std::vector<std::pair<std::string, std::string>> fields = {
+        {"entries", absl::StrCat(entity_cache_->TableEntryCount(table_id))},
+        {"max-entries", absl::StrCat(table_def.size())},
+        {"last-update-timestamp", timestamp},
+    };
+    updates.push_back(swss::KeyOpFieldsValuesTuple(
+        absl::StrCat("RESOURCE_UTILIZATION:TABLE:",
+                     table_def.preamble().alias()),
+        "SET", std::move(fields)));
+  }
+  for (const auto& [action_profile_id, capacity] :
+       capacity_by_action_profile_id_) {
+    std::vector<std::pair<std::string, std::string>> fields = {
+        {"current-weight", absl::StrCat(capacity.current_utilization)},
+        {"max-weight", absl::StrCat(capacity.max_weight_for_all_groups)},
+        {"max-group-size", absl::StrCat(capacity.max_group_size)},
+        {"last-update-timestamp", timestamp},
+    };
+    updates.push_back(swss::KeyOpFieldsValuesTuple(
+        absl::StrCat("RESOURCE_UTILIZATION:ACTION_PROFILE:", capacity.name),
+        "SET", std::move(fields)));
+  }
+  host_stats_table_.state_db->batch_set(updates);
+}
+
+void P4RuntimeImpl::PublishMemoryFootprint() {
+  const std::string timestamp = absl::StrCat(absl::ToUnixNanos(absl::Now()));
+  auto footprint_fields = [&](const EntityCache::Footprint& footprint) {
+    return std::vector<std::pair<std::string, std::string>>{
+        {"entries", absl::StrCat(footprint.entries)},
+        {"bytes", absl::StrCat(footprint.bytes)},
+        {"last-update-timestamp", timestamp},
+    };
+  };
+
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  const MemoryFootprintStatistics memory = GetMemoryFootprint();
+  std::vector<swss::KeyOpFieldsValuesTuple> updates;
+  updates.push_back(swss::KeyOpFieldsValuesTuple(
+      "MEMORY_FOOTPRINT", "SET",
+      {
+          {"entity-cache-entries", absl::StrCat(memory.entity_cache.entries)},
+          {"entity-cache-bytes", absl::StrCat(memory.entity_cache.bytes)},
+          {"ir-p4info-bytes", absl::StrCat(memory.ir_p4info_bytes)},
+          {"action-profile-capacity-bytes",
+           absl::StrCat(memory.action_profile_capacity_bytes)},
+          {"last-update-timestamp", timestamp},
+      }));
+  for (const auto& [entity_type, footprint] :
+       memory.entity_cache_by_entity_type) {
+    updates.push_back(swss::KeyOpFieldsValuesTuple(
+        absl::StrCat("MEMORY_FOOTPRINT:ENTITY:", entity_type), "SET",
+        footprint_fields(footprint)));
+  }
+  for (const auto& [table, footprint] : memory.entity_cache_by_table) {
+    updates.push_back(swss::KeyOpFieldsValuesTuple(
+        absl::StrCat("MEMORY_FOOTPRINT:TABLE:", table), "SET",
+        footprint_fields(footprint)));
+  }
+  host_stats_table_.state_db->batch_set(updates);
+}
+
 void P4RuntimeImpl::SetCpuQueueTranslator(
     std::unique_ptr<CpuQueueTranslator> translator) {
-  absl::MutexLock l(&server_state_lock_);
-  cpu_queue_translator_ = std::move(translator);
+  std::atomic_store(&cpu_queue_translator_,
+                    std::shared_ptr<const CpuQueueTranslator>(
+                        std::move(translator)));
 }
 
-sonic::PacketIoCounters P4RuntimeImpl::GetPacketIoCounters() {
-  absl::MutexLock l(&server_state_lock_);
+std::shared_ptr<const CpuQueueTranslator>
+P4RuntimeImpl::CurrentCpuQueueTranslator() const {
+  return std::atomic_load(&cpu_queue_translator_);
+}
+
+void P4RuntimeImpl::PublishPacketIoView(bool ir_p4info_changed) {
+  PacketIoView view{.port_translator = port_translator_};
+  std::shared_ptr<const PacketIoView> current = CurrentPacketIoView();
+  if (current->port_translator == view.port_translator) {
+    view.packet_in_templates = current->packet_in_templates;
+  } else {
+    view.packet_in_templates =
+        std::make_shared<const PacketInTemplates>(*view.port_translator);
+  }
+  if (!ir_p4info_changed) {
+    view.ir_p4info = current->ir_p4info;
+    view.packet_out_layout = current->packet_out_layout;
+  } else if (ir_p4info_.has_value()) {
+    view.ir_p4info = ir_p4info_->shared_info();
+    view.packet_out_layout = std::make_shared<const PacketOutMetadataLayout>(
+        BuildPacketOutMetadataLayout(ir_p4info_->info()));
+  }
+  std::atomic_store(&packetio_view_,
+                    std::make_shared<const PacketIoView>(std::move(view)));
+}
 
-  return packetio_counters_;
+std::shared_ptr<const P4RuntimeImpl::PacketIoView>
+P4RuntimeImpl::CurrentPacketIoView() const {
+  return std::atomic_load(&packetio_view_);
+}
+
+EntityCache& P4RuntimeImpl::MutableEntityCache() {
+  // Readers can only take a new reference to the cache while holding the
+  // server_state_lock_. So if we are the only owner now, nobody else can be
+  // reading the cache while we modify it.
+  if (entity_cache_.use_count() > 1) {
+    entity_cache_ = std::make_shared<EntityCache>(*entity_cache_);
+  }
+  return *entity_cache_;
+}
+
+sonic::PacketIoCounters P4RuntimeImpl::GetPacketIoCounters() {
+  return sonic::PacketIoCounters{
+      .packet_out_sent = packet_out_sent_.ReadData(),
+      .packet_out_errors = packet_out_errors_.ReadData(),
+      .packet_in_received = packet_in_received_.ReadData(),
+      .packet_in_errors = packet_in_errors_.ReadData(),
+  };
 }
 
 absl::Status P4RuntimeImpl::HandlePacketOutRequest(
     const p4::v1::PacketOut& packet_out) {
-  if (!ir_p4info_.has_value()) {
+  std::shared_ptr<const PacketIoView> view = CurrentPacketIoView();
+  if (view->ir_p4info == nullptr) {
     return gutil::FailedPreconditionErrorBuilder()
            << "Switch has not configured the forwarding pipeline.";
   }
-  return SendPacketOut(*ir_p4info_, translate_port_ids_, port_translation_map_,
+  absl::MutexLock l(&packetio_lock_);
+  return SendPacketOut(*view->ir_p4info, *view->packet_out_layout,
+                       translate_port_ids_, *view->port_translator,
                        packetio_impl_.get(), packet_out);
 }
 
+absl::Status P4RuntimeImpl::CommitSavedPipelineConfig() {
+  absl::Status status = LoadSavedPipelineConfig();
+  if (status.ok()) {
+    LOG(INFO) << "Committed the saved forwarding config.";
+  } else {
+    LOG(WARNING) << "Could not commit the saved forwarding config: " << status;
+  }
+  if (!saved_config_committed_.HasBeenNotified()) {
+    saved_config_committed_.Notify();
+  }
+  return status;
+}
+
+absl::Status P4RuntimeImpl::LoadSavedPipelineConfig() {
+  // Holding the write_lock_ means neither the AppDb, nor the IrP4Info, can
+  // change while the cache is rebuilt. So, like VerifyEntityCacheSnapshot(),
+  // they can be used after releasing the server_state_lock_.
+  absl::MutexLock programming_lock(&write_lock_);
+
+  const pdpi::IrP4Info* ir_p4info = nullptr;
+  const IrTranslationPlan* translation_plan = nullptr;
+  sonic::P4rtTable* p4rt_table = nullptr;
+  sonic::VrfTable* vrf_table = nullptr;
+  std::shared_ptr<const CpuQueueTranslator> cpu_queue_translator;
+  std::shared_ptr<const PortTranslator> port_translator;
+  {
+    ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+    if (forwarding_pipeline_config_.has_value()) return absl::OkStatus();
+    if (!forwarding_config_full_path_.has_value()) {
+      return gutil::FailedPreconditionErrorBuilder()
+             << "P4RT App has not been configured to save forwarding configs.";
+    }
+    p4::v1::SetForwardingPipelineConfigRequest saved_config;
+    RETURN_IF_ERROR(gutil::ReadProtoFromFile(*forwarding_config_full_path_,
+                                             saved_config.mutable_config()))
+        << "Could not read saved config.";
+
+    // A warm start loads the cache from its snapshot, which is already cheap.
+    if (is_freeze_mode_ && entity_cache_snapshot_path_.has_value()) {
+      return gutil::GrpcStatusToAbslStatus(VerifyAndCommitPipelineConfig(
+          saved_config, /*config_verified=*/false));
+    }
+
+    RETURN_IF_ERROR(gutil::GrpcStatusToAbslStatus(
+        ReconcileAndCommitPipelineConfig(saved_config,
+                                         /*config_verified=*/false)));
+    ir_p4info = &ir_p4info_->info();
+    translation_plan = &*ir_translation_plan_;
+    p4rt_table = &p4rt_table_;
+    vrf_table = &vrf_table_;
+    cpu_queue_translator = CurrentCpuQueueTranslator();
+    port_translator = port_translator_;
+  }
+
+  absl::StatusOr<EntityCache> entity_cache = RebuildEntityEntryCache(
+      *ir_p4info, *translation_plan, translate_port_ids_, *port_translator,
+      *cpu_queue_translator, *p4rt_table, *vrf_table, translation_pool_.get());
+
+  ProfiledMutexLock l(&server_state_lock_, &server_state_lock_contention_);
+  if (!entity_cache.ok()) {
+    LOG(ERROR) << "Failed to build the table cache for the saved config: "
+               << entity_cache.status();
+    return gutil::GrpcStatusToAbslStatus(
+        EnterCriticalState(entity_cache.status().ToString()));
+  }
+  entity_cache_ = std::make_shared<EntityCache>(*std::move(entity_cache));
+  return absl::OkStatus();
+}
+
+grpc::Status P4RuntimeImpl::AwaitSavedPipelineConfig() const {
+  if (saved_config_committed_.WaitForNotificationWithTimeout(
+          kSavedConfigCommitWait)) {
+    return grpc::Status::OK;
+  }
+  return grpc::Status(grpc::StatusCode::UNAVAILABLE,
+                      "The switch is still committing its saved forwarding "
+                      "config.");
+}
+
 grpc::Status P4RuntimeImpl::VerifyPipelineConfig(
     const p4::v1::SetForwardingPipelineConfigRequest& request) const {
   // In all cases where we need to verify a config the spec requires a config to
@@ -1316,7 +2931,8 @@ grpc::Status P4RuntimeImpl::VerifyPipelineConfig(
 }
 
 grpc::Status P4RuntimeImpl::VerifyAndCommitPipelineConfig(
-    const p4::v1::SetForwardingPipelineConfigRequest& request) {
+    const p4::v1::SetForwardingPipelineConfigRequest& request,
+    bool config_verified) {
   // Today we do not clear any forwarding state so if we detect any we return an
   // UNIMPLEMENTED error.
   if (forwarding_pipeline_config_.has_value()) {
@@ -1327,15 +2943,42 @@ grpc::Status P4RuntimeImpl::VerifyAndCommitPipelineConfig(
   }
 
   // Apply the P4Info, and configure the switch.
-  grpc::Status commit_status = ReconcileAndCommitPipelineConfig(request);
+  grpc::Status commit_status =
+      ReconcileAndCommitPipelineConfig(request, config_verified);
   if (!commit_status.ok()) {
     return commit_status;
   }
 
+  // During a warm start the cache can be loaded from the snapshot taken before
+  // the reboot. The snapshot is then verified against the AppDb in the
+  // background instead of blocking the commit.
+  if (is_freeze_mode_ && entity_cache_snapshot_path_.has_value() &&
+      !snapshot_verification_thread_.joinable()) {
+    absl::StatusOr<EntityCache> snapshot =
+        LoadEntityCacheSnapshot(request.config().cookie().cookie());
+    if (snapshot.ok()) {
+      LOG(INFO) << "Loaded " << snapshot->size()
+                << " entities from the entity cache snapshot.";
+      entity_cache_ = std::make_shared<EntityCache>(*std::move(snapshot));
+      snapshot_verification_thread_ = std::thread([this] {
+        absl::Status status = VerifyEntityCacheSnapshot();
+        if (!status.ok()) {
+          LOG(ERROR) << "Failed to verify the entity cache snapshot: "
+                     << status;
+        }
+      });
+      return grpc::Status::OK;
+    }
+    LOG(WARNING) << "Rebuilding the entity cache from the AppDb because the "
+                    "snapshot could not be used: "
+                 << snapshot.status();
+  }
+
   // Rebuild the table_entry cache.
   auto entity_cache = RebuildEntityEntryCache(
-      *ir_p4info_, translate_port_ids_, port_translation_map_,
-      *cpu_queue_translator_, p4rt_table_, vrf_table_);
+      ir_p4info_->info(), *ir_translation_plan_, translate_port_ids_,
+      *port_translator_, *CurrentCpuQueueTranslator(), p4rt_table_, vrf_table_,
+      translation_pool_.get());
   if (!entity_cache.ok()) {
     LOG(ERROR) << "Failed to build the table cache during COMMIT: "
                << entity_cache.status();
@@ -1344,7 +2987,7 @@ grpc::Status P4RuntimeImpl::VerifyAndCommitPipelineConfig(
     return EnterCriticalState(entity_cache.status().ToString(),
                               component_state_); */
   }
-  entity_cache_ = *std::move(entity_cache);
+  entity_cache_ = std::make_shared<EntityCache>(*std::move(entity_cache));
 
   return grpc::Status::OK;
 }
@@ -1372,59 +3015,48 @@ grpc::Status P4RuntimeImpl::CommitPipelineConfig(
     return gutil::AbslStatusToGrpcStatus(read_status);
   }
 
-  return VerifyAndCommitPipelineConfig(saved_config);
+  return VerifyAndCommitPipelineConfig(saved_config,
+                                       /*config_verified=*/false);
 }
 
 grpc::Status P4RuntimeImpl::ReconcileAndCommitPipelineConfig(
-    const p4::v1::SetForwardingPipelineConfigRequest& request) {
-  grpc::Status verified = VerifyPipelineConfig(request);
-  if (!verified.ok()) return verified;
-
-  // We cannot reconcile any config today so if we see that the new forwarding
-  // config is different from the current one we just return an error.
-  std::string diff_report;
-  if (forwarding_pipeline_config_.has_value() &&
-      !P4InfoEquals(forwarding_pipeline_config_->p4info(),
-                    request.config().p4info(), &diff_report)) {
-    LOG(WARNING) << "Cannot modify P4Info once it has been configured.";
-    return grpc::Status(
-        grpc::StatusCode::UNIMPLEMENTED,
-        absl::StrCat(
-            "Modifying a configured forwarding pipeline is not currently "
-            "supported. Please reboot the device. Configuration "
-            "differences:\n",
-            diff_report));
+    const p4::v1::SetForwardingPipelineConfigRequest& request,
+    bool config_verified) {
+  // A P4Info that matches the current one has already been validated, so only
+  // the cookie needs to be updated.
+  bool same_p4info = request.has_config() &&
+                     forwarding_pipeline_config_.has_value() &&
+                     P4InfoEquals(forwarding_pipeline_config_->p4info(),
+                                  request.config().p4info(),
+                                  /*diff_report=*/nullptr);
+  if (!same_p4info && !config_verified) {
+    grpc::Status verified = VerifyPipelineConfig(request);
+    if (!verified.ok()) return verified;
+  }
+
+  // Only ACL tables can be changed in a configured pipeline.
+  if (forwarding_pipeline_config_.has_value() && !same_p4info) {
+    grpc::Status reconciled = ReconcileAclTables(request.config().p4info());
+    if (!reconciled.ok()) return reconciled;
   }
 
   // If the IrP4Info hasn't been set then we need to configure the lower layers.
   if (!ir_p4info_.has_value()) {
     // Collect any P4RT constraints from the P4Info.
-    auto constraint_info =
-        p4_constraints::P4ToConstraintInfo(request.config().p4info());
+    auto constraint_info = CreateConstraintInfo(request.config().p4info());
     if (!constraint_info.ok()) {
-      LOG(WARNING) << "Could not get constraint info from P4Info: "
-                   << constraint_info.status();
-      return gutil::AbslStatusToGrpcStatus(
-          absl::Status(constraint_info.status().code(),
-                       absl::StrCat("[P4 Constraint] ",
-                                    constraint_info.status().message())));
+      return gutil::AbslStatusToGrpcStatus(constraint_info.status());
     }
 
     // Convert the P4Info into an IrP4Info.
-    auto ir_p4info = pdpi::CreateIrP4Info(request.config().p4info());
+    auto ir_p4info = CreateIrP4InfoForOrchAgent(request.config().p4info());
     if (!ir_p4info.ok()) {
-      LOG(WARNING) << "Could not convert P4Info into IrP4Info: "
-                   << ir_p4info.status();
-      return gutil::AbslStatusToGrpcStatus(absl::Status(
-          ir_p4info.status().code(),
-          absl::StrCat("[P4RT/PDPI] ", ir_p4info.status().message())));
+      return gutil::AbslStatusToGrpcStatus(ir_p4info.status());
     }
-    // Remove `@unsupported` entities so their use in requests will be rejected.
-    pdpi::RemoveUnsupportedEntities(*ir_p4info);
-    TranslateIrP4InfoForOrchAgent(*ir_p4info);
 
     // Apply a config if we don't currently have one.
-    absl::Status config_result = ConfigureAppDbTables(*ir_p4info);
+    absl::Status config_result = ConfigureAppDbTables(
+        ir_p4info->info(), request.config().cookie().cookie());
     if (!config_result.ok()) {
       LOG(ERROR) << "Failed to apply ForwardingPipelineConfig: "
                  << config_result;
@@ -1434,9 +3066,11 @@ grpc::Status P4RuntimeImpl::ReconcileAndCommitPipelineConfig(
     }
 
     // Store resource utilization limits for any ActionProfiles.
-    for (const auto& [action_profile_name, action_profile_def] :
-         ir_p4info->action_profiles_by_name()) {
-      capacity_by_action_profile_name_[action_profile_name] =
+    for (const auto& [action_profile_id, action_profile_def] :
+         ir_p4info->info().action_profiles_by_id()) {
+      const std::string& action_profile_name =
+          action_profile_def.action_profile().preamble().alias();
+      capacity_by_action_profile_id_[action_profile_id] =
           GetActionProfileResourceCapacity(action_profile_def);
       LOG(INFO) << "Adding action profile limits for '" << action_profile_name
                 << "': max_weights_for_all_groups="
@@ -1444,8 +3078,12 @@ grpc::Status P4RuntimeImpl::ReconcileAndCommitPipelineConfig(
     }
 
     // Update P4RuntimeImpl's state only if we succeed.
-    p4_constraint_info_ = *std::move(constraint_info);
+    constraint_plan_.emplace(ir_p4info->info(), *std::move(constraint_info));
+    ir_translation_plan_.emplace(ir_p4info->info());
+    app_db_serialization_plan_.emplace(ir_p4info->info());
     ir_p4info_ = *std::move(ir_p4info);
+    UpdateRoleWriteLocks();
+    PublishPacketIoView(/*ir_p4info_changed=*/true);
   }
 
   // The ForwardingPipelineConfig is still updated in case the cookie value has
@@ -1462,6 +3100,93 @@ grpc::Status P4RuntimeImpl::ReconcileAndCommitPipelineConfig(
   return grpc::Status::OK;
 }
 
+grpc::Status P4RuntimeImpl::ReconcileAclTables(
+    const p4::config::v1::P4Info& p4info) {
+  auto constraint_info = CreateConstraintInfo(p4info);
+  if (!constraint_info.ok()) {
+    return gutil::AbslStatusToGrpcStatus(constraint_info.status());
+  }
+  auto ir_p4info = CreateIrP4InfoForOrchAgent(p4info);
+  if (!ir_p4info.ok()) {
+    return gutil::AbslStatusToGrpcStatus(ir_p4info.status());
+  }
+
+  absl::StatusOr<AclTableDiff> diff =
+      DiffAclTables(ir_p4info_->info(), ir_p4info->info());
+  if (!diff.ok()) {
+    LOG(WARNING) << "Cannot modify P4Info once it has been configured: "
+                 << diff.status();
+    return gutil::AbslStatusToGrpcStatus(diff.status());
+  }
+
+  // Installed entries could not be translated against the new definition, so
+  // only ACL tables without entries can be changed.
+  for (const pdpi::IrTableDefinition& table : diff->removed) {
+    int entries = entity_cache_->TableEntryCount(table.preamble().id());
+    if (entries > 0) {
+      return gutil::AbslStatusToGrpcStatus(
+          gutil::FailedPreconditionErrorBuilder()
+          << "Cannot modify ACL table '" << table.preamble().alias()
+          << "' because it still has " << entries << " entries.");
+    }
+  }
+  std::vector<sonic::CompiledAclTableDefinition> added_definitions;
+  for (const pdpi::IrTableDefinition& table : diff->added) {
+    absl::StatusOr<sonic::CompiledAclTableDefinition> definition =
+        sonic::CompileAclTableDefinition(table);
+    if (!definition.ok()) {
+      return gutil::AbslStatusToGrpcStatus(
+          gutil::InvalidArgumentErrorBuilder()
+          << "Cannot add ACL table '" << table.preamble().alias()
+          << "': " << definition.status().message());
+    }
+    added_definitions.push_back(*std::move(definition));
+  }
+
+  // From here on the AppDb is being changed, so a failure leaves it out of sync
+  // with the current IrP4Info.
+  for (const pdpi::IrTableDefinition& table : diff->removed) {
+    LOG(INFO) << "Removing ACL table: " << table.preamble().alias();
+    absl::Status status = WaitForAclTableDefinitionResponse(
+        p4rt_table_, sonic::RemoveAclTableDefinition(p4rt_table_, table));
+    if (!status.ok()) {
+      return EnterCriticalState(absl::StrCat("Failed to remove ACL table '",
+                                             table.preamble().alias(),
+                                             "': ", status.ToString()));
+    }
+  }
+  for (int i = 0; i < diff->added.size(); ++i) {
+    const std::string& table_name = diff->added[i].preamble().alias();
+    LOG(INFO) << "Configuring ACL table: " << table_name;
+    absl::Status status = WaitForAclTableDefinitionResponse(
+        p4rt_table_,
+        sonic::InsertAclTableDefinition(p4rt_table_, added_definitions[i]));
+    if (!status.ok()) {
+      return EnterCriticalState(absl::StrCat(
+          "Failed to add ACL table '", table_name, "': ", status.ToString()));
+    }
+  }
+
+  LOG(INFO) << "Reconciled the forwarding pipeline by removing "
+            << diff->removed.size() << " and adding " << diff->added.size()
+            << " ACL table definitions.";
+  constraint_plan_.emplace(ir_p4info->info(), *std::move(constraint_info));
+  ir_translation_plan_.emplace(ir_p4info->info());
+  app_db_serialization_plan_.emplace(ir_p4info->info());
+  ir_p4info_ = *std::move(ir_p4info);
+  UpdateRoleWriteLocks();
+  PublishPacketIoView(/*ir_p4info_changed=*/true);
+  return grpc::Status::OK;
+}
+
+void P4RuntimeImpl::UpdateRoleWriteLocks() {
+  role_write_locks_.clear();
+  for (const std::string& role : GetIndependentRoles(ir_p4info_->info())) {
+    LOG(INFO) << "Role '" << role << "' can be programmed independently.";
+    role_write_locks_[role] = std::make_unique<absl::Mutex>();
+  }
+}
+
 grpc::Status P4RuntimeImpl::SavePipelineConfig(
     const p4::v1::ForwardingPipelineConfig& config) const {
   // If the save path is not set then there is nothing to do.
@@ -1475,9 +3200,22 @@ grpc::Status P4RuntimeImpl::SavePipelineConfig(
 }
 
 absl::Status P4RuntimeImpl::ConfigureAppDbTables(
-    const pdpi::IrP4Info& ir_p4info) {
+    const pdpi::IrP4Info& ir_p4info, uint64_t p4info_cookie) {
   nlohmann::json ext_tables_json = {};
 
+  // Compiling the ACL table definitions parses every ACL annotation, so they
+  // are reused from the cache file when the P4Info has not changed.
+  sonic::AclTableDefinitions acl_definitions;
+  if (acl_table_definition_cache_path_.has_value()) {
+    ASSIGN_OR_RETURN(acl_definitions,
+                     sonic::LoadOrCompileAclTableDefinitions(
+                         *acl_table_definition_cache_path_, p4info_cookie,
+                         ir_p4info));
+  } else {
+    ASSIGN_OR_RETURN(acl_definitions,
+                     sonic::CompileAclTableDefinitions(ir_p4info));
+  }
+
   // Setup definitions for each each P4 ACL table.
   for (const pdpi::IrTableDefinition& table :
        OrderTablesBySize(ir_p4info.tables_by_name())) {
@@ -1488,10 +3226,14 @@ absl::Status P4RuntimeImpl::ConfigureAppDbTables(
     // Add ACL table definition to AppDb (if applicable).
     if (table_type == table::Type::kAcl) {
       LOG(INFO) << "Configuring ACL table: " << table_name;
-      ASSIGN_OR_RETURN(std::string acl_key,
-                       sonic::InsertAclTableDefinition(p4rt_table_, table),
-                       _ << "Failed to add ACL table definition '" << table_name
-                         << "' to AppDb.");
+      auto acl_definition = acl_definitions.find(table_name);
+      if (acl_definition == acl_definitions.end()) {
+        return gutil::InternalErrorBuilder()
+               << "Failed to add ACL table definition '" << table_name
+               << "' to AppDb. The table was not compiled.";
+      }
+      std::string acl_key =
+          sonic::InsertAclTableDefinition(p4rt_table_, acl_definition->second);
 
       // Wait for OA to confirm it can realize the table updates.
       ASSIGN_OR_RETURN(
@@ -1541,74 +3283,79 @@ absl::StatusOr<std::thread> P4RuntimeImpl::StartReceive(
   // Define the lambda function for the callback to be executed for every
   // receive packet.
   auto SendPacketInToController =
-      [this](const std::string& netdev_source_port_name,
-             const std::string& netdev_target_port_name,
-             const std::string& payload) -> absl::Status {
-    absl::MutexLock l(&server_state_lock_);
-
+      [this](absl::string_view netdev_source_port_name,
+             absl::string_view netdev_target_port_name,
+             absl::string_view payload,
+             absl::Time receive_time) -> absl::Status {
+    const absl::Time start_time = absl::Now();
     // The callback will have Linux netdev interfaces. So we first need to
     // convert it into a SONiC port name then if needed into the controller port
-    // number.
-    std::string sonic_source_port_name = netdev_source_port_name;
-    std::string sonic_target_port_name = netdev_target_port_name;
-
-    std::string source_port_id;
+    // number. With translation the metadata comes from the view's prebuilt
+    // templates, and the arguments point into the receive buffer, so the only
+    // per-packet copies are the template metadata and the payload.
+    std::shared_ptr<const PacketIoView> view = CurrentPacketIoView();
+    p4::v1::StreamMessageResponse response;
+    p4::v1::PacketIn& packet_in = *response.mutable_packet();
     if (translate_port_ids_) {
-      auto port_id_or =
-          TranslatePort(TranslationDirection::kForController,
-                        port_translation_map_, sonic_source_port_name);
-      if (!port_id_or.ok()) {
-        packetio_counters_.packet_in_errors += 1;
-        return gutil::StatusBuilder(port_id_or.status())
+      const PacketInTemplates& templates = *view->packet_in_templates;
+      const p4::v1::PacketIn* source = templates.Find(netdev_source_port_name);
+      if (source == nullptr) {
+        packet_in_errors_ += 1;
+        return gutil::InvalidArgumentErrorBuilder()
                << "Could not send PacketIn request because of bad source port "
-                  "name."
-               << port_id_or.status().message() << "Packet(hex): "
+                  "name. "
+               << TranslatePort(TranslationDirection::kForController,
+                                *view->port_translator,
+                                std::string(netdev_source_port_name))
+                      .status()
+                      .message()
+               << "Packet(hex): "
                << absl::BytesToHexString(payload).substr(
                       0, std::min<int>(payload.size(), 100));
       }
-      source_port_id = *port_id_or;
-    } else {
-      source_port_id = sonic_source_port_name;
-    }
-
-    std::string target_port_id = source_port_id;
-    if (!sonic_target_port_name.empty()) {
-      if (translate_port_ids_) {
-        auto port_id_or =
-            TranslatePort(TranslationDirection::kForController,
-                          port_translation_map_, sonic_target_port_name);
-        if (!port_id_or.ok()) {
-          packetio_counters_.packet_in_errors += 1;
-          return gutil::StatusBuilder(port_id_or.status())
+      const p4::v1::PacketIn* target = nullptr;
+      if (!netdev_target_port_name.empty()) {
+        target = templates.Find(netdev_target_port_name);
+        if (target == nullptr) {
+          packet_in_errors_ += 1;
+          return gutil::InvalidArgumentErrorBuilder()
                  << "Could not send PacketIn request because of bad target "
-                    "port name."
-                 << port_id_or.status().message() << "Packet(hex): "
+                    "port name. "
+                 << TranslatePort(TranslationDirection::kForController,
+                                  *view->port_translator,
+                                  std::string(netdev_target_port_name))
+                        .status()
+                        .message()
+                 << "Packet(hex): "
                  << absl::BytesToHexString(payload).substr(
                         0, std::min<int>(payload.size(), 100));
         }
-        target_port_id = *port_id_or;
-      } else {
-        target_port_id = sonic_target_port_name;
       }
+      SetPacketInMetadata(*source, target, packet_in);
+    } else {
+      packet_in = CreatePacketInMessage(netdev_source_port_name,
+                                        netdev_target_port_name.empty()
+                                            ? netdev_source_port_name
+                                            : netdev_target_port_name);
     }
-
-    // Form the PacketIn metadata fields before writing into the
-    // stream.
-    auto packet_in = CreatePacketInMessage(source_port_id, target_port_id);
-
-    p4::v1::StreamMessageResponse response;
-    *response.mutable_packet() = packet_in;
-    *response.mutable_packet()->mutable_payload() = payload;
+    packet_in.set_payload(payload.data(), payload.size());
 
     // Get the primary streamchannel and write into the stream.
     absl::Status status = controller_manager_->SendPacketInToPrimary(response);
-    status.ok() ? packetio_counters_.packet_in_received += 1
-                : packetio_counters_.packet_in_errors += 1;
+    status.ok() ? packet_in_received_ += 1
+                : packet_in_errors_ += 1;
+    if (status.ok()) {
+      const absl::Time end_time = absl::Now();
+      absl::MutexLock l(&packet_in_latency_lock_);
+      RecordPacketInLatencies(netdev_source_port_name,
+                              start_time - receive_time, end_time - start_time,
+                              packet_in_latency_);
+    }
 
     return status;
   };
 
-  absl::MutexLock l(&server_state_lock_);
+  absl::MutexLock l(&packetio_lock_);
   if (packetio_impl_ == nullptr) {
     return absl::InvalidArgumentError("PacketIoImpl is a required object");
   }
@@ -20,44 +20,177 @@
 #include <memory>
 #include <string>
 #include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "absl/base/attributes.h"
 #include "absl/base/thread_annotations.h"
+#include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
 #include "absl/time/time.h"
 #include "absl/types/optional.h"
-#include "boost/bimap.hpp"
+#include "absl/types/span.h"
 #include "glog/logging.h"
 #include "grpcpp/server_context.h"
 #include "grpcpp/support/status.h"
 #include "grpcpp/support/sync_stream.h"
+#include "p4/config/v1/p4info.pb.h"
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_constraints/backend/constraint_info.h"
 #include "p4_pdpi/entity_keys.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/shared_ir_p4info.h"
+#include "p4rt_app/p4runtime/acl_counter_cache.h"
+#include "p4rt_app/p4runtime/constraint_plan.h"
 #include "p4rt_app/p4runtime/cpu_queue_translator.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
+#include "p4rt_app/p4runtime/ir_translation.h"
+#include "p4rt_app/p4runtime/p4runtime_read.h"
+#include "p4rt_app/p4runtime/packetio_helpers.h"
+#include "p4rt_app/p4runtime/port_translator.h"
 #include "p4rt_app/p4runtime/resource_utilization.h"
 #include "p4rt_app/p4runtime/sdn_controller_manager.h"
+#include "p4rt_app/p4runtime/write_admission.h"
+#include "p4rt_app/p4runtime/write_capture_ring.h"
 #include "p4rt_app/sonic/adapters/warm_boot_state_adapter.h"
+#include "p4rt_app/sonic/app_db_to_pdpi_ir_translator.h"
 #include "p4rt_app/sonic/packetio_interface.h"
 #include "p4rt_app/sonic/redis_connections.h"
 #include "p4rt_app/utils/event_data_tracker.h"
+#include "p4rt_app/utils/latency_histogram.h"
+#include "p4rt_app/utils/lock_contention.h"
+#include "p4rt_app/utils/worker_pool.h"
 //TODO(PINS):
 //#include "swss/component_state_helper_interface.h"
 //#include "swss/intf_translator.h"
 
 namespace p4rt_app {
 
+// Trailing metadata of GetForwardingPipelineConfig responses. Holds the
+// fingerprint of all entities programmed on the switch (see
+// EntityCache::Fingerprint) as 16 hex digits.
+inline constexpr char kStateFingerprintMetadataKey[] = "p4rt-state-fingerprint";
+
 struct P4RuntimeImplOptions {
   bool use_genetlink = false;
   bool translate_port_ids = true;
   bool is_freeze_mode = false;
   absl::optional<std::string> forwarding_config_full_path;
+  // The entity cache can be saved to this file before a warm reboot, and
+  // loaded from it when the pipeline config is committed during warm start.
+  absl::optional<std::string> entity_cache_snapshot_path;
+  // Compiled ACL table definitions are saved to this file, tagged with the
+  // P4Info cookie, so re-applying the same P4Info (e.g. after a warm restart)
+  // does not parse the ACL annotations again.
+  absl::optional<std::string> acl_table_definition_cache_path;
+  // Reads are streamed back in responses of roughly this many bytes.
+  int read_response_max_bytes = kDefaultReadResponseMaxBytes;
+  // Extra threads used to translate large Write batches, and to rebuild the
+  // entity cache from the AppDb. When 0 everything is translated on the
+  // calling thread.
+  int write_translation_threads = 0;
+  // Extra threads used to filter, and serialize, the entries of large Read
+  // requests. When 0 reads are served on the calling thread.
+  int read_threads = 0;
+  // Recent Write() requests, with their timing and status, are captured in a
+  // memory-mapped ring at this file, and included in debug data dumps.
+  absl::optional<std::string> write_capture_path;
+  // The size of the write capture ring.
+  int64_t write_capture_bytes = 64 << 20;
+  // When positive, Write() requests that are programmed one at a time wait
+  // this long for the requests that follow them. Requests that arrive in the
+  // meantime are published to the AppDb together, with their superseded
+  // MODIFYs and cancelled out INSERT+DELETE pairs dropped (see
+  // WriteCoalescer). Every request still gets a status for each of its
+  // updates.
+  absl::Duration write_coalescing_window = absl::ZeroDuration();
+  // When set, the P4RT_TABLE updates of each batch are split into sends by
+  // this policy instead of being sent to the AppDb at once.
+  absl::optional<sonic::AppDbPublishPolicy> app_db_publish_policy;
+  // When positive, ACL counter data is served from memory as long as it was
+  // fetched from the CountersDb at most this long ago (see AclCounterCache).
+  // RefreshAclCounterCache() should then be called periodically to keep the
+  // counters that are being read fresh.
+  absl::Duration acl_counter_cache_max_staleness = absl::ZeroDuration();
+  // ACL counters that are not read for this long are dropped from the cache.
+  absl::Duration acl_counter_cache_idle_timeout = absl::Minutes(1);
+  // Limits on outstanding writes, beyond which new Write() requests are
+  // rejected with a retry hint (see WriteAdmissionController).
+  WriteAdmissionOptions write_admission;
+  // When set, the saved forwarding config is committed at startup by calling
+  // CommitSavedPipelineConfig(), instead of waiting for a controller to send
+  // a COMMIT request. Read, Write and GetForwardingPipelineConfig requests
+  // wait for it to finish, while arbitration is served right away.
+  bool commit_saved_config_at_startup = false;
+};
+
+// Latency histograms for each stage of handling a Write() request.
+struct WriteStageLatencies {
+  // Translating, and validating, the PI updates into AppDb entries.
+  LatencyHistogram translate;
+
+  // Publishing the entries into the AppDb.
+  LatencyHistogram app_db_publish;
+
+  // Waiting for, and handling, the OrchAgent responses.
+  LatencyHistogram orch_agent_wait;
+
+  // Updating the entity cache and resource utilization with the results.
+  LatencyHistogram cache_update;
+};
+
+struct WriteLatencyStatistics {
+  // End-to-end latency of every Write() request.
+  LatencyHistogram total;
+
+  // Per-stage latency of every Write() request.
+  WriteStageLatencies stages;
+
+  // Per-stage latency of the Write() requests that included an entity of a
+  // given type (e.g. "table_entry") or an entry for a given table (e.g.
+  // "ipv4_table"). A batch touching multiple tables is counted for each of
+  // them.
+  absl::btree_map<std::string, WriteStageLatencies> stages_by_entity_type;
+  absl::btree_map<std::string, WriteStageLatencies> stages_by_table;
+};
+
+// Latency histograms of the PacketIns sent to the controller.
+struct PacketInLatencies {
+  // From the kernel receiving the packet to the P4RT App handling it (i.e. in
+  // the socket buffer and the receive queue).
+  LatencyHistogram queueing;
+
+  // Building the PacketIn, and handing it to the primary controller's stream.
+  LatencyHistogram processing;
+};
+
+struct PacketInLatencyStatistics {
+  PacketInLatencies total;
+
+  // By the netdev port the packet was punted on.
+  absl::btree_map<std::string, PacketInLatencies> by_port;
+};
+
+// Approximate memory used by the P4RT App's forwarding state.
+struct MemoryFootprintStatistics {
+  // The whole entity cache, and its entities of a given type (e.g.
+  // "table_entry") or in a given table (e.g. "ipv4_table").
+  EntityCache::Footprint entity_cache;
+  absl::btree_map<std::string, EntityCache::Footprint>
+      entity_cache_by_entity_type;
+  absl::btree_map<std::string, EntityCache::Footprint> entity_cache_by_table;
+
+  // The in-memory size of the IrP4Info, and of the capacity tracked for every
+  // action profile.
+  int64_t ir_p4info_bytes = 0;
+  int64_t action_profile_capacity_bytes = 0;
 };
 
 struct FlowProgrammingStatistics {
@@ -86,6 +219,62 @@ struct FlowProgrammingStatistics {
   // reads everything it needs from the RedisDB layer, and the OA or other
   // layers are not involved in these requests.
   absl::Duration read_time;
+
+  // Latency distribution of the Write() requests, broken down by stage.
+  WriteLatencyStatistics write_latency;
+
+  // The current write queue depth, and the total number of rejected writes.
+  // Unlike the rest, these are not reset on reading.
+  WriteAdmissionController::Stats write_admission;
+
+  // The current memory footprint. Also not reset on reading.
+  MemoryFootprintStatistics memory;
+};
+
+// Where the P4RT App is spending its time, for diagnosing slowness without a
+// restart. Unlike FlowProgrammingStatistics, reading it does not reset
+// anything.
+struct RuntimeIntrospection {
+  // Write latencies, and Read requests, since the flow programming statistics
+  // were last read (i.e. every minute).
+  WriteLatencyStatistics write_latency;
+  int read_request_count = 0;
+  absl::Duration read_time = absl::ZeroDuration();
+
+  // Writes waiting to be programmed, or on the OrchAgent responses.
+  WriteAdmissionController::Stats write_admission;
+
+  // Contention on the server_state_lock_, and on the controller manager's
+  // lock, since the server started.
+  LockContentionStats server_state_lock;
+  LockContentionStats controller_manager_lock;
+
+  // PacketIns waiting to be sent to the controller, and those dropped.
+  sonic::PacketIoQueueStats packetio_queue;
+
+  // PacketIn latencies since they were last published (i.e. every minute).
+  PacketInLatencyStatistics packet_in_latency;
+};
+
+// Progress of the incremental state verification (see
+// P4RuntimeImpl::VerifyStateIncrementally()).
+struct StateVerificationProgress {
+  // Number of passes over the P4RT_TABLE key space that have finished.
+  int64_t completed_passes = 0;
+
+  // Position of the next key to verify in the current pass, and the number of
+  // keys that were snapshotted when the pass started.
+  int64_t cursor = 0;
+  int64_t key_space_size = 0;
+
+  // Totals since the server started.
+  int64_t keys_verified = 0;
+  int64_t mismatches = 0;
+
+  // Mismatches found so far in the current pass, and in the whole of the last
+  // completed pass.
+  int64_t current_pass_mismatches = 0;
+  int64_t last_pass_mismatches = 0;
 };
 
 class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
@@ -100,7 +289,7 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
                 swss::SystemStateHelperInterface& system_state,
                 swss::IntfTranslator& netdev_translator, */
                 const P4RuntimeImplOptions& p4rt_options);
-  ~P4RuntimeImpl() override = default;
+  ~P4RuntimeImpl() override;
 
   // Determines the type of write request (e.g. table entry, direct counter
   // entry, etc.) then passes work off to a helper method. Requests will be
@@ -109,21 +298,54 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
   //  * No config has been applied.
   //  * The last saved config has not been applied.
   //  * The switch is in a critical state.
+  //
+  // Write requests are handled in three stages. The request is translated and
+  // validated against the entity cache while holding the server_state_lock_.
+  // The updates are then published to the AppDb, and we wait for the OrchAgent
+  // responses, while only holding the write_lock_. Finally, the cache and
+  // resource utilization are updated under the server_state_lock_ again. This
+  // allows Reads, PacketIO, etc. to be handled while the OrchAgent is busy.
+  //
+  // Writes from roles that are independent of every other role (see
+  // GetIndependentRoles) only hold the write_lock_ shared, so one role's
+  // translation and cache updates can overlap with another role waiting on the
+  // OrchAgent.
   grpc::Status Write(grpc::ServerContext* context,
                      const p4::v1::WriteRequest* request,
                      p4::v1::WriteResponse* response) override
-      ABSL_LOCKS_EXCLUDED(server_state_lock_);
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
 
+  // Read requests are served from a snapshot of the entity cache. The
+  // server_state_lock_ is only held while taking the snapshot so reads do not
+  // block, and are not blocked by, any on-going Write requests.
   grpc::Status Read(
       grpc::ServerContext* context, const p4::v1::ReadRequest* request,
       grpc::ServerWriter<p4::v1::ReadResponse>* response_writer) override
-      ABSL_LOCKS_EXCLUDED(server_state_lock_);
+      ABSL_LOCKS_EXCLUDED(server_state_lock_, counter_db_lock_);
+
+  // Serves a Read request by handing every serialized response to
+  // `write_response`, which returns false once the stream is closed. Shared by
+  // the sync and callback gRPC services. When ACL counters are served from the
+  // cache, their age is added to the `context`'s trailing metadata (see
+  // kAclCounterDataTimeMetadataKey).
+  grpc::Status ReadEntities(
+      const p4::v1::ReadRequest* request,
+      absl::FunctionRef<bool(absl::string_view serialized_response)>
+          write_response,
+      grpc::ServerContextBase* context = nullptr)
+      ABSL_LOCKS_EXCLUDED(server_state_lock_, counter_db_lock_);
+
+  // Re-fetches the counter data of every ACL entry that has recently been read,
+  // with one batched CountersDb request. Does nothing if the ACL counter cache
+  // is disabled.
+  absl::Status RefreshAclCounterCache()
+      ABSL_LOCKS_EXCLUDED(server_state_lock_, counter_db_lock_);
 
   grpc::Status SetForwardingPipelineConfig(
       grpc::ServerContext* context,
       const p4::v1::SetForwardingPipelineConfigRequest* request,
       p4::v1::SetForwardingPipelineConfigResponse* response) override
-      ABSL_LOCKS_EXCLUDED(server_state_lock_);
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
 
   grpc::Status GetForwardingPipelineConfig(
       grpc::ServerContext* context,
@@ -137,6 +359,18 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
                                p4::v1::StreamMessageRequest>* stream) override
       ABSL_LOCKS_EXCLUDED(server_state_lock_);
 
+  // Handles a single request received on a StreamChannel. A failed status means
+  // the stream must be closed with that status, and the connection has already
+  // been disconnected.
+  grpc::Status HandleStreamMessageRequest(
+      const p4::v1::StreamMessageRequest& request,
+      SdnConnection& sdn_connection) ABSL_LOCKS_EXCLUDED(server_state_lock_);
+
+  // Removes a StreamChannel that was closed by the peer from arbitration, and
+  // flushes its pending responses.
+  void DisconnectStreamChannel(SdnConnection& sdn_connection)
+      ABSL_LOCKS_EXCLUDED(server_state_lock_);
+
   // Updates the Device ID for the P4Runtime service if there is no active
   // connections.
   virtual absl::Status UpdateDeviceId(uint64_t device_id)
@@ -144,9 +378,17 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
 
   // Adds or removes a port from PacketIO.
   virtual absl::Status AddPacketIoPort(const std::string& port_name)
-      ABSL_LOCKS_EXCLUDED(server_state_lock_);
+      ABSL_LOCKS_EXCLUDED(packetio_lock_);
   virtual absl::Status RemovePacketIoPort(const std::string& port_name)
-      ABSL_LOCKS_EXCLUDED(server_state_lock_);
+      ABSL_LOCKS_EXCLUDED(packetio_lock_);
+
+  // Adds and removes a batch of PacketIO ports while only taking the
+  // packetio_lock_ once. Removals are handled first, and every port is
+  // attempted even if an earlier one fails.
+  virtual absl::Status UpdatePacketIoPorts(
+      const std::vector<std::string>& additions,
+      const std::vector<std::string>& removals)
+      ABSL_LOCKS_EXCLUDED(packetio_lock_);
 
   // Responds with one of the following actions to port translation:
   // * Add the new port translation for unknown name & ID
@@ -167,13 +409,23 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
   // -----|--------|--------|--------|
   virtual absl::Status AddPortTranslation(const std::string& port_name,
                                           const std::string& port_id)
-      ABSL_LOCKS_EXCLUDED(server_state_lock_);
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
 
   // Removes a port translation. Returns an error for an empty port name.
   // Triggers AppDb and AppStateDb updates even if the port translation does not
   // currently exist.
   virtual absl::Status RemovePortTranslation(const std::string& port_name)
-      ABSL_LOCKS_EXCLUDED(server_state_lock_);
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
+
+  // Applies a batch of port translation changes while only taking the locks
+  // once. Each addition behaves like AddPortTranslation, and each removal like
+  // RemovePortTranslation. Removals are handled first so a port ID can move
+  // between ports in one batch. Every change is attempted even if an earlier
+  // one fails.
+  virtual absl::Status UpdatePortTranslations(
+      const std::vector<std::pair<std::string, std::string>>& additions,
+      const std::vector<std::string>& removals)
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
 
   // Verifies state for the P4RT App. These are checks like:
   //  * Do VRF_TABLE entries match in AppStateDb and AppDb.
@@ -183,28 +435,104 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
   // NOTE: We do not verify ownership of table entries today. Therefore, shared
   // tables (e.g. VRF_TABLE) could cause false positives.
   virtual absl::Status VerifyState()
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
+
+  // Verifies the same state as VerifyState(), but only checks the next
+  // `max_keys` P4RT_TABLE entries per call. The P4RT_TABLE key space is
+  // snapshotted at the start of every pass, and a cursor moves through it on
+  // each call. Writes are only blocked while a single slice is verified. The
+  // smaller VRF_TABLE, HASH_TABLE, SWITCH_TABLE and packet replication checks
+  // are done in full at the start of every pass.
+  //
+  // Returns an error listing any mismatches found by this call.
+  absl::Status VerifyStateIncrementally(int max_keys)
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
+
+  // Returns the progress, and mismatch counters, of the incremental state
+  // verification. The same values are published into the HOST_STATS table.
+  StateVerificationProgress GetStateVerificationProgress()
       ABSL_LOCKS_EXCLUDED(server_state_lock_);
 
+  // Saves the entity cache to the entity_cache_snapshot_path so it can be
+  // loaded after a warm reboot instead of being rebuilt from the AppDb. Should
+  // be called once P4RT is frozen. Does nothing if no path is configured.
+  absl::Status SaveEntityCacheSnapshot()
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
+
+  // Compares an entity cache loaded from a snapshot with the P4RT_TABLE
+  // entries in the AppDb. On any mismatch the cache is rebuilt from the AppDb.
+  // Writes are blocked while verifying, but Reads are not.
+  absl::Status VerifyEntityCacheSnapshot()
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
+
+  // Commits the saved forwarding config, like a COMMIT request would, and
+  // then unblocks the requests waiting on it (see
+  // commit_saved_config_at_startup). The entity cache is rebuilt from the
+  // AppDb without holding the server_state_lock_, so arbitration and port
+  // updates are not blocked by it. Does nothing if a config is already set.
+  //
+  // Should be called once, after the port translations have been loaded.
+  absl::Status CommitSavedPipelineConfig()
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
+
   // Dump various debug data for the P4RT App, including:
   // * PacketIO counters.
+  // * The runtime introspection (i.e. latencies, lock contention, and queue
+  //   depths).
+  // * The P4Info.
+  // * The entity cache, as both a binary snapshot and text.
   //
-  // TODO: Dump other artifacts(e.g. P4Info, internal cache and
-  // mappings etc.)
+  // The server_state_lock_ is only held while taking a snapshot of the state,
+  // so dumping does not block programming.
+  //
+  // TODO: Dump other artifacts(e.g. mappings etc.)
   virtual absl::Status DumpDebugData(const std::string& path,
                                      const std::string& log_level)
       ABSL_LOCKS_EXCLUDED(server_state_lock_);
 
+  // Returns the current latencies, lock contention, and queue depths. Also
+  // written by DumpDebugData().
+  RuntimeIntrospection GetRuntimeIntrospection()
+      ABSL_LOCKS_EXCLUDED(server_state_lock_);
+
   // Returns performance statistics relating to the P4Runtime flow programming
   // API. Data will be reset to zero on reading(i.e. results are not
   // cumulative).
   absl::StatusOr<FlowProgrammingStatistics> GetFlowProgrammingStatistics()
       ABSL_LOCKS_EXCLUDED(server_state_lock_);
 
-  // Sets the CPU Queue translator.
-  virtual void SetCpuQueueTranslator(
-      std::unique_ptr<CpuQueueTranslator> translator)
+  // Writes a summary of the write latencies (e.g. p50, p99, max) into the
+  // HOST_STATS table.
+  void PublishWriteLatencyStatistics(
+      const WriteLatencyStatistics& write_latency)
+      ABSL_LOCKS_EXCLUDED(server_state_lock_);
+
+  // Writes the current write queue depth, OrchAgent latency, and number of
+  // rejected writes into the HOST_STATS table.
+  void PublishWriteAdmissionStatistics()
       ABSL_LOCKS_EXCLUDED(server_state_lock_);
 
+  // Writes the PacketIn queue depth, the PacketIns dropped because the queue
+  // was full or they were over a rate limit, and the PacketIn latencies since
+  // the last call (e.g. p50, p99, max) into the HOST_STATS table.
+  void PublishPacketIoStatistics()
+      ABSL_LOCKS_EXCLUDED(server_state_lock_, packetio_lock_,
+                          packet_in_latency_lock_);
+
+  // Writes the number of entries in every table, and the weight used in every
+  // action profile, into the HOST_STATS table. Does nothing until a forwarding
+  // pipeline has been set.
+  void PublishResourceUtilization() ABSL_LOCKS_EXCLUDED(server_state_lock_);
+
+  // Writes the memory footprint of the entity cache, in total and for every
+  // entity type and table, and of the IrP4Info into the HOST_STATS table.
+  void PublishMemoryFootprint() ABSL_LOCKS_EXCLUDED(server_state_lock_);
+
+  // Sets the CPU Queue translator. Does not take any locks, and requests that
+  // are already translating keep using the previous translator.
+  virtual void SetCpuQueueTranslator(
+      std::unique_ptr<CpuQueueTranslator> translator);
+
   sonic::PacketIoCounters GetPacketIoCounters()
       ABSL_LOCKS_EXCLUDED(server_state_lock_);
 
@@ -228,9 +556,143 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
   // entry to match the response and restore if needed.
   pdpi::IrUpdateStatus GetAndProcessResponse(absl::string_view key);
 
+  // The state used to translate PacketIO. Published whenever the ir_p4info_ or
+  // port_translator_ change, so packets can be handled without the
+  // server_state_lock_.
+  struct PacketIoView {
+    // Unset until a forwarding pipeline config has been pushed.
+    std::shared_ptr<const pdpi::IrP4Info> ir_p4info;
+    // Precomputed from ir_p4info so PacketOuts skip the IR translation.
+    std::shared_ptr<const PacketOutMetadataLayout> packet_out_layout;
+    std::shared_ptr<const PortTranslator> port_translator;
+    // Rebuilt from port_translator whenever the translations change.
+    std::shared_ptr<const PacketInTemplates> packet_in_templates;
+  };
+
+  // PacketOuts are handled without the server_state_lock_, so they are never
+  // queued behind a large Write() or a pipeline config push.
+  void HandleStreamPacketOut(const p4::v1::PacketOut& packet_out,
+                             SdnConnection& sdn_connection)
+      ABSL_LOCKS_EXCLUDED(server_state_lock_, packetio_lock_);
   absl::Status HandlePacketOutRequest(const p4::v1::PacketOut& packet_out)
+      ABSL_LOCKS_EXCLUDED(server_state_lock_, packetio_lock_);
+
+  // Returns the lock ordering writes from the request's role if the request
+  // can be programmed while only holding the write_lock_ shared. Otherwise,
+  // returns nullptr.
+  absl::Mutex* IndependentRoleWriteLock(const p4::v1::WriteRequest& request)
+      ABSL_SHARED_LOCKS_REQUIRED(write_lock_);
+
+  // Admits the request through the write_admission_ controller, and handles it
+  // with SequenceWrite. Rejected requests get a retry hint in the `context`'s
+  // trailing metadata (see kWriteRetryAfterMetadataKey).
+  grpc::Status AdmitWrite(grpc::ServerContext* context,
+                          const p4::v1::WriteRequest* request,
+                          p4::v1::WriteResponse* response)
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
+
+  // Orders the request against other writes and handles it with
+  // WriteEntities.
+  grpc::Status SequenceWrite(const p4::v1::WriteRequest* request,
+                             p4::v1::WriteResponse* response)
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
+
+  // Handles the Write stages. The caller must hold either the write_lock_
+  // exclusively, or hold it shared along with the request's role lock.
+  grpc::Status WriteEntities(const p4::v1::WriteRequest* request,
+                             p4::v1::WriteResponse* response)
+      ABSL_SHARED_LOCKS_REQUIRED(write_lock_)
+          ABSL_LOCKS_EXCLUDED(app_db_write_lock_, server_state_lock_);
+
+  // A Write() request waiting to be coalesced with the requests around it.
+  struct PendingWrite {
+    const p4::v1::WriteRequest* request = nullptr;
+    absl::Time start_time;
+    // Set, along with the status, once the request has been handled.
+    bool done = false;
+    grpc::Status status;
+  };
+
+  // Queues the request to be coalesced with other requests. The first request
+  // queued waits out the write_coalescing_window_ and then handles every
+  // queued request with WriteCoalescedEntities, while the others wait for it.
+  grpc::Status CoalesceWrite(const p4::v1::WriteRequest* request)
+      ABSL_LOCKS_EXCLUDED(coalescing_lock_, write_lock_, server_state_lock_);
+
+  // Handles the Write stages for consecutive requests together, in as few
+  // AppDb updates as possible. Sets the status of every request.
+  void WriteCoalescedEntities(absl::Span<PendingWrite* const> writes)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_)
+          ABSL_LOCKS_EXCLUDED(app_db_write_lock_, server_state_lock_);
+
+  // Handles the Write stages for a prefix of `writes` that can be coalesced,
+  // and returns how many requests were handled.
+  int WriteCoalescedGroup(absl::Span<PendingWrite* const> writes)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_)
+          ABSL_LOCKS_EXCLUDED(app_db_write_lock_, server_state_lock_);
+
+  // Returns the entity cache for modification. If the current cache is still
+  // referenced by a Read request then it will be copied first so the reader's
+  // view does not change.
+  EntityCache& MutableEntityCache()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
+
+  // Returns a marker for the P4RT_TABLE and VRF_TABLE keys currently in the
+  // AppDb that is stored with, and compared against, entity cache snapshots.
+  std::string CurrentAppDbGeneration()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
+
+  // Verifies the VRF_TABLE, HASH_TABLE and SWITCH_TABLE entries, and the packet
+  // replication entries, appending a message to `failures` for every error.
+  // With `only_changed_entries` the VRF_TABLE, HASH_TABLE and SWITCH_TABLE
+  // entries that were verified, and not written since, are not read again.
+  void VerifyNonP4rtTableState(std::vector<std::string>& failures,
+                               bool only_changed_entries)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
+
+  // Returns the port translator so it can be updated. The translator is copied
+  // first if a reader still holds a reference to it.
+  PortTranslator& MutablePortTranslator()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
+
+  // Returns the current CPU queue translator. The caller must keep the
+  // returned pointer for as long as it uses the translator.
+  std::shared_ptr<const CpuQueueTranslator> CurrentCpuQueueTranslator() const;
+
+  // Publishes the port_translator_, and the ir_p4info_ if it has changed, to
+  // PacketIO. Must be called after either of them is updated.
+  void PublishPacketIoView(bool ir_p4info_changed)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
+
+  // Returns the state PacketIO uses to translate packets. The caller must keep
+  // the returned pointer for as long as it uses the view.
+  std::shared_ptr<const PacketIoView> CurrentPacketIoView() const;
+
+  // Implement AddPortTranslation and RemovePortTranslation for callers that
+  // already hold the locks.
+  absl::Status AddPortTranslationLocked(const std::string& port_name,
+                                        const std::string& port_id)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_, server_state_lock_);
+  absl::Status RemovePortTranslationLocked(const std::string& port_name)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_, server_state_lock_);
+
+  // Loads the entity cache from the snapshot file if it was taken with the
+  // same config cookie, and the AppDb has the same keys.
+  absl::StatusOr<EntityCache> LoadEntityCacheSnapshot(uint64_t config_cookie)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
 
+  // Computes the current MemoryFootprintStatistics.
+  MemoryFootprintStatistics GetMemoryFootprint() const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
+
+  // Implements CommitSavedPipelineConfig() without unblocking requests.
+  absl::Status LoadSavedPipelineConfig()
+      ABSL_LOCKS_EXCLUDED(write_lock_, server_state_lock_);
+
+  // Waits for the saved config to be committed at startup. Returns UNAVAILABLE
+  // if that is taking too long.
+  grpc::Status AwaitSavedPipelineConfig() const;
+
   // Verify that the target can realize the given config. Will not modify the
   // forwarding state in the target.
   //
@@ -241,13 +703,15 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
 
   // Verify, save and realize the given config. Today we DO NOT support clearing
   // any forwarding state, and we will return a failure if a config has already
-  // been applied.
+  // been applied. Verification is skipped if `config_verified` is set, i.e.
+  // the caller already ran VerifyPipelineConfig() without holding the locks.
   //
   // Returns an error if the config is not provided of if the provided config
   // cannot be realized.
   grpc::Status VerifyAndCommitPipelineConfig(
-      const p4::v1::SetForwardingPipelineConfigRequest& request)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
+      const p4::v1::SetForwardingPipelineConfigRequest& request,
+      bool config_verified)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_, server_state_lock_);
 
   // Realize the last saved, but not yet committed config.
   //
@@ -255,7 +719,7 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
   // or if a no saved config is found.
   grpc::Status CommitPipelineConfig(
       const p4::v1::SetForwardingPipelineConfigRequest& request)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_, server_state_lock_);
 
   // Verify, save and realize the given config. Today we DO NOT support changing
   // the P4Info in any way, and we will return a failure if we detect any
@@ -264,9 +728,22 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
   //
   // Returns an error if the config is not provided, or if the existing
   // forwarding state cannot be preserved for the given config by the target.
+  // As above, verification is skipped if `config_verified` is set.
   grpc::Status ReconcileAndCommitPipelineConfig(
-      const p4::v1::SetForwardingPipelineConfigRequest& request)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
+      const p4::v1::SetForwardingPipelineConfigRequest& request,
+      bool config_verified)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_, server_state_lock_);
+
+  // Applies a P4Info that only differs from the current one in its ACL tables.
+  // Only the changed ACL table definitions are republished to the AppDb, and
+  // changed tables cannot have any installed entries. Any other difference is
+  // UNIMPLEMENTED.
+  grpc::Status ReconcileAclTables(const p4::config::v1::P4Info& p4info)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_, server_state_lock_);
+
+  // Rebuilds the role_write_locks_ for the current IrP4Info.
+  void UpdateRoleWriteLocks()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_, server_state_lock_);
 
   // Tries to save the forwarding config to a file. If the
   // forwarding_config_full_path_ variable is not set it will return OK, but any
@@ -278,16 +755,55 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
   // Writes the necessary updates from the pipeline config into the AppDb
   // tables. These configurations (e.g. ACLs, hashing, etc.) are needed before
   // we can start accepting write requests.
-  absl::Status ConfigureAppDbTables(const pdpi::IrP4Info& ir_p4info)
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(server_state_lock_);
+  absl::Status ConfigureAppDbTables(const pdpi::IrP4Info& ir_p4info,
+                                    uint64_t p4info_cookie)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(write_lock_, server_state_lock_);
 
   // Defines the callback lambda function to be invoked for receive packets
   // and calls into the sonic::StartReceive to spawn the receiver thread.
   ABSL_MUST_USE_RESULT absl::StatusOr<std::thread> StartReceive(
       bool use_genetlink);
 
-  // Mutex for constraining actions to access and modify server state.
+  // Mutex for serializing any action that programs the lower layers, or waits
+  // on the OrchAgent response channels (e.g. Write, SetForwardingPipeline).
+  // Holding this lock guarantees that the ForwardingPipelineConfig and the
+  // AppDb tables will not be changed by another thread so they can be used
+  // without also holding the server_state_lock_. Writes from independent roles
+  // hold it shared, everything else holds it exclusively.
+  //
+  // Lock ordering: write_lock_ must always be acquired before
+  // server_state_lock_.
+  absl::Mutex write_lock_ ABSL_ACQUIRED_BEFORE(server_state_lock_);
+
+  // Orders the writes from each independent role. Rebuilt whenever a new
+  // P4Info is committed. Acquired after the write_lock_, and before any other
+  // lock.
+  absl::flat_hash_map<std::string, std::unique_ptr<absl::Mutex>>
+      role_write_locks_ ABSL_GUARDED_BY(write_lock_);
+
+  // Writes holding the write_lock_ shared take turns waiting on the OrchAgent
+  // response channel, which is shared by every table.
+  absl::Mutex app_db_write_lock_ ABSL_ACQUIRED_AFTER(write_lock_)
+      ABSL_ACQUIRED_BEFORE(server_state_lock_);
+
+  // Guards the Write() requests waiting to be coalesced. Only held briefly, so
+  // it is acquired after the write_lock_.
+  absl::Mutex coalescing_lock_ ABSL_ACQUIRED_AFTER(write_lock_);
+  std::vector<PendingWrite*> pending_writes_ ABSL_GUARDED_BY(coalescing_lock_);
+
+  // Mutex for constraining actions to access and modify server state. Always
+  // acquired with a ProfiledMutexLock to count how long threads wait on it.
   absl::Mutex server_state_lock_;
+  LockContentionCounter server_state_lock_contention_;
+
+  // Guards the PacketIO interface, whose ports are updated while packets are
+  // sent. PacketOuts only take this lock, so they never wait on programming.
+  absl::Mutex packetio_lock_ ABSL_ACQUIRED_AFTER(server_state_lock_);
+
+  // Read requests fetch ACL counter data from the CountersDb outside of the
+  // server_state_lock_. The underlying Redis connection cannot be shared
+  // between threads so concurrent reads take turns using it.
+  absl::Mutex counter_db_lock_;
 
   // Interfaces which are used to update entries in the RedisDB tables.
   sonic::P4rtTable p4rt_table_ ABSL_GUARDED_BY(server_state_lock_);
@@ -305,16 +821,30 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
   //
   // It is possible for connections to be made for specific roles. In which case
   // one primary connection is allowed for each distinct role.
-  std::unique_ptr<SdnControllerManager> controller_manager_
-      ABSL_GUARDED_BY(server_state_lock_);
+  //
+  // Set during construction, and the manager handles its own synchronization
+  // so PacketOuts can check for the primary connection without any locks.
+  std::unique_ptr<SdnControllerManager> controller_manager_;
 
   // SONiC uses name to reference ports (e.g. Ethernet4), but the controller can
   // be configured to send port IDs. The P4RT App takes responsibility for
   // translating between the two.
   //
-  // boost::bimap<SONiC port name, controller ID>;
-  boost::bimap<std::string, std::string> port_translation_map_
-      ABSL_GUARDED_BY(server_state_lock_);
+  // Reads keep a reference to the translator so they can run without holding
+  // the lock. Updates modify it in place unless a reader is still using it (see
+  // MutablePortTranslator()).
+  std::shared_ptr<PortTranslator> port_translator_
+      ABSL_GUARDED_BY(server_state_lock_) = std::make_shared<PortTranslator>();
+
+  // A read-only copy of the state PacketIO needs from the ir_p4info_ and
+  // port_translator_. It is only read or replaced with the atomic shared_ptr
+  // operations, so packets never take the server_state_lock_. Always read it
+  // through CurrentPacketIoView().
+  std::shared_ptr<const PacketIoView> packetio_view_ =
+      std::make_shared<const PacketIoView>(
+          PacketIoView{.port_translator = port_translator_,
+                       .packet_in_templates =
+                           std::make_shared<const PacketInTemplates>()});
 
   // A forwarding pipeline config with a P4Info protobuf will be set once a
   // controller connects to the switch. Only after we receive this config can
@@ -328,19 +858,42 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
   absl::optional<std::string> forwarding_config_full_path_
       ABSL_GUARDED_BY(server_state_lock_);
 
+  // The entity cache can be saved to disk before a warm reboot, and loaded
+  // back during warm start. Never changes after construction.
+  const absl::optional<std::string> entity_cache_snapshot_path_;
+  const absl::optional<std::string> acl_table_definition_cache_path_;
+
+  // A cache loaded from a snapshot is verified against the AppDb by this
+  // thread so that committing the pipeline config is not blocked.
+  std::thread snapshot_verification_thread_;
+
+  // Notified once the saved config has been committed at startup, or right
+  // away if it is not committed at startup.
+  absl::Notification saved_config_committed_;
+
   // Once we receive the P4Info we create a pdpi::IrP4Info object which allows
-  // us to translate the PI requests into human-readable objects.
-  absl::optional<pdpi::IrP4Info> ir_p4info_ ABSL_GUARDED_BY(server_state_lock_);
+  // us to translate the PI requests into human-readable objects. Its compiled
+  // lookup tables are used to translate write requests, and the PacketIoView
+  // shares it rather than keeping a copy.
+  absl::optional<pdpi::SharedIrP4Info> ir_p4info_
+      ABSL_GUARDED_BY(server_state_lock_);
+
+  // Pre-computed translation plans for the IrP4Info. Set at the same time as
+  // the ir_p4info_.
+  absl::optional<IrTranslationPlan> ir_translation_plan_
+      ABSL_GUARDED_BY(server_state_lock_);
+  absl::optional<sonic::AppDbSerializationPlan> app_db_serialization_plan_
+      ABSL_GUARDED_BY(server_state_lock_);
 
   // The P4Info can use annotations to specify table constraints for specific
   // tables. The P4RT service will reject any table entry requests that do not
-  // meet these constraints.
-  absl::optional<p4_constraints::ConstraintInfo> p4_constraint_info_;
+  // meet these constraints. Set at the same time as the ir_p4info_.
+  absl::optional<ConstraintPlan> constraint_plan_;
 
   // PacketIoImplementation object.
   std::thread receive_thread_;
   std::unique_ptr<sonic::PacketIoInterface> packetio_impl_
-      ABSL_GUARDED_BY(server_state_lock_);
+      ABSL_GUARDED_BY(packetio_lock_);
 
   /* TODO(PINS): To handle component_state, system_state and netdev_translator later.
   // When the switch is in critical state the P4RT service shuould not accept
@@ -355,42 +908,103 @@ class P4RuntimeImpl : public p4::v1::P4Runtime::Service {
   swss::IntfTranslator& netdev_translator_ ABSL_GUARDED_BY(server_state_lock_); */
 
   // Some switch environments cannot rely on the SONiC port names, and can
-  // instead choose to use port ID's configured through gNMI.
-  const bool translate_port_ids_ ABSL_GUARDED_BY(server_state_lock_);
+  // instead choose to use port ID's configured through gNMI. Never changes
+  // after construction.
+  const bool translate_port_ids_;
+
+  // Byte budget for each ReadResponse. Never changes after construction so it
+  // can be used without holding any locks.
+  const int read_response_max_bytes_ = kDefaultReadResponseMaxBytes;
+
+  // Serves ACL counter data to reads when enabled. Only set during
+  // construction, and the cache handles its own synchronization.
+  std::unique_ptr<AclCounterCache> acl_counter_cache_;
+
+  // Optional threads for translating large Write batches in parallel. Only set
+  // during construction, and the pool handles its own synchronization.
+  std::unique_ptr<WorkerPool> translation_pool_;
+
+  // Optional threads for serving large Read requests in parallel. Only set
+  // during construction, and the pool handles its own synchronization.
+  std::unique_ptr<WorkerPool> read_pool_;
+
+  // How long Write() requests wait to be coalesced with later requests. Never
+  // changes after construction. Coalescing is disabled when not positive.
+  const absl::Duration write_coalescing_window_ = absl::ZeroDuration();
+
+  // How P4RT_TABLE updates are split into sends. Never changes after
+  // construction.
+  const absl::optional<sonic::AppDbPublishPolicy> app_db_publish_policy_;
+
+  // Tracks outstanding writes, and the OrchAgent latency, to reject writes
+  // when the OrchAgent falls behind. Handles its own synchronization.
+  WriteAdmissionController write_admission_;
+
+  // Optional capture of recent Write() requests. Only set during construction,
+  // and the ring handles its own synchronization.
+  std::unique_ptr<WriteCaptureRing> write_capture_ring_;
 
   // Reading a large number of entries from Redis is costly. To improve the
   // read performance we cache table entries in software.
-  absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity> entity_cache_
-      ABSL_GUARDED_BY(server_state_lock_);
+  //
+  // The cache is shared with any in-flight Read requests so they can be served
+  // without holding the server_state_lock_. Therefore, the cache should only
+  // be modified through MutableEntityCache() which will copy it first if any
+  // reader still holds a reference (i.e. copy-on-write).
+  std::shared_ptr<EntityCache> entity_cache_
+      ABSL_GUARDED_BY(server_state_lock_) = std::make_shared<EntityCache>();
 
   // Monitoring resources in hardware can be difficult. For example in WCMP if a
   // port is down the lower layers will remove those path both freeing resources
   // and ensuring packets are not routed to a down port. To ensure we do not
   // overuse space we track resource usage in the P4RT layer.
-  absl::flat_hash_map<std::string, ActionProfileResourceCapacity>
-      capacity_by_action_profile_name_ ABSL_GUARDED_BY(server_state_lock_);
+  ActionProfileCapacityMap capacity_by_action_profile_id_
+      ABSL_GUARDED_BY(server_state_lock_);
 
-  // Utility to perform translations between CPU queue name and id.
-  std::unique_ptr<CpuQueueTranslator> cpu_queue_translator_
+  // Utility to perform translations between CPU queue name and id. The
+  // translator is immutable, and is only read or replaced with the atomic
+  // shared_ptr operations. So CPU queue updates never take the
+  // server_state_lock_, and in-flight requests keep using the translator they
+  // started with. Always read it through CurrentCpuQueueTranslator().
+  std::shared_ptr<const CpuQueueTranslator> cpu_queue_translator_;
+  // Performance statistics for P4RT Write(). The counters are atomic so they
+  // do not need the server_state_lock_.
+  AtomicEventDataTracker<int> write_batch_requests_{
+      AtomicEventDataTracker<int>(0)};
+  AtomicEventDataTracker<int> write_total_requests_{
+      AtomicEventDataTracker<int>(0)};
+  AtomicEventDataTracker<absl::Duration> write_execution_time_{
+      AtomicEventDataTracker<absl::Duration>(absl::ZeroDuration())};
+  WriteLatencyStatistics write_latency_ ABSL_GUARDED_BY(server_state_lock_);
+
+  // Incremental state verification walks over a snapshot of the P4RT_TABLE
+  // keys. Each key is paired with the cache entity it belonged to when the
+  // pass started, if any.
+  std::vector<std::pair<std::string, absl::optional<pdpi::EntityKey>>>
+      state_verification_keys_ ABSL_GUARDED_BY(server_state_lock_);
+  StateVerificationProgress state_verification_progress_
       ABSL_GUARDED_BY(server_state_lock_);
-  // Performance statistics for P4RT Write().
-  EventDataTracker<int> write_batch_requests_
-      ABSL_GUARDED_BY(server_state_lock_){EventDataTracker<int>(0)};
-  EventDataTracker<int> write_total_requests_
-      ABSL_GUARDED_BY(server_state_lock_){EventDataTracker<int>(0)};
-  EventDataTracker<absl::Duration> write_execution_time_
-      ABSL_GUARDED_BY(server_state_lock_){
-          EventDataTracker<absl::Duration>(absl::ZeroDuration())};
 
   // Performance statistics for P4RT Read().
-  EventDataTracker<int> read_total_requests_
-      ABSL_GUARDED_BY(server_state_lock_){EventDataTracker<int>(0)};
-  EventDataTracker<absl::Duration> read_execution_time_
-      ABSL_GUARDED_BY(server_state_lock_){
-          EventDataTracker<absl::Duration>(absl::ZeroDuration())};
-
-  // PacketIO debug counters.
-  sonic::PacketIoCounters packetio_counters_;
+  AtomicEventDataTracker<int> read_total_requests_{
+      AtomicEventDataTracker<int>(0)};
+  AtomicEventDataTracker<absl::Duration> read_execution_time_{
+      AtomicEventDataTracker<absl::Duration>(absl::ZeroDuration())};
+
+  // PacketIO debug counters. These are updated for every packet so they are
+  // atomic instead of relying on the server_state_lock_.
+  AtomicEventDataTracker<int> packet_out_sent_{AtomicEventDataTracker<int>(0)};
+  AtomicEventDataTracker<int> packet_out_errors_{
+      AtomicEventDataTracker<int>(0)};
+  AtomicEventDataTracker<int> packet_in_received_{
+      AtomicEventDataTracker<int>(0)};
+  AtomicEventDataTracker<int> packet_in_errors_{AtomicEventDataTracker<int>(0)};
+
+  // PacketIn latencies since they were last published. Has its own lock, since
+  // it is updated for every packet.
+  mutable absl::Mutex packet_in_latency_lock_;
+  PacketInLatencyStatistics packet_in_latency_
+      ABSL_GUARDED_BY(packet_in_latency_lock_);
 
   // Flag to indicate whether P4RT is in warm-boot freeze process.
   bool is_freeze_mode_ ABSL_GUARDED_BY(server_state_lock_) = false;
@@ -14,7 +14,6 @@
 #include "p4rt_app/p4runtime/p4runtime_impl.h"
 
 #include "absl/strings/string_view.h"
-#include "boost/bimap.hpp"
 #include "glog/logging.h"
 #include "gmock/gmock.h"
 #include "google/protobuf/text_format.h"
@@ -23,6 +22,7 @@
 #include "gutil/status_matchers.h"
 #include "p4_pdpi/utils/ir.h"
 #include "p4rt_app/p4runtime/p4info_verification.h"
+#include "p4rt_app/p4runtime/port_translator.h"
 #include "p4rt_app/sonic/adapters/mock_system_call_adapter.h"
 #include "p4rt_app/sonic/packetio_impl.h"
 #include "p4rt_app/sonic/packetio_port.h"
@@ -94,8 +94,8 @@ TEST(P4RuntimeImplTest, SendPacketOutEgressPortUsingPortIdOk) {
       absl::make_unique<p4rt_app::sonic::PacketIoPortSockets>("Ethernet1",
                                                               fd[1]));
 
-  boost::bimap<std::string, std::string> port_maps;
-  port_maps.insert({"Ethernet1", "1"});
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1", "1");
 
   auto mock_call_adapter = absl::make_unique<sonic::MockSystemCallAdapter>();
   struct ifreq if_resp { /*ifr_name=*/
@@ -127,8 +127,8 @@ TEST(P4RuntimeImplTest, SendPacketOutEgressPortUsingPortNameOk) {
       absl::make_unique<p4rt_app::sonic::PacketIoPortSockets>("Ethernet1",
                                                               fd[1]));
 
-  boost::bimap<std::string, std::string> port_maps;
-  port_maps.insert({"Ethernet1", "1"});
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1", "1");
 
   auto mock_call_adapter = absl::make_unique<sonic::MockSystemCallAdapter>();
   struct ifreq if_resp { /*ifr_name=*/
@@ -172,7 +172,7 @@ TEST(P4RuntimeImplTest, SendPacketOutIngressInjectOk) {
   auto packetio_impl = absl::make_unique<sonic::PacketIoImpl>(
       std::move(mock_call_adapter), std::move(port_sockets));
 
-  boost::bimap<std::string, std::string> port_maps;
+  PortTranslator port_maps;
   EXPECT_OK(SendPacketOut(ir_p4_info, /*translate_port_ids=*/true, port_maps,
                           packetio_impl.get(), packet));
 }
@@ -201,7 +201,7 @@ TEST(P4RuntimeImplTest, SendPacketOutDuplicateId) {
   auto mock_call_adapter = absl::make_unique<sonic::MockSystemCallAdapter>();
   auto packetio_impl = absl::make_unique<sonic::PacketIoImpl>(
       std::move(mock_call_adapter), std::move(port_sockets));
-  boost::bimap<std::string, std::string> port_maps;
+  PortTranslator port_maps;
   ASSERT_THAT(SendPacketOut(ir_p4_info, /*translate_port_ids=*/true, port_maps,
                             packetio_impl.get(), packet),
               StatusIs(absl::StatusCode::kInvalidArgument));
@@ -232,7 +232,7 @@ TEST(P4RuntimeImplTest, SendPacketOutIdMismatch) {
   auto mock_call_adapter = absl::make_unique<sonic::MockSystemCallAdapter>();
   auto packetio_impl = absl::make_unique<sonic::PacketIoImpl>(
       std::move(mock_call_adapter), std::move(port_sockets));
-  boost::bimap<std::string, std::string> port_maps;
+  PortTranslator port_maps;
   ASSERT_THAT(SendPacketOut(ir_p4_info, /*translate_port_ids=*/true, port_maps,
                             packetio_impl.get(), packet),
               StatusIs(absl::StatusCode::kInvalidArgument));
@@ -266,7 +266,7 @@ TEST(P4RuntimeImplTest, SendPacketOutMultipleValidValues) {
   EXPECT_CALL(*mock_call_adapter, write).Times(1);
   auto packetio_impl = absl::make_unique<sonic::PacketIoImpl>(
       std::move(mock_call_adapter), std::move(port_sockets));
-  boost::bimap<std::string, std::string> port_maps;
+  PortTranslator port_maps;
   ASSERT_OK(SendPacketOut(ir_p4_info, /*translate_port_ids=*/true, port_maps,
                           packetio_impl.get(), packet));
 }
@@ -286,8 +286,8 @@ TEST(P4RuntimeImplTest, SendPacketOutPortZero) {
   port_sockets.push_back(
       absl::make_unique<p4rt_app::sonic::PacketIoPortSockets>("Ethernet0",
                                                               fd[1]));
-  boost::bimap<std::string, std::string> port_maps;
-  port_maps.insert({"Ethernet0", "0"});
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet0", "0");
 
   auto mock_call_adapter = absl::make_unique<sonic::MockSystemCallAdapter>();
   struct ifreq if_resp { /*ifr_name=*/
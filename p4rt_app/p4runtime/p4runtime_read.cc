@@ -13,39 +13,96 @@
 // limitations under the License.
 #include "p4rt_app/p4runtime/p4runtime_read.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/functional/function_ref.h"
 #include "absl/strings/str_format.h"
-#include "boost/bimap.hpp"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/util/message_differencer.h"
 #include "gutil/status.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/entity_keys.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/p4runtime/acl_counter_cache.h"
 #include "p4rt_app/p4runtime/cpu_queue_translator.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
 #include "p4rt_app/p4runtime/ir_translation.h"
+#include "p4rt_app/p4runtime/port_translator.h"
 #include "p4rt_app/sonic/app_db_manager.h"
 #include "p4rt_app/sonic/redis_connections.h"
 #include "p4rt_app/utils/table_utility.h"
+#include "p4rt_app/utils/worker_pool.h"
 
 namespace p4rt_app {
 namespace {
 
 absl::Status SupportedTableEntryRequest(const p4::v1::TableEntry& table_entry) {
-  if (table_entry.table_id() != 0 || !table_entry.match().empty() ||
-      table_entry.priority() != 0 || !table_entry.metadata().empty() ||
-      table_entry.has_action() || table_entry.is_default_action() != false) {
+  // Reads can be scoped to a single table, and further filtered by priority and
+  // match fields. Any other filter is not supported.
+  if (!table_entry.metadata().empty() || table_entry.has_action() ||
+      table_entry.is_default_action() != false) {
     return gutil::UnimplementedErrorBuilder()
            << "Read request for table entry: "
            << table_entry.ShortDebugString();
   }
+  if (table_entry.table_id() == 0 &&
+      (!table_entry.match().empty() || table_entry.priority() != 0)) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Read requests can only filter on match fields or priority "
+              "when a table ID is also specified: "
+           << table_entry.ShortDebugString();
+  }
   return absl::OkStatus();
 }
 
+// Returns true if the cached entry satisfies the read request's filter. An
+// entry matches if it has the same priority (when one is requested), and if
+// every requested match field is also in the cached entry.
+bool TableEntryMatchesFilter(const p4::v1::TableEntry& filter,
+                             const p4::v1::TableEntry& cached_entry) {
+  if (filter.priority() != 0 && filter.priority() != cached_entry.priority()) {
+    return false;
+  }
+  for (const p4::v1::FieldMatch& requested_match : filter.match()) {
+    bool found = false;
+    for (const p4::v1::FieldMatch& cached_match : cached_entry.match()) {
+      if (cached_match.field_id() != requested_match.field_id()) continue;
+      found = google::protobuf::util::MessageDifferencer::Equals(
+          cached_match, requested_match);
+      break;
+    }
+    if (!found) return false;
+  }
+  return true;
+}
+
+// Returns true if the filter can match at most one entry because it holds
+// every match field of its table, and a priority if the table needs one.
+bool IsSingleEntryRead(const p4::v1::TableEntry& filter,
+                       const pdpi::IrP4Info& ir_p4_info) {
+  if (filter.table_id() == 0) return false;
+  auto table_def = ir_p4_info.tables_by_id().find(filter.table_id());
+  if (table_def == ir_p4_info.tables_by_id().end()) return false;
+  if (table_def->second.requires_priority() && filter.priority() == 0) {
+    return false;
+  }
+  return filter.match_size() == table_def->second.match_fields_by_id_size();
+}
+
 absl::Status SupportedPacketReplicationEntryRequest(
     const p4::v1::PacketReplicationEngineEntry& replication_entry) {
   if (replication_entry.multicast_group_entry().multicast_group_id() != 0 ||
@@ -57,46 +114,116 @@ absl::Status SupportedPacketReplicationEntryRequest(
   return absl::OkStatus();
 }
 
-absl::Status AppendAclCounterData(
-    p4::v1::TableEntry& pi_table_entry, const pdpi::IrP4Info& ir_p4_info,
-    bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
-    const CpuQueueTranslator& cpu_queue_translator,
-    sonic::P4rtTable& p4rt_table) {
+// Everything needed to fetch ACL counter data from the CountersDb.
+struct CounterDataContext {
+  const pdpi::IrP4Info& ir_p4_info;
+  bool translate_port_ids;
+  const PortTranslator& port_translation_map;
+  const CpuQueueTranslator& cpu_queue_translator;
+  sonic::P4rtTable& p4rt_table;
+  absl::Mutex& counter_db_lock;
+  // When set, counter data is served from this cache instead.
+  AclCounterCache* acl_counter_cache;
+  // When the oldest counter data in the read was fetched.
+  absl::Time counter_data_time = absl::InfiniteFuture();
+};
+
+// An ACL entry in a pending response that still needs counter data.
+struct PendingCounterEntry {
+  p4::v1::TableEntry* pi_table_entry;
+  // The P4RT_TABLE key stored in the entity cache, or nullptr if one was not
+  // stored.
+  const std::string* app_db_key;
+};
+
+// Returns the P4RT_TABLE key for an entry that does not have one cached.
+absl::StatusOr<std::string> TranslateP4rtTableKey(
+    const p4::v1::TableEntry& pi_table_entry,
+    const CounterDataContext& context) {
   ASSIGN_OR_RETURN(
       pdpi::IrTableEntry ir_table_entry,
       TranslatePiTableEntryForOrchAgent(
-          pi_table_entry, ir_p4_info, translate_port_ids, port_translation_map,
-          cpu_queue_translator, /*translate_key_only=*/false));
+          pi_table_entry, context.ir_p4_info, context.translate_port_ids,
+          context.port_translation_map, context.cpu_queue_translator,
+          /*translate_key_only=*/true));
+  return sonic::GetRedisP4rtTableKey(ir_table_entry, context.ir_p4_info);
+}
 
-  RETURN_IF_ERROR(sonic::AppendCounterDataForTableEntry(
-      ir_table_entry, p4rt_table, ir_p4_info));
-  if (ir_table_entry.has_counter_data()) {
-    *pi_table_entry.mutable_counter_data() = ir_table_entry.counter_data();
+// Appends counter/meter data from the ACL counter cache to every table entry.
+// Any entries without fresh data are fetched with one batched CountersDb
+// request.
+absl::Status AppendCachedAclCounterData(
+    const std::vector<std::string>& p4rt_keys,
+    const std::vector<p4::v1::TableEntry*>& pi_table_entries,
+    CounterDataContext& context) {
+  ASSIGN_OR_RETURN(
+      AclCounterCache::Lookup lookup,
+      context.acl_counter_cache->Get(
+          sonic::GetCounterDbKeys(context.p4rt_table, p4rt_keys),
+          [&context](const std::vector<std::string>& counter_db_keys)
+              -> absl::StatusOr<std::vector<AclCounterCache::CounterValues>> {
+            absl::MutexLock l(&context.counter_db_lock);
+            return context.p4rt_table.counter_db->batch_get(counter_db_keys);
+          }));
+  for (int i = 0; i < pi_table_entries.size(); ++i) {
+    RETURN_IF_ERROR(sonic::AppendCounterDataToTableEntry(lookup.values[i],
+                                                         *pi_table_entries[i]));
   }
-  if (ir_table_entry.has_meter_counter_data()) {
-    *pi_table_entry.mutable_meter_counter_data() =
-        ir_table_entry.meter_counter_data();
+  context.counter_data_time =
+      std::min(context.counter_data_time, lookup.fetch_time);
+  return absl::OkStatus();
+}
+
+// Fetches counter/meter data for every table entry with one batched CountersDb
+// request, and appends it to the entries.
+absl::Status AppendAclCounterData(
+    const std::vector<PendingCounterEntry>& pending_entries,
+    CounterDataContext& context) {
+  if (pending_entries.empty()) return absl::OkStatus();
+
+  std::vector<std::string> p4rt_keys;
+  std::vector<p4::v1::TableEntry*> pi_table_entries;
+  p4rt_keys.reserve(pending_entries.size());
+  pi_table_entries.reserve(pending_entries.size());
+  for (const PendingCounterEntry& pending : pending_entries) {
+    if (pending.app_db_key != nullptr) {
+      p4rt_keys.push_back(*pending.app_db_key);
+    } else {
+      ASSIGN_OR_RETURN(std::string p4rt_key,
+                       TranslateP4rtTableKey(*pending.pi_table_entry, context));
+      p4rt_keys.push_back(std::move(p4rt_key));
+    }
+    pi_table_entries.push_back(pending.pi_table_entry);
   }
 
-  return absl::OkStatus();
+  if (context.acl_counter_cache != nullptr) {
+    return AppendCachedAclCounterData(p4rt_keys, pi_table_entries, context);
+  }
+  context.counter_data_time = std::min(context.counter_data_time, absl::Now());
+  absl::MutexLock l(&context.counter_db_lock);
+  return sonic::AppendCounterDataForTableEntries(p4rt_keys, pi_table_entries,
+                                                 context.p4rt_table);
 }
 
-absl::Status AppendTableEntryReads(
-    p4::v1::ReadResponse& response, const p4::v1::TableEntry& cached_entry,
-    const std::string& role_name, const pdpi::IrP4Info& ir_p4_info,
-    bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
-    const CpuQueueTranslator& cpu_queue_translator,
-    sonic::P4rtTable& p4rt_table) {
+// Describes how a cached table entry should be handled by a read.
+struct TableEntryReadAccess {
+  // False if the reader's role is not allowed to see the entry.
+  bool allowed = false;
+  // True if counter data needs to be appended from the CountersDb.
+  bool has_counter_data = false;
+};
+
+absl::StatusOr<TableEntryReadAccess> GetTableEntryReadAccess(
+    uint32_t table_id, const std::string& role_name,
+    const pdpi::IrP4Info& ir_p4_info) {
   // Fetch the table definition since it will inform how we process the read
   // request.
-  auto table_def = ir_p4_info.tables_by_id().find(cached_entry.table_id());
+  auto table_def = ir_p4_info.tables_by_id().find(table_id);
   if (table_def == ir_p4_info.tables_by_id().end()) {
     return gutil::InternalErrorBuilder() << absl::StreamFormat(
                "Could not find table ID %u when checking role access. Did an "
                "IR translation fail somewhere?",
-               cached_entry.table_id());
+               table_id);
   }
 
   // Multiple roles can be connected to a switch so we need to ensure the
@@ -105,77 +232,434 @@ absl::Status AppendTableEntryReads(
     VLOG(2) << absl::StreamFormat(
         "Role '%s' is not allowed access to table '%s'.", role_name,
         table_def->second.preamble().name());
-    return absl::OkStatus();
+    return TableEntryReadAccess{.allowed = false};
   }
 
-  // Update the response to include the table entry.
-  p4::v1::TableEntry* response_entry =
-      response.add_entities()->mutable_table_entry();
-  *response_entry = cached_entry;
-
   // For ACL tables we need to check for counter/meter data, and append it as
   // needed.
   ASSIGN_OR_RETURN(table::Type table_type, GetTableType(table_def->second),
                    _ << "Could not determine table type for table '"
                      << table_def->second.preamble().name() << "'.");
-  if (table_type == table::Type::kAcl) {
-    RETURN_IF_ERROR(AppendAclCounterData(
-        *response_entry, ir_p4_info, translate_port_ids, port_translation_map,
-        cpu_queue_translator, p4rt_table));
-  }
+  return TableEntryReadAccess{
+      .allowed = true, .has_counter_data = table_type == table::Type::kAcl};
+}
 
-  return absl::OkStatus();
+// ReadResponse.entities is field 1, and length-delimited.
+static_assert(p4::v1::ReadResponse::kEntitiesFieldNumber == 1);
+constexpr char kEntitiesFieldTag = (1 << 3) | 2;
+
+// Returns the bytes an entity of `entity_bytes` takes up in a ReadResponse,
+// including its tag and length prefix.
+size_t EntityFieldBytes(size_t entity_bytes) {
+  return 1 +
+         google::protobuf::io::CodedOutputStream::VarintSize64(entity_bytes) +
+         entity_bytes;
 }
 
-absl::Status AppendPacketReplicationEntryReads(
-    p4::v1::ReadResponse& response, const p4::v1::Entity& cached_entry) {
-  // Update the response to include the packet replication entry.
-  *response.add_entities() = cached_entry;
-  return absl::OkStatus();
+// Appends a serialized entity to a serialized ReadResponse.
+void AppendEntityField(absl::string_view serialized_entity,
+                       std::string& response) {
+  uint8_t length[10];
+  uint8_t* length_end =
+      google::protobuf::io::CodedOutputStream::WriteVarint64ToArray(
+          serialized_entity.size(), length);
+  response.push_back(kEntitiesFieldTag);
+  response.append(reinterpret_cast<const char*>(length), length_end - length);
+  response.append(serialized_entity.data(), serialized_entity.size());
 }
 
+// Packs entities into serialized ReadResponses, and hands each response to the
+// writer once the next entity would push it past the byte budget.
+//
+// Cached entities are already serialized, so most are copied into the response
+// as is. Only ACL entries are kept parsed until the response is written: their
+// counter data is fetched in one batch, after which they are serialized into
+// their place in the response.
+class ReadResponseStreamer {
+ public:
+  ReadResponseStreamer(
+      int max_response_bytes, CounterDataContext& counter_context,
+      absl::FunctionRef<absl::Status(absl::string_view)> write)
+      : max_response_bytes_(max_response_bytes),
+        counter_context_(counter_context),
+        write_(write) {}
+
+  // Adds a serialized entity to the current response.
+  absl::Status AddSerialized(absl::string_view serialized_entity) {
+    RETURN_IF_ERROR(Reserve(EntityFieldBytes(serialized_entity.size())));
+    AppendEntityField(serialized_entity, response_);
+    return absl::OkStatus();
+  }
+
+  // Adds a table entry that needs counter data to the current response. The
+  // entry can pass the P4RT_TABLE key stored in the entity cache, if any.
+  absl::Status AddWithCounterData(p4::v1::Entity entity,
+                                  const std::string* app_db_key) {
+    // Counter data is not known yet, but only adds a few bytes per entry which
+    // the budget's headroom covers.
+    RETURN_IF_ERROR(Reserve(EntityFieldBytes(entity.ByteSizeLong())));
+    p4::v1::Entity* added = counter_entities_.add_entities();
+    *added = std::move(entity);
+    pending_counter_entries_.push_back(PendingCounterEntry{
+        .pi_table_entry = added->mutable_table_entry(),
+        .app_db_key = app_db_key,
+    });
+    counter_entity_offsets_.push_back(response_.size());
+    return absl::OkStatus();
+  }
+
+  // Writes a response that was assembled by another streamer. Any entities in
+  // the current response are written first so the order is kept.
+  absl::Status AddResponse(absl::string_view serialized_response) {
+    RETURN_IF_ERROR(FlushPending());
+    RETURN_IF_ERROR(write_(serialized_response));
+    ++responses_written_;
+    return absl::OkStatus();
+  }
+
+  // Writes the current response, if it holds any entities.
+  absl::Status FlushPending() {
+    if (entity_count_ > 0) return Flush();
+    return absl::OkStatus();
+  }
+
+  // Writes any remaining entities. If nothing was written we still send one
+  // empty response so the controller gets a reply.
+  absl::Status Finish() {
+    if (entity_count_ > 0 || responses_written_ == 0) return Flush();
+    return absl::OkStatus();
+  }
+
+ private:
+  // Makes room for an entity of `entity_bytes` in the current response. A
+  // response always holds at least one entity, even if that entity alone
+  // exceeds the budget.
+  absl::Status Reserve(size_t entity_bytes) {
+    if (entity_count_ > 0 &&
+        response_bytes_ + entity_bytes > max_response_bytes_) {
+      RETURN_IF_ERROR(Flush());
+    }
+    ++entity_count_;
+    response_bytes_ += entity_bytes;
+    return absl::OkStatus();
+  }
+
+  absl::Status Flush() {
+    if (!pending_counter_entries_.empty()) {
+      RETURN_IF_ERROR(
+          AppendAclCounterData(pending_counter_entries_, counter_context_));
+      SpliceCounterEntities();
+    }
+    RETURN_IF_ERROR(write_(response_));
+    ++responses_written_;
+    response_.clear();
+    response_bytes_ = 0;
+    entity_count_ = 0;
+    return absl::OkStatus();
+  }
+
+  // Serializes the entries with counter data into their place in `response_`.
+  void SpliceCounterEntities() {
+    std::string spliced;
+    spliced.reserve(response_bytes_);
+    std::string serialized_entity;
+    size_t copied = 0;
+    for (int i = 0; i < counter_entities_.entities_size(); ++i) {
+      spliced.append(response_, copied, counter_entity_offsets_[i] - copied);
+      copied = counter_entity_offsets_[i];
+      counter_entities_.entities(i).SerializeToString(&serialized_entity);
+      AppendEntityField(serialized_entity, spliced);
+    }
+    spliced.append(response_, copied, std::string::npos);
+    response_ = std::move(spliced);
+
+    pending_counter_entries_.clear();
+    counter_entity_offsets_.clear();
+    counter_entities_.Clear();
+  }
+
+  const size_t max_response_bytes_;
+  CounterDataContext& counter_context_;
+  absl::FunctionRef<absl::Status(absl::string_view)> write_;
+
+  // The serialized response, without the entries that still need counter data.
+  std::string response_;
+  // The estimated size of the response once every entry is added.
+  size_t response_bytes_ = 0;
+  int entity_count_ = 0;
+  int responses_written_ = 0;
+
+  // Entries that still need counter data, and the offset in `response_` that
+  // each belongs at. Protobuf repeated fields keep their elements at stable
+  // addresses so the pending entries stay valid until the response is written.
+  p4::v1::ReadResponse counter_entities_;
+  std::vector<size_t> counter_entity_offsets_;
+  std::vector<PendingCounterEntry> pending_counter_entries_;
+};
+
+// Streams the entry identified by a single entry read, if it exists. The entry
+// is looked up by its key instead of visiting every entry in its table, so
+// reading back a few entries stays cheap no matter how full the table is.
+absl::Status StreamSingleTableEntry(const p4::v1::TableEntry& filter,
+                                    const std::string& role_name,
+                                    const pdpi::IrP4Info& ir_p4_info,
+                                    const EntityCache& entity_cache,
+                                    ReadResponseStreamer& streamer) {
+  const pdpi::EntityKey key(filter);
+  std::optional<p4::v1::Entity> entry = entity_cache.Find(key);
+  if (!entry.has_value()) return absl::OkStatus();
+
+  ASSIGN_OR_RETURN(
+      TableEntryReadAccess access,
+      GetTableEntryReadAccess(filter.table_id(), role_name, ir_p4_info));
+  if (!access.allowed) return absl::OkStatus();
+  if (access.has_counter_data) {
+    return streamer.AddWithCounterData(*std::move(entry),
+                                       entity_cache.FindAppDbKey(key));
+  }
+  return streamer.AddSerialized(entry->SerializeAsString());
+}
+
+// Adds every cached table entry that the reader's role can access, and that
+// satisfies the read's filter, to a response.
+class TableEntryCollector {
+ public:
+  TableEntryCollector(const p4::v1::TableEntry& filter,
+                      const std::string& role_name,
+                      const pdpi::IrP4Info& ir_p4_info,
+                      const EntityCache& entity_cache)
+      : filter_(filter),
+        // Entries only need to be parsed to apply a filter, or to append
+        // counter data.
+        has_filter_(filter.priority() != 0 || !filter.match().empty()),
+        role_name_(role_name),
+        ir_p4_info_(ir_p4_info),
+        entity_cache_(entity_cache) {}
+
+  absl::Status Add(const pdpi::EntityKey& key, uint32_t table_id,
+                   absl::string_view serialized,
+                   ReadResponseStreamer& streamer) {
+    // Entries are visited table by table, so the access is only looked up
+    // again when the table changes.
+    if (table_id != access_table_id_) {
+      ASSIGN_OR_RETURN(access_, GetTableEntryReadAccess(table_id, role_name_,
+                                                        ir_p4_info_));
+      access_table_id_ = table_id;
+    }
+    if (!access_.allowed) return absl::OkStatus();
+    if (!has_filter_ && !access_.has_counter_data) {
+      return streamer.AddSerialized(serialized);
+    }
+
+    if (!entry_.ParseFromArray(serialized.data(), serialized.size())) {
+      return gutil::InternalErrorBuilder()
+             << "Could not parse the cached entity for key: " << key;
+    }
+    if (!TableEntryMatchesFilter(filter_, entry_.table_entry())) {
+      return absl::OkStatus();
+    }
+    if (!access_.has_counter_data) {
+      return streamer.AddSerialized(serialized);
+    }
+    return streamer.AddWithCounterData(std::move(entry_),
+                                       entity_cache_.FindAppDbKey(key));
+  }
+
+ private:
+  const p4::v1::TableEntry& filter_;
+  const bool has_filter_;
+  const std::string& role_name_;
+  const pdpi::IrP4Info& ir_p4_info_;
+  const EntityCache& entity_cache_;
+
+  uint32_t access_table_id_ = 0;
+  TableEntryReadAccess access_;
+  p4::v1::Entity entry_;
+};
+
+// Number of cached table entries in each shard of a parallel read.
+constexpr int kReadShardEntries = 1024;
+
+// Splits the visited table entries into shards which are filtered, given
+// counter data, and packed into responses concurrently by a worker pool.
+//
+// Entries are gathered until there is one shard for every thread, and the
+// shards' responses are written in order once they are all done. So the
+// entities are streamed in the same order as a serial read, and only one
+// round of responses is held in memory at a time. The entries point into the
+// entity cache, which is not modified while it is read.
+class ParallelTableEntryReader {
+ public:
+  ParallelTableEntryReader(int max_response_bytes, WorkerPool& worker_pool,
+                           const p4::v1::TableEntry& filter,
+                           const std::string& role_name,
+                           const pdpi::IrP4Info& ir_p4_info,
+                           const EntityCache& entity_cache,
+                           CounterDataContext& counter_context,
+                           ReadResponseStreamer& streamer)
+      : max_response_bytes_(max_response_bytes),
+        worker_pool_(worker_pool),
+        round_entries_((worker_pool.size() + 1) * kReadShardEntries),
+        filter_(filter),
+        role_name_(role_name),
+        ir_p4_info_(ir_p4_info),
+        entity_cache_(entity_cache),
+        counter_context_(counter_context),
+        streamer_(streamer) {}
+
+  absl::Status Add(const pdpi::EntityKey& key, uint32_t table_id,
+                   absl::string_view serialized) {
+    entries_.push_back(CachedTableEntry{
+        .key = &key, .table_id = table_id, .serialized = serialized});
+    if (entries_.size() < round_entries_) return absl::OkStatus();
+    return ProcessRound();
+  }
+
+  // Processes any entries that are left.
+  absl::Status Finish() {
+    if (entries_.empty()) return absl::OkStatus();
+    return ProcessRound();
+  }
+
+ private:
+  struct CachedTableEntry {
+    const pdpi::EntityKey* key;
+    uint32_t table_id;
+    absl::string_view serialized;
+  };
+
+  struct Shard {
+    absl::Status status;
+    std::vector<std::string> responses;
+    absl::Time counter_data_time = absl::InfiniteFuture();
+  };
+
+  absl::Status ProcessRound() {
+    const int num_shards =
+        (entries_.size() + kReadShardEntries - 1) / kReadShardEntries;
+    std::vector<Shard> shards(num_shards);
+    worker_pool_.ParallelFor(num_shards, [&](int shard_index) {
+      Shard& shard = shards[shard_index];
+      shard.status = ProcessShard(shard_index, shard);
+    });
+    entries_.clear();
+
+    for (const Shard& shard : shards) {
+      RETURN_IF_ERROR(shard.status);
+      counter_context_.counter_data_time =
+          std::min(counter_context_.counter_data_time, shard.counter_data_time);
+      for (const std::string& response : shard.responses) {
+        RETURN_IF_ERROR(streamer_.AddResponse(response));
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status ProcessShard(int shard_index, Shard& shard) {
+    CounterDataContext counter_context = counter_context_;
+    counter_context.counter_data_time = absl::InfiniteFuture();
+    auto collect_response =
+        [&shard](absl::string_view response) -> absl::Status {
+      shard.responses.push_back(std::string(response));
+      return absl::OkStatus();
+    };
+    ReadResponseStreamer streamer(max_response_bytes_, counter_context,
+                                  collect_response);
+    TableEntryCollector collector(filter_, role_name_, ir_p4_info_,
+                                  entity_cache_);
+
+    const size_t end = std::min(
+        entries_.size(), static_cast<size_t>(shard_index + 1) *
+                             kReadShardEntries);
+    for (size_t i = shard_index * kReadShardEntries; i < end; ++i) {
+      const CachedTableEntry& entry = entries_[i];
+      RETURN_IF_ERROR(collector.Add(*entry.key, entry.table_id,
+                                    entry.serialized, streamer));
+    }
+    RETURN_IF_ERROR(streamer.FlushPending());
+    shard.counter_data_time = counter_context.counter_data_time;
+    return absl::OkStatus();
+  }
+
+  const int max_response_bytes_;
+  WorkerPool& worker_pool_;
+  const size_t round_entries_;
+  const p4::v1::TableEntry& filter_;
+  const std::string& role_name_;
+  const pdpi::IrP4Info& ir_p4_info_;
+  const EntityCache& entity_cache_;
+  CounterDataContext& counter_context_;
+  ReadResponseStreamer& streamer_;
+
+  std::vector<CachedTableEntry> entries_;
+};
+
 }  // namespace
 
-absl::StatusOr<std::vector<p4::v1::ReadResponse>> ReadAllEntitiesInBatches(
-    int batch_size, const p4::v1::ReadRequest& request,
-    const pdpi::IrP4Info& ir_p4_info,
-    const absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity>& entity_cache,
+absl::Status StreamAllEntities(
+    int max_response_bytes, const p4::v1::ReadRequest& request,
+    const pdpi::IrP4Info& ir_p4_info, const EntityCache& entity_cache,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
-    CpuQueueTranslator& cpu_queue_translator, sonic::P4rtTable& p4rt_table) {
-  std::vector<p4::v1::ReadResponse> responses;
-  responses.push_back(p4::v1::ReadResponse{});
+    const PortTranslator& port_translation_map,
+    const CpuQueueTranslator& cpu_queue_translator,
+    sonic::P4rtTable& p4rt_table, absl::Mutex& counter_db_lock,
+    AclCounterCache* acl_counter_cache,
+    absl::FunctionRef<absl::Status(absl::string_view)> write_response,
+    absl::Time* counter_data_time, WorkerPool* worker_pool) {
+  CounterDataContext counter_context{
+      .ir_p4_info = ir_p4_info,
+      .translate_port_ids = translate_port_ids,
+      .port_translation_map = port_translation_map,
+      .cpu_queue_translator = cpu_queue_translator,
+      .p4rt_table = p4rt_table,
+      .counter_db_lock = counter_db_lock,
+      .acl_counter_cache = acl_counter_cache,
+  };
+  ReadResponseStreamer streamer(max_response_bytes, counter_context,
+                                write_response);
   for (const auto& entity : request.entities()) {
     VLOG(1) << "Read request: " << entity.ShortDebugString();
     switch (entity.entity_case()) {
       case p4::v1::Entity::kTableEntry: {
-        RETURN_IF_ERROR(SupportedTableEntryRequest(entity.table_entry()));
-        for (const auto& [_, entry] : entity_cache) {
-          if (entry.entity_case() == p4::v1::Entity::kTableEntry) {
-            RETURN_IF_ERROR(AppendTableEntryReads(
-                responses.back(), entry.table_entry(), request.role(),
-                ir_p4_info, translate_port_ids, port_translation_map,
-                cpu_queue_translator, p4rt_table));
-            if (responses.size() >= batch_size) {
-              responses.push_back(p4::v1::ReadResponse{});
-            }
-          }
+        const p4::v1::TableEntry& filter = entity.table_entry();
+        RETURN_IF_ERROR(SupportedTableEntryRequest(filter));
+        if (IsSingleEntryRead(filter, ir_p4_info)) {
+          RETURN_IF_ERROR(StreamSingleTableEntry(filter, request.role(),
+                                                 ir_p4_info, entity_cache,
+                                                 streamer));
+          break;
         }
+        if (worker_pool != nullptr) {
+          ParallelTableEntryReader reader(
+              max_response_bytes, *worker_pool, filter, request.role(),
+              ir_p4_info, entity_cache, counter_context, streamer);
+          RETURN_IF_ERROR(entity_cache.ForEachSerializedTableEntry(
+              filter.table_id(),
+              [&](const pdpi::EntityKey& key, uint32_t table_id,
+                  absl::string_view serialized) -> absl::Status {
+                return reader.Add(key, table_id, serialized);
+              }));
+          RETURN_IF_ERROR(reader.Finish());
+          break;
+        }
+        TableEntryCollector collector(filter, request.role(), ir_p4_info,
+                                      entity_cache);
+        RETURN_IF_ERROR(entity_cache.ForEachSerializedTableEntry(
+            filter.table_id(),
+            [&](const pdpi::EntityKey& key, uint32_t table_id,
+                absl::string_view serialized) -> absl::Status {
+              return collector.Add(key, table_id, serialized, streamer);
+            }));
         break;
       }
       case p4::v1::Entity::kPacketReplicationEngineEntry: {
         RETURN_IF_ERROR(SupportedPacketReplicationEntryRequest(
             entity.packet_replication_engine_entry()));
-        for (const auto& [_, entry] : entity_cache) {
-          if (entry.entity_case() ==
-              p4::v1::Entity::kPacketReplicationEngineEntry) {
-            RETURN_IF_ERROR(
-                AppendPacketReplicationEntryReads(responses.back(), entry));
-            if (responses.size() >= batch_size) {
-              responses.push_back(p4::v1::ReadResponse{});
-            }
-          }
-        }
+        RETURN_IF_ERROR(entity_cache.ForEachSerializedEntityOfType(
+            p4::v1::Entity::kPacketReplicationEngineEntry,
+            [&](absl::string_view serialized) -> absl::Status {
+              return streamer.AddSerialized(serialized);
+            }));
         break;
       }
       default:
@@ -184,10 +668,11 @@ absl::StatusOr<std::vector<p4::v1::ReadResponse>> ReadAllEntitiesInBatches(
                << entity.ShortDebugString();
     }
   }
-  if (responses.size() > 1 && responses.back().entities().empty()) {
-    responses.pop_back();
+  RETURN_IF_ERROR(streamer.Finish());
+  if (counter_data_time != nullptr) {
+    *counter_data_time = counter_context.counter_data_time;
   }
-  return responses;
+  return absl::OkStatus();
 }
 
 }  // namespace p4rt_app
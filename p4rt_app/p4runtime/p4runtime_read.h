@@ -17,25 +17,74 @@
 #include <string>
 
 #include "absl/container/flat_hash_map.h"
-#include "absl/status/statusor.h"
-#include "boost/bimap.hpp"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/entity_keys.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/p4runtime/acl_counter_cache.h"
 #include "p4rt_app/p4runtime/cpu_queue_translator.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
+#include "p4rt_app/p4runtime/port_translator.h"
 #include "p4rt_app/sonic/redis_connections.h"
+#include "p4rt_app/utils/worker_pool.h"
 
 namespace p4rt_app {
 
-// Reads all table entries from the cache and return in batches (of batch_size).
-// For each ACL entry we also fetch counter data from CounterDb.
-absl::StatusOr<std::vector<p4::v1::ReadResponse>> ReadAllEntitiesInBatches(
-    int batch_size, const p4::v1::ReadRequest& request,
-    const pdpi::IrP4Info& ir_p4_info,
-    const absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity>& entity_cache,
+// Default byte budget for a single ReadResponse. gRPC's default max receive
+// message size is 4MB so we leave headroom for framing, and for the last entity
+// which may push a response slightly past the budget.
+inline constexpr int kDefaultReadResponseMaxBytes = 3 * 1024 * 1024;
+
+// Trailing metadata of Read responses served with the ACL counter cache. Holds
+// when the oldest counter data in the read was fetched from the CountersDb, in
+// microseconds since the Unix epoch.
+inline constexpr char kAclCounterDataTimeMetadataKey[] =
+    "p4rt-acl-counter-data-time-us";
+
+// Reads all requested entities from the cache and streams them to
+// `write_response` as serialized ReadResponses. Entities are packed into a
+// response until the next one would exceed `max_response_bytes`, at which point
+// the response is written. A response always holds at least one entity, and an
+// empty response is written if nothing matches the request.
+//
+// Responses are assembled from the cache's serialized entities, so entities are
+// only parsed when they need to be filtered, or need counter data.
+//
+// For ACL entries we also fetch counter data from CounterDb. The counters for
+// every ACL entry in a response are fetched with one batched request while
+// holding the `counter_db_lock`. The lock is not held while writing responses.
+// When an `acl_counter_cache` is given, counter data that is fresh enough is
+// served from it instead, and only the rest is fetched. If set, the
+// `counter_data_time` is assigned when the oldest counter data in the read was
+// fetched, or absl::InfiniteFuture() if the read had no ACL entries.
+//
+// Table entry reads can be scoped to a single table ID. In which case only the
+// entries in that table are visited. Scoped reads can be further filtered by
+// priority, and by a subset of the entry's match fields.
+// A scoped read with every match field of the table, and a priority if the
+// table needs one, identifies a single entry which is looked up by its key.
+//
+// When a `worker_pool` is given, table entry reads are split into shards that
+// are filtered, given counter data, and packed into responses concurrently.
+// Entities are still written in the same order, but a shard's last response
+// may hold fewer entities than the budget allows.
+absl::Status StreamAllEntities(
+    int max_response_bytes, const p4::v1::ReadRequest& request,
+    const pdpi::IrP4Info& ir_p4_info, const EntityCache& entity_cache,
     bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
-    CpuQueueTranslator& cpu_queue_translator, sonic::P4rtTable& p4rt_table);
+    const PortTranslator& port_translation_map,
+    const CpuQueueTranslator& cpu_queue_translator,
+    sonic::P4rtTable& p4rt_table, absl::Mutex& counter_db_lock,
+    AclCounterCache* acl_counter_cache,
+    absl::FunctionRef<absl::Status(absl::string_view serialized_response)>
+        write_response,
+    absl::Time* counter_data_time = nullptr,
+    WorkerPool* worker_pool = nullptr);
+
 }  // namespace p4rt_app
 
 #endif  // PINS_P4RT_APP_P4RUNTIME_P4RUNTIME_READ_H_
@@ -13,44 +13,119 @@
 // limitations under the License.
 #include "p4rt_app/p4runtime/packetio_helpers.h"
 
+#include <cstdint>
 #include <string>
 
+#include "absl/container/inlined_vector.h"
+#include "absl/numeric/bits.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
-#include "boost/bimap.hpp"
+#include "absl/strings/string_view.h"
 #include "gutil/status.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/utils/ir.h"
 #include "p4rt_app/p4runtime/ir_translation.h"
+#include "p4rt_app/p4runtime/port_translator.h"
 #include "p4rt_app/sonic/packetio_impl.h"
 #include "p4rt_app/sonic/packetio_interface.h"
 #include "sai_p4/fixed/ids.h"
 #include "swss/schema.h"
 
 namespace p4rt_app {
+namespace {
+
+// Returns true if the bytestring is non-empty and its value fits in
+// `bitwidth` bits, ignoring leading zeros.
+bool FitsInBitwidth(const std::string& bytes, int bitwidth) {
+  if (bytes.empty()) return false;
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    uint8_t byte = static_cast<uint8_t>(bytes[i]);
+    if (byte == 0) continue;
+    int used_bits = (bytes.size() - i - 1) * 8 + absl::bit_width(byte);
+    return used_bits <= bitwidth;
+  }
+  return true;
+}
+
+bool IsValidMetadataValue(const PacketOutMetadataLayout::Field& field,
+                          const std::string& value) {
+  if (field.is_padding) return pdpi::IsAllZeros(value);
+  switch (field.format) {
+    case pdpi::Format::STRING:
+      return !value.empty();
+    case pdpi::Format::HEX_STRING:
+      return FitsInBitwidth(value, field.bitwidth);
+    default:
+      return pdpi::ArbitraryByteStringToIrValue(field.format, field.bitwidth,
+                                                value)
+          .ok();
+  }
+}
+
+// Returns PDPI's description of why a PacketOut is invalid.
+absl::Status InvalidPacketOutError(const pdpi::IrP4Info& p4_info,
+                                   const p4::v1::PacketOut& packet) {
+  absl::Status status = pdpi::PiPacketOutToIr(p4_info, packet).status();
+  if (status.ok()) {
+    // The layout should be stricter than PDPI, but never send a packet we
+    // could not validate.
+    return gutil::InvalidArgumentErrorBuilder()
+           << "[P4RT] PacketOut metadata does not match the P4Info: "
+           << packet.ShortDebugString();
+  }
+  LOG(WARNING) << "PDPI PacketOutToIr failure: " << status;
+  return gutil::StatusBuilder(status.code()) << "[P4RT/PDPI] "
+                                             << status.message();
+}
+
+}  // namespace
 
 // Adds the given metadata to the PacketIn.
-p4::v1::PacketIn CreatePacketInMessage(const std::string& source_port_id,
-                                       const std::string& target_port_id) {
+p4::v1::PacketIn CreatePacketInMessage(absl::string_view source_port_id,
+                                       absl::string_view target_port_id) {
   p4::v1::PacketIn packet;
   p4::v1::PacketMetadata* metadata = packet.add_metadata();
   // Add Ingress port id.
   metadata->set_metadata_id(PACKET_IN_INGRESS_PORT_ID);
-  metadata->set_value(source_port_id);
+  metadata->set_value(source_port_id.data(), source_port_id.size());
 
   // Add target egress port id.
   metadata = packet.add_metadata();
   metadata->set_metadata_id(PACKET_IN_TARGET_EGRESS_PORT_ID);
-  metadata->set_value(target_port_id);
+  metadata->set_value(target_port_id.data(), target_port_id.size());
 
   return packet;
 }
 
+PacketInTemplates::PacketInTemplates(const PortTranslator& port_translator) {
+  by_port_name_.reserve(port_translator.size());
+  for (const auto& [port_name, port_id] : port_translator.NameToIdMap()) {
+    by_port_name_[port_name] = CreatePacketInMessage(port_id, port_id);
+  }
+}
+
+const p4::v1::PacketIn* PacketInTemplates::Find(
+    absl::string_view port_name) const {
+  auto iter = by_port_name_.find(port_name);
+  if (iter == by_port_name_.end()) return nullptr;
+  return &iter->second;
+}
+
+void SetPacketInMetadata(const p4::v1::PacketIn& source_template,
+                         const p4::v1::PacketIn* target_template,
+                         p4::v1::PacketIn& packet) {
+  *packet.mutable_metadata() = source_template.metadata();
+  if (target_template != nullptr && target_template != &source_template) {
+    // CreatePacketInMessage puts the target egress port second.
+    *packet.mutable_metadata(1) = target_template->metadata(1);
+  }
+}
+
 absl::Status SendPacketOut(
     const pdpi::IrP4Info& p4_info, bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
     sonic::PacketIoInterface* const packetio_impl,
     const p4::v1::PacketOut& packet) {
   // Convert to IR to check validity of PacketOut message (e.g. duplicate or
@@ -113,4 +188,80 @@ absl::Status SendPacketOut(
   return absl::OkStatus();
 }
 
+PacketOutMetadataLayout BuildPacketOutMetadataLayout(
+    const pdpi::IrP4Info& p4_info) {
+  PacketOutMetadataLayout layout;
+  for (const auto& [id, definition] : p4_info.packet_out_metadata_by_id()) {
+    layout.offset_by_id[id] = layout.fields.size();
+    layout.fields.push_back(PacketOutMetadataLayout::Field{
+        .id = id,
+        .bitwidth = definition.metadata().bitwidth(),
+        .format = definition.format(),
+        .is_padding = definition.is_padding(),
+    });
+  }
+  return layout;
+}
+
+absl::Status SendPacketOut(
+    const pdpi::IrP4Info& p4_info, const PacketOutMetadataLayout& layout,
+    bool translate_port_ids, const PortTranslator& port_translation_map,
+    sonic::PacketIoInterface* const packetio_impl,
+    const p4::v1::PacketOut& packet) {
+  // Every metadata field must be present exactly once with a valid value.
+  if (packet.metadata_size() != static_cast<int>(layout.fields.size())) {
+    return InvalidPacketOutError(p4_info, packet);
+  }
+  absl::InlinedVector<bool, 4> seen(layout.fields.size(), false);
+  const std::string* egress_port_id = nullptr;
+  int submit_to_ingress = 0;
+  for (const auto& meta : packet.metadata()) {
+    auto offset = layout.offset_by_id.find(meta.metadata_id());
+    if (offset == layout.offset_by_id.end() || seen[offset->second] ||
+        !IsValidMetadataValue(layout.fields[offset->second], meta.value())) {
+      return InvalidPacketOutError(p4_info, packet);
+    }
+    seen[offset->second] = true;
+
+    switch (meta.metadata_id()) {
+      case PACKET_OUT_EGRESS_PORT_ID: {
+        egress_port_id = &meta.value();
+        break;
+      }
+      case PACKET_OUT_SUBMIT_TO_INGRESS_ID: {
+        ASSIGN_OR_RETURN(
+            submit_to_ingress,
+            pdpi::ArbitraryByteStringToUint(meta.value(), /*bitwidth=*/1),
+            _ << "Unable to get inject_ingress from the packet metadata");
+        break;
+      }
+      case PACKET_OUT_UNUSED_PAD_ID: {
+        // Nothing to do.
+        break;
+      }
+      default:
+        return gutil::InvalidArgumentErrorBuilder()
+               << "Unexpected Packet Out metadata id " << meta.metadata_id();
+    }
+  }
+
+  // Send packet out via the socket. The port name and payload are only
+  // referenced, never copied, unless the port ID needs translating.
+  if (submit_to_ingress == 1) {
+    return packetio_impl->SendPacketOut(SEND_TO_INGRESS_PORT_NAME,
+                                        packet.payload());
+  }
+  if (egress_port_id == nullptr) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "PacketOut is missing the egress port metadata.";
+  }
+  if (!translate_port_ids) {
+    return packetio_impl->SendPacketOut(*egress_port_id, packet.payload());
+  }
+  ASSIGN_OR_RETURN(std::string sonic_port_name,
+                   TranslatePort(TranslationDirection::kForOrchAgent,
+                                 port_translation_map, *egress_port_id));
+  return packetio_impl->SendPacketOut(sonic_port_name, packet.payload());
+}
+
 }  // namespace p4rt_app
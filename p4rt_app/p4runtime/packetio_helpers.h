@@ -14,13 +14,17 @@
 #ifndef PINS_P4RT_APP_P4RUNTIME_PACKET_IO_HELPERS_H_
 #define PINS_P4RT_APP_P4RUNTIME_PACKET_IO_HELPERS_H_
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
-#include "boost/bimap.hpp"
+#include "absl/strings/string_view.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/p4runtime/port_translator.h"
 #include "p4rt_app/sonic/packetio_interface.h"
 
 namespace p4rt_app {
@@ -28,14 +32,63 @@ namespace p4rt_app {
 #define SEND_TO_INGRESS_PORT_NAME "SEND_TO_INGRESS"
 
 // Add the required metadata and return a PacketIn.
-p4::v1::PacketIn CreatePacketInMessage(const std::string& source_port_id,
-                                       const std::string& target_port_id);
+p4::v1::PacketIn CreatePacketInMessage(absl::string_view source_port_id,
+                                       absl::string_view target_port_id);
+
+// PacketIn metadata for every translated port, rebuilt whenever the port
+// translations change so a PacketIn needs one lookup per port and no
+// per-packet metadata construction.
+class PacketInTemplates {
+ public:
+  PacketInTemplates() = default;
+  explicit PacketInTemplates(const PortTranslator& port_translator);
+
+  // Returns a PacketIn whose ingress and target egress port metadata are both
+  // set to the port's ID, or nullptr if the port has no translation.
+  const p4::v1::PacketIn* Find(absl::string_view port_name) const;
+
+ private:
+  absl::flat_hash_map<std::string, p4::v1::PacketIn> by_port_name_;
+};
+
+// Sets the PacketIn metadata from the source port's template. If a different
+// target port template is given its target egress port replaces the source's.
+void SetPacketInMetadata(const p4::v1::PacketIn& source_template,
+                         const p4::v1::PacketIn* target_template,
+                         p4::v1::PacketIn& packet);
 
 // Utility function to parse the packet metadata and send it out via the
 // socket interface.
 absl::Status SendPacketOut(
     const pdpi::IrP4Info& p4_info, bool translate_port_ids,
-    const boost::bimap<std::string, std::string>& port_translation_map,
+    const PortTranslator& port_translation_map,
+    sonic::PacketIoInterface* const packetio_impl,
+    const p4::v1::PacketOut& packet);
+
+// The packet-out metadata definitions from an IrP4Info, laid out so a
+// PacketOut can be validated without translating it to IR.
+struct PacketOutMetadataLayout {
+  struct Field {
+    uint32_t id = 0;
+    int bitwidth = 0;
+    pdpi::Format format = pdpi::Format::HEX_STRING;
+    bool is_padding = false;
+  };
+  // One entry per packet-out metadata defined in the P4Info.
+  std::vector<Field> fields;
+  // Maps a metadata ID to its offset in `fields`.
+  absl::flat_hash_map<uint32_t, int> offset_by_id;
+};
+
+PacketOutMetadataLayout BuildPacketOutMetadataLayout(
+    const pdpi::IrP4Info& p4_info);
+
+// Same as above, but validates the metadata against a precomputed layout
+// instead of translating the PacketOut to IR, and sends the payload straight
+// from the request. The IrP4Info is only used to describe invalid requests.
+absl::Status SendPacketOut(
+    const pdpi::IrP4Info& p4_info, const PacketOutMetadataLayout& layout,
+    bool translate_port_ids, const PortTranslator& port_translation_map,
     sonic::PacketIoInterface* const packetio_impl,
     const p4::v1::PacketOut& packet);
 
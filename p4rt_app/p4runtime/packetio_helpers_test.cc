@@ -17,7 +17,6 @@
 #include <utility>
 
 #include "absl/strings/string_view.h"
-#include "boost/bimap.hpp"
 #include "glog/logging.h"
 #include "gmock/gmock.h"
 #include "google/protobuf/text_format.h"
@@ -26,6 +25,7 @@
 #include "gutil/status_matchers.h"
 #include "p4_pdpi/utils/ir.h"
 #include "p4rt_app/p4runtime/p4info_verification.h"
+#include "p4rt_app/p4runtime/port_translator.h"
 #include "p4rt_app/sonic/adapters/mock_system_call_adapter.h"
 #include "p4rt_app/sonic/packetio_impl.h"
 #include "p4rt_app/sonic/packetio_port.h"
@@ -136,8 +136,8 @@ TEST_F(PacketIoHelpersTest, SendPacketOutEgressPortUsingPortIdOk) {
   EXPECT_CALL(*mock_call_adapter_, socket).WillOnce(Return(fd[1]));
   EXPECT_CALL(*mock_call_adapter_, if_nametoindex).WillOnce(Return(1));
 
-  boost::bimap<std::string, std::string> port_maps;
-  port_maps.insert({"Ethernet1/2", "1"});
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1/2", "1");
   ASSERT_OK(packetio_impl_->AddPacketIoPort("Ethernet1/2"));
   EXPECT_OK(SendPacketOut(ir_p4_info_, kTranslatePortId, port_maps,
                           packetio_impl_.get(), packet));
@@ -163,8 +163,8 @@ TEST_F(PacketIoHelpersTest, SendPacketOutEgressPortUsingPortNameOk) {
   EXPECT_CALL(*mock_call_adapter_, socket).WillOnce(Return(fd[1]));
   EXPECT_CALL(*mock_call_adapter_, if_nametoindex).WillOnce(Return(1));
 
-  boost::bimap<std::string, std::string> port_maps;
-  port_maps.insert({"Ethernet1/2", "1"});
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1/2", "1");
   ASSERT_OK(packetio_impl_->AddPacketIoPort("Ethernet1/2"));
   EXPECT_OK(SendPacketOut(ir_p4_info_, !kTranslatePortId, port_maps,
                           packetio_impl_.get(), packet));
@@ -191,7 +191,7 @@ TEST_F(PacketIoHelpersTest, SendPacketOutIngressInjectOk) {
   EXPECT_CALL(*mock_call_adapter_, socket).WillOnce(Return(fd[1]));
   EXPECT_CALL(*mock_call_adapter_, if_nametoindex).WillOnce(Return(1));
 
-  boost::bimap<std::string, std::string> port_maps;
+  PortTranslator port_maps;
   ASSERT_OK(packetio_impl_->AddPacketIoPort(kSubmitToIngress));
   EXPECT_OK(SendPacketOut(ir_p4_info_, kTranslatePortId, port_maps,
                           packetio_impl_.get(), packet));
@@ -208,7 +208,7 @@ TEST_F(PacketIoHelpersTest, SendPacketOutDuplicateId) {
     iter->set_metadata_id(PACKET_OUT_EGRESS_PORT_ID);
   }
 
-  boost::bimap<std::string, std::string> port_maps;
+  PortTranslator port_maps;
   ASSERT_THAT(SendPacketOut(ir_p4_info_, kTranslatePortId, port_maps,
                             packetio_impl_.get(), packet),
               StatusIs(absl::StatusCode::kInvalidArgument));
@@ -226,7 +226,7 @@ TEST_F(PacketIoHelpersTest, SendPacketOutIdMismatch) {
     iter->set_metadata_id(prev_id + 100);
   }
 
-  boost::bimap<std::string, std::string> port_maps;
+  PortTranslator port_maps;
   ASSERT_THAT(SendPacketOut(ir_p4_info_, kTranslatePortId, port_maps,
                             packetio_impl_.get(), packet),
               StatusIs(absl::StatusCode::kInvalidArgument));
@@ -254,7 +254,7 @@ TEST_F(PacketIoHelpersTest, SendPacketOutMultipleValidValues) {
   EXPECT_CALL(*mock_call_adapter_, socket).WillOnce(Return(fd[1]));
   EXPECT_CALL(*mock_call_adapter_, if_nametoindex).WillOnce(Return(1));
 
-  boost::bimap<std::string, std::string> port_maps;
+  PortTranslator port_maps;
   ASSERT_OK(packetio_impl_->AddPacketIoPort(kSubmitToIngress));
   ASSERT_OK(SendPacketOut(ir_p4_info_, kTranslatePortId, port_maps,
                           packetio_impl_.get(), packet));
@@ -281,13 +281,96 @@ TEST_F(PacketIoHelpersTest, SendPacketOutPortZero) {
   EXPECT_CALL(*mock_call_adapter_, socket).WillOnce(Return(fd[1]));
   EXPECT_CALL(*mock_call_adapter_, if_nametoindex).WillOnce(Return(1));
 
-  boost::bimap<std::string, std::string> port_maps;
-  port_maps.insert({"Ethernet1/1", "0"});
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1/1", "0");
   ASSERT_OK(packetio_impl_->AddPacketIoPort("Ethernet1/1"));
   ASSERT_OK(SendPacketOut(ir_p4_info_, kTranslatePortId, port_maps,
                           packetio_impl_.get(), packet));
 }
 
+TEST_F(PacketIoHelpersTest, SendPacketOutWithLayoutUsingPortIdOk) {
+  p4::v1::PacketOut packet;
+  SetupPacketOutMetadata(/*egress_port*/ "1", /*egress_bitwidth*/ 9,
+                         /*submit_to_ingress*/ 0,
+                         /*ingress_bitwidth*/ 1, packet);
+  packet.set_payload("test packet");
+
+  int fd[2];
+  EXPECT_GE(pipe(fd), 0);
+
+  struct ifreq if_resp {
+    /*ifr_name=*/{""},
+    /*ifr_flags=*/{
+      { IFF_UP | IFF_RUNNING }
+    }
+  };
+  EXPECT_CALL(*mock_call_adapter_, ioctl(_, _, IfrNameEq("Ethernet1/2")))
+      .WillOnce(DoAll(SetArgPointee<2>(if_resp), Return(0)));
+  EXPECT_CALL(*mock_call_adapter_, write).Times(1);
+  EXPECT_CALL(*mock_call_adapter_, socket).WillOnce(Return(fd[1]));
+  EXPECT_CALL(*mock_call_adapter_, if_nametoindex).WillOnce(Return(1));
+
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1/2", "1");
+  ASSERT_OK(packetio_impl_->AddPacketIoPort(kSubmitToIngress));
+  EXPECT_OK(SendPacketOut(ir_p4_info_,
+                          BuildPacketOutMetadataLayout(ir_p4_info_),
+                          kTranslatePortId, port_maps, packetio_impl_.get(),
+                          packet));
+}
+
+TEST_F(PacketIoHelpersTest, SendPacketOutWithLayoutDuplicateId) {
+  p4::v1::PacketOut packet;
+  SetupPacketOutMetadata(/*egress_port*/ "1", /*egress_bitwidth*/ 9,
+                         /*submit_to_ingress*/ 0,
+                         /*ingress_bitwidth*/ 1, packet);
+  packet.mutable_metadata(1)->set_metadata_id(PACKET_OUT_EGRESS_PORT_ID);
+
+  EXPECT_CALL(*mock_call_adapter_, write).Times(0);
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1/2", "1");
+  EXPECT_THAT(SendPacketOut(ir_p4_info_,
+                            BuildPacketOutMetadataLayout(ir_p4_info_),
+                            kTranslatePortId, port_maps, packetio_impl_.get(),
+                            packet),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(PacketIoHelpersTest, SendPacketOutWithLayoutMissingMetadata) {
+  p4::v1::PacketOut packet;
+  SetupPacketOutMetadata(/*egress_port*/ "1", /*egress_bitwidth*/ 9,
+                         /*submit_to_ingress*/ 0,
+                         /*ingress_bitwidth*/ 1, packet);
+  packet.mutable_metadata()->RemoveLast();
+
+  EXPECT_CALL(*mock_call_adapter_, write).Times(0);
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1/2", "1");
+  EXPECT_THAT(SendPacketOut(ir_p4_info_,
+                            BuildPacketOutMetadataLayout(ir_p4_info_),
+                            kTranslatePortId, port_maps, packetio_impl_.get(),
+                            packet),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(PacketIoHelpersTest, SendPacketOutWithLayoutValueTooWide) {
+  p4::v1::PacketOut packet;
+  SetupPacketOutMetadata(/*egress_port*/ "1", /*egress_bitwidth*/ 9,
+                         /*submit_to_ingress*/ 0,
+                         /*ingress_bitwidth*/ 1, packet);
+  // submit_to_ingress is a single bit.
+  packet.mutable_metadata(1)->set_value("\x02");
+
+  EXPECT_CALL(*mock_call_adapter_, write).Times(0);
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1/2", "1");
+  EXPECT_THAT(SendPacketOut(ir_p4_info_,
+                            BuildPacketOutMetadataLayout(ir_p4_info_),
+                            kTranslatePortId, port_maps, packetio_impl_.get(),
+                            packet),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST_F(PacketIoHelpersTest, AddPacketInMetadataOk) {
   std::string ingress_port = "1";
   std::string target_port = "1";
@@ -297,5 +380,32 @@ TEST_F(PacketIoHelpersTest, AddPacketInMetadataOk) {
   EXPECT_THAT(actual_packet, EqualsProto(expected_packet));
 }
 
+TEST_F(PacketIoHelpersTest, PacketInTemplatesMatchCreatePacketInMessage) {
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1/1", "1");
+  port_maps.Insert("Ethernet1/2", "2");
+  PacketInTemplates templates(port_maps);
+
+  const p4::v1::PacketIn* source = templates.Find("Ethernet1/1");
+  const p4::v1::PacketIn* target = templates.Find("Ethernet1/2");
+  ASSERT_NE(source, nullptr);
+  ASSERT_NE(target, nullptr);
+
+  p4::v1::PacketIn same_port;
+  SetPacketInMetadata(*source, /*target_template=*/nullptr, same_port);
+  EXPECT_THAT(same_port, EqualsProto(CreatePacketInMessage("1", "1")));
+
+  p4::v1::PacketIn different_ports;
+  SetPacketInMetadata(*source, target, different_ports);
+  EXPECT_THAT(different_ports, EqualsProto(CreatePacketInMessage("1", "2")));
+}
+
+TEST_F(PacketIoHelpersTest, PacketInTemplatesIgnoreUnknownPorts) {
+  PortTranslator port_maps;
+  port_maps.Insert("Ethernet1/1", "1");
+  PacketInTemplates templates(port_maps);
+  EXPECT_EQ(templates.Find("Ethernet1/9"), nullptr);
+}
+
 }  // namespace
 }  // namespace p4rt_app
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "p4rt_app/p4runtime/port_translator.h"
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "gutil/collections.h"
+
+namespace p4rt_app {
+
+bool PortTranslator::Insert(absl::string_view port_name,
+                            absl::string_view port_id) {
+  if (name_to_id_.contains(port_name) || id_to_name_.contains(port_id)) {
+    return false;
+  }
+  name_to_id_.emplace(port_name, port_id);
+  id_to_name_.emplace(port_id, port_name);
+  return true;
+}
+
+bool PortTranslator::RemoveName(absl::string_view port_name) {
+  auto name = name_to_id_.find(port_name);
+  if (name == name_to_id_.end()) return false;
+  id_to_name_.erase(name->second);
+  name_to_id_.erase(name);
+  return true;
+}
+
+const std::string* PortTranslator::NameToId(
+    absl::string_view port_name) const {
+  return gutil::FindOrNull(name_to_id_, port_name);
+}
+
+const std::string* PortTranslator::IdToName(absl::string_view port_id) const {
+  return gutil::FindOrNull(id_to_name_, port_id);
+}
+
+}  // namespace p4rt_app
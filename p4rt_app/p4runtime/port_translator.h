@@ -0,0 +1,60 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PINS_P4RT_APP_P4RUNTIME_PORT_TRANSLATOR_H_
+#define PINS_P4RT_APP_P4RUNTIME_PORT_TRANSLATOR_H_
+
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace p4rt_app {
+
+// PortTranslator is a bidirectional map between SONiC port names (e.g.
+// "Ethernet0") and the port IDs used by the controller (e.g. "1"). Every name
+// and every ID can only be part of one translation.
+class PortTranslator {
+ public:
+  PortTranslator() = default;
+
+  // Adds a translation. Returns false, and does nothing, if either the name or
+  // the ID is already used by a translation.
+  bool Insert(absl::string_view port_name, absl::string_view port_id);
+
+  // Removes the translation for a port name. Returns false if there was none.
+  bool RemoveName(absl::string_view port_name);
+
+  // Returns nullptr if there is no translation. The returned value is only
+  // valid until the translator is modified.
+  const std::string* NameToId(absl::string_view port_name) const;
+  const std::string* IdToName(absl::string_view port_id) const;
+
+  // All translations, keyed by port name.
+  const absl::flat_hash_map<std::string, std::string>& NameToIdMap() const {
+    return name_to_id_;
+  }
+
+  int size() const { return name_to_id_.size(); }
+  bool empty() const { return name_to_id_.empty(); }
+
+ private:
+  absl::flat_hash_map<std::string, std::string> name_to_id_;
+  absl::flat_hash_map<std::string, std::string> id_to_name_;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_P4RUNTIME_PORT_TRANSLATOR_H_
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "p4rt_app/p4runtime/port_translator.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::testing::IsNull;
+using ::testing::Pointee;
+
+TEST(PortTranslatorTest, TranslatesInBothDirections) {
+  PortTranslator translator;
+  EXPECT_TRUE(translator.Insert("Ethernet0", "1"));
+  EXPECT_TRUE(translator.Insert("Ethernet4", "2"));
+
+  EXPECT_EQ(translator.size(), 2);
+  EXPECT_THAT(translator.NameToId("Ethernet0"), Pointee(std::string("1")));
+  EXPECT_THAT(translator.NameToId("Ethernet4"), Pointee(std::string("2")));
+  EXPECT_THAT(translator.IdToName("1"), Pointee(std::string("Ethernet0")));
+  EXPECT_THAT(translator.IdToName("2"), Pointee(std::string("Ethernet4")));
+}
+
+TEST(PortTranslatorTest, UnknownValuesReturnNull) {
+  PortTranslator translator;
+  EXPECT_TRUE(translator.empty());
+  EXPECT_THAT(translator.NameToId("Ethernet0"), IsNull());
+  EXPECT_THAT(translator.IdToName("1"), IsNull());
+
+  // Names and IDs are not interchangeable.
+  ASSERT_TRUE(translator.Insert("Ethernet0", "1"));
+  EXPECT_THAT(translator.NameToId("1"), IsNull());
+  EXPECT_THAT(translator.IdToName("Ethernet0"), IsNull());
+}
+
+TEST(PortTranslatorTest, InsertRejectsNamesAndIdsThatAreInUse) {
+  PortTranslator translator;
+  ASSERT_TRUE(translator.Insert("Ethernet0", "1"));
+
+  EXPECT_FALSE(translator.Insert("Ethernet0", "2"));
+  EXPECT_FALSE(translator.Insert("Ethernet4", "1"));
+  EXPECT_EQ(translator.size(), 1);
+  EXPECT_THAT(translator.NameToId("Ethernet0"), Pointee(std::string("1")));
+  EXPECT_THAT(translator.IdToName("2"), IsNull());
+  EXPECT_THAT(translator.NameToId("Ethernet4"), IsNull());
+}
+
+TEST(PortTranslatorTest, RemoveNameRemovesBothDirections) {
+  PortTranslator translator;
+  ASSERT_TRUE(translator.Insert("Ethernet0", "1"));
+  ASSERT_TRUE(translator.Insert("Ethernet4", "2"));
+
+  EXPECT_TRUE(translator.RemoveName("Ethernet0"));
+  EXPECT_FALSE(translator.RemoveName("Ethernet0"));
+  EXPECT_THAT(translator.NameToId("Ethernet0"), IsNull());
+  EXPECT_THAT(translator.IdToName("1"), IsNull());
+  EXPECT_THAT(translator.NameToId("Ethernet4"), Pointee(std::string("2")));
+
+  // The name and ID can be reused once removed.
+  EXPECT_TRUE(translator.Insert("Ethernet8", "1"));
+  EXPECT_TRUE(translator.Insert("Ethernet0", "3"));
+}
+
+TEST(PortTranslatorTest, CopiesAreIndependent) {
+  PortTranslator translator;
+  ASSERT_TRUE(translator.Insert("Ethernet0", "1"));
+  PortTranslator copy = translator;
+  ASSERT_TRUE(copy.RemoveName("Ethernet0"));
+
+  EXPECT_THAT(translator.NameToId("Ethernet0"), Pointee(std::string("1")));
+  EXPECT_THAT(copy.NameToId("Ethernet0"), IsNull());
+}
+
+}  // namespace
+}  // namespace p4rt_app
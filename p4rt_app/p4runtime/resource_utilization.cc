@@ -27,21 +27,58 @@
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/entity_keys.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
 #include "p4rt_app/sonic/app_db_manager.h"
 
 namespace p4rt_app {
 namespace {
 
-absl::StatusOr<std::string> GetActionProfileName(
-    const pdpi::IrP4Info& ir_p4info, uint32_t action_profile_id) {
-  const pdpi::IrActionProfileDefinition* action_profile_def =
-      gutil::FindOrNull(ir_p4info.action_profiles_by_id(), action_profile_id);
+// Returns the action profile used by a table, without any resources counted
+// against it, or nullopt if the table does not use an action profile.
+absl::StatusOr<std::optional<sonic::ActionProfileResources>>
+GetActionProfileResources(const pdpi::IrP4Info& ir_p4info,
+                          const pdpi::IrTableDefinition& table_def) {
+  if (!table_def.has_action_profile_id()) return std::nullopt;
+
+  const pdpi::IrActionProfileDefinition* action_profile_def = gutil::FindOrNull(
+      ir_p4info.action_profiles_by_id(), table_def.action_profile_id());
   if (action_profile_def == nullptr) {
     return gutil::NotFoundErrorBuilder()
            << "Could not find action profile definition for ID: "
-           << action_profile_id;
+           << table_def.action_profile_id();
   }
-  return action_profile_def->action_profile().preamble().alias();
+  return sonic::ActionProfileResources{
+      .name = action_profile_def->action_profile().preamble().alias(),
+      .id = table_def.action_profile_id(),
+  };
+}
+
+// Returns the resources used by a cached table entry. The action set is not
+// walked again, instead we use the usage counted when the entry was cached.
+absl::StatusOr<sonic::TableResources> GetResourceUsageForCachedTableEntry(
+    const pdpi::IrP4Info& ir_p4info, const EntityCache& entity_cache,
+    const pdpi::EntityKey& key, const p4::v1::TableEntry& table_entry) {
+  const pdpi::IrTableDefinition* table_def =
+      gutil::FindOrNull(ir_p4info.tables_by_id(), table_entry.table_id());
+  if (table_def == nullptr) {
+    return gutil::NotFoundErrorBuilder()
+           << "Could not find table definition for ID: "
+           << table_entry.table_id();
+  }
+  sonic::TableResources resources{
+      .name = table_def->preamble().alias(),
+  };
+  ASSIGN_OR_RETURN(resources.action_profile,
+                   GetActionProfileResources(ir_p4info, *table_def));
+  if (!resources.action_profile.has_value()) return resources;
+
+  const EntityCache::ActionSetUsage* usage =
+      entity_cache.FindActionSetUsage(key);
+  if (usage != nullptr) {
+    resources.action_profile->number_of_actions = usage->number_of_actions;
+    resources.action_profile->total_weight = usage->total_weight;
+  }
+  return resources;
 }
 
 }  // namespace
@@ -62,27 +99,18 @@ absl::StatusOr<sonic::TableResources> GetResourceUsageForIrTableEntry(
 
   // If the table does not have an action profile then we do not need to include
   // those resources in the result. So we're done.
-  if (!table_def->has_action_profile_id()) {
+  ASSIGN_OR_RETURN(resources.action_profile,
+                   GetActionProfileResources(ir_p4info, *table_def));
+  if (!resources.action_profile.has_value()) {
     return resources;
   }
 
   // Otherwise, compute the resources used.
-  ASSIGN_OR_RETURN(
-      std::string action_profile_name,
-      GetActionProfileName(ir_p4info, table_def->action_profile_id()));
-  int32_t actions = 0;
-  int64_t total_weight = 0;
   for (const pdpi::IrActionSetInvocation& action :
        table_entry.action_set().actions()) {
-    ++actions;
-    total_weight += action.weight();
+    ++resources.action_profile->number_of_actions;
+    resources.action_profile->total_weight += action.weight();
   }
-  resources.action_profile = sonic::ActionProfileResources{
-      .name = action_profile_name,
-      .number_of_actions = actions,
-      .total_weight = total_weight,
-  };
-
   return resources;
 }
 
@@ -101,35 +129,27 @@ absl::StatusOr<sonic::TableResources> GetResourceUsageForPiTableEntry(
 
   // If the table does not have an action profile then we do need to include
   // those resources in the result. So we're done.
-  if (!table_def->has_action_profile_id()) {
+  ASSIGN_OR_RETURN(resources.action_profile,
+                   GetActionProfileResources(ir_p4info, *table_def));
+  if (!resources.action_profile.has_value()) {
     return resources;
   }
 
   // Otherwise, compute the resources used.
-  ASSIGN_OR_RETURN(
-      std::string action_profile_name,
-      GetActionProfileName(ir_p4info, table_def->action_profile_id()));
-  int32_t actions = 0;
-  int64_t total_weight = 0;
   for (const p4::v1::ActionProfileAction& action :
        table_entry.action()
            .action_profile_action_set()
            .action_profile_actions()) {
-    ++actions;
-    total_weight += action.weight();
+    ++resources.action_profile->number_of_actions;
+    resources.action_profile->total_weight += action.weight();
   }
-  resources.action_profile = sonic::ActionProfileResources{
-      .name = action_profile_name,
-      .number_of_actions = actions,
-      .total_weight = total_weight,
-  };
-
   return resources;
 }
 
 ActionProfileResourceCapacity GetActionProfileResourceCapacity(
     const pdpi::IrActionProfileDefinition& action_profile_def) {
   return ActionProfileResourceCapacity{
+      .name = action_profile_def.action_profile().preamble().alias(),
       .max_group_size = action_profile_def.action_profile().max_group_size(),
 
       // TODO: replace with max_member_weight.
@@ -141,10 +161,9 @@ ActionProfileResourceCapacity GetActionProfileResourceCapacity(
 
 absl::StatusOr<sonic::TableResources> VerifyCapacityAndGetTableResourceChange(
     const pdpi::IrP4Info& ir_p4info, const sonic::AppDbEntry& app_db_entry,
-    const absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity>& entity_cache,
-    const absl::flat_hash_map<std::string, ActionProfileResourceCapacity>&
-        capacity_by_action_profile_name,
-    absl::flat_hash_map<std::string, int64_t>& current_batch_resources) {
+    const EntityCache& entity_cache,
+    const ActionProfileCapacityMap& capacity_by_action_profile_id,
+    absl::flat_hash_map<uint32_t, int64_t>& current_batch_resources) {
   sonic::TableResources resources;
   // This function currently only applies to table entries.
   if (app_db_entry.entry.entity_case() != pdpi::IrEntity::kTableEntry) {
@@ -174,15 +193,16 @@ absl::StatusOr<sonic::TableResources> VerifyCapacityAndGetTableResourceChange(
   // entry.
   if (app_db_entry.update_type == p4::v1::Update::MODIFY ||
       app_db_entry.update_type == p4::v1::Update::DELETE) {
-    const auto* cache_entry =
-        gutil::FindOrNull(entity_cache, app_db_entry.entity_key);
-    if (cache_entry == nullptr) {
+    std::optional<p4::v1::Entity> cache_entry =
+        entity_cache.Find(app_db_entry.entity_key);
+    if (!cache_entry.has_value()) {
       return gutil::NotFoundErrorBuilder() << "[P4RT App] Could not find cache "
                                               "entry for resource accounting.";
     }
     absl::StatusOr<sonic::TableResources> cache_resources =
-        GetResourceUsageForPiTableEntry(ir_p4info,
-                                        (*cache_entry).table_entry());
+        GetResourceUsageForCachedTableEntry(ir_p4info, entity_cache,
+                                            app_db_entry.entity_key,
+                                            cache_entry->table_entry());
     if (!cache_resources.ok()) {
       LOG(WARNING) << "Could not get cached entry's resources: "
                    << cache_resources.status();
@@ -208,6 +228,7 @@ absl::StatusOr<sonic::TableResources> VerifyCapacityAndGetTableResourceChange(
     if (!resources.action_profile.has_value()) {
       resources.action_profile = sonic::ActionProfileResources{
           .name = old_resources->action_profile->name,
+          .id = old_resources->action_profile->id,
       };
     }
     resources.action_profile->number_of_actions -=
@@ -220,8 +241,8 @@ absl::StatusOr<sonic::TableResources> VerifyCapacityAndGetTableResourceChange(
   // not exceed the reserved amount.
   if (resources.action_profile.has_value()) {
     const std::string& profile_name = resources.action_profile->name;
-    const auto* current_capacity =
-        gutil::FindOrNull(capacity_by_action_profile_name, profile_name);
+    const ActionProfileResourceCapacity* current_capacity = gutil::FindOrNull(
+        capacity_by_action_profile_id, resources.action_profile->id);
     if (current_capacity == nullptr) {
       LOG(WARNING) << "Could not find the current ActionProfile capcity for '"
                    << profile_name << "'";
@@ -239,7 +260,7 @@ absl::StatusOr<sonic::TableResources> VerifyCapacityAndGetTableResourceChange(
 
     int64_t projected_utilization =
         current_capacity->current_utilization +
-        current_batch_resources[resources.action_profile->name] +
+        current_batch_resources[resources.action_profile->id] +
         resources.action_profile->total_weight;
     if (projected_utilization > current_capacity->max_weight_for_all_groups) {
       return gutil::ResourceExhaustedErrorBuilder()
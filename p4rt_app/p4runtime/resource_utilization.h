@@ -22,6 +22,7 @@
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/entity_keys.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
 #include "p4rt_app/sonic/app_db_manager.h"
 
 namespace p4rt_app {
@@ -45,6 +46,8 @@ absl::StatusOr<sonic::TableResources> GetResourceUsageForPiTableEntry(
 // by a selector (e.g. hash). These selectors can place hard limits on the
 // profile that need to be enforced.
 struct ActionProfileResourceCapacity {
+  // The action profile's alias, used when reporting its utilization.
+  std::string name;
   int32_t max_group_size = 0;
   int64_t max_weight_for_all_groups = 0;
 
@@ -53,6 +56,10 @@ struct ActionProfileResourceCapacity {
   int64_t current_utilization = 0;
 };
 
+// Resource capacity for every action profile keyed by its P4Info ID.
+using ActionProfileCapacityMap =
+    absl::flat_hash_map<uint32_t, ActionProfileResourceCapacity>;
+
 // Parses an IrActionProfileDefinition for resource capacity information.
 ActionProfileResourceCapacity GetActionProfileResourceCapacity(
     const pdpi::IrActionProfileDefinition& action_profile_def);
@@ -62,7 +69,8 @@ ActionProfileResourceCapacity GetActionProfileResourceCapacity(
 // positive). For deletes the resource usage will depend on the entry being
 // removed from the table cache (i.e. always negative). For modifies the
 // resource usage will be the difference between the new and old entry (i.e. may
-// use more or fewer resources).
+// use more or fewer resources). The old entry's usage comes from the cache, so
+// only the new entry's action set is walked.
 //
 // When determining if a request has enough space we need to take into
 // consideration all the requests that came before it in the batch (i.e.
@@ -72,10 +80,9 @@ ActionProfileResourceCapacity GetActionProfileResourceCapacity(
 // SumOfActions selectors.
 absl::StatusOr<sonic::TableResources> VerifyCapacityAndGetTableResourceChange(
     const pdpi::IrP4Info& ir_p4info, const sonic::AppDbEntry& app_db_entry,
-    const absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity>& entity_cache,
-    const absl::flat_hash_map<std::string, ActionProfileResourceCapacity>&
-        capacity_by_action_profile_name,
-    absl::flat_hash_map<std::string, int64_t>& current_batch_resources);
+    const EntityCache& entity_cache,
+    const ActionProfileCapacityMap& capacity_by_action_profile_id,
+    absl::flat_hash_map<uint32_t, int64_t>& current_batch_resources);
 
 }  // namespace p4rt_app
 
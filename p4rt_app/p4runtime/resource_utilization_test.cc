@@ -31,6 +31,7 @@
 #include "p4_pdpi/entity_keys.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
 #include "p4rt_app/sonic/app_db_manager.h"
 #include "sai_p4/instantiations/google/instantiations.h"
 #include "sai_p4/instantiations/google/sai_p4info.h"
@@ -40,7 +41,8 @@ namespace sonic {
 
 // Pretty print function to help clarify failed expectations.
 void PrintTo(const ActionProfileResources& resource, std::ostream* os) {
-  *os << "name:" << resource.name << " actions:" << resource.number_of_actions
+  *os << "name:" << resource.name << " id:" << resource.id
+      << " actions:" << resource.number_of_actions
       << " total_weight:" << resource.total_weight;
 }
 
@@ -91,6 +93,11 @@ class ResourceUtilizationTest : public testing::Test {
       sai::GetIrP4Info(sai::Instantiation::kMiddleblock);
   std::string wcmp_table_name_ = "wcmp_group_table";
   std::string wcmp_selector_name_ = "wcmp_group_selector";
+  uint32_t wcmp_selector_id_ = ir_p4info_.action_profiles_by_name()
+                                   .at(wcmp_selector_name_)
+                                   .action_profile()
+                                   .preamble()
+                                   .id();
 };
 
 TEST_F(ResourceUtilizationTest, IgnoresTableEntriesWithoutActionProfiles) {
@@ -156,10 +163,12 @@ TEST_F(ResourceUtilizationTest, CountsWcmpActionsAndWeights) {
                            ir_p4info_, table_entries.pi_table_entry));
 
   EXPECT_THAT(ir_resources.action_profile,
-              Optional(FieldsAre(wcmp_selector_name_, /*number_of_actions=*/2,
+              Optional(FieldsAre(wcmp_selector_name_, wcmp_selector_id_,
+                                 /*number_of_actions=*/2,
                                  /*total_weight=*/3)));
   EXPECT_THAT(pi_resources.action_profile,
-              Optional(FieldsAre(wcmp_selector_name_, /*number_of_actions=*/2,
+              Optional(FieldsAre(wcmp_selector_name_, wcmp_selector_id_,
+                                 /*number_of_actions=*/2,
                                  /*total_weight=*/3)));
 }
 
@@ -263,17 +272,16 @@ absl::StatusOr<sonic::AppDbEntry> GetAppDbEntry(
 class GetTableResourceChangeTest : public ResourceUtilizationTest {
  protected:
   GetTableResourceChangeTest() : ResourceUtilizationTest() {
-    for (const auto& [action_profile_name, action_profile_def] :
-         ir_p4info_.action_profiles_by_name()) {
-      capacity_by_action_profile_name_[action_profile_name] =
+    for (const auto& [action_profile_id, action_profile_def] :
+         ir_p4info_.action_profiles_by_id()) {
+      capacity_by_action_profile_id_[action_profile_id] =
           GetActionProfileResourceCapacity(action_profile_def);
     }
   }
 
-  absl::flat_hash_map<pdpi::EntityKey, p4::v1::Entity> entity_cache_;
-  absl::flat_hash_map<std::string, ActionProfileResourceCapacity>
-      capacity_by_action_profile_name_;
-  absl::flat_hash_map<std::string, int64_t> resources_in_current_batch_;
+  EntityCache entity_cache_;
+  ActionProfileCapacityMap capacity_by_action_profile_id_;
+  absl::flat_hash_map<uint32_t, int64_t> resources_in_current_batch_;
 };
 
 TEST_F(GetTableResourceChangeTest, CanGetInsertResources) {
@@ -314,11 +322,12 @@ TEST_F(GetTableResourceChangeTest, CanGetInsertResources) {
       sonic::TableResources resources,
       VerifyCapacityAndGetTableResourceChange(
           ir_p4info_, app_db_entry, entity_cache_,
-          capacity_by_action_profile_name_, resources_in_current_batch_));
+          capacity_by_action_profile_id_, resources_in_current_batch_));
 
   EXPECT_THAT(resources.name, wcmp_table_name_);
   EXPECT_THAT(resources.action_profile,
-              Optional(FieldsAre(wcmp_selector_name_, /*number_of_actions=*/2,
+              Optional(FieldsAre(wcmp_selector_name_, wcmp_selector_id_,
+                                 /*number_of_actions=*/2,
                                  /*total_weight=*/3)));
 }
 
@@ -358,31 +367,31 @@ TEST_F(GetTableResourceChangeTest, CanGetModifyResources) {
 
   // The "old" entry that we will be modifying should have 1 action with a
   // weight of 3.
-  auto [cache_entry, table_entry_cache_success] =
-      entity_cache_.insert({app_db_entry.entity_key, app_db_entry.pi_entity});
-  ASSERT_TRUE(table_entry_cache_success);
-  cache_entry->second.mutable_table_entry()
+  p4::v1::Entity cache_entry = app_db_entry.pi_entity;
+  cache_entry.mutable_table_entry()
       ->mutable_action()
       ->mutable_action_profile_action_set()
       ->mutable_action_profile_actions(0)
       ->set_weight(3);
-  cache_entry->second.mutable_table_entry()
+  cache_entry.mutable_table_entry()
       ->mutable_action()
       ->mutable_action_profile_action_set()
       ->mutable_action_profile_actions()
       ->RemoveLast();
+  entity_cache_.InsertOrAssign(app_db_entry.entity_key, cache_entry);
 
   ASSERT_OK_AND_ASSIGN(
       sonic::TableResources resources,
       VerifyCapacityAndGetTableResourceChange(
           ir_p4info_, app_db_entry, entity_cache_,
-          capacity_by_action_profile_name_, resources_in_current_batch_));
+          capacity_by_action_profile_id_, resources_in_current_batch_));
 
   // This modify is changing from 1 action and a weight of 3 to 2 actions with a
   // total weight of 2. So we gain 1 group, and lose 1 weight.
   EXPECT_THAT(resources.name, wcmp_table_name_);
   EXPECT_THAT(resources.action_profile,
-              Optional(FieldsAre(wcmp_selector_name_, /*number_of_actions=*/1,
+              Optional(FieldsAre(wcmp_selector_name_, wcmp_selector_id_,
+                                 /*number_of_actions=*/1,
                                  /*total_weight=*/-1)));
 }
 
@@ -421,19 +430,19 @@ TEST_F(GetTableResourceChangeTest, CanGetDeleteResources) {
                                        })pb"));
 
   // Insert the entry into the cache so we can delete it.
-  auto [cache_entry, table_entry_cache_success] =
-      entity_cache_.insert({app_db_entry.entity_key, app_db_entry.pi_entity});
-  ASSERT_TRUE(table_entry_cache_success);
+  entity_cache_.InsertOrAssign(app_db_entry.entity_key,
+                               app_db_entry.pi_entity);
 
   ASSERT_OK_AND_ASSIGN(
       sonic::TableResources resources,
       VerifyCapacityAndGetTableResourceChange(
           ir_p4info_, app_db_entry, entity_cache_,
-          capacity_by_action_profile_name_, resources_in_current_batch_));
+          capacity_by_action_profile_id_, resources_in_current_batch_));
 
   EXPECT_THAT(resources.name, wcmp_table_name_);
   EXPECT_THAT(resources.action_profile,
-              Optional(FieldsAre(wcmp_selector_name_, /*number_of_actions=*/-2,
+              Optional(FieldsAre(wcmp_selector_name_, wcmp_selector_id_,
+                                 /*number_of_actions=*/-2,
                                  /*total_weight=*/-7)));
 }
 
@@ -466,7 +475,7 @@ TEST_F(GetTableResourceChangeTest, InvalidTableNameFails) {
   EXPECT_THAT(
       VerifyCapacityAndGetTableResourceChange(
           ir_p4info_, app_db_entry, entity_cache_,
-          capacity_by_action_profile_name_, resources_in_current_batch_),
+          capacity_by_action_profile_id_, resources_in_current_batch_),
       StatusIs(absl::StatusCode::kInvalidArgument,
                HasSubstr("Could not get table resources")));
 }
@@ -496,15 +505,14 @@ TEST_F(GetTableResourceChangeTest, InvalidCacheEntryFails) {
                                        })pb"));
 
   // Invalidate the cached table entry.
-  auto [cache_entry, table_entry_cache_success] =
-      entity_cache_.insert({app_db_entry.entity_key, app_db_entry.pi_entity});
-  ASSERT_TRUE(table_entry_cache_success);
-  cache_entry->second.mutable_table_entry()->set_table_id(0);
+  p4::v1::Entity cache_entry = app_db_entry.pi_entity;
+  cache_entry.mutable_table_entry()->set_table_id(0);
+  entity_cache_.InsertOrAssign(app_db_entry.entity_key, cache_entry);
 
   EXPECT_THAT(
       VerifyCapacityAndGetTableResourceChange(
           ir_p4info_, app_db_entry, entity_cache_,
-          capacity_by_action_profile_name_, resources_in_current_batch_),
+          capacity_by_action_profile_id_, resources_in_current_batch_),
       StatusIs(absl::StatusCode::kNotFound,
                HasSubstr("Could not get resources for cached table entry")));
 }
@@ -533,12 +541,12 @@ TEST_F(GetTableResourceChangeTest, NoExistingResourceCapacityFails) {
                                          }
                                        })pb"));
 
-  capacity_by_action_profile_name_.clear();
+  capacity_by_action_profile_id_.clear();
 
   EXPECT_THAT(
       VerifyCapacityAndGetTableResourceChange(
           ir_p4info_, app_db_entry, entity_cache_,
-          capacity_by_action_profile_name_, resources_in_current_batch_),
+          capacity_by_action_profile_id_, resources_in_current_batch_),
       StatusIs(absl::StatusCode::kNotFound,
                HasSubstr("Could not get the current capacity data for")));
 }
@@ -568,14 +576,14 @@ TEST_F(GetTableResourceChangeTest, ConsidersOtherRequestsIntheBatch) {
                                        })pb"));
 
   // Set the utilization for everything to full.
-  for (auto& [name, capacity] : capacity_by_action_profile_name_) {
+  for (auto& [name, capacity] : capacity_by_action_profile_id_) {
     capacity.current_utilization = capacity.max_weight_for_all_groups;
   }
 
   EXPECT_THAT(
       VerifyCapacityAndGetTableResourceChange(
           ir_p4info_, app_db_entry, entity_cache_,
-          capacity_by_action_profile_name_, resources_in_current_batch_),
+          capacity_by_action_profile_id_, resources_in_current_batch_),
       StatusIs(absl::StatusCode::kResourceExhausted,
                HasSubstr("not enough resources to fit in")));
 }
@@ -625,14 +633,14 @@ TEST_F(GetTableResourceChangeTest, RejectsRequestsWithTooManyActions) {
                                        })pb"));
 
   // Set the max group size to 2.
-  for (auto& [name, capacity] : capacity_by_action_profile_name_) {
+  for (auto& [name, capacity] : capacity_by_action_profile_id_) {
     capacity.max_group_size = 2;
   }
 
   EXPECT_THAT(
       VerifyCapacityAndGetTableResourceChange(
           ir_p4info_, app_db_entry, entity_cache_,
-          capacity_by_action_profile_name_, resources_in_current_batch_),
+          capacity_by_action_profile_id_, resources_in_current_batch_),
       StatusIs(absl::StatusCode::kResourceExhausted,
                HasSubstr("max allowed is 2, but got 3")));
 }
@@ -654,7 +662,7 @@ TEST_F(GetTableResourceChangeTest, PacketReplicationEntriesIgnored) {
       sonic::TableResources resources,
       VerifyCapacityAndGetTableResourceChange(
           ir_p4info_, app_db_entry, entity_cache_,
-          capacity_by_action_profile_name_, resources_in_current_batch_));
+          capacity_by_action_profile_id_, resources_in_current_batch_));
 
   EXPECT_EQ(resources.name, "");
   EXPECT_EQ(resources.action_profile, std::nullopt);
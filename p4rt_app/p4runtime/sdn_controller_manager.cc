@@ -14,7 +14,10 @@
 #include "p4rt_app/p4runtime/sdn_controller_manager.h"
 
 #include <cstdint>
+#include <memory>
 #include <optional>
+#include <string>
+#include <utility>
 
 #include "absl/numeric/int128.h"
 #include "absl/status/status.h"
@@ -25,6 +28,7 @@
 #include "gutil/collections.h"
 #include "gutil/status.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4rt_app/utils/lock_contention.h"
 
 namespace p4rt_app {
 namespace {
@@ -86,6 +90,38 @@ grpc::Status VerifyElectionIdIsActive(
 
 }  // namespace
 
+SdnConnection::SdnConnection(
+    grpc::ServerContext* context,
+    grpc::ServerReaderWriter<p4::v1::StreamMessageResponse,
+                             p4::v1::StreamMessageRequest>* stream,
+    int max_queued_packet_ins)
+    : SdnConnection(
+          context->peer(),
+          [stream](const p4::v1::StreamMessageResponse& response) {
+            return stream->Write(response);
+          },
+          max_queued_packet_ins) {}
+
+SdnConnection::SdnConnection(std::string peer,
+                             ResponseWriter::WriteFunction write_function,
+                             int max_queued_packet_ins)
+    : initialized_(false), peer_(std::move(peer)) {
+  writer_ = std::make_shared<ResponseWriter>(
+      [peer = peer_, write_function = std::move(write_function)](
+          const p4::v1::StreamMessageResponse& response) {
+        VLOG(2) << "Sending response: " << response.ShortDebugString();
+        if (!write_function(response)) {
+          LOG(ERROR) << "Could not send stream message response to peer '"
+                     << peer << "': " << response.ShortDebugString();
+          return false;
+        }
+        return true;
+      },
+      max_queued_packet_ins);
+}
+
+SdnConnection::~SdnConnection() { CloseStream(); }
+
 void SdnConnection::SetElectionId(const std::optional<absl::uint128>& id) {
   election_id_ = id;
 }
@@ -104,16 +140,15 @@ std::optional<std::string> SdnConnection::GetRoleName() const {
 
 void SdnConnection::SendStreamMessageResponse(
     const p4::v1::StreamMessageResponse& response) {
-  VLOG(2) << "Sending response: " << response.ShortDebugString();
-  if (!grpc_stream_->Write(response)) {
-    LOG(ERROR) << "Could not send arbitration update response to gRPC conext '"
-               << grpc_context_ << "': " << response.ShortDebugString();
+  if (!writer_->WriteReliably(response)) {
+    LOG(WARNING) << "Dropping stream message response to closed stream for '"
+                 << peer_ << "': " << response.ShortDebugString();
   }
 }
 
 grpc::Status SdnControllerManager::HandleArbitrationUpdate(
     const p4::v1::MasterArbitrationUpdate& update, SdnConnection* controller) {
-  absl::MutexLock l(&lock_);
+  ProfiledMutexLock l(&lock_, &lock_contention_);
 
   // If the Device ID has not been set then we don't allow any connections.
   if (!device_id_.has_value()) {
@@ -241,11 +276,12 @@ grpc::Status SdnControllerManager::HandleArbitrationUpdate(
                 << PrettyPrintElectionId(new_election_id_for_connection);
     }
   }
+  UpdatePacketInRouting();
   return grpc::Status::OK;
 }
 
 void SdnControllerManager::Disconnect(SdnConnection* connection) {
-  absl::MutexLock l(&lock_);
+  ProfiledMutexLock l(&lock_, &lock_contention_);
 
   // If the connection was never initialized then there is no work needed to
   // disconnect it.
@@ -270,10 +306,11 @@ void SdnControllerManager::Disconnect(SdnConnection* connection) {
        election_id_past_by_role_[connection->GetRoleName()])) {
     InformConnectionsAboutPrimaryChange(connection->GetRoleName());
   }
+  UpdatePacketInRouting();
 }
 
 absl::Status SdnControllerManager::SetDeviceId(uint64_t device_id) {
-  absl::MutexLock l(&lock_);
+  ProfiledMutexLock l(&lock_, &lock_contention_);
 
   // Ignore no-ops on Device ID values.
   if (device_id_.has_value() && *device_id_ == device_id) {
@@ -305,7 +342,7 @@ absl::Status SdnControllerManager::SetDeviceId(uint64_t device_id) {
 }
 
 std::optional<uint64_t> SdnControllerManager::GetDeviceId() const {
-  absl::MutexLock l(&lock_);
+  ProfiledMutexLock l(&lock_, &lock_contention_);
   return device_id_;
 }
 
@@ -313,7 +350,7 @@ grpc::Status SdnControllerManager::AllowMutableRequest(
     const std::optional<uint64_t>& device_id,
     const std::optional<std::string>& role_name,
     const std::optional<absl::uint128>& election_id) const {
-  absl::MutexLock l(&lock_);
+  ProfiledMutexLock l(&lock_, &lock_contention_);
 
   // Both the switch and request must have a device ID, and they must match
   // before we allow the request to mutate state.
@@ -349,7 +386,7 @@ grpc::Status SdnControllerManager::AllowMutableRequest(
 
 grpc::Status SdnControllerManager::AllowNonMutableRequest(
     const std::optional<uint64_t>& device_id) const {
-  absl::MutexLock l(&lock_);
+  ProfiledMutexLock l(&lock_, &lock_contention_);
 
   // Both the switch and request must have a device ID, and they must match
   // before we allow a request to read any state.
@@ -517,27 +554,35 @@ absl::Status SdnControllerManager::SendPacketInToPrimary(
   return SendStreamMessageToPrimary(response);
 }
 
-absl::Status SdnControllerManager::SendStreamMessageToPrimary(
-    const p4::v1::StreamMessageResponse& response) {
-  absl::MutexLock l(&lock_);
-
-  bool found_at_least_one_primary = false;
-
+void SdnControllerManager::UpdatePacketInRouting() {
+  auto routing = std::make_shared<PacketInRouting>();
   for (const auto& connection : connections_) {
     auto role_name = connection->GetRoleName();
+    if (!role_receives_packet_in_.contains(role_name)) continue;
 
     auto primary_id_by_role_name = gutil::FindOrDefault(
         election_id_past_by_role_, role_name, std::nullopt);
     if (primary_id_by_role_name.has_value() &&
         primary_id_by_role_name == connection->GetElectionId()) {
-      if (role_receives_packet_in_.contains(role_name)) {
-        found_at_least_one_primary = true;
-        connection->SendStreamMessageResponse(response);
-      }
+      routing->push_back(connection->GetResponseWriter());
     }
   }
 
-  if (!found_at_least_one_primary) {
+  absl::MutexLock l(&routing_lock_);
+  packet_in_primaries_ = std::move(routing);
+}
+
+absl::Status SdnControllerManager::SendStreamMessageToPrimary(
+    const p4::v1::StreamMessageResponse& response) {
+  // Only the routing snapshot is read under a lock. The writers never block on
+  // their gRPC streams, so a slow controller cannot stall the PacketIn path.
+  std::shared_ptr<const PacketInRouting> primaries;
+  {
+    absl::MutexLock l(&routing_lock_);
+    primaries = packet_in_primaries_;
+  }
+
+  if (primaries->empty()) {
     LOG_EVERY_T(WARNING, 30)
         << "Cannot send stream message response because there is no "
         << "active primary connection: " << response.ShortDebugString();
@@ -545,6 +590,17 @@ absl::Status SdnControllerManager::SendStreamMessageToPrimary(
            << "No active role has a primary connection configured to receive "
               "PacketIn messages.";
   }
+
+  bool queued_for_at_least_one_primary = false;
+  for (const auto& writer : *primaries) {
+    if (writer->Write(response)) queued_for_at_least_one_primary = true;
+  }
+  if (!queued_for_at_least_one_primary) {
+    LOG_EVERY_T(WARNING, 30)
+        << "Dropping PacketIn because no primary connection is keeping up.";
+    return gutil::ResourceExhaustedErrorBuilder()
+           << "Every primary connection has too many PacketIns queued.";
+  }
   return absl::OkStatus();
 }
 
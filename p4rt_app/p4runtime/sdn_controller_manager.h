@@ -17,39 +17,84 @@
 #define PINS_P4RT_APP_P4RUNTIME_SDN_CONTROLLER_MANAGER_H_
 
 #include <cstdint>
+#include <memory>
 #include <optional>
+#include <string>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/numeric/int128.h"
 #include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4rt_app/utils/bounded_stream_writer.h"
+#include "p4rt_app/utils/lock_contention.h"
 #include "sai_p4/fixed/roles.h"
 
 namespace p4rt_app {
 
 // A connection between a controller and p4rt server.
+//
+// Responses are written to the gRPC stream by a writer thread owned by the
+// connection, so a controller that stops reading only ever stalls its own
+// stream.
 class SdnConnection {
  public:
+  using ResponseWriter = BoundedStreamWriter<p4::v1::StreamMessageResponse>;
+
+  // Max number of PacketIns waiting to be written to the stream before new
+  // ones are dropped.
+  static constexpr int kDefaultMaxQueuedPacketIns = 1024;
+
   SdnConnection(grpc::ServerContext* context,
                 grpc::ServerReaderWriter<p4::v1::StreamMessageResponse,
-                                         p4::v1::StreamMessageRequest>* stream)
-      : initialized_(false), grpc_context_(context), grpc_stream_(stream) {}
+                                         p4::v1::StreamMessageRequest>* stream,
+                int max_queued_packet_ins = kDefaultMaxQueuedPacketIns);
+
+  // Connection for a stream that is not a sync ServerReaderWriter (e.g. a
+  // callback reactor). `write_function` is only ever called from the
+  // connection's writer thread, one response at a time.
+  SdnConnection(std::string peer, ResponseWriter::WriteFunction write_function,
+                int max_queued_packet_ins = kDefaultMaxQueuedPacketIns);
+
+  // Closes the stream writer.
+  ~SdnConnection();
+
+  SdnConnection(const SdnConnection&) = delete;
+  SdnConnection& operator=(const SdnConnection&) = delete;
 
   void Initialize() { initialized_ = true; }
   bool IsInitialized() const { return initialized_; }
 
+  const std::string& GetPeer() const { return peer_; }
+
   void SetElectionId(const std::optional<absl::uint128>& id);
   std::optional<absl::uint128> GetElectionId() const;
 
   void SetRoleName(const std::optional<std::string>& name);
   std::optional<std::string> GetRoleName() const;
 
-  // Sends back StreamMessageResponse to this controller.
+  // Queues a StreamMessageResponse for this controller. Responses sent this
+  // way (e.g. arbitration updates and errors) are never dropped while the
+  // connection is open.
   void SendStreamMessageResponse(const p4::v1::StreamMessageResponse& response);
 
+  // The writer is shared so PacketIns can be routed to it without holding any
+  // SdnControllerManager lock. It drops PacketIns when its queue is full.
+  std::shared_ptr<ResponseWriter> GetResponseWriter() const { return writer_; }
+
+  // Writes any queued responses, and stops writing to the stream. Must be
+  // called before the gRPC stream goes out of scope.
+  void CloseStream() { writer_->Close(); }
+
+  // Per-connection write, drop, and queue depth counters.
+  ResponseWriter::Counters GetStreamCounters() const {
+    return writer_->GetCounters();
+  }
+
  private:
   // The SDN connection should be initialized through arbitration before it can
   // be used.
@@ -66,12 +111,11 @@ class SdnConnection {
   // connection is determined based on the election ID.
   std::optional<absl::uint128> election_id_;
 
-  // While the gRPC connection is open we keep access to the context & the
-  // read/write stream for communication.
-  grpc::ServerContext* grpc_context_;  // not owned.
-  grpc::ServerReaderWriter<p4::v1::StreamMessageResponse,
-                           p4::v1::StreamMessageRequest>*
-      grpc_stream_;  // not owned.
+  // The controller's gRPC peer address, for logging.
+  std::string peer_;
+
+  // Owns the only thread that writes to the gRPC stream.
+  std::shared_ptr<ResponseWriter> writer_;
 };
 
 class SdnControllerManager {
@@ -111,6 +155,11 @@ class SdnControllerManager {
   absl::Status SendPacketInToPrimary(
       const p4::v1::StreamMessageResponse& response);
 
+  // Returns how often, and how long, threads waited on `lock_`.
+  LockContentionStats GetLockContention() const {
+    return lock_contention_.GetStats();
+  }
+
  private:
   // Goes through the current list of active connections, and returns if one of
   // them is currently the primary.
@@ -130,8 +179,14 @@ class SdnControllerManager {
   void SendArbitrationResponse(SdnConnection* connection)
       ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
 
+  // Republishes `packet_in_primaries_` after the set of connections, or their
+  // election IDs, have changed.
+  void UpdatePacketInRouting() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_)
+      ABSL_LOCKS_EXCLUDED(routing_lock_);
+
   // Lock for protecting SdnControllerManager member fields.
   mutable absl::Mutex lock_;
+  mutable LockContentionCounter lock_contention_;
 
   // Device ID is used to ensure all requests are connecting to the intended
   // place.
@@ -175,6 +230,15 @@ class SdnControllerManager {
       P4RUNTIME_ROLE_SDN_CONTROLLER,
       std::nullopt,  // default role
   };
+
+  // Writers for the primary connection of every role that receives PacketIns.
+  // The list is immutable once published, so the PacketIn path only holds
+  // `routing_lock_` long enough to copy the pointer, and never takes `lock_`.
+  using PacketInRouting =
+      std::vector<std::shared_ptr<SdnConnection::ResponseWriter>>;
+  mutable absl::Mutex routing_lock_ ABSL_ACQUIRED_AFTER(lock_);
+  std::shared_ptr<const PacketInRouting> packet_in_primaries_
+      ABSL_GUARDED_BY(routing_lock_) = std::make_shared<PacketInRouting>();
 };
 
 }  // namespace p4rt_app
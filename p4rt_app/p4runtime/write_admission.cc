@@ -0,0 +1,114 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/p4runtime/write_admission.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "gutil/status.h"
+
+namespace p4rt_app {
+namespace {
+
+// Weight of the newest sample in the OrchAgent latency moving average.
+constexpr double kLatencySmoothing = 0.2;
+
+// Controllers are never told to retry sooner than this.
+constexpr absl::Duration kMinRetryAfter = absl::Milliseconds(10);
+
+}  // namespace
+
+absl::Status WriteAdmissionController::Admit(int64_t num_updates,
+                                             absl::Duration& retry_after) {
+  absl::MutexLock l(&lock_);
+  absl::Status status = Check(num_updates);
+  if (!status.ok() && options_.max_wait > absl::ZeroDuration()) {
+    struct Waiter {
+      const WriteAdmissionController* controller;
+      int64_t num_updates;
+    } waiter{this, num_updates};
+    lock_.AwaitWithTimeout(
+        absl::Condition(
+            +[](Waiter* waiter) {
+              waiter->controller->lock_.AssertHeld();
+              return waiter->controller->Check(waiter->num_updates).ok();
+            },
+            &waiter),
+        options_.max_wait);
+    status = Check(num_updates);
+  }
+  if (!status.ok()) {
+    ++stats_.rejected_batches;
+    retry_after = RetryAfter();
+    return status;
+  }
+  ++stats_.outstanding_batches;
+  stats_.outstanding_updates += num_updates;
+  return absl::OkStatus();
+}
+
+void WriteAdmissionController::Release(int64_t num_updates) {
+  absl::MutexLock l(&lock_);
+  --stats_.outstanding_batches;
+  stats_.outstanding_updates -= num_updates;
+}
+
+void WriteAdmissionController::RecordOrchAgentLatency(absl::Duration latency) {
+  absl::MutexLock l(&lock_);
+  if (stats_.orch_agent_latency == absl::ZeroDuration()) {
+    stats_.orch_agent_latency = latency;
+    return;
+  }
+  stats_.orch_agent_latency = stats_.orch_agent_latency *
+                                  (1 - kLatencySmoothing) +
+                              latency * kLatencySmoothing;
+}
+
+WriteAdmissionController::Stats WriteAdmissionController::GetStats() const {
+  absl::MutexLock l(&lock_);
+  return stats_;
+}
+
+absl::Status WriteAdmissionController::Check(int64_t num_updates) const {
+  if (stats_.outstanding_batches == 0) return absl::OkStatus();
+
+  if (options_.max_outstanding_updates > 0 &&
+      stats_.outstanding_updates + num_updates >
+          options_.max_outstanding_updates) {
+    return gutil::ResourceExhaustedErrorBuilder()
+           << "The switch is busy programming " << stats_.outstanding_updates
+           << " updates from " << stats_.outstanding_batches
+           << " Write requests. Retry after "
+           << absl::ToInt64Milliseconds(RetryAfter()) << "ms.";
+  }
+  if (options_.max_orch_agent_latency > absl::ZeroDuration() &&
+      stats_.orch_agent_latency > options_.max_orch_agent_latency) {
+    return gutil::UnavailableErrorBuilder()
+           << "The OrchAgent is responding slowly ("
+           << absl::ToInt64Milliseconds(stats_.orch_agent_latency)
+           << "ms per batch). Retry after "
+           << absl::ToInt64Milliseconds(RetryAfter()) << "ms.";
+  }
+  return absl::OkStatus();
+}
+
+absl::Duration WriteAdmissionController::RetryAfter() const {
+  return std::max(kMinRetryAfter,
+                  stats_.orch_agent_latency * stats_.outstanding_batches);
+}
+
+}  // namespace p4rt_app
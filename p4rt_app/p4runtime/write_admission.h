@@ -0,0 +1,107 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PINS_P4RT_APP_P4RUNTIME_WRITE_ADMISSION_H_
+#define PINS_P4RT_APP_P4RUNTIME_WRITE_ADMISSION_H_
+
+#include <cstdint>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace p4rt_app {
+
+// Trailing metadata of Write responses rejected by admission control. Holds
+// how long the controller should wait before retrying, in milliseconds.
+inline constexpr char kWriteRetryAfterMetadataKey[] =
+    "p4rt-write-retry-after-ms";
+
+struct WriteAdmissionOptions {
+  // Writes are rejected with RESOURCE_EXHAUSTED while this many updates are
+  // already admitted, i.e. waiting to be programmed or waiting on the
+  // OrchAgent. A batch is always admitted when nothing else is outstanding.
+  // Disabled when 0.
+  int64_t max_outstanding_updates = 0;
+  // Writes are rejected with UNAVAILABLE while other writes are outstanding,
+  // and the recent OrchAgent response latency is above this. Disabled when
+  // zero.
+  absl::Duration max_orch_agent_latency = absl::ZeroDuration();
+  // How long a write may wait for the above limits to clear before it is
+  // rejected.
+  absl::Duration max_wait = absl::ZeroDuration();
+};
+
+// Admission control for Write() requests. When the OrchAgent falls behind,
+// writes would otherwise keep queueing on the server's locks until they time
+// out. Instead, every batch is admitted here first, and rejected with a retry
+// hint once too many updates are outstanding, or the OrchAgent is responding
+// slowly. Controllers can then back off and retry.
+//
+// The OrchAgent latency is a moving average of the per-batch response waits,
+// so a single slow batch does not reject writes. The latency limit only
+// applies while other writes are outstanding, so an idle switch always admits
+// the next batch, which in turn measures whether the OrchAgent has caught up.
+//
+// Thread-safe.
+class WriteAdmissionController {
+ public:
+  struct Stats {
+    // Batches, and their updates, that have been admitted but not released.
+    int64_t outstanding_batches = 0;
+    int64_t outstanding_updates = 0;
+    // Batches rejected since construction.
+    int64_t rejected_batches = 0;
+    // Moving average of the OrchAgent response latency.
+    absl::Duration orch_agent_latency = absl::ZeroDuration();
+  };
+
+  explicit WriteAdmissionController(WriteAdmissionOptions options = {})
+      : options_(options) {}
+
+  // Returns OK if a batch of `num_updates` is admitted, in which case it must
+  // be released once it is done. Otherwise returns RESOURCE_EXHAUSTED or
+  // UNAVAILABLE, and sets `retry_after` to how long the controller should wait
+  // before retrying.
+  absl::Status Admit(int64_t num_updates, absl::Duration& retry_after)
+      ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Releases a batch admitted with `num_updates`.
+  void Release(int64_t num_updates) ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Records how long the OrchAgent took to respond to a batch.
+  void RecordOrchAgentLatency(absl::Duration latency)
+      ABSL_LOCKS_EXCLUDED(lock_);
+
+  Stats GetStats() const ABSL_LOCKS_EXCLUDED(lock_);
+
+ private:
+  // Returns why a batch of `num_updates` cannot be admitted right now, or OK.
+  absl::Status Check(int64_t num_updates) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  // Roughly how long the outstanding batches take to drain.
+  absl::Duration RetryAfter() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  const WriteAdmissionOptions options_;
+
+  mutable absl::Mutex lock_;
+  Stats stats_ ABSL_GUARDED_BY(lock_);
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_P4RUNTIME_WRITE_ADMISSION_H_
@@ -0,0 +1,114 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/p4runtime/write_admission.h"
+
+#include <thread>  // NOLINT: third_party code.
+
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::HasSubstr;
+
+TEST(WriteAdmissionControllerTest, AdmitsEverythingByDefault) {
+  WriteAdmissionController controller;
+  absl::Duration retry_after;
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_OK(controller.Admit(1000, retry_after));
+  }
+  controller.RecordOrchAgentLatency(absl::Minutes(1));
+  EXPECT_OK(controller.Admit(1000, retry_after));
+
+  WriteAdmissionController::Stats stats = controller.GetStats();
+  EXPECT_EQ(stats.outstanding_batches, 11);
+  EXPECT_EQ(stats.outstanding_updates, 11000);
+  EXPECT_EQ(stats.rejected_batches, 0);
+}
+
+TEST(WriteAdmissionControllerTest, RejectsBatchesOverTheOutstandingLimit) {
+  WriteAdmissionController controller({.max_outstanding_updates = 100});
+  absl::Duration retry_after;
+  // A batch is admitted when nothing else is outstanding, even if it alone is
+  // over the limit.
+  ASSERT_OK(controller.Admit(150, retry_after));
+  EXPECT_THAT(controller.Admit(1, retry_after),
+              StatusIs(absl::StatusCode::kResourceExhausted,
+                       HasSubstr("Retry after")));
+  EXPECT_GT(retry_after, absl::ZeroDuration());
+
+  controller.Release(150);
+  ASSERT_OK(controller.Admit(60, retry_after));
+  EXPECT_OK(controller.Admit(40, retry_after));
+  EXPECT_THAT(controller.Admit(1, retry_after),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+
+  WriteAdmissionController::Stats stats = controller.GetStats();
+  EXPECT_EQ(stats.outstanding_batches, 2);
+  EXPECT_EQ(stats.outstanding_updates, 100);
+  EXPECT_EQ(stats.rejected_batches, 2);
+}
+
+TEST(WriteAdmissionControllerTest, RejectsWritesWhileTheOrchAgentIsSlow) {
+  WriteAdmissionController controller(
+      {.max_orch_agent_latency = absl::Seconds(1)});
+  controller.RecordOrchAgentLatency(absl::Seconds(5));
+  absl::Duration retry_after;
+
+  // An idle switch admits the next batch, to measure the OrchAgent again.
+  ASSERT_OK(controller.Admit(1, retry_after));
+  EXPECT_THAT(controller.Admit(1, retry_after),
+              StatusIs(absl::StatusCode::kUnavailable));
+  EXPECT_EQ(retry_after, absl::Seconds(5));
+
+  // A few fast responses bring the moving average back under the limit.
+  for (int i = 0; i < 20; ++i) {
+    controller.RecordOrchAgentLatency(absl::Milliseconds(10));
+  }
+  EXPECT_LT(controller.GetStats().orch_agent_latency, absl::Seconds(1));
+  EXPECT_OK(controller.Admit(1, retry_after));
+}
+
+TEST(WriteAdmissionControllerTest, WaitsForOutstandingWritesToBeReleased) {
+  WriteAdmissionController controller(
+      {.max_outstanding_updates = 10, .max_wait = absl::Seconds(30)});
+  absl::Duration retry_after;
+  ASSERT_OK(controller.Admit(10, retry_after));
+
+  std::thread release([&controller] {
+    absl::SleepFor(absl::Milliseconds(50));
+    controller.Release(10);
+  });
+  EXPECT_OK(controller.Admit(10, retry_after));
+  release.join();
+  EXPECT_EQ(controller.GetStats().rejected_batches, 0);
+}
+
+TEST(WriteAdmissionControllerTest, RejectsAfterWaiting) {
+  WriteAdmissionController controller(
+      {.max_outstanding_updates = 10, .max_wait = absl::Milliseconds(10)});
+  absl::Duration retry_after;
+  ASSERT_OK(controller.Admit(10, retry_after));
+  EXPECT_THAT(controller.Admit(10, retry_after),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+}
+
+}  // namespace
+}  // namespace p4rt_app
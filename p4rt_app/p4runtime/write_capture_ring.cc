@@ -0,0 +1,205 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "p4rt_app/p4runtime/write_capture_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+
+#include "absl/base/internal/endian.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4rt_app/p4runtime/write_capture.pb.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+using ::google::protobuf::io::CodedOutputStream;
+
+constexpr char kCaptureMagic[] = "P4RTCAP1";
+constexpr int kCaptureMagicSize = sizeof(kCaptureMagic) - 1;
+constexpr int64_t kHeaderSize = 64;
+constexpr int64_t kSizeBytes = sizeof(uint32_t);
+constexpr uint32_t kWrapMarker = 0xffffffff;
+constexpr int kMaxVarint32Bytes = 5;
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<WriteCaptureRing>> WriteCaptureRing::Create(
+    const std::string& path, int64_t capacity_bytes) {
+  if (capacity_bytes <= kSizeBytes || capacity_bytes >= kWrapMarker) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Write capture ring capacity must be in (" << kSizeBytes << ", "
+           << kWrapMarker << ") bytes, but got " << capacity_bytes << ".";
+  }
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return gutil::InternalErrorBuilder()
+           << "Could not open write capture ring '" << path
+           << "': " << std::strerror(errno);
+  }
+  if (ftruncate(fd, kHeaderSize + capacity_bytes) != 0) {
+    const int error = errno;
+    close(fd);
+    return gutil::InternalErrorBuilder()
+           << "Could not resize write capture ring '" << path
+           << "': " << std::strerror(error);
+  }
+  void* mapping = mmap(nullptr, kHeaderSize + capacity_bytes,
+                       PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    const int error = errno;
+    close(fd);
+    return gutil::InternalErrorBuilder()
+           << "Could not memory-map write capture ring '" << path
+           << "': " << std::strerror(error);
+  }
+
+  auto ring = std::unique_ptr<WriteCaptureRing>(new WriteCaptureRing(
+      fd, static_cast<char*>(mapping), capacity_bytes));
+  std::memcpy(ring->mapping_, kCaptureMagic, kCaptureMagicSize);
+  absl::little_endian::Store64(ring->mapping_ + 8, capacity_bytes);
+  absl::MutexLock l(&ring->mutex_);
+  ring->WriteHeader();
+  return ring;
+}
+
+WriteCaptureRing::~WriteCaptureRing() {
+  munmap(mapping_, kHeaderSize + capacity_);
+  close(fd_);
+}
+
+void WriteCaptureRing::Record(const p4::v1::WriteRequest& request,
+                              absl::Time start_time, absl::Duration latency,
+                              int grpc_code, absl::string_view grpc_message) {
+  // The request is appended as field `pi` after the other fields, rather than
+  // copied into the message, so it is serialized exactly once.
+  CapturedWrite captured;
+  captured.set_timestamp_request(absl::ToUnixMillis(start_time));
+  captured.set_timestamp_response(absl::ToUnixMillis(start_time + latency));
+  captured.set_latency_us(absl::ToInt64Microseconds(latency));
+  captured.set_grpc_code(grpc_code);
+  captured.set_grpc_message(std::string(grpc_message));
+  const size_t captured_size = captured.ByteSizeLong();
+  const size_t request_size = request.ByteSizeLong();
+  const uint32_t pi_tag = WireFormatLite::MakeTag(
+      CapturedWrite::kPiFieldNumber, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  const int64_t payload_size =
+      captured_size + CodedOutputStream::VarintSize32(pi_tag) +
+      CodedOutputStream::VarintSize32(request_size) + request_size;
+  const int64_t record_size = kSizeBytes + payload_size;
+
+  absl::MutexLock l(&mutex_);
+  if (record_size > capacity_) {
+    ++num_dropped_;
+    return;
+  }
+
+  char* const ring = mapping_ + kHeaderSize;
+  int64_t offset = next_;
+  if (offset + record_size > capacity_) {
+    // The records between `next_` and the end of the ring are the oldest, and
+    // become unreachable from the start of the ring.
+    while (!records_.empty() && records_.front().offset >= next_) {
+      records_.pop_front();
+    }
+    if (capacity_ - offset >= kSizeBytes) {
+      absl::little_endian::Store32(ring + offset, kWrapMarker);
+    }
+    offset = 0;
+  }
+  while (!records_.empty() && records_.front().offset < offset + record_size &&
+         offset < records_.front().offset + records_.front().size) {
+    records_.pop_front();
+  }
+
+  absl::little_endian::Store32(ring + offset, payload_size);
+  uint8_t* target = reinterpret_cast<uint8_t*>(ring + offset + kSizeBytes);
+  target = captured.SerializeWithCachedSizesToArray(target);
+  target = CodedOutputStream::WriteVarint32ToArray(pi_tag, target);
+  target = CodedOutputStream::WriteVarint32ToArray(request_size, target);
+  request.SerializeWithCachedSizesToArray(target);
+
+  records_.push_back({.offset = offset, .size = record_size});
+  next_ = offset + record_size;
+  WriteHeader();
+}
+
+absl::Status WriteCaptureRing::Dump(const std::string& path) const {
+  // Records are copied out while holding the lock, and written to the file
+  // after releasing it so a slow disk does not stall Write() requests.
+  std::string contents;
+  {
+    absl::MutexLock l(&mutex_);
+    for (const RecordLocation& record : records_) {
+      const char* payload = mapping_ + kHeaderSize + record.offset + kSizeBytes;
+      const uint32_t payload_size = record.size - kSizeBytes;
+      uint8_t size_bytes[kMaxVarint32Bytes];
+      const uint8_t* end =
+          CodedOutputStream::WriteVarint32ToArray(payload_size, size_bytes);
+      contents.append(reinterpret_cast<const char*>(size_bytes),
+                      end - size_bytes);
+      contents.append(payload, payload_size);
+    }
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return gutil::InternalErrorBuilder()
+           << "Could not open '" << path
+           << "' for writing: " << std::strerror(errno);
+  }
+  file << contents;
+  file.close();
+  if (file.fail()) {
+    return gutil::InternalErrorBuilder() << "Failed to write '" << path << "'.";
+  }
+  return absl::OkStatus();
+}
+
+int WriteCaptureRing::num_records() const {
+  absl::MutexLock l(&mutex_);
+  return records_.size();
+}
+
+int64_t WriteCaptureRing::num_dropped() const {
+  absl::MutexLock l(&mutex_);
+  return num_dropped_;
+}
+
+void WriteCaptureRing::WriteHeader() {
+  const int64_t oldest = records_.empty() ? next_ : records_.front().offset;
+  absl::little_endian::Store64(mapping_ + 16, oldest);
+  absl::little_endian::Store64(mapping_ + 24, next_);
+  absl::little_endian::Store64(mapping_ + 32, records_.size());
+}
+
+}  // namespace p4rt_app
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PINS_P4RT_APP_P4RUNTIME_WRITE_CAPTURE_RING_H_
+#define PINS_P4RT_APP_P4RUNTIME_WRITE_CAPTURE_RING_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "p4/v1/p4runtime.pb.h"
+
+namespace p4rt_app {
+
+// Keeps the most recent Write() requests, with their timing and status, in a
+// fixed-size memory-mapped file. Each request is serialized once, directly
+// into the mapping, as a `CapturedWrite` (see write_capture.proto); the oldest
+// requests are overwritten once the ring is full. Because the file is mapped
+// shared, the last requests survive a crash of the process.
+//
+// File layout: a 64 byte header (magic, capacity, the offsets of the oldest
+// record and of the next record to write, and the number of records, as
+// little-endian 64-bit integers) followed by the records. A
+// record is a little-endian uint32 size followed by that many bytes. A size of
+// 0xffffffff marks that the next record starts at the beginning of the ring.
+//
+// Thread-safe.
+class WriteCaptureRing {
+ public:
+  // Creates, or truncates, the file at `path` and maps it. The ring holds
+  // `capacity_bytes` of records.
+  static absl::StatusOr<std::unique_ptr<WriteCaptureRing>> Create(
+      const std::string& path, int64_t capacity_bytes);
+
+  WriteCaptureRing(const WriteCaptureRing&) = delete;
+  WriteCaptureRing& operator=(const WriteCaptureRing&) = delete;
+  ~WriteCaptureRing();
+
+  // Records a request received at `start_time` that was answered after
+  // `latency` with the given gRPC status. Requests larger than the ring are
+  // counted in `num_dropped` instead.
+  void Record(const p4::v1::WriteRequest& request, absl::Time start_time,
+              absl::Duration latency, int grpc_code,
+              absl::string_view grpc_message);
+
+  // Writes the captured requests, oldest first, to `path` as length-delimited
+  // `CapturedWrite`s. This is the trace format read by
+  // `p4_fuzzer::ReadWriteTrace`.
+  absl::Status Dump(const std::string& path) const;
+
+  int num_records() const;
+  int64_t num_dropped() const;
+
+ private:
+  struct RecordLocation {
+    // The offset of the record's size, relative to the start of the ring.
+    int64_t offset;
+    // The size of the record, including its size.
+    int64_t size;
+  };
+
+  WriteCaptureRing(int fd, char* mapping, int64_t capacity)
+      : fd_(fd), mapping_(mapping), capacity_(capacity) {}
+
+  // Updates the header in the file to the in-memory state.
+  void WriteHeader() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const int fd_;
+  // The whole file: the header followed by `capacity_` bytes of records.
+  char* const mapping_;
+  const int64_t capacity_;
+
+  mutable absl::Mutex mutex_;
+  // The offset at which the next record is written.
+  int64_t next_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The records still in the ring, oldest first.
+  std::deque<RecordLocation> records_ ABSL_GUARDED_BY(mutex_);
+  int64_t num_dropped_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_P4RUNTIME_WRITE_CAPTURE_RING_H_
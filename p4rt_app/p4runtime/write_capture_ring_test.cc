@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "p4rt_app/p4runtime/write_capture_ring.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/util/delimited_message_util.h"
+#include "gtest/gtest.h"
+#include "gutil/io.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4rt_app/p4runtime/write_capture.pb.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::StartsWith;
+
+std::string TestPath(absl::string_view name) {
+  return absl::StrCat(testing::TempDir(), "/", name);
+}
+
+p4::v1::WriteRequest Request(int id) {
+  p4::v1::WriteRequest request;
+  request.set_device_id(id);
+  request.add_updates()->mutable_entity()->mutable_table_entry()->set_table_id(
+      id);
+  return request;
+}
+
+// Dumps `ring` and returns the device IDs of the captured requests.
+absl::StatusOr<std::vector<int>> DumpedDeviceIds(const WriteCaptureRing& ring) {
+  const std::string path = TestPath("dump.bin");
+  RETURN_IF_ERROR(ring.Dump(path));
+  std::ifstream file(path, std::ios::binary);
+  google::protobuf::io::IstreamInputStream input(&file);
+  std::vector<int> ids;
+  CapturedWrite captured;
+  bool clean_eof = false;
+  while (google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+      &captured, &input, &clean_eof)) {
+    ids.push_back(captured.pi().device_id());
+  }
+  if (!clean_eof) return absl::DataLossError("Corrupt dump");
+  return ids;
+}
+
+TEST(WriteCaptureRingTest, CapturesRequestsWithTimingAndStatus) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<WriteCaptureRing> ring,
+                       WriteCaptureRing::Create(TestPath("ring"), 1 << 16));
+  const absl::Time start = absl::FromUnixMillis(1000);
+  ring->Record(Request(1), start, absl::Microseconds(2500), /*grpc_code=*/2,
+               "failed");
+  ASSERT_OK(ring->Dump(TestPath("single.bin")));
+
+  std::ifstream file(TestPath("single.bin"), std::ios::binary);
+  google::protobuf::io::IstreamInputStream input(&file);
+  CapturedWrite captured;
+  ASSERT_TRUE(google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+      &captured, &input, nullptr));
+  EXPECT_EQ(captured.timestamp_request(), 1000);
+  EXPECT_EQ(captured.timestamp_response(), 1002);
+  EXPECT_EQ(captured.latency_us(), 2500);
+  EXPECT_EQ(captured.grpc_code(), 2);
+  EXPECT_EQ(captured.grpc_message(), "failed");
+  EXPECT_THAT(captured.pi(), EqualsProto(Request(1)));
+}
+
+TEST(WriteCaptureRingTest, KeepsTheMostRecentRequestsInOrder) {
+  const int64_t record_size = CapturedWrite().ByteSizeLong() + 64;
+  ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<WriteCaptureRing> ring,
+      WriteCaptureRing::Create(TestPath("ring"), 5 * record_size));
+  EXPECT_THAT(DumpedDeviceIds(*ring), gutil::IsOkAndHolds(IsEmpty()));
+
+  for (int i = 1; i <= 50; ++i) {
+    ring->Record(Request(i), absl::Now(), absl::Milliseconds(1), 0, "");
+  }
+
+  ASSERT_OK_AND_ASSIGN(std::vector<int> ids, DumpedDeviceIds(*ring));
+  ASSERT_GE(ring->num_records(), 1);
+  ASSERT_EQ(ids.size(), ring->num_records());
+  // The dump holds the last `num_records` requests, oldest first.
+  for (int i = 0; i < ring->num_records(); ++i) {
+    EXPECT_EQ(ids[i], 50 - ring->num_records() + 1 + i);
+  }
+}
+
+TEST(WriteCaptureRingTest, DropsRequestsLargerThanTheRing) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<WriteCaptureRing> ring,
+                       WriteCaptureRing::Create(TestPath("ring"), 64));
+  p4::v1::WriteRequest large = Request(1);
+  for (int i = 0; i < 100; ++i) *large.add_updates() = large.updates(0);
+  ring->Record(large, absl::Now(), absl::Milliseconds(1), 0, "");
+  ring->Record(Request(2), absl::Now(), absl::Milliseconds(1), 0, "");
+
+  EXPECT_EQ(ring->num_dropped(), 1);
+  EXPECT_THAT(DumpedDeviceIds(*ring), gutil::IsOkAndHolds(ElementsAre(2)));
+}
+
+TEST(WriteCaptureRingTest, FileStartsWithMagic) {
+  ASSERT_OK_AND_ASSIGN(std::unique_ptr<WriteCaptureRing> ring,
+                       WriteCaptureRing::Create(TestPath("magic"), 128));
+  ASSERT_OK_AND_ASSIGN(std::string contents,
+                       gutil::ReadFile(TestPath("magic")));
+  EXPECT_THAT(contents, StartsWith("P4RTCAP1"));
+  EXPECT_EQ(contents.size(), 64 + 128);
+}
+
+TEST(WriteCaptureRingTest, RejectsInvalidCapacities) {
+  EXPECT_THAT(WriteCaptureRing::Create(TestPath("invalid"), 0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace p4rt_app
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "p4rt_app/p4runtime/write_coalescer.h"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/sonic/app_db_manager.h"
+#include "p4rt_app/utils/status_utility.h"
+
+namespace p4rt_app {
+namespace {
+
+// Returns true if the net effect of `earlier` followed by `later`, for the
+// same entity, can be published without publishing `earlier`.
+bool CanMerge(p4::v1::Update::Type earlier, p4::v1::Update::Type later) {
+  switch (earlier) {
+    case p4::v1::Update::INSERT:
+      return later == p4::v1::Update::DELETE;
+    case p4::v1::Update::MODIFY:
+      return later == p4::v1::Update::MODIFY ||
+             later == p4::v1::Update::DELETE;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+std::optional<int> WriteCoalescer::Add(
+    sonic::AppDbUpdates updates,
+    absl::flat_hash_map<uint32_t, int64_t> resources_in_batch) {
+  // Check every update before changing anything, so a request that cannot be
+  // merged leaves the earlier ones untouched.
+  for (const sonic::AppDbEntry& entry : updates.entries) {
+    auto live_slot = live_slot_by_key_.find(entry.entity_key);
+    if (live_slot != live_slot_by_key_.end() &&
+        !CanMerge(entries_[live_slot->second].update_type,
+                  entry.update_type)) {
+      return std::nullopt;
+    }
+  }
+
+  if (serialization_plan_ == nullptr) {
+    serialization_plan_ = updates.serialization_plan;
+  }
+  resources_in_batch_ = std::move(resources_in_batch);
+  total_rpc_updates_ += updates.total_rpc_updates;
+
+  const int request = sources_.size();
+  std::vector<std::pair<int, int>>& sources = sources_.emplace_back();
+  sources.reserve(updates.entries.size());
+  for (sonic::AppDbEntry& entry : updates.entries) {
+    const int slot = entries_.size();
+    sources.push_back({entry.rpc_index, slot});
+    slots_.emplace_back();
+
+    auto [live_slot, inserted] =
+        live_slot_by_key_.try_emplace(entry.entity_key, slot);
+    if (inserted) {
+      if (entry.update_type == p4::v1::Update::INSERT) {
+        pending_inserts_.insert(entry.entity_key);
+      }
+    } else if (entries_[live_slot->second].update_type ==
+               p4::v1::Update::INSERT) {
+      // A DELETE of an entity inserted earlier.
+      slots_[live_slot->second].cancelled = true;
+      slots_[slot].cancelled = true;
+      num_coalesced_updates_ += 2;
+      pending_inserts_.erase(entry.entity_key);
+      live_slot_by_key_.erase(live_slot);
+    } else {
+      slots_[live_slot->second].superseded_by = slot;
+      live_slot->second = slot;
+      ++num_coalesced_updates_;
+    }
+    entries_.push_back(std::move(entry));
+  }
+  return request;
+}
+
+sonic::AppDbUpdates WriteCoalescer::TakeMergedUpdates() {
+  sonic::AppDbUpdates merged;
+  merged.serialization_plan = serialization_plan_;
+  merged.total_rpc_updates = total_rpc_updates_;
+  merged.entries.reserve(entries_.size() - num_coalesced_updates_);
+  for (int slot = 0; slot < entries_.size(); ++slot) {
+    if (slots_[slot].cancelled || slots_[slot].superseded_by >= 0) continue;
+    slots_[slot].merged_index = merged.entries.size();
+    entries_[slot].rpc_index = slots_[slot].merged_index;
+    merged.entries.push_back(std::move(entries_[slot]));
+  }
+  return merged;
+}
+
+void WriteCoalescer::CopyStatuses(int request,
+                                  const pdpi::IrWriteResponse& merged_response,
+                                  pdpi::IrWriteResponse& response) const {
+  for (const auto& [rpc_index, first_slot] : sources_[request]) {
+    int slot = first_slot;
+    while (slots_[slot].superseded_by >= 0) slot = slots_[slot].superseded_by;
+    *response.mutable_statuses(rpc_index) =
+        slots_[slot].cancelled
+            ? GetIrUpdateStatus(absl::OkStatus())
+            : merged_response.statuses(slots_[slot].merged_index);
+  }
+}
+
+}  // namespace p4rt_app
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PINS_P4RT_APP_P4RUNTIME_WRITE_COALESCER_H_
+#define PINS_P4RT_APP_P4RUNTIME_WRITE_COALESCER_H_
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/sonic/app_db_manager.h"
+
+namespace p4rt_app {
+
+// Merges the AppDb updates of consecutive Write() requests so that only their
+// net effect is published to the AppDb. When a later request updates an entity
+// that an earlier request also updates:
+//   * a MODIFY followed by a MODIFY, or a DELETE, is superseded: only the later
+//     update is published, and the earlier one reports its status.
+//   * an INSERT followed by a DELETE cancels out: neither is published, and
+//     both report OK.
+// Any other combination depends on the earlier update having been applied, so
+// the later request cannot be merged.
+//
+// Each request is translated, and validated, on its own. The only difference
+// is that a DELETE of an entity in `pending_inserts` is valid even though the
+// entity is not in the entity cache yet.
+//
+// Not thread-safe.
+class WriteCoalescer {
+ public:
+  // Adds the translated updates of the next request, where each update's
+  // rpc_index refers to the request's response. `resources_in_batch` are the
+  // action profile resources used by every request added so far, including
+  // this one. Returns the index of the request, or nullopt (and adds nothing)
+  // if the request cannot be merged with the earlier ones.
+  std::optional<int> Add(
+      sonic::AppDbUpdates updates,
+      absl::flat_hash_map<uint32_t, int64_t> resources_in_batch);
+
+  // Returns the net updates of every request, in the order they were added.
+  // The rpc_index of each update is its index in the returned updates, and
+  // the statuses of a response for them are handed out with CopyStatuses.
+  // Must only be called once, after every request has been added.
+  sonic::AppDbUpdates TakeMergedUpdates();
+
+  // Sets the status of every update of the `request` from the
+  // `merged_response` to the TakeMergedUpdates result.
+  void CopyStatuses(int request, const pdpi::IrWriteResponse& merged_response,
+                    pdpi::IrWriteResponse& response) const;
+
+  // Entities inserted by the requests added so far that have not been
+  // cancelled out by a later DELETE.
+  const absl::flat_hash_set<pdpi::EntityKey>& pending_inserts() const {
+    return pending_inserts_;
+  }
+
+  const absl::flat_hash_map<uint32_t, int64_t>& resources_in_batch() const {
+    return resources_in_batch_;
+  }
+
+  bool empty() const { return sources_.empty(); }
+  int num_requests() const { return sources_.size(); }
+
+  // The number of updates that will not be published because they were
+  // superseded, or cancelled out.
+  int num_coalesced_updates() const { return num_coalesced_updates_; }
+
+ private:
+  struct Slot {
+    // The slot of the update that superseded this one, if any.
+    int superseded_by = -1;
+    // Set for both updates of an INSERT and DELETE that cancel out.
+    bool cancelled = false;
+    // The index of the update in the merged updates, if it is published.
+    int merged_index = -1;
+  };
+
+  // Every update added, in order, with the same index as its slot.
+  std::vector<sonic::AppDbEntry> entries_;
+  std::vector<Slot> slots_;
+
+  // For each request, the rpc_index and slot of each of its updates.
+  std::vector<std::vector<std::pair<int, int>>> sources_;
+
+  // The slot of the latest update of every entity that is still published.
+  absl::flat_hash_map<pdpi::EntityKey, int> live_slot_by_key_;
+  absl::flat_hash_set<pdpi::EntityKey> pending_inserts_;
+
+  absl::flat_hash_map<uint32_t, int64_t> resources_in_batch_;
+  const sonic::AppDbSerializationPlan* serialization_plan_ = nullptr;
+  int total_rpc_updates_ = 0;
+  int num_coalesced_updates_ = 0;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_P4RUNTIME_WRITE_COALESCER_H_
@@ -0,0 +1,238 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/p4runtime/write_coalescer.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/sonic/app_db_manager.h"
+#include "p4rt_app/utils/status_utility.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
+
+pdpi::EntityKey KeyOf(int id) {
+  p4::v1::TableEntry entry;
+  entry.set_table_id(1);
+  p4::v1::FieldMatch& match = *entry.add_match();
+  match.set_field_id(1);
+  match.mutable_exact()->set_value(absl::StrCat(id));
+  return pdpi::EntityKey(entry);
+}
+
+struct Update {
+  p4::v1::Update::Type type;
+  int id;
+  // Distinguishes the updates of the same entity.
+  std::string value = "";
+};
+
+// Returns the updates of a request, where the i-th update has rpc_index i.
+sonic::AppDbUpdates Request(const std::vector<Update>& updates) {
+  sonic::AppDbUpdates app_db_updates;
+  for (const Update& update : updates) {
+    sonic::AppDbEntry& entry = app_db_updates.entries.emplace_back();
+    entry.rpc_index = app_db_updates.entries.size() - 1;
+    entry.update_type = update.type;
+    entry.entity_key = KeyOf(update.id);
+    entry.app_db_key = absl::StrCat(update.id, update.value);
+  }
+  app_db_updates.total_rpc_updates = updates.size();
+  return app_db_updates;
+}
+
+// The app_db_key, which identifies the update in these tests, and the type of a
+// merged update.
+using PublishedUpdate = std::pair<std::string, p4::v1::Update::Type>;
+
+std::vector<PublishedUpdate> Published(const sonic::AppDbUpdates& updates) {
+  std::vector<PublishedUpdate> published;
+  for (int i = 0; i < updates.entries.size(); ++i) {
+    EXPECT_EQ(updates.entries[i].rpc_index, i);
+    published.push_back(
+        {updates.entries[i].app_db_key, updates.entries[i].update_type});
+  }
+  return published;
+}
+
+pdpi::IrWriteResponse ResponseWithStatuses(
+    const std::vector<absl::StatusCode>& codes) {
+  pdpi::IrWriteResponse response;
+  for (absl::StatusCode code : codes) {
+    *response.add_statuses() = GetIrUpdateStatus(code, "");
+  }
+  return response;
+}
+
+std::vector<google::rpc::Code> Codes(const pdpi::IrWriteResponse& response) {
+  std::vector<google::rpc::Code> codes;
+  for (const pdpi::IrUpdateStatus& status : response.statuses()) {
+    codes.push_back(status.code());
+  }
+  return codes;
+}
+
+TEST(WriteCoalescerTest, CombinesIndependentRequestsInOrder) {
+  WriteCoalescer coalescer;
+  EXPECT_TRUE(coalescer.empty());
+  EXPECT_THAT(coalescer.Add(Request({{p4::v1::Update::INSERT, 1},
+                                     {p4::v1::Update::MODIFY, 2}}),
+                            /*resources_in_batch=*/{}),
+              Optional(0));
+  EXPECT_THAT(coalescer.Add(Request({{p4::v1::Update::DELETE, 3}}),
+                            /*resources_in_batch=*/{{7, 10}}),
+              Optional(1));
+  EXPECT_EQ(coalescer.num_requests(), 2);
+  EXPECT_EQ(coalescer.num_coalesced_updates(), 0);
+  EXPECT_THAT(coalescer.pending_inserts(), UnorderedElementsAre(KeyOf(1)));
+  EXPECT_THAT(coalescer.resources_in_batch(),
+              UnorderedElementsAre(Pair(7, 10)));
+
+  sonic::AppDbUpdates merged = coalescer.TakeMergedUpdates();
+  EXPECT_EQ(merged.total_rpc_updates, 3);
+  EXPECT_THAT(Published(merged),
+              ElementsAre(PublishedUpdate("1", p4::v1::Update::INSERT),
+                          PublishedUpdate("2", p4::v1::Update::MODIFY),
+                          PublishedUpdate("3", p4::v1::Update::DELETE)));
+
+  pdpi::IrWriteResponse merged_response =
+      ResponseWithStatuses({absl::StatusCode::kOk, absl::StatusCode::kUnknown,
+                            absl::StatusCode::kNotFound});
+  pdpi::IrWriteResponse first = ResponseWithStatuses(
+      {absl::StatusCode::kAborted, absl::StatusCode::kAborted});
+  pdpi::IrWriteResponse second =
+      ResponseWithStatuses({absl::StatusCode::kAborted});
+  coalescer.CopyStatuses(0, merged_response, first);
+  coalescer.CopyStatuses(1, merged_response, second);
+  EXPECT_THAT(Codes(first), ElementsAre(google::rpc::OK, google::rpc::UNKNOWN));
+  EXPECT_THAT(Codes(second), ElementsAre(google::rpc::NOT_FOUND));
+}
+
+TEST(WriteCoalescerTest, LaterModifyOrDeleteSupersedesModify) {
+  WriteCoalescer coalescer;
+  ASSERT_TRUE(coalescer
+                  .Add(Request({{p4::v1::Update::MODIFY, 1, "a"},
+                                {p4::v1::Update::MODIFY, 2, "a"}}),
+                       {})
+                  .has_value());
+  ASSERT_TRUE(coalescer
+                  .Add(Request({{p4::v1::Update::MODIFY, 1, "b"},
+                                {p4::v1::Update::DELETE, 2, "b"}}),
+                       {})
+                  .has_value());
+  ASSERT_TRUE(
+      coalescer.Add(Request({{p4::v1::Update::MODIFY, 1, "c"}}), {})
+          .has_value());
+  EXPECT_EQ(coalescer.num_coalesced_updates(), 3);
+
+  // The latest update of each entity is published where it was requested.
+  sonic::AppDbUpdates merged = coalescer.TakeMergedUpdates();
+  EXPECT_THAT(Published(merged),
+              ElementsAre(PublishedUpdate("2b", p4::v1::Update::DELETE),
+                          PublishedUpdate("1c", p4::v1::Update::MODIFY)));
+
+  // Superseded updates report the status of the update that replaced them.
+  pdpi::IrWriteResponse merged_response = ResponseWithStatuses(
+      {absl::StatusCode::kOk, absl::StatusCode::kInvalidArgument});
+  pdpi::IrWriteResponse first = ResponseWithStatuses(
+      {absl::StatusCode::kAborted, absl::StatusCode::kAborted});
+  coalescer.CopyStatuses(0, merged_response, first);
+  EXPECT_THAT(Codes(first),
+              ElementsAre(google::rpc::INVALID_ARGUMENT, google::rpc::OK));
+}
+
+TEST(WriteCoalescerTest, DeleteCancelsOutEarlierInsert) {
+  WriteCoalescer coalescer;
+  ASSERT_TRUE(coalescer
+                  .Add(Request({{p4::v1::Update::INSERT, 1},
+                                {p4::v1::Update::INSERT, 2}}),
+                       {})
+                  .has_value());
+  EXPECT_THAT(coalescer.pending_inserts(),
+              UnorderedElementsAre(KeyOf(1), KeyOf(2)));
+  ASSERT_TRUE(
+      coalescer.Add(Request({{p4::v1::Update::DELETE, 1}}), {}).has_value());
+  EXPECT_THAT(coalescer.pending_inserts(), UnorderedElementsAre(KeyOf(2)));
+
+  // Once cancelled out, the entity can be inserted again.
+  ASSERT_TRUE(
+      coalescer.Add(Request({{p4::v1::Update::INSERT, 1, "again"}}), {})
+          .has_value());
+  EXPECT_EQ(coalescer.num_coalesced_updates(), 2);
+
+  sonic::AppDbUpdates merged = coalescer.TakeMergedUpdates();
+  EXPECT_EQ(merged.total_rpc_updates, 4);
+  EXPECT_THAT(Published(merged),
+              ElementsAre(PublishedUpdate("2", p4::v1::Update::INSERT),
+                          PublishedUpdate("1again", p4::v1::Update::INSERT)));
+
+  pdpi::IrWriteResponse merged_response = ResponseWithStatuses(
+      {absl::StatusCode::kUnknown, absl::StatusCode::kUnknown});
+  pdpi::IrWriteResponse first = ResponseWithStatuses(
+      {absl::StatusCode::kAborted, absl::StatusCode::kAborted});
+  pdpi::IrWriteResponse second =
+      ResponseWithStatuses({absl::StatusCode::kAborted});
+  coalescer.CopyStatuses(0, merged_response, first);
+  coalescer.CopyStatuses(1, merged_response, second);
+  EXPECT_THAT(Codes(first),
+              ElementsAre(google::rpc::OK, google::rpc::UNKNOWN));
+  EXPECT_THAT(Codes(second), ElementsAre(google::rpc::OK));
+}
+
+TEST(WriteCoalescerTest, RejectsRequestsThatDependOnEarlierUpdates) {
+  const std::vector<std::pair<p4::v1::Update::Type, p4::v1::Update::Type>>
+      kDependentPairs = {
+          {p4::v1::Update::INSERT, p4::v1::Update::INSERT},
+          {p4::v1::Update::INSERT, p4::v1::Update::MODIFY},
+          {p4::v1::Update::MODIFY, p4::v1::Update::INSERT},
+          {p4::v1::Update::DELETE, p4::v1::Update::INSERT},
+          {p4::v1::Update::DELETE, p4::v1::Update::MODIFY},
+          {p4::v1::Update::DELETE, p4::v1::Update::DELETE},
+      };
+  for (const auto& [earlier, later] : kDependentPairs) {
+    SCOPED_TRACE(absl::StrCat(p4::v1::Update::Type_Name(earlier), " then ",
+                              p4::v1::Update::Type_Name(later)));
+    WriteCoalescer coalescer;
+    ASSERT_TRUE(coalescer.Add(Request({{earlier, 1}}), {}).has_value());
+
+    // Nothing from the rejected request is added, even if it could be merged.
+    EXPECT_EQ(coalescer.Add(Request({{p4::v1::Update::INSERT, 2},
+                                     {later, 1}}),
+                            /*resources_in_batch=*/{{7, 10}}),
+              std::nullopt);
+    EXPECT_EQ(coalescer.num_requests(), 1);
+    EXPECT_THAT(coalescer.resources_in_batch(), IsEmpty());
+    EXPECT_THAT(Published(coalescer.TakeMergedUpdates()),
+                ElementsAre(PublishedUpdate("1", earlier)));
+  }
+}
+
+}  // namespace
+}  // namespace p4rt_app
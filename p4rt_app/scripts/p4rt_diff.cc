@@ -0,0 +1,337 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compares the entities on a switch against a desired snapshot, and reports
+// the entities that are missing, extra or modified on the switch. It can also
+// write, and optionally send, the sequenced write requests that bring the
+// switch to the desired state.
+//
+// Only the desired snapshot is indexed: each of its entities is reduced to its
+// `pdpi::EntityKey` and a fingerprint of its contents. The switch's entities
+// are streamed from the Read response and compared against the index one at a
+// time, so memory is proportional to the snapshot (plus the size of the diff).
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+#include "gutil/io.h"
+#include "gutil/proto.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/p4_runtime_session.h"
+#include "p4_pdpi/sequencing.h"
+#include "p4rt_app/scripts/p4rt_tool_helpers.h"
+
+DEFINE_string(desired_entities_file, "",
+              "The desired state of the switch. Files ending in '.binpb' hold "
+              "length-delimited p4::v1::Entity messages. Other files hold "
+              "pdpi::IrEntity text protos separated by lines of '***'.");
+DEFINE_bool(print_diff, true,
+            "Prints every missing, extra and modified entity.");
+DEFINE_string(corrective_requests_file, "",
+              "Writes the sequenced write requests that bring the switch to "
+              "the desired state to this file. Files ending in '.binpb' hold "
+              "length-delimited p4::v1::WriteRequest messages. Other files "
+              "hold pdpi::IrWriteRequest text protos separated by lines of "
+              "'***'.");
+DEFINE_bool(apply, false,
+            "Sends the corrective write requests to the switch.");
+DEFINE_int32(max_batch_size, 1000,
+             "The maximum number of updates in one corrective write request.");
+
+namespace p4rt_app {
+namespace {
+
+absl::StatusOr<pdpi::IrP4Info> GetIrP4infoFromSwitch(
+    pdpi::P4RuntimeSession& session) {
+  ASSIGN_OR_RETURN(p4::v1::GetForwardingPipelineConfigResponse response,
+                   pdpi::GetForwardingPipelineConfig(&session));
+  return pdpi::CreateIrP4Info(response.config().p4info());
+}
+
+std::string SerializeDeterministically(
+    const google::protobuf::Message& message) {
+  std::string bytes;
+  google::protobuf::io::StringOutputStream stream(&bytes);
+  google::protobuf::io::CodedOutputStream coded_stream(&stream);
+  coded_stream.SetSerializationDeterministic(true);
+  message.SerializePartialToCodedStream(&coded_stream);
+  coded_stream.Trim();
+  return bytes;
+}
+
+void SortParams(p4::v1::Action& action) {
+  std::sort(action.mutable_params()->begin(), action.mutable_params()->end(),
+            [](const p4::v1::Action::Param& a,
+               const p4::v1::Action::Param& b) {
+              return a.param_id() < b.param_id();
+            });
+}
+
+// Returns a fingerprint of the contents of `entity` that does not depend on
+// the order of repeated fields whose order has no meaning, nor on the data
+// the switch reports (e.g. counters). 64-bit fingerprints make accidental
+// collisions between two versions of the same entity negligible.
+uint64_t Fingerprint(p4::v1::Entity entity) {
+  if (entity.has_table_entry()) {
+    p4::v1::TableEntry& entry = *entity.mutable_table_entry();
+    entry.clear_counter_data();
+    entry.clear_meter_counter_data();
+    entry.clear_time_since_last_hit();
+    std::sort(entry.mutable_match()->begin(), entry.mutable_match()->end(),
+              [](const p4::v1::FieldMatch& a, const p4::v1::FieldMatch& b) {
+                return a.field_id() < b.field_id();
+              });
+    p4::v1::TableAction& action = *entry.mutable_action();
+    if (action.has_action()) SortParams(*action.mutable_action());
+    if (action.has_action_profile_action_set()) {
+      auto& actions =
+          *action.mutable_action_profile_action_set()
+               ->mutable_action_profile_actions();
+      for (p4::v1::ActionProfileAction& member : actions) {
+        SortParams(*member.mutable_action());
+      }
+      std::sort(actions.begin(), actions.end(),
+                [](const p4::v1::ActionProfileAction& a,
+                   const p4::v1::ActionProfileAction& b) {
+                  return SerializeDeterministically(a) <
+                         SerializeDeterministically(b);
+                });
+    }
+  }
+  return absl::Hash<std::string>{}(SerializeDeterministically(entity));
+}
+
+// What we remember about an entity of the desired snapshot.
+struct DesiredEntity {
+  uint64_t fingerprint = 0;
+  // The position of the entity in the snapshot file.
+  int64_t index = 0;
+  // Set once the switch has reported an entity with the same key.
+  bool on_switch = false;
+};
+
+struct StateDiff {
+  // Positions of entities in the snapshot file.
+  absl::flat_hash_set<int64_t> missing_indices;
+  absl::flat_hash_set<int64_t> modified_indices;
+  std::vector<p4::v1::Entity> extra_entities;
+};
+
+absl::StatusOr<std::string> EntityToString(const pdpi::IrP4Info& ir_p4info,
+                                           const p4::v1::Entity& entity) {
+  ASSIGN_OR_RETURN(pdpi::IrEntity ir_entity,
+                   pdpi::PiEntityToIr(ir_p4info, entity));
+  return ir_entity.ShortDebugString();
+}
+
+absl::StatusOr<StateDiff> ComputeStateDiff(pdpi::P4RuntimeSession& session,
+                                           const pdpi::IrP4Info& ir_p4info) {
+  // Index the desired snapshot.
+  absl::flat_hash_map<pdpi::EntityKey, DesiredEntity> desired;
+  {
+    ASSIGN_OR_RETURN(
+        std::unique_ptr<EntityFileReader> reader,
+        EntityFileReader::Open(FLAGS_desired_entities_file, ir_p4info));
+    p4::v1::Entity entity;
+    for (int64_t index = 0;; ++index) {
+      ASSIGN_OR_RETURN(bool has_entity, reader->ReadNext(entity));
+      if (!has_entity) break;
+      ASSIGN_OR_RETURN(pdpi::EntityKey key,
+                       pdpi::EntityKey::MakeEntityKey(entity));
+      auto [it, inserted] = desired.try_emplace(
+          key, DesiredEntity{.fingerprint = Fingerprint(entity),
+                             .index = index});
+      if (!inserted) {
+        return gutil::InvalidArgumentErrorBuilder()
+               << "Entities " << it->second.index << " and " << index
+               << " of the desired snapshot have the same key: " << key;
+      }
+    }
+  }
+  Info(absl::StrCat("Indexed ", desired.size(),
+                    " entities of the desired snapshot."));
+
+  // Stream the switch's entities against the index.
+  StateDiff diff;
+  int64_t num_switch_entities = 0;
+  RETURN_IF_ERROR(pdpi::ReadPiEntities(
+      &session, [&](p4::v1::Entity& entity) -> absl::Status {
+        ++num_switch_entities;
+        ASSIGN_OR_RETURN(pdpi::EntityKey key,
+                         pdpi::EntityKey::MakeEntityKey(entity));
+        auto it = desired.find(key);
+        if (it == desired.end()) {
+          diff.extra_entities.push_back(std::move(entity));
+          return absl::OkStatus();
+        }
+        it->second.on_switch = true;
+        if (it->second.fingerprint != Fingerprint(entity)) {
+          diff.modified_indices.insert(it->second.index);
+        }
+        return absl::OkStatus();
+      }));
+  for (const auto& [key, entity] : desired) {
+    if (!entity.on_switch) diff.missing_indices.insert(entity.index);
+  }
+
+  Info(absl::StrFormat(
+      "Read %d entities from the switch: %d missing, %d extra, %d modified.",
+      num_switch_entities, diff.missing_indices.size(),
+      diff.extra_entities.size(), diff.modified_indices.size()));
+  return diff;
+}
+
+// Returns the updates that turn the switch's state into the desired one. The
+// entities to insert or modify are read from the snapshot file again, so only
+// the diff is held in memory.
+absl::StatusOr<std::vector<p4::v1::Update>> ComputeCorrectiveUpdates(
+    const pdpi::IrP4Info& ir_p4info, StateDiff& diff) {
+  std::vector<p4::v1::Update> updates;
+  const bool print_diff = FLAGS_print_diff;
+  for (p4::v1::Entity& entity : diff.extra_entities) {
+    if (print_diff) {
+      ASSIGN_OR_RETURN(std::string text, EntityToString(ir_p4info, entity));
+      Info(absl::StrCat("extra: ", text));
+    }
+    p4::v1::Update& update = updates.emplace_back();
+    update.set_type(p4::v1::Update::DELETE);
+    *update.mutable_entity() = std::move(entity);
+  }
+  diff.extra_entities.clear();
+
+  if (diff.missing_indices.empty() && diff.modified_indices.empty()) {
+    return updates;
+  }
+  ASSIGN_OR_RETURN(
+      std::unique_ptr<EntityFileReader> reader,
+      EntityFileReader::Open(FLAGS_desired_entities_file, ir_p4info));
+  p4::v1::Entity entity;
+  for (int64_t index = 0;; ++index) {
+    ASSIGN_OR_RETURN(bool has_entity, reader->ReadNext(entity));
+    if (!has_entity) break;
+
+    p4::v1::Update::Type type;
+    if (diff.missing_indices.contains(index)) {
+      type = p4::v1::Update::INSERT;
+    } else if (diff.modified_indices.contains(index)) {
+      type = p4::v1::Update::MODIFY;
+    } else {
+      continue;
+    }
+    if (print_diff) {
+      ASSIGN_OR_RETURN(std::string text, EntityToString(ir_p4info, entity));
+      Info(absl::StrCat(
+          type == p4::v1::Update::INSERT ? "missing: " : "modified: ", text));
+    }
+    p4::v1::Update& update = updates.emplace_back();
+    update.set_type(type);
+    *update.mutable_entity() = entity;
+  }
+  return updates;
+}
+
+absl::Status SaveCorrectiveRequests(
+    const pdpi::IrP4Info& ir_p4info,
+    const std::vector<p4::v1::WriteRequest>& requests,
+    const std::string& path) {
+  if (absl::EndsWith(path, gutil::kBinaryProtoFileExtension)) {
+    return gutil::SaveDelimitedProtosToFile(path, requests);
+  }
+
+  std::string text;
+  for (const p4::v1::WriteRequest& request : requests) {
+    ASSIGN_OR_RETURN(pdpi::IrWriteRequest ir_request,
+                     pdpi::PiWriteRequestToIr(ir_p4info, request));
+    if (!text.empty()) absl::StrAppend(&text, "***\n");
+    absl::StrAppend(&text, ir_request.DebugString());
+  }
+  return gutil::WriteFile(text, path);
+}
+
+absl::Status Main() {
+  if (FLAGS_desired_entities_file.empty()) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "--desired_entities_file must be set.";
+  }
+
+  // Connect to the P4RT server.
+  ASSIGN_OR_RETURN(std::unique_ptr<pdpi::P4RuntimeSession> session,
+                   CreateP4rtSession());
+  ASSIGN_OR_RETURN(pdpi::IrP4Info ir_p4info, GetIrP4infoFromSwitch(*session));
+
+  ASSIGN_OR_RETURN(StateDiff diff, ComputeStateDiff(*session, ir_p4info));
+  ASSIGN_OR_RETURN(std::vector<p4::v1::Update> updates,
+                   ComputeCorrectiveUpdates(ir_p4info, diff));
+  if (updates.empty()) {
+    Info("The switch is in the desired state.");
+    return absl::OkStatus();
+  }
+
+  if (!FLAGS_corrective_requests_file.empty()) {
+    ASSIGN_OR_RETURN(std::vector<p4::v1::WriteRequest> requests,
+                     pdpi::SequencePiUpdatesIntoWriteRequests(
+                         ir_p4info, updates, FLAGS_max_batch_size));
+    RETURN_IF_ERROR(SaveCorrectiveRequests(ir_p4info, requests,
+                                           FLAGS_corrective_requests_file));
+    Info(absl::StrFormat("Wrote %d corrective write requests to '%s'.",
+                         requests.size(), FLAGS_corrective_requests_file));
+  }
+
+  if (FLAGS_apply) {
+    RETURN_IF_ERROR(
+        pdpi::SendPiUpdatesPipelined(*session, ir_p4info, updates,
+                                     {.max_batch_size = FLAGS_max_batch_size})
+            .status());
+    Info(absl::StrCat("Sent ", updates.size(), " corrective updates."));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+}  // namespace p4rt_app
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  absl::Status status = p4rt_app::Main();
+  if (!status.ok()) {
+    p4rt_app::Error(status.ToString());
+    return status.raw_code();
+  }
+
+  p4rt_app::Info("Completed successfully.");
+  return 0;
+}
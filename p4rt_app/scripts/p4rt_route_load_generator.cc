@@ -14,10 +14,12 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT: third_party code.
 #include <utility>
 #include <vector>
 
@@ -25,8 +27,10 @@
 #include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/numeric/int128.h"
+#include "absl/random/discrete_distribution.h"
 #include "absl/random/distributions.h"
 #include "absl/random/random.h"
+#include "absl/strings/ascii.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/numbers.h"
@@ -36,16 +40,16 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
-#include "gmock/gmock.h"
-#include "gtest/gtest.h"
 #include "gutil/collections.h"
 #include "gutil/io.h"
 #include "gutil/status.h"
-#include "gutil/status_matchers.h"
+#include "include/nlohmann/json.hpp"
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.h"
@@ -55,12 +59,20 @@
 #include "p4_pdpi/netaddr/mac_address.h"
 #include "p4_pdpi/p4_runtime_session.h"
 #include "p4_pdpi/sequencing.h"
+#include "p4rt_app/utils/latency_histogram.h"
 #include "sai_p4/instantiations/google/instantiations.h"
 #include "sai_p4/instantiations/google/sai_p4info.h"
 #include "sai_p4/instantiations/google/sai_pd.pb.h"
 #include "tests/lib/p4rt_fixed_table_programming_helper.h"
 
-// The test can be run over a unix socket or TCP connection. In general (i.e.
+// A load generator for measuring how quickly a switch programs routes through
+// P4RT. It installs a random set of prerequisite entries (VRFs, RIFs, neighbors
+// and next hops), and then measures the INSERT, MODIFY and DELETE latency of
+// the selected workloads for every batch size in the sweep. The results are
+// written as JSON so that route-scale qualification runs can be compared
+// across builds.
+//
+// The tool can be run over a unix socket or TCP connection. In general (i.e.
 // verify for your own enviornment) the socket will be unsecured while the TCP
 // connection requires authentication.
 //
@@ -100,23 +112,53 @@ DEFINE_int32(next_hops, 512, "The number of next-hop entries to install.");
 DEFINE_int32(encaps, 512, "The number of tunnel encap entries to install.");
 
 // A run will automatically generate `number_batches` write requests each with
-// `batch_size` updates (i.e. number_batches x batch_size total flows). Runtime
-// only includes the P4RT Write() time, and not the generation.
+// `batch_size` updates (i.e. number_batches x batch_size total flows) for every
+// workload. Passing `batch_sizes` sweeps over multiple batch sizes instead.
+// Latency only includes the P4RT Write() time, and not the generation.
 DEFINE_int32(number_batches, 10,
              "Total number of gRPC write calls made to the switch.");
 DEFINE_int32(batch_size, 100,
              "Total number of table entries in each gRPC write.");
+DEFINE_string(batch_sizes, "",
+              "A comma separated list of batch sizes to sweep over. Overrides "
+              "--batch_size when set.");
 DEFINE_bool(cleanup, true, "Delete all programmed flows at end of test.");
 
-// Users should select the specific test they want to run.  Because the tested
-// tables don't overlap users can run multiple, and they will happen
-// sequentially. Users should be careful when running multiple tests since the
-// batch sizes are reused (i.e. 10k IPv4 flows may be reasonable, but 10k WCMP
-// groups may not be).
-DEFINE_bool(run_ipv4, false, "Run IPv4 route latency tests.");
-DEFINE_bool(run_ipv6, false, "Run IPv6 route latency tests.");
-DEFINE_bool(run_wcmp, false, "Run IPv4 route latency tests.");
-DEFINE_bool(run_encap, false, "Run Tunnel encap latency tests.");
+// Write requests within one operation (e.g. all IPv4 INSERTs) are independent,
+// so up to `concurrency` of them are kept in flight at the same time. By
+// default requests are sent closed-loop: a new request is sent as soon as one
+// completes. Setting `arrival_rate` sends the requests open-loop at a fixed
+// rate instead, and latency is then measured from when a request was scheduled
+// to be sent so that a slow switch cannot hide its queueing delay.
+DEFINE_int32(concurrency, 1,
+             "Maximum number of outstanding gRPC write calls.");
+DEFINE_double(arrival_rate, 0,
+              "Open-loop arrival rate in write requests per second. Requests "
+              "are sent closed-loop when 0.");
+
+// Users should select the specific workloads they want to run. Because the
+// tested tables don't overlap users can run multiple, and they will happen
+// sequentially. Users should be careful when running multiple workloads since
+// the batch sizes are reused (i.e. 10k IPv4 flows may be reasonable, but 10k
+// WCMP groups may not be).
+//
+// The `mixed` workload interleaves IPv4, IPv6, next hop and WCMP updates in
+// every write request according to `mixed_workload_weights`.
+DEFINE_string(workloads, "",
+              "A comma separated list of workloads to run: ipv4, ipv6, "
+              "nexthop, wcmp, encap, or mixed.");
+DEFINE_string(mixed_workload_weights, "ipv4=70,ipv6=10,nexthop=10,wcmp=10",
+              "A comma separated list of <workload>=<weight> pairs used by the "
+              "mixed workload.");
+
+// Deprecated aliases for --workloads.
+DEFINE_bool(run_ipv4, false, "Same as --workloads=ipv4.");
+DEFINE_bool(run_ipv6, false, "Same as --workloads=ipv6.");
+DEFINE_bool(run_wcmp, false, "Same as --workloads=wcmp.");
+DEFINE_bool(run_encap, false, "Same as --workloads=encap.");
+
+// The JSON results are written to stdout when no file is given.
+DEFINE_string(output_file, "", "File to write the JSON results to.");
 
 // Extra configs that affect WCMP batch sizes and flows.
 DEFINE_int32(wcmp_members_per_group, 2,
@@ -145,7 +187,7 @@ using P4RTUpdateByNameMap = absl::btree_map<std::string, p4::v1::Update>;
 
 // Uses the seed sequence passed by the `--seed_seq` flag. If no sequence is set
 // then it will choose a random one.
-std::seed_seq GetSeedSeq() {
+std::vector<int> GetSeedSeq() {
   std::string forced_seq = FLAGS_seed_seq;
   std::vector<int> seq;
   if (forced_seq.empty()) {
@@ -158,16 +200,15 @@ std::seed_seq GetSeedSeq() {
     for (const auto& s : absl::StrSplit(forced_seq, ',')) {
       int value;
       if (!absl::SimpleAtoi(s, &value)) {
-        std::cout << "--seed_seq is invalid: " << forced_seq << std::endl;
+        LOG(WARNING) << "--seed_seq is invalid: " << forced_seq;
       } else {
         seq.push_back(value);
       }
     }
   }
 
-  std::cout << "--seed_seq=" << absl::StrJoin(seq, ",", absl::StreamFormatter())
-            << std::endl;
-  return std::seed_seq(seq.begin(), seq.end());
+  LOG(INFO) << "--seed_seq=" << absl::StrJoin(seq, ",");
+  return seq;
 }
 
 // Generated a random set of unique value in the range [min_value, max_value)
@@ -374,62 +415,6 @@ absl::Status VerifyP4WcmpWriteSizes(
   return absl::OkStatus();
 }
 
-class P4rtRouteTest : public testing::Test {
- protected:
-  void SetUp() override {
-    ASSERT_OK_AND_ASSIGN(p4rt_session_, OpenP4RuntimeSession());
-    ASSERT_OK_AND_ASSIGN(ir_p4info_,
-                         GetExistingP4InfoOrSetDefault(
-                             *p4rt_session_, sai::Instantiation::kMiddleblock));
-
-    // Clear the current table entries, if any.
-    ASSERT_OK(pdpi::ClearTableEntries(p4rt_session_.get()));
-  }
-
-  void TearDown() override {
-    // Remove table entries that were created.
-    if (p4rt_session_ != nullptr) {
-      if (FLAGS_cleanup) {
-        ASSERT_OK(pdpi::ClearTableEntries(p4rt_session_.get()));
-      }
-    }
-  }
-
-  // Set connection & switch IDs so the request will not be rejected.
-  void UpdateRequestMetadata(std::vector<p4::v1::WriteRequest>& requests) {
-    for (auto& request : requests) {
-      request.set_device_id(p4rt_session_->DeviceId());
-      request.set_role(p4rt_session_->Role());
-      *request.mutable_election_id() = p4rt_session_->ElectionId();
-    }
-  }
-
-  void UpdateRequestMetadata(P4WriteRequests& requests) {
-    UpdateRequestMetadata(requests.inserts);
-    UpdateRequestMetadata(requests.modifies);
-    UpdateRequestMetadata(requests.deletes);
-  }
-
-  absl::StatusOr<absl::Duration> SendBatchRequest(
-      const std::vector<p4::v1::WriteRequest>& requests) {
-    absl::Duration total_execution_time;
-    for (const auto& request : requests) {
-      // Send a batch of requests to the server and measure the response time.
-      absl::Time start = absl::Now();
-
-      // We don't expect any errors in the test. So if we see one we invalidate
-      // the run.
-      RETURN_IF_ERROR(p4rt_session_->Write(request));
-      total_execution_time += absl::Now() - start;
-    }
-
-    return total_execution_time;
-  }
-
-  std::unique_ptr<pdpi::P4RuntimeSession> p4rt_session_;
-  pdpi::IrP4Info ir_p4info_;
-};
-
 // When testing we randomly generate routes to program. RouteEntryInfo acts as a
 // cache of table entries subsiquent flows can build upon. This also makes the
 // order this object is built important! For example we should have a list of
@@ -446,7 +431,8 @@ struct RouteEntryInfo {
   // needed.
   absl::flat_hash_map<std::string, std::string> port_by_rif_name;
   absl::flat_hash_map<std::string, std::string> port_by_next_hop_name;
-  // Used for matching the router interface in the tunnel and neighbor tables.
+  // Used for matching the router interface in the tunnel, neighbor and next hop
+  // tables.
   absl::btree_map<std::string, std::string> neighbor_to_router_interface_name;
 };
 
@@ -543,6 +529,7 @@ absl::Status GenerateRandomNextHops(absl::BitGen& bitgen,
              << "Could not find port name for rif '" << rif << "'.";
     }
     routes.port_by_next_hop_name[nexthop_name] = *port_name;
+    routes.neighbor_to_router_interface_name[neighbor_name] = rif;
   }
   return absl::OkStatus();
 }
@@ -883,6 +870,169 @@ absl::StatusOr<P4WriteRequests> ComputeIpv6WriteRequests(
   return requests;
 }
 
+// The next hops created by this workload reference the pre-installed neighbors,
+// and are not referenced by any other entry. So they can be written in any
+// order.
+absl::StatusOr<P4WriteRequests> ComputeNextHopWriteRequests(
+    absl::BitGen& bitgen, const RouteEntryInfo& routes,
+    const pdpi::IrP4Info& ir_p4info, uint32_t number_batches,
+    uint32_t batch_size) {
+  ASSIGN_OR_RETURN(std::vector<std::string> neighbors,
+                   GetKeys(routes.neighbors_by_name),
+                   _ << "Neighbors need to be created before next hops");
+  auto random_neighbor =
+      [&]() -> absl::StatusOr<std::pair<std::string, std::string>> {
+    std::string neighbor =
+        neighbors[absl::Uniform<size_t>(bitgen, 0, neighbors.size())];
+    const std::string* rif =
+        gutil::FindOrNull(routes.neighbor_to_router_interface_name, neighbor);
+    if (rif == nullptr) {
+      return gutil::NotFoundErrorBuilder()
+             << "Could not find router interface for neighbor '" << neighbor
+             << "'.";
+    }
+    return std::make_pair(*rif, neighbor);
+  };
+
+  P4WriteRequests requests;
+  for (uint32_t i = 0; i < number_batches * batch_size; ++i) {
+    if (requests.inserts.empty() ||
+        requests.inserts.back().updates_size() == batch_size) {
+      requests.inserts.push_back(p4::v1::WriteRequest{});
+      requests.modifies.push_back(p4::v1::WriteRequest{});
+      requests.deletes.push_back(p4::v1::WriteRequest{});
+    }
+
+    // The initial INSERT request.
+    std::string nexthop_name = absl::StrCat("nh-load-", i);
+    ASSIGN_OR_RETURN(auto rif_and_neighbor, random_neighbor());
+    ASSIGN_OR_RETURN(*requests.inserts.back().add_updates(),
+                     gpins::NexthopTableUpdate(
+                         ir_p4info, p4::v1::Update::INSERT, nexthop_name,
+                         rif_and_neighbor.first, rif_and_neighbor.second));
+
+    // MODIFY the neighbor.
+    ASSIGN_OR_RETURN(rif_and_neighbor, random_neighbor());
+    ASSIGN_OR_RETURN(*requests.modifies.back().add_updates(),
+                     gpins::NexthopTableUpdate(
+                         ir_p4info, p4::v1::Update::MODIFY, nexthop_name,
+                         rif_and_neighbor.first, rif_and_neighbor.second));
+
+    // DELETE the entry.
+    ASSIGN_OR_RETURN(*requests.deletes.back().add_updates(),
+                     gpins::NexthopTableUpdate(
+                         ir_p4info, p4::v1::Update::DELETE, nexthop_name,
+                         rif_and_neighbor.first, rif_and_neighbor.second));
+  }
+
+  RETURN_IF_ERROR(
+      VerifyP4WriteRequestSizes(requests, number_batches, batch_size));
+  return requests;
+}
+
+// Parses the `--mixed_workload_weights` flag. To make runs reproducible we
+// intentionally return a absl::btree_map.
+absl::StatusOr<absl::btree_map<std::string, int>> ParseMixedWorkloadWeights(
+    absl::string_view flag) {
+  absl::btree_map<std::string, int> weights;
+  int total_weight = 0;
+  for (absl::string_view pair : absl::StrSplit(flag, ',', absl::SkipEmpty())) {
+    std::vector<std::string> parts = absl::StrSplit(pair, '=');
+    int weight = 0;
+    if (parts.size() != 2 || !absl::SimpleAtoi(parts[1], &weight) ||
+        weight < 0) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Expected <workload>=<non-negative weight> but got '" << pair
+             << "'.";
+    }
+    if (parts[0] != "ipv4" && parts[0] != "ipv6" && parts[0] != "nexthop" &&
+        parts[0] != "wcmp") {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unsupported mixed workload '" << parts[0]
+             << "'. Expected one of: ipv4, ipv6, nexthop or wcmp.";
+    }
+    weights[parts[0]] = weight;
+    total_weight += weight;
+  }
+  if (total_weight <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "The mixed workload needs at least one positive weight: '"
+           << flag << "'.";
+  }
+  return weights;
+}
+
+// Randomly picks the workload of every update based on `weights`, and then
+// interleaves the updates of all workloads into `number_batches` write requests
+// of `batch_size` updates each. The updates of one workload only depend on the
+// pre-installed entries so they can be written in any order.
+absl::StatusOr<P4WriteRequests> ComputeMixedWriteRequests(
+    absl::BitGen& bitgen, const RouteEntryInfo& routes,
+    const pdpi::IrP4Info& ir_p4info, uint32_t number_batches,
+    uint32_t batch_size, const absl::btree_map<std::string, int>& weights) {
+  std::vector<std::string> names;
+  std::vector<int> name_weights;
+  for (const auto& [name, weight] : weights) {
+    names.push_back(name);
+    name_weights.push_back(weight);
+  }
+  absl::discrete_distribution<int> pick_workload(name_weights.begin(),
+                                                 name_weights.end());
+  std::vector<int> workload_by_update(number_batches * batch_size);
+  std::vector<uint32_t> updates_per_workload(names.size());
+  for (int& workload : workload_by_update) {
+    workload = pick_workload(bitgen);
+    ++updates_per_workload[workload];
+  }
+
+  // Generate each workload as single update batches so they can be reshuffled.
+  std::vector<P4WriteRequests> requests_by_workload(names.size());
+  for (int i = 0; i < names.size(); ++i) {
+    const uint32_t count = updates_per_workload[i];
+    if (count == 0) continue;
+    if (names[i] == "ipv4") {
+      ASSIGN_OR_RETURN(requests_by_workload[i],
+                       ComputeIpv4WriteRequests(bitgen, routes, ir_p4info,
+                                                count, /*batch_size=*/1));
+    } else if (names[i] == "ipv6") {
+      ASSIGN_OR_RETURN(requests_by_workload[i],
+                       ComputeIpv6WriteRequests(bitgen, routes, ir_p4info,
+                                                count, /*batch_size=*/1));
+    } else if (names[i] == "nexthop") {
+      ASSIGN_OR_RETURN(requests_by_workload[i],
+                       ComputeNextHopWriteRequests(bitgen, routes, ir_p4info,
+                                                   count, /*batch_size=*/1));
+    } else {
+      ASSIGN_OR_RETURN(
+          requests_by_workload[i],
+          ComputeWcmpWriteRequests(
+              bitgen, routes, ir_p4info, count, /*batch_size=*/1,
+              FLAGS_wcmp_members_per_group, /*randomize_weights=*/true,
+              FLAGS_wcmp_total_group_weight));
+    }
+  }
+
+  P4WriteRequests requests;
+  std::vector<int> next_update(names.size());
+  for (int workload : workload_by_update) {
+    if (requests.inserts.empty() ||
+        requests.inserts.back().updates_size() == batch_size) {
+      requests.inserts.push_back(p4::v1::WriteRequest{});
+      requests.modifies.push_back(p4::v1::WriteRequest{});
+      requests.deletes.push_back(p4::v1::WriteRequest{});
+    }
+    const P4WriteRequests& source = requests_by_workload[workload];
+    const int index = next_update[workload]++;
+    *requests.inserts.back().add_updates() = source.inserts[index].updates(0);
+    *requests.modifies.back().add_updates() = source.modifies[index].updates(0);
+    *requests.deletes.back().add_updates() = source.deletes[index].updates(0);
+  }
+
+  RETURN_IF_ERROR(
+      VerifyP4WriteRequestSizes(requests, number_batches, batch_size));
+  return requests;
+}
+
 // Encap tunnel needs the following objects and is referenced by nexthop.
 // Nexthop group -> Nexthop tunnel -> Tunnel -> Neighbor, RouterInterface
 absl::StatusOr<P4WriteRequests> ComputeEncapWriteRequests(
@@ -969,208 +1119,459 @@ absl::StatusOr<P4WriteRequests> ComputeEncapWriteRequests(
   return requests;
 }
 
-TEST_F(P4rtRouteTest, MeasureWriteLatency) {
-  int32_t number_of_batches = FLAGS_number_batches;
-  int32_t requests_per_batch = FLAGS_batch_size;
-  std::string available_port_ids = FLAGS_port_ids;
-  int32_t number_of_vrfs = FLAGS_vrfs;
-  int32_t number_of_rifs = FLAGS_rifs;
-  int32_t number_of_nexthops = FLAGS_next_hops;
-  int32_t number_of_encaps = FLAGS_encaps;
-
-  // Randomly generate the routes that will be used by these tests.
-  absl::BitGen bitgen(GetSeedSeq());
-  RouteEntryInfo routes;
-  ASSERT_OK_AND_ASSIGN(routes.port_ids, ParsePortIds(available_port_ids));
-  ASSERT_OK(GenerateRandomRIFs(bitgen, routes, ir_p4info_, number_of_rifs));
-  ASSERT_OK(GenerateRandomVrfs(bitgen, routes, ir_p4info_, number_of_vrfs));
-  // Tunnel nexthops are created differently later.
-  if (!FLAGS_run_encap) {
-    ASSERT_OK(
-        GenerateRandomNextHops(bitgen, routes, ir_p4info_, number_of_nexthops));
-  }
 
-  // Install the route entries that are needed by the IPv4 flows.
-  std::vector<p4::v1::WriteRequest> premeasurement_requests;
-  AppendUpdatesToWriteRequest(premeasurement_requests.emplace_back(),
-                              routes.vrfs_by_name);
-  AppendUpdatesToWriteRequest(premeasurement_requests.emplace_back(),
-                              routes.router_interfaces_by_name);
-  AppendUpdatesToWriteRequest(premeasurement_requests.emplace_back(),
-                              routes.neighbors_by_name);
-  AppendUpdatesToWriteRequest(premeasurement_requests.emplace_back(),
-                              routes.next_hops_by_name);
-  UpdateRequestMetadata(premeasurement_requests);
-  ASSERT_OK(SendBatchRequest(premeasurement_requests).status());
-
-  if (FLAGS_run_ipv4) {
-    // Pre-compute all the IPv4 requests so they can be sent as quickly as
-    // possible to the switch under test.
-    ASSERT_OK_AND_ASSIGN(
-        P4WriteRequests requests,
-        ComputeIpv4WriteRequests(bitgen, routes, ir_p4info_, number_of_batches,
-                                 requests_per_batch));
+// The write requests of one workload. Workloads that need multiple tables are
+// split into one `WorkloadRequests` per table, in dependency order.
+struct WorkloadRequests {
+  std::string workload;
+  P4WriteRequests requests;
+  bool modify_supported = true;
+};
+
+// The measurements of sending one operation (e.g. all the IPv4 INSERTs) of a
+// workload to the switch.
+struct OperationResult {
+  std::string workload;
+  std::string operation;
+  int batch_size = 0;
+  int64_t num_requests = 0;
+  int64_t num_updates = 0;
+  absl::Duration wall_time;
+  // The time from when a request was scheduled to be sent until it completed.
+  LatencyHistogram latency;
+  // The time from when a request was actually sent until it completed. Only
+  // differs from `latency` when an open-loop run falls behind its arrival rate.
+  LatencyHistogram service_time;
+};
+
+class LoadGenerator {
+ public:
+  LoadGenerator(std::unique_ptr<pdpi::P4RuntimeSession> session,
+                int concurrency, double arrival_rate)
+      : session_(std::move(session)),
+        concurrency_(concurrency),
+        arrival_rate_(arrival_rate) {}
+
+  pdpi::P4RuntimeSession& session() { return *session_; }
+  const std::vector<OperationResult>& results() const { return results_; }
+
+  // Installs entries that the measured workloads depend on. The time needed to
+  // install them is not reported.
+  absl::Status InstallPrerequisites(
+      std::vector<p4::v1::WriteRequest> requests) {
     UpdateRequestMetadata(requests);
-    ASSERT_OK_AND_ASSIGN(absl::Duration insert_time,
-                         SendBatchRequest(requests.inserts));
-    ASSERT_OK_AND_ASSIGN(absl::Duration modify_time,
-                         SendBatchRequest(requests.modifies));
-
-    // Write the results to stdout so that the callers can parse the output.
-    int64_t total_entries = number_of_batches * requests_per_batch;
-    std::cout << absl::StreamFormat(
-        "ipv4_requests=%d ipv4_entry_total=%lld "
-        "ipv4_insert_time=%lld(msecs) ipv4_modify_time=%lld(msecs) ",
-        number_of_batches, total_entries,
-        absl::ToInt64Milliseconds(insert_time),
-        absl::ToInt64Milliseconds(modify_time));
-    if (FLAGS_cleanup) {
-      ASSERT_OK_AND_ASSIGN(absl::Duration delete_time,
-                           SendBatchRequest(requests.deletes));
-      std::cout << absl::StreamFormat("ipv4_delete_time=%lld(msecs) ",
-                                      absl::ToInt64Milliseconds(delete_time));
+    for (const auto& request : requests) {
+      if (request.updates().empty()) continue;
+      RETURN_IF_ERROR(session_->Write(request));
     }
-    std::cout << std::endl;
+    return absl::OkStatus();
+  }
 
-    // TODO: remove once we migrate the Perfkit dashboard to the
-    // new tags.
-    std::cout << "Successfully wrote IpTable entries to the switch, time: "
-              << ToInt64Milliseconds(insert_time) << "(msecs)" << std::endl;
+  // Measures the INSERTs, MODIFYs and DELETEs of a workload. Dependent tables
+  // are inserted and modified in order, and deleted in reverse order.
+  absl::Status Measure(std::vector<WorkloadRequests> workload, int batch_size,
+                       bool send_deletes) {
+    for (WorkloadRequests& table : workload) {
+      UpdateRequestMetadata(table.requests);
+    }
+    for (const WorkloadRequests& table : workload) {
+      RETURN_IF_ERROR(Send(table.workload, "insert", batch_size,
+                           table.requests.inserts));
+    }
+    for (const WorkloadRequests& table : workload) {
+      if (!table.modify_supported) continue;
+      RETURN_IF_ERROR(Send(table.workload, "modify", batch_size,
+                           table.requests.modifies));
+    }
+    if (!send_deletes) return absl::OkStatus();
+    for (auto table = workload.rbegin(); table != workload.rend(); ++table) {
+      RETURN_IF_ERROR(Send(table->workload, "delete", batch_size,
+                           table->requests.deletes));
+    }
+    return absl::OkStatus();
   }
 
-  if (FLAGS_run_ipv6) {
-    // Pre-compute all the IPv6 requests so they can be sent as quickly as
-    // possible to the switch under test.
-    ASSERT_OK_AND_ASSIGN(
-        P4WriteRequests requests,
-        ComputeIpv6WriteRequests(bitgen, routes, ir_p4info_, number_of_batches,
-                                 requests_per_batch));
-    UpdateRequestMetadata(requests);
-    ASSERT_OK_AND_ASSIGN(absl::Duration insert_time,
-                         SendBatchRequest(requests.inserts));
-    ASSERT_OK_AND_ASSIGN(absl::Duration modify_time,
-                         SendBatchRequest(requests.modifies));
-
-    // Write the results to stdout so that the callers can parse the output.
-    int64_t total_entries = number_of_batches * requests_per_batch;
-    std::cout << absl::StreamFormat(
-        "ipv6_requests=%d ipv6_entry_total=%lld "
-        "ipv6_insert_time=%lld(msecs) ipv6_modify_time=%lld(msecs) ",
-        number_of_batches, total_entries,
-        absl::ToInt64Milliseconds(insert_time),
-        absl::ToInt64Milliseconds(modify_time));
-    if (FLAGS_cleanup) {
-      ASSERT_OK_AND_ASSIGN(absl::Duration delete_time,
-                           SendBatchRequest(requests.deletes));
-      std::cout << absl::StreamFormat("ipv6_delete_time=%lld(msecs) ",
-                                      absl::ToInt64Milliseconds(delete_time));
+ private:
+  // Set connection & switch IDs so the request will not be rejected.
+  void UpdateRequestMetadata(std::vector<p4::v1::WriteRequest>& requests) {
+    for (auto& request : requests) {
+      request.set_device_id(session_->DeviceId());
+      request.set_role(session_->Role());
+      *request.mutable_election_id() = session_->ElectionId();
     }
-    std::cout << std::endl;
   }
 
-  int members_per_group = FLAGS_wcmp_members_per_group;
-  int total_group_weight = FLAGS_wcmp_total_group_weight;
-  if (FLAGS_run_wcmp) {
-    // Pre-compute all the WCMP requests so they can be sent as quickly as
-    // possible to the switch under test.
-    ASSERT_OK_AND_ASSIGN(
-        P4WriteRequests requests,
-        ComputeWcmpWriteRequests(
-            bitgen, routes, ir_p4info_, number_of_batches, requests_per_batch,
-            members_per_group, /*randomize_weights=*/true, total_group_weight));
-    UpdateRequestMetadata(requests);
-    ASSERT_OK_AND_ASSIGN(absl::Duration insert_time,
-                         SendBatchRequest(requests.inserts));
-    ASSERT_OK_AND_ASSIGN(absl::Duration modify_time,
-                         SendBatchRequest(requests.modifies));
-
-    // Write the results to stdout so that callers can parse the output.
-    int64_t total_groups = number_of_batches * requests_per_batch;
-    int64_t total_members = total_groups * members_per_group;
-    int64_t total_weight = total_groups * total_group_weight;
-    std::cout << absl::StreamFormat(
-        "wcmp_requests=%d wcmp_groups_total=%lld "
-        "wcmp_members_total=%lld wcmp_weight_total=%lld "
-        "wcmp_insert_time=%lld(msecs) wcmp_modify_time=%lld(msecs) ",
-        number_of_batches, total_groups, total_members, total_weight,
-        absl::ToInt64Milliseconds(insert_time),
-        absl::ToInt64Milliseconds(modify_time));
-    if (FLAGS_cleanup) {
-      ASSERT_OK_AND_ASSIGN(absl::Duration delete_time,
-                           SendBatchRequest(requests.deletes));
-      std::cout << absl::StreamFormat("wcmp_delete_time=%lld(msecs) ",
-                                      absl::ToInt64Milliseconds(delete_time));
+  void UpdateRequestMetadata(P4WriteRequests& requests) {
+    UpdateRequestMetadata(requests.inserts);
+    UpdateRequestMetadata(requests.modifies);
+    UpdateRequestMetadata(requests.deletes);
+  }
+
+  // Sends independent write requests keeping up to `concurrency_` of them in
+  // flight, and records the result.
+  absl::Status Send(absl::string_view workload, absl::string_view operation,
+                    int batch_size,
+                    absl::Span<const p4::v1::WriteRequest> requests) {
+    OperationResult result{
+        .workload = std::string(workload),
+        .operation = std::string(operation),
+        .batch_size = batch_size,
+        .num_requests = static_cast<int64_t>(requests.size()),
+    };
+    for (const auto& request : requests) {
+      result.num_updates += request.updates_size();
     }
-    std::cout << std::endl;
+
+    const absl::Duration interval = arrival_rate_ > 0
+                                        ? absl::Seconds(1 / arrival_rate_)
+                                        : absl::ZeroDuration();
+    absl::Mutex mutex;
+    // Guarded by `mutex`. Requests are started in order, so every request that
+    // is not sent comes after the one that failed.
+    int next_request = 0;
+    int failed_request = -1;
+    absl::Status failure;
+
+    const absl::Time start = absl::Now();
+    auto send_requests = [&]() {
+      LatencyHistogram latency;
+      LatencyHistogram service_time;
+      while (true) {
+        int index;
+        {
+          absl::MutexLock lock(&mutex);
+          if (!failure.ok() || next_request == requests.size()) break;
+          index = next_request++;
+        }
+
+        // Open-loop requests are scheduled at a fixed rate from the start,
+        // while closed-loop requests are sent as soon as a worker is free.
+        absl::Time scheduled = absl::Now();
+        if (interval > absl::ZeroDuration()) {
+          const absl::Time now = scheduled;
+          scheduled = start + interval * index;
+          if (now < scheduled) absl::SleepFor(scheduled - now);
+        }
+        const absl::Time sent = absl::Now();
+        absl::Status status = session_->Write(requests[index]);
+        const absl::Time completed = absl::Now();
+
+        // We don't expect any errors. So if we see one we invalidate the run.
+        if (!status.ok()) {
+          absl::MutexLock lock(&mutex);
+          if (failure.ok()) {
+            failure = std::move(status);
+            failed_request = index;
+          }
+          break;
+        }
+        latency.Record(completed - scheduled);
+        service_time.Record(completed - sent);
+      }
+
+      absl::MutexLock lock(&mutex);
+      result.latency.Merge(latency);
+      result.service_time.Merge(service_time);
+    };
+
+    // The calling thread sends requests too, so a concurrency of 1 sends the
+    // requests sequentially without spawning threads.
+    const int num_threads = std::min<int>(concurrency_, requests.size());
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; ++i) threads.emplace_back(send_requests);
+    send_requests();
+    for (std::thread& thread : threads) thread.join();
+    result.wall_time = absl::Now() - start;
+
+    RETURN_IF_ERROR(failure)
+        << "in " << workload << " " << operation << " write request "
+        << failed_request << " of " << requests.size();
+    LOG(INFO) << absl::StreamFormat(
+        "%s %s batch_size=%d updates=%d time=%d(msecs) latency: %s", workload,
+        operation, batch_size, result.num_updates,
+        absl::ToInt64Milliseconds(result.wall_time), result.latency.Summary());
+    results_.push_back(std::move(result));
+    return absl::OkStatus();
   }
 
-  if (FLAGS_run_encap) {
-    int total_tunnels =
-        number_of_batches * requests_per_batch * members_per_group;
-
-    ASSERT_OK_AND_ASSIGN(
-        P4WriteRequests encap_neighbor_requests,
-        ComputeEncapNeighbors(bitgen, routes, ir_p4info_, number_of_batches,
-                              number_of_encaps));
-    UpdateRequestMetadata(encap_neighbor_requests);
-    ASSERT_OK_AND_ASSIGN(absl::Duration encap_neighbor_insert_time,
-                         SendBatchRequest(encap_neighbor_requests.inserts));
-
-    // Pre-compute all the Tunnel encap requests so they can be sent as quickly
-    // as possible to the switch under test.
-    ASSERT_OK_AND_ASSIGN(
-        P4WriteRequests encap_requests,
-        ComputeEncapWriteRequests(bitgen, routes, ir_p4info_, number_of_batches,
-                                  number_of_encaps));
-    UpdateRequestMetadata(encap_requests);
-    ASSERT_OK_AND_ASSIGN(absl::Duration encap_insert_time,
-                         SendBatchRequest(encap_requests.inserts));
-
-    ASSERT_OK_AND_ASSIGN(P4WriteRequests wcmp_requests,
-                         ComputeWcmpWriteRequests(
-                             bitgen, routes, ir_p4info_, number_of_batches,
-                             requests_per_batch, members_per_group,
-                             /*randomize_weights=*/false, total_group_weight));
-    UpdateRequestMetadata(wcmp_requests);
-    ASSERT_OK_AND_ASSIGN(absl::Duration wcmp_insert_time,
-                         SendBatchRequest(wcmp_requests.inserts));
-
-    int64_t total_groups = number_of_batches * requests_per_batch;
-    std::cout << absl::StreamFormat(
-        "encap_entry_total=%d wcmp_total_groups=%lld "
-        "encap_insert_time=%lld(msecs) wcmp_insert_time=%lld(msecs) ",
-        total_tunnels, total_groups,
-        absl::ToInt64Milliseconds(encap_insert_time) +
-            absl::ToInt64Milliseconds(encap_neighbor_insert_time),
-        absl::ToInt64Milliseconds(wcmp_insert_time));
-    if (FLAGS_cleanup) {
-      ASSERT_OK_AND_ASSIGN(absl::Duration wcmp_delete_time,
-                           SendBatchRequest(wcmp_requests.deletes));
-
-      ASSERT_OK_AND_ASSIGN(absl::Duration encap_delete_time,
-                           SendBatchRequest(encap_requests.deletes));
-
-      ASSERT_OK_AND_ASSIGN(absl::Duration encap_neighbor_delete_time,
-                           SendBatchRequest(encap_neighbor_requests.deletes));
-      // Write the results to stdout so that callers can parse the output.
-      std::cout << absl::StreamFormat(
-          "encap_delete_time=%lld(msecs) wcmp_delete_time=%lld(msecs) ",
-          absl::ToInt64Milliseconds(encap_delete_time) +
-              absl::ToInt64Milliseconds(encap_neighbor_delete_time),
-          absl::ToInt64Milliseconds(wcmp_delete_time));
+  std::unique_ptr<pdpi::P4RuntimeSession> session_;
+  const int concurrency_;
+  const double arrival_rate_;
+  std::vector<OperationResult> results_;
+};
+
+// Returns the workloads selected by `--workloads` and the deprecated `--run_*`
+// flags, in the order they should run.
+absl::StatusOr<std::vector<std::string>> GetWorkloads() {
+  std::vector<std::string> workloads;
+  auto add_workload = [&](absl::string_view workload) {
+    if (std::find(workloads.begin(), workloads.end(), workload) ==
+        workloads.end()) {
+      workloads.push_back(std::string(workload));
+    }
+  };
+  for (absl::string_view workload :
+       absl::StrSplit(FLAGS_workloads, ',', absl::SkipWhitespace())) {
+    std::string name =
+        absl::AsciiStrToLower(absl::StripAsciiWhitespace(workload));
+    if (name != "ipv4" && name != "ipv6" && name != "nexthop" &&
+        name != "wcmp" && name != "encap" && name != "mixed") {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unsupported workload '" << name
+             << "'. Expected one of: ipv4, ipv6, nexthop, wcmp, encap or "
+                "mixed.";
     }
-    std::cout << std::endl;
+    add_workload(name);
+  }
+  if (FLAGS_run_ipv4) add_workload("ipv4");
+  if (FLAGS_run_ipv6) add_workload("ipv6");
+  if (FLAGS_run_wcmp) add_workload("wcmp");
+  if (FLAGS_run_encap) add_workload("encap");
+
+  if (workloads.empty()) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "No workloads were selected. Use --workloads.";
   }
+  // Tunnel next hops replace the regular next hops that the other workloads
+  // rely on.
+  if (workloads.size() > 1 &&
+      std::find(workloads.begin(), workloads.end(), "encap") !=
+          workloads.end()) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "The encap workload cannot be combined with other workloads.";
+  }
+  return workloads;
+}
+
+// Returns the batch sizes to sweep over.
+absl::StatusOr<std::vector<int>> GetBatchSizes() {
+  if (FLAGS_batch_sizes.empty()) return std::vector<int>{FLAGS_batch_size};
+
+  std::vector<int> batch_sizes;
+  for (absl::string_view str :
+       absl::StrSplit(FLAGS_batch_sizes, ',', absl::SkipWhitespace())) {
+    int batch_size = 0;
+    if (!absl::SimpleAtoi(str, &batch_size) || batch_size <= 0) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Batch sizes must be positive integers: '" << str << "'.";
+    }
+    batch_sizes.push_back(batch_size);
+  }
+  return batch_sizes;
+}
+
+absl::StatusOr<std::vector<WorkloadRequests>> ComputeWorkload(
+    absl::string_view workload, absl::BitGen& bitgen,
+    const RouteEntryInfo& routes, const pdpi::IrP4Info& ir_p4info,
+    int batch_size, const absl::btree_map<std::string, int>& mixed_weights) {
+  const uint32_t number_batches = FLAGS_number_batches;
+  std::vector<WorkloadRequests> requests;
+  if (workload == "ipv4") {
+    ASSIGN_OR_RETURN(requests.emplace_back().requests,
+                     ComputeIpv4WriteRequests(bitgen, routes, ir_p4info,
+                                              number_batches, batch_size));
+  } else if (workload == "ipv6") {
+    ASSIGN_OR_RETURN(requests.emplace_back().requests,
+                     ComputeIpv6WriteRequests(bitgen, routes, ir_p4info,
+                                              number_batches, batch_size));
+  } else if (workload == "nexthop") {
+    ASSIGN_OR_RETURN(requests.emplace_back().requests,
+                     ComputeNextHopWriteRequests(bitgen, routes, ir_p4info,
+                                                 number_batches, batch_size));
+  } else if (workload == "wcmp") {
+    ASSIGN_OR_RETURN(
+        requests.emplace_back().requests,
+        ComputeWcmpWriteRequests(
+            bitgen, routes, ir_p4info, number_batches, batch_size,
+            FLAGS_wcmp_members_per_group, /*randomize_weights=*/true,
+            FLAGS_wcmp_total_group_weight));
+  } else if (workload == "mixed") {
+    ASSIGN_OR_RETURN(
+        requests.emplace_back().requests,
+        ComputeMixedWriteRequests(bitgen, routes, ir_p4info, number_batches,
+                                  batch_size, mixed_weights));
+  } else {
+    // Tunnel encaps add their own neighbors and next hops, so every sweep
+    // starts from the shared prerequisites.
+    RouteEntryInfo encap_routes = routes;
+    WorkloadRequests& neighbors = requests.emplace_back();
+    neighbors.workload = "encap_neighbor";
+    neighbors.modify_supported = false;
+    ASSIGN_OR_RETURN(neighbors.requests,
+                     ComputeEncapNeighbors(bitgen, encap_routes, ir_p4info,
+                                           number_batches, FLAGS_encaps));
+    WorkloadRequests& tunnels = requests.emplace_back();
+    tunnels.workload = "encap_tunnel";
+    tunnels.modify_supported = false;
+    ASSIGN_OR_RETURN(tunnels.requests,
+                     ComputeEncapWriteRequests(bitgen, encap_routes, ir_p4info,
+                                               number_batches, FLAGS_encaps));
+    WorkloadRequests& groups = requests.emplace_back();
+    groups.workload = "encap_wcmp";
+    groups.modify_supported = false;
+    ASSIGN_OR_RETURN(
+        groups.requests,
+        ComputeWcmpWriteRequests(
+            bitgen, encap_routes, ir_p4info, number_batches, batch_size,
+            FLAGS_wcmp_members_per_group, /*randomize_weights=*/false,
+            FLAGS_wcmp_total_group_weight));
+    return requests;
+  }
+  requests.back().workload = std::string(workload);
+  return requests;
+}
+
+nlohmann::json LatencyHistogramToJson(const LatencyHistogram& histogram) {
+  nlohmann::json json;
+  json["count"] = histogram.count();
+  json["mean_us"] =
+      histogram.count() == 0
+          ? 0
+          : absl::ToInt64Microseconds(histogram.sum()) / histogram.count();
+  json["p50_us"] = absl::ToInt64Microseconds(histogram.Percentile(50));
+  json["p90_us"] = absl::ToInt64Microseconds(histogram.Percentile(90));
+  json["p99_us"] = absl::ToInt64Microseconds(histogram.Percentile(99));
+  json["p999_us"] = absl::ToInt64Microseconds(histogram.Percentile(99.9));
+  json["max_us"] = absl::ToInt64Microseconds(histogram.max());
+
+  // Only the non-empty buckets are reported to keep the output short.
+  nlohmann::json buckets = nlohmann::json::array();
+  for (int i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+    if (histogram.bucket_count(i) == 0) continue;
+    buckets.push_back({
+        {"lower_bound_us", LatencyHistogram::BucketLowerBound(i)},
+        {"count", histogram.bucket_count(i)},
+    });
+  }
+  json["buckets"] = std::move(buckets);
+  return json;
+}
+
+nlohmann::json OperationResultToJson(const OperationResult& result) {
+  const double seconds = absl::ToDoubleSeconds(result.wall_time);
+  nlohmann::json json;
+  json["workload"] = result.workload;
+  json["operation"] = result.operation;
+  json["batch_size"] = result.batch_size;
+  json["requests"] = result.num_requests;
+  json["updates"] = result.num_updates;
+  json["wall_time_ms"] = absl::ToDoubleMilliseconds(result.wall_time);
+  json["requests_per_second"] =
+      seconds > 0 ? result.num_requests / seconds : 0.0;
+  json["updates_per_second"] = seconds > 0 ? result.num_updates / seconds : 0.0;
+  json["latency"] = LatencyHistogramToJson(result.latency);
+  json["service_time"] = LatencyHistogramToJson(result.service_time);
+  return json;
+}
+
+absl::Status Main() {
+  ASSIGN_OR_RETURN(std::vector<std::string> workloads, GetWorkloads());
+  ASSIGN_OR_RETURN(std::vector<int> batch_sizes, GetBatchSizes());
+  ASSIGN_OR_RETURN(auto mixed_weights,
+                   ParseMixedWorkloadWeights(FLAGS_mixed_workload_weights));
+  if (FLAGS_concurrency <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "--concurrency must be positive: " << FLAGS_concurrency;
+  }
+  if (FLAGS_arrival_rate < 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "--arrival_rate must not be negative: " << FLAGS_arrival_rate;
+  }
+
+  // Randomly generate the routes that will be used by the workloads.
+  const std::vector<int> seed = GetSeedSeq();
+  std::seed_seq seed_seq(seed.begin(), seed.end());
+  absl::BitGen bitgen(seed_seq);
+
+  ASSIGN_OR_RETURN(std::unique_ptr<pdpi::P4RuntimeSession> session,
+                   OpenP4RuntimeSession());
+  ASSIGN_OR_RETURN(pdpi::IrP4Info ir_p4info,
+                   GetExistingP4InfoOrSetDefault(
+                       *session, sai::Instantiation::kMiddleblock));
+  // Clear the current table entries, if any.
+  RETURN_IF_ERROR(pdpi::ClearEntities(*session));
+  LoadGenerator generator(std::move(session), FLAGS_concurrency,
+                          FLAGS_arrival_rate);
+
+  RouteEntryInfo routes;
+  ASSIGN_OR_RETURN(routes.port_ids, ParsePortIds(FLAGS_port_ids));
+  RETURN_IF_ERROR(GenerateRandomRIFs(bitgen, routes, ir_p4info, FLAGS_rifs));
+  RETURN_IF_ERROR(GenerateRandomVrfs(bitgen, routes, ir_p4info, FLAGS_vrfs));
+  // Tunnel nexthops are created differently later.
+  if (workloads != std::vector<std::string>{"encap"}) {
+    RETURN_IF_ERROR(
+        GenerateRandomNextHops(bitgen, routes, ir_p4info, FLAGS_next_hops));
+  }
+
+  std::vector<p4::v1::WriteRequest> prerequisites(4);
+  AppendUpdatesToWriteRequest(prerequisites[0], routes.vrfs_by_name);
+  AppendUpdatesToWriteRequest(prerequisites[1],
+                              routes.router_interfaces_by_name);
+  AppendUpdatesToWriteRequest(prerequisites[2], routes.neighbors_by_name);
+  AppendUpdatesToWriteRequest(prerequisites[3], routes.next_hops_by_name);
+  RETURN_IF_ERROR(generator.InstallPrerequisites(std::move(prerequisites)));
+
+  for (int i = 0; i < batch_sizes.size(); ++i) {
+    for (int j = 0; j < workloads.size(); ++j) {
+      // Pre-compute all the requests so they can be sent as quickly as
+      // possible to the switch under test.
+      ASSIGN_OR_RETURN(std::vector<WorkloadRequests> requests,
+                       ComputeWorkload(workloads[j], bitgen, routes, ir_p4info,
+                                       batch_sizes[i], mixed_weights));
+
+      // Entries are always deleted before the next run so that runs do not
+      // collide. Only the entries of the last run are kept without --cleanup.
+      const bool last_run =
+          i + 1 == batch_sizes.size() && j + 1 == workloads.size();
+      RETURN_IF_ERROR(generator.Measure(std::move(requests), batch_sizes[i],
+                                        FLAGS_cleanup || !last_run));
+    }
+  }
+
+  if (FLAGS_cleanup) {
+    RETURN_IF_ERROR(pdpi::ClearEntities(generator.session()));
+  }
+
+  nlohmann::json json;
+  json["config"] = {
+      {"p4info_version", ir_p4info.pkg_info().version()},
+      {"workloads", workloads},
+      {"batch_sizes", batch_sizes},
+      {"number_batches", FLAGS_number_batches},
+      {"concurrency", FLAGS_concurrency},
+      {"arrival_rate", FLAGS_arrival_rate},
+      {"mixed_workload_weights", mixed_weights},
+      {"vrfs", FLAGS_vrfs},
+      {"rifs", FLAGS_rifs},
+      {"next_hops", FLAGS_next_hops},
+      {"encaps", FLAGS_encaps},
+      {"wcmp_members_per_group", FLAGS_wcmp_members_per_group},
+      {"wcmp_total_group_weight", FLAGS_wcmp_total_group_weight},
+      {"seed_seq", absl::StrJoin(seed, ",")},
+  };
+  json["results"] = nlohmann::json::array();
+  for (const OperationResult& result : generator.results()) {
+    json["results"].push_back(OperationResultToJson(result));
+  }
+
+  if (FLAGS_output_file.empty()) {
+    std::cout << json.dump(/*indent=*/2) << std::endl;
+    return absl::OkStatus();
+  }
+  return gutil::WriteFile(json.dump(/*indent=*/2), FLAGS_output_file);
 }
 
 }  // namespace
 }  // namespace p4rt_app
 
-// Temporary fix to have performance tests run nightly until we find a way to
-// bring p4rt_test_main.cc to p4rt_app specific tests alone.
-GTEST_API_ int main(int argc, char** argv) {
-  gflags::ParseCommandLineFlags(&argc, &argv, true);
+int main(int argc, char** argv) {
   google::InitGoogleLogging(argv[0]);
-  testing::InitGoogleTest(&argc, argv);
-  return RUN_ALL_TESTS();
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  absl::Status status = p4rt_app::Main();
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return status.raw_code();
+  }
+  return 0;
 }
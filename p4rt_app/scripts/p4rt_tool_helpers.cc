@@ -15,12 +15,21 @@
 
 #include <iostream>
 #include <memory>
+#include <string>
 
+#include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "gflags/gflags.h"
 #include "grpcpp/security/credentials.h"
+#include "gutil/proto.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
 
 DEFINE_string(p4rt_server_address, "unix:/sock/p4rt.sock",
@@ -55,4 +64,44 @@ absl::StatusOr<std::unique_ptr<pdpi::P4RuntimeSession>> CreateP4rtSession() {
   return pdpi::P4RuntimeSession::Create(std::move(stub), FLAGS_p4rt_device_id);
 }
 
+absl::StatusOr<std::unique_ptr<EntityFileReader>> EntityFileReader::Open(
+    const std::string& path, const pdpi::IrP4Info& ir_p4info) {
+  auto reader = absl::WrapUnique(new EntityFileReader(path, ir_p4info));
+  if (absl::EndsWith(path, gutil::kBinaryProtoFileExtension)) {
+    ASSIGN_OR_RETURN(reader->binary_reader_,
+                     gutil::DelimitedProtoFileReader::Open(path));
+  } else {
+    reader->text_file_.open(path);
+    if (!reader->text_file_.is_open()) {
+      return gutil::NotFoundErrorBuilder()
+             << "Could not open '" << path << "'.";
+    }
+  }
+  return reader;
+}
+
+absl::StatusOr<bool> EntityFileReader::ReadNext(p4::v1::Entity& entity) {
+  if (binary_reader_ != nullptr) return binary_reader_->ReadNext(entity);
+
+  std::string text;
+  std::string line;
+  while (std::getline(text_file_, line)) {
+    if (absl::StrContains(line, "***")) {
+      if (text.empty()) continue;
+      break;
+    }
+    absl::StrAppend(&text, line, "\n");
+  }
+  if (text.empty()) return false;
+
+  ++num_text_entities_;
+  pdpi::IrEntity ir_entity;
+  RETURN_IF_ERROR(gutil::ReadProtoFromString(text, &ir_entity))
+      << "in entity " << num_text_entities_ << " of '" << path_ << "'";
+  ASSIGN_OR_RETURN(entity, pdpi::IrEntityToPi(ir_p4info_, ir_entity),
+                   _ << "in entity " << num_text_entities_ << " of '" << path_
+                     << "'");
+  return true;
+}
+
 }  // namespace p4rt_app
@@ -14,11 +14,17 @@
 #ifndef PINS_P4RT_APP_SCRIPTS_P4RT_TOOL_HELPERS_H_
 #define PINS_P4RT_APP_SCRIPTS_P4RT_TOOL_HELPERS_H_
 
+#include <fstream>
 #include <memory>
+#include <string>
+#include <utility>
 
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "gflags/gflags.h"
+#include "gutil/proto.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
 
 // Flags to configure the P4RT connection.
@@ -38,6 +44,32 @@ void Error(absl::string_view message);    // red color to stderr
 
 absl::StatusOr<std::unique_ptr<pdpi::P4RuntimeSession>> CreateP4rtSession();
 
+// Streams the entities of a file one at a time, so large files (e.g. backups of
+// a switch) never have to be held in memory. Files ending in
+// `gutil::kBinaryProtoFileExtension` hold length-delimited p4::v1::Entity
+// messages. Other files hold pdpi::IrEntity text protos separated by lines
+// containing '***'.
+class EntityFileReader {
+ public:
+  static absl::StatusOr<std::unique_ptr<EntityFileReader>> Open(
+      const std::string& path, const pdpi::IrP4Info& ir_p4info);
+
+  // Reads the next entity. Returns false at the end of the file.
+  absl::StatusOr<bool> ReadNext(p4::v1::Entity& entity);
+
+ private:
+  EntityFileReader(std::string path, const pdpi::IrP4Info& ir_p4info)
+      : path_(std::move(path)), ir_p4info_(ir_p4info) {}
+
+  const std::string path_;
+  const pdpi::IrP4Info& ir_p4info_;
+  // Set for binary files.
+  std::unique_ptr<gutil::DelimitedProtoFileReader> binary_reader_;
+  // Used for text files.
+  std::ifstream text_file_;
+  int num_text_entities_ = 0;
+};
+
 }  // namespace p4rt_app
 
 #endif  // PINS_P4RT_APP_SCRIPTS_P4RT_TOOL_HELPERS_H_
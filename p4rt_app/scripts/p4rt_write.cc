@@ -11,12 +11,20 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/flags/parse.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "grpcpp/client_context.h"
@@ -28,6 +36,7 @@
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
 #include "p4rt_app/scripts/p4rt_tool_helpers.h"
+#include "p4rt_app/utils/latency_histogram.h"
 
 // Flags to write table updates.
 DEFINE_string(ir_write_request_file, "",
@@ -35,6 +44,28 @@ DEFINE_string(ir_write_request_file, "",
               "P4RT service.");
 DEFINE_bool(force_delete, false, "Forces all write reqests to be deletes.");
 
+// Bulk mode is meant for restoring large amounts of state (e.g. a backup of
+// 100k entries). Entities are streamed from the file a chunk at a time, so the
+// file is never held in memory as a whole. Every chunk is sequenced into
+// dependency layers, and each layer is sent as pipelined batches. Entities may
+// depend on entities of earlier chunks, but not on those of later ones (i.e.
+// the file must be in dependency order, which backups are).
+DEFINE_string(bulk_entities_file, "",
+              "Streams entities from a file and writes them to the P4RT "
+              "service in pipelined batches. Files ending in '.binpb' hold "
+              "length-delimited p4::v1::Entity messages. Other files hold "
+              "pdpi::IrEntity text protos separated by lines of '***'.");
+DEFINE_string(bulk_update_type, "INSERT",
+              "The update type used in bulk mode: INSERT or MODIFY.");
+DEFINE_int32(bulk_chunk_size, 10000,
+             "The number of entities read and sequenced at a time in bulk "
+             "mode.");
+DEFINE_int32(bulk_batch_size, 1000,
+             "The maximum number of updates in one write request in bulk "
+             "mode.");
+DEFINE_int32(bulk_max_outstanding_requests, 8,
+             "The maximum number of write requests in flight in bulk mode.");
+
 namespace p4rt_app {
 namespace {
 
@@ -69,6 +100,70 @@ absl::Status SendWriteRequest(pdpi::P4RuntimeSession& session,
   return session.Write(pi_write_request);
 }
 
+absl::Status SendBulkEntities(pdpi::P4RuntimeSession& session,
+                              const pdpi::IrP4Info& ir_p4info) {
+  if (FLAGS_force_delete) {
+    // Deleting has to follow the reverse dependency order, which would require
+    // reading the whole file first.
+    return gutil::InvalidArgumentErrorBuilder()
+           << "--force_delete is not supported with --bulk_entities_file.";
+  }
+  p4::v1::Update::Type type;
+  if (!p4::v1::Update::Type_Parse(FLAGS_bulk_update_type, &type) ||
+      (type != p4::v1::Update::INSERT && type != p4::v1::Update::MODIFY)) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "--bulk_update_type must be INSERT or MODIFY, but got '"
+           << FLAGS_bulk_update_type << "'.";
+  }
+  if (FLAGS_bulk_chunk_size <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "--bulk_chunk_size must be positive: " << FLAGS_bulk_chunk_size;
+  }
+  const pdpi::PipelinedWriteOptions options{
+      .max_outstanding_requests = FLAGS_bulk_max_outstanding_requests,
+      .max_batch_size = FLAGS_bulk_batch_size,
+  };
+
+  ASSIGN_OR_RETURN(std::unique_ptr<EntityFileReader> reader,
+                   EntityFileReader::Open(FLAGS_bulk_entities_file, ir_p4info));
+  const absl::Time start = absl::Now();
+  LatencyHistogram batch_latency;
+  int64_t num_written = 0;
+  std::vector<p4::v1::Update> updates;
+  bool end_of_file = false;
+  while (!end_of_file) {
+    updates.clear();
+    while (updates.size() < FLAGS_bulk_chunk_size) {
+      p4::v1::Update update;
+      ASSIGN_OR_RETURN(bool has_entity,
+                       reader->ReadNext(*update.mutable_entity()));
+      if (!has_entity) {
+        end_of_file = true;
+        break;
+      }
+      update.set_type(type);
+      updates.push_back(std::move(update));
+    }
+    if (updates.empty()) break;
+
+    ASSIGN_OR_RETURN(
+        std::vector<pdpi::WriteBatchLatency> latencies,
+        pdpi::SendPiUpdatesPipelined(session, ir_p4info, updates, options),
+        _ << "after successfully writing " << num_written << " entities");
+    for (const pdpi::WriteBatchLatency& latency : latencies) {
+      batch_latency.Record(latency.latency);
+    }
+    num_written += updates.size();
+
+    const absl::Duration elapsed = absl::Now() - start;
+    Info(absl::StrFormat("Wrote %d entities in %s (%.0f entities/s).",
+                         num_written, absl::FormatDuration(elapsed),
+                         num_written / absl::ToDoubleSeconds(elapsed)));
+  }
+  Info(absl::StrCat("Write request latency: ", batch_latency.Summary()));
+  return absl::OkStatus();
+}
+
 absl::Status Main() {
   // Connect to the P4RT server.
   ASSIGN_OR_RETURN(std::unique_ptr<pdpi::P4RuntimeSession> session,
@@ -78,6 +173,10 @@ absl::Status Main() {
   // to an IR.
   ASSIGN_OR_RETURN(pdpi::IrP4Info ir_p4info, GetIrP4infoFromSwitch(*session));
 
+  if (!FLAGS_bulk_entities_file.empty()) {
+    return SendBulkEntities(*session, ir_p4info);
+  }
+
   // Create the write request.
   ASSIGN_OR_RETURN(p4::v1::WriteRequest pi_write_request,
                    GetPiWriteRequest(ir_p4info));
@@ -0,0 +1,253 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/acl_table_definition_cache.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "gutil/status.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/sonic/app_db_acl_def_table_manager.h"
+#include "p4rt_app/utils/table_utility.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+constexpr char kCacheMagic[] = "P4RTACLDEF";
+constexpr int kCacheMagicSize = sizeof(kCacheMagic) - 1;
+constexpr uint32_t kCacheVersion = 1;
+
+void WriteString(google::protobuf::io::CodedOutputStream& output,
+                 const std::string& value) {
+  output.WriteVarint32(value.size());
+  output.WriteString(value);
+}
+
+bool ReadString(google::protobuf::io::CodedInputStream& input,
+                std::string& value) {
+  uint32_t size = 0;
+  return input.ReadVarint32(&size) && input.ReadString(&value, size);
+}
+
+// Returns the aliases of every ACL table. Only the @sai_acl annotation is
+// parsed.
+absl::StatusOr<absl::flat_hash_set<std::string>> AclTableNames(
+    const pdpi::IrP4Info& ir_p4info) {
+  absl::flat_hash_set<std::string> names;
+  for (const auto& [name, table] : ir_p4info.tables_by_name()) {
+    ASSIGN_OR_RETURN(table::Type table_type, GetTableType(table));
+    if (table_type == table::Type::kAcl) names.insert(table.preamble().alias());
+  }
+  return names;
+}
+
+}  // namespace
+
+absl::StatusOr<AclTableDefinitions> CompileAclTableDefinitions(
+    const pdpi::IrP4Info& ir_p4info) {
+  AclTableDefinitions definitions;
+  for (const auto& [name, table] : ir_p4info.tables_by_name()) {
+    ASSIGN_OR_RETURN(table::Type table_type, GetTableType(table));
+    if (table_type != table::Type::kAcl) continue;
+
+    ASSIGN_OR_RETURN(definitions[table.preamble().alias()],
+                     CompileAclTableDefinition(table),
+                     _ << "Failed to compile ACL table definition '"
+                       << table.preamble().alias() << "'.");
+  }
+  return definitions;
+}
+
+absl::Status WriteAclTableDefinitionCache(
+    const std::string& path, uint64_t p4info_cookie,
+    const AclTableDefinitions& definitions) {
+  const std::string tmp_path = absl::StrCat(path, ".tmp");
+  std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return gutil::InternalErrorBuilder()
+           << "Could not open ACL table definition cache '" << tmp_path
+           << "' for writing: " << std::strerror(errno);
+  }
+
+  bool serialized = true;
+  {
+    google::protobuf::io::OstreamOutputStream output_stream(&file);
+    google::protobuf::io::CodedOutputStream output(&output_stream);
+
+    output.WriteRaw(kCacheMagic, kCacheMagicSize);
+    output.WriteVarint32(kCacheVersion);
+    output.WriteLittleEndian64(p4info_cookie);
+    output.WriteVarint32(definitions.size());
+    for (const auto& [name, definition] : definitions) {
+      WriteString(output, name);
+      WriteString(output, definition.key);
+      output.WriteVarint32(definition.values.size());
+      for (const auto& [field, value] : definition.values) {
+        WriteString(output, field);
+        WriteString(output, value);
+      }
+    }
+    serialized = !output.HadError();
+  }
+  file.close();
+  if (!serialized || file.fail()) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Failed to write ACL table definition cache '" << tmp_path
+           << "'.";
+  }
+
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Could not move ACL table definition cache to '" << path
+           << "': " << std::strerror(errno);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<AclTableDefinitions> ReadAclTableDefinitionCache(
+    const std::string& path, uint64_t p4info_cookie) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return gutil::NotFoundErrorBuilder()
+           << "Could not open ACL table definition cache '" << path
+           << "': " << std::strerror(errno);
+  }
+  std::stringstream contents;
+  contents << file.rdbuf();
+  const std::string data = contents.str();
+
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(data.data()), data.size());
+
+  std::string magic;
+  uint32_t version = 0;
+  uint64_t cookie = 0;
+  uint32_t table_count = 0;
+  if (!input.ReadString(&magic, kCacheMagicSize) || magic != kCacheMagic ||
+      !input.ReadVarint32(&version)) {
+    return gutil::DataLossErrorBuilder()
+           << "'" << path << "' is not an ACL table definition cache.";
+  }
+  if (version != kCacheVersion) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "ACL table definition cache '" << path << "' has version "
+           << version << ", but only version " << kCacheVersion
+           << " is supported.";
+  }
+  if (!input.ReadLittleEndian64(&cookie) ||
+      !input.ReadVarint32(&table_count)) {
+    return gutil::DataLossErrorBuilder()
+           << "ACL table definition cache '" << path
+           << "' has a corrupt header.";
+  }
+  if (cookie != p4info_cookie) {
+    return gutil::FailedPreconditionErrorBuilder()
+           << "ACL table definition cache '" << path
+           << "' is stale. It was written for P4Info cookie " << cookie
+           << ", but the P4Info has cookie " << p4info_cookie << ".";
+  }
+
+  AclTableDefinitions definitions;
+  for (uint32_t i = 0; i < table_count; ++i) {
+    std::string name;
+    CompiledAclTableDefinition definition;
+    uint32_t value_count = 0;
+    if (!ReadString(input, name) || !ReadString(input, definition.key) ||
+        !input.ReadVarint32(&value_count)) {
+      return gutil::DataLossErrorBuilder()
+             << "ACL table definition cache '" << path
+             << "' is truncated after " << i << " tables.";
+    }
+    for (uint32_t j = 0; j < value_count; ++j) {
+      std::string field;
+      std::string value;
+      if (!ReadString(input, field) || !ReadString(input, value)) {
+        return gutil::DataLossErrorBuilder()
+               << "ACL table definition cache '" << path
+               << "' has a corrupt definition for table '" << name << "'.";
+      }
+      definition.values.push_back({std::move(field), std::move(value)});
+    }
+    if (!definitions.try_emplace(std::move(name), std::move(definition))
+             .second) {
+      return gutil::DataLossErrorBuilder()
+             << "ACL table definition cache '" << path
+             << "' has a duplicate table at index " << i << ".";
+    }
+  }
+  if (input.CurrentPosition() != data.size()) {
+    return gutil::DataLossErrorBuilder()
+           << "ACL table definition cache '" << path
+           << "' has unexpected trailing data.";
+  }
+  return definitions;
+}
+
+absl::StatusOr<AclTableDefinitions> LoadOrCompileAclTableDefinitions(
+    const std::string& path, uint64_t p4info_cookie,
+    const pdpi::IrP4Info& ir_p4info) {
+  // A cookie of 0 means the controller did not set one, so it cannot identify
+  // the P4Info.
+  if (p4info_cookie != 0) {
+    absl::StatusOr<AclTableDefinitions> cached =
+        ReadAclTableDefinitionCache(path, p4info_cookie);
+    if (cached.ok()) {
+      ASSIGN_OR_RETURN(absl::flat_hash_set<std::string> acl_tables,
+                       AclTableNames(ir_p4info));
+      bool same_tables = acl_tables.size() == cached->size();
+      for (const std::string& name : acl_tables) {
+        same_tables = same_tables && cached->contains(name);
+      }
+      if (same_tables) {
+        LOG(INFO) << "Loaded " << cached->size()
+                  << " ACL table definitions from '" << path << "'.";
+        return cached;
+      }
+      LOG(WARNING) << "Ignoring ACL table definition cache '" << path
+                   << "' because it has different ACL tables.";
+    } else {
+      LOG(INFO) << "Not using the ACL table definition cache: "
+                << cached.status();
+    }
+  }
+
+  ASSIGN_OR_RETURN(AclTableDefinitions definitions,
+                   CompileAclTableDefinitions(ir_p4info));
+  if (p4info_cookie != 0) {
+    absl::Status saved =
+        WriteAclTableDefinitionCache(path, p4info_cookie, definitions);
+    LOG_IF(WARNING, !saved.ok())
+        << "Could not save the ACL table definition cache: " << saved;
+  }
+  return definitions;
+}
+
+}  // namespace sonic
+}  // namespace p4rt_app
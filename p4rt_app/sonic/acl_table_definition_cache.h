@@ -0,0 +1,61 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_SONIC_ACL_TABLE_DEFINITION_CACHE_H_
+#define PINS_P4RT_APP_SONIC_ACL_TABLE_DEFINITION_CACHE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/sonic/app_db_acl_def_table_manager.h"
+
+namespace p4rt_app {
+namespace sonic {
+
+// Compiled definitions for every ACL table in a P4Info, keyed by table alias.
+using AclTableDefinitions =
+    absl::flat_hash_map<std::string, CompiledAclTableDefinition>;
+
+// Compiles the definition of every ACL table in the IrP4Info.
+absl::StatusOr<AclTableDefinitions> CompileAclTableDefinitions(
+    const pdpi::IrP4Info& ir_p4info);
+
+// Writes the compiled definitions to a binary file, tagged with the cookie of
+// the P4Info they were compiled from. The file is replaced atomically.
+absl::Status WriteAclTableDefinitionCache(
+    const std::string& path, uint64_t p4info_cookie,
+    const AclTableDefinitions& definitions);
+
+// Reads compiled definitions from a file written by
+// WriteAclTableDefinitionCache. Returns a FailedPrecondition error if the file
+// was written for a different cookie, and a DataLoss error if it is corrupt.
+absl::StatusOr<AclTableDefinitions> ReadAclTableDefinitionCache(
+    const std::string& path, uint64_t p4info_cookie);
+
+// Returns the compiled ACL table definitions for the IrP4Info. When the cache
+// file at `path` was written for the same, non-zero, cookie and has the same
+// set of ACL tables, the definitions are read from it. Otherwise, they are
+// compiled and the cache file is rewritten. Failing to use the cache file is
+// not an error, the definitions are compiled instead.
+absl::StatusOr<AclTableDefinitions> LoadOrCompileAclTableDefinitions(
+    const std::string& path, uint64_t p4info_cookie,
+    const pdpi::IrP4Info& ir_p4info);
+
+}  // namespace sonic
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_SONIC_ACL_TABLE_DEFINITION_CACHE_H_
@@ -0,0 +1,158 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/acl_table_definition_cache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/sonic/app_db_acl_def_table_manager.h"
+#include "p4rt_app/utils/ir_builder.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::testing::Key;
+using ::testing::UnorderedElementsAre;
+
+pdpi::IrTableDefinition AclTable(const std::string& alias) {
+  return IrTableDefinitionBuilder()
+      .preamble(absl::StrCat(R"pb(alias: ")pb", alias,
+                             R"pb(" annotations: "@sai_acl(INGRESS)")pb"))
+      .match_field(
+          R"pb(id: 1
+               name: "in_port"
+               annotations: "@sai_field(SAI_ACL_TABLE_ATTR_FIELD_IN_PORT)")pb",
+          pdpi::STRING)
+      .entry_action(IrActionDefinitionBuilder().preamble(
+          R"pb(alias: "acl_drop"
+               annotations: "@sai_action(SAI_PACKET_ACTION_DROP)")pb"))
+      .size(10)();
+}
+
+pdpi::IrP4Info P4InfoWithTables() {
+  pdpi::IrP4Info ir_p4info;
+  (*ir_p4info.mutable_tables_by_name())["acl_a"] = AclTable("acl_a");
+  (*ir_p4info.mutable_tables_by_name())["acl_b"] = AclTable("acl_b");
+  (*ir_p4info.mutable_tables_by_name())["vrf_table"] =
+      IrTableDefinitionBuilder().preamble(R"pb(alias: "vrf_table")pb")();
+  return ir_p4info;
+}
+
+class AclTableDefinitionCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    const char* test_tmpdir = std::getenv("TEST_TMPDIR");
+    ASSERT_NE(test_tmpdir, nullptr)
+        << "Could not find environment variable ${TEST_TMPDIR}.";
+    path_ = absl::StrCat(test_tmpdir, "/", test_info_->name(), ".acl_cache");
+  }
+
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  std::string path_;
+};
+
+TEST_F(AclTableDefinitionCacheTest, CompilesOnlyAclTables) {
+  EXPECT_THAT(CompileAclTableDefinitions(P4InfoWithTables()),
+              IsOkAndHolds(UnorderedElementsAre(Key("acl_a"), Key("acl_b"))));
+}
+
+TEST_F(AclTableDefinitionCacheTest, RoundTripsDefinitions) {
+  ASSERT_OK_AND_ASSIGN(AclTableDefinitions definitions,
+                       CompileAclTableDefinitions(P4InfoWithTables()));
+  ASSERT_OK(WriteAclTableDefinitionCache(path_, /*p4info_cookie=*/7,
+                                         definitions));
+
+  ASSERT_OK_AND_ASSIGN(AclTableDefinitions cached,
+                       ReadAclTableDefinitionCache(path_, /*p4info_cookie=*/7));
+  EXPECT_EQ(cached, definitions);
+}
+
+TEST_F(AclTableDefinitionCacheTest, RejectsADifferentCookie) {
+  ASSERT_OK(WriteAclTableDefinitionCache(path_, /*p4info_cookie=*/7, {}));
+  EXPECT_THAT(ReadAclTableDefinitionCache(path_, /*p4info_cookie=*/8),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_F(AclTableDefinitionCacheTest, RejectsACorruptFile) {
+  std::ofstream(path_) << "P4RTACLDEF garbage";
+  EXPECT_THAT(ReadAclTableDefinitionCache(path_, /*p4info_cookie=*/7),
+              StatusIs(absl::StatusCode::kDataLoss));
+}
+
+TEST_F(AclTableDefinitionCacheTest, LoadsDefinitionsForTheSameCookie) {
+  // Cache a definition that differs from what would be compiled, so we can
+  // tell the cache was used.
+  CompiledAclTableDefinition cached_definition = {
+      .key = "ACL_TABLE_DEFINITION_TABLE:ACL_A", .values = {{"from", "cache"}}};
+  ASSERT_OK(WriteAclTableDefinitionCache(
+      path_, /*p4info_cookie=*/7,
+      {{"acl_a", cached_definition}, {"acl_b", cached_definition}}));
+
+  ASSERT_OK_AND_ASSIGN(
+      AclTableDefinitions definitions,
+      LoadOrCompileAclTableDefinitions(path_, /*p4info_cookie=*/7,
+                                       P4InfoWithTables()));
+  EXPECT_EQ(definitions.at("acl_a"), cached_definition);
+}
+
+TEST_F(AclTableDefinitionCacheTest, CompilesAndSavesOnACacheMiss) {
+  ASSERT_OK_AND_ASSIGN(
+      AclTableDefinitions definitions,
+      LoadOrCompileAclTableDefinitions(path_, /*p4info_cookie=*/7,
+                                       P4InfoWithTables()));
+  ASSERT_OK_AND_ASSIGN(CompiledAclTableDefinition expected,
+                       CompileAclTableDefinition(AclTable("acl_a")));
+  EXPECT_EQ(definitions.at("acl_a"), expected);
+
+  EXPECT_THAT(ReadAclTableDefinitionCache(path_, /*p4info_cookie=*/7),
+              IsOkAndHolds(definitions));
+}
+
+TEST_F(AclTableDefinitionCacheTest, RecompilesWhenTheAclTablesDiffer) {
+  CompiledAclTableDefinition cached_definition = {
+      .key = "ACL_TABLE_DEFINITION_TABLE:ACL_A", .values = {{"from", "cache"}}};
+  ASSERT_OK(WriteAclTableDefinitionCache(path_, /*p4info_cookie=*/7,
+                                         {{"acl_a", cached_definition}}));
+
+  ASSERT_OK_AND_ASSIGN(
+      AclTableDefinitions definitions,
+      LoadOrCompileAclTableDefinitions(path_, /*p4info_cookie=*/7,
+                                       P4InfoWithTables()));
+  EXPECT_THAT(definitions, UnorderedElementsAre(Key("acl_a"), Key("acl_b")));
+  EXPECT_FALSE(definitions.at("acl_a") == cached_definition);
+}
+
+TEST_F(AclTableDefinitionCacheTest, DoesNotCacheWithoutACookie) {
+  ASSERT_OK(LoadOrCompileAclTableDefinitions(path_, /*p4info_cookie=*/0,
+                                             P4InfoWithTables())
+                .status());
+  EXPECT_THAT(ReadAclTableDefinitionCache(path_, /*p4info_cookie=*/0),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+}  // namespace
+}  // namespace sonic
+}  // namespace p4rt_app
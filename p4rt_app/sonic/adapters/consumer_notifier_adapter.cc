@@ -17,6 +17,7 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "glog/logging.h"
@@ -61,5 +62,36 @@ bool ConsumerNotifierAdapter::WaitForNotificationAndPop(
   return true;
 }
 
+bool ConsumerNotifierAdapter::WaitForNotificationsAndPop(
+    int max_notifications,
+    std::vector<swss::KeyOpFieldsValuesTuple> &notifications,
+    int64_t timeout_ms) {
+  if (max_notifications <= 0) return true;
+
+  swss::KeyOpFieldsValuesTuple notification;
+  if (!WaitForNotificationAndPop(kfvOp(notification), kfvKey(notification),
+                                 kfvFieldsValues(notification), timeout_ms)) {
+    return false;
+  }
+  notifications.push_back(std::move(notification));
+
+  // Anything already read off the channel can be handled in the same wakeup.
+  for (int i = 1; i < max_notifications && HasQueuedNotification(); ++i) {
+    swss::KeyOpFieldsValuesTuple queued;
+    if (!WaitForNotificationAndPop(kfvOp(queued), kfvKey(queued),
+                                   kfvFieldsValues(queued),
+                                   /*timeout_ms=*/0)) {
+      break;
+    }
+    notifications.push_back(std::move(queued));
+  }
+  return true;
+}
+
+bool ConsumerNotifierAdapter::HasQueuedNotification() {
+  return notification_consumer_ != nullptr &&
+         notification_consumer_->peek() > 0;
+}
+
 }  // namespace sonic
 }  // namespace p4rt_app
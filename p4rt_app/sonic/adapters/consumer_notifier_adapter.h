@@ -37,10 +37,24 @@ class ConsumerNotifierAdapter {
       std::string &op, std::string &data,
       std::vector<swss::FieldValueTuple> &values, int64_t timeout_ms = 60000LL);
 
+  // Waits for at least one notification, and then pops any other notification
+  // that has already been received without waiting again. At most
+  // `max_notifications` are appended to `notifications`. Returns false if
+  // nothing is received before the timeout.
+  virtual bool WaitForNotificationsAndPop(
+      int max_notifications,
+      std::vector<swss::KeyOpFieldsValuesTuple> &notifications,
+      int64_t timeout_ms = 60000LL);
+
  protected:
   // Test only constructor for Mock and Fake classes.
   ConsumerNotifierAdapter() = default;
 
+  // Returns true if a notification can be popped without waiting. Mock and
+  // Fake classes do not have a consumer so they return one notification per
+  // WaitForNotificationsAndPop call.
+  virtual bool HasQueuedNotification();
+
  private:
   std::unique_ptr<swss::NotificationConsumer> notification_consumer_;
   std::string notifier_channel_name_;
@@ -13,42 +13,75 @@
 // limitations under the License.
 #include "p4rt_app/sonic/adapters/fake_sonic_db_table.h"
 
-#include <queue>
+#include <array>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "glog/logging.h"
 
 namespace p4rt_app {
 namespace sonic {
+namespace {
+
+void UpdateEntry(const SonicDbEntryList &values, SonicDbEntryMap &entry) {
+  for (const auto &[field, data] : values) {
+    entry.insert_or_assign(field, data);
+  }
+}
+
+}  // namespace
+
+int FakeSonicDbTable::ShardIndex(const std::string &key) {
+  return absl::Hash<std::string>{}(key) % kShardCount;
+}
 
 void FakeSonicDbTable::InsertTableEntry(const std::string &key,
                                         const SonicDbEntryList &values) {
   VLOG(1) << absl::StreamFormat("'%s' insert table entry: %s",
                                 debug_table_name_, key);
-  absl::WriterMutexLock lock(&entries_mutex_);
-  auto &entry = entries_[key];
-  for (const auto &[field, data] : values) {
-    entry.insert_or_assign(field, data);
+  Shard &shard = GetShard(key);
+  absl::WriterMutexLock lock(&shard.mutex);
+  UpdateEntry(values, shard.entries[key]);
+}
+
+void FakeSonicDbTable::InsertTableEntries(
+    absl::Span<const std::pair<std::string, SonicDbEntryList>> entries) {
+  VLOG(1) << absl::StreamFormat("'%s' insert %d table entries",
+                                debug_table_name_, entries.size());
+  // Group the entries by shard (keeping their order) so every lock is taken
+  // once.
+  std::array<std::vector<int>, kShardCount> entries_by_shard;
+  for (int i = 0; i < entries.size(); ++i) {
+    entries_by_shard[ShardIndex(entries[i].first)].push_back(i);
+  }
+  for (int shard_index = 0; shard_index < kShardCount; ++shard_index) {
+    if (entries_by_shard[shard_index].empty()) continue;
+    Shard &shard = shards_[shard_index];
+    absl::WriterMutexLock lock(&shard.mutex);
+    for (int i : entries_by_shard[shard_index]) {
+      UpdateEntry(entries[i].second, shard.entries[entries[i].first]);
+    }
   }
 }
 
 void FakeSonicDbTable::DeleteTableEntry(const std::string &key) {
   VLOG(1) << absl::StreamFormat("'%s' delete table entry: %s",
                                 debug_table_name_, key);
-  absl::WriterMutexLock lock(&entries_mutex_);
-  if (auto iter = entries_.find(key); iter != entries_.end()) {
-    entries_.erase(iter);
-  }
+  Shard &shard = GetShard(key);
+  absl::WriterMutexLock lock(&shard.mutex);
+  shard.entries.erase(key);
 }
 
 void FakeSonicDbTable::SetResponseForKey(const std::string &key,
@@ -56,24 +89,33 @@ void FakeSonicDbTable::SetResponseForKey(const std::string &key,
                                          const std::string &message) {
   VLOG(1) << absl::StreamFormat("'%s' set response for key '%s': %s:%s",
                                 debug_table_name_, key, code, message);
+  absl::WriterMutexLock lock(&responses_mutex_);
   responses_[key] = ResponseInfo{.code = code, .message = message};
 }
 
 bool FakeSonicDbTable::PushNotification(const std::string &key) {
   VLOG(1) << absl::StreamFormat("'%s' push notification: %s", debug_table_name_,
                                 key);
-  notifications_.push(key);
+  notifications_.Push(key);
   if (!UpdateAppStateDb(key)) {
     VLOG(2) << absl::StreamFormat("'%s' will not update StateDB entry for '%s'",
                                   debug_table_name_, key);
     return false;
   }
 
-  // If the key exists Insert into the StateDb, otherwise delete.
-  absl::WriterMutexLock lock(&entries_mutex_);
-  auto entry_iter = entries_.find(key);
-  if (entry_iter != entries_.end()) {
-    InsertStateDbTableEntry(key, entry_iter->second);
+  // If the key exists Insert into the StateDb, otherwise delete. The entry is
+  // copied so the StateDb is not updated while holding our shard lock.
+  std::optional<SonicDbEntryMap> entry;
+  {
+    const Shard &shard = GetShard(key);
+    absl::ReaderMutexLock lock(&shard.mutex);
+    if (auto entry_iter = shard.entries.find(key);
+        entry_iter != shard.entries.end()) {
+      entry = entry_iter->second;
+    }
+  }
+  if (entry.has_value()) {
+    InsertStateDbTableEntry(key, *entry);
   } else {
     DeleteStateDbTableEntry(key);
   }
@@ -85,7 +127,7 @@ bool FakeSonicDbTable::PushNotification(const std::string &key,
                                         const SonicDbEntryMap &values) {
   VLOG(1) << absl::StreamFormat("'%s' push notification: %s, %s",
                                 debug_table_name_, op, key);
-  notifications_.push(key);
+  notifications_.Push(key);
   if (!UpdateAppStateDb(key)) {
     VLOG(2) << absl::StreamFormat("'%s' will not update StateDB entry for '%s'",
                                   debug_table_name_, key);
@@ -102,19 +144,24 @@ bool FakeSonicDbTable::PushNotification(const std::string &key,
 
 void FakeSonicDbTable::GetNextNotification(std::string &op, std::string &data,
                                            SonicDbEntryList &values) {
-  if (notifications_.empty()) {
+  std::optional<std::string> notification;
+  {
+    absl::MutexLock lock(&notification_reader_mutex_);
+    notification = notifications_.Pop();
+  }
+  if (!notification.has_value()) {
     // TODO: we probably want to return a timeout error if we never
     // get a notification?
     LOG(FATAL) << "Could not find a notification.";
   }
 
   VLOG(1) << absl::StreamFormat("'%s' get notification: %s", debug_table_name_,
-                                notifications_.front());
-  data = notifications_.front();
-  notifications_.pop();
+                                *notification);
+  data = *std::move(notification);
 
   // If the user has overwritten the default response with custom values we will
   // use those. Otherwise, we default to success.
+  absl::ReaderMutexLock lock(&responses_mutex_);
   if (auto response_iter = responses_.find(data);
       response_iter != responses_.end()) {
     op = response_iter->second.code;
@@ -130,8 +177,9 @@ absl::StatusOr<SonicDbEntryMap> FakeSonicDbTable::ReadTableEntry(
   VLOG(1) << absl::StreamFormat("'%s' read table entry: %s", debug_table_name_,
                                 key);
   {
-    absl::ReaderMutexLock lock(&entries_mutex_);
-    if (auto entry = entries_.find(key); entry != entries_.end()) {
+    const Shard &shard = GetShard(key);
+    absl::ReaderMutexLock lock(&shard.mutex);
+    if (auto entry = shard.entries.find(key); entry != shard.entries.end()) {
       return entry->second;
     }
   }
@@ -139,12 +187,39 @@ absl::StatusOr<SonicDbEntryMap> FakeSonicDbTable::ReadTableEntry(
                       absl::StrCat("AppDb missing: ", key));
 }
 
+std::vector<absl::StatusOr<SonicDbEntryMap>> FakeSonicDbTable::ReadTableEntries(
+    absl::Span<const std::string> keys) const {
+  VLOG(1) << absl::StreamFormat("'%s' read %d table entries",
+                                debug_table_name_, keys.size());
+  std::array<std::vector<int>, kShardCount> keys_by_shard;
+  for (int i = 0; i < keys.size(); ++i) {
+    keys_by_shard[ShardIndex(keys[i])].push_back(i);
+  }
+
+  std::vector<absl::StatusOr<SonicDbEntryMap>> result(keys.size());
+  for (int shard_index = 0; shard_index < kShardCount; ++shard_index) {
+    if (keys_by_shard[shard_index].empty()) continue;
+    const Shard &shard = shards_[shard_index];
+    absl::ReaderMutexLock lock(&shard.mutex);
+    for (int i : keys_by_shard[shard_index]) {
+      if (auto entry = shard.entries.find(keys[i]);
+          entry != shard.entries.end()) {
+        result[i] = entry->second;
+      } else {
+        result[i] = absl::Status(absl::StatusCode::kNotFound,
+                                 absl::StrCat("AppDb missing: ", keys[i]));
+      }
+    }
+  }
+  return result;
+}
+
 std::vector<std::string> FakeSonicDbTable::GetAllKeys() const {
   std::vector<std::string> result;
   VLOG(1) << absl::StreamFormat("'%s' get all keys.", debug_table_name_);
-  {
-    absl::ReaderMutexLock lock(&entries_mutex_);
-    for (const auto &entry : entries_) {
+  for (const Shard &shard : shards_) {
+    absl::ReaderMutexLock lock(&shard.mutex);
+    for (const auto &entry : shard.entries) {
       result.push_back(entry.first);
     }
   }
@@ -154,11 +229,13 @@ std::vector<std::string> FakeSonicDbTable::GetAllKeys() const {
 }
 
 void FakeSonicDbTable::DebugState() const {
-  absl::ReaderMutexLock lock(&entries_mutex_);
-  for (const auto &[key, values] : entries_) {
-    LOG(INFO) << "AppDb entry: " << key;
-    for (const auto &[field, data] : values) {
-      LOG(INFO) << "  " << field << " " << data;
+  for (const Shard &shard : shards_) {
+    absl::ReaderMutexLock lock(&shard.mutex);
+    for (const auto &[key, values] : shard.entries) {
+      LOG(INFO) << "AppDb entry: " << key;
+      for (const auto &[field, data] : values) {
+        LOG(INFO) << "  " << field << " " << data;
+      }
     }
   }
 }
@@ -194,6 +271,7 @@ void FakeSonicDbTable::DeleteStateDbTableEntry(const std::string &key) {
 // Update the AppStateDb only if the user has not overriden the respose, or if
 // they explicitly set that response to succeed.
 bool FakeSonicDbTable::UpdateAppStateDb(const std::string &key) {
+  absl::ReaderMutexLock lock(&responses_mutex_);
   auto response_iter = responses_.find(key);
   return response_iter == responses_.end() ||
          response_iter->second.code == "SWSS_RC_SUCCESS";
@@ -14,7 +14,7 @@
 #ifndef PINS_P4RT_APP_SONIC_ADAPTERS_FAKE_SONIC_DB_TABLE_H_
 #define PINS_P4RT_APP_SONIC_ADAPTERS_FAKE_SONIC_DB_TABLE_H_
 
-#include <queue>
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -24,6 +24,8 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "p4rt_app/utils/mpsc_queue.h"
 
 namespace p4rt_app {
 namespace sonic {
@@ -43,6 +45,10 @@ using SonicDbEntryMap = std::unordered_map<std::string, std::string>;
 
 // Fakes how the OrchAgent updates AppDb tables. When an entry is inserted the
 // Orchagent will respond with a notification of success or failure.
+//
+// The class is thread-safe. Entries are spread over independently locked
+// shards, and notifications are pushed without taking a lock, so that the fake
+// does not serialize heavy write loads from the app under test.
 class FakeSonicDbTable {
  public:
   FakeSonicDbTable(const std::string &table_name = "SonicDb:TABLE")
@@ -54,10 +60,13 @@ class FakeSonicDbTable {
   FakeSonicDbTable(const std::string &table_name, FakeSonicDbTable *state_db)
       : debug_table_name_(table_name), state_db_(state_db) {}
 
-  void InsertTableEntry(const std::string &key, const SonicDbEntryList &values)
-      ABSL_LOCKS_EXCLUDED(entries_mutex_);
-  void DeleteTableEntry(const std::string &key)
-      ABSL_LOCKS_EXCLUDED(entries_mutex_);
+  void InsertTableEntry(const std::string &key, const SonicDbEntryList &values);
+  void DeleteTableEntry(const std::string &key);
+
+  // Same as calling InsertTableEntry for each entry in order, but every shard
+  // is only locked once.
+  void InsertTableEntries(
+      absl::Span<const std::pair<std::string, SonicDbEntryList>> entries);
 
   void SetResponseForKey(const std::string &key, const std::string &code,
                          const std::string &message);
@@ -70,11 +79,14 @@ class FakeSonicDbTable {
   void GetNextNotification(std::string &op, std::string &data,
                            SonicDbEntryList &values);
 
-  absl::StatusOr<SonicDbEntryMap> ReadTableEntry(const std::string &key) const
-      ABSL_LOCKS_EXCLUDED(entries_mutex_);
+  absl::StatusOr<SonicDbEntryMap> ReadTableEntry(const std::string &key) const;
 
-  std::vector<std::string> GetAllKeys() const
-      ABSL_LOCKS_EXCLUDED(entries_mutex_);
+  // Same as calling ReadTableEntry for each key, but every shard is only locked
+  // once. Results are returned in the order of `keys`.
+  std::vector<absl::StatusOr<SonicDbEntryMap>> ReadTableEntries(
+      absl::Span<const std::string> keys) const;
+
+  std::vector<std::string> GetAllKeys() const;
 
   // Method should only be used for debug purposes.
   void DebugState() const;
@@ -85,29 +97,45 @@ class FakeSonicDbTable {
     std::string message;
   };
 
+  static constexpr int kShardCount = 16;
+
+  struct Shard {
+    mutable absl::Mutex mutex;
+    absl::flat_hash_map<std::string, SonicDbEntryMap> entries
+        ABSL_GUARDED_BY(mutex);
+  };
+
+  static int ShardIndex(const std::string &key);
+  Shard &GetShard(const std::string &key) { return shards_[ShardIndex(key)]; }
+  const Shard &GetShard(const std::string &key) const {
+    return shards_[ShardIndex(key)];
+  }
+
   void InsertStateDbTableEntry(const std::string &key,
                                const SonicDbEntryMap &values);
   void DeleteStateDbTableEntry(const std::string &key);
 
-  bool UpdateAppStateDb(const std::string &key);
-
-  // Mutex to protect synchronization of entries_.
-  mutable absl::Mutex entries_mutex_;
+  bool UpdateAppStateDb(const std::string &key)
+      ABSL_LOCKS_EXCLUDED(responses_mutex_);
 
   // Debug table name is used in log messages to help distinguish messages.
   const std::string debug_table_name_;
 
-  // Current list of DB entries stored in the table.
-  absl::flat_hash_map<std::string, SonicDbEntryMap> entries_
-      ABSL_GUARDED_BY(entries_mutex_);
+  // Current list of DB entries stored in the table, sharded by key.
+  std::array<Shard, kShardCount> shards_;
 
   // List of notifications the OrchAgent would have generated. One notification
-  // is created per insert, and one is removed per notification check.
-  std::queue<std::string> notifications_;
+  // is created per insert, and one is removed per notification check. Pushing
+  // is lock-free, while readers are serialized by `notification_reader_mutex_`
+  // because the queue only supports a single consumer.
+  MpscQueue<std::string> notifications_;
+  absl::Mutex notification_reader_mutex_;
 
   // By default all notifications will return success. To fake an error case we
   // need to set the expected response for an AppDb key.
-  absl::flat_hash_map<std::string, ResponseInfo> responses_;
+  mutable absl::Mutex responses_mutex_;
+  absl::flat_hash_map<std::string, ResponseInfo> responses_
+      ABSL_GUARDED_BY(responses_mutex_);
 
   // If a StateDb is set then entries will automatically be added on
   // successful inserts, and removed on successful deletes.
@@ -14,11 +14,14 @@
 #include "p4rt_app/sonic/adapters/fake_sonic_db_table.h"
 
 #include <string>
+#include <thread>  // NOLINT: third_party code.
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -27,6 +30,8 @@ namespace sonic {
 namespace {
 
 using ::testing::ElementsAre;
+using ::testing::Pair;
+using ::testing::SizeIs;
 using ::testing::UnorderedElementsAre;
 
 TEST(FakeSonicDbTest, InsertSingleEntry) {
@@ -100,6 +105,65 @@ TEST(FakeSonicDbTest, DeleteEntry) {
   EXPECT_TRUE(table.GetAllKeys().empty());
 }
 
+TEST(FakeSonicDbTest, InsertTableEntriesInBulk) {
+  FakeSonicDbTable table;
+  table.InsertTableEntries({
+      {"entry0", {{"key", "value"}}},
+      {"entry1", {{"key", "value"}}},
+      {"entry0", {{"other_key", "other_value"}}},
+  });
+
+  EXPECT_THAT(table.GetAllKeys(), UnorderedElementsAre("entry0", "entry1"));
+  auto result = table.ReadTableEntry("entry0");
+  ASSERT_TRUE(result.ok());
+  EXPECT_THAT(*result, UnorderedElementsAre(Pair("key", "value"),
+                                            Pair("other_key", "other_value")));
+}
+
+TEST(FakeSonicDbTest, ReadTableEntriesInBulkKeepsTheOrderOfTheKeys) {
+  FakeSonicDbTable table;
+  table.InsertTableEntry("entry0", /*values=*/{{"key", "value0"}});
+  table.InsertTableEntry("entry1", /*values=*/{{"key", "value1"}});
+
+  std::vector<absl::StatusOr<SonicDbEntryMap>> result =
+      table.ReadTableEntries({"entry1", "missing", "entry0"});
+  ASSERT_THAT(result, SizeIs(3));
+  ASSERT_TRUE(result[0].ok());
+  EXPECT_THAT(*result[0], UnorderedElementsAre(Pair("key", "value1")));
+  EXPECT_EQ(result[1].status().code(), absl::StatusCode::kNotFound);
+  ASSERT_TRUE(result[2].ok());
+  EXPECT_THAT(*result[2], UnorderedElementsAre(Pair("key", "value0")));
+}
+
+TEST(FakeSonicDbTest, ConcurrentWritersAndNotifications) {
+  constexpr int kThreads = 4;
+  constexpr int kEntriesPerThread = 100;
+  FakeSonicDbTable state_table;
+  FakeSonicDbTable table("AppDb:TABLE", &state_table);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&table, t]() {
+      for (int i = 0; i < kEntriesPerThread; ++i) {
+        std::string key = absl::StrCat("entry-", t, "-", i);
+        table.InsertTableEntry(key, /*values=*/{{"key", "value"}});
+        table.PushNotification(key);
+      }
+    });
+  }
+  for (std::thread &thread : threads) thread.join();
+
+  EXPECT_THAT(table.GetAllKeys(), SizeIs(kThreads * kEntriesPerThread));
+  EXPECT_THAT(state_table.GetAllKeys(), SizeIs(kThreads * kEntriesPerThread));
+  for (int i = 0; i < kThreads * kEntriesPerThread; ++i) {
+    std::string op;
+    std::string data;
+    SonicDbEntryList values;
+    table.GetNextNotification(op, data, values);
+    EXPECT_EQ(op, "SWSS_RC_SUCCESS");
+  }
+}
+
 TEST(FakeSonicDbDeathTest, GetNotificationDiesIfNoNotificationExists) {
   FakeSonicDbTable table;
   std::string op;
@@ -57,6 +57,16 @@ std::vector<std::pair<std::string, std::string>> FakeTableAdapter::get(
   return result;
 }
 
+std::vector<std::vector<std::pair<std::string, std::string>>>
+FakeTableAdapter::batch_get(const std::vector<std::string>& keys) {
+  std::vector<std::vector<std::pair<std::string, std::string>>> results;
+  results.reserve(keys.size());
+  for (const auto& key : keys) {
+    results.push_back(FakeTableAdapter::get(key));
+  }
+  return results;
+}
+
 void FakeTableAdapter::set(
     const std::string& key,
     const std::vector<std::pair<std::string, std::string>>& values) {
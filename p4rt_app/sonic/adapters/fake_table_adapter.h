@@ -40,6 +40,8 @@ class FakeTableAdapter final : public TableAdapter {
 
   std::vector<std::pair<std::string, std::string>> get(
       const std::string& key) override;
+  std::vector<std::vector<std::pair<std::string, std::string>>> batch_get(
+      const std::vector<std::string>& keys) override;
   void set(
       const std::string& key,
       const std::vector<std::pair<std::string, std::string>>& values) override;
@@ -43,6 +43,11 @@ class MockSystemCallAdapter final : public SystemCallAdapter {
   MOCK_METHOD(void, freeifaddrs, (struct ifaddrs*), (const, override));
   MOCK_METHOD(int, getsockopt, (int, int, int, int*, socklen_t*),
               (const, override));
+  MOCK_METHOD(int, recvmmsg,
+              (int, struct mmsghdr*, unsigned int, int, struct timespec*),
+              (const, override));
+  MOCK_METHOD(int, sendmmsg, (int, struct mmsghdr*, unsigned int, int),
+              (const, override));
 };
 
 }  // namespace sonic
@@ -34,6 +34,9 @@ class MockTableAdapter : public TableAdapter {
   MOCK_METHOD((std::vector<std::pair<std::string, std::string>>), get,
               (const std::string& key), (override));
 
+  MOCK_METHOD((std::vector<std::vector<std::pair<std::string, std::string>>>),
+              batch_get, (const std::vector<std::string>& keys), (override));
+
   MOCK_METHOD(
       void, set,
       (const std::string& key,
@@ -76,5 +76,16 @@ int SystemCallAdapter::getsockopt(int socket, int level, int option_name,
   return ::getsockopt(socket, level, option_name, option_value, option_len);
 }
 
+int SystemCallAdapter::recvmmsg(int sockfd, struct mmsghdr *msgvec,
+                                unsigned int vlen, int flags,
+                                struct timespec *timeout) const {
+  return ::recvmmsg(sockfd, msgvec, vlen, flags, timeout);
+}
+
+int SystemCallAdapter::sendmmsg(int sockfd, struct mmsghdr *msgvec,
+                                unsigned int vlen, int flags) const {
+  return ::sendmmsg(sockfd, msgvec, vlen, flags);
+}
+
 }  // namespace sonic
 }  // namespace p4rt_app
@@ -21,6 +21,7 @@
 #include <stddef.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <time.h>
 
 namespace p4rt_app {
 namespace sonic {
@@ -50,6 +51,12 @@ class SystemCallAdapter {
   // Make option_val int* to support mocking.
   virtual int getsockopt(int socket, int level, int option_name,
                          int *option_value, socklen_t *option_len) const;
+  // Batched versions of recvmsg & sendmsg. Each call receives or sends up to
+  // `vlen` datagrams.
+  virtual int recvmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+                       int flags, struct timespec *timeout) const;
+  virtual int sendmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+                       int flags) const;
 };
 
 }  // namespace sonic
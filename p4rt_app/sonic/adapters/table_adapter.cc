@@ -13,12 +13,16 @@
 // limitations under the License.
 #include "p4rt_app/sonic/adapters/table_adapter.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "swss/dbconnector.h"
+#include "swss/rediscommand.h"
+#include "swss/redispipeline.h"
+#include "swss/redisreply.h"
 #include "swss/table.h"
 
 namespace p4rt_app {
@@ -46,6 +50,39 @@ std::vector<std::pair<std::string, std::string>> TableAdapter::get(
   return result;
 }
 
+std::vector<std::vector<std::pair<std::string, std::string>>>
+TableAdapter::batch_get(const std::vector<std::string>& keys) {
+  // The RedisPipeline drops any unread replies when its buffer fills up. So we
+  // send requests in chunks that always fit, and read every reply before
+  // sending the next chunk.
+  constexpr int kMaxPipelineSize = 512;
+
+  std::vector<std::vector<std::pair<std::string, std::string>>> results(
+      keys.size());
+  if (keys.empty()) return results;
+
+  swss::RedisPipeline pipeline(db_connector_, kMaxPipelineSize + 1);
+  for (int start = 0; start < keys.size(); start += kMaxPipelineSize) {
+    int end = std::min<int>(start + kMaxPipelineSize, keys.size());
+    for (int i = start; i < end; ++i) {
+      swss::RedisCommand hgetall;
+      hgetall.format("HGETALL %s",
+                     absl::StrCat(getTablePrefix(), keys[i]).c_str());
+      pipeline.push(hgetall);
+    }
+    for (int i = start; i < end; ++i) {
+      swss::RedisReply reply(pipeline.pop());
+      redisReply* context = reply.getContext();
+      if (context == nullptr || context->type != REDIS_REPLY_ARRAY) continue;
+      for (size_t j = 0; j + 1 < context->elements; j += 2) {
+        results[i].emplace_back(context->element[j]->str,
+                                context->element[j + 1]->str);
+      }
+    }
+  }
+  return results;
+}
+
 void TableAdapter::set(
     const std::string& key,
     const std::vector<std::pair<std::string, std::string>>& values) {
@@ -54,9 +91,16 @@ void TableAdapter::set(
 
 void TableAdapter::batch_set(
     const std::vector<swss::KeyOpFieldsValuesTuple>& values) {
+  if (values.empty()) return;
+
+  // A buffered table queues every write in the pipeline, and only waits on
+  // the replies when the pipeline fills up or is flushed.
+  swss::RedisPipeline pipeline(db_connector_);
+  swss::Table table(&pipeline, table_->getTableName(), /*buffered=*/true);
   for (const swss::KeyOpFieldsValuesTuple& value : values) {
-    table_->set(kfvKey(value), kfvFieldsValues(value));
+    table.set(kfvKey(value), kfvFieldsValues(value));
   }
+  table.flush();
 }
 void TableAdapter::del(const std::string& key) { table_->del(key); }
 
@@ -47,13 +47,21 @@ class TableAdapter {
 
   virtual std::vector<std::pair<std::string, std::string>> get(
       const std::string& key);
+  // Reads multiple entries using pipelined requests over a single connection.
+  // Results are returned in the same order as the keys, and missing entries
+  // are returned as an empty list.
+  virtual std::vector<std::vector<std::pair<std::string, std::string>>>
+  batch_get(const std::vector<std::string>& keys);
   virtual void set(
       const std::string& key,
       const std::vector<std::pair<std::string, std::string>>& values);
+  // Writes multiple entries using pipelined requests over a single connection.
+  // Only the key and field values of each tuple are used.
   virtual void batch_set(
       const std::vector<swss::KeyOpFieldsValuesTuple>& values);
 
   virtual void del(const std::string& key);
+  // Deletes multiple entries with a single request.
   virtual void batch_del(const std::vector<std::string>& keys);
 
   virtual std::string getTablePrefix() const;
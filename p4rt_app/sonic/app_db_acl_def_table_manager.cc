@@ -594,8 +594,9 @@ StatusOr<std::string> ExtractActionParamSaiObjectType(
 
 StatusOr<IrActionInfo::SaiAction> ParseActionParam(
     const IrActionDefinition::IrActionParamDefinition& param) {
-  auto annotation_args_result = pdpi::GetAnnotationAsArgList(
-      kActionParamAnnotationLabel, param.param().annotations());
+  const pdpi::AnnotationIndex annotations(param.param().annotations());
+  auto annotation_args_result =
+      pdpi::GetAnnotationAsArgList(kActionParamAnnotationLabel, annotations);
   if (annotation_args_result.status().code() == absl::StatusCode::kNotFound) {
     return InvalidArgumentErrorBuilder()
            << "Action parameter [" << param.ShortDebugString()
@@ -614,7 +615,7 @@ StatusOr<IrActionInfo::SaiAction> ParseActionParam(
                      << param.ShortDebugString() << "].");
   // This is an optional annotation.
   auto annotation_object_type_args_list = pdpi::GetAnnotationAsArgList(
-      kActionParamObjectTypeAnnotationLabel, param.param().annotations());
+      kActionParamObjectTypeAnnotationLabel, annotations);
   if (annotation_object_type_args_list.ok()) {
     ASSIGN_OR_RETURN(sai_action.object_type,
                      ExtractActionParamSaiObjectType(
@@ -903,29 +904,43 @@ StatusOr<std::vector<swss::FieldValueTuple>> GenerateSonicDbValuesFromIrTable(
 
 }  // namespace
 
+StatusOr<CompiledAclTableDefinition> CompileAclTableDefinition(
+    const IrTableDefinition& ir_table) {
+  CompiledAclTableDefinition definition;
+  ASSIGN_OR_RETURN(definition.key, GenerateSonicDbKeyFromIrTable(ir_table));
+  ASSIGN_OR_RETURN(definition.values,
+                   GenerateSonicDbValuesFromIrTable(ir_table));
+  return definition;
+}
+
 Status VerifyAclTableDefinition(const IrTableDefinition& ir_table) {
-  RETURN_IF_ERROR(GenerateSonicDbKeyFromIrTable(ir_table).status());
-  return GenerateSonicDbValuesFromIrTable(ir_table).status();
+  return CompileAclTableDefinition(ir_table).status();
 }
 
 StatusOr<std::string> InsertAclTableDefinition(
     P4rtTable& p4rt_table, const IrTableDefinition& ir_table) {
+  ASSIGN_OR_RETURN(CompiledAclTableDefinition definition,
+                   CompileAclTableDefinition(ir_table));
+  return InsertAclTableDefinition(p4rt_table, definition);
+}
+
+std::string InsertAclTableDefinition(
+    P4rtTable& p4rt_table, const CompiledAclTableDefinition& definition) {
   swss::KeyOpFieldsValuesTuple kfv;
-  ASSIGN_OR_RETURN(kfvKey(kfv), GenerateSonicDbKeyFromIrTable(ir_table));
+  kfvKey(kfv) = definition.key;
   kfvOp(kfv) = "SET";
-  ASSIGN_OR_RETURN(kfvFieldsValues(kfv),
-                   GenerateSonicDbValuesFromIrTable(ir_table));
+  kfvFieldsValues(kfv) = definition.values;
   p4rt_table.notification_producer->send({kfv});
   return kfvKey(kfv);
 }
 
-absl::Status RemoveAclTableDefinition(P4rtTable& p4rt_table,
-                                      const IrTableDefinition& ir_table) {
+StatusOr<std::string> RemoveAclTableDefinition(
+    P4rtTable& p4rt_table, const IrTableDefinition& ir_table) {
   swss::KeyOpFieldsValuesTuple kfv;
   ASSIGN_OR_RETURN(kfvKey(kfv), GenerateSonicDbKeyFromIrTable(ir_table));
   kfvOp(kfv) = "DEL";
   p4rt_table.notification_producer->send({kfv});
-  return absl::OkStatus();
+  return kfvKey(kfv);
 }
 
 }  // namespace sonic
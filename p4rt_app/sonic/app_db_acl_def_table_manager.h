@@ -14,6 +14,10 @@
 #ifndef PINS_P4RT_APP_SONIC_APP_DB_ACL_DEF_TABLE_MANAGER_H_
 #define PINS_P4RT_APP_SONIC_APP_DB_ACL_DEF_TABLE_MANAGER_H_
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "p4_pdpi/ir.pb.h"
@@ -22,6 +26,22 @@
 namespace p4rt_app {
 namespace sonic {
 
+// An ACL table definition translated into its AppDb entry. Translating parses
+// every sai_* annotation in the table, so the result can be kept and reused
+// for the same P4Info (see acl_table_definition_cache.h).
+struct CompiledAclTableDefinition {
+  std::string key;
+  std::vector<std::pair<std::string, std::string>> values;
+
+  bool operator==(const CompiledAclTableDefinition& other) const {
+    return key == other.key && values == other.values;
+  }
+};
+
+// Translates an ACL table definition into its AppDb entry.
+absl::StatusOr<CompiledAclTableDefinition> CompileAclTableDefinition(
+    const pdpi::IrTableDefinition& ir_table);
+
 // Verify an ACL table definition can be inserted into the AppDB ACL Table
 // Definition Table.
 absl::Status VerifyAclTableDefinition(const pdpi::IrTableDefinition& ir_table);
@@ -31,10 +51,15 @@ absl::Status VerifyAclTableDefinition(const pdpi::IrTableDefinition& ir_table);
 absl::StatusOr<std::string> InsertAclTableDefinition(
     P4rtTable& p4rt_table, const pdpi::IrTableDefinition& ir_table);
 
+// Insert a compiled ACL table definition entry into the AppDB ACL Table
+// Definition Table, returns the key that was used.
+std::string InsertAclTableDefinition(
+    P4rtTable& p4rt_table, const CompiledAclTableDefinition& definition);
+
 // Remove an ACL table definition entry from the AppDB ACL Table Definition
-// Table.
-absl::Status RemoveAclTableDefinition(P4rtTable& p4rt_table,
-                                      const pdpi::IrTableDefinition& ir_table);
+// Table, returns the key that was used.
+absl::StatusOr<std::string> RemoveAclTableDefinition(
+    P4rtTable& p4rt_table, const pdpi::IrTableDefinition& ir_table);
 
 }  // namespace sonic
 }  // namespace p4rt_app
@@ -13,14 +13,19 @@
 // limitations under the License.
 #include "p4rt_app/sonic/app_db_manager.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <deque>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -30,6 +35,8 @@
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "glog/logging.h"
 #include "google/rpc/code.pb.h"
 #include "gutil/collections.h"
@@ -53,15 +60,35 @@ namespace p4rt_app {
 namespace sonic {
 namespace {
 
+// Returns the precomputed P4RT key if one exists. Otherwise, generates the key
+// from the table entry.
+absl::StatusOr<std::string> GetOrCreateP4rtTableKey(
+    const pdpi::IrTableEntry& entry, const std::string& precomputed_key,
+    const pdpi::IrP4Info& p4_info, AppDbEntrySerializer* serializer) {
+  if (!precomputed_key.empty()) return precomputed_key;
+  if (serializer != nullptr) return serializer->P4rtTableKey(entry);
+  return GetRedisP4rtTableKey(entry, p4_info);
+}
+
+// Uses the serializer, if one is available, to build the AppDb values.
+absl::StatusOr<std::vector<swss::FieldValueTuple>> CreateAppDbValues(
+    const pdpi::IrTableEntry& entry, AppDbEntrySerializer* serializer) {
+  if (serializer != nullptr) return serializer->AppDbValues(entry);
+  return IrTableEntryToAppDbValues(entry);
+}
+
 // Translates the IR entry into a format understood by the OA layer. Also
 // verifies that the entry can be deleted (i.e. already exist). On success the
 // P4RT key is returned.
 absl::StatusOr<std::string> CreateEntryForDelete(
     P4rtTable& p4rt_table, const pdpi::IrTableEntry& entry,
-    const pdpi::IrP4Info& p4_info,
+    const std::string& precomputed_key, const pdpi::IrP4Info& p4_info,
+    AppDbEntrySerializer* serializer,
     std::vector<swss::KeyOpFieldsValuesTuple>& p4rt_deletes) {
   VLOG(2) << "Delete PDPI IR entry: " << entry.ShortDebugString();
-  ASSIGN_OR_RETURN(std::string key, GetRedisP4rtTableKey(entry, p4_info));
+  ASSIGN_OR_RETURN(std::string key,
+                   GetOrCreateP4rtTableKey(entry, precomputed_key, p4_info,
+                                           serializer));
 
   VLOG(1) << "Delete AppDb entry: " << key;
   swss::KeyOpFieldsValuesTuple key_value;
@@ -76,17 +103,20 @@ absl::StatusOr<std::string> CreateEntryForDelete(
 // success the P4RT key is returned.
 absl::StatusOr<std::string> CreateEntryForInsert(
     P4rtTable& p4rt_table, const pdpi::IrTableEntry& entry,
-    const pdpi::IrP4Info& p4_info,
+    const std::string& precomputed_key, const pdpi::IrP4Info& p4_info,
+    AppDbEntrySerializer* serializer,
     std::vector<swss::KeyOpFieldsValuesTuple>& p4rt_inserts) {
   VLOG(2) << "Insert PDPI IR entry: " << entry.ShortDebugString();
-  ASSIGN_OR_RETURN(std::string key, GetRedisP4rtTableKey(entry, p4_info));
+  ASSIGN_OR_RETURN(std::string key,
+                   GetOrCreateP4rtTableKey(entry, precomputed_key, p4_info,
+                                           serializer));
 
   VLOG(1) << "Insert AppDb entry: " << key;
   swss::KeyOpFieldsValuesTuple key_value;
   kfvKey(key_value) = key;
   kfvOp(key_value) = "SET";
   ASSIGN_OR_RETURN(kfvFieldsValues(key_value),
-                   IrTableEntryToAppDbValues(entry));
+                   CreateAppDbValues(entry, serializer));
   p4rt_inserts.push_back(std::move(key_value));
   return key;
 }
@@ -96,23 +126,29 @@ absl::StatusOr<std::string> CreateEntryForInsert(
 // P4RT key is returned.
 absl::StatusOr<std::string> CreateEntryForModify(
     P4rtTable& p4rt_table, const pdpi::IrTableEntry& entry,
-    const pdpi::IrP4Info& p4_info,
+    const std::string& precomputed_key, const pdpi::IrP4Info& p4_info,
+    AppDbEntrySerializer* serializer,
     std::vector<swss::KeyOpFieldsValuesTuple>& p4rt_modifies) {
   VLOG(2) << "Modify PDPI IR entry: " << entry.ShortDebugString();
-  ASSIGN_OR_RETURN(std::string key, GetRedisP4rtTableKey(entry, p4_info));
+  ASSIGN_OR_RETURN(std::string key,
+                   GetOrCreateP4rtTableKey(entry, precomputed_key, p4_info,
+                                           serializer));
 
   VLOG(1) << "Modify AppDb entry: " << key;
   swss::KeyOpFieldsValuesTuple key_value;
   kfvKey(key_value) = key;
   kfvOp(key_value) = "SET";
   ASSIGN_OR_RETURN(kfvFieldsValues(key_value),
-                   IrTableEntryToAppDbValues(entry));
+                   CreateAppDbValues(entry, serializer));
   p4rt_modifies.push_back(std::move(key_value));
   return key;
 }
 
+// Works on both IR and PI table entries since they share the same counter and
+// meter fields.
+template <typename TableEntry>
 absl::Status AppendCounterData(
-    pdpi::IrTableEntry& table_entry,
+    TableEntry& table_entry,
     const std::vector<std::pair<std::string, std::string>>& counter_data) {
   auto field_value_error = [&table_entry](absl::string_view field,
                                           absl::string_view value) {
@@ -169,6 +205,139 @@ absl::Status AppendCounterData(
   return absl::OkStatus();
 }
 
+// Returns the tighter of two limits, where 0 is unlimited.
+template <typename T>
+T TighterLimit(T a, T b) {
+  if (a == 0) return b;
+  if (b == 0) return a;
+  return std::min(a, b);
+}
+
+// Returns the limits for a P4RT_TABLE update. Limits for the AppDb table in
+// the key (e.g. "FIXED_IPV4_TABLE") take precedence over limits for its table
+// type (e.g. "FIXED").
+const AppDbPublishLimits& GetPublishLimits(const AppDbPublishPolicy& policy,
+                                           absl::string_view key) {
+  if (policy.limits_by_table.empty()) return policy.default_limits;
+  absl::string_view table_name = key.substr(0, key.find(':'));
+  auto limits = policy.limits_by_table.find(table_name);
+  if (limits != policy.limits_by_table.end()) return limits->second;
+  limits = policy.limits_by_table.find(
+      table_name.substr(0, table_name.find('_')));
+  if (limits != policy.limits_by_table.end()) return limits->second;
+  return policy.default_limits;
+}
+
+// The number of bytes written to Redis for an update, ignoring the framing.
+int64_t PublishedSize(const swss::KeyOpFieldsValuesTuple& kfv) {
+  int64_t size = kfvKey(kfv).size() + kfvOp(kfv).size();
+  for (const auto& [field, value] : kfvFieldsValues(kfv)) {
+    size += field.size() + value.size();
+  }
+  return size;
+}
+
+// Splits the updates into consecutive sends that each stay within the tightest
+// limits of the updates they hold. Returns the end index of every send.
+std::vector<int> SplitIntoSends(
+    const std::vector<swss::KeyOpFieldsValuesTuple>& kfv_updates,
+    const AppDbPublishPolicy& policy) {
+  std::vector<int> send_ends;
+  int entries = 0;
+  int64_t bytes = 0;
+  AppDbPublishLimits send_limits;
+  for (int i = 0; i < kfv_updates.size(); ++i) {
+    const AppDbPublishLimits& limits =
+        GetPublishLimits(policy, kfvKey(kfv_updates[i]));
+    const int64_t size = PublishedSize(kfv_updates[i]);
+    AppDbPublishLimits next_limits = {
+        .max_entries =
+            TighterLimit(send_limits.max_entries, limits.max_entries),
+        .max_bytes = TighterLimit(send_limits.max_bytes, limits.max_bytes),
+    };
+    // A single update always gets sent, even if it is over the byte limit.
+    if (entries > 0 &&
+        ((next_limits.max_entries > 0 &&
+          entries + 1 > next_limits.max_entries) ||
+         (next_limits.max_bytes > 0 && bytes + size > next_limits.max_bytes))) {
+      send_ends.push_back(i);
+      entries = 0;
+      bytes = 0;
+      next_limits = limits;
+    }
+    ++entries;
+    bytes += size;
+    send_limits = next_limits;
+  }
+  if (entries > 0) send_ends.push_back(kfv_updates.size());
+  return send_ends;
+}
+
+// Sends the P4RT_TABLE updates, and waits for their responses. Without a
+// policy every update is sent at once. Otherwise, the updates are split into
+// sends and up to `max_outstanding_sends` are waited on at a time. Once a send
+// reports a failure no further sends are made, and their updates are marked as
+// not attempted.
+absl::Status PublishP4rtTableUpdates(
+    P4rtTable& p4rt_table, const AppDbPublishPolicy* policy,
+    std::vector<swss::KeyOpFieldsValuesTuple>& kfv_updates,
+    absl::btree_map<std::string, pdpi::IrUpdateStatus*>& app_db_status,
+    absl::Time& first_send_time) {
+  if (policy == nullptr) {
+    p4rt_table.notification_producer->send(kfv_updates);
+    first_send_time = absl::Now();
+    return GetAndProcessResponseNotificationWithoutRevertingState(
+        *p4rt_table.notification_consumer, app_db_status);
+  }
+
+  const std::vector<int> send_ends = SplitIntoSends(kfv_updates, *policy);
+  const int max_outstanding_sends = std::max(1, policy->max_outstanding_sends);
+  auto send_begin = [&send_ends](int send) {
+    return send == 0 ? 0 : send_ends[send - 1];
+  };
+
+  // The statuses of every send that has not been waited on yet, in order.
+  std::deque<absl::btree_map<std::string, pdpi::IrUpdateStatus*>> outstanding;
+  first_send_time = absl::Now();
+  int next_send = 0;
+  bool failed = false;
+  while (true) {
+    while (!failed && next_send < send_ends.size() &&
+           static_cast<int>(outstanding.size()) < max_outstanding_sends) {
+      absl::btree_map<std::string, pdpi::IrUpdateStatus*>& send_status =
+          outstanding.emplace_back();
+      for (int i = send_begin(next_send); i < send_ends[next_send]; ++i) {
+        auto status = app_db_status.find(kfvKey(kfv_updates[i]));
+        if (status != app_db_status.end()) send_status.insert(*status);
+      }
+      std::vector<swss::KeyOpFieldsValuesTuple> send(
+          std::make_move_iterator(kfv_updates.begin() +
+                                  send_begin(next_send)),
+          std::make_move_iterator(kfv_updates.begin() +
+                                  send_ends[next_send]));
+      p4rt_table.notification_producer->send(send);
+      if (next_send == 0) first_send_time = absl::Now();
+      ++next_send;
+    }
+    if (outstanding.empty()) break;
+
+    RETURN_IF_ERROR(GetAndProcessResponseNotificationWithoutRevertingState(
+        *p4rt_table.notification_consumer, outstanding.front()));
+    for (const auto& [key, status] : outstanding.front()) {
+      if (status->code() != google::rpc::Code::OK) failed = true;
+    }
+    outstanding.pop_front();
+  }
+
+  for (int i = send_begin(next_send); i < kfv_updates.size(); ++i) {
+    auto status = app_db_status.find(kfvKey(kfv_updates[i]));
+    if (status != app_db_status.end()) {
+      *status->second = NotAttemptedIrUpdateStatus();
+    }
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 // Generates the table definition in json format
@@ -398,6 +567,27 @@ absl::StatusOr<pdpi::IrTableEntry> ReadP4TableEntry(
   return table_entry;
 }
 
+std::vector<absl::StatusOr<pdpi::IrTableEntry>> ReadP4TableEntries(
+    P4rtTable& p4rt_table, const pdpi::IrP4Info& p4info,
+    const std::vector<std::string>& keys) {
+  std::vector<std::vector<std::pair<std::string, std::string>>> values =
+      p4rt_table.app_db->batch_get(keys);
+
+  std::vector<absl::StatusOr<pdpi::IrTableEntry>> table_entries;
+  table_entries.reserve(keys.size());
+  for (int i = 0; i < keys.size(); ++i) {
+    if (i >= values.size()) {
+      table_entries.push_back(gutil::InternalErrorBuilder()
+                              << "AppDb did not return values for: "
+                              << keys[i]);
+      continue;
+    }
+    table_entries.push_back(
+        AppDbKeyAndValuesToIrTableEntry(p4info, keys[i], values[i]));
+  }
+  return table_entries;
+}
+
 absl::Status AppendCounterDataForTableEntry(pdpi::IrTableEntry& ir_table_entry,
                                             P4rtTable& p4rt_table,
                                             const pdpi::IrP4Info& p4info) {
@@ -407,6 +597,48 @@ absl::Status AppendCounterDataForTableEntry(pdpi::IrTableEntry& ir_table_entry,
                                p4rt_table.app_db->getTablePrefix(), key)));
 }
 
+absl::Status AppendCounterDataForTableEntries(
+    const std::vector<std::string>& p4rt_keys,
+    const std::vector<p4::v1::TableEntry*>& pi_table_entries,
+    P4rtTable& p4rt_table) {
+  if (p4rt_keys.size() != pi_table_entries.size()) {
+    return gutil::InternalErrorBuilder()
+           << "Got " << p4rt_keys.size() << " P4RT keys for "
+           << pi_table_entries.size() << " table entries.";
+  }
+  if (p4rt_keys.empty()) return absl::OkStatus();
+
+  std::vector<std::vector<std::pair<std::string, std::string>>> counter_data =
+      p4rt_table.counter_db->batch_get(GetCounterDbKeys(p4rt_table, p4rt_keys));
+  if (counter_data.size() != pi_table_entries.size()) {
+    return gutil::InternalErrorBuilder()
+           << "Requested counter data for " << pi_table_entries.size()
+           << " table entries, but got " << counter_data.size()
+           << " results from the CountersDB.";
+  }
+  for (int i = 0; i < pi_table_entries.size(); ++i) {
+    RETURN_IF_ERROR(AppendCounterData(*pi_table_entries[i], counter_data[i]));
+  }
+  return absl::OkStatus();
+}
+
+std::vector<std::string> GetCounterDbKeys(
+    P4rtTable& p4rt_table, const std::vector<std::string>& p4rt_keys) {
+  std::vector<std::string> counter_keys;
+  counter_keys.reserve(p4rt_keys.size());
+  const std::string app_db_prefix = p4rt_table.app_db->getTablePrefix();
+  for (const std::string& key : p4rt_keys) {
+    counter_keys.push_back(absl::StrCat(app_db_prefix, key));
+  }
+  return counter_keys;
+}
+
+absl::Status AppendCounterDataToTableEntry(
+    const std::vector<std::pair<std::string, std::string>>& counter_data,
+    p4::v1::TableEntry& pi_table_entry) {
+  return AppendCounterData(pi_table_entry, counter_data);
+}
+
 std::vector<std::string> GetAllP4TableEntryKeys(P4rtTable& p4rt_table) {
   std::vector<std::string> p4rt_keys;
 
@@ -432,18 +664,68 @@ std::vector<std::string> GetAllP4TableEntryKeys(P4rtTable& p4rt_table) {
   return p4rt_keys;
 }
 
+absl::StatusOr<absl::flat_hash_map<std::string, AppDbPublishLimits>>
+ParseAppDbPublishLimitsByTable(absl::string_view limits) {
+  absl::flat_hash_map<std::string, AppDbPublishLimits> limits_by_table;
+  for (absl::string_view table_limits :
+       absl::StrSplit(limits, ',', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> table_and_limits =
+        absl::StrSplit(table_limits, '=');
+    std::vector<absl::string_view> values;
+    if (table_and_limits.size() == 2) {
+      values = absl::StrSplit(table_and_limits[1], ':');
+    }
+    AppDbPublishLimits parsed;
+    if (values.size() != 2 || table_and_limits[0].empty() ||
+        !absl::SimpleAtoi(values[0], &parsed.max_entries) ||
+        !absl::SimpleAtoi(values[1], &parsed.max_bytes) ||
+        parsed.max_entries < 0 || parsed.max_bytes < 0) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Invalid publish limits '" << table_limits
+             << "'. Expected <table>=<max_entries>:<max_bytes>.";
+    }
+    if (!limits_by_table.try_emplace(table_and_limits[0], parsed).second) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Publish limits for '" << table_and_limits[0]
+             << "' are set more than once.";
+    }
+  }
+  return limits_by_table;
+}
+
 absl::Status UpdateAppDb(P4rtTable& p4rt_table, VrfTable& vrf_table,
                          const AppDbUpdates& updates,
                          const pdpi::IrP4Info& p4_info,
-                         pdpi::IrWriteResponse* response) {
+                         pdpi::IrWriteResponse* response,
+                         AppDbUpdateTimes* times) {
+  absl::Time publish_start_time = absl::Now();
   std::vector<swss::KeyOpFieldsValuesTuple> kfv_updates;
   absl::btree_map<std::string, pdpi::IrUpdateStatus*> app_db_status;
+
+  // VRF_TABLE updates are sent as their own batch, and their responses are
+  // handled before any P4RT_TABLE updates are sent. We remember where each
+  // update came from in the request so that a failed VRF_TABLE update can
+  // still abort any P4RT_TABLE updates after it.
+  std::vector<swss::KeyOpFieldsValuesTuple> vrf_updates;
+  absl::btree_map<std::string, pdpi::IrUpdateStatus*> vrf_status;
+  absl::flat_hash_map<std::string, int> vrf_position_by_key;
+  std::vector<int> kfv_update_positions;
+
+  // One serializer is shared by the whole batch so its buffer is reused.
+  std::optional<AppDbEntrySerializer> serializer;
+  if (updates.serialization_plan != nullptr) {
+    serializer.emplace(*updates.serialization_plan);
+  }
+  AppDbEntrySerializer* serializer_ptr =
+      serializer.has_value() ? &*serializer : nullptr;
+
   bool fail_on_first_error = false;
-  for (const auto& entry : updates.entries) {
+  for (int position = 0; position < updates.entries.size(); ++position) {
+    const auto& entry = updates.entries[position];
     // Mark rest of the entries as not attempted after the first error.
     if (fail_on_first_error) {
       *response->mutable_statuses(entry.rpc_index) =
-          GetIrUpdateStatus(absl::StatusCode::kAborted, "Not attempted");
+          NotAttemptedIrUpdateStatus();
       continue;
     }
 
@@ -454,11 +736,18 @@ absl::Status UpdateAppDb(P4rtTable& p4rt_table, VrfTable& vrf_table,
              << "Could not determine AppDb table type for entry: "
              << entry.entry.ShortDebugString();
     } else if (entry.appdb_table == AppDbTableType::VRF_TABLE) {
-      // Update non AppDb:P4RT entries (e.g. VRF_TABLE).
-      RETURN_IF_ERROR(
-          UpdateAppDbVrfTable(vrf_table, entry.update_type, entry.rpc_index,
-                              entry.entry.table_entry(), *response));
-      if (response->statuses(entry.rpc_index).code() != google::rpc::Code::OK) {
+      // Add update for non AppDb:P4RT entries (e.g. VRF_TABLE) to the VRF
+      // batch.
+      absl::StatusOr<std::string> vrf_key = CreateAppDbVrfTableUpdate(
+          vrf_table, entry.update_type, entry.entry.table_entry(),
+          vrf_updates);
+      if (vrf_key.ok()) {
+        vrf_status[*vrf_key] = response->mutable_statuses(entry.rpc_index);
+        vrf_position_by_key[*vrf_key] = position;
+      } else {
+        LOG(WARNING) << "Could not update in AppDb: " << vrf_key.status();
+        *response->mutable_statuses(entry.rpc_index) =
+            GetIrUpdateStatus(vrf_key.status());
         fail_on_first_error = true;
       }
     } else if (entry.appdb_table == AppDbTableType::P4RT &&
@@ -485,15 +774,18 @@ absl::Status UpdateAppDb(P4rtTable& p4rt_table, VrfTable& vrf_table,
       switch (entry.update_type) {
         case p4::v1::Update::INSERT:
           key = CreateEntryForInsert(p4rt_table, entry.entry.table_entry(),
-                                     p4_info, kfv_updates);
+                                     entry.app_db_key, p4_info,
+                                     serializer_ptr, kfv_updates);
           break;
         case p4::v1::Update::MODIFY:
           key = CreateEntryForModify(p4rt_table, entry.entry.table_entry(),
-                                     p4_info, kfv_updates);
+                                     entry.app_db_key, p4_info,
+                                     serializer_ptr, kfv_updates);
           break;
         case p4::v1::Update::DELETE:
           key = CreateEntryForDelete(p4rt_table, entry.entry.table_entry(),
-                                     p4_info, kfv_updates);
+                                     entry.app_db_key, p4_info,
+                                     serializer_ptr, kfv_updates);
           break;
         default:
           key = gutil::InvalidArgumentErrorBuilder()
@@ -509,12 +801,45 @@ absl::Status UpdateAppDb(P4rtTable& p4rt_table, VrfTable& vrf_table,
         fail_on_first_error = true;
       }
     }
+    kfv_update_positions.resize(kfv_updates.size(), position);
+  }
+
+  // Send all the VRF_TABLE updates as one batch, and wait for all of their
+  // responses together.
+  RETURN_IF_ERROR(UpdateAppDbVrfTable(vrf_table, vrf_updates, vrf_status));
+  int first_vrf_failure = updates.entries.size();
+  for (const auto& [key, status] : vrf_status) {
+    if (status->code() != google::rpc::Code::OK) {
+      first_vrf_failure = std::min(first_vrf_failure, vrf_position_by_key[key]);
+    }
+  }
+
+  // Any P4RT_TABLE update after a failed VRF_TABLE update is not attempted.
+  if (first_vrf_failure < updates.entries.size()) {
+    std::vector<swss::KeyOpFieldsValuesTuple> attempted_updates;
+    for (int i = 0; i < kfv_updates.size(); ++i) {
+      if (kfv_update_positions[i] < first_vrf_failure) {
+        attempted_updates.push_back(std::move(kfv_updates[i]));
+        continue;
+      }
+      auto status = app_db_status.find(kfvKey(kfv_updates[i]));
+      if (status != app_db_status.end()) {
+        *status->second = NotAttemptedIrUpdateStatus();
+        app_db_status.erase(status);
+      }
+    }
+    kfv_updates = std::move(attempted_updates);
   }
 
-  // Send all the P4RT_TABLE updates as one batch.
-  p4rt_table.notification_producer->send(kfv_updates);
-  RETURN_IF_ERROR(GetAndProcessResponseNotificationWithoutRevertingState(
-      *p4rt_table.notification_consumer, app_db_status));
+  absl::Time response_start_time;
+  RETURN_IF_ERROR(PublishP4rtTableUpdates(p4rt_table, updates.publish_policy,
+                                          kfv_updates, app_db_status,
+                                          response_start_time));
+
+  if (times != nullptr) {
+    times->publish = response_start_time - publish_start_time;
+    times->response_wait = absl::Now() - response_start_time;
+  }
 
   return absl::OkStatus();
 }
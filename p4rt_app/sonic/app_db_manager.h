@@ -19,12 +19,18 @@
 #include <cstdint>
 #include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/entity_keys.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/sonic/app_db_to_pdpi_ir_translator.h"
 #include "p4rt_app/sonic/packet_replication_entry_translation.h"
 #include "p4rt_app/sonic/redis_connections.h"
 #include "swss/json.h"
@@ -48,6 +54,9 @@ enum class AppDbTableType {
 // weights.
 struct ActionProfileResources {
   std::string name;
+  // The P4Info ID of the action profile. Capacity is tracked by ID so
+  // accounting does not need to hash the profile's name.
+  uint32_t id = 0;
   int32_t number_of_actions = 0;
   int64_t total_weight = 0;
 };
@@ -80,6 +89,11 @@ struct AppDbEntry {
   // any caching of entries.
   pdpi::EntityKey entity_key;
 
+  // The P4RT_TABLE key for table entries written to the P4RT_TABLE (see
+  // GetRedisP4rtTableKey). Empty if the key has not been computed, or the entry
+  // is not written to the P4RT_TABLE.
+  std::string app_db_key;
+
   // The net utilization change for table entries with group actions. If the
   // update_type is an insert then this value will simply be the resources for
   // the entry. If the update_type is a modify then this value is the difference
@@ -92,10 +106,47 @@ struct AppDbEntry {
   AppDbTableType appdb_table = AppDbTableType::UNKNOWN;
 };
 
+// Limits on a single send of P4RT_TABLE updates. A value of 0 is unlimited.
+struct AppDbPublishLimits {
+  int max_entries = 0;
+  // Counts the bytes of every key, operation, field and value.
+  int64_t max_bytes = 0;
+};
+
+// Controls how the P4RT_TABLE updates of a batch are split into sends. Each
+// send is handled by the OrchAgent as it arrives, so smaller sends let it
+// start on a large batch sooner.
+struct AppDbPublishPolicy {
+  AppDbPublishLimits default_limits;
+
+  // Limits keyed by either an AppDb table name (e.g. "FIXED_IPV4_TABLE"), or a
+  // table type (e.g. "ACL"), where the table name takes precedence. A send
+  // holding updates for different tables is held to the tightest limits.
+  absl::flat_hash_map<std::string, AppDbPublishLimits> limits_by_table;
+
+  // The number of sends that can be waiting on responses at a time. Once a
+  // send reports a failure no further sends are made.
+  int max_outstanding_sends = 1;
+};
+
+// Parses per-table publish limits of the form
+//   <table>=<max_entries>:<max_bytes>[,<table>=<max_entries>:<max_bytes>]...
+// e.g. "ACL=100:0,FIXED_IPV4_TABLE=1000:65536".
+absl::StatusOr<absl::flat_hash_map<std::string, AppDbPublishLimits>>
+ParseAppDbPublishLimitsByTable(absl::string_view limits);
+
 // List of all updates that should be made to the AppDb.
 struct AppDbUpdates {
   std::vector<AppDbEntry> entries;
   int total_rpc_updates = 0;
+
+  // Pre-computed names for the current P4Info. When set, P4RT_TABLE values are
+  // built with an AppDbEntrySerializer instead of the generic translation.
+  const AppDbSerializationPlan* serialization_plan = nullptr;
+
+  // When set, the P4RT_TABLE updates are split into sends by the policy.
+  // Otherwise, they are all sent at once.
+  const AppDbPublishPolicy* publish_policy = nullptr;
 };
 
 // Insert table definition
@@ -109,20 +160,41 @@ absl::StatusOr<std::string> PublishExtTablesDefinitionToAppDb(
     uint64_t cookie,
     P4rtTable& p4rt_table);
 
+// Time spent in each stage of UpdateAppDb.
+struct AppDbUpdateTimes {
+  // Building, and sending, the updates to the AppDb. This includes any VRF
+  // table updates.
+  absl::Duration publish;
+  // Waiting for, and handling, the OrchAgent responses.
+  absl::Duration response_wait;
+};
+
 // Takes a list of AppDb updates (i.e. inserts, modifies, or deletes) and
 // translates them so that they are consumable by the AppDb. It will also
 // create, or remove, any VRF IDs as needed.
+//
+// If `times` is set it is filled with how long each stage took.
 absl::Status UpdateAppDb(P4rtTable& p4rt_table,
                          VrfTable& vrf_table,
                          const AppDbUpdates& updates,
                          const pdpi::IrP4Info& p4_info,
-                         pdpi::IrWriteResponse* response);
+                         pdpi::IrWriteResponse* response,
+                         AppDbUpdateTimes* times = nullptr);
 
 // Returns all P4RT keys currently installed in the AppStateDb. This does not
 // include any keys that are currently being handled by the lower layers (i.e.
 // keys starting with _).
 std::vector<std::string> GetAllP4TableEntryKeys(P4rtTable& p4rt_table);
 
+// Returns the CountersDB key of each P4RT_TABLE key.
+std::vector<std::string> GetCounterDbKeys(
+    P4rtTable& p4rt_table, const std::vector<std::string>& p4rt_keys);
+
+// Appends counter data, as read from the CountersDB, to a PI table entry.
+absl::Status AppendCounterDataToTableEntry(
+    const std::vector<std::pair<std::string, std::string>>& counter_data,
+    p4::v1::TableEntry& pi_table_entry);
+
 // Returns the expected P4RT_TABLE key for a given IRTableEntry.
 absl::StatusOr<std::string> GetRedisP4rtTableKey(
     const pdpi::IrTableEntry& entry, const pdpi::IrP4Info& p4_info);
@@ -135,6 +207,13 @@ absl::StatusOr<pdpi::IrTableEntry> ReadP4TableEntry(
     P4rtTable& p4rt_table, const pdpi::IrP4Info& p4info,
     const std::string& key);
 
+// Reads multiple table entries from the P4RT_TABLE using pipelined requests.
+// Results are returned in the same order as the keys. Unlike ReadP4TableEntry
+// this function does not read any counter data.
+std::vector<absl::StatusOr<pdpi::IrTableEntry>> ReadP4TableEntries(
+    P4rtTable& p4rt_table, const pdpi::IrP4Info& p4info,
+    const std::vector<std::string>& keys);
+
 // Checks CounterDB for any counter data relating to the table entry and appends
 // it to the ir_table_entry argument. The ir_table_entry is untouched if no
 // counter data is found.
@@ -142,6 +221,16 @@ absl::Status AppendCounterDataForTableEntry(pdpi::IrTableEntry& ir_table_entry,
                                             P4rtTable& p4rt_table,
                                             const pdpi::IrP4Info& p4info);
 
+// Checks CounterDB for counter data relating to each PI table entry and appends
+// it. Every entry is fetched with one pipelined CounterDB request. The
+// `p4rt_keys` are the P4RT_TABLE keys (see GetRedisP4rtTableKey) for each
+// entry in `pi_table_entries`. An entry is untouched if no counter data is
+// found.
+absl::Status AppendCounterDataForTableEntries(
+    const std::vector<std::string>& p4rt_keys,
+    const std::vector<p4::v1::TableEntry*>& pi_table_entries,
+    P4rtTable& p4rt_table);
+
 // Returns the expected P4RT_TABLE key for a given IRTableEntry.
 absl::StatusOr<std::string> GetRedisP4rtTableKey(
     const pdpi::IrTableEntry& entry, const pdpi::IrP4Info& p4_info);
@@ -15,11 +15,14 @@
 
 #include <map>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
 #include "glog/logging.h"
 #include "gmock/gmock.h"
 #include "google/protobuf/text_format.h"
@@ -27,6 +30,7 @@
 #include "gtest/gtest.h"
 #include "gutil/proto_matchers.h"
 #include "gutil/status_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4rt_app/sonic/adapters/mock_consumer_notifier_adapter.h"
 #include "p4rt_app/sonic/adapters/mock_notification_producer_adapter.h"
@@ -61,6 +65,42 @@ GetSuccessfulResponseValues() {
   return *kResponse;
 }
 
+// Returns an insert of a router interface with the `id`.
+AppDbEntry RouterInterfaceInsert(int rpc_index, absl::string_view id) {
+  pdpi::IrEntity entity;
+  pdpi::IrTableEntry& entry = *entity.mutable_table_entry();
+  entry.set_table_name("router_interface_table");
+  pdpi::IrMatch& match = *entry.add_matches();
+  match.set_name("router_interface_id");
+  match.mutable_exact()->set_hex_str(std::string(id));
+  entry.mutable_action()->set_name("set_port_and_src_mac");
+  pdpi::IrActionInvocation::IrActionParam& port =
+      *entry.mutable_action()->add_params();
+  port.set_name("port");
+  port.mutable_value()->set_str("Ethernet28/5");
+  pdpi::IrActionInvocation::IrActionParam& src_mac =
+      *entry.mutable_action()->add_params();
+  src_mac.set_name("src_mac");
+  src_mac.mutable_value()->set_mac("00:02:03:04:05:06");
+  return AppDbEntry{
+      .rpc_index = rpc_index,
+      .entry = entity,
+      .update_type = p4::v1::Update::INSERT,
+      .appdb_table = AppDbTableType::P4RT,
+  };
+}
+
+// The P4RT_TABLE update for a RouterInterfaceInsert.
+swss::KeyOpFieldsValuesTuple RouterInterfaceKeyValue(absl::string_view id) {
+  const auto entry = AppDbEntryBuilder{}
+                         .SetTableName("FIXED_ROUTER_INTERFACE_TABLE")
+                         .AddMatchField("router_interface_id", std::string(id))
+                         .SetAction("set_port_and_src_mac")
+                         .AddActionParam("port", "Ethernet28/5")
+                         .AddActionParam("src_mac", "00:02:03:04:05:06");
+  return std::make_tuple(entry.GetKey(), "SET", entry.GetValueList());
+}
+
 class AppDbManagerTest : public ::testing::Test {
  protected:
   AppDbManagerTest() {
@@ -555,6 +595,84 @@ TEST_F(AppDbManagerTest, ReadAclTableEntryWithMeterCounterData) {
                 })pb"));
 }
 
+TEST_F(AppDbManagerTest, ReadP4TableEntriesUsesOneBatchRead) {
+  const auto app_db_entry = AppDbEntryBuilder{}
+                                .SetTableName("ACL_ACL_INGRESS_TABLE")
+                                .SetPriority(123)
+                                .AddMatchField("ether_type", "0x0800&0xFFFF")
+                                .SetAction("drop");
+
+  // Both entries should be read with one request, and because the entries are
+  // only used to rebuild the cache we never read any counter data.
+  EXPECT_CALL(*mock_p4rt_app_db_, get).Times(0);
+  EXPECT_CALL(*mock_p4rt_counter_db_, get).Times(0);
+  EXPECT_CALL(*mock_p4rt_counter_db_, batch_get).Times(0);
+  const std::vector<std::string> keys = {app_db_entry.GetKey(),
+                                         "ACL_ACL_INGRESS_TABLE:missing"};
+  EXPECT_CALL(*mock_p4rt_app_db_, batch_get(ContainerEq(keys)))
+      .WillOnce(
+          Return(std::vector<std::vector<std::pair<std::string, std::string>>>{
+              app_db_entry.GetValueList()}));
+
+  std::vector<absl::StatusOr<pdpi::IrTableEntry>> table_entries =
+      ReadP4TableEntries(mock_p4rt_table_,
+                         sai::GetIrP4Info(sai::Instantiation::kMiddleblock),
+                         keys);
+  ASSERT_EQ(table_entries.size(), 2);
+  ASSERT_OK(table_entries[0].status());
+  EXPECT_THAT(*table_entries[0], EqualsProto(R"pb(
+                table_name: "acl_ingress_table"
+                priority: 123
+                matches {
+                  name: "ether_type"
+                  ternary {
+                    value { hex_str: "0x0800" }
+                    mask { hex_str: "0xFFFF" }
+                  }
+                }
+                action { name: "drop" })pb"));
+  EXPECT_THAT(table_entries[1], StatusIs(absl::StatusCode::kInternal));
+}
+
+TEST_F(AppDbManagerTest, AppendCounterDataForTableEntriesUsesOneBatchRead) {
+  p4::v1::TableEntry entry1;
+  entry1.set_table_id(1);
+  entry1.set_priority(123);
+  p4::v1::TableEntry entry2;
+  entry2.set_table_id(1);
+  entry2.set_priority(124);
+
+  // Counter data for both entries should be fetched with one request, and the
+  // second entry has no counter data.
+  EXPECT_CALL(*mock_p4rt_app_db_, getTablePrefix)
+      .WillOnce(Return("P4RT_TABLE:"));
+  EXPECT_CALL(*mock_p4rt_counter_db_, get).Times(0);
+  EXPECT_CALL(*mock_p4rt_counter_db_,
+              batch_get(ContainerEq(std::vector<std::string>{
+                  "P4RT_TABLE:ACL_TABLE:key1", "P4RT_TABLE:ACL_TABLE:key2"})))
+      .WillOnce(
+          Return(std::vector<std::vector<std::pair<std::string, std::string>>>{
+              {{"packets", "10"}, {"bytes", "100"}}, {}}));
+
+  ASSERT_OK(AppendCounterDataForTableEntries(
+      {"ACL_TABLE:key1", "ACL_TABLE:key2"}, {&entry1, &entry2},
+      mock_p4rt_table_));
+  EXPECT_THAT(entry1.counter_data(), EqualsProto(R"pb(
+                byte_count: 100
+                packet_count: 10
+              )pb"));
+  EXPECT_FALSE(entry2.has_counter_data());
+}
+
+TEST_F(AppDbManagerTest, AppendCounterDataForTableEntriesRejectsKeyMismatch) {
+  p4::v1::TableEntry entry;
+  EXPECT_CALL(*mock_p4rt_counter_db_, batch_get).Times(0);
+  EXPECT_THAT(
+      AppendCounterDataForTableEntries({"key1", "key2"}, {&entry},
+                                       mock_p4rt_table_),
+      StatusIs(absl::StatusCode::kInternal));
+}
+
 TEST_F(AppDbManagerTest, GetAllP4KeysReturnsInstalledKeys) {
   EXPECT_CALL(*mock_p4rt_app_db_, keys)
       .WillOnce(Return(std::vector<std::string>{"TABLE:{key}"}));
@@ -574,6 +692,98 @@ TEST_F(AppDbManagerTest, GetAllP4KeysIgnoresCertainTables) {
               ContainerEq(std::vector<std::string>{"TABLE:{key}"}));
 }
 
+TEST_F(AppDbManagerTest, PublishPolicySplitsUpdatesIntoSends) {
+  AppDbUpdates updates;
+  updates.entries = {RouterInterfaceInsert(0, "16"),
+                     RouterInterfaceInsert(1, "17"),
+                     RouterInterfaceInsert(2, "18")};
+  updates.total_rpc_updates = 3;
+  AppDbPublishPolicy policy;
+  policy.limits_by_table["FIXED"] = {.max_entries = 2};
+  updates.publish_policy = &policy;
+
+  const std::vector<swss::KeyOpFieldsValuesTuple> first_send = {
+      RouterInterfaceKeyValue("16"), RouterInterfaceKeyValue("17")};
+  const std::vector<swss::KeyOpFieldsValuesTuple> second_send = {
+      RouterInterfaceKeyValue("18")};
+  EXPECT_CALL(*mock_p4rt_notification_producer_, send(first_send)).Times(1);
+  EXPECT_CALL(*mock_p4rt_notification_producer_, send(second_send)).Times(1);
+
+  EXPECT_CALL(*mock_p4rt_notifier_, WaitForNotificationAndPop)
+      .WillOnce(DoAll(SetArgReferee<0>("SWSS_RC_SUCCESS"),
+                      SetArgReferee<1>(kfvKey(first_send[0])),
+                      SetArgReferee<2>(GetSuccessfulResponseValues()),
+                      Return(true)))
+      .WillOnce(DoAll(SetArgReferee<0>("SWSS_RC_SUCCESS"),
+                      SetArgReferee<1>(kfvKey(first_send[1])),
+                      SetArgReferee<2>(GetSuccessfulResponseValues()),
+                      Return(true)))
+      .WillOnce(DoAll(SetArgReferee<0>("SWSS_RC_SUCCESS"),
+                      SetArgReferee<1>(kfvKey(second_send[0])),
+                      SetArgReferee<2>(GetSuccessfulResponseValues()),
+                      Return(true)));
+
+  pdpi::IrWriteResponse response;
+  for (int i = 0; i < 3; ++i) response.add_statuses();
+  EXPECT_OK(UpdateAppDb(mock_p4rt_table_, mock_vrf_table_, updates,
+                        sai::GetIrP4Info(sai::Instantiation::kMiddleblock),
+                        &response));
+  ASSERT_EQ(response.statuses_size(), 3);
+  for (const pdpi::IrUpdateStatus& status : response.statuses()) {
+    EXPECT_EQ(status.code(), google::rpc::OK);
+  }
+}
+
+TEST_F(AppDbManagerTest, PublishPolicyStopsSendingAfterAFailure) {
+  AppDbUpdates updates;
+  updates.entries = {RouterInterfaceInsert(0, "16"),
+                     RouterInterfaceInsert(1, "17")};
+  updates.total_rpc_updates = 2;
+  AppDbPublishPolicy policy;
+  policy.default_limits.max_entries = 1;
+  updates.publish_policy = &policy;
+
+  const std::vector<swss::KeyOpFieldsValuesTuple> first_send = {
+      RouterInterfaceKeyValue("16")};
+  EXPECT_CALL(*mock_p4rt_notification_producer_, send(first_send)).Times(1);
+
+  const std::vector<std::pair<std::string, std::string>> kFailure = {
+      {"err_str", "my error"}};
+  EXPECT_CALL(*mock_p4rt_notifier_, WaitForNotificationAndPop)
+      .WillOnce(DoAll(SetArgReferee<0>("SWSS_RC_INVALID_PARAM"),
+                      SetArgReferee<1>(kfvKey(first_send[0])),
+                      SetArgReferee<2>(kFailure), Return(true)));
+
+  pdpi::IrWriteResponse response;
+  for (int i = 0; i < 2; ++i) response.add_statuses();
+  EXPECT_OK(UpdateAppDb(mock_p4rt_table_, mock_vrf_table_, updates,
+                        sai::GetIrP4Info(sai::Instantiation::kMiddleblock),
+                        &response));
+  ASSERT_EQ(response.statuses_size(), 2);
+  EXPECT_EQ(response.statuses(0).code(), google::rpc::INVALID_ARGUMENT);
+  EXPECT_EQ(response.statuses(1).code(), google::rpc::ABORTED);
+}
+
+TEST(ParseAppDbPublishLimitsByTableTest, ParsesEveryTable) {
+  ASSERT_OK_AND_ASSIGN(
+      auto limits,
+      ParseAppDbPublishLimitsByTable("ACL=100:0, FIXED_IPV4_TABLE=0:4096"));
+  ASSERT_EQ(limits.size(), 2);
+  EXPECT_EQ(limits["ACL"].max_entries, 100);
+  EXPECT_EQ(limits["ACL"].max_bytes, 0);
+  EXPECT_EQ(limits["FIXED_IPV4_TABLE"].max_entries, 0);
+  EXPECT_EQ(limits["FIXED_IPV4_TABLE"].max_bytes, 4096);
+}
+
+TEST(ParseAppDbPublishLimitsByTableTest, RejectsInvalidLimits) {
+  for (absl::string_view limits :
+       {"ACL", "ACL=100", "=1:1", "ACL=a:1", "ACL=-1:0", "ACL=1:1,ACL=2:2"}) {
+    SCOPED_TRACE(limits);
+    EXPECT_THAT(ParseAppDbPublishLimitsByTable(limits),
+                StatusIs(absl::StatusCode::kInvalidArgument));
+  }
+}
+
 }  // namespace
 }  // namespace sonic
 }  // namespace p4rt_app
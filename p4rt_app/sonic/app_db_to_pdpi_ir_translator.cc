@@ -13,12 +13,17 @@
 // limitations under the License.
 #include "p4rt_app/sonic/app_db_to_pdpi_ir_translator.h"
 
+#include <algorithm>
 #include <iterator>
 #include <optional>
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_split.h"
@@ -132,6 +137,72 @@ absl::StatusOr<std::string> IrValueToAppDbString(const pdpi::IrValue &value) {
          << "Unsupported IrValue type: " << value.ShortDebugString();
 }
 
+// Returns the AppDb string for an IrValue without copying it, or nullptr if
+// the format is not supported.
+const std::string *IrValueToAppDbStringOrNull(const pdpi::IrValue &value) {
+  switch (value.format_case()) {
+    case pdpi::IrValue::kHexStr:
+      return &value.hex_str();
+    case pdpi::IrValue::kIpv4:
+      return &value.ipv4();
+    case pdpi::IrValue::kIpv6:
+      return &value.ipv6();
+    case pdpi::IrValue::kMac:
+      return &value.mac();
+    case pdpi::IrValue::kStr:
+      return &value.str();
+    default:
+      return nullptr;
+  }
+}
+
+// Appends `value` to `out` with the same escaping as nlohmann::json::dump().
+// Returns false for non-ASCII values since dump() would validate them as UTF-8.
+bool AppendJsonEscaped(absl::string_view value, std::string &out) {
+  for (unsigned char c : value) {
+    switch (c) {
+      case '"':
+        out.append("\\\"");
+        break;
+      case '\\':
+        out.append("\\\\");
+        break;
+      case '\b':
+        out.append("\\b");
+        break;
+      case '\f':
+        out.append("\\f");
+        break;
+      case '\n':
+        out.append("\\n");
+        break;
+      case '\r':
+        out.append("\\r");
+        break;
+      case '\t':
+        out.append("\\t");
+        break;
+      default:
+        if (c >= 0x80) return false;
+        if (c < 0x20) {
+          absl::StrAppendFormat(&out, "\\u%04x", c);
+        } else {
+          out.push_back(c);
+        }
+    }
+  }
+  return true;
+}
+
+// Returns the quoted JSON object name followed by the separator, or an empty
+// string if the name cannot be serialized by the fast path.
+std::string JsonObjectName(absl::string_view name) {
+  std::string json_name = "\"";
+  if (!AppendJsonEscaped(name, json_name)) return "";
+  json_name.append("\":");
+  return json_name;
+}
+
 absl::StatusOr<pdpi::IrMatch::IrLpmMatch> AppDbLpmValueToIrLpmMatch(
     const std::string &value, pdpi::Format format) {
   pdpi::IrMatch::IrLpmMatch lpm;
@@ -588,6 +659,269 @@ absl::StatusOr<pdpi::IrTableEntry> AppDbKeyAndValuesToIrTableEntry(
   return table_entry;
 }
 
+AppDbSerializationPlan::AppDbSerializationPlan(
+    const pdpi::IrP4Info &ir_p4_info) {
+  for (const auto &[table_name, table_def] : ir_p4_info.tables_by_name()) {
+    Table &table = tables_by_name_[table_name];
+    absl::StatusOr<table::Type> table_type = GetTableType(table_def);
+    if (!table_type.ok()) {
+      table.status = table_type.status();
+      continue;
+    }
+    table.key_prefix = absl::AsciiStrToUpper(absl::Substitute(
+        "$0_$1:", table::TypeName(*table_type), table_name));
+
+    // The JSON key is ordered by name, so we rank the fields up front.
+    std::vector<std::string> names;
+    for (const auto &[name, _] : table_def.match_fields_by_name()) {
+      names.push_back(name);
+    }
+    std::sort(names.begin(), names.end());
+    for (int rank = 0; rank < names.size(); ++rank) {
+      table.match_fields_by_name[names[rank]] = MatchField{
+          .json_name = JsonObjectName(AddAppDbMatchPrefix(names[rank])),
+          .rank = rank,
+      };
+    }
+  }
+
+  for (const auto &[action_name, action_def] : ir_p4_info.actions_by_name()) {
+    Action &action = actions_by_name_[action_name];
+    std::vector<std::string> names;
+    for (const auto &[name, _] : action_def.params_by_name()) {
+      names.push_back(name);
+    }
+    std::sort(names.begin(), names.end());
+    for (int rank = 0; rank < names.size(); ++rank) {
+      std::string field_name = AddAppDbActionParamPrefix(names[rank]);
+      std::string json_name = JsonObjectName(field_name);
+      action.params_by_name[names[rank]] = ActionParam{
+          .field_name = std::move(field_name),
+          .json_name = std::move(json_name),
+          .rank = rank,
+      };
+    }
+  }
+}
+
+const AppDbSerializationPlan::Table *AppDbSerializationPlan::FindTable(
+    absl::string_view table_name) const {
+  auto iter = tables_by_name_.find(table_name);
+  if (iter == tables_by_name_.end()) return nullptr;
+  return &iter->second;
+}
+
+const AppDbSerializationPlan::Action *AppDbSerializationPlan::FindAction(
+    absl::string_view action_name) const {
+  auto iter = actions_by_name_.find(action_name);
+  if (iter == actions_by_name_.end()) return nullptr;
+  return &iter->second;
+}
+
+absl::StatusOr<std::string> AppDbEntrySerializer::P4rtTableKey(
+    const pdpi::IrTableEntry &entry) {
+  const AppDbSerializationPlan::Table *table =
+      plan_.FindTable(entry.table_name());
+  if (table == nullptr) {
+    return gutil::InternalErrorBuilder()
+           << "Table name '" << entry.table_name() << "' does not exist";
+  }
+  RETURN_IF_ERROR(table->status);
+
+  buffer_.assign(table->key_prefix);
+  if (SerializeJsonKey(*table, entry)) return buffer_;
+
+  ASSIGN_OR_RETURN(const std::string json_key, IrTableEntryToAppDbKey(entry));
+  return absl::StrCat(table->key_prefix, json_key);
+}
+
+absl::StatusOr<std::vector<swss::FieldValueTuple>>
+AppDbEntrySerializer::AppDbValues(const pdpi::IrTableEntry &entry) {
+  std::vector<swss::FieldValueTuple> result;
+
+  switch (entry.type_case()) {
+    case pdpi::IrTableEntry::kAction: {
+      const pdpi::IrActionInvocation &invocation = entry.action();
+      const AppDbSerializationPlan::Action *action =
+          plan_.FindAction(invocation.name());
+      if (action == nullptr) return IrTableEntryToAppDbValues(entry);
+
+      // Leave room for the meter values and controller metadata.
+      result.reserve(invocation.params_size() + 6);
+      result.emplace_back("action", invocation.name());
+      for (const auto &param : invocation.params()) {
+        const AppDbSerializationPlan::ActionParam *param_plan =
+            gutil::FindOrNull(action->params_by_name, param.name());
+        const std::string *value = IrValueToAppDbStringOrNull(param.value());
+        if (param_plan == nullptr || value == nullptr) {
+          return IrTableEntryToAppDbValues(entry);
+        }
+        result.emplace_back(param_plan->field_name, *value);
+      }
+      break;
+    }
+    case pdpi::IrTableEntry::kActionSet: {
+      buffer_.clear();
+      if (!SerializeActionSet(entry.action_set())) {
+        return IrTableEntryToAppDbValues(entry);
+      }
+      result.reserve(6);
+      result.emplace_back("actions", buffer_);
+      break;
+    }
+    default:
+      return IrTableEntryToAppDbValues(entry);
+  }
+
+  if (entry.has_meter_config()) {
+    auto meter_values = P4MeterConfigToAppDbValues(entry.meter_config());
+    result.insert(result.end(), std::make_move_iterator(meter_values.begin()),
+                  std::make_move_iterator(meter_values.end()));
+  }
+
+  if (!entry.controller_metadata().empty()) {
+    result.emplace_back("controller_metadata", entry.controller_metadata());
+  }
+
+  return result;
+}
+
+bool AppDbEntrySerializer::SerializeJsonKey(
+    const AppDbSerializationPlan::Table &table,
+    const pdpi::IrTableEntry &entry) {
+  sorted_matches_.clear();
+  for (const pdpi::IrMatch &match : entry.matches()) {
+    // Optional matches without a value are not part of the key.
+    if (match.match_value_case() == pdpi::IrMatch::kOptional &&
+        !match.optional().has_value()) {
+      continue;
+    }
+    const AppDbSerializationPlan::MatchField *field =
+        gutil::FindOrNull(table.match_fields_by_name, match.name());
+    if (field == nullptr || field->json_name.empty()) return false;
+    sorted_matches_.push_back({field->rank, &match});
+  }
+  std::sort(sorted_matches_.begin(), sorted_matches_.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+
+  // An empty JSON object is serialized as null.
+  if (sorted_matches_.empty() && entry.priority() <= 0) {
+    buffer_.append("null");
+    return true;
+  }
+
+  buffer_.push_back('{');
+  for (int i = 0; i < sorted_matches_.size(); ++i) {
+    const auto &[rank, match] = sorted_matches_[i];
+    if (i > 0) {
+      // Leave duplicate fields to the generic translation.
+      if (sorted_matches_[i - 1].first == rank) return false;
+      buffer_.push_back(',');
+    }
+    buffer_.append(
+        gutil::FindOrNull(table.match_fields_by_name, match->name())
+            ->json_name);
+    buffer_.push_back('"');
+    switch (match->match_value_case()) {
+      case pdpi::IrMatch::kExact: {
+        const std::string *value = IrValueToAppDbStringOrNull(match->exact());
+        if (value == nullptr || !AppendJsonEscaped(*value, buffer_)) {
+          return false;
+        }
+        break;
+      }
+      case pdpi::IrMatch::kLpm: {
+        const std::string *value =
+            IrValueToAppDbStringOrNull(match->lpm().value());
+        if (value == nullptr || !AppendJsonEscaped(*value, buffer_)) {
+          return false;
+        }
+        absl::StrAppend(&buffer_, "/", match->lpm().prefix_length());
+        break;
+      }
+      case pdpi::IrMatch::kTernary: {
+        const std::string *value =
+            IrValueToAppDbStringOrNull(match->ternary().value());
+        const std::string *mask =
+            IrValueToAppDbStringOrNull(match->ternary().mask());
+        if (value == nullptr || mask == nullptr ||
+            !AppendJsonEscaped(*value, buffer_)) {
+          return false;
+        }
+        buffer_.append(kTernaryMatchDelimiter);
+        if (!AppendJsonEscaped(*mask, buffer_)) return false;
+        break;
+      }
+      case pdpi::IrMatch::kOptional: {
+        const std::string *value =
+            IrValueToAppDbStringOrNull(match->optional().value());
+        if (value == nullptr || !AppendJsonEscaped(*value, buffer_)) {
+          return false;
+        }
+        break;
+      }
+      default:
+        return false;
+    }
+    buffer_.push_back('"');
+  }
+
+  // "priority" sorts after every "match/" field.
+  if (entry.priority() > 0) {
+    if (!sorted_matches_.empty()) buffer_.push_back(',');
+    absl::StrAppend(&buffer_, "\"priority\":", entry.priority());
+  }
+  buffer_.push_back('}');
+  return true;
+}
+
+bool AppDbEntrySerializer::SerializeActionSet(
+    const pdpi::IrActionSet &action_set) {
+  buffer_.push_back('[');
+  for (int i = 0; i < action_set.actions_size(); ++i) {
+    const pdpi::IrActionSetInvocation &invocation = action_set.actions(i);
+    const AppDbSerializationPlan::Action *action =
+        plan_.FindAction(invocation.action().name());
+    if (action == nullptr) return false;
+
+    sorted_params_.clear();
+    for (const auto &param : invocation.action().params()) {
+      const AppDbSerializationPlan::ActionParam *param_plan =
+          gutil::FindOrNull(action->params_by_name, param.name());
+      if (param_plan == nullptr || param_plan->json_name.empty()) return false;
+      sorted_params_.push_back({param_plan->rank, &param});
+    }
+    std::sort(sorted_params_.begin(), sorted_params_.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    // Object names are ordered: action, param/*, watch_port, weight.
+    if (i > 0) buffer_.push_back(',');
+    buffer_.append("{\"action\":\"");
+    if (!AppendJsonEscaped(invocation.action().name(), buffer_)) return false;
+    buffer_.push_back('"');
+    for (int j = 0; j < sorted_params_.size(); ++j) {
+      const auto &[rank, param] = sorted_params_[j];
+      if (j > 0 && sorted_params_[j - 1].first == rank) return false;
+      const std::string *value = IrValueToAppDbStringOrNull(param->value());
+      if (value == nullptr) return false;
+      buffer_.push_back(',');
+      buffer_.append(
+          gutil::FindOrNull(action->params_by_name, param->name())->json_name);
+      buffer_.push_back('"');
+      if (!AppendJsonEscaped(*value, buffer_)) return false;
+      buffer_.push_back('"');
+    }
+    if (!invocation.watch_port().empty()) {
+      buffer_.append(",\"watch_port\":\"");
+      if (!AppendJsonEscaped(invocation.watch_port(), buffer_)) return false;
+      buffer_.push_back('"');
+    }
+    absl::StrAppend(&buffer_, ",\"weight\":", invocation.weight(), "}");
+  }
+  buffer_.push_back(']');
+  return true;
+}
+
 std::string IrMulticastGroupEntryToAppDbKey(
     const pdpi::IrMulticastGroupEntry &entry) {
   return absl::StrCat("0x",
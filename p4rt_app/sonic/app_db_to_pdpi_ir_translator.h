@@ -21,6 +21,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -46,6 +47,87 @@ absl::StatusOr<pdpi::IrTableEntry> AppDbKeyAndValuesToIrTableEntry(
     const pdpi::IrP4Info &ir_p4_info, absl::string_view app_db_key,
     const std::vector<std::pair<std::string, std::string>> &app_db_values);
 
+// Field names, and key prefixes, used when writing P4RT_TABLE entries. They only
+// depend on the P4Info so they are computed once per ForwardingPipelineConfig
+// instead of once per entry.
+class AppDbSerializationPlan {
+ public:
+  explicit AppDbSerializationPlan(const pdpi::IrP4Info& ir_p4_info);
+
+  struct MatchField {
+    // The quoted JSON name, including the separator (e.g. "match/vrf_id":).
+    std::string json_name;
+    // Position of the field when the JSON key is ordered by name.
+    int rank = 0;
+  };
+
+  struct Table {
+    // Set if the table type could not be determined from the P4Info.
+    absl::Status status;
+    // The P4RT_TABLE key prefix (e.g. FIXED_VRF_TABLE:).
+    std::string key_prefix;
+    absl::flat_hash_map<std::string, MatchField> match_fields_by_name;
+  };
+
+  struct ActionParam {
+    // The AppDb field name (e.g. param/port).
+    std::string field_name;
+    // The quoted JSON name used in action sets (e.g. "param/port":).
+    std::string json_name;
+    // Position of the parameter when the action set JSON is ordered by name.
+    int rank = 0;
+  };
+
+  struct Action {
+    absl::flat_hash_map<std::string, ActionParam> params_by_name;
+  };
+
+  // Returns nullptr if the table, or action, is not in the P4Info.
+  const Table* FindTable(absl::string_view table_name) const;
+  const Action* FindAction(absl::string_view action_name) const;
+
+ private:
+  absl::flat_hash_map<std::string, Table> tables_by_name_;
+  absl::flat_hash_map<std::string, Action> actions_by_name_;
+};
+
+// Builds the P4RT_TABLE key, and field values, for IR table entries. The output
+// is the same as GetRedisP4rtTableKey() and IrTableEntryToAppDbValues(), but
+// the JSON is written straight into a buffer that is reused between entries
+// instead of being built from temporary JSON objects.
+//
+// Entries that cannot be handled by the fast path (e.g. non-ASCII values) fall
+// back to the generic translation. Not thread-safe, so use one serializer per
+// batch or thread. The plan must outlive the serializer.
+class AppDbEntrySerializer {
+ public:
+  explicit AppDbEntrySerializer(const AppDbSerializationPlan& plan)
+      : plan_(plan) {}
+
+  // Returns the full P4RT_TABLE key: <TableType>_<TABLE_NAME>:<json_key>
+  absl::StatusOr<std::string> P4rtTableKey(const pdpi::IrTableEntry& entry);
+
+  // Returns the AppDb field values for the entry.
+  absl::StatusOr<std::vector<swss::FieldValueTuple>> AppDbValues(
+      const pdpi::IrTableEntry& entry);
+
+ private:
+  // Writes the JSON key into buffer_. Returns false if the fast path cannot
+  // handle the entry.
+  bool SerializeJsonKey(const AppDbSerializationPlan::Table& table,
+                        const pdpi::IrTableEntry& entry);
+
+  // Writes the action set JSON array into buffer_. Returns false if the fast
+  // path cannot handle the action set.
+  bool SerializeActionSet(const pdpi::IrActionSet& action_set);
+
+  const AppDbSerializationPlan& plan_;
+  std::string buffer_;
+  std::vector<std::pair<int, const pdpi::IrMatch*>> sorted_matches_;
+  std::vector<std::pair<int, const pdpi::IrActionInvocation::IrActionParam*>>
+      sorted_params_;
+};
+
 // Given a PDPI IrMulticastGroupEntry, generate the SONiC AppDb key for
 // packet replication in the P4RT table.
 std::string IrMulticastGroupEntryToAppDbKey(
@@ -13,11 +13,14 @@
 // limitations under the License.
 #include "p4rt_app/sonic/app_db_to_pdpi_ir_translator.h"
 
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "glog/logging.h"
 #include "gmock/gmock.h"
 #include "google/protobuf/text_format.h"
@@ -201,6 +204,200 @@ TEST(TranslatePdpiToAppDbTest, Meters) {
            {"meter/pburst", "456"}}))));
 }
 
+class AppDbEntrySerializerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK_AND_ASSIGN(ir_p4_info_, GetCanonicalP4Info());
+    plan_.emplace(ir_p4_info_);
+  }
+
+  // The serializer should always agree with the generic translation.
+  void ExpectSameAsGenericTranslation(const pdpi::IrTableEntry& entry,
+                                      absl::string_view key_prefix) {
+    AppDbEntrySerializer serializer(*plan_);
+    ASSERT_OK_AND_ASSIGN(std::string json_key, IrTableEntryToAppDbKey(entry));
+    EXPECT_THAT(serializer.P4rtTableKey(entry),
+                IsOkAndHolds(absl::StrCat(key_prefix, json_key)));
+    ASSERT_OK_AND_ASSIGN(std::vector<swss::FieldValueTuple> values,
+                         IrTableEntryToAppDbValues(entry));
+    EXPECT_THAT(serializer.AppDbValues(entry), IsOkAndHolds(ContainerEq(values)));
+  }
+
+  pdpi::IrP4Info ir_p4_info_;
+  std::optional<AppDbSerializationPlan> plan_;
+};
+
+TEST_F(AppDbEntrySerializerTest, ExactMatchAndAction) {
+  pdpi::IrTableEntry table_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(table_name: "neighbor_table"
+           matches {
+             name: "router_interface_id"
+             exact { str: "rif-1" }
+           }
+           matches {
+             name: "neighbor_id"
+             exact { ipv6: "fe80::1" }
+           }
+           action {
+             name: "set_dst_mac"
+             params {
+               name: "dst_mac"
+               value { mac: "00:01:02:03:04:05" }
+             }
+           })pb",
+      &table_entry));
+
+  AppDbEntrySerializer serializer(*plan_);
+  EXPECT_THAT(serializer.P4rtTableKey(table_entry),
+              IsOkAndHolds(R"(FIXED_NEIGHBOR_TABLE:{"match/neighbor_id":)"
+                           R"("fe80::1","match/router_interface_id":"rif-1"})"));
+  EXPECT_THAT(serializer.AppDbValues(table_entry),
+              IsOkAndHolds(ContainerEq(std::vector<swss::FieldValueTuple>{
+                  {"action", "set_dst_mac"},
+                  {"param/dst_mac", "00:01:02:03:04:05"},
+              })));
+  ExpectSameAsGenericTranslation(table_entry, "FIXED_NEIGHBOR_TABLE:");
+}
+
+TEST_F(AppDbEntrySerializerTest, LpmMatch) {
+  pdpi::IrTableEntry table_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(table_name: "ipv4_table"
+           matches {
+             name: "vrf_id"
+             exact { str: "vrf-1" }
+           }
+           matches {
+             name: "ipv4_dst"
+             lpm {
+               value { ipv4: "10.0.0.0" }
+               prefix_length: 8
+             }
+           }
+           action { name: "drop" })pb",
+      &table_entry));
+
+  EXPECT_THAT(AppDbEntrySerializer(*plan_).P4rtTableKey(table_entry),
+              IsOkAndHolds(R"(FIXED_IPV4_TABLE:{"match/ipv4_dst":)"
+                           R"("10.0.0.0/8","match/vrf_id":"vrf-1"})"));
+  ExpectSameAsGenericTranslation(table_entry, "FIXED_IPV4_TABLE:");
+}
+
+TEST_F(AppDbEntrySerializerTest, TernaryAndOptionalMatchesWithPriority) {
+  pdpi::IrTableEntry table_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(table_name: "acl_ingress_table"
+           priority: 10
+           matches {
+             name: "is_ipv4"
+             optional { value { hex_str: "0x1" } }
+           }
+           matches {
+             name: "ether_type"
+             ternary {
+               value { hex_str: "0x0800" }
+               mask { hex_str: "0xffff" }
+             }
+           }
+           matches { name: "is_ip" optional {} }
+           action { name: "acl_drop" }
+           meter_config { cir: 123 cburst: 234 pir: 345 pburst: 456 }
+           controller_metadata: "abc")pb",
+      &table_entry));
+
+  EXPECT_THAT(AppDbEntrySerializer(*plan_).P4rtTableKey(table_entry),
+              IsOkAndHolds(R"(ACL_ACL_INGRESS_TABLE:{"match/ether_type":)"
+                           R"("0x0800&0xffff","match/is_ipv4":"0x1",)"
+                           R"("priority":10})"));
+  ExpectSameAsGenericTranslation(table_entry, "ACL_ACL_INGRESS_TABLE:");
+}
+
+TEST_F(AppDbEntrySerializerTest, ActionSet) {
+  pdpi::IrTableEntry table_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(table_name: "wcmp_group_table"
+           matches {
+             name: "wcmp_group_id"
+             exact { str: "group-1" }
+           }
+           action_set {
+             actions {
+               action {
+                 name: "set_nexthop_id"
+                 params {
+                   name: "nexthop_id"
+                   value { str: "nexthop-1" }
+                 }
+               }
+               weight: 1
+               watch_port: "Ethernet0"
+             }
+             actions {
+               action {
+                 name: "set_nexthop_id"
+                 params {
+                   name: "nexthop_id"
+                   value { str: "nexthop-2" }
+                 }
+               }
+               weight: 2
+             }
+           })pb",
+      &table_entry));
+
+  ExpectSameAsGenericTranslation(table_entry, "FIXED_WCMP_GROUP_TABLE:");
+}
+
+TEST_F(AppDbEntrySerializerTest, EmptyKeyIsSerializedAsNull) {
+  pdpi::IrTableEntry table_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(table_name: "neighbor_table" action { name: "set_dst_mac" })pb",
+      &table_entry));
+
+  EXPECT_THAT(AppDbEntrySerializer(*plan_).P4rtTableKey(table_entry),
+              IsOkAndHolds("FIXED_NEIGHBOR_TABLE:null"));
+  ExpectSameAsGenericTranslation(table_entry, "FIXED_NEIGHBOR_TABLE:");
+}
+
+TEST_F(AppDbEntrySerializerTest, EscapesValuesLikeTheGenericTranslation) {
+  pdpi::IrTableEntry table_entry;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(table_name: "ipv4_table"
+           matches {
+             name: "vrf_id"
+             exact { str: "a\"b\\c\n\t\001" }
+           }
+           action { name: "drop" })pb",
+      &table_entry));
+  ExpectSameAsGenericTranslation(table_entry, "FIXED_IPV4_TABLE:");
+
+  // Non-ASCII values are handled by the generic translation.
+  table_entry.mutable_matches(0)->mutable_exact()->set_str("vrf-\xc3\xa9");
+  ExpectSameAsGenericTranslation(table_entry, "FIXED_IPV4_TABLE:");
+}
+
+TEST_F(AppDbEntrySerializerTest, SerializerCanBeReusedForABatch) {
+  AppDbEntrySerializer serializer(*plan_);
+  for (const std::string vrf : {"vrf-long-name", "v", "vrf-2"}) {
+    pdpi::IrTableEntry table_entry;
+    table_entry.set_table_name("vrf_table");
+    pdpi::IrMatch* match = table_entry.add_matches();
+    match->set_name("vrf_id");
+    match->mutable_exact()->set_str(vrf);
+    EXPECT_THAT(serializer.P4rtTableKey(table_entry),
+                IsOkAndHolds(absl::StrCat(R"(FIXED_VRF_TABLE:{"match/vrf_id":")",
+                                          vrf, R"("})")));
+  }
+}
+
+TEST_F(AppDbEntrySerializerTest, UnknownTableFails) {
+  pdpi::IrTableEntry table_entry;
+  table_entry.set_table_name("unknown_table");
+  EXPECT_THAT(AppDbEntrySerializer(*plan_).P4rtTableKey(table_entry),
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("unknown_table")));
+}
+
 TEST(TranslateAppDbToPdpiTest, AppDbKeyAndValuesToIrTableEntryExactMatch) {
   const std::string app_db_key =
       R"(FIXED_ROUTER_INTERFACE_TABLE:)"
@@ -0,0 +1,63 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/entry_generations.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "swss/table.h"
+
+namespace p4rt_app {
+namespace sonic {
+
+void EntryGenerations::RecordUpdates(
+    const std::vector<swss::KeyOpFieldsValuesTuple>& updates) {
+  absl::MutexLock l(&lock_);
+  for (const swss::KeyOpFieldsValuesTuple& update : updates) {
+    if (kfvOp(update) == "DEL") {
+      generations_.erase(kfvKey(update));
+    } else {
+      ++generations_[kfvKey(update)].written;
+    }
+  }
+}
+
+void EntryGenerations::RecordUpdate(absl::string_view key) {
+  absl::MutexLock l(&lock_);
+  ++generations_[std::string(key)].written;
+}
+
+bool EntryGenerations::IsVerified(absl::string_view key) const {
+  absl::MutexLock l(&lock_);
+  auto it = generations_.find(key);
+  return it != generations_.end() &&
+         it->second.verified == it->second.written;
+}
+
+void EntryGenerations::MarkVerified(absl::string_view key) {
+  absl::MutexLock l(&lock_);
+  Generations& generations = generations_[std::string(key)];
+  generations.verified = generations.written;
+}
+
+int64_t EntryGenerations::size() const {
+  absl::MutexLock l(&lock_);
+  return generations_.size();
+}
+
+}  // namespace sonic
+}  // namespace p4rt_app
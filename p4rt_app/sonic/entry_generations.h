@@ -0,0 +1,70 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_SONIC_ENTRY_GENERATIONS_H_
+#define PINS_P4RT_APP_SONIC_ENTRY_GENERATIONS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "swss/table.h"
+
+namespace p4rt_app {
+namespace sonic {
+
+// Tracks a generation for every key the P4RT App writes into an AppDb table,
+// and the generation at which the AppDb and AppStateDb copies of the entry
+// were last verified to match. Routine state verification uses it to only
+// read the entries that changed since they were last verified, instead of
+// rereading every entry of both DBs.
+//
+// Thread-safe.
+class EntryGenerations {
+ public:
+  // Bumps the generation of every key in `updates`, and stops tracking the
+  // deleted ones. Called once OrchAgent has responded, whether it accepted the
+  // updates or they were reverted.
+  void RecordUpdates(const std::vector<swss::KeyOpFieldsValuesTuple>& updates)
+      ABSL_LOCKS_EXCLUDED(lock_);
+  void RecordUpdate(absl::string_view key) ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Returns true if `key` was verified and has not been written since.
+  bool IsVerified(absl::string_view key) const ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Records that both DBs hold the same copy of `key` at its current
+  // generation.
+  void MarkVerified(absl::string_view key) ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Returns the number of keys that are tracked.
+  int64_t size() const ABSL_LOCKS_EXCLUDED(lock_);
+
+ private:
+  struct Generations {
+    int64_t written = 0;
+    int64_t verified = -1;
+  };
+
+  mutable absl::Mutex lock_;
+  absl::flat_hash_map<std::string, Generations> generations_
+      ABSL_GUARDED_BY(lock_);
+};
+
+}  // namespace sonic
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_SONIC_ENTRY_GENERATIONS_H_
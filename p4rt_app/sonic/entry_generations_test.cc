@@ -0,0 +1,60 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/entry_generations.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "swss/table.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+TEST(EntryGenerationsTest, UnknownKeysAreNotVerified) {
+  EntryGenerations generations;
+  EXPECT_FALSE(generations.IsVerified("vrf-1"));
+}
+
+TEST(EntryGenerationsTest, WritesInvalidateTheVerification) {
+  EntryGenerations generations;
+  generations.MarkVerified("vrf-1");
+  EXPECT_TRUE(generations.IsVerified("vrf-1"));
+
+  generations.RecordUpdate("vrf-1");
+  EXPECT_FALSE(generations.IsVerified("vrf-1"));
+  generations.MarkVerified("vrf-1");
+  EXPECT_TRUE(generations.IsVerified("vrf-1"));
+}
+
+TEST(EntryGenerationsTest, RecordsEveryKeyInABatch) {
+  EntryGenerations generations;
+  generations.MarkVerified("vrf-1");
+  generations.MarkVerified("vrf-2");
+  generations.MarkVerified("vrf-3");
+
+  generations.RecordUpdates({
+      swss::KeyOpFieldsValuesTuple("vrf-1", "SET", {{"field", "value"}}),
+      swss::KeyOpFieldsValuesTuple("vrf-2", "DEL", {}),
+  });
+  EXPECT_FALSE(generations.IsVerified("vrf-1"));
+  EXPECT_FALSE(generations.IsVerified("vrf-2"));
+  EXPECT_TRUE(generations.IsVerified("vrf-3"));
+
+  // Deleted keys are no longer tracked.
+  EXPECT_EQ(generations.size(), 2);
+}
+
+}  // namespace
+}  // namespace sonic
+}  // namespace p4rt_app
@@ -16,6 +16,7 @@
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "glog/logging.h"
 #include "gutil/collections.h"
 
@@ -29,8 +30,7 @@ absl::Status FakePacketIoInterface::PushPacketIn(
           << packet;
 
   // Invoke the callback function for the passed in packets.
-  return callback_function_(std::string(source_port), std::string(target_port),
-                            std::string(packet));
+  return callback_function_(source_port, target_port, packet, absl::Now());
 }
 
 absl::StatusOr<std::vector<std::string>> FakePacketIoInterface::VerifyPacketOut(
@@ -197,6 +197,17 @@ absl::Status UpdateHashParamConfigsFromAction(
   return absl::OkStatus();
 }
 
+// Returns true if an APP_DB entry holds exactly the expected fields and
+// values, regardless of field order.
+bool AppDbEntryMatches(
+    const std::vector<std::pair<std::string, std::string>>& entry,
+    const std::vector<swss::FieldValueTuple>& expected) {
+  return absl::btree_map<std::string, std::string>(entry.begin(),
+                                                   entry.end()) ==
+         absl::btree_map<std::string, std::string>(expected.begin(),
+                                                   expected.end());
+}
+
 }  // namespace
 
 bool IsIpv4HashKey(absl::string_view key) {
@@ -260,23 +271,47 @@ absl::StatusOr<HashParamConfigs> ExtractHashParamConfigs(
 absl::Status ProgramHashFieldTable(HashTable& hash_table,
                                    std::vector<HashPacketFieldConfig> configs) {
   if (configs.empty()) return absl::OkStatus();
+
+  // Only write the configs that differ from what APP_DB already holds.
+  std::vector<std::string> keys;
+  keys.reserve(configs.size());
+  for (const auto& config : configs) keys.push_back(config.key);
+  std::vector<std::vector<std::pair<std::string, std::string>>> entries =
+      hash_table.app_db->batch_get(keys);
+
+  std::vector<HashPacketFieldConfig> changed_configs;
+  for (int i = 0; i < configs.size(); ++i) {
+    if (i < entries.size() &&
+        AppDbEntryMatches(entries[i], configs[i].AppDbContents())) {
+      continue;
+    }
+    changed_configs.push_back(std::move(configs[i]));
+  }
+  if (changed_configs.empty()) {
+    VLOG(1) << "Hash fields are already up to date.";
+    return absl::OkStatus();
+  }
   LOG(INFO) << "Apply hash fields: \n "
-            << absl::StrJoin(configs, "\n  ",
+            << absl::StrJoin(changed_configs, "\n  ",
                              HashPacketFieldConfig::AbslFormatter);
 
-  // Write to APP_DB.
+  // Write to APP_DB as one batch.
   pdpi::IrWriteResponse update_status;
   absl::btree_map<std::string, pdpi::IrUpdateStatus*> status_by_key;
-  for (const auto& config : configs) {
-    hash_table.producer_state->set(config.key, config.AppDbContents());
+  std::vector<swss::KeyOpFieldsValuesTuple> hash_updates;
+  for (const auto& config : changed_configs) {
+    hash_updates.push_back({config.key, "SET", config.AppDbContents()});
     status_by_key[config.key] = update_status.add_statuses();
   }
+  hash_table.producer_state->batch_set(hash_updates);
 
   // Wait for the OrchAgent's response.
   pdpi::IrWriteResponse ir_write_response;
-  RETURN_IF_ERROR(GetAndProcessResponseNotification(
+  absl::Status response_status = GetAndProcessResponseNotification(
       *hash_table.notification_consumer, *hash_table.app_db,
-      *hash_table.app_state_db, status_by_key));
+      *hash_table.app_state_db, status_by_key);
+  hash_table.generations->RecordUpdates(hash_updates);
+  RETURN_IF_ERROR(response_status);
 
   // Pickup the hash field keys that were written(and ack'ed) successfully by
   // OrchAgent.
@@ -304,17 +339,36 @@ absl::Status ProgramSwitchTable(
   }
   if (hash_tuples.empty()) return absl::OkStatus();
 
+  // Only write the fields that differ from what APP_DB already holds. Other
+  // fields in the entry are left untouched by a SET.
+  absl::btree_map<std::string, std::string> existing;
+  for (auto& [field, value] : switch_table.app_db->get(kSwitchTableEntryKey)) {
+    existing[field] = std::move(value);
+  }
+  std::vector<swss::FieldValueTuple> changed_tuples;
+  for (auto& [field, value] : hash_tuples) {
+    auto it = existing.find(field);
+    if (it != existing.end() && it->second == value) continue;
+    changed_tuples.push_back({std::move(field), std::move(value)});
+  }
+  if (changed_tuples.empty()) {
+    VLOG(1) << "Hash config is already up to date.";
+    return absl::OkStatus();
+  }
+
   LOG(INFO) << "Applying hash config: \n  "
-            << absl::StrJoin(hash_tuples, "\n  ", absl::PairFormatter(": "));
+            << absl::StrJoin(changed_tuples, "\n  ",
+                             absl::PairFormatter(": "));
 
   // Write to switch table and process response.
-  switch_table.producer_state->set(kSwitchTableEntryKey, hash_tuples);
+  switch_table.producer_state->set(kSwitchTableEntryKey, changed_tuples);
 
-  ASSIGN_OR_RETURN(
-      pdpi::IrUpdateStatus status,
+  absl::StatusOr<pdpi::IrUpdateStatus> response =
       GetAndProcessResponseNotification(
           *switch_table.notification_consumer, *switch_table.app_db,
-          *switch_table.app_state_db, kSwitchTableEntryKey));
+          *switch_table.app_state_db, kSwitchTableEntryKey);
+  switch_table.generations->RecordUpdate(kSwitchTableEntryKey);
+  ASSIGN_OR_RETURN(pdpi::IrUpdateStatus status, response);
 
   // Failing to program the switch table should never happen so we return an
   // internal error.
@@ -117,7 +117,8 @@ absl::StatusOr<HashParamConfigs> ExtractHashParamConfigs(
 
 // Programs the APP_DB entries (HASH_TABLE) that specifies which fields are
 // used for ECMP hashing (IPv4, IPv6), this creates the hash objects to
-// be used in the SWITCH_TABLE later.
+// be used in the SWITCH_TABLE later. Entries that APP_DB already holds are not
+// rewritten, and the rest are written as one batch.
 //
 // Example entry:
 //
@@ -129,7 +130,8 @@ absl::Status ProgramHashFieldTable(HashTable& hash_table,
 
 // Programs the APP_DB enries (SWITCH_TABLE) with all ecmp hashing related
 // fields in the switch table, like algorithm, seed, offset and the hash field
-// object.
+// object. Only the fields that differ from the current APP_DB entry are
+// written, so nothing is sent to the OrchAgent when the config is unchanged.
 absl::Status ProgramSwitchTable(
     SwitchTable& switch_table, const HashParamConfigs& hash_params,
     const std::vector<HashPacketFieldConfig>& hash_packet_fields);
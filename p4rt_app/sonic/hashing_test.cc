@@ -277,6 +277,28 @@ TEST(HashingTest, ProgramHashFieldTableSucceeds) {
                                   "l4_dst_port", "ipv6_flow_label"}))))));
 }
 
+TEST(HashingTest, ProgramHashFieldTableOnlyWritesChangedConfigs) {
+  ASSERT_OK_AND_ASSIGN(pdpi::IrP4Info ir_p4_info, GetSampleHashConfig("ecmp"));
+  ASSERT_OK_AND_ASSIGN(std::vector<HashPacketFieldConfig> configs,
+                       ExtractHashPacketFieldConfigs(ir_p4_info));
+  FakeTable fake_table;
+  HashTable hash_table = fake_table.GenerateHashTable();
+  ASSERT_OK(ProgramHashFieldTable(hash_table, configs));
+
+  // A failure response for an unchanged entry is never seen because the entry
+  // is not rewritten.
+  fake_table.db_table().SetResponseForKey("compute_ecmp_hash_ipv4",
+                                          "SWSS_RC_UNKNOWN", "Test Failure");
+  EXPECT_OK(ProgramHashFieldTable(hash_table, configs));
+
+  // Changing the IPv4 config rewrites it.
+  for (auto& config : configs) {
+    if (config.key == "compute_ecmp_hash_ipv4") config.fields = {"src_ip"};
+  }
+  EXPECT_THAT(ProgramHashFieldTable(hash_table, configs),
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("Test Failure")));
+}
+
 TEST(HashingTest, SupportLagHashConfig) {
   ASSERT_OK_AND_ASSIGN(pdpi::IrP4Info ir_p4_info, GetSampleHashConfig("lag"));
   ASSERT_OK_AND_ASSIGN(std::vector<HashPacketFieldConfig> configs,
@@ -719,6 +741,29 @@ TEST(HashingTest, ProgramSwitchTableSucceeds) {
                   Pair("ecmp_hash_ipv6", "compute_ecmp_hash_ipv6"))));
 }
 
+TEST(HashingTest, ProgramSwitchTableOnlyWritesChangedFields) {
+  ASSERT_OK_AND_ASSIGN(auto hash_field_configs,
+                       ExtractHashPacketFieldConfigs(FullHashIrP4Info()));
+  ASSERT_OK_AND_ASSIGN(auto hash_value_configs,
+                       ExtractHashParamConfigs(FullHashIrP4Info()));
+
+  FakeTable fake_table;
+  SwitchTable switch_table = fake_table.GenerateSwitchTable();
+  ASSERT_OK(
+      ProgramSwitchTable(switch_table, hash_value_configs, hash_field_configs));
+
+  // Nothing is written when the config is unchanged.
+  fake_table.db_table().SetResponseForKey("switch", "SWSS_RC_UNKNOWN",
+                                          "Test Failure");
+  EXPECT_OK(
+      ProgramSwitchTable(switch_table, hash_value_configs, hash_field_configs));
+
+  hash_value_configs["ecmp_hash_seed"] = "5";
+  EXPECT_THAT(
+      ProgramSwitchTable(switch_table, hash_value_configs, hash_field_configs),
+      StatusIs(absl::StatusCode::kInternal, HasSubstr("Test Failure")));
+}
+
 TEST(HashingTest, ProgramHashFieldTableReturnsErrorForBackendFailure) {
   FakeTable fake_table;
   HashTable hash_table = fake_table.GenerateHashTable();
@@ -0,0 +1,147 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/packet_in_rate_limiter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "gutil/status.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+absl::StatusOr<PacketInRateLimit> ParsePacketInRateLimit(
+    absl::string_view spec) {
+  std::vector<absl::string_view> parts = absl::StrSplit(spec, ':');
+  PacketInRateLimit limit;
+  if (parts.size() > 2 ||
+      !absl::SimpleAtod(parts[0], &limit.packets_per_second) ||
+      limit.packets_per_second <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Invalid PacketIn rate limit '" << spec
+           << "'. Expected <packets per second>[:<burst>].";
+  }
+  // Allow a second's worth of packets by default, and at least one packet.
+  limit.burst = std::max<int64_t>(1, limit.packets_per_second);
+  if (parts.size() == 2 &&
+      (!absl::SimpleAtoi(parts[1], &limit.burst) || limit.burst <= 0)) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Invalid burst in PacketIn rate limit '" << spec
+           << "'. Expected a positive number of packets.";
+  }
+  return limit;
+}
+
+}  // namespace
+
+absl::StatusOr<PacketInRateLimits> ParsePacketInRateLimits(
+    absl::string_view spec) {
+  PacketInRateLimits limits;
+  for (absl::string_view key_spec :
+       absl::StrSplit(spec, ';', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> parts =
+        absl::StrSplit(absl::StripAsciiWhitespace(key_spec),
+                       absl::MaxSplits('=', 1));
+    if (parts.size() != 2 || parts[0].empty()) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Invalid PacketIn rate limit '" << key_spec
+             << "'. Expected <total|per_port|port name>=<limit>.";
+    }
+    ASSIGN_OR_RETURN(PacketInRateLimit limit, ParsePacketInRateLimit(parts[1]));
+    if (parts[0] == "total") {
+      limits.total = limit;
+    } else if (parts[0] == "per_port") {
+      limits.per_port = limit;
+    } else {
+      limits.ports[std::string(parts[0])] = limit;
+    }
+  }
+  return limits;
+}
+
+PacketInRateLimiter::TokenBucket::TokenBucket(const PacketInRateLimit& limit)
+    : limit_(limit), tokens_(limit.burst) {}
+
+void PacketInRateLimiter::TokenBucket::Refill(absl::Time now) {
+  if (last_refill_ != absl::InfinitePast() && now > last_refill_) {
+    tokens_ = std::min<double>(
+        limit_.burst, tokens_ + absl::ToDoubleSeconds(now - last_refill_) *
+                                    limit_.packets_per_second);
+  }
+  last_refill_ = std::max(last_refill_, now);
+}
+
+PacketInRateLimiter::PacketInRateLimiter(PacketInRateLimits limits)
+    : limits_(std::move(limits)) {
+  if (limits_.total.has_value()) total_bucket_.emplace(*limits_.total);
+}
+
+std::optional<PacketInRateLimit> PacketInRateLimiter::PortLimit(
+    absl::string_view port_name) const {
+  if (auto it = limits_.ports.find(port_name); it != limits_.ports.end()) {
+    return it->second;
+  }
+  return limits_.per_port;
+}
+
+bool PacketInRateLimiter::Admit(absl::string_view port_name, absl::Time now) {
+  absl::MutexLock l(&lock_);
+  auto it = ports_.find(port_name);
+  if (it == ports_.end()) {
+    it = ports_.try_emplace(std::string(port_name)).first;
+    if (std::optional<PacketInRateLimit> limit = PortLimit(port_name);
+        limit.has_value()) {
+      it->second.bucket.emplace(*limit);
+    }
+  }
+  PortState& port = it->second;
+
+  // Only take tokens once the packet is known to be within both limits, so a
+  // flood on one port does not use up the total for the others.
+  if (port.bucket.has_value()) port.bucket->Refill(now);
+  if (total_bucket_.has_value()) total_bucket_->Refill(now);
+  if ((port.bucket.has_value() && !port.bucket->HasToken()) ||
+      (total_bucket_.has_value() && !total_bucket_->HasToken())) {
+    ++port.drops;
+    ++total_drops_;
+    return false;
+  }
+  if (port.bucket.has_value()) port.bucket->TakeToken();
+  if (total_bucket_.has_value()) total_bucket_->TakeToken();
+  return true;
+}
+
+PacketInRateLimiter::Drops PacketInRateLimiter::GetDrops() const {
+  absl::MutexLock l(&lock_);
+  Drops drops{.total = total_drops_};
+  for (const auto& [port_name, port] : ports_) {
+    if (port.drops > 0) drops.by_port[port_name] = port.drops;
+  }
+  return drops;
+}
+
+}  // namespace sonic
+}  // namespace p4rt_app
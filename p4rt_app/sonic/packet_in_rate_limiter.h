@@ -0,0 +1,119 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_SONIC_PACKET_IN_RATE_LIMITER_H_
+#define PINS_P4RT_APP_SONIC_PACKET_IN_RATE_LIMITER_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace p4rt_app {
+namespace sonic {
+
+struct PacketInRateLimit {
+  // Sustained rate, in packets per second.
+  double packets_per_second = 0;
+  // Packets that can be received back to back after a quiet period.
+  int64_t burst = 0;
+};
+
+struct PacketInRateLimits {
+  // Limits the PacketIns from all ports together.
+  std::optional<PacketInRateLimit> total;
+  // Limits the PacketIns from every port that is not listed in `ports`.
+  std::optional<PacketInRateLimit> per_port;
+  // Limits the PacketIns from a given port.
+  absl::flat_hash_map<std::string, PacketInRateLimit> ports;
+
+  bool empty() const {
+    return !total.has_value() && !per_port.has_value() && ports.empty();
+  }
+};
+
+// Parses a semicolon separated list of "<key>=<rate>[:<burst>]", where <key>
+// is "total", "per_port", or a port name, <rate> is in packets per second,
+// and <burst> defaults to a second's worth of packets. For example:
+//   "total=5000:1000;per_port=1000;Ethernet1/1/1=50:10"
+absl::StatusOr<PacketInRateLimits> ParsePacketInRateLimits(
+    absl::string_view spec);
+
+// Token buckets for the PacketIns from each port, and from all of them
+// together. Used by the receive paths to drop packets during punt storms
+// before they are queued or turned into PacketIn messages, so a flood on one
+// port does not crowd out the others on the controller stream.
+//
+// Thread-safe.
+class PacketInRateLimiter {
+ public:
+  struct Drops {
+    int64_t total = 0;
+    absl::btree_map<std::string, int64_t> by_port;
+  };
+
+  explicit PacketInRateLimiter(PacketInRateLimits limits);
+
+  // Returns true if a packet received on `port_name` at `now` is within every
+  // limit that applies to it, and takes a token from each. Otherwise counts
+  // it as dropped.
+  bool Admit(absl::string_view port_name, absl::Time now)
+      ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Returns the packets dropped since construction.
+  Drops GetDrops() const ABSL_LOCKS_EXCLUDED(lock_);
+
+ private:
+  class TokenBucket {
+   public:
+    explicit TokenBucket(const PacketInRateLimit& limit);
+
+    // Adds the tokens accumulated since the last refill, up to the burst.
+    void Refill(absl::Time now);
+    bool HasToken() const { return tokens_ >= 1; }
+    void TakeToken() { tokens_ -= 1; }
+
+   private:
+    PacketInRateLimit limit_;
+    double tokens_;
+    absl::Time last_refill_ = absl::InfinitePast();
+  };
+
+  struct PortState {
+    std::optional<TokenBucket> bucket;
+    int64_t drops = 0;
+  };
+
+  // Returns the limit for `port_name`, if any.
+  std::optional<PacketInRateLimit> PortLimit(absl::string_view port_name) const;
+
+  const PacketInRateLimits limits_;
+
+  mutable absl::Mutex lock_;
+  std::optional<TokenBucket> total_bucket_ ABSL_GUARDED_BY(lock_);
+  int64_t total_drops_ ABSL_GUARDED_BY(lock_) = 0;
+  // Created on the first packet from every port.
+  absl::flat_hash_map<std::string, PortState> ports_ ABSL_GUARDED_BY(lock_);
+};
+
+}  // namespace sonic
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_SONIC_PACKET_IN_RATE_LIMITER_H_
@@ -0,0 +1,133 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/packet_in_rate_limiter.h"
+
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+
+// Admits packets from `port_name` at `now` until one is dropped. Returns the
+// number admitted.
+int AdmitUntilDropped(PacketInRateLimiter& limiter,
+                      absl::string_view port_name, absl::Time now) {
+  int admitted = 0;
+  while (limiter.Admit(port_name, now) && admitted < 1000) ++admitted;
+  return admitted;
+}
+
+TEST(PacketInRateLimitsTest, ParsesEveryKey) {
+  ASSERT_OK_AND_ASSIGN(
+      PacketInRateLimits limits,
+      ParsePacketInRateLimits(
+          "total=5000:1000; per_port=100;Ethernet1/1/1=2.5:10"));
+  ASSERT_TRUE(limits.total.has_value());
+  EXPECT_EQ(limits.total->packets_per_second, 5000);
+  EXPECT_EQ(limits.total->burst, 1000);
+  ASSERT_TRUE(limits.per_port.has_value());
+  EXPECT_EQ(limits.per_port->packets_per_second, 100);
+  EXPECT_EQ(limits.per_port->burst, 100);
+  ASSERT_TRUE(limits.ports.contains("Ethernet1/1/1"));
+  EXPECT_EQ(limits.ports["Ethernet1/1/1"].packets_per_second, 2.5);
+  EXPECT_EQ(limits.ports["Ethernet1/1/1"].burst, 10);
+}
+
+TEST(PacketInRateLimitsTest, EmptySpecHasNoLimits) {
+  ASSERT_OK_AND_ASSIGN(PacketInRateLimits limits, ParsePacketInRateLimits(""));
+  EXPECT_TRUE(limits.empty());
+}
+
+TEST(PacketInRateLimitsTest, RejectsInvalidLimits) {
+  EXPECT_THAT(ParsePacketInRateLimits("total"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParsePacketInRateLimits("total=fast"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParsePacketInRateLimits("total=0"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParsePacketInRateLimits("total=10:0"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParsePacketInRateLimits("=10"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PacketInRateLimiterTest, AdmitsEverythingWithoutLimits) {
+  PacketInRateLimiter limiter({});
+  const absl::Time now = absl::UnixEpoch();
+  for (int i = 0; i < 100; ++i) EXPECT_TRUE(limiter.Admit("Ethernet0", now));
+  EXPECT_EQ(limiter.GetDrops().total, 0);
+  EXPECT_THAT(limiter.GetDrops().by_port, IsEmpty());
+}
+
+TEST(PacketInRateLimiterTest, RefillsAtTheConfiguredRate) {
+  PacketInRateLimiter limiter(
+      {.per_port = PacketInRateLimit{.packets_per_second = 10, .burst = 5}});
+  const absl::Time start = absl::UnixEpoch();
+  EXPECT_EQ(AdmitUntilDropped(limiter, "Ethernet0", start), 5);
+
+  // 10 packets per second refills a token every 100ms, up to the burst.
+  EXPECT_EQ(AdmitUntilDropped(limiter, "Ethernet0",
+                              start + absl::Milliseconds(300)),
+            3);
+  EXPECT_EQ(AdmitUntilDropped(limiter, "Ethernet0", start + absl::Seconds(10)),
+            5);
+  EXPECT_EQ(limiter.GetDrops().total, 3);
+}
+
+TEST(PacketInRateLimiterTest, LimitsEachPortSeparately) {
+  PacketInRateLimits limits{
+      .per_port = PacketInRateLimit{.packets_per_second = 1, .burst = 2}};
+  limits.ports["Ethernet8"] = {.packets_per_second = 1, .burst = 4};
+  PacketInRateLimiter limiter(std::move(limits));
+  const absl::Time now = absl::UnixEpoch();
+
+  // A flood on one port does not affect the others.
+  EXPECT_EQ(AdmitUntilDropped(limiter, "Ethernet0", now), 2);
+  EXPECT_FALSE(limiter.Admit("Ethernet0", now));
+  EXPECT_EQ(AdmitUntilDropped(limiter, "Ethernet4", now), 2);
+  EXPECT_EQ(AdmitUntilDropped(limiter, "Ethernet8", now), 4);
+
+  EXPECT_THAT(limiter.GetDrops().by_port,
+              ElementsAre(Pair("Ethernet0", 2), Pair("Ethernet4", 1),
+                          Pair("Ethernet8", 1)));
+}
+
+TEST(PacketInRateLimiterTest, DroppedPacketsDoNotUseTheTotal) {
+  PacketInRateLimiter limiter(
+      {.total = PacketInRateLimit{.packets_per_second = 1, .burst = 4},
+       .per_port = PacketInRateLimit{.packets_per_second = 1, .burst = 2}});
+  const absl::Time now = absl::UnixEpoch();
+
+  EXPECT_EQ(AdmitUntilDropped(limiter, "Ethernet0", now), 2);
+  EXPECT_EQ(AdmitUntilDropped(limiter, "Ethernet4", now), 2);
+  // The total is used up, even though this port still has tokens.
+  EXPECT_FALSE(limiter.Admit("Ethernet8", now));
+  EXPECT_EQ(limiter.GetDrops().total, 3);
+}
+
+}  // namespace
+}  // namespace sonic
+}  // namespace p4rt_app
@@ -21,8 +21,9 @@
 #include <utility>
 #include <vector>
 
-#include "absl/container/btree_map.h"
+#include "absl/algorithm/container.h"
 #include "absl/container/btree_set.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/numbers.h"
@@ -34,6 +35,7 @@
 #include "p4_pdpi/ir.pb.h"
 #include "p4rt_app/sonic/app_db_to_pdpi_ir_translator.h"
 #include "p4rt_app/sonic/redis_connections.h"
+#include "p4rt_app/sonic/replica_serializations.h"
 #include "swss/json.h"
 #include "swss/schema.h"
 #include "swss/table.h"
@@ -66,23 +68,16 @@ std::string GetRedisPacketReplicationTableKey(
 
 std::string CreateEntryForInsert(
     const pdpi::IrPacketReplicationEngineEntry& entry,
+    ReplicaSerializations& replica_serializations,
     std::vector<swss::KeyOpFieldsValuesTuple>& p4rt_inserts) {
   std::string key = GetRedisPacketReplicationTableKey(entry);
 
   swss::KeyOpFieldsValuesTuple key_value;
   kfvKey(key_value) = key;
   kfvOp(key_value) = "SET";
-
-  nlohmann::json json_array = nlohmann::json::array();
-  for (auto& replica : entry.multicast_group_entry().replicas()) {
-    nlohmann::json json;
-    json["multicast_replica_port"] = replica.port();
-    json["multicast_replica_instance"] =
-        absl::StrCat("0x", absl::Hex(replica.instance(), absl::kZeroPad4));
-    json_array.push_back(json);
-  }
-  kfvFieldsValues(key_value).push_back(
-      std::make_pair("replicas", json_array.dump()));
+  kfvFieldsValues(key_value).push_back(std::make_pair(
+      "replicas",
+      replica_serializations.Serialize(entry.multicast_group_entry())));
 
   p4rt_inserts.push_back(std::move(key_value));
   return key;
@@ -90,8 +85,11 @@ std::string CreateEntryForInsert(
 
 std::string CreateEntryForDelete(
     const pdpi::IrPacketReplicationEngineEntry& entry,
+    ReplicaSerializations& replica_serializations,
     std::vector<swss::KeyOpFieldsValuesTuple>& p4rt_deletes) {
   std::string key = GetRedisPacketReplicationTableKey(entry);
+  replica_serializations.Erase(
+      entry.multicast_group_entry().multicast_group_id());
 
   swss::KeyOpFieldsValuesTuple key_value;
   kfvKey(key_value) = key;
@@ -149,6 +147,122 @@ void ComparePacketReplicationEntities(const pdpi::IrEntity& entity_app_db,
   }
 }
 
+// Packet replication entries are read from the App DB in chunks of this many
+// keys, each with one pipelined request.
+constexpr int kAppDbReadChunkSize = 1024;
+
+absl::StatusOr<uint32_t> MulticastGroupIdFromAppDbKey(
+    absl::string_view app_db_key) {
+  ASSIGN_OR_RETURN(std::string multicast_group_id,
+                   StripTableName(app_db_key));
+  uint32_t group_id;
+  if (!absl::SimpleHexAtoi(multicast_group_id, &group_id)) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Failed to parse multicast_group_id from App DB packet "
+           << "replication entry key '" << app_db_key;
+  }
+  return group_id;
+}
+
+// Adds the replicas of an App DB entry's `values` to `multicast_group_entry`.
+absl::Status AppendReplicas(
+    const std::vector<std::pair<std::string, std::string>>& values,
+    pdpi::IrMulticastGroupEntry& multicast_group_entry) {
+  const uint32_t group_id = multicast_group_entry.multicast_group_id();
+  for (const auto& [field, data] : values) {
+    if (field != "replicas") continue;
+    nlohmann::json json;
+#ifdef __EXCEPTIONS
+    try {
+#endif
+      json = nlohmann::json::parse(data);
+#ifdef __EXCEPTIONS
+    } catch (...) {
+      return gutil::InternalErrorBuilder()
+             << "Could not parse JSON string: " << data;
+    }
+#endif
+
+    for (const auto& json_replica : json) {
+      std::string port_name;
+      uint32_t instance;
+      if (json_replica.find("multicast_replica_port") != json_replica.end()) {
+        port_name =
+            json_replica.at("multicast_replica_port").get<std::string>();
+      } else {
+        return gutil::InvalidArgumentErrorBuilder()
+               << "JSON replica for multicast group ID "
+               << absl::StrCat("0x", absl::Hex(group_id))
+               << " is missing multicast_replica_port: " << json_replica;
+      }
+      if (json_replica.find("multicast_replica_instance") !=
+          json_replica.end()) {
+        std::string inst =
+            json_replica.at("multicast_replica_instance").get<std::string>();
+        if (!absl::SimpleHexAtoi(inst, &instance)) {
+          return gutil::InvalidArgumentErrorBuilder()
+                 << "Failed to parse multicast_replica_instance in "
+                 << "multicast group ID "
+                 << absl::StrCat("0x", absl::Hex(group_id))
+                 << " from JSON replica " << json_replica;
+        }
+      } else {
+        return gutil::InvalidArgumentErrorBuilder()
+               << "JSON replica for multicast group ID "
+               << absl::StrCat("0x", absl::Hex(group_id))
+               << " is missing multicast_replica_instance: " << json_replica;
+      }
+      auto* replica = multicast_group_entry.add_replicas();
+      replica->set_port(port_name);
+      replica->set_instance(instance);
+    }
+  }
+  return absl::OkStatus();
+}
+
+// A view of a multicast group entity, with its replicas in canonical (sorted,
+// deduplicated) form so that equal replica sets compare equal without
+// building any strings.
+struct GroupView {
+  uint32_t id;
+  const pdpi::IrEntity* entity;
+  std::vector<std::pair<absl::string_view, uint32_t>> replicas;
+};
+
+// Returns a view of every entity, sorted by multicast group ID. If a group ID
+// appears more than once, the last entity wins.
+std::vector<GroupView> SortedGroupViews(
+    const std::vector<pdpi::IrEntity>& entities) {
+  std::vector<GroupView> groups;
+  groups.reserve(entities.size());
+  for (const pdpi::IrEntity& entity : entities) {
+    const auto& group_entry =
+        entity.packet_replication_engine_entry().multicast_group_entry();
+    GroupView& group = groups.emplace_back();
+    group.id = group_entry.multicast_group_id();
+    group.entity = &entity;
+    group.replicas.reserve(group_entry.replicas_size());
+    for (const auto& replica : group_entry.replicas()) {
+      group.replicas.push_back({replica.port(), replica.instance()});
+    }
+    absl::c_sort(group.replicas);
+    group.replicas.erase(
+        std::unique(group.replicas.begin(), group.replicas.end()),
+        group.replicas.end());
+  }
+  // Stable, so that the last of several entities with the same ID comes last.
+  absl::c_stable_sort(groups, [](const GroupView& a, const GroupView& b) {
+    return a.id < b.id;
+  });
+  std::vector<GroupView> unique_groups;
+  unique_groups.reserve(groups.size());
+  for (int i = 0; i < groups.size(); ++i) {
+    if (i + 1 < groups.size() && groups[i + 1].id == groups[i].id) continue;
+    unique_groups.push_back(std::move(groups[i]));
+  }
+  return unique_groups;
+}
+
 }  // namespace
 
 absl::StatusOr<std::string> CreatePacketReplicationTableUpdateForAppDb(
@@ -163,10 +277,12 @@ absl::StatusOr<std::string> CreatePacketReplicationTableUpdateForAppDb(
     case p4::v1::Update::MODIFY:
       // Modify looks exactly the same as insert.
       // The Orchagent layer resolves differences.
-      update_key = CreateEntryForInsert(entry, kfv_updates);
+      update_key = CreateEntryForInsert(
+          entry, *p4rt_table.replica_serializations, kfv_updates);
       break;
     case p4::v1::Update::DELETE:
-      update_key = CreateEntryForDelete(entry, kfv_updates);
+      update_key = CreateEntryForDelete(
+          entry, *p4rt_table.replica_serializations, kfv_updates);
       break;
     default:
       return gutil::InvalidArgumentErrorBuilder()
@@ -189,80 +305,44 @@ std::vector<std::string> GetAllPacketReplicationTableEntryKeys(
 
 absl::StatusOr<std::vector<pdpi::IrPacketReplicationEngineEntry>>
 GetAllAppDbPacketReplicationTableEntries(P4rtTable& p4rt_table) {
-  std::vector<pdpi::IrPacketReplicationEngineEntry> pre_entries;
-
   // Each key corresponds to a single multicast group, with all its replicas.
-  auto keys = GetAllPacketReplicationTableEntryKeys(p4rt_table);
-  for (const std::string& key : keys) {
-    VLOG(1) << "Read packet replication engine entry " << key << " from App DB";
-    ASSIGN_OR_RETURN(std::string multicast_group_id, StripTableName(key));
-
-    pdpi::IrPacketReplicationEngineEntry pre_entry;
-    auto* multicast_group_entry = pre_entry.mutable_multicast_group_entry();
-
-    // Multicast Group ID.
-    uint32_t group_id;
-    if (absl::SimpleHexAtoi(multicast_group_id, &group_id)) {
-      multicast_group_entry->set_multicast_group_id(group_id);
-    } else {
-      return gutil::InvalidArgumentErrorBuilder()
-             << "Failed to parse multicast_group_id from App DB packet "
-             << "replication entry key '" << key;
-    }
-
-    // Build replicas.
-    for (const auto& [field, data] : p4rt_table.app_db->get(key)) {
-      if (field == "replicas") {
-        nlohmann::json json;
-#ifdef __EXCEPTIONS
-        try {
-#endif
-          json = nlohmann::json::parse(data);
-#ifdef __EXCEPTIONS
-        } catch (...) {
-          return gutil::InternalErrorBuilder()
-                 << "Could not parse JSON string: " << data;
-        }
-#endif
+  // Keys are read in multicast group ID order, so that callers can merge the
+  // result with other sorted entries.
+  std::vector<std::pair<uint32_t, std::string>> ids_and_keys;
+  for (std::string& key : GetAllPacketReplicationTableEntryKeys(p4rt_table)) {
+    ASSIGN_OR_RETURN(uint32_t group_id, MulticastGroupIdFromAppDbKey(key));
+    ids_and_keys.push_back({group_id, std::move(key)});
+  }
+  absl::c_sort(ids_and_keys);
 
-        for (const auto& json_replica : json) {
-          std::string port_name;
-          uint32_t instance;
-          if (json_replica.find("multicast_replica_port") !=
-              json_replica.end()) {
-            port_name =
-                json_replica.at("multicast_replica_port").get<std::string>();
-          } else {
-            return gutil::InvalidArgumentErrorBuilder()
-                   << "JSON replica for multicast group ID "
-                   << absl::StrCat("0x", absl::Hex(group_id))
-                   << " is missing multicast_replica_port: " << json_replica;
-          }
-          if (json_replica.find("multicast_replica_instance") !=
-              json_replica.end()) {
-            std::string inst = json_replica.at("multicast_replica_instance")
-                                   .get<std::string>();
-            if (!absl::SimpleHexAtoi(inst, &instance)) {
-              return gutil::InvalidArgumentErrorBuilder()
-                     << "Failed to parse multicast_replica_instance in "
-                     << "multicast group ID "
-                     << absl::StrCat("0x", absl::Hex(group_id))
-                     << " from JSON replica " << json_replica;
-            }
-          } else {
-            return gutil::InvalidArgumentErrorBuilder()
-                   << "JSON replica for multicast group ID "
-                   << absl::StrCat("0x", absl::Hex(group_id))
-                   << " is missing multicast_replica_instance: "
-                   << json_replica;
-          }
-          auto* replica = multicast_group_entry->add_replicas();
-          replica->set_port(port_name);
-          replica->set_instance(instance);
-        }
-      }
+  std::vector<pdpi::IrPacketReplicationEngineEntry> pre_entries;
+  pre_entries.reserve(ids_and_keys.size());
+  for (int chunk_start = 0; chunk_start < ids_and_keys.size();
+       chunk_start += kAppDbReadChunkSize) {
+    const int chunk_end = std::min<int>(chunk_start + kAppDbReadChunkSize,
+                                        ids_and_keys.size());
+    std::vector<std::string> keys;
+    keys.reserve(chunk_end - chunk_start);
+    for (int i = chunk_start; i < chunk_end; ++i) {
+      VLOG(1) << "Read packet replication engine entry "
+              << ids_and_keys[i].second << " from App DB";
+      keys.push_back(ids_and_keys[i].second);
+    }
+    std::vector<std::vector<std::pair<std::string, std::string>>> values =
+        p4rt_table.app_db->batch_get(keys);
+    if (values.size() != keys.size()) {
+      return gutil::InternalErrorBuilder()
+             << "App DB returned " << values.size() << " results for "
+             << keys.size() << " packet replication entries.";
+    }
+    for (int i = 0; i < keys.size(); ++i) {
+      pdpi::IrPacketReplicationEngineEntry& pre_entry =
+          pre_entries.emplace_back();
+      auto* multicast_group_entry = pre_entry.mutable_multicast_group_entry();
+      multicast_group_entry->set_multicast_group_id(
+          ids_and_keys[chunk_start + i].first);
+      RETURN_IF_ERROR(AppendReplicas(values[i], *multicast_group_entry));
     }
-    pre_entries.push_back(pre_entry);
   }
   return pre_entries;
 }
@@ -271,43 +351,39 @@ std::vector<std::string> ComparePacketReplicationTableEntries(
     const std::vector<pdpi::IrEntity>& entries_app_db,
     const std::vector<pdpi::IrEntity>& entries_cache) {
   std::vector<std::string> failures;
-
-  // Multicast group ID -> IrEntity.
-  absl::btree_map<uint32_t, pdpi::IrEntity> map_app_db;
-  absl::btree_map<uint32_t, pdpi::IrEntity> map_cache;
-
-  for (const auto& entry : entries_app_db) {
-    map_app_db[entry.packet_replication_engine_entry()
-                   .multicast_group_entry()
-                   .multicast_group_id()] = entry;
-  }
-
-  for (const auto& entry : entries_cache) {
-    map_cache[entry.packet_replication_engine_entry()
-                  .multicast_group_entry()
-                  .multicast_group_id()] = entry;
-  }
-
-  for (const auto& id_and_entry : map_app_db) {
-    if (map_cache.find(id_and_entry.first) == map_cache.end()) {
+  const std::vector<GroupView> groups_app_db = SortedGroupViews(entries_app_db);
+  const std::vector<GroupView> groups_cache = SortedGroupViews(entries_cache);
+
+  // Merge-join both sides by multicast group ID. Groups missing from the App DB
+  // are reported after all other failures.
+  std::vector<std::string> missing_from_app_db;
+  auto app_db = groups_app_db.begin();
+  auto cache = groups_cache.begin();
+  while (app_db != groups_app_db.end() || cache != groups_cache.end()) {
+    if (cache == groups_cache.end() ||
+        (app_db != groups_app_db.end() && app_db->id < cache->id)) {
       failures.push_back(
           absl::StrCat("Packet replication cache is missing multicast group ",
-                       "ID ", id_and_entry.first));
-      continue;
-    }
-    ComparePacketReplicationEntities(id_and_entry.second,
-                                     map_cache[id_and_entry.first], failures);
-  }
-
-  for (const auto& id_and_entry : map_cache) {
-    if (map_app_db.find(id_and_entry.first) == map_app_db.end()) {
-      failures.push_back(absl::StrCat("APP DB is missing multicast group ID ",
-                                      id_and_entry.first));
+                       "ID ", app_db->id));
+      ++app_db;
+    } else if (app_db == groups_app_db.end() || cache->id < app_db->id) {
+      missing_from_app_db.push_back(
+          absl::StrCat("APP DB is missing multicast group ID ", cache->id));
+      ++cache;
+    } else {
+      // Only diff the replicas field by field if they differ.
+      if (app_db->replicas != cache->replicas) {
+        ComparePacketReplicationEntities(*app_db->entity, *cache->entity,
+                                         failures);
+      }
+      ++app_db;
+      ++cache;
     }
-    // There's no need to compare entities here, since all overlapping entities
-    // were checked in the previous for loop.
   }
 
+  failures.insert(failures.end(),
+                  std::make_move_iterator(missing_from_app_db.begin()),
+                  std::make_move_iterator(missing_from_app_db.end()));
   return failures;
 }
 
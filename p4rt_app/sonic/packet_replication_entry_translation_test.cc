@@ -42,7 +42,7 @@ using ::gutil::EqualsProto;
 using ::gutil::IsOk;
 using ::gutil::IsOkAndHolds;
 using ::testing::ContainerEq;
-using ::testing::Eq;
+using ::testing::ElementsAre;
 using ::testing::IsEmpty;
 using ::testing::Not;
 using ::testing::Return;
@@ -228,13 +228,15 @@ TEST_F(PacketReplicationEntryTranslationTest,
 
   EXPECT_CALL(*mock_pre_app_db_, keys)
       .WillOnce(Return(std::vector<std::string>{app_db_key1, app_db_key2}));
-  EXPECT_CALL(*mock_pre_app_db_, get(Eq(app_db_key1)))
-      .WillOnce(Return(kfv_values1));
-  EXPECT_CALL(*mock_pre_app_db_, get(Eq(app_db_key2)))
-      .WillOnce(Return(kfv_values2));
+  EXPECT_CALL(*mock_pre_app_db_, batch_get(ElementsAre(app_db_key1,
+                                                      app_db_key2)))
+      .WillOnce(Return(
+          std::vector<std::vector<std::pair<std::string, std::string>>>{
+              kfv_values1, kfv_values2}));
 
+  // Entries are returned in multicast group ID order.
   EXPECT_THAT(GetAllAppDbPacketReplicationTableEntries(mock_p4rt_table_),
-              IsOkAndHolds(UnorderedElementsAre(
+              IsOkAndHolds(ElementsAre(
                   EqualsProto(R"pb(
                     multicast_group_entry {
                       multicast_group_id: 1
@@ -248,6 +250,40 @@ TEST_F(PacketReplicationEntryTranslationTest,
                     })pb"))));
 }
 
+TEST_F(PacketReplicationEntryTranslationTest,
+       GetAllAppDbPacketReplicationTableEntriesReadsInGroupIdOrder) {
+  const std::string app_db_key1 = "REPLICATION_IP_MULTICAST_TABLE:0x0010";
+  const std::string app_db_key2 = "REPLICATION_IP_MULTICAST_TABLE:0x0002";
+
+  EXPECT_CALL(*mock_pre_app_db_, keys)
+      .WillOnce(Return(std::vector<std::string>{app_db_key1, app_db_key2}));
+  EXPECT_CALL(*mock_pre_app_db_, batch_get(ElementsAre(app_db_key2,
+                                                      app_db_key1)))
+      .WillOnce(Return(
+          std::vector<std::vector<std::pair<std::string, std::string>>>(2)));
+
+  EXPECT_THAT(GetAllAppDbPacketReplicationTableEntries(mock_p4rt_table_),
+              IsOkAndHolds(ElementsAre(
+                  EqualsProto(R"pb(multicast_group_entry {
+                                     multicast_group_id: 2
+                                   })pb"),
+                  EqualsProto(R"pb(multicast_group_entry {
+                                     multicast_group_id: 16
+                                   })pb"))));
+}
+
+TEST_F(PacketReplicationEntryTranslationTest, MissingBatchResults) {
+  const std::string app_db_key1 = "REPLICATION_IP_MULTICAST_TABLE:0x0001";
+
+  EXPECT_CALL(*mock_pre_app_db_, keys)
+      .WillOnce(Return(std::vector<std::string>{app_db_key1}));
+  EXPECT_CALL(*mock_pre_app_db_, batch_get)
+      .WillOnce(Return(
+          std::vector<std::vector<std::pair<std::string, std::string>>>{}));
+
+  EXPECT_FALSE(GetAllAppDbPacketReplicationTableEntries(mock_p4rt_table_).ok());
+}
+
 TEST_F(PacketReplicationEntryTranslationTest, InvalidTableName) {
   const std::string bad_app_db_key =
       "FIXED_MULTICAST_ROUTER_INTERFACE_TABLE:0x1";
@@ -281,8 +317,10 @@ TEST_F(PacketReplicationEntryTranslationTest, InvalidInstance) {
 
   EXPECT_CALL(*mock_pre_app_db_, keys)
       .WillOnce(Return(std::vector<std::string>{app_db_key1}));
-  EXPECT_CALL(*mock_pre_app_db_, get(Eq(app_db_key1)))
-      .WillOnce(Return(kfv_values1));
+  EXPECT_CALL(*mock_pre_app_db_, batch_get(ElementsAre(app_db_key1)))
+      .WillOnce(Return(
+          std::vector<std::vector<std::pair<std::string, std::string>>>{
+              kfv_values1}));
 
   EXPECT_FALSE(GetAllAppDbPacketReplicationTableEntries(mock_p4rt_table_).ok());
 }
@@ -297,8 +335,10 @@ TEST_F(PacketReplicationEntryTranslationTest, MissingMulticastReplicaPort) {
 
   EXPECT_CALL(*mock_pre_app_db_, keys)
       .WillOnce(Return(std::vector<std::string>{app_db_key1}));
-  EXPECT_CALL(*mock_pre_app_db_, get(Eq(app_db_key1)))
-      .WillOnce(Return(kfv_values1));
+  EXPECT_CALL(*mock_pre_app_db_, batch_get(ElementsAre(app_db_key1)))
+      .WillOnce(Return(
+          std::vector<std::vector<std::pair<std::string, std::string>>>{
+              kfv_values1}));
 
   EXPECT_FALSE(GetAllAppDbPacketReplicationTableEntries(mock_p4rt_table_).ok());
 }
@@ -313,8 +353,10 @@ TEST_F(PacketReplicationEntryTranslationTest, MissingMulticastReplicaInstance) {
 
   EXPECT_CALL(*mock_pre_app_db_, keys)
       .WillOnce(Return(std::vector<std::string>{app_db_key1}));
-  EXPECT_CALL(*mock_pre_app_db_, get(Eq(app_db_key1)))
-      .WillOnce(Return(kfv_values1));
+  EXPECT_CALL(*mock_pre_app_db_, batch_get(ElementsAre(app_db_key1)))
+      .WillOnce(Return(
+          std::vector<std::vector<std::pair<std::string, std::string>>>{
+              kfv_values1}));
 
   EXPECT_FALSE(GetAllAppDbPacketReplicationTableEntries(mock_p4rt_table_).ok());
 }
@@ -439,6 +481,45 @@ TEST_F(PacketReplicationEntryTranslationTest, CompareEntriesDifferentReplica) {
             "APP DB is missing replica Ethernet0_1 for group id 1");
 }
 
+TEST_F(PacketReplicationEntryTranslationTest, CompareEntriesIgnoresOrder) {
+  pdpi::IrEntity entity1;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        packet_replication_engine_entry {
+          multicast_group_entry {
+            multicast_group_id: 1
+            replicas { port: "Ethernet0" instance: 0 }
+            replicas { port: "Ethernet1" instance: 0 }
+          }
+        })pb",
+      &entity1));
+  pdpi::IrEntity entity2;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        packet_replication_engine_entry {
+          multicast_group_entry {
+            multicast_group_id: 2
+            replicas { port: "Ethernet0" instance: 0 }
+          }
+        })pb",
+      &entity2));
+  pdpi::IrEntity entity1_reordered;
+  ASSERT_TRUE(TextFormat::ParseFromString(
+      R"pb(
+        packet_replication_engine_entry {
+          multicast_group_entry {
+            multicast_group_id: 1
+            replicas { port: "Ethernet1" instance: 0 }
+            replicas { port: "Ethernet0" instance: 0 }
+          }
+        })pb",
+      &entity1_reordered));
+
+  std::vector<pdpi::IrEntity> input1 = {entity1, entity2};
+  std::vector<pdpi::IrEntity> input2 = {entity2, entity1_reordered};
+  EXPECT_THAT(ComparePacketReplicationTableEntries(input1, input2), IsEmpty());
+}
+
 }  // namespace
 }  // namespace sonic
 }  // namespace p4rt_app
@@ -21,14 +21,45 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "glog/logging.h"
 #include "gutil/collections.h"
 #include "gutil/status.h"
+#include "p4rt_app/sonic/packet_in_rate_limiter.h"
+#include "p4rt_app/sonic/packetio_receiver.h"
 #include "p4rt_app/sonic/receive_genetlink.h"
 #include "swss/selectable.h"
 
 namespace p4rt_app {
 namespace sonic {
+namespace {
+
+// Drops the packets over the rate limits before `callback_function` turns
+// them into PacketIns.
+packet_metadata::ReceiveCallbackFunction RateLimitedCallback(
+    std::shared_ptr<PacketInRateLimiter> rate_limiter,
+    packet_metadata::ReceiveCallbackFunction callback_function) {
+  return [rate_limiter = std::move(rate_limiter),
+          callback_function = std::move(callback_function)](
+             absl::string_view source_port_name,
+             absl::string_view target_port_name, absl::string_view payload,
+             absl::Time receive_time) -> absl::Status {
+    if (!rate_limiter->Admit(source_port_name, absl::Now())) {
+      return absl::OkStatus();
+    }
+    return callback_function(source_port_name, target_port_name, payload,
+                             receive_time);
+  };
+}
+
+}  // namespace
+
+PacketIoImpl::~PacketIoImpl() {
+  // The dispatch thread holds its own reference to the receiver, and lets go
+  // of it once it returns.
+  if (receiver_ != nullptr) receiver_->Stop();
+}
 
 absl::Status PacketIoImpl::SendPacketOut(absl::string_view port_name,
                                          const std::string& packet) {
@@ -63,6 +94,13 @@ absl::Status PacketIoImpl::AddPacketIoPort(absl::string_view port_name) {
   // PacketInSelectables is needed only for Netdev receive model.
   if (use_genetlink_) return absl::OkStatus();
 
+  // With receive threads the port shares its socket with the receiver. Ports
+  // added before StartReceive are handed to the receiver when it is created.
+  if (receive_threads_ > 0) {
+    if (receiver_ == nullptr) return absl::OkStatus();
+    return receiver_->AddPort(port_name, port_params->socket);
+  }
+
   // Add the port object into the port select so that receive thread can start
   // monitoring for receive packets.
   port_select_.addSelectable(port_params->packet_in_selectable.get());
@@ -81,8 +119,11 @@ absl::Status PacketIoImpl::AddPacketIoPort(absl::string_view port_name) {
 absl::Status PacketIoImpl::RemovePacketIoPort(absl::string_view port_name) {
   LOG(INFO) << "Removing PacketIO port '" << port_name << "'.";
 
-  // Cleanup PacketInSelectable, if in Netdev mode.
-  if (!use_genetlink_) {
+  // Stop receiving before the socket is closed below.
+  if (!use_genetlink_ && receive_threads_ > 0) {
+    if (receiver_ != nullptr) RETURN_IF_ERROR(receiver_->RemovePort(port_name));
+  } else if (!use_genetlink_) {
+    // Cleanup PacketInSelectable, if in Netdev mode.
     auto it = port_to_selectables_.find(port_name);
     if (it == port_to_selectables_.end()) {
       return absl::InvalidArgumentError(absl::StrCat(
@@ -113,6 +154,21 @@ absl::Status PacketIoImpl::RemovePacketIoPort(absl::string_view port_name) {
   return absl::OkStatus();
 }
 
+PacketIoQueueStats PacketIoImpl::GetQueueStats() const {
+  PacketIoQueueStats stats;
+  if (receiver_ != nullptr) {
+    stats.queued_packet_ins = receiver_->QueuedPackets();
+    stats.dropped_packet_ins =
+        static_cast<int64_t>(receiver_->DroppedPackets());
+  }
+  if (rate_limiter_ != nullptr) {
+    PacketInRateLimiter::Drops drops = rate_limiter_->GetDrops();
+    stats.rate_limited_packet_ins = drops.total;
+    stats.rate_limited_packet_ins_by_port = std::move(drops.by_port);
+  }
+  return stats;
+}
+
 bool PacketIoImpl::IsValidPortForTransmit(absl::string_view port_name) const {
   return port_to_socket_.contains(port_name);
 }
@@ -122,6 +178,9 @@ bool PacketIoImpl::IsValidPortForReceive(absl::string_view port_name) const {
   if (callback_function_ == nullptr) return false;
 
   // For netdev model, additionally check that the receive socket exists.
+  if (!use_genetlink_ && receive_threads_ > 0) {
+    return receiver_ != nullptr && receiver_->HasPort(port_name);
+  }
   if (!use_genetlink_) {
     return port_to_selectables_.contains(port_name);
   }
@@ -137,11 +196,52 @@ absl::StatusOr<std::thread> PacketIoImpl::StartReceive(
   }
   callback_function_ = std::move(callback_function);
   use_genetlink_ = use_genetlink;
+  // The receiver checks the rate limits itself, before queueing a packet.
+  if (rate_limiter_ != nullptr && (use_genetlink_ || receive_threads_ == 0)) {
+    callback_function_ =
+        RateLimitedCallback(rate_limiter_, std::move(callback_function_));
+  }
 
   if (use_genetlink_) {
-    return packet_metadata::StartReceive(callback_function_);
+    ASSIGN_OR_RETURN(std::thread thread,
+                     packet_metadata::StartReceive(callback_function_));
+    // The genetlink thread is created elsewhere, so it can only be pinned.
+    if (absl::Status status = SetThreadCpuAffinity(thread.native_handle(),
+                                                   receive_placement_.cpus);
+        !status.ok()) {
+      LOG(WARNING) << "Could not place the genetlink receive thread: "
+                   << status;
+    }
+    return thread;
+  } else if (receive_threads_ > 0) {
+    if (receiver_ != nullptr) {
+      return gutil::FailedPreconditionErrorBuilder()
+             << "PacketIO receive threads have already been started.";
+    }
+    ASSIGN_OR_RETURN(
+        std::unique_ptr<PacketInReceiver> receiver,
+        PacketInReceiver::Create(receive_threads_, /*max_queued_packets=*/4096,
+                                 receive_placement_, rate_limiter_));
+    for (const auto& [port_name, socket] : port_to_socket_) {
+      RETURN_IF_ERROR(receiver->AddPort(port_name, socket));
+    }
+    receiver_ = std::move(receiver);
+    return std::thread([receiver = receiver_,
+                        callback_function = callback_function_,
+                        placement = receive_placement_] {
+      if (absl::Status status = ApplyThreadPlacement(placement); !status.ok()) {
+        LOG(WARNING) << "Could not place the Receive dispatch thread: "
+                     << status;
+      }
+      LOG(INFO) << "Successfully created Receive dispatch thread";
+      receiver->Dispatch(callback_function);
+    });
   } else {
     return std::thread([this] {
+      if (absl::Status status = ApplyThreadPlacement(receive_placement_);
+          !status.ok()) {
+        LOG(WARNING) << "Could not place the Receive thread: " << status;
+      }
       LOG(INFO) << "Successfully created Receive thread";
       while (true) {
         swss::Selectable* sel;
@@ -24,8 +24,11 @@
 #include "absl/strings/string_view.h"
 #include "glog/logging.h"
 #include "p4rt_app/sonic/adapters/system_call_adapter.h"
+#include "p4rt_app/sonic/packet_in_rate_limiter.h"
 #include "p4rt_app/sonic/packetio_interface.h"
 #include "p4rt_app/sonic/packetio_port.h"
+#include "p4rt_app/sonic/packetio_receiver.h"
+#include "p4rt_app/utils/thread_placement.h"
 #include "swss/selectable.h"
 
 namespace p4rt_app {
@@ -34,6 +37,16 @@ namespace sonic {
 struct PacketIoOptions {
   packet_metadata::ReceiveCallbackFunction callback_function = nullptr;
   bool use_genetlink = false;
+  // Number of threads receiving packets in the netdev model. When 0, a single
+  // thread reads every port and invokes the callback directly. Otherwise ports
+  // are sharded across a PacketInReceiver.
+  int receive_threads = 0;
+  // Where the receive threads run. In the genetlink model only the CPU
+  // affinity applies.
+  ThreadPlacement receive_placement;
+  // Received packets over these limits are dropped before they are queued,
+  // or handed to the callback.
+  PacketInRateLimits packet_in_rate_limits;
 };
 
 // Implementation class for PacketIoInterface.
@@ -43,7 +56,15 @@ class PacketIoImpl : public PacketIoInterface {
                         const PacketIoOptions& options)
       : system_call_adapter_(std::move(system_call_adapter)),
         callback_function_(options.callback_function),
-        use_genetlink_(options.use_genetlink) {}
+        use_genetlink_(options.use_genetlink),
+        receive_threads_(options.receive_threads),
+        receive_placement_(options.receive_placement),
+        rate_limiter_(options.packet_in_rate_limits.empty()
+                          ? nullptr
+                          : std::make_shared<PacketInRateLimiter>(
+                                options.packet_in_rate_limits)) {}
+
+  ~PacketIoImpl() override;
 
   // Not copyable or moveable.
   PacketIoImpl(const PacketIoImpl&) = delete;
@@ -65,6 +86,11 @@ class PacketIoImpl : public PacketIoInterface {
   absl::Status SendPacketOut(absl::string_view port_name,
                              const std::string& packet) override;
 
+  // Returns the depth of the PacketInReceiver queue, which is zero until
+  // StartReceive is called or when receive_threads is 0, and the packets
+  // dropped by the rate limits.
+  PacketIoQueueStats GetQueueStats() const override;
+
   // Checks if a transmit socket exists for the specified port.
   bool IsValidPortForTransmit(absl::string_view port_name) const;
 
@@ -90,6 +116,18 @@ class PacketIoImpl : public PacketIoInterface {
 
   // Stores the 'Select' object used in the receive thread.
   swss::Select port_select_;
+
+  // Used instead of the 'Select' object when receive_threads_ > 0. Created by
+  // StartReceive, and shared with the dispatch thread so it outlives it.
+  const int receive_threads_ = 0;
+  std::shared_ptr<PacketInReceiver> receiver_;
+
+  // Applied to every receive thread.
+  const ThreadPlacement receive_placement_;
+
+  // Null when there are no PacketIn rate limits. Shared with the receiver, or
+  // with the callback it wraps.
+  const std::shared_ptr<PacketInRateLimiter> rate_limiter_;
 };
 
 }  // namespace sonic
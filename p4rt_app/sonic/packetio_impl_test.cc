@@ -15,14 +15,20 @@
 
 #include <linux/if.h>
 #include <netpacket/packet.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 
 #include "absl/cleanup/cleanup.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "gutil/status_matchers.h"
@@ -38,9 +44,10 @@ using ::testing::Eq;
 using ::testing::Return;
 using ::testing::StrEq;
 
-absl::Status EmptyPacketInCallback(std::string source_port,
-                                   std::string tartget_port,
-                                   std::string payload) {
+absl::Status EmptyPacketInCallback(absl::string_view source_port,
+                                   absl::string_view tartget_port,
+                                   absl::string_view payload,
+                                   absl::Time receive_time) {
   return absl::OkStatus();
 }
 
@@ -276,6 +283,66 @@ TEST(PacketIoImplTest, AddAndRemovePacketIoPortWithGenetlink) {
   EXPECT_FALSE(packetio_impl.IsValidPortForTransmit(kSubmitToIngress));
 }
 
+TEST(PacketIoImplTest, ReceivesOnReceiveThreads) {
+  auto mock_call_adapter = absl::make_unique<sonic::MockSystemCallAdapter>();
+
+  // The receive threads read whole packets, so use datagram sockets instead of
+  // pipes.
+  int port0[2], port1[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, port0), 0);
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_DGRAM, 0, port1), 0);
+  absl::Cleanup close_sockets = [&] {
+    for (int fd : {port0[0], port0[1], port1[0], port1[1]}) close(fd);
+  };
+
+  EXPECT_CALL(*mock_call_adapter, socket)
+      .WillOnce(Return(port0[0]))
+      .WillOnce(Return(port1[0]));
+  EXPECT_CALL(*mock_call_adapter, setsockopt).WillRepeatedly(Return(0));
+  EXPECT_CALL(*mock_call_adapter, if_nametoindex).WillRepeatedly(Return(1));
+  EXPECT_CALL(*mock_call_adapter, bind).WillRepeatedly(Return(0));
+  EXPECT_CALL(*mock_call_adapter, close).Times(2).WillRepeatedly(Return(0));
+
+  auto packetio_impl = std::make_unique<PacketIoImpl>(
+      std::move(mock_call_adapter), PacketIoOptions{.receive_threads = 2});
+
+  // Ports added before the receiver starts are picked up when it does.
+  ASSERT_OK(packetio_impl->AddPacketIoPort("Ethernet1/1"));
+  EXPECT_FALSE(packetio_impl->IsValidPortForReceive("Ethernet1/1"));
+
+  absl::Notification received;
+  std::string received_port;
+  std::string received_payload;
+  ASSERT_OK_AND_ASSIGN(
+      std::thread receive_thread,
+      packetio_impl->StartReceive(
+          [&](absl::string_view source_port, absl::string_view target_port,
+              absl::string_view payload, absl::Time receive_time) {
+            received_port = std::string(source_port);
+            received_payload = std::string(payload);
+            received.Notify();
+            return absl::OkStatus();
+          },
+          /*use_genetlink=*/false));
+  ASSERT_OK(packetio_impl->AddPacketIoPort("Ethernet1/2"));
+  EXPECT_TRUE(packetio_impl->IsValidPortForReceive("Ethernet1/1"));
+  EXPECT_TRUE(packetio_impl->IsValidPortForReceive("Ethernet1/2"));
+
+  ASSERT_EQ(write(port1[1], "packet", 6), 6);
+  ASSERT_TRUE(received.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  EXPECT_EQ(received_port, "Ethernet1/2");
+  EXPECT_EQ(received_payload, "packet");
+
+  ASSERT_OK(packetio_impl->RemovePacketIoPort("Ethernet1/1"));
+  ASSERT_OK(packetio_impl->RemovePacketIoPort("Ethernet1/2"));
+  EXPECT_FALSE(packetio_impl->IsValidPortForReceive("Ethernet1/1"));
+  EXPECT_FALSE(packetio_impl->IsValidPortForReceive("Ethernet1/2"));
+
+  // Destroying PacketIoImpl stops the receive thread.
+  packetio_impl.reset();
+  receive_thread.join();
+}
+
 }  // namespace
 }  // namespace sonic
 }  // namespace p4rt_app
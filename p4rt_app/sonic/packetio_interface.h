@@ -14,10 +14,12 @@
 #ifndef PINS_P4RT_APP_SONIC_PACKETIO_INTERFACE_H_
 #define PINS_P4RT_APP_SONIC_PACKETIO_INTERFACE_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <thread>  //NOLINT
 
+#include "absl/container/btree_map.h"
 #include "absl/status/status.h"
 #include "p4rt_app/sonic/receive_genetlink.h"
 
@@ -38,6 +40,20 @@ struct PacketIoCounters {
   int packet_in_errors = 0;
 };
 
+// The PacketIn receive queue, and the packets dropped before reaching it.
+struct PacketIoQueueStats {
+  // Packets received, but not yet handed to the receive callback.
+  int64_t queued_packet_ins = 0;
+
+  // Packets dropped because the receive callback fell behind.
+  int64_t dropped_packet_ins = 0;
+
+  // Packets dropped for being over a PacketIn rate limit, in total and for
+  // every port that dropped any.
+  int64_t rate_limited_packet_ins = 0;
+  absl::btree_map<std::string, int64_t> rate_limited_packet_ins_by_port;
+};
+
 // Base class for PacketIoInterface.
 class PacketIoInterface {
  public:
@@ -52,6 +68,8 @@ class PacketIoInterface {
   // Send the given packet out on the specified interface.
   virtual absl::Status SendPacketOut(absl::string_view port_name,
                                      const std::string& packet) = 0;
+  // Returns the current state of the PacketIn receive queue, if any.
+  virtual PacketIoQueueStats GetQueueStats() const { return {}; }
 };
 
 }  // namespace sonic
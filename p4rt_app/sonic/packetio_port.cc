@@ -20,6 +20,7 @@
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <iomanip>
@@ -34,6 +35,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/types/span.h"
 #include "gutil/collections.h"
 #include "gutil/status.h"
 #include "p4rt_app/sonic/adapters/system_call_adapter.h"
@@ -111,29 +113,11 @@ absl::StatusOr<int> CreatePacketIoSocket(
   return port_socket;
 }
 
-}  // namespace
-
-absl::StatusOr<std::unique_ptr<PacketIoPortParams>> AddPacketIoPort(
-    const SystemCallAdapter &system_call_adapter, absl::string_view port_name,
-    packet_metadata::ReceiveCallbackFunction callback_function) {
-  ASSIGN_OR_RETURN(int port_socket,
-                   CreatePacketIoSocket(system_call_adapter, port_name));
-  auto in_selectable = absl::make_unique<PacketInSelectable>(
-      port_name, port_socket, callback_function);
-
-  return absl::make_unique<PacketIoPortParams>(PacketIoPortParams{
-      .socket = port_socket,
-      .packet_in_selectable = std::move(in_selectable),
-  });
-}
-
-absl::Status SendPacketOut(const SystemCallAdapter &system_call_adapter,
-                           int transmit_socket,
-                           absl::string_view interface_name,
-                           const std::string &packet) {
-  int msg_len = packet.length();
-  const char *ptr = packet.data();
-
+// Checks that the link is up, and clears any pending socket error, before
+// packets are written to `transmit_socket`.
+absl::Status PrepareToTransmit(const SystemCallAdapter &system_call_adapter,
+                               int transmit_socket,
+                               absl::string_view interface_name) {
   struct ifreq if_req;
   memset(&if_req, 0, sizeof(if_req));
   strncpy(if_req.ifr_name, std::string(interface_name).c_str(),
@@ -161,6 +145,34 @@ absl::Status SendPacketOut(const SystemCallAdapter &system_call_adapter,
                  << " returned pending errno " << optval;
   }
 
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<PacketIoPortParams>> AddPacketIoPort(
+    const SystemCallAdapter &system_call_adapter, absl::string_view port_name,
+    packet_metadata::ReceiveCallbackFunction callback_function) {
+  ASSIGN_OR_RETURN(int port_socket,
+                   CreatePacketIoSocket(system_call_adapter, port_name));
+  auto in_selectable = absl::make_unique<PacketInSelectable>(
+      port_name, port_socket, callback_function);
+
+  return absl::make_unique<PacketIoPortParams>(PacketIoPortParams{
+      .socket = port_socket,
+      .packet_in_selectable = std::move(in_selectable),
+  });
+}
+
+absl::Status SendPacketOut(const SystemCallAdapter &system_call_adapter,
+                           int transmit_socket,
+                           absl::string_view interface_name,
+                           const std::string &packet) {
+  int msg_len = packet.length();
+  const char *ptr = packet.data();
+  RETURN_IF_ERROR(
+      PrepareToTransmit(system_call_adapter, transmit_socket, interface_name));
+
   do {
     int res = system_call_adapter.write(transmit_socket, ptr, msg_len);
     if (res < 0) {
@@ -179,5 +191,39 @@ absl::Status SendPacketOut(const SystemCallAdapter &system_call_adapter,
   return absl::OkStatus();
 }
 
+absl::Status SendPacketOuts(const SystemCallAdapter &system_call_adapter,
+                            int transmit_socket,
+                            absl::string_view interface_name,
+                            absl::Span<const std::string> packets) {
+  if (packets.empty()) return absl::OkStatus();
+  RETURN_IF_ERROR(
+      PrepareToTransmit(system_call_adapter, transmit_socket, interface_name));
+
+  std::vector<struct iovec> iovecs(packets.size());
+  std::vector<struct mmsghdr> messages(packets.size());
+  for (size_t i = 0; i < packets.size(); ++i) {
+    iovecs[i].iov_base = const_cast<char *>(packets[i].data());
+    iovecs[i].iov_len = packets[i].size();
+    memset(&messages[i], 0, sizeof(messages[i]));
+    messages[i].msg_hdr.msg_iov = &iovecs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  // sendmmsg can stop early, so keep going until every packet is sent.
+  size_t sent = 0;
+  while (sent < packets.size()) {
+    int res = system_call_adapter.sendmmsg(
+        transmit_socket, &messages[sent], packets.size() - sent, /*flags=*/0);
+    if (res < 0) {
+      if (errno == EINTR) continue;
+      return gutil::InternalErrorBuilder()
+             << "Failed to send packet " << sent << " of " << packets.size()
+             << " out of " << interface_name << ", errno " << errno;
+    }
+    sent += res;
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace sonic
 }  // namespace p4rt_app
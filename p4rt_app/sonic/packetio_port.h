@@ -21,6 +21,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "glog/logging.h"
 #include "p4_pdpi/utils/ir.h"
 #include "p4rt_app/sonic/adapters/system_call_adapter.h"
@@ -49,6 +50,15 @@ absl::Status SendPacketOut(const SystemCallAdapter& system_call_adapter,
                            absl::string_view interface_name,
                            const std::string& packet);
 
+// Sends a batch of packets out on the specified egress socket. The link and
+// socket are checked once for the whole batch, and the packets are written
+// with as few system calls as possible. Packets are sent in order, and on
+// failure none of the packets after the failing one are sent.
+absl::Status SendPacketOuts(const SystemCallAdapter& system_call_adapter,
+                            int transmit_socket,
+                            absl::string_view interface_name,
+                            absl::Span<const std::string> packets);
+
 }  // namespace sonic
 }  // namespace p4rt_app
 
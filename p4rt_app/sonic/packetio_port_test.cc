@@ -15,6 +15,8 @@
 
 #include <cstddef>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "glog/logging.h"
 #include "gmock/gmock.h"
@@ -176,6 +178,80 @@ TEST(PacketIoTest, SendPacketOutSplitWrite) {
                           std::string(kTestPacket, sizeof(kTestPacket))));
 }
 
+TEST(PacketIoTest, SendPacketOutsChecksTheLinkOnceForTheBatch) {
+  MockSystemCallAdapter mock_call_adapter;
+  struct ifreq if_resp { /*ifr_name=*/
+    {""}, /*ifr_flags=*/{
+      { IFF_UP | IFF_RUNNING }
+    }
+  };
+  EXPECT_CALL(mock_call_adapter, ioctl)
+      .WillOnce(DoAll(SetArgPointee<2>(if_resp), Return(0)));
+  EXPECT_CALL(mock_call_adapter, getsockopt).WillOnce(Return(0));
+  EXPECT_CALL(mock_call_adapter, sendmmsg(_, _, 3, _)).WillOnce(Return(3));
+  EXPECT_CALL(mock_call_adapter, write).Times(0);
+
+  const std::vector<std::string> packets(
+      3, std::string(kTestPacket, sizeof(kTestPacket)));
+  EXPECT_OK(SendPacketOuts(mock_call_adapter, /*transmit_socket=*/1,
+                           kEthernet0, packets));
+}
+
+TEST(PacketIoTest, SendPacketOutsContinuesAfterAPartialBatch) {
+  MockSystemCallAdapter mock_call_adapter;
+  struct ifreq if_resp { /*ifr_name=*/
+    {""}, /*ifr_flags=*/{
+      { IFF_UP | IFF_RUNNING }
+    }
+  };
+  EXPECT_CALL(mock_call_adapter, ioctl)
+      .WillOnce(DoAll(SetArgPointee<2>(if_resp), Return(0)));
+  EXPECT_CALL(mock_call_adapter, sendmmsg(_, _, 3, _)).WillOnce(Return(2));
+  EXPECT_CALL(mock_call_adapter, sendmmsg(_, _, 1, _)).WillOnce(Return(1));
+
+  const std::vector<std::string> packets(
+      3, std::string(kTestPacket, sizeof(kTestPacket)));
+  EXPECT_OK(SendPacketOuts(mock_call_adapter, /*transmit_socket=*/1,
+                           kEthernet0, packets));
+}
+
+TEST(PacketIoTest, SendPacketOutsFailsOnSendError) {
+  MockSystemCallAdapter mock_call_adapter;
+  struct ifreq if_resp { /*ifr_name=*/
+    {""}, /*ifr_flags=*/{
+      { IFF_UP | IFF_RUNNING }
+    }
+  };
+  EXPECT_CALL(mock_call_adapter, ioctl)
+      .WillOnce(DoAll(SetArgPointee<2>(if_resp), Return(0)));
+  EXPECT_CALL(mock_call_adapter, sendmmsg).WillOnce(Return(-1));
+
+  const std::vector<std::string> packets(
+      2, std::string(kTestPacket, sizeof(kTestPacket)));
+  EXPECT_THAT(SendPacketOuts(mock_call_adapter, /*transmit_socket=*/1,
+                             kEthernet0, packets),
+              StatusIs(absl::StatusCode::kInternal,
+                       HasSubstr("Failed to send packet 0 of 2")));
+}
+
+TEST(PacketIoTest, SendPacketOutsLinkDown) {
+  MockSystemCallAdapter mock_call_adapter;
+  struct ifreq if_resp { /*ifr_name=*/
+    {""}, /*ifr_flags=*/{
+      { IFF_UP }
+    }
+  };
+  EXPECT_CALL(mock_call_adapter, ioctl)
+      .WillOnce(DoAll(SetArgPointee<2>(if_resp), Return(0)));
+  EXPECT_CALL(mock_call_adapter, sendmmsg).Times(0);
+
+  const std::vector<std::string> packets(
+      2, std::string(kTestPacket, sizeof(kTestPacket)));
+  EXPECT_THAT(SendPacketOuts(mock_call_adapter, /*transmit_socket=*/1,
+                             kEthernet0, packets),
+              StatusIs(absl::StatusCode::kInternal, HasSubstr("Link not up")));
+}
+
 TEST(PacketIoTest, AddPacketIoPortOK) {
   // Prepare mocks for CreateAndBindSocket.
   MockSystemCallAdapter mock_call_adapter;
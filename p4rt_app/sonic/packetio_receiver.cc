@@ -0,0 +1,341 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/packetio_receiver.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "glog/logging.h"
+#include "gutil/status.h"
+#include "p4rt_app/sonic/receive_genetlink.h"
+#include "p4rt_app/sonic/receive_timestamps.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+// Max number of ready sockets handled per epoll_wait call.
+constexpr int kMaxEventsPerWait = 64;
+
+}  // namespace
+
+PacketInReceiver::Shard::~Shard() {
+  if (epoll_fd >= 0) close(epoll_fd);
+  if (wakeup_fd >= 0) close(wakeup_fd);
+}
+
+absl::StatusOr<std::unique_ptr<PacketInReceiver>> PacketInReceiver::Create(
+    int num_threads, int max_queued_packets, const ThreadPlacement& placement,
+    std::shared_ptr<PacketInRateLimiter> rate_limiter) {
+  if (num_threads <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "PacketIO receiver needs at least 1 thread, but got "
+           << num_threads << ".";
+  }
+  if (max_queued_packets <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "PacketIO receiver must be able to queue at least 1 packet, but "
+           << "got " << max_queued_packets << ".";
+  }
+
+  // Not using make_unique because the constructor is private.
+  auto receiver = std::unique_ptr<PacketInReceiver>(
+      new PacketInReceiver(max_queued_packets, std::move(rate_limiter)));
+  for (int i = 0; i < num_threads; ++i) {
+    auto shard = std::make_unique<Shard>();
+    shard->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (shard->epoll_fd < 0) {
+      return gutil::InternalErrorBuilder()
+             << "Could not create epoll instance for PacketIO receiver: "
+             << std::strerror(errno);
+    }
+    shard->wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (shard->wakeup_fd < 0) {
+      return gutil::InternalErrorBuilder()
+             << "Could not create eventfd for PacketIO receiver: "
+             << std::strerror(errno);
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = shard->wakeup_fd;
+    if (epoll_ctl(shard->epoll_fd, EPOLL_CTL_ADD, shard->wakeup_fd, &event) <
+        0) {
+      return gutil::InternalErrorBuilder()
+             << "Could not watch eventfd for PacketIO receiver: "
+             << std::strerror(errno);
+    }
+
+    Shard& shard_ref = *shard;
+    shard->worker =
+        std::thread([receiver = receiver.get(), &shard_ref, placement] {
+          if (absl::Status status = ApplyThreadPlacement(placement);
+              !status.ok()) {
+            LOG(WARNING) << "Could not place PacketIO receive thread: "
+                         << status;
+          }
+          receiver->WorkerLoop(shard_ref);
+        });
+    receiver->shards_.push_back(std::move(shard));
+  }
+  LOG(INFO) << "Started PacketIO receiver with " << num_threads
+            << " receive threads on " << placement.ToString() << ".";
+  return receiver;
+}
+
+PacketInReceiver::~PacketInReceiver() {
+  Stop();
+  shutdown_.store(true);
+  for (auto& shard : shards_) {
+    uint64_t wakeup = 1;
+    if (write(shard->wakeup_fd, &wakeup, sizeof(wakeup)) < 0) {
+      LOG(ERROR) << "Could not wake up PacketIO receive thread: "
+                 << std::strerror(errno);
+    }
+  }
+  for (auto& shard : shards_) {
+    if (shard->worker.joinable()) shard->worker.join();
+  }
+}
+
+absl::Status PacketInReceiver::AddPort(absl::string_view port_name,
+                                       int socket) {
+  absl::MutexLock l(&ports_lock_);
+  if (port_to_shard_.contains(port_name)) {
+    return gutil::AlreadyExistsErrorBuilder()
+           << "PacketIO receiver is already receiving for port '" << port_name
+           << "'.";
+  }
+
+  // Pick the shard with the fewest ports.
+  absl::flat_hash_map<int, int> ports_per_shard;
+  for (const auto& [name, index] : port_to_shard_) ++ports_per_shard[index];
+  int shard_index = 0;
+  for (int i = 1; i < static_cast<int>(shards_.size()); ++i) {
+    if (ports_per_shard[i] < ports_per_shard[shard_index]) shard_index = i;
+  }
+  Shard& shard = *shards_[shard_index];
+
+  if (absl::Status status = EnableReceiveTimestamps(socket); !status.ok()) {
+    LOG(WARNING) << "PacketIns from " << port_name
+                 << " are timestamped when read: " << status.message();
+  }
+  {
+    absl::MutexLock shard_lock(&shard.lock);
+    shard.socket_to_port[socket] = std::string(port_name);
+  }
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = socket;
+  if (epoll_ctl(shard.epoll_fd, EPOLL_CTL_ADD, socket, &event) < 0) {
+    int error = errno;
+    absl::MutexLock shard_lock(&shard.lock);
+    shard.socket_to_port.erase(socket);
+    return gutil::InternalErrorBuilder()
+           << "Could not receive on socket " << socket << " for port '"
+           << port_name << "': " << std::strerror(error);
+  }
+  port_to_shard_[port_name] = shard_index;
+  return absl::OkStatus();
+}
+
+absl::Status PacketInReceiver::RemovePort(absl::string_view port_name) {
+  absl::MutexLock l(&ports_lock_);
+  auto port_iter = port_to_shard_.find(port_name);
+  if (port_iter == port_to_shard_.end()) {
+    return gutil::NotFoundErrorBuilder()
+           << "PacketIO receiver is not receiving for port '" << port_name
+           << "'.";
+  }
+  Shard& shard = *shards_[port_iter->second];
+  port_to_shard_.erase(port_iter);
+
+  // Holding the shard lock waits out any read in progress, and the worker
+  // ignores events for sockets that are no longer mapped.
+  absl::MutexLock shard_lock(&shard.lock);
+  for (auto it = shard.socket_to_port.begin(); it != shard.socket_to_port.end();
+       ++it) {
+    if (it->second != port_name) continue;
+    if (epoll_ctl(shard.epoll_fd, EPOLL_CTL_DEL, it->first, nullptr) < 0) {
+      LOG(WARNING) << "Could not stop watching socket " << it->first
+                   << " for port '" << port_name
+                   << "': " << std::strerror(errno);
+    }
+    shard.socket_to_port.erase(it);
+    break;
+  }
+  return absl::OkStatus();
+}
+
+bool PacketInReceiver::HasPort(absl::string_view port_name) const {
+  absl::MutexLock l(&ports_lock_);
+  return port_to_shard_.contains(port_name);
+}
+
+void PacketInReceiver::WorkerLoop(Shard& shard) {
+  epoll_event events[kMaxEventsPerWait];
+  while (!shutdown_.load()) {
+    int ready = epoll_wait(shard.epoll_fd, events, kMaxEventsPerWait, -1);
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      LOG(ERROR) << "PacketIO receive thread stopped, epoll_wait failed: "
+                 << std::strerror(errno);
+      return;
+    }
+    for (int i = 0; i < ready; ++i) {
+      if (events[i].data.fd == shard.wakeup_fd) continue;
+      ReadPackets(shard, events[i].data.fd);
+    }
+  }
+}
+
+void PacketInReceiver::ReadPackets(Shard& shard, int socket) {
+  // Drain as many packets as are ready, up to kMaxPacketsPerRead, with a single
+  // system call.
+  auto& buffers = shard.read_buffers;
+  iovec iovecs[kMaxPacketsPerRead];
+  mmsghdr messages[kMaxPacketsPerRead];
+  memset(messages, 0, sizeof(messages));
+  for (int i = 0; i < kMaxPacketsPerRead; ++i) {
+    iovecs[i].iov_base = buffers[i];
+    iovecs[i].iov_len = kMaxPacketSize;
+    messages[i].msg_hdr.msg_iov = &iovecs[i];
+    messages[i].msg_hdr.msg_iovlen = 1;
+    messages[i].msg_hdr.msg_control = shard.control_buffers[i];
+    messages[i].msg_hdr.msg_controllen = kReceiveTimestampControlSize;
+  }
+
+  std::string port_name;
+  int received = 0;
+  int read_error = 0;
+  {
+    absl::MutexLock l(&shard.lock);
+    auto port_iter = shard.socket_to_port.find(socket);
+    // The port was removed after epoll_wait returned.
+    if (port_iter == shard.socket_to_port.end()) return;
+    port_name = port_iter->second;
+
+    do {
+      received = recvmmsg(socket, messages, kMaxPacketsPerRead, MSG_DONTWAIT,
+                          /*timeout=*/nullptr);
+    } while (received < 0 && errno == EINTR);
+    read_error = errno;
+  }
+  if (received < 0) {
+    // Another wakeup may have already drained the socket.
+    if (read_error == EAGAIN || read_error == EWOULDBLOCK) return;
+    LOG(ERROR) << "Error " << read_error
+               << " in reading buffer from socket for " << port_name;
+    return;
+  }
+
+  const absl::Time read_time = absl::Now();
+  for (int i = 0; i < received; ++i) {
+    if (messages[i].msg_len == 0) continue;
+    QueuePacket(port_name, absl::string_view(buffers[i], messages[i].msg_len),
+                ReceiveTimestamp(messages[i].msg_hdr, read_time));
+  }
+}
+
+void PacketInReceiver::QueuePacket(absl::string_view port_name,
+                                   absl::string_view payload,
+                                   absl::Time receive_time) {
+  // Drop packets over the rate limits before spending a queue slot on them.
+  if (rate_limiter_ != nullptr &&
+      !rate_limiter_->Admit(port_name, absl::Now())) {
+    return;
+  }
+  if (queued_packets_.load(std::memory_order_relaxed) >= max_queued_packets_) {
+    dropped_packets_.fetch_add(1, std::memory_order_relaxed);
+    LOG_EVERY_N(WARNING, 1000)
+        << "Dropping packet in from " << port_name
+        << " because the controller is not keeping up.";
+    return;
+  }
+  // Count the packet before it is visible so the dispatch thread never sees
+  // the count drop below zero. Only the first packet after the queue drained
+  // needs to wake up the dispatch thread.
+  const int previously_queued =
+      queued_packets_.fetch_add(1, std::memory_order_acq_rel);
+  queue_.Push(PacketIn{
+      .port_name = std::string(port_name),
+      .payload = std::string(payload),
+      .receive_time = receive_time,
+  });
+  if (previously_queued == 0) {
+    absl::MutexLock l(&dispatch_lock_);
+    dispatch_cond_.Signal();
+  }
+}
+
+void PacketInReceiver::Dispatch(
+    packet_metadata::ReceiveCallbackFunction callback_function) {
+  while (true) {
+    std::optional<PacketIn> packet = queue_.Pop();
+    if (!packet.has_value()) {
+      if (queued_packets_.load(std::memory_order_acquire) > 0) {
+        // A worker counted the packet but has not linked it into the queue
+        // yet.
+        std::this_thread::yield();
+        continue;
+      }
+      absl::MutexLock l(&dispatch_lock_);
+      while (queued_packets_.load(std::memory_order_acquire) == 0 &&
+             !stopped_) {
+        dispatch_cond_.Wait(&dispatch_lock_);
+      }
+      if (stopped_ && queued_packets_.load(std::memory_order_acquire) == 0) {
+        return;
+      }
+      continue;
+    }
+    queued_packets_.fetch_sub(1, std::memory_order_acq_rel);
+
+    // Just pass empty string for target egress port since this support is not
+    // available in netdev model.
+    absl::Status status = callback_function(packet->port_name, "",
+                                            packet->payload,
+                                            packet->receive_time);
+    if (!status.ok()) {
+      LOG(WARNING) << "Unable to send packet to the controller"
+                   << status.ToString();
+    }
+  }
+}
+
+void PacketInReceiver::Stop() {
+  absl::MutexLock l(&dispatch_lock_);
+  stopped_ = true;
+  dispatch_cond_.Signal();
+}
+
+}  // namespace sonic
+}  // namespace p4rt_app
@@ -0,0 +1,169 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_SONIC_PACKETIO_RECEIVER_H_
+#define PINS_P4RT_APP_SONIC_PACKETIO_RECEIVER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "p4rt_app/sonic/packet_in_rate_limiter.h"
+#include "p4rt_app/sonic/receive_genetlink.h"
+#include "p4rt_app/sonic/receive_timestamps.h"
+#include "p4rt_app/utils/mpsc_queue.h"
+#include "p4rt_app/utils/thread_placement.h"
+
+namespace p4rt_app {
+namespace sonic {
+
+// Receives packets from the netdev receive sockets on a fixed set of worker
+// threads. Ports are sharded across the workers, each of which waits on its
+// own epoll instance. Workers never call back into the P4RT server. Instead
+// they hand every packet to a single dispatch thread over a lock-free queue,
+// so a slow StreamChannel write cannot stall the sockets.
+//
+// Example:
+//   ASSIGN_OR_RETURN(auto receiver, PacketInReceiver::Create(/*threads=*/4));
+//   RETURN_IF_ERROR(receiver->AddPort("Ethernet1/1/1", socket));
+//   std::thread dispatch([&] { receiver->Dispatch(callback); });
+class PacketInReceiver {
+ public:
+  // Max number of bytes read per packet. Matches the PacketInSelectable read
+  // path.
+  static constexpr int kMaxPacketSize = 1024;
+  // Max number of packets read from a socket per readiness event.
+  static constexpr int kMaxPacketsPerRead = 32;
+
+  // Starts `num_threads` receive workers, each with the given `placement`.
+  // Packets are dropped while more than `max_queued_packets` are waiting for
+  // the dispatch thread, and, if a `rate_limiter` is given, when they are over
+  // its limits. Both are checked before a packet is queued.
+  static absl::StatusOr<std::unique_ptr<PacketInReceiver>> Create(
+      int num_threads, int max_queued_packets = 4096,
+      const ThreadPlacement& placement = {},
+      std::shared_ptr<PacketInRateLimiter> rate_limiter = nullptr);
+
+  // Stops and joins the receive workers.
+  ~PacketInReceiver();
+
+  PacketInReceiver(const PacketInReceiver&) = delete;
+  PacketInReceiver& operator=(const PacketInReceiver&) = delete;
+
+  // Starts receiving on `socket` for `port_name`. The port is assigned to the
+  // worker with the fewest ports. The caller still owns the socket. Enables
+  // kernel receive timestamps on the socket, if it supports them.
+  absl::Status AddPort(absl::string_view port_name, int socket);
+
+  // Stops receiving for `port_name`. Once this returns no worker is reading
+  // from the port's socket, so the caller may close it.
+  absl::Status RemovePort(absl::string_view port_name);
+
+  bool HasPort(absl::string_view port_name) const;
+
+  // Invokes `callback_function` for every received packet, in the order each
+  // port received them. Blocks until Stop() is called. Must only be running on
+  // one thread at a time.
+  void Dispatch(packet_metadata::ReceiveCallbackFunction callback_function);
+
+  // Makes Dispatch return once the packets already queued have been handled.
+  // Receive workers keep running until the receiver is destroyed.
+  void Stop() ABSL_LOCKS_EXCLUDED(dispatch_lock_);
+
+  // Number of packets waiting for the dispatch thread.
+  int QueuedPackets() const {
+    return queued_packets_.load(std::memory_order_relaxed);
+  }
+
+  // Number of packets dropped because the dispatch thread fell behind.
+  uint64_t DroppedPackets() const {
+    return dropped_packets_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct PacketIn {
+    std::string port_name;
+    std::string payload;
+    absl::Time receive_time;
+  };
+
+  // Each worker owns one epoll instance. The eventfd wakes the worker up on
+  // shutdown.
+  struct Shard {
+    ~Shard();
+
+    int epoll_fd = -1;
+    int wakeup_fd = -1;
+    // Held while reading from a socket so RemovePort cannot return while the
+    // socket is still in use.
+    mutable absl::Mutex lock;
+    absl::flat_hash_map<int, std::string> socket_to_port ABSL_GUARDED_BY(lock);
+    // Only used by the worker.
+    char read_buffers[kMaxPacketsPerRead][kMaxPacketSize];
+    char control_buffers[kMaxPacketsPerRead][kReceiveTimestampControlSize];
+    std::thread worker;
+  };
+
+  PacketInReceiver(int max_queued_packets,
+                   std::shared_ptr<PacketInRateLimiter> rate_limiter)
+      : max_queued_packets_(max_queued_packets),
+        rate_limiter_(std::move(rate_limiter)) {}
+
+  void WorkerLoop(Shard& shard);
+
+  // Reads every packet ready on `socket`, up to kMaxPacketsPerRead, and queues
+  // them for dispatch.
+  void ReadPackets(Shard& shard, int socket) ABSL_LOCKS_EXCLUDED(shard.lock);
+
+  // Queues a packet for dispatch, or drops it if the queue is full.
+  void QueuePacket(absl::string_view port_name, absl::string_view payload,
+                   absl::Time receive_time);
+
+  const int max_queued_packets_;
+  const std::shared_ptr<PacketInRateLimiter> rate_limiter_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<bool> shutdown_ = false;
+
+  // Index into `shards_` for every port.
+  mutable absl::Mutex ports_lock_;
+  absl::flat_hash_map<std::string, int> port_to_shard_
+      ABSL_GUARDED_BY(ports_lock_);
+
+  MpscQueue<PacketIn> queue_;
+  // Number of packets pushed to `queue_` that have not been dispatched yet.
+  std::atomic<int> queued_packets_ = 0;
+  std::atomic<uint64_t> dropped_packets_ = 0;
+
+  // The dispatch thread sleeps on `dispatch_cond_` while the queue is empty.
+  // Workers only take `dispatch_lock_` when the queue goes from empty to
+  // non-empty.
+  absl::Mutex dispatch_lock_;
+  absl::CondVar dispatch_cond_;
+  bool stopped_ ABSL_GUARDED_BY(dispatch_lock_) = false;
+};
+
+}  // namespace sonic
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_SONIC_PACKETIO_RECEIVER_H_
@@ -0,0 +1,296 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/packetio_receiver.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "glog/logging.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::AllOf;
+using ::testing::ElementsAre;
+using ::testing::Ge;
+using ::testing::Le;
+using ::testing::Pair;
+using ::testing::SizeIs;
+
+// A connected pair of datagram sockets. Packets written to one end are read
+// from the other one at a time, like from a netdev port. Both ends are closed
+// on destruction.
+class SocketPair {
+ public:
+  SocketPair() {
+    int err = socketpair(AF_UNIX, SOCK_DGRAM, 0, fd_);
+    LOG_IF(FATAL, err < 0) << "Failed to open socket pair: " << err;
+  }
+
+  ~SocketPair() {
+    close(fd_[0]);
+    close(fd_[1]);
+  }
+
+  int ReadEnd() const { return fd_[0]; }
+  int WriteEnd() const { return fd_[1]; }
+
+  void Write(const std::string& packet) const {
+    ASSERT_EQ(write(WriteEnd(), packet.data(), packet.size()),
+              static_cast<ssize_t>(packet.size()));
+  }
+
+ private:
+  int fd_[2];
+};
+
+// Collects the packets handed to the dispatch callback.
+class PacketCollector {
+ public:
+  packet_metadata::ReceiveCallbackFunction Callback() {
+    return [this](absl::string_view source_port, absl::string_view target_port,
+                  absl::string_view payload, absl::Time receive_time) {
+      absl::MutexLock l(&lock_);
+      packets_.push_back({std::string(source_port), std::string(payload)});
+      receive_times_.push_back(receive_time);
+      received_.SignalAll();
+      return absl::OkStatus();
+    };
+  }
+
+  // Waits until `count` packets have been collected, and returns them.
+  std::vector<std::pair<std::string, std::string>> WaitFor(int count) {
+    absl::MutexLock l(&lock_);
+    absl::Time deadline = absl::Now() + absl::Seconds(10);
+    while (packets_.size() < count &&
+           !received_.WaitWithDeadline(&lock_, deadline)) {
+    }
+    return packets_;
+  }
+
+  // The receive time of every collected packet.
+  std::vector<absl::Time> ReceiveTimes() {
+    absl::MutexLock l(&lock_);
+    return receive_times_;
+  }
+
+ private:
+  absl::Mutex lock_;
+  absl::CondVar received_;
+  std::vector<std::pair<std::string, std::string>> packets_
+      ABSL_GUARDED_BY(lock_);
+  std::vector<absl::Time> receive_times_ ABSL_GUARDED_BY(lock_);
+};
+
+TEST(PacketInReceiverTest, RequiresAtLeastOneThread) {
+  EXPECT_THAT(PacketInReceiver::Create(/*num_threads=*/0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PacketInReceiverTest, RequiresRoomForAtLeastOnePacket) {
+  EXPECT_THAT(PacketInReceiver::Create(/*num_threads=*/1,
+                                       /*max_queued_packets=*/0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(PacketInReceiverTest, AddAndRemovePorts) {
+  SocketPair port1;
+  SocketPair port2;
+  ASSERT_OK_AND_ASSIGN(auto receiver,
+                       PacketInReceiver::Create(/*num_threads=*/2));
+
+  ASSERT_OK(receiver->AddPort("Ethernet1/1/1", port1.ReadEnd()));
+  ASSERT_OK(receiver->AddPort("Ethernet1/1/2", port2.ReadEnd()));
+  EXPECT_TRUE(receiver->HasPort("Ethernet1/1/1"));
+  EXPECT_TRUE(receiver->HasPort("Ethernet1/1/2"));
+  EXPECT_THAT(receiver->AddPort("Ethernet1/1/1", port1.ReadEnd()),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+
+  ASSERT_OK(receiver->RemovePort("Ethernet1/1/1"));
+  EXPECT_FALSE(receiver->HasPort("Ethernet1/1/1"));
+  EXPECT_TRUE(receiver->HasPort("Ethernet1/1/2"));
+  EXPECT_THAT(receiver->RemovePort("Ethernet1/1/1"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(PacketInReceiverTest, DispatchesPacketsFromEveryPort) {
+  SocketPair port1;
+  SocketPair port2;
+  ASSERT_OK_AND_ASSIGN(auto receiver,
+                       PacketInReceiver::Create(/*num_threads=*/2));
+  ASSERT_OK(receiver->AddPort("Ethernet1/1/1", port1.ReadEnd()));
+  ASSERT_OK(receiver->AddPort("Ethernet1/1/2", port2.ReadEnd()));
+
+  PacketCollector collector;
+  std::thread dispatch([&] { receiver->Dispatch(collector.Callback()); });
+
+  port1.Write("packet1");
+  EXPECT_THAT(collector.WaitFor(1),
+              ElementsAre(Pair("Ethernet1/1/1", "packet1")));
+  port2.Write("packet2");
+  EXPECT_THAT(collector.WaitFor(2),
+              ElementsAre(Pair("Ethernet1/1/1", "packet1"),
+                          Pair("Ethernet1/1/2", "packet2")));
+
+  receiver->Stop();
+  dispatch.join();
+}
+
+TEST(PacketInReceiverTest, PassesTheKernelReceiveTime) {
+  SocketPair port;
+  ASSERT_OK_AND_ASSIGN(auto receiver,
+                       PacketInReceiver::Create(/*num_threads=*/1));
+  ASSERT_OK(receiver->AddPort("Ethernet1/1/1", port.ReadEnd()));
+
+  const absl::Time before = absl::Now();
+  port.Write("packet");
+  const absl::Time after = absl::Now();
+  // Waiting to be dispatched does not change when the packet was received.
+  absl::SleepFor(absl::Milliseconds(50));
+  PacketCollector collector;
+  std::thread dispatch([&] { receiver->Dispatch(collector.Callback()); });
+
+  ASSERT_THAT(collector.WaitFor(1), SizeIs(1));
+  EXPECT_THAT(collector.ReceiveTimes(),
+              ElementsAre(AllOf(Ge(before), Le(after))));
+
+  receiver->Stop();
+  dispatch.join();
+}
+
+TEST(PacketInReceiverTest, KeepsPacketOrderPerPort) {
+  constexpr int kPorts = 8;
+  constexpr int kPacketsPerPort = 50;
+  std::vector<std::unique_ptr<SocketPair>> ports;
+  ASSERT_OK_AND_ASSIGN(auto receiver,
+                       PacketInReceiver::Create(/*num_threads=*/3));
+  for (int i = 0; i < kPorts; ++i) {
+    ports.push_back(std::make_unique<SocketPair>());
+    ASSERT_OK(receiver->AddPort(absl::StrCat("Ethernet", i),
+                                ports.back()->ReadEnd()));
+  }
+
+  PacketCollector collector;
+  std::thread dispatch([&] { receiver->Dispatch(collector.Callback()); });
+
+  // Several packets are usually waiting on a port when it is read.
+  for (int packet = 0; packet < kPacketsPerPort; ++packet) {
+    for (int port = 0; port < kPorts; ++port) {
+      ports[port]->Write(absl::StrCat("packet", packet));
+    }
+  }
+
+  std::vector<std::pair<std::string, std::string>> packets =
+      collector.WaitFor(kPorts * kPacketsPerPort);
+  ASSERT_EQ(packets.size(), kPorts * kPacketsPerPort);
+  std::vector<int> next_packet(kPorts, 0);
+  for (const auto& [port_name, payload] : packets) {
+    int port = std::stoi(port_name.substr(std::string("Ethernet").size()));
+    EXPECT_EQ(payload, absl::StrCat("packet", next_packet[port]++));
+  }
+  EXPECT_EQ(receiver->DroppedPackets(), 0);
+
+  receiver->Stop();
+  dispatch.join();
+}
+
+TEST(PacketInReceiverTest, DropsPacketsWhenTheQueueIsFull) {
+  SocketPair port;
+  ASSERT_OK_AND_ASSIGN(auto receiver,
+                       PacketInReceiver::Create(/*num_threads=*/1,
+                                                /*max_queued_packets=*/1));
+  ASSERT_OK(receiver->AddPort("Ethernet1/1/1", port.ReadEnd()));
+
+  // Nothing is dispatching yet, so only the first packet fits in the queue.
+  port.Write("packet1");
+  while (receiver->DroppedPackets() == 0) {
+    port.Write("dropped");
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+
+  PacketCollector collector;
+  std::thread dispatch([&] { receiver->Dispatch(collector.Callback()); });
+  EXPECT_THAT(collector.WaitFor(1),
+              ElementsAre(Pair("Ethernet1/1/1", "packet1")));
+
+  receiver->Stop();
+  dispatch.join();
+}
+
+TEST(PacketInReceiverTest, DropsPacketsOverTheRateLimitBeforeQueueing) {
+  PacketInRateLimits limits;
+  limits.ports["Ethernet1/1/1"] = {.packets_per_second = 0.001, .burst = 2};
+  auto rate_limiter = std::make_shared<PacketInRateLimiter>(limits);
+  SocketPair port1;
+  SocketPair port2;
+  ASSERT_OK_AND_ASSIGN(
+      auto receiver,
+      PacketInReceiver::Create(/*num_threads=*/1, /*max_queued_packets=*/4096,
+                               /*placement=*/{}, rate_limiter));
+  ASSERT_OK(receiver->AddPort("Ethernet1/1/1", port1.ReadEnd()));
+  ASSERT_OK(receiver->AddPort("Ethernet1/1/2", port2.ReadEnd()));
+
+  for (int i = 0; i < 5; ++i) port1.Write(absl::StrCat("packet", i));
+  while (rate_limiter->GetDrops().total < 3) {
+    absl::SleepFor(absl::Milliseconds(10));
+  }
+  port2.Write("unlimited");
+
+  PacketCollector collector;
+  std::thread dispatch([&] { receiver->Dispatch(collector.Callback()); });
+  EXPECT_THAT(collector.WaitFor(3),
+              ElementsAre(Pair("Ethernet1/1/1", "packet0"),
+                          Pair("Ethernet1/1/1", "packet1"),
+                          Pair("Ethernet1/1/2", "unlimited")));
+  EXPECT_EQ(receiver->DroppedPackets(), 0);
+
+  receiver->Stop();
+  dispatch.join();
+}
+
+TEST(PacketInReceiverTest, RemovedPortsAreNoLongerRead) {
+  SocketPair port;
+  ASSERT_OK_AND_ASSIGN(auto receiver,
+                       PacketInReceiver::Create(/*num_threads=*/1));
+  ASSERT_OK(receiver->AddPort("Ethernet1/1/1", port.ReadEnd()));
+  ASSERT_OK(receiver->RemovePort("Ethernet1/1/1"));
+
+  port.Write("packet");
+  absl::SleepFor(absl::Milliseconds(50));
+
+  // The packet is still waiting in the socket.
+  char buffer[16];
+  EXPECT_EQ(read(port.ReadEnd(), buffer, sizeof(buffer)), 6);
+}
+
+}  // namespace
+}  // namespace sonic
+}  // namespace p4rt_app
@@ -14,8 +14,10 @@
 #include "p4rt_app/sonic/packetio_selectables.h"
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -23,7 +25,12 @@
 #include <string>
 #include <vector>
 
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
 #include "glog/logging.h"
+#include "p4rt_app/sonic/receive_genetlink.h"
+#include "p4rt_app/sonic/receive_timestamps.h"
 
 namespace p4rt_app {
 namespace sonic {
@@ -31,26 +38,50 @@ namespace sonic {
 // Max buffer size for Receive packets.
 static constexpr int kPacketIoPortMaxBufferSize = 1024;
 
+PacketInSelectable::PacketInSelectable(
+    absl::string_view port_name, int receive_socket,
+    packet_metadata::ReceiveCallbackFunction callback_function)
+    : port_name_(port_name),
+      receive_socket_(receive_socket),
+      callback_function_(callback_function) {
+  absl::Status status = EnableReceiveTimestamps(receive_socket_);
+  if (!status.ok()) {
+    LOG(WARNING) << "PacketIns from " << port_name_
+                 << " are timestamped when read: " << status.message();
+  }
+}
+
 // Return the receive socket used for this port.
 int PacketInSelectable::getFd() { return receive_socket_; }
 
 // Reads data from socket and invokes callback function to pass back the In
 // packet.
 uint64_t PacketInSelectable::readData() {
+  struct iovec iov = {
+      .iov_base = read_buffer_,
+      .iov_len = kPacketIoPortMaxBufferSize,
+  };
+  struct msghdr message;
   ssize_t msg_len = 0;
   do {
-    msg_len = read(receive_socket_, read_buffer_, kPacketIoPortMaxBufferSize);
-  } while (errno == EINTR);
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control_buffer_;
+    message.msg_controllen = sizeof(control_buffer_);
+    msg_len = recvmsg(receive_socket_, &message, /*flags=*/0);
+  } while (msg_len < 0 && errno == EINTR);
   if (msg_len < 0) {
     LOG(ERROR) << "Error " << errno << " in reading buffer from socket for "
                << port_name_;
   } else if (msg_len == 0) {
     LOG(ERROR) << "Unexpected socket shutdown during read for " << port_name_;
   } else {
-    std::string packet(read_buffer_, msg_len);
     // Just pass empty string for target egress port since this support is not
     // available in netdev model.
-    auto status = callback_function_(port_name_, "", packet);
+    auto status = callback_function_(
+        port_name_, "", absl::string_view(read_buffer_, msg_len),
+        ReceiveTimestamp(message, absl::Now()));
     if (!status.ok()) {
       LOG(WARNING) << "Unable to send packet to the controller"
                    << status.ToString();
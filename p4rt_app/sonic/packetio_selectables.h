@@ -18,6 +18,7 @@
 #include <string>
 
 #include "p4rt_app/sonic/receive_genetlink.h"
+#include "p4rt_app/sonic/receive_timestamps.h"
 #include "swss/selectable.h"
 
 namespace p4rt_app {
@@ -28,11 +29,10 @@ namespace sonic {
 // and the virtual funcs will read the buffers when packet in arrives.
 class PacketInSelectable : public swss::Selectable {
  public:
+  // Enables kernel receive timestamps on `receive_socket`, if it supports
+  // them.
   PacketInSelectable(absl::string_view port_name, int receive_socket,
-                     packet_metadata::ReceiveCallbackFunction callback_function)
-      : port_name_(port_name),
-        receive_socket_(receive_socket),
-        callback_function_(callback_function) {}
+                     packet_metadata::ReceiveCallbackFunction callback_function);
   ~PacketInSelectable() override{};
 
   // Override functions.
@@ -51,6 +51,8 @@ class PacketInSelectable : public swss::Selectable {
   int receive_socket_;
   // Buffer to hold data read from socket.
   char read_buffer_[1024];
+  // Buffer to hold the kernel receive timestamp.
+  char control_buffer_[kReceiveTimestampControlSize];
   // Callback function to be invoked.
   packet_metadata::ReceiveCallbackFunction callback_function_;
 };
@@ -19,6 +19,11 @@
 #include <netlink/genl/family.h>
 #include <netlink/genl/genl.h>
 
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
 #include "glog/logging.h"
 #include "gutil/status.h"
 
@@ -50,6 +55,8 @@ struct NetlinkCallbackArgs {
   }
   struct nla_policy* const genl_attr_policy_;
   const ReceiveCallbackFunction callback_function_;
+  // Interface names by ifindex. Only used by the receive thread.
+  absl::flat_hash_map<int, std::string> ifname_cache_;
 };
 
 namespace {
@@ -110,16 +117,22 @@ absl::Status PrepareNetlinkSocket(struct nl_sock** nlsock) {
   return absl::OkStatus();
 }
 
-// Convert ifindex to the corresponding interface name.
-absl::StatusOr<std::string> GetIfname(int16_t ifindex) {
+// Convert ifindex to the corresponding interface name. Every punted packet
+// carries the ifindex, so the names are looked up once and cached. The view
+// stays valid for as long as `ifname_cache` is not cleared.
+absl::StatusOr<absl::string_view> GetIfname(
+    absl::flat_hash_map<int, std::string>& ifname_cache, int16_t ifindex) {
   RET_CHECK(ifindex >= 0) << "Got an invalid ifindex: " << ifindex;
   // Return empty string for CPU port.
-  if (ifindex == 0) return std::string("");
+  if (ifindex == 0) return absl::string_view();
+  if (auto it = ifname_cache.find(ifindex); it != ifname_cache.end()) {
+    return it->second;
+  }
   char ifname[IF_NAMESIZE] = {0};
   RET_CHECK(if_indextoname(ifindex, ifname) != nullptr)
       << "Failed to convert ifindex: " << ifindex
       << " to ifname, errno: " << errno;
-  return std::string(ifname);
+  return ifname_cache.emplace(ifindex, ifname).first->second;
 }
 
 // Process a receive message to retrieve the netlink attribute values.
@@ -137,15 +150,17 @@ absl::Status ProcessReceiveMessage(struct nl_msg* msg, void* arg) {
     return gutil::UnknownErrorBuilder() << "Failed to parse, error: " << error;
   }
 
-  std::string source_port_name, target_port_name;
-  std::string packet;
+  // Everything points into the netlink message or the ifname cache, so nothing
+  // is copied before the callback.
+  absl::string_view source_port_name, target_port_name;
+  absl::string_view packet;
   for (int i = 0; i < GENL_ATTR_MAX; i++) {
     if (attr[i]) {
       switch (i) {
         case GENL_ATTR_SOURCE_IFINDEX: {
           /*G3_WA*/
           auto port = nla_get_u16(attr[i]);
-          const auto name_or = GetIfname(port);
+          const auto name_or = GetIfname(nl_cb_args->ifname_cache_, port);
           if (name_or.ok()) {
             source_port_name = *name_or;
           } else {
@@ -157,7 +172,7 @@ absl::Status ProcessReceiveMessage(struct nl_msg* msg, void* arg) {
         }
         case GENL_ATTR_DEST_IFINDEX: {
           auto port = nla_get_u16(attr[i]);
-          const auto name_or = GetIfname(port);
+          const auto name_or = GetIfname(nl_cb_args->ifname_cache_, port);
           if (name_or.ok()) {
             target_port_name = *name_or;
           } else {
@@ -171,8 +186,9 @@ absl::Status ProcessReceiveMessage(struct nl_msg* msg, void* arg) {
           break;
         }
         case GENL_ATTR_PAYLOAD: {
-          packet = std::string(static_cast<const char*>(nla_data(attr[i])),
-                               static_cast<size_t>(nla_len(attr[i])));
+          packet =
+              absl::string_view(static_cast<const char*>(nla_data(attr[i])),
+                                static_cast<size_t>(nla_len(attr[i])));
           break;
         }
         default: {
@@ -193,8 +209,9 @@ absl::Status ProcessReceiveMessage(struct nl_msg* msg, void* arg) {
            << "No source port, skipping this packet.";
   }
 
-  RETURN_IF_ERROR((nl_cb_args->callback_function_)(source_port_name,
-                                                   target_port_name, packet))
+  // Netlink messages carry no receive timestamp.
+  RETURN_IF_ERROR((nl_cb_args->callback_function_)(
+                      source_port_name, target_port_name, packet, absl::Now()))
           .SetPrepend()
       << "Callback function failed for the receive packet with error: ";
 
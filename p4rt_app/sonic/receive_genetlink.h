@@ -14,18 +14,24 @@
 #ifndef PINS_P4RT_APP_SONIC_RECEIVE_GENETLINK_H_
 #define PINS_P4RT_APP_SONIC_RECEIVE_GENETLINK_H_
 
+#include <functional>
 #include <thread>  //NOLINT
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 
 namespace packet_metadata {
 
 // Alias of the Receive Callback function used by the Receive thread to
-// be invoked on every packet from the hardware.
+// be invoked on every packet from the hardware. The arguments point into the
+// receive buffers and are only valid for the duration of the call, so the
+// callback must copy anything it keeps. `receive_time` is when the kernel
+// received the packet, or when it was read if the kernel did not timestamp it.
 using ReceiveCallbackFunction = std::function<absl::Status(
-    const std::string& src_port_name, const std::string& target_port_name,
-    const std::string& payload)>;
+    absl::string_view src_port_name, absl::string_view target_port_name,
+    absl::string_view payload, absl::Time receive_time)>;
 
 // Spawns the Receive thread for receiving all punted packets via the generic
 // netlink socket. Invokes the callback function with the packet metadata
@@ -0,0 +1,58 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/receive_timestamps.h"
+
+#include <sys/socket.h>
+#include <time.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "gutil/status.h"
+
+namespace p4rt_app {
+namespace sonic {
+
+absl::Status EnableReceiveTimestamps(int socket) {
+  const int enable = 1;
+  if (setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable,
+                 sizeof(enable)) < 0) {
+    return gutil::InternalErrorBuilder()
+           << "Could not enable receive timestamps on socket " << socket
+           << ": " << std::strerror(errno);
+  }
+  return absl::OkStatus();
+}
+
+absl::Time ReceiveTimestamp(const struct msghdr& message, absl::Time fallback) {
+  // CMSG_NXTHDR takes a non-const message, but does not modify it.
+  auto& mutable_message = const_cast<struct msghdr&>(message);
+  for (struct cmsghdr* control = CMSG_FIRSTHDR(&mutable_message);
+       control != nullptr;
+       control = CMSG_NXTHDR(&mutable_message, control)) {
+    if (control->cmsg_level != SOL_SOCKET ||
+        control->cmsg_type != SCM_TIMESTAMPNS) {
+      continue;
+    }
+    struct timespec timestamp;
+    memcpy(&timestamp, CMSG_DATA(control), sizeof(timestamp));
+    return absl::TimeFromTimespec(timestamp);
+  }
+  return fallback;
+}
+
+}  // namespace sonic
+}  // namespace p4rt_app
@@ -0,0 +1,45 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_SONIC_RECEIVE_TIMESTAMPS_H_
+#define PINS_P4RT_APP_SONIC_RECEIVE_TIMESTAMPS_H_
+
+#include <sys/socket.h>
+#include <time.h>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+
+namespace p4rt_app {
+namespace sonic {
+
+// Kernel receive timestamps tell how long a punted packet waited in the socket
+// buffer before the P4RT App read it.
+
+// Bytes of control buffer needed to receive a timestamp with recvmsg or
+// recvmmsg.
+constexpr int kReceiveTimestampControlSize =
+    CMSG_SPACE(sizeof(struct timespec));
+
+// Asks the kernel to timestamp every packet received on `socket` (i.e.
+// SO_TIMESTAMPNS). Fails if `socket` is not a socket.
+absl::Status EnableReceiveTimestamps(int socket);
+
+// Returns the kernel receive timestamp of a packet read into `message`, or
+// `fallback` if there is none (e.g. timestamps are not enabled).
+absl::Time ReceiveTimestamp(const struct msghdr& message, absl::Time fallback);
+
+}  // namespace sonic
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_SONIC_RECEIVE_TIMESTAMPS_H_
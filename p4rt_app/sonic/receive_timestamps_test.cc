@@ -0,0 +1,90 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/receive_timestamps.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+class SocketPair {
+ public:
+  SocketPair() { socketpair(AF_UNIX, SOCK_DGRAM, 0, fds_); }
+  ~SocketPair() {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+
+  int SendEnd() const { return fds_[0]; }
+  int ReceiveEnd() const { return fds_[1]; }
+
+ private:
+  int fds_[2] = {-1, -1};
+};
+
+// Receives a single packet from `socket` and returns its receive timestamp,
+// or `fallback`.
+absl::Time ReceiveAndTimestamp(int socket, absl::Time fallback) {
+  char buffer[16];
+  char control[kReceiveTimestampControlSize];
+  struct iovec iov = {.iov_base = buffer, .iov_len = sizeof(buffer)};
+  struct msghdr message = {};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  EXPECT_EQ(recvmsg(socket, &message, 0), 6);
+  return ReceiveTimestamp(message, fallback);
+}
+
+TEST(ReceiveTimestampsTest, ReturnsTheKernelReceiveTime) {
+  SocketPair sockets;
+  ASSERT_OK(EnableReceiveTimestamps(sockets.ReceiveEnd()));
+
+  const absl::Time before = absl::Now();
+  ASSERT_EQ(write(sockets.SendEnd(), "packet", 6), 6);
+  const absl::Time after = absl::Now();
+
+  const absl::Time timestamp =
+      ReceiveAndTimestamp(sockets.ReceiveEnd(), absl::InfinitePast());
+  EXPECT_GE(timestamp, before);
+  EXPECT_LE(timestamp, after);
+}
+
+TEST(ReceiveTimestampsTest, ReturnsTheFallbackWithoutTimestamps) {
+  SocketPair sockets;
+  ASSERT_EQ(write(sockets.SendEnd(), "packet", 6), 6);
+  const absl::Time fallback = absl::FromUnixSeconds(42);
+  EXPECT_EQ(ReceiveAndTimestamp(sockets.ReceiveEnd(), fallback), fallback);
+}
+
+TEST(ReceiveTimestampsTest, FailsForNonSockets) {
+  int pipe_fds[2];
+  ASSERT_EQ(pipe(pipe_fds), 0);
+  EXPECT_FALSE(EnableReceiveTimestamps(pipe_fds[0]).ok());
+  close(pipe_fds[0]);
+  close(pipe_fds[1]);
+}
+
+}  // namespace
+}  // namespace sonic
+}  // namespace p4rt_app
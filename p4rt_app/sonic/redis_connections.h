@@ -22,6 +22,8 @@
 #include "p4rt_app/sonic/adapters/notification_producer_adapter.h"
 #include "p4rt_app/sonic/adapters/producer_state_table_adapter.h"
 #include "p4rt_app/sonic/adapters/table_adapter.h"
+#include "p4rt_app/sonic/entry_generations.h"
+#include "p4rt_app/sonic/replica_serializations.h"
 
 namespace p4rt_app {
 namespace sonic {
@@ -34,6 +36,9 @@ struct P4rtTable {
   std::unique_ptr<ConsumerNotifierAdapter> notification_consumer;
   std::unique_ptr<TableAdapter> app_db;
   std::unique_ptr<TableAdapter> counter_db;
+  // Lets multicast group modifies reuse the JSON of unchanged replicas.
+  std::unique_ptr<ReplicaSerializations> replica_serializations =
+      std::make_unique<ReplicaSerializations>();
 };
 
 // The P4RT app needs to:
@@ -46,6 +51,9 @@ struct VrfTable {
   std::unique_ptr<ConsumerNotifierAdapter> notification_consumer;
   std::unique_ptr<TableAdapter> app_db;
   std::unique_ptr<TableAdapter> app_state_db;
+  // Lets routine state verification skip the entries that did not change.
+  std::unique_ptr<EntryGenerations> generations =
+      std::make_unique<EntryGenerations>();
 };
 
 // The P4RT app needs to:
@@ -57,6 +65,9 @@ struct HashTable {
   std::unique_ptr<ConsumerNotifierAdapter> notification_consumer;
   std::unique_ptr<TableAdapter> app_db;
   std::unique_ptr<TableAdapter> app_state_db;
+  // Lets routine state verification skip the entries that did not change.
+  std::unique_ptr<EntryGenerations> generations =
+      std::make_unique<EntryGenerations>();
 };
 
 // The P4RT app needs to:
@@ -68,6 +79,9 @@ struct SwitchTable {
   std::unique_ptr<ConsumerNotifierAdapter> notification_consumer;
   std::unique_ptr<TableAdapter> app_db;
   std::unique_ptr<TableAdapter> app_state_db;
+  // Lets routine state verification skip the entries that did not change.
+  std::unique_ptr<EntryGenerations> generations =
+      std::make_unique<EntryGenerations>();
 };
 
 // The P4RT app needs to:
@@ -0,0 +1,109 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/replica_serializations.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "nlohmann/json.hpp"
+#include "p4_pdpi/ir.pb.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+std::string ReplicaJson(const pdpi::IrReplica& replica) {
+  nlohmann::json json;
+  json["multicast_replica_port"] = replica.port();
+  json["multicast_replica_instance"] =
+      absl::StrCat("0x", absl::Hex(replica.instance(), absl::kZeroPad4));
+  return json.dump();
+}
+
+}  // namespace
+
+std::string ReplicaSerializations::Serialize(
+    const pdpi::IrMulticastGroupEntry& group) {
+  absl::MutexLock l(&lock_);
+  std::vector<Replica>& old_replicas =
+      replicas_by_group_[group.multicast_group_id()];
+
+  // Replicas usually keep their position, so each one is first compared with
+  // the old replica at the same index. The index of every old replica is only
+  // built if that fails.
+  absl::flat_hash_map<std::pair<absl::string_view, uint32_t>, int> old_index;
+  auto find_old_replica = [&](int i, const pdpi::IrReplica& replica) -> int {
+    if (i < old_replicas.size() && old_replicas[i].port == replica.port() &&
+        old_replicas[i].instance == replica.instance()) {
+      return i;
+    }
+    if (old_index.empty()) {
+      for (int j = 0; j < old_replicas.size(); ++j) {
+        old_index.try_emplace(
+            {old_replicas[j].port, old_replicas[j].instance}, j);
+      }
+    }
+    auto old = old_index.find({replica.port(), replica.instance()});
+    return old == old_index.end() ? -1 : old->second;
+  };
+
+  std::vector<Replica> new_replicas;
+  new_replicas.reserve(group.replicas_size());
+  std::string result = "[";
+  for (int i = 0; i < group.replicas_size(); ++i) {
+    const pdpi::IrReplica& replica = group.replicas(i);
+    Replica& new_replica = new_replicas.emplace_back();
+    new_replica.port = replica.port();
+    new_replica.instance = replica.instance();
+    const int old = find_old_replica(i, replica);
+    if (old >= 0) {
+      // Copied rather than moved, since duplicate replicas share the same old
+      // one.
+      new_replica.json = old_replicas[old].json;
+    } else {
+      new_replica.json = ReplicaJson(replica);
+      ++serialized_replicas_;
+    }
+    if (i > 0) result.push_back(',');
+    result.append(new_replica.json);
+  }
+  result.push_back(']');
+
+  old_replicas = std::move(new_replicas);
+  return result;
+}
+
+void ReplicaSerializations::Erase(uint32_t multicast_group_id) {
+  absl::MutexLock l(&lock_);
+  replicas_by_group_.erase(multicast_group_id);
+}
+
+int64_t ReplicaSerializations::size() const {
+  absl::MutexLock l(&lock_);
+  return replicas_by_group_.size();
+}
+
+int64_t ReplicaSerializations::serialized_replicas() const {
+  absl::MutexLock l(&lock_);
+  return serialized_replicas_;
+}
+
+}  // namespace sonic
+}  // namespace p4rt_app
@@ -0,0 +1,72 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_SONIC_REPLICA_SERIALIZATIONS_H_
+#define PINS_P4RT_APP_SONIC_REPLICA_SERIALIZATIONS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace p4rt_app {
+namespace sonic {
+
+// Remembers the JSON of every replica the P4RT App last wrote for each
+// multicast group, i.e. the elements of the group's AppDb "replicas" field.
+// A modify usually adds or removes a few replicas of a large group, so the new
+// replica set is diffed against the remembered one and only the replicas that
+// were added are serialized again.
+//
+// The JSON of a replica only depends on its port and instance, so a group that
+// OrchAgent rejected is still remembered correctly.
+//
+// Thread-safe.
+class ReplicaSerializations {
+ public:
+  // Returns the "replicas" field value of `group`, in replica order, and
+  // remembers its replicas for the next update of the group.
+  std::string Serialize(const pdpi::IrMulticastGroupEntry& group)
+      ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Forgets a deleted multicast group.
+  void Erase(uint32_t multicast_group_id) ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Returns the number of groups that are remembered.
+  int64_t size() const ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Returns how many replicas had to be serialized, rather than reused, over
+  // the lifetime of this object.
+  int64_t serialized_replicas() const ABSL_LOCKS_EXCLUDED(lock_);
+
+ private:
+  struct Replica {
+    std::string port;
+    uint32_t instance;
+    std::string json;
+  };
+
+  mutable absl::Mutex lock_;
+  absl::flat_hash_map<uint32_t, std::vector<Replica>> replicas_by_group_
+      ABSL_GUARDED_BY(lock_);
+  int64_t serialized_replicas_ ABSL_GUARDED_BY(lock_) = 0;
+};
+
+}  // namespace sonic
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_SONIC_REPLICA_SERIALIZATIONS_H_
@@ -0,0 +1,111 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/sonic/replica_serializations.h"
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/testing.h"
+#include "p4_pdpi/ir.pb.h"
+
+namespace p4rt_app {
+namespace sonic {
+namespace {
+
+constexpr char kReplica1[] =
+    R"j({"multicast_replica_instance":"0x0001",)j"
+    R"j("multicast_replica_port":"Ethernet1"})j";
+constexpr char kReplica2[] =
+    R"j({"multicast_replica_instance":"0x0002",)j"
+    R"j("multicast_replica_port":"Ethernet2"})j";
+constexpr char kReplica3[] =
+    R"j({"multicast_replica_instance":"0x0003",)j"
+    R"j("multicast_replica_port":"Ethernet3"})j";
+
+pdpi::IrMulticastGroupEntry Group(const std::string& text) {
+  return gutil::ParseProtoOrDie<pdpi::IrMulticastGroupEntry>(text);
+}
+
+TEST(ReplicaSerializationsTest, SerializesEveryReplicaInOrder) {
+  ReplicaSerializations serializations;
+  EXPECT_EQ(serializations.Serialize(Group(R"pb(
+              multicast_group_id: 1
+              replicas { port: "Ethernet2" instance: 2 }
+              replicas { port: "Ethernet1" instance: 1 }
+            )pb")),
+            absl::StrCat("[", kReplica2, ",", kReplica1, "]"));
+  EXPECT_EQ(serializations.Serialize(Group("multicast_group_id: 2")), "[]");
+  EXPECT_EQ(serializations.size(), 2);
+}
+
+TEST(ReplicaSerializationsTest, OnlySerializesAddedReplicas) {
+  ReplicaSerializations serializations;
+  serializations.Serialize(Group(R"pb(
+    multicast_group_id: 1
+    replicas { port: "Ethernet1" instance: 1 }
+    replicas { port: "Ethernet2" instance: 2 }
+  )pb"));
+  ASSERT_EQ(serializations.serialized_replicas(), 2);
+
+  // Ethernet1 moves, Ethernet2 is removed, and Ethernet3 is added.
+  EXPECT_EQ(serializations.Serialize(Group(R"pb(
+              multicast_group_id: 1
+              replicas { port: "Ethernet3" instance: 3 }
+              replicas { port: "Ethernet1" instance: 1 }
+            )pb")),
+            absl::StrCat("[", kReplica3, ",", kReplica1, "]"));
+  EXPECT_EQ(serializations.serialized_replicas(), 3);
+
+  // Unchanged groups are not serialized again.
+  serializations.Serialize(Group(R"pb(
+    multicast_group_id: 1
+    replicas { port: "Ethernet3" instance: 3 }
+    replicas { port: "Ethernet1" instance: 1 }
+  )pb"));
+  EXPECT_EQ(serializations.serialized_replicas(), 3);
+}
+
+TEST(ReplicaSerializationsTest, ReplicasAreNotSharedBetweenGroups) {
+  ReplicaSerializations serializations;
+  serializations.Serialize(Group(R"pb(
+    multicast_group_id: 1
+    replicas { port: "Ethernet1" instance: 1 }
+  )pb"));
+  serializations.Serialize(Group(R"pb(
+    multicast_group_id: 2
+    replicas { port: "Ethernet1" instance: 1 }
+  )pb"));
+  EXPECT_EQ(serializations.serialized_replicas(), 2);
+}
+
+TEST(ReplicaSerializationsTest, ErasedGroupsAreSerializedAgain) {
+  ReplicaSerializations serializations;
+  const pdpi::IrMulticastGroupEntry group = Group(R"pb(
+    multicast_group_id: 1
+    replicas { port: "Ethernet1" instance: 1 }
+  )pb");
+  serializations.Serialize(group);
+  serializations.Erase(1);
+  EXPECT_EQ(serializations.size(), 0);
+
+  EXPECT_EQ(serializations.Serialize(group),
+            absl::StrCat("[", kReplica1, "]"));
+  EXPECT_EQ(serializations.serialized_replicas(), 2);
+}
+
+}  // namespace
+}  // namespace sonic
+}  // namespace p4rt_app
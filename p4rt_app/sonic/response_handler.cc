@@ -15,10 +15,13 @@
  */
 #include "p4rt_app/sonic/response_handler.h"
 
+#include <algorithm>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/escaping.h"
@@ -78,142 +81,174 @@ google::rpc::Code SwssToP4RTErrorCode(const std::string& status_str) {
 // p4rt does not match the order in which the entries are pulled out from
 // APP_DB. Hence, we expect to see the expected responses but not in the same
 // order.
-absl::StatusOr<absl::btree_map<std::string, pdpi::IrUpdateStatus>>
+//
+// Responses are popped in bulk (i.e. everything already received is handled in
+// one wakeup), and collected into a hash map so large batches do not pay for
+// ordered inserts.
+absl::StatusOr<absl::flat_hash_map<std::string, pdpi::IrUpdateStatus>>
 GetAppDbResponses(int expected_response_count,
                   ConsumerNotifierAdapter& notification_interface) {
-  absl::btree_map<std::string, pdpi::IrUpdateStatus> key_to_status_map;
+  absl::flat_hash_map<std::string, pdpi::IrUpdateStatus> key_to_status_map;
+  key_to_status_map.reserve(expected_response_count);
 
   // Loop through and get the expected notification responses from Orchagent,
   // max timeout 10 minutes. OrchAgent sends the status code as string in the
   // op, key as data and the actual table entries as value_tuples.
-  for (int i = 0; i < expected_response_count; i++) {
-    std::string status_str;
-    std::string actual_key;
-    std::vector<swss::FieldValueTuple> value_tuples;
-
-    if (!notification_interface.WaitForNotificationAndPop(
-            status_str, actual_key, value_tuples, /*timeout_ms=*/10 * 60000)) {
+  std::vector<swss::KeyOpFieldsValuesTuple> notifications;
+  int received = 0;
+  while (received < expected_response_count) {
+    notifications.clear();
+    if (!notification_interface.WaitForNotificationsAndPop(
+            expected_response_count - received, notifications,
+            /*timeout_ms=*/10 * 60000)) {
       return gutil::InternalErrorBuilder()
              << "[OrchAgent] P4RT App timed out or failed waiting on a AppDB "
                 "response from the OrchAgent.";
     }
-    if (value_tuples.empty()) {
-      return gutil::InternalErrorBuilder()
-             << "Notification response for '" << actual_key
-             << "' should not be empty.";
-    }
+    received += notifications.size();
 
-    pdpi::IrUpdateStatus result;
-    // The first element in the values vector is the detailed error message in
-    // the form of ("err_str", <error message>).
-    const swss::FieldValueTuple& first_tuple = value_tuples[0];
-    if (fvField(first_tuple) != "err_str") {
-      return gutil::InternalErrorBuilder()
-             << "[OrchAgent] responded with '" << fvField(first_tuple)
-             << "' as its first value, but P4RT App was expecting 'err_str'.";
-    } else {
-      // Sanatize any response messages coming from the OA layers.
-      result.set_code(SwssToP4RTErrorCode(status_str));
-      result.set_message(absl::CHexEscape(fvValue(first_tuple)));
-    }
+    for (const swss::KeyOpFieldsValuesTuple& notification : notifications) {
+      const std::string& status_str = kfvOp(notification);
+      const std::string& actual_key = kfvKey(notification);
+      const std::vector<swss::FieldValueTuple>& value_tuples =
+          kfvFieldsValues(notification);
+      if (value_tuples.empty()) {
+        return gutil::InternalErrorBuilder()
+               << "Notification response for '" << actual_key
+               << "' should not be empty.";
+      }
 
-    // Insert into the responses map, but do not allow duplicates.
-    if (bool success = key_to_status_map.insert({actual_key, result}).second;
-        !success) {
-      return gutil::InternalErrorBuilder()
-             << "[P4RT App] The response path received a duplicate key from "
-                "the AppDb: "
-             << actual_key;
+      pdpi::IrUpdateStatus result;
+      // The first element in the values vector is the detailed error message
+      // in the form of ("err_str", <error message>).
+      const swss::FieldValueTuple& first_tuple = value_tuples[0];
+      if (fvField(first_tuple) != "err_str") {
+        return gutil::InternalErrorBuilder()
+               << "[OrchAgent] responded with '" << fvField(first_tuple)
+               << "' as its first value, but P4RT App was expecting "
+                  "'err_str'.";
+      } else {
+        // Sanatize any response messages coming from the OA layers.
+        result.set_code(SwssToP4RTErrorCode(status_str));
+        result.set_message(absl::CHexEscape(fvValue(first_tuple)));
+      }
+
+      // Insert into the responses map, but do not allow duplicates.
+      if (bool success =
+              key_to_status_map.try_emplace(actual_key, std::move(result))
+                  .second;
+          !success) {
+        return gutil::InternalErrorBuilder()
+               << "[P4RT App] The response path received a duplicate key from "
+                  "the AppDb: "
+               << actual_key;
+      }
     }
   }
   return key_to_status_map;
 }
 
-// Restore APPL_DB to the last successful state.
+// Restores APPL_DB entries to their last successful state. The APPL_STATE_DB
+// copies of every entry are read with one pipelined request. Then every entry
+// is deleted with one request, and the ones that existed before are rewritten
+// with one pipelined request.
 absl::Status RestoreApplDb(TableAdapter& app_db_table,
                            TableAdapter& state_db_table,
-                           const std::string& key) {
-  // Query the APPL_STATE_DB with the same key as in APPL_DB.
-  std::vector<std::pair<std::string, std::string>> values =
-      state_db_table.get(key);
-  if (values.empty()) {
-    LOG(INFO) << "Restoring (by delete) AppDb entry: " << key;
-    app_db_table.del(key);
-  } else {
-    // Update APPL_DB with the retrieved values from APPL_STATE_DB.
-    LOG(INFO) << "Restoring (by update) AppDb entry: " << key;
-    app_db_table.del(key);
-    app_db_table.set(key, values);
+                           const std::vector<std::string>& keys) {
+  if (keys.empty()) return absl::OkStatus();
+
+  // Query the APPL_STATE_DB with the same keys as in APPL_DB.
+  std::vector<std::vector<std::pair<std::string, std::string>>> values =
+      state_db_table.batch_get(keys);
+  if (values.size() != keys.size()) {
+    return gutil::InternalErrorBuilder()
+           << "Requested " << keys.size()
+           << " entries from the AppStateDb to restore the AppDb, but got "
+           << values.size() << ".";
   }
 
+  // Entries without a copy in the APPL_STATE_DB did not exist before, so they
+  // are only deleted.
+  std::vector<swss::KeyOpFieldsValuesTuple> updates;
+  for (int i = 0; i < keys.size(); ++i) {
+    if (values[i].empty()) {
+      VLOG(1) << "Restoring (by delete) AppDb entry: " << keys[i];
+      continue;
+    }
+    VLOG(1) << "Restoring (by update) AppDb entry: " << keys[i];
+    updates.push_back(
+        swss::KeyOpFieldsValuesTuple(keys[i], "SET", std::move(values[i])));
+  }
+  LOG(INFO) << "Restoring " << keys.size() << " AppDb entries: "
+            << updates.size() << " by update, " << keys.size() - updates.size()
+            << " by delete.";
+
+  app_db_table.batch_del(keys);
+  if (!updates.empty()) app_db_table.batch_set(updates);
   return absl::OkStatus();
 }
 
 absl::Status UpdateResponsesAndRestoreState(
     absl::btree_map<std::string, pdpi::IrUpdateStatus*>& key_to_status_map,
-    const absl::btree_map<std::string, pdpi::IrUpdateStatus>&
+    const absl::flat_hash_map<std::string, pdpi::IrUpdateStatus>&
         response_status_map,
     TableAdapter* app_db_table, TableAdapter* state_db_table) {
   // We have a map of all the keys we expect to have a response for, and a map
   // of all the keys returned by the OrchAgent. If anything doesn't match up
   // then we have a problem, and should raise an internal error because of it.
-  auto expected_iter = key_to_status_map.begin();
-  auto response_iter = response_status_map.begin();
   std::vector<std::string> error_messages;
-  while (expected_iter != key_to_status_map.end() &&
-         response_iter != response_status_map.end()) {
-    const auto& expected_key = expected_iter->first;
-    auto* expected_status = expected_iter->second;
-    const auto& response_key = response_iter->first;
-    const auto& response_status = response_iter->second;
-
-    if (expected_key < response_key) {
+  std::vector<std::string> keys_to_restore;
+  size_t matched_responses = 0;
+  for (auto& [expected_key, expected_status] : key_to_status_map) {
+    auto response_iter = response_status_map.find(expected_key);
+    if (response_iter == response_status_map.end()) {
       // Missing an expected response.
       error_messages.push_back(
           absl::StrCat("Missing response for: ", expected_key));
-      ++expected_iter;
-    } else if (expected_key > response_key) {
-      // Got an extra response.
-      error_messages.push_back(
-          absl::StrCat("Extra response for: ", response_key));
-      ++response_iter;
-    } else {
-      // If we're waiting for a response then we should have a place to put the
-      // status.
-      if (expected_status == nullptr) {
-        LOG(ERROR) << "Cannot populate response for: " << expected_key;
-        return gutil::InternalErrorBuilder()
-               << "Response path is missing status object for key: "
-               << expected_key;
-      }
+      continue;
+    }
+    ++matched_responses;
+    const pdpi::IrUpdateStatus& response_status = response_iter->second;
 
-      // We got the expected response. However, if the OrchAgent failed to
-      // handle it correctly then we need to cleanup state in the AppDb.
-      if (response_iter->second.code() != google::rpc::Code::OK) {
-        *expected_status = response_iter->second;
-        LOG(WARNING) << "OrchAgent could not handle AppDb entry '"
-                     << response_key << "'. Failed with: "
-                     << response_status.ShortDebugString();
-        if (app_db_table != nullptr && state_db_table != nullptr) {
-          RETURN_IF_ERROR(
-              RestoreApplDb(*app_db_table, *state_db_table, response_key));
-        }
-      }
-      ++expected_iter;
-      ++response_iter;
+    // If we're waiting for a response then we should have a place to put the
+    // status.
+    if (expected_status == nullptr) {
+      LOG(ERROR) << "Cannot populate response for: " << expected_key;
+      return gutil::InternalErrorBuilder()
+             << "Response path is missing status object for key: "
+             << expected_key;
+    }
+
+    // We got the expected response. However, if the OrchAgent failed to handle
+    // it correctly then we need to cleanup state in the AppDb.
+    if (response_status.code() != google::rpc::Code::OK) {
+      *expected_status = response_status;
+      LOG(WARNING) << "OrchAgent could not handle AppDb entry '"
+                   << expected_key << "'. Failed with: "
+                   << response_status.ShortDebugString();
+      keys_to_restore.push_back(expected_key);
     }
   }
 
-  // There should be no unvisited keys in either the expected or response maps.
-  while (expected_iter != key_to_status_map.end()) {
-    error_messages.push_back(
-        absl::StrCat("Missing response for: ", expected_iter->first));
-    ++expected_iter;
+  // Failed entries are restored together so that a batch with many failures
+  // does not make a round trip per entry.
+  if (app_db_table != nullptr && state_db_table != nullptr) {
+    RETURN_IF_ERROR(
+        RestoreApplDb(*app_db_table, *state_db_table, keys_to_restore));
   }
-  while (response_iter != response_status_map.end()) {
-    error_messages.push_back(
-        absl::StrCat("Extra response for: ", response_iter->first));
-    ++response_iter;
+
+  // Any response we did not match is one we were not expecting.
+  if (matched_responses < response_status_map.size()) {
+    std::vector<std::string> extra_keys;
+    for (const auto& [response_key, _] : response_status_map) {
+      if (!key_to_status_map.contains(response_key)) {
+        extra_keys.push_back(response_key);
+      }
+    }
+    std::sort(extra_keys.begin(), extra_keys.end());
+    for (const std::string& key : extra_keys) {
+      error_messages.push_back(absl::StrCat("Extra response for: ", key));
+    }
   }
 
   if (!error_messages.empty()) {
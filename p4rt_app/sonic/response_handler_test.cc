@@ -13,7 +13,10 @@
 // limitations under the License.
 #include "p4rt_app/sonic/response_handler.h"
 
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -25,6 +28,7 @@
 #include "gutil/status_matchers.h"
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
+#include "p4rt_app/sonic/adapters/consumer_notifier_adapter.h"
 #include "p4rt_app/sonic/adapters/mock_consumer_notifier_adapter.h"
 #include "p4rt_app/sonic/adapters/mock_table_adapter.h"
 
@@ -36,9 +40,12 @@ using ::gutil::EqualsProto;
 using ::gutil::IsOkAndHolds;
 using ::gutil::StatusIs;
 using ::testing::DoAll;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::Return;
+using ::testing::SaveArg;
 using ::testing::SetArgReferee;
+using ::testing::SizeIs;
 using ::testing::Test;
 
 // Swss string to indicate status of the transaction, these are coming from
@@ -56,6 +63,70 @@ std::vector<swss::FieldValueTuple> GetSwssError(const std::string& message) {
       {swss::FieldValueTuple("err_str", message)});
 }
 
+// Notifier where every response has already been received by the time the
+// first notification is popped.
+class QueuedConsumerNotifierAdapter : public ConsumerNotifierAdapter {
+ public:
+  explicit QueuedConsumerNotifierAdapter(
+      std::deque<swss::KeyOpFieldsValuesTuple> notifications)
+      : notifications_(std::move(notifications)) {}
+
+  bool WaitForNotificationAndPop(std::string& op, std::string& data,
+                                 std::vector<swss::FieldValueTuple>& values,
+                                 int64_t timeout_ms) override {
+    if (timeout_ms != 0) ++blocking_waits_;
+    if (notifications_.empty()) return false;
+    op = kfvOp(notifications_.front());
+    data = kfvKey(notifications_.front());
+    values = kfvFieldsValues(notifications_.front());
+    notifications_.pop_front();
+    return true;
+  }
+
+  int blocking_waits() const { return blocking_waits_; }
+
+ protected:
+  bool HasQueuedNotification() override { return !notifications_.empty(); }
+
+ private:
+  std::deque<swss::KeyOpFieldsValuesTuple> notifications_;
+  int blocking_waits_ = 0;
+};
+
+TEST(ResponseHandlerTest, QueuedResponsesAreHandledInOneWakeup) {
+  QueuedConsumerNotifierAdapter notifier({
+      {"key2", kSwssSuccess, GetSwssOkResponse()},
+      {"key0", kSwssInternal, GetSwssError("my error")},
+      {"key1", kSwssSuccess, GetSwssOkResponse()},
+  });
+
+  pdpi::IrWriteResponse ir_write_response;
+  absl::btree_map<std::string, pdpi::IrUpdateStatus*> key_to_status_map;
+  key_to_status_map["key0"] = ir_write_response.add_statuses();
+  key_to_status_map["key1"] = ir_write_response.add_statuses();
+  key_to_status_map["key2"] = ir_write_response.add_statuses();
+
+  EXPECT_OK(GetAndProcessResponseNotificationWithoutRevertingState(
+      notifier, key_to_status_map));
+  EXPECT_EQ(notifier.blocking_waits(), 1);
+  EXPECT_THAT(ir_write_response.statuses(0),
+              EqualsProto(R"pb(code: INTERNAL message: "my error")pb"));
+}
+
+TEST(ResponseHandlerTest, QueuedResponsesForTheNextBatchAreNotPopped) {
+  QueuedConsumerNotifierAdapter notifier({
+      {"key0", kSwssSuccess, GetSwssOkResponse()},
+      {"key1", kSwssSuccess, GetSwssOkResponse()},
+  });
+
+  EXPECT_THAT(GetAndProcessResponseNotificationWithoutRevertingState(notifier,
+                                                                     "key0"),
+              IsOkAndHolds(EqualsProto(R"pb(code: OK)pb")));
+  EXPECT_THAT(GetAndProcessResponseNotificationWithoutRevertingState(notifier,
+                                                                     "key1"),
+              IsOkAndHolds(EqualsProto(R"pb(code: OK)pb")));
+}
+
 TEST(ResponseHandlerTest, SingleRequests) {
   MockConsumerNotifierAdapter mock_notifier;
   MockTableAdapter mock_app_db_client;
@@ -290,11 +361,13 @@ TEST(ResponseHandlerTest, CleanupAppDbWithAnUpdate) {
   // checking the AppStateDb we return a result which implies the entry existed
   // before and should be reverted back to the old values (i.e. call hmset to
   // the AppDb entry).
-  EXPECT_CALL(mock_state_db_client, get("key1"))
-      .WillOnce(Return(std::vector<std::pair<std::string, std::string>>{
-          {"action", "set_port_and_src_mac"},
-      }));
-  EXPECT_CALL(mock_app_db_client, set).Times(1);
+  EXPECT_CALL(mock_state_db_client, batch_get(ElementsAre("key1")))
+      .WillOnce(Return(
+          std::vector<std::vector<std::pair<std::string, std::string>>>{{
+              {"action", "set_port_and_src_mac"},
+          }}));
+  EXPECT_CALL(mock_app_db_client, batch_del(ElementsAre("key1"))).Times(1);
+  EXPECT_CALL(mock_app_db_client, batch_set(SizeIs(1))).Times(1);
 
   // Nothing goes wrong with the response path itself so we expect it to return
   // okay.
@@ -330,9 +403,11 @@ TEST(ResponseHandlerTest, CleanupAppDbWithADelete) {
   // The failure should invoke a cleanup response for the first key. When
   // checking the AppStateDb we do not return any values which implies the entry
   // did not exist before and the current AppDb entry should be deleted.
-  EXPECT_CALL(mock_state_db_client, get("key0"))
-      .WillOnce(Return(std::vector<std::pair<std::string, std::string>>{}));
-  EXPECT_CALL(mock_app_db_client, del("key0")).Times(1);
+  EXPECT_CALL(mock_state_db_client, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(
+          std::vector<std::vector<std::pair<std::string, std::string>>>(1)));
+  EXPECT_CALL(mock_app_db_client, batch_del(ElementsAre("key0"))).Times(1);
+  EXPECT_CALL(mock_app_db_client, batch_set).Times(0);
 
   // Nothing goes wrong with the response path itself so we expect it to return
   // okay.
@@ -347,6 +422,52 @@ TEST(ResponseHandlerTest, CleanupAppDbWithADelete) {
               )pb"));
 }
 
+TEST(ResponseHandlerTest, CleanupAppDbRestoresEveryFailureTogether) {
+  MockConsumerNotifierAdapter mock_notifier;
+  MockTableAdapter mock_app_db_client;
+  MockTableAdapter mock_state_db_client;
+
+  // The test will wait for a response for 3 keys.
+  pdpi::IrWriteResponse ir_write_response;
+  absl::btree_map<std::string, pdpi::IrUpdateStatus*> key_to_status_map;
+  key_to_status_map["key0"] = ir_write_response.add_statuses();
+  key_to_status_map["key1"] = ir_write_response.add_statuses();
+  key_to_status_map["key2"] = ir_write_response.add_statuses();
+
+  // The first and last keys fail.
+  EXPECT_CALL(mock_notifier, WaitForNotificationAndPop)
+      .WillOnce(DoAll(SetArgReferee<0>(kSwssInternal), SetArgReferee<1>("key0"),
+                      SetArgReferee<2>(GetSwssError("my_error")), Return(true)))
+      .WillOnce(DoAll(SetArgReferee<0>(kSwssSuccess), SetArgReferee<1>("key1"),
+                      SetArgReferee<2>(GetSwssOkResponse()), Return(true)))
+      .WillOnce(DoAll(SetArgReferee<0>(kSwssInternal), SetArgReferee<1>("key2"),
+                      SetArgReferee<2>(GetSwssError("my_error")),
+                      Return(true)));
+
+  // Both failures are read from the AppStateDb, and deleted from the AppDb,
+  // with one request. Only the entry that existed before is rewritten.
+  EXPECT_CALL(mock_state_db_client, batch_get(ElementsAre("key0", "key2")))
+      .WillOnce(Return(
+          std::vector<std::vector<std::pair<std::string, std::string>>>{
+              {},
+              {{"action", "set_port_and_src_mac"}},
+          }));
+  EXPECT_CALL(mock_app_db_client, batch_del(ElementsAre("key0", "key2")))
+      .Times(1);
+  std::vector<swss::KeyOpFieldsValuesTuple> restored;
+  EXPECT_CALL(mock_app_db_client, batch_set)
+      .WillOnce(SaveArg<0>(&restored));
+
+  EXPECT_OK(GetAndProcessResponseNotification(mock_notifier, mock_app_db_client,
+                                              mock_state_db_client,
+                                              key_to_status_map));
+  ASSERT_EQ(restored.size(), 1);
+  EXPECT_EQ(kfvKey(restored[0]), "key2");
+  EXPECT_EQ(ir_write_response.statuses(0).code(), google::rpc::INTERNAL);
+  EXPECT_EQ(ir_write_response.statuses(1).code(), google::rpc::OK);
+  EXPECT_EQ(ir_write_response.statuses(2).code(), google::rpc::INTERNAL);
+}
+
 struct SwssToP4rtErrorMapping {
   std::string swss_error;
   google::rpc::Code p4rt_error;
@@ -370,9 +491,11 @@ TEST_P(ResponseHandlerErrorCodeTest, VerifySwssToGrpcMapping) {
       .WillOnce(DoAll(
           SetArgReferee<0>(GetParam().swss_error), SetArgReferee<1>("key0"),
           SetArgReferee<2>(GetSwssError("my_error")), Return(true)));
-  EXPECT_CALL(mock_state_db_client, get("key0"))
-      .WillOnce(Return(std::vector<std::pair<std::string, std::string>>{}));
-  EXPECT_CALL(mock_app_db_client, del("key0")).Times(1);
+  EXPECT_CALL(mock_state_db_client, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(
+          std::vector<std::vector<std::pair<std::string, std::string>>>(1)));
+  EXPECT_CALL(mock_app_db_client, batch_del(ElementsAre("key0"))).Times(1);
+  EXPECT_CALL(mock_app_db_client, batch_set).Times(0);
 
   EXPECT_OK(GetAndProcessResponseNotification(mock_notifier, mock_app_db_client,
                                               mock_state_db_client,
@@ -13,12 +13,14 @@
 // limitations under the License.
 #include "p4rt_app/sonic/state_verification.h"
 
+#include <iterator>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "absl/container/btree_map.h"
+#include "absl/container/btree_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -31,6 +33,7 @@
 #include "p4rt_app/sonic/adapters/table_adapter.h"
 #include "p4rt_app/sonic/app_db_manager.h"
 #include "p4rt_app/sonic/app_db_to_pdpi_ir_translator.h"
+#include "p4rt_app/sonic/entry_generations.h"
 #include "p4rt_app/sonic/packet_replication_entry_translation.h"
 #include "p4rt_app/sonic/redis_connections.h"
 #include "swss/schema.h"
@@ -89,14 +92,21 @@ struct RedisTable {
   absl::btree_map<std::string, RedisTableEntry> entries;
 };
 
-RedisTable ReadAllEntriesFromRedisTable(TableAdapter& table,
-                                        absl::string_view db_name) {
+RedisTable ReadEntriesFromRedisTable(TableAdapter& table,
+                                     const std::vector<std::string>& table_keys,
+                                     absl::string_view db_name) {
   RedisTable result{.db_name = std::string{db_name}};
-  for (const std::string& table_key : table.keys()) {
+  if (table_keys.empty()) return result;
+
+  // Pipeline the reads instead of paying a Redis round trip for every entry.
+  std::vector<std::vector<std::pair<std::string, std::string>>> table_values =
+      table.batch_get(table_keys);
+  for (int i = 0; i < table_keys.size(); ++i) {
+    const std::string& table_key = table_keys[i];
     RedisTableEntry table_entry;
 
     // Verify that there are no duplicate fields in the table entry.
-    auto redis_values = ListToMap(table.get(table_key));
+    auto redis_values = ListToMap(table_values[i]);
     if (!redis_values.ok()) {
       table_entry.errors =
           absl::StrCat(db_name, " has duplicate fields for key: ", table_key);
@@ -110,6 +120,16 @@ RedisTable ReadAllEntriesFromRedisTable(TableAdapter& table,
   return result;
 }
 
+RedisTable ReadAllEntriesFromRedisTable(TableAdapter& table,
+                                        absl::string_view db_name) {
+  return ReadEntriesFromRedisTable(table, table.keys(), db_name);
+}
+
+absl::btree_set<std::string> ToSet(std::vector<std::string> keys) {
+  return absl::btree_set<std::string>(std::make_move_iterator(keys.begin()),
+                                      std::make_move_iterator(keys.end()));
+}
+
 RedisTable TranslateP4rtIrEntitiesIntoRedisTable(
     const std::vector<pdpi::IrEntity>& ir_entities, absl::string_view db_name,
     const pdpi::IrP4Info& ir_p4_info) {
@@ -239,6 +259,49 @@ std::vector<std::string> VerifyAppStateDbAndAppDbEntries(
       ReadAllEntriesFromRedisTable(app_state_db, "AppStateDb"));
 }
 
+std::vector<std::string> VerifyChangedAppStateDbAndAppDbEntries(
+    TableAdapter& app_state_db, TableAdapter& app_db,
+    EntryGenerations& generations) {
+  // Listing the keys is cheap compared to reading every entry. Any key that is
+  // not in both DBs is always compared so it gets reported.
+  const absl::btree_set<std::string> app_db_keys = ToSet(app_db.keys());
+  const absl::btree_set<std::string> app_state_db_keys =
+      ToSet(app_state_db.keys());
+  std::vector<std::string> changed_app_db_keys;
+  std::vector<std::string> changed_app_state_db_keys;
+  for (const std::string& key : app_db_keys) {
+    if (app_state_db_keys.contains(key) && generations.IsVerified(key)) {
+      continue;
+    }
+    changed_app_db_keys.push_back(key);
+    if (app_state_db_keys.contains(key)) {
+      changed_app_state_db_keys.push_back(key);
+    }
+  }
+  for (const std::string& key : app_state_db_keys) {
+    if (!app_db_keys.contains(key)) changed_app_state_db_keys.push_back(key);
+  }
+
+  RedisTable changed_app_db_entries =
+      ReadEntriesFromRedisTable(app_db, changed_app_db_keys, "AppDb");
+  RedisTable changed_app_state_db_entries = ReadEntriesFromRedisTable(
+      app_state_db, changed_app_state_db_keys, "AppStateDb");
+
+  // Only entries that are in both DBs, and match, are marked as verified.
+  for (const auto& [key, app_db_entry] : changed_app_db_entries.entries) {
+    auto app_state_db_entry = changed_app_state_db_entries.entries.find(key);
+    if (app_state_db_entry == changed_app_state_db_entries.entries.end()) {
+      continue;
+    }
+    if (app_db_entry.errors.empty() &&
+        app_state_db_entry->second.errors.empty() &&
+        app_db_entry.values == app_state_db_entry->second.values) {
+      generations.MarkVerified(key);
+    }
+  }
+  return CompareTables(changed_app_db_entries, changed_app_state_db_entries);
+}
+
 std::vector<std::string> VerifyP4rtTableWithCacheEntities(
     TableAdapter& app_db, const std::vector<pdpi::IrEntity>& ir_entities,
     const pdpi::IrP4Info& ir_p4_info) {
@@ -261,6 +324,47 @@ std::vector<std::string> VerifyP4rtTableWithCacheEntities(
   return failures;
 }
 
+std::vector<std::string> VerifyP4rtTableEntryWithCacheEntity(
+    absl::string_view key,
+    const std::vector<std::pair<std::string, std::string>>& app_db_values,
+    const pdpi::IrTableEntry* cache_entry) {
+  if (app_db_values.empty() && cache_entry == nullptr) return {};
+  if (app_db_values.empty()) {
+    return {absl::StrCat("AppDb is missing key: ", key)};
+  }
+  if (cache_entry == nullptr) {
+    return {absl::StrCat("EntityCache is missing key: ", key)};
+  }
+
+  std::vector<std::string> failures;
+  RedisTableEntry app_db_entry;
+  auto redis_values = ListToMap(app_db_values);
+  if (!redis_values.ok()) {
+    failures.push_back(
+        absl::StrCat("AppDb has duplicate fields for key: ", key));
+  } else {
+    app_db_entry.values = *std::move(redis_values);
+  }
+
+  RedisTableEntry cache_table_entry;
+  auto cache_values = IrTableEntryToAppDbValues(*cache_entry);
+  if (!cache_values.ok()) {
+    failures.push_back(absl::StrCat(
+        "EntityCache entry values could not be translated for key: ", key));
+  } else if (auto cache_map = ListToMap(*cache_values); !cache_map.ok()) {
+    failures.push_back(
+        absl::StrCat("EntityCache has duplicate fields for key: ", key));
+  } else {
+    cache_table_entry.values = *std::move(cache_map);
+  }
+  if (!failures.empty()) return failures;
+
+  std::string error_message = CompareTableEntries(
+      key, "AppDb", app_db_entry, "EntityCache", cache_table_entry);
+  if (!error_message.empty()) failures.push_back(error_message);
+  return failures;
+}
+
 std::vector<std::string> VerifyPacketReplicationWithCacheEntities(
     P4rtTable& p4rt_table,
     const std::vector<pdpi::IrEntity>& cache_ir_entities) {
@@ -14,12 +14,16 @@
 #ifndef PINS_P4RT_APP_SONIC_STATE_VERIFICATION_H_
 #define PINS_P4RT_APP_SONIC_STATE_VERIFICATION_H_
 
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4rt_app/sonic/adapters/table_adapter.h"
+#include "p4rt_app/sonic/entry_generations.h"
 #include "p4rt_app/sonic/packet_replication_entry_translation.h"
 #include "p4rt_app/sonic/redis_connections.h"
 
@@ -35,6 +39,15 @@ namespace sonic {
 std::vector<std::string> VerifyAppStateDbAndAppDbEntries(
     TableAdapter& app_state_db, TableAdapter& app_db);
 
+// Same as VerifyAppStateDbAndAppDbEntries, but only reads the entries that
+// were written since they were last verified, or that are not in both DBs.
+// Entries that match are marked as verified in `generations`. Entries that
+// were changed in Redis without going through the P4RT App are only caught
+// by the full verification.
+std::vector<std::string> VerifyChangedAppStateDbAndAppDbEntries(
+    TableAdapter& app_state_db, TableAdapter& app_db,
+    EntryGenerations& generations);
+
 // Reads all the entries out of a P4RT table, and compares the values to a
 // list of PI TableEntries. Non-P4RT table entries will be ignored.
 //
@@ -44,6 +57,18 @@ std::vector<std::string> VerifyP4rtTableWithCacheEntities(
     TableAdapter& app_db, const std::vector<pdpi::IrEntity>& ir_entities,
     const pdpi::IrP4Info& ir_p4_info);
 
+// Compares a single P4RT_TABLE entry read from the AppDb with the same entry
+// from the entity cache. Empty `app_db_values` means the key is missing from
+// the AppDb, and a nullptr `cache_entry` means it is missing from the cache.
+// Used to verify the P4RT_TABLE a few keys at a time.
+//
+// On success an empty vector is returned. Otherwise, the vector will contain
+// one message for every error found.
+std::vector<std::string> VerifyP4rtTableEntryWithCacheEntity(
+    absl::string_view key,
+    const std::vector<std::pair<std::string, std::string>>& app_db_values,
+    const pdpi::IrTableEntry* cache_entry);
+
 // Reads all the packet replication entries out of the P4RT table and compares
 // the values to a list of PI PacketReplicationEntries.
 // On success, an empty vector is returned.  Otherwise, the vector will contain
@@ -14,6 +14,7 @@
 #include "p4rt_app/sonic/state_verification.h"
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -23,9 +24,11 @@
 #include "google/protobuf/text_format.h"
 #include "gtest/gtest.h"
 #include "gutil/status_matchers.h"
+#include "p4_pdpi/ir.pb.h"
 #include "p4rt_app/sonic/adapters/mock_consumer_notifier_adapter.h"
 #include "p4rt_app/sonic/adapters/mock_notification_producer_adapter.h"
 #include "p4rt_app/sonic/adapters/mock_table_adapter.h"
+#include "p4rt_app/sonic/entry_generations.h"
 #include "p4rt_app/sonic/redis_connections.h"
 
 namespace p4rt_app {
@@ -41,6 +44,7 @@ using ::testing::Return;
 
 using ListOfKeys = std::vector<std::string>;
 using ListOfValues = std::vector<std::pair<std::string, std::string>>;
+using ListOfEntries = std::vector<ListOfValues>;
 
 class StateVerificationPacketReplicationTest : public ::testing::Test {
  protected:
@@ -78,21 +82,15 @@ TEST(StateVerificationTest, VerifyStateMatches) {
   EXPECT_CALL(mock_app_state_db, keys)
       .WillOnce(Return(ListOfKeys{"key0", "key1"}));
 
-  // Because the key0 matches we'll read the full entry from both DBs.
-  EXPECT_CALL(mock_app_db, get("key0"))
-      .WillOnce(
-          Return(ListOfValues{{"field1", "value1"}, {"field0", "value0"}}));
-  EXPECT_CALL(mock_app_state_db, get("key0"))
-      .WillOnce(
-          Return(ListOfValues{{"field0", "value0"}, {"field1", "value1"}}));
-
-  // Because the key1 matches we'll read the full entry from both DBs.
-  EXPECT_CALL(mock_app_db, get("key1"))
-      .WillOnce(
-          Return(ListOfValues{{"field11", "value11"}, {"field10", "value10"}}));
-  EXPECT_CALL(mock_app_state_db, get("key1"))
-      .WillOnce(
-          Return(ListOfValues{{"field10", "value10"}, {"field11", "value11"}}));
+  // Because the keys match we'll read the full entries from both DBs.
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key1", "key0")))
+      .WillOnce(Return(ListOfEntries{
+          ListOfValues{{"field11", "value11"}, {"field10", "value10"}},
+          ListOfValues{{"field1", "value1"}, {"field0", "value0"}}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key0", "key1")))
+      .WillOnce(Return(ListOfEntries{
+          ListOfValues{{"field0", "value0"}, {"field1", "value1"}},
+          ListOfValues{{"field10", "value10"}, {"field11", "value11"}}}));
 
   // Because everything matches the state verification should return no errors.
   EXPECT_THAT(VerifyAppStateDbAndAppDbEntries(mock_app_state_db, mock_app_db),
@@ -105,17 +103,16 @@ TEST(StateVerificationTest, MissingEntryInAppDbFails) {
 
   // Read only 1 key from the AppDb and 2 keys from the AppStateDb.
   EXPECT_CALL(mock_app_db, keys).WillOnce(Return(ListOfKeys{"key1"}));
-  EXPECT_CALL(mock_app_db, get("key1"))
-      .WillOnce(
-          Return(ListOfValues{{"field1", "value1"}, {"field0", "value0"}}));
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key1")))
+      .WillOnce(Return(ListOfEntries{
+          ListOfValues{{"field1", "value1"}, {"field0", "value0"}}}));
 
   EXPECT_CALL(mock_app_state_db, keys)
       .WillOnce(Return(ListOfKeys{"key0", "key1"}));
-  EXPECT_CALL(mock_app_state_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{}}));
-  EXPECT_CALL(mock_app_state_db, get("key1"))
-      .WillOnce(
-          Return(ListOfValues{{"field0", "value0"}, {"field1", "value1"}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key0", "key1")))
+      .WillOnce(Return(ListOfEntries{
+          ListOfValues{{}},
+          ListOfValues{{"field0", "value0"}, {"field1", "value1"}}}));
 
   // Because of the missing key we should return 1 failure.
   EXPECT_THAT(VerifyAppStateDbAndAppDbEntries(mock_app_state_db, mock_app_db),
@@ -128,15 +125,15 @@ TEST(StateVerificationTest, MissingEntryInAppStateDbFails) {
 
   // Read 2 key from the AppDb and only 1 key from the AppStateDb.
   EXPECT_CALL(mock_app_db, keys).WillOnce(Return(ListOfKeys{"key0", "key1"}));
-  EXPECT_CALL(mock_app_db, get("key0")).WillOnce(Return(ListOfValues{{}}));
-  EXPECT_CALL(mock_app_db, get("key1"))
-      .WillOnce(
-          Return(ListOfValues{{"field1", "value1"}, {"field0", "value0"}}));
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key0", "key1")))
+      .WillOnce(Return(ListOfEntries{
+          ListOfValues{{}},
+          ListOfValues{{"field1", "value1"}, {"field0", "value0"}}}));
 
   EXPECT_CALL(mock_app_state_db, keys).WillOnce(Return(ListOfKeys{"key1"}));
-  EXPECT_CALL(mock_app_state_db, get("key1"))
-      .WillOnce(
-          Return(ListOfValues{{"field0", "value0"}, {"field1", "value1"}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key1")))
+      .WillOnce(Return(ListOfEntries{
+          ListOfValues{{"field0", "value0"}, {"field1", "value1"}}}));
 
   // Because of the missing key we should return 1 failure.
   EXPECT_THAT(VerifyAppStateDbAndAppDbEntries(mock_app_state_db, mock_app_db),
@@ -152,11 +149,11 @@ TEST(StateVerificationTest, MissingFieldInAppDbEntryFails) {
   EXPECT_CALL(mock_app_state_db, keys).WillOnce(Return(ListOfKeys{"key0"}));
 
   // However, the AppDb entry has 1 less field value.
-  EXPECT_CALL(mock_app_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{"field1", "value1"}}));
-  EXPECT_CALL(mock_app_state_db, get("key0"))
-      .WillOnce(
-          Return(ListOfValues{{"field0", "value0"}, {"field1", "value1"}}));
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field1", "value1"}}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{
+          ListOfValues{{"field0", "value0"}, {"field1", "value1"}}}));
 
   // Because of the missing field we should return 1 failure.
   EXPECT_THAT(VerifyAppStateDbAndAppDbEntries(mock_app_state_db, mock_app_db),
@@ -172,11 +169,11 @@ TEST(StateVerificationTest, ExtraFieldInAppDbEntryFails) {
   EXPECT_CALL(mock_app_state_db, keys).WillOnce(Return(ListOfKeys{"key0"}));
 
   // However, the AppDb entry has 1 more field value.
-  EXPECT_CALL(mock_app_db, get("key0"))
-      .WillOnce(
-          Return(ListOfValues{{"field0", "value0"}, {"field1", "value1"}}));
-  EXPECT_CALL(mock_app_state_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{"field1", "value1"}}));
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{
+          ListOfValues{{"field0", "value0"}, {"field1", "value1"}}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field1", "value1"}}}));
 
   // Because of the extra field we should return 1 failure.
   EXPECT_THAT(VerifyAppStateDbAndAppDbEntries(mock_app_state_db, mock_app_db),
@@ -192,10 +189,10 @@ TEST(StateVerificationTest, MismatchFieldInEntryFails) {
   EXPECT_CALL(mock_app_state_db, keys).WillOnce(Return(ListOfKeys{"key0"}));
 
   // However, the entries have different fields.
-  EXPECT_CALL(mock_app_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{"field0", "value"}}));
-  EXPECT_CALL(mock_app_state_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{"field1", "value"}}));
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field0", "value"}}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field1", "value"}}}));
 
   // Because of the mismatched field names we should return 1 failure
   EXPECT_THAT(VerifyAppStateDbAndAppDbEntries(mock_app_state_db, mock_app_db),
@@ -211,10 +208,10 @@ TEST(StateVerificationTest, DifferentFieldValuesInEntryFails) {
   EXPECT_CALL(mock_app_state_db, keys).WillOnce(Return(ListOfKeys{"key0"}));
 
   // However, the entries have different values.
-  EXPECT_CALL(mock_app_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{"field", "value0"}}));
-  EXPECT_CALL(mock_app_state_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{"field", "value1"}}));
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field", "value0"}}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field", "value1"}}}));
 
   // Because of the differing field values we should return 1 failure.
   EXPECT_THAT(VerifyAppStateDbAndAppDbEntries(mock_app_state_db, mock_app_db),
@@ -230,10 +227,11 @@ TEST(StateVerificationTest, DuplicateAppDbFieldNameInEntryFails) {
   EXPECT_CALL(mock_app_state_db, keys).WillOnce(Return(ListOfKeys{"key0"}));
 
   // However, the AppDb entry has 2 fields with the same name.
-  EXPECT_CALL(mock_app_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{"field", "value0"}, {"field", "value1"}}));
-  EXPECT_CALL(mock_app_state_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{"field", "value0"}}));
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{
+          ListOfValues{{"field", "value0"}, {"field", "value1"}}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field", "value0"}}}));
 
   // Because of the differing field values we should return 1 failure.
   EXPECT_THAT(VerifyAppStateDbAndAppDbEntries(mock_app_state_db, mock_app_db),
@@ -249,16 +247,154 @@ TEST(StateVerificationTest, DuplicateAppStateDbFieldNameInEntryFails) {
   EXPECT_CALL(mock_app_state_db, keys).WillOnce(Return(ListOfKeys{"key0"}));
 
   // However, the AppStateDb entry has 2 fields with the same name.
-  EXPECT_CALL(mock_app_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{"field", "value0"}}));
-  EXPECT_CALL(mock_app_state_db, get("key0"))
-      .WillOnce(Return(ListOfValues{{"field", "value0"}, {"field", "value1"}}));
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field", "value0"}}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{
+          ListOfValues{{"field", "value0"}, {"field", "value1"}}}));
 
   // Because of the differing field values we should return 1 failure.
   EXPECT_THAT(VerifyAppStateDbAndAppDbEntries(mock_app_state_db, mock_app_db),
               ElementsAre(HasSubstr("AppStateDb has duplicate fields")));
 }
 
+TEST(StateVerificationTest, ChangedEntriesAreReadUntilVerified) {
+  MockTableAdapter mock_app_state_db;
+  MockTableAdapter mock_app_db;
+  EntryGenerations generations;
+
+  EXPECT_CALL(mock_app_db, keys)
+      .WillRepeatedly(Return(ListOfKeys{"key1", "key0"}));
+  EXPECT_CALL(mock_app_state_db, keys)
+      .WillRepeatedly(Return(ListOfKeys{"key0", "key1"}));
+
+  // Nothing has been verified yet so every entry is read.
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key0", "key1")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field", "value0"}},
+                                     ListOfValues{{"field", "value1"}}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key0", "key1")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field", "value0"}},
+                                     ListOfValues{{"field", "value1"}}}));
+  EXPECT_THAT(VerifyChangedAppStateDbAndAppDbEntries(
+                  mock_app_state_db, mock_app_db, generations),
+              IsEmpty());
+
+  // Once verified, only the entries written since are read again.
+  generations.RecordUpdate("key1");
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key1")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field", "value2"}}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key1")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field", "value2"}}}));
+  EXPECT_THAT(VerifyChangedAppStateDbAndAppDbEntries(
+                  mock_app_state_db, mock_app_db, generations),
+              IsEmpty());
+
+  // Clean state is verified without reading any entries.
+  EXPECT_THAT(VerifyChangedAppStateDbAndAppDbEntries(
+                  mock_app_state_db, mock_app_db, generations),
+              IsEmpty());
+}
+
+TEST(StateVerificationTest, ChangedEntriesAreReadUntilTheyMatch) {
+  MockTableAdapter mock_app_state_db;
+  MockTableAdapter mock_app_db;
+  EntryGenerations generations;
+
+  EXPECT_CALL(mock_app_db, keys).WillRepeatedly(Return(ListOfKeys{"key0"}));
+  EXPECT_CALL(mock_app_state_db, keys)
+      .WillRepeatedly(Return(ListOfKeys{"key0"}));
+
+  // A mismatch is reported every time because the entry is never verified.
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key0")))
+      .Times(2)
+      .WillRepeatedly(Return(ListOfEntries{ListOfValues{{"field", "value0"}}}));
+  EXPECT_CALL(mock_app_state_db, batch_get(ElementsAre("key0")))
+      .Times(2)
+      .WillRepeatedly(Return(ListOfEntries{ListOfValues{{"field", "value1"}}}));
+  EXPECT_THAT(VerifyChangedAppStateDbAndAppDbEntries(
+                  mock_app_state_db, mock_app_db, generations),
+              ElementsAre(HasSubstr("do not match")));
+  EXPECT_THAT(VerifyChangedAppStateDbAndAppDbEntries(
+                  mock_app_state_db, mock_app_db, generations),
+              ElementsAre(HasSubstr("do not match")));
+}
+
+TEST(StateVerificationTest, ChangedEntriesReportMissingKeysOfVerifiedEntries) {
+  MockTableAdapter mock_app_state_db;
+  MockTableAdapter mock_app_db;
+  EntryGenerations generations;
+  generations.MarkVerified("key0");
+  generations.MarkVerified("key1");
+
+  // The verified key0 is only in the AppDb, so it is read and reported.
+  EXPECT_CALL(mock_app_db, keys).WillOnce(Return(ListOfKeys{"key0", "key1"}));
+  EXPECT_CALL(mock_app_state_db, keys).WillOnce(Return(ListOfKeys{"key1"}));
+  EXPECT_CALL(mock_app_db, batch_get(ElementsAre("key0")))
+      .WillOnce(Return(ListOfEntries{ListOfValues{{"field", "value0"}}}));
+  EXPECT_THAT(VerifyChangedAppStateDbAndAppDbEntries(
+                  mock_app_state_db, mock_app_db, generations),
+              ElementsAre(HasSubstr("AppStateDb is missing key: key0")));
+}
+
+pdpi::IrTableEntry SetPortEntry(const std::string& port) {
+  pdpi::IrTableEntry entry;
+  entry.set_table_name("table");
+  entry.mutable_action()->set_name("set_port");
+  pdpi::IrActionInvocation::IrActionParam* param =
+      entry.mutable_action()->add_params();
+  param->set_name("port");
+  param->mutable_value()->set_str(port);
+  return entry;
+}
+
+TEST(StateVerificationTest, P4rtTableEntryMatchesCacheEntity) {
+  pdpi::IrTableEntry cache_entry = SetPortEntry("Ethernet0");
+  EXPECT_THAT(VerifyP4rtTableEntryWithCacheEntity(
+                  "FIXED_TABLE:{}",
+                  ListOfValues{{"param/port", "Ethernet0"},
+                               {"action", "set_port"}},
+                  &cache_entry),
+              IsEmpty());
+}
+
+TEST(StateVerificationTest, P4rtTableEntryMissingFromBothIsIgnored) {
+  EXPECT_THAT(VerifyP4rtTableEntryWithCacheEntity("FIXED_TABLE:{}",
+                                                  ListOfValues{}, nullptr),
+              IsEmpty());
+}
+
+TEST(StateVerificationTest, P4rtTableEntryMissingFromOneSideFails) {
+  pdpi::IrTableEntry cache_entry = SetPortEntry("Ethernet0");
+  EXPECT_THAT(VerifyP4rtTableEntryWithCacheEntity("FIXED_TABLE:{}",
+                                                  ListOfValues{}, &cache_entry),
+              ElementsAre(HasSubstr("AppDb is missing key: FIXED_TABLE:{}")));
+  EXPECT_THAT(
+      VerifyP4rtTableEntryWithCacheEntity(
+          "FIXED_TABLE:{}", ListOfValues{{"action", "set_port"}}, nullptr),
+      ElementsAre(HasSubstr("EntityCache is missing key: FIXED_TABLE:{}")));
+}
+
+TEST(StateVerificationTest, P4rtTableEntryWithDifferentValuesFails) {
+  pdpi::IrTableEntry cache_entry = SetPortEntry("Ethernet0");
+  EXPECT_THAT(VerifyP4rtTableEntryWithCacheEntity(
+                  "FIXED_TABLE:{}",
+                  ListOfValues{{"action", "set_port"},
+                               {"param/port", "Ethernet1"}},
+                  &cache_entry),
+              ElementsAre(HasSubstr("do not match")));
+}
+
+TEST(StateVerificationTest, P4rtTableEntryWithDuplicateAppDbFieldsFails) {
+  pdpi::IrTableEntry cache_entry = SetPortEntry("Ethernet0");
+  EXPECT_THAT(VerifyP4rtTableEntryWithCacheEntity(
+                  "FIXED_TABLE:{}",
+                  ListOfValues{{"action", "set_port"},
+                               {"action", "set_port"},
+                               {"param/port", "Ethernet0"}},
+                  &cache_entry),
+              ElementsAre(HasSubstr("AppDb has duplicate fields")));
+}
+
 TEST_F(StateVerificationPacketReplicationTest,
        PacketReplicationEntriesIgnoredByP4rtTable) {
   MockTableAdapter mock_app_db;
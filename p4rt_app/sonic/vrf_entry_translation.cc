@@ -15,6 +15,8 @@
 #include "p4rt_app/sonic/vrf_entry_translation.h"
 
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/container/btree_map.h"
 #include "absl/status/status.h"
@@ -28,7 +30,6 @@
 #include "p4_pdpi/ir.pb.h"
 #include "p4rt_app/sonic/redis_connections.h"
 #include "p4rt_app/sonic/response_handler.h"
-#include "p4rt_app/utils/status_utility.h"
 #include "swss/rediscommand.h"
 
 namespace p4rt_app {
@@ -65,7 +66,8 @@ absl::StatusOr<std::string> GetVrfTableKey(const pdpi::IrTableEntry& entry) {
 }
 
 absl::StatusOr<std::string> InsertVrfTableEntry(
-    VrfTable& vrf_table, const pdpi::IrTableEntry& entry) {
+    VrfTable& vrf_table, const pdpi::IrTableEntry& entry,
+    std::vector<swss::KeyOpFieldsValuesTuple>& vrf_updates) {
   VLOG(2) << "Insert PDPI IR entry: " << entry.ShortDebugString();
   ASSIGN_OR_RETURN(std::string key, GetVrfTableKey(entry));
 
@@ -78,12 +80,17 @@ absl::StatusOr<std::string> InsertVrfTableEntry(
   }
 
   VLOG(1) << "Insert VRF_TABLE entry: " << key;
-  vrf_table.producer_state->set(key, GetVrfValues());
+  swss::KeyOpFieldsValuesTuple key_value;
+  kfvKey(key_value) = key;
+  kfvOp(key_value) = "SET";
+  kfvFieldsValues(key_value) = GetVrfValues();
+  vrf_updates.push_back(std::move(key_value));
   return key;
 }
 
 absl::StatusOr<std::string> DeleteVrfTableEntry(
-    VrfTable& vrf_table, const pdpi::IrTableEntry& entry) {
+    VrfTable& vrf_table, const pdpi::IrTableEntry& entry,
+    std::vector<swss::KeyOpFieldsValuesTuple>& vrf_updates) {
   VLOG(2) << "Delete PDPI IR entry: " << entry.ShortDebugString();
   ASSIGN_OR_RETURN(std::string key, GetVrfTableKey(entry));
 
@@ -96,45 +103,56 @@ absl::StatusOr<std::string> DeleteVrfTableEntry(
   }
 
   VLOG(1) << "Delete VRF_TABLE entry: " << key;
-  vrf_table.producer_state->del(key);
+  swss::KeyOpFieldsValuesTuple key_value;
+  kfvKey(key_value) = key;
+  kfvOp(key_value) = "DEL";
+  vrf_updates.push_back(std::move(key_value));
   return key;
 }
 
 }  // namespace
 
-absl::Status UpdateAppDbVrfTable(VrfTable& vrf_table,
-                                 p4::v1::Update::Type update_type,
-                                 int rpc_index, const pdpi::IrTableEntry& entry,
-                                 pdpi::IrWriteResponse& response) {
-  absl::StatusOr<std::string> update_key;
+absl::StatusOr<std::string> CreateAppDbVrfTableUpdate(
+    VrfTable& vrf_table, p4::v1::Update::Type update_type,
+    const pdpi::IrTableEntry& entry,
+    std::vector<swss::KeyOpFieldsValuesTuple>& vrf_updates) {
   switch (update_type) {
     case p4::v1::Update::INSERT:
-      update_key = InsertVrfTableEntry(vrf_table, entry);
-      break;
+      return InsertVrfTableEntry(vrf_table, entry, vrf_updates);
     case p4::v1::Update::MODIFY:
-      update_key = gutil::InvalidArgumentErrorBuilder()
-                   << "Modifing VRF_TABLE entries is not allowed.";
-      break;
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Modifing VRF_TABLE entries is not allowed.";
     case p4::v1::Update::DELETE:
-      update_key = DeleteVrfTableEntry(vrf_table, entry);
-      break;
+      return DeleteVrfTableEntry(vrf_table, entry, vrf_updates);
     default:
-      update_key = gutil::InvalidArgumentErrorBuilder()
-                   << "Unsupported update type: " << update_type;
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unsupported update type: " << update_type;
   }
+}
 
-  if (update_key.ok()) {
-    ASSIGN_OR_RETURN(*response.mutable_statuses(rpc_index),
-                     GetAndProcessResponseNotification(
-                         *vrf_table.notification_consumer, *vrf_table.app_db,
-                         *vrf_table.app_state_db, *update_key));
-  } else {
-    LOG(WARNING) << "Could not update in AppDb: " << update_key.status();
-    *response.mutable_statuses(rpc_index) =
-        GetIrUpdateStatus(update_key.status());
+absl::Status UpdateAppDbVrfTable(
+    VrfTable& vrf_table,
+    const std::vector<swss::KeyOpFieldsValuesTuple>& vrf_updates,
+    absl::btree_map<std::string, pdpi::IrUpdateStatus*>& status_by_key) {
+  if (vrf_updates.empty()) return absl::OkStatus();
+
+  std::vector<swss::KeyOpFieldsValuesTuple> sets;
+  std::vector<std::string> deletes;
+  for (const swss::KeyOpFieldsValuesTuple& update : vrf_updates) {
+    if (kfvOp(update) == "DEL") {
+      deletes.push_back(kfvKey(update));
+    } else {
+      sets.push_back(update);
+    }
   }
-
-  return absl::OkStatus();
+  if (!sets.empty()) vrf_table.producer_state->batch_set(sets);
+  if (!deletes.empty()) vrf_table.producer_state->batch_del(deletes);
+
+  absl::Status status = GetAndProcessResponseNotification(
+      *vrf_table.notification_consumer, *vrf_table.app_db,
+      *vrf_table.app_state_db, status_by_key);
+  vrf_table.generations->RecordUpdates(vrf_updates);
+  return status;
 }
 
 absl::StatusOr<std::vector<pdpi::IrTableEntry>> GetAllAppDbVrfTableEntries(
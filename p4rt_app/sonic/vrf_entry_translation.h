@@ -14,6 +14,10 @@
 #ifndef PINS_P4RT_APP_SONIC_VRF_ENTRY_TRANSLATION_H_
 #define PINS_P4RT_APP_SONIC_VRF_ENTRY_TRANSLATION_H_
 
+#include <string>
+#include <vector>
+
+#include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -21,17 +25,28 @@
 #include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4rt_app/sonic/redis_connections.h"
+#include "swss/rediscommand.h"
 
 namespace p4rt_app {
 namespace sonic {
 
-// Takes a list of AppDb updates (i.e. inserts, modifies, or deletes) and
-// translates them so that they are consumable by the AppDb. It will also
-// create, or remove, any VRF IDs as needed.
-absl::Status UpdateAppDbVrfTable(VrfTable& vrf_table,
-                                 p4::v1::Update::Type update_type,
-                                 int rpc_index, const pdpi::IrTableEntry& entry,
-                                 pdpi::IrWriteResponse& response);
+// Translates a VRF_TABLE update (i.e. insert or delete) so that it is
+// consumable by the AppDb, and appends it to `vrf_updates`. Also verifies that
+// the entry can be inserted (i.e. doesn't already exist) or deleted (i.e.
+// already exists). Nothing is written to the AppDb. On success the VRF_TABLE
+// key is returned.
+absl::StatusOr<std::string> CreateAppDbVrfTableUpdate(
+    VrfTable& vrf_table, p4::v1::Update::Type update_type,
+    const pdpi::IrTableEntry& entry,
+    std::vector<swss::KeyOpFieldsValuesTuple>& vrf_updates);
+
+// Writes a batch of VRF_TABLE updates into the AppDb, and then waits for an
+// OrchAgent response for every key in `status_by_key`. Any failed update is
+// reverted in the AppDb.
+absl::Status UpdateAppDbVrfTable(
+    VrfTable& vrf_table,
+    const std::vector<swss::KeyOpFieldsValuesTuple>& vrf_updates,
+    absl::btree_map<std::string, pdpi::IrUpdateStatus*>& status_by_key);
 
 // Returns all the VRF_TABLE entries currently installed in the AppDb. This does
 // not include any entries that are currently being handled by the lower layers
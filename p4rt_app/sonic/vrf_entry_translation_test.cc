@@ -13,8 +13,11 @@
 // limitations under the License.
 #include "p4rt_app/sonic/vrf_entry_translation.h"
 
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "gmock/gmock.h"
@@ -29,6 +32,7 @@
 #include "p4rt_app/sonic/adapters/mock_producer_state_table_adapter.h"
 #include "p4rt_app/sonic/adapters/mock_table_adapter.h"
 #include "p4rt_app/sonic/redis_connections.h"
+#include "swss/rediscommand.h"
 
 namespace p4rt_app {
 namespace sonic {
@@ -37,9 +41,10 @@ namespace {
 using ::google::protobuf::TextFormat;
 using ::gutil::EqualsProto;
 using ::gutil::IsOkAndHolds;
-using ::testing::_;
+using ::gutil::StatusIs;
 using ::testing::DoAll;
-using ::testing::Eq;
+using ::testing::IsEmpty;
+using ::testing::ResultOf;
 using ::testing::Return;
 using ::testing::SetArgReferee;
 using ::testing::UnorderedElementsAre;
@@ -73,106 +78,100 @@ class VrfEntryTranslationTest : public ::testing::Test {
   VrfTable vrf_table_;
 };
 
-TEST_F(VrfEntryTranslationTest, InsertVrfEntry) {
+pdpi::IrTableEntry VrfEntry(const std::string& vrf_id) {
   pdpi::IrTableEntry table_entry;
-  ASSERT_TRUE(TextFormat::ParseFromString(R"pb(matches {
-                                                 name: "vrf_id"
-                                                 exact { str: "vrf-1" }
-                                               })pb",
-                                          &table_entry));
+  auto* match = table_entry.add_matches();
+  match->set_name("vrf_id");
+  match->mutable_exact()->set_str(vrf_id);
+  return table_entry;
+}
+
+auto SuccessfulResponse(const std::string& key) {
+  return DoAll(SetArgReferee<0>("SWSS_RC_SUCCESS"), SetArgReferee<1>(key),
+               SetArgReferee<2>(std::vector<swss::FieldValueTuple>(
+                   {swss::FieldValueTuple("err_str", "Ok")})),
+               Return(true));
+}
 
-  EXPECT_CALL(*mock_vrf_producer_state_, set(Eq("vrf-1"), _)).Times(1);
+TEST_F(VrfEntryTranslationTest, InsertVrfEntry) {
+  std::vector<swss::KeyOpFieldsValuesTuple> vrf_updates;
+  EXPECT_THAT(CreateAppDbVrfTableUpdate(vrf_table_, p4::v1::Update::INSERT,
+                                        VrfEntry("vrf-1"), vrf_updates),
+              IsOkAndHolds("vrf-1"));
+  ASSERT_EQ(vrf_updates.size(), 1);
+  EXPECT_EQ(kfvKey(vrf_updates[0]), "vrf-1");
+  EXPECT_EQ(kfvOp(vrf_updates[0]), "SET");
+  EXPECT_THAT(kfvFieldsValues(vrf_updates[0]),
+              UnorderedElementsAre(std::make_pair("v4", "true"),
+                                   std::make_pair("v6", "true"),
+                                   std::make_pair("sync_mode", "true")));
+
+  EXPECT_CALL(*mock_vrf_producer_state_, batch_set(vrf_updates)).Times(1);
+  EXPECT_CALL(*mock_vrf_producer_state_, batch_del).Times(0);
   EXPECT_CALL(*mock_vrf_notifier_, WaitForNotificationAndPop)
-      .WillOnce(DoAll(SetArgReferee<0>("SWSS_RC_SUCCESS"),
-                      SetArgReferee<1>("vrf-1"),
-                      SetArgReferee<2>(std::vector<swss::FieldValueTuple>(
-                          {swss::FieldValueTuple("err_str", "Ok")})),
-                      Return(true)));
+      .WillOnce(SuccessfulResponse("vrf-1"));
 
   pdpi::IrWriteResponse response;
-  response.add_statuses();
-  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, p4::v1::Update::INSERT,
-                                /*rpc_index=*/0, table_entry, response));
+  absl::btree_map<std::string, pdpi::IrUpdateStatus*> status_by_key = {
+      {"vrf-1", response.add_statuses()}};
+  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, vrf_updates, status_by_key));
   EXPECT_EQ(response.statuses(0).code(), google::rpc::Code::OK);
 }
 
 TEST_F(VrfEntryTranslationTest, CannotInsertDuplicateVrfEntry) {
-  pdpi::IrTableEntry table_entry;
-  ASSERT_TRUE(TextFormat::ParseFromString(R"pb(matches {
-                                                 name: "vrf_id"
-                                                 exact { str: "vrf-1" }
-                                               })pb",
-                                          &table_entry));
-
   // When checking for existance we return `true`. Then because it already
   // exists we should not try to add a VRF entry.
   EXPECT_CALL(*mock_vrf_app_db_, exists("vrf-1")).WillOnce(Return(true));
-  EXPECT_CALL(*mock_vrf_producer_state_, set).Times(0);
 
-  pdpi::IrWriteResponse response;
-  response.add_statuses();
-  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, p4::v1::Update::INSERT,
-                                /*rpc_index=*/0, table_entry, response));
-  EXPECT_EQ(response.statuses(0).code(), google::rpc::Code::ALREADY_EXISTS);
+  std::vector<swss::KeyOpFieldsValuesTuple> vrf_updates;
+  EXPECT_THAT(CreateAppDbVrfTableUpdate(vrf_table_, p4::v1::Update::INSERT,
+                                        VrfEntry("vrf-1"), vrf_updates),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+  EXPECT_THAT(vrf_updates, IsEmpty());
 }
 
 TEST_F(VrfEntryTranslationTest, DeleteVrfEntry) {
-  pdpi::IrTableEntry table_entry;
-  ASSERT_TRUE(TextFormat::ParseFromString(R"pb(matches {
-                                                 name: "vrf_id"
-                                                 exact { str: "vrf-1" }
-                                               })pb",
-                                          &table_entry));
-
   EXPECT_CALL(*mock_vrf_app_db_, exists("vrf-1")).WillOnce(Return(true));
-  EXPECT_CALL(*mock_vrf_producer_state_, del(Eq("vrf-1"))).Times(1);
+
+  std::vector<swss::KeyOpFieldsValuesTuple> vrf_updates;
+  EXPECT_THAT(CreateAppDbVrfTableUpdate(vrf_table_, p4::v1::Update::DELETE,
+                                        VrfEntry("vrf-1"), vrf_updates),
+              IsOkAndHolds("vrf-1"));
+  ASSERT_EQ(vrf_updates.size(), 1);
+  EXPECT_EQ(kfvOp(vrf_updates[0]), "DEL");
+
+  EXPECT_CALL(*mock_vrf_producer_state_, batch_set).Times(0);
+  EXPECT_CALL(*mock_vrf_producer_state_,
+              batch_del(std::vector<std::string>{"vrf-1"}))
+      .Times(1);
   EXPECT_CALL(*mock_vrf_notifier_, WaitForNotificationAndPop)
-      .WillOnce(DoAll(SetArgReferee<0>("SWSS_RC_SUCCESS"),
-                      SetArgReferee<1>("vrf-1"),
-                      SetArgReferee<2>(std::vector<swss::FieldValueTuple>(
-                          {swss::FieldValueTuple("err_str", "Ok")})),
-                      Return(true)));
+      .WillOnce(SuccessfulResponse("vrf-1"));
 
   pdpi::IrWriteResponse response;
-  response.add_statuses();
-  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, p4::v1::Update::DELETE,
-                                /*rpc_index=*/0, table_entry, response));
+  absl::btree_map<std::string, pdpi::IrUpdateStatus*> status_by_key = {
+      {"vrf-1", response.add_statuses()}};
+  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, vrf_updates, status_by_key));
   EXPECT_EQ(response.statuses(0).code(), google::rpc::Code::OK);
 }
 
 TEST_F(VrfEntryTranslationTest, CannotDeleteMissingVrfEntry) {
-  pdpi::IrTableEntry table_entry;
-  ASSERT_TRUE(TextFormat::ParseFromString(R"pb(matches {
-                                                 name: "vrf_id"
-                                                 exact { str: "vrf-1" }
-                                               })pb",
-                                          &table_entry));
-
   // When checking for existance we return `false`. Then because the entry does
   // not exist we should not try to delete it.
   EXPECT_CALL(*mock_vrf_app_db_, exists("vrf-1")).WillOnce(Return(false));
-  EXPECT_CALL(*mock_vrf_producer_state_, del).Times(0);
 
-  pdpi::IrWriteResponse response;
-  response.add_statuses();
-  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, p4::v1::Update::DELETE,
-                                /*rpc_index=*/0, table_entry, response));
-  EXPECT_EQ(response.statuses(0).code(), google::rpc::Code::NOT_FOUND);
+  std::vector<swss::KeyOpFieldsValuesTuple> vrf_updates;
+  EXPECT_THAT(CreateAppDbVrfTableUpdate(vrf_table_, p4::v1::Update::DELETE,
+                                        VrfEntry("vrf-1"), vrf_updates),
+              StatusIs(absl::StatusCode::kNotFound));
+  EXPECT_THAT(vrf_updates, IsEmpty());
 }
 
 TEST_F(VrfEntryTranslationTest, ModifyVrfEntryIsNotAllowed) {
-  pdpi::IrTableEntry table_entry;
-  ASSERT_TRUE(TextFormat::ParseFromString(R"pb(matches {
-                                                 name: "vrf_id"
-                                                 exact { str: "vrf-1" }
-                                               })pb",
-                                          &table_entry));
-
-  pdpi::IrWriteResponse response;
-  response.add_statuses();
-  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, p4::v1::Update::MODIFY,
-                                /*rpc_index=*/0, table_entry, response));
-  EXPECT_EQ(response.statuses(0).code(), google::rpc::INVALID_ARGUMENT);
+  std::vector<swss::KeyOpFieldsValuesTuple> vrf_updates;
+  EXPECT_THAT(CreateAppDbVrfTableUpdate(vrf_table_, p4::v1::Update::MODIFY,
+                                        VrfEntry("vrf-1"), vrf_updates),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(vrf_updates, IsEmpty());
 }
 
 TEST_F(VrfEntryTranslationTest, RequireVrfIdMatchField) {
@@ -183,43 +182,70 @@ TEST_F(VrfEntryTranslationTest, RequireVrfIdMatchField) {
                                                })pb",
                                           &table_entry));
 
-  pdpi::IrWriteResponse response;
-  response.add_statuses();
-  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, p4::v1::Update::INSERT,
-                                /*rpc_index=*/0, table_entry, response));
-  EXPECT_EQ(response.statuses(0).code(), google::rpc::INVALID_ARGUMENT);
+  std::vector<swss::KeyOpFieldsValuesTuple> vrf_updates;
+  EXPECT_THAT(CreateAppDbVrfTableUpdate(vrf_table_, p4::v1::Update::INSERT,
+                                        table_entry, vrf_updates),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(vrf_updates, IsEmpty());
 }
 
-TEST_F(VrfEntryTranslationTest, CannotChangeTheSonicDefaultVrf) {
-  pdpi::IrTableEntry table_entry;
-  ASSERT_TRUE(TextFormat::ParseFromString(R"pb(matches {
-                                                 name: "invalid_name"
-                                                 exact { str: "" }
-                                               })pb",
-                                          &table_entry));
+TEST_F(VrfEntryTranslationTest, CannotTouchSonicDefaultVrf) {
+  std::vector<swss::KeyOpFieldsValuesTuple> vrf_updates;
+  EXPECT_THAT(CreateAppDbVrfTableUpdate(vrf_table_, p4::v1::Update::INSERT,
+                                        VrfEntry(""), vrf_updates),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(vrf_updates, IsEmpty());
+}
+
+TEST_F(VrfEntryTranslationTest, VrfUpdatesAreSentAsOneBatch) {
+  EXPECT_CALL(*mock_vrf_app_db_, exists("vrf-1")).WillOnce(Return(false));
+  EXPECT_CALL(*mock_vrf_app_db_, exists("vrf-2")).WillOnce(Return(false));
+  EXPECT_CALL(*mock_vrf_app_db_, exists("vrf-3")).WillOnce(Return(true));
+
+  std::vector<swss::KeyOpFieldsValuesTuple> vrf_updates;
+  ASSERT_OK(CreateAppDbVrfTableUpdate(vrf_table_, p4::v1::Update::INSERT,
+                                      VrfEntry("vrf-1"), vrf_updates));
+  ASSERT_OK(CreateAppDbVrfTableUpdate(vrf_table_, p4::v1::Update::INSERT,
+                                      VrfEntry("vrf-2"), vrf_updates));
+  ASSERT_OK(CreateAppDbVrfTableUpdate(vrf_table_, p4::v1::Update::DELETE,
+                                      VrfEntry("vrf-3"), vrf_updates));
+
+  // All inserts go in one request, and all deletes in another. Then every
+  // response is handled together.
+  EXPECT_CALL(*mock_vrf_producer_state_,
+              batch_set(ResultOf(
+                  [](const std::vector<swss::KeyOpFieldsValuesTuple>& values) {
+                    return values.size();
+                  },
+                  2)))
+      .Times(1);
+  EXPECT_CALL(*mock_vrf_producer_state_,
+              batch_del(std::vector<std::string>{"vrf-3"}))
+      .Times(1);
+  EXPECT_CALL(*mock_vrf_notifier_, WaitForNotificationAndPop)
+      .WillOnce(SuccessfulResponse("vrf-1"))
+      .WillOnce(SuccessfulResponse("vrf-3"))
+      .WillOnce(SuccessfulResponse("vrf-2"));
 
   pdpi::IrWriteResponse response;
-  response.add_statuses();
-  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, p4::v1::Update::INSERT,
-                                /*rpc_index=*/0, table_entry, response));
-  EXPECT_EQ(response.statuses(0).code(), google::rpc::INVALID_ARGUMENT);
+  absl::btree_map<std::string, pdpi::IrUpdateStatus*> status_by_key = {
+      {"vrf-1", response.add_statuses()},
+      {"vrf-2", response.add_statuses()},
+      {"vrf-3", response.add_statuses()},
+  };
+  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, vrf_updates, status_by_key));
+  for (const auto& status : response.statuses()) {
+    EXPECT_EQ(status.code(), google::rpc::Code::OK);
+  }
 }
 
-TEST_F(VrfEntryTranslationTest, CannotTouchSonicDefaultVrf) {
-  pdpi::IrTableEntry table_entry;
-  ASSERT_TRUE(TextFormat::ParseFromString(R"pb(matches {
-                                                 name: "vrf_id"
-                                                 exact { str: "" }
-                                               })pb",
-                                          &table_entry));
-
-  EXPECT_CALL(*mock_vrf_producer_state_, set).Times(0);
+TEST_F(VrfEntryTranslationTest, EmptyBatchDoesNothing) {
+  EXPECT_CALL(*mock_vrf_producer_state_, batch_set).Times(0);
+  EXPECT_CALL(*mock_vrf_producer_state_, batch_del).Times(0);
+  EXPECT_CALL(*mock_vrf_notifier_, WaitForNotificationAndPop).Times(0);
 
-  pdpi::IrWriteResponse response;
-  response.add_statuses();
-  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, p4::v1::Update::INSERT,
-                                /*rpc_index=*/0, table_entry, response));
-  EXPECT_EQ(response.statuses(0).code(), google::rpc::Code::INVALID_ARGUMENT);
+  absl::btree_map<std::string, pdpi::IrUpdateStatus*> status_by_key;
+  EXPECT_OK(UpdateAppDbVrfTable(vrf_table_, {}, status_by_key));
 }
 
 }  // namespace
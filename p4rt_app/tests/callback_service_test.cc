@@ -0,0 +1,172 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "gmock/gmock.h"
+#include "grpcpp/security/credentials.h"
+#include "grpcpp/support/status.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/p4_runtime_session.h"
+#include "p4rt_app/p4runtime/p4runtime_impl.h"
+#include "p4rt_app/tests/lib/p4runtime_grpc_service.h"
+#include "p4rt_app/tests/lib/p4runtime_request_helpers.h"
+#include "sai_p4/instantiations/google/instantiations.h"
+#include "sai_p4/instantiations/google/sai_p4info.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+
+// The P4RT service served through the gRPC callback API should behave exactly
+// like the sync service.
+class CallbackServiceTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_OK(p4rt_service_.GetP4rtServer().UpdateDeviceId(device_id_));
+    ASSERT_OK_AND_ASSIGN(p4rt_session_, CreateSession(/*election_id=*/2));
+    ASSERT_OK(pdpi::SetMetadataAndSetForwardingPipelineConfig(
+        p4rt_session_.get(),
+        p4::v1::SetForwardingPipelineConfigRequest::RECONCILE_AND_COMMIT,
+        sai::GetP4Info(sai::Instantiation::kMiddleblock)));
+  }
+
+  absl::StatusOr<std::unique_ptr<pdpi::P4RuntimeSession>> CreateSession(
+      uint64_t election_id, bool error_if_not_primary = true) {
+    const std::string address =
+        absl::StrCat("localhost:", p4rt_service_.GrpcPort());
+    auto stub =
+        pdpi::CreateP4RuntimeStub(address, grpc::InsecureChannelCredentials());
+    return pdpi::P4RuntimeSession::Create(
+        std::move(stub), device_id_,
+        pdpi::P4RuntimeSessionOptionalArgs{
+            .election_id = absl::MakeUint128(0, election_id)},
+        error_if_not_primary);
+  }
+
+  test_lib::P4RuntimeGrpcService p4rt_service_ =
+      test_lib::P4RuntimeGrpcService(P4RuntimeImplOptions{},
+                                     /*callback_service_threads=*/2);
+  std::unique_ptr<pdpi::P4RuntimeSession> p4rt_session_;
+  uint64_t device_id_ = 100401;
+};
+
+TEST_F(CallbackServiceTest, WriteAndReadEntries) {
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::WriteRequest request,
+      test_lib::IrWriteRequestToPi(
+          R"pb(
+            updates {
+              type: INSERT
+              entity {
+                table_entry {
+                  table_name: "vrf_table"
+                  matches {
+                    name: "vrf_id"
+                    exact { str: "vrf-0" }
+                  }
+                  action { name: "no_action" }
+                }
+              }
+            })pb",
+          sai::GetIrP4Info(sai::Instantiation::kMiddleblock)));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), request));
+
+  p4::v1::ReadRequest read_request;
+  read_request.add_entities()->mutable_table_entry();
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::ReadResponse read_response,
+      pdpi::SetMetadataAndSendPiReadRequest(p4rt_session_.get(), read_request));
+  ASSERT_EQ(read_response.entities_size(), 1);
+  EXPECT_THAT(read_response.entities(0),
+              EqualsProto(request.updates(0).entity()));
+}
+
+TEST_F(CallbackServiceTest, GetForwardingPipelineConfig) {
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::GetForwardingPipelineConfigResponse response,
+      pdpi::GetForwardingPipelineConfig(p4rt_session_.get()));
+  EXPECT_THAT(response.config().p4info(),
+              EqualsProto(sai::GetP4Info(sai::Instantiation::kMiddleblock)));
+}
+
+TEST_F(CallbackServiceTest, BackupIsRejectedAndLearnsAboutThePrimary) {
+  ASSERT_OK_AND_ASSIGN(
+      auto backup,
+      CreateSession(/*election_id=*/1, /*error_if_not_primary=*/false));
+
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::WriteRequest request,
+      test_lib::IrWriteRequestToPi(
+          R"pb(
+            updates {
+              type: INSERT
+              entity {
+                table_entry {
+                  table_name: "vrf_table"
+                  matches {
+                    name: "vrf_id"
+                    exact { str: "vrf-0" }
+                  }
+                  action { name: "no_action" }
+                }
+              }
+            })pb",
+          sai::GetIrP4Info(sai::Instantiation::kMiddleblock)));
+  EXPECT_THAT(pdpi::SetMetadataAndSendPiWriteRequest(backup.get(), request),
+              StatusIs(absl::StatusCode::kPermissionDenied));
+
+  // Once the primary disconnects the backup is told there is no primary.
+  ASSERT_OK(p4rt_session_->Finish());
+  p4::v1::StreamMessageResponse response;
+  ASSERT_TRUE(backup->StreamChannelRead(response));
+  EXPECT_EQ(response.arbitration().status().code(), grpc::StatusCode::NOT_FOUND)
+      << response.ShortDebugString();
+}
+
+TEST_F(CallbackServiceTest, SendsPacketInsToThePrimary) {
+  ASSERT_OK(p4rt_service_.GetP4rtServer().AddPacketIoPort("Ethernet1/1/0"));
+  ASSERT_OK(p4rt_service_.GetP4rtServer().AddPortTranslation("Ethernet1/1/0",
+                                                             "0"));
+  ASSERT_OK(p4rt_service_.GetFakePacketIoInterface().PushPacketIn(
+      "Ethernet1/1/0", "Ethernet1/1/0", "test packet"));
+
+  EXPECT_THAT(p4rt_session_->ReadStreamChannelResponsesAndFinish(),
+              IsOkAndHolds(ElementsAre(EqualsProto(R"pb(
+                packet {
+                  payload: "test packet"
+                  metadata { metadata_id: 1 value: "0" }
+                  metadata { metadata_id: 2 value: "0" }
+                }
+              )pb"))));
+}
+
+}  // namespace
+}  // namespace p4rt_app
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include <string>
+#include <vector>
 
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -19,14 +20,27 @@
 #include "grpcpp/support/status.h"
 #include "gtest/gtest.h"
 #include "gutil/io.h"
+#include "gutil/proto.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/p4_runtime_session.h"
+#include "p4rt_app/p4runtime/entity_cache.h"
+#include "p4rt_app/p4runtime/entity_cache_snapshot.h"
 #include "p4rt_app/p4runtime/p4runtime_impl.h"
 #include "p4rt_app/tests/lib/p4runtime_component_test_fixture.h"
 #include "p4rt_app/tests/lib/p4runtime_grpc_service.h"
+#include "p4rt_app/tests/lib/p4runtime_request_helpers.h"
 #include "sai_p4/instantiations/google/instantiations.h"
 
 namespace p4rt_app {
 namespace {
 
+using ::gutil::EqualsProto;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
 class DebugDataDumpTest : public test_lib::P4RuntimeComponentTestFixture {
  protected:
   DebugDataDumpTest()
@@ -45,5 +59,80 @@ TEST_F(DebugDataDumpTest, VerifyDebugDumpPacketIoCountersToCorrectFile) {
   ASSERT_FALSE(packetio_debugs.empty());
 }
 
+TEST_F(DebugDataDumpTest, DumpsTheP4InfoAndEntityCache) {
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest request,
+                       test_lib::PdWriteRequestToPi(
+                           R"pb(
+                             updates {
+                               type: INSERT
+                               table_entry {
+                                 vrf_table_entry {
+                                   match { vrf_id: "vrf-1" }
+                                   action { no_action {} }
+                                 }
+                               }
+                             }
+                           )pb",
+                           ir_p4_info_));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), request));
+
+  std::string temp_dir = testing::TempDir();
+  EXPECT_OK(p4rt_service_.GetP4rtServer().DumpDebugData(temp_dir, "alert"));
+
+  p4::config::v1::P4Info p4info;
+  ASSERT_OK(gutil::ReadProtoFromFile(temp_dir + "/p4info.txt", &p4info));
+  EXPECT_THAT(p4info, EqualsProto(p4_info_));
+
+  ASSERT_OK_AND_ASSIGN(std::vector<std::string> entities,
+                       gutil::ReadFileLines(temp_dir + "/entity_cache.txt"));
+  EXPECT_THAT(entities, ElementsAre(HasSubstr("vrf-1")));
+
+  ASSERT_OK_AND_ASSIGN(
+      EntityCache entity_cache,
+      ReadEntityCacheSnapshot(temp_dir + "/entity_cache.bin",
+                              EntityCacheSnapshotHeader{}));
+  EXPECT_EQ(entity_cache.size(), 1);
+}
+
+TEST_F(DebugDataDumpTest, DumpsTheRuntimeIntrospection) {
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest request,
+                       test_lib::PdWriteRequestToPi(
+                           R"pb(
+                             updates {
+                               type: INSERT
+                               table_entry {
+                                 vrf_table_entry {
+                                   match { vrf_id: "vrf-1" }
+                                   action { no_action {} }
+                                 }
+                               }
+                             }
+                           )pb",
+                           ir_p4_info_));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), request));
+
+  RuntimeIntrospection introspection =
+      p4rt_service_.GetP4rtServer().GetRuntimeIntrospection();
+  EXPECT_EQ(introspection.write_latency.total.count(), 1);
+  EXPECT_GT(introspection.server_state_lock.acquisitions, 0);
+  EXPECT_GT(introspection.controller_manager_lock.acquisitions, 0);
+  EXPECT_EQ(introspection.write_admission.outstanding_batches, 0);
+
+  std::string temp_dir = testing::TempDir();
+  EXPECT_OK(p4rt_service_.GetP4rtServer().DumpDebugData(temp_dir, "alert"));
+  ASSERT_OK_AND_ASSIGN(std::string report,
+                       gutil::ReadFile(temp_dir + "/runtime_introspection"));
+  EXPECT_THAT(report, HasSubstr("server_state_lock: acquisitions: "));
+  EXPECT_THAT(report, HasSubstr("table vrf_table:"));
+
+  // Reading the introspection does not reset the flow programming statistics.
+  ASSERT_OK_AND_ASSIGN(
+      FlowProgrammingStatistics stats,
+      p4rt_service_.GetP4rtServer().GetFlowProgrammingStatistics());
+  EXPECT_EQ(stats.write_batch_count, 1);
+}
+
 }  // namespace
 }  // namespace p4rt_app
@@ -14,6 +14,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>  // NOLINT: third_party code.
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -21,9 +22,13 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "gmock/gmock.h"
+#include "grpcpp/client_context.h"
 #include "grpcpp/security/credentials.h"
 #include "gtest/gtest.h"
 #include "gutil/proto.h"
@@ -36,6 +41,7 @@
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
 #include "p4_pdpi/pd.h"
+#include "p4rt_app/p4runtime/p4runtime_impl.h"
 #include "p4rt_app/tests/lib/app_db_entry_builder.h"
 #include "p4rt_app/tests/lib/p4runtime_component_test_fixture.h"
 #include "p4rt_app/tests/lib/p4runtime_grpc_service.h"
@@ -50,6 +56,7 @@ namespace {
 using ::gutil::EqualsProto;
 using ::gutil::IsOkAndHolds;
 using ::gutil::StatusIs;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::UnorderedElementsAreArray;
 
@@ -61,6 +68,133 @@ class FixedL3TableTest : public test_lib::P4RuntimeComponentTestFixture {
             sai::Instantiation::kMiddleblock) {}
 };
 
+// Uses a tiny read response budget so every entity gets its own response.
+class FixedL3TableSmallReadResponseTest
+    : public test_lib::P4RuntimeComponentTestFixture {
+ protected:
+  FixedL3TableSmallReadResponseTest()
+      : test_lib::P4RuntimeComponentTestFixture(
+            sai::Instantiation::kMiddleblock,
+            P4RuntimeImplOptions{.read_response_max_bytes = 1}) {}
+};
+
+// Uses extra threads to translate large write requests.
+class FixedL3TableParallelTranslationTest
+    : public test_lib::P4RuntimeComponentTestFixture {
+ protected:
+  FixedL3TableParallelTranslationTest()
+      : test_lib::P4RuntimeComponentTestFixture(
+            sai::Instantiation::kMiddleblock,
+            P4RuntimeImplOptions{.write_translation_threads = 3}) {}
+
+  // Returns a request that inserts `count` neighbor entries. If
+  // `duplicate_last_entry` is set then the last update will be a copy of the
+  // first.
+  absl::StatusOr<p4::v1::WriteRequest> NeighborInserts(
+      int count, bool duplicate_last_entry = false) {
+    std::string updates;
+    for (int i = 0; i < count; ++i) {
+      int id = (duplicate_last_entry && i == count - 1) ? 1 : i + 1;
+      absl::StrAppend(
+          &updates, absl::Substitute(R"pb(
+                                       updates {
+                                         type: INSERT
+                                         table_entry {
+                                           neighbor_table_entry {
+                                             match {
+                                               neighbor_id: "fe80::$0"
+                                               router_interface_id: "1"
+                                             }
+                                             action {
+                                               set_dst_mac {
+                                                 dst_mac: "00:1a:11:17:5f:80"
+                                               }
+                                             }
+                                           }
+                                         }
+                                       }
+                                     )pb",
+                                     id));
+    }
+    return test_lib::PdWriteRequestToPi(updates, ir_p4_info_);
+  }
+};
+
+// Uses extra threads to serve large read requests.
+class FixedL3TableParallelReadTest
+    : public test_lib::P4RuntimeComponentTestFixture {
+ protected:
+  FixedL3TableParallelReadTest()
+      : test_lib::P4RuntimeComponentTestFixture(
+            sai::Instantiation::kMiddleblock,
+            P4RuntimeImplOptions{.read_threads = 3}) {}
+};
+
+// Coalesces Write requests that arrive within 50ms of each other.
+class FixedL3TableWriteCoalescingTest
+    : public test_lib::P4RuntimeComponentTestFixture {
+ protected:
+  FixedL3TableWriteCoalescingTest()
+      : test_lib::P4RuntimeComponentTestFixture(
+            sai::Instantiation::kMiddleblock,
+            P4RuntimeImplOptions{
+                .write_coalescing_window = absl::Milliseconds(50)}) {}
+
+  // Returns a request with one update, of the given type, for each neighbor.
+  absl::StatusOr<p4::v1::WriteRequest> NeighborUpdates(
+      absl::string_view type, const std::vector<int>& neighbor_ids,
+      absl::string_view dst_mac = "00:1a:11:17:5f:80") {
+    std::string updates;
+    for (int id : neighbor_ids) {
+      absl::StrAppend(
+          &updates, absl::Substitute(R"pb(
+                                       updates {
+                                         type: $0
+                                         table_entry {
+                                           neighbor_table_entry {
+                                             match {
+                                               neighbor_id: "fe80::$1"
+                                               router_interface_id: "1"
+                                             }
+                                             action {
+                                               set_dst_mac { dst_mac: "$2" }
+                                             }
+                                           }
+                                         }
+                                       }
+                                     )pb",
+                                     type, id, dst_mac));
+    }
+    return test_lib::PdWriteRequestToPi(updates, ir_p4_info_);
+  }
+
+  // Sends `first` and, shortly after, `second` so that they are coalesced.
+  // Returns the status of each request.
+  std::pair<absl::Status, absl::Status> SendConcurrently(
+      const p4::v1::WriteRequest& first, const p4::v1::WriteRequest& second) {
+    absl::Status first_status;
+    std::thread first_thread([&] {
+      first_status =
+          pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), first);
+    });
+    absl::SleepFor(absl::Milliseconds(10));
+    absl::Status second_status =
+        pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), second);
+    first_thread.join();
+    return {first_status, second_status};
+  }
+
+  absl::StatusOr<std::vector<p4::v1::Entity>> ReadEntities() {
+    p4::v1::ReadRequest read_request;
+    read_request.add_entities()->mutable_table_entry();
+    ASSIGN_OR_RETURN(p4::v1::ReadResponse read_response,
+                     pdpi::SetMetadataAndSendPiReadRequest(p4rt_session_.get(),
+                                                           read_request));
+    return std::vector<p4::v1::Entity>(read_response.entities().begin(),
+                                       read_response.entities().end());
+  }
+};
+
 TEST_F(FixedL3TableTest, SupportRouterInterfaceTableFlows) {
   ASSERT_OK(p4rt_service_.GetP4rtServer().AddPortTranslation("Ethernet4", "2"));
 
@@ -359,6 +493,162 @@ TEST_F(FixedL3TableTest, MissingActionWhenRequiredFails) {
       StatusIs(absl::StatusCode::kUnknown, HasSubstr("#1: INVALID_ARGUMENT")));
 }
 
+TEST_F(FixedL3TableTest, ReadCanBeScopedToASingleTable) {
+  ASSERT_OK(p4rt_service_.GetP4rtServer().AddPortTranslation("Ethernet4", "2"));
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest request,
+                       test_lib::PdWriteRequestToPi(
+                           R"pb(
+                             updates {
+                               type: INSERT
+                               table_entry {
+                                 router_interface_table_entry {
+                                   match { router_interface_id: "16" }
+                                   action {
+                                     set_port_and_src_mac {
+                                       port: "2"
+                                       src_mac: "00:02:03:04:05:06"
+                                     }
+                                   }
+                                 }
+                               }
+                             }
+                             updates {
+                               type: INSERT
+                               table_entry {
+                                 router_interface_table_entry {
+                                   match { router_interface_id: "17" }
+                                   action {
+                                     set_port_and_src_mac {
+                                       port: "2"
+                                       src_mac: "00:02:03:04:05:07"
+                                     }
+                                   }
+                                 }
+                               }
+                             }
+                             updates {
+                               type: INSERT
+                               table_entry {
+                                 neighbor_table_entry {
+                                   match {
+                                     neighbor_id: "fe80::21a:11ff:fe17:5f80"
+                                     router_interface_id: "16"
+                                   }
+                                   action {
+                                     set_dst_mac { dst_mac: "00:1a:11:17:5f:80" }
+                                   }
+                                 }
+                               }
+                             }
+                           )pb",
+                           ir_p4_info_));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), request));
+
+  // Only the router interface entries should be returned.
+  const p4::v1::TableEntry& router_interface_entry =
+      request.updates(0).entity().table_entry();
+  p4::v1::ReadRequest read_request;
+  read_request.add_entities()->mutable_table_entry()->set_table_id(
+      router_interface_entry.table_id());
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::ReadResponse read_response,
+      pdpi::SetMetadataAndSendPiReadRequest(p4rt_session_.get(), read_request));
+  EXPECT_EQ(read_response.entities_size(), 2);
+
+  // The table scoped read can be further filtered by match fields.
+  *read_request.mutable_entities(0)->mutable_table_entry()->add_match() =
+      router_interface_entry.match(0);
+  ASSERT_OK_AND_ASSIGN(
+      read_response,
+      pdpi::SetMetadataAndSendPiReadRequest(p4rt_session_.get(), read_request));
+  ASSERT_EQ(read_response.entities_size(), 1);
+  EXPECT_THAT(read_response.entities(0),
+              EqualsProto(request.updates(0).entity()));
+}
+
+TEST_F(FixedL3TableTest, ReadCanBeScopedToASingleEntry) {
+  ASSERT_OK(p4rt_service_.GetP4rtServer().AddPortTranslation("Ethernet4", "2"));
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest request,
+                       test_lib::PdWriteRequestToPi(
+                           R"pb(
+                             updates {
+                               type: INSERT
+                               table_entry {
+                                 router_interface_table_entry {
+                                   match { router_interface_id: "16" }
+                                   action {
+                                     set_port_and_src_mac {
+                                       port: "2"
+                                       src_mac: "00:02:03:04:05:06"
+                                     }
+                                   }
+                                 }
+                               }
+                             }
+                             updates {
+                               type: INSERT
+                               table_entry {
+                                 neighbor_table_entry {
+                                   match {
+                                     neighbor_id: "fe80::21a:11ff:fe17:5f80"
+                                     router_interface_id: "16"
+                                   }
+                                   action {
+                                     set_dst_mac { dst_mac: "00:1a:11:17:5f:80" }
+                                   }
+                                 }
+                               }
+                             }
+                             updates {
+                               type: INSERT
+                               table_entry {
+                                 neighbor_table_entry {
+                                   match {
+                                     neighbor_id: "fe80::21a:11ff:fe17:5f81"
+                                     router_interface_id: "16"
+                                   }
+                                   action {
+                                     set_dst_mac { dst_mac: "00:1a:11:17:5f:81" }
+                                   }
+                                 }
+                               }
+                             }
+                           )pb",
+                           ir_p4_info_));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), request));
+
+  // Reading an entry by its full key only returns that entry.
+  p4::v1::ReadRequest read_request;
+  p4::v1::TableEntry& filter =
+      *read_request.add_entities()->mutable_table_entry();
+  filter = request.updates(1).entity().table_entry();
+  filter.clear_action();
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::ReadResponse read_response,
+      pdpi::SetMetadataAndSendPiReadRequest(p4rt_session_.get(), read_request));
+  ASSERT_EQ(read_response.entities_size(), 1);
+  EXPECT_THAT(read_response.entities(0),
+              EqualsProto(request.updates(1).entity()));
+
+  // An entry that does not exist returns nothing.
+  ASSERT_OK(pdpi::ClearEntities(*p4rt_session_));
+  ASSERT_OK_AND_ASSIGN(
+      read_response,
+      pdpi::SetMetadataAndSendPiReadRequest(p4rt_session_.get(), read_request));
+  EXPECT_EQ(read_response.entities_size(), 0);
+}
+
+TEST_F(FixedL3TableTest, ReadWithMatchFilterRequiresATableId) {
+  p4::v1::ReadRequest read_request;
+  read_request.add_entities()->mutable_table_entry()->add_match()->set_field_id(
+      1);
+  EXPECT_THAT(
+      pdpi::SetMetadataAndSendPiReadRequest(p4rt_session_.get(), read_request),
+      StatusIs(absl::StatusCode::kUnknown, HasSubstr("table ID")));
+}
+
 // Ensure we can program each of the L3 flow actions.
 class L3LpmTableTest : public FixedL3TableTest,
                        public testing::WithParamInterface<std::string> {
@@ -506,5 +796,247 @@ INSTANTIATE_TEST_SUITE_P(PerAction, L3LpmTableTest,
                            return info.param;
                          });
 
+TEST_F(FixedL3TableSmallReadResponseTest,
+       ReadsAreStreamedInMultipleResponses) {
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest request,
+                       test_lib::PdWriteRequestToPi(
+                           R"pb(
+                             updates {
+                               type: INSERT
+                               table_entry {
+                                 neighbor_table_entry {
+                                   match {
+                                     neighbor_id: "fe80::21a:11ff:fe17:5f80"
+                                     router_interface_id: "1"
+                                   }
+                                   action {
+                                     set_dst_mac { dst_mac: "00:1a:11:17:5f:80" }
+                                   }
+                                 }
+                               }
+                             }
+                             updates {
+                               type: INSERT
+                               table_entry {
+                                 neighbor_table_entry {
+                                   match {
+                                     neighbor_id: "fe80::21a:11ff:fe17:5f81"
+                                     router_interface_id: "1"
+                                   }
+                                   action {
+                                     set_dst_mac { dst_mac: "00:1a:11:17:5f:81" }
+                                   }
+                                 }
+                               }
+                             }
+                           )pb",
+                           ir_p4_info_));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), request));
+
+  // Read with a raw stub so we can see each individual response.
+  auto stub = pdpi::CreateP4RuntimeStub(
+      absl::StrCat("localhost:", p4rt_service_.GrpcPort()),
+      grpc::InsecureChannelCredentials());
+  p4::v1::ReadRequest read_request;
+  read_request.set_device_id(device_id_);
+  read_request.add_entities()->mutable_table_entry();
+
+  grpc::ClientContext context;
+  auto reader = stub->Read(&context, read_request);
+  std::vector<p4::v1::ReadResponse> responses;
+  p4::v1::ReadResponse response;
+  while (reader->Read(&response)) {
+    responses.push_back(response);
+  }
+  ASSERT_OK(gutil::GrpcStatusToAbslStatus(reader->Finish()));
+
+  // Each entity exceeds the budget on its own, so each is sent separately.
+  ASSERT_EQ(responses.size(), 2);
+  EXPECT_EQ(responses[0].entities_size(), 1);
+  EXPECT_EQ(responses[1].entities_size(), 1);
+}
+
+TEST_F(FixedL3TableSmallReadResponseTest, EmptyReadStillSendsOneResponse) {
+  auto stub = pdpi::CreateP4RuntimeStub(
+      absl::StrCat("localhost:", p4rt_service_.GrpcPort()),
+      grpc::InsecureChannelCredentials());
+  p4::v1::ReadRequest read_request;
+  read_request.set_device_id(device_id_);
+  read_request.add_entities()->mutable_table_entry();
+
+  grpc::ClientContext context;
+  auto reader = stub->Read(&context, read_request);
+  int response_count = 0;
+  p4::v1::ReadResponse response;
+  while (reader->Read(&response)) {
+    ++response_count;
+    EXPECT_EQ(response.entities_size(), 0);
+  }
+  ASSERT_OK(gutil::GrpcStatusToAbslStatus(reader->Finish()));
+  EXPECT_EQ(response_count, 1);
+}
+
+TEST_F(FixedL3TableParallelTranslationTest, LargeBatchIsProgrammed) {
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest request, NeighborInserts(500));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), request));
+
+  p4::v1::ReadRequest read_request;
+  read_request.add_entities()->mutable_table_entry();
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::ReadResponse read_response,
+      pdpi::SetMetadataAndSendPiReadRequest(p4rt_session_.get(), read_request));
+  EXPECT_EQ(read_response.entities_size(), request.updates_size());
+}
+
+TEST_F(FixedL3TableParallelTranslationTest,
+       DuplicateInLargeBatchRejectsTheWholeRequest) {
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::WriteRequest request,
+      NeighborInserts(500, /*duplicate_last_entry=*/true));
+  EXPECT_THAT(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), request),
+      StatusIs(absl::StatusCode::kUnknown,
+               HasSubstr("Found duplicated key in the same batch request")));
+
+  p4::v1::ReadRequest read_request;
+  read_request.add_entities()->mutable_table_entry();
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::ReadResponse read_response,
+      pdpi::SetMetadataAndSendPiReadRequest(p4rt_session_.get(), read_request));
+  EXPECT_EQ(read_response.entities_size(), 0);
+}
+
+TEST_F(FixedL3TableParallelReadTest, LargeReadReturnsEveryEntry) {
+  // Enough entries to be split into several shards.
+  std::string updates;
+  for (int i = 1; i <= 2500; ++i) {
+    absl::StrAppend(
+        &updates, absl::Substitute(R"pb(
+                                     updates {
+                                       type: INSERT
+                                       table_entry {
+                                         neighbor_table_entry {
+                                           match {
+                                             neighbor_id: "fe80::$0"
+                                             router_interface_id: "1"
+                                           }
+                                           action {
+                                             set_dst_mac {
+                                               dst_mac: "00:1a:11:17:5f:80"
+                                             }
+                                           }
+                                         }
+                                       }
+                                     }
+                                   )pb",
+                                   i));
+  }
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest request,
+                       test_lib::PdWriteRequestToPi(updates, ir_p4_info_));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), request));
+
+  p4::v1::ReadRequest read_request;
+  read_request.add_entities()->mutable_table_entry();
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::ReadResponse read_response,
+      pdpi::SetMetadataAndSendPiReadRequest(p4rt_session_.get(), read_request));
+  std::set<std::string> expected_entities;
+  for (const p4::v1::Update& update : request.updates()) {
+    expected_entities.insert(update.entity().ShortDebugString());
+  }
+  std::set<std::string> read_entities;
+  for (const p4::v1::Entity& entity : read_response.entities()) {
+    read_entities.insert(entity.ShortDebugString());
+  }
+  EXPECT_EQ(read_response.entities_size(), request.updates_size());
+  EXPECT_EQ(read_entities, expected_entities);
+}
+
+TEST_F(FixedL3TableWriteCoalescingTest, SequentialRequestsAreProgrammed) {
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest insert,
+                       NeighborUpdates("INSERT", {1, 2}));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), insert));
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest remove,
+                       NeighborUpdates("DELETE", {1}));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), remove));
+
+  ASSERT_OK_AND_ASSIGN(std::vector<p4::v1::Entity> entities, ReadEntities());
+  EXPECT_EQ(entities.size(), 1);
+}
+
+TEST_F(FixedL3TableWriteCoalescingTest, DeleteCancelsOutConcurrentInsert) {
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest insert,
+                       NeighborUpdates("INSERT", {1, 2}));
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest remove,
+                       NeighborUpdates("DELETE", {1}));
+  auto [insert_status, remove_status] = SendConcurrently(insert, remove);
+  EXPECT_OK(insert_status);
+  EXPECT_OK(remove_status);
+
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest expected,
+                       NeighborUpdates("INSERT", {2}));
+  EXPECT_THAT(ReadEntities(),
+              IsOkAndHolds(ElementsAre(
+                  EqualsProto(expected.updates(0).entity()))));
+}
+
+TEST_F(FixedL3TableWriteCoalescingTest, LastOfConcurrentModifiesIsKept) {
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest insert,
+                       NeighborUpdates("INSERT", {1}));
+  ASSERT_OK(
+      pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(), insert));
+
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::WriteRequest first_modify,
+      NeighborUpdates("MODIFY", {1}, /*dst_mac=*/"00:00:00:00:00:01"));
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::WriteRequest second_modify,
+      NeighborUpdates("MODIFY", {1}, /*dst_mac=*/"00:00:00:00:00:02"));
+  auto [first_status, second_status] =
+      SendConcurrently(first_modify, second_modify);
+  EXPECT_OK(first_status);
+  EXPECT_OK(second_status);
+
+  EXPECT_THAT(ReadEntities(),
+              IsOkAndHolds(ElementsAre(
+                  EqualsProto(second_modify.updates(0).entity()))));
+}
+
+TEST_F(FixedL3TableWriteCoalescingTest,
+       DependentRequestIsProgrammedAfterTheEarlierOne) {
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest insert,
+                       NeighborUpdates("INSERT", {1}));
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::WriteRequest modify,
+      NeighborUpdates("MODIFY", {1}, /*dst_mac=*/"00:00:00:00:00:02"));
+  auto [insert_status, modify_status] = SendConcurrently(insert, modify);
+  EXPECT_OK(insert_status);
+  EXPECT_OK(modify_status);
+
+  EXPECT_THAT(ReadEntities(),
+              IsOkAndHolds(ElementsAre(
+                  EqualsProto(modify.updates(0).entity()))));
+}
+
+TEST_F(FixedL3TableWriteCoalescingTest, FailuresOnlyAffectTheirOwnRequest) {
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest bad_modify,
+                       NeighborUpdates("MODIFY", {1}));
+  ASSERT_OK_AND_ASSIGN(p4::v1::WriteRequest insert,
+                       NeighborUpdates("INSERT", {2}));
+  auto [modify_status, insert_status] = SendConcurrently(bad_modify, insert);
+  EXPECT_THAT(modify_status,
+              StatusIs(absl::StatusCode::kUnknown, HasSubstr("#1: NOT_FOUND")));
+  EXPECT_OK(insert_status);
+
+  EXPECT_THAT(ReadEntities(),
+              IsOkAndHolds(ElementsAre(
+                  EqualsProto(insert.updates(0).entity()))));
+}
+
 }  // namespace
 }  // namespace p4rt_app
@@ -44,6 +44,7 @@
 #include "p4rt_app/p4runtime/p4runtime_impl.h"
 #include "p4rt_app/tests/lib/app_db_entry_builder.h"
 #include "p4rt_app/tests/lib/p4runtime_grpc_service.h"
+#include "p4rt_app/tests/lib/p4runtime_request_helpers.h"
 #include "sai_p4/instantiations/google/clos_stage.h"
 #include "sai_p4/instantiations/google/instantiations.h"
 #include "sai_p4/instantiations/google/sai_p4info.h"
@@ -65,6 +66,7 @@ using ::testing::ExplainMatchResult;
 using ::testing::IsEmpty;
 using ::testing::Key;
 using ::testing::Not;
+using ::testing::Pair;
 
 MATCHER_P2(TimeIsBetween, start, end,
            absl::StrCat("Has a value between '", absl::FormatTime(start),
@@ -148,7 +150,8 @@ class ForwardingPipelineConfigTest : public testing::Test {
     }
   }
 
-  absl::Status ResetGrpcServerAndClient() {
+  absl::Status ResetGrpcServerAndClient(
+      bool commit_saved_config_at_startup = false) {
     uint64_t device_id = 100500;
 
     // The P4RT service will wait for the client to close before stopping.
@@ -159,6 +162,7 @@ class ForwardingPipelineConfigTest : public testing::Test {
     p4rt_service_ =
         std::make_unique<test_lib::P4RuntimeGrpcService>(P4RuntimeImplOptions{
             .forwarding_config_full_path = config_save_path_,
+            .commit_saved_config_at_startup = commit_saved_config_at_startup,
         });
     RETURN_IF_ERROR(p4rt_service_->GetP4rtServer().UpdateDeviceId(device_id));
 
@@ -416,6 +420,40 @@ TEST_F(CommitTest, GoesCriticalIfReadingCacheFails) {
               swss::ComponentState::kError); 
 }*/
 
+TEST_F(CommitTest, CommitsSavedConfigAtStartup) {
+  p4::v1::ForwardingPipelineConfig expected_config;
+  *expected_config.mutable_p4info() =
+      sai::GetP4Info(sai::Instantiation::kMiddleblock);
+  ASSERT_OK(SaveConfigFile(expected_config));
+
+  // Arbitration is served before the saved config has been committed.
+  ASSERT_OK(ResetGrpcServerAndClient(/*commit_saved_config_at_startup=*/true));
+  auto p4rt_entry =
+      test_lib::AppDbEntryBuilder{}
+          .SetTableName("FIXED_NEIGHBOR_TABLE")
+          .AddMatchField("neighbor_id", "fe80::21a:11ff:fe17:5f80")
+          .AddMatchField("router_interface_id", "1")
+          .SetAction("set_dst_mac")
+          .AddActionParam("dst_mac", "00:1a:11:17:5f:80");
+  p4rt_service_->GetP4rtAppDbTable().InsertTableEntry(
+      p4rt_entry.GetKey(), p4rt_entry.GetValueList());
+  p4rt_service_->GetVrfAppDbTable().InsertTableEntry("vrf-0", {});
+  ASSERT_OK(p4rt_service_->GetP4rtServer().CommitSavedPipelineConfig());
+
+  GetForwardingPipelineConfigRequest get_request;
+  get_request.set_device_id(p4rt_session_->DeviceId());
+  ASSERT_OK_AND_ASSIGN(GetForwardingPipelineConfigResponse get_response,
+                       p4rt_session_->GetForwardingPipelineConfig(get_request));
+  EXPECT_THAT(get_response.config(), EqualsProto(expected_config));
+
+  p4::v1::ReadRequest read_request;
+  read_request.set_device_id(p4rt_session_->DeviceId());
+  read_request.add_entities()->mutable_table_entry();
+  ASSERT_OK_AND_ASSIGN(p4::v1::ReadResponse read_response,
+                       p4rt_session_->Read(read_request));
+  EXPECT_EQ(read_response.entities_size(), 2);
+}
+
 TEST_F(CommitTest, FailsIfNoConfigHasBeenSaved) {
   // If the file exists before this test for any reason then this test is
   // pointless.
@@ -509,6 +547,66 @@ TEST_F(ReconcileAndCommitTest, ModifiedConfigPushIsUnimplemented) {
               StatusIs(absl::StatusCode::kUnimplemented));
 }
 
+// Sets the size of a table in the P4Info.
+void SetTableSize(p4::config::v1::P4Info& p4info, absl::string_view alias,
+                  int64_t size) {
+  for (auto& table : *p4info.mutable_tables()) {
+    if (table.preamble().alias() == alias) table.set_size(size);
+  }
+}
+
+TEST_F(ReconcileAndCommitTest, ModifiedAclTableIsRepublished) {
+  auto request = GetBasicForwardingRequest();
+  request.set_action(SetForwardingPipelineConfigRequest::RECONCILE_AND_COMMIT);
+  *request.mutable_config()->mutable_p4info() =
+      sai::GetP4Info(sai::Instantiation::kMiddleblock);
+  ASSERT_OK(p4rt_session_->SetForwardingPipelineConfig(request));
+
+  SetTableSize(*request.mutable_config()->mutable_p4info(),
+               "acl_pre_ingress_table", 17);
+  ASSERT_OK(p4rt_session_->SetForwardingPipelineConfig(request));
+
+  EXPECT_THAT(p4rt_service_->GetP4rtAppDbTable().ReadTableEntry(
+                  "ACL_TABLE_DEFINITION_TABLE:ACL_ACL_PRE_INGRESS_TABLE"),
+              IsOkAndHolds(Contains(Pair("size", "17"))));
+  EXPECT_THAT(GetSavedConfig(), IsOkAndHolds(EqualsProto(request.config())));
+}
+
+TEST_F(ReconcileAndCommitTest, CannotModifyAclTableWithEntries) {
+  auto request = GetBasicForwardingRequest();
+  request.set_action(SetForwardingPipelineConfigRequest::RECONCILE_AND_COMMIT);
+  *request.mutable_config()->mutable_p4info() =
+      sai::GetP4Info(sai::Instantiation::kMiddleblock);
+  ASSERT_OK(p4rt_session_->SetForwardingPipelineConfig(request));
+
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::WriteRequest write_request,
+      test_lib::PdWriteRequestToPi(
+          R"pb(
+            updates {
+              type: INSERT
+              table_entry {
+                acl_pre_ingress_table_entry {
+                  match {
+                    is_ipv4 { value: "0x1" }
+                    dst_ip { value: "10.0.0.1" mask: "255.255.255.255" }
+                  }
+                  priority: 2000
+                  action { set_vrf { vrf_id: "vrf-1" } }
+                }
+              }
+            }
+          )pb",
+          sai::GetIrP4Info(sai::Instantiation::kMiddleblock)));
+  ASSERT_OK(pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(),
+                                                   write_request));
+
+  SetTableSize(*request.mutable_config()->mutable_p4info(),
+               "acl_pre_ingress_table", 17);
+  EXPECT_THAT(p4rt_session_->SetForwardingPipelineConfig(request),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
 using GetForwardingConfigTest = ForwardingPipelineConfigTest;
 
 TEST_F(GetForwardingConfigTest, ReturnsNothingIfConfigHasNotBeenSet) {
@@ -25,6 +25,7 @@
 #include "grpcpp/security/server_credentials.h"
 #include "grpcpp/server.h"
 #include "grpcpp/server_builder.h"
+#include "p4rt_app/p4runtime/p4runtime_callback_service.h"
 #include "p4rt_app/p4runtime/p4runtime_impl.h"
 #include "p4rt_app/sonic/adapters/fake_consumer_notifier_adapter.h"
 #include "p4rt_app/sonic/adapters/fake_notification_producer_adapter.h"
@@ -34,6 +35,7 @@
 #include "p4rt_app/sonic/adapters/fake_warm_boot_state_adapter.h"
 #include "p4rt_app/sonic/fake_packetio_interface.h"
 #include "p4rt_app/sonic/redis_connections.h"
+#include "p4rt_app/utils/task_executor.h"
 //TODO(PINS): Add Component/System state Translator
 // #include "swss/fakes/fake_component_state_helper.h"
 // #include "swss/fakes/fake_system_state_helper.h"
@@ -41,7 +43,8 @@
 namespace p4rt_app {
 namespace test_lib {
 
-P4RuntimeGrpcService::P4RuntimeGrpcService(const P4RuntimeImplOptions& options)
+P4RuntimeGrpcService::P4RuntimeGrpcService(const P4RuntimeImplOptions& options,
+                                           int callback_service_threads)
     : fake_vrf_state_table_("AppStateDb:VRF_TABLE"),
       fake_hash_state_table_("AppStateDb:HASH_TABLE"),
       fake_switch_state_table_("AppStateDb:SWITCH_TABLE"),
@@ -164,7 +167,15 @@ P4RuntimeGrpcService::P4RuntimeGrpcService(const P4RuntimeImplOptions& options)
   // Finally start the gRPC service.
   grpc::ServerBuilder builder;
   builder.AddListeningPort(server_address, creds);
-  builder.RegisterService(p4runtime_server_.get());
+  if (callback_service_threads > 0) {
+    callback_executor_ =
+        std::make_unique<TaskExecutor>(callback_service_threads);
+    callback_service_ = std::make_unique<P4RuntimeCallbackService>(
+        *p4runtime_server_, *callback_executor_);
+    builder.RegisterService(callback_service_.get());
+  } else {
+    builder.RegisterService(p4runtime_server_.get());
+  }
   std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
 
   LOG(INFO) << "Server listening on " << server_address;
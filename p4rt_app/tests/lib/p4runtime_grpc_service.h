@@ -17,10 +17,12 @@
 #include <memory>
 
 #include "grpcpp/server.h"
+#include "p4rt_app/p4runtime/p4runtime_callback_service.h"
 #include "p4rt_app/p4runtime/p4runtime_impl.h"
 #include "p4rt_app/sonic/adapters/fake_sonic_db_table.h"
 #include "p4rt_app/sonic/adapters/fake_warm_boot_state_adapter.h"
 #include "p4rt_app/sonic/fake_packetio_interface.h"
+#include "p4rt_app/utils/task_executor.h"
 //TODO(PINS):
 // #include "swss/fakes/fake_component_state_helper.h"
 // #include "swss/fakes/fake_system_state_helper.h"
@@ -30,7 +32,11 @@ namespace test_lib {
 
 class P4RuntimeGrpcService {
  public:
-  explicit P4RuntimeGrpcService(const P4RuntimeImplOptions& options);
+  // If `callback_service_threads` is set the server is registered through the
+  // gRPC callback API, with that many handler threads, instead of as a sync
+  // service.
+  explicit P4RuntimeGrpcService(const P4RuntimeImplOptions& options,
+                                int callback_service_threads = 0);
   ~P4RuntimeGrpcService();
 
   absl::Status VerifyState();
@@ -113,6 +119,10 @@ class P4RuntimeGrpcService {
   // gRPC server faking the P4RT App for testing.
   std::unique_ptr<grpc::Server> server_;
   std::unique_ptr<P4RuntimeImpl> p4runtime_server_;
+
+  // Only set when serving with the callback API.
+  std::unique_ptr<TaskExecutor> callback_executor_;
+  std::unique_ptr<P4RuntimeCallbackService> callback_service_;
 };
 
 }  // namespace test_lib
@@ -329,6 +329,38 @@ TEST_F(FakePacketIoTest, VerifyPacketOut) {
   EXPECT_EQ(counters.packet_out_errors, 0);
 }
 
+TEST_F(FakePacketIoTest, PacketOutUsesUpdatedPortTranslation) {
+  ASSERT_OK(pdpi::SetMetadataAndSetForwardingPipelineConfig(
+      p4rt_session_.get(),
+      p4::v1::SetForwardingPipelineConfigRequest::RECONCILE_AND_COMMIT,
+      sai::GetP4Info(sai::Instantiation::kMiddleblock)));
+  ASSERT_OK(AddPacketIoPort("Ethernet1/1/0", "0"));
+  ASSERT_OK(
+      p4rt_service_.GetP4rtServer().AddPortTranslation("Ethernet1/1/0", "7"));
+  EXPECT_OK(SendPacketOut(7, "test packet",
+                          sai::GetIrP4Info(sai::Instantiation::kMiddleblock)));
+
+  absl::StatusOr<std::vector<std::string>> packets_or;
+  // Retry for a few times with delay since it takes a few msecs for the
+  // PacketOut to reach the P4RT server.
+  for (int i = 0; i < 10; i++) {
+    packets_or = p4rt_service_.GetFakePacketIoInterface().VerifyPacketOut(
+        "Ethernet1/1/0");
+    if (!packets_or.ok() || packets_or->empty()) {
+      absl::SleepFor(absl::Seconds(2));
+    } else {
+      break;
+    }
+  }
+  ASSERT_OK(packets_or);
+  EXPECT_EQ(*packets_or, std::vector<std::string>({"test packet"}));
+
+  sonic::PacketIoCounters counters =
+      p4rt_service_.GetP4rtServer().GetPacketIoCounters();
+  EXPECT_EQ(counters.packet_out_sent, 1);
+  EXPECT_EQ(counters.packet_out_errors, 0);
+}
+
 TEST_F(FakePacketIoTest, VerifyPacketInWithPortNames) {
   ASSERT_OK(pdpi::SetMetadataAndSetForwardingPipelineConfig(
       p4rt_session_.get(),
@@ -20,6 +20,7 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/time/time.h"
 #include "glog/logging.h"
 #include "gmock/gmock.h"
@@ -48,7 +49,8 @@ void PrintTo(const FlowProgrammingStatistics& stats, std::ostream* os) {
       << ", write_requests_count:" << stats.write_requests_count
       << ", write_time:" << stats.write_time
       << ", read_request_count:" << stats.read_request_count
-      << ", read_time:" << stats.read_time;
+      << ", read_time:" << stats.read_time
+      << ", write_latency_count:" << stats.write_latency.total.count();
 }
 
 namespace {
@@ -59,12 +61,24 @@ using ::gutil::IsOkAndHolds;
 using ::gutil::StatusIs;
 using ::testing::_;
 using ::testing::AllOf;
+using ::testing::Contains;
 using ::testing::FieldsAre;
 using ::testing::HasSubstr;
+using ::testing::Key;
 using ::testing::Not;
+using ::testing::Pair;
 using ::testing::UnorderedElementsAre;
 using ::testing::UnorderedElementsAreArray;
 
+// Every stage of a write is recorded once per batch.
+MATCHER_P(HasWriteLatencyCount, count,
+          absl::StrCat("has ", count, " write latencies for every stage")) {
+  return arg.total.count() == count && arg.stages.translate.count() == count &&
+         arg.stages.app_db_publish.count() == count &&
+         arg.stages.orch_agent_wait.count() == count &&
+         arg.stages.cache_update.count() == count;
+}
+
 // Testing end-to-end features around the response path (e.g.
 // insert/modify/delete, pass/fail, etc.)
 class ResponsePathTest : public test_lib::P4RuntimeComponentTestFixture {
@@ -770,8 +784,10 @@ TEST_F(ResponsePathTest, P4rtTableFailOnFirstErrorDoesNotAffectVrfTable) {
 }
 
 TEST_F(ResponsePathTest, FailOnFirstErrorInVrfTable) {
-  // VRF entry failure will cause the subsequent entries not to be updated
+  // VRF entry failure will cause the subsequent P4RT entries not to be updated
   // to App Db and hence the status returned as ABORTED for those entries.
+  // VRF entries are sent to the OrchAgent as one batch so the other VRF
+  // entries are still programmed.
   ASSERT_OK_AND_ASSIGN(
       p4::v1::WriteRequest write_request,
       test_lib::PdWriteRequestToPi(
@@ -823,7 +839,7 @@ TEST_F(ResponsePathTest, FailOnFirstErrorInVrfTable) {
       StatusIs(absl::StatusCode::kUnknown,
                AllOf(HasSubstr("#1: INVALID_ARGUMENT: error with vrf-1"),
                      HasSubstr("#2: ABORTED: Not attempted"),
-                     HasSubstr("#3: ABORTED: Not attempted"))));
+                     HasSubstr("#3: OK"))));
 }
 
 TEST_F(ResponsePathTest, FailsOnFirstErrorInP4rtTable) {
@@ -1020,14 +1036,15 @@ TEST_F(ResponsePathTest, WriteRequestsUpdateStatistics) {
       FieldsAre(/*write_batches=*/4, /*write_requests=*/3,
                 /*write_time=*/Not(absl::ZeroDuration()),
                 /*max_write_time=*/Not(absl::ZeroDuration()),
-                /*read_requests=*/0, /*read_time=*/absl::ZeroDuration()));
+                /*read_requests=*/0, /*read_time=*/absl::ZeroDuration(),
+                /*write_latency=*/HasWriteLatencyCount(4)));
 
   // Reading stats should reset values to zero.
   ASSERT_OK_AND_ASSIGN(
       flow_stats, p4rt_service_.GetP4rtServer().GetFlowProgrammingStatistics());
   EXPECT_THAT(flow_stats,
               FieldsAre(0, 0, absl::ZeroDuration(), absl::ZeroDuration(), 0,
-                        absl::ZeroDuration()));
+                        absl::ZeroDuration(), HasWriteLatencyCount(0)));
 }
 
 TEST_F(ResponsePathTest, ReadRequestsUpdateStatistics) {
@@ -1043,18 +1060,20 @@ TEST_F(ResponsePathTest, ReadRequestsUpdateStatistics) {
   ASSERT_OK_AND_ASSIGN(
       FlowProgrammingStatistics flow_stats,
       p4rt_service_.GetP4rtServer().GetFlowProgrammingStatistics());
-  EXPECT_THAT(flow_stats, FieldsAre(/*write_batches=*/0, /*write_requests=*/0,
-                                    /*write_time=*/absl::ZeroDuration(),
-                                    /*max_write_time=*/absl::ZeroDuration(),
-                                    /*read_requests=*/2,
-                                    /*read_time=*/Not(absl::ZeroDuration())));
+  EXPECT_THAT(flow_stats,
+              FieldsAre(/*write_batches=*/0, /*write_requests=*/0,
+                        /*write_time=*/absl::ZeroDuration(),
+                        /*max_write_time=*/absl::ZeroDuration(),
+                        /*read_requests=*/2,
+                        /*read_time=*/Not(absl::ZeroDuration()),
+                        /*write_latency=*/HasWriteLatencyCount(0)));
 
   // Reading stats should reset values to zero.
   ASSERT_OK_AND_ASSIGN(
       flow_stats, p4rt_service_.GetP4rtServer().GetFlowProgrammingStatistics());
   EXPECT_THAT(flow_stats,
               FieldsAre(0, 0, absl::ZeroDuration(), absl::ZeroDuration(), 0,
-                        absl::ZeroDuration()));
+                        absl::ZeroDuration(), HasWriteLatencyCount(0)));
 }
 
 TEST_F(ResponsePathTest, WriteRequestsStatisticsHandleBatchRequests) {
@@ -1101,7 +1120,8 @@ TEST_F(ResponsePathTest, WriteRequestsStatisticsHandleBatchRequests) {
   EXPECT_THAT(flow_stats,
               FieldsAre(/*write_batches=*/1, /*write_requests=*/2,
                         /*write_time=*/Not(absl::ZeroDuration()),
-                        /*max_write_time=*/Not(absl::ZeroDuration()), _, _));
+                        /*max_write_time=*/Not(absl::ZeroDuration()), _, _,
+                        HasWriteLatencyCount(1)));
 }
 
 TEST_F(ResponsePathTest, WriteRequestsStatisticsDoNotIncludeInvalidPiEntries) {
@@ -1174,7 +1194,129 @@ TEST_F(ResponsePathTest, WriteRequestsStatisticsDoNotIncludeInvalidPiEntries) {
   EXPECT_THAT(flow_stats,
               FieldsAre(/*write_batches=*/1, /*write_requests=*/1,
                         /*write_time=*/Not(absl::ZeroDuration()),
-                        /*max_write_time=*/Not(absl::ZeroDuration()), _, _));
+                        /*max_write_time=*/Not(absl::ZeroDuration()), _, _,
+                        HasWriteLatencyCount(1)));
+}
+
+TEST_F(ResponsePathTest, WriteLatencyIsTrackedPerTableAndPublished) {
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::WriteRequest write_request,
+      test_lib::PdWriteRequestToPi(
+          R"pb(
+            updates {
+              type: INSERT
+              table_entry {
+                ipv6_table_entry {
+                  match {
+                    vrf_id: "80"
+                    ipv6_dst { value: "2002:a17:506:c114::" prefix_length: 64 }
+                  }
+                  action { set_nexthop_id { nexthop_id: "20" } }
+                }
+              }
+            }
+          )pb",
+          ir_p4_info_));
+  EXPECT_OK(pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(),
+                                                   write_request));
+
+  ASSERT_OK_AND_ASSIGN(
+      FlowProgrammingStatistics flow_stats,
+      p4rt_service_.GetP4rtServer().GetFlowProgrammingStatistics());
+  EXPECT_THAT(flow_stats.write_latency.stages_by_table,
+              UnorderedElementsAre(Key("ipv6_table")));
+  EXPECT_THAT(flow_stats.write_latency.stages_by_entity_type,
+              UnorderedElementsAre(Key("table_entry")));
+
+  p4rt_service_.GetP4rtServer().PublishWriteLatencyStatistics(
+      flow_stats.write_latency);
+  EXPECT_THAT(p4rt_service_.GetHostStatsStateDbTable().GetAllKeys(),
+              AllOf(Contains("WRITE_LATENCY"),
+                    Contains("WRITE_LATENCY:ENTITY:table_entry"),
+                    Contains("WRITE_LATENCY:TABLE:ipv6_table")));
+  EXPECT_THAT(
+      p4rt_service_.GetHostStatsStateDbTable().ReadTableEntry("WRITE_LATENCY"),
+      IsOkAndHolds(AllOf(Contains(Pair("total-count", "1")),
+                         Contains(Pair("orch-agent-wait-count", "1")),
+                         Contains(Key("orch-agent-wait-p99-us")))));
+}
+
+TEST_F(ResponsePathTest, ResourceUtilizationIsPublishedPerTable) {
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::WriteRequest write_request,
+      test_lib::PdWriteRequestToPi(
+          R"pb(
+            updates {
+              type: INSERT
+              table_entry {
+                ipv6_table_entry {
+                  match {
+                    vrf_id: "80"
+                    ipv6_dst { value: "2002:a17:506:c114::" prefix_length: 64 }
+                  }
+                  action { set_nexthop_id { nexthop_id: "20" } }
+                }
+              }
+            }
+          )pb",
+          ir_p4_info_));
+  EXPECT_OK(pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(),
+                                                   write_request));
+
+  p4rt_service_.GetP4rtServer().PublishResourceUtilization();
+  EXPECT_THAT(p4rt_service_.GetHostStatsStateDbTable().ReadTableEntry(
+                  "RESOURCE_UTILIZATION:TABLE:ipv6_table"),
+              IsOkAndHolds(AllOf(Contains(Pair("entries", "1")),
+                                 Contains(Key("max-entries")))));
+  EXPECT_THAT(p4rt_service_.GetHostStatsStateDbTable().ReadTableEntry(
+                  "RESOURCE_UTILIZATION:ACTION_PROFILE:wcmp_group_selector"),
+              IsOkAndHolds(AllOf(Contains(Pair("current-weight", "0")),
+                                 Contains(Key("max-weight")))));
+}
+
+TEST_F(ResponsePathTest, MemoryFootprintIsPublishedPerTable) {
+  ASSERT_OK_AND_ASSIGN(
+      p4::v1::WriteRequest write_request,
+      test_lib::PdWriteRequestToPi(
+          R"pb(
+            updates {
+              type: INSERT
+              table_entry {
+                ipv6_table_entry {
+                  match {
+                    vrf_id: "80"
+                    ipv6_dst { value: "2002:a17:506:c114::" prefix_length: 64 }
+                  }
+                  action { set_nexthop_id { nexthop_id: "20" } }
+                }
+              }
+            }
+          )pb",
+          ir_p4_info_));
+  EXPECT_OK(pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(),
+                                                   write_request));
+
+  ASSERT_OK_AND_ASSIGN(
+      FlowProgrammingStatistics stats,
+      p4rt_service_.GetP4rtServer().GetFlowProgrammingStatistics());
+  EXPECT_GE(stats.memory.entity_cache.entries, 1);
+  EXPECT_GT(stats.memory.entity_cache.bytes, 0);
+  EXPECT_GT(stats.memory.ir_p4info_bytes, 0);
+  EXPECT_EQ(stats.memory.entity_cache_by_table["ipv6_table"].entries, 1);
+
+  p4rt_service_.GetP4rtServer().PublishMemoryFootprint();
+  EXPECT_THAT(p4rt_service_.GetHostStatsStateDbTable().ReadTableEntry(
+                  "MEMORY_FOOTPRINT:TABLE:ipv6_table"),
+              IsOkAndHolds(AllOf(Contains(Pair("entries", "1")),
+                                 Contains(Key("bytes")))));
+  EXPECT_THAT(p4rt_service_.GetHostStatsStateDbTable().ReadTableEntry(
+                  "MEMORY_FOOTPRINT:ENTITY:table_entry"),
+              IsOkAndHolds(Contains(Key("bytes"))));
+  EXPECT_THAT(
+      p4rt_service_.GetHostStatsStateDbTable().ReadTableEntry(
+          "MEMORY_FOOTPRINT"),
+      IsOkAndHolds(AllOf(Contains(Key("entity-cache-bytes")),
+                         Contains(Key("ir-p4info-bytes")))));
 }
 
 TEST_F(ResponsePathTest, ReadCacheUsesCanonicalFormToStoreTableEntries) {
@@ -11,12 +11,17 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License."
+#include <string>
+
 #include "absl/status/status.h"
+#include "absl/strings/substitute.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "gutil/status.h"
 #include "gutil/status_matchers.h"
 #include "p4/v1/p4runtime.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
+#include "p4rt_app/p4runtime/p4runtime_impl.h"
 #include "p4rt_app/tests/lib/app_db_entry_builder.h"
 #include "p4rt_app/tests/lib/p4runtime_component_test_fixture.h"
 #include "p4rt_app/tests/lib/p4runtime_request_helpers.h"
@@ -25,14 +30,43 @@
 namespace p4rt_app {
 namespace {
 
+using ::gutil::IsOkAndHolds;
 using ::gutil::StatusIs;
+using ::testing::AllOf;
+using ::testing::Contains;
 using ::testing::HasSubstr;
+using ::testing::Pair;
 
 class StateVerificationTest : public test_lib::P4RuntimeComponentTestFixture {
  protected:
   StateVerificationTest()
       : test_lib::P4RuntimeComponentTestFixture(
             sai::Instantiation::kMiddleblock) {}
+
+  absl::Status InsertNeighborEntry(const std::string& router_interface_id) {
+    ASSIGN_OR_RETURN(
+        p4::v1::WriteRequest request,
+        test_lib::PdWriteRequestToPi(
+            absl::Substitute(
+                R"pb(updates {
+                       type: INSERT
+                       table_entry {
+                         neighbor_table_entry {
+                           match {
+                             neighbor_id: "fe80::1"
+                             router_interface_id: "$0"
+                           }
+                           action {
+                             set_dst_mac { dst_mac: "00:1a:11:17:5f:80" }
+                           }
+                         }
+                       }
+                     })pb",
+                router_interface_id),
+            ir_p4_info_));
+    return pdpi::SetMetadataAndSendPiWriteRequest(p4rt_session_.get(),
+                                                  request);
+  }
 };
 
 TEST_F(StateVerificationTest, VerifyEntriesInAppDbAndAppStateDbTables) {
@@ -226,5 +260,68 @@ TEST_F(StateVerificationTest, VerifyVrfEntriesAreIgnoredFromWriteRequests) {
 //            swss::ComponentState::kUp);
 }
 
+TEST_F(StateVerificationTest, IncrementalVerificationWalksKeysInSlices) {
+  ASSERT_OK(InsertNeighborEntry("1"));
+  ASSERT_OK(InsertNeighborEntry("2"));
+  ASSERT_OK(InsertNeighborEntry("3"));
+
+  EXPECT_OK(p4rt_service_.GetP4rtServer().VerifyStateIncrementally(
+      /*max_keys=*/2));
+  StateVerificationProgress progress =
+      p4rt_service_.GetP4rtServer().GetStateVerificationProgress();
+  EXPECT_EQ(progress.cursor, 2);
+  EXPECT_EQ(progress.key_space_size, 3);
+  EXPECT_EQ(progress.completed_passes, 0);
+
+  // An entry added in the middle of a pass is picked up by the next pass.
+  ASSERT_OK(InsertNeighborEntry("4"));
+  EXPECT_OK(p4rt_service_.GetP4rtServer().VerifyStateIncrementally(
+      /*max_keys=*/2));
+  progress = p4rt_service_.GetP4rtServer().GetStateVerificationProgress();
+  EXPECT_EQ(progress.completed_passes, 1);
+  EXPECT_EQ(progress.keys_verified, 3);
+  EXPECT_EQ(progress.mismatches, 0);
+
+  EXPECT_OK(p4rt_service_.GetP4rtServer().VerifyStateIncrementally(
+      /*max_keys=*/10));
+  progress = p4rt_service_.GetP4rtServer().GetStateVerificationProgress();
+  EXPECT_EQ(progress.completed_passes, 2);
+  EXPECT_EQ(progress.key_space_size, 4);
+  EXPECT_EQ(progress.keys_verified, 7);
+
+  EXPECT_THAT(
+      p4rt_service_.GetHostStatsStateDbTable().ReadTableEntry(
+          "STATE_VERIFICATION"),
+      IsOkAndHolds(AllOf(Contains(Pair("completed_passes", "2")),
+                         Contains(Pair("keys_verified", "7")),
+                         Contains(Pair("mismatches", "0")))));
+}
+
+TEST_F(StateVerificationTest, IncrementalVerificationReportsMismatches) {
+  ASSERT_OK(InsertNeighborEntry("1"));
+
+  // Remove the entry from the AppDb.
+  auto app_db_entry = test_lib::AppDbEntryBuilder{}
+                          .SetTableName("FIXED_NEIGHBOR_TABLE")
+                          .AddMatchField("neighbor_id", "fe80::1")
+                          .AddMatchField("router_interface_id", "1");
+  p4rt_service_.GetP4rtAppDbTable().DeleteTableEntry(app_db_entry.GetKey());
+
+  EXPECT_THAT(p4rt_service_.GetP4rtServer().VerifyStateIncrementally(
+                  /*max_keys=*/10),
+              StatusIs(absl::StatusCode::kUnknown,
+                       HasSubstr("AppDb is missing key")));
+  StateVerificationProgress progress =
+      p4rt_service_.GetP4rtServer().GetStateVerificationProgress();
+  EXPECT_EQ(progress.mismatches, 1);
+  EXPECT_EQ(progress.last_pass_mismatches, 1);
+}
+
+TEST_F(StateVerificationTest, IncrementalVerificationRejectsEmptySlices) {
+  EXPECT_THAT(p4rt_service_.GetP4rtServer().VerifyStateIncrementally(
+                  /*max_keys=*/0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 }  // namespace
 }  // namespace p4rt_app
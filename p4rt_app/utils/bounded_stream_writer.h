@@ -0,0 +1,153 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_UTILS_BOUNDED_STREAM_WRITER_H_
+#define PINS_P4RT_APP_UTILS_BOUNDED_STREAM_WRITER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace p4rt_app {
+
+// Writes messages to a blocking stream (e.g. a gRPC ServerReaderWriter) from a
+// dedicated thread, so callers only ever wait on a short queue operation.
+//
+// Droppable messages (e.g. PacketIns) are only queued while fewer than
+// `max_queued_messages` are waiting, otherwise they are dropped. Messages that
+// must be delivered (e.g. arbitration updates) are always queued.
+//
+// Example:
+//   BoundedStreamWriter<Response> writer(
+//       [stream](const Response& r) { return stream->Write(r); },
+//       /*max_queued_messages=*/1024);
+//   writer.Write(response);  // Never blocks on the stream.
+//   writer.Close();          // Flushes the queue before returning.
+template <typename T>
+class BoundedStreamWriter {
+ public:
+  // Returns false if the stream is broken.
+  using WriteFunction = std::function<bool(const T&)>;
+
+  struct Counters {
+    // Messages handed to the stream.
+    uint64_t written = 0;
+    // Droppable messages discarded because the queue was full or the writer was
+    // closed.
+    uint64_t dropped = 0;
+    // Messages the stream refused.
+    uint64_t write_failures = 0;
+    // Most messages ever waiting in the queue at once.
+    int max_queue_depth = 0;
+  };
+
+  BoundedStreamWriter(WriteFunction write_function, int max_queued_messages)
+      : write_function_(std::move(write_function)),
+        max_queued_messages_(max_queued_messages),
+        writer_([this] { WriterLoop(); }) {}
+
+  ~BoundedStreamWriter() { Close(); }
+
+  BoundedStreamWriter(const BoundedStreamWriter&) = delete;
+  BoundedStreamWriter& operator=(const BoundedStreamWriter&) = delete;
+
+  // Queues a droppable message. Returns false if the message was dropped.
+  bool Write(T message) ABSL_LOCKS_EXCLUDED(lock_) {
+    absl::MutexLock l(&lock_);
+    if (closed_ || queue_.size() >= max_queued_messages_) {
+      ++counters_.dropped;
+      return false;
+    }
+    PushLocked(std::move(message));
+    return true;
+  }
+
+  // Queues a message that is never dropped while the writer is open. Returns
+  // false if the writer has been closed.
+  bool WriteReliably(T message) ABSL_LOCKS_EXCLUDED(lock_) {
+    absl::MutexLock l(&lock_);
+    if (closed_) return false;
+    PushLocked(std::move(message));
+    return true;
+  }
+
+  // Writes everything already queued, then stops the writer thread. Once this
+  // returns the write function is never called again. Safe to call more than
+  // once.
+  void Close() ABSL_LOCKS_EXCLUDED(lock_) {
+    {
+      absl::MutexLock l(&lock_);
+      closed_ = true;
+    }
+    absl::MutexLock l(&join_lock_);
+    if (writer_.joinable()) writer_.join();
+  }
+
+  Counters GetCounters() const ABSL_LOCKS_EXCLUDED(lock_) {
+    absl::MutexLock l(&lock_);
+    return counters_;
+  }
+
+ private:
+  void PushLocked(T message) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    queue_.push_back(std::move(message));
+    counters_.max_queue_depth =
+        std::max(counters_.max_queue_depth, static_cast<int>(queue_.size()));
+  }
+
+  void WriterLoop() ABSL_LOCKS_EXCLUDED(lock_) {
+    auto ready = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+      return closed_ || !queue_.empty();
+    };
+    while (true) {
+      T message;
+      {
+        absl::MutexLock l(&lock_);
+        lock_.Await(absl::Condition(&ready));
+        if (queue_.empty()) return;  // Closed and flushed.
+        message = std::move(queue_.front());
+        queue_.pop_front();
+      }
+
+      // The stream write may block for as long as the peer is not reading, so
+      // it must never be done while holding the lock.
+      bool ok = write_function_(message);
+
+      absl::MutexLock l(&lock_);
+      ok ? ++counters_.written : ++counters_.write_failures;
+    }
+  }
+
+  const WriteFunction write_function_;
+  const size_t max_queued_messages_;
+
+  mutable absl::Mutex lock_;
+  std::deque<T> queue_ ABSL_GUARDED_BY(lock_);
+  bool closed_ ABSL_GUARDED_BY(lock_) = false;
+  Counters counters_ ABSL_GUARDED_BY(lock_);
+
+  // Serializes concurrent Close() calls on the join.
+  absl::Mutex join_lock_;
+  // Declared last so everything it uses is initialized before it starts.
+  std::thread writer_;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_UTILS_BOUNDED_STREAM_WRITER_H_
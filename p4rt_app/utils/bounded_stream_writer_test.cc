@@ -0,0 +1,135 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/bounded_stream_writer.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::testing::ElementsAre;
+
+// A stream that records everything written to it. The stream can be stalled to
+// mimic a controller that stopped reading.
+class FakeStream {
+ public:
+  BoundedStreamWriter<std::string>::WriteFunction WriteFunction() {
+    return [this](const std::string& message) {
+      absl::MutexLock l(&lock_);
+      lock_.Await(absl::Condition(
+          +[](bool* stalled) { return !*stalled; }, &stalled_));
+      messages_.push_back(message);
+      return accept_writes_;
+    };
+  }
+
+  void Stall() {
+    absl::MutexLock l(&lock_);
+    stalled_ = true;
+  }
+  void Resume() {
+    absl::MutexLock l(&lock_);
+    stalled_ = false;
+  }
+  void Break() {
+    absl::MutexLock l(&lock_);
+    accept_writes_ = false;
+  }
+
+  std::vector<std::string> Messages() {
+    absl::MutexLock l(&lock_);
+    return messages_;
+  }
+
+ private:
+  absl::Mutex lock_;
+  bool stalled_ ABSL_GUARDED_BY(lock_) = false;
+  bool accept_writes_ ABSL_GUARDED_BY(lock_) = true;
+  std::vector<std::string> messages_ ABSL_GUARDED_BY(lock_);
+};
+
+TEST(BoundedStreamWriterTest, WritesMessagesInOrder) {
+  FakeStream stream;
+  BoundedStreamWriter<std::string> writer(stream.WriteFunction(),
+                                          /*max_queued_messages=*/8);
+  EXPECT_TRUE(writer.Write("first"));
+  EXPECT_TRUE(writer.WriteReliably("second"));
+  EXPECT_TRUE(writer.Write("third"));
+  writer.Close();
+
+  EXPECT_THAT(stream.Messages(), ElementsAre("first", "second", "third"));
+  EXPECT_EQ(writer.GetCounters().written, 3);
+  EXPECT_EQ(writer.GetCounters().dropped, 0);
+}
+
+TEST(BoundedStreamWriterTest, StalledStreamDoesNotBlockWriters) {
+  FakeStream stream;
+  stream.Stall();
+  BoundedStreamWriter<std::string> writer(stream.WriteFunction(),
+                                          /*max_queued_messages=*/2);
+
+  // The writer thread picks up at most one message before blocking on the
+  // stream, so at most 3 fit before the queue is full.
+  int accepted = 0;
+  for (int i = 0; i < 10; ++i) {
+    if (writer.Write("packet")) ++accepted;
+  }
+  EXPECT_GE(accepted, 2);
+  EXPECT_LE(accepted, 3);
+  EXPECT_EQ(writer.GetCounters().dropped, 10 - accepted);
+
+  // Reliable messages are queued even though the queue is full.
+  EXPECT_TRUE(writer.WriteReliably("arbitration"));
+  EXPECT_GE(writer.GetCounters().max_queue_depth, 3);
+
+  stream.Resume();
+  writer.Close();
+  std::vector<std::string> messages = stream.Messages();
+  ASSERT_EQ(messages.size(), accepted + 1);
+  EXPECT_EQ(messages.back(), "arbitration");
+}
+
+TEST(BoundedStreamWriterTest, CountsStreamFailures) {
+  FakeStream stream;
+  stream.Break();
+  BoundedStreamWriter<std::string> writer(stream.WriteFunction(),
+                                          /*max_queued_messages=*/8);
+  writer.Write("packet");
+  writer.WriteReliably("arbitration");
+  writer.Close();
+
+  EXPECT_EQ(writer.GetCounters().written, 0);
+  EXPECT_EQ(writer.GetCounters().write_failures, 2);
+}
+
+TEST(BoundedStreamWriterTest, DropsMessagesAfterClose) {
+  FakeStream stream;
+  BoundedStreamWriter<std::string> writer(stream.WriteFunction(),
+                                          /*max_queued_messages=*/8);
+  writer.Close();
+  writer.Close();
+
+  EXPECT_FALSE(writer.Write("packet"));
+  EXPECT_FALSE(writer.WriteReliably("arbitration"));
+  EXPECT_THAT(stream.Messages(), ElementsAre());
+  EXPECT_EQ(writer.GetCounters().dropped, 1);
+}
+
+}  // namespace
+}  // namespace p4rt_app
@@ -14,10 +14,16 @@
 #ifndef PINS_P4RT_APP_UTILS_EVENT_DATA_TRACKER_H_
 #define PINS_P4RT_APP_UTILS_EVENT_DATA_TRACKER_H_
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <mutex>  // NOLINT
 #include <optional>
+#include <type_traits>
 #include <utility>
 
+#include "absl/time/time.h"
+
 namespace p4rt_app {
 
 // TODO: move into sonic-swss-common if others have a need.
@@ -80,6 +86,115 @@ class EventDataTracker {
   std::optional<T> max_value_seen_;
 };
 
+namespace internal {
+
+// Maps a tracked type onto the arithmetic type stored in the atomics.
+template <typename T, typename Enable = void>
+struct AtomicTrackerStorage {};
+
+template <typename T>
+struct AtomicTrackerStorage<T, std::enable_if_t<std::is_arithmetic_v<T>>> {
+  using Type = T;
+  static Type Encode(T value) { return value; }
+  static T Decode(Type value) { return value; }
+};
+
+template <>
+struct AtomicTrackerStorage<absl::Duration> {
+  using Type = int64_t;
+  static Type Encode(absl::Duration value) {
+    return absl::ToInt64Nanoseconds(value);
+  }
+  static absl::Duration Decode(Type value) { return absl::Nanoseconds(value); }
+};
+
+}  // namespace internal
+
+// Lock-free version of the EventDataTracker for arithmetic types (and
+// absl::Duration with nanosecond precision). Increment() never blocks so it
+// can be used on hot paths (e.g. per packet).
+//
+// Each value is updated atomically, but ReadDataAndReset() is not atomic as a
+// whole. An Increment() racing with a reset may show up in either period.
+template <typename T>
+class AtomicEventDataTracker {
+ public:
+  explicit AtomicEventDataTracker(T default_value)
+      : default_value_(Storage::Encode(default_value)),
+        data_(default_value_) {}
+
+  AtomicEventDataTracker(const AtomicEventDataTracker&) = delete;
+  AtomicEventDataTracker& operator=(const AtomicEventDataTracker&) = delete;
+
+  void Increment(const T& value) {
+    const StorageType encoded = Storage::Encode(value);
+    if constexpr (std::is_integral_v<StorageType>) {
+      data_.fetch_add(encoded, std::memory_order_relaxed);
+    } else {
+      StorageType current = data_.load(std::memory_order_relaxed);
+      while (!data_.compare_exchange_weak(current, current + encoded,
+                                          std::memory_order_relaxed)) {
+      }
+    }
+
+    StorageType current_min = min_value_seen_.load(std::memory_order_relaxed);
+    while (encoded < current_min &&
+           !min_value_seen_.compare_exchange_weak(current_min, encoded,
+                                                  std::memory_order_relaxed)) {
+    }
+    StorageType current_max = max_value_seen_.load(std::memory_order_relaxed);
+    while (encoded > current_max &&
+           !max_value_seen_.compare_exchange_weak(current_max, encoded,
+                                                  std::memory_order_relaxed)) {
+    }
+
+    // Published last so readers never see a count without a min and max.
+    events_.fetch_add(1, std::memory_order_release);
+  }
+
+  AtomicEventDataTracker<T>& operator+=(const T& value) {
+    this->Increment(value);
+    return *this;
+  }
+
+  T ReadData() const {
+    return Storage::Decode(data_.load(std::memory_order_relaxed));
+  }
+
+  std::optional<T> ReadMinValue() const {
+    if (events_.load(std::memory_order_acquire) == 0) return std::nullopt;
+    return Storage::Decode(min_value_seen_.load(std::memory_order_relaxed));
+  }
+
+  std::optional<T> ReadMaxValue() const {
+    if (events_.load(std::memory_order_acquire) == 0) return std::nullopt;
+    return Storage::Decode(max_value_seen_.load(std::memory_order_relaxed));
+  }
+
+  T ReadDataAndReset() {
+    events_.store(0, std::memory_order_relaxed);
+    min_value_seen_.store(kNoMinValue, std::memory_order_relaxed);
+    max_value_seen_.store(kNoMaxValue, std::memory_order_relaxed);
+    return Storage::Decode(
+        data_.exchange(default_value_, std::memory_order_relaxed));
+  }
+
+ private:
+  using Storage = internal::AtomicTrackerStorage<T>;
+  using StorageType = typename Storage::Type;
+
+  static constexpr StorageType kNoMinValue =
+      std::numeric_limits<StorageType>::max();
+  static constexpr StorageType kNoMaxValue =
+      std::numeric_limits<StorageType>::lowest();
+
+  const StorageType default_value_;
+  std::atomic<StorageType> data_;
+  std::atomic<StorageType> min_value_seen_{kNoMinValue};
+  std::atomic<StorageType> max_value_seen_{kNoMaxValue};
+  std::atomic<int64_t> events_{0};
+};
+
 }  // namespace p4rt_app
 
 #endif  // PINS_P4RT_APP_UTILS_EVENT_DATA_TRACKER_H_
@@ -13,6 +13,9 @@
 // limitations under the License.
 #include "p4rt_app/utils/event_data_tracker.h"
 
+#include <thread>  // NOLINT
+#include <vector>
+
 #include "absl/time/time.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -82,5 +85,70 @@ TEST(EventDataTracker, CanIncrementWithOverloadedOperator) {
   EXPECT_EQ(data.ReadData(), absl::Seconds(61));
 }
 
+TEST(AtomicEventDataTracker, ReadAndResetClearsDataAndResetsToTheDefault) {
+  AtomicEventDataTracker<int> data(/*default_value=*/100);
+
+  data.Increment(1);
+  data.Increment(2);
+  data.Increment(10);
+
+  EXPECT_EQ(data.ReadData(), 113);
+  EXPECT_EQ(data.ReadDataAndReset(), 113);
+  EXPECT_EQ(data.ReadDataAndReset(), 100);
+}
+
+TEST(AtomicEventDataTracker, ReadingMinAndMaxValues) {
+  AtomicEventDataTracker<absl::Duration> data(
+      /*default_value=*/absl::ZeroDuration());
+  EXPECT_FALSE(data.ReadMinValue().has_value());
+  EXPECT_FALSE(data.ReadMaxValue().has_value());
+
+  data += absl::Minutes(1);
+  EXPECT_EQ(data.ReadMinValue(), absl::Seconds(60));
+  EXPECT_EQ(data.ReadMaxValue(), absl::Seconds(60));
+
+  data += absl::Seconds(121);
+  data += absl::Seconds(55);
+  EXPECT_EQ(data.ReadMinValue(), absl::Seconds(55));
+  EXPECT_EQ(data.ReadMaxValue(), absl::Seconds(121));
+  EXPECT_EQ(data.ReadData(), absl::Seconds(236));
+
+  data.ReadDataAndReset();
+  EXPECT_FALSE(data.ReadMinValue().has_value());
+  EXPECT_FALSE(data.ReadMaxValue().has_value());
+  EXPECT_EQ(data.ReadData(), absl::ZeroDuration());
+}
+
+TEST(AtomicEventDataTracker, SupportsFloatingPointValues) {
+  AtomicEventDataTracker<double> data(/*default_value=*/0.0);
+
+  data += 1.5;
+  data += -0.5;
+
+  EXPECT_DOUBLE_EQ(data.ReadData(), 1.0);
+  EXPECT_EQ(data.ReadMinValue(), -0.5);
+  EXPECT_EQ(data.ReadMaxValue(), 1.5);
+}
+
+TEST(AtomicEventDataTracker, ConcurrentIncrementsAreNotLost) {
+  constexpr int kThreads = 8;
+  constexpr int kIncrementsPerThread = 10000;
+  AtomicEventDataTracker<int> data(/*default_value=*/0);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&data, t]() {
+      for (int i = 0; i < kIncrementsPerThread; ++i) data += t + 1;
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  // Each thread adds (t + 1) every time: sum of 1..kThreads per iteration.
+  EXPECT_EQ(data.ReadData(),
+            kIncrementsPerThread * kThreads * (kThreads + 1) / 2);
+  EXPECT_EQ(data.ReadMinValue(), 1);
+  EXPECT_EQ(data.ReadMaxValue(), kThreads);
+}
+
 }  // namespace
 }  // namespace p4rt_app
@@ -0,0 +1,89 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "absl/numeric/bits.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/time.h"
+
+namespace p4rt_app {
+
+int LatencyHistogram::BucketIndex(int64_t micros) {
+  if (micros < kSubBucketCount) return std::max<int64_t>(micros, 0);
+
+  // The highest set bit picks the power of two, and the next kSubBucketBits
+  // pick the sub-bucket within it.
+  int exponent = absl::bit_width(static_cast<uint64_t>(micros)) - 1;
+  int sub_bucket =
+      (micros >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+  int index = (exponent - kSubBucketBits + 1) * kSubBucketCount + sub_bucket;
+  return std::min(index, kBucketCount - 1);
+}
+
+int64_t LatencyHistogram::BucketLowerBound(int index) {
+  if (index < kSubBucketCount) return index;
+  int exponent = index / kSubBucketCount + kSubBucketBits - 1;
+  int64_t sub_bucket = index % kSubBucketCount;
+  return (kSubBucketCount + sub_bucket) << (exponent - kSubBucketBits);
+}
+
+void LatencyHistogram::Record(absl::Duration latency) {
+  int64_t micros = std::max<int64_t>(absl::ToInt64Microseconds(latency), 0);
+  ++buckets_[BucketIndex(micros)];
+  ++count_;
+  sum_us_ += micros;
+  max_us_ = std::max(max_us_, micros);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (int i = 0; i < kBucketCount; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+  sum_us_ += other.sum_us_;
+  max_us_ = std::max(max_us_, other.max_us_);
+}
+
+absl::Duration LatencyHistogram::Percentile(double percentile) const {
+  if (count_ == 0) return absl::ZeroDuration();
+
+  percentile = std::clamp(percentile, 0.0, 100.0);
+  int64_t rank = std::max<int64_t>(
+      static_cast<int64_t>(std::ceil(percentile / 100.0 * count_)), 1);
+
+  int64_t seen = 0;
+  for (int i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen < rank) continue;
+
+    // Never report more than the largest value we have actually seen.
+    if (i == kBucketCount - 1) return max();
+    return absl::Microseconds(std::min(BucketLowerBound(i + 1) - 1, max_us_));
+  }
+  return max();
+}
+
+std::string LatencyHistogram::Summary() const {
+  return absl::StrFormat("count=%d p50=%dus p90=%dus p99=%dus max=%dus",
+                         count_, absl::ToInt64Microseconds(Percentile(50)),
+                         absl::ToInt64Microseconds(Percentile(90)),
+                         absl::ToInt64Microseconds(Percentile(99)), max_us_);
+}
+
+}  // namespace p4rt_app
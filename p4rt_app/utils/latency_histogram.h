@@ -0,0 +1,75 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_UTILS_LATENCY_HISTOGRAM_H_
+#define PINS_P4RT_APP_UTILS_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "absl/time/time.h"
+
+namespace p4rt_app {
+
+// Fixed size histogram for tracking latencies with microsecond resolution.
+//
+// Buckets follow a log-linear (HDR-style) layout: every power of two is split
+// into 4 equally sized sub-buckets. So any reported percentile is within 25%
+// of the real value, and the memory used does not depend on how many values
+// have been recorded. Latencies above ~4 minutes are counted in the last
+// bucket.
+//
+// The class is not thread safe.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 2;
+  static constexpr int kSubBucketCount = 1 << kSubBucketBits;
+  static constexpr int kMaxExponent = 27;
+  static constexpr int kBucketCount = kMaxExponent * kSubBucketCount;
+
+  void Record(absl::Duration latency);
+
+  // Adds all the values recorded by `other` into this histogram.
+  void Merge(const LatencyHistogram& other);
+
+  int64_t count() const { return count_; }
+  absl::Duration sum() const { return absl::Microseconds(sum_us_); }
+  absl::Duration max() const { return absl::Microseconds(max_us_); }
+
+  // Returns the number of values recorded in the bucket at `index`.
+  int64_t bucket_count(int index) const { return buckets_[index]; }
+
+  // Returns an upper bound for the latency at `percentile` (i.e. [0, 100]).
+  // Returns zero if nothing has been recorded.
+  absl::Duration Percentile(double percentile) const;
+
+  // Returns a short human readable summary (e.g. count, p50, p99, and max).
+  std::string Summary() const;
+
+  // Returns the bucket used to hold a latency in microseconds.
+  static int BucketIndex(int64_t micros);
+
+  // Returns the smallest latency in microseconds held by a bucket.
+  static int64_t BucketLowerBound(int index);
+
+ private:
+  std::array<int64_t, kBucketCount> buckets_ = {};
+  int64_t count_ = 0;
+  int64_t sum_us_ = 0;
+  int64_t max_us_ = 0;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_UTILS_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,108 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/latency_histogram.h"
+
+#include <cstdint>
+
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace p4rt_app {
+namespace {
+
+TEST(LatencyHistogram, EmptyHistogramReportsZero) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0);
+  EXPECT_EQ(histogram.max(), absl::ZeroDuration());
+  EXPECT_EQ(histogram.Percentile(99), absl::ZeroDuration());
+}
+
+TEST(LatencyHistogram, BucketsCoverEveryValueInOrder) {
+  EXPECT_EQ(LatencyHistogram::BucketIndex(0), 0);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(3), 3);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(4), 4);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(7), 7);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(8), 8);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(9), 8);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(10), 9);
+
+  for (int i = 1; i < LatencyHistogram::kBucketCount; ++i) {
+    int64_t lower_bound = LatencyHistogram::BucketLowerBound(i);
+    EXPECT_EQ(LatencyHistogram::BucketIndex(lower_bound), i);
+    EXPECT_EQ(LatencyHistogram::BucketIndex(lower_bound - 1), i - 1);
+  }
+}
+
+TEST(LatencyHistogram, LargeValuesGoIntoTheLastBucket) {
+  EXPECT_EQ(LatencyHistogram::BucketIndex(absl::ToInt64Microseconds(
+                absl::Hours(24))),
+            LatencyHistogram::kBucketCount - 1);
+}
+
+TEST(LatencyHistogram, CountsValuesPerBucket) {
+  LatencyHistogram histogram;
+  histogram.Record(absl::Microseconds(8));
+  histogram.Record(absl::Microseconds(9));
+  histogram.Record(absl::Microseconds(10));
+
+  EXPECT_EQ(histogram.bucket_count(7), 0);
+  EXPECT_EQ(histogram.bucket_count(8), 2);
+  EXPECT_EQ(histogram.bucket_count(9), 1);
+}
+
+TEST(LatencyHistogram, PercentilesAreWithinBucketPrecision) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.Record(absl::Microseconds(i));
+  }
+
+  EXPECT_EQ(histogram.count(), 1000);
+  EXPECT_EQ(histogram.max(), absl::Microseconds(1000));
+  EXPECT_EQ(histogram.sum(), absl::Microseconds(500500));
+
+  int64_t p50 = absl::ToInt64Microseconds(histogram.Percentile(50));
+  EXPECT_GE(p50, 500);
+  EXPECT_LE(p50, 625);
+
+  int64_t p99 = absl::ToInt64Microseconds(histogram.Percentile(99));
+  EXPECT_GE(p99, 990);
+  EXPECT_LE(p99, 1000);
+
+  EXPECT_EQ(histogram.Percentile(100), absl::Microseconds(1000));
+}
+
+TEST(LatencyHistogram, MergeCombinesValues) {
+  LatencyHistogram first;
+  first.Record(absl::Microseconds(10));
+  LatencyHistogram second;
+  second.Record(absl::Milliseconds(10));
+  second.Record(absl::Milliseconds(20));
+
+  first.Merge(second);
+  EXPECT_EQ(first.count(), 3);
+  EXPECT_EQ(first.max(), absl::Milliseconds(20));
+  EXPECT_EQ(first.sum(), absl::Microseconds(30010));
+  EXPECT_LE(first.Percentile(10), absl::Microseconds(11));
+}
+
+TEST(LatencyHistogram, NegativeLatenciesAreRecordedAsZero) {
+  LatencyHistogram histogram;
+  histogram.Record(absl::Microseconds(-5));
+  EXPECT_EQ(histogram.count(), 1);
+  EXPECT_EQ(histogram.max(), absl::ZeroDuration());
+}
+
+}  // namespace
+}  // namespace p4rt_app
@@ -0,0 +1,76 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/lock_contention.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace p4rt_app {
+
+std::string LockContentionStats::ToString() const {
+  return absl::StrFormat(
+      "acquisitions: %d, contended: %d, total_wait_us: %d, max_wait_us: %d",
+      acquisitions, contended_acquisitions,
+      absl::ToInt64Microseconds(total_wait),
+      absl::ToInt64Microseconds(max_wait));
+}
+
+void LockContentionCounter::RecordAcquisition() {
+  acquisitions_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LockContentionCounter::RecordContendedAcquisition(absl::Duration wait) {
+  const int64_t wait_ns = absl::ToInt64Nanoseconds(wait);
+  acquisitions_.fetch_add(1, std::memory_order_relaxed);
+  contended_acquisitions_.fetch_add(1, std::memory_order_relaxed);
+  total_wait_ns_.fetch_add(wait_ns, std::memory_order_relaxed);
+  int64_t max_wait_ns = max_wait_ns_.load(std::memory_order_relaxed);
+  while (wait_ns > max_wait_ns &&
+         !max_wait_ns_.compare_exchange_weak(max_wait_ns, wait_ns,
+                                             std::memory_order_relaxed)) {
+  }
+}
+
+LockContentionStats LockContentionCounter::GetStats() const {
+  return LockContentionStats{
+      .acquisitions = acquisitions_.load(std::memory_order_relaxed),
+      .contended_acquisitions =
+          contended_acquisitions_.load(std::memory_order_relaxed),
+      .total_wait =
+          absl::Nanoseconds(total_wait_ns_.load(std::memory_order_relaxed)),
+      .max_wait =
+          absl::Nanoseconds(max_wait_ns_.load(std::memory_order_relaxed)),
+  };
+}
+
+ProfiledMutexLock::ProfiledMutexLock(absl::Mutex* mu,
+                                     LockContentionCounter* counter)
+    : mu_(mu) {
+  if (mu_->TryLock()) {
+    counter->RecordAcquisition();
+    return;
+  }
+  const absl::Time start = absl::Now();
+  mu_->Lock();
+  counter->RecordContendedAcquisition(absl::Now() - start);
+}
+
+ProfiledMutexLock::~ProfiledMutexLock() { mu_->Unlock(); }
+
+}  // namespace p4rt_app
@@ -0,0 +1,76 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_UTILS_LOCK_CONTENTION_H_
+#define PINS_P4RT_APP_UTILS_LOCK_CONTENTION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace p4rt_app {
+
+struct LockContentionStats {
+  // Number of times the lock was acquired, and how many of those had to wait
+  // for another thread to release it.
+  int64_t acquisitions = 0;
+  int64_t contended_acquisitions = 0;
+  // Time spent waiting for the lock, in total and by the longest wait.
+  absl::Duration total_wait = absl::ZeroDuration();
+  absl::Duration max_wait = absl::ZeroDuration();
+
+  std::string ToString() const;
+};
+
+// Counts how often, and for how long, threads wait on a lock. Thread-safe.
+class LockContentionCounter {
+ public:
+  // Records an acquisition that did not wait.
+  void RecordAcquisition();
+
+  // Records an acquisition that waited `wait` for another thread.
+  void RecordContendedAcquisition(absl::Duration wait);
+
+  // Returns the totals since construction.
+  LockContentionStats GetStats() const;
+
+ private:
+  std::atomic<int64_t> acquisitions_ = 0;
+  std::atomic<int64_t> contended_acquisitions_ = 0;
+  std::atomic<int64_t> total_wait_ns_ = 0;
+  std::atomic<int64_t> max_wait_ns_ = 0;
+};
+
+// Like absl::MutexLock, but records into `counter` whether, and how long, the
+// acquisition waited. An uncontended acquisition costs a single TryLock(), so
+// this is cheap enough to use on hot locks.
+class ABSL_SCOPED_LOCKABLE ProfiledMutexLock {
+ public:
+  ProfiledMutexLock(absl::Mutex* mu, LockContentionCounter* counter)
+      ABSL_EXCLUSIVE_LOCK_FUNCTION(mu);
+  ~ProfiledMutexLock() ABSL_UNLOCK_FUNCTION();
+
+  ProfiledMutexLock(const ProfiledMutexLock&) = delete;
+  ProfiledMutexLock& operator=(const ProfiledMutexLock&) = delete;
+
+ private:
+  absl::Mutex* const mu_;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_UTILS_LOCK_CONTENTION_H_
@@ -0,0 +1,81 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/lock_contention.h"
+
+#include <thread>  // NOLINT: third_party code.
+
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::testing::HasSubstr;
+
+TEST(LockContentionTest, CountsUncontendedAcquisitions) {
+  absl::Mutex mu;
+  LockContentionCounter counter;
+  for (int i = 0; i < 3; ++i) {
+    ProfiledMutexLock l(&mu, &counter);
+    mu.AssertHeld();
+  }
+
+  LockContentionStats stats = counter.GetStats();
+  EXPECT_EQ(stats.acquisitions, 3);
+  EXPECT_EQ(stats.contended_acquisitions, 0);
+  EXPECT_EQ(stats.total_wait, absl::ZeroDuration());
+  EXPECT_EQ(stats.max_wait, absl::ZeroDuration());
+}
+
+TEST(LockContentionTest, RecordsHowLongAcquisitionsWait) {
+  absl::Mutex mu;
+  LockContentionCounter counter;
+  absl::Notification locked;
+  std::thread holder([&] {
+    absl::MutexLock l(&mu);
+    locked.Notify();
+    absl::SleepFor(absl::Milliseconds(50));
+  });
+  locked.WaitForNotification();
+  { ProfiledMutexLock l(&mu, &counter); }
+  holder.join();
+
+  LockContentionStats stats = counter.GetStats();
+  EXPECT_EQ(stats.acquisitions, 1);
+  EXPECT_EQ(stats.contended_acquisitions, 1);
+  EXPECT_GT(stats.max_wait, absl::ZeroDuration());
+  EXPECT_EQ(stats.total_wait, stats.max_wait);
+  EXPECT_THAT(stats.ToString(), HasSubstr("contended: 1"));
+}
+
+TEST(LockContentionTest, KeepsTheLongestWait) {
+  LockContentionCounter counter;
+  counter.RecordContendedAcquisition(absl::Milliseconds(5));
+  counter.RecordContendedAcquisition(absl::Milliseconds(20));
+  counter.RecordContendedAcquisition(absl::Milliseconds(10));
+  counter.RecordAcquisition();
+
+  LockContentionStats stats = counter.GetStats();
+  EXPECT_EQ(stats.acquisitions, 4);
+  EXPECT_EQ(stats.contended_acquisitions, 3);
+  EXPECT_EQ(stats.total_wait, absl::Milliseconds(35));
+  EXPECT_EQ(stats.max_wait, absl::Milliseconds(20));
+}
+
+}  // namespace
+}  // namespace p4rt_app
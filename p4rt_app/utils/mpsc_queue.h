@@ -0,0 +1,91 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_UTILS_MPSC_QUEUE_H_
+#define PINS_P4RT_APP_UTILS_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace p4rt_app {
+
+// An unbounded multi-producer, single-consumer FIFO queue. Push never takes a
+// lock, so producers never block each other or the consumer.
+//
+// Push may be called from any number of threads. Pop must only ever be called
+// from one thread at a time. Pop can briefly return nothing while a concurrent
+// Push is still linking its value into the queue; callers that need a value
+// should retry.
+//
+// Example:
+//   MpscQueue<std::string> queue;
+//   // On any thread:
+//   queue.Push("packet");
+//   // On the consumer thread:
+//   while (std::optional<std::string> value = queue.Pop()) Process(*value);
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+  ~MpscQueue() {
+    while (Pop().has_value()) {
+    }
+    if (tail_ != &stub_) delete tail_;
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  void Push(T value) {
+    Node* node = new Node(std::move(value));
+    // Producers serialize on the exchange. The previous head is only linked to
+    // the new node afterwards, which is the window where Pop sees nothing.
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  std::optional<T> Pop() {
+    // `tail_` is always a node whose value has already been consumed (or the
+    // stub), so the next value lives in its successor.
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (next == nullptr) return std::nullopt;
+
+    std::optional<T> value = std::move(next->value);
+    next->value.reset();
+    tail_ = next;
+    if (tail != &stub_) delete tail;
+    return value;
+  }
+
+ private:
+  struct Node {
+    Node() = default;
+    explicit Node(T value) : value(std::move(value)) {}
+
+    std::atomic<Node*> next{nullptr};
+    std::optional<T> value;
+  };
+
+  Node stub_;
+  // Most recently pushed node. Written by producers.
+  std::atomic<Node*> head_;
+  // Last consumed node. Only touched by the consumer.
+  Node* tail_;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_UTILS_MPSC_QUEUE_H_
@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/mpsc_queue.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::testing::Optional;
+
+TEST(MpscQueueTest, EmptyQueueReturnsNothing) {
+  MpscQueue<int> queue;
+  EXPECT_EQ(queue.Pop(), std::nullopt);
+}
+
+TEST(MpscQueueTest, ValuesArePoppedInPushOrder) {
+  MpscQueue<std::string> queue;
+  queue.Push("first");
+  queue.Push("second");
+  EXPECT_THAT(queue.Pop(), Optional(std::string("first")));
+  queue.Push("third");
+  EXPECT_THAT(queue.Pop(), Optional(std::string("second")));
+  EXPECT_THAT(queue.Pop(), Optional(std::string("third")));
+  EXPECT_EQ(queue.Pop(), std::nullopt);
+}
+
+TEST(MpscQueueTest, SupportsMoveOnlyValues) {
+  MpscQueue<std::unique_ptr<int>> queue;
+  queue.Push(std::make_unique<int>(7));
+  std::optional<std::unique_ptr<int>> value = queue.Pop();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(**value, 7);
+}
+
+TEST(MpscQueueTest, DestructorReleasesUnpoppedValues) {
+  auto shared = std::make_shared<int>(0);
+  {
+    MpscQueue<std::shared_ptr<int>> queue;
+    queue.Push(shared);
+    queue.Push(shared);
+    EXPECT_EQ(shared.use_count(), 3);
+  }
+  EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(MpscQueueTest, KeepsPerProducerOrderWithConcurrentProducers) {
+  constexpr int kProducers = 4;
+  constexpr int kValuesPerProducer = 10000;
+  struct Value {
+    int producer;
+    int sequence;
+  };
+  MpscQueue<Value> queue;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kValuesPerProducer; ++i) queue.Push({p, i});
+    });
+  }
+
+  std::vector<int> next_sequence(kProducers, 0);
+  int received = 0;
+  while (received < kProducers * kValuesPerProducer) {
+    std::optional<Value> value = queue.Pop();
+    if (!value.has_value()) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(value->sequence, next_sequence[value->producer]);
+    ++next_sequence[value->producer];
+    ++received;
+  }
+  for (std::thread& producer : producers) producer.join();
+
+  EXPECT_EQ(queue.Pop(), std::nullopt);
+}
+
+}  // namespace
+}  // namespace p4rt_app
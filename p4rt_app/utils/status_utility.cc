@@ -13,16 +13,22 @@
 // limitations under the License.
 #include "p4rt_app/utils/status_utility.h"
 
+#include <string>
+#include <vector>
+
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
 
 namespace p4rt_app {
 
 pdpi::IrUpdateStatus GetIrUpdateStatus(absl::StatusCode code,
-                                       const std::string& message) {
+                                       absl::string_view message) {
   pdpi::IrUpdateStatus status;
   if (code != absl::StatusCode::kOk) {
     status.set_code(static_cast<google::rpc::Code>(code));
-    *status.mutable_message() = message;
+    status.set_message(std::string(message));
   }
   return status;
 }
@@ -31,7 +37,27 @@ pdpi::IrUpdateStatus GetIrUpdateStatus(const absl::Status& status) {
   if (status.ok()) {
     return GetIrUpdateStatus(absl::StatusCode::kOk, "");
   }
-  return GetIrUpdateStatus(status.code(), std::string{status.message()});
+  return GetIrUpdateStatus(status.code(), status.message());
+}
+
+const pdpi::IrUpdateStatus& NotAttemptedIrUpdateStatus() {
+  static const auto* const kNotAttempted = new pdpi::IrUpdateStatus(
+      GetIrUpdateStatus(absl::StatusCode::kAborted, "Not attempted"));
+  return *kNotAttempted;
+}
+
+absl::Status CombineStatuses(const std::vector<absl::Status>& statuses) {
+  absl::StatusCode code = absl::StatusCode::kOk;
+  std::vector<std::string> messages;
+  for (const absl::Status& status : statuses) {
+    if (status.ok()) continue;
+    if (code == absl::StatusCode::kOk) code = status.code();
+    messages.push_back(std::string(status.message()));
+  }
+  if (code == absl::StatusCode::kOk) return absl::OkStatus();
+  if (messages.size() == 1) return absl::Status(code, messages[0]);
+  return absl::Status(code, absl::StrCat(messages.size(), " failures: ",
+                                         absl::StrJoin(messages, "; ")));
 }
 
 }  // namespace p4rt_app
@@ -14,6 +14,8 @@
 #ifndef PINS_P4RT_APP_UTILS_STATUS_UTILITY_H_
 #define PINS_P4RT_APP_UTILS_STATUS_UTILITY_H_
 
+#include <vector>
+
 #include "absl/status/status.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
@@ -34,9 +36,18 @@ inline std::string LibraryPrefix(const absl::Status& status) {
 
 // Translates absl::Status to pdpi::IrUpdateStatus
 pdpi::IrUpdateStatus GetIrUpdateStatus(absl::StatusCode code,
-                                       const std::string& message);
+                                       absl::string_view message);
 pdpi::IrUpdateStatus GetIrUpdateStatus(const absl::Status& status);
 
+// The ABORTED status of updates that were not attempted because an earlier
+// update of the batch failed. Built once, since rejected batches mark every
+// remaining update with it.
+const pdpi::IrUpdateStatus& NotAttemptedIrUpdateStatus();
+
+// Returns OK if every status is OK. Otherwise, returns an error with the code
+// of the first failure, and the messages of every failure.
+absl::Status CombineStatuses(const std::vector<absl::Status>& statuses);
+
 }  // namespace p4rt_app
 
 #endif  // PINS_P4RT_APP_UTILS_STATUS_UTILITY_H_
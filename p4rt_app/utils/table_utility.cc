@@ -14,14 +14,18 @@
 #include "p4rt_app/utils/table_utility.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/map.h"
+#include "google/protobuf/util/message_differencer.h"
 #include "gutil/status.h"
 #include "absl/strings/substitute.h"
 #include "p4/config/v1/p4info.pb.h"
@@ -77,6 +81,64 @@ absl::StatusOr<Type> TypeParse(absl::string_view type_name) {
 
 }  // namespace table
 
+namespace {
+
+// Returns a copy of the IrP4Info without its ACL tables, and without the
+// actions that are only used by ACL tables.
+absl::StatusOr<pdpi::IrP4Info> WithoutAclTables(
+    const pdpi::IrP4Info& ir_p4info) {
+  pdpi::IrP4Info result = ir_p4info;
+  absl::flat_hash_set<std::string> acl_actions;
+  absl::flat_hash_set<std::string> other_actions;
+  for (const auto& [table_name, table_def] : ir_p4info.tables_by_name()) {
+    ASSIGN_OR_RETURN(table::Type table_type, GetTableType(table_def));
+    absl::flat_hash_set<std::string>& actions =
+        table_type == table::Type::kAcl ? acl_actions : other_actions;
+    for (const auto& action : table_def.entry_actions()) {
+      actions.insert(action.action().preamble().alias());
+    }
+    for (const auto& action : table_def.default_only_actions()) {
+      actions.insert(action.action().preamble().alias());
+    }
+    if (table_type == table::Type::kAcl) {
+      result.mutable_tables_by_name()->erase(table_name);
+      result.mutable_tables_by_id()->erase(table_def.preamble().id());
+    }
+  }
+
+  for (const std::string& action_name : acl_actions) {
+    if (other_actions.contains(action_name)) continue;
+    auto action_def = ir_p4info.actions_by_name().find(action_name);
+    if (action_def == ir_p4info.actions_by_name().end()) continue;
+    result.mutable_actions_by_id()->erase(action_def->second.preamble().id());
+    result.mutable_actions_by_name()->erase(action_name);
+  }
+  return result;
+}
+
+// Returns the ACL tables in `tables` that are missing from, or different in,
+// `other_tables`.
+absl::StatusOr<std::vector<pdpi::IrTableDefinition>> ChangedAclTables(
+    const google::protobuf::Map<std::string, pdpi::IrTableDefinition>& tables,
+    const google::protobuf::Map<std::string, pdpi::IrTableDefinition>&
+        other_tables) {
+  std::vector<pdpi::IrTableDefinition> result;
+  for (pdpi::IrTableDefinition& table_def : OrderTablesBySize(tables)) {
+    ASSIGN_OR_RETURN(table::Type table_type, GetTableType(table_def));
+    if (table_type != table::Type::kAcl) continue;
+
+    auto other = other_tables.find(table_def.preamble().alias());
+    if (other == other_tables.end() ||
+        !google::protobuf::util::MessageDifferencer::Equals(table_def,
+                                                            other->second)) {
+      result.push_back(std::move(table_def));
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
 table::Type conditional_kExt(const pdpi::IrTableDefinition& ir_table)
 {
     if (ir_table.preamble().id() > 0x03000000)
@@ -164,4 +226,80 @@ std::vector<pdpi::IrTableDefinition> OrderTablesBySize(
   return result;
 }
 
+absl::flat_hash_set<std::string> GetIndependentRoles(
+    const pdpi::IrP4Info& ir_p4info) {
+  absl::flat_hash_set<std::string> roles;
+  absl::flat_hash_set<std::string> dependent_roles;
+  absl::flat_hash_map<uint32_t, std::string> role_by_action_profile_id;
+
+  // Returns true if `table` is a P4 table owned by `role`.
+  auto owned_by = [&](const pdpi::IrTable& table, const std::string& role) {
+    if (!table.has_p4_table()) return false;
+    auto other = ir_p4info.tables_by_name().find(table.p4_table().table_name());
+    return other != ir_p4info.tables_by_name().end() &&
+           other->second.role() == role;
+  };
+
+  for (const auto& [table_name, table_def] : ir_p4info.tables_by_name()) {
+    const std::string& role = table_def.role();
+    if (role.empty()) continue;
+    roles.insert(role);
+
+    for (const auto& reference : table_def.outgoing_references()) {
+      if (!owned_by(reference.destination_table(), role)) {
+        dependent_roles.insert(role);
+      }
+    }
+    for (const auto& reference : table_def.incoming_references()) {
+      if (!owned_by(reference.source_table(), role)) {
+        dependent_roles.insert(role);
+      }
+    }
+
+    if (table_def.has_action_profile_id()) {
+      auto [existing, inserted] = role_by_action_profile_id.insert(
+          {table_def.action_profile_id(), role});
+      if (!inserted && existing->second != role) {
+        dependent_roles.insert(role);
+        dependent_roles.insert(existing->second);
+      }
+    }
+  }
+
+  for (const std::string& role : dependent_roles) roles.erase(role);
+  return roles;
+}
+
+absl::StatusOr<AclTableDiff> DiffAclTables(
+    const pdpi::IrP4Info& old_ir_p4info, const pdpi::IrP4Info& new_ir_p4info) {
+  ASSIGN_OR_RETURN(pdpi::IrP4Info old_fixed, WithoutAclTables(old_ir_p4info));
+  ASSIGN_OR_RETURN(pdpi::IrP4Info new_fixed, WithoutAclTables(new_ir_p4info));
+
+  // The differences are only written to `diff_report` once the differencer is
+  // destroyed.
+  std::string diff_report;
+  bool equal = false;
+  {
+    google::protobuf::util::MessageDifferencer differencer;
+    differencer.ReportDifferencesToString(&diff_report);
+    equal = differencer.Compare(old_fixed, new_fixed);
+  }
+  if (!equal) {
+    return gutil::UnimplementedErrorBuilder()
+           << "Only ACL tables can be modified in a configured forwarding "
+              "pipeline. Please reboot the device. Configuration "
+              "differences:\n"
+           << diff_report;
+  }
+
+  AclTableDiff diff;
+  ASSIGN_OR_RETURN(diff.removed,
+                   ChangedAclTables(old_ir_p4info.tables_by_name(),
+                                    new_ir_p4info.tables_by_name()));
+  ASSIGN_OR_RETURN(diff.added,
+                   ChangedAclTables(new_ir_p4info.tables_by_name(),
+                                    old_ir_p4info.tables_by_name()));
+  return diff;
+}
+
 }  // namespace p4rt_app
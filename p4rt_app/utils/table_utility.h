@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/map.h"
@@ -57,6 +58,27 @@ std::vector<pdpi::IrTableDefinition> OrderTablesBySize(
     const google::protobuf::Map<std::string, pdpi::IrTableDefinition>&
         tables_by_name);
 
+// Returns the roles whose tables can be programmed independently of every
+// other role. A role is independent if none of its tables refer to, or are
+// referred to by, a table of another role or a built-in table, and it does not
+// share an action profile with another role. The default (empty) role is never
+// independent since it can access every table.
+absl::flat_hash_set<std::string> GetIndependentRoles(
+    const pdpi::IrP4Info& ir_p4info);
+
+// The ACL tables that differ between two IrP4Infos. A changed table is both
+// removed, with its old definition, and added with its new definition.
+struct AclTableDiff {
+  std::vector<pdpi::IrTableDefinition> removed;
+  std::vector<pdpi::IrTableDefinition> added;
+};
+
+// Compares two IrP4Infos that should only differ in their ACL tables, or the
+// actions only used by ACL tables. Returns an UNIMPLEMENTED error if anything
+// else differs. Tables are returned in the same order as OrderTablesBySize.
+absl::StatusOr<AclTableDiff> DiffAclTables(const pdpi::IrP4Info& old_ir_p4info,
+                                           const pdpi::IrP4Info& new_ir_p4info);
+
 }  // namespace p4rt_app
 
 #endif  // PINS_P4RT_APP_UTILS_TABLE_UTILITY_H_
@@ -29,7 +29,10 @@ namespace p4rt_app {
 namespace {
 
 using ::gutil::EqualsProto;
+using ::gutil::StatusIs;
 using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::UnorderedElementsAre;
 
 TEST(GetTableType, ReturnsAclForSaiAclAnnotation) {
   pdpi::IrTableDefinition ir_table;
@@ -184,5 +187,228 @@ TEST(OrderTablesBySize, OrdersTablesByNameToBreakTies) {
                           EqualsProto(table0)));
 }
 
+TEST(GetIndependentRoles, ReturnsRolesWithoutCrossRoleReferences) {
+  ASSERT_OK_AND_ASSIGN(auto ir_p4info,
+                       gutil::ParseTextProto<pdpi::IrP4Info>(R"pb(
+                         tables_by_name {
+                           key: "vrf_table"
+                           value { role: "routing" }
+                         }
+                         tables_by_name {
+                           key: "ipv4_table"
+                           value {
+                             role: "routing"
+                             outgoing_references {
+                               destination_table {
+                                 p4_table { table_name: "vrf_table" }
+                               }
+                             }
+                           }
+                         }
+                         tables_by_name {
+                           key: "acl_ingress_table"
+                           value { role: "acl" }
+                         }
+                         tables_by_name {
+                           key: "unowned_table"
+                           value {}
+                         }
+                       )pb"));
+
+  EXPECT_THAT(GetIndependentRoles(ir_p4info),
+              UnorderedElementsAre("routing", "acl"));
+}
+
+TEST(GetIndependentRoles, ExcludesRolesReferencingOtherRoles) {
+  ASSERT_OK_AND_ASSIGN(auto ir_p4info,
+                       gutil::ParseTextProto<pdpi::IrP4Info>(R"pb(
+                         tables_by_name {
+                           key: "vrf_table"
+                           value {
+                             role: "routing"
+                             incoming_references {
+                               source_table {
+                                 p4_table { table_name: "acl_ingress_table" }
+                               }
+                             }
+                           }
+                         }
+                         tables_by_name {
+                           key: "acl_ingress_table"
+                           value {
+                             role: "acl"
+                             outgoing_references {
+                               destination_table {
+                                 p4_table { table_name: "vrf_table" }
+                               }
+                             }
+                           }
+                         }
+                         tables_by_name {
+                           key: "mirror_table"
+                           value {
+                             role: "mirror"
+                             outgoing_references {
+                               destination_table {
+                                 built_in_table:
+                                     BUILT_IN_TABLE_MULTICAST_GROUP_TABLE
+                               }
+                             }
+                           }
+                         }
+                       )pb"));
+
+  EXPECT_THAT(GetIndependentRoles(ir_p4info), IsEmpty());
+}
+
+TEST(GetIndependentRoles, ExcludesRolesSharingAnActionProfile) {
+  ASSERT_OK_AND_ASSIGN(auto ir_p4info,
+                       gutil::ParseTextProto<pdpi::IrP4Info>(R"pb(
+                         tables_by_name {
+                           key: "wcmp_table"
+                           value { role: "routing" action_profile_id: 1 }
+                         }
+                         tables_by_name {
+                           key: "other_wcmp_table"
+                           value { role: "tunnel" action_profile_id: 1 }
+                         }
+                         tables_by_name {
+                           key: "acl_ingress_table"
+                           value { role: "acl" action_profile_id: 2 }
+                         }
+                       )pb"));
+
+  EXPECT_THAT(GetIndependentRoles(ir_p4info), UnorderedElementsAre("acl"));
+}
+
+TEST(DiffAclTables, ReturnsChangedAddedAndRemovedAclTables) {
+  ASSERT_OK_AND_ASSIGN(auto old_ir_p4info,
+                       gutil::ParseTextProto<pdpi::IrP4Info>(R"pb(
+                         tables_by_name {
+                           key: "vrf_table"
+                           value { preamble { alias: "vrf_table" } }
+                         }
+                         tables_by_name {
+                           key: "acl_changed"
+                           value {
+                             preamble {
+                               alias: "acl_changed"
+                               annotations: "@sai_acl(INGRESS)"
+                             }
+                             size: 10
+                           }
+                         }
+                         tables_by_name {
+                           key: "acl_removed"
+                           value {
+                             preamble {
+                               alias: "acl_removed"
+                               annotations: "@sai_acl(INGRESS)"
+                             }
+                           }
+                         }
+                         tables_by_name {
+                           key: "acl_unchanged"
+                           value {
+                             preamble {
+                               alias: "acl_unchanged"
+                               annotations: "@sai_acl(INGRESS)"
+                             }
+                           }
+                         }
+                       )pb"));
+  ASSERT_OK_AND_ASSIGN(auto new_ir_p4info,
+                       gutil::ParseTextProto<pdpi::IrP4Info>(R"pb(
+                         tables_by_name {
+                           key: "vrf_table"
+                           value { preamble { alias: "vrf_table" } }
+                         }
+                         tables_by_name {
+                           key: "acl_changed"
+                           value {
+                             preamble {
+                               alias: "acl_changed"
+                               annotations: "@sai_acl(INGRESS)"
+                             }
+                             size: 20
+                           }
+                         }
+                         tables_by_name {
+                           key: "acl_added"
+                           value {
+                             preamble {
+                               alias: "acl_added"
+                               annotations: "@sai_acl(INGRESS)"
+                             }
+                           }
+                         }
+                         tables_by_name {
+                           key: "acl_unchanged"
+                           value {
+                             preamble {
+                               alias: "acl_unchanged"
+                               annotations: "@sai_acl(INGRESS)"
+                             }
+                           }
+                         }
+                       )pb"));
+
+  ASSERT_OK_AND_ASSIGN(AclTableDiff diff,
+                       DiffAclTables(old_ir_p4info, new_ir_p4info));
+  EXPECT_THAT(diff.removed,
+              UnorderedElementsAre(
+                  EqualsProto(old_ir_p4info.tables_by_name().at("acl_changed")),
+                  EqualsProto(
+                      old_ir_p4info.tables_by_name().at("acl_removed"))));
+  EXPECT_THAT(diff.added,
+              UnorderedElementsAre(
+                  EqualsProto(new_ir_p4info.tables_by_name().at("acl_changed")),
+                  EqualsProto(new_ir_p4info.tables_by_name().at("acl_added"))));
+}
+
+TEST(DiffAclTables, IgnoresActionsOnlyUsedByAclTables) {
+  ASSERT_OK_AND_ASSIGN(auto old_ir_p4info,
+                       gutil::ParseTextProto<pdpi::IrP4Info>(R"pb(
+                         tables_by_name {
+                           key: "acl_table"
+                           value {
+                             preamble {
+                               alias: "acl_table"
+                               annotations: "@sai_acl(INGRESS)"
+                             }
+                             entry_actions {
+                               action { preamble { alias: "acl_drop" } }
+                             }
+                           }
+                         }
+                         actions_by_name {
+                           key: "acl_drop"
+                           value { preamble { alias: "acl_drop" } }
+                         }
+                       )pb"));
+  pdpi::IrP4Info new_ir_p4info = old_ir_p4info;
+  new_ir_p4info.mutable_actions_by_name()->clear();
+
+  ASSERT_OK_AND_ASSIGN(AclTableDiff diff,
+                       DiffAclTables(old_ir_p4info, new_ir_p4info));
+  EXPECT_THAT(diff.removed, IsEmpty());
+  EXPECT_THAT(diff.added, IsEmpty());
+}
+
+TEST(DiffAclTables, RejectsChangesToOtherTables) {
+  ASSERT_OK_AND_ASSIGN(auto old_ir_p4info,
+                       gutil::ParseTextProto<pdpi::IrP4Info>(R"pb(
+                         tables_by_name {
+                           key: "vrf_table"
+                           value { preamble { alias: "vrf_table" } size: 10 }
+                         }
+                       )pb"));
+  pdpi::IrP4Info new_ir_p4info = old_ir_p4info;
+  (*new_ir_p4info.mutable_tables_by_name())["vrf_table"].set_size(20);
+
+  EXPECT_THAT(DiffAclTables(old_ir_p4info, new_ir_p4info),
+              StatusIs(absl::StatusCode::kUnimplemented));
+}
+
 }  // namespace
 }  // namespace p4rt_app
@@ -0,0 +1,64 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/task_executor.h"
+
+#include <functional>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+
+namespace p4rt_app {
+
+TaskExecutor::TaskExecutor(int num_threads) {
+  workers_.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+TaskExecutor::~TaskExecutor() {
+  {
+    absl::MutexLock l(&lock_);
+    shutdown_ = true;
+  }
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void TaskExecutor::Schedule(std::function<void()> task) {
+  absl::MutexLock l(&lock_);
+  tasks_.push_back(std::move(task));
+}
+
+void TaskExecutor::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      absl::MutexLock l(&lock_);
+      auto has_work = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+        return shutdown_ || !tasks_.empty();
+      };
+      lock_.Await(absl::Condition(&has_work));
+      // Tasks scheduled before shutdown still run.
+      if (tasks_.empty()) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace p4rt_app
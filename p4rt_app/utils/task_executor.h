@@ -0,0 +1,61 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_UTILS_TASK_EXECUTOR_H_
+#define PINS_P4RT_APP_UTILS_TASK_EXECUTOR_H_
+
+#include <deque>
+#include <functional>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace p4rt_app {
+
+// A fixed set of threads that run scheduled tasks in FIFO order. Unlike the
+// WorkerPool the tasks are independent, and the caller does not wait for them.
+//
+// Example:
+//   TaskExecutor executor(/*num_threads=*/4);
+//   executor.Schedule([] { HandleRequest(); });
+class TaskExecutor {
+ public:
+  explicit TaskExecutor(int num_threads);
+
+  // Runs every task that was already scheduled, then joins the threads.
+  ~TaskExecutor();
+
+  TaskExecutor(const TaskExecutor&) = delete;
+  TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+  int size() const { return workers_.size(); }
+
+  // Queues `task` to run on one of the executor's threads. Must not be called
+  // once the executor is being destroyed.
+  void Schedule(std::function<void()> task) ABSL_LOCKS_EXCLUDED(lock_);
+
+ private:
+  void WorkerLoop() ABSL_LOCKS_EXCLUDED(lock_);
+
+  absl::Mutex lock_;
+  std::deque<std::function<void()>> tasks_ ABSL_GUARDED_BY(lock_);
+  bool shutdown_ ABSL_GUARDED_BY(lock_) = false;
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_UTILS_TASK_EXECUTOR_H_
@@ -0,0 +1,80 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/task_executor.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "gtest/gtest.h"
+
+namespace p4rt_app {
+namespace {
+
+TEST(TaskExecutorTest, RunsEveryTask) {
+  constexpr int kTasks = 1000;
+  std::atomic<int> ran = 0;
+  {
+    TaskExecutor executor(/*num_threads=*/4);
+    for (int i = 0; i < kTasks; ++i) {
+      executor.Schedule([&ran] { ran.fetch_add(1); });
+    }
+  }
+  EXPECT_EQ(ran.load(), kTasks);
+}
+
+TEST(TaskExecutorTest, RunsTasksOnTheExecutorThreads) {
+  constexpr int kThreads = 3;
+  TaskExecutor executor(kThreads);
+  EXPECT_EQ(executor.size(), kThreads);
+
+  // Every task blocks until all threads are busy, so each one must run on a
+  // different thread.
+  absl::BlockingCounter started(kThreads);
+  absl::Notification release;
+  absl::Mutex lock;
+  absl::flat_hash_set<std::thread::id> thread_ids;
+  absl::BlockingCounter done(kThreads);
+  for (int i = 0; i < kThreads; ++i) {
+    executor.Schedule([&] {
+      {
+        absl::MutexLock l(&lock);
+        thread_ids.insert(std::this_thread::get_id());
+      }
+      started.DecrementCount();
+      release.WaitForNotification();
+      done.DecrementCount();
+    });
+  }
+  started.Wait();
+  release.Notify();
+  done.Wait();
+
+  absl::MutexLock l(&lock);
+  EXPECT_EQ(thread_ids.size(), kThreads);
+  EXPECT_FALSE(thread_ids.contains(std::this_thread::get_id()));
+}
+
+TEST(TaskExecutorTest, TasksCanScheduleMoreTasks) {
+  absl::Notification done;
+  TaskExecutor executor(/*num_threads=*/1);
+  executor.Schedule([&] { executor.Schedule([&] { done.Notify(); }); });
+  done.WaitForNotification();
+}
+
+}  // namespace
+}  // namespace p4rt_app
@@ -0,0 +1,164 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/thread_placement.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "gutil/status.h"
+
+namespace p4rt_app {
+namespace {
+
+absl::StatusOr<int> ParseCpu(absl::string_view cpu) {
+  int value;
+  if (!absl::SimpleAtoi(cpu, &value) || value < 0 || value >= CPU_SETSIZE) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Invalid CPU '" << cpu << "'.";
+  }
+  return value;
+}
+
+// Parses a list of CPUs and CPU ranges, e.g. "0-3,6".
+absl::StatusOr<std::vector<int>> ParseCpuList(absl::string_view list) {
+  std::vector<int> cpus;
+  for (absl::string_view item : absl::StrSplit(list, ',', absl::SkipEmpty())) {
+    std::vector<absl::string_view> range = absl::StrSplit(item, '-');
+    if (range.size() > 2) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Invalid CPU range '" << item << "'.";
+    }
+    ASSIGN_OR_RETURN(int first, ParseCpu(range.front()));
+    ASSIGN_OR_RETURN(int last, ParseCpu(range.back()));
+    if (first > last) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Invalid CPU range '" << item << "'.";
+    }
+    for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+  }
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+}  // namespace
+
+std::string ThreadPlacement::ToString() const {
+  std::string result = "any CPU";
+  if (!cpus.empty()) result = absl::StrCat("CPUs ", absl::StrJoin(cpus, ","));
+  if (nice.has_value()) absl::StrAppend(&result, " with nice ", *nice);
+  return result;
+}
+
+absl::StatusOr<ThreadPlacement> ParseThreadPlacement(absl::string_view spec) {
+  std::vector<absl::string_view> parts = absl::StrSplit(spec, '@');
+  if (parts.size() > 2) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Invalid thread placement '" << spec
+           << "'. Expected <cpus>[@<nice>].";
+  }
+  ThreadPlacement placement;
+  ASSIGN_OR_RETURN(placement.cpus, ParseCpuList(parts[0]),
+                   _ << "Invalid thread placement '" << spec << "'.");
+  if (parts.size() == 2) {
+    int nice;
+    if (!absl::SimpleAtoi(parts[1], &nice) || nice < -20 || nice > 19) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Invalid nice value in thread placement '" << spec
+             << "'. Expected a value in [-20, 19].";
+    }
+    placement.nice = nice;
+  }
+  return placement;
+}
+
+absl::StatusOr<ThreadPlacementConfig> ParseThreadPlacementConfig(
+    absl::string_view spec) {
+  ThreadPlacementConfig config;
+  for (absl::string_view role_spec :
+       absl::StrSplit(spec, ';', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> parts =
+        absl::StrSplit(absl::StripAsciiWhitespace(role_spec),
+                       absl::MaxSplits('=', 1));
+    if (parts.size() != 2) {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Invalid thread role placement '" << role_spec
+             << "'. Expected <role>=<placement>.";
+    }
+    ThreadPlacement* placement = nullptr;
+    if (parts[0] == "grpc") {
+      placement = &config.grpc;
+    } else if (parts[0] == "packetio") {
+      placement = &config.packetio;
+    } else if (parts[0] == "event_loops") {
+      placement = &config.event_loops;
+    } else if (parts[0] == "background") {
+      placement = &config.background;
+    } else {
+      return gutil::InvalidArgumentErrorBuilder()
+             << "Unknown thread role '" << parts[0]
+             << "'. Expected one of: grpc, packetio, event_loops, background.";
+    }
+    ASSIGN_OR_RETURN(*placement, ParseThreadPlacement(parts[1]));
+  }
+  return config;
+}
+
+absl::Status SetThreadCpuAffinity(pthread_t thread,
+                                  const std::vector<int>& cpus) {
+  if (cpus.empty()) return absl::OkStatus();
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) CPU_SET(cpu, &cpu_set);
+  if (int error = pthread_setaffinity_np(thread, sizeof(cpu_set), &cpu_set);
+      error != 0) {
+    return gutil::InternalErrorBuilder()
+           << "Could not restrict thread to CPUs " << absl::StrJoin(cpus, ",")
+           << ": " << std::strerror(error);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ApplyThreadPlacement(const ThreadPlacement& placement) {
+  RETURN_IF_ERROR(SetThreadCpuAffinity(pthread_self(), placement.cpus));
+  if (placement.nice.has_value()) {
+    // On Linux the nice value belongs to a thread, not the whole process.
+    const pid_t thread_id = syscall(SYS_gettid);
+    if (setpriority(PRIO_PROCESS, thread_id, *placement.nice) != 0) {
+      return gutil::InternalErrorBuilder()
+             << "Could not set the thread's nice value to " << *placement.nice
+             << ": " << std::strerror(errno);
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace p4rt_app
@@ -0,0 +1,76 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_UTILS_THREAD_PLACEMENT_H_
+#define PINS_P4RT_APP_UTILS_THREAD_PLACEMENT_H_
+
+#include <pthread.h>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace p4rt_app {
+
+// Which CPUs, and at which priority, a thread runs.
+struct ThreadPlacement {
+  // The CPUs the thread may run on. Any CPU when empty.
+  std::vector<int> cpus;
+  // The thread's nice value. Inherited from the creating thread when unset.
+  std::optional<int> nice;
+
+  bool empty() const { return cpus.empty() && !nice.has_value(); }
+  std::string ToString() const;
+};
+
+// The placement of every role of the P4RT App's threads. Threads inherit the
+// placement of the thread that created them, so placing the main thread
+// before it starts the gRPC server also places gRPC's own threads.
+struct ThreadPlacementConfig {
+  // The gRPC server, and the callback executor.
+  ThreadPlacement grpc;
+  // The PacketIO receive threads.
+  ThreadPlacement packetio;
+  // The AppStateDb and ConfigDb event loops.
+  ThreadPlacement event_loops;
+  // Periodic work: statistics, state verification, and ACL counter refreshes.
+  ThreadPlacement background;
+};
+
+// Parses a placement of the form "<cpus>[@<nice>]", where <cpus> is a list of
+// CPUs and CPU ranges (e.g. "2-3,6"), and may be empty. For example, "2-3@-10"
+// runs on CPUs 2 and 3 with a nice value of -10, and "@5" runs on any CPU
+// with a nice value of 5.
+absl::StatusOr<ThreadPlacement> ParseThreadPlacement(absl::string_view spec);
+
+// Parses a semicolon separated list of "<role>=<placement>", where <role> is
+// one of "grpc", "packetio", "event_loops", or "background". Roles that are not
+// listed keep the default placement. For example:
+//   "grpc=4-7;packetio=2-3@-10;background=0-1@10"
+absl::StatusOr<ThreadPlacementConfig> ParseThreadPlacementConfig(
+    absl::string_view spec);
+
+// Restricts `thread` to the given CPUs. Does nothing if `cpus` is empty.
+absl::Status SetThreadCpuAffinity(pthread_t thread,
+                                  const std::vector<int>& cpus);
+
+// Applies the placement to the calling thread.
+absl::Status ApplyThreadPlacement(const ThreadPlacement& placement);
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_UTILS_THREAD_PLACEMENT_H_
@@ -0,0 +1,85 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/thread_placement.h"
+
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::gutil::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Optional;
+
+TEST(ThreadPlacementTest, ParsesCpusAndNice) {
+  ASSERT_OK_AND_ASSIGN(ThreadPlacement placement,
+                       ParseThreadPlacement("6,2-3@-10"));
+  EXPECT_THAT(placement.cpus, ElementsAre(2, 3, 6));
+  EXPECT_THAT(placement.nice, Optional(-10));
+  EXPECT_EQ(placement.ToString(), "CPUs 2,3,6 with nice -10");
+}
+
+TEST(ThreadPlacementTest, ParsesNiceOnly) {
+  ASSERT_OK_AND_ASSIGN(ThreadPlacement placement, ParseThreadPlacement("@5"));
+  EXPECT_THAT(placement.cpus, IsEmpty());
+  EXPECT_THAT(placement.nice, Optional(5));
+}
+
+TEST(ThreadPlacementTest, EmptyPlacementIsTheDefault) {
+  ASSERT_OK_AND_ASSIGN(ThreadPlacement placement, ParseThreadPlacement(""));
+  EXPECT_TRUE(placement.empty());
+  EXPECT_OK(ApplyThreadPlacement(placement));
+}
+
+TEST(ThreadPlacementTest, RejectsInvalidPlacements) {
+  EXPECT_THAT(ParseThreadPlacement("3-2"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParseThreadPlacement("1-2-3"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParseThreadPlacement("a"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParseThreadPlacement("-1"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParseThreadPlacement("1@20"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParseThreadPlacement("1@2@3"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ThreadPlacementTest, ParsesConfig) {
+  ASSERT_OK_AND_ASSIGN(
+      ThreadPlacementConfig config,
+      ParseThreadPlacementConfig("grpc=4-5; packetio=2@-10;background=@10"));
+  EXPECT_THAT(config.grpc.cpus, ElementsAre(4, 5));
+  EXPECT_THAT(config.packetio.cpus, ElementsAre(2));
+  EXPECT_THAT(config.packetio.nice, Optional(-10));
+  EXPECT_TRUE(config.event_loops.empty());
+  EXPECT_THAT(config.background.nice, Optional(10));
+}
+
+TEST(ThreadPlacementTest, RejectsInvalidConfigs) {
+  EXPECT_THAT(ParseThreadPlacementConfig("grpc"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParseThreadPlacementConfig("gnmi=1"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(ParseThreadPlacementConfig("grpc=x"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace p4rt_app
@@ -0,0 +1,100 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/worker_pool.h"
+
+#include <cstdint>
+#include <thread>  // NOLINT
+
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+
+namespace p4rt_app {
+
+WorkerPool::WorkerPool(int num_threads) {
+  workers_.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    absl::MutexLock l(&lock_);
+    shutdown_ = true;
+  }
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void WorkerPool::ParallelFor(int count, absl::FunctionRef<void(int)> work) {
+  if (count <= 0) return;
+  if (workers_.empty() || count == 1) {
+    for (int i = 0; i < count; ++i) work(i);
+    return;
+  }
+
+  absl::MutexLock parallel_for_lock(&parallel_for_lock_);
+  Batch batch(count, work);
+  {
+    absl::MutexLock l(&lock_);
+    batch_ = &batch;
+    ++batch_generation_;
+  }
+
+  RunBatch(batch);
+
+  // Wait for any workers still running the last items before the batch goes
+  // out of scope.
+  absl::MutexLock l(&lock_);
+  auto batch_done = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+    return active_workers_ == 0 && batch.completed.load() == batch.count;
+  };
+  lock_.Await(absl::Condition(&batch_done));
+  batch_ = nullptr;
+}
+
+void WorkerPool::RunBatch(Batch& batch) {
+  for (int i = batch.next_index.fetch_add(1); i < batch.count;
+       i = batch.next_index.fetch_add(1)) {
+    batch.work(i);
+    batch.completed.fetch_add(1);
+  }
+}
+
+void WorkerPool::WorkerLoop() {
+  uint64_t last_generation = 0;
+  while (true) {
+    Batch* batch = nullptr;
+    {
+      absl::MutexLock l(&lock_);
+      auto has_work = [&]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+        return shutdown_ ||
+               (batch_ != nullptr && batch_generation_ != last_generation);
+      };
+      lock_.Await(absl::Condition(&has_work));
+      if (shutdown_) return;
+      batch = batch_;
+      last_generation = batch_generation_;
+      ++active_workers_;
+    }
+
+    RunBatch(*batch);
+
+    absl::MutexLock l(&lock_);
+    --active_workers_;
+  }
+}
+
+}  // namespace p4rt_app
@@ -0,0 +1,88 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef PINS_P4RT_APP_UTILS_WORKER_POOL_H_
+#define PINS_P4RT_APP_UTILS_WORKER_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/function_ref.h"
+#include "absl/synchronization/mutex.h"
+
+namespace p4rt_app {
+
+// A fixed set of worker threads that can split independent work items between
+// them. The threads are started once, and reused for every ParallelFor call.
+//
+// Example:
+//   WorkerPool pool(/*num_threads=*/3);
+//   std::vector<Result> results(inputs.size());
+//   pool.ParallelFor(inputs.size(), [&](int i) {
+//     results[i] = Process(inputs[i]);
+//   });
+class WorkerPool {
+ public:
+  explicit WorkerPool(int num_threads);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Number of worker threads, not counting the caller of ParallelFor.
+  int size() const { return workers_.size(); }
+
+  // Calls `work(i)` for every i in [0, count), and blocks until all calls
+  // return. The calling thread also runs work items, so calls may happen on
+  // any thread and in any order. Concurrent ParallelFor calls take turns.
+  void ParallelFor(int count, absl::FunctionRef<void(int)> work)
+      ABSL_LOCKS_EXCLUDED(parallel_for_lock_, lock_);
+
+ private:
+  // A single ParallelFor call shared between the caller and the workers.
+  struct Batch {
+    Batch(int count, absl::FunctionRef<void(int)> work)
+        : count(count), work(work) {}
+
+    const int count;
+    absl::FunctionRef<void(int)> work;
+    std::atomic<int> next_index = 0;
+    std::atomic<int> completed = 0;
+  };
+
+  // Runs work items from the batch until none are left.
+  static void RunBatch(Batch& batch);
+
+  void WorkerLoop() ABSL_LOCKS_EXCLUDED(lock_);
+
+  // Only one ParallelFor call can use the workers at a time.
+  absl::Mutex parallel_for_lock_ ABSL_ACQUIRED_BEFORE(lock_);
+
+  absl::Mutex lock_;
+  Batch* batch_ ABSL_GUARDED_BY(lock_) = nullptr;
+  // Incremented for every new batch so a worker never rejoins a batch it has
+  // already finished.
+  uint64_t batch_generation_ ABSL_GUARDED_BY(lock_) = 0;
+  // Number of workers currently running items from `batch_`.
+  int active_workers_ ABSL_GUARDED_BY(lock_) = 0;
+  bool shutdown_ ABSL_GUARDED_BY(lock_) = false;
+
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace p4rt_app
+
+#endif  // PINS_P4RT_APP_UTILS_WORKER_POOL_H_
@@ -0,0 +1,77 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "p4rt_app/utils/worker_pool.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/synchronization/mutex.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace p4rt_app {
+namespace {
+
+using ::testing::Each;
+using ::testing::Eq;
+
+TEST(WorkerPoolTest, ParallelForVisitsEveryIndexOnce) {
+  WorkerPool pool(/*num_threads=*/4);
+  std::vector<int> visits(1000, 0);
+  pool.ParallelFor(visits.size(), [&](int i) { ++visits[i]; });
+  EXPECT_THAT(visits, Each(Eq(1)));
+}
+
+TEST(WorkerPoolTest, ParallelForCanBeCalledRepeatedly) {
+  WorkerPool pool(/*num_threads=*/2);
+  std::atomic<int> total = 0;
+  for (int i = 0; i < 100; ++i) {
+    pool.ParallelFor(10, [&](int) { total.fetch_add(1); });
+  }
+  EXPECT_EQ(total.load(), 1000);
+}
+
+TEST(WorkerPoolTest, ParallelForUsesWorkerThreads) {
+  WorkerPool pool(/*num_threads=*/2);
+  absl::Mutex mu;
+  absl::flat_hash_set<std::thread::id> thread_ids;
+  std::atomic<int> started = 0;
+  pool.ParallelFor(3, [&](int) {
+    // Hold every item until all three have started, so each one must be on a
+    // different thread.
+    started.fetch_add(1);
+    while (started.load() < 3) std::this_thread::yield();
+    absl::MutexLock l(&mu);
+    thread_ids.insert(std::this_thread::get_id());
+  });
+  EXPECT_EQ(thread_ids.size(), 3);
+}
+
+TEST(WorkerPoolTest, EmptyPoolRunsOnCallingThread) {
+  WorkerPool pool(/*num_threads=*/0);
+  std::vector<std::thread::id> thread_ids(5);
+  pool.ParallelFor(thread_ids.size(),
+                   [&](int i) { thread_ids[i] = std::this_thread::get_id(); });
+  EXPECT_THAT(thread_ids, Each(Eq(std::this_thread::get_id())));
+}
+
+TEST(WorkerPoolTest, ParallelForWithNoWorkDoesNothing) {
+  WorkerPool pool(/*num_threads=*/2);
+  pool.ParallelFor(0, [](int) { FAIL() << "Should not be called."; });
+}
+
+}  // namespace
+}  // namespace p4rt_app
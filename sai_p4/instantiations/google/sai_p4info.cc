@@ -1,14 +1,17 @@
 #include "sai_p4/instantiations/google/sai_p4info.h"
 
-#include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "glog/logging.h"
 #include "google/protobuf/text_format.h"
 #include "p4/config/v1/p4info.pb.h"
-#include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
+#include "sai_p4/instantiations/google/fabric_border_router_ir_p4info_embed.h"
 #include "sai_p4/instantiations/google/instantiations.h"
+#include "sai_p4/instantiations/google/middleblock_ir_p4info_embed.h"
 #include "sai_p4/instantiations/google/sai_p4info_fetcher.h"
+#include "sai_p4/instantiations/google/tor_ir_p4info_embed.h"
+#include "sai_p4/instantiations/google/unioned_ir_p4info_embed.h"
+#include "sai_p4/instantiations/google/wbb_ir_p4info_embed.h"
 #include "sai_p4/tools/p4info_tools.h"
 
 namespace sai {
@@ -18,11 +21,14 @@ using ::pdpi::IrP4Info;
 
 namespace {
 
-IrP4Info* CreateIrP4Info(const P4Info& info) {
-  absl::StatusOr<IrP4Info> ir_p4info = pdpi::CreateIrP4Info(info);
-  CHECK(ir_p4info.status().ok())  // Crash ok: TAP rules out failures.
-      << ir_p4info.status();
-  return new IrP4Info(std::move(ir_p4info).value());
+// Parses an embedded IrP4Info. These are created from the embedded P4Infos at
+// build time (see BUILD file), which spares each process from doing so.
+IrP4Info* ParseEmbeddedIrP4Info(const gutil::FileToc* const toc) {
+  auto* ir_p4info = new IrP4Info();
+  CHECK(  // Crash ok: TAP rules out failures.
+      ir_p4info->ParseFromArray(toc[0].data, toc[0].size))
+      << "unable to parse embedded IrP4Info binary file";
+  return ir_p4info;
 }
 
 }  // namespace
@@ -61,24 +67,29 @@ P4Info GetP4InfoWithHashSeed(Instantiation instantiation, uint32_t seed) {
 }
 
 const IrP4Info& GetIrP4Info(Instantiation instantiation) {
-  static const IrP4Info* const kFabricBorderRouterIrP4Info =
-      CreateIrP4Info(GetP4Info(Instantiation::kFabricBorderRouter));
-  static const IrP4Info* const kMiddleblockIrP4Info =
-      CreateIrP4Info(GetP4Info(Instantiation::kMiddleblock));
-  static const IrP4Info* const kTorIrP4Info =
-      CreateIrP4Info(GetP4Info(Instantiation::kTor));
-  static const IrP4Info* const kWbbIrP4Info =
-      CreateIrP4Info(GetP4Info(Instantiation::kWbb));
-
+  // Each IrP4Info is parsed on first use, so processes only pay for the
+  // instantiations they use.
   switch (instantiation) {
-    case Instantiation::kFabricBorderRouter:
+    case Instantiation::kFabricBorderRouter: {
+      static const IrP4Info* const kFabricBorderRouterIrP4Info =
+          ParseEmbeddedIrP4Info(fabric_border_router_ir_p4info_embed_create());
       return *kFabricBorderRouterIrP4Info;
-    case Instantiation::kMiddleblock:
+    }
+    case Instantiation::kMiddleblock: {
+      static const IrP4Info* const kMiddleblockIrP4Info =
+          ParseEmbeddedIrP4Info(middleblock_ir_p4info_embed_create());
       return *kMiddleblockIrP4Info;
-    case Instantiation::kTor:
+    }
+    case Instantiation::kTor: {
+      static const IrP4Info* const kTorIrP4Info =
+          ParseEmbeddedIrP4Info(tor_ir_p4info_embed_create());
       return *kTorIrP4Info;
-    case Instantiation::kWbb:
+    }
+    case Instantiation::kWbb: {
+      static const IrP4Info* const kWbbIrP4Info =
+          ParseEmbeddedIrP4Info(wbb_ir_p4info_embed_create());
       return *kWbbIrP4Info;
+    }
   }
   LOG(DFATAL) << "Obtaining P4Info for invalid instantiation: "
               << static_cast<int>(instantiation);
@@ -93,7 +104,7 @@ const p4::config::v1::P4Info& GetUnionedP4Info() {
 
 const IrP4Info& GetUnionedIrP4Info() {
   static const IrP4Info* const kUnionedIrP4Info =
-      CreateIrP4Info(GetUnionedP4Info());
+      ParseEmbeddedIrP4Info(unioned_ir_p4info_embed_create());
   return *kUnionedIrP4Info;
 }
 
@@ -29,7 +29,8 @@ p4::config::v1::P4Info GetP4InfoWithHashSeed(Instantiation instantiation,
 // Returns a reference to a static IrP4info message for the SAI P4 program.
 // The reference is guaranteed to remain valid at all times.  If a invalid
 // Instantiation is provided, the method does a LOG(DFATAL) and returns an
-// empty IrP4Info.
+// empty IrP4Info. The IrP4Info is created at build time and parsed on first
+// use; concurrent first uses are safe.
 const pdpi::IrP4Info& GetIrP4Info(Instantiation instantiation);
 
 // Returns a reference to a static unioned P4Info of all instantiations. The
@@ -12,6 +12,8 @@
 #include "gutil/version.h"
 #include "p4/config/v1/p4info.pb.h"
 #include "p4_constraints/backend/constraint_info.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
 #include "sai_p4/instantiations/google/instantiations.h"
 
 namespace sai {
@@ -47,6 +49,12 @@ TEST_P(InstantiationTest, GetIrP4InfoDoesNotCrash) {
   }
 }
 
+TEST_P(InstantiationTest, GetIrP4InfoMatchesIrP4InfoCreatedFromP4Info) {
+  ASSERT_OK_AND_ASSIGN(pdpi::IrP4Info expected,
+                       pdpi::CreateIrP4Info(GetP4Info(GetParam())));
+  EXPECT_THAT(GetIrP4Info(GetParam()), gutil::EqualsProto(expected));
+}
+
 TEST_P(InstantiationTest, GetP4InfoWithHashSeedReplacesHashSeed) {
   constexpr uint32_t kHashSeed = 1966175594;
   std::string p4info = GetP4Info(GetParam()).ShortDebugString();
@@ -66,5 +74,11 @@ TEST(GetUnionedP4InfoTest, DoesNotCrashTest) { GetUnionedP4Info(); }
 
 TEST(GetUnionedIrP4InfoTest, DoesNotCrashTest) { GetUnionedIrP4Info(); }
 
+TEST(GetUnionedIrP4InfoTest, MatchesIrP4InfoCreatedFromUnionedP4Info) {
+  ASSERT_OK_AND_ASSIGN(pdpi::IrP4Info expected,
+                       pdpi::CreateIrP4Info(GetUnionedP4Info()));
+  EXPECT_THAT(GetUnionedIrP4Info(), gutil::EqualsProto(expected));
+}
+
 }  // namespace
 }  // namespace sai
@@ -0,0 +1,172 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sai_p4/instantiations/google/test_tools/bmv2_reference_model.h"
+
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <thread>  // NOLINT: third_party code.
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "glog/logging.h"
+#include "gutil/status.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/p4_runtime_session.h"
+#include "platforms/networking/p4/p4_infra/bmv2/bmv2.h"
+#include "sai_p4/instantiations/google/instantiations.h"
+#include "sai_p4/instantiations/google/sai_nonstandard_platforms.h"
+#include "sai_p4/instantiations/google/test_tools/set_up_bmv2.h"
+
+namespace sai {
+namespace {
+
+using ::orion::p4::test::Bmv2;
+
+// The maximum number of packet-ins read from an instance at a time.
+constexpr int kMaxPacketInsPerRead = 1000;
+
+// Calls `run(i)` for every instance index i in [0, num_instances), each on its
+// own thread. The calling thread runs index 0.
+void RunOnEachInstance(int num_instances, const std::function<void(int)>& run) {
+  std::vector<std::thread> threads;
+  threads.reserve(num_instances > 0 ? num_instances - 1 : 0);
+  for (int i = 1; i < num_instances; ++i) threads.emplace_back(run, i);
+  if (num_instances > 0) run(0);
+  for (std::thread& thread : threads) thread.join();
+}
+
+// Returns the first error of `statuses`, if any.
+absl::Status FirstError(absl::Span<const absl::Status> statuses) {
+  for (const absl::Status& status : statuses) {
+    RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
+// Reads packet-ins from `bmv2` until none arrives within `timeout`, and
+// appends them to `packet_ins`.
+absl::Status ReadPacketIns(Bmv2& bmv2, absl::Duration timeout,
+                           std::vector<p4::v1::PacketIn>& packet_ins) {
+  while (true) {
+    absl::StatusOr<std::vector<p4::v1::StreamMessageResponse>> responses =
+        bmv2.P4RuntimeSession().GetNextStreamMessages(kMaxPacketInsPerRead,
+                                                      timeout);
+    if (absl::IsDeadlineExceeded(responses.status())) return absl::OkStatus();
+    RETURN_IF_ERROR(responses.status());
+    for (p4::v1::StreamMessageResponse& response : *responses) {
+      if (response.has_packet()) {
+        packet_ins.push_back(std::move(*response.mutable_packet()));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<Bmv2ReferenceModel> Bmv2ReferenceModel::Create(
+    Instantiation instantiation, const pdpi::IrP4Info& ir_p4info,
+    absl::Span<const p4::v1::Entity> pi_entities,
+    Bmv2ReferenceModelOptions options) {
+  if (options.num_instances < 1) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "num_instances must be positive, but is "
+           << options.num_instances;
+  }
+  const p4::v1::ForwardingPipelineConfig bmv2_config =
+      GetNonstandardForwardingPipelineConfig(instantiation,
+                                             NonstandardPlatform::kBmv2);
+
+  // Starting and programming an instance takes a while, so instances are set
+  // up concurrently.
+  std::vector<std::optional<Bmv2>> instances(options.num_instances);
+  std::vector<absl::Status> statuses(options.num_instances);
+  RunOnEachInstance(options.num_instances, [&](int i) {
+    statuses[i] = [&]() -> absl::Status {
+      ASSIGN_OR_RETURN(Bmv2 bmv2,
+                       SetUpBmv2ForSaiP4(bmv2_config, options.bmv2_args));
+      RETURN_IF_ERROR(pdpi::InstallPiEntities(&bmv2.P4RuntimeSession(),
+                                              ir_p4info, pi_entities));
+      instances[i].emplace(std::move(bmv2));
+      return absl::OkStatus();
+    }();
+  });
+  RETURN_IF_ERROR(FirstError(statuses))
+      << " while setting up a BMv2 instance of the reference model";
+
+  std::vector<Bmv2> ready_instances;
+  ready_instances.reserve(instances.size());
+  for (std::optional<Bmv2>& instance : instances) {
+    ready_instances.push_back(*std::move(instance));
+  }
+  return Bmv2ReferenceModel(std::move(ready_instances), std::move(options));
+}
+
+absl::StatusOr<Bmv2OutputsByTag> Bmv2ReferenceModel::ComputeOutputs(
+    const Bmv2PacketsByTag& packets_by_tag) {
+  std::vector<std::pair<int, const pins::PacketAtPort*>> packets;
+  packets.reserve(packets_by_tag.size());
+  for (const auto& [tag, packet] : packets_by_tag) {
+    packets.push_back({tag, &packet});
+  }
+
+  // BMv2 returns the forwarded packets of an input packet synchronously, so
+  // instances pick up the next packet as soon as they are done with one.
+  // Packet-ins arrive asynchronously, and are matched to their input by tag
+  // once the batch is done.
+  std::vector<std::vector<pins::PacketAtPort>> forwarded(packets.size());
+  std::vector<std::vector<p4::v1::PacketIn>> packet_ins(instances_.size());
+  std::vector<absl::Status> statuses(instances_.size());
+  std::atomic<int> next_packet = 0;
+  RunOnEachInstance(instances_.size(), [&](int instance) {
+    statuses[instance] = [&]() -> absl::Status {
+      Bmv2& bmv2 = instances_[instance];
+      for (int i = next_packet++; i < static_cast<int>(packets.size());
+           i = next_packet++) {
+        ASSIGN_OR_RETURN(forwarded[i], bmv2.SendPacket(*packets[i].second),
+                         _ << " for the packet with tag " << packets[i].first);
+      }
+      return ReadPacketIns(bmv2, options_.packet_in_timeout,
+                           packet_ins[instance]);
+    }();
+  });
+  RETURN_IF_ERROR(FirstError(statuses));
+
+  Bmv2OutputsByTag outputs_by_tag;
+  for (int i = 0; i < static_cast<int>(packets.size()); ++i) {
+    outputs_by_tag[packets[i].first].packets = std::move(forwarded[i]);
+  }
+  if (!options_.extract_tag_from_packet_in) return outputs_by_tag;
+  for (std::vector<p4::v1::PacketIn>& instance_packet_ins : packet_ins) {
+    for (p4::v1::PacketIn& packet_in : instance_packet_ins) {
+      absl::StatusOr<int> tag =
+          options_.extract_tag_from_packet_in(packet_in.payload());
+      auto output = tag.ok() ? outputs_by_tag.find(*tag) : outputs_by_tag.end();
+      if (output == outputs_by_tag.end()) {
+        LOG(WARNING) << "Ignoring packet-in of no packet in the batch: "
+                     << packet_in.ShortDebugString();
+        continue;
+      }
+      output->second.packet_ins.push_back(std::move(packet_in));
+    }
+  }
+  return outputs_by_tag;
+}
+
+}  // namespace sai
@@ -0,0 +1,95 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_SAI_P4_INSTANTIATIONS_GOOGLE_TEST_TOOLS_BMV2_REFERENCE_MODEL_H_
+#define PINS_SAI_P4_INSTANTIATIONS_GOOGLE_TEST_TOOLS_BMV2_REFERENCE_MODEL_H_
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.pb.h"
+#include "platforms/networking/p4/p4_infra/bmv2/bmv2.h"
+#include "sai_p4/instantiations/google/instantiations.h"
+#include "sai_p4/instantiations/google/test_tools/set_up_bmv2.h"
+
+namespace sai {
+
+// The output of BMv2 for a single input packet.
+struct Bmv2Output {
+  // The packets forwarded on the dataplane.
+  std::vector<pins::PacketAtPort> packets;
+  // The packets punted to the controller.
+  std::vector<p4::v1::PacketIn> packet_ins;
+};
+
+// Input packets or outputs, keyed by the test tag of the input packet.
+using Bmv2PacketsByTag = absl::btree_map<int, pins::PacketAtPort>;
+using Bmv2OutputsByTag = absl::btree_map<int, Bmv2Output>;
+
+struct Bmv2ReferenceModelOptions {
+  // The number of BMv2 instances packets are spread across. Each instance is
+  // driven by its own thread.
+  int num_instances = 1;
+  // Returns the test tag of a raw punted packet. Needed to match packet-ins to
+  // their input packet; if unset, packet-ins are not collected.
+  std::function<absl::StatusOr<int>(absl::string_view raw_packet)>
+      extract_tag_from_packet_in;
+  // After a batch, every instance waits this long for further packet-ins.
+  absl::Duration packet_in_timeout = absl::Seconds(1);
+  orion::p4::test::Bmv2::Args bmv2_args = DefaultSaiP4Bmv2Args();
+};
+
+// Computes the expected outputs of test packets using several BMv2 instances,
+// all set up for SAI P4 and programmed with the same entities once, at
+// creation. Batches of packets are then spread across the instances, rather
+// than pushing them through a single BMv2 one at a time.
+//
+// Not thread-safe: batches must be computed one at a time.
+class Bmv2ReferenceModel {
+ public:
+  static absl::StatusOr<Bmv2ReferenceModel> Create(
+      Instantiation instantiation, const pdpi::IrP4Info& ir_p4info,
+      absl::Span<const p4::v1::Entity> pi_entities,
+      Bmv2ReferenceModelOptions options = {});
+
+  Bmv2ReferenceModel(Bmv2ReferenceModel&&) = default;
+  Bmv2ReferenceModel& operator=(Bmv2ReferenceModel&&) = default;
+
+  // Returns the output of every input packet, keyed by the same tag. Every
+  // input packet has an output, which is empty if the packet was dropped.
+  // Packet-ins whose tag is not in `packets_by_tag` are logged and ignored.
+  absl::StatusOr<Bmv2OutputsByTag> ComputeOutputs(
+      const Bmv2PacketsByTag& packets_by_tag);
+
+  int num_instances() const { return instances_.size(); }
+
+ private:
+  Bmv2ReferenceModel(std::vector<orion::p4::test::Bmv2> instances,
+                     Bmv2ReferenceModelOptions options)
+      : instances_(std::move(instances)), options_(std::move(options)) {}
+
+  std::vector<orion::p4::test::Bmv2> instances_;
+  Bmv2ReferenceModelOptions options_;
+};
+
+}  // namespace sai
+
+#endif  // PINS_SAI_P4_INSTANTIATIONS_GOOGLE_TEST_TOOLS_BMV2_REFERENCE_MODEL_H_
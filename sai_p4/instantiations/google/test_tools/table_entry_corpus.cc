@@ -0,0 +1,180 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sai_p4/instantiations/google/test_tools/table_entry_corpus.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT: third_party code.
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "glog/logging.h"
+#include "gutil/proto.h"
+#include "gutil/status.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "p4_pdpi/ir.h"
+#include "p4_pdpi/ir.pb.h"
+#include "p4_pdpi/ir_p4info_cache.h"
+#include "sai_p4/instantiations/google/test_tools/table_entry_generator.h"
+#include "sai_p4/instantiations/google/test_tools/table_entry_generator_helper.h"
+
+namespace sai {
+namespace {
+
+std::string CacheFilePath(const std::string& directory,
+                          const p4::config::v1::P4Info& p4_info,
+                          int entries_per_table) {
+  return absl::StrCat(directory, "/table_entry_corpus_",
+                      absl::Hex(pdpi::P4InfoFingerprint(p4_info),
+                                absl::kZeroPad16),
+                      "_", entries_per_table, ".entries");
+}
+
+// Writes `entries` to `path` through a temporary file, so readers never see a
+// partially written corpus.
+absl::Status WriteCacheFile(const std::string& path,
+                            const std::vector<p4::v1::TableEntry>& entries) {
+  const std::string tmp_path = absl::StrCat(path, ".tmp");
+  absl::Status saved = gutil::SaveDelimitedProtosToFile(tmp_path, entries);
+  if (!saved.ok()) {
+    std::remove(tmp_path.c_str());
+    return saved;
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return gutil::InternalErrorBuilder()
+           << "Could not move table entry corpus to '" << path << "'.";
+  }
+  return absl::OkStatus();
+}
+
+// Returns the PI prerequisites and entries of `table`, or nothing if the table
+// has no generator.
+std::vector<p4::v1::TableEntry> GenerateTableEntries(
+    const pdpi::IrP4Info& ir_p4info, const pdpi::IrTableDefinition& table,
+    int entries_per_table) {
+  std::vector<p4::v1::TableEntry> entries;
+  absl::StatusOr<TableEntryGenerator> generator = GetGenerator(table);
+  if (!generator.ok()) return entries;
+
+  auto add_entry = [&](const pdpi::IrTableEntry& ir_entry) {
+    absl::StatusOr<p4::v1::TableEntry> pi_entry =
+        pdpi::IrTableEntryToPi(ir_p4info, ir_entry);
+    if (pi_entry.ok()) entries.push_back(*std::move(pi_entry));
+  };
+  int64_t num_entries = entries_per_table;
+  if (table.size() > 0) num_entries = std::min(num_entries, table.size());
+  entries.reserve(generator->prerequisites.size() + num_entries);
+  for (const pdpi::IrTableEntry& prerequisite : generator->prerequisites) {
+    add_entry(prerequisite);
+  }
+  for (int i = 0; i < num_entries; ++i) add_entry(generator->generator(i));
+  return entries;
+}
+
+}  // namespace
+
+absl::StatusOr<std::vector<p4::v1::TableEntry>> GenerateTableEntryCorpus(
+    const p4::config::v1::P4Info& p4_info,
+    const TableEntryCorpusOptions& options) {
+  if (options.entries_per_table < 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Number of entries per table must be >= 0. Number of entries: "
+           << options.entries_per_table;
+  }
+  if (options.num_threads <= 0) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Number of threads must be > 0. Number of threads: "
+           << options.num_threads;
+  }
+
+  std::string path;
+  if (!options.cache_directory.empty()) {
+    path = CacheFilePath(options.cache_directory, p4_info,
+                         options.entries_per_table);
+    if (std::ifstream(path).good()) {
+      absl::StatusOr<std::vector<p4::v1::TableEntry>> from_file =
+          gutil::ReadDelimitedProtosFromFile<p4::v1::TableEntry>(path);
+      if (from_file.ok()) return from_file;
+      LOG(INFO) << "Not using the table entry corpus cache: "
+                << from_file.status();
+    }
+  }
+
+  ASSIGN_OR_RETURN(std::shared_ptr<const pdpi::IrP4Info> ir_p4info,
+                   pdpi::GetOrCreateIrP4Info(p4_info));
+  // Visits the tables in a fixed order, so corpora are reproducible.
+  std::vector<const pdpi::IrTableDefinition*> tables;
+  {
+    std::map<std::string, const pdpi::IrTableDefinition*> tables_by_name;
+    for (const auto& [name, table] : ir_p4info->tables_by_name()) {
+      tables_by_name[name] = &table;
+    }
+    tables.reserve(tables_by_name.size());
+    for (const auto& [name, table] : tables_by_name) tables.push_back(table);
+  }
+
+  // Table sizes vary widely, so threads pick up the next table when done with
+  // one rather than working through fixed chunks.
+  std::vector<std::vector<p4::v1::TableEntry>> entries_by_table(tables.size());
+  std::atomic<int> next_table = 0;
+  auto generate = [&] {
+    for (int i = next_table++; i < static_cast<int>(tables.size());
+         i = next_table++) {
+      entries_by_table[i] = GenerateTableEntries(*ir_p4info, *tables[i],
+                                                 options.entries_per_table);
+    }
+  };
+  const int num_threads = std::min<int>(options.num_threads, tables.size());
+  if (num_threads <= 1) {
+    generate();
+  } else {
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int i = 0; i < num_threads; ++i) threads.emplace_back(generate);
+    for (std::thread& thread : threads) thread.join();
+  }
+
+  std::vector<p4::v1::TableEntry> corpus;
+  absl::flat_hash_set<pdpi::TableEntryKey> keys;
+  for (std::vector<p4::v1::TableEntry>& entries : entries_by_table) {
+    for (p4::v1::TableEntry& entry : entries) {
+      if (keys.insert(pdpi::TableEntryKey(entry)).second) {
+        corpus.push_back(std::move(entry));
+      }
+    }
+  }
+
+  if (!path.empty()) {
+    absl::Status saved = WriteCacheFile(path, corpus);
+    LOG_IF(WARNING, !saved.ok())
+        << "Could not save the table entry corpus cache: " << saved;
+  }
+  return corpus;
+}
+
+}  // namespace sai
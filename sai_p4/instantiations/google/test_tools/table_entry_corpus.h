@@ -0,0 +1,53 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PINS_SAI_P4_INSTANTIATIONS_GOOGLE_TEST_TOOLS_TABLE_ENTRY_CORPUS_H_
+#define PINS_SAI_P4_INSTANTIATIONS_GOOGLE_TEST_TOOLS_TABLE_ENTRY_CORPUS_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+
+namespace sai {
+
+struct TableEntryCorpusOptions {
+  // The number of entries generated per table, capped at the table size.
+  int entries_per_table = 100;
+  // Tables are generated concurrently on up to this many threads.
+  int num_threads = 8;
+  // If non-empty, a corpus is read from, and written to, a file in this
+  // directory named after the P4Info fingerprint and `entries_per_table`.
+  // Failing to use the file is not an error, the corpus is generated instead.
+  std::string cache_directory;
+};
+
+// Returns PI table entries for every table of `p4_info` that has a
+// `TableEntryGenerator`, in a valid order for installation: the tables are
+// visited by name and each table's prerequisites precede its entries. Entries
+// are deduplicated by key, and generated entries that cannot be translated to
+// PI, e.g. because the instantiation lacks a match field, are skipped.
+//
+// Generating and translating entries is the bulk of the cost of setting up
+// large scale tests and benchmarks; `options.cache_directory` lets repeated
+// runs against the same P4Info skip it.
+absl::StatusOr<std::vector<p4::v1::TableEntry>> GenerateTableEntryCorpus(
+    const p4::config::v1::P4Info& p4_info,
+    const TableEntryCorpusOptions& options = {});
+
+}  // namespace sai
+
+#endif  // PINS_SAI_P4_INSTANTIATIONS_GOOGLE_TEST_TOOLS_TABLE_ENTRY_CORPUS_H_
@@ -0,0 +1,92 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sai_p4/instantiations/google/test_tools/table_entry_corpus.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "p4/config/v1/p4info.pb.h"
+#include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/entity_keys.h"
+#include "sai_p4/instantiations/google/instantiations.h"
+#include "sai_p4/instantiations/google/sai_p4info.h"
+
+namespace sai {
+namespace {
+
+using ::gutil::EqualsProtoSequence;
+using ::gutil::StatusIs;
+using ::testing::IsEmpty;
+using ::testing::Not;
+
+TEST(TableEntryCorpusTest, GeneratesEntriesWithDistinctKeys) {
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<p4::v1::TableEntry> corpus,
+      GenerateTableEntryCorpus(GetP4Info(Instantiation::kMiddleblock),
+                               {.entries_per_table = 10}));
+  EXPECT_THAT(corpus, Not(IsEmpty()));
+
+  absl::flat_hash_set<pdpi::TableEntryKey> keys;
+  for (const p4::v1::TableEntry& entry : corpus) {
+    EXPECT_TRUE(keys.insert(pdpi::TableEntryKey(entry)).second)
+        << "Duplicate entry: " << entry.ShortDebugString();
+  }
+}
+
+TEST(TableEntryCorpusTest, IsIndependentOfTheNumberOfThreads) {
+  const p4::config::v1::P4Info& p4info =
+      GetP4Info(Instantiation::kFabricBorderRouter);
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<p4::v1::TableEntry> sequential,
+      GenerateTableEntryCorpus(
+          p4info, {.entries_per_table = 10, .num_threads = 1}));
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<p4::v1::TableEntry> parallel,
+      GenerateTableEntryCorpus(
+          p4info, {.entries_per_table = 10, .num_threads = 4}));
+  EXPECT_THAT(parallel, EqualsProtoSequence(sequential));
+}
+
+TEST(TableEntryCorpusTest, ReusesTheCorpusInTheCacheDirectory) {
+  const p4::config::v1::P4Info& p4info =
+      GetP4Info(Instantiation::kMiddleblock);
+  const TableEntryCorpusOptions options{
+      .entries_per_table = 5,
+      .cache_directory = testing::TempDir(),
+  };
+  ASSERT_OK_AND_ASSIGN(std::vector<p4::v1::TableEntry> generated,
+                       GenerateTableEntryCorpus(p4info, options));
+  ASSERT_OK_AND_ASSIGN(std::vector<p4::v1::TableEntry> cached,
+                       GenerateTableEntryCorpus(p4info, options));
+  EXPECT_THAT(cached, EqualsProtoSequence(generated));
+}
+
+TEST(TableEntryCorpusTest, RejectsInvalidOptions) {
+  const p4::config::v1::P4Info& p4info =
+      GetP4Info(Instantiation::kMiddleblock);
+  EXPECT_THAT(GenerateTableEntryCorpus(p4info, {.entries_per_table = -1}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(GenerateTableEntryCorpus(p4info, {.num_threads = 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace sai
@@ -24,11 +24,12 @@
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "glog/logging.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "google/protobuf/message.h"
 #include "google/protobuf/message_lite.h"
 #include "google/protobuf/repeated_ptr_field.h"
 #include "gutil/proto.h"
-#include "gutil/proto_ordering.h"
 #include "gutil/status.h"
 #include "gutil/testing.h"
 #include "p4/v1/p4runtime.pb.h"
@@ -38,6 +39,21 @@
 #include "sai_p4/instantiations/google/sai_pd.pb.h"
 
 namespace sai {
+namespace {
+
+std::string SerializeDeterministically(
+    const google::protobuf::Message& message) {
+  std::string bytes;
+  {
+    google::protobuf::io::StringOutputStream output_stream(&bytes);
+    google::protobuf::io::CodedOutputStream output(&output_stream);
+    output.SetSerializationDeterministic(true);
+    message.SerializeToCodedStream(&output);
+  }
+  return bytes;
+}
+
+}  // namespace
 
 absl::StatusOr<sai::TableEntries> MakePdEntriesForwardingIpPacketsToGivenPort(
     absl::string_view egress_port) {
@@ -177,26 +193,84 @@ EntryBuilder& EntryBuilder::LogPdEntries() {
   return *this;
 }
 
+absl::StatusOr<EntryBuilder::TranslationCache*>
+EntryBuilder::GetTranslationCache(const pdpi::IrP4Info& ir_p4info,
+                                  bool allow_unsupported) const {
+  TranslationCache& cache = translation_cache_;
+  if (cache.ir_p4info != &ir_p4info ||
+      cache.allow_unsupported != allow_unsupported) {
+    cache = TranslationCache{
+        .ir_p4info = &ir_p4info,
+        .allow_unsupported = allow_unsupported,
+    };
+  }
+
+  const pdpi::TranslationOptions options{.allow_unsupported =
+                                             allow_unsupported};
+  for (; cache.num_translated_entries < entries_.entries_size();
+       ++cache.num_translated_entries) {
+    ASSIGN_OR_RETURN(
+        pdpi::IrEntity ir_entity,
+        pdpi::PdTableEntryToIrEntity(
+            ir_p4info, entries_.entries(cache.num_translated_entries),
+            options));
+    if (!cache.serialized_entities.insert(SerializeDeterministically(ir_entity))
+             .second) {
+      continue;
+    }
+    // The order of `gutil::InefficientProtoSort`, used before entries were
+    // cached.
+    cache.entities.push_back({
+        .sort_key = gutil::PrintTextProto(ir_entity),
+        .ir = std::move(ir_entity),
+    });
+    cache.sorted = false;
+  }
+  if (!cache.sorted) {
+    absl::c_sort(cache.entities, [](const TranslationCache::Entity& a,
+                                    const TranslationCache::Entity& b) {
+      return a.sort_key < b.sort_key;
+    });
+    cache.sorted = true;
+  }
+  return &cache;
+}
+
 absl::StatusOr<std::vector<p4::v1::Entity>> EntryBuilder::GetDedupedPiEntities(
     const pdpi::IrP4Info& ir_p4info, bool allow_unsupported) const {
-  ASSIGN_OR_RETURN(pdpi::IrEntities ir_entities,
-                   GetDedupedIrEntities(ir_p4info, allow_unsupported));
-  return pdpi::IrEntitiesToPi(
-      ir_p4info, ir_entities,
-      pdpi::TranslationOptions{.allow_unsupported = allow_unsupported});
+  ASSIGN_OR_RETURN(TranslationCache * cache,
+                   GetTranslationCache(ir_p4info, allow_unsupported));
+  const pdpi::TranslationOptions options{.allow_unsupported =
+                                             allow_unsupported};
+  std::vector<p4::v1::Entity> pi_entities;
+  pi_entities.reserve(cache->entities.size());
+  for (TranslationCache::Entity& entity : cache->entities) {
+    if (!entity.pi.has_value()) {
+      ASSIGN_OR_RETURN(entity.pi,
+                       pdpi::IrEntityToPi(ir_p4info, entity.ir, options));
+    }
+    pi_entities.push_back(*entity.pi);
+  }
+  return pi_entities;
 }
 
 absl::StatusOr<pdpi::IrEntities> EntryBuilder::GetDedupedIrEntities(
     const pdpi::IrP4Info& ir_p4info, bool allow_unsupported) const {
-  ASSIGN_OR_RETURN(
-      pdpi::IrEntities ir_entities,
-      pdpi::PdTableEntriesToIrEntities(
-          ir_p4info, entries_,
-          pdpi::TranslationOptions{.allow_unsupported = allow_unsupported}));
-  gutil::InefficientProtoSortAndDedup(*ir_entities.mutable_entities());
+  ASSIGN_OR_RETURN(TranslationCache * cache,
+                   GetTranslationCache(ir_p4info, allow_unsupported));
+  pdpi::IrEntities ir_entities;
+  ir_entities.mutable_entities()->Reserve(cache->entities.size());
+  for (const TranslationCache::Entity& entity : cache->entities) {
+    *ir_entities.add_entities() = entity.ir;
+  }
   return ir_entities;
 }
 
+EntryBuilder& EntryBuilder::AddEntries(const sai::TableEntries& entries) {
+  entries_.mutable_entries()->MergeFrom(entries.entries());
+  return *this;
+}
+
 EntryBuilder& EntryBuilder::AddVrfEntry(absl::string_view vrf) {
   sai::TableEntry& entry = *entries_.add_entries();
   entry = gutil::ParseProtoOrDie<sai::TableEntry>(R"pb(
@@ -20,10 +20,13 @@
 #ifndef GOOGLE_SAI_P4_INSTANTIATIONS_GOOGLE_TEST_TOOLS_TEST_ENTRIES_H_
 #define GOOGLE_SAI_P4_INSTANTIATIONS_GOOGLE_TEST_TOOLS_TEST_ENTRIES_H_
 
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/base/attributes.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "p4/v1/p4runtime.pb.h"
@@ -57,6 +60,12 @@ enum class IpVersion {
 //       .AddEntryPuntingAllPackets(PuntAction::kCopy)
 //       .GetDedupedIrEntities());
 // ```
+//
+// Each added entry is translated at most once per IrP4Info: repeated calls to
+// `GetDeduped*Entities` with the same `ir_p4info` object (and options) only
+// translate entries added since the previous call. The IrP4Info must therefore
+// not be modified between such calls. Calls to `GetDeduped*Entities` on the
+// same builder must not run concurrently.
 class EntryBuilder {
  public:
   EntryBuilder() = default;
@@ -67,11 +76,16 @@ class EntryBuilder {
   const EntryBuilder& LogPdEntries() const;
   EntryBuilder& LogPdEntries();
 
+  // Returns the added entries, translated and with duplicates removed, in an
+  // arbitrary but deterministic order.
   absl::StatusOr<std::vector<p4::v1::Entity>> GetDedupedPiEntities(
       const pdpi::IrP4Info& ir_p4info, bool allow_unsupported = false) const;
   absl::StatusOr<pdpi::IrEntities> GetDedupedIrEntities(
       const pdpi::IrP4Info& ir_p4info, bool allow_unsupported = false) const;
 
+  // Adds all of `entries`, e.g. a pregenerated set of entries.
+  EntryBuilder& AddEntries(const sai::TableEntries& entries);
+
   EntryBuilder& AddEntryPuntingAllPackets(PuntAction action);
   EntryBuilder& AddEntriesForwardingIpPacketsToGivenPort(
       absl::string_view egress_port);
@@ -86,7 +100,36 @@ class EntryBuilder {
       absl::string_view vrf);
 
  private:
+  // The translations of `entries_` for one IrP4Info and set of options.
+  struct TranslationCache {
+    struct Entity {
+      // The key `GetDeduped*Entities` sorts by.
+      std::string sort_key;
+      pdpi::IrEntity ir;
+      // Translated on first use.
+      std::optional<p4::v1::Entity> pi;
+    };
+
+    const pdpi::IrP4Info* ir_p4info = nullptr;
+    bool allow_unsupported = false;
+    // The number of `entries_` translated so far. Entries are only ever
+    // appended, so these are the first `num_translated_entries` entries.
+    int num_translated_entries = 0;
+    // The distinct translated entities, sorted by `sort_key` unless `sorted` is
+    // false.
+    std::vector<Entity> entities;
+    bool sorted = true;
+    // The deterministic serializations of `entities`, for deduplication.
+    absl::flat_hash_set<std::string> serialized_entities;
+  };
+
+  // Translates the entries added since the last call and returns the cache.
+  // Starts over if `ir_p4info` or `allow_unsupported` changed since then.
+  absl::StatusOr<TranslationCache*> GetTranslationCache(
+      const pdpi::IrP4Info& ir_p4info, bool allow_unsupported) const;
+
   sai::TableEntries entries_;
+  mutable TranslationCache translation_cache_;
 };
 
 // Returns an ACL table entry that punts all packets to the controller using the
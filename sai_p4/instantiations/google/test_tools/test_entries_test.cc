@@ -24,6 +24,7 @@
 #include "gutil/status_matchers.h"
 #include "gutil/testing.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/ir.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/pd.h"
 #include "sai_p4/instantiations/google/instantiations.h"
@@ -169,6 +170,65 @@ TEST(EntryBuilder, GetDedupedEntitiesRemovesDuplicates) {
       IsOkAndHolds(Pointwise(EqualsProto(), deduped_pi_entities)));
 }
 
+TEST(EntryBuilder, GetDedupedEntitiesTranslatesEntriesAddedAfterEarlierCalls) {
+  pdpi::IrP4Info kIrP4Info = GetIrP4Info(Instantiation::kFabricBorderRouter);
+  EntryBuilder builder;
+  builder.AddVrfEntry("vrf-1");
+  ASSERT_OK_AND_ASSIGN(pdpi::IrEntities first,
+                       builder.GetDedupedIrEntities(kIrP4Info));
+  EXPECT_THAT(first.entities(), SizeIs(1));
+
+  builder.AddVrfEntry("vrf-2").AddVrfEntry("vrf-1");
+  ASSERT_OK_AND_ASSIGN(pdpi::IrEntities second,
+                       builder.GetDedupedIrEntities(kIrP4Info));
+  EXPECT_THAT(second.entities(), SizeIs(2));
+
+  // The result matches that of a builder that never cached translations.
+  EXPECT_THAT(EntryBuilder()
+                  .AddVrfEntry("vrf-1")
+                  .AddVrfEntry("vrf-2")
+                  .GetDedupedIrEntities(kIrP4Info),
+              IsOkAndHolds(EqualsProto(second)));
+  ASSERT_OK_AND_ASSIGN(std::vector<p4::v1::Entity> pi_entities,
+                       pdpi::IrEntitiesToPi(kIrP4Info, second));
+  EXPECT_THAT(builder.GetDedupedPiEntities(kIrP4Info),
+              IsOkAndHolds(Pointwise(EqualsProto(), pi_entities)));
+}
+
+TEST(EntryBuilder, GetDedupedEntitiesHonorsChangedTranslationOptions) {
+  pdpi::IrP4Info kIrP4Info = GetIrP4Info(Instantiation::kFabricBorderRouter);
+  EntryBuilder builder;
+  builder.AddEntryDecappingAllIpInIpv6PacketsAndSettingVrf("vrf-1");
+  EXPECT_OK(builder.GetDedupedIrEntities(kIrP4Info,
+                                         /*allow_unsupported=*/true));
+  EXPECT_FALSE(builder.GetDedupedIrEntities(kIrP4Info).ok());
+}
+
+TEST(EntryBuilder, AddEntriesAddsAllEntries) {
+  pdpi::IrP4Info kIrP4Info = GetIrP4Info(Instantiation::kFabricBorderRouter);
+  auto entries = gutil::ParseProtoOrDie<sai::TableEntries>(
+      R"pb(
+        entries {
+          vrf_table_entry {
+            match { vrf_id: "vrf-1" }
+            action { no_action {} }
+          }
+        }
+        entries {
+          vrf_table_entry {
+            match { vrf_id: "vrf-2" }
+            action { no_action {} }
+          }
+        }
+      )pb");
+  ASSERT_OK_AND_ASSIGN(pdpi::IrEntities entities,
+                       EntryBuilder()
+                           .AddVrfEntry("vrf-1")
+                           .AddEntries(entries)
+                           .GetDedupedIrEntities(kIrP4Info));
+  EXPECT_THAT(entities.entities(), SizeIs(2));
+}
+
 TEST(EntryBuilder, AddEntryPuntingAllPacketsDoesNotAddEntry) {
   pdpi::IrP4Info kIrP4Info = GetIrP4Info(Instantiation::kFabricBorderRouter);
   ASSERT_OK_AND_ASSIGN(pdpi::IrEntities entities,
@@ -14,10 +14,88 @@
 
 #include "sai_p4/tools/auxiliary_entries_for_v1model_targets.h"
 
+#include <bitset>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "gutil/status.h"
 #include "p4/v1/p4runtime.pb.h"
+#include "p4_pdpi/string_encodings/byte_string.h"
 #include "sai_p4/fixed/ids.h"
 
 namespace sai {
+namespace {
+
+// Returns the match key of a `mirror_session_table` entry.
+absl::StatusOr<std::string> MirrorSessionKey(const p4::v1::TableEntry& entry) {
+  if (entry.match_size() != 1 || !entry.match(0).has_exact()) {
+    return gutil::InvalidArgumentErrorBuilder()
+           << "Expected a single exact match in mirror_session_table entry: "
+           << entry.ShortDebugString();
+  }
+  return entry.match(0).exact().value();
+}
+
+// Returns the mirror port of a `mirror_session_table` entry, in canonical
+// form so that equal ports compare equal.
+absl::StatusOr<std::string> MirrorPort(const p4::v1::TableEntry& entry) {
+  if (entry.action().action().action_id() ==
+      MIRRORING_MIRROR_AS_IPV4_ERSPAN_ACTION_ID) {
+    for (const p4::v1::Action::Param& param :
+         entry.action().action().params()) {
+      if (param.param_id() == 1) {
+        return pdpi::ByteStringToP4runtimeByteString(param.value());
+      }
+    }
+  }
+  return gutil::InvalidArgumentErrorBuilder()
+         << "Expected a mirror_as_ipv4_erspan action with a port in "
+            "mirror_session_table entry: "
+         << entry.ShortDebugString();
+}
+
+// Returns the entities that mirror packets to `port`, in the order they need
+// to be inserted.
+absl::StatusOr<std::vector<p4::v1::Entity>> MakeMirrorPortEntities(
+    const std::string& port) {
+  ASSIGN_OR_RETURN(std::bitset<32> port_number,
+                   pdpi::ByteStringToBitset<32>(port));
+  const uint32_t session_id =
+      kV1modelMirrorSessionIdOffset + port_number.to_ulong();
+  std::vector<p4::v1::Entity> entities(2);
+
+  p4::v1::CloneSessionEntry& clone_session =
+      *entities[0]
+           .mutable_packet_replication_engine_entry()
+           ->mutable_clone_session_entry();
+  clone_session.set_session_id(session_id);
+  p4::v1::Replica& replica = *clone_session.add_replicas();
+  replica.set_egress_port(port_number.to_ulong());
+  replica.set_instance(CLONE_REPLICA_INSTANCE_MIRRORING);
+
+  p4::v1::TableEntry& table_entry = *entities[1].mutable_table_entry();
+  table_entry.set_table_id(MIRROR_PORT_TO_PRE_SESSION_TABLE_ID);
+  p4::v1::FieldMatch& match = *table_entry.add_match();
+  match.set_field_id(1);
+  match.mutable_exact()->set_value(port);
+  p4::v1::Action& action = *table_entry.mutable_action()->mutable_action();
+  action.set_action_id(MIRRORING_SET_PRE_SESSION_ACTION_ID);
+  p4::v1::Action::Param& param = *action.add_params();
+  param.set_param_id(1);
+  param.set_value(
+      pdpi::BitsetToP4RuntimeByteString(std::bitset<32>(session_id)));
+
+  return entities;
+}
+
+}  // namespace
 
 p4::v1::Entity MakeV1modelPacketReplicationEngineEntryRequiredForPunts() {
   p4::v1::Entity entity;
@@ -33,4 +111,125 @@ p4::v1::Entity MakeV1modelPacketReplicationEngineEntryRequiredForPunts() {
   return entity;
 }
 
+std::vector<p4::v1::Entity>
+V1modelAuxiliaryEntityTracker::GetAuxiliaryEntities() const {
+  std::vector<p4::v1::Entity> entities = {
+      MakeV1modelPacketReplicationEngineEntryRequiredForPunts()};
+  for (const auto& [port, count] : mirror_session_count_by_port_) {
+    // The port was validated when it was applied.
+    absl::StatusOr<std::vector<p4::v1::Entity>> port_entities =
+        MakeMirrorPortEntities(port);
+    if (port_entities.ok()) {
+      entities.insert(entities.end(), port_entities->begin(),
+                      port_entities->end());
+    }
+  }
+  return entities;
+}
+
+absl::StatusOr<std::vector<p4::v1::Update>>
+V1modelAuxiliaryEntityTracker::Apply(
+    absl::Span<const p4::v1::Update> updates) {
+  // The changes are staged, so that nothing is applied if an update fails.
+  // A staged session without a port is deleted.
+  absl::flat_hash_map<std::string, std::optional<std::string>> staged_sessions;
+  absl::btree_map<std::string, int> session_count_delta_by_port;
+  auto current_port =
+      [&](const std::string& key) -> std::optional<std::string> {
+    if (auto it = staged_sessions.find(key); it != staged_sessions.end()) {
+      return it->second;
+    }
+    if (auto it = port_by_mirror_session_.find(key);
+        it != port_by_mirror_session_.end()) {
+      return it->second;
+    }
+    return std::nullopt;
+  };
+
+  for (const p4::v1::Update& update : updates) {
+    if (!update.entity().has_table_entry() ||
+        update.entity().table_entry().table_id() != MIRROR_SESSION_TABLE_ID) {
+      continue;
+    }
+    const p4::v1::TableEntry& entry = update.entity().table_entry();
+    ASSIGN_OR_RETURN(std::string key, MirrorSessionKey(entry));
+    std::optional<std::string> old_port = current_port(key);
+    std::optional<std::string> new_port;
+    switch (update.type()) {
+      case p4::v1::Update::INSERT:
+        if (old_port.has_value()) {
+          return gutil::AlreadyExistsErrorBuilder()
+                 << "Mirror session already exists: "
+                 << entry.ShortDebugString();
+        }
+        break;
+      case p4::v1::Update::MODIFY:
+      case p4::v1::Update::DELETE:
+        if (!old_port.has_value()) {
+          return gutil::NotFoundErrorBuilder()
+                 << "Mirror session does not exist: "
+                 << entry.ShortDebugString();
+        }
+        break;
+      default:
+        return gutil::InvalidArgumentErrorBuilder()
+               << "Unsupported update type: " << update.ShortDebugString();
+    }
+    if (update.type() != p4::v1::Update::DELETE) {
+      ASSIGN_OR_RETURN(new_port, MirrorPort(entry));
+      // Fails early on ports that cannot be mirrored to.
+      RETURN_IF_ERROR(MakeMirrorPortEntities(*new_port).status());
+      ++session_count_delta_by_port[*new_port];
+    }
+    if (old_port.has_value()) --session_count_delta_by_port[*old_port];
+    staged_sessions[key] = std::move(new_port);
+  }
+
+  // Deletions come first, to free resources for the insertions.
+  std::vector<p4::v1::Update> auxiliary_updates;
+  std::vector<p4::v1::Update> insertions;
+  for (const auto& [port, delta] : session_count_delta_by_port) {
+    const int old_count = mirror_session_count_by_port_.contains(port)
+                              ? mirror_session_count_by_port_[port]
+                              : 0;
+    const int new_count = old_count + delta;
+    if ((old_count == 0) == (new_count == 0)) continue;
+    ASSIGN_OR_RETURN(std::vector<p4::v1::Entity> entities,
+                     MakeMirrorPortEntities(port));
+    if (new_count == 0) {
+      // Deletes in reverse order of insertion, so the table entry never
+      // refers to a missing clone session.
+      for (auto it = entities.rbegin(); it != entities.rend(); ++it) {
+        p4::v1::Update& auxiliary_update = auxiliary_updates.emplace_back();
+        auxiliary_update.set_type(p4::v1::Update::DELETE);
+        *auxiliary_update.mutable_entity() = std::move(*it);
+      }
+    } else {
+      for (auto it = entities.begin(); it != entities.end(); ++it) {
+        p4::v1::Update& auxiliary_update = insertions.emplace_back();
+        auxiliary_update.set_type(p4::v1::Update::INSERT);
+        *auxiliary_update.mutable_entity() = std::move(*it);
+      }
+    }
+  }
+  auxiliary_updates.insert(auxiliary_updates.end(),
+                           std::make_move_iterator(insertions.begin()),
+                           std::make_move_iterator(insertions.end()));
+
+  // Commits the staged changes.
+  for (auto& [key, port] : staged_sessions) {
+    if (port.has_value()) {
+      port_by_mirror_session_[key] = *std::move(port);
+    } else {
+      port_by_mirror_session_.erase(key);
+    }
+  }
+  for (const auto& [port, delta] : session_count_delta_by_port) {
+    int& count = mirror_session_count_by_port_[port];
+    count += delta;
+    if (count == 0) mirror_session_count_by_port_.erase(port);
+  }
+  return auxiliary_updates;
+}
+
 }  // namespace sai
@@ -22,6 +22,14 @@
 #ifndef GOOGLE_SAI_P4_TOOLS_AUXILIARY_ENTRIES_FOR_V1MODEL_TARGETS_H_
 #define GOOGLE_SAI_P4_TOOLS_AUXILIARY_ENTRIES_FOR_V1MODEL_TARGETS_H_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "p4/v1/p4runtime.pb.h"
 
 namespace sai {
@@ -34,6 +42,45 @@ namespace sai {
 // Not required by PINS targets, since PINS has this config built-in.
 p4::v1::Entity MakeV1modelPacketReplicationEngineEntryRequiredForPunts();
 
+// The Packet Replication Engine clone session that mirrors packets to the port
+// with the given v1model port number is this offset plus the port number. It
+// is above the range of v1model ports, and so of `COPY_TO_CPU_SESSION_ID`.
+inline constexpr uint32_t kV1modelMirrorSessionIdOffset = 1024;
+
+// Keeps track of the auxiliary entities that native v1model targets need for a
+// changing set of entities, so that keeping a target in sync after an update
+// does not require rederiving them from all entities.
+//
+// Besides `MakeV1modelPacketReplicationEngineEntryRequiredForPunts`, v1model
+// targets need, for every port used by a `mirror_session_table` entry, a
+// `mirror_port_to_pre_session_table` entry and a clone session that sends the
+// mirrored packets out of that port. PINS targets derive both from the mirror
+// session themselves. Ports must use the v1model encoding, i.e. be numbers
+// rather than translated port names.
+//
+// Not thread-safe.
+class V1modelAuxiliaryEntityTracker {
+ public:
+  // Returns the auxiliary entities needed for the entities applied so far,
+  // e.g. to install on a fresh target.
+  std::vector<p4::v1::Entity> GetAuxiliaryEntities() const;
+
+  // Applies `updates`, which must be valid against the entities applied so
+  // far, and returns the changes to the auxiliary entities they cause as
+  // DELETE updates followed by INSERT updates. Fails without applying anything
+  // if an update inserts an existing entry or modifies or deletes a missing
+  // one.
+  absl::StatusOr<std::vector<p4::v1::Update>> Apply(
+      absl::Span<const p4::v1::Update> updates);
+
+ private:
+  // The mirror port of each `mirror_session_table` entry, by match key.
+  absl::flat_hash_map<std::string, std::string> port_by_mirror_session_;
+  // The number of mirror sessions using each mirror port. Ordered to make
+  // the output deterministic.
+  absl::btree_map<std::string, int> mirror_session_count_by_port_;
+};
+
 }  // namespace sai
 
 #endif  // GOOGLE_SAI_P4_TOOLS_AUXILIARY_ENTRIES_FOR_V1MODEL_TARGETS_H_
@@ -0,0 +1,190 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "sai_p4/tools/auxiliary_entries_for_v1model_targets.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/proto_matchers.h"
+#include "gutil/status_matchers.h"
+#include "gutil/testing.h"
+#include "p4/v1/p4runtime.pb.h"
+
+namespace sai {
+namespace {
+
+using ::gutil::EqualsProto;
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::p4::v1::Update;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// Returns an update of a `mirror_session_table` entry mirroring to `port`.
+p4::v1::Update MirrorSessionUpdate(p4::v1::Update::Type type,
+                                   absl::string_view session_id,
+                                   absl::string_view port) {
+  return gutil::ParseProtoOrDie<p4::v1::Update>(absl::Substitute(
+      R"pb(
+        type: $0
+        entity {
+          table_entry {
+            table_id: 33554502  # mirror_session_table
+            match {
+              field_id: 1
+              exact { value: "$1" }
+            }
+            action {
+              action {
+                action_id: 16777223  # mirror_as_ipv4_erspan
+                params { param_id: 1 value: "$2" }
+                params { param_id: 2 value: "\001\002\003\004" }
+              }
+            }
+          }
+        }
+      )pb",
+      p4::v1::Update::Type_Name(type), session_id, port));
+}
+
+// The updates of the auxiliary entities for mirror port 3.
+constexpr char kPort3CloneSession[] = R"pb(
+  entity {
+    packet_replication_engine_entry {
+      clone_session_entry {
+        session_id: 1027
+        replicas { egress_port: 3 instance: 2 }
+      }
+    }
+  }
+)pb";
+constexpr char kPort3PreSessionEntry[] = R"pb(
+  entity {
+    table_entry {
+      table_id: 33554504  # mirror_port_to_pre_session_table
+      match {
+        field_id: 1
+        exact { value: "\003" }
+      }
+      action {
+        action {
+          action_id: 16777225  # set_pre_session
+          params { param_id: 1 value: "\004\003" }
+        }
+      }
+    }
+  }
+)pb";
+
+std::string WithType(absl::string_view type, absl::string_view update) {
+  return absl::StrCat("type: ", type, " ", update);
+}
+
+TEST(V1modelAuxiliaryEntityTrackerTest, OnlyNeedsThePuntEntryInitially) {
+  V1modelAuxiliaryEntityTracker tracker;
+  EXPECT_THAT(tracker.GetAuxiliaryEntities(),
+              ElementsAre(EqualsProto(
+                  MakeV1modelPacketReplicationEngineEntryRequiredForPunts())));
+}
+
+TEST(V1modelAuxiliaryEntityTrackerTest, AddsAndRemovesMirrorPortEntities) {
+  V1modelAuxiliaryEntityTracker tracker;
+  EXPECT_THAT(
+      tracker.Apply({MirrorSessionUpdate(Update::INSERT, "a", "\\003")}),
+      IsOkAndHolds(
+          ElementsAre(EqualsProto(WithType("INSERT", kPort3CloneSession)),
+                      EqualsProto(WithType("INSERT", kPort3PreSessionEntry)))));
+  EXPECT_EQ(tracker.GetAuxiliaryEntities().size(), 3);
+
+  EXPECT_THAT(
+      tracker.Apply({MirrorSessionUpdate(Update::DELETE, "a", "\\003")}),
+      IsOkAndHolds(
+          ElementsAre(EqualsProto(WithType("DELETE", kPort3PreSessionEntry)),
+                      EqualsProto(WithType("DELETE", kPort3CloneSession)))));
+  EXPECT_EQ(tracker.GetAuxiliaryEntities().size(), 1);
+}
+
+TEST(V1modelAuxiliaryEntityTrackerTest, SharesEntitiesBetweenSessions) {
+  V1modelAuxiliaryEntityTracker tracker;
+  ASSERT_OK_AND_ASSIGN(
+      std::vector<p4::v1::Update> updates,
+      tracker.Apply(
+          {MirrorSessionUpdate(Update::INSERT, "a", "\\003"),
+           // Non-canonical encodings of the same port.
+           MirrorSessionUpdate(Update::INSERT, "b", "\\000\\003")}));
+  EXPECT_EQ(updates.size(), 2);
+
+  // The port is still used by "b".
+  EXPECT_THAT(tracker.Apply({MirrorSessionUpdate(Update::DELETE, "a",
+                                                 "\\003")}),
+              IsOkAndHolds(IsEmpty()));
+  // Moving "b" to another port replaces the entities of port 3.
+  ASSERT_OK_AND_ASSIGN(updates, tracker.Apply({MirrorSessionUpdate(
+                                    Update::MODIFY, "b", "\\005")}));
+  ASSERT_EQ(updates.size(), 4);
+  EXPECT_THAT(updates[0],
+              EqualsProto(WithType("DELETE", kPort3PreSessionEntry)));
+  EXPECT_THAT(updates[1], EqualsProto(WithType("DELETE", kPort3CloneSession)));
+  EXPECT_EQ(updates[2].type(), Update::INSERT);
+  EXPECT_EQ(updates[2]
+                .entity()
+                .packet_replication_engine_entry()
+                .clone_session_entry()
+                .session_id(),
+            1029);
+}
+
+TEST(V1modelAuxiliaryEntityTrackerTest, ChangesWithinABatchCancelOut) {
+  V1modelAuxiliaryEntityTracker tracker;
+  EXPECT_THAT(
+      tracker.Apply({MirrorSessionUpdate(Update::INSERT, "a", "\\003"),
+                     MirrorSessionUpdate(Update::DELETE, "a", "")}),
+      IsOkAndHolds(IsEmpty()));
+  EXPECT_EQ(tracker.GetAuxiliaryEntities().size(), 1);
+}
+
+TEST(V1modelAuxiliaryEntityTrackerTest, IgnoresOtherEntities) {
+  V1modelAuxiliaryEntityTracker tracker;
+  EXPECT_THAT(tracker.Apply({gutil::ParseProtoOrDie<p4::v1::Update>(R"pb(
+                type: INSERT
+                entity { table_entry { table_id: 33554497 } }
+              )pb")}),
+              IsOkAndHolds(IsEmpty()));
+}
+
+TEST(V1modelAuxiliaryEntityTrackerTest, InvalidBatchesAreNotApplied) {
+  V1modelAuxiliaryEntityTracker tracker;
+  EXPECT_THAT(
+      tracker.Apply({MirrorSessionUpdate(Update::INSERT, "a", "\\003"),
+                     MirrorSessionUpdate(Update::INSERT, "a", "\\003")}),
+      StatusIs(absl::StatusCode::kAlreadyExists));
+  EXPECT_THAT(
+      tracker.Apply({MirrorSessionUpdate(Update::INSERT, "a", "\\003"),
+                     MirrorSessionUpdate(Update::MODIFY, "b", "\\003")}),
+      StatusIs(absl::StatusCode::kNotFound));
+  // Port names, as used by PINS targets, cannot be mirrored to.
+  EXPECT_THAT(tracker.Apply({MirrorSessionUpdate(Update::INSERT, "a",
+                                                 "Ethernet1/1/1")}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(tracker.GetAuxiliaryEntities().size(), 1);
+}
+
+}  // namespace
+}  // namespace sai
@@ -15,11 +15,16 @@
 #include "tests/forwarding/util.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <optional>
 #include <sstream>
+#include <vector>
 
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "gutil/status.h"
+#include "gutil/token_bucket.h"
 #include "p4_pdpi/ir.pb.h"
 #include "sai_p4/tools/packetio_tools.h"
 
@@ -67,6 +72,55 @@ absl::Status InjectEgressPacket(const std::string& port,
                    << request.ShortDebugString();
 }
 
+absl::Status InjectEgressPackets(absl::Span<const EgressPacket> packets,
+                                 const pdpi::IrP4Info& p4info,
+                                 pdpi::P4RuntimeSession* p4rt,
+                                 const PacketInjectionOptions& options) {
+  // Assemble P4Runtime requests.
+  std::vector<p4::v1::StreamMessageRequest> requests(packets.size());
+  for (int i = 0; i < packets.size(); ++i) {
+    ASSIGN_OR_RETURN(
+        *requests[i].mutable_packet(),
+        sai::MakePiPacketOutMessage(p4info, sai::PacketOutMetadata{
+                                                .submit_to_ingress = false,
+                                                .payload = packets[i].packet,
+                                                .egress_port = packets[i].port,
+                                            }));
+  }
+  return WriteStreamMessageRequests(requests, p4rt, options);
+}
+
+absl::Status WriteStreamMessageRequests(
+    absl::Span<const p4::v1::StreamMessageRequest> requests,
+    pdpi::P4RuntimeSession* p4rt, const PacketInjectionOptions& options) {
+  RET_CHECK(options.max_batch_size > 0)
+      << "max_batch_size should be greater than 0";
+  std::optional<gutil::TokenBucket> token_bucket;
+  if (options.packets_per_second.has_value()) {
+    RET_CHECK(*options.packets_per_second > 0)
+        << "packets_per_second should be greater than 0";
+    token_bucket.emplace(*options.packets_per_second, options.max_batch_size);
+  }
+
+  while (!requests.empty()) {
+    int64_t batch_size =
+        std::min<int64_t>(options.max_batch_size, requests.size());
+    if (token_bucket.has_value()) {
+      batch_size = token_bucket->Acquire(batch_size);
+    }
+    absl::Span<const p4::v1::StreamMessageRequest> batch =
+        requests.subspan(0, batch_size);
+    if (!p4rt->StreamChannelWriteBatch(batch)) {
+      return gutil::InternalErrorBuilder()
+             << "Failed to write batch of " << batch.size()
+             << " stream message requests, starting with: "
+             << batch.front().ShortDebugString();
+    }
+    requests.remove_prefix(batch_size);
+  }
+  return absl::OkStatus();
+}
+
 absl::Status InjectIngressPacket(const std::string& packet,
                                  const pdpi::IrP4Info& p4info,
                                  pdpi::P4RuntimeSession* p4rt,
@@ -16,11 +16,13 @@
 #define PINS_TESTS_FORWARDING_UTIL_H_
 
 #include <functional>
+#include <optional>
 #include <string>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "p4_pdpi/ir.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
 
@@ -55,6 +57,37 @@ absl::Status InjectIngressPacket(
     pdpi::P4RuntimeSession* p4rt,
     std::optional<absl::Duration> packet_delay = std::nullopt);
 
+// A packet to be injected at the egress `port` of a switch.
+struct EgressPacket {
+  std::string port;
+  std::string packet;
+};
+
+struct PacketInjectionOptions {
+  // If set, packets are paced to this average rate by a token bucket instead
+  // of sleeping a fixed delay before each packet.
+  std::optional<double> packets_per_second;
+  // The number of PacketOuts written back to back in one batch. Also the burst
+  // size of the token bucket, i.e. how far ahead of the average rate the
+  // injection may get after falling behind.
+  int max_batch_size = 64;
+};
+
+// Injects the given test packets via packetIO at the egress ports specified by
+// the test packets, using the given P4RT session. All PacketOuts are built
+// before any is sent, and are then written in batches of buffered stream
+// writes (see `P4RuntimeSession::StreamChannelWriteBatch`).
+absl::Status InjectEgressPackets(absl::Span<const EgressPacket> packets,
+                                 const pdpi::IrP4Info& p4info,
+                                 pdpi::P4RuntimeSession* p4rt,
+                                 const PacketInjectionOptions& options = {});
+
+// Writes the given `requests` to the stream channel of the given P4RT session
+// in batches, pacing them as specified by `options`.
+absl::Status WriteStreamMessageRequests(
+    absl::Span<const p4::v1::StreamMessageRequest> requests,
+    pdpi::P4RuntimeSession* p4rt, const PacketInjectionOptions& options = {});
+
 // -- END OF PUBLIC INTERFACE -- implementation details follow -----------------
 
 template <class T>
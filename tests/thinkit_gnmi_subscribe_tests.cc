@@ -14,30 +14,211 @@
 
 #include "tests/thinkit_gnmi_subscribe_tests.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT: third_party code.
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "glog/logging.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "gutil/status.h"
 #include "gutil/status_matchers.h"
 #include "lib/gnmi/gnmi_helper.h"
 #include "p4/v1/p4runtime.grpc.pb.h"
 #include "p4_pdpi/p4_runtime_session.h"
+#include "p4rt_app/utils/latency_histogram.h"
 #include "proto/gnmi/gnmi.grpc.pb.h"
 #include "proto/gnmi/gnmi.pb.h"
 #include "include/nlohmann/json.hpp"
 #include "tests/thinkit_util.h"
+#include "thinkit/control_device.h"
+#include "thinkit/generic_testbed.h"
+#include "thinkit/proto/generic_testbed.pb.h"
 #include "thinkit/ssh_client.h"
 #include "thinkit/switch.h"
 
 namespace pins_test {
 
 constexpr absl::Duration kSubscribeWaitTime = absl::Seconds(100);
+// How long the scale test waits for subscriptions to sync, and for every
+// subscription to receive a link state change.
+constexpr absl::Duration kSyncTimeout = absl::Minutes(2);
+constexpr absl::Duration kEventTimeout = absl::Minutes(1);
+
+namespace {
+
+using ::p4rt_app::LatencyHistogram;
+
+// A Subscribe RPC whose responses are recorded, with the time they were
+// received, by a background thread.
+class RecordingSubscription {
+ public:
+  // Records the updates of a single leaf, e.g. an oper-status.
+  static constexpr absl::Duration kRecordEveryUpdate = absl::ZeroDuration();
+
+  // Notifications received less than `min_sample_gap` after the last recorded
+  // one belong to the same sample, and are not recorded.
+  explicit RecordingSubscription(absl::Duration min_sample_gap)
+      : min_sample_gap_(min_sample_gap) {}
+
+  ~RecordingSubscription() {
+    context_.TryCancel();
+    if (reader_.joinable()) reader_.join();
+  }
+
+  // Sends `request` and starts recording the responses.
+  absl::Status Start(gnmi::gNMI::StubInterface& stub,
+                     const gnmi::SubscribeRequest& request) {
+    stream_ = stub.Subscribe(&context_);
+    if (stream_ == nullptr || !stream_->Write(request)) {
+      return gutil::UnavailableErrorBuilder()
+             << "Failed to send subscription: " << request.ShortDebugString();
+    }
+    reader_ = std::thread([this] { Read(); });
+    return absl::OkStatus();
+  }
+
+  // Waits until the initial updates have all been received.
+  absl::Status WaitForSync(absl::Duration timeout) {
+    absl::MutexLock l(&mu_);
+    if (!mu_.AwaitWithTimeout(absl::Condition(&synced_), timeout)) {
+      return gutil::DeadlineExceededErrorBuilder()
+             << "Subscription did not sync within " << timeout;
+    }
+    return absl::OkStatus();
+  }
+
+  // Returns when the first update to `value` after `after` was received.
+  std::optional<absl::Time> FirstUpdateAfter(absl::Time after,
+                                             absl::string_view value) const {
+    absl::MutexLock l(&mu_);
+    for (const auto& [time, update_value] : updates_) {
+      if (time > after && absl::StrContains(update_value, value)) return time;
+    }
+    return std::nullopt;
+  }
+
+  // Returns the times at which samples were received.
+  std::vector<absl::Time> Samples() const {
+    absl::MutexLock l(&mu_);
+    std::vector<absl::Time> samples;
+    for (const auto& [time, value] : updates_) samples.push_back(time);
+    return samples;
+  }
+
+ private:
+  void Read() {
+    gnmi::SubscribeResponse response;
+    while (stream_->Read(&response)) {
+      const absl::Time now = absl::Now();
+      absl::MutexLock l(&mu_);
+      if (response.sync_response()) synced_ = true;
+      if (!response.has_update()) continue;
+      if (min_sample_gap_ > absl::ZeroDuration()) {
+        if (updates_.empty() ||
+            now - updates_.back().first >= min_sample_gap_) {
+          updates_.push_back({now, ""});
+        }
+        continue;
+      }
+      for (const gnmi::Update& update : response.update().update()) {
+        const gnmi::TypedValue& value = update.val();
+        updates_.push_back({now, value.has_json_ietf_val()
+                                     ? value.json_ietf_val()
+                                     : value.string_val()});
+      }
+    }
+  }
+
+  const absl::Duration min_sample_gap_;
+  grpc::ClientContext context_;
+  std::unique_ptr<grpc::ClientReaderWriterInterface<gnmi::SubscribeRequest,
+                                                    gnmi::SubscribeResponse>>
+      stream_;
+  std::thread reader_;
+
+  mutable absl::Mutex mu_;
+  bool synced_ ABSL_GUARDED_BY(mu_) = false;
+  std::vector<std::pair<absl::Time, std::string>> updates_
+      ABSL_GUARDED_BY(mu_);
+};
+
+// Returns `value` as an integer, whether it is encoded as a JSON number or as
+// a string (as 64-bit integers are in JSON IETF).
+int64_t JsonToInt(const nlohmann::json& value) {
+  int64_t result = 0;
+  if (value.is_number()) return value.get<int64_t>();
+  if (value.is_string()) {
+    absl::SimpleAtoi(value.get<std::string>(), &result);
+  }
+  return result;
+}
+
+// The resources used by all processes of the switch.
+struct SwitchResourceUsage {
+  int64_t cpu_utilization = 0;  // Sum over all processes, in percent.
+  int64_t memory_usage = 0;     // Sum over all processes, in bytes.
+  // The process using the most CPU.
+  std::string busiest_process;
+  int64_t busiest_process_cpu_utilization = 0;
+
+  std::string ToString() const {
+    return absl::StrCat("cpu-utilization: ", cpu_utilization,
+                        "%, memory-usage: ", memory_usage,
+                        " bytes, busiest process: ", busiest_process, " (",
+                        busiest_process_cpu_utilization, "%)");
+  }
+};
+
+absl::StatusOr<SwitchResourceUsage> GetSwitchResourceUsage(
+    gnmi::gNMI::StubInterface& stub) {
+  ASSIGN_OR_RETURN(std::string response,
+                   GetGnmiStatePathInfo(&stub, "system/processes",
+                                        "openconfig-system:processes"));
+  const nlohmann::json processes = nlohmann::json::parse(
+      response, /*cb=*/nullptr, /*allow_exceptions=*/false);
+  if (processes.is_discarded() || !processes.contains("process")) {
+    return gutil::InternalErrorBuilder()
+           << "Unexpected system/processes response: " << response;
+  }
+  SwitchResourceUsage usage;
+  for (const nlohmann::json& process : processes["process"]) {
+    if (!process.contains("state")) continue;
+    const nlohmann::json& state = process["state"];
+    const int64_t cpu_utilization = state.contains("cpu-utilization")
+                                        ? JsonToInt(state["cpu-utilization"])
+                                        : 0;
+    usage.cpu_utilization += cpu_utilization;
+    if (state.contains("memory-usage")) {
+      usage.memory_usage += JsonToInt(state["memory-usage"]);
+    }
+    if (cpu_utilization >= usage.busiest_process_cpu_utilization &&
+        state.contains("name")) {
+      usage.busiest_process = state["name"].get<std::string>();
+      usage.busiest_process_cpu_utilization = cpu_utilization;
+    }
+  }
+  return usage;
+}
+
+}  // namespace
 
 // This test subscribes to interface and component subtree for updates.
 void TestGnmiInterfaceAndComponentSubscribe(thinkit::Switch& sut) {
@@ -85,4 +266,146 @@ void TestGnmiInterfaceAndComponentSubscribe(thinkit::Switch& sut) {
   EXPECT_TRUE(intf_response_received);
 }
 
+void TestGnmiSubscribeScale(thinkit::GenericTestbed& testbed,
+                            const GnmiSubscribeScaleParams& params) {
+  std::string sut_interface;
+  std::string peer_interface;
+  for (const auto& [interface, info] : testbed.GetSutInterfaceInfo()) {
+    if (info.interface_modes.contains(thinkit::CONTROL_INTERFACE)) {
+      sut_interface = interface;
+      peer_interface = info.peer_interface_name;
+      break;
+    }
+  }
+  ASSERT_FALSE(sut_interface.empty())
+      << "The testbed has no SUT interface connected to the control device.";
+  ASSERT_OK_AND_ASSIGN(auto sut_gnmi_stub, testbed.Sut().CreateGnmiStub());
+
+  ASSERT_OK_AND_ASSIGN(SwitchResourceUsage baseline_usage,
+                       GetSwitchResourceUsage(*sut_gnmi_stub));
+  LOG(INFO) << "Switch resource usage without subscriptions: "
+            << baseline_usage.ToString();
+
+  // Opens the subscriptions.
+  auto make_request = [&](absl::string_view path, gnmi::SubscriptionMode mode) {
+    gnmi::SubscribeRequest request;
+    gnmi::SubscriptionList* subscription_list = request.mutable_subscribe();
+    subscription_list->set_mode(gnmi::SubscriptionList::STREAM);
+    subscription_list->mutable_prefix()->set_origin(kOpenconfigStr);
+    subscription_list->mutable_prefix()->set_target(kTarget);
+    AddSubtreeToGnmiSubscription(path, *subscription_list, mode,
+                                 /*suppress_redundant=*/false,
+                                 params.sample_interval);
+    return request;
+  };
+  const gnmi::SubscribeRequest on_change_request = make_request(
+      absl::StrCat("interfaces/interface[name=", sut_interface,
+                   "]/state/oper-status"),
+      gnmi::ON_CHANGE);
+  const gnmi::SubscribeRequest sample_request = make_request(
+      "interfaces/interface[name=*]/state/counters", gnmi::SAMPLE);
+  std::vector<std::unique_ptr<RecordingSubscription>> on_change_subscriptions;
+  std::vector<std::unique_ptr<RecordingSubscription>> sample_subscriptions;
+  for (int i = 0; i < params.on_change_subscriptions; ++i) {
+    on_change_subscriptions.push_back(std::make_unique<RecordingSubscription>(
+        RecordingSubscription::kRecordEveryUpdate));
+    ASSERT_OK(on_change_subscriptions.back()->Start(*sut_gnmi_stub,
+                                                    on_change_request));
+  }
+  for (int i = 0; i < params.sample_subscriptions; ++i) {
+    sample_subscriptions.push_back(std::make_unique<RecordingSubscription>(
+        params.sample_interval / 2));
+    ASSERT_OK(
+        sample_subscriptions.back()->Start(*sut_gnmi_stub, sample_request));
+  }
+  const absl::Time subscribe_time = absl::Now();
+  for (auto& subscription : on_change_subscriptions) {
+    ASSERT_OK(subscription->WaitForSync(kSyncTimeout));
+  }
+  for (auto& subscription : sample_subscriptions) {
+    ASSERT_OK(subscription->WaitForSync(kSyncTimeout));
+  }
+  LOG(INFO) << "Synced " << on_change_subscriptions.size()
+            << " ON_CHANGE and " << sample_subscriptions.size()
+            << " SAMPLE subscriptions in " << absl::Now() - subscribe_time;
+
+  // Flaps the link. The latencies are measured from when the control device
+  // is asked to bring the link down, and from when it should bring it back
+  // up, so they include the time to detect the link state change. That part
+  // is the same for all subscriptions; the spread is gNMI's.
+  LatencyHistogram down_latencies;
+  LatencyHistogram up_latencies;
+  std::optional<SwitchResourceUsage> loaded_usage;
+  for (int flap = 0; flap < params.link_flaps; ++flap) {
+    const absl::Time down_time = absl::Now();
+    const absl::Time up_time = down_time + params.link_down_duration;
+    LOG(INFO) << "Flapping " << peer_interface << " (" << flap + 1 << " of "
+              << params.link_flaps << ").";
+    ASSERT_OK(testbed.ControlDevice().FlapLinks(peer_interface,
+                                                params.link_down_duration));
+    if (!loaded_usage.has_value()) {
+      ASSERT_OK_AND_ASSIGN(loaded_usage,
+                           GetSwitchResourceUsage(*sut_gnmi_stub));
+    }
+
+    const absl::Time deadline = absl::Now() + kEventTimeout;
+    for (int i = 0; i < on_change_subscriptions.size(); ++i) {
+      const RecordingSubscription& subscription = *on_change_subscriptions[i];
+      std::optional<absl::Time> down, up;
+      while (true) {
+        down = subscription.FirstUpdateAfter(down_time, kStateDown);
+        if (down.has_value()) {
+          up = subscription.FirstUpdateAfter(*down, kStateUp);
+        }
+        if (up.has_value() || absl::Now() > deadline) break;
+        absl::SleepFor(absl::Milliseconds(100));
+      }
+      EXPECT_TRUE(down.has_value())
+          << "ON_CHANGE subscription " << i << " missed " << sut_interface
+          << " going down in flap " << flap + 1;
+      EXPECT_TRUE(up.has_value())
+          << "ON_CHANGE subscription " << i << " missed " << sut_interface
+          << " coming up in flap " << flap + 1;
+      if (down.has_value()) down_latencies.Record(*down - down_time);
+      if (up.has_value()) {
+        up_latencies.Record(std::max(*up - up_time, absl::ZeroDuration()));
+      }
+    }
+  }
+  LOG(INFO) << "Link down event latency: " << down_latencies.Summary();
+  LOG(INFO) << "Link up event latency: " << up_latencies.Summary();
+
+  // The jitter is how far apart consecutive samples are from the interval.
+  LatencyHistogram sample_jitter;
+  const absl::Time end_time = absl::Now();
+  const int64_t expected_samples =
+      (end_time - subscribe_time) / params.sample_interval;
+  for (int i = 0; i < sample_subscriptions.size(); ++i) {
+    const std::vector<absl::Time> samples = sample_subscriptions[i]->Samples();
+    // Allows for the first and last interval to be cut short.
+    EXPECT_GE(samples.size(), expected_samples - 1)
+        << "SAMPLE subscription " << i << " received too few samples.";
+    for (int j = 1; j < samples.size(); ++j) {
+      sample_jitter.Record(
+          absl::AbsDuration(samples[j] - samples[j - 1] -
+                            params.sample_interval));
+    }
+  }
+  LOG(INFO) << "Sample jitter: " << sample_jitter.Summary();
+
+  if (loaded_usage.has_value()) {
+    LOG(INFO) << "Switch resource usage with subscriptions: "
+              << loaded_usage->ToString() << " (cpu-utilization "
+              << loaded_usage->cpu_utilization - baseline_usage.cpu_utilization
+              << "%, memory-usage "
+              << loaded_usage->memory_usage - baseline_usage.memory_usage
+              << " bytes more than without subscriptions)";
+  }
+
+  if (params.max_p99_event_latency.has_value()) {
+    EXPECT_LE(down_latencies.Percentile(99), *params.max_p99_event_latency);
+    EXPECT_LE(up_latencies.Percentile(99), *params.max_p99_event_latency);
+  }
+}
+
 }  // namespace pins_test
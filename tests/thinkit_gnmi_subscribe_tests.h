@@ -15,11 +15,37 @@
 #ifndef GOOGLE_TESTS_THINKIT_GNMI_SUBSCRIBE_TESTS_H_
 #define GOOGLE_TESTS_THINKIT_GNMI_SUBSCRIBE_TESTS_H_
 
+#include <optional>
+
+#include "absl/time/time.h"
+#include "thinkit/generic_testbed.h"
 #include "thinkit/switch.h"
 
 namespace pins_test {
 
 void TestGnmiInterfaceAndComponentSubscribe(thinkit::Switch& sut);
 
-}
+struct GnmiSubscribeScaleParams {
+  // Concurrent subscriptions to the oper-status of the flapped interface.
+  int on_change_subscriptions = 32;
+  // Concurrent subscriptions to the counters of every interface.
+  int sample_subscriptions = 32;
+  absl::Duration sample_interval = absl::Seconds(10);
+  // Flaps of the control device link connected to the SUT.
+  int link_flaps = 5;
+  absl::Duration link_down_duration = absl::Seconds(10);
+  // If set, the 99th percentile of the time from a link state change to its
+  // delivery to every ON_CHANGE subscription must not exceed this.
+  std::optional<absl::Duration> max_p99_event_latency;
+};
+
+// Opens many concurrent ON_CHANGE and SAMPLE subscriptions, flaps a link from
+// the control device, and reports the distribution of event delivery
+// latencies, the jitter of samples, and the CPU and memory used by the switch
+// before and during the load. Expects every subscription to receive every
+// link state change and its samples.
+void TestGnmiSubscribeScale(thinkit::GenericTestbed& testbed,
+                            const GnmiSubscribeScaleParams& params = {});
+
+}  // namespace pins_test
 #endif  // GOOGLE_TESTS_THINKIT_GNMI_SUBSCRIBE_TESTS_H_
@@ -48,6 +48,21 @@ enum class RebootType {
   kCold,
 };
 
+// A packet to send out of one of a control device's interfaces.
+struct InterfacePacket {
+  std::string interface;
+  // The raw byte string of the packet.
+  std::string packet;
+};
+
+struct SendPacketBatchOptions {
+  // If set, packets are paced to this average rate.
+  std::optional<double> packets_per_second;
+  // The number of packets the device may send back to back, where it supports
+  // sending several at once.
+  int max_batch_size = 64;
+};
+
 // A `ControlDevice` represents any device or devices that can at the very
 // least send and receive packets over their interfaces. It may be able to get
 // and set link state, as well as perform various other operations like link
@@ -81,6 +96,44 @@ class ControlDevice {
   virtual absl::Status SendPackets(absl::string_view interface,
                                    absl::Span<const std::string> packets) = 0;
 
+  // Sends each packet out of its interface, in order. The default
+  // implementation sends the packets one at a time with `SendPacket`, delaying
+  // each one to keep to `packets_per_second`; implementations that can write
+  // several packets at once should override it.
+  virtual absl::Status SendPacketBatch(
+      absl::Span<const InterfacePacket> packets,
+      const SendPacketBatchOptions& options) {
+    std::optional<absl::Duration> packet_delay;
+    if (options.packets_per_second.has_value()) {
+      if (*options.packets_per_second <= 0) {
+        return absl::InvalidArgumentError(
+            "packets_per_second should be greater than 0");
+      }
+      packet_delay = absl::Seconds(1) / *options.packets_per_second;
+    }
+    for (const InterfacePacket& packet : packets) {
+      absl::Status status =
+          SendPacket(packet.interface, packet.packet, packet_delay);
+      if (!status.ok()) return status;
+    }
+    return absl::OkStatus();
+  }
+  absl::Status SendPacketBatch(absl::Span<const InterfacePacket> packets) {
+    return SendPacketBatch(packets, SendPacketBatchOptions());
+  }
+
+  // Starts collecting packets, and calls `callback` with each packet as it
+  // arrives, on a background thread, until the returned
+  // `PacketGenerationFinalizer` goes out of scope. Unlike with
+  // `CollectPackets`, packets are handled while the test keeps going, so
+  // `HandlePacketsFor` must not be called on the returned finalizer. Not all
+  // control devices support it.
+  virtual absl::StatusOr<std::unique_ptr<thinkit::PacketGenerationFinalizer>>
+  StreamPackets(PacketCallback callback) {
+    return absl::UnimplementedError(
+        "This control device does not support streaming packets.");
+  }
+
   // Sets the admin link state on the control device's 'interfaces'.
   virtual absl::Status SetAdminLinkState(
       absl::Span<const std::string> interfaces, LinkState state) = 0;
@@ -47,6 +47,13 @@ class MockControlDevice : public ControlDevice {
               (absl::string_view interface,
                absl::Span<const std::string> packets),
               (override));
+  MOCK_METHOD(absl::Status, SendPacketBatch,
+              (absl::Span<const InterfacePacket> packets,
+               const SendPacketBatchOptions& options),
+              (override));
+  MOCK_METHOD(
+      absl::StatusOr<std::unique_ptr<thinkit::PacketGenerationFinalizer>>,
+      StreamPackets, (PacketCallback callback), (override));
   MOCK_METHOD(absl::Status, SetAdminLinkState,
               (absl::Span<const std::string> sut_ports, LinkState state),
               (override));
@@ -0,0 +1,116 @@
+// Copyright (c) 2024, Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "thinkit/ssh_client.h"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <thread>  // NOLINT: third_party code.
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+
+namespace thinkit {
+
+absl::StatusOr<std::vector<SSHCommandResult>> SSHClient::RunCommands(
+    absl::Span<const SSHCommand> commands, const RunCommandsOptions& options) {
+  if (options.max_concurrency <= 0 || options.max_concurrency_per_device <= 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "The concurrency limits must be positive, but are ",
+        options.max_concurrency, " and ", options.max_concurrency_per_device,
+        " per device."));
+  }
+  if (options.max_output_bytes < 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("max_output_bytes must not be negative, but is ",
+                     options.max_output_bytes));
+  }
+
+  std::vector<SSHCommandResult> results(commands.size());
+  absl::Mutex mu;
+  // The indices of the commands that have not started, in order.
+  std::deque<int> pending;
+  for (int i = 0; i < commands.size(); ++i) pending.push_back(i);
+  absl::flat_hash_map<std::string, int> running_by_device;
+  // Serializes the `on_result` calls without holding up the scheduling.
+  absl::Mutex on_result_mu;
+
+  // Returns the position in `pending` of the first command whose device has
+  // room for it, or -1.
+  auto next_startable = [&]() -> int {
+    for (int i = 0; i < pending.size(); ++i) {
+      auto it = running_by_device.find(commands[pending[i]].device);
+      if (it == running_by_device.end() ||
+          it->second < options.max_concurrency_per_device) {
+        return i;
+      }
+    }
+    return -1;
+  };
+  auto can_proceed = [&] { return pending.empty() || next_startable() >= 0; };
+
+  auto worker = [&] {
+    while (true) {
+      int index;
+      {
+        absl::MutexLock l(&mu);
+        mu.Await(absl::Condition(&can_proceed));
+        if (pending.empty()) return;
+        auto it = pending.begin() + next_startable();
+        index = *it;
+        pending.erase(it);
+        ++running_by_device[commands[index].device];
+      }
+
+      const SSHCommand& command = commands[index];
+      SSHCommandResult& result = results[index];
+      const absl::Time start = absl::Now();
+      result.output = RunCommand(command.device, command.command,
+                                 options.timeout);
+      result.duration = absl::Now() - start;
+      if (result.output.ok() &&
+          result.output->size() > options.max_output_bytes) {
+        result.output->resize(options.max_output_bytes);
+        result.truncated = true;
+      }
+
+      {
+        absl::MutexLock l(&mu);
+        --running_by_device[command.device];
+      }
+      if (options.on_result) {
+        absl::MutexLock l(&on_result_mu);
+        options.on_result(index, result);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const int num_threads =
+      std::min<int>(options.max_concurrency, commands.size());
+  threads.reserve(num_threads);
+  for (int i = 0; i < num_threads; ++i) threads.emplace_back(worker);
+  for (std::thread& thread : threads) thread.join();
+  return results;
+}
+
+}  // namespace thinkit
@@ -15,12 +15,16 @@
 #ifndef THINKIT_SSH_CLIENT_H_
 #define THINKIT_SSH_CLIENT_H_
 
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 
 namespace thinkit {
 
@@ -31,6 +35,39 @@ struct RemotePath {
   absl::string_view file_path;
 };
 
+// A command to run on a device with `SSHClient::RunCommands`.
+struct SSHCommand {
+  std::string device;
+  std::string command;
+};
+
+// The outcome of an `SSHCommand`.
+struct SSHCommandResult {
+  // The stdout of the command, as `SSHClient::RunCommand` returns it, but cut
+  // to `RunCommandsOptions::max_output_bytes`.
+  absl::StatusOr<std::string> output;
+  // True if `output` was cut.
+  bool truncated = false;
+  absl::Duration duration;
+};
+
+struct RunCommandsOptions {
+  // The timeout of each command.
+  absl::Duration timeout = absl::Minutes(1);
+  // The maximum number of commands running at once, in total and on each
+  // device. The per-device limit keeps below the number of concurrent
+  // unauthenticated connections sshd accepts by default.
+  int max_concurrency = 32;
+  int max_concurrency_per_device = 4;
+  // The maximum size of each output that is kept, so that a pod-wide
+  // collection of large logs does not exhaust memory.
+  int64_t max_output_bytes = 16 * 1024 * 1024;
+  // If set, called with the index of each command and its result as soon as
+  // it finishes. Calls are serialized, so the callback need not be
+  // thread-safe.
+  std::function<void(int index, const SSHCommandResult& result)> on_result;
+};
+
 // SSHClient handles running remote commands or getting/putting remote files
 // onto a specified device. As these operations are whitebox and platform
 // specific, this interface should be used sparingly and only when needed.
@@ -45,6 +82,17 @@ class SSHClient {
                                                  absl::string_view command,
                                                  absl::Duration timeout) = 0;
 
+  // Runs `commands` concurrently, across devices and on each device, and
+  // returns their results in the order of `commands`. Fails only if `options`
+  // are invalid.
+  //
+  // By default, calls `RunCommand` from a pool of threads. Implementations
+  // that can reuse a connection to a device across commands should override
+  // this, or pool connections in `RunCommand`.
+  virtual absl::StatusOr<std::vector<SSHCommandResult>> RunCommands(
+      absl::Span<const SSHCommand> commands,
+      const RunCommandsOptions& options);
+
   // Copies a local file's contents to a remote destination file, creating a new
   // file if needed and replacing any existing contents that was there.
   virtual absl::Status PutFile(absl::string_view source,
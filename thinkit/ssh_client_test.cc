@@ -0,0 +1,175 @@
+// Copyright (c) 2024, Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "thinkit/ssh_client.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "gutil/status_matchers.h"
+#include "thinkit/mock_ssh_client.h"
+
+namespace thinkit {
+namespace {
+
+using ::gutil::IsOkAndHolds;
+using ::gutil::StatusIs;
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+// Echoes commands back after a short delay, and tracks how many run at once.
+class EchoingSSHClient : public NiceMock<MockSSHClient> {
+ public:
+  EchoingSSHClient() {
+    ON_CALL(*this, RunCommand(_, _, _))
+        .WillByDefault(Invoke([this](absl::string_view device,
+                                     absl::string_view command,
+                                     absl::Duration) {
+          Start(device);
+          absl::SleepFor(absl::Milliseconds(5));
+          Stop(device);
+          if (command == "fail") {
+            return absl::StatusOr<std::string>(
+                absl::UnknownError("command failed"));
+          }
+          return absl::StatusOr<std::string>(
+              absl::StrCat(device, ": ", command));
+        }));
+  }
+
+  int MaxRunning() {
+    absl::MutexLock l(&mu_);
+    return max_running_;
+  }
+  int MaxRunningOnOneDevice() {
+    absl::MutexLock l(&mu_);
+    return max_running_on_one_device_;
+  }
+
+ private:
+  void Start(absl::string_view device) {
+    absl::MutexLock l(&mu_);
+    max_running_ = std::max(max_running_, ++running_);
+    max_running_on_one_device_ = std::max(
+        max_running_on_one_device_, ++running_by_device_[std::string(device)]);
+  }
+  void Stop(absl::string_view device) {
+    absl::MutexLock l(&mu_);
+    --running_;
+    --running_by_device_[std::string(device)];
+  }
+
+  absl::Mutex mu_;
+  int running_ ABSL_GUARDED_BY(mu_) = 0;
+  int max_running_ ABSL_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<std::string, int> running_by_device_
+      ABSL_GUARDED_BY(mu_);
+  int max_running_on_one_device_ ABSL_GUARDED_BY(mu_) = 0;
+};
+
+std::vector<SSHCommand> Commands(int num_devices, int commands_per_device) {
+  std::vector<SSHCommand> commands;
+  for (int i = 0; i < commands_per_device; ++i) {
+    for (int j = 0; j < num_devices; ++j) {
+      commands.push_back(
+          {.device = absl::StrCat("device", j), .command = absl::StrCat(i)});
+    }
+  }
+  return commands;
+}
+
+TEST(RunCommandsTest, ReturnsResultsInOrder) {
+  EchoingSSHClient client;
+  std::vector<SSHCommand> commands = Commands(4, 5);
+  commands[3].command = "fail";
+  ASSERT_OK_AND_ASSIGN(std::vector<SSHCommandResult> results,
+                       client.RunCommands(commands, {}));
+  ASSERT_EQ(results.size(), commands.size());
+  for (int i = 0; i < commands.size(); ++i) {
+    if (i == 3) {
+      EXPECT_THAT(results[i].output, StatusIs(absl::StatusCode::kUnknown));
+    } else {
+      EXPECT_THAT(results[i].output,
+                  IsOkAndHolds(absl::StrCat(commands[i].device, ": ",
+                                            commands[i].command)));
+    }
+    EXPECT_GE(results[i].duration, absl::Milliseconds(5));
+  }
+}
+
+TEST(RunCommandsTest, RespectsConcurrencyLimits) {
+  EchoingSSHClient client;
+  ASSERT_OK(client
+                .RunCommands(Commands(3, 10), {.max_concurrency = 4,
+                                               .max_concurrency_per_device = 2})
+                .status());
+  EXPECT_LE(client.MaxRunning(), 4);
+  EXPECT_LE(client.MaxRunningOnOneDevice(), 2);
+  EXPECT_GT(client.MaxRunning(), 1);
+}
+
+TEST(RunCommandsTest, TruncatesLongOutputs) {
+  EchoingSSHClient client;
+  ASSERT_OK_AND_ASSIGN(std::vector<SSHCommandResult> results,
+                       client.RunCommands({{.device = "d", .command = "0"},
+                                           {.device = "device0",
+                                            .command = "0"}},
+                                          {.max_output_bytes = 4}));
+  EXPECT_THAT(results[0].output, IsOkAndHolds("d: 0"));
+  EXPECT_FALSE(results[0].truncated);
+  EXPECT_THAT(results[1].output, IsOkAndHolds("devi"));
+  EXPECT_TRUE(results[1].truncated);
+}
+
+TEST(RunCommandsTest, ReportsEveryResultAsItFinishes) {
+  EchoingSSHClient client;
+  std::vector<int> reported;
+  ASSERT_OK(client
+                .RunCommands(Commands(2, 3),
+                             {.on_result =
+                                  [&](int index, const SSHCommandResult&) {
+                                    reported.push_back(index);
+                                  }})
+                .status());
+  std::sort(reported.begin(), reported.end());
+  EXPECT_THAT(reported, ElementsAre(0, 1, 2, 3, 4, 5));
+}
+
+TEST(RunCommandsTest, RejectsInvalidOptions) {
+  EchoingSSHClient client;
+  EXPECT_THAT(client.RunCommands(Commands(1, 1), {.max_concurrency = 0}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(
+      client.RunCommands(Commands(1, 1), {.max_concurrency_per_device = 0}),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(client.RunCommands(Commands(1, 1), {.max_output_bytes = -1}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace thinkit